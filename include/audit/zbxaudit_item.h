@@ -79,6 +79,8 @@ PREPARE_AUDIT_ITEM_UPDATE_H(ssl_key_password, const char*)
 PREPARE_AUDIT_ITEM_UPDATE_H(verify_peer, int)
 PREPARE_AUDIT_ITEM_UPDATE_H(verify_host, int)
 PREPARE_AUDIT_ITEM_UPDATE_H(allow_traps, int)
+PREPARE_AUDIT_ITEM_UPDATE_H(history_downsample, int)
+PREPARE_AUDIT_ITEM_UPDATE_H(history_downsample_param, const char*)
 PREPARE_AUDIT_ITEM_UPDATE_H(discover, int)
 PREPARE_AUDIT_ITEM_UPDATE_H(key, const char*)
 
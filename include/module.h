@@ -226,11 +226,84 @@ typedef struct
 }
 ZBX_HISTORY_WRITE_CBS;
 
+/* Columnar history views passed to callbacks returned by zbx_module_history_write_cbs_v2(). */
+/* Values of the same index in all arrays belong to the same history record. The arrays are */
+/* read only and valid only until the callback returns.                                     */
+typedef struct
+{
+	const zbx_uint64_t	*itemid;
+	const int		*clock;
+	const int		*ns;
+	const double		*value;
+	int			values_num;
+}
+ZBX_HISTORY_FLOAT_COLUMNS;
+
+typedef struct
+{
+	const zbx_uint64_t	*itemid;
+	const int		*clock;
+	const int		*ns;
+	const zbx_uint64_t	*value;
+	int			values_num;
+}
+ZBX_HISTORY_INTEGER_COLUMNS;
+
+typedef struct
+{
+	const zbx_uint64_t	*itemid;
+	const int		*clock;
+	const int		*ns;
+	const char * const	*value;
+	int			values_num;
+}
+ZBX_HISTORY_STRING_COLUMNS;
+
+typedef struct
+{
+	const zbx_uint64_t	*itemid;
+	const int		*clock;
+	const int		*ns;
+	const char * const	*value;
+	int			values_num;
+}
+ZBX_HISTORY_TEXT_COLUMNS;
+
+typedef struct
+{
+	const zbx_uint64_t	*itemid;
+	const int		*clock;
+	const int		*ns;
+	const char * const	*value;
+	const char * const	*source;
+	const int		*timestamp;
+	const int		*logeventid;
+	const int		*severity;
+	int			values_num;
+}
+ZBX_HISTORY_LOG_COLUMNS;
+
+/* history write callbacks are called from a separate thread, so that slow module does not delay history */
+/* synchronization; when the module does not keep up, new history is dropped for that module             */
+#define ZBX_MODULE_HISTORY_ASYNC	0x01
+
+typedef struct
+{
+	void	(*history_float_cb)(const ZBX_HISTORY_FLOAT_COLUMNS *history);
+	void	(*history_integer_cb)(const ZBX_HISTORY_INTEGER_COLUMNS *history);
+	void	(*history_string_cb)(const ZBX_HISTORY_STRING_COLUMNS *history);
+	void	(*history_text_cb)(const ZBX_HISTORY_TEXT_COLUMNS *history);
+	void	(*history_log_cb)(const ZBX_HISTORY_LOG_COLUMNS *history);
+	int	flags;
+}
+ZBX_HISTORY_WRITE_CBS_V2;
+
 int	zbx_module_api_version(void);
 int	zbx_module_init(void);
 int	zbx_module_uninit(void);
 void	zbx_module_item_timeout(int timeout);
 ZBX_METRIC	*zbx_module_item_list(void);
 ZBX_HISTORY_WRITE_CBS	zbx_module_history_write_cbs(void);
+ZBX_HISTORY_WRITE_CBS_V2	zbx_module_history_write_cbs_v2(void);
 
 #endif
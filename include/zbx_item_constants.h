@@ -28,6 +28,14 @@
 #define ITEM_STATE_NORMAL		0
 #define ITEM_STATE_NOTSUPPORTED		1
 
+/* item history downsampling modes */
+#define ITEM_HISTORY_DOWNSAMPLE_NONE		0
+#define ITEM_HISTORY_DOWNSAMPLE_AVG		1
+#define ITEM_HISTORY_DOWNSAMPLE_MIN		2
+#define ITEM_HISTORY_DOWNSAMPLE_MAX		3
+#define ITEM_HISTORY_DOWNSAMPLE_LAST		4
+#define ITEM_HISTORY_DOWNSAMPLE_DEADBAND	5
+
 #define ZBX_HC_ITEM_STATUS_NORMAL	0
 #define ZBX_HC_ITEM_STATUS_BUSY		1
 
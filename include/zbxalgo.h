@@ -28,12 +28,13 @@
 typedef zbx_uint32_t zbx_hash_t;
 
 zbx_hash_t	zbx_hash_modfnv(const void *data, size_t len, zbx_hash_t seed);
+zbx_hash_t	zbx_hash_words(const void *data, size_t len, zbx_hash_t seed);
 zbx_hash_t	zbx_hash_splittable64(const void *data);
 
-#define ZBX_DEFAULT_HASH_ALGO		zbx_hash_modfnv
-#define ZBX_DEFAULT_PTR_HASH_ALGO	zbx_hash_modfnv
-#define ZBX_DEFAULT_UINT64_HASH_ALGO	zbx_hash_modfnv
-#define ZBX_DEFAULT_STRING_HASH_ALGO	zbx_hash_modfnv
+#define ZBX_DEFAULT_HASH_ALGO		zbx_hash_words
+#define ZBX_DEFAULT_PTR_HASH_ALGO	zbx_hash_words
+#define ZBX_DEFAULT_UINT64_HASH_ALGO	zbx_hash_words
+#define ZBX_DEFAULT_STRING_HASH_ALGO	zbx_hash_words
 
 typedef zbx_hash_t (*zbx_hash_func_t)(const void *data);
 
@@ -356,6 +357,14 @@ ZBX_VECTOR_DECL(dbl, double)
 
 ZBX_PTR_VECTOR_DECL(tags, zbx_tag_t*)
 
+/* specialized zbx_vector_uint64_t functions, ordering values in ascending order without comparison callbacks */
+void	zbx_vector_uint64_sort_asc(zbx_vector_uint64_t *vector);
+void	zbx_vector_uint64_uniq_asc(zbx_vector_uint64_t *vector);
+void	zbx_vector_uint64_sort_uniq(zbx_vector_uint64_t *vector);
+void	zbx_vector_uint64_setdiff_asc(zbx_vector_uint64_t *left, const zbx_vector_uint64_t *right);
+void	zbx_vector_uint64_intersect_asc(zbx_vector_uint64_t *left, const zbx_vector_uint64_t *right);
+void	zbx_vector_uint64_union_asc(zbx_vector_uint64_t *left, const zbx_vector_uint64_t *right);
+
 #define	ZBX_VECTOR_ARRAY_GROWTH_FACTOR	3/2
 
 #define	ZBX_VECTOR_IMPL(__id, __type)										\
@@ -745,4 +754,29 @@ int	zbx_list_iterator_isset(const zbx_list_iterator_t *iterator);
 void	zbx_list_iterator_update(zbx_list_iterator_t *iterator);
 void	*zbx_list_iterator_remove_next(zbx_list_iterator_t *iterator);
 
+/* arena allocator, the allocated memory is released all at once */
+typedef struct zbx_arena_block
+{
+	struct zbx_arena_block	*next;
+	size_t			size;
+	size_t			used;
+}
+zbx_arena_block_t;
+
+typedef struct
+{
+	zbx_arena_block_t	*first;
+	zbx_arena_block_t	*current;
+	size_t			block_size;
+}
+zbx_arena_t;
+
+void	zbx_arena_create(zbx_arena_t *arena, size_t block_size);
+void	zbx_arena_destroy(zbx_arena_t *arena);
+void	*zbx_arena_alloc(zbx_arena_t *arena, size_t size);
+char	*zbx_arena_strdup(zbx_arena_t *arena, const char *str);
+char	*zbx_arena_strndup(zbx_arena_t *arena, const char *str, size_t len);
+void	zbx_arena_reset(zbx_arena_t *arena);
+void	zbx_arena_clear(zbx_arena_t *arena);
+
 #endif /* ZABBIX_ZBXALGO_H */
@@ -135,6 +135,12 @@ void	zbx_availability_deserialize_hostids(const unsigned char *data, zbx_vector_
 
 void	zbx_availability_deserialize_active_proxy_hb_update(const unsigned char *data, zbx_uint64_t *hostid);
 
+typedef struct
+{
+	int	config_availability_flush_delay;
+}
+zbx_thread_avail_manager_args;
+
 ZBX_THREAD_ENTRY(zbx_availability_manager_thread, args);
 
 #endif /* ZABBIX_AVAILABILITY_H */
@@ -37,7 +37,10 @@
 #define	ZBX_POLLER_TYPE_JAVA		4
 #define	ZBX_POLLER_TYPE_HISTORY		5
 #define	ZBX_POLLER_TYPE_ODBC		6
-#define	ZBX_POLLER_TYPE_COUNT		7	/* number of poller types */
+#define	ZBX_POLLER_TYPE_AGENT		7
+#define	ZBX_POLLER_TYPE_SNMP		8
+#define	ZBX_POLLER_TYPE_HTTPAGENT	9
+#define	ZBX_POLLER_TYPE_COUNT		10	/* number of poller types */
 
 typedef enum
 {
@@ -132,6 +135,7 @@ typedef struct
 	zbx_dc_interface_t	interface;
 	zbx_uint64_t		itemid;
 	zbx_uint64_t		lastlogsize;
+	zbx_uint64_t		revision;
 	unsigned char		type;
 	unsigned char		snmp_version;
 	unsigned char		value_type;
@@ -208,6 +212,9 @@ typedef struct
 	char			*units;
 	char			*error;
 	char			*history_period, *trends_period;
+	char			*history_downsample_param;
+	double			history_downsample_deadband;
+	int			history_downsample_period;
 	int			mtime;
 	int			history_sec;
 	int			trends_sec;
@@ -219,6 +226,7 @@ typedef struct
 	unsigned char		status;
 	unsigned char		history;
 	unsigned char		trends;
+	unsigned char		history_downsample;
 }
 zbx_history_sync_item_t;
 
@@ -239,6 +247,7 @@ typedef struct
 	char		tls_psk_identity[HOST_TLS_PSK_IDENTITY_LEN_MAX];
 	char		tls_psk[HOST_TLS_PSK_LEN_MAX];
 #endif
+	zbx_uint64_t	revision;
 }
 zbx_history_recv_host_t;
 
@@ -608,6 +617,8 @@ typedef struct
 	zbx_list_t		data_point_link_queue;
 	int			time_flush;
 	int			senders;
+	int			senders_window;	/* the current limit of concurrent senders, adapted to */
+						/* delivery results up to max_senders              */
 }
 zbx_connector_t;
 
@@ -662,7 +673,10 @@ zbx_synced_new_config_t;
 void	zbx_dc_sync_configuration(unsigned char mode, zbx_synced_new_config_t synced,
 		zbx_vector_uint64_t *deleted_itemids, const zbx_config_vault_t *config_vault,
 		int proxyconfig_frequency);
+void	zbx_dc_sync_configuration_standby(unsigned char mode, const zbx_config_vault_t *config_vault,
+		int proxyconfig_frequency);
 void	zbx_dc_sync_kvs_paths(const struct zbx_json_parse *jp_kvs_paths, const zbx_config_vault_t *config_vault);
+void	zbx_dc_expire_kvs_paths(void);
 int	zbx_init_configuration_cache(zbx_get_program_type_f get_program_type, zbx_get_config_forks_f get_config_forks,
 		zbx_uint64_t conf_cache_size, char **error);
 void	zbx_free_configuration_cache(void);
@@ -670,6 +684,7 @@ void	zbx_free_configuration_cache(void);
 void	zbx_dc_config_get_triggers_by_triggerids(zbx_dc_trigger_t *triggers, const zbx_uint64_t *triggerids,
 		int *errcode, size_t num);
 void	zbx_dc_config_clean_items(zbx_dc_item_t *items, int *errcodes, size_t num);
+void	zbx_dc_item_copy(zbx_dc_item_t *dst, const zbx_dc_item_t *src);
 int	zbx_dc_get_host_by_hostid(zbx_dc_host_t *host, zbx_uint64_t hostid);
 int	zbx_dc_config_get_hostid_by_name(const char *host, zbx_uint64_t *hostid);
 void	zbx_dc_config_get_hosts_by_itemids(zbx_dc_host_t *hosts, const zbx_uint64_t *itemids, int *errcodes, size_t num);
@@ -704,7 +719,8 @@ void	zbx_dc_config_get_functions_by_functionids(zbx_dc_function_t *functions,
 		zbx_uint64_t *functionids, int *errcodes, size_t num);
 void	zbx_dc_config_clean_functions(zbx_dc_function_t *functions, int *errcodes, size_t num);
 void	zbx_dc_config_clean_triggers(zbx_dc_trigger_t *triggers, int *errcodes, size_t num);
-int	zbx_dc_config_lock_triggers_by_history_items(zbx_vector_ptr_t *history_items, zbx_vector_uint64_t *triggerids);
+int	zbx_dc_config_lock_triggers_by_history_items(zbx_vector_ptr_t *history_items, int triggers_max,
+		zbx_vector_uint64_t *triggerids);
 void	zbx_dc_config_lock_triggers_by_triggerids(zbx_vector_uint64_t *triggerids_in,
 		zbx_vector_uint64_t *triggerids_out);
 void	zbx_dc_config_unlock_triggers(const zbx_vector_uint64_t *triggerids);
@@ -717,7 +733,9 @@ int	zbx_dc_config_get_suggested_snmp_vars(zbx_uint64_t interfaceid, int *bulk);
 int	zbx_dc_config_get_interface_by_type(zbx_dc_interface_t *interface, zbx_uint64_t hostid, unsigned char type);
 int	zbx_dc_config_get_interface(zbx_dc_interface_t *interface, zbx_uint64_t hostid, zbx_uint64_t itemid);
 int	zbx_dc_config_get_poller_nextcheck(unsigned char poller_type);
-int	zbx_dc_config_get_poller_items(unsigned char poller_type, int config_timeout, zbx_dc_item_t **items);
+int	zbx_dc_get_poller_lag(unsigned char poller_type);
+int	zbx_dc_config_get_poller_items(unsigned char poller_type, int config_timeout, int processing,
+		int config_max_concurrent_checks_per_poller, zbx_dc_item_t **items);
 int	zbx_dc_config_get_ipmi_poller_items(int now, int items_num, int config_timeout, zbx_dc_item_t *items,
 		int *nextcheck);
 int	zbx_dc_config_get_snmp_interfaceids_by_addr(const char *addr, zbx_uint64_t **interfaceids);
@@ -742,6 +760,7 @@ void	zbx_dc_config_delete_autoreg_host(const zbx_vector_ptr_t *autoreg_hosts);
 void	zbx_dc_requeue_items(const zbx_uint64_t *itemids, const int *lastclocks, const int *errcodes, size_t num);
 void	zbx_dc_poller_requeue_items(const zbx_uint64_t *itemids, const int *lastclocks,
 		const int *errcodes, size_t num, unsigned char poller_type, int *nextcheck);
+int	zbx_dc_get_inflight_checks(unsigned char poller_type);
 #ifdef HAVE_OPENIPMI
 void	zbx_dc_requeue_unreachable_items(zbx_uint64_t *itemids, size_t itemids_num);
 #endif
@@ -866,6 +885,7 @@ void	zbx_dc_get_hostids_by_group_name(const char *name, zbx_vector_uint64_t *hos
 #define ZBX_DC_FLAG_UNDEF	0x08	/* unsupported or undefined (delta calculation failed) value */
 #define ZBX_DC_FLAG_NOHISTORY	0x10	/* values should not be kept in history */
 #define ZBX_DC_FLAG_NOTRENDS	0x20	/* values should not be kept in trends */
+#define ZBX_DC_FLAG_DOWNSAMPLED	0x40	/* value is cached, but replaced by downsampled value in history storage */
 
 typedef struct zbx_hc_data
 {
@@ -876,6 +896,7 @@ typedef struct zbx_hc_data
 	unsigned char		value_type;
 	unsigned char		flags;
 	unsigned char		state;
+	unsigned char		compressed;	/* non-zero if text or log value string is compressed */
 
 	struct zbx_hc_data	*next;
 }
@@ -951,6 +972,7 @@ typedef struct
 	zbx_uint64_t	upstream;	/* configuration revision received from server */
 	zbx_uint64_t	config_table;	/* the global configuration revision (config table) */
 	zbx_uint64_t	connector;
+	zbx_uint64_t	items;		/* revision of hosts, items, host groups and tags */
 }
 zbx_dc_revision_t;
 
@@ -1003,6 +1025,9 @@ void	zbx_dc_get_host_maintenance_updates(const zbx_vector_uint64_t *maintenancei
 void	zbx_dc_flush_host_maintenance_updates(const zbx_vector_ptr_t *updates);
 int	zbx_dc_get_event_maintenances(zbx_vector_ptr_t *event_queries, const zbx_vector_uint64_t *maintenanceids);
 int	zbx_dc_get_running_maintenanceids(zbx_vector_uint64_t *maintenanceids);
+void	zbx_dc_maintenance_set_modified(void);
+int	zbx_dc_get_modified_maintenanceids(zbx_vector_uint64_t *maintenanceids);
+void	zbx_dc_get_maintenance_hostids(const zbx_vector_uint64_t *maintenanceids, zbx_vector_uint64_t *hostids);
 
 void	zbx_dc_maintenance_set_update_flags(void);
 void	zbx_dc_maintenance_reset_update_flag(int timer);
@@ -1013,8 +1038,9 @@ int	zbx_dc_maintenance_has_tags(void);
 
 typedef struct
 {
-	char	*lld_macro;
-	char	*path;
+	char		*lld_macro;
+	char		*path;
+	zbx_jsonpath_t	*jsonpath;	/* compiled path, NULL if the path is compiled on every query */
 }
 zbx_lld_macro_path_t;
 
@@ -1029,6 +1055,9 @@ void	zbx_get_item_tags(zbx_uint64_t itemid, zbx_vector_ptr_t *item_tags);
 
 void	zbx_dc_config_history_sync_get_item_tags_by_functionids(const zbx_uint64_t *functionids,
 		size_t functionids_num, zbx_vector_ptr_t *item_tags);
+void	zbx_dc_config_history_sync_get_items_export_info(const zbx_uint64_t *itemids, size_t itemids_num,
+		char **names, zbx_vector_tags_t **item_tags);
+void	zbx_dc_config_history_sync_get_hosts_groups(const zbx_vector_uint64_t *hostids, zbx_vector_ptr_t **groups);
 
 const char	*zbx_dc_get_instanceid(void);
 
@@ -1040,6 +1069,7 @@ typedef struct
 	zbx_uint32_t		type;
 	unsigned char		lock;		/* 1 if the timer has locked trigger, 0 otherwise */
 	zbx_uint64_t		revision;	/* revision */
+	zbx_uint64_t		seed;		/* schedule seed, timers of the same item share it */
 	time_t			lastcheck;
 	zbx_timespec_t		eval_ts;	/* the history time for which trigger must be recalculated */
 	zbx_timespec_t		check_ts;	/* time when timer must be checked */
@@ -1114,12 +1144,25 @@ int	zbx_dc_get_proxy_name_type_by_id(zbx_uint64_t proxyid, int *status, char **n
 /* special item key used for ICMP ping loss packages */
 #define ZBX_SERVER_ICMPPINGLOSS_KEY	"icmppingloss"
 
+typedef struct
+{
+	zbx_uint64_t	druleid;
+	time_t		started;
+	int		addresses_num;
+	int		processed_num;
+}
+zbx_dc_drule_stats_t;
+
 int	zbx_dc_drule_next(time_t now, zbx_uint64_t *druleid, time_t *nextcheck);
 void	zbx_dc_drule_queue(time_t now, zbx_uint64_t druleid, int delay);
+void	zbx_dc_drule_update_progress(zbx_uint64_t druleid, int addresses_num, int processed_num);
+void	zbx_dc_get_drule_stats(time_t now, zbx_vector_ptr_t *stats, int *queued_num, int *overdue_num);
 
 int	zbx_dc_httptest_next(time_t now, zbx_uint64_t *httptestid, time_t *nextcheck);
 void	zbx_dc_httptest_queue(time_t now, zbx_uint64_t httptestid, int delay);
 
+zbx_uint64_t	zbx_dc_get_host_config_revision(zbx_uint64_t hostid);
+zbx_uint64_t	zbx_dc_get_items_revision(void);
 zbx_uint64_t	zbx_dc_get_received_revision(void);
 void	zbx_dc_update_received_revision(zbx_uint64_t revision);
 
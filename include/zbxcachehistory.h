@@ -50,23 +50,70 @@ typedef struct
 	zbx_uint64_t	index_total;
 	zbx_uint64_t	trend_free;
 	zbx_uint64_t	trend_total;
+	zbx_uint64_t	ingest_free;
+	zbx_uint64_t	ingest_total;
+	zbx_uint64_t	ingest_overflows;	/* the number of flushes bypassing ingestion rings */
 }
 zbx_wcache_info_t;
 
+void	zbx_hc_set_sync_shards(int syncer_num, int syncers_num);
+int	zbx_hc_sync_is_active(void);
+void	zbx_hc_scale_syncers(int syncers_min, int syncers_max);
 void	zbx_sync_history_cache(const zbx_events_funcs_t *events_cbs, int *values_num, int *triggers_num, int *more);
+void	zbx_dc_set_trend_writer(int running);
+void	zbx_dc_write_queued_trends(int *trends_num, int *more);
 void	zbx_log_sync_history_cache_progress(void);
+void	zbx_hc_modules_stop(void);
 
 #define ZBX_SYNC_NONE	0
 #define ZBX_SYNC_ALL	1
 
+/* the maximum number of independently locked history cache shards */
+#define ZBX_HC_SHARDS_MAX	16
+/* the minimum history cache and history index cache size per shard */
+#define ZBX_HC_SHARD_SIZE_MIN	(__UINT64_C(128) * ZBX_KIBIBYTE)
+/* the minimum size of history ingestion ring */
+#define ZBX_HC_RING_SIZE_MIN	(__UINT64_C(64) * ZBX_KIBIBYTE)
+
 int	zbx_init_database_cache(zbx_get_program_type_f get_program_type, zbx_uint64_t history_cache_size,
-		zbx_uint64_t history_index_cache_size,zbx_uint64_t trends_cache_size, char **error);
+		zbx_uint64_t history_index_cache_size, zbx_uint64_t trends_cache_size, int history_cache_shards,
+		char **error);
+int	zbx_init_history_ingest(zbx_uint64_t ring_size, int rings_num, char **error);
 void	zbx_free_database_cache(int sync, const zbx_events_funcs_t *events_cbs);
 
 void	zbx_change_proxy_history_count(int change_count);
 void	zbx_reset_proxy_history_count(int reset);
 int	zbx_get_proxy_history_count(void);
 
+/* the minimum size of proxy memory buffer */
+#define ZBX_PB_MEMORY_SIZE_MIN	(__UINT64_C(128) * ZBX_KIBIBYTE)
+
+typedef struct
+{
+	zbx_uint64_t	id;
+	zbx_uint64_t	itemid;
+	zbx_uint64_t	lastlogsize;
+	size_t		source_offset;
+	size_t		value_offset;
+	int		clock;
+	int		ns;
+	int		timestamp;
+	int		severity;
+	int		logeventid;
+	int		mtime;
+	unsigned char	state;
+	unsigned char	flags;
+}
+zbx_proxy_history_data_t;
+
+int	zbx_init_proxy_buffer(const char *mode, zbx_uint64_t size, int age, char **error);
+int	zbx_pb_history_has_data(void);
+int	zbx_pb_history_get_data(zbx_uint64_t lastid, zbx_proxy_history_data_t **data, size_t *data_alloc,
+		char **string_buffer, size_t *string_buffer_alloc, int *more);
+void	zbx_pb_history_set_lastid(zbx_uint64_t lastid);
+int	zbx_pb_history_get_delay(zbx_uint64_t lastid);
+void	zbx_pb_history_set_memory_state(void);
+
 #define ZBX_STATS_HISTORY_COUNTER	0
 #define ZBX_STATS_HISTORY_FLOAT_COUNTER	1
 #define ZBX_STATS_HISTORY_UINT_COUNTER	2
@@ -92,6 +92,18 @@ typedef struct
 }
 zbx_vc_item_stats_t;
 
+/* item history prefetch request */
+typedef struct
+{
+	zbx_uint64_t	itemid;
+	int		range_start;	/* the values must be cached since this timestamp */
+	unsigned char	value_type;
+}
+zbx_vc_prefetch_t;
+
+/* the callback to process item history values without copying them */
+typedef void	(*zbx_vc_values_func_t)(const zbx_history_record_t *values, int values_num, void *data);
+
 int	zbx_vc_init(zbx_uint64_t value_cache_size, char **error);
 
 void	zbx_vc_destroy(void);
@@ -105,10 +117,18 @@ void	zbx_vc_disable(void);
 int	zbx_vc_get_values(zbx_uint64_t itemid, unsigned char value_type, zbx_vector_history_record_t *values,
 		int seconds, int count, const zbx_timespec_t *ts);
 
+int	zbx_vc_iterate_values(zbx_uint64_t itemid, unsigned char value_type, int seconds, int count,
+		const zbx_timespec_t *ts, zbx_vc_values_func_t values_func, void *values_data);
+
+void	zbx_vc_prefetch_values(const zbx_vc_prefetch_t *requests, int requests_num);
+
+int	zbx_vc_get_item_revision(zbx_uint64_t itemid, unsigned char value_type, zbx_uint64_t *revision);
+
 int	zbx_vc_get_value(zbx_uint64_t itemid, unsigned char value_type, const zbx_timespec_t *ts,
 		zbx_history_record_t *value);
 
 int	zbx_vc_add_values(zbx_vector_ptr_t *history, int *ret_flush);
+void	zbx_vc_cache_values(const zbx_vector_ptr_t *history);
 
 int	zbx_vc_get_statistics(zbx_vc_stats_t *stats);
 
@@ -119,4 +139,7 @@ void	zbx_vc_get_mem_stats(zbx_shmem_stats_t *mem);
 void	zbx_vc_get_item_stats(zbx_vector_ptr_t *stats);
 void	zbx_vc_flush_stats(void);
 
+int	zbx_vc_snapshot_save(const char *path, char **error);
+int	zbx_vc_snapshot_load(const char *path, char **error);
+
 #endif
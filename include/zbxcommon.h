@@ -306,7 +306,11 @@ const char	*get_program_type_string(unsigned char program_type);
 #define ZBX_PROCESS_TYPE_ODBCPOLLER		36
 #define ZBX_PROCESS_TYPE_CONNECTORMANAGER	37
 #define ZBX_PROCESS_TYPE_CONNECTORWORKER	38
-#define ZBX_PROCESS_TYPE_COUNT			39	/* number of process types */
+#define ZBX_PROCESS_TYPE_AGENT_POLLER		39
+#define ZBX_PROCESS_TYPE_SNMP_POLLER		40
+#define ZBX_PROCESS_TYPE_HTTPAGENT_POLLER	41
+#define ZBX_PROCESS_TYPE_TRENDWRITER		42
+#define ZBX_PROCESS_TYPE_COUNT			43	/* number of process types */
 
 /* special processes that are not present worker list */
 #define ZBX_PROCESS_TYPE_EXT_FIRST		126
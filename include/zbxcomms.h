@@ -165,7 +165,19 @@ typedef struct
 	gnutls_psk_server_credentials_t	psk_server_creds;
 #elif defined(HAVE_OPENSSL)
 	SSL				*ctx;
+#if defined(HAVE_OPENSSL_WITH_PSK)
+	/* PSK of outgoing connection, in non-blocking mode PSK client callback */
+	/* can be called after zbx_tls_connect() has returned. For incoming    */
+	/* connection only PSK identity is set by PSK server callback.         */
+	char				*psk_identity;
+	char				*psk;
+	size_t				psk_len;
 #endif
+#endif
+	/* usage of PSK found for incoming connection by PSK server callback */
+	unsigned int			psk_usage;
+	/* key of outgoing connection session in TLS session cache, 0 if not cached */
+	zbx_uint64_t			session_key;
 } zbx_tls_context_t;
 #endif
 
@@ -204,12 +216,28 @@ void	zbx_gethost_by_ip(const char *ip, char *host, size_t hostlen);
 void	zbx_getip_by_host(const char *host, char *ip, size_t iplen);
 #endif
 
+void	zbx_tcp_dns_cache_enable(void);
+void	zbx_tcp_allowed_peers_cache_enable(void);
+
 int	zbx_tcp_connect(zbx_socket_t *s, const char *source_ip, const char *ip, unsigned short port, int timeout,
 		unsigned int tls_connect, const char *tls_arg1, const char *tls_arg2);
+int	zbx_tcp_connect_start(zbx_socket_t *s, const char *source_ip, const char *ip, unsigned short port,
+		int timeout);
+int	zbx_tcp_connect_check(zbx_socket_t *s);
+#if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
+int	zbx_tcp_tls_connect(zbx_socket_t *s, unsigned int tls_connect, const char *tls_arg1, const char *tls_arg2,
+		short *event);
+#endif
 
 #define ZBX_TCP_PROTOCOL		0x01
 #define ZBX_TCP_COMPRESS		0x02
 #define ZBX_TCP_LARGE			0x04
+/* compression codec flags, used together with ZBX_TCP_COMPRESS, zlib is used if none is set */
+#define ZBX_TCP_COMPRESS_ZSTD		0x08
+#define ZBX_TCP_COMPRESS_LZ4		0x10
+#define ZBX_TCP_COMPRESS_MASK		(ZBX_TCP_COMPRESS | ZBX_TCP_COMPRESS_ZSTD | ZBX_TCP_COMPRESS_LZ4)
+
+unsigned char	zbx_tcp_compress_flags(unsigned char codec);
 
 #define ZBX_TCP_SEC_UNENCRYPTED		1		/* do not use encryption with this socket */
 #define ZBX_TCP_SEC_TLS_PSK		2		/* use TLS with pre-shared key (PSK) with this socket */
@@ -229,6 +257,23 @@ const char	*zbx_tcp_connection_type_name(unsigned int type);
 int	zbx_tcp_send_ext(zbx_socket_t *s, const char *data, size_t len, size_t reserved, unsigned char flags,
 		int timeout);
 
+typedef struct
+{
+	const char	*data;
+	char		*compressed_data;
+	char		*header_buf;		/* protocol header followed by the first chunk of data */
+	size_t		header_len;
+	size_t		header_written;
+	size_t		send_len;
+	size_t		written;
+}
+zbx_tcp_send_context_t;
+
+int	zbx_tcp_send_context_init(const char *data, size_t len, size_t reserved, unsigned char flags,
+		zbx_tcp_send_context_t *context);
+void	zbx_tcp_send_context_clear(zbx_tcp_send_context_t *context);
+int	zbx_tcp_send_context(zbx_socket_t *s, zbx_tcp_send_context_t *context, short *event);
+
 void	zbx_tcp_close(zbx_socket_t *s);
 
 #ifdef HAVE_IPV6
@@ -241,6 +286,10 @@ void	zbx_tcp_unlisten(zbx_socket_t *s);
 int	zbx_tcp_accept(zbx_socket_t *s, unsigned int tls_accept, int poll_timeout);
 void	zbx_tcp_unaccept(zbx_socket_t *s);
 
+int	zbx_tcp_listen_nonblocking(zbx_socket_t *s);
+int	zbx_tcp_accept_start(const zbx_socket_t *listen_sock, ZBX_SOCKET listen_socket, zbx_socket_t *s);
+int	zbx_tcp_accept_check(zbx_socket_t *s, unsigned int tls_accept, short *event);
+
 #define ZBX_TCP_READ_UNTIL_CLOSE 0x01
 
 #define	zbx_tcp_recv(s)				SUCCEED_OR_FAIL(zbx_tcp_recv_ext(s, 0, 0))
@@ -248,9 +297,25 @@ void	zbx_tcp_unaccept(zbx_socket_t *s);
 #define	zbx_tcp_recv_to(s, timeout)		SUCCEED_OR_FAIL(zbx_tcp_recv_ext(s, timeout, 0))
 #define	zbx_tcp_recv_raw(s)			SUCCEED_OR_FAIL(zbx_tcp_recv_raw_ext(s, 0))
 
-ssize_t	zbx_tcp_read(zbx_socket_t *s, char *buf, size_t len);
-ssize_t	zbx_tcp_write(zbx_socket_t *s, const char *buf, size_t len);
+typedef struct
+{
+	size_t		buf_dyn_bytes;
+	size_t		buf_stat_bytes;
+	size_t		offset;
+	zbx_uint64_t	expected_len;
+	zbx_uint64_t	reserved;
+	zbx_uint64_t	max_len;
+	unsigned char	expect;
+	int		protocol_version;
+}
+zbx_tcp_recv_context_t;
+
+ssize_t	zbx_tcp_read(zbx_socket_t *s, char *buf, size_t len, short *event);
+ssize_t	zbx_tcp_write(zbx_socket_t *s, const char *buf, size_t len, short *event);
 ssize_t		zbx_tcp_recv_ext(zbx_socket_t *s, int timeout, unsigned char flags);
+void		zbx_tcp_recv_context_init(zbx_socket_t *s, zbx_tcp_recv_context_t *context, unsigned char flags);
+ssize_t		zbx_tcp_recv_context(zbx_socket_t *s, zbx_tcp_recv_context_t *context, unsigned char flags,
+		short *event);
 ssize_t		zbx_tcp_recv_raw_ext(zbx_socket_t *s, int timeout);
 const char	*zbx_tcp_recv_line(zbx_socket_t *s);
 
@@ -372,6 +437,24 @@ void	zbx_tls_free(void);
 void	zbx_tls_free_on_signal(void);
 void	zbx_tls_version(void);
 
+/* resumption statistics of certificate based TLS sessions */
+typedef struct
+{
+	zbx_uint64_t	client_hits;	/* resumed outgoing sessions */
+	zbx_uint64_t	client_misses;	/* full handshakes of outgoing connections */
+	zbx_uint64_t	server_hits;	/* resumed incoming sessions */
+	zbx_uint64_t	server_misses;	/* full handshakes of incoming connections */
+	zbx_uint64_t	sessions_num;	/* cached outgoing sessions */
+	zbx_uint64_t	slots_num;	/* session cache capacity */
+}
+zbx_tls_session_stats_t;
+
+#ifndef _WINDOWS
+int	zbx_tls_session_cache_init(zbx_uint64_t size, char **error);
+void	zbx_tls_session_cache_destroy(void);
+#endif
+int	zbx_tls_session_get_stats(zbx_tls_session_stats_t *stats, char **error);
+
 #endif	/* #if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL) */
 typedef struct
 {
@@ -389,7 +472,7 @@ int		zbx_tls_validate_attr(const zbx_socket_t *sock, const zbx_tls_conn_attr_t *
 				const char *tls_subject, const char *tls_psk_identity, const char **msg);
 int		zbx_check_server_issuer_subject(const zbx_socket_t *sock, const char *allowed_issuer,
 				const char *allowed_subject, char **error);
-unsigned int	zbx_tls_get_psk_usage(void);
+unsigned int	zbx_tls_get_psk_usage(const zbx_socket_t *s);
 
 /* TLS BLOCK END */
 
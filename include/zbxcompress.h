@@ -22,8 +22,24 @@
 
 #include "zbxtypes.h"
 
+/* compression codecs */
+#define ZBX_COMPRESS_ZLIB	0
+#define ZBX_COMPRESS_ZSTD	1
+#define ZBX_COMPRESS_LZ4	2
+
+#define ZBX_COMPRESS_NAME_ZLIB	"zlib"
+#define ZBX_COMPRESS_NAME_ZSTD	"zstd"
+#define ZBX_COMPRESS_NAME_LZ4	"lz4"
+
 int	zbx_compress(const char *in, size_t size_in, char **out, size_t *size_out);
 int	zbx_uncompress(const char *in, size_t size_in, char *out, size_t *size_out);
+int	zbx_compress_ext(unsigned char codec, const char *in, size_t size_in, char **out, size_t *size_out);
+int	zbx_uncompress_ext(unsigned char codec, const char *in, size_t size_in, char *out, size_t *size_out);
 const char	*zbx_compress_strerror(void);
 
+int		zbx_compress_codec_supported(unsigned char codec);
+const char	*zbx_compress_codec_name(unsigned char codec);
+const char	*zbx_compress_codecs(void);
+unsigned char	zbx_compress_select_codec(const char *codecs);
+
 #endif
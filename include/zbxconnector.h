@@ -37,6 +37,10 @@
 #define ZBX_IPC_CONNECTOR_QUEUE			8
 #define ZBX_IPC_CONNECTOR_QUEUE_RESULT		9
 
+/* the maximum number of requests delivered concurrently by one connector worker, */
+/* connector requests and results are prefixed with the worker task slot number   */
+#define ZBX_CONNECTOR_WORKER_TASKS_MAX		8
+
 typedef struct
 {
 	zbx_uint64_t		objectid;
@@ -59,6 +59,11 @@ typedef struct
 	char	*config_db_tls_cipher;
 	char	*config_db_tls_cipher_13;
 	int	config_dbport;
+	char	*config_dbreplica_host;
+	int	config_dbreplica_port;
+	int	config_dbreplica_max_lag;
+	int	config_db_idle_timeout;
+	int	config_db_prepared_inserts;
 }
 zbx_config_dbhigh_t;
 
@@ -83,6 +88,11 @@ void	zbx_db_init_autoincrement_options_basic(void);
 int	zbx_db_connect_basic(const zbx_config_dbhigh_t *cfg);
 void	zbx_db_close_basic(void);
 
+int	zbx_db_connect_replica_basic(const zbx_config_dbhigh_t *cfg);
+void	zbx_db_close_replica_basic(void);
+int	zbx_db_replica_switch_basic(void);
+void	zbx_db_replica_restore_basic(void);
+
 int	zbx_db_begin_basic(void);
 int	zbx_db_commit_basic(void);
 int	zbx_db_rollback_basic(void);
@@ -143,10 +153,18 @@ void	zbx_postgresql_escape_bin(const char *src, char **dst, size_t size);
 #endif
 
 int		zbx_db_vexecute(const char *fmt, va_list args);
+#if defined(HAVE_POSTGRESQL)
+int		zbx_db_copy_basic(const char *sql, const char *data, size_t data_len);
+#endif
+#if defined(HAVE_MYSQL) || defined(HAVE_POSTGRESQL) || defined(HAVE_SQLITE3)
+int		zbx_db_execute_prepared_basic(const char *sql, int params_num, const char * const *params);
+#endif
 zbx_db_result_t	zbx_db_vselect(const char *fmt, va_list args);
+zbx_db_result_t	zbx_db_vselect_stream(const char *fmt, va_list args);
 zbx_db_result_t	zbx_db_select_n_basic(const char *query, int n);
 
 zbx_db_row_t		zbx_db_fetch_basic(zbx_db_result_t result);
+int		zbx_db_get_row_num(zbx_db_result_t result);
 void		zbx_db_free_result(zbx_db_result_t result);
 int		zbx_db_is_null_basic(const char *field);
 
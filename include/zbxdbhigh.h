@@ -486,6 +486,10 @@ void	zbx_db_init_autoincrement_options(void);
 
 int	zbx_db_connect(int flag);
 void	zbx_db_close(void);
+void	zbx_db_release_idle(void);
+
+void	zbx_db_begin_replica_read(int clock);
+void	zbx_db_end_replica_read(void);
 
 int	zbx_db_validate_config_features(unsigned char program_type, const zbx_config_dbhigh_t *config_dbhigh);
 #if defined(HAVE_MYSQL) || defined(HAVE_POSTGRESQL)
@@ -500,6 +504,7 @@ int	zbx_db_check_oracle_colum_type(const char *table_name, const char *column_na
 int		zbx_db_execute(const char *fmt, ...) __zbx_attr_format_printf(1, 2);
 int		zbx_db_execute_once(const char *fmt, ...) __zbx_attr_format_printf(1, 2);
 zbx_db_result_t	zbx_db_select(const char *fmt, ...) __zbx_attr_format_printf(1, 2);
+zbx_db_result_t	zbx_db_select_stream(const char *fmt, ...) __zbx_attr_format_printf(1, 2);
 zbx_db_result_t	zbx_db_select_n(const char *query, int n);
 zbx_db_row_t	zbx_db_fetch(zbx_db_result_t result);
 int		zbx_db_is_null(const char *field);
@@ -614,6 +619,7 @@ typedef void	(*zbx_reset_event_recovery_func_t)(void);
 typedef void	(*zbx_export_events_func_t)(int events_export_enabled, zbx_vector_connector_filter_t *connector_filters,
 		unsigned char **data, size_t *data_alloc, size_t *data_offset);
 typedef void	(*zbx_events_update_itservices_func_t)(void);
+typedef void	(*zbx_events_notify_escalators_func_t)(void);
 
 typedef struct
 {
@@ -623,6 +629,7 @@ typedef struct
 	zbx_reset_event_recovery_func_t		reset_event_recovery_cb;
 	zbx_export_events_func_t		export_events_cb;
 	zbx_events_update_itservices_func_t	events_update_itservices_cb;
+	zbx_events_notify_escalators_func_t	events_notify_escalators_cb;
 } zbx_events_funcs_t;
 
 /* events callbacks end */
@@ -702,6 +709,11 @@ typedef struct
 	zbx_vector_ptr_t	rows;
 	/* index of autoincrement field */
 	int			autoincrement;
+	/* 1 - rows are inserted with COPY statement (PostgreSQL only), string values are not escaped */
+	unsigned char		copy;
+	/* 1 - rows are inserted with prepared statement (not on Oracle, MySQL and PostgreSQL need */
+	/* DBPreparedInserts), string values are not escaped */
+	unsigned char		prepared;
 }
 zbx_db_insert_t;
 
@@ -713,6 +725,7 @@ void	zbx_db_insert_add_values(zbx_db_insert_t *self, ...);
 int	zbx_db_insert_execute(zbx_db_insert_t *self);
 void	zbx_db_insert_clean(zbx_db_insert_t *self);
 void	zbx_db_insert_autoincrement(zbx_db_insert_t *self, const char *field_name);
+void	zbx_db_insert_use_copy(zbx_db_insert_t *self);
 int	zbx_db_get_database_type(void);
 
 typedef struct
@@ -27,9 +27,12 @@ typedef struct
 {
 	const zbx_events_funcs_t	*events_cbs;
 	int				config_histsyncer_frequency;
+	int				config_histsyncer_forks;
+	int				config_histsyncer_min;	/* 0 - all syncers are always active */
 }
 zbx_thread_dbsyncer_args;
 
 ZBX_THREAD_ENTRY(zbx_dbsyncer_thread, args);
+ZBX_THREAD_ENTRY(zbx_trendwriter_thread, args);
 
 #endif
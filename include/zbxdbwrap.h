@@ -53,7 +53,13 @@ int	zbx_proxy_check_permissions(const zbx_dc_proxy_t *proxy, const zbx_socket_t
 
 int	zbx_get_interface_availability_data(struct zbx_json *json, int *ts);
 
-int	zbx_proxy_get_hist_data(struct zbx_json *j, zbx_uint64_t *lastid, int *more);
+/* proxy history data formats */
+#define ZBX_PROXY_HISTORY_FORMAT_JSON	0
+#define ZBX_PROXY_HISTORY_FORMAT_BINARY	1
+
+int	zbx_proxy_get_hist_data(struct zbx_json *j, int format, zbx_uint64_t *lastid, int *more);
+int	zbx_proxy_get_hist_data_batches(struct zbx_json **jsons, int batches_num, int format, zbx_uint64_t *lastid,
+		zbx_uint64_t *firstids, int *more);
 int	zbx_proxy_get_dhis_data(struct zbx_json *j, zbx_uint64_t *lastid, int *more);
 int	zbx_proxy_get_areg_data(struct zbx_json *j, zbx_uint64_t *lastid, int *more);
 void	zbx_proxy_set_hist_lastid(const zbx_uint64_t lastid);
@@ -70,15 +76,31 @@ int	zbx_process_history_data(zbx_history_recv_item_t *items, zbx_agent_value_t *
 void	zbx_update_proxy_data(zbx_dc_proxy_t *proxy, char *version_str, int version_int, int lastaccess, int compress,
 		zbx_uint64_t flags_add);
 
-int	zbx_process_agent_history_data(zbx_socket_t *sock, struct zbx_json_parse *jp, zbx_timespec_t *ts, char **info);
+/* connection permissions of the last checked host */
+typedef struct
+{
+	zbx_uint64_t	hostid;
+	zbx_uint64_t	revision;
+	int		value;
+}
+zbx_host_rights_t;
+
+int	zbx_process_agent_history_data(zbx_socket_t *sock, struct zbx_json_parse *jp, zbx_timespec_t *ts,
+		zbx_host_rights_t *rights, char **info);
 int	zbx_process_sender_history_data(zbx_socket_t *sock, struct zbx_json_parse *jp, zbx_timespec_t *ts, char **info);
+void	zbx_history_data_arena_release(void);
 int	zbx_process_proxy_data(const zbx_dc_proxy_t *proxy, struct zbx_json_parse *jp, const zbx_timespec_t *ts,
 		unsigned char proxy_status, const zbx_events_funcs_t *events_cbs, int proxydata_frequency, int *more,
 		char **error);
 int	zbx_check_protocol_version(zbx_dc_proxy_t *proxy, int version);
 
+typedef struct zbx_template_link_cache zbx_template_link_cache_t;
+
+zbx_template_link_cache_t	*zbx_template_link_cache_create(void);
+void	zbx_template_link_cache_free(zbx_template_link_cache_t *cache);
+
 int	zbx_db_copy_template_elements(zbx_uint64_t hostid, zbx_vector_uint64_t *lnk_templateids,
-		zbx_host_template_link_type link_type, char **error);
+		zbx_host_template_link_type link_type, zbx_template_link_cache_t *cache, char **error);
 int	zbx_db_delete_template_elements(zbx_uint64_t hostid, const char *hostname, zbx_vector_uint64_t *del_templateids,
 		char **error);
 
@@ -35,7 +35,9 @@ typedef enum
 	ZBX_DIAGINFO_LLD,
 	ZBX_DIAGINFO_ALERTING,
 	ZBX_DIAGINFO_LOCKS,
-	ZBX_DIAGINFO_CONNECTOR
+	ZBX_DIAGINFO_CONNECTOR,
+	ZBX_DIAGINFO_DISCOVERY,
+	ZBX_DIAGINFO_PROFILING
 }
 zbx_diaginfo_section_t;
 
@@ -57,6 +59,8 @@ typedef int (*zbx_diag_add_section_info_func_t)(const char *section, const struc
 #define ZBX_DIAG_ALERTING	"alerting"
 #define ZBX_DIAG_LOCKS		"locks"
 #define ZBX_DIAG_CONNECTOR	"connector"
+#define ZBX_DIAG_DISCOVERY	"discovery"
+#define ZBX_DIAG_PROFILING	"profiling"
 
 void	zbx_diag_map_free(zbx_diag_map_t *map);
 int	zbx_diag_parse_request(const struct zbx_json_parse *jp, const zbx_diag_map_t *field_map, zbx_uint64_t
@@ -66,6 +70,8 @@ int	zbx_diag_add_historycache_info(const struct zbx_json_parse *jp, struct zbx_j
 int	zbx_diag_add_preproc_info(const struct zbx_json_parse *jp, struct zbx_json *json, char **error);
 void	zbx_diag_add_locks_info(struct zbx_json *json);
 int	zbx_diag_add_connector_info(const struct zbx_json_parse *jp, struct zbx_json *json, char **error);
+int	zbx_diag_add_discovery_info(const struct zbx_json_parse *jp, struct zbx_json *json, char **error);
+void	zbx_diag_add_profiling_info(struct zbx_json *json);
 
 void	zbx_diag_init(zbx_diag_add_section_info_func_t cb);
 int	zbx_diag_get_info(const struct zbx_json_parse *jp, char **info);
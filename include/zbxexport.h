@@ -28,9 +28,13 @@
 
 typedef struct
 {
-	char	*name;
-	FILE	*file;
-	int	missing;
+	char		*name;
+	int		fd;
+	int		missing;
+	zbx_uint64_t	size;		/* the export file size, not including buffered data */
+	char		*buffer;	/* the records buffered until flush */
+	size_t		buffer_alloc;
+	size_t		buffer_offset;
 }
 zbx_export_file_t;
 
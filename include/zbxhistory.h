@@ -59,6 +59,19 @@ int	zbx_history_add_values(const zbx_vector_ptr_t *history, int *ret_flush);
 int	zbx_history_get_values(zbx_uint64_t itemid, int value_type, int start, int count, int end,
 		zbx_vector_history_record_t *values);
 
+/* item history read request for batched reading */
+typedef struct
+{
+	zbx_uint64_t			itemid;
+	int				start;
+	int				end;
+	int				ret;
+	zbx_vector_history_record_t	values;
+}
+zbx_history_query_t;
+
+void	zbx_history_get_values_batch(zbx_history_query_t *queries, int queries_num, int value_type);
+
 int	zbx_history_requires_trends(int value_type);
 void	zbx_history_check_version(struct zbx_json *json, int *result);
 
@@ -67,6 +67,19 @@ char	*zbx_http_parse_header(char **headers);
 int	zbx_http_get(const char *url, const char *header, long timeout, const char *ssl_cert_file,
 		const char *ssl_key_file, char **out, long *response_code, char **error);
 
+typedef struct
+{
+	char		*url;
+	char		*out;
+	long		response_code;
+	char		*error;
+	int		ret;
+}
+zbx_http_get_request_t;
+
+void	zbx_http_get_multi(zbx_http_get_request_t *requests, int requests_num, const char *header, long timeout,
+		const char *ssl_cert_file, const char *ssl_key_file, int max_connections);
+
 #define HTTP_REQUEST_GET	0
 #define HTTP_REQUEST_POST	1
 #define HTTP_REQUEST_PUT	2
@@ -75,6 +88,30 @@ int	zbx_http_get(const char *url, const char *header, long timeout, const char *
 #define HTTP_STORE_RAW		0
 #define HTTP_STORE_JSON		1
 
+typedef struct
+{
+	CURL			*easyhandle;
+	struct curl_slist	*headers_slist;
+	zbx_http_response_t	header;
+	zbx_http_response_t	body;
+	char			errbuf[CURL_ERROR_SIZE];
+	int			max_attempts;
+	unsigned char		retrieve_mode;
+	unsigned char		output_format;
+}
+zbx_http_context_t;
+
+void	zbx_http_context_create(zbx_http_context_t *context);
+void	zbx_http_context_destroy(zbx_http_context_t *context);
+int	zbx_http_request_prepare(zbx_http_context_t *context, unsigned char request_method, const char *url,
+		const char *query_fields, char *headers, const char *posts, unsigned char retrieve_mode,
+		const char *http_proxy, unsigned char follow_redirects, const char *timeout, int max_attempts,
+		const char *ssl_cert_file, const char *ssl_key_file, const char *ssl_key_password,
+		unsigned char verify_peer, unsigned char verify_host, unsigned char authtype, const char *username,
+		const char *password, const char *token, unsigned char post_type, unsigned char output_format,
+		char **error);
+int	zbx_http_handle_response(zbx_http_context_t *context, CURLcode err, char *status_codes, char **out,
+		char **error);
 int	zbx_http_request(unsigned char request_method, const char *url, const char *query_fields, char *headers,
 		const char *posts, unsigned char retrieve_mode, const char *http_proxy, unsigned char follow_redirects,
 		const char *timeout, int max_attempts, const char *ssl_cert_file, const char *ssl_key_file,
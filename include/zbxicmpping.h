@@ -30,6 +30,7 @@ typedef struct
 	zbx_get_config_str_f	get_fping6_location;
 #endif
 	zbx_get_config_str_f	get_tmpdir;
+	zbx_get_config_int_f	get_native_icmpping;
 }
 zbx_config_icmpping_t;
 
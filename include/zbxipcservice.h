@@ -55,6 +55,12 @@ typedef struct
 	unsigned char	rx_buffer[ZBX_IPC_SOCKET_BUFFER_SIZE];
 	zbx_uint32_t	rx_buffer_bytes;
 	zbx_uint32_t	rx_buffer_offset;
+
+	/* coalesced outgoing messages, see zbx_ipc_socket_write_batch() */
+	unsigned char	*tx_batch;
+	zbx_uint32_t	tx_batch_size;
+	zbx_uint32_t	tx_batch_alloc;
+	double		tx_batch_time;
 }
 zbx_ipc_socket_t;
 
@@ -116,6 +122,9 @@ int	zbx_ipc_socket_open(zbx_ipc_socket_t *csocket, const char *service_name, int
 void	zbx_ipc_socket_close(zbx_ipc_socket_t *csocket);
 int	zbx_ipc_socket_write(zbx_ipc_socket_t *csocket, zbx_uint32_t code, const unsigned char *data,
 		zbx_uint32_t size);
+int	zbx_ipc_socket_write_batch(zbx_ipc_socket_t *csocket, zbx_uint32_t code, const unsigned char *data,
+		zbx_uint32_t size);
+int	zbx_ipc_socket_flush(zbx_ipc_socket_t *csocket);
 int	zbx_ipc_socket_read(zbx_ipc_socket_t *csocket, zbx_ipc_message_t *message);
 int	zbx_ipc_socket_connected(const zbx_ipc_socket_t *csocket);
 
@@ -200,16 +200,23 @@
 #define ZBX_PROTO_TAG_PROXY_HOSTIDS		"proxy_hostids"
 #define ZBX_PROTO_TAG_SUPPRESS_UNTIL		"suppress_until"
 #define ZBX_PROTO_TAG_CONFIG_REVISION		"config_revision"
+#define ZBX_PROTO_TAG_CONFIG_DELTA		"config_delta"
+#define ZBX_PROTO_TAG_UNCHANGED_ITEMIDS		"unchanged_itemids"
 #define ZBX_PROTO_TAG_FULL_SYNC			"full_sync"
 #define ZBX_PROTO_TAG_MACRO_SECRETS		"macro.secrets"
 #define ZBX_PROTO_TAG_REMOVED_HOSTIDS		"del_hostids"
 #define ZBX_PROTO_TAG_REMOVED_MACRO_HOSTIDS	"del_macro_hostids"
 #define ZBX_PROTO_TAG_ACKNOWLEDGEID		"acknowledgeid"
+#define ZBX_PROTO_TAG_HISTORY_FORMAT		"history_format"
+#define ZBX_PROTO_TAG_COMPRESSION		"compression"
+#define ZBX_PROTO_TAG_HISTORY_DATA_BINARY	"history data binary"
+#define ZBX_PROTO_TAG_PERSISTENT		"persistent"
 
 #define ZBX_PROTO_VALUE_FAILED		"failed"
 #define ZBX_PROTO_VALUE_SUCCESS		"success"
 
 #define ZBX_PROTO_VALUE_GET_ACTIVE_CHECKS	"active checks"
+#define ZBX_PROTO_VALUE_GET_PASSIVE_CHECKS	"passive checks"
 #define ZBX_PROTO_VALUE_PROXY_CONFIG		"proxy config"
 #define ZBX_PROTO_VALUE_PROXY_HEARTBEAT		"proxy heartbeat"
 #define ZBX_PROTO_VALUE_SENDER_DATA		"sender data"
@@ -241,6 +248,8 @@
 #define ZBX_PROTO_VALUE_PROXY_UPLOAD_ENABLED	"enabled"
 #define ZBX_PROTO_VALUE_PROXY_UPLOAD_DISABLED	"disabled"
 
+#define ZBX_PROTO_VALUE_HISTORY_FORMAT_BINARY	"binary"
+
 #define ZBX_PROTO_VALUE_REPORT_TEST		"report.test"
 
 #define ZBX_PROTO_VALUE_SUPPRESSION_SUPPRESS	"suppress"
@@ -360,6 +369,8 @@ typedef struct
 }
 zbx_jsonobj_index_t;
 
+typedef struct zbx_jsonobj_arena zbx_jsonobj_arena_t;
+
 struct zbx_jsonobj
 {
 	zbx_json_type_t		type;
@@ -367,6 +378,11 @@ struct zbx_jsonobj
 
 	zbx_jsonobj_index_t	*index;
 	int			index_num;	/* used by root object - number of indexed children */
+
+	const char		*lazy;		/* unparsed object or array data of lazily opened json, */
+						/* NULL when the object is parsed                       */
+
+	zbx_jsonobj_arena_t	*arena;		/* used by root object - memory of the whole object tree */
 };
 
 typedef struct
@@ -378,11 +394,15 @@ zbx_jsonobj_el_t;
 
 int	zbx_jsonpath_compile(const char *path, zbx_jsonpath_t *jsonpath);
 int	zbx_jsonpath_query(const struct zbx_json_parse *jp, const char *path, char **output);
+int	zbx_jsonpath_query_ext(const struct zbx_json_parse *jp, zbx_jsonpath_t *jsonpath, char **output);
 void	zbx_jsonpath_clear(zbx_jsonpath_t *jsonpath);
 
 int	zbx_jsonobj_open(const char *data, zbx_jsonobj_t *obj);
+int	zbx_jsonobj_open_lazy(const char *data, zbx_jsonobj_t *obj);
+int	zbx_jsonobj_open_arena(const char *data, zbx_jsonobj_t *obj);
 void	zbx_jsonobj_clear(zbx_jsonobj_t *obj);
 int	zbx_jsonobj_query(zbx_jsonobj_t *obj, const char *path, char **output);
+int	zbx_jsonobj_query_ext(zbx_jsonobj_t *obj, zbx_jsonpath_t *jsonpath, char **output);
 int	zbx_jsonobj_to_string(char **str, size_t *str_alloc, size_t *str_offset, zbx_jsonobj_t *obj);
 
 void	zbx_jsonobj_disable_indexing(zbx_jsonobj_t *obj);
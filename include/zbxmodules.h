@@ -64,12 +64,21 @@ typedef struct
 }
 zbx_history_log_cb_t;
 
+typedef struct
+{
+	zbx_module_t			*module;
+	ZBX_HISTORY_WRITE_CBS_V2	cbs;
+}
+zbx_history_write_cbs_v2_t;
+
 extern zbx_history_float_cb_t	*history_float_cbs;
 extern zbx_history_integer_cb_t	*history_integer_cbs;
 extern zbx_history_string_cb_t	*history_string_cbs;
 extern zbx_history_text_cb_t	*history_text_cbs;
 extern zbx_history_log_cb_t	*history_log_cbs;
 
+extern zbx_history_write_cbs_v2_t	*history_write_cbs_v2;
+
 int	zbx_load_modules(const char *path, char **file_names, int timeout, int verbose);
 void	zbx_unload_modules(void);
 
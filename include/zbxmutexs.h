@@ -35,6 +35,11 @@ typedef HANDLE zbx_mutex_t;
 #	define zbx_mutex_lock(mutex)		__zbx_mutex_lock(__FILE__, __LINE__, mutex)
 #	define zbx_mutex_unlock(mutex)		__zbx_mutex_unlock(__FILE__, __LINE__, mutex)
 #else	/* not _WINDOWS */
+/* the first history cache shard is protected by ZBX_MUTEX_CACHE, the rest by ZBX_MUTEX_CACHE_SHARD + (shard - 1) */
+#define ZBX_MUTEX_CACHE_SHARDS_NUM	15
+/* value cache items are protected by ZBX_MUTEX_VALUECACHE_ITEM + (itemid % ZBX_MUTEX_VALUECACHE_ITEMS_NUM) */
+#define ZBX_MUTEX_VALUECACHE_ITEMS_NUM	16
+
 typedef enum
 {
 	ZBX_MUTEX_LOG = 0,
@@ -54,7 +59,14 @@ typedef enum
 #endif
 	ZBX_MUTEX_MODBUS,
 	ZBX_MUTEX_TREND_FUNC,
-	/* NOTE: Do not forget to sync changes here with mutex names in diag_add_locks_info()! */
+	ZBX_MUTEX_CACHE_INGEST,
+	ZBX_MUTEX_PROXY_BUFFER,
+	ZBX_MUTEX_TLS_SESSION,
+	ZBX_MUTEX_CACHE_SHARD,
+	ZBX_MUTEX_CACHE_SHARD_LAST = ZBX_MUTEX_CACHE_SHARD + ZBX_MUTEX_CACHE_SHARDS_NUM - 1,
+	ZBX_MUTEX_VALUECACHE_ITEM,
+	ZBX_MUTEX_VALUECACHE_ITEM_LAST = ZBX_MUTEX_VALUECACHE_ITEM + ZBX_MUTEX_VALUECACHE_ITEMS_NUM - 1,
+	/* NOTE: Do not forget to sync changes here with mutex names in mutexs.c! */
 	ZBX_MUTEX_COUNT
 }
 zbx_mutex_name_t;
@@ -154,6 +166,28 @@ int		zbx_rwlock_create(zbx_rwlock_t *rwlock, zbx_rwlock_name_t name, char **erro
 zbx_mutex_t	zbx_mutex_addr_get(zbx_mutex_name_t mutex_name);
 zbx_rwlock_t	zbx_rwlock_addr_get(zbx_rwlock_name_t rwlock_name);
 
+/* locks are numbered by mutexes followed by read-write locks (ZBX_MUTEX_COUNT + rwlock name) */
+#define ZBX_LOCKS_NUM			(ZBX_MUTEX_COUNT + ZBX_RWLOCK_COUNT)
+
+/* bucket i counts hold times below 2^i nanoseconds, the last bucket counts all longer hold times */
+#define ZBX_LOCK_HOLD_BUCKETS_NUM	32
+
+typedef struct
+{
+	zbx_uint64_t	locks;		/* number of acquisitions */
+	zbx_uint64_t	contended;	/* number of acquisitions that had to wait */
+	zbx_uint64_t	wait_ns;	/* total time waited for contended acquisitions */
+	zbx_uint64_t	wait_max_ns;
+	zbx_uint64_t	hold_ns;	/* total time the lock was held */
+	zbx_uint64_t	hold_buckets[ZBX_LOCK_HOLD_BUCKETS_NUM];
+}
+zbx_lock_stats_t;
+
+void	zbx_lock_name_get(int lock, char *name, size_t size);
+int	zbx_lock_get_by_name(const char *name);
+int	zbx_lock_get_stats(int lock, zbx_lock_stats_t *stats);
+double	zbx_lock_stats_hold_percentile(const zbx_lock_stats_t *stats, double percentile);
+
 #	define zbx_mutex_lock(mutex)					\
 									\
 	do								\
@@ -183,4 +217,11 @@ void	zbx_mutex_destroy(zbx_mutex_t *mutex);
 zbx_mutex_name_t	zbx_mutex_create_per_process_name(const zbx_mutex_name_t prefix);
 #endif
 
+#if defined(HAVE_ATOMIC_BUILTINS)
+/* atomic operations for data shared between processes without locking */
+#	define zbx_atomic_load(ptr)		__atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+#	define zbx_atomic_store(ptr, value)	__atomic_store_n(ptr, value, __ATOMIC_RELEASE)
+#	define zbx_atomic_add(ptr, value)	__atomic_add_fetch(ptr, value, __ATOMIC_RELAXED)
+#endif
+
 #endif	/* ZABBIX_MUTEXS_H */
@@ -27,6 +27,8 @@
 #include "zbxipcservice.h"
 #include "zbxthreads.h"
 #include "zbxjson.h"
+#include "zbxprometheus.h"
+#include "zbxregexp.h"
 #include "zbxstats.h"
 
 #define ZBX_PREPROCESSING_BATCH_SIZE	256
@@ -66,14 +68,22 @@ zbx_pp_process_mode_t;
 
 typedef struct
 {
-	int	type;
-	int	error_handler;
-	char	*params;
-	char	*error_handler_params;
+	int		type;
+	int		error_handler;
+	char		*params;
+	char		*error_handler_params;
+	zbx_jsonpath_t	*jsonpath;	/* compiled jsonpath of jsonpath steps, NULL if not compiled */
+
+	/* prepared filter of prometheus pattern steps, NULL if not compiled */
+	zbx_prometheus_filter_t	*prometheus;
+
+	/* compiled expression of xpath steps, NULL if not compiled, see zbxxml.h */
+	struct zbx_xpath	*xpath;
 }
 zbx_pp_step_t;
 
 void	zbx_pp_step_free(zbx_pp_step_t *step);
+void	zbx_pp_step_compile(zbx_pp_step_t *step);
 
 ZBX_PTR_VECTOR_DECL(pp_step_ptr, zbx_pp_step_t *)
 
@@ -170,7 +180,9 @@ typedef struct zbx_pp_manager	zbx_pp_manager_t;
 typedef void(*zbx_flush_value_func_t)(zbx_pp_manager_t *manager, zbx_uint64_t itemid, unsigned char value_type,
 	unsigned char flags, zbx_variant_t *value, zbx_timespec_t ts, zbx_pp_value_opt_t *value_opt);
 
-void	zbx_init_library_preproc(zbx_flush_value_func_t flush_value_cb);
+typedef void(*zbx_flush_values_func_t)(void);
+
+void	zbx_init_library_preproc(zbx_flush_value_func_t flush_value_cb, zbx_flush_values_func_t flush_values_cb);
 
 void	zbx_pp_value_task_get_data(zbx_pp_task_t *task, unsigned char *value_type, unsigned char *flags,
 		zbx_variant_t **value, zbx_timespec_t *ts, zbx_pp_value_opt_t **value_opt);
@@ -201,6 +213,17 @@ zbx_uint64_t	zbx_pp_manager_get_pending_num(zbx_pp_manager_t *manager);
 void	zbx_pp_manager_get_diag_stats(zbx_pp_manager_t *manager, zbx_uint64_t *preproc_num, zbx_uint64_t *pending_num,
 		zbx_uint64_t *finished_num, zbx_uint64_t *sequences_num);
 
+typedef struct
+{
+	zbx_uint64_t	scripts_num;	/* the number of cached script bytecodes */
+	zbx_uint64_t	compiled_num;	/* the number of script compilations */
+	zbx_uint64_t	hits_num;	/* the number of script bytecode cache hits */
+	zbx_uint64_t	resets_num;	/* the number of scripting environment resets after fatal errors */
+}
+zbx_pp_script_stats_t;
+
+void	zbx_pp_manager_get_script_stats(zbx_pp_manager_t *manager, zbx_pp_script_stats_t *stats);
+
 typedef struct
 {
 	zbx_uint64_t	itemid;
@@ -212,7 +235,8 @@ ZBX_PTR_VECTOR_DECL(pp_sequence_stats_ptr, zbx_pp_sequence_stats_t *)
 
 void	zbx_pp_manager_get_sequence_stats(zbx_pp_manager_t *manager, zbx_vector_pp_sequence_stats_ptr_t *sequences);
 
-void	zbx_pp_manager_get_worker_usage(zbx_pp_manager_t *manager, zbx_vector_dbl_t *worker_usage);
+void	zbx_pp_manager_get_worker_usage(zbx_pp_manager_t *manager, zbx_vector_dbl_t *worker_usage,
+		zbx_vector_uint64_t *worker_steals, zbx_vector_uint64_t *worker_idles);
 void	zbx_pp_manager_change_worker_loglevel(zbx_pp_manager_t *manager, int worker_num, int direction);
 
 void zbx_preproc_stats_ext_get(struct zbx_json *json, const void *arg);
@@ -222,12 +246,14 @@ void	zbx_preprocess_item_value(zbx_uint64_t itemid, zbx_uint64_t hostid, unsigne
 		unsigned char item_flags, AGENT_RESULT *result, zbx_timespec_t *ts, unsigned char state, char *error);
 void	zbx_preprocessor_flush(void);
 int	zbx_preprocessor_get_diag_stats(zbx_uint64_t *preproc_num, zbx_uint64_t *pending_num,
-		zbx_uint64_t *finished_num, zbx_uint64_t *sequences_num, char **error);
+		zbx_uint64_t *finished_num, zbx_uint64_t *sequences_num, zbx_pp_script_stats_t *scripts,
+		zbx_regexp_cache_stats_t *regexps, char **error);
 int	zbx_preprocessor_get_top_sequences(int limit, zbx_vector_pp_sequence_stats_ptr_t *sequences, char **error);
 int	zbx_preprocessor_test(unsigned char value_type, const char *value, const zbx_timespec_t *ts,
 		unsigned char state, const zbx_vector_pp_step_ptr_t *steps, zbx_vector_pp_result_ptr_t *results,
 		zbx_pp_history_t *history, char **error);
 int	zbx_preprocessor_get_usage_stats(zbx_vector_dbl_t *usage, int *count, char **error);
+int	zbx_preprocessor_get_worker_stats(zbx_vector_uint64_t *steals, zbx_vector_uint64_t *idles, char **error);
 
 ZBX_THREAD_ENTRY(zbx_pp_manager_thread, args);
 
@@ -20,6 +20,8 @@
 #ifndef ZABBIX_PROF_H
 #define ZABBIX_PROF_H
 
+#include "zbxcommon.h"
+
 #define ZBX_PROF_UNKNOWN	0x00
 #define ZBX_PROF_PROCESSING	0x01
 #define ZBX_PROF_RWLOCK		0x02
@@ -35,4 +37,45 @@ void	zbx_prof_end_wait(void);
 void	zbx_prof_end(void);
 void	zbx_prof_update(const char *info, double time_now);
 
+/* always-on latency probes of hot paths, shared by all processes */
+#define ZBX_PROF_PROBE_HISTORY_SYNC	0
+#define ZBX_PROF_PROBE_POLLER		1
+#define ZBX_PROF_PROBE_PREPROCESSING	2
+#define ZBX_PROF_PROBE_DB_QUERY		3
+#define ZBX_PROF_PROBE_COUNT		4
+
+/* bucket i counts durations below 2^i microseconds (and not below 2^(i-1)), */
+/* the last bucket counts all longer durations                               */
+#define ZBX_PROF_PROBE_BUCKETS_NUM	32
+
+typedef struct
+{
+	zbx_uint64_t	count;
+	zbx_uint64_t	total_us;
+	zbx_uint64_t	buckets[ZBX_PROF_PROBE_BUCKETS_NUM];
+}
+zbx_prof_probe_stats_t;
+
+/* stages of value processing, latency is measured from the value timestamp */
+#define ZBX_PROF_VALUE_SYNC		0	/* value was taken from history cache by history syncer */
+#define ZBX_PROF_VALUE_HISTORY		1	/* value was written to history storage */
+#define ZBX_PROF_VALUE_TRIGGERS		2	/* triggers were recalculated with the value */
+#define ZBX_PROF_VALUE_STAGE_COUNT	3
+
+#define ZBX_PROF_ITEM_TYPES_NUM		(ITEM_TYPE_SCRIPT + 1)
+
+int	zbx_prof_probes_init(char **error);
+void	zbx_prof_probes_destroy(void);
+int	zbx_prof_probes_enabled(void);
+void	zbx_prof_probe_add(int probe, double sec);
+int	zbx_prof_probe_get_stats(int probe, zbx_prof_probe_stats_t *stats);
+int	zbx_prof_probe_by_name(const char *name);
+const char	*zbx_prof_probe_name(int probe);
+double	zbx_prof_probe_percentile(const zbx_prof_probe_stats_t *stats, double percentile);
+
+void	zbx_prof_value_latency_add(int stage, unsigned char item_type, double sec);
+int	zbx_prof_value_latency_get_stats(int stage, int item_type, zbx_prof_probe_stats_t *stats);
+int	zbx_prof_value_stage_by_name(const char *name);
+const char	*zbx_prof_value_stage_name(int stage);
+
 #endif
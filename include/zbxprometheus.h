@@ -54,15 +54,23 @@ ZBX_PTR_VECTOR_DECL(prometheus_label_index, zbx_prometheus_label_index_t *)
 typedef struct
 {
 	zbx_vector_prometheus_row_t		rows;
+	zbx_hashset_t				metrics;	/* rows grouped by metric name */
 	zbx_vector_prometheus_label_index_t	indexes;
 	pthread_rwlock_t			index_lock;
 }
 zbx_prometheus_t;
 
+typedef struct zbx_prometheus_filter	zbx_prometheus_filter_t;
+
+int	zbx_prometheus_filter_create(const char *data, zbx_prometheus_filter_t **filter, char **error);
+void	zbx_prometheus_filter_free(zbx_prometheus_filter_t *filter);
+
 int	zbx_prometheus_init(zbx_prometheus_t *prom, const char *data, char **error);
 void	zbx_prometheus_clear(zbx_prometheus_t *prom);
 int	zbx_prometheus_pattern_ex(zbx_prometheus_t *prom, const char *filter_data, const char *request,
 		const char *output, char **value, char **error);
+int	zbx_prometheus_pattern_prepared(zbx_prometheus_t *prom, const zbx_prometheus_filter_t *filter,
+		const char *request, const char *output, char **value, char **error);
 
 int	zbx_prometheus_pattern(const char *data, const char *filter_data, const char *request, const char *output,
 		char **value, char **error);
@@ -41,10 +41,18 @@ zbx_expression_t;
 
 ZBX_PTR_VECTOR_DECL(expression, zbx_expression_t *)
 
+typedef struct
+{
+	zbx_uint64_t	hits_num;	/* the number of compiled regexp cache hits */
+	zbx_uint64_t	misses_num;	/* the number of regexp compilations by cache */
+}
+zbx_regexp_cache_stats_t;
+
 /* regular expressions */
 int	zbx_regexp_compile(const char *pattern, zbx_regexp_t **regexp, const char **err_msg);
 int	zbx_regexp_compile_ext(const char *pattern, zbx_regexp_t **regexp, int flags, const char **err_msg);
 void	zbx_regexp_free(zbx_regexp_t *regexp);
+void	zbx_regexp_get_cache_stats(zbx_regexp_cache_stats_t *stats);
 int	zbx_regexp_match_precompiled(const char *string, const zbx_regexp_t *regexp);
 char	*zbx_regexp_match(const char *string, const char *pattern, int *len);
 int	zbx_regexp_sub(const char *string, const char *pattern, const char *output_template, char **out);
@@ -63,6 +71,7 @@ int	zbx_regexp_sub_ex(const zbx_vector_expression_t *regexps, const char *string
 		int case_sensitive, const char *output_template, char **output);
 int	zbx_global_regexp_exists(const char *name, const zbx_vector_expression_t *regexps);
 void	zbx_regexp_escape(char **string);
+char	*zbx_regexp_get_literal(const char *pattern);
 
 /* wildcards */
 void	zbx_wildcard_minimize(char *str);
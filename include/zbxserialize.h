@@ -139,4 +139,11 @@
 zbx_uint32_t	zbx_serialize_uint31_compact(unsigned char *ptr, zbx_uint32_t value);
 zbx_uint32_t	zbx_deserialize_uint31_compact(const unsigned char *ptr, zbx_uint32_t *value);
 
+/* the maximum number of bytes used by compact 64 bit unsigned integer serialization */
+#define ZBX_SERIALIZE_UINT64_COMPACT_MAX	10
+
+zbx_uint32_t	zbx_serialize_uint64_compact(unsigned char *ptr, zbx_uint64_t value);
+zbx_uint32_t	zbx_deserialize_uint64_compact(const unsigned char *ptr, const unsigned char *end,
+		zbx_uint64_t *value);
+
 #endif /* ZABBIX_SERIALIZE_H */
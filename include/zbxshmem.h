@@ -25,8 +25,10 @@
 #define SHMEM_MIN_ALLOC	24		/* should be a multiple of 8 and at least (2 * ZBX_PTR_SIZE) */
 
 #define ZBX_SHMEM_MIN_BUCKET_SIZE	SHMEM_MIN_ALLOC
-#define SHMEM_MAX_BUCKET_SIZE		256 /* starting from this size all free chunks are put into the same bucket */
-#define ZBX_SHMEM_BUCKET_COUNT		((SHMEM_MAX_BUCKET_SIZE - ZBX_SHMEM_MIN_BUCKET_SIZE) / 8 + 1)
+#define SHMEM_MAX_BUCKET_SIZE		256 /* starting from this size free chunks are put into buckets by power of 2 */
+#define ZBX_SHMEM_EXACT_BUCKET_COUNT	((SHMEM_MAX_BUCKET_SIZE - ZBX_SHMEM_MIN_BUCKET_SIZE) / 8)
+#define ZBX_SHMEM_RANGE_BUCKET_COUNT	23  /* 256 bytes, 512 bytes, ... 1 GB and larger */
+#define ZBX_SHMEM_BUCKET_COUNT		(ZBX_SHMEM_EXACT_BUCKET_COUNT + ZBX_SHMEM_RANGE_BUCKET_COUNT)
 
 typedef struct
 {
@@ -63,6 +65,8 @@ typedef struct
 }
 zbx_shmem_stats_t;
 
+void	zbx_shmem_set_huge_pages(int enable);
+
 int	zbx_shmem_create(zbx_shmem_info_t **info, zbx_uint64_t size, const char *descr, const char *param,
 		int allow_oom, char **error);
 int	zbx_shmem_create_min(zbx_shmem_info_t **info, zbx_uint64_t size, const char *descr, const char *param,
@@ -91,6 +95,7 @@ void	zbx_shmem_dump_stats(int level, zbx_shmem_info_t *info);
 
 size_t		zbx_shmem_required_size(int chunks_num, const char *descr, const char *param);
 zbx_uint64_t	zbx_shmem_required_chunk_size(zbx_uint64_t size);
+zbx_uint64_t	zbx_shmem_bucket_size(int index);
 
 #define ZBX_SHMEM_FUNC1_DECL_MALLOC(__prefix)				\
 static void	*__prefix ## _shmem_malloc_func(void *old, size_t size)
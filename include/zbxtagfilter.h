@@ -36,4 +36,34 @@ int	zbx_match_tags(int eval_type, const zbx_vector_match_tags_t *match_tags, con
 int	zbx_compare_match_tags(const void *d1, const void *d2);
 void	zbx_match_tag_free(zbx_match_tag_t *tag);
 
+typedef struct
+{
+	int				eval_type;
+	const zbx_vector_match_tags_t	*match_tags;
+}
+zbx_match_tags_filter_t;
+
+ZBX_VECTOR_DECL(match_tags_filter, zbx_match_tags_filter_t)
+
+/* tag filter index, used to match entity tags against many filters at once */
+typedef struct
+{
+	/* the indexed filters, the match tags are referenced, not copied */
+	zbx_vector_match_tags_filter_t	filters;
+
+	/* filters that can match only entities having tag with the indexed name */
+	zbx_hashset_t			names;
+
+	/* filters that must be checked for all entities */
+	zbx_vector_uint32_t		always;
+}
+zbx_match_tags_index_t;
+
+void	zbx_match_tags_index_init(zbx_match_tags_index_t *index);
+void	zbx_match_tags_index_destroy(zbx_match_tags_index_t *index);
+void	zbx_match_tags_index_add(zbx_match_tags_index_t *index, int eval_type,
+		const zbx_vector_match_tags_t *match_tags);
+void	zbx_match_tags_index_match(const zbx_match_tags_index_t *index, const zbx_vector_tags_t *entity_tags,
+		zbx_vector_uint32_t *filters);
+
 #endif /* ZABBIX_TAGFILTER_H */
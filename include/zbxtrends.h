@@ -51,6 +51,11 @@ typedef struct
 }
 ZBX_DC_TREND;
 
+/* Trends are additionally aggregated by UTC days into <trends table>_day tables */
+/* used by trend functions for the days fully covered by the requested period.  */
+#define ZBX_TRENDS_ROLLUP_PERIOD	SEC_PER_DAY
+#define ZBX_TRENDS_ROLLUP_SUFFIX	"_day"
+
 int	zbx_trends_parse_base(const char *params, zbx_time_unit_t *base, char **error);
 int	zbx_trends_parse_timeshift(time_t from, const char *timeshift, struct tm *tm, char **error);
 
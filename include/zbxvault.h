@@ -30,11 +30,23 @@ typedef struct
 	char	*tls_cert_file;
 	char	*tls_key_file;
 	char	*db_path;
+	int	secrets_ttl;
 }
 zbx_config_vault_t;
 
+typedef struct
+{
+	const char	*path;
+	zbx_kvs_t	kvs;
+	char		*error;
+	int		ret;
+}
+zbx_vault_kvs_request_t;
+
 int	zbx_vault_init(const zbx_config_vault_t *config_vault, char **error);
 int	zbx_vault_kvs_get(const char *path, zbx_kvs_t *kvs, const zbx_config_vault_t *config_vault, char **error);
+void	zbx_vault_kvs_get_multi(zbx_vault_kvs_request_t *requests, int requests_num,
+		const zbx_config_vault_t *config_vault);
 int	zbx_vault_db_credentials_get(const zbx_config_vault_t *config_vault, char **dbuser, char **dbpassword,
 		char **error);
 
@@ -33,6 +33,16 @@ void	zbx_xml_free_data_dyn(char **data);
 char	*zbx_xml_escape_dyn(const char *data);
 void	zbx_xml_escape_xpath(char **data);
 
+typedef struct zbx_xml_doc	zbx_xml_doc_t;
+typedef struct zbx_xpath	zbx_xpath_t;
+
+int	zbx_xml_doc_parse(const char *data, zbx_xml_doc_t **doc, char **errmsg);
+void	zbx_xml_doc_free(zbx_xml_doc_t *doc);
+int	zbx_xml_doc_query_xpath(const zbx_xml_doc_t *doc, const char *params, const zbx_xpath_t *xpath,
+		zbx_variant_t *value, char **errmsg);
+int	zbx_xpath_compile(const char *expression, zbx_xpath_t **xpath, char **errmsg);
+void	zbx_xpath_free(zbx_xpath_t *xpath);
+
 int	zbx_query_xpath(zbx_variant_t *value, const char *params, char **errmsg);
 
 #ifdef HAVE_LIBXML2
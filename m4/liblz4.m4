@@ -0,0 +1,103 @@
+# LIBLZ4_CHECK_CONFIG ([DEFAULT-ACTION])
+# ----------------------------------------------------------
+#
+# Checks for LZ4 compression library.  DEFAULT-ACTION is the string
+# yes or no to specify whether to default to --with-lz4 or --without-lz4.
+# If not supplied, DEFAULT-ACTION is no.
+#
+# This macro #defines HAVE_LZ4 if a required header files are
+# found, and sets @LZ4_LDFLAGS@, @LZ4_CFLAGS@ and @LZ4_LIBS@
+# to the necessary values.
+#
+# This macro is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+AC_DEFUN([LIBLZ4_TRY_LINK],
+[
+AC_LINK_IFELSE([AC_LANG_PROGRAM([[
+#include <lz4.h>
+]], [[
+	char	out[64];
+
+	LZ4_compress_default("lz4", out, 3, sizeof(out));
+]])],[found_lz4="yes"],[])
+])dnl
+
+AC_DEFUN([LIBLZ4_CHECK_CONFIG],
+[
+  AC_ARG_WITH(lz4,[
+If you want to use LZ4 compression of Zabbix protocol:
+AS_HELP_STRING([--with-lz4@<:@=DIR@:>@],[use LZ4 library @<:@default=no@:>@, DIR is the LZ4 library install directory.])],
+    [
+	if test "$withval" = "no"; then
+	    want_lz4="no"
+	    _liblz4_dir="no"
+	elif test "$withval" = "yes"; then
+	    want_lz4="yes"
+	    _liblz4_dir="no"
+	else
+	    want_lz4="yes"
+	    _liblz4_dir=$withval
+	fi
+    ],[want_lz4=ifelse([$1],,[no],[$1])]
+  )
+
+  if test "x$want_lz4" = "xyes"; then
+     AC_MSG_CHECKING(for LZ4 support)
+     LZ4_LIBS="-llz4"
+
+     if test "x$_liblz4_dir" = "xno"; then
+       if test -f /usr/include/lz4.h; then
+         found_lz4="yes"
+       elif test -f /usr/local/include/lz4.h; then
+         LZ4_CFLAGS=-I/usr/local/include
+         LZ4_LDFLAGS=-L/usr/local/lib
+         found_lz4="yes"
+       else
+         found_lz4="no"
+         AC_MSG_RESULT(no)
+       fi
+     else
+       if test -f $_liblz4_dir/include/lz4.h; then
+         LZ4_CFLAGS=-I$_liblz4_dir/include
+         LZ4_LDFLAGS=-L$_liblz4_dir/lib
+         found_lz4="yes"
+       else
+         found_lz4="no"
+         AC_MSG_RESULT(no)
+       fi
+     fi
+  fi
+
+  if test "x$found_lz4" = "xyes"; then
+    am_save_cflags="$CFLAGS"
+    am_save_ldflags="$LDFLAGS"
+    am_save_libs="$LIBS"
+
+    CFLAGS="$CFLAGS $LZ4_CFLAGS"
+    LDFLAGS="$LDFLAGS $LZ4_LDFLAGS"
+    LIBS="$LIBS $LZ4_LIBS"
+
+    found_lz4="no"
+    LIBLZ4_TRY_LINK([no])
+
+    CFLAGS="$am_save_cflags"
+    LDFLAGS="$am_save_ldflags"
+    LIBS="$am_save_libs"
+
+    if test "x$found_lz4" = "xyes"; then
+      AC_DEFINE([HAVE_LZ4], 1, [Define to 1 if you have the 'lz4' library (-llz4)])
+      AC_MSG_RESULT(yes)
+    else
+      AC_MSG_RESULT(no)
+      LZ4_CFLAGS=""
+      LZ4_LDFLAGS=""
+      LZ4_LIBS=""
+    fi
+  fi
+
+  AC_SUBST(LZ4_CFLAGS)
+  AC_SUBST(LZ4_LDFLAGS)
+  AC_SUBST(LZ4_LIBS)
+])dnl
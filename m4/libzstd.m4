@@ -0,0 +1,104 @@
+# LIBZSTD_CHECK_CONFIG ([DEFAULT-ACTION])
+# ----------------------------------------------------------
+#
+# Checks for Zstandard compression library.  DEFAULT-ACTION is the string
+# yes or no to specify whether to default to --with-zstd or --without-zstd.
+# If not supplied, DEFAULT-ACTION is no.
+#
+# This macro #defines HAVE_ZSTD if a required header files are
+# found, and sets @ZSTD_LDFLAGS@, @ZSTD_CFLAGS@ and @ZSTD_LIBS@
+# to the necessary values.
+#
+# This macro is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+AC_DEFUN([LIBZSTD_TRY_LINK],
+[
+AC_LINK_IFELSE([AC_LANG_PROGRAM([[
+#include <zstd.h>
+]], [[
+	ZSTD_CCtx	*cctx;
+
+	cctx = ZSTD_createCCtx();
+	ZSTD_freeCCtx(cctx);
+]])],[found_zstd="yes"],[])
+])dnl
+
+AC_DEFUN([LIBZSTD_CHECK_CONFIG],
+[
+  AC_ARG_WITH(zstd,[
+If you want to use Zstandard compression of Zabbix protocol:
+AS_HELP_STRING([--with-zstd@<:@=DIR@:>@],[use Zstandard library @<:@default=no@:>@, DIR is the Zstandard library install directory.])],
+    [
+	if test "$withval" = "no"; then
+	    want_zstd="no"
+	    _libzstd_dir="no"
+	elif test "$withval" = "yes"; then
+	    want_zstd="yes"
+	    _libzstd_dir="no"
+	else
+	    want_zstd="yes"
+	    _libzstd_dir=$withval
+	fi
+    ],[want_zstd=ifelse([$1],,[no],[$1])]
+  )
+
+  if test "x$want_zstd" = "xyes"; then
+     AC_MSG_CHECKING(for Zstandard support)
+     ZSTD_LIBS="-lzstd"
+
+     if test "x$_libzstd_dir" = "xno"; then
+       if test -f /usr/include/zstd.h; then
+         found_zstd="yes"
+       elif test -f /usr/local/include/zstd.h; then
+         ZSTD_CFLAGS=-I/usr/local/include
+         ZSTD_LDFLAGS=-L/usr/local/lib
+         found_zstd="yes"
+       else
+         found_zstd="no"
+         AC_MSG_RESULT(no)
+       fi
+     else
+       if test -f $_libzstd_dir/include/zstd.h; then
+         ZSTD_CFLAGS=-I$_libzstd_dir/include
+         ZSTD_LDFLAGS=-L$_libzstd_dir/lib
+         found_zstd="yes"
+       else
+         found_zstd="no"
+         AC_MSG_RESULT(no)
+       fi
+     fi
+  fi
+
+  if test "x$found_zstd" = "xyes"; then
+    am_save_cflags="$CFLAGS"
+    am_save_ldflags="$LDFLAGS"
+    am_save_libs="$LIBS"
+
+    CFLAGS="$CFLAGS $ZSTD_CFLAGS"
+    LDFLAGS="$LDFLAGS $ZSTD_LDFLAGS"
+    LIBS="$LIBS $ZSTD_LIBS"
+
+    found_zstd="no"
+    LIBZSTD_TRY_LINK([no])
+
+    CFLAGS="$am_save_cflags"
+    LDFLAGS="$am_save_ldflags"
+    LIBS="$am_save_libs"
+
+    if test "x$found_zstd" = "xyes"; then
+      AC_DEFINE([HAVE_ZSTD], 1, [Define to 1 if you have the 'zstd' library (-lzstd)])
+      AC_MSG_RESULT(yes)
+    else
+      AC_MSG_RESULT(no)
+      ZSTD_CFLAGS=""
+      ZSTD_LDFLAGS=""
+      ZSTD_LIBS=""
+    fi
+  fi
+
+  AC_SUBST(ZSTD_CFLAGS)
+  AC_SUBST(ZSTD_LDFLAGS)
+  AC_SUBST(ZSTD_LIBS)
+])dnl
@@ -42,6 +42,15 @@
 # Default:
 $SNMPTrapperFile = '/tmp/zabbix_traps.tmp';
 
+### Option: SNMPTrapperSocket
+#	UNIX datagram socket for passing traps directly to the server (or proxy). Must be the
+#	same as in the server (or proxy) configuration file. If set, traps are sent to the
+#	socket instead of being written to SNMPTrapperFile.
+#
+# Mandatory: no
+# Default:
+$SNMPTrapperSocket = '';
+
 ### Option: DateTimeFormat
 #	The date time format in strftime() format. Please make sure to have a corresponding
 #	log time format for the SNMP trap items.
@@ -56,19 +65,16 @@ $DateTimeFormat = '%H:%M:%S %Y/%m/%d';
 
 use Fcntl qw(O_WRONLY O_APPEND O_CREAT);
 use POSIX qw(strftime);
+use IO::Socket::UNIX;
+use Socket qw(SOCK_DGRAM);
+
+my $socket;
 
 sub zabbix_receiver
 {
 	my (%pdu_info) = %{$_[0]};
 	my (@varbinds) = @{$_[1]};
 
-	# open the output file
-	unless (sysopen(OUTPUT_FILE, $SNMPTrapperFile, O_WRONLY|O_APPEND|O_CREAT, 0666))
-	{
-		print STDERR "Cannot open [$SNMPTrapperFile]: $!\n";
-		return NETSNMPTRAPD_HANDLER_FAIL;
-	}
-
 	# get the host name
 	my $hostname = $pdu_info{'receivedfrom'} || 'unknown';
 	if ($hostname ne 'unknown')
@@ -82,10 +88,10 @@ sub zabbix_receiver
 	#       the first line must include the header "ZBXTRAP [IP/DNS address] "
 	#              * IP/DNS address is the used to find the corresponding SNMP trap items
 	#              * this header will be cut during processing (will not appear in the item value)
-	printf OUTPUT_FILE "%s ZBXTRAP %s\n", strftime($DateTimeFormat, localtime), $hostname;
+	my $trap = sprintf("%s ZBXTRAP %s\n", strftime($DateTimeFormat, localtime), $hostname);
 
 	# print the PDU info
-	print OUTPUT_FILE "PDU INFO:\n";
+	$trap .= "PDU INFO:\n";
 	foreach my $key(keys(%pdu_info))
 	{
 		if ($pdu_info{$key} !~ /^[[:print:]]*$/)
@@ -94,16 +100,43 @@ sub zabbix_receiver
 			$pdu_info{$key} = "0x$OctetAsHex";		# apply 0x prefix for consistency
 		}
 
-		printf OUTPUT_FILE "  %-30s %s\n", $key, $pdu_info{$key};
+		$trap .= sprintf("  %-30s %s\n", $key, $pdu_info{$key});
 	}
 
 	# print the variable bindings:
-	print OUTPUT_FILE "VARBINDS:\n";
+	$trap .= "VARBINDS:\n";
 	foreach my $x (@varbinds)
 	{
-		printf OUTPUT_FILE "  %-30s type=%-2d value=%s\n", $x->[0], $x->[2], $x->[1];
+		$trap .= sprintf("  %-30s type=%-2d value=%s\n", $x->[0], $x->[2], $x->[1]);
 	}
 
+	# send the trap as a single datagram
+	if ($SNMPTrapperSocket ne '')
+	{
+		unless (defined($socket) && defined($socket->send($trap)))
+		{
+			$socket = IO::Socket::UNIX->new(Type => SOCK_DGRAM, Peer => $SNMPTrapperSocket);
+
+			unless (defined($socket) && defined($socket->send($trap)))
+			{
+				print STDERR "Cannot send trap to [$SNMPTrapperSocket]: $!\n";
+				undef $socket;
+				return NETSNMPTRAPD_HANDLER_FAIL;
+			}
+		}
+
+		return NETSNMPTRAPD_HANDLER_OK;
+	}
+
+	# open the output file
+	unless (sysopen(OUTPUT_FILE, $SNMPTrapperFile, O_WRONLY|O_APPEND|O_CREAT, 0666))
+	{
+		print STDERR "Cannot open [$SNMPTrapperFile]: $!\n";
+		return NETSNMPTRAPD_HANDLER_FAIL;
+	}
+
+	print OUTPUT_FILE $trap;
+
 	close (OUTPUT_FILE);
 
 	return NETSNMPTRAPD_HANDLER_OK;
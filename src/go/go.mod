@@ -4,7 +4,6 @@ go 1.19
 
 require (
 	git.zabbix.com/ap/plugin-support v1.2.2-0.20230328072810-77ed282adaf3
-	github.com/BurntSushi/locker v0.0.0-20171006230638-a6e239ea1c69
 	github.com/Microsoft/go-winio v0.6.0
 	github.com/chromedp/cdproto v0.0.0-20230220211738-2b1ec77315c9
 	github.com/chromedp/chromedp v0.8.7
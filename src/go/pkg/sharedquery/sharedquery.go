@@ -0,0 +1,77 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+// Package sharedquery lets items requesting the same data from one monitored service share a single query.
+// Status queries like 'SHOW GLOBAL STATUS' or 'INFO' return data for many items at once, so a result fetched
+// for one item is reused by other items requesting it shortly after, and concurrent requests wait for the
+// query in progress instead of starting their own.
+package sharedquery
+
+import (
+	"sync"
+	"time"
+)
+
+type entry struct {
+	mu      sync.Mutex
+	value   interface{}
+	fetched time.Time
+}
+
+// Cache holds recent query results by key. The zero value is ready to use.
+type Cache struct {
+	mu      sync.Mutex
+	entries map[string]*entry
+}
+
+// Get returns the result stored for key if it was fetched less than maxAge ago. Otherwise it calls fetch
+// and stores the result. Concurrent calls for the same key are served by a single fetch. Errors are
+// returned to the caller but are not stored.
+func (c *Cache) Get(key string, maxAge time.Duration, fetch func() (interface{}, error)) (interface{}, error) {
+	c.mu.Lock()
+
+	if c.entries == nil {
+		c.entries = make(map[string]*entry)
+	}
+
+	e, ok := c.entries[key]
+	if !ok {
+		e = &entry{}
+		c.entries[key] = e
+	}
+
+	c.mu.Unlock()
+
+	e.mu.Lock()
+	defer e.mu.Unlock()
+
+	if !e.fetched.IsZero() && time.Since(e.fetched) < maxAge {
+		return e.value, nil
+	}
+
+	value, err := fetch()
+	if err != nil {
+		return nil, err
+	}
+
+	e.value = value
+	e.fetched = time.Now()
+
+	return value, nil
+}
@@ -0,0 +1,89 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+package sharedquery
+
+import (
+	"errors"
+	"sync"
+	"sync/atomic"
+	"testing"
+	"time"
+)
+
+func TestCacheGet(t *testing.T) {
+	var c Cache
+	var calls int32
+
+	fetch := func() (interface{}, error) {
+		atomic.AddInt32(&calls, 1)
+		time.Sleep(10 * time.Millisecond)
+
+		return "value", nil
+	}
+
+	var wg sync.WaitGroup
+
+	for i := 0; i < 10; i++ {
+		wg.Add(1)
+
+		go func() {
+			defer wg.Done()
+
+			if v, err := c.Get("status", time.Minute, fetch); err != nil || v != "value" {
+				t.Errorf("unexpected result %v, %v", v, err)
+			}
+		}()
+	}
+
+	wg.Wait()
+
+	if calls != 1 {
+		t.Errorf("expected a single fetch for concurrent requests, got %d", calls)
+	}
+
+	if _, err := c.Get("other", time.Minute, fetch); err != nil || calls != 2 {
+		t.Errorf("expected a separate fetch for another key, got %d", calls)
+	}
+
+	if _, err := c.Get("status", 0, fetch); err != nil || calls != 3 {
+		t.Errorf("expected a fetch for expired result, got %d", calls)
+	}
+}
+
+func TestCacheGetError(t *testing.T) {
+	var c Cache
+	var calls int
+
+	fail := func() (interface{}, error) {
+		calls++
+
+		return nil, errors.New("cannot fetch data")
+	}
+
+	for i := 0; i < 2; i++ {
+		if _, err := c.Get("status", time.Minute, fail); err == nil {
+			t.Errorf("expected error")
+		}
+	}
+
+	if calls != 2 {
+		t.Errorf("expected errors not to be cached, got %d fetches", calls)
+	}
+}
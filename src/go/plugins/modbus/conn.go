@@ -0,0 +1,351 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+package modbus
+
+import (
+	"errors"
+	"fmt"
+	"sort"
+	"sync"
+	"time"
+
+	mblib "github.com/goburrow/modbus"
+)
+
+// Maximum number of registers and bits allowed to be read with a single request
+const (
+	maxReadRegisters = 125
+	maxReadBits      = 2000
+)
+
+// request - a pending read of a single item
+type request struct {
+	params  *mbParams
+	timeout int
+	results []byte
+	err     error
+	done    chan struct{}
+}
+
+// batch - a set of requests of the same slave and function covering a contiguous address range
+type batch struct {
+	params   *mbParams
+	address  uint16
+	quantity uint16
+	timeout  int
+	requests []*request
+}
+
+// endpoint - a persistent connection to a TCP address or a serial port.
+// Requests to the endpoint are executed sequentially. Requests queued while the endpoint is busy
+// are merged into single reads where their address ranges are adjacent or overlap.
+// Idle connections are closed by the modbus library after its idle timeout and reopened on demand.
+type endpoint struct {
+	mutex   sync.Mutex
+	queue   []*request
+	busy    bool
+	handler mblib.ClientHandler
+	conn    string
+}
+
+var endpoints = struct {
+	sync.Mutex
+	m map[string]*endpoint
+}{m: make(map[string]*endpoint)}
+
+// connecting and receiving data from modbus device
+func modbusRead(p *mbParams, timeout int) (results []byte, err error) {
+	req := &request{params: p, timeout: timeout, done: make(chan struct{})}
+	ep := getEndpoint(p)
+
+	ep.mutex.Lock()
+	ep.queue = append(ep.queue, req)
+
+	if !ep.busy {
+		ep.busy = true
+		go ep.run()
+	}
+	ep.mutex.Unlock()
+
+	<-req.done
+
+	return req.results, req.err
+}
+
+// getEndpoint returns endpoint of the TCP address or serial port used by the request
+func getEndpoint(p *mbParams) *endpoint {
+	var name string
+	if p.ReqType == TCP {
+		name = p.NetAddr
+	} else {
+		name = p.Serial.PortName
+	}
+
+	endpoints.Lock()
+	defer endpoints.Unlock()
+
+	ep, ok := endpoints.m[name]
+	if !ok {
+		ep = &endpoint{}
+		endpoints.m[name] = ep
+	}
+
+	return ep
+}
+
+// run processes queued requests until the queue is empty
+func (ep *endpoint) run() {
+	for {
+		ep.mutex.Lock()
+		if len(ep.queue) == 0 {
+			ep.busy = false
+			ep.mutex.Unlock()
+
+			return
+		}
+
+		queue := ep.queue
+		ep.queue = nil
+		ep.mutex.Unlock()
+
+		for _, b := range mergeRequests(queue) {
+			ep.process(b)
+		}
+	}
+}
+
+// process reads the batch address range and distributes results to its requests
+func (ep *endpoint) process(b *batch) {
+	results, err := ep.read(b.params, b.address, b.quantity, b.timeout)
+
+	var mbErr *mblib.ModbusError
+	if err != nil && len(b.requests) > 1 && errors.As(err, &mbErr) {
+		// the device rejected merged read, fall back to reading items separately
+		for _, r := range b.requests {
+			r.results, r.err = ep.read(r.params, r.params.MemAddr, r.params.Count, r.timeout)
+			close(r.done)
+		}
+
+		return
+	}
+
+	for _, r := range b.requests {
+		if err != nil {
+			r.err = err
+		} else if len(b.requests) == 1 {
+			r.results = results
+		} else {
+			r.results, r.err = sliceResults(results, b.params.FuncID, b.address, r.params.MemAddr,
+				r.params.Count)
+		}
+
+		close(r.done)
+	}
+}
+
+// read performs a single read request using the endpoint connection
+func (ep *endpoint) read(p *mbParams, address, quantity uint16, timeout int) (results []byte, err error) {
+	if conn := connString(p); ep.handler == nil || ep.conn != conn {
+		ep.close()
+		ep.handler = newHandler(p, timeout)
+		ep.conn = conn
+	}
+
+	setHandlerOptions(ep.handler, p.SlaveID, timeout)
+
+	if err = connectHandler(ep.handler); err != nil {
+		ep.close()
+		return nil, fmt.Errorf("Unable to connect: %s", err)
+	}
+
+	client := mblib.NewClient(ep.handler)
+	switch p.FuncID {
+	case ReadCoil:
+		results, err = client.ReadCoils(address, quantity)
+	case ReadDiscrete:
+		results, err = client.ReadDiscreteInputs(address, quantity)
+	case ReadHolding:
+		results, err = client.ReadHoldingRegisters(address, quantity)
+	case ReadInput:
+		results, err = client.ReadInputRegisters(address, quantity)
+	}
+
+	if err != nil {
+		// the connection state is unknown after failed transaction, reconnect on the next request
+		// unless the device has responded with modbus exception
+		var mbErr *mblib.ModbusError
+		if !errors.As(err, &mbErr) {
+			ep.close()
+		}
+
+		return nil, fmt.Errorf("Unable to read: %w", err)
+	} else if len(results) == 0 {
+		return nil, fmt.Errorf("Unable to read data")
+	}
+
+	return results, nil
+}
+
+// close closes the endpoint connection
+func (ep *endpoint) close() {
+	if ep.handler == nil {
+		return
+	}
+
+	switch h := ep.handler.(type) {
+	case *mblib.TCPClientHandler:
+		h.Close()
+	case *mblib.RTUClientHandler:
+		h.Close()
+	case *mblib.ASCIIClientHandler:
+		h.Close()
+	}
+
+	ep.handler = nil
+}
+
+// connectHandler opens handler connection if it's not opened yet
+func connectHandler(handler mblib.ClientHandler) error {
+	switch h := handler.(type) {
+	case *mblib.TCPClientHandler:
+		return h.Connect()
+	case *mblib.RTUClientHandler:
+		return h.Connect()
+	case *mblib.ASCIIClientHandler:
+		return h.Connect()
+	}
+
+	return fmt.Errorf("Unsupported modbus protocol")
+}
+
+// setHandlerOptions sets request specific handler options
+func setHandlerOptions(handler mblib.ClientHandler, slaveID uint8, timeout int) {
+	switch h := handler.(type) {
+	case *mblib.TCPClientHandler:
+		h.SlaveId = slaveID
+		h.Timeout = time.Duration(timeout) * time.Second
+	case *mblib.RTUClientHandler:
+		h.SlaveId = slaveID
+		h.Timeout = time.Duration(timeout) * time.Second
+	case *mblib.ASCIIClientHandler:
+		h.SlaveId = slaveID
+		h.Timeout = time.Duration(timeout) * time.Second
+	}
+}
+
+// connString returns connection parameters the handler is created with
+func connString(p *mbParams) string {
+	if p.ReqType == TCP {
+		return p.NetAddr
+	}
+
+	return fmt.Sprintf("%d:%s:%d:%d:%s:%d", p.ReqType, p.Serial.PortName, p.Serial.Speed, p.Serial.DataBits,
+		p.Serial.Parity, p.Serial.StopBit)
+}
+
+// mergeRequests groups requests of the same slave and function with adjacent or overlapping address
+// ranges into batches that can be read with a single request
+func mergeRequests(queue []*request) (batches []*batch) {
+	sort.SliceStable(queue, func(i, j int) bool {
+		pi, pj := queue[i].params, queue[j].params
+
+		if ci, cj := connString(pi), connString(pj); ci != cj {
+			return ci < cj
+		}
+
+		if pi.SlaveID != pj.SlaveID {
+			return pi.SlaveID < pj.SlaveID
+		}
+
+		if pi.FuncID != pj.FuncID {
+			return pi.FuncID < pj.FuncID
+		}
+
+		return pi.MemAddr < pj.MemAddr
+	})
+
+	var last *batch
+	for _, r := range queue {
+		p := r.params
+
+		if last != nil && last.params.SlaveID == p.SlaveID && last.params.FuncID == p.FuncID &&
+			connString(last.params) == connString(p) && int(p.MemAddr) <= int(last.address)+int(last.quantity) {
+
+			end := int(p.MemAddr) + int(p.Count)
+			if end < int(last.address)+int(last.quantity) {
+				end = int(last.address) + int(last.quantity)
+			}
+
+			if end-int(last.address) <= maxReadQuantity(p.FuncID) {
+				last.quantity = uint16(end - int(last.address))
+				last.requests = append(last.requests, r)
+
+				if r.timeout > last.timeout {
+					last.timeout = r.timeout
+				}
+
+				continue
+			}
+		}
+
+		last = &batch{params: p, address: p.MemAddr, quantity: p.Count, timeout: r.timeout,
+			requests: []*request{r}}
+		batches = append(batches, last)
+	}
+
+	return batches
+}
+
+// maxReadQuantity returns maximum number of registers or bits the function can read
+func maxReadQuantity(funcID uint8) int {
+	switch funcID {
+	case ReadCoil, ReadDiscrete:
+		return maxReadBits
+	default:
+		return maxReadRegisters
+	}
+}
+
+// sliceResults extracts data of the specified address range from the results of a merged read
+func sliceResults(results []byte, funcID uint8, start, address, quantity uint16) ([]byte, error) {
+	offset := int(address) - int(start)
+
+	switch funcID {
+	case ReadCoil, ReadDiscrete:
+		if len(results)*8 < offset+int(quantity) {
+			return nil, fmt.Errorf("Wrong length of received data: %d", len(results))
+		}
+
+		out := make([]byte, (int(quantity)+7)/8)
+		for i := 0; i < int(quantity); i++ {
+			if bit := offset + i; results[bit/8]&(1<<uint(bit%8)) != 0 {
+				out[i/8] |= 1 << uint(i%8)
+			}
+		}
+
+		return out, nil
+	default:
+		if len(results) < (offset+int(quantity))*2 {
+			return nil, fmt.Errorf("Wrong length of received data: %d", len(results))
+		}
+
+		return results[offset*2 : (offset+int(quantity))*2], nil
+	}
+}
@@ -33,7 +33,6 @@ import (
 
 	"git.zabbix.com/ap/plugin-support/conf"
 	"git.zabbix.com/ap/plugin-support/plugin"
-	named "github.com/BurntSushi/locker"
 	"github.com/goburrow/modbus"
 	mblib "github.com/goburrow/modbus"
 )
@@ -256,58 +255,6 @@ func (p *Plugin) Validate(options interface{}) error {
 	return nil
 }
 
-// connecting and receiving data from modbus device
-func modbusRead(p *mbParams, timeout int) (results []byte, err error) {
-	handler := newHandler(p, timeout)
-	var lockName string
-	if p.ReqType == TCP {
-		lockName = p.NetAddr
-	} else {
-		lockName = p.Serial.PortName
-	}
-
-	named.Lock(lockName)
-
-	switch p.ReqType {
-	case TCP:
-		err = handler.(*mblib.TCPClientHandler).Connect()
-		defer handler.(*mblib.TCPClientHandler).Close()
-	case RTU:
-		err = handler.(*mblib.RTUClientHandler).Connect()
-		defer handler.(*mblib.RTUClientHandler).Close()
-	case ASCII:
-		err = handler.(*mblib.ASCIIClientHandler).Connect()
-		defer handler.(*mblib.ASCIIClientHandler).Close()
-	}
-
-	if err != nil {
-		named.Unlock(lockName)
-		return nil, fmt.Errorf("Unable to connect: %s", err)
-	}
-
-	client := mblib.NewClient(handler)
-	switch p.FuncID {
-	case ReadCoil:
-		results, err = client.ReadCoils(p.MemAddr, p.Count)
-	case ReadDiscrete:
-		results, err = client.ReadDiscreteInputs(p.MemAddr, p.Count)
-	case ReadHolding:
-		results, err = client.ReadHoldingRegisters(p.MemAddr, p.Count)
-	case ReadInput:
-		results, err = client.ReadInputRegisters(p.MemAddr, p.Count)
-	}
-
-	named.Unlock(lockName)
-
-	if err != nil {
-		return nil, fmt.Errorf("Unable to read: %s", err)
-	} else if len(results) == 0 {
-		return nil, fmt.Errorf("Unable to read data")
-	}
-
-	return results, nil
-}
-
 // make new modbus handler depend on connection type
 func newHandler(p *mbParams, timeout int) (handler mblib.ClientHandler) {
 	switch p.ReqType {
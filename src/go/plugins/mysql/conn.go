@@ -33,16 +33,22 @@ import (
 
 	"git.zabbix.com/ap/plugin-support/log"
 	"git.zabbix.com/ap/plugin-support/zbxerr"
+	"zabbix.com/pkg/sharedquery"
 )
 
+// sharedQueryMaxAge is how long a result of a server-wide query is reused by other items.
+const sharedQueryMaxAge = time.Second
+
 type MyClient interface {
 	Query(ctx context.Context, query string, args ...interface{}) (rows *sql.Rows, err error)
 	QueryRow(ctx context.Context, query string, args ...interface{}) (row *sql.Row, err error)
+	QueryShared(key string, fetch func() (interface{}, error)) (interface{}, error)
 }
 
 type MyConn struct {
 	client         *sql.DB
 	lastTimeAccess time.Time
+	shared         sharedquery.Cache
 }
 
 func (conn *MyConn) Query(ctx context.Context, query string, args ...interface{}) (rows *sql.Rows, err error) {
@@ -66,6 +72,12 @@ func (conn *MyConn) QueryRow(ctx context.Context, query string, args ...interfac
 	return
 }
 
+// QueryShared returns a recent result stored by key or calls fetch, so that items requesting the same data
+// at the same time are served by a single query.
+func (conn *MyConn) QueryShared(key string, fetch func() (interface{}, error)) (interface{}, error) {
+	return conn.shared.Get(key, sharedQueryMaxAge, fetch)
+}
+
 // updateAccessTime updates the last time a connection was accessed.
 func (conn *MyConn) updateAccessTime() {
 	conn.lastTimeAccess = time.Now()
@@ -26,27 +26,31 @@ import (
 	"git.zabbix.com/ap/plugin-support/zbxerr"
 )
 
+// statusVarsHandler returns global status variables in JSON format. The result is shared by all items
+// requesting it from the connection at the same time.
 func statusVarsHandler(ctx context.Context, conn MyClient, _ map[string]string,
 	_ ...string) (interface{}, error) {
-	rows, err := conn.Query(ctx, `SHOW GLOBAL STATUS`)
-	if err != nil {
-		return nil, zbxerr.ErrorCannotFetchData.Wrap(err)
-	}
-
-	data, err := rows2data(rows)
-	if err != nil {
-		return nil, zbxerr.ErrorCannotFetchData.Wrap(err)
-	}
-
-	res := make(map[string]string)
-	for _, row := range data {
-		res[row["Variable_name"]] = row["Value"]
-	}
-
-	jsonRes, err := json.Marshal(res)
-	if err != nil {
-		return nil, zbxerr.ErrorCannotMarshalJSON.Wrap(err)
-	}
-
-	return string(jsonRes), nil
+	return conn.QueryShared(keyStatusVars, func() (interface{}, error) {
+		rows, err := conn.Query(ctx, `SHOW GLOBAL STATUS`)
+		if err != nil {
+			return nil, zbxerr.ErrorCannotFetchData.Wrap(err)
+		}
+
+		data, err := rows2data(rows)
+		if err != nil {
+			return nil, zbxerr.ErrorCannotFetchData.Wrap(err)
+		}
+
+		res := make(map[string]string)
+		for _, row := range data {
+			res[row["Variable_name"]] = row["Value"]
+		}
+
+		jsonRes, err := json.Marshal(res)
+		if err != nil {
+			return nil, zbxerr.ErrorCannotMarshalJSON.Wrap(err)
+		}
+
+		return string(jsonRes), nil
+	})
 }
@@ -29,19 +29,25 @@ import (
 	"git.zabbix.com/ap/plugin-support/uri"
 	"git.zabbix.com/ap/plugin-support/zbxerr"
 	"github.com/mediocregopher/radix/v3"
+	"zabbix.com/pkg/sharedquery"
 )
 
 const hkInterval = 10
 
+// sharedQueryMaxAge is how long a result of a server-wide query is reused by other items.
+const sharedQueryMaxAge = time.Second
+
 var errMasterDown = errors.New("MASTERDOWN Link with MASTER is down and slave-serve-stale-data is set to 'no'.")
 
 type redisClient interface {
 	Query(cmd radix.CmdAction) error
+	QueryShared(key string, fetch func() (interface{}, error)) (interface{}, error)
 }
 
 type RedisConn struct {
 	client         radix.Client
 	lastTimeAccess time.Time
+	shared         sharedquery.Cache
 }
 
 // Query wraps the radix.Client.Do function.
@@ -49,6 +55,12 @@ func (r *RedisConn) Query(cmd radix.CmdAction) error {
 	return r.client.Do(cmd)
 }
 
+// QueryShared returns a recent result stored by key or calls fetch, so that items requesting the same data
+// at the same time are served by a single query.
+func (r *RedisConn) QueryShared(key string, fetch func() (interface{}, error)) (interface{}, error) {
+	return r.shared.Get(key, sharedQueryMaxAge, fetch)
+}
+
 // updateAccessTime updates the last time a connection was accessed.
 func (r *RedisConn) updateAccessTime() {
 	r.lastTimeAccess = time.Now()
@@ -110,24 +110,27 @@ func parseRedisInfo(info string) (res redisInfo, err error) {
 }
 
 // infoHandler gets an output of 'INFO' command, parses it and returns it in JSON format.
+// The result is shared by all items requesting the same section from the connection at the same time.
 func infoHandler(conn redisClient, params map[string]string) (interface{}, error) {
-	var res string
-
 	section := infoSection(strings.ToLower(params["Section"]))
 
-	if err := conn.Query(radix.Cmd(&res, "INFO", string(section))); err != nil {
-		return nil, zbxerr.ErrorCannotFetchData.Wrap(err)
-	}
+	return conn.QueryShared("INFO "+string(section), func() (interface{}, error) {
+		var res string
 
-	redisInfo, err := parseRedisInfo(res)
-	if err != nil {
-		return nil, err
-	}
+		if err := conn.Query(radix.Cmd(&res, "INFO", string(section))); err != nil {
+			return nil, zbxerr.ErrorCannotFetchData.Wrap(err)
+		}
 
-	jsonRes, err := json.Marshal(redisInfo)
-	if err != nil {
-		return nil, zbxerr.ErrorCannotMarshalJSON.Wrap(err)
-	}
+		redisInfo, err := parseRedisInfo(res)
+		if err != nil {
+			return nil, err
+		}
+
+		jsonRes, err := json.Marshal(redisInfo)
+		if err != nil {
+			return nil, zbxerr.ErrorCannotMarshalJSON.Wrap(err)
+		}
 
-	return string(jsonRes), nil
+		return string(jsonRes), nil
+	})
 }
@@ -246,3 +246,29 @@ func TestPlugin_infoHandler(t *testing.T) {
 		})
 	}
 }
+
+func TestPlugin_infoHandlerShared(t *testing.T) {
+	var calls int
+
+	stubConn := radix.Stub("", "", func(args []string) interface{} {
+		calls++
+
+		return infoCommonSectionOutput
+	})
+
+	defer stubConn.Close()
+
+	conn := &RedisConn{
+		client: stubConn,
+	}
+
+	for i := 0; i < 3; i++ {
+		if _, err := infoHandler(conn, map[string]string{"Section": "commonsection"}); err != nil {
+			t.Fatalf("Plugin.infoHandler() unexpected error = %v", err)
+		}
+	}
+
+	if calls != 1 {
+		t.Errorf("Plugin.infoHandler() sent %d INFO commands, want 1", calls)
+	}
+}
@@ -50,6 +50,41 @@ zbx_hash_t	zbx_hash_modfnv(const void *data, size_t len, zbx_hash_t seed)
 	return hash;
 }
 
+/*
+ * hashes data a 64-bit word at a time, the words are mixed by multiplication and
+ * the result is finalized with splitmix64 finalizer (see zbx_hash_splittable64)
+ */
+zbx_hash_t	zbx_hash_words(const void *data, size_t len, zbx_hash_t seed)
+{
+	const uchar	*p = (const uchar *)data;
+	zbx_uint64_t	hash, word;
+
+	hash = ((zbx_uint64_t)seed << 32 ^ (zbx_uint64_t)len) ^ __UINT64_C(0x9e3779b97f4a7c15);
+
+	for (; sizeof(word) <= len; len -= sizeof(word), p += sizeof(word))
+	{
+		memcpy(&word, p, sizeof(word));
+		hash = (hash ^ word) * __UINT64_C(0xbf58476d1ce4e5b9);
+		hash ^= hash >> 31;
+	}
+
+	if (0 != len)
+	{
+		word = 0;
+		memcpy(&word, p, len);
+		hash = (hash ^ word) * __UINT64_C(0xbf58476d1ce4e5b9);
+		hash ^= hash >> 31;
+	}
+
+	hash ^= hash >> 30;
+	hash *= __UINT64_C(0xbf58476d1ce4e5b9);
+	hash ^= hash >> 27;
+	hash *= __UINT64_C(0x94d049bb133111eb);
+	hash ^= hash >> 31;
+
+	return (zbx_hash_t)hash ^ (zbx_hash_t)(hash >> 32);
+}
+
 /*
  * see http://xoshiro.di.unimi.it/splitmix64.c
  */
@@ -0,0 +1,195 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxalgo.h"
+
+#include "zbxcommon.h"
+
+#define ZBX_ARENA_ALIGN			8
+#define ZBX_ARENA_ALIGN_SIZE(size)	(((size) + ZBX_ARENA_ALIGN - 1) & ~(size_t)(ZBX_ARENA_ALIGN - 1))
+#define ZBX_ARENA_BLOCK_HEADER_SIZE	ZBX_ARENA_ALIGN_SIZE(sizeof(zbx_arena_block_t))
+
+static zbx_arena_block_t	*arena_block_create(size_t size)
+{
+	zbx_arena_block_t	*block;
+
+	block = (zbx_arena_block_t *)zbx_malloc(NULL, ZBX_ARENA_BLOCK_HEADER_SIZE + size);
+	block->next = NULL;
+	block->size = size;
+	block->used = 0;
+
+	return block;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: creates arena allocator                                           *
+ *                                                                            *
+ * Parameters: arena      - [OUT] the arena                                   *
+ *             block_size - [IN] the size of memory blocks allocated by arena *
+ *                                                                            *
+ * Comments: The first block is allocated on the first allocation and is kept *
+ *           until the arena is destroyed.                                    *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_arena_create(zbx_arena_t *arena, size_t block_size)
+{
+	arena->first = NULL;
+	arena->current = NULL;
+	arena->block_size = ZBX_ARENA_ALIGN_SIZE(block_size);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: frees all memory blocks of arena                                  *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_arena_destroy(zbx_arena_t *arena)
+{
+	zbx_arena_block_t	*block, *next;
+
+	for (block = arena->first; NULL != block; block = next)
+	{
+		next = block->next;
+		zbx_free(block);
+	}
+
+	arena->first = NULL;
+	arena->current = NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: allocates memory from arena                                       *
+ *                                                                            *
+ * Parameters: arena - [IN/OUT] the arena                                     *
+ *             size  - [IN] the number of bytes to allocate                   *
+ *                                                                            *
+ * Return value: the allocated memory, aligned to 8 bytes                     *
+ *                                                                            *
+ * Comments: The memory must not be freed individually, it is released by     *
+ *           resetting, clearing or destroying the arena. Allocations larger  *
+ *           than block size get a block of their own.                        *
+ *                                                                            *
+ ******************************************************************************/
+void	*zbx_arena_alloc(zbx_arena_t *arena, size_t size)
+{
+	zbx_arena_block_t	*block;
+	void			*ptr;
+
+	size = ZBX_ARENA_ALIGN_SIZE(size);
+
+	if (NULL == (block = arena->current))
+	{
+		block = arena->first = arena->current = arena_block_create(MAX(arena->block_size, size));
+	}
+	else if (block->size - block->used < size)
+	{
+		/* reuse blocks kept by reset if they are large enough */
+		if (NULL == block->next || block->next->size < size)
+		{
+			zbx_arena_block_t	*new_block;
+
+			new_block = arena_block_create(MAX(arena->block_size, size));
+			new_block->next = block->next;
+			block->next = new_block;
+		}
+
+		block = arena->current = block->next;
+	}
+
+	ptr = (char *)block + ZBX_ARENA_BLOCK_HEADER_SIZE + block->used;
+	block->used += size;
+
+	return ptr;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: copies string into arena memory                                   *
+ *                                                                            *
+ ******************************************************************************/
+char	*zbx_arena_strdup(zbx_arena_t *arena, const char *str)
+{
+	return zbx_arena_strndup(arena, str, strlen(str));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: copies len bytes of string into arena memory and terminates it    *
+ *                                                                            *
+ ******************************************************************************/
+char	*zbx_arena_strndup(zbx_arena_t *arena, const char *str, size_t len)
+{
+	char	*ptr;
+
+	ptr = (char *)zbx_arena_alloc(arena, len + 1);
+	memcpy(ptr, str, len);
+	ptr[len] = '\0';
+
+	return ptr;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: releases all memory allocated from arena, keeping memory blocks   *
+ *          for the next allocations                                          *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_arena_reset(zbx_arena_t *arena)
+{
+	zbx_arena_block_t	*block;
+
+	for (block = arena->first; NULL != block; block = block->next)
+		block->used = 0;
+
+	arena->current = arena->first;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: releases all memory allocated from arena and frees memory blocks  *
+ *          except the first one                                              *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_arena_clear(zbx_arena_t *arena)
+{
+	zbx_arena_block_t	*block, *next;
+
+	if (NULL == arena->first)
+		return;
+
+	for (block = arena->first->next; NULL != block; block = next)
+	{
+		next = block->next;
+		zbx_free(block);
+	}
+
+	/* the first block can be a single large allocation, keep only regular size blocks */
+	if (arena->first->size != arena->block_size)
+	{
+		zbx_free(arena->first);
+		arena->current = NULL;
+		return;
+	}
+
+	arena->first->next = NULL;
+	arena->first->used = 0;
+	arena->current = arena->first;
+}
@@ -32,6 +32,27 @@ static void	__hashset_free_entry(zbx_hashset_t *hs, ZBX_HASHSET_ENTRY_T *entry);
 
 /* private hashset functions */
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: check if hashset entry matches the searched data                  *
+ *                                                                            *
+ * Comments: Most hashsets are keyed by uint64 identifiers, their keys are    *
+ *           compared directly instead of calling comparison function for     *
+ *           every entry with matching hash.                                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	__hashset_entry_match(const zbx_hashset_t *hs, const ZBX_HASHSET_ENTRY_T *entry, zbx_hash_t hash,
+		const void *data)
+{
+	if (entry->hash != hash)
+		return FAIL;
+
+	if (ZBX_DEFAULT_UINT64_COMPARE_FUNC == hs->compare_func)
+		return *(const zbx_uint64_t *)entry->data == *(const zbx_uint64_t *)data ? SUCCEED : FAIL;
+
+	return 0 == hs->compare_func(entry->data, data) ? SUCCEED : FAIL;
+}
+
 static void	__hashset_free_entry(zbx_hashset_t *hs, ZBX_HASHSET_ENTRY_T *entry)
 {
 	if (NULL != hs->clean_func)
@@ -153,7 +174,13 @@ int	zbx_hashset_reserve(zbx_hashset_t *hs, int num_slots_req)
 		void			*slots;
 		ZBX_HASHSET_ENTRY_T	**prev_next, *curr_entry, *tmp;
 
-		inc_slots = next_prime(hs->num_slots * SLOT_GROWTH_FACTOR);
+		inc_slots = hs->num_slots * SLOT_GROWTH_FACTOR;
+
+		/* grow directly to the required size when reserving for many entries at once */
+		if (num_slots_req >= inc_slots * CRIT_LOAD_FACTOR)
+			inc_slots = num_slots_req * (2 - CRIT_LOAD_FACTOR) + 1;
+
+		inc_slots = next_prime(inc_slots);
 
 		if (NULL == (slots = hs->mem_realloc_func(hs->slots, inc_slots * sizeof(ZBX_HASHSET_ENTRY_T *))))
 			return FAIL;
@@ -213,7 +240,7 @@ void	*zbx_hashset_insert_ext(zbx_hashset_t *hs, const void *data, size_t size, s
 
 	while (NULL != entry)
 	{
-		if (entry->hash == hash && hs->compare_func(entry->data, data) == 0)
+		if (SUCCEED == __hashset_entry_match(hs, entry, hash, data))
 			break;
 
 		entry = entry->next;
@@ -256,7 +283,7 @@ void	*zbx_hashset_search(const zbx_hashset_t *hs, const void *data)
 
 	while (NULL != entry)
 	{
-		if (entry->hash == hash && hs->compare_func(entry->data, data) == 0)
+		if (SUCCEED == __hashset_entry_match(hs, entry, hash, data))
 			break;
 
 		entry = entry->next;
@@ -286,7 +313,7 @@ void	zbx_hashset_remove(zbx_hashset_t *hs, const void *data)
 
 	if (NULL != entry)
 	{
-		if (entry->hash == hash && hs->compare_func(entry->data, data) == 0)
+		if (SUCCEED == __hashset_entry_match(hs, entry, hash, data))
 		{
 			hs->slots[slot] = entry->next;
 			__hashset_free_entry(hs, entry);
@@ -301,7 +328,7 @@ void	zbx_hashset_remove(zbx_hashset_t *hs, const void *data)
 
 			while (NULL != entry)
 			{
-				if (entry->hash == hash && hs->compare_func(entry->data, data) == 0)
+				if (SUCCEED == __hashset_entry_match(hs, entry, hash, data))
 				{
 					prev_entry->next = entry->next;
 					__hashset_free_entry(hs, entry);
@@ -32,6 +32,9 @@
 #define ZBX_MATRIX_EL(m, row, col)	((m)->elements[(row) * (m)->columns + (col)])
 #define ZBX_MATRIX_ROW(m, row)		((m)->elements + (row) * (m)->columns)
 
+/* the number of regression coefficients of the highest supported polynomial fit (degree 6) */
+#define ZBX_REGRESSION_COLUMNS_MAX	7
+
 typedef struct
 {
 	int	rows;
@@ -102,26 +105,6 @@ static int	zbx_identity_matrix(zbx_matrix_t *m, int n)
 	return SUCCEED;
 }
 
-static int	zbx_transpose_matrix(zbx_matrix_t *m, zbx_matrix_t *r)
-{
-	int	i, j;
-
-	if (!ZBX_VALID_MATRIX(m))
-		goto error;
-
-	if (SUCCEED != zbx_matrix_alloc(r, m->columns, m->rows))
-		return FAIL;
-
-	for (i = 0; i < r->rows; i++)
-		for (j = 0; j < r->columns; j++)
-			ZBX_MATRIX_EL(r, i, j) = ZBX_MATRIX_EL(m, j, i);
-
-	return SUCCEED;
-error:
-	THIS_SHOULD_NEVER_HAPPEN;
-	return FAIL;
-}
-
 static void	zbx_matrix_swap_rows(zbx_matrix_t *m, int r1, int r2)
 {
 	double	tmp;
@@ -298,147 +281,110 @@ error:
 	return FAIL;
 }
 
-static int	zbx_least_squares(zbx_matrix_t *independent, zbx_matrix_t *dependent, zbx_matrix_t *coefficients)
-{
-	/*                         |<----------to_be_inverted---------->|                                          */
-	/* coefficients = inverse( transpose( independent ) * independent ) * transpose( independent ) * dependent */
-	/*                |<------------------left_part------------------>|   |<-----------right_part----------->| */
-	/*           we change order of matrix multiplication to reduce operation count and memory usage           */
-	zbx_matrix_t	*independent_transposed = NULL, *to_be_inverted = NULL, *left_part = NULL, *right_part = NULL;
-	int		res;
-
-	zbx_matrix_struct_alloc(&independent_transposed);
-	zbx_matrix_struct_alloc(&to_be_inverted);
-	zbx_matrix_struct_alloc(&left_part);
-	zbx_matrix_struct_alloc(&right_part);
-
-	if (SUCCEED != (res = zbx_transpose_matrix(independent, independent_transposed)))
-		goto out;
-
-	if (SUCCEED != (res = zbx_matrix_mult(independent_transposed, independent, to_be_inverted)))
-		goto out;
-
-	if (SUCCEED != (res = zbx_inverse_matrix(to_be_inverted, left_part)))
-		goto out;
-
-	if (SUCCEED != (res = zbx_matrix_mult(independent_transposed, dependent, right_part)))
-		goto out;
-
-	if (SUCCEED != (res = zbx_matrix_mult(left_part, right_part, coefficients)))
-		goto out;
-
-out:
-	zbx_matrix_free(independent_transposed);
-	zbx_matrix_free(to_be_inverted);
-	zbx_matrix_free(left_part);
-	zbx_matrix_free(right_part);
-	return res;
-}
-
-static int	zbx_fill_dependent(double *x, int n, zbx_fit_t fit, zbx_matrix_t *m)
+static void	zbx_fill_independent_row(double t, zbx_fit_t fit, int k, double *row)
 {
-	int	i;
+	double	element;
+	int	j;
 
-	if (FIT_LINEAR == fit || FIT_POLYNOMIAL == fit || FIT_LOGARITHMIC == fit)
+	if (FIT_LINEAR == fit || FIT_EXPONENTIAL == fit)
 	{
-		if (SUCCEED != zbx_matrix_alloc(m, n, 1))
-			return FAIL;
-
-		for (i = 0; i < n; i++)
-			ZBX_MATRIX_EL(m, i, 0) = x[i];
+		row[0] = 1.0;
+		row[1] = t;
 	}
-	else if (FIT_EXPONENTIAL == fit || FIT_POWER == fit)
+	else if (FIT_LOGARITHMIC == fit || FIT_POWER == fit)
 	{
-		if (SUCCEED != zbx_matrix_alloc(m, n, 1))
-			return FAIL;
+		row[0] = 1.0;
+		row[1] = log(t);
+	}
+	else if (FIT_POLYNOMIAL == fit)
+	{
+		element = 1.0;
 
-		for (i = 0; i < n; i++)
+		for (j = 0; j < k; j++)
 		{
-			if (0.0 >= x[i])
-			{
-				zabbix_log(LOG_LEVEL_DEBUG, "data contains negative or zero values");
-				return FAIL;
-			}
-
-			ZBX_MATRIX_EL(m, i, 0) = log(x[i]);
+			row[j] = element;
+			element *= t;
 		}
-	}
 
-	return SUCCEED;
+		row[k] = element;
+	}
 }
 
-static int	zbx_fill_independent(double *t, int n, zbx_fit_t fit, int k, zbx_matrix_t *m)
+static int	zbx_regression(double *t, double *x, int n, zbx_fit_t fit, int k, zbx_matrix_t *coefficients)
 {
-	double	element;
-	int	i, j;
-
-	if (FIT_LINEAR == fit || FIT_EXPONENTIAL == fit)
+	/* coefficients = inverse( transpose( independent ) * independent ) * transpose( independent ) * dependent */
+	/*                         |<------------normal------------->|     |<-----------right_part----------->|   */
+	/* Both products are accumulated row by row in one pass over data, so the independent and dependent       */
+	/* matrices of n rows are never built. The products are summed in the same order as by full matrix       */
+	/* multiplication, so the result does not change.                                                         */
+	zbx_matrix_t	*normal = NULL, *normal_inverted = NULL, *right_part = NULL;
+	double		row[ZBX_REGRESSION_COLUMNS_MAX], dependent;
+	int		i, j, l, columns, res;
+
+	if (FIT_POLYNOMIAL == fit)
 	{
-		if (SUCCEED != zbx_matrix_alloc(m, n, 2))
-			return FAIL;
+		if (k > n - 1)
+			k = n - 1;
 
-		for (i = 0; i < n; i++)
-		{
-			ZBX_MATRIX_EL(m, i, 0) = 1.0;
-			ZBX_MATRIX_EL(m, i, 1) = t[i];
-		}
+		columns = k + 1;
 	}
-	else if (FIT_LOGARITHMIC == fit || FIT_POWER == fit)
-	{
-		if (SUCCEED != zbx_matrix_alloc(m, n, 2))
-			return FAIL;
+	else
+		columns = 2;
 
-		for (i = 0; i < n; i++)
-		{
-			ZBX_MATRIX_EL(m, i, 0) = 1.0;
-			ZBX_MATRIX_EL(m, i, 1) = log(t[i]);
-		}
-	}
-	else if (FIT_POLYNOMIAL == fit)
+	if (0 >= n || ZBX_REGRESSION_COLUMNS_MAX < columns)
 	{
-		if (k > n - 1)
-			k = n - 1;
+		THIS_SHOULD_NEVER_HAPPEN;
+		return FAIL;
+	}
 
-		if (SUCCEED != zbx_matrix_alloc(m, n, k+1))
-			return FAIL;
+	zbx_matrix_struct_alloc(&normal);
+	zbx_matrix_struct_alloc(&normal_inverted);
+	zbx_matrix_struct_alloc(&right_part);
 
-		for (i = 0; i < n; i++)
-		{
-			element = 1.0;
+	if (SUCCEED != (res = zbx_matrix_alloc(normal, columns, columns)))
+		goto out;
+
+	if (SUCCEED != (res = zbx_matrix_alloc(right_part, columns, 1)))
+		goto out;
+
+	memset(normal->elements, 0, sizeof(double) * columns * columns);
+	memset(right_part->elements, 0, sizeof(double) * columns);
 
-			for (j = 0; j < k; j++)
+	for (i = 0; i < n; i++)
+	{
+		if (FIT_EXPONENTIAL == fit || FIT_POWER == fit)
+		{
+			if (0.0 >= x[i])
 			{
-				ZBX_MATRIX_EL(m, i, j) = element;
-				element *= t[i];
+				zabbix_log(LOG_LEVEL_DEBUG, "data contains negative or zero values");
+				res = FAIL;
+				goto out;
 			}
 
-			ZBX_MATRIX_EL(m, i, k) = element;
+			dependent = log(x[i]);
 		}
-	}
-
-	return SUCCEED;
-}
-
-static int	zbx_regression(double *t, double *x, int n, zbx_fit_t fit, int k, zbx_matrix_t *coefficients)
-{
-	zbx_matrix_t	*independent = NULL, *dependent = NULL;
-	int		res;
+		else
+			dependent = x[i];
 
-	zbx_matrix_struct_alloc(&independent);
-	zbx_matrix_struct_alloc(&dependent);
+		zbx_fill_independent_row(t[i], fit, k, row);
 
-	if (SUCCEED != (res = zbx_fill_independent(t, n, fit, k, independent)))
-		goto out;
+		for (j = 0; j < columns; j++)
+		{
+			for (l = 0; l < columns; l++)
+				ZBX_MATRIX_EL(normal, j, l) += row[j] * row[l];
 
-	if (SUCCEED != (res = zbx_fill_dependent(x, n, fit, dependent)))
-		goto out;
+			ZBX_MATRIX_EL(right_part, j, 0) += row[j] * dependent;
+		}
+	}
 
-	if (SUCCEED != (res = zbx_least_squares(independent, dependent, coefficients)))
+	if (SUCCEED != (res = zbx_inverse_matrix(normal, normal_inverted)))
 		goto out;
 
+	res = zbx_matrix_mult(normal_inverted, right_part, coefficients);
 out:
-	zbx_matrix_free(independent);
-	zbx_matrix_free(dependent);
+	zbx_matrix_free(normal);
+	zbx_matrix_free(normal_inverted);
+	zbx_matrix_free(right_part);
 	return res;
 }
 
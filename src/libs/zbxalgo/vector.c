@@ -31,6 +31,237 @@ ZBX_VECTOR_IMPL(dbl, double)
 
 ZBX_PTR_VECTOR_IMPL(tags, zbx_tag_t*)
 
+/* smaller vectors are sorted with qsort, radix sort counting overhead does not pay off */
+#define ZBX_VECTOR_UINT64_RADIX_MIN	256
+
+#define ZBX_VECTOR_UINT64_RADIX_BITS	8
+#define ZBX_VECTOR_UINT64_RADIX_SIZE	(1 << ZBX_VECTOR_UINT64_RADIX_BITS)
+#define ZBX_VECTOR_UINT64_RADIX_PASSES	(64 / ZBX_VECTOR_UINT64_RADIX_BITS)
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: sorts uint64 vector in ascending order                            *
+ *                                                                            *
+ * Parameters: vector - [IN/OUT]                                              *
+ *                                                                            *
+ * Comments: Large vectors are sorted with LSD radix sort. Passes over bytes  *
+ *           that are the same for all values (typically the high bytes of    *
+ *           database identifiers) are skipped.                               *
+ *           The result is the same as zbx_vector_uint64_sort() with          *
+ *           ZBX_DEFAULT_UINT64_COMPARE_FUNC.                                 *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_vector_uint64_sort_asc(zbx_vector_uint64_t *vector)
+{
+	size_t		counts[ZBX_VECTOR_UINT64_RADIX_PASSES][ZBX_VECTOR_UINT64_RADIX_SIZE], i, num, offset, count;
+	zbx_uint64_t	*src, *dst, *tmp, *buffer;
+	int		pass, shift;
+
+	if (ZBX_VECTOR_UINT64_RADIX_MIN > vector->values_num)
+	{
+		zbx_vector_uint64_sort(vector, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		return;
+	}
+
+	num = (size_t)vector->values_num;
+	memset(counts, 0, sizeof(counts));
+
+	for (i = 0; i < num; i++)
+	{
+		zbx_uint64_t	value = vector->values[i];
+
+		for (pass = 0; pass < ZBX_VECTOR_UINT64_RADIX_PASSES; pass++)
+		{
+			counts[pass][value & (ZBX_VECTOR_UINT64_RADIX_SIZE - 1)]++;
+			value >>= ZBX_VECTOR_UINT64_RADIX_BITS;
+		}
+	}
+
+	buffer = (zbx_uint64_t *)zbx_malloc(NULL, num * sizeof(zbx_uint64_t));
+	src = vector->values;
+	dst = buffer;
+
+	for (pass = 0; pass < ZBX_VECTOR_UINT64_RADIX_PASSES; pass++)
+	{
+		shift = pass * ZBX_VECTOR_UINT64_RADIX_BITS;
+
+		/* all values have the same digit - the pass would not change the order */
+		if (num == counts[pass][(src[0] >> shift) & (ZBX_VECTOR_UINT64_RADIX_SIZE - 1)])
+			continue;
+
+		for (i = 0, offset = 0; i < ZBX_VECTOR_UINT64_RADIX_SIZE; i++)
+		{
+			count = counts[pass][i];
+			counts[pass][i] = offset;
+			offset += count;
+		}
+
+		for (i = 0; i < num; i++)
+			dst[counts[pass][(src[i] >> shift) & (ZBX_VECTOR_UINT64_RADIX_SIZE - 1)]++] = src[i];
+
+		tmp = src;
+		src = dst;
+		dst = tmp;
+	}
+
+	if (src != vector->values)
+		memcpy(vector->values, src, num * sizeof(zbx_uint64_t));
+
+	zbx_free(buffer);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: removes duplicate values from uint64 vector sorted in ascending   *
+ *          order                                                             *
+ *                                                                            *
+ * Parameters: vector - [IN/OUT]                                              *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_vector_uint64_uniq_asc(zbx_vector_uint64_t *vector)
+{
+	int	i, j;
+
+	if (2 > vector->values_num)
+		return;
+
+	/* branchless - the value is always copied, but the position advances only for new values */
+	for (i = 1, j = 1; i < vector->values_num; i++)
+	{
+		vector->values[j] = vector->values[i];
+		j += (vector->values[i] != vector->values[j - 1]);
+	}
+
+	vector->values_num = j;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: sorts uint64 vector in ascending order and removes duplicates     *
+ *                                                                            *
+ * Parameters: vector - [IN/OUT]                                              *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_vector_uint64_sort_uniq(zbx_vector_uint64_t *vector)
+{
+	zbx_vector_uint64_sort_asc(vector);
+	zbx_vector_uint64_uniq_asc(vector);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: removes from left vector values found in right vector             *
+ *                                                                            *
+ * Parameters: left  - [IN/OUT]                                               *
+ *             right - [IN]                                                   *
+ *                                                                            *
+ * Comments: Both vectors must be sorted in ascending order. Each value in    *
+ *           right vector removes at most one matching value from left        *
+ *           vector, the same as zbx_vector_uint64_setdiff().                 *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_vector_uint64_setdiff_asc(zbx_vector_uint64_t *left, const zbx_vector_uint64_t *right)
+{
+	int	i, j, k;
+
+	for (i = 0, j = 0, k = 0; i < left->values_num; i++)
+	{
+		while (j < right->values_num && right->values[j] < left->values[i])
+			j++;
+
+		if (j < right->values_num && right->values[j] == left->values[i])
+		{
+			j++;
+			continue;
+		}
+
+		left->values[k++] = left->values[i];
+	}
+
+	left->values_num = k;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: keeps in left vector only values found in right vector            *
+ *                                                                            *
+ * Parameters: left  - [IN/OUT]                                               *
+ *             right - [IN]                                                   *
+ *                                                                            *
+ * Comments: Both vectors must be sorted in ascending order.                  *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_vector_uint64_intersect_asc(zbx_vector_uint64_t *left, const zbx_vector_uint64_t *right)
+{
+	int	i, j, k;
+
+	for (i = 0, j = 0, k = 0; i < left->values_num && j < right->values_num;)
+	{
+		if (left->values[i] < right->values[j])
+		{
+			i++;
+		}
+		else if (left->values[i] > right->values[j])
+		{
+			j++;
+		}
+		else
+		{
+			left->values[k++] = left->values[i++];
+			j++;
+		}
+	}
+
+	left->values_num = k;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: merges right vector values into left vector                       *
+ *                                                                            *
+ * Parameters: left  - [IN/OUT]                                               *
+ *             right - [IN]                                                   *
+ *                                                                            *
+ * Comments: Both vectors must be sorted in ascending order and contain       *
+ *           unique values. The result is sorted and contains unique values.  *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_vector_uint64_union_asc(zbx_vector_uint64_t *left, const zbx_vector_uint64_t *right)
+{
+	int	i, j, k, num;
+
+	if (0 == right->values_num)
+		return;
+
+	num = left->values_num + right->values_num;
+	zbx_vector_uint64_reserve(left, (size_t)num);
+
+	/* merge from the end so values can be placed in left vector without additional buffer */
+	for (i = left->values_num - 1, j = right->values_num - 1, k = num - 1; 0 <= j; k--)
+	{
+		if (0 <= i && left->values[i] > right->values[j])
+		{
+			left->values[k] = left->values[i--];
+		}
+		else
+		{
+			if (0 <= i && left->values[i] == right->values[j])
+				i--;
+
+			left->values[k] = right->values[j--];
+		}
+	}
+
+	/* remaining left values are already in place, unless duplicates left a gap before merged values */
+	if (k != i)
+	{
+		memmove(left->values + i + 1, left->values + k + 1, (size_t)(num - k - 1) * sizeof(zbx_uint64_t));
+		num -= k - i;
+	}
+
+	left->values_num = num;
+}
+
 void	zbx_ptr_free(void *data)
 {
 	zbx_free(data);
@@ -33,6 +33,9 @@
 static int		audit_mode;
 static zbx_hashset_t	zbx_audit;
 
+/* the last found entry - audit details are usually appended to the same entry many times in a row */
+static zbx_audit_entry_t	*audit_last_entry;
+
 int	zbx_get_audit_mode(void)
 {
 	return audit_mode;
@@ -264,6 +267,37 @@ static int	zbx_audit_compare_func(const void *d1, const void *d2)
 	return zbx_strcmp_null((*audit_entry_1)->cuid, (*audit_entry_2)->cuid);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: finds audit entry                                                 *
+ *                                                                            *
+ * Parameters: id       - [IN] resource id                                    *
+ *             cuid     - [IN] resource cuid (optional)                       *
+ *             id_table - [IN] resource table                                 *
+ *                                                                            *
+ * Return value: The audit entry or NULL if not found.                        *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_audit_entry_t	*audit_entry_find(zbx_uint64_t id, const char *cuid, int id_table)
+{
+	zbx_audit_entry_t	local_audit_entry, *plocal_audit_entry = &local_audit_entry, **paudit_entry;
+
+	if (NULL != audit_last_entry && id == audit_last_entry->id && id_table == audit_last_entry->id_table &&
+			0 == zbx_strcmp_null(cuid, audit_last_entry->cuid))
+	{
+		return audit_last_entry;
+	}
+
+	local_audit_entry.id = id;
+	local_audit_entry.cuid = (char *)cuid;
+	local_audit_entry.id_table = id_table;
+
+	if (NULL == (paudit_entry = (zbx_audit_entry_t **)zbx_hashset_search(&zbx_audit, &plocal_audit_entry)))
+		return NULL;
+
+	return audit_last_entry = *paudit_entry;
+}
+
 void	zbx_audit_clean(void)
 {
 	zbx_hashset_iter_t	iter;
@@ -282,12 +316,14 @@ void	zbx_audit_clean(void)
 	}
 
 	zbx_hashset_destroy(&zbx_audit);
+	audit_last_entry = NULL;
 }
 
 void	zbx_audit_init(int audit_mode_set)
 {
 	audit_mode = audit_mode_set;
 	RETURN_IF_AUDIT_OFF();
+	audit_last_entry = NULL;
 #define AUDIT_HASHSET_DEF_SIZE	100
 	zbx_hashset_create(&zbx_audit, AUDIT_HASHSET_DEF_SIZE, zbx_audit_hash_func, zbx_audit_compare_func);
 #undef AUDIT_HASHSET_DEF_SIZE
@@ -315,9 +351,18 @@ static int	zbx_audit_validate_entry(const zbx_audit_entry_t *entry)
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: writes collected audit entries to database                        *
+ *                                                                            *
+ * Comments: Audit records are written in bulk with COPY statement when it is *
+ *           supported by database, otherwise with multi-row inserts.         *
+ *                                                                            *
+ ******************************************************************************/
 void	zbx_audit_flush(void)
 {
 	char			recsetid_cuid[CUID_LEN];
+	int			now;
 	zbx_hashset_iter_t	iter;
 	zbx_audit_entry_t	**audit_entry;
 	zbx_db_insert_t		db_insert_audit;
@@ -326,16 +371,18 @@ void	zbx_audit_flush(void)
 
 	zbx_new_cuid(recsetid_cuid);
 	zbx_hashset_iter_reset(&zbx_audit, &iter);
+	now = (int)time(NULL);
 
 	zbx_db_insert_prepare(&db_insert_audit, "auditlog", "auditid", "userid", "username", "clock", "action", "ip",
 			"resourceid", "resourcename", "resourcetype", "recordsetid", "details", NULL);
+	zbx_db_insert_use_copy(&db_insert_audit);
 
 	while (NULL != (audit_entry = (zbx_audit_entry_t **)zbx_hashset_iter_next(&iter)))
 	{
 		if (SUCCEED == zbx_audit_validate_entry(*audit_entry))
 		{
 			zbx_db_insert_add_values(&db_insert_audit, (*audit_entry)->audit_cuid, AUDIT_USERID,
-					AUDIT_USERNAME, (int)time(NULL), (*audit_entry)->audit_action, AUDIT_IP,
+					AUDIT_USERNAME, now, (*audit_entry)->audit_action, AUDIT_IP,
 					(*audit_entry)->id, (*audit_entry)->name, (*audit_entry)->resource_type,
 					recsetid_cuid, 0 == strcmp((*audit_entry)->details_json.buffer, "{}") ? "" :
 					(*audit_entry)->details_json.buffer);
@@ -454,84 +501,60 @@ static int	audit_field_default(const char *table_name, const char *field_name, c
 void	zbx_audit_update_json_append_string(const zbx_uint64_t id, const int id_table, const char *audit_op,
 		const char *key, const char *value, const char *table, const char *field)
 {
-	zbx_audit_entry_t	local_audit_entry, **found_audit_entry;
-	zbx_audit_entry_t	*local_audit_entry_x = &local_audit_entry;
+	zbx_audit_entry_t	*found_audit_entry;
 
 	if (SUCCEED == audit_field_default(table, field, value, 0))
 		return;
 
-	local_audit_entry.id = id;
-	local_audit_entry.cuid = NULL;
-	local_audit_entry.id_table = id_table;
-	found_audit_entry = (zbx_audit_entry_t**)zbx_hashset_search(&zbx_audit, &(local_audit_entry_x));
-
-	if (NULL == found_audit_entry)
+	if (NULL == (found_audit_entry = audit_entry_find(id, NULL, id_table)))
 	{
 		THIS_SHOULD_NEVER_HAPPEN;
 		exit(EXIT_FAILURE);
 	}
 
-	append_str_json(&((*found_audit_entry)->details_json), audit_op, key, value);
+	append_str_json(&found_audit_entry->details_json, audit_op, key, value);
 }
 
 void	zbx_audit_update_json_append_string_secret(const zbx_uint64_t id, const int id_table, const char *audit_op,
 		const char *key, const char *value, const char *table, const char *field)
 {
-	zbx_audit_entry_t	local_audit_entry, **found_audit_entry;
-	zbx_audit_entry_t	*local_audit_entry_x = &local_audit_entry;
+	zbx_audit_entry_t	*found_audit_entry;
 
 	if (SUCCEED == audit_field_default(table, field, value, 0))
 		return;
 
-	local_audit_entry.id = id;
-	local_audit_entry.cuid = NULL;
-	local_audit_entry.id_table = id_table;
-	found_audit_entry = (zbx_audit_entry_t**)zbx_hashset_search(&zbx_audit, &(local_audit_entry_x));
-
-	if (NULL == found_audit_entry)
+	if (NULL == (found_audit_entry = audit_entry_find(id, NULL, id_table)))
 	{
 		THIS_SHOULD_NEVER_HAPPEN;
 		exit(EXIT_FAILURE);
 	}
 
-	append_str_json(&((*found_audit_entry)->details_json), audit_op, key, ZBX_MACRO_SECRET_MASK);
+	append_str_json(&found_audit_entry->details_json, audit_op, key, ZBX_MACRO_SECRET_MASK);
 }
 
 void	zbx_audit_update_json_append_uint64(const zbx_uint64_t id, const int id_table, const char *audit_op,
 		const char *key, uint64_t value, const char *table, const char *field)
 {
 	char			buffer[MAX_ID_LEN];
-	zbx_audit_entry_t	local_audit_entry, **found_audit_entry;
-	zbx_audit_entry_t	*local_audit_entry_x = &local_audit_entry;
+	zbx_audit_entry_t	*found_audit_entry;
 
 	zbx_snprintf(buffer, sizeof(buffer), ZBX_FS_UI64, value);
 	if (SUCCEED == audit_field_default(table, field, buffer, value))
 		return;
 
-	local_audit_entry.id = id;
-	local_audit_entry.cuid = NULL;
-	local_audit_entry.id_table = id_table;
-	found_audit_entry = (zbx_audit_entry_t**)zbx_hashset_search(&zbx_audit, &(local_audit_entry_x));
-
-	if (NULL == found_audit_entry)
+	if (NULL == (found_audit_entry = audit_entry_find(id, NULL, id_table)))
 	{
 		THIS_SHOULD_NEVER_HAPPEN;
 		exit(EXIT_FAILURE);
 	}
 
-	append_uint64_json(&((*found_audit_entry)->details_json), audit_op, key, value);
+	append_uint64_json(&found_audit_entry->details_json, audit_op, key, value);
 }
 
 #define PREPARE_UPDATE_JSON_APPEND_OP(...)					\
-	zbx_audit_entry_t	local_audit_entry, **found_audit_entry;		\
-	zbx_audit_entry_t	*local_audit_entry_x = &local_audit_entry;	\
+	zbx_audit_entry_t	*found_audit_entry;				\
 										\
-	local_audit_entry.id = id;						\
-	local_audit_entry.cuid = NULL;						\
-	local_audit_entry.id_table = id_table;					\
-	found_audit_entry = (zbx_audit_entry_t**)zbx_hashset_search(&zbx_audit,	\
-			&(local_audit_entry_x));				\
-	if (NULL == found_audit_entry)						\
+	if (NULL == (found_audit_entry = audit_entry_find(id, NULL, id_table)))	\
 	{									\
 		zbx_hashset_iter_t	iter;					\
 		zbx_audit_entry_t	**log_audit_entry;			\
@@ -556,7 +579,7 @@ void	zbx_audit_update_json_append_no_value(const zbx_uint64_t id, const int id_t
 		const char *key)
 {
 	PREPARE_UPDATE_JSON_APPEND_OP()
-	append_json_no_value(&((*found_audit_entry)->details_json), audit_op, key);
+	append_json_no_value(&found_audit_entry->details_json, audit_op, key);
 }
 
 void	zbx_audit_update_json_append_int(const zbx_uint64_t id, const int id_table, const char *audit_op,
@@ -573,7 +596,7 @@ void	zbx_audit_update_json_append_int(const zbx_uint64_t id, const int id_table,
 	else
 	{
 		PREPARE_UPDATE_JSON_APPEND_OP()
-		append_int_json(&((*found_audit_entry)->details_json), audit_op, key, value);
+		append_int_json(&found_audit_entry->details_json, audit_op, key, value);
 	}
 }
 
@@ -591,7 +614,7 @@ void	zbx_audit_update_json_append_double(const zbx_uint64_t id, const int id_tab
 	else
 	{
 		PREPARE_UPDATE_JSON_APPEND_OP()
-		append_double_json(&((*found_audit_entry)->details_json), audit_op, key, value);
+		append_double_json(&found_audit_entry->details_json, audit_op, key, value);
 	}
 }
 
@@ -599,51 +622,47 @@ void	zbx_audit_update_json_update_string(const zbx_uint64_t id, const int id_tab
 		const char *value_old, const char *value_new)
 {
 	PREPARE_UPDATE_JSON_APPEND_OP()
-	update_str_json(&((*found_audit_entry)->details_json), key, value_old, value_new);
+	update_str_json(&found_audit_entry->details_json, key, value_old, value_new);
 }
 
 void	zbx_audit_update_json_update_uint64(const zbx_uint64_t id, const int id_table, const char *key,
 		uint64_t value_old, uint64_t value_new)
 {
 	PREPARE_UPDATE_JSON_APPEND_OP()
-	update_uint64_json(&((*found_audit_entry)->details_json), key, value_old, value_new);
+	update_uint64_json(&found_audit_entry->details_json, key, value_old, value_new);
 }
 
 void	zbx_audit_update_json_update_int(const zbx_uint64_t id, const int id_table, const char *key, int value_old,
 		int value_new)
 {
 	PREPARE_UPDATE_JSON_APPEND_OP()
-	update_int_json(&((*found_audit_entry)->details_json), key, value_old, value_new);
+	update_int_json(&found_audit_entry->details_json, key, value_old, value_new);
 }
 
 void	zbx_audit_update_json_update_double(const zbx_uint64_t id, const int id_table, const char *key,
 		double value_old, double value_new)
 {
 	PREPARE_UPDATE_JSON_APPEND_OP()
-	update_double_json(&((*found_audit_entry)->details_json), key, value_old, value_new);
+	update_double_json(&found_audit_entry->details_json, key, value_old, value_new);
 }
 
 void	zbx_audit_update_json_delete(const zbx_uint64_t id, const int id_table, const char *audit_op, const char *key)
 {
 	PREPARE_UPDATE_JSON_APPEND_OP()
-	delete_json(&((*found_audit_entry)->details_json), audit_op, key);
+	delete_json(&found_audit_entry->details_json, audit_op, key);
 }
 
 zbx_audit_entry_t	*zbx_audit_get_entry(zbx_uint64_t id, const char *cuid, int id_table)
 {
-	zbx_audit_entry_t	local_audit_entry, *plocal_audit_entry = &local_audit_entry, **paudit_entry;
-
-	local_audit_entry.id = id;
-	local_audit_entry.cuid = (char *)cuid;
-	local_audit_entry.id_table = id_table;
+	zbx_audit_entry_t	*audit_entry;
 
-	if (NULL == (paudit_entry = (zbx_audit_entry_t**)zbx_hashset_search(&zbx_audit, &plocal_audit_entry)))
+	if (NULL == (audit_entry = audit_entry_find(id, cuid, id_table)))
 	{
 		THIS_SHOULD_NEVER_HAPPEN;
 		exit(EXIT_FAILURE);
 	}
 
-	return *paudit_entry;
+	return audit_entry;
 }
 
 void	zbx_audit_entry_append_int(zbx_audit_entry_t *entry, int audit_op, const char *key, ...)
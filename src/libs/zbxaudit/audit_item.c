@@ -115,6 +115,8 @@ void	zbx_audit_item_update_json_add_data(zbx_uint64_t itemid, const zbx_template
 	}
 
 	ADD_JSON_UI(allow_traps, AUDIT_TABLE_NAME, "allow_traps");
+	ADD_JSON_UI(history_downsample, AUDIT_TABLE_NAME, "history_downsample");
+	ADD_JSON_S(history_downsample_param, AUDIT_TABLE_NAME, "history_downsample_param");
 	ADD_JSON_UI(authtype, AUDIT_TABLE_NAME, "authtype");
 	ADD_JSON_S(description, AUDIT_TABLE_NAME, "description");
 
@@ -284,6 +286,8 @@ PREPARE_AUDIT_ITEM_UPDATE(ssl_key_password,	const char*,	string)
 PREPARE_AUDIT_ITEM_UPDATE(verify_peer,		int,		int)
 PREPARE_AUDIT_ITEM_UPDATE(verify_host,		int,		int)
 PREPARE_AUDIT_ITEM_UPDATE(allow_traps,		int,		int)
+PREPARE_AUDIT_ITEM_UPDATE(history_downsample,	int,		int)
+PREPARE_AUDIT_ITEM_UPDATE(history_downsample_param,	const char*,	string)
 PREPARE_AUDIT_ITEM_UPDATE(discover,		int,		int)
 PREPARE_AUDIT_ITEM_UPDATE(key,			const char*,	string)
 #undef PREPARE_AUDIT_ITEM_UPDATE
@@ -52,6 +52,108 @@ static int	interface_availability_compare(const void *d1, const void *d2)
 	return ia1->id - ia2->id;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: merges availability updates of the same interface                 *
+ *                                                                            *
+ * Parameters: interface_availabilities - [IN/OUT] interface availability     *
+ *                                        updates sorted by interfaceid and   *
+ *                                        arrival order                       *
+ *                                                                            *
+ * Comments: Fields set by later updates override the same fields of earlier  *
+ *           updates, so flapping interfaces are written only once per flush. *
+ *                                                                            *
+ ******************************************************************************/
+static void	interface_availabilities_coalesce(zbx_vector_availability_ptr_t *interface_availabilities)
+{
+	int	i, j;
+
+	for (i = 0, j = 1; j < interface_availabilities->values_num; j++)
+	{
+		zbx_interface_availability_t	*last = interface_availabilities->values[i],
+						*ia = interface_availabilities->values[j];
+
+		if (last->interfaceid != ia->interfaceid)
+		{
+			interface_availabilities->values[++i] = ia;
+			continue;
+		}
+
+		if (0 != (ia->agent.flags & ZBX_FLAGS_AGENT_STATUS_AVAILABLE))
+			last->agent.available = ia->agent.available;
+
+		if (0 != (ia->agent.flags & ZBX_FLAGS_AGENT_STATUS_ERROR))
+		{
+			zbx_free(last->agent.error);
+			last->agent.error = ia->agent.error;
+			ia->agent.error = NULL;
+		}
+
+		if (0 != (ia->agent.flags & ZBX_FLAGS_AGENT_STATUS_ERRORS_FROM))
+			last->agent.errors_from = ia->agent.errors_from;
+
+		if (0 != (ia->agent.flags & ZBX_FLAGS_AGENT_STATUS_DISABLE_UNTIL))
+			last->agent.disable_until = ia->agent.disable_until;
+
+		last->agent.flags |= ia->agent.flags;
+		last->id = ia->id;
+
+		zbx_interface_availability_free(ia);
+	}
+
+	if (0 != interface_availabilities->values_num)
+		interface_availabilities->values_num = i + 1;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: writes queued interface availability updates into database        *
+ *                                                                            *
+ ******************************************************************************/
+static int	flush_interface_availabilities(zbx_vector_availability_ptr_t *interface_availabilities)
+{
+	int	processed_num = interface_availabilities->values_num;
+
+	zbx_vector_availability_ptr_sort(interface_availabilities, interface_availability_compare);
+	interface_availabilities_coalesce(interface_availabilities);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() updates:%d interfaces:%d", __func__, processed_num,
+			interface_availabilities->values_num);
+
+	zbx_db_update_interface_availabilities(interface_availabilities);
+	zbx_vector_availability_ptr_clear_ext(interface_availabilities, zbx_interface_availability_free);
+
+	return processed_num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: queues active check status update of a host                       *
+ *                                                                            *
+ * Comments: The last status queued during flush period is written.           *
+ *                                                                            *
+ ******************************************************************************/
+static void	queue_active_check_status(zbx_avail_active_hb_cache_t *cache, zbx_uint64_t hostid, int status)
+{
+	zbx_host_active_avail_t	*queued_host;
+
+	if (NULL != (queued_host = zbx_hashset_search(&cache->queue, &hostid)))
+	{
+		queued_host->active_status = status;
+	}
+	else
+	{
+		zbx_host_active_avail_t	host_local;
+
+		host_local.active_status = status;
+		host_local.hostid = hostid;
+		host_local.lastaccess_active = 0;
+		host_local.heartbeat_freq = 0;
+
+		zbx_hashset_insert(&cache->queue, &host_local, sizeof(zbx_host_active_avail_t));
+	}
+}
+
 static void	process_new_active_check_heartbeat(zbx_avail_active_hb_cache_t *cache,
 		zbx_host_active_avail_t *avail_new)
 {
@@ -228,28 +330,8 @@ static void	process_confsync_diff(zbx_avail_active_hb_cache_t *cache, zbx_ipc_me
 
 	for (int i = 0; i < hostids.values_num; i++)
 	{
-		zbx_host_active_avail_t	*queued_host;
-		zbx_uint64_t		hostid;
-
-		hostid = hostids.values[i];
-
-		zbx_hashset_remove(&cache->hosts, &hostid);
-
-		if (NULL != (queued_host = zbx_hashset_search(&cache->queue, &hostid)))
-		{
-			queued_host->active_status = ZBX_INTERFACE_AVAILABLE_UNKNOWN;
-		}
-		else
-		{
-			zbx_host_active_avail_t	host_local;
-
-			host_local.active_status = ZBX_INTERFACE_AVAILABLE_UNKNOWN;
-			host_local.hostid = hostid;
-			host_local.lastaccess_active = 0;
-			host_local.heartbeat_freq = 0;
-
-			zbx_hashset_insert(&cache->queue, &host_local, sizeof(zbx_host_active_avail_t));
-		}
+		zbx_hashset_remove(&cache->hosts, &hostids.values[i]);
+		queue_active_check_status(cache, hostids.values[i], ZBX_INTERFACE_AVAILABLE_UNKNOWN);
 	}
 
 	zbx_vector_uint64_destroy(&hostids);
@@ -287,46 +369,36 @@ static void	init_active_availability(zbx_avail_active_hb_cache_t *cache, unsigne
 		zbx_db_free_result(result);
 	}
 }
-static void	flush_proxy_hostdata(zbx_avail_active_hb_cache_t *cache, zbx_ipc_message_t *message)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: queues active check statuses received from proxy                  *
+ *                                                                            *
+ * Comments: The statuses are written together with other queued active check *
+ *           statuses during the next flush.                                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	process_proxy_hostdata(zbx_avail_active_hb_cache_t *cache, zbx_ipc_message_t *message)
 {
 	zbx_uint64_t			proxy_hostid;
 	zbx_vector_proxy_hostdata_ptr_t	hosts;
-	zbx_proxy_hostdata_t		*host;
-	zbx_vector_uint64_t		status_unknown, status_available, status_unavailable;
 	zbx_active_avail_proxy_t	*proxy_avail;
 
 	zbx_vector_proxy_hostdata_ptr_create(&hosts);
 
 	zbx_availability_deserialize_proxy_hostdata(message->data, &hosts, &proxy_hostid);
 
-	zbx_vector_uint64_create(&status_unknown);
-	zbx_vector_uint64_create(&status_available);
-	zbx_vector_uint64_create(&status_unavailable);
-
 	for (int i = 0; i < hosts.values_num; i++)
 	{
-		host = hosts.values[i];
+		zbx_proxy_hostdata_t	*host = hosts.values[i];
 
-		if (host->status == ZBX_INTERFACE_AVAILABLE_UNKNOWN)
+		if (ZBX_INTERFACE_AVAILABLE_UNKNOWN != host->status && ZBX_INTERFACE_AVAILABLE_TRUE != host->status &&
+				ZBX_INTERFACE_AVAILABLE_FALSE != host->status)
 		{
-			zbx_vector_uint64_append(&status_unknown, host->hostid);
+			continue;
 		}
-		else if (host->status == ZBX_INTERFACE_AVAILABLE_TRUE)
-		{
-			zbx_vector_uint64_append(&status_available, host->hostid);
-		}
-		else if (host->status == ZBX_INTERFACE_AVAILABLE_FALSE)
-			zbx_vector_uint64_append(&status_unavailable, host->hostid);
-	}
 
-	zbx_db_begin();
-
-	db_update_active_check_status(&status_unknown, ZBX_INTERFACE_AVAILABLE_UNKNOWN);
-	db_update_active_check_status(&status_available, ZBX_INTERFACE_AVAILABLE_TRUE);
-	db_update_active_check_status(&status_unavailable, ZBX_INTERFACE_AVAILABLE_FALSE);
-
-	if (ZBX_DB_OK == zbx_db_commit())
-		zbx_hashset_clear(&cache->queue);
+		queue_active_check_status(cache, host->hostid, host->status);
+	}
 
 	if (NULL == (proxy_avail = zbx_hashset_search(&cache->proxy_avail, &proxy_hostid)))
 	{
@@ -340,9 +412,6 @@ static void	flush_proxy_hostdata(zbx_avail_active_hb_cache_t *cache, zbx_ipc_mes
 	else
 		proxy_avail->lastaccess = (int)time(NULL);
 
-	zbx_vector_uint64_destroy(&status_unknown);
-	zbx_vector_uint64_destroy(&status_available);
-	zbx_vector_uint64_destroy(&status_unavailable);
 	zbx_vector_proxy_hostdata_ptr_clear_ext(&hosts, (zbx_proxy_hostdata_ptr_free_func_t)zbx_ptr_free);
 	zbx_vector_proxy_hostdata_ptr_destroy(&hosts);
 }
@@ -408,7 +477,6 @@ static void	update_proxy_heartbeat(zbx_avail_active_hb_cache_t *cache, zbx_ipc_m
 ZBX_THREAD_ENTRY(zbx_availability_manager_thread, args)
 {
 #define AVAILABILITY_MANAGER_DELAY				1
-#define AVAILABILITY_MANAGER_FLUSH_DELAY_SEC			5
 #define AVAILABILITY_MANAGER_ACTIVE_HEARTBEAT_DELAY_SEC		10
 #define AVAILABILITY_MANAGER_PROXY_ACTIVE_AUTOFLUSH_DELAY	(SEC_PER_MIN * 5)
 #define	STAT_INTERVAL	5	/* if a process is busy and does not sleep then update status not faster than */
@@ -424,6 +492,8 @@ ZBX_THREAD_ENTRY(zbx_availability_manager_thread, args)
 	zbx_timespec_t			timeout = {AVAILABILITY_MANAGER_DELAY, 0};
 	zbx_avail_active_hb_cache_t	active_hb_cache;
 	const zbx_thread_info_t		*info = &((zbx_thread_args_t *)args)->info;
+	const zbx_thread_avail_manager_args	*avail_manager_args_in = (const zbx_thread_avail_manager_args *)
+							(((zbx_thread_args_t *)args)->args);
 	int				server_num = ((zbx_thread_args_t *)args)->info.server_num;
 	int				process_num = ((zbx_thread_args_t *)args)->info.process_num;
 	unsigned char			process_type = ((zbx_thread_args_t *)args)->info.process_type;
@@ -507,7 +577,7 @@ ZBX_THREAD_ENTRY(zbx_availability_manager_thread, args)
 					process_confsync_diff(&active_hb_cache, message);
 					break;
 				case ZBX_IPC_AVAILMAN_PROCESS_PROXY_HOSTDATA:
-					flush_proxy_hostdata(&active_hb_cache, message);
+					process_proxy_hostdata(&active_hb_cache, message);
 					break;
 				case ZBX_IPC_AVAILMAN_ACTIVE_PROXY_HB_UPDATE:
 					update_proxy_heartbeat(&active_hb_cache, message);
@@ -528,22 +598,15 @@ ZBX_THREAD_ENTRY(zbx_availability_manager_thread, args)
 			calculate_cached_active_check_availabilities(&active_hb_cache);
 		}
 
-		if (AVAILABILITY_MANAGER_FLUSH_DELAY_SEC < time_now - time_flush)
+		if (avail_manager_args_in->config_availability_flush_delay <= time_now - time_flush)
 		{
 			time_flush = time_now;
 
 			if (0 != interface_availabilities.values_num)
 			{
 				zbx_block_signals(&orig_mask);
-				zbx_vector_availability_ptr_sort(&interface_availabilities,
-						interface_availability_compare);
-
-				zbx_db_update_interface_availabilities(&interface_availabilities);
+				processed_num = flush_interface_availabilities(&interface_availabilities);
 				zbx_unblock_signals(&orig_mask);
-
-				processed_num = interface_availabilities.values_num;
-				zbx_vector_availability_ptr_clear_ext(&interface_availabilities,
-						zbx_interface_availability_free);
 			}
 
 			if (0 != active_hb_cache.queue.num_data && 0 != (info->program_type & ZBX_PROGRAM_TYPE_SERVER))
@@ -571,17 +634,17 @@ ZBX_THREAD_ENTRY(zbx_availability_manager_thread, args)
 
 	zbx_block_signals(&orig_mask);
 	if (0 != interface_availabilities.values_num)
-	{
-		zbx_vector_availability_ptr_sort(&interface_availabilities, interface_availability_compare);
-		zbx_db_update_interface_availabilities(&interface_availabilities);
-	}
+		flush_interface_availabilities(&interface_availabilities);
+
+	if (0 != active_hb_cache.queue.num_data && 0 != (info->program_type & ZBX_PROGRAM_TYPE_SERVER))
+		flush_active_hb_queue(&active_hb_cache);
+
 	zbx_db_close();
 	zbx_unblock_signals(&orig_mask);
 
 	exit(EXIT_SUCCESS);
 #undef STAT_INTERVAL
 #undef AVAILABILITY_MANAGER_DELAY
-#undef AVAILABILITY_MANAGER_FLUSH_DELAY_SEC
 #undef AVAILABILITY_MANAGER_ACTIVE_HEARTBEAT_DELAY_SEC
 #undef AVAILABILITY_MANAGER_PROXY_ACTIVE_AUTOFLUSH_DELAY
 }
@@ -188,11 +188,57 @@ int	zbx_interface_availability_is_set(const zbx_interface_availability_t *ia)
 	return FAIL;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compares values written by interface availability updates         *
+ *                                                                            *
+ ******************************************************************************/
+static int	interface_availability_compare_values(const zbx_interface_availability_t *ia1,
+		const zbx_interface_availability_t *ia2)
+{
+	ZBX_RETURN_IF_NOT_EQUAL(ia1->agent.flags, ia2->agent.flags);
+
+	if (0 != (ia1->agent.flags & ZBX_FLAGS_AGENT_STATUS_AVAILABLE))
+	{
+		ZBX_RETURN_IF_NOT_EQUAL(ia1->agent.available, ia2->agent.available);
+	}
+
+	if (0 != (ia1->agent.flags & ZBX_FLAGS_AGENT_STATUS_ERRORS_FROM))
+	{
+		ZBX_RETURN_IF_NOT_EQUAL(ia1->agent.errors_from, ia2->agent.errors_from);
+	}
+
+	if (0 != (ia1->agent.flags & ZBX_FLAGS_AGENT_STATUS_DISABLE_UNTIL))
+	{
+		ZBX_RETURN_IF_NOT_EQUAL(ia1->agent.disable_until, ia2->agent.disable_until);
+	}
+
+	if (0 != (ia1->agent.flags & ZBX_FLAGS_AGENT_STATUS_ERROR))
+		return strcmp(ZBX_NULL2EMPTY_STR(ia1->agent.error), ZBX_NULL2EMPTY_STR(ia2->agent.error));
+
+	return 0;
+}
+
+static int	interface_availability_compare_update(const void *d1, const void *d2)
+{
+	const zbx_interface_availability_t	*ia1 = *(const zbx_interface_availability_t * const *)d1;
+	const zbx_interface_availability_t	*ia2 = *(const zbx_interface_availability_t * const *)d2;
+	int					ret;
+
+	if (0 != (ret = interface_availability_compare_values(ia1, ia2)))
+		return ret;
+
+	ZBX_RETURN_IF_NOT_EQUAL(ia1->interfaceid, ia2->interfaceid);
+
+	return 0;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: adds interface availability update to sql statement               *
  *                                                                            *
  * Parameters: ia           [IN] interface availability data                  *
+ *             interfaceids [IN] identifiers of interfaces to update          *
  *             sql        - [IN/OUT] sql statement                            *
  *             sql_alloc  - [IN/OUT] number of bytes allocated for sql        *
  *                                   statement                                *
@@ -203,8 +249,8 @@ int	zbx_interface_availability_is_set(const zbx_interface_availability_t *ia)
  *               FAIL    - no interface availability is set                   *
  *                                                                            *
  ******************************************************************************/
-static int	zbx_sql_add_interface_availability(const zbx_interface_availability_t *ia, char **sql,
-		size_t *sql_alloc, size_t *sql_offset)
+static int	zbx_sql_add_interface_availability(const zbx_interface_availability_t *ia,
+		const zbx_vector_uint64_t *interfaceids, char **sql, size_t *sql_alloc, size_t *sql_offset)
 {
 	char	delim = ' ';
 
@@ -238,7 +284,9 @@ static int	zbx_sql_add_interface_availability(const zbx_interface_availability_t
 	if (0 != (ia->agent.flags & ZBX_FLAGS_AGENT_STATUS_DISABLE_UNTIL))
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%cdisable_until=%d", delim, ia->agent.disable_until);
 
-	zbx_snprintf_alloc(sql, sql_alloc, sql_offset, " where interfaceid=" ZBX_FS_UI64, ia->interfaceid);
+	zbx_strcpy_alloc(sql, sql_alloc, sql_offset, " where");
+	zbx_db_add_condition_alloc(sql, sql_alloc, sql_offset, "interfaceid", interfaceids->values,
+			interfaceids->values_num);
 
 	return SUCCEED;
 }
@@ -247,17 +295,31 @@ static int	zbx_sql_add_interface_availability(const zbx_interface_availability_t
  *                                                                            *
  * Purpose: sync interface availabilities updates into database               *
  *                                                                            *
- * Parameters: interface_availabilities - [IN] interface availability data    *
+ * Parameters: interface_availabilities - [IN] interface availability data,   *
+ *                                        one update per interface            *
+ *                                                                            *
+ * Comments: Interfaces with identical updates (for example interfaces        *
+ *           becoming available again) are updated with a single statement.  *
  *                                                                            *
  ******************************************************************************/
 void	zbx_db_update_interface_availabilities(const zbx_vector_availability_ptr_t *interface_availabilities)
 {
-	int	txn_error;
-	char	*sql = NULL;
-	size_t	sql_alloc = 4 * ZBX_KIBIBYTE;
+#define ZBX_AVAILABILITY_UPDATE_BATCH_SIZE	1000
+	int				txn_error;
+	char				*sql = NULL;
+	size_t				sql_alloc = 4 * ZBX_KIBIBYTE;
+	zbx_vector_availability_ptr_t	ias;
+	zbx_vector_uint64_t		interfaceids;
 
 	sql = (char *)zbx_malloc(sql, sql_alloc);
 
+	zbx_vector_availability_ptr_create(&ias);
+	zbx_vector_uint64_create(&interfaceids);
+
+	zbx_vector_availability_ptr_append_array(&ias, interface_availabilities->values,
+			interface_availabilities->values_num);
+	zbx_vector_availability_ptr_sort(&ias, interface_availability_compare_update);
+
 	do
 	{
 		size_t	sql_offset = 0;
@@ -265,10 +327,21 @@ void	zbx_db_update_interface_availabilities(const zbx_vector_availability_ptr_t
 		zbx_db_begin();
 		zbx_db_begin_multiple_update(&sql, &sql_alloc, &sql_offset);
 
-		for (int i = 0; i < interface_availabilities->values_num; i++)
+		for (int i = 0; i < ias.values_num;)
 		{
-			if (SUCCEED != zbx_sql_add_interface_availability(interface_availabilities->values[i], &sql,
-					&sql_alloc, &sql_offset))
+			const zbx_interface_availability_t	*ia = ias.values[i];
+
+			zbx_vector_uint64_clear(&interfaceids);
+
+			do
+			{
+				zbx_vector_uint64_append(&interfaceids, ias.values[i++]->interfaceid);
+			}
+			while (i < ias.values_num && ZBX_AVAILABILITY_UPDATE_BATCH_SIZE > interfaceids.values_num &&
+					0 == interface_availability_compare_values(ia, ias.values[i]));
+
+			if (SUCCEED != zbx_sql_add_interface_availability(ia, &interfaceids, &sql, &sql_alloc,
+					&sql_offset))
 			{
 				continue;
 			}
@@ -286,5 +359,8 @@ void	zbx_db_update_interface_availabilities(const zbx_vector_availability_ptr_t
 	}
 	while (ZBX_DB_DOWN == txn_error);
 
+	zbx_vector_uint64_destroy(&interfaceids);
+	zbx_vector_availability_ptr_destroy(&ias);
 	zbx_free(sql);
+#undef ZBX_AVAILABILITY_UPDATE_BATCH_SIZE
 }
@@ -145,6 +145,21 @@ struct zbx_dc_um_handle_t
 
 static zbx_dc_um_handle_t	*dc_um_handle = NULL;
 
+/* Macros resolved through user macro handles are remembered per host for as long as the */
+/* user macro cache is locked by the process - the locked cache cannot change, so the    */
+/* same macro of the same host is resolved by walking the template chain only once.      */
+typedef struct
+{
+	zbx_uint64_t	hostid;
+	char		*macro;
+	size_t		macro_len;
+	const char	*value;
+	unsigned char	env;
+}
+zbx_dc_um_memo_t;
+
+static zbx_hashset_t	dc_um_memo;
+
 /******************************************************************************
  *                                                                            *
  * Parameters: type - [IN] item type [ITEM_TYPE_* flag]                       *
@@ -243,8 +258,11 @@ static int	cmp_key_id(const char *key_1, const char *key_2)
 	return ('\0' == *p || '[' == *p) && ('\0' == *q || '[' == *q) ? SUCCEED : FAIL;
 }
 
-static unsigned char	poller_by_item(unsigned char type, const char *key)
+static unsigned char	poller_by_item(const ZBX_DC_ITEM *dc_item)
 {
+	unsigned char	type = dc_item->type;
+	const char	*key = dc_item->key;
+
 	switch (type)
 	{
 		case ITEM_TYPE_SIMPLE:
@@ -259,11 +277,31 @@ static unsigned char	poller_by_item(unsigned char type, const char *key)
 			}
 			ZBX_FALLTHROUGH;
 		case ITEM_TYPE_ZABBIX:
+			if (ITEM_TYPE_ZABBIX == type && 0 != get_config_forks_cb(ZBX_PROCESS_TYPE_AGENT_POLLER))
+				return ZBX_POLLER_TYPE_AGENT;
+			ZBX_FALLTHROUGH;
 		case ITEM_TYPE_SNMP:
+			if (ITEM_TYPE_SNMP == type && 0 != get_config_forks_cb(ZBX_PROCESS_TYPE_SNMP_POLLER) &&
+					0 == (ZBX_FLAG_DISCOVERY_RULE & dc_item->flags))
+			{
+				const ZBX_DC_SNMPITEM	*snmpitem;
+
+				/* only plain OIDs are queried asynchronously, dynamic index, walk[] and discovery[] */
+				/* OIDs require walking the device and are left to regular pollers                  */
+				if (NULL != (snmpitem = (const ZBX_DC_SNMPITEM *)zbx_hashset_search(&config->snmpitems,
+						&dc_item->itemid)) && ZBX_SNMP_OID_TYPE_NORMAL == snmpitem->snmp_oid_type)
+				{
+					return ZBX_POLLER_TYPE_SNMP;
+				}
+			}
+			ZBX_FALLTHROUGH;
+		case ITEM_TYPE_HTTPAGENT:
+			if (ITEM_TYPE_HTTPAGENT == type && 0 != get_config_forks_cb(ZBX_PROCESS_TYPE_HTTPAGENT_POLLER))
+				return ZBX_POLLER_TYPE_HTTPAGENT;
+			ZBX_FALLTHROUGH;
 		case ITEM_TYPE_EXTERNAL:
 		case ITEM_TYPE_SSH:
 		case ITEM_TYPE_TELNET:
-		case ITEM_TYPE_HTTPAGENT:
 		case ITEM_TYPE_SCRIPT:
 		case ITEM_TYPE_INTERNAL:
 			if (0 == get_config_forks_cb(ZBX_PROCESS_TYPE_POLLER))
@@ -404,7 +442,7 @@ static char	*dc_expand_user_macros_dyn(const char *text, const zbx_uint64_t *hos
 	char		*str = NULL, *name = NULL, *context = NULL;
 	size_t		str_alloc = 0, str_offset = 0;
 
-	if ('\0' == *text)
+	if (NULL == strstr(text, "{$"))
 		return zbx_strdup(NULL, text);
 
 	for (; SUCCEED == zbx_token_find(text, pos, &token, ZBX_TOKEN_SEARCH_BASIC); pos++)
@@ -439,13 +477,229 @@ static char	*dc_expand_user_macros_dyn(const char *text, const zbx_uint64_t *hos
 	return str;
 }
 
+/* preprocessed update interval, shared by items with the same (macro expanded) delay */
+typedef struct
+{
+	char			*delay;
+	int			simple_interval;
+	zbx_custom_interval_t	*custom_intervals;
+	int			lastaccess;
+}
+zbx_dc_interval_t;
+
+#define ZBX_DC_INTERVAL_TTL	SEC_PER_HOUR
+
+/* process local cache of preprocessed update intervals */
+static zbx_hashset_t	dc_intervals;
+static int		dc_intervals_lastcleanup;
+
+static zbx_hash_t	dc_interval_hash_func(const void *data)
+{
+	const zbx_dc_interval_t	*interval = (const zbx_dc_interval_t *)data;
+
+	return ZBX_DEFAULT_STRING_HASH_FUNC(interval->delay);
+}
+
+static int	dc_interval_compare_func(const void *d1, const void *d2)
+{
+	const zbx_dc_interval_t	*i1 = (const zbx_dc_interval_t *)d1;
+	const zbx_dc_interval_t	*i2 = (const zbx_dc_interval_t *)d2;
+
+	return strcmp(i1->delay, i2->delay);
+}
+
+static void	dc_interval_clean_func(void *data)
+{
+	zbx_dc_interval_t	*interval = (zbx_dc_interval_t *)data;
+
+	zbx_free(interval->delay);
+
+	if (NULL != interval->custom_intervals)
+		zbx_custom_interval_free(interval->custom_intervals);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get preprocessed update interval                                  *
+ *                                                                            *
+ * Parameters: delay            - [IN] the update interval with expanded      *
+ *                                     macros                                 *
+ *             simple_interval  - [OUT] the simple update interval            *
+ *             custom_intervals - [OUT] the flexible and scheduling intervals,*
+ *                                      owned by the cache                    *
+ *             error            - [OUT] the error message                     *
+ *                                                                            *
+ * Return value: SUCCEED - the update interval is valid                       *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Update intervals are parsed once per process and reused on every *
+ *           item requeue. Intervals not used for an hour are dropped.        *
+ *                                                                            *
+ ******************************************************************************/
+static int	dc_interval_preproc(const char *delay, int *simple_interval,
+		const zbx_custom_interval_t **custom_intervals, char **error)
+{
+	zbx_dc_interval_t	*interval, interval_local;
+	int			now;
+
+	now = (int)time(NULL);
+
+	if (0 == dc_intervals.num_slots)
+	{
+		zbx_hashset_create_ext(&dc_intervals, 100, dc_interval_hash_func, dc_interval_compare_func,
+				dc_interval_clean_func, ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC,
+				ZBX_DEFAULT_MEM_FREE_FUNC);
+		dc_intervals_lastcleanup = now;
+	}
+	else if (now - dc_intervals_lastcleanup >= ZBX_DC_INTERVAL_TTL)
+	{
+		zbx_hashset_iter_t	iter;
+
+		zbx_hashset_iter_reset(&dc_intervals, &iter);
+		while (NULL != (interval = (zbx_dc_interval_t *)zbx_hashset_iter_next(&iter)))
+		{
+			if (interval->lastaccess + ZBX_DC_INTERVAL_TTL <= now)
+				zbx_hashset_iter_remove(&iter);
+		}
+
+		dc_intervals_lastcleanup = now;
+	}
+
+	interval_local.delay = (char *)delay;
+
+	if (NULL == (interval = (zbx_dc_interval_t *)zbx_hashset_search(&dc_intervals, &interval_local)))
+	{
+		if (SUCCEED != zbx_interval_preproc(delay, &interval_local.simple_interval,
+				&interval_local.custom_intervals, error))
+		{
+			return FAIL;
+		}
+
+		interval_local.delay = zbx_strdup(NULL, delay);
+		interval = (zbx_dc_interval_t *)zbx_hashset_insert(&dc_intervals, &interval_local,
+				sizeof(interval_local));
+	}
+
+	interval->lastaccess = now;
+	*simple_interval = interval->simple_interval;
+	*custom_intervals = interval->custom_intervals;
+
+	return SUCCEED;
+}
+
+#undef ZBX_DC_INTERVAL_TTL
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: updates item check load histogram with item schedule              *
+ *                                                                            *
+ * Parameters: load  - [IN/OUT] the check load histogram                      *
+ *             delay - [IN] the item update interval                          *
+ *             phase - [IN] the item check offset within update interval      *
+ *             num   - [IN] the number to add to occupied seconds             *
+ *                                                                            *
+ * Comments: Histogram seconds are aligned to epoch like item nextchecks, so  *
+ *           intervals that divide schedule period are reflected exactly.     *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_schedule_load_update(int *load, int delay, int phase, int num)
+{
+	int	slot;
+
+	for (slot = phase % ZBX_DC_SCHEDULE_PERIOD; slot < ZBX_DC_SCHEDULE_PERIOD; slot += delay)
+		load[slot] += num;
+}
+
+static int	dc_schedule_load_get(const int *load, int delay, int phase)
+{
+	int	slot, load_sum = 0;
+
+	for (slot = phase % ZBX_DC_SCHEDULE_PERIOD; slot < ZBX_DC_SCHEDULE_PERIOD; slot += delay)
+		load_sum += load[slot];
+
+	return load_sum;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: removes item schedule from check load histogram                   *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_item_schedule_release(ZBX_DC_ITEM *item)
+{
+	if (0 == item->schedule_delay)
+		return;
+
+	dc_schedule_load_update(config->schedule_load[item->schedule_poller_type], item->schedule_delay,
+			item->schedule_phase, -1);
+	item->schedule_delay = 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets seed for item nextcheck calculation, placing items into the  *
+ *          least loaded seconds of their update interval                     *
+ *                                                                            *
+ * Parameters: item  - [IN/OUT] the item                                      *
+ *             seed  - [IN] the item seed based on item properties            *
+ *             delay - [IN] the item update interval                          *
+ *                                                                            *
+ * Return value: the seed for nextcheck calculations                          *
+ *                                                                            *
+ * Comments: Only items scheduled by itemid are placed, items grouped by      *
+ *           interface or other properties keep their common seed. The phase  *
+ *           is chosen once per update interval from several candidates       *
+ *           evenly spread over the interval, starting with the hashed one.   *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint64_t	dc_item_schedule_seed(ZBX_DC_ITEM *item, zbx_uint64_t seed, int delay)
+{
+#define ZBX_DC_SCHEDULE_CANDIDATES	8
+	int		i, candidates, phase, load, phase_min, load_min;
+	unsigned char	poller_type;
+	const int	*poller_load;
+
+	if (0 != item->schedule_delay && delay == item->schedule_delay)
+		return (zbx_uint64_t)item->schedule_phase;
+
+	dc_item_schedule_release(item);
+
+	if (0 >= delay || seed != item->itemid || ZBX_POLLER_TYPE_COUNT <= (poller_type = poller_by_item(item)))
+		return seed;
+
+	poller_load = config->schedule_load[poller_type];
+	candidates = MIN(delay, ZBX_DC_SCHEDULE_CANDIDATES);
+	phase_min = (int)(seed % (zbx_uint64_t)delay);
+	load_min = dc_schedule_load_get(poller_load, delay, phase_min);
+
+	for (i = 1; i < candidates && 0 != load_min; i++)
+	{
+		phase = (int)((seed + (zbx_uint64_t)(i * (delay / candidates))) % (zbx_uint64_t)delay);
+
+		if ((load = dc_schedule_load_get(poller_load, delay, phase)) < load_min)
+		{
+			load_min = load;
+			phase_min = phase;
+		}
+	}
+
+	dc_schedule_load_update(config->schedule_load[poller_type], delay, phase_min, 1);
+
+	item->schedule_delay = delay;
+	item->schedule_phase = phase_min;
+	item->schedule_poller_type = poller_type;
+
+	return (zbx_uint64_t)phase_min;
+#undef ZBX_DC_SCHEDULE_CANDIDATES
+}
+
 int	DCitem_nextcheck_update(ZBX_DC_ITEM *item, const ZBX_DC_INTERFACE *interface, int flags, int now,
 		char **error)
 {
-	zbx_uint64_t		seed;
-	int			simple_interval, disable_until, ret;
-	zbx_custom_interval_t	*custom_intervals;
-	char			*delay_s;
+	zbx_uint64_t			seed;
+	int				simple_interval, disable_until, ret;
+	const zbx_custom_interval_t	*custom_intervals;
+	char				*delay_s;
 
 	if (0 == (flags & ZBX_ITEM_COLLECTED) && 0 != item->nextcheck &&
 			0 == (flags & ZBX_ITEM_KEY_CHANGED) && 0 == (flags & ZBX_ITEM_TYPE_CHANGED) &&
@@ -457,7 +711,7 @@ int	DCitem_nextcheck_update(ZBX_DC_ITEM *item, const ZBX_DC_INTERFACE *interface
 	seed = get_item_nextcheck_seed(item->itemid, item->interfaceid, item->type, item->key);
 
 	delay_s = dc_expand_user_macros_dyn(item->delay, &item->hostid, 1, ZBX_MACRO_ENV_NONSECURE);
-	ret = zbx_interval_preproc(delay_s, &simple_interval, &custom_intervals, error);
+	ret = dc_interval_preproc(delay_s, &simple_interval, &custom_intervals, error);
 	zbx_free(delay_s);
 
 	if (SUCCEED != ret)
@@ -468,9 +722,18 @@ int	DCitem_nextcheck_update(ZBX_DC_ITEM *item, const ZBX_DC_INTERFACE *interface
 		/* detects item configuration changes affecting check scheduling and passes them in flags. */
 
 		item->nextcheck = ZBX_JAN_2038;
+		dc_item_schedule_release(item);
 		return FAIL;
 	}
 
+	if (0 != (flags & ZBX_ITEM_TYPE_CHANGED))
+		dc_item_schedule_release(item);
+
+	if (NULL == custom_intervals && ITEM_TYPE_ZABBIX_ACTIVE != item->type)
+		seed = dc_item_schedule_seed(item, seed, simple_interval);
+	else
+		dc_item_schedule_release(item);
+
 	if (0 != (flags & ZBX_HOST_UNREACHABLE) && NULL != interface && 0 != (disable_until =
 			DCget_disable_until(item, interface)))
 	{
@@ -496,8 +759,6 @@ int	DCitem_nextcheck_update(ZBX_DC_ITEM *item, const ZBX_DC_INTERFACE *interface
 		}
 	}
 
-	zbx_custom_interval_free(custom_intervals);
-
 	return SUCCEED;
 }
 
@@ -511,12 +772,15 @@ static void	DCitem_poller_type_update(ZBX_DC_ITEM *dc_item, const ZBX_DC_HOST *d
 		return;
 	}
 
-	poller_type = poller_by_item(dc_item->type, dc_item->key);
+	poller_type = poller_by_item(dc_item);
 
 	if (0 != (flags & ZBX_HOST_UNREACHABLE))
 	{
-		if (ZBX_POLLER_TYPE_NORMAL == poller_type || ZBX_POLLER_TYPE_JAVA == poller_type)
+		if (ZBX_POLLER_TYPE_NORMAL == poller_type || ZBX_POLLER_TYPE_JAVA == poller_type ||
+				ZBX_POLLER_TYPE_AGENT == poller_type || ZBX_POLLER_TYPE_SNMP == poller_type)
+		{
 			poller_type = ZBX_POLLER_TYPE_UNREACHABLE;
+		}
 
 		dc_item->poller_type = poller_type;
 		return;
@@ -528,8 +792,9 @@ static void	DCitem_poller_type_update(ZBX_DC_ITEM *dc_item, const ZBX_DC_HOST *d
 		return;
 	}
 
-	if (ZBX_POLLER_TYPE_UNREACHABLE != dc_item->poller_type ||
-			(ZBX_POLLER_TYPE_NORMAL != poller_type && ZBX_POLLER_TYPE_JAVA != poller_type))
+	if (ZBX_POLLER_TYPE_UNREACHABLE != dc_item->poller_type || (ZBX_POLLER_TYPE_NORMAL != poller_type &&
+			ZBX_POLLER_TYPE_JAVA != poller_type && ZBX_POLLER_TYPE_AGENT != poller_type &&
+			ZBX_POLLER_TYPE_SNMP != poller_type))
 	{
 		dc_item->poller_type = poller_type;
 	}
@@ -576,6 +841,27 @@ void	*DCfind_id(zbx_hashset_t *hashset, zbx_uint64_t id, size_t size, int *found
 	return ptr;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reserve hashset slots for rows of initial sync                    *
+ *                                                                            *
+ * Parameters: hashset - [IN] hashset to be filled from changeset             *
+ *             sync    - [IN] changeset                                       *
+ *                                                                            *
+ * Comments: Sizing large hashsets once avoids rehashing them over and over   *
+ *           while millions of objects are loaded at startup.                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_hashset_reserve_sync(zbx_hashset_t *hashset, const zbx_dbsync_t *sync)
+{
+	int	rows_num;
+
+	if (ZBX_DBSYNC_INIT != sync->mode || 0 >= (rows_num = zbx_dbsync_get_row_num(sync)))
+		return;
+
+	(void)zbx_hashset_reserve(hashset, hashset->num_data + rows_num);
+}
+
 ZBX_DC_ITEM	*DCfind_item(zbx_uint64_t hostid, const char *key)
 {
 	ZBX_DC_ITEM_HK	*item_hk, item_hk_local;
@@ -1253,6 +1539,8 @@ static void	DCsync_hosts(zbx_dbsync_t *sync, zbx_uint64_t revision, zbx_vector_u
 #endif
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
+	dc_hashset_reserve_sync(&config->hosts, sync);
+
 #if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
 	zbx_hashset_create(&psk_owners, 0, ZBX_DEFAULT_PTR_HASH_FUNC, ZBX_DEFAULT_PTR_COMPARE_FUNC);
 #endif
@@ -1900,106 +2188,224 @@ static void	DCsync_host_inventory(zbx_dbsync_t *sync, zbx_uint64_t revision)
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
-void	zbx_dc_sync_kvs_paths(const struct zbx_json_parse *jp_kvs_paths, const zbx_config_vault_t *config_vault)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: updates macro secrets of a path in configuration cache            *
+ *                                                                            *
+ * Parameters: dc_kvs_path - [IN] the cached path                             *
+ *             kvs         - [IN] the secrets retrieved for the path          *
+ *             diff        - [IN/OUT] the work vector                         *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_kvs_path_update(zbx_dc_kvs_path_t *dc_kvs_path, zbx_kvs_t *kvs, zbx_vector_ptr_pair_t *diff)
 {
-	zbx_dc_kvs_path_t	*dc_kvs_path;
 	zbx_dc_kv_t		*dc_kv;
-	zbx_kvs_t		kvs;
 	zbx_hashset_iter_t	iter;
-	int			i, j;
-	zbx_vector_ptr_pair_t	diff;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+	zbx_hashset_iter_reset(&dc_kvs_path->kvs, &iter);
+	while (NULL != (dc_kv = (zbx_dc_kv_t *)zbx_hashset_iter_next(&iter)))
+	{
+		zbx_kv_t	*kv, kv_local;
+		zbx_ptr_pair_t	pair;
 
-	zbx_vector_ptr_pair_create(&diff);
-	zbx_kvs_create(&kvs, 100);
+		kv_local.key = (char *)dc_kv->key;
+		if (NULL != (kv = zbx_kvs_search(kvs, &kv_local)))
+		{
+			if (0 == zbx_strcmp_null(dc_kv->value, kv->value) && 0 == dc_kv->update)
+				continue;
+		}
+		else if (NULL == dc_kv->value)
+			continue;
 
-	for (i = 0; i < config->kvs_paths.values_num; i++)
+		pair.first = dc_kv;
+		pair.second = kv;
+		zbx_vector_ptr_pair_append(diff, pair);
+	}
+
+	if (0 != diff->values_num)
 	{
-		char	*error = NULL;
+		START_SYNC;
 
-		dc_kvs_path = (zbx_dc_kvs_path_t *)config->kvs_paths.values[i];
+		config->revision.config++;
 
-		if (NULL != jp_kvs_paths)
+		for (int j = 0; j < diff->values_num; j++)
 		{
-			if (FAIL == zbx_kvs_from_json_by_path_get(dc_kvs_path->path, jp_kvs_paths, &kvs, &error))
+			zbx_kv_t	*kv;
+
+			dc_kv = (zbx_dc_kv_t *)diff->values[j].first;
+			kv = (zbx_kv_t *)diff->values[j].second;
+
+			if (NULL != kv)
 			{
-				zabbix_log(LOG_LEVEL_WARNING, "cannot get secrets for path \"%s\": %s",
-						dc_kvs_path->path, error);
-				zbx_free(error);
-				continue;
+				dc_strpool_replace(dc_kv->value != NULL ? 1 : 0, &dc_kv->value, kv->value);
+			}
+			else
+			{
+				dc_strpool_release(dc_kv->value);
+				dc_kv->value = NULL;
 			}
 
+			config->um_cache = um_cache_set_value_to_macros(config->um_cache,
+					config->revision.config, &dc_kv->macros, dc_kv->value);
+
+			dc_kv->update = 0;
 		}
-		else if (FAIL == zbx_vault_kvs_get(dc_kvs_path->path, &kvs, config_vault, &error))
-		{
-			zabbix_log(LOG_LEVEL_WARNING, "cannot get secrets for path \"%s\": %s", dc_kvs_path->path,
-					error);
-			zbx_free(error);
+
+		FINISH_SYNC;
+	}
+
+	zbx_vector_ptr_pair_clear(diff);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if secrets of the path must be retrieved from vault        *
+ *                                                                            *
+ * Comments: Secrets are retrieved when they expire or when new macro refers  *
+ *           to a key of the path.                                            *
+ *                                                                            *
+ ******************************************************************************/
+static int	dc_kvs_path_refresh_required(const zbx_dc_kvs_path_t *dc_kvs_path, int now)
+{
+	zbx_hashset_iter_t	iter;
+	const zbx_dc_kv_t	*dc_kv;
+
+	if (dc_kvs_path->next_refresh <= now)
+		return SUCCEED;
+
+	zbx_hashset_iter_reset((zbx_hashset_t *)&dc_kvs_path->kvs, &iter);
+	while (NULL != (dc_kv = (const zbx_dc_kv_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (0 != dc_kv->update)
+			return SUCCEED;
+	}
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: retrieves expired macro secrets from vault                        *
+ *                                                                            *
+ * Comments: Secrets are kept in cache and retrieved again only after they    *
+ *           expire. Expired paths are retrieved with parallel requests. When *
+ *           a path cannot be retrieved the cached secrets are kept and the   *
+ *           retrieval is retried after a shorter delay.                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_sync_kvs_paths_vault(const zbx_config_vault_t *config_vault, zbx_vector_ptr_pair_t *diff)
+{
+#define ZBX_VAULT_RETRY_DELAY	SEC_PER_MIN
+	zbx_vault_kvs_request_t	*requests;
+	zbx_dc_kvs_path_t	**paths;
+	int			requests_num = 0, now;
+
+	if (0 == config->kvs_paths.values_num)
+		return;
+
+	now = (int)time(NULL);
+
+	requests = (zbx_vault_kvs_request_t *)zbx_malloc(NULL, sizeof(zbx_vault_kvs_request_t) *
+			(size_t)config->kvs_paths.values_num);
+	paths = (zbx_dc_kvs_path_t **)zbx_malloc(NULL, sizeof(zbx_dc_kvs_path_t *) *
+			(size_t)config->kvs_paths.values_num);
+
+	for (int i = 0; i < config->kvs_paths.values_num; i++)
+	{
+		zbx_dc_kvs_path_t	*dc_kvs_path = (zbx_dc_kvs_path_t *)config->kvs_paths.values[i];
+
+		if (SUCCEED != dc_kvs_path_refresh_required(dc_kvs_path, now))
 			continue;
-		}
 
-		zbx_hashset_iter_reset(&dc_kvs_path->kvs, &iter);
-		while (NULL != (dc_kv = (zbx_dc_kv_t *)zbx_hashset_iter_next(&iter)))
-		{
-			zbx_kv_t	*kv, kv_local;
-			zbx_ptr_pair_t	pair;
+		paths[requests_num] = dc_kvs_path;
+		requests[requests_num].path = dc_kvs_path->path;
+		zbx_kvs_create(&requests[requests_num].kvs, 10);
+		requests_num++;
+	}
 
-			kv_local.key = (char *)dc_kv->key;
-			if (NULL != (kv = zbx_kvs_search(&kvs, &kv_local)))
-			{
-				if (0 == zbx_strcmp_null(dc_kv->value, kv->value) && 0 == dc_kv->update)
-					continue;
-			}
-			else if (NULL == dc_kv->value)
-				continue;
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() paths:%d expired:%d", __func__, config->kvs_paths.values_num,
+			requests_num);
 
-			pair.first = dc_kv;
-			pair.second = kv;
-			zbx_vector_ptr_pair_append(&diff, pair);
-		}
+	if (0 != requests_num)
+		zbx_vault_kvs_get_multi(requests, requests_num, config_vault);
 
-		if (0 != diff.values_num)
+	for (int i = 0; i < requests_num; i++)
+	{
+		if (SUCCEED == requests[i].ret)
 		{
-			START_SYNC;
+			dc_kvs_path_update(paths[i], &requests[i].kvs, diff);
+			paths[i]->next_refresh = now + config_vault->secrets_ttl;
+		}
+		else
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot get secrets for path \"%s\": %s", paths[i]->path,
+					requests[i].error);
+			paths[i]->next_refresh = now + MIN(config_vault->secrets_ttl, ZBX_VAULT_RETRY_DELAY);
+			zbx_free(requests[i].error);
+		}
 
-			config->revision.config++;
+		zbx_kvs_destroy(&requests[i].kvs);
+	}
 
-			for (j = 0; j < diff.values_num; j++)
-			{
-				zbx_kv_t	*kv;
+	zbx_free(paths);
+	zbx_free(requests);
+#undef ZBX_VAULT_RETRY_DELAY
+}
 
-				dc_kv = (zbx_dc_kv_t *)diff.values[j].first;
-				kv = (zbx_kv_t *)diff.values[j].second;
+void	zbx_dc_sync_kvs_paths(const struct zbx_json_parse *jp_kvs_paths, const zbx_config_vault_t *config_vault)
+{
+	zbx_kvs_t		kvs;
+	zbx_vector_ptr_pair_t	diff;
 
-				if (NULL != kv)
-				{
-					dc_strpool_replace(dc_kv->value != NULL ? 1 : 0, &dc_kv->value, kv->value);
-				}
-				else
-				{
-					dc_strpool_release(dc_kv->value);
-					dc_kv->value = NULL;
-				}
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-				config->um_cache = um_cache_set_value_to_macros(config->um_cache,
-						config->revision.config, &dc_kv->macros, dc_kv->value);
+	zbx_vector_ptr_pair_create(&diff);
 
-				dc_kv->update = 0;
-			}
+	if (NULL == jp_kvs_paths)
+	{
+		dc_sync_kvs_paths_vault(config_vault, &diff);
+		goto out;
+	}
+
+	zbx_kvs_create(&kvs, 100);
 
-			FINISH_SYNC;
+	for (int i = 0; i < config->kvs_paths.values_num; i++)
+	{
+		zbx_dc_kvs_path_t	*dc_kvs_path;
+		char			*error = NULL;
+
+		dc_kvs_path = (zbx_dc_kvs_path_t *)config->kvs_paths.values[i];
+
+		if (FAIL == zbx_kvs_from_json_by_path_get(dc_kvs_path->path, jp_kvs_paths, &kvs, &error))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot get secrets for path \"%s\": %s", dc_kvs_path->path,
+					error);
+			zbx_free(error);
+			continue;
 		}
 
-		zbx_vector_ptr_pair_clear(&diff);
+		dc_kvs_path_update(dc_kvs_path, &kvs, &diff);
 		zbx_kvs_clear(&kvs);
 	}
 
-	zbx_vector_ptr_pair_destroy(&diff);
 	zbx_kvs_destroy(&kvs);
+out:
+	zbx_vector_ptr_pair_destroy(&diff);
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: forces macro secrets to be retrieved from vault during the next   *
+ *          secret synchronization                                            *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dc_expire_kvs_paths(void)
+{
+	for (int i = 0; i < config->kvs_paths.values_num; i++)
+		((zbx_dc_kvs_path_t *)config->kvs_paths.values[i])->next_refresh = 0;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: trying to resolve the macros in host interface                    *
@@ -2244,7 +2650,9 @@ static void	DCsync_interfaces(zbx_dbsync_t *sync, zbx_uint64_t revision)
 		reset_snmp_stats |= (SUCCEED == dc_strpool_replace(found, &interface->ip, row[5]));
 		reset_snmp_stats |= (SUCCEED == dc_strpool_replace(found, &interface->dns, row[6]));
 		reset_snmp_stats |= (SUCCEED == dc_strpool_replace(found, &interface->port, row[7]));
-		reset_snmp_stats |= (SUCCEED == dc_strpool_replace(found, &interface->error, row[10]));
+
+		/* request size limits learned from the device stay valid when only its availability changes */
+		dc_strpool_replace(found, &interface->error, row[10]);
 
 		if (0 == found)
 		{
@@ -2452,9 +2860,11 @@ static void	dc_masteritem_free(ZBX_DC_MASTERITEM *masteritem)
  *                                                                            *
  * Parameters: master_itemid - [IN] the master item identifier                *
  *             dep_itemid    - [IN] the dependent item identifier             *
+ *             revision      - [IN] the configuration revision                *
  *                                                                            *
  ******************************************************************************/
-static void	dc_masteritem_remove_depitem(zbx_uint64_t master_itemid, zbx_uint64_t dep_itemid)
+static void	dc_masteritem_remove_depitem(zbx_uint64_t master_itemid, zbx_uint64_t dep_itemid,
+		zbx_uint64_t revision)
 {
 	ZBX_DC_MASTERITEM	*masteritem;
 	ZBX_DC_ITEM		*item;
@@ -2464,7 +2874,7 @@ static void	dc_masteritem_remove_depitem(zbx_uint64_t master_itemid, zbx_uint64_
 	if (NULL == (item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &master_itemid)))
 		return;
 
-	if (NULL == (masteritem = item->master_item))
+	if (NULL == (masteritem = item->cold->master_item))
 		return;
 
 	pair.first = dep_itemid;
@@ -2475,11 +2885,12 @@ static void	dc_masteritem_remove_depitem(zbx_uint64_t master_itemid, zbx_uint64_
 	}
 
 	zbx_vector_uint64_pair_remove_noorder(&masteritem->dep_itemids, index);
+	dc_item_update_revision(item, revision);
 
 	if (0 == masteritem->dep_itemids.values_num)
 	{
-		dc_masteritem_free(item->master_item);
-		item->master_item = NULL;
+		dc_masteritem_free(item->cold->master_item);
+		item->cold->master_item = NULL;
 	}
 }
 
@@ -2578,6 +2989,9 @@ static void	DCsync_items(zbx_dbsync_t *sync, zbx_uint64_t revision, int flags, z
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
+	dc_hashset_reserve_sync(&config->items, sync);
+	dc_hashset_reserve_sync(&config->items_hk, sync);
+
 	now = time(NULL);
 
 	while (SUCCEED == (ret = zbx_dbsync_next(sync, &rowid, &row, &tag)))
@@ -2596,8 +3010,11 @@ static void	DCsync_items(zbx_dbsync_t *sync, zbx_uint64_t revision, int flags, z
 
 		item = (ZBX_DC_ITEM *)DCfind_id(&config->items, itemid, sizeof(ZBX_DC_ITEM), &found);
 
+		if (0 == found)
+			item->cold = (ZBX_DC_ITEM_COLD *)__config_shmem_malloc_func(NULL, sizeof(ZBX_DC_ITEM_COLD));
+
 		/* template item */
-		ZBX_DBROW2UINT64(item->templateid, row[48]);
+		ZBX_DBROW2UINT64(item->cold->templateid, row[48]);
 
 		if (0 != found && ITEM_TYPE_SNMPTRAP == item->type)
 			dc_interface_snmpitems_remove(item);
@@ -2643,10 +3060,11 @@ static void	DCsync_items(zbx_dbsync_t *sync, zbx_uint64_t revision, int flags, z
 		item->flags = (unsigned char)atoi(row[18]);
 		ZBX_DBROW2UINT64(interfaceid, row[19]);
 
-		dc_strpool_replace(found, &item->history_period, row[22]);
+		dc_strpool_replace(found, &item->cold->history_period, row[22]);
+		dc_strpool_replace(found, &item->cold->name, row[51]);
 
-		ZBX_STR2UCHAR(item->inventory_link, row[24]);
-		ZBX_DBROW2UINT64(item->valuemapid, row[25]);
+		ZBX_STR2UCHAR(item->cold->inventory_link, row[24]);
+		ZBX_DBROW2UINT64(item->cold->valuemapid, row[25]);
 
 		if (0 != (ZBX_FLAG_DISCOVERY_RULE & item->flags))
 			value_type = ITEM_VALUE_TYPE_TEXT;
@@ -2661,10 +3079,11 @@ static void	DCsync_items(zbx_dbsync_t *sync, zbx_uint64_t revision, int flags, z
 			item->triggers = NULL;
 			item->update_triggers = 0;
 			item->nextcheck = 0;
+			item->schedule_delay = 0;
 			item->state = (unsigned char)atoi(row[12]);
-			ZBX_STR2UINT64(item->lastlogsize, row[20]);
-			item->mtime = atoi(row[21]);
-			dc_strpool_replace(found, &item->error, row[27]);
+			ZBX_STR2UINT64(item->cold->lastlogsize, row[20]);
+			item->cold->mtime = atoi(row[21]);
+			dc_strpool_replace(found, &item->cold->error, row[27]);
 			item->data_expected_from = now;
 			item->location = ZBX_LOC_NOWHERE;
 			item->poller_type = ZBX_NO_POLLER;
@@ -2674,13 +3093,13 @@ static void	DCsync_items(zbx_dbsync_t *sync, zbx_uint64_t revision, int flags, z
 			if (ZBX_SYNCED_NEW_CONFIG_YES == synced && 0 == host->proxy_hostid)
 				flags |= ZBX_ITEM_NEW;
 
-			zbx_vector_ptr_create_ext(&item->tags, __config_shmem_malloc_func, __config_shmem_realloc_func,
+			zbx_vector_ptr_create_ext(&item->cold->tags, __config_shmem_malloc_func, __config_shmem_realloc_func,
 					__config_shmem_free_func);
 
 			zbx_vector_dc_item_ptr_append(&host->items, item);
 
-			item->preproc_item = NULL;
-			item->master_item = NULL;
+			item->cold->preproc_item = NULL;
+			item->cold->master_item = NULL;
 		}
 		else
 		{
@@ -2747,6 +3166,8 @@ static void	DCsync_items(zbx_dbsync_t *sync, zbx_uint64_t revision, int flags, z
 
 			dc_strpool_replace(found, &numitem->trends_period, row[23]);
 			dc_strpool_replace(found, &numitem->units, row[26]);
+			ZBX_STR2UCHAR(numitem->history_downsample, row[49]);
+			dc_strpool_replace(found, &numitem->history_downsample_param, row[50]);
 		}
 		else if (NULL != (numitem = (ZBX_DC_NUMITEM *)zbx_hashset_search(&config->numitems, &itemid)))
 		{
@@ -2754,6 +3175,7 @@ static void	DCsync_items(zbx_dbsync_t *sync, zbx_uint64_t revision, int flags, z
 
 			dc_strpool_release(numitem->units);
 			dc_strpool_release(numitem->trends_period);
+			dc_strpool_release(numitem->history_downsample_param);
 
 			zbx_hashset_remove_direct(&config->numitems, numitem);
 		}
@@ -2835,7 +3257,7 @@ static void	DCsync_items(zbx_dbsync_t *sync, zbx_uint64_t revision, int flags, z
 		else if (NULL != (depitem = (ZBX_DC_DEPENDENTITEM *)zbx_hashset_search(&config->dependentitems,
 				&itemid)))
 		{
-			dc_masteritem_remove_depitem(depitem->master_itemid, itemid);
+			dc_masteritem_remove_depitem(depitem->master_itemid, itemid, revision);
 			zbx_hashset_remove_direct(&config->dependentitems, depitem);
 		}
 
@@ -2996,7 +3418,7 @@ static void	DCsync_items(zbx_dbsync_t *sync, zbx_uint64_t revision, int flags, z
 			if (1 == found && NULL != calcitem->formula_bin)
 				__config_shmem_free_func((void *)calcitem->formula_bin);
 
-			calcitem->formula_bin = config_decode_serialized_expression(row[49]);
+			calcitem->formula_bin = config_decode_serialized_expression(row[52]);
 		}
 		else if (NULL != (calcitem = (ZBX_DC_CALCITEM *)zbx_hashset_search(&config->calcitems, &itemid)))
 		{
@@ -3121,6 +3543,7 @@ static void	DCsync_items(zbx_dbsync_t *sync, zbx_uint64_t revision, int flags, z
 			item->nextcheck = 0;
 			item->queue_priority = ZBX_QUEUE_PRIORITY_NORMAL;
 			item->poller_type = ZBX_NO_POLLER;
+			dc_item_schedule_release(item);
 		}
 
 		DCupdate_item_queue(item, old_poller_type, old_nextcheck);
@@ -3133,7 +3556,7 @@ static void	DCsync_items(zbx_dbsync_t *sync, zbx_uint64_t revision, int flags, z
 		zbx_uint64_pair_t	pair;
 
 		depitem = (ZBX_DC_DEPENDENTITEM *)dep_items.values[i];
-		dc_masteritem_remove_depitem(depitem->last_master_itemid, depitem->itemid);
+		dc_masteritem_remove_depitem(depitem->last_master_itemid, depitem->itemid, revision);
 
 		if (NULL == (item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &depitem->master_itemid)))
 			continue;
@@ -3141,16 +3564,17 @@ static void	DCsync_items(zbx_dbsync_t *sync, zbx_uint64_t revision, int flags, z
 		pair.first = depitem->itemid;
 		pair.second = depitem->flags;
 
-		if (NULL == item->master_item)
+		if (NULL == item->cold->master_item)
 		{
-			item->master_item = (ZBX_DC_MASTERITEM *)__config_shmem_malloc_func(NULL,
+			item->cold->master_item = (ZBX_DC_MASTERITEM *)__config_shmem_malloc_func(NULL,
 					sizeof(ZBX_DC_MASTERITEM));
 
-			zbx_vector_uint64_pair_create_ext(&item->master_item->dep_itemids, __config_shmem_malloc_func,
+			zbx_vector_uint64_pair_create_ext(&item->cold->master_item->dep_itemids, __config_shmem_malloc_func,
 					__config_shmem_realloc_func, __config_shmem_free_func);
 		}
 
-		zbx_vector_uint64_pair_append(&item->master_item->dep_itemids, pair);
+		zbx_vector_uint64_pair_append(&item->cold->master_item->dep_itemids, pair);
+		dc_item_update_revision(item, revision);
 	}
 
 	zbx_vector_ptr_destroy(&dep_items);
@@ -3197,6 +3621,7 @@ static void	DCsync_items(zbx_dbsync_t *sync, zbx_uint64_t revision, int flags, z
 
 			dc_strpool_release(numitem->units);
 			dc_strpool_release(numitem->trends_period);
+			dc_strpool_release(numitem->history_downsample_param);
 
 			zbx_hashset_remove_direct(&config->numitems, numitem);
 		}
@@ -3232,7 +3657,7 @@ static void	DCsync_items(zbx_dbsync_t *sync, zbx_uint64_t revision, int flags, z
 
 		if (NULL != (depitem = (ZBX_DC_DEPENDENTITEM *)zbx_hashset_search(&config->dependentitems, &itemid)))
 		{
-			dc_masteritem_remove_depitem(depitem->master_itemid, itemid);
+			dc_masteritem_remove_depitem(depitem->master_itemid, itemid, revision);
 			zbx_hashset_remove_direct(&config->dependentitems, depitem);
 		}
 
@@ -3379,10 +3804,13 @@ static void	DCsync_items(zbx_dbsync_t *sync, zbx_uint64_t revision, int flags, z
 		if (ZBX_LOC_QUEUE == item->location)
 			zbx_binary_heap_remove_direct(&config->queues[item->poller_type], item->itemid);
 
+		dc_item_schedule_release(item);
+
 		dc_strpool_release(item->key);
-		dc_strpool_release(item->error);
+		dc_strpool_release(item->cold->error);
 		dc_strpool_release(item->delay);
-		dc_strpool_release(item->history_period);
+		dc_strpool_release(item->cold->history_period);
+		dc_strpool_release(item->cold->name);
 
 		if (NULL != item->delay_ex)
 			dc_strpool_release(item->delay_ex);
@@ -3390,14 +3818,15 @@ static void	DCsync_items(zbx_dbsync_t *sync, zbx_uint64_t revision, int flags, z
 		if (NULL != item->triggers)
 			config->items.mem_free_func(item->triggers);
 
-		zbx_vector_ptr_destroy(&item->tags);
+		zbx_vector_ptr_destroy(&item->cold->tags);
 
-		if (NULL != item->preproc_item)
-			dc_preprocitem_free(item->preproc_item);
+		if (NULL != item->cold->preproc_item)
+			dc_preprocitem_free(item->cold->preproc_item);
 
-		if (NULL != item->master_item)
-			dc_masteritem_free(item->master_item);
+		if (NULL != item->cold->master_item)
+			dc_masteritem_free(item->cold->master_item);
 
+		__config_shmem_free_func(item->cold);
 		zbx_hashset_remove_direct(&config->items, item);
 	}
 
@@ -3414,6 +3843,8 @@ static void	DCsync_item_discovery(zbx_dbsync_t *sync)
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
+	dc_hashset_reserve_sync(&config->item_discovery, sync);
+
 	while (SUCCEED == (ret = zbx_dbsync_next(sync, &rowid, &row, &tag)))
 	{
 		/* removed rows will be always added at the end */
@@ -3527,6 +3958,8 @@ static void	DCsync_triggers(zbx_dbsync_t *sync, zbx_uint64_t revision)
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
+	dc_hashset_reserve_sync(&config->triggers, sync);
+
 	while (SUCCEED == (ret = zbx_dbsync_next(sync, &rowid, &row, &tag)))
 	{
 		/* removed rows will be always added at the end */
@@ -3910,7 +4343,27 @@ static time_t	dc_function_calculate_nextcheck(const zbx_dc_um_handle_t *um_handl
 
 	THIS_SHOULD_NEVER_HAPPEN;
 
-	return 0;
+	return 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get seed used to spread out trigger timer schedule                *
+ *                                                                            *
+ * Comments: Timers are seeded by the first trigger item, so triggers of the  *
+ *           same item are checked at the same time with the same evaluation  *
+ *           timestamp. This allows to evaluate their common functions once   *
+ *           and fetch item values from value cache in one request, while     *
+ *           timers of different items are still spread over the period.      *
+ *           All timers of a trigger share the seed to be evaluated together. *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint64_t	dc_trigger_timer_seed(const ZBX_DC_TRIGGER *trigger)
+{
+	if (NULL != trigger->itemids && 0 != trigger->itemids[0])
+		return trigger->itemids[0];
+
+	return trigger->triggerid;
 }
 
 /******************************************************************************
@@ -3920,7 +4373,8 @@ static time_t	dc_function_calculate_nextcheck(const zbx_dc_um_handle_t *um_handl
  * Return value:  Created timer or NULL in the case of error.                 *
  *                                                                            *
  ******************************************************************************/
-static zbx_trigger_timer_t	*dc_trigger_function_timer_create(ZBX_DC_FUNCTION *function, int now)
+static zbx_trigger_timer_t	*dc_trigger_function_timer_create(ZBX_DC_FUNCTION *function,
+		const ZBX_DC_TRIGGER *trigger, int now)
 {
 	zbx_trigger_timer_t	*timer;
 	zbx_uint32_t		type;
@@ -3943,6 +4397,7 @@ static zbx_trigger_timer_t	*dc_trigger_function_timer_create(ZBX_DC_FUNCTION *fu
 	timer->objectid = function->functionid;
 	timer->triggerid = function->triggerid;
 	timer->revision = function->revision;
+	timer->seed = dc_trigger_timer_seed(trigger);
 	timer->lock = 0;
 	timer->type = type;
 	timer->lastcheck = (time_t)now;
@@ -3981,6 +4436,7 @@ static zbx_trigger_timer_t	*dc_trigger_timer_create(ZBX_DC_TRIGGER *trigger)
 	timer->revision = trigger->revision;
 	timer->lock = 0;
 	timer->parameter = NULL;
+	timer->seed = dc_trigger_timer_seed(trigger);
 
 	trigger->timer_revision = trigger->revision;
 
@@ -4064,7 +4520,7 @@ static void	dc_schedule_trigger_timers(zbx_hashset_t *trend_queue, int now)
 		if (TRIGGER_STATUS_ENABLED != trigger->status || TRIGGER_FUNCTIONAL_TRUE != trigger->functional)
 			continue;
 
-		if (NULL == (timer = dc_trigger_function_timer_create(function, now)))
+		if (NULL == (timer = dc_trigger_function_timer_create(function, trigger, now)))
 			continue;
 
 		if (NULL != trend_queue && NULL != (old = (zbx_trigger_timer_t *)zbx_hashset_search(trend_queue,
@@ -4073,7 +4529,7 @@ static void	dc_schedule_trigger_timers(zbx_hashset_t *trend_queue, int now)
 			/* if the trigger was scheduled during next 10 minutes         */
 			/* schedule its evaluation later to reduce server startup load */
 			if (old->eval_ts.sec < now + 10 * SEC_PER_MIN)
-				ts.sec = now + 10 * SEC_PER_MIN + (int)(timer->triggerid % (10 * SEC_PER_MIN));
+				ts.sec = now + 10 * SEC_PER_MIN + (int)(timer->seed % (10 * SEC_PER_MIN));
 			else
 				ts.sec = old->eval_ts.sec;
 
@@ -4081,7 +4537,7 @@ static void	dc_schedule_trigger_timers(zbx_hashset_t *trend_queue, int now)
 		}
 		else
 		{
-			if (0 == (ts.sec = (int)dc_function_calculate_nextcheck(NULL, timer, now, timer->triggerid)))
+			if (0 == (ts.sec = (int)dc_function_calculate_nextcheck(NULL, timer, now, timer->seed)))
 			{
 				dc_trigger_timer_free(timer);
 				function->timer_revision = 0;
@@ -4109,7 +4565,7 @@ static void	dc_schedule_trigger_timers(zbx_hashset_t *trend_queue, int now)
 		if (NULL == (timer = dc_trigger_timer_create(trigger)))
 			continue;
 
-		if (0 == (ts.sec = (int)dc_function_calculate_nextcheck(NULL, timer, now, timer->triggerid)))
+		if (0 == (ts.sec = (int)dc_function_calculate_nextcheck(NULL, timer, now, timer->seed)))
 		{
 			dc_trigger_timer_free(timer);
 			trigger->timer_revision = 0;
@@ -4133,6 +4589,8 @@ static void	DCsync_functions(zbx_dbsync_t *sync, zbx_uint64_t revision)
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
+	dc_hashset_reserve_sync(&config->functions, sync);
+
 	while (SUCCEED == (ret = zbx_dbsync_next(sync, &rowid, &row, &tag)))
 	{
 		/* removed rows will be always added at the end */
@@ -5148,7 +5606,7 @@ static void	DCsync_item_tags(zbx_dbsync_t *sync)
 		if (0 == found)
 		{
 			item_tag->itemid = itemid;
-			zbx_vector_ptr_append(&item->tags, item_tag);
+			zbx_vector_ptr_append(&item->cold->tags, item_tag);
 		}
 	}
 
@@ -5161,16 +5619,16 @@ static void	DCsync_item_tags(zbx_dbsync_t *sync)
 
 		if (NULL != (item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &item_tag->itemid)))
 		{
-			if (FAIL != (index = zbx_vector_ptr_search(&item->tags, item_tag,
+			if (FAIL != (index = zbx_vector_ptr_search(&item->cold->tags, item_tag,
 					ZBX_DEFAULT_PTR_COMPARE_FUNC)))
 			{
-				zbx_vector_ptr_remove_noorder(&item->tags, index);
+				zbx_vector_ptr_remove_noorder(&item->cold->tags, index);
 
 				/* recreate empty tags vector to release used memory */
-				if (0 == item->tags.values_num)
+				if (0 == item->cold->tags.values_num)
 				{
-					zbx_vector_ptr_destroy(&item->tags);
-					zbx_vector_ptr_create_ext(&item->tags, __config_shmem_malloc_func,
+					zbx_vector_ptr_destroy(&item->cold->tags);
+					zbx_vector_ptr_create_ext(&item->cold->tags, __config_shmem_malloc_func,
 							__config_shmem_realloc_func, __config_shmem_free_func);
 				}
 			}
@@ -5347,6 +5805,8 @@ static void	DCsync_item_preproc(zbx_dbsync_t *sync, zbx_uint64_t revision)
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
+	dc_hashset_reserve_sync(&config->preprocops, sync);
+
 	zbx_vector_dc_item_ptr_create(&items);
 
 	while (SUCCEED == (ret = zbx_dbsync_next(sync, &rowid, &row, &tag)))
@@ -5360,14 +5820,14 @@ static void	DCsync_item_preproc(zbx_dbsync_t *sync, zbx_uint64_t revision)
 		if (NULL == (item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &itemid)))
 			continue;
 
-		if (NULL == (preprocitem = item->preproc_item))
+		if (NULL == (preprocitem = item->cold->preproc_item))
 		{
 			preprocitem = (ZBX_DC_PREPROCITEM *)__config_shmem_malloc_func(NULL, sizeof(ZBX_DC_PREPROCITEM));
 
 			zbx_vector_ptr_create_ext(&preprocitem->preproc_ops, __config_shmem_malloc_func,
 					__config_shmem_realloc_func, __config_shmem_free_func);
 
-			item->preproc_item = preprocitem;
+			item->cold->preproc_item = preprocitem;
 		}
 		zbx_vector_dc_item_ptr_append(&items, item);
 
@@ -5397,7 +5857,7 @@ static void	DCsync_item_preproc(zbx_dbsync_t *sync, zbx_uint64_t revision)
 			continue;
 
 		if (NULL != (item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &op->itemid)) &&
-				NULL != (preprocitem = item->preproc_item))
+				NULL != (preprocitem = item->cold->preproc_item))
 		{
 			if (FAIL != (index = zbx_vector_ptr_search(&preprocitem->preproc_ops, op,
 					ZBX_DEFAULT_PTR_COMPARE_FUNC)))
@@ -5421,7 +5881,7 @@ static void	DCsync_item_preproc(zbx_dbsync_t *sync, zbx_uint64_t revision)
 	{
 		item = items.values[i];
 
-		if (NULL == (preprocitem = item->preproc_item))
+		if (NULL == (preprocitem = item->cold->preproc_item))
 			continue;
 
 		dc_item_update_revision(item, revision);
@@ -5429,7 +5889,7 @@ static void	DCsync_item_preproc(zbx_dbsync_t *sync, zbx_uint64_t revision)
 		if (0 == preprocitem->preproc_ops.values_num)
 		{
 			dc_preprocitem_free(preprocitem);
-			item->preproc_item = NULL;
+			item->cold->preproc_item = NULL;
 		}
 		else
 			zbx_vector_ptr_sort(&preprocitem->preproc_ops, dc_compare_preprocops_by_step);
@@ -5691,6 +6151,9 @@ static void	dc_sync_drules(zbx_dbsync_t *sync, zbx_uint64_t revision)
 		{
 			drule->location = ZBX_LOC_NOWHERE;
 			drule->nextcheck = 0;
+			drule->started = 0;
+			drule->addresses_num = 0;
+			drule->processed_num = 0;
 		}
 		else
 		{
@@ -6504,13 +6967,16 @@ static void	dc_load_trigger_queue(zbx_hashset_t *trend_functions)
 	zbx_db_free_result(result);
 }
 
+static int	standby_sync = 0;
+
 static void	zbx_dbsync_process_active_avail_diff(zbx_vector_uint64_t *diff)
 {
 	zbx_ipc_message_t	message;
 	unsigned char		*data = NULL;
 	zbx_uint32_t		data_len = 0;
 
-	if (0 == diff->values_num)
+	/* availability manager is not running on standby node */
+	if (0 == diff->values_num || 0 != standby_sync)
 		return;
 
 	zbx_ipc_message_init(&message);
@@ -6825,11 +7291,12 @@ void	zbx_dc_sync_configuration(unsigned char mode, zbx_synced_new_config_t synce
 	zbx_dbsync_init(&connector_sync, changelog_sync_mode);
 	zbx_dbsync_init(&connector_tag_sync, changelog_sync_mode);
 
-#ifdef HAVE_ORACLE
-	/* With Oracle fetch statements can fail before all data has been fetched. */
-	/* In such cache next sync will need to do full scan rather than just      */
-	/* applying changelog diff. To detect this problem configuration is synced */
-	/* in transaction and error is checked at the end.                         */
+#if defined(HAVE_ORACLE) || defined(HAVE_POSTGRESQL)
+	/* With Oracle and with PostgreSQL streamed selects fetch statements can   */
+	/* fail before all data has been fetched. In such cache next sync will     */
+	/* need to do full scan rather than just applying changelog diff. To       */
+	/* detect this problem configuration is synced in transaction and error is */
+	/* checked at the end.                                                     */
 	zbx_db_begin();
 #endif
 
@@ -7157,20 +7624,10 @@ void	zbx_dc_sync_configuration(unsigned char mode, zbx_synced_new_config_t synce
 		goto out;
 	corr_operation_sec = zbx_time() - sec;
 
+	/* actions, correlations, discovery rules and web scenarios are not linked to triggers and items, */
+	/* apply them separately to keep the write lock periods short                                    */
 	START_SYNC;
 
-	sec = zbx_time();
-	DCsync_triggers(&triggers_sync, new_revision);
-	tsec2 = zbx_time() - sec;
-
-	sec = zbx_time();
-	DCsync_trigdeps(&tdep_sync);
-	dsec2 = zbx_time() - sec;
-
-	sec = zbx_time();
-	DCsync_expressions(&expr_sync, new_revision);
-	expr_sec2 = zbx_time() - sec;
-
 	sec = zbx_time();
 	DCsync_actions(&action_sync);
 	action_sec2 = zbx_time() - sec;
@@ -7183,15 +7640,6 @@ void	zbx_dc_sync_configuration(unsigned char mode, zbx_synced_new_config_t synce
 	DCsync_action_conditions(&action_condition_sync);
 	action_condition_sec2 = zbx_time() - sec;
 
-	sec = zbx_time();
-	/* relies on triggers, must be after DCsync_triggers() */
-	DCsync_trigger_tags(&trigger_tag_sync);
-	trigger_tag_sec2 = zbx_time() - sec;
-
-	sec = zbx_time();
-	DCsync_item_tags(&item_tag_sync);
-	item_tag_sec2 = zbx_time() - sec;
-
 	sec = zbx_time();
 	DCsync_correlations(&correlation_sync);
 	correlation_sec2 = zbx_time() - sec;
@@ -7218,6 +7666,31 @@ void	zbx_dc_sync_configuration(unsigned char mode, zbx_synced_new_config_t synce
 	dc_sync_httpstep_fields(&httpstep_field_sync, new_revision);
 	httptest_sec2 = zbx_time() - sec;
 
+	FINISH_SYNC;
+
+	START_SYNC;
+
+	sec = zbx_time();
+	DCsync_triggers(&triggers_sync, new_revision);
+	tsec2 = zbx_time() - sec;
+
+	sec = zbx_time();
+	DCsync_trigdeps(&tdep_sync);
+	dsec2 = zbx_time() - sec;
+
+	sec = zbx_time();
+	DCsync_expressions(&expr_sync, new_revision);
+	expr_sec2 = zbx_time() - sec;
+
+	sec = zbx_time();
+	/* relies on triggers, must be after DCsync_triggers() */
+	DCsync_trigger_tags(&trigger_tag_sync);
+	trigger_tag_sec2 = zbx_time() - sec;
+
+	sec = zbx_time();
+	DCsync_item_tags(&item_tag_sync);
+	item_tag_sec2 = zbx_time() - sec;
+
 	sec = zbx_time();
 
 	if (0 != hosts_sync.add_num + hosts_sync.update_num + hosts_sync.remove_num)
@@ -7244,6 +7717,14 @@ void	zbx_dc_sync_configuration(unsigned char mode, zbx_synced_new_config_t synce
 	if (0 != htmpl_sync.add_num + htmpl_sync.update_num + htmpl_sync.remove_num)
 		update_flags |= ZBX_DBSYNC_UPDATE_MACROS;
 
+	if (0 != (update_flags & (ZBX_DBSYNC_UPDATE_HOSTS | ZBX_DBSYNC_UPDATE_ITEMS | ZBX_DBSYNC_UPDATE_HOST_GROUPS)) ||
+			0 != hgroup_host_sync.add_num + hgroup_host_sync.update_num + hgroup_host_sync.remove_num ||
+			0 != item_tag_sync.add_num + item_tag_sync.update_num + item_tag_sync.remove_num ||
+			0 != host_tag_sync.add_num + host_tag_sync.update_num + host_tag_sync.remove_num)
+	{
+		config->revision.items = new_revision;
+	}
+
 	if (0 != connector_sync.add_num + connector_sync.update_num + connector_sync.remove_num +
 			connector_tag_sync.add_num + connector_tag_sync.update_num + connector_tag_sync.remove_num)
 	{
@@ -7597,7 +8078,7 @@ out:
 
 	FINISH_SYNC;
 
-#ifdef HAVE_ORACLE
+#if defined(HAVE_ORACLE) || defined(HAVE_POSTGRESQL)
 	if (ZBX_DB_OK == dberr)
 		dberr = zbx_db_commit();
 	else
@@ -7698,6 +8179,30 @@ clean:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: synchronize configuration cache on standby node                   *
+ *                                                                            *
+ * Parameters: mode                  - [IN] ZBX_DBSYNC_INIT - initial sync    *
+ *                                          ZBX_DBSYNC_UPDATE - update sync   *
+ *             config_vault          - [IN]                                   *
+ *             proxyconfig_frequency - [IN]                                   *
+ *                                                                            *
+ * Comments: Standby node keeps configuration cache up to date in the main    *
+ *           process, so it does not have to be loaded from scratch on        *
+ *           failover. Other server processes are not running, so their       *
+ *           notifications are skipped.                                       *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dc_sync_configuration_standby(unsigned char mode, const zbx_config_vault_t *config_vault,
+		int proxyconfig_frequency)
+{
+	standby_sync = 1;
+	zbx_dc_sync_configuration(mode, ZBX_SYNCED_NEW_CONFIG_NO, NULL, config_vault, proxyconfig_frequency);
+	zbx_dc_sync_kvs_paths(NULL, config_vault);
+	standby_sync = 0;
+}
+
 /******************************************************************************
  *                                                                            *
  * Helper functions for configuration cache data structure element comparison *
@@ -7959,6 +8464,8 @@ static int	__config_timer_compare(const void *d1, const void *d2)
 	if (0 != (ret = zbx_timespec_compare(&t1->check_ts, &t2->check_ts)))
 		return ret;
 
+	/* keep timers with the same seed together so they are processed in the same batch */
+	ZBX_RETURN_IF_NOT_EQUAL(t1->seed, t2->seed);
 	ZBX_RETURN_IF_NOT_EQUAL(t1->triggerid, t2->triggerid);
 
 	if (0 != (ret = zbx_timespec_compare(&t1->eval_ts, &t2->eval_ts)))
@@ -8134,8 +8641,12 @@ int	zbx_init_configuration_cache(zbx_get_program_type_f get_program_type, zbx_ge
 	CREATE_HASHSET(config->connectors, 0);
 	CREATE_HASHSET(config->connector_tags, 0);
 
+	memset(config->schedule_load, 0, sizeof(config->schedule_load));
+
 	for (i = 0; i < ZBX_POLLER_TYPE_COUNT; i++)
 	{
+		config->inflight_checks[i] = 0;
+
 		switch (i)
 		{
 			case ZBX_POLLER_TYPE_JAVA:
@@ -8790,7 +9301,17 @@ void	DCget_interface(zbx_dc_interface_t *dst_interface, const ZBX_DC_INTERFACE *
 	dst_interface->port = 0;
 }
 
-static void	DCget_item(zbx_dc_item_t *dst_item, const ZBX_DC_ITEM *src_item)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: copy item data from configuration cache                           *
+ *                                                                            *
+ * Parameters: dst_item   - [OUT] item                                        *
+ *             src_item   - [IN] configuration cache item                     *
+ *             copy_delay - [IN] 1 - allocate copy of item update interval,   *
+ *                               0 - leave it NULL (pollers don't use it)     *
+ *                                                                            *
+ ******************************************************************************/
+static void	DCget_item_ext(zbx_dc_item_t *dst_item, const ZBX_DC_ITEM *src_item, unsigned char copy_delay)
 {
 	const ZBX_DC_LOGITEM		*logitem;
 	const ZBX_DC_SNMPITEM		*snmpitem;
@@ -8811,21 +9332,25 @@ static void	DCget_item(zbx_dc_item_t *dst_item, const ZBX_DC_ITEM *src_item)
 	dst_item->value_type = src_item->value_type;
 
 	dst_item->state = src_item->state;
-	dst_item->lastlogsize = src_item->lastlogsize;
-	dst_item->mtime = src_item->mtime;
+	dst_item->lastlogsize = src_item->cold->lastlogsize;
+	dst_item->mtime = src_item->cold->mtime;
 
 	dst_item->status = src_item->status;
 
 	zbx_strscpy(dst_item->key_orig, src_item->key);
 
 	dst_item->itemid = src_item->itemid;
+	dst_item->revision = src_item->revision;
 	dst_item->flags = src_item->flags;
 	dst_item->key = NULL;
 
-	dst_item->delay = zbx_strdup(NULL, src_item->delay);	/* not used, should be initialized */
+	if (0 != copy_delay)
+		dst_item->delay = zbx_strdup(NULL, src_item->delay);
+	else
+		dst_item->delay = NULL;
 
-	if ('\0' != *src_item->error)
-		dst_item->error = zbx_strdup(NULL, src_item->error);
+	if ('\0' != *src_item->cold->error)
+		dst_item->error = zbx_strdup(NULL, src_item->cold->error);
 	else
 		dst_item->error = NULL;
 
@@ -9118,6 +9643,28 @@ static void	DCget_item(zbx_dc_item_t *dst_item, const ZBX_DC_ITEM *src_item)
 	}
 }
 
+static void	DCget_item(zbx_dc_item_t *dst_item, const ZBX_DC_ITEM *src_item)
+{
+	DCget_item_ext(dst_item, src_item, 1);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: copy item while keeping interface address pointing into the copy  *
+ *                                                                            *
+ * Parameters: dst - [OUT] destination item                                   *
+ *             src - [IN] source item                                         *
+ *                                                                            *
+ * Comments: Dynamic fields are not duplicated and belong to both items, only *
+ *           one of them must be cleaned.                                     *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dc_item_copy(zbx_dc_item_t *dst, const zbx_dc_item_t *src)
+{
+	*dst = *src;
+	dst->interface.addr = (1 == dst->interface.useip ? dst->interface.ip_orig : dst->interface.dns_orig);
+}
+
 void	zbx_dc_config_clean_items(zbx_dc_item_t *items, int *errcodes, size_t num)
 {
 	size_t	i;
@@ -9445,6 +9992,9 @@ static void	dc_preproc_sync_preprocitem(zbx_pp_item_preproc_t *preproc, zbx_uint
 
 		preproc->steps[i].params = dc_expand_user_macros_dyn(op->params, &hostid, 1, ZBX_MACRO_ENV_NONSECURE);
 		preproc->steps[i].error_handler_params = zbx_strdup(NULL, op->error_handler_params);
+		preproc->steps[i].jsonpath = NULL;
+		preproc->steps[i].prometheus = NULL;
+		preproc->steps[i].xpath = NULL;
 	}
 
 	preproc->steps_num = preprocitem->preproc_ops.values_num;
@@ -9463,10 +10013,10 @@ static void	dc_preproc_sync_masteritem(zbx_pp_item_preproc_t *preproc, const ZBX
 	for (int i = 0; i < masteritem->dep_itemids.values_num; i++)
 		preproc->dep_itemids[i] = masteritem->dep_itemids.values[i].first;
 
+	preproc->dep_itemids_num = masteritem->dep_itemids.values_num;
+
 	qsort(preproc->dep_itemids, (size_t)preproc->dep_itemids_num, sizeof(zbx_uint64_t),
 			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
-
-	preproc->dep_itemids_num = masteritem->dep_itemids.values_num;
 }
 
 /******************************************************************************
@@ -9530,11 +10080,11 @@ static void	dc_preproc_sync_item(zbx_hashset_t *items, ZBX_DC_ITEM *dc_item, zbx
 	preproc = zbx_pp_item_preproc_create(dc_item->type, dc_item->value_type, dc_item->flags);
 	pp_item->revision = revision;
 
-	if (NULL != dc_item->master_item)
-		dc_preproc_sync_masteritem(preproc, dc_item->master_item);
+	if (NULL != dc_item->cold->master_item)
+		dc_preproc_sync_masteritem(preproc, dc_item->cold->master_item);
 
-	if (NULL != dc_item->preproc_item)
-		dc_preproc_sync_preprocitem(preproc, dc_item->hostid, dc_item->preproc_item);
+	if (NULL != dc_item->cold->preproc_item)
+		dc_preproc_sync_preprocitem(preproc, dc_item->hostid, dc_item->cold->preproc_item);
 
 	if (NULL != pp_item->preproc)
 	{
@@ -9554,6 +10104,8 @@ static void	dc_preproc_sync_item(zbx_hashset_t *items, ZBX_DC_ITEM *dc_item, zbx
 			preproc->history_num++;
 			preproc->mode = ZBX_PP_PROCESS_SERIAL;
 		}
+
+		zbx_pp_step_compile(&preproc->steps[i]);
 	}
 
 	pp_item->preproc = preproc;
@@ -9563,16 +10115,16 @@ static void	dc_preproc_add_item_rec(ZBX_DC_ITEM *dc_item, zbx_vector_dc_item_ptr
 {
 	zbx_vector_dc_item_ptr_append(items_sync, dc_item);
 
-	if (NULL != dc_item->master_item)
+	if (NULL != dc_item->cold->master_item)
 	{
 		int	i;
 
-		for (i = 0; i < dc_item->master_item->dep_itemids.values_num; i++)
+		for (i = 0; i < dc_item->cold->master_item->dep_itemids.values_num; i++)
 		{
 			ZBX_DC_ITEM	*dep_item;
 
 			if (NULL == (dep_item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items,
-					&dc_item->master_item->dep_itemids.values[i].first)) ||
+					&dc_item->cold->master_item->dep_itemids.values[i].first)) ||
 					ITEM_STATUS_ACTIVE != dep_item->status)
 			{
 				continue;
@@ -9593,6 +10145,9 @@ static void	dc_preproc_add_item_rec(ZBX_DC_ITEM *dc_item, zbx_vector_dc_item_ptr
  * Parameters: items       - [IN/OUT] hashset with DC_ITEMs                   *
  *             timestamp   - [IN/OUT] timestamp of a last update              *
  *                                                                            *
+ * Comments: Preprocessing data is rebuilt only for items with revision newer *
+ *           than the last update, unless global or host macros have changed. *
+ *                                                                            *
  ******************************************************************************/
 void	zbx_dc_config_get_preprocessable_items(zbx_hashset_t *items, zbx_uint64_t *revision)
 {
@@ -9627,7 +10182,7 @@ void	zbx_dc_config_get_preprocessable_items(zbx_hashset_t *items, zbx_uint64_t *
 			if (ITEM_STATUS_ACTIVE != dc_item->status || ITEM_TYPE_DEPENDENT == dc_item->type)
 				continue;
 
-			if (NULL == dc_item->preproc_item && NULL == dc_item->master_item &&
+			if (NULL == dc_item->cold->preproc_item && NULL == dc_item->cold->master_item &&
 					ITEM_TYPE_INTERNAL != dc_item->type &&
 					ZBX_FLAG_DISCOVERY_RULE != dc_item->flags)
 			{
@@ -9645,24 +10200,28 @@ void	zbx_dc_config_get_preprocessable_items(zbx_hashset_t *items, zbx_uint64_t *
 		if (0 == items_sync.values_num)
 			continue;
 
-		if (*revision >= global_revision && *revision >= dc_host->revision)
+		if (*revision >= global_revision)
 		{
 			zbx_uint64_t	macro_revision = *revision;
 
 			if (SUCCEED != um_cache_get_host_revision(config->um_cache, dc_host->hostid, &macro_revision) ||
 					*revision >= macro_revision)
 			{
-				/* no host/macro changes - update item revision without actually syncing it */
-				for (i = 0; i < items_sync.values_num; i++)
+				/* No macro changes - sync only items changed since the last revision. Unchanged */
+				/* items keep their preprocessing data, only the item revision is updated.       */
+				for (i = 0; i < items_sync.values_num;)
 				{
-					if (NULL != (pp_item = (zbx_pp_item_t *)zbx_hashset_search(items,
+					if (*revision >= items_sync.values[i]->revision && NULL != (pp_item =
+							(zbx_pp_item_t *)zbx_hashset_search(items,
 							&items_sync.values[i]->itemid)))
 					{
 						pp_item->revision = config->revision.config;
+						zbx_vector_dc_item_ptr_remove_noorder(&items_sync, i);
+						continue;
 					}
 
+					i++;
 				}
-				zbx_vector_dc_item_ptr_clear(&items_sync);
 			}
 		}
 
@@ -9845,6 +10404,10 @@ void	zbx_dc_config_clean_triggers(zbx_dc_trigger_t *triggers, int *errcodes, siz
  *                                    output, the item locked field is set    *
  *                                    to 0 if the corresponding item cannot   *
  *                                    be taken                                *
+ *             triggers_max  - [IN] the maximum number of triggers to lock;   *
+ *                                  items whose triggers do not fit are left  *
+ *                                  for other processes, but the first item   *
+ *                                  with triggers is always taken             *
  *             triggerids  - [OUT] list of trigger IDs that this function has *
  *                                 locked for processing; unlock those using  *
  *                                 zbx_dc_config_unlock_triggers() function   *
@@ -9864,9 +10427,10 @@ void	zbx_dc_config_clean_triggers(zbx_dc_trigger_t *triggers, int *errcodes, siz
  * Return value: the number of items available for processing (unlocked).     *
  *                                                                            *
  ******************************************************************************/
-int	zbx_dc_config_lock_triggers_by_history_items(zbx_vector_ptr_t *history_items, zbx_vector_uint64_t *triggerids)
+int	zbx_dc_config_lock_triggers_by_history_items(zbx_vector_ptr_t *history_items, int triggers_max,
+		zbx_vector_uint64_t *triggerids)
 {
-	int			i, j, locked_num = 0;
+	int			i, j, locked_num = 0, triggers_num;
 	const ZBX_DC_ITEM	*dc_item;
 	ZBX_DC_TRIGGER		*dc_trigger;
 	zbx_hc_item_t		*history_item;
@@ -9886,7 +10450,7 @@ int	zbx_dc_config_lock_triggers_by_history_items(zbx_vector_ptr_t *history_items
 		if (NULL == dc_item->triggers)
 			continue;
 
-		for (j = 0; NULL != (dc_trigger = dc_item->triggers[j]); j++)
+		for (j = 0, triggers_num = 0; NULL != (dc_trigger = dc_item->triggers[j]); j++)
 		{
 			if (TRIGGER_STATUS_ENABLED != dc_trigger->status)
 				continue;
@@ -9897,6 +10461,17 @@ int	zbx_dc_config_lock_triggers_by_history_items(zbx_vector_ptr_t *history_items
 				history_item->status = ZBX_HC_ITEM_STATUS_BUSY;
 				goto next;
 			}
+
+			triggers_num++;
+		}
+
+		/* leave items with many triggers to other processes, so that trigger */
+		/* recalculation of large hosts is spread between history syncers     */
+		if (0 != triggerids->values_num && triggerids->values_num + triggers_num > triggers_max)
+		{
+			locked_num++;
+			history_item->status = ZBX_HC_ITEM_STATUS_BUSY;
+			continue;
 		}
 
 		for (j = 0; NULL != (dc_trigger = dc_item->triggers[j]); j++)
@@ -10352,7 +10927,7 @@ void	zbx_dc_reschedule_trigger_timers(zbx_vector_ptr_t *timers, int now)
 		if (0 == timer->check_ts.sec)
 		{
 			if (0 != (timer->check_ts.sec = (int)dc_function_calculate_nextcheck(um_handle, timer, now,
-					timer->triggerid)))
+					timer->seed)))
 			{
 				timer->eval_ts = timer->check_ts;
 			}
@@ -10645,6 +11220,34 @@ int	zbx_dc_config_get_poller_nextcheck(unsigned char poller_type)
 	return nextcheck;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get scheduling lag of selected poller type                        *
+ *                                                                            *
+ * Parameters: poller_type - [IN] poller type (ZBX_POLLER_TYPE_...)           *
+ *                                                                            *
+ * Return value: number of seconds the most overdue queued item is late, 0 if *
+ *               no queued items are overdue                                  *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_dc_get_poller_lag(unsigned char poller_type)
+{
+	int	nextcheck, now, lag = 0;
+
+	now = (int)time(NULL);
+
+	RDLOCK_CACHE;
+
+	nextcheck = dc_config_get_queue_nextcheck(&config->queues[poller_type]);
+
+	UNLOCK_CACHE;
+
+	if (FAIL != nextcheck && nextcheck < now)
+		lag = now - nextcheck;
+
+	return lag;
+}
+
 static void	dc_requeue_item(ZBX_DC_ITEM *dc_item, const ZBX_DC_HOST *dc_host, const ZBX_DC_INTERFACE *dc_interface,
 		int flags, int lastclock)
 {
@@ -10691,6 +11294,9 @@ static void	dc_requeue_item_at(ZBX_DC_ITEM *dc_item, ZBX_DC_HOST *dc_host, int n
  *                                                                            *
  * Parameters: poller_type    - [IN] poller type (ZBX_POLLER_TYPE_...)        *
  *             config_timeout - [IN]                                          *
+ *             processing     - [IN] number of items being processed          *
+ *                                   asynchronously by the poller             *
+ *             config_max_concurrent_checks_per_poller - [IN]                 *
  *             items          - [OUT] array of items                          *
  *                                                                            *
  * Return value: number of items in items array                               *
@@ -10699,18 +11305,28 @@ static void	dc_requeue_item_at(ZBX_DC_ITEM *dc_item, ZBX_DC_HOST *dc_host, int n
  *           always return the items they have taken using                    *
  *           zbx_dc_requeue_items() or zbx_dc_poller_requeue_items().         *
  *                                                                            *
- *           Currently batch polling is supported only for JMX, SNMP and      *
- *           icmpping* simple checks. In other cases only single item is      *
- *           retrieved.                                                       *
+ *           Currently batch polling is supported only for JMX, SNMP,         *
+ *           icmpping* simple checks and asynchronous agent and HTTP agent    *
+ *           checks. In other cases only single item is retrieved.            *
+ *           Asynchronous SNMP pollers get all due items of a single          *
+ *           interface per call, up to the concurrency limit.                 *
  *                                                                            *
  *           IPMI poller queue are handled by DCconfig_get_ipmi_poller_items()*
  *           function.                                                        *
  *                                                                            *
+ *           When more than one item can be returned the items array is a     *
+ *           per process buffer that is reused by the next call, so it must   *
+ *           not be freed by caller. Item data that must outlive the next     *
+ *           call must be copied by caller.                                   *
+ *                                                                            *
  ******************************************************************************/
-int	zbx_dc_config_get_poller_items(unsigned char poller_type, int config_timeout, zbx_dc_item_t **items)
+int	zbx_dc_config_get_poller_items(unsigned char poller_type, int config_timeout, int processing,
+		int config_max_concurrent_checks_per_poller, zbx_dc_item_t **items)
 {
 	int			now, num = 0, max_items;
 	zbx_binary_heap_t	*queue;
+	static zbx_dc_item_t	*items_buf = NULL;
+	static int		items_buf_alloc = 0;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() poller_type:%d", __func__, (int)poller_type);
 
@@ -10726,6 +11342,14 @@ int	zbx_dc_config_get_poller_items(unsigned char poller_type, int config_timeout
 		case ZBX_POLLER_TYPE_PINGER:
 			max_items = ZBX_MAX_PINGER_ITEMS;
 			break;
+		case ZBX_POLLER_TYPE_AGENT:
+		case ZBX_POLLER_TYPE_SNMP:
+		case ZBX_POLLER_TYPE_HTTPAGENT:
+			if (0 >= (max_items = config_max_concurrent_checks_per_poller - processing))
+				goto out;
+
+			max_items = MIN(max_items, ZBX_MAX_POLLER_ITEMS);
+			break;
 		default:
 			max_items = 1;
 	}
@@ -10800,6 +11424,7 @@ int	zbx_dc_config_get_poller_items(unsigned char poller_type, int config_timeout
 				/* postpone checks on hosts that have been checked recently and */
 				/* are still unreachable                                        */
 				if (ZBX_POLLER_TYPE_NORMAL == poller_type || ZBX_POLLER_TYPE_JAVA == poller_type ||
+						ZBX_POLLER_TYPE_AGENT == poller_type || ZBX_POLLER_TYPE_SNMP == poller_type ||
 						disable_until > now)
 				{
 					dc_requeue_item(dc_item, dc_host, dc_interface,
@@ -10813,6 +11438,7 @@ int	zbx_dc_config_get_poller_items(unsigned char poller_type, int config_timeout
 
 		if (0 == num)
 		{
+			/* asynchronous SNMP check splits its items into requests of suggested size itself */
 			if (ZBX_POLLER_TYPE_NORMAL == poller_type && ITEM_TYPE_SNMP == dc_item->type &&
 					0 == (ZBX_FLAG_DISCOVERY_RULE & dc_item->flags))
 			{
@@ -10828,18 +11454,34 @@ int	zbx_dc_config_get_poller_items(unsigned char poller_type, int config_timeout
 			}
 
 			if (1 < max_items)
-				*items = zbx_malloc(NULL, sizeof(zbx_dc_item_t) * max_items);
+			{
+				/* the buffer is kept between calls to avoid reallocating large item array */
+				if (items_buf_alloc < max_items)
+				{
+					items_buf = (zbx_dc_item_t *)zbx_realloc(items_buf,
+							sizeof(zbx_dc_item_t) * (size_t)max_items);
+					items_buf_alloc = max_items;
+				}
+
+				*items = items_buf;
+			}
 		}
 
 		dc_item_prev = dc_item;
 		dc_item->location = ZBX_LOC_POLLER;
 		DCget_host(&(*items)[num].host, dc_host);
-		DCget_item(&(*items)[num], dc_item);
+		DCget_item_ext(&(*items)[num], dc_item, 0);
 		num++;
 	}
 
-	UNLOCK_CACHE;
+	if (ZBX_POLLER_TYPE_AGENT == poller_type || ZBX_POLLER_TYPE_SNMP == poller_type ||
+			ZBX_POLLER_TYPE_HTTPAGENT == poller_type)
+	{
+		config->inflight_checks[poller_type] += num;
+	}
 
+	UNLOCK_CACHE;
+out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%d", __func__, num);
 
 	return num;
@@ -11121,7 +11763,36 @@ void	zbx_dc_poller_requeue_items(const zbx_uint64_t *itemids, const int *lastclo
 	dc_requeue_items(itemids, lastclocks, errcodes, num);
 	*nextcheck = dc_config_get_queue_nextcheck(&config->queues[poller_type]);
 
+	if (ZBX_POLLER_TYPE_AGENT == poller_type || ZBX_POLLER_TYPE_SNMP == poller_type ||
+			ZBX_POLLER_TYPE_HTTPAGENT == poller_type)
+	{
+		config->inflight_checks[poller_type] -= (int)num;
+	}
+
+	UNLOCK_CACHE;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get number of checks being processed by asynchronous pollers      *
+ *                                                                            *
+ * Parameters: poller_type - [IN] poller type (ZBX_POLLER_TYPE_...)           *
+ *                                                                            *
+ * Return value: number of items taken by pollers of the specified type and   *
+ *               not yet returned to the queue                                *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_dc_get_inflight_checks(unsigned char poller_type)
+{
+	int	num;
+
+	RDLOCK_CACHE;
+
+	num = config->inflight_checks[poller_type];
+
 	UNLOCK_CACHE;
+
+	return num;
 }
 
 #ifdef HAVE_OPENIPMI
@@ -11993,47 +12664,188 @@ void	zbx_dc_requeue_proxy(zbx_uint64_t hostid, unsigned char update_nextcheck, i
 		else if (CONFIG_ERROR == proxy_conn_err)
 			dc_proxy->last_cfg_error_time = (int)now;
 
-		if (HOST_STATUS_PROXY_PASSIVE == dc_host->status)
+		if (HOST_STATUS_PROXY_PASSIVE == dc_host->status)
+		{
+			if (0 != (update_nextcheck & ZBX_PROXY_CONFIG_NEXTCHECK))
+			{
+				dc_proxy->proxy_config_nextcheck = (int)calculate_proxy_nextcheck(
+						hostid, proxyconfig_frequency, now);
+			}
+
+			if (0 != (update_nextcheck & ZBX_PROXY_DATA_NEXTCHECK))
+			{
+				dc_proxy->proxy_data_nextcheck = (int)calculate_proxy_nextcheck(
+						hostid, proxydata_frequency, now);
+			}
+			if (0 != (update_nextcheck & ZBX_PROXY_TASKS_NEXTCHECK))
+			{
+				dc_proxy->proxy_tasks_nextcheck = (int)calculate_proxy_nextcheck(
+						hostid, ZBX_TASK_UPDATE_FREQUENCY, now);
+			}
+
+			DCupdate_proxy_queue(dc_proxy);
+		}
+	}
+
+	UNLOCK_CACHE;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
+/********************************************************************************
+ *                                                                              *
+ * Purpose: frees the item queue data vector created by zbx_dc_get_item_queue() *
+ *                                                                              *
+ * Parameters: queue - [IN] the item queue data vector to free                  *
+ *                                                                              *
+ *******************************************************************************/
+void	zbx_dc_free_item_queue(zbx_vector_ptr_t *queue)
+{
+	int	i;
+
+	for (i = 0; i < queue->values_num; i++)
+		zbx_free(queue->values[i]);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if item is counted in item queue                           *
+ *                                                                            *
+ * Parameters: dc_host - [IN] the monitored item host                         *
+ *             dc_item - [IN] the item                                        *
+ *             now     - [IN] the current time                                *
+ *                                                                            *
+ * Return value: SUCCEED - item is expected to be checked at its nextcheck    *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	dc_item_queue_check(const ZBX_DC_HOST *dc_host, const ZBX_DC_ITEM *dc_item, int now)
+{
+	const ZBX_DC_INTERFACE	*dc_interface;
+	char			*delay_s;
+	int			ret, data_expected_from, delay;
+
+	if (ITEM_STATUS_ACTIVE != dc_item->status)
+		return FAIL;
+
+	if (SUCCEED != zbx_is_counted_in_item_queue(dc_item->type, dc_item->key))
+		return FAIL;
+
+	if (SUCCEED == DCin_maintenance_without_data_collection(dc_host, dc_item))
+		return FAIL;
+
+	switch (dc_item->type)
+	{
+		case ITEM_TYPE_ZABBIX:
+		case ITEM_TYPE_SNMP:
+		case ITEM_TYPE_IPMI:
+		case ITEM_TYPE_JMX:
+			if (NULL == (dc_interface = (const ZBX_DC_INTERFACE *)zbx_hashset_search(
+					&config->interfaces, &dc_item->interfaceid)))
+			{
+				return FAIL;
+			}
+
+			if (ZBX_INTERFACE_AVAILABLE_TRUE != dc_interface->available)
+				return FAIL;
+			break;
+		case ITEM_TYPE_ZABBIX_ACTIVE:
+			if (dc_host->data_expected_from > (data_expected_from = dc_item->data_expected_from))
+				data_expected_from = dc_host->data_expected_from;
+
+			delay_s = dc_expand_user_macros_dyn(dc_item->delay, &dc_item->hostid, 1,
+					ZBX_MACRO_ENV_NONSECURE);
+			ret = zbx_interval_preproc(delay_s, &delay, NULL, NULL);
+			zbx_free(delay_s);
+
+			if (SUCCEED != ret)
+				return FAIL;
+			if (data_expected_from + delay > now)
+				return FAIL;
+			break;
+	}
+
+	return SUCCEED;
+}
+
+/* Sorted nextcheck timestamps of overdue items. The snapshot is process local and is used to */
+/* count delayed items without scanning configuration cache on every queue statistics request. */
+static zbx_vector_uint64_t	dc_queue_snapshot;
+static int			dc_queue_snapshot_time = 0;
+
+#define ZBX_QUEUE_SNAPSHOT_TTL	5
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: refreshes delayed item snapshot                                   *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_queue_snapshot_update(int now)
+{
+	zbx_hashset_iter_t	iter;
+	const ZBX_DC_HOST	*dc_host;
+
+	if (0 == dc_queue_snapshot_time)
+		zbx_vector_uint64_create(&dc_queue_snapshot);
+	else
+		zbx_vector_uint64_clear(&dc_queue_snapshot);
+
+	RDLOCK_CACHE;
+
+	zbx_hashset_iter_reset(&config->hosts, &iter);
+
+	while (NULL != (dc_host = (const ZBX_DC_HOST *)zbx_hashset_iter_next(&iter)))
+	{
+		int	i;
+
+		if (HOST_STATUS_MONITORED != dc_host->status)
+			continue;
+
+		for (i = 0; i < dc_host->items.values_num; i++)
 		{
-			if (0 != (update_nextcheck & ZBX_PROXY_CONFIG_NEXTCHECK))
-			{
-				dc_proxy->proxy_config_nextcheck = (int)calculate_proxy_nextcheck(
-						hostid, proxyconfig_frequency, now);
-			}
+			const ZBX_DC_ITEM	*dc_item = dc_host->items.values[i];
 
-			if (0 != (update_nextcheck & ZBX_PROXY_DATA_NEXTCHECK))
-			{
-				dc_proxy->proxy_data_nextcheck = (int)calculate_proxy_nextcheck(
-						hostid, proxydata_frequency, now);
-			}
-			if (0 != (update_nextcheck & ZBX_PROXY_TASKS_NEXTCHECK))
-			{
-				dc_proxy->proxy_tasks_nextcheck = (int)calculate_proxy_nextcheck(
-						hostid, ZBX_TASK_UPDATE_FREQUENCY, now);
-			}
+			/* queue delays are non-negative, items scheduled in future are never counted */
+			if (dc_item->nextcheck > now)
+				continue;
 
-			DCupdate_proxy_queue(dc_proxy);
+			if (SUCCEED != dc_item_queue_check(dc_host, dc_item, now))
+				continue;
+
+			zbx_vector_uint64_append(&dc_queue_snapshot, (zbx_uint64_t)dc_item->nextcheck);
 		}
 	}
 
 	UNLOCK_CACHE;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+	zbx_vector_uint64_sort(&dc_queue_snapshot, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	dc_queue_snapshot_time = now;
 }
 
-/********************************************************************************
- *                                                                              *
- * Purpose: frees the item queue data vector created by zbx_dc_get_item_queue() *
- *                                                                              *
- * Parameters: queue - [IN] the item queue data vector to free                  *
- *                                                                              *
- *******************************************************************************/
-void	zbx_dc_free_item_queue(zbx_vector_ptr_t *queue)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns number of snapshot items with nextcheck not later than    *
+ *          the specified time                                                *
+ *                                                                            *
+ ******************************************************************************/
+static int	dc_queue_snapshot_count(int nextcheck)
 {
-	int	i;
+	int	lo = 0, hi = dc_queue_snapshot.values_num;
 
-	for (i = 0; i < queue->values_num; i++)
-		zbx_free(queue->values[i]);
+	if (0 > nextcheck)
+		return 0;
+
+	while (lo < hi)
+	{
+		int	mid = lo + (hi - lo) / 2;
+
+		if (dc_queue_snapshot.values[mid] <= (zbx_uint64_t)nextcheck)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
 }
 
 /******************************************************************************
@@ -12047,17 +12859,39 @@ void	zbx_dc_free_item_queue(zbx_vector_ptr_t *queue)
  *                                                                            *
  * Return value: the number of delayed items                                  *
  *                                                                            *
+ * Comments: When only the number of delayed items is requested it is         *
+ *           counted from a snapshot of overdue items that is refreshed at    *
+ *           most every ZBX_QUEUE_SNAPSHOT_TTL seconds, so the returned       *
+ *           value can lag behind the configuration cache by that time.       *
+ *                                                                            *
  ******************************************************************************/
 int	zbx_dc_get_item_queue(zbx_vector_ptr_t *queue, int from, int to)
 {
 	zbx_hashset_iter_t	iter;
 	const ZBX_DC_ITEM	*dc_item;
 	const ZBX_DC_HOST	*dc_host;
-	int			now, nitems = 0, data_expected_from, delay;
+	int			now, nitems = 0;
 	zbx_queue_item_t	*queue_item;
 
 	now = (int)time(NULL);
 
+	if (NULL == queue)
+	{
+		if (0 == dc_queue_snapshot_time || ZBX_QUEUE_SNAPSHOT_TTL <= now - dc_queue_snapshot_time ||
+				now < dc_queue_snapshot_time)
+		{
+			dc_queue_snapshot_update(now);
+		}
+
+		nitems = dc_queue_snapshot_count(now - from);
+
+		/* empty range when 'to' does not exceed 'from' */
+		if (ZBX_QUEUE_TO_INFINITY != to)
+			nitems -= MIN(nitems, dc_queue_snapshot_count(now - to));
+
+		return nitems;
+	}
+
 	RDLOCK_CACHE;
 
 	zbx_hashset_iter_reset(&config->hosts, &iter);
@@ -12071,72 +12905,24 @@ int	zbx_dc_get_item_queue(zbx_vector_ptr_t *queue, int from, int to)
 
 		for (i = 0; i < dc_host->items.values_num; i++)
 		{
-			const ZBX_DC_INTERFACE	*dc_interface;
-			char			*delay_s;
-			int			ret;
-
 			dc_item = dc_host->items.values[i];
 
-			if (ITEM_STATUS_ACTIVE != dc_item->status)
-				continue;
-
-			if (SUCCEED != zbx_is_counted_in_item_queue(dc_item->type, dc_item->key))
-				continue;
-
-			if (SUCCEED == DCin_maintenance_without_data_collection(dc_host, dc_item))
+			if (SUCCEED != dc_item_queue_check(dc_host, dc_item, now))
 				continue;
 
-			switch (dc_item->type)
-			{
-				case ITEM_TYPE_ZABBIX:
-				case ITEM_TYPE_SNMP:
-				case ITEM_TYPE_IPMI:
-				case ITEM_TYPE_JMX:
-					if (NULL == (dc_interface = (const ZBX_DC_INTERFACE *)zbx_hashset_search(
-							&config->interfaces, &dc_item->interfaceid)))
-					{
-						continue;
-					}
-
-					if (ZBX_INTERFACE_AVAILABLE_TRUE != dc_interface->available)
-						continue;
-					break;
-				case ITEM_TYPE_ZABBIX_ACTIVE:
-					if (dc_host->data_expected_from >
-						(data_expected_from = dc_item->data_expected_from))
-					{
-						data_expected_from = dc_host->data_expected_from;
-					}
-
-					delay_s = dc_expand_user_macros_dyn(dc_item->delay, &dc_item->hostid, 1,
-							ZBX_MACRO_ENV_NONSECURE);
-					ret = zbx_interval_preproc(delay_s, &delay, NULL, NULL);
-					zbx_free(delay_s);
-
-					if (SUCCEED != ret)
-						continue;
-					if (data_expected_from + delay > now)
-						continue;
-					break;
-
-			}
-
 			if (now - dc_item->nextcheck < from || (ZBX_QUEUE_TO_INFINITY != to &&
 					now - dc_item->nextcheck >= to))
 			{
 				continue;
 			}
 
-			if (NULL != queue)
-			{
-				queue_item = (zbx_queue_item_t *)zbx_malloc(NULL, sizeof(zbx_queue_item_t));
-				queue_item->itemid = dc_item->itemid;
-				queue_item->type = dc_item->type;
-				queue_item->nextcheck = dc_item->nextcheck;
-				queue_item->proxy_hostid = dc_host->proxy_hostid;
+			queue_item = (zbx_queue_item_t *)zbx_malloc(NULL, sizeof(zbx_queue_item_t));
+			queue_item->itemid = dc_item->itemid;
+			queue_item->type = dc_item->type;
+			queue_item->nextcheck = dc_item->nextcheck;
+			queue_item->proxy_hostid = dc_host->proxy_hostid;
 
-				zbx_vector_ptr_append(queue, queue_item);
-			}
+			zbx_vector_ptr_append(queue, queue_item);
 			nitems++;
 		}
 	}
@@ -12146,6 +12932,8 @@ int	zbx_dc_get_item_queue(zbx_vector_ptr_t *queue, int from, int to)
 	return nitems;
 }
 
+#undef ZBX_QUEUE_SNAPSHOT_TTL
+
 
 static void	get_trigger_statistics(zbx_hashset_t *triggers)
 {
@@ -12262,6 +13050,22 @@ static void	get_host_statistics(ZBX_DC_HOST *dc_host, ZBX_DC_PROXY *dc_proxy, in
 	}
 }
 
+#define ZBX_STATUS_LIFETIME	SEC_PER_MIN
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: check if status information stored in configuration cache has     *
+ *          not expired yet                                                   *
+ *                                                                            *
+ ******************************************************************************/
+static int	dc_status_is_actual(void)
+{
+	if (0 != config->status->last_update && config->status->last_update + ZBX_STATUS_LIFETIME > time(NULL))
+		return SUCCEED;
+
+	return FAIL;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: dc_status_update                                                 *
@@ -12284,21 +13088,19 @@ static void	get_host_statistics(ZBX_DC_HOST *dc_host, ZBX_DC_PROXY *dc_proxy, in
  *           Gathered information can then be displayed in the frontend (see  *
  *           "status.get" request) and used in calculation of zabbix[] items. *
  *                                                                            *
- * NOTE: Always call this function before accessing information stored in     *
- *       config->status as well as host and required performance counters     *
- *       stored in elements of config->proxies and item counters in elements  *
- *       of config->hosts.                                                    *
+ * NOTE: Always call this function (see dc_status_lock()) before accessing    *
+ *       information stored in config->status as well as host and required    *
+ *       performance counters stored in elements of config->proxies and item  *
+ *       counters in elements of config->hosts.                               *
  *                                                                            *
  ******************************************************************************/
 static void	dc_status_update(void)
 {
-#define ZBX_STATUS_LIFETIME	SEC_PER_MIN
-
 	zbx_hashset_iter_t	iter;
 	ZBX_DC_HOST		*dc_host;
 	int			reset;
 
-	if (0 != config->status->last_update && config->status->last_update + ZBX_STATUS_LIFETIME > time(NULL))
+	if (SUCCEED == dc_status_is_actual())
 		return;
 
 	if (config->status->sync_ts != config->sync_ts)
@@ -12394,8 +13196,33 @@ static void	dc_status_update(void)
 
 	config->status->sync_ts = config->sync_ts;
 	config->status->last_update = time(NULL);
+}
 
 #undef ZBX_STATUS_LIFETIME
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: lock configuration cache for reading status information           *
+ *                                                                            *
+ * Comments: The status information is updated under write lock only when it  *
+ *           has expired, otherwise the cache is locked for reading so that   *
+ *           frequent status requests do not block each other and the         *
+ *           processes using configuration cache.                             *
+ *           The cache must be unlocked with UNLOCK_CACHE afterwards.         *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_status_lock(void)
+{
+	RDLOCK_CACHE;
+
+	if (SUCCEED == dc_status_is_actual())
+		return;
+
+	UNLOCK_CACHE;
+
+	WRLOCK_CACHE;
+
+	dc_status_update();
 }
 
 /******************************************************************************
@@ -12412,9 +13239,7 @@ zbx_uint64_t	zbx_dc_get_item_count(zbx_uint64_t hostid)
 	zbx_uint64_t		count;
 	const ZBX_DC_HOST	*dc_host;
 
-	WRLOCK_CACHE;
-
-	dc_status_update();
+	dc_status_lock();
 
 	if (0 == hostid)
 		count = config->status->items_active_normal + config->status->items_active_notsupported;
@@ -12442,9 +13267,7 @@ zbx_uint64_t	zbx_dc_get_item_unsupported_count(zbx_uint64_t hostid)
 	zbx_uint64_t		count;
 	const ZBX_DC_HOST	*dc_host;
 
-	WRLOCK_CACHE;
-
-	dc_status_update();
+	dc_status_lock();
 
 	if (0 == hostid)
 		count = config->status->items_active_notsupported;
@@ -12467,9 +13290,7 @@ zbx_uint64_t	zbx_dc_get_trigger_count(void)
 {
 	zbx_uint64_t	count;
 
-	WRLOCK_CACHE;
-
-	dc_status_update();
+	dc_status_lock();
 
 	count = config->status->triggers_enabled_ok + config->status->triggers_enabled_problem;
 
@@ -12487,9 +13308,7 @@ zbx_uint64_t	zbx_dc_get_host_count(void)
 {
 	zbx_uint64_t	nhosts;
 
-	WRLOCK_CACHE;
-
-	dc_status_update();
+	dc_status_lock();
 
 	nhosts = config->status->hosts_monitored;
 
@@ -12507,9 +13326,7 @@ double	zbx_dc_get_required_performance(void)
 {
 	double	nvps;
 
-	WRLOCK_CACHE;
-
-	dc_status_update();
+	dc_status_lock();
 
 	nvps = config->status->required_performance;
 
@@ -12527,9 +13344,7 @@ double	zbx_dc_get_required_performance(void)
  ******************************************************************************/
 void	zbx_dc_get_count_stats_all(zbx_config_cache_info_t *stats)
 {
-	WRLOCK_CACHE;
-
-	dc_status_update();
+	dc_status_lock();
 
 	stats->hosts = config->status->hosts_monitored;
 	stats->items = config->status->items_active_normal + config->status->items_active_notsupported;
@@ -12569,9 +13384,7 @@ void	zbx_dc_get_status(zbx_vector_ptr_t *hosts_monitored, zbx_vector_ptr_t *host
 	const ZBX_DC_PROXY	*dc_proxy;
 	const ZBX_DC_HOST	*dc_proxy_host;
 
-	WRLOCK_CACHE;
-
-	dc_status_update();
+	dc_status_lock();
 
 	proxy_counter_ui64_push(hosts_monitored, 0, config->status->hosts_monitored);
 	proxy_counter_ui64_push(hosts_not_monitored, 0, config->status->hosts_not_monitored);
@@ -12743,8 +13556,7 @@ void	dc_get_hostids_by_functionids(const zbx_uint64_t *functionids, int function
 			zbx_vector_uint64_append(hostids, item->hostid);
 	}
 
-	zbx_vector_uint64_sort(hostids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
-	zbx_vector_uint64_uniq(hostids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_sort_uniq(hostids);
 }
 
 /******************************************************************************
@@ -13513,8 +14325,7 @@ static void	dc_maintenance_precache_nested_groups(void)
 				maintenance->groupids.values_num);
 	}
 
-	zbx_vector_uint64_sort(&groupids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
-	zbx_vector_uint64_uniq(&groupids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_sort_uniq(&groupids);
 
 	for (i = 0; i < groupids.values_num; i++)
 	{
@@ -13580,8 +14391,7 @@ void	zbx_dc_get_nested_hostgroupids(zbx_uint64_t *groupids, int groupids_num, zb
 
 	UNLOCK_CACHE;
 
-	zbx_vector_uint64_sort(nested_groupids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
-	zbx_vector_uint64_uniq(nested_groupids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_sort_uniq(nested_groupids);
 }
 
 /******************************************************************************
@@ -13612,8 +14422,7 @@ void	zbx_dc_get_hostids_by_group_name(const char *name, zbx_vector_uint64_t *hos
 
 	UNLOCK_CACHE;
 
-	zbx_vector_uint64_sort(&groupids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
-	zbx_vector_uint64_uniq(&groupids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_sort_uniq(&groupids);
 
 	RDLOCK_CACHE;
 
@@ -13638,8 +14447,7 @@ void	zbx_dc_get_hostids_by_group_name(const char *name, zbx_vector_uint64_t *hos
 
 	zbx_vector_uint64_destroy(&groupids);
 
-	zbx_vector_uint64_sort(hostids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
-	zbx_vector_uint64_uniq(hostids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_sort_uniq(hostids);
 }
 
 /******************************************************************************
@@ -13903,13 +14711,13 @@ void	zbx_dc_config_items_apply_changes(const zbx_vector_ptr_t *item_diff)
 			continue;
 
 		if (0 != (ZBX_FLAGS_ITEM_DIFF_UPDATE_LASTLOGSIZE & diff->flags))
-			dc_item->lastlogsize = diff->lastlogsize;
+			dc_item->cold->lastlogsize = diff->lastlogsize;
 
 		if (0 != (ZBX_FLAGS_ITEM_DIFF_UPDATE_MTIME & diff->flags))
-			dc_item->mtime = diff->mtime;
+			dc_item->cold->mtime = diff->mtime;
 
 		if (0 != (ZBX_FLAGS_ITEM_DIFF_UPDATE_ERROR & diff->flags))
-			dc_strpool_replace(1, &dc_item->error, diff->error);
+			dc_strpool_replace(1, &dc_item->cold->error, diff->error);
 
 		if (0 != (ZBX_FLAGS_ITEM_DIFF_UPDATE_STATE & diff->flags))
 			dc_item->state = diff->state;
@@ -14502,9 +15310,9 @@ static void	zbx_gather_item_tags(ZBX_DC_ITEM *item, zbx_vector_ptr_t *item_tags)
 	zbx_item_tag_t		*tag;
 	int			i;
 
-	for (i = 0; i < item->tags.values_num; i++)
+	for (i = 0; i < item->cold->tags.values_num; i++)
 	{
-		dc_tag = (zbx_dc_item_tag_t *)item->tags.values[i];
+		dc_tag = (zbx_dc_item_tag_t *)item->cold->tags.values[i];
 		tag = (zbx_item_tag_t *) zbx_malloc(NULL, sizeof(zbx_item_tag_t));
 		tag->tag.tag = zbx_strdup(NULL, dc_tag->tag);
 		tag->tag.value = zbx_strdup(NULL, dc_tag->value);
@@ -14560,8 +15368,8 @@ void	zbx_get_item_tags(zbx_uint64_t itemid, zbx_vector_ptr_t *item_tags)
 
 	zbx_gather_tags_from_host(item->hostid, item_tags);
 
-	if (0 != item->templateid)
-		zbx_gather_tags_from_template_chain(item->templateid, item_tags);
+	if (0 != item->cold->templateid)
+		zbx_gather_tags_from_template_chain(item->cold->templateid, item_tags);
 
 	/* check for discovered item */
 	if (ZBX_FLAG_DISCOVERY_CREATED == item->flags)
@@ -14749,9 +15557,7 @@ int	zbx_proxy_discovery_get(char **data, char **error)
 	zbx_vector_cached_proxy_ptr_t	proxies;
 	struct zbx_json			json;
 
-	WRLOCK_CACHE;
-
-	dc_status_update();
+	dc_status_lock();
 
 	UNLOCK_CACHE;
 
@@ -15045,6 +15851,36 @@ zbx_dc_um_handle_t	*zbx_dc_open_user_macros_masked(void)
 	return dc_open_user_macros(ZBX_MACRO_ENV_NONSECURE);
 }
 
+static zbx_hash_t	dc_um_memo_hash(const void *data)
+{
+	const zbx_dc_um_memo_t	*memo = (const zbx_dc_um_memo_t *)data;
+	zbx_hash_t		hash;
+
+	hash = ZBX_DEFAULT_UINT64_HASH_FUNC(&memo->hostid);
+	hash = ZBX_DEFAULT_HASH_ALGO(memo->macro, memo->macro_len, hash);
+
+	return ZBX_DEFAULT_HASH_ALGO(&memo->env, sizeof(memo->env), hash);
+}
+
+static int	dc_um_memo_compare(const void *d1, const void *d2)
+{
+	const zbx_dc_um_memo_t	*m1 = (const zbx_dc_um_memo_t *)d1;
+	const zbx_dc_um_memo_t	*m2 = (const zbx_dc_um_memo_t *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(m1->hostid, m2->hostid);
+	ZBX_RETURN_IF_NOT_EQUAL(m1->env, m2->env);
+	ZBX_RETURN_IF_NOT_EQUAL(m1->macro_len, m2->macro_len);
+
+	return memcmp(m1->macro, m2->macro, m1->macro_len);
+}
+
+static void	dc_um_memo_clean(void *data)
+{
+	zbx_dc_um_memo_t	*memo = (zbx_dc_um_memo_t *)data;
+
+	zbx_free(memo->macro);
+}
+
 static const zbx_um_cache_t	*dc_um_get_cache(const zbx_dc_um_handle_t *um_handle)
 {
 	if (NULL == *um_handle->cache)
@@ -15053,11 +15889,64 @@ static const zbx_um_cache_t	*dc_um_get_cache(const zbx_dc_um_handle_t *um_handle
 		*um_handle->cache = config->um_cache;
 		config->um_cache->refcount++;
 		UNLOCK_CACHE;
+
+		zbx_hashset_create_ext(&dc_um_memo, 0, dc_um_memo_hash, dc_um_memo_compare, dc_um_memo_clean,
+				ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
 	}
 
 	return *um_handle->cache;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: resolve user macro using the locked user macro cache              *
+ *                                                                            *
+ * Parameters: um_handle   - [IN] the user macro cache handle                 *
+ *             hostids     - [IN] an array of host identifiers                *
+ *             hostids_num - [IN] the number of host identifiers              *
+ *             macro       - [IN] the macro with optional context             *
+ *             macro_len   - [IN] the macro length                            *
+ *             value       - [OUT] the macro value, NULL if macro was not     *
+ *                                 found                                      *
+ *                                                                            *
+ * Comments: Single host lookups are remembered until the user macro cache    *
+ *           is released.                                                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_um_resolve_const(const zbx_dc_um_handle_t *um_handle, const zbx_uint64_t *hostids, int hostids_num,
+		const char *macro, size_t macro_len, const char **value)
+{
+	const zbx_um_cache_t	*um_cache;
+	zbx_dc_um_memo_t	memo_local, *memo;
+
+	um_cache = dc_um_get_cache(um_handle);
+
+	if (1 != hostids_num)
+	{
+		um_cache_resolve_const(um_cache, hostids, hostids_num, macro, um_handle->macro_env, value);
+		return;
+	}
+
+	memo_local.hostid = hostids[0];
+	memo_local.macro = (char *)macro;
+	memo_local.macro_len = macro_len;
+	memo_local.env = um_handle->macro_env;
+
+	if (NULL == (memo = (zbx_dc_um_memo_t *)zbx_hashset_search(&dc_um_memo, &memo_local)))
+	{
+		memo_local.value = NULL;
+		um_cache_resolve_const(um_cache, hostids, hostids_num, macro, um_handle->macro_env, &memo_local.value);
+
+		memo_local.macro = (char *)zbx_malloc(NULL, macro_len + 1);
+		memcpy(memo_local.macro, macro, macro_len);
+		memo_local.macro[macro_len] = '\0';
+
+		memo = (zbx_dc_um_memo_t *)zbx_hashset_insert(&dc_um_memo, &memo_local, sizeof(memo_local));
+	}
+
+	*value = memo->value;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: closes user macro resolving handle                                *
@@ -15075,6 +15964,7 @@ void	zbx_dc_close_user_macros(zbx_dc_um_handle_t *um_handle)
 		UNLOCK_CACHE;
 
 		*um_handle->cache = NULL;
+		zbx_hashset_destroy(&dc_um_memo);
 	}
 
 	dc_um_handle = um_handle->prev;
@@ -15111,6 +16001,12 @@ int	zbx_dc_expand_user_macros(const zbx_dc_um_handle_t *um_handle, char **text,
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() '%s'", __func__, *text);
 
+	if (NULL == strstr(*text, "{$"))
+	{
+		ret = SUCCEED;
+		goto out;
+	}
+
 	for (; SUCCEED == zbx_token_find(*text, pos, &token, ZBX_TOKEN_SEARCH_BASIC); pos++)
 	{
 		const char	*value = NULL;
@@ -15118,8 +16014,8 @@ int	zbx_dc_expand_user_macros(const zbx_dc_um_handle_t *um_handle, char **text,
 		if (ZBX_TOKEN_USER_MACRO != token.type)
 			continue;
 
-		um_cache_resolve_const(dc_um_get_cache(um_handle), hostids, hostids_num, *text + token.loc.l,
-				um_handle->macro_env, &value);
+		dc_um_resolve_const(um_handle, hostids, hostids_num, *text + token.loc.l, token.loc.r - token.loc.l + 1,
+				&value);
 
 		if (NULL == value)
 		{
@@ -15445,6 +16341,9 @@ int	zbx_dc_drule_next(time_t now, zbx_uint64_t *druleid, time_t *nextcheck)
 			zbx_binary_heap_remove_min(&config->drule_queue);
 			*druleid = drule->druleid;
 			drule->location = ZBX_LOC_POLLER;
+			drule->started = now;
+			drule->addresses_num = 0;
+			drule->processed_num = 0;
 			ret = SUCCEED;
 		}
 		else
@@ -15475,12 +16374,90 @@ void	zbx_dc_drule_queue(time_t now, zbx_uint64_t druleid, int delay)
 	{
 		drule->delay = delay;
 		drule->nextcheck = dc_calculate_nextcheck(drule->druleid, drule->delay, now);
+		drule->started = 0;
+		drule->addresses_num = 0;
+		drule->processed_num = 0;
 		dc_drule_queue(drule);
 	}
 
 	UNLOCK_CACHE;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: update progress of the drule being processed                      *
+ *                                                                            *
+ * Parameter: druleid       - [IN] the id of drule being processed            *
+ *            addresses_num - [IN] the total number of addresses to check     *
+ *            processed_num - [IN] the number of already checked addresses    *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dc_drule_update_progress(zbx_uint64_t druleid, int addresses_num, int processed_num)
+{
+	zbx_dc_drule_t	*drule;
+
+	WRLOCK_CACHE;
+
+	if (NULL != (drule = (zbx_dc_drule_t *)zbx_hashset_search(&config->drules, &druleid)) &&
+			ZBX_LOC_POLLER == drule->location)
+	{
+		drule->addresses_num = addresses_num;
+		drule->processed_num = processed_num;
+	}
+
+	UNLOCK_CACHE;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get discovery rule queue and progress statistics                  *
+ *                                                                            *
+ * Parameter: now         - [IN] the current timestamp                        *
+ *            stats       - [OUT] the drules being processed right now        *
+ *                                (zbx_dc_drule_stats_t)                      *
+ *            queued_num  - [OUT] the number of queued drules                 *
+ *            overdue_num - [OUT] the number of queued drules that should     *
+ *                                have been already started                   *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dc_get_drule_stats(time_t now, zbx_vector_ptr_t *stats, int *queued_num, int *overdue_num)
+{
+	zbx_hashset_iter_t	iter;
+	zbx_dc_drule_t		*drule;
+
+	*queued_num = 0;
+	*overdue_num = 0;
+
+	RDLOCK_CACHE;
+
+	zbx_hashset_iter_reset(&config->drules, &iter);
+
+	while (NULL != (drule = (zbx_dc_drule_t *)zbx_hashset_iter_next(&iter)))
+	{
+		zbx_dc_drule_stats_t	*stat;
+
+		switch (drule->location)
+		{
+			case ZBX_LOC_QUEUE:
+				(*queued_num)++;
+
+				if (drule->nextcheck < now)
+					(*overdue_num)++;
+				break;
+			case ZBX_LOC_POLLER:
+				stat = (zbx_dc_drule_stats_t *)zbx_malloc(NULL, sizeof(zbx_dc_drule_stats_t));
+				stat->druleid = drule->druleid;
+				stat->started = drule->started;
+				stat->addresses_num = drule->addresses_num;
+				stat->processed_num = drule->processed_num;
+				zbx_vector_ptr_append(stats, stat);
+				break;
+		}
+	}
+
+	UNLOCK_CACHE;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: get next httptest to be processed                                 *
@@ -15574,6 +16551,60 @@ void	zbx_dc_httptest_queue(time_t now, zbx_uint64_t httptestid, int delay)
 	UNLOCK_CACHE;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get revision of hosts, items, host groups and item/host tags      *
+ *                                                                            *
+ * Return value: The configuration revision when any host, item, host group,  *
+ *               host group membership or tag was last changed.               *
+ *                                                                            *
+ ******************************************************************************/
+zbx_uint64_t	zbx_dc_get_items_revision(void)
+{
+	zbx_uint64_t	revision;
+
+	RDLOCK_CACHE;
+	revision = config->revision.items;
+	UNLOCK_CACHE;
+
+	return revision;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get configuration revision of host                                *
+ *                                                                            *
+ * Parameters: hostid - [IN]                                                  *
+ *                                                                            *
+ * Return value: The highest revision of host, its items and triggers, global *
+ *               regular expressions and user macros available to the host or *
+ *               0 if the host was not found.                                 *
+ *                                                                            *
+ ******************************************************************************/
+zbx_uint64_t	zbx_dc_get_host_config_revision(zbx_uint64_t hostid)
+{
+	const ZBX_DC_HOST	*dc_host;
+	zbx_uint64_t		revision = 0;
+
+	RDLOCK_CACHE;
+
+	if (NULL != (dc_host = (const ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, &hostid)))
+	{
+		revision = MAX(dc_host->revision, config->revision.expression);
+
+		um_cache_get_host_revision(config->um_cache, ZBX_UM_CACHE_GLOBAL_MACRO_HOSTID, &revision);
+		um_cache_get_host_revision(config->um_cache, hostid, &revision);
+
+		/* configuration is not yet fully synced */
+		if (revision > config->revision.config)
+			revision = config->revision.config;
+	}
+
+	UNLOCK_CACHE;
+
+	return revision;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: get the configuration revision received from server               *
@@ -15668,10 +16699,10 @@ void	zbx_dc_get_proxy_config_updates(zbx_uint64_t proxy_hostid, zbx_uint64_t rev
 
 	UNLOCK_CACHE;
 
-	zbx_vector_uint64_sort(hostids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
-	zbx_vector_uint64_sort(updated_hostids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
-	zbx_vector_uint64_sort(removed_hostids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
-	zbx_vector_uint64_sort(httptestids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_sort_asc(hostids);
+	zbx_vector_uint64_sort_asc(updated_hostids);
+	zbx_vector_uint64_sort_asc(removed_hostids);
+	zbx_vector_uint64_sort_asc(httptestids);
 }
 
 void	zbx_dc_get_macro_updates(const zbx_vector_uint64_t *hostids, const zbx_vector_uint64_t *updated_hostids,
@@ -15689,7 +16720,7 @@ void	zbx_dc_get_macro_updates(const zbx_vector_uint64_t *hostids, const zbx_vect
 	if (0 != hostids->values_num)
 	{
 		zbx_vector_uint64_append_array(&hostids_tmp, hostids->values, hostids->values_num);
-		zbx_vector_uint64_setdiff(&hostids_tmp, updated_hostids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_setdiff_asc(&hostids_tmp, updated_hostids);
 	}
 
 	zbx_vector_uint64_create(&globalids);
@@ -15716,10 +16747,10 @@ void	zbx_dc_get_macro_updates(const zbx_vector_uint64_t *hostids, const zbx_vect
 	*global = (0 < globalids.values_num ? SUCCEED : FAIL);
 
 	if (0 != macro_hostids->values_num)
-		zbx_vector_uint64_sort(macro_hostids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_sort_asc(macro_hostids);
 
 	if (0 != del_macro_hostids->values_num)
-		zbx_vector_uint64_sort(del_macro_hostids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_sort_asc(del_macro_hostids);
 
 	zbx_vector_uint64_destroy(&globalids);
 	zbx_vector_uint64_destroy(&hostids_tmp);
@@ -15737,7 +16768,7 @@ void	zbx_dc_get_unused_macro_templates(zbx_hashset_t *templates, const zbx_vecto
 	UNLOCK_CACHE;
 
 	if (0 != templateids->values_num)
-		zbx_vector_uint64_sort(templateids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_sort_asc(templateids);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() templateids_num:%d", __func__, templateids->values_num);
 }
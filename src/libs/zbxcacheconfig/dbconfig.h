@@ -117,40 +117,56 @@ typedef struct
 }
 ZBX_DC_PREPROCITEM;
 
+/* rarely accessed item configuration, allocated separately from the item to keep items compact */
 typedef struct
 {
-	zbx_uint64_t		itemid;
-	zbx_uint64_t		hostid;
-	zbx_uint64_t		interfaceid;
 	zbx_uint64_t		lastlogsize;
 	zbx_uint64_t		valuemapid;
-	const char		*key;
+	zbx_uint64_t		templateid;
 	const char		*port;
 	const char		*error;
-	const char		*delay;
-	const char		*delay_ex;
 	const char		*history_period;
-	ZBX_DC_TRIGGER		**triggers;
-	int			nextcheck;
+	const char		*name;
+	ZBX_DC_PREPROCITEM	*preproc_item;
+	ZBX_DC_MASTERITEM	*master_item;
+	zbx_vector_ptr_t	tags;
 	int			mtime;
+	unsigned char		inventory_link;
+}
+ZBX_DC_ITEM_COLD;
+
+typedef struct
+{
+	/* Fields read by poller queue heaps, zbx_dc_config_get_poller_items() and item queue */
+	/* scans are kept together at the beginning of the structure (64 bytes on 64-bit    */
+	/* platforms), so that scheduling touches as few cache lines per item as possible.  */
+	zbx_uint64_t		itemid;
+	zbx_uint64_t		hostid;
+	zbx_uint64_t		interfaceid;
+	const char		*key;
+	const char		*delay;
+	int			nextcheck;
+	int			schedule_delay;		/* update interval the schedule phase was chosen for */
+	int			schedule_phase;		/* check offset within update interval              */
 	int			data_expected_from;
-	zbx_uint64_t		revision;
 	unsigned char		type;
-	unsigned char		value_type;
 	unsigned char		poller_type;
-	unsigned char		state;
-	unsigned char		db_state;
-	unsigned char		inventory_link;
+	unsigned char		schedule_poller_type;
 	unsigned char		location;
 	unsigned char		flags;
 	unsigned char		status;
+	unsigned char		state;
 	unsigned char		queue_priority;
+
+	/* fields used by history, trigger and preprocessing data paths */
+	zbx_uint64_t		revision;
+	const char		*delay_ex;
+	ZBX_DC_TRIGGER		**triggers;
+	unsigned char		value_type;
+	unsigned char		db_state;
 	unsigned char		update_triggers;
-	zbx_uint64_t		templateid;
-	ZBX_DC_PREPROCITEM	*preproc_item;
-	ZBX_DC_MASTERITEM	*master_item;
 
-	zbx_vector_ptr_t	tags;
+	ZBX_DC_ITEM_COLD	*cold;
 }
 ZBX_DC_ITEM;
 
@@ -190,6 +206,8 @@ typedef struct
 	zbx_uint64_t	itemid;
 	const char	*units;
 	const char	*trends_period;
+	const char	*history_downsample_param;
+	unsigned char	history_downsample;
 }
 ZBX_DC_NUMITEM;
 
@@ -498,6 +516,7 @@ typedef struct
 {
 	const char	*path;
 	zbx_hashset_t	kvs;
+	int		next_refresh;	/* time when secrets must be retrieved from vault again */
 }
 zbx_dc_kvs_path_t;
 
@@ -786,6 +805,7 @@ typedef struct
 	unsigned char		type;
 	unsigned char		tags_evaltype;
 	unsigned char		state;
+	unsigned char		modified;	/* state or configuration was changed during the last update */
 	int			active_since;
 	int			active_until;
 	int			running_since;
@@ -846,6 +866,9 @@ typedef struct
 	unsigned char	status;
 	unsigned char	location;
 	zbx_uint64_t	revision;
+	time_t		started;	/* the time discoverer started processing the rule */
+	int		addresses_num;	/* the number of addresses to check in the current run */
+	int		processed_num;	/* the number of addresses already checked in the current run */
 }
 zbx_dc_drule_t;
 
@@ -894,6 +917,8 @@ typedef struct
 }
 zbx_dc_connector_t;
 
+#define ZBX_DC_SCHEDULE_PERIOD	SEC_PER_HOUR	/* period of item check load histograms */
+
 typedef struct
 {
 	/* timestamp of the last host availability diff sent to sever, used only by proxies */
@@ -990,6 +1015,10 @@ typedef struct
 	zbx_hashset_t		connector_tags;
 	zbx_hashset_t		sessions[ZBX_SESSION_TYPE_COUNT];
 	zbx_binary_heap_t	queues[ZBX_POLLER_TYPE_COUNT];
+	int			inflight_checks[ZBX_POLLER_TYPE_COUNT];	/* items taken by asynchronous */
+									/* pollers                     */
+	/* number of item checks scheduled in each second of schedule period by poller type */
+	int			schedule_load[ZBX_POLLER_TYPE_COUNT][ZBX_DC_SCHEDULE_PERIOD];
 	zbx_binary_heap_t	pqueue;
 	zbx_binary_heap_t	trigger_queue;
 	zbx_binary_heap_t	drule_queue;
@@ -405,6 +405,8 @@ static void	DCdump_interfaces(void)
 static void	DCdump_numitem(const ZBX_DC_NUMITEM *numitem)
 {
 	zabbix_log(LOG_LEVEL_TRACE, "  units:'%s' trends:%s", numitem->units, numitem->trends_period);
+	zabbix_log(LOG_LEVEL_TRACE, "  history_downsample:%u history_downsample_param:'%s'",
+			numitem->history_downsample, numitem->history_downsample_param);
 }
 
 static void	DCdump_snmpitem(const ZBX_DC_SNMPITEM *snmpitem)
@@ -545,7 +547,7 @@ static void	DCdump_item_tags(const ZBX_DC_ITEM *item)
 
 	zbx_vector_ptr_create(&index);
 
-	zbx_vector_ptr_append_array(&index, item->tags.values, item->tags.values_num);
+	zbx_vector_ptr_append_array(&index, item->cold->tags.values, item->cold->tags.values_num);
 	zbx_vector_ptr_sort(&index, ZBX_DEFAULT_UINT64_PTR_COMPARE_FUNC);
 
 	zabbix_log(LOG_LEVEL_TRACE, "  tags:");
@@ -600,16 +602,18 @@ static void	DCdump_items(void)
 		zabbix_log(LOG_LEVEL_TRACE, "itemid:" ZBX_FS_UI64 " hostid:" ZBX_FS_UI64 " key:'%s' revision:" ZBX_FS_UI64,
 				item->itemid, item->hostid, item->key, item->revision);
 		zabbix_log(LOG_LEVEL_TRACE, "  type:%u value_type:%u", item->type, item->value_type);
+		zabbix_log(LOG_LEVEL_TRACE, "  name:'%s'", item->cold->name);
 		zabbix_log(LOG_LEVEL_TRACE, "  interfaceid:" ZBX_FS_UI64, item->interfaceid);
-		zabbix_log(LOG_LEVEL_TRACE, "  state:%u error:'%s'", item->state, item->error);
+		zabbix_log(LOG_LEVEL_TRACE, "  state:%u error:'%s'", item->state, item->cold->error);
 		zabbix_log(LOG_LEVEL_TRACE, "  flags:%u status:%u", item->flags, item->status);
-		zabbix_log(LOG_LEVEL_TRACE, "  valuemapid:" ZBX_FS_UI64, item->valuemapid);
-		zabbix_log(LOG_LEVEL_TRACE, "  lastlogsize:" ZBX_FS_UI64 " mtime:%d", item->lastlogsize, item->mtime);
+		zabbix_log(LOG_LEVEL_TRACE, "  valuemapid:" ZBX_FS_UI64, item->cold->valuemapid);
+		zabbix_log(LOG_LEVEL_TRACE, "  lastlogsize:" ZBX_FS_UI64 " mtime:%d", item->cold->lastlogsize,
+				item->cold->mtime);
 		zabbix_log(LOG_LEVEL_TRACE, "  delay:'%s' nextcheck:%d", item->delay, item->nextcheck);
 		zabbix_log(LOG_LEVEL_TRACE, "  data_expected_from:%d", item->data_expected_from);
-		zabbix_log(LOG_LEVEL_TRACE, "  history:%s", item->history_period);
+		zabbix_log(LOG_LEVEL_TRACE, "  history:%s", item->cold->history_period);
 		zabbix_log(LOG_LEVEL_TRACE, "  poller_type:%u location:%u", item->poller_type, item->location);
-		zabbix_log(LOG_LEVEL_TRACE, "  inventory_link:%u", item->inventory_link);
+		zabbix_log(LOG_LEVEL_TRACE, "  inventory_link:%u", item->cold->inventory_link);
 		zabbix_log(LOG_LEVEL_TRACE, "  priority:%u", item->queue_priority);
 
 		for (j = 0; j < (int)ARRSIZE(trace_items); j++)
@@ -618,13 +622,13 @@ static void	DCdump_items(void)
 				trace_items[j].dump_func(ptr);
 		}
 
-		if (NULL != item->master_item)
-			DCdump_masteritem(item->master_item);
+		if (NULL != item->cold->master_item)
+			DCdump_masteritem(item->cold->master_item);
 
-		if (NULL != item->preproc_item)
-			DCdump_preprocitem(item->preproc_item);
+		if (NULL != item->cold->preproc_item)
+			DCdump_preprocitem(item->cold->preproc_item);
 
-		if (0 != item->tags.values_num)
+		if (0 != item->cold->tags.values_num)
 			DCdump_item_tags(item);
 
 		if (NULL != item->triggers)
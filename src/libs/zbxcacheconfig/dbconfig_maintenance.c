@@ -81,6 +81,7 @@ void	DCsync_maintenances(zbx_dbsync_t *sync)
 		if (0 == found)
 		{
 			maintenance->state = ZBX_MAINTENANCE_IDLE;
+			maintenance->modified = 0;
 			maintenance->running_since = 0;
 			maintenance->running_until = 0;
 
@@ -474,7 +475,7 @@ void	DCsync_maintenance_hosts(zbx_dbsync_t *sync)
 	for (i = 0; i < maintenances.values_num; i++)
 	{
 		maintenance = (zbx_dc_maintenance_t *)maintenances.values[i];
-		zbx_vector_uint64_sort(&maintenance->hostids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_sort_asc(&maintenance->hostids);
 	}
 
 	zbx_vector_ptr_destroy(&maintenances);
@@ -799,6 +800,9 @@ out:
  * Comments: This function calculates if any maintenance period is running    *
  *           and based on that sets current maintenance state - running/idle  *
  *           and period start/end time.                                       *
+ *           Maintenances that were started, stopped or changed their period  *
+ *           are marked as modified. After configuration changes all          *
+ *           maintenances are marked as modified.                             *
  *                                                                            *
  ******************************************************************************/
 int	zbx_dc_update_maintenances(void)
@@ -806,8 +810,9 @@ int	zbx_dc_update_maintenances(void)
 	zbx_dc_maintenance_t		*maintenance;
 	zbx_dc_maintenance_period_t	*period;
 	zbx_hashset_iter_t		iter;
-	int				i, running_num = 0, started_num = 0, stopped_num = 0, ret = FAIL;
-	unsigned char			state;
+	int				i, running_num = 0, started_num = 0, stopped_num = 0, modified_num = 0,
+					ret = FAIL;
+	unsigned char			state, modified = 0;
 	time_t				now, period_start, period_end, running_since, running_until;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
@@ -819,12 +824,14 @@ int	zbx_dc_update_maintenances(void)
 	if (ZBX_MAINTENANCE_UPDATE_TRUE == config->maintenance_update)
 	{
 		ret = SUCCEED;
+		modified = 1;
 		config->maintenance_update = ZBX_MAINTENANCE_UPDATE_FALSE;
 	}
 
 	zbx_hashset_iter_reset(&config->maintenances, &iter);
 	while (NULL != (maintenance = (zbx_dc_maintenance_t *)zbx_hashset_iter_next(&iter)))
 	{
+		maintenance->modified = modified;
 		state = ZBX_MAINTENANCE_IDLE;
 		running_since = 0;
 		running_until = 0;
@@ -870,12 +877,14 @@ int	zbx_dc_update_maintenances(void)
 						dc_hostgroup_cache_nested_groupids(group);
 					}
 				}
+				maintenance->modified = 1;
 				ret = SUCCEED;
 			}
 
 			if (maintenance->running_until != running_until)
 			{
 				maintenance->running_until = running_until;
+				maintenance->modified = 1;
 				ret = SUCCEED;
 			}
 			running_num++;
@@ -887,20 +896,76 @@ int	zbx_dc_update_maintenances(void)
 				maintenance->running_since = 0;
 				maintenance->running_until = 0;
 				maintenance->state = ZBX_MAINTENANCE_IDLE;
+				maintenance->modified = 1;
 				stopped_num++;
 				ret = SUCCEED;
 			}
 		}
+
+		if (0 != maintenance->modified)
+			modified_num++;
 	}
 
 	UNLOCK_CACHE;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() started:%d stopped:%d running:%d", __func__,
-			started_num, stopped_num, running_num);
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() started:%d stopped:%d running:%d modified:%d", __func__,
+			started_num, stopped_num, running_num, modified_num);
 
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: mark all maintenances as modified to force full host and event    *
+ *          maintenance update                                                *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dc_maintenance_set_modified(void)
+{
+	zbx_dc_maintenance_t	*maintenance;
+	zbx_hashset_iter_t	iter;
+
+	WRLOCK_CACHE;
+
+	zbx_hashset_iter_reset(&config->maintenances, &iter);
+	while (NULL != (maintenance = (zbx_dc_maintenance_t *)zbx_hashset_iter_next(&iter)))
+		maintenance->modified = 1;
+
+	UNLOCK_CACHE;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get identifiers of maintenances modified during the last update   *
+ *                                                                            *
+ * Parameters: maintenanceids - [OUT] the modified maintenance identifiers,   *
+ *                                    sorted                                  *
+ *                                                                            *
+ * Return value: SUCCEED - at least one modified maintenance was found        *
+ *               FAIL    - no maintenances were modified                      *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_dc_get_modified_maintenanceids(zbx_vector_uint64_t *maintenanceids)
+{
+	zbx_dc_maintenance_t	*maintenance;
+	zbx_hashset_iter_t	iter;
+
+	RDLOCK_CACHE;
+
+	zbx_hashset_iter_reset(&config->maintenances, &iter);
+	while (NULL != (maintenance = (zbx_dc_maintenance_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (0 != maintenance->modified)
+			zbx_vector_uint64_append(maintenanceids, maintenance->maintenanceid);
+	}
+
+	UNLOCK_CACHE;
+
+	zbx_vector_uint64_sort(maintenanceids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	return (0 != maintenanceids->values_num ? SUCCEED : FAIL);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: assign maintenance to a host, host can only be in one maintenance *
@@ -959,6 +1024,23 @@ static void	dc_assign_event_maintenance_to_host(zbx_hashset_t *host_event_mainte
 	zbx_vector_ptr_append(&host_event_maintenance->maintenances, maintenance);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: collect identifiers of hosts in maintenance                       *
+ *                                                                            *
+ * Parameters: hostids     - [OUT] the host identifiers                       *
+ *             maintenance - [IN] maintenance that host is in (unused)        *
+ *             hostid      - [IN] ID of the host                              *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_assign_maintenance_hostid(zbx_hashset_t *hostids, zbx_dc_maintenance_t *maintenance,
+		zbx_uint64_t hostid)
+{
+	ZBX_UNUSED(maintenance);
+
+	zbx_hashset_insert(hostids, &hostid, sizeof(hostid));
+}
+
 typedef void	(*assign_maintenance_to_host_f)(zbx_hashset_t *host_maintenances,
 		zbx_dc_maintenance_t *maintenance, zbx_uint64_t hostid);
 
@@ -998,8 +1080,7 @@ static void	dc_get_host_maintenances_by_ids(const zbx_vector_uint64_t *maintenan
 			for (j = 0; j < maintenance->groupids.values_num; j++)
 				dc_get_nested_hostgroupids(maintenance->groupids.values[j], &groupids);
 
-			zbx_vector_uint64_sort(&groupids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
-			zbx_vector_uint64_uniq(&groupids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+			zbx_vector_uint64_sort_uniq(&groupids);
 
 			for (j = 0; j < groupids.values_num; j++)
 			{
@@ -1191,6 +1272,42 @@ void	zbx_dc_get_host_maintenance_updates(const zbx_vector_uint64_t *maintenancei
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() updates:%d", __func__, updates->values_num);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get hosts included in the specified maintenances                  *
+ *                                                                            *
+ * Parameters: maintenanceids - [IN] the maintenance identifiers              *
+ *             hostids        - [OUT] the host identifiers, sorted            *
+ *                                                                            *
+ * Comments: Nested groups of the maintenances must be already precached,     *
+ *           which is true for running maintenances.                          *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dc_get_maintenance_hostids(const zbx_vector_uint64_t *maintenanceids, zbx_vector_uint64_t *hostids)
+{
+	zbx_hashset_t		maintenance_hostids;
+	zbx_hashset_iter_t	iter;
+	zbx_uint64_t		*phostid;
+
+	zbx_hashset_create(&maintenance_hostids, 100, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	RDLOCK_CACHE;
+
+	dc_get_host_maintenances_by_ids(maintenanceids, &maintenance_hostids, dc_assign_maintenance_hostid);
+
+	UNLOCK_CACHE;
+
+	zbx_vector_uint64_reserve(hostids, (size_t)maintenance_hostids.num_data);
+
+	zbx_hashset_iter_reset(&maintenance_hostids, &iter);
+	while (NULL != (phostid = (zbx_uint64_t *)zbx_hashset_iter_next(&iter)))
+		zbx_vector_uint64_append(hostids, *phostid);
+
+	zbx_hashset_destroy(&maintenance_hostids);
+
+	zbx_vector_uint64_sort(hostids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: perform maintenance tag comparison using maintenance tag operator *
@@ -1499,8 +1616,7 @@ int	zbx_dc_get_event_maintenances(zbx_vector_ptr_t *event_queries, const zbx_vec
 			zbx_vector_uint64_append(&hostids, item->hostid);
 		}
 
-		zbx_vector_uint64_sort(&hostids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
-		zbx_vector_uint64_uniq(&hostids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_sort_uniq(&hostids);
 
 		/* find matching maintenances */
 		for (j = 0; j < hostids.values_num; j++)
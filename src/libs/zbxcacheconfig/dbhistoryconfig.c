@@ -58,19 +58,19 @@ static void	dc_get_history_sync_item(zbx_history_sync_item_t *dst_item, const ZB
 	dst_item->value_type = src_item->value_type;
 
 	dst_item->state = src_item->state;
-	dst_item->lastlogsize = src_item->lastlogsize;
-	dst_item->mtime = src_item->mtime;
+	dst_item->lastlogsize = src_item->cold->lastlogsize;
+	dst_item->mtime = src_item->cold->mtime;
 
-	if ('\0' != *src_item->error)
-		dst_item->error = zbx_strdup(NULL, src_item->error);
+	if ('\0' != *src_item->cold->error)
+		dst_item->error = zbx_strdup(NULL, src_item->cold->error);
 	else
 		dst_item->error = NULL;
 
-	dst_item->inventory_link = src_item->inventory_link;
-	dst_item->valuemapid = src_item->valuemapid;
+	dst_item->inventory_link = src_item->cold->inventory_link;
+	dst_item->valuemapid = src_item->cold->valuemapid;
 	dst_item->status = src_item->status;
 
-	dst_item->history_period = zbx_strdup(NULL, src_item->history_period);
+	dst_item->history_period = zbx_strdup(NULL, src_item->cold->history_period);
 	dst_item->flags = src_item->flags;
 
 	zbx_strscpy(dst_item->key_orig, src_item->key);
@@ -87,10 +87,21 @@ static void	dc_get_history_sync_item(zbx_history_sync_item_t *dst_item, const ZB
 				dst_item->units = zbx_strdup(NULL, numitem->units);
 			else
 				dst_item->units = NULL;
+
+			if (ITEM_HISTORY_DOWNSAMPLE_NONE != (dst_item->history_downsample =
+					numitem->history_downsample))
+			{
+				dst_item->history_downsample_param = zbx_strdup(NULL,
+						numitem->history_downsample_param);
+			}
+			else
+				dst_item->history_downsample_param = NULL;
 			break;
 		default:
 			dst_item->trends_period = NULL;
 			dst_item->units = NULL;
+			dst_item->history_downsample = ITEM_HISTORY_DOWNSAMPLE_NONE;
+			dst_item->history_downsample_param = NULL;
 	}
 }
 
@@ -131,6 +142,44 @@ static void	dc_items_convert_hk_periods(const zbx_config_hk_t *config_hk, zbx_hi
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: convert item history downsampling parameter to numeric value      *
+ *          expanding user macros                                             *
+ *                                                                            *
+ * Comments: Downsampling is disabled if the parameter is not valid - a       *
+ *           positive period for aggregating modes or non-negative deadband   *
+ *           threshold.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_items_convert_downsample_param(zbx_history_sync_item_t *item)
+{
+	item->history_downsample_period = 0;
+	item->history_downsample_deadband = 0;
+
+	if (NULL == item->history_downsample_param)
+		return;
+
+	zbx_substitute_simple_macros(NULL, NULL, NULL, NULL, &item->host.hostid, NULL, NULL, NULL, NULL, NULL,
+			NULL, NULL, &item->history_downsample_param, MACRO_TYPE_COMMON, NULL, 0);
+
+	if (ITEM_HISTORY_DOWNSAMPLE_DEADBAND == item->history_downsample)
+	{
+		if (SUCCEED == zbx_is_double(item->history_downsample_param, &item->history_downsample_deadband) &&
+				0 <= item->history_downsample_deadband)
+		{
+			return;
+		}
+	}
+	else if (SUCCEED == zbx_is_time_suffix(item->history_downsample_param, &item->history_downsample_period,
+			ZBX_LENGTH_UNLIMITED) && 0 < item->history_downsample_period)
+	{
+		return;
+	}
+
+	item->history_downsample = ITEM_HISTORY_DOWNSAMPLE_NONE;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: Get item with specified ID                                        *
@@ -197,6 +246,7 @@ void	zbx_dc_config_history_sync_get_items_by_itemids(zbx_history_sync_item_t *it
 		items[i].itemid = itemids[i];
 
 		dc_items_convert_hk_periods(&config_hk, &items[i]);
+		dc_items_convert_downsample_param(&items[i]);
 	}
 
 	zbx_dc_close_user_macros(um_handle);
@@ -212,7 +262,10 @@ void	zbx_dc_config_clean_history_sync_items(zbx_history_sync_item_t *items, int
 			continue;
 
 		if (ITEM_VALUE_TYPE_FLOAT == items[i].value_type || ITEM_VALUE_TYPE_UINT64 == items[i].value_type)
+		{
 			zbx_free(items[i].units);
+			zbx_free(items[i].history_downsample_param);
+		}
 
 		zbx_free(items[i].error);
 		zbx_free(items[i].history_period);
@@ -307,6 +360,111 @@ void	zbx_dc_config_history_sync_get_item_tags_by_functionids(const zbx_uint64_t
 	UNLOCK_CACHE_CONFIG_HISTORY;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get item names and tags for real-time export                      *
+ *                                                                            *
+ * Parameters: itemids     - [IN] array of item IDs                           *
+ *             itemids_num - [IN] number of elements                          *
+ *             names       - [OUT] item names, NULL for unknown items         *
+ *             item_tags   - [OUT] item tags, sorted by tag and value         *
+ *                                                                            *
+ * Comments: Only tags of the item itself are returned (not inherited from    *
+ *           host or templates), the same as stored in item_tag table.        *
+ *                                                                            *
+ *           Data is retrieved using history read lock that must be write     *
+ *           locked only when configuration sync occurs to avoid processes    *
+ *           blocking each other.                                             *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dc_config_history_sync_get_items_export_info(const zbx_uint64_t *itemids, size_t itemids_num,
+		char **names, zbx_vector_tags_t **item_tags)
+{
+	const ZBX_DC_ITEM	*dc_item;
+	size_t			i;
+	int			j;
+
+	RDLOCK_CACHE_CONFIG_HISTORY;
+
+	for (i = 0; i < itemids_num; i++)
+	{
+		if (NULL == (dc_item = (const ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &itemids[i])))
+			continue;
+
+		names[i] = zbx_strdup(names[i], dc_item->cold->name);
+
+		for (j = 0; j < dc_item->cold->tags.values_num; j++)
+		{
+			const zbx_dc_item_tag_t	*dc_tag = (const zbx_dc_item_tag_t *)dc_item->cold->tags.values[j];
+			zbx_tag_t		*tag;
+
+			tag = (zbx_tag_t *)zbx_malloc(NULL, sizeof(zbx_tag_t));
+			tag->tag = zbx_strdup(NULL, dc_tag->tag);
+			tag->value = zbx_strdup(NULL, dc_tag->value);
+			zbx_vector_tags_append(item_tags[i], tag);
+		}
+
+		zbx_vector_tags_sort(item_tags[i], zbx_compare_tags);
+	}
+
+	UNLOCK_CACHE_CONFIG_HISTORY;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get names of groups the hosts belong to for real-time export      *
+ *                                                                            *
+ * Parameters: hostids - [IN] sorted host IDs                                 *
+ *             groups  - [OUT] group names, groups[i] for hostids[i]          *
+ *                                                                            *
+ * Comments: The configuration cache does not index groups by host, so all    *
+ *           groups are scanned once, looking for the requested hosts either  *
+ *           in group members or in the requested hosts, whichever is less.   *
+ *                                                                            *
+ *           Data is retrieved using history read lock that must be write     *
+ *           locked only when configuration sync occurs to avoid processes    *
+ *           blocking each other.                                             *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dc_config_history_sync_get_hosts_groups(const zbx_vector_uint64_t *hostids, zbx_vector_ptr_t **groups)
+{
+	zbx_dc_hostgroup_t	*group;
+	zbx_hashset_iter_t	iter;
+	int			i;
+
+	RDLOCK_CACHE_CONFIG_HISTORY;
+
+	zbx_hashset_iter_reset(&config->hostgroups, &iter);
+	while (NULL != (group = (zbx_dc_hostgroup_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (group->hostids.num_data < hostids->values_num)
+		{
+			zbx_hashset_iter_t	host_iter;
+			const zbx_uint64_t	*hostid;
+
+			zbx_hashset_iter_reset(&group->hostids, &host_iter);
+			while (NULL != (hostid = (const zbx_uint64_t *)zbx_hashset_iter_next(&host_iter)))
+			{
+				if (FAIL != (i = zbx_vector_uint64_bsearch(hostids, *hostid,
+						ZBX_DEFAULT_UINT64_COMPARE_FUNC)))
+				{
+					zbx_vector_ptr_append(groups[i], zbx_strdup(NULL, group->name));
+				}
+			}
+		}
+		else
+		{
+			for (i = 0; i < hostids->values_num; i++)
+			{
+				if (NULL != zbx_hashset_search(&group->hostids, &hostids->values[i]))
+					zbx_vector_ptr_append(groups[i], zbx_strdup(NULL, group->name));
+			}
+		}
+	}
+
+	UNLOCK_CACHE_CONFIG_HISTORY;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: get enabled triggers for specified items                          *
@@ -489,6 +647,7 @@ static void	dc_get_history_recv_host(zbx_history_recv_host_t *dst_host, const ZB
 	dst_host->hostid = src_host->hostid;
 	dst_host->proxy_hostid = src_host->proxy_hostid;
 	dst_host->status = src_host->status;
+	dst_host->revision = src_host->revision;
 
 	if (ZBX_ITEM_GET_HOST & mode)
 		zbx_strscpy(dst_host->host, src_host->host);
@@ -940,6 +1099,10 @@ void	zbx_dc_config_history_sync_get_connectors(zbx_hashset_t *connectors, zbx_ha
 			connector->url = zbx_strdup(connector->url, dc_connector->url);
 			connector->max_records = dc_connector->max_records;
 			connector->max_senders = dc_connector->max_senders;
+
+			if (0 == connector->senders_window || connector->senders_window > connector->max_senders)
+				connector->senders_window = connector->max_senders;
+
 			connector->timeout_orig = zbx_strdup(connector->timeout_orig, dc_connector->timeout);
 			connector->timeout = zbx_strdup(connector->timeout, dc_connector->timeout);
 			connector->max_attempts = dc_connector->max_attempts;
@@ -388,49 +388,6 @@ static void	dbsync_prune_changelog(void)
 	zbx_db_free_result(result);
 }
 
-/******************************************************************************
- *                                                                            *
- * Purpose: remove from first vector all ids found in second vector           *
- *                                                                            *
- * Comments: Both vectors must be sorted in ascending order                   *
- *                                                                            *
- ******************************************************************************/
-static void	dbsync_remove_duplicate_ids(zbx_vector_uint64_t *dst, const zbx_vector_uint64_t *src)
-{
-	int	i, j, k;
-
-	for (i = 0, j = 0, k = 0; j < src->values_num && i < dst->values_num;)
-	{
-		if (dst->values[i] == src->values[j])
-		{
-			i++;
-			j++;
-			continue;
-		}
-
-		if (dst->values[i] < src->values[j])
-		{
-			while (i < dst->values_num && dst->values[i] < src->values[j])
-				dst->values[k++] = dst->values[i++];
-		}
-		else
-		{
-			while (j < src->values_num && dst->values[i] > src->values[j])
-				j++;
-		}
-	}
-
-	if (j == src->values_num && i < dst->values_num)
-	{
-		if (k != i)
-			memmove(dst->values + k, dst->values + i, (size_t)(dst->values_num - i) * sizeof(zbx_uint64_t));
-
-		k += dst->values_num - i;
-	}
-
-	dst->values_num = k;
-}
-
 /******************************************************************************
  *                                                                            *
  * Purpose: read changelog and prepare lists of modified objects since last   *
@@ -504,18 +461,17 @@ int	zbx_dbsync_env_prepare(unsigned char mode)
 
 	for (i = 0; i < ARRSIZE(dbsync_env.journals); i++)
 	{
-		zbx_vector_uint64_sort(&dbsync_env.journals[i].inserts, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
-		zbx_vector_uint64_sort(&dbsync_env.journals[i].updates, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
-		zbx_vector_uint64_uniq(&dbsync_env.journals[i].updates, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
-		zbx_vector_uint64_sort(&dbsync_env.journals[i].deletes, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_sort_asc(&dbsync_env.journals[i].inserts);
+		zbx_vector_uint64_sort_uniq(&dbsync_env.journals[i].updates);
+		zbx_vector_uint64_sort_asc(&dbsync_env.journals[i].deletes);
 
 		/* in the case multiple changelog records are registered for the same object          */
 		/* the operation priority is delete, insert, update:                                  */
 		/*   delete - if object is removed any prior changes to it does not matter            */
 		/*   insert - if object was added and then updated, only the insert operation matters */
-		dbsync_remove_duplicate_ids(&dbsync_env.journals[i].inserts, &dbsync_env.journals[i].deletes);
-		dbsync_remove_duplicate_ids(&dbsync_env.journals[i].updates, &dbsync_env.journals[i].deletes);
-		dbsync_remove_duplicate_ids(&dbsync_env.journals[i].updates, &dbsync_env.journals[i].inserts);
+		zbx_vector_uint64_setdiff_asc(&dbsync_env.journals[i].inserts, &dbsync_env.journals[i].deletes);
+		zbx_vector_uint64_setdiff_asc(&dbsync_env.journals[i].updates, &dbsync_env.journals[i].deletes);
+		zbx_vector_uint64_setdiff_asc(&dbsync_env.journals[i].updates, &dbsync_env.journals[i].inserts);
 	}
 
 	return changelog_num;
@@ -637,8 +593,8 @@ static int	dbsync_get_rows(zbx_dbsync_t *sync, char **sql, size_t *sql_alloc, si
 		zbx_db_free_result(result);
 	}
 
-	zbx_vector_uint64_sort(&read_ids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
-	dbsync_remove_duplicate_ids(ids, &read_ids);
+	zbx_vector_uint64_sort_asc(&read_ids);
+	zbx_vector_uint64_setdiff_asc(ids, &read_ids);
 
 	zbx_vector_uint64_destroy(&read_ids);
 
@@ -815,6 +771,21 @@ int	zbx_dbsync_next(zbx_dbsync_t *sync, zbx_uint64_t *rowid, char ***row, unsign
 	return SUCCEED;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get number of rows in changeset                                   *
+ *                                                                            *
+ * Return value: number of rows or -1 if it is not known                      *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_dbsync_get_row_num(const zbx_dbsync_t *sync)
+{
+	if (ZBX_DBSYNC_UPDATE == sync->mode)
+		return sync->rows.values_num;
+
+	return zbx_db_get_row_num(sync->dbresult);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: encode serialized expression to be returned as db field           *
@@ -975,7 +946,7 @@ int	zbx_dbsync_compare_autoreg_host(zbx_dbsync_t *sync)
 	if (ZBX_DBSYNC_INIT != sync->mode)
 		return SUCCEED;
 
-	if (NULL == (sync->dbresult = zbx_db_select(
+	if (NULL == (sync->dbresult = zbx_db_select_stream(
 			"select host,listen_ip,listen_dns,host_metadata,flags,listen_port"
 			" from autoreg_host"
 			" where proxy_hostid is null")))
@@ -1037,7 +1008,7 @@ int	zbx_dbsync_compare_hosts(zbx_dbsync_t *sync)
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
-		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
+		if (NULL == (sync->dbresult = zbx_db_select_stream("%s", sql)))
 			ret = FAIL;
 		goto out;
 	}
@@ -1703,7 +1674,7 @@ static char	**dbsync_item_preproc_row(char **row)
 			zbx_free(error);
 		}
 
-		row[49] = encode_expression(&ctx);
+		row[52] = encode_expression(&ctx);
 		zbx_eval_clear(&ctx);
 	}
 
@@ -1733,18 +1704,19 @@ int	zbx_dbsync_compare_items(zbx_dbsync_t *sync)
 				"i.master_itemid,i.timeout,i.url,i.query_fields,i.posts,i.status_codes,"
 				"i.follow_redirects,i.post_type,i.http_proxy,i.headers,i.retrieve_mode,"
 				"i.request_method,i.output_format,i.ssl_cert_file,i.ssl_key_file,i.ssl_key_password,"
-				"i.verify_peer,i.verify_host,i.allow_traps,i.templateid,null"
+				"i.verify_peer,i.verify_host,i.allow_traps,i.templateid,i.history_downsample,"
+				"i.history_downsample_param,i.name,null"
 			" from items i"
 			" inner join hosts h on i.hostid=h.hostid"
 			" join item_rtdata ir on i.itemid=ir.itemid"
 			" where h.status in (%d,%d) and i.flags<>%d",
 			HOST_STATUS_MONITORED, HOST_STATUS_NOT_MONITORED, ZBX_FLAG_DISCOVERY_PROTOTYPE);
 
-	dbsync_prepare(sync, 50, dbsync_item_preproc_row);
+	dbsync_prepare(sync, 53, dbsync_item_preproc_row);
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
-		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
+		if (NULL == (sync->dbresult = zbx_db_select_stream("%s", sql)))
 			ret = FAIL;
 		goto out;
 	}
@@ -1764,14 +1736,52 @@ static int	dbsync_compare_item_discovery(const ZBX_DC_ITEM_DISCOVERY *item_disco
 
 /******************************************************************************
  *                                                                            *
- * Purpose: compares mapping between items, prototypes and rules with         *
- *          configuration cache                                               *
+ * Purpose: get identifiers of items changed since last sync                  *
+ *                                                                            *
+ * Parameters: itemids - [OUT] identifiers of inserted, updated and removed   *
+ *                             items                                          *
+ *                                                                            *
+ * Return value: SUCCEED - the identifiers were obtained from changelog       *
+ *               FAIL    - items were not synced from changelog               *
+ *                                                                            *
+ * Comments: Items journal is consumed by items and item prototypes syncs, so *
+ *           the identifiers read by those syncs are taken from their rows.   *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbsync_get_changed_itemids(zbx_vector_uint64_t *itemids)
+{
+	zbx_dbsync_journal_t	*journal = &dbsync_env.journals[ZBX_DBSYNC_JOURNAL(ZBX_DBSYNC_OBJ_ITEM)];
+	int			i, j;
+
+	if (0 == journal->syncs.values_num)
+		return FAIL;
+
+	for (j = 0; j < journal->syncs.values_num; j++)
+	{
+		zbx_dbsync_t	*sync = journal->syncs.values[j];
+
+		for (i = 0; i < sync->rows.values_num; i++)
+			zbx_vector_uint64_append(itemids, ((zbx_dbsync_row_t *)sync->rows.values[i])->rowid);
+	}
+
+	zbx_vector_uint64_append_array(itemids, journal->inserts.values, journal->inserts.values_num);
+	zbx_vector_uint64_append_array(itemids, journal->updates.values, journal->updates.values_num);
+	zbx_vector_uint64_append_array(itemids, journal->deletes.values, journal->deletes.values_num);
+
+	zbx_vector_uint64_sort_uniq(itemids);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compares whole item discovery table with configuration cache      *
  *                                                                            *
  * Return value: SUCCEED - the changeset was successfully calculated          *
  *               FAIL    - otherwise                                          *
  *                                                                            *
  ******************************************************************************/
-int	zbx_dbsync_compare_item_discovery(zbx_dbsync_t *sync)
+static int	dbsync_compare_item_discovery_all(zbx_dbsync_t *sync)
 {
 	zbx_db_row_t		dbrow;
 	zbx_db_result_t		result;
@@ -1784,14 +1794,6 @@ int	zbx_dbsync_compare_item_discovery(zbx_dbsync_t *sync)
 	if (NULL == (result = zbx_db_select("select itemid,parent_itemid from item_discovery")))
 		return FAIL;
 
-	dbsync_prepare(sync, 2, NULL);
-
-	if (ZBX_DBSYNC_INIT == sync->mode)
-	{
-		sync->dbresult = result;
-		return SUCCEED;
-	}
-
 	zbx_hashset_create(&ids, (size_t)dbsync_env.cache->item_discovery.num_data, ZBX_DEFAULT_UINT64_HASH_FUNC,
 			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 
@@ -1829,6 +1831,109 @@ int	zbx_dbsync_compare_item_discovery(zbx_dbsync_t *sync)
 	return SUCCEED;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compares mapping between items, prototypes and rules with         *
+ *          configuration cache                                               *
+ *                                                                            *
+ * Return value: SUCCEED - the changeset was successfully calculated          *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Item discovery records are created and removed together with     *
+ *           their items and parent item never changes, so during update only *
+ *           the records of items found in changelog are compared. Must be    *
+ *           called after items and item prototypes are compared. Whole table *
+ *           is compared if items were not synced from changelog.             *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_dbsync_compare_item_discovery(zbx_dbsync_t *sync)
+{
+	zbx_db_row_t		dbrow;
+	zbx_db_result_t		result;
+	zbx_hashset_t		ids;
+	zbx_uint64_t		rowid, *batch;
+	ZBX_DC_ITEM_DISCOVERY	*item_discovery;
+	char			**row, *sql = NULL;
+	size_t			sql_alloc = 0, sql_offset = 0;
+	int			i, batch_size, ret = SUCCEED;
+	zbx_vector_uint64_t	itemids;
+
+	dbsync_prepare(sync, 2, NULL);
+
+	if (ZBX_DBSYNC_INIT == sync->mode)
+	{
+		if (NULL == (sync->dbresult = zbx_db_select_stream("select itemid,parent_itemid from item_discovery")))
+			return FAIL;
+
+		return SUCCEED;
+	}
+
+	zbx_vector_uint64_create(&itemids);
+
+	if (SUCCEED != dbsync_get_changed_itemids(&itemids))
+	{
+		zbx_vector_uint64_destroy(&itemids);
+
+		return dbsync_compare_item_discovery_all(sync);
+	}
+
+	zbx_hashset_create(&ids, (size_t)itemids.values_num, ZBX_DEFAULT_UINT64_HASH_FUNC,
+			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	for (batch = itemids.values; batch < itemids.values + itemids.values_num; batch += ZBX_DBSYNC_BATCH_SIZE)
+	{
+		batch_size = MIN(ZBX_DBSYNC_BATCH_SIZE, itemids.values + itemids.values_num - batch);
+
+		sql_offset = 0;
+		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, "select itemid,parent_itemid from item_discovery where");
+		zbx_db_add_condition_alloc(&sql, &sql_alloc, &sql_offset, "itemid", batch, batch_size);
+
+		if (NULL == (result = zbx_db_select("%s", sql)))
+		{
+			ret = FAIL;
+			goto out;
+		}
+
+		while (NULL != (dbrow = zbx_db_fetch(result)))
+		{
+			unsigned char	tag = ZBX_DBSYNC_ROW_NONE;
+
+			ZBX_STR2UINT64(rowid, dbrow[0]);
+			zbx_hashset_insert(&ids, &rowid, sizeof(rowid));
+
+			row = dbsync_preproc_row(sync, dbrow);
+
+			if (NULL == (item_discovery = (ZBX_DC_ITEM_DISCOVERY *)zbx_hashset_search(
+					&dbsync_env.cache->item_discovery, &rowid)))
+			{
+				tag = ZBX_DBSYNC_ROW_ADD;
+			}
+			else if (FAIL == dbsync_compare_item_discovery(item_discovery, row))
+				tag = ZBX_DBSYNC_ROW_UPDATE;
+
+			if (ZBX_DBSYNC_ROW_NONE != tag)
+				dbsync_add_row(sync, rowid, tag, row);
+		}
+
+		zbx_db_free_result(result);
+	}
+
+	for (i = 0; i < itemids.values_num; i++)
+	{
+		if (NULL != zbx_hashset_search(&ids, &itemids.values[i]))
+			continue;
+
+		if (NULL != zbx_hashset_search(&dbsync_env.cache->item_discovery, &itemids.values[i]))
+			dbsync_add_row(sync, itemids.values[i], ZBX_DBSYNC_ROW_REMOVE, NULL);
+	}
+out:
+	zbx_free(sql);
+	zbx_hashset_destroy(&ids);
+	zbx_vector_uint64_destroy(&itemids);
+
+	return ret;
+}
+
 static int	dbsync_compare_template_item(const ZBX_DC_TEMPLATE_ITEM *item, const zbx_db_row_t dbrow)
 {
 	if (FAIL == dbsync_compare_uint64(dbrow[1], item->hostid))
@@ -1932,7 +2037,7 @@ int	zbx_dbsync_compare_prototype_items(zbx_dbsync_t *sync)
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
-		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
+		if (NULL == (sync->dbresult = zbx_db_select_stream("%s", sql)))
 			ret = FAIL;
 		goto out;
 	}
@@ -2044,7 +2149,7 @@ int	zbx_dbsync_compare_triggers(zbx_dbsync_t *sync)
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
-		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
+		if (NULL == (sync->dbresult = zbx_db_select_stream("%s", sql)))
 			ret = FAIL;
 		goto out;
 	}
@@ -2183,7 +2288,7 @@ int	zbx_dbsync_compare_functions(zbx_dbsync_t *sync)
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
-		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
+		if (NULL == (sync->dbresult = zbx_db_select_stream("%s", sql)))
 			ret = FAIL;
 		goto out;
 	}
@@ -2612,7 +2717,7 @@ int	zbx_dbsync_compare_trigger_tags(zbx_dbsync_t *sync)
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
-		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
+		if (NULL == (sync->dbresult = zbx_db_select_stream("%s", sql)))
 			ret = FAIL;
 		goto out;
 	}
@@ -2647,7 +2752,7 @@ int	zbx_dbsync_compare_item_tags(zbx_dbsync_t *sync)
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
-		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
+		if (NULL == (sync->dbresult = zbx_db_select_stream("%s", sql)))
 			ret = FAIL;
 		goto out;
 	}
@@ -2682,7 +2787,7 @@ int	zbx_dbsync_compare_host_tags(zbx_dbsync_t *sync)
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
-		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
+		if (NULL == (sync->dbresult = zbx_db_select_stream("%s", sql)))
 			ret = FAIL;
 		goto out;
 	}
@@ -2793,7 +2898,7 @@ int	zbx_dbsync_compare_correlations(zbx_dbsync_t *sync)
 
 /******************************************************************************
  *                                                                            *
- * Purpose: compares correlation condition tables dbrow with cached             *
+ * Purpose: compares correlation condition tables dbrow with cached           *
  *          configuration data                                                *
  *                                                                            *
  * Parameter: corr_condition - [IN] the cached correlation condition          *
@@ -2929,7 +3034,7 @@ int	zbx_dbsync_compare_corr_conditions(zbx_dbsync_t *sync)
 
 /******************************************************************************
  *                                                                            *
- * Purpose: compares correlation operation tables dbrow with cached             *
+ * Purpose: compares correlation operation tables dbrow with cached           *
  *          configuration data                                                *
  *                                                                            *
  * Parameter: corr_operation - [IN] the cached correlation operation          *
@@ -3128,7 +3233,7 @@ int	zbx_dbsync_compare_item_preprocs(zbx_dbsync_t *sync)
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
-		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
+		if (NULL == (sync->dbresult = zbx_db_select_stream("%s", sql)))
 			ret = FAIL;
 		goto out;
 	}
@@ -3807,7 +3912,7 @@ int	zbx_dbsync_prepare_drules(zbx_dbsync_t *sync)
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
-		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
+		if (NULL == (sync->dbresult = zbx_db_select_stream("%s", sql)))
 			ret = FAIL;
 		goto out;
 	}
@@ -3842,7 +3947,7 @@ int	zbx_dbsync_prepare_dchecks(zbx_dbsync_t *sync)
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
-		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
+		if (NULL == (sync->dbresult = zbx_db_select_stream("%s", sql)))
 			ret = FAIL;
 		goto out;
 	}
@@ -3877,7 +3982,7 @@ int	zbx_dbsync_prepare_httptests(zbx_dbsync_t *sync)
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
-		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
+		if (NULL == (sync->dbresult = zbx_db_select_stream("%s", sql)))
 			ret = FAIL;
 		goto out;
 	}
@@ -3912,7 +4017,7 @@ int	zbx_dbsync_prepare_httptest_fields(zbx_dbsync_t *sync)
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
-		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
+		if (NULL == (sync->dbresult = zbx_db_select_stream("%s", sql)))
 			ret = FAIL;
 		goto out;
 	}
@@ -3946,7 +4051,7 @@ int	zbx_dbsync_prepare_httpsteps(zbx_dbsync_t *sync)
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
-		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
+		if (NULL == (sync->dbresult = zbx_db_select_stream("%s", sql)))
 			ret = FAIL;
 		goto out;
 	}
@@ -3980,7 +4085,7 @@ int	zbx_dbsync_prepare_httpstep_fields(zbx_dbsync_t *sync)
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
-		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
+		if (NULL == (sync->dbresult = zbx_db_select_stream("%s", sql)))
 			ret = FAIL;
 		goto out;
 	}
@@ -4019,7 +4124,7 @@ int	zbx_dbsync_compare_connectors(zbx_dbsync_t *sync)
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
-		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
+		if (NULL == (sync->dbresult = zbx_db_select_stream("%s", sql)))
 			ret = FAIL;
 		goto out;
 	}
@@ -4046,7 +4151,7 @@ int	zbx_dbsync_compare_connector_tags(zbx_dbsync_t *sync)
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
-		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
+		if (NULL == (sync->dbresult = zbx_db_select_stream("%s", sql)))
 			ret = FAIL;
 		goto out;
 	}
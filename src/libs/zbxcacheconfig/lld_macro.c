@@ -70,11 +70,12 @@ int	zbx_lld_macro_paths_get(zbx_uint64_t lld_ruleid, zbx_vector_ptr_t *lld_macro
 			break;
 		}
 
-		zbx_jsonpath_clear(&path);
-
+		/* keep the compiled path for queries of all discovered rows */
 		lld_macro_path = (zbx_lld_macro_path_t *)zbx_malloc(NULL, sizeof(zbx_lld_macro_path_t));
 		lld_macro_path->lld_macro = zbx_strdup(NULL, row[0]);
 		lld_macro_path->path = zbx_strdup(NULL, row[1]);
+		lld_macro_path->jsonpath = (zbx_jsonpath_t *)zbx_malloc(NULL, sizeof(zbx_jsonpath_t));
+		*lld_macro_path->jsonpath = path;
 
 		zbx_vector_ptr_append(lld_macro_paths, lld_macro_path);
 	}
@@ -96,6 +97,12 @@ int	zbx_lld_macro_paths_get(zbx_uint64_t lld_ruleid, zbx_vector_ptr_t *lld_macro
  ******************************************************************************/
 void	zbx_lld_macro_path_free(zbx_lld_macro_path_t *lld_macro_path)
 {
+	if (NULL != lld_macro_path->jsonpath)
+	{
+		zbx_jsonpath_clear(lld_macro_path->jsonpath);
+		zbx_free(lld_macro_path->jsonpath);
+	}
+
 	zbx_free(lld_macro_path->path);
 	zbx_free(lld_macro_path->lld_macro);
 	zbx_free(lld_macro_path);
@@ -116,7 +123,7 @@ int	zbx_lld_macro_value_by_name(const struct zbx_json_parse *jp_row, const zbx_v
 		const char *macro, char **value)
 {
 	zbx_lld_macro_path_t	lld_macro_path_local, *lld_macro_path;
-	int			index;
+	int			index, ret;
 	size_t			value_alloc = 0;
 	zbx_json_type_t		type;
 
@@ -127,7 +134,12 @@ int	zbx_lld_macro_value_by_name(const struct zbx_json_parse *jp_row, const zbx_v
 	{
 		lld_macro_path = (zbx_lld_macro_path_t *)lld_macro_paths->values[index];
 
-		if (SUCCEED == zbx_jsonpath_query(jp_row, lld_macro_path->path, value) && NULL != *value)
+		if (NULL != lld_macro_path->jsonpath)
+			ret = zbx_jsonpath_query_ext(jp_row, lld_macro_path->jsonpath, value);
+		else
+			ret = zbx_jsonpath_query(jp_row, lld_macro_path->path, value);
+
+		if (SUCCEED == ret && NULL != *value)
 			return SUCCEED;
 
 		return FAIL;
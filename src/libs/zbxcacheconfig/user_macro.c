@@ -494,6 +494,7 @@ static void	um_macro_register_kvs(zbx_um_macro_t *macro, const char *location,
 	{
 		kvs_path = (zbx_dc_kvs_path_t *)__config_shmem_malloc_func(NULL, sizeof(zbx_dc_kvs_path_t));
 		kvs_path->path = dc_strpool_intern(path);
+		kvs_path->next_refresh = 0;
 		zbx_hashset_create_ext(&kvs_path->kvs, 0, dc_kv_hash, dc_kv_compare, NULL,
 				__config_shmem_malloc_func, __config_shmem_realloc_func, __config_shmem_free_func);
 
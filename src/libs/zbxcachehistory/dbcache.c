@@ -19,6 +19,8 @@
 
 #include "zbxcachehistory.h"
 #include "zbxcachevalue.h"
+#include "proxy_buffer.h"
+#include "history_modules.h"
 
 #include "log.h"
 #include "zbxmutexs.h"
@@ -38,13 +40,25 @@
 #include "zbxpreproc.h"
 #include "zbxtagfilter.h"
 #include "zbxcrypto.h"
+#include "zbxprof.h"
+#include "zbxcompress.h"
 
+#if ZBX_HC_SHARDS_MAX != ZBX_MUTEX_CACHE_SHARDS_NUM + 1
+#	error "the number of history cache shards does not match the number of shard mutexes"
+#endif
+
+/* history cache memory of the currently locked shard */
 static zbx_shmem_info_t	*hc_index_mem = NULL;
 static zbx_shmem_info_t	*hc_mem = NULL;
 static zbx_shmem_info_t	*trend_mem = NULL;
 
-#define	LOCK_CACHE	zbx_mutex_lock(cache_lock)
-#define	UNLOCK_CACHE	zbx_mutex_unlock(cache_lock)
+static zbx_shmem_info_t	*hc_shard_index_mem[ZBX_HC_SHARDS_MAX];
+static zbx_shmem_info_t	*hc_shard_mem[ZBX_HC_SHARDS_MAX];
+static zbx_mutex_t	hc_shard_lock[ZBX_HC_SHARDS_MAX];
+
+/* the first shard lock also protects the history cache data not bound to any shard */
+#define	LOCK_CACHE	hc_lock_shard(0)
+#define	UNLOCK_CACHE	hc_unlock_shard()
 #define	LOCK_TRENDS	zbx_mutex_lock(trends_lock)
 #define	UNLOCK_TRENDS	zbx_mutex_unlock(trends_lock)
 #define	LOCK_CACHE_IDS		zbx_mutex_lock(cache_ids_lock)
@@ -63,19 +77,60 @@ static zbx_get_program_type_f	get_program_type_cb = NULL;
 
 #define ZBX_HC_ITEMS_INIT_SIZE	1000
 
+/* Short string values (including terminating zero) are stored in history cache */
+/* string pool and shared between history values with the same contents.       */
+#define ZBX_HC_STRPOOL_STR_MAX		256
+#define ZBX_HC_STRPOOL_REFCOUNT_SIZE	sizeof(zbx_uint32_t)
+
+/* Text and log values (including terminating zero) of this size and larger are */
+/* compressed before storing them in history cache if compression is available. */
+#define ZBX_HC_COMPRESS_LEN_MIN		(2 * ZBX_KIBIBYTE)
+
+#if defined(HAVE_LZ4)
+#	define ZBX_HC_COMPRESS_CODEC	ZBX_COMPRESS_LZ4
+#elif defined(HAVE_ZLIB)
+#	define ZBX_HC_COMPRESS_CODEC	ZBX_COMPRESS_ZLIB
+#endif
+
 #define ZBX_TRENDS_CLEANUP_TIME	(SEC_PER_MIN * 55)
 
 /* the maximum time spent synchronizing history */
 #define ZBX_HC_SYNC_TIME_MAX	10
 
-/* the maximum number of items in one synchronization batch */
+/* the initial number of items in one synchronization batch */
 #define ZBX_HC_SYNC_MAX		1000
 #define ZBX_HC_TIMER_MAX	(ZBX_HC_SYNC_MAX / 2)
 #define ZBX_HC_TIMER_SOFT_MAX	(ZBX_HC_TIMER_MAX - 10)
 
+/* the limits of synchronization batch size adjusted by history syncer */
+#define ZBX_HC_SYNC_BATCH_MIN	(ZBX_HC_SYNC_MAX / 10)
+#define ZBX_HC_SYNC_BATCH_MAX	(ZBX_HC_SYNC_MAX * 4)
+
+/* the target time of processing one synchronization batch, in seconds */
+#define ZBX_HC_SYNC_BATCH_TIME	0.5
+
+/* the maximum number of triggers recalculated by new values per item of synchronization batch */
+#define ZBX_HC_SYNC_TRIGGERS_PER_ITEM	2
+
+/* the interval of adjusting the number of active history syncers, in seconds */
+#define ZBX_HC_SCALE_INTERVAL		10
+
+/* history cache usage (%) and its growth rate (% per second) above which a history syncer is activated */
+#define ZBX_HC_SCALE_UP_PUSED		20
+#define ZBX_HC_SCALE_UP_RATE		0.5
+
+/* history cache usage (%) below which a history syncer is parked unless the usage grows */
+#define ZBX_HC_SCALE_DOWN_PUSED		5
+
 /* the minimum processed item percentage of item candidates to continue synchronizing */
 #define ZBX_HC_SYNC_MIN_PCNT	10
 
+/* the interval of writing downsampled values of items that stopped receiving values, in seconds */
+#define ZBX_HC_DOWNSAMPLE_FLUSH_INTERVAL	SEC_PER_MIN
+
+/* the time after which downsampling state of item without new values is removed, in seconds */
+#define ZBX_HC_DOWNSAMPLE_STATE_TTL		SEC_PER_DAY
+
 /* the maximum number of characters for history cache values */
 #define ZBX_HISTORY_VALUE_LEN	(1024 * 64)
 
@@ -110,17 +165,56 @@ typedef struct
 }
 zbx_hc_proxyqueue_t;
 
+/* item history downsampling state */
+typedef struct
+{
+	zbx_uint64_t		itemid;
+	zbx_history_value_t	value;		/* min/max/last value of period or the last stored value */
+	zbx_value_avg_t		sum;		/* average value of period */
+	int			period_start;	/* start of the aggregated (or the last written) period */
+	int			period;
+	int			count;		/* number of aggregated values, 0 - period was written */
+	int			lastupdate;
+	int			ttl;
+	unsigned char		value_type;
+	unsigned char		mode;
+}
+zbx_hc_downsample_t;
+
+/* history cache shard, items are assigned to shards by itemid */
 typedef struct
 {
-	zbx_hashset_t		trends;
 	zbx_dc_stats_t		stats;
 
 	zbx_hashset_t		history_items;
 	zbx_binary_heap_t	history_queue;
 
+	/* item downsampling states, used only by server */
+	zbx_hashset_t		downsample;
+
+	/* reference counted short string values, allocated in shard data memory */
+	zbx_hashset_t		strpool;
+
 	int			history_num;
+}
+zbx_hc_shard_t;
+
+typedef struct
+{
+	zbx_hashset_t		trends;
+
+	zbx_hc_shard_t		shards[ZBX_HC_SHARDS_MAX];
+	int			shards_num;
+
 	int			trends_num;
 	int			trends_last_cleanup_hour;
+
+	/* completed trends passed by history syncers to trend writer, allocated in trend cache */
+	ZBX_DC_TREND		*trends_queue;
+	int			trends_queue_num;
+	int			trends_queue_alloc;
+	int			trend_writers_num;
+
 	int			history_num_total;
 	int			history_progress_ts;
 
@@ -128,11 +222,63 @@ typedef struct
 
 	zbx_hc_proxyqueue_t	proxyqueue;
 	int			proxy_history_count;
+
+	/* the number of history syncers allowed to sync, 0 - all syncers, updated by the first syncer */
+	int			syncers_active;
 }
 ZBX_DC_CACHE;
 
 static ZBX_DC_CACHE	*cache = NULL;
 
+/* the currently locked history cache shard */
+static zbx_hc_shard_t	*hc_shard = NULL;
+
+/* the history cache shards owned by history syncer are hc_sync_shard_home + N * hc_sync_shard_step */
+static int		hc_sync_shard_home = 0, hc_sync_shard_step = 0, hc_sync_shard = 0;
+
+/* the history syncer number and the number of syncers the shards were assigned for */
+static int		hc_syncer_num = 0, hc_syncers_num = 0;
+
+/* the synchronization batch size of the current history syncer */
+static int		hc_sync_batch = ZBX_HC_SYNC_MAX;
+
+/* history ingestion ring */
+typedef struct
+{
+	zbx_uint64_t	head;		/* write position, updated only by the ring owner */
+	zbx_uint64_t	tail;		/* read position, updated only by consumers under ingest lock */
+	zbx_uint64_t	overflows;	/* the number of flushes bypassing the ring */
+	pid_t		pid;		/* the ring owner process, 0 - ring is not used */
+	char		*data;
+}
+zbx_hc_ring_t;
+
+typedef struct
+{
+	zbx_hc_ring_t	*rings;
+	int		rings_num;
+	zbx_uint64_t	ring_size;
+}
+zbx_hc_ingest_t;
+
+/* the ingestion ring chunk header, followed by item values and their string data */
+typedef struct
+{
+	zbx_uint32_t	size;		/* the chunk size including header */
+	zbx_uint32_t	values_num;	/* the number of values, 0 - padding up to ring end */
+}
+zbx_hc_ring_chunk_t;
+
+#define ZBX_HC_RING_ALIGN(size)	(((size) + 7) & ~(size_t)7)
+
+static zbx_shmem_info_t	*hc_ring_mem = NULL;
+static zbx_mutex_t	ingest_lock = ZBX_MUTEX_NULL;
+static zbx_hc_ingest_t	*hc_ingest = NULL;
+
+/* the ingestion ring owned by the current process */
+static zbx_hc_ring_t	*hc_ring = NULL;
+static pid_t		hc_ring_pid = 0;
+
 /* local history cache */
 #define ZBX_MAX_VALUES_LOCAL	256
 #define ZBX_STRUCT_REALLOC_STEP	8
@@ -142,9 +288,18 @@ typedef struct
 {
 	size_t	pvalue;
 	size_t	len;
+	size_t	size;	/* compressed data size, 0 if the string is not compressed */
 }
 dc_value_str_t;
 
+/* header of compressed string value stored in history cache */
+typedef struct
+{
+	zbx_uint32_t	len;	/* uncompressed string length including terminating zero */
+	zbx_uint32_t	size;	/* compressed data size */
+}
+zbx_hc_str_compressed_t;
+
 typedef struct
 {
 	double		value_dbl;
@@ -176,7 +331,7 @@ static size_t		string_values_alloc = 0, string_values_offset = 0;
 static dc_item_value_t	*item_values = NULL;
 static size_t		item_values_alloc = 0, item_values_num = 0;
 
-static void	hc_add_item_values(dc_item_value_t *values, int values_num);
+static int	hc_add_item_values(dc_item_value_t *values, int values_num, const char *strings, int wait);
 static void	hc_pop_items(zbx_vector_ptr_t *history_items);
 static void	hc_get_item_values(zbx_dc_history_t *history, zbx_vector_ptr_t *history_items);
 static void	hc_push_items(zbx_vector_ptr_t *history_items);
@@ -185,6 +340,236 @@ static void	hc_queue_item(zbx_hc_item_t *item);
 static int	hc_queue_elem_compare_func(const void *d1, const void *d2);
 static int	hc_queue_get_size(void);
 static int	hc_get_history_compression_age(void);
+static int	hc_get_history_num(void);
+static void	hc_ingest_get_stats(zbx_wcache_info_t *wcache_info);
+static void	hc_ingest_sync(void);
+static int	hc_ingest_pending(void);
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: selects history cache shard memory and data without locking it    *
+ *                                                                            *
+ * Parameters: index - [IN] the shard index                                   *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_select_shard(int index)
+{
+	hc_mem = hc_shard_mem[index];
+	hc_index_mem = hc_shard_index_mem[index];
+	hc_shard = &cache->shards[index];
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: locks history cache shard                                         *
+ *                                                                            *
+ * Parameters: index - [IN] the shard index                                   *
+ *                                                                            *
+ * Comments: Only one shard can be locked at a time by a process. The shard   *
+ *           shared memory allocators (__hc_*) are switched to the shard      *
+ *           memory segments while it is locked.                              *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_lock_shard(int index)
+{
+	zbx_mutex_lock(hc_shard_lock[index]);
+	hc_select_shard(index);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: unlocks the currently locked history cache shard                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_unlock_shard(void)
+{
+	zbx_mutex_unlock(hc_shard_lock[hc_shard - cache->shards]);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns history cache shard index of the specified item           *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_get_shard_index(zbx_uint64_t itemid)
+{
+	return (int)(itemid % (zbx_uint64_t)cache->shards_num);
+}
+
+static void	dc_stats_add(zbx_dc_stats_t *dst, const zbx_dc_stats_t *src)
+{
+	dst->history_counter += src->history_counter;
+	dst->history_float_counter += src->history_float_counter;
+	dst->history_uint_counter += src->history_uint_counter;
+	dst->history_str_counter += src->history_str_counter;
+	dst->history_log_counter += src->history_log_counter;
+	dst->history_text_counter += src->history_text_counter;
+	dst->history_bin_counter += src->history_bin_counter;
+	dst->notsupported_counter += src->notsupported_counter;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: sets history cache shards owned by history syncer                 *
+ *                                                                            *
+ * Parameters: syncer_num  - [IN] the history syncer number (1..syncers_num)  *
+ *             syncers_num - [IN] the number of history syncers               *
+ *                                                                            *
+ * Comments: Syncer starts each batch from one of its own shards and steals   *
+ *           items from the following shards if there is space left in batch. *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_hc_set_sync_shards(int syncer_num, int syncers_num)
+{
+	hc_syncer_num = syncer_num;
+	hc_syncers_num = syncers_num;
+
+	hc_sync_shard_home = (syncer_num - 1) % cache->shards_num;
+	hc_sync_shard_step = (syncers_num < cache->shards_num ? syncers_num : 0);
+	hc_sync_shard = hc_sync_shard_home;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if the current history syncer is allowed to sync history   *
+ *                                                                            *
+ * Return value: SUCCEED - the syncer is active                               *
+ *               FAIL    - the syncer is parked                               *
+ *                                                                            *
+ * Comments: When the number of active syncers changes the history cache      *
+ *           shards are reassigned between active syncers, so that shards of  *
+ *           parked syncers are not left to be processed only when the active *
+ *           syncers have space left in their batches.                        *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_hc_sync_is_active(void)
+{
+	int	syncers_active = cache->syncers_active;
+
+	if (0 != syncers_active && hc_syncer_num > syncers_active)
+		return FAIL;
+
+	if (0 != syncers_active && syncers_active != hc_syncers_num)
+		zbx_hc_set_sync_shards(hc_syncer_num, syncers_active);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: starts or parks history syncers depending on history cache usage  *
+ *                                                                            *
+ * Parameters: syncers_min - [IN] the minimum number of active syncers        *
+ *             syncers_max - [IN] the number of started syncers               *
+ *                                                                            *
+ * Comments: This function must be called only by the first history syncer.   *
+ *           Another syncer is activated when history cache usage is high or  *
+ *           grows fast, the last active syncer is parked when the usage is   *
+ *           low and does not grow. One syncer is activated or parked every   *
+ *           ZBX_HC_SCALE_INTERVAL seconds at most.                           *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_hc_scale_syncers(int syncers_min, int syncers_max)
+{
+	static time_t		scale_time;
+	static double		pused_last;
+	time_t			now;
+	double			pused, rate;
+	int			syncers_active;
+	zbx_wcache_info_t	wcache_info;
+
+	if (syncers_min >= syncers_max)
+		return;
+
+	now = time(NULL);
+
+	if (0 == cache->syncers_active)
+	{
+		/* start with all syncers active to sync values cached before start */
+		cache->syncers_active = syncers_max;
+		scale_time = now;
+		return;
+	}
+
+	if (ZBX_HC_SCALE_INTERVAL > now - scale_time)
+		return;
+
+	zbx_dc_get_stats_all(&wcache_info);
+	pused = 100 * (double)(wcache_info.history_total - wcache_info.history_free) /
+			(double)wcache_info.history_total;
+	rate = (pused - pused_last) / (double)(now - scale_time);
+
+	syncers_active = cache->syncers_active;
+
+	if ((ZBX_HC_SCALE_UP_PUSED <= pused || ZBX_HC_SCALE_UP_RATE <= rate) && syncers_max > syncers_active)
+		syncers_active++;
+	else if (ZBX_HC_SCALE_DOWN_PUSED > pused && 0 >= rate && syncers_min < syncers_active)
+		syncers_active--;
+
+	if (syncers_active != cache->syncers_active)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "history cache usage " ZBX_FS_DBL "%%, growth " ZBX_FS_DBL "%%/sec,"
+				" active history syncers: %d", pused, rate, syncers_active);
+		cache->syncers_active = syncers_active;
+	}
+
+	pused_last = pused;
+	scale_time = now;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adjusts synchronization batch size of the current history syncer  *
+ *                                                                            *
+ * Parameters: history_num - [IN] the number of synced items                  *
+ *             sec         - [IN] the time spent syncing the batch            *
+ *                                                                            *
+ * Comments: The batch size approaches the number of items that could be      *
+ *           synced in ZBX_HC_SYNC_BATCH_TIME at the measured cost per item.  *
+ *           Small batches waste database round trips under load while large  *
+ *           ones delay trigger processing, so the batch grows only when it   *
+ *           was full and more items are queued, and shrinks faster than it   *
+ *           grows when syncing takes too long.                               *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_sync_batch_update(int history_num, double sec)
+{
+	int	batch;
+
+	if (0 == history_num)
+		return;
+
+	if (ZBX_HC_SYNC_BATCH_TIME * history_num >= sec * ZBX_HC_SYNC_BATCH_MAX)
+		batch = ZBX_HC_SYNC_BATCH_MAX;
+	else
+		batch = (int)(ZBX_HC_SYNC_BATCH_TIME * history_num / sec);
+
+	if (batch > hc_sync_batch)
+	{
+		if (history_num < hc_sync_batch || hc_sync_batch > hc_queue_get_size())
+			return;
+
+		batch = (hc_sync_batch * 3 + batch) / 4;
+	}
+	else
+	{
+		/* cost per item of small batches is dominated by fixed overhead */
+		if (ZBX_HC_SYNC_BATCH_TIME >= sec)
+			return;
+
+		batch = (hc_sync_batch + batch) / 2;
+	}
+
+	if (ZBX_HC_SYNC_BATCH_MIN > batch)
+		batch = ZBX_HC_SYNC_BATCH_MIN;
+
+	if (batch != hc_sync_batch)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "%s() synced %d items in " ZBX_FS_DBL " sec, batch size %d -> %d",
+				__func__, history_num, sec, hc_sync_batch, batch);
+		hc_sync_batch = batch;
+	}
+}
 
 /******************************************************************************
  *                                                                            *
@@ -195,21 +580,30 @@ static int	hc_get_history_compression_age(void);
  ******************************************************************************/
 void	zbx_dc_get_stats_all(zbx_wcache_info_t *wcache_info)
 {
-	LOCK_CACHE;
+	int	i;
 
-	wcache_info->stats = cache->stats;
-	wcache_info->history_free = hc_mem->free_size;
-	wcache_info->history_total = hc_mem->total_size;
-	wcache_info->index_free = hc_index_mem->free_size;
-	wcache_info->index_total = hc_index_mem->total_size;
+	memset(wcache_info, 0, sizeof(zbx_wcache_info_t));
 
-	if (0 != (get_program_type_cb() & ZBX_PROGRAM_TYPE_SERVER))
+	for (i = 0; i < cache->shards_num; i++)
 	{
-		wcache_info->trend_free = trend_mem->free_size;
-		wcache_info->trend_total = trend_mem->orig_size;
+		hc_lock_shard(i);
+
+		dc_stats_add(&wcache_info->stats, &hc_shard->stats);
+		wcache_info->history_free += hc_mem->free_size;
+		wcache_info->history_total += hc_mem->total_size;
+		wcache_info->index_free += hc_index_mem->free_size;
+		wcache_info->index_total += hc_index_mem->total_size;
+
+		if (0 == i && 0 != (get_program_type_cb() & ZBX_PROGRAM_TYPE_SERVER))
+		{
+			wcache_info->trend_free = trend_mem->free_size;
+			wcache_info->trend_total = trend_mem->orig_size;
+		}
+
+		hc_unlock_shard();
 	}
 
-	UNLOCK_CACHE;
+	hc_ingest_get_stats(wcache_info);
 }
 
 /******************************************************************************
@@ -222,111 +616,111 @@ void	*zbx_dc_get_stats(int request)
 	static zbx_uint64_t	value_uint;
 	static double		value_double;
 	void			*ret;
+	zbx_wcache_info_t	wcache_info;
 
-	LOCK_CACHE;
+	zbx_dc_get_stats_all(&wcache_info);
 
 	switch (request)
 	{
 		case ZBX_STATS_HISTORY_COUNTER:
-			value_uint = cache->stats.history_counter;
+			value_uint = wcache_info.stats.history_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_FLOAT_COUNTER:
-			value_uint = cache->stats.history_float_counter;
+			value_uint = wcache_info.stats.history_float_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_UINT_COUNTER:
-			value_uint = cache->stats.history_uint_counter;
+			value_uint = wcache_info.stats.history_uint_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_STR_COUNTER:
-			value_uint = cache->stats.history_str_counter;
+			value_uint = wcache_info.stats.history_str_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_LOG_COUNTER:
-			value_uint = cache->stats.history_log_counter;
+			value_uint = wcache_info.stats.history_log_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_TEXT_COUNTER:
-			value_uint = cache->stats.history_text_counter;
+			value_uint = wcache_info.stats.history_text_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_NOTSUPPORTED_COUNTER:
-			value_uint = cache->stats.notsupported_counter;
+			value_uint = wcache_info.stats.notsupported_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_TOTAL:
-			value_uint = hc_mem->total_size;
+			value_uint = wcache_info.history_total;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_USED:
-			value_uint = hc_mem->total_size - hc_mem->free_size;
+			value_uint = wcache_info.history_total - wcache_info.history_free;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_FREE:
-			value_uint = hc_mem->free_size;
+			value_uint = wcache_info.history_free;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_PUSED:
-			value_double = 100 * (double)(hc_mem->total_size - hc_mem->free_size) / hc_mem->total_size;
+			value_double = 100 * (double)(wcache_info.history_total - wcache_info.history_free) /
+					(double)wcache_info.history_total;
 			ret = (void *)&value_double;
 			break;
 		case ZBX_STATS_HISTORY_PFREE:
-			value_double = 100 * (double)hc_mem->free_size / hc_mem->total_size;
+			value_double = 100 * (double)wcache_info.history_free / wcache_info.history_total;
 			ret = (void *)&value_double;
 			break;
 		case ZBX_STATS_TREND_TOTAL:
-			value_uint = trend_mem->orig_size;
+			value_uint = wcache_info.trend_total;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_TREND_USED:
-			value_uint = trend_mem->orig_size - trend_mem->free_size;
+			value_uint = wcache_info.trend_total - wcache_info.trend_free;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_TREND_FREE:
-			value_uint = trend_mem->free_size;
+			value_uint = wcache_info.trend_free;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_TREND_PUSED:
-			value_double = 100 * (double)(trend_mem->orig_size - trend_mem->free_size) /
-					trend_mem->orig_size;
+			value_double = 100 * (double)(wcache_info.trend_total - wcache_info.trend_free) /
+					wcache_info.trend_total;
 			ret = (void *)&value_double;
 			break;
 		case ZBX_STATS_TREND_PFREE:
-			value_double = 100 * (double)trend_mem->free_size / trend_mem->orig_size;
+			value_double = 100 * (double)wcache_info.trend_free / wcache_info.trend_total;
 			ret = (void *)&value_double;
 			break;
 		case ZBX_STATS_HISTORY_INDEX_TOTAL:
-			value_uint = hc_index_mem->total_size;
+			value_uint = wcache_info.index_total;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_INDEX_USED:
-			value_uint = hc_index_mem->total_size - hc_index_mem->free_size;
+			value_uint = wcache_info.index_total - wcache_info.index_free;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_INDEX_FREE:
-			value_uint = hc_index_mem->free_size;
+			value_uint = wcache_info.index_free;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_INDEX_PUSED:
-			value_double = 100 * (double)(hc_index_mem->total_size - hc_index_mem->free_size) /
-					hc_index_mem->total_size;
+			value_double = 100 * (double)(wcache_info.index_total - wcache_info.index_free) /
+					wcache_info.index_total;
 			ret = (void *)&value_double;
 			break;
 		case ZBX_STATS_HISTORY_INDEX_PFREE:
-			value_double = 100 * (double)hc_index_mem->free_size / hc_index_mem->total_size;
+			value_double = 100 * (double)wcache_info.index_free / wcache_info.index_total;
 			ret = (void *)&value_double;
 			break;
 		case ZBX_STATS_HISTORY_BIN_COUNTER:
-			value_uint = cache->stats.history_bin_counter;
+			value_uint = wcache_info.stats.history_bin_counter;
 			ret = (void *)&value_uint;
 			break;
 		default:
 			ret = NULL;
 	}
 
-	UNLOCK_CACHE;
-
 	return ret;
 }
 
@@ -390,6 +784,7 @@ static void	dc_insert_trends_in_db(ZBX_DC_TREND *trends, int trends_num, unsigne
 
 	zbx_db_insert_prepare(&db_insert, table_name, "itemid", "clock", "num", "value_min", "value_avg",
 			"value_max", NULL);
+	zbx_db_insert_use_copy(&db_insert);
 
 	for (i = 0; i < trends_num; i++)
 	{
@@ -640,6 +1035,54 @@ static void	dc_trends_fetch_and_update(ZBX_DC_TREND *trends, int trends_num, zbx
 		zbx_db_execute("%s", sql);
 }
 
+#if defined(HAVE_POSTGRESQL) || defined(HAVE_MYSQL)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: remove daily rollups of the day trends are written for            *
+ *                                                                            *
+ * Parameters: trends     - [IN] trends being written                         *
+ *             trends_num - [IN] number of trends                             *
+ *             table_name - [IN] trends table name                            *
+ *             value_type - [IN] type of written trends                       *
+ *             clock      - [IN] clock of written trends                      *
+ *                                                                            *
+ * Comments: Only trend writer maintains daily rollups, trends written by     *
+ *           other processes make trend functions read the day from hourly    *
+ *           trends until trend writer recalculates the rollup.               *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_invalidate_trends_rollup(const ZBX_DC_TREND *trends, int trends_num, const char *table_name,
+		unsigned char value_type, int clock)
+{
+	zbx_vector_uint64_t	itemids;
+	size_t			sql_offset = 0;
+	int			i;
+
+	zbx_vector_uint64_create(&itemids);
+
+	for (i = 0; i < trends_num; i++)
+	{
+		if (clock != trends[i].clock || value_type != trends[i].value_type || 0 == trends[i].itemid)
+			continue;
+
+		zbx_vector_uint64_append(&itemids, trends[i].itemid);
+	}
+
+	if (0 != itemids.values_num)
+	{
+		zbx_vector_uint64_sort(&itemids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "delete from %s" ZBX_TRENDS_ROLLUP_SUFFIX
+				" where clock=%d and", table_name, clock - clock % ZBX_TRENDS_ROLLUP_PERIOD);
+		zbx_db_add_condition_alloc(&sql, &sql_alloc, &sql_offset, "itemid", itemids.values,
+				itemids.values_num);
+		zbx_db_execute("%s", sql);
+	}
+
+	zbx_vector_uint64_destroy(&itemids);
+}
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Purpose: flush trend to the database                                       *
@@ -694,6 +1137,9 @@ static void	DBflush_trends(ZBX_DC_TREND *trends, int *trends_num, zbx_vector_uin
 		}
 	}
 
+#if defined(HAVE_POSTGRESQL) || defined(HAVE_MYSQL)
+	dc_invalidate_trends_rollup(trends, trends_to, table_name, value_type, clock);
+#endif
 	if (0 != itemids_num)
 	{
 		dc_remove_updated_trends(trends, trends_to, table_name, value_type, itemids,
@@ -972,191 +1418,573 @@ static void	DBmass_update_trends(const ZBX_DC_TREND *trends, int trends_num,
 	}
 }
 
-typedef struct
+/* trends queue grows by this many trends */
+#define ZBX_TRENDS_QUEUE_STEP	1024
+/* the maximum number of queued trends written by trend writer in one transaction */
+#define ZBX_TRENDS_WRITE_MAX	(ZBX_HC_SYNC_MAX * 10)
+/* the maximum number of rows in one trends upsert statement */
+#define ZBX_TRENDS_UPSERT_ROWS	1000
+
+static int	dc_trend_compare_type(const void *d1, const void *d2)
 {
-	zbx_uint64_t		hostid;
-	zbx_vector_ptr_t	groups;
+	const ZBX_DC_TREND	*p1 = (const ZBX_DC_TREND *)d1;
+	const ZBX_DC_TREND	*p2 = (const ZBX_DC_TREND *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(p1->itemid, p2->itemid);
+	ZBX_RETURN_IF_NOT_EQUAL(p1->clock, p2->clock);
+	ZBX_RETURN_IF_NOT_EQUAL(p1->value_type, p2->value_type);
+
+	return 0;
 }
-zbx_host_info_t;
 
 /******************************************************************************
  *                                                                            *
- * Purpose: frees resources allocated to store host groups names              *
- *                                                                            *
- * Parameters: host_info - [IN] host information                              *
+ * Purpose: sort trends and merge trends of the same item hour                *
  *                                                                            *
- ******************************************************************************/
-static void	zbx_host_info_clean(zbx_host_info_t *host_info)
-{
-	zbx_vector_ptr_clear_ext(&host_info->groups, zbx_ptr_free);
-	zbx_vector_ptr_destroy(&host_info->groups);
-}
-
-/******************************************************************************
+ * Parameters: trends     - [IN/OUT] trends to merge                          *
+ *             trends_num - [IN] number of trends                             *
  *                                                                            *
- * Purpose: get hosts groups names                                            *
+ * Return value: number of trends after merging                               *
  *                                                                            *
- * Parameters: hosts_info - [IN/OUT] output names of host groups for a host   *
- *             hostids    - [IN] hosts identifiers                            *
+ * Comments: Queued trends can contain the same hour more than once when late *
+ *           values reopened an hour that was already completed.              *
  *                                                                            *
  ******************************************************************************/
-static void	db_get_hosts_info_by_hostid(zbx_hashset_t *hosts_info, const zbx_vector_uint64_t *hostids)
+static int	dc_trends_merge(ZBX_DC_TREND *trends, int trends_num)
 {
-	int		i;
-	size_t		sql_offset = 0;
-	zbx_db_result_t	result;
-	zbx_db_row_t	row;
-
-	for (i = 0; i < hostids->values_num; i++)
-	{
-		zbx_host_info_t	host_info = {.hostid = hostids->values[i]};
-
-		zbx_vector_ptr_create(&host_info.groups);
-		zbx_hashset_insert(hosts_info, &host_info, sizeof(host_info));
-	}
-
-	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
-				"select distinct hg.hostid,g.name"
-				" from hstgrp g,hosts_groups hg"
-				" where g.groupid=hg.groupid"
-					" and");
+	int	i, num = 0;
 
-	zbx_db_add_condition_alloc(&sql, &sql_alloc, &sql_offset, "hg.hostid", hostids->values, hostids->values_num);
+	if (0 == trends_num)
+		return 0;
 
-	result = zbx_db_select("%s", sql);
+	qsort(trends, (size_t)trends_num, sizeof(ZBX_DC_TREND), dc_trend_compare_type);
 
-	while (NULL != (row = zbx_db_fetch(result)))
+	for (i = 1; i < trends_num; i++)
 	{
-		zbx_uint64_t	hostid;
-		zbx_host_info_t	*host_info;
-
-		ZBX_DBROW2UINT64(hostid, row[0]);
+		ZBX_DC_TREND	*dst = &trends[num], *src = &trends[i];
 
-		if (NULL == (host_info = (zbx_host_info_t *)zbx_hashset_search(hosts_info, &hostid)))
+		if (0 != dc_trend_compare_type(dst, src))
 		{
-			THIS_SHOULD_NEVER_HAPPEN;
+			trends[++num] = *src;
 			continue;
 		}
 
-		zbx_vector_ptr_append(&host_info->groups, zbx_strdup(NULL, row[1]));
-	}
-	zbx_db_free_result(result);
-}
+		if (ITEM_VALUE_TYPE_FLOAT == dst->value_type)
+		{
+			if (src->value_min.dbl < dst->value_min.dbl)
+				dst->value_min.dbl = src->value_min.dbl;
 
-typedef struct
-{
-	zbx_uint64_t		itemid;
-	char			*name;
-	zbx_history_sync_item_t	*item;
-	zbx_vector_tags_t	item_tags;
+			if (src->value_max.dbl > dst->value_max.dbl)
+				dst->value_max.dbl = src->value_max.dbl;
+
+			dst->value_avg.dbl = dst->value_avg.dbl / (dst->num + src->num) * dst->num +
+					src->value_avg.dbl / (dst->num + src->num) * src->num;
+		}
+		else
+		{
+			if (src->value_min.ui64 < dst->value_min.ui64)
+				dst->value_min.ui64 = src->value_min.ui64;
+
+			if (src->value_max.ui64 > dst->value_max.ui64)
+				dst->value_max.ui64 = src->value_max.ui64;
+
+			/* unsigned trends keep the sum of values until written to database */
+			zbx_uinc128_128(&dst->value_avg.ui64, &src->value_avg.ui64);
+		}
+
+		dst->num += src->num;
+
+		if (0 == dst->disable_from || (0 != src->disable_from && src->disable_from < dst->disable_from))
+			dst->disable_from = src->disable_from;
+	}
+
+	return num + 1;
 }
-zbx_item_info_t;
 
 /******************************************************************************
  *                                                                            *
- * Purpose: get item names                                                    *
+ * Purpose: pass completed trends to trend writer                             *
+ *                                                                            *
+ * Parameters: trends     - [IN] completed trends                             *
+ *             trends_num - [IN] number of trends                             *
  *                                                                            *
- * Parameters: items_info - [IN/OUT] output item names                        *
- *             itemids    - [IN] the item identifiers                         *
+ * Return value: SUCCEED - trends were queued                                 *
+ *               FAIL    - trend writer is not running or the queue cannot    *
+ *                         grow without taking memory from aggregated trends  *
  *                                                                            *
  ******************************************************************************/
-static void	db_get_item_names_by_itemid(zbx_hashset_t *items_info, const zbx_vector_uint64_t *itemids)
+static int	hc_queue_trends(const ZBX_DC_TREND *trends, int trends_num)
 {
-	size_t		sql_offset = 0;
-	zbx_db_result_t	result;
-	zbx_db_row_t	row;
+	int	ret = FAIL;
 
-	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "select itemid,name from items where");
-	zbx_db_add_condition_alloc(&sql, &sql_alloc, &sql_offset, "itemid", itemids->values, itemids->values_num);
+	LOCK_TRENDS;
 
-	result = zbx_db_select("%s", sql);
+	if (0 == cache->trend_writers_num)
+		goto out;
 
-	while (NULL != (row = zbx_db_fetch(result)))
+	if (cache->trends_queue_alloc < cache->trends_queue_num + trends_num)
 	{
-		zbx_uint64_t	itemid;
-		zbx_item_info_t	*item_info;
+		int	alloc = cache->trends_queue_alloc;
 
-		ZBX_DBROW2UINT64(itemid, row[0]);
+		while (alloc < cache->trends_queue_num + trends_num)
+			alloc += ZBX_TRENDS_QUEUE_STEP;
 
-		if (NULL == (item_info = (zbx_item_info_t *)zbx_hashset_search(items_info, &itemid)))
-		{
-			THIS_SHOULD_NEVER_HAPPEN;
+		/* at least a quarter of trend cache is left for trends being aggregated */
+		if (trend_mem->free_size < (zbx_uint64_t)alloc * sizeof(ZBX_DC_TREND) + trend_mem->orig_size / 4)
+			goto out;
+
+		cache->trends_queue = (ZBX_DC_TREND *)zbx_shmem_realloc(trend_mem, cache->trends_queue,
+				(size_t)alloc * sizeof(ZBX_DC_TREND));
+		cache->trends_queue_alloc = alloc;
+	}
+
+	memcpy(&cache->trends_queue[cache->trends_queue_num], trends, (size_t)trends_num * sizeof(ZBX_DC_TREND));
+	cache->trends_queue_num += trends_num;
+
+	ret = SUCCEED;
+out:
+	UNLOCK_TRENDS;
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: start or stop passing completed trends to trend writer            *
+ *                                                                            *
+ * Parameters: running - [IN] 1 - trend writer has started, 0 - has stopped   *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dc_set_trend_writer(int running)
+{
+	LOCK_TRENDS;
+
+	if (0 != running)
+		cache->trend_writers_num++;
+	else if (0 < cache->trend_writers_num)
+		cache->trend_writers_num--;
+
+	UNLOCK_TRENDS;
+}
+
+#if defined(HAVE_POSTGRESQL) || defined(HAVE_MYSQL)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: write trends of one value type merging them with rows of the same *
+ *          hour already in database                                          *
+ *                                                                            *
+ * Parameters: trends     - [IN] sorted and merged trends                     *
+ *             trends_num - [IN] number of trends                             *
+ *             value_type - [IN] type of trends to write                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_upsert_trends(const ZBX_DC_TREND *trends, int trends_num, unsigned char value_type)
+{
+	const char	*table_name, *update;
+	size_t		sql_offset = 0;
+	int		i, rows_num = 0;
+
+	if (ITEM_VALUE_TYPE_FLOAT == value_type)
+	{
+		table_name = "trends";
+#if defined(HAVE_POSTGRESQL)
+		update = " on conflict (itemid,clock) do update set"
+				" value_min=least(trends.value_min,excluded.value_min),"
+				"value_avg=(trends.value_avg*trends.num+excluded.value_avg*excluded.num)/"
+					"(trends.num+excluded.num),"
+				"value_max=greatest(trends.value_max,excluded.value_max),"
+				"num=trends.num+excluded.num";
+#else
+		/* MySQL assigns columns from left to right, so num must be updated last */
+		update = " on duplicate key update"
+				" value_min=least(value_min,values(value_min)),"
+				"value_avg=(value_avg*num+values(value_avg)*values(num))/(num+values(num)),"
+				"value_max=greatest(value_max,values(value_max)),"
+				"num=num+values(num)";
+#endif
+	}
+	else
+	{
+		table_name = "trends_uint";
+#if defined(HAVE_POSTGRESQL)
+		update = " on conflict (itemid,clock) do update set"
+				" value_min=least(trends_uint.value_min,excluded.value_min),"
+				"value_avg=div(trends_uint.value_avg*trends_uint.num+excluded.value_avg*excluded.num,"
+					"trends_uint.num+excluded.num),"
+				"value_max=greatest(trends_uint.value_max,excluded.value_max),"
+				"num=trends_uint.num+excluded.num";
+#else
+		/* sum of unsigned values can exceed the range of bigint unsigned */
+		update = " on duplicate key update"
+				" value_min=least(value_min,values(value_min)),"
+				"value_avg=truncate((cast(value_avg as decimal(65,0))*num+"
+					"cast(values(value_avg) as decimal(65,0))*values(num))/(num+values(num)),0),"
+				"value_max=greatest(value_max,values(value_max)),"
+				"num=num+values(num)";
+#endif
+	}
+
+	for (i = 0; i < trends_num; i++)
+	{
+		const ZBX_DC_TREND	*trend = &trends[i];
+
+		if (value_type != trend->value_type)
 			continue;
+
+		if (0 == rows_num)
+		{
+			zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
+					"insert into %s (itemid,clock,num,value_min,value_avg,value_max) values ",
+					table_name);
+		}
+		else
+			zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, ',');
+
+		if (ITEM_VALUE_TYPE_FLOAT == value_type)
+		{
+			zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "(" ZBX_FS_UI64 ",%d,%d," ZBX_FS_DBL64_SQL
+					"," ZBX_FS_DBL64_SQL "," ZBX_FS_DBL64_SQL ")", trend->itemid, trend->clock,
+					trend->num, trend->value_min.dbl, trend->value_avg.dbl, trend->value_max.dbl);
+		}
+		else
+		{
+			zbx_uint128_t	avg;
+
+			/* calculate the trend average value */
+			zbx_udiv128_64(&avg, &trend->value_avg.ui64, trend->num);
+
+			zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "(" ZBX_FS_UI64 ",%d,%d," ZBX_FS_UI64 ","
+					ZBX_FS_UI64 "," ZBX_FS_UI64 ")", trend->itemid, trend->clock, trend->num,
+					trend->value_min.ui64, avg.lo, trend->value_max.ui64);
 		}
 
-		item_info->name = zbx_strdup(item_info->name, row[1]);
+		if (ZBX_TRENDS_UPSERT_ROWS == ++rows_num)
+		{
+			zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, update);
+			zbx_db_execute("%s", sql);
+			sql_offset = 0;
+			rows_num = 0;
+		}
 	}
 
-	zbx_db_free_result(result);
+	if (0 != rows_num)
+	{
+		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, update);
+		zbx_db_execute("%s", sql);
+	}
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: get item tags                                                     *
+ * Purpose: recalculate daily rollups of the days trends were written for     *
  *                                                                            *
- * Parameters: items_info - [IN/OUT] output item tags                         *
- *             itemids    - [IN] the item identifiers                         *
+ * Parameters: trends     - [IN] written trends                               *
+ *             trends_num - [IN] number of trends                             *
+ *             value_type - [IN] type of trends to recalculate rollups for    *
+ *                                                                            *
+ * Comments: Rollups are calculated from hourly trends of the whole day, so   *
+ *           they stay exact regardless of how the day hours were written.    *
  *                                                                            *
  ******************************************************************************/
-static void	db_get_item_tags_by_itemid(zbx_hashset_t *items_info, const zbx_vector_uint64_t *itemids)
+static void	dc_rollup_trends(const ZBX_DC_TREND *trends, int trends_num, unsigned char value_type)
 {
-	size_t		sql_offset = 0;
-	zbx_db_result_t	result;
-	zbx_db_row_t	row;
-	zbx_item_info_t	*item_info = NULL;
+	const char		*table_name;
+	size_t			sql_offset;
+	int			i, j;
+	zbx_vector_uint64_t	days, itemids;
 
-	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "select itemid,tag,value from item_tag where");
-	zbx_db_add_condition_alloc(&sql, &sql_alloc, &sql_offset, "itemid", itemids->values, itemids->values_num);
-	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " order by itemid");
+	table_name = (ITEM_VALUE_TYPE_FLOAT == value_type ? "trends" : "trends_uint");
 
-	result = zbx_db_select("%s", sql);
+	zbx_vector_uint64_create(&days);
+	zbx_vector_uint64_create(&itemids);
 
-	while (NULL != (row = zbx_db_fetch(result)))
+	for (i = 0; i < trends_num; i++)
 	{
-		zbx_uint64_t	itemid;
-		zbx_tag_t	*item_tag;
+		if (value_type != trends[i].value_type)
+			continue;
+
+		zbx_vector_uint64_append(&days, (zbx_uint64_t)(trends[i].clock -
+				trends[i].clock % ZBX_TRENDS_ROLLUP_PERIOD));
+	}
+
+	zbx_vector_uint64_sort(&days, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_uniq(&days, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 
-		ZBX_DBROW2UINT64(itemid, row[0]);
+	for (i = 0; i < days.values_num; i++)
+	{
+		int	day = (int)days.values[i];
+
+		zbx_vector_uint64_clear(&itemids);
 
-		if (NULL == item_info || item_info->itemid != itemid)
+		/* trends are sorted by itemid, so item ids are appended in ascending order */
+		for (j = 0; j < trends_num; j++)
 		{
-			if (NULL != item_info)
-			{
-				zbx_vector_tags_sort(&item_info->item_tags, zbx_compare_tags);
-			}
-			if (NULL == (item_info = (zbx_item_info_t *)zbx_hashset_search(items_info, &itemid)))
+			if (value_type != trends[j].value_type || day != trends[j].clock -
+					trends[j].clock % ZBX_TRENDS_ROLLUP_PERIOD)
 			{
-				THIS_SHOULD_NEVER_HAPPEN;
 				continue;
 			}
+
+			if (0 == itemids.values_num || itemids.values[itemids.values_num - 1] != trends[j].itemid)
+				zbx_vector_uint64_append(&itemids, trends[j].itemid);
 		}
 
-		item_tag = (zbx_tag_t *)zbx_malloc(NULL, sizeof(*item_tag));
-		item_tag->tag = zbx_strdup(NULL, row[1]);
-		item_tag->value = zbx_strdup(NULL, row[2]);
-		zbx_vector_tags_append(&item_info->item_tags, item_tag);
+		sql_offset = 0;
+
+		/* integer averages are multiplied by floating point constant to avoid bigint overflow */
+		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
+				"insert into %s" ZBX_TRENDS_ROLLUP_SUFFIX " (itemid,clock,num,value_min,value_avg,value_max)"
+				" select itemid,%d,sum(num),min(value_min),sum(value_avg*1e0*num)/sum(num),max(value_max)"
+				" from %s"
+				" where clock>=%d"
+					" and clock<%d"
+					" and",
+				table_name, day, table_name, day, day + ZBX_TRENDS_ROLLUP_PERIOD);
+
+		zbx_db_add_condition_alloc(&sql, &sql_alloc, &sql_offset, "itemid", itemids.values,
+				itemids.values_num);
+#if defined(HAVE_POSTGRESQL)
+		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " group by itemid"
+				" on conflict (itemid,clock) do update set"
+				" num=excluded.num,value_min=excluded.value_min,value_avg=excluded.value_avg,"
+				"value_max=excluded.value_max");
+#else
+		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " group by itemid"
+				" on duplicate key update"
+				" num=values(num),value_min=values(value_min),value_avg=values(value_avg),"
+				"value_max=values(value_max)");
+#endif
+		zbx_db_execute("%s", sql);
+	}
+
+	zbx_vector_uint64_destroy(&itemids);
+	zbx_vector_uint64_destroy(&days);
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: write completed trends queued by history syncers to database      *
+ *                                                                            *
+ * Parameters: trends_num - [OUT] number of written trends                    *
+ *             more       - [OUT] ZBX_SYNC_MORE - the queue has more trends,  *
+ *                                ZBX_SYNC_DONE - otherwise                   *
+ *                                                                            *
+ * Comments: Trends are removed from the queue only after they are written,   *
+ *           so trends being written when the server stops are flushed by     *
+ *           the main process.                                                *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dc_write_queued_trends(int *trends_num, int *more)
+{
+	ZBX_DC_TREND	*trends;
+	int		queued_num, num, txn_error;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	*more = ZBX_SYNC_DONE;
+	*trends_num = 0;
+
+	LOCK_TRENDS;
+
+	if (0 == (queued_num = MIN(cache->trends_queue_num, ZBX_TRENDS_WRITE_MAX)))
+	{
+		UNLOCK_TRENDS;
+		goto out;
 	}
 
-	if (NULL != item_info)
+	trends = (ZBX_DC_TREND *)zbx_malloc(NULL, (size_t)queued_num * sizeof(ZBX_DC_TREND));
+	memcpy(trends, cache->trends_queue, (size_t)queued_num * sizeof(ZBX_DC_TREND));
+
+	UNLOCK_TRENDS;
+
+	num = dc_trends_merge(trends, queued_num);
+
+	do
 	{
-		zbx_vector_tags_sort(&item_info->item_tags, zbx_compare_tags);
+#if defined(HAVE_POSTGRESQL) || defined(HAVE_MYSQL)
+		zbx_db_begin();
+
+		dc_upsert_trends(trends, num, ITEM_VALUE_TYPE_FLOAT);
+		dc_upsert_trends(trends, num, ITEM_VALUE_TYPE_UINT64);
+		dc_rollup_trends(trends, num, ITEM_VALUE_TYPE_FLOAT);
+		dc_rollup_trends(trends, num, ITEM_VALUE_TYPE_UINT64);
+
+		txn_error = zbx_db_commit();
+#else
+		zbx_vector_uint64_pair_t	trends_diff;
+
+		zbx_vector_uint64_pair_create(&trends_diff);
+
+		zbx_db_begin();
+
+		DBmass_update_trends(trends, num, &trends_diff);
+
+		if (ZBX_DB_OK == (txn_error = zbx_db_commit()))
+			DCupdate_trends(&trends_diff);
+
+		zbx_vector_uint64_pair_destroy(&trends_diff);
+#endif
 	}
+	while (ZBX_DB_DOWN == txn_error);
 
-	zbx_db_free_result(result);
+	if (ZBX_DB_OK == txn_error)
+		zbx_tfc_invalidate_trends(trends, num);
+	else
+		zabbix_log(LOG_LEVEL_WARNING, "cannot write %d trends to database", num);
+
+	zbx_free(trends);
+
+	LOCK_TRENDS;
+
+	cache->trends_queue_num -= queued_num;
+	memmove(cache->trends_queue, cache->trends_queue + queued_num,
+			(size_t)cache->trends_queue_num * sizeof(ZBX_DC_TREND));
+
+	if (0 != cache->trends_queue_num)
+		*more = ZBX_SYNC_MORE;
+
+	UNLOCK_TRENDS;
+
+	*trends_num = num;
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() trends_num:%d", __func__, *trends_num);
+}
+
+typedef struct
+{
+	zbx_uint64_t		hostid;
+	zbx_vector_ptr_t	groups;
+}
+zbx_host_info_t;
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: frees resources allocated to store host groups names              *
+ *                                                                            *
+ * Parameters: host_info - [IN] host information                              *
+ *                                                                            *
+ ******************************************************************************/
+static void	zbx_host_info_clean(zbx_host_info_t *host_info)
+{
+	zbx_vector_ptr_clear_ext(&host_info->groups, zbx_ptr_free);
+	zbx_vector_ptr_destroy(&host_info->groups);
 }
 
+/* host group names cached for export until hosts, items, groups or tags change */
+static zbx_hashset_t	export_hosts_info;
+static zbx_uint64_t	export_hosts_revision;
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get hosts groups names                                            *
+ *                                                                            *
+ * Parameters: hostids - [IN] sorted hosts identifiers                        *
+ *                                                                            *
+ * Return value: names of host groups for a host, including the requested     *
+ *               hosts                                                        *
+ *                                                                            *
+ * Comments: Host groups are retrieved from configuration cache and kept      *
+ *           between history syncs, they are dropped when the configuration   *
+ *           revision of hosts, items, host groups or tags changes.           *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_hashset_t	*dc_get_hosts_info_by_hostid(const zbx_vector_uint64_t *hostids)
+{
+	int			i;
+	zbx_uint64_t		revision;
+	zbx_vector_uint64_t	hostids_missing;
+	zbx_vector_ptr_t	**groups;
+
+	revision = zbx_dc_get_items_revision();
+
+	if (NULL == export_hosts_info.slots)
+	{
+		zbx_hashset_create_ext(&export_hosts_info, (size_t)hostids->values_num, ZBX_DEFAULT_UINT64_HASH_FUNC,
+				ZBX_DEFAULT_UINT64_COMPARE_FUNC, (zbx_clean_func_t)zbx_host_info_clean,
+				ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
+	}
+	else if (revision != export_hosts_revision)
+		zbx_hashset_clear(&export_hosts_info);
+
+	export_hosts_revision = revision;
+
+	zbx_vector_uint64_create(&hostids_missing);
+
+	for (i = 0; i < hostids->values_num; i++)
+	{
+		if (NULL == zbx_hashset_search(&export_hosts_info, &hostids->values[i]))
+			zbx_vector_uint64_append(&hostids_missing, hostids->values[i]);
+	}
+
+	if (0 != hostids_missing.values_num)
+	{
+		groups = (zbx_vector_ptr_t **)zbx_malloc(NULL, sizeof(zbx_vector_ptr_t *) *
+				(size_t)hostids_missing.values_num);
+
+		for (i = 0; i < hostids_missing.values_num; i++)
+		{
+			zbx_host_info_t	host_info_local = {.hostid = hostids_missing.values[i]}, *host_info;
+
+			host_info = (zbx_host_info_t *)zbx_hashset_insert(&export_hosts_info, &host_info_local,
+					sizeof(host_info_local));
+			zbx_vector_ptr_create(&host_info->groups);
+			groups[i] = &host_info->groups;
+		}
+
+		zbx_dc_config_history_sync_get_hosts_groups(&hostids_missing, groups);
+		zbx_free(groups);
+	}
+
+	zbx_vector_uint64_destroy(&hostids_missing);
+
+	return &export_hosts_info;
+}
+
+typedef struct
+{
+	zbx_uint64_t		itemid;
+	char			*name;
+	zbx_history_sync_item_t	*item;
+	zbx_vector_tags_t	item_tags;
+}
+zbx_item_info_t;
+
 /******************************************************************************
  *                                                                            *
  * Purpose: get item names and item tags                                      *
  *                                                                            *
  * Parameters: items_info - [IN/OUT] output item name and item tags           *
- *             itemids    - [IN] the item identifiers                         *
+ *             itemids    - [IN] the unique item identifiers                  *
  *                                                                            *
  ******************************************************************************/
-static void	db_get_items_info_by_itemid(zbx_hashset_t *items_info, const zbx_vector_uint64_t *itemids)
+static void	dc_get_items_info_by_itemid(zbx_hashset_t *items_info, const zbx_vector_uint64_t *itemids)
 {
-	db_get_item_names_by_itemid(items_info, itemids);
-	db_get_item_tags_by_itemid(items_info, itemids);
+	char			**names;
+	zbx_vector_tags_t	**item_tags;
+	zbx_item_info_t		**item_info;
+	int			i;
+
+	names = (char **)zbx_malloc(NULL, sizeof(char *) * (size_t)itemids->values_num);
+	item_tags = (zbx_vector_tags_t **)zbx_malloc(NULL, sizeof(zbx_vector_tags_t *) * (size_t)itemids->values_num);
+	item_info = (zbx_item_info_t **)zbx_malloc(NULL, sizeof(zbx_item_info_t *) * (size_t)itemids->values_num);
+
+	for (i = 0; i < itemids->values_num; i++)
+	{
+		item_info[i] = (zbx_item_info_t *)zbx_hashset_search(items_info, &itemids->values[i]);
+		names[i] = NULL;
+		item_tags[i] = &item_info[i]->item_tags;
+	}
+
+	zbx_dc_config_history_sync_get_items_export_info(itemids->values, (size_t)itemids->values_num, names,
+			item_tags);
+
+	for (i = 0; i < itemids->values_num; i++)
+		item_info[i]->name = names[i];
+
+	zbx_free(item_info);
+	zbx_free(item_tags);
+	zbx_free(names);
 }
 
 /******************************************************************************
@@ -1292,9 +2120,19 @@ static void	DCexport_history(const zbx_dc_history_t *history, int history_num, z
 	zbx_item_info_t			*item_info;
 	struct zbx_json			json;
 	zbx_connector_object_t		connector_object;
+	zbx_match_tags_index_t		connector_index;
+	zbx_vector_uint32_t		connector_matches;
 
 	zbx_json_init(&json, ZBX_JSON_STAT_BUF_LEN);
 	zbx_vector_uint64_create(&connector_object.ids);
+	zbx_vector_uint32_create(&connector_matches);
+	zbx_match_tags_index_init(&connector_index);
+
+	for (i = 0; i < connector_filters->values_num; i++)
+	{
+		zbx_match_tags_index_add(&connector_index, connector_filters->values[i].tags_evaltype,
+				&connector_filters->values[i].connector_tags);
+	}
 
 	for (i = 0; i < history_num; i++)
 	{
@@ -1327,16 +2165,16 @@ static void	DCexport_history(const zbx_dc_history_t *history, int history_num, z
 		{
 			int	k;
 
-			for (k = 0; k < connector_filters->values_num; k++)
+			zbx_match_tags_index_match(&connector_index, &item_info->item_tags, &connector_matches);
+
+			for (k = 0; k < connector_matches.values_num; k++)
 			{
-				if (SUCCEED == zbx_match_tags(connector_filters->values[k].tags_evaltype,
-						&connector_filters->values[k].connector_tags, &item_info->item_tags))
-				{
-					zbx_vector_uint64_append(&connector_object.ids,
-							connector_filters->values[k].connectorid);
-				}
+				zbx_vector_uint64_append(&connector_object.ids,
+						connector_filters->values[connector_matches.values[k]].connectorid);
 			}
 
+			zbx_vector_uint32_clear(&connector_matches);
+
 			if (0 == connector_object.ids.values_num && FAIL == history_export_enabled)
 				continue;
 		}
@@ -1426,6 +2264,8 @@ static void	DCexport_history(const zbx_dc_history_t *history, int history_num, z
 	if (SUCCEED == history_export_enabled)
 		zbx_history_export_flush();
 
+	zbx_match_tags_index_destroy(&connector_index);
+	zbx_vector_uint32_destroy(&connector_matches);
 	zbx_vector_uint64_destroy(&connector_object.ids);
 	zbx_json_free(&json);
 }
@@ -1452,7 +2292,7 @@ static void	DCexport_history_and_trends(const zbx_dc_history_t *history, int his
 {
 	int			i, index;
 	zbx_vector_uint64_t	hostids, item_info_ids;
-	zbx_hashset_t		hosts_info, items_info;
+	zbx_hashset_t		*hosts_info, items_info;
 	zbx_history_sync_item_t	*item;
 	zbx_item_info_t		item_info;
 
@@ -1525,27 +2365,22 @@ static void	DCexport_history_and_trends(const zbx_dc_history_t *history, int his
 		goto clean;
 
 	zbx_vector_uint64_sort(&item_info_ids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_uniq(&item_info_ids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 	zbx_vector_uint64_sort(&hostids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 	zbx_vector_uint64_uniq(&hostids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 
-	zbx_hashset_create_ext(&hosts_info, hostids.values_num, ZBX_DEFAULT_UINT64_HASH_FUNC,
-			ZBX_DEFAULT_UINT64_COMPARE_FUNC, (zbx_clean_func_t)zbx_host_info_clean,
-			ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
-
-	db_get_hosts_info_by_hostid(&hosts_info, &hostids);
+	hosts_info = dc_get_hosts_info_by_hostid(&hostids);
 
-	db_get_items_info_by_itemid(&items_info, &item_info_ids);
+	dc_get_items_info_by_itemid(&items_info, &item_info_ids);
 
 	if (0 != history_num)
 	{
-		DCexport_history(history, history_num, &hosts_info, &items_info, history_export_enabled,
+		DCexport_history(history, history_num, hosts_info, &items_info, history_export_enabled,
 				connector_filters, data, data_alloc, data_offset);
 	}
 
 	if (0 != trends_num)
-		DCexport_trends(trends, trends_num, &hosts_info, &items_info);
-
-	zbx_hashset_destroy(&hosts_info);
+		DCexport_trends(trends, trends_num, hosts_info, &items_info);
 clean:
 	zbx_hashset_destroy(&items_info);
 	zbx_vector_uint64_destroy(&item_info_ids);
@@ -1613,7 +2448,7 @@ static void	DCsync_trends(void)
 {
 	zbx_hashset_iter_t	iter;
 	ZBX_DC_TREND		*trends = NULL, *trend;
-	int			trends_alloc = 0, trends_num = 0, compression_age;
+	int			trends_alloc = 0, trends_num = 0, trends_queued = 0, compression_age;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() trends_num:%d", __func__, cache->trends_num);
 
@@ -1634,13 +2469,23 @@ static void	DCsync_trends(void)
 		}
 	}
 
+	/* completed trends not written by trend writer, they were already exported by history syncers */
+	if (0 != cache->trends_queue_num)
+	{
+		trends_queued = cache->trends_queue_num;
+		trends = (ZBX_DC_TREND *)zbx_realloc(trends, (size_t)(trends_num + trends_queued) *
+				sizeof(ZBX_DC_TREND));
+		memcpy(trends + trends_num, cache->trends_queue, (size_t)trends_queued * sizeof(ZBX_DC_TREND));
+		cache->trends_queue_num = 0;
+	}
+
 	UNLOCK_TRENDS;
 
 	if (SUCCEED == zbx_is_export_enabled(ZBX_FLAG_EXPTYPE_TRENDS) && 0 != trends_num)
 		DCexport_all_trends(trends, trends_num);
 
-	if (0 < trends_num)
-		qsort(trends, trends_num, sizeof(ZBX_DC_TREND), zbx_trend_compare);
+	/* merging also sorts trends by itemid and clock */
+	trends_num = dc_trends_merge(trends, trends_num + trends_queued);
 
 	zbx_db_begin();
 
@@ -2575,9 +3420,11 @@ static void	remove_history_duplicates(zbx_vector_ptr_t *history)
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
-static int	add_history(zbx_dc_history_t *history, int history_num, zbx_vector_ptr_t *history_values, int *ret_flush)
+static int	add_history(zbx_dc_history_t *history, int history_num, zbx_dc_history_t *downsampled,
+		int downsampled_num, zbx_vector_ptr_t *history_values, int *ret_flush)
 {
-	int	i, ret = SUCCEED;
+	int			i, ret = SUCCEED, cached_num = 0;
+	zbx_vector_ptr_t	cached_values;
 
 	for (i = 0; i < history_num; i++)
 	{
@@ -2586,11 +3433,45 @@ static int	add_history(zbx_dc_history_t *history, int history_num, zbx_vector_pt
 		if (0 != (ZBX_DC_FLAGS_NOT_FOR_HISTORY & h->flags))
 			continue;
 
-		zbx_vector_ptr_append(history_values, h);
+		if (0 != (ZBX_DC_FLAG_DOWNSAMPLED & h->flags))
+		{
+			cached_num++;
+			continue;
+		}
+
+		zbx_vector_ptr_append(history_values, h);
+	}
+
+	if (0 == cached_num && 0 == downsampled_num)
+	{
+		if (0 != history_values->values_num)
+			ret = zbx_vc_add_values(history_values, ret_flush);
+
+		return ret;
+	}
+
+	/* history storage gets downsampled values while value cache gets the raw values */
+
+	for (i = 0; i < downsampled_num; i++)
+	{
+		if (0 == (ZBX_DC_FLAGS_NOT_FOR_HISTORY & downsampled[i].flags))
+			zbx_vector_ptr_append(history_values, &downsampled[i]);
+	}
+
+	if (0 != history_values->values_num && SUCCEED != zbx_history_add_values(history_values, ret_flush))
+		return FAIL;
+
+	zbx_vector_ptr_create(&cached_values);
+	zbx_vector_ptr_reserve(&cached_values, (size_t)history_num);
+
+	for (i = 0; i < history_num; i++)
+	{
+		if (0 == (ZBX_DC_FLAGS_NOT_FOR_HISTORY & history[i].flags))
+			zbx_vector_ptr_append(&cached_values, &history[i]);
 	}
 
-	if (0 != history_values->values_num)
-		ret = zbx_vc_add_values(history_values, ret_flush);
+	zbx_vc_cache_values(&cached_values);
+	zbx_vector_ptr_destroy(&cached_values);
 
 	return ret;
 }
@@ -2599,11 +3480,15 @@ static int	add_history(zbx_dc_history_t *history, int history_num, zbx_vector_pt
  *                                                                            *
  * Purpose: inserting new history data after new value is received            *
  *                                                                            *
- * Parameters: history     - array of history data                            *
- *             history_num - number of history structures                     *
+ * Parameters: history         - array of history data                        *
+ *             history_num     - number of history structures                 *
+ *             downsampled     - downsampled values to write instead of the   *
+ *                               history values flagged as downsampled        *
+ *             downsampled_num - number of downsampled values                 *
  *                                                                            *
  ******************************************************************************/
-static int	DBmass_add_history(zbx_dc_history_t *history, int history_num)
+static int	DBmass_add_history(zbx_dc_history_t *history, int history_num, zbx_dc_history_t *downsampled,
+		int downsampled_num)
 {
 	int			ret, ret_flush = FLUSH_SUCCEED, num;
 	zbx_vector_ptr_t	history_values;
@@ -2613,14 +3498,16 @@ static int	DBmass_add_history(zbx_dc_history_t *history, int history_num)
 	zbx_vector_ptr_create(&history_values);
 	zbx_vector_ptr_reserve(&history_values, history_num);
 
-	if (FAIL == (ret = add_history(history, history_num, &history_values, &ret_flush)) &&
+	if (FAIL == (ret = add_history(history, history_num, downsampled, downsampled_num, &history_values,
+			&ret_flush)) &&
 			FLUSH_DUPL_REJECTED == ret_flush)
 	{
 		num = history_values.values_num;
 		remove_history_duplicates(&history_values);
 		zbx_vector_ptr_clear(&history_values);
 
-		if (SUCCEED == (ret = add_history(history, history_num, &history_values, &ret_flush)))
+		if (SUCCEED == (ret = add_history(history, history_num, downsampled, downsampled_num, &history_values,
+				&ret_flush)))
 			zabbix_log(LOG_LEVEL_WARNING, "skipped %d duplicates", num - history_values.values_num);
 	}
 
@@ -2649,6 +3536,7 @@ static void	dc_add_proxy_history(zbx_dc_history_t *history, int history_num)
 	now = (int)time(NULL);
 	zbx_db_insert_prepare(&db_insert, "proxy_history", "itemid", "clock", "ns", "value", "flags", "write_clock",
 			NULL);
+	zbx_db_insert_use_copy(&db_insert);
 
 	for (i = 0; i < history_num; i++)
 	{
@@ -2719,6 +3607,7 @@ static void	dc_add_proxy_history_meta(zbx_dc_history_t *history, int history_num
 	now = (int)time(NULL);
 	zbx_db_insert_prepare(&db_insert, "proxy_history", "itemid", "clock", "ns", "value", "lastlogsize", "mtime",
 			"flags", "write_clock", NULL);
+	zbx_db_insert_use_copy(&db_insert);
 
 	for (i = 0; i < history_num; i++)
 	{
@@ -2792,6 +3681,7 @@ static void	dc_add_proxy_history_log(zbx_dc_history_t *history, int history_num)
 	/* see hc_copy_history_data() for fields that might be uninitialized and need special handling here */
 	zbx_db_insert_prepare(&db_insert, "proxy_history", "itemid", "clock", "ns", "timestamp", "source", "severity",
 			"value", "logeventid", "lastlogsize", "mtime", "flags", "write_clock", NULL);
+	zbx_db_insert_use_copy(&db_insert);
 
 	for (i = 0; i < history_num; i++)
 	{
@@ -2858,6 +3748,7 @@ static void	dc_add_proxy_history_notsupported(zbx_dc_history_t *history, int his
 	now = (int)time(NULL);
 	zbx_db_insert_prepare(&db_insert, "proxy_history", "itemid", "clock", "ns", "value", "state", "write_clock",
 			NULL);
+	zbx_db_insert_use_copy(&db_insert);
 
 	for (i = 0; i < history_num; i++)
 	{
@@ -3161,6 +4052,120 @@ static void	DCmodule_prepare_history(zbx_dc_history_t *history, int history_num,
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: prepares columnar history views for modules                       *
+ *                                                                            *
+ * Parameters: history     - [IN] array of history data                       *
+ *             history_num - [IN] number of history structures                *
+ *             columns     - [OUT] history columns of each value type         *
+ *                                                                            *
+ * Comments: Values of each type are placed in a contiguous segment of shared *
+ *           column arrays. String values are not copied, the views point to *
+ *           history cache values and are shared by all modules.              *
+ *                                                                            *
+ ******************************************************************************/
+static void	DCmodule_prepare_history_columns(const zbx_dc_history_t *history, int history_num,
+		zbx_history_columns_t *columns)
+{
+	static zbx_uint64_t	*itemid, *value_ui64;
+	static int		*clock, *ns, *timestamp, *logeventid, *severity;
+	static double		*value_dbl;
+	static const char	**value_str, **source;
+	int			offset[ITEM_VALUE_TYPE_BIN] = {0}, num[ITEM_VALUE_TYPE_BIN] = {0}, i, pos;
+
+	if (NULL == itemid)
+	{
+		itemid = (zbx_uint64_t *)zbx_malloc(NULL, ZBX_HC_SYNC_BATCH_MAX * sizeof(zbx_uint64_t));
+		value_ui64 = (zbx_uint64_t *)zbx_malloc(NULL, ZBX_HC_SYNC_BATCH_MAX * sizeof(zbx_uint64_t));
+		clock = (int *)zbx_malloc(NULL, ZBX_HC_SYNC_BATCH_MAX * sizeof(int));
+		ns = (int *)zbx_malloc(NULL, ZBX_HC_SYNC_BATCH_MAX * sizeof(int));
+		timestamp = (int *)zbx_malloc(NULL, ZBX_HC_SYNC_BATCH_MAX * sizeof(int));
+		logeventid = (int *)zbx_malloc(NULL, ZBX_HC_SYNC_BATCH_MAX * sizeof(int));
+		severity = (int *)zbx_malloc(NULL, ZBX_HC_SYNC_BATCH_MAX * sizeof(int));
+		value_dbl = (double *)zbx_malloc(NULL, ZBX_HC_SYNC_BATCH_MAX * sizeof(double));
+		value_str = (const char **)zbx_malloc(NULL, ZBX_HC_SYNC_BATCH_MAX * sizeof(char *));
+		source = (const char **)zbx_malloc(NULL, ZBX_HC_SYNC_BATCH_MAX * sizeof(char *));
+	}
+
+	for (i = 0; i < history_num; i++)
+	{
+		if (0 != (ZBX_DC_FLAGS_NOT_FOR_MODULES & history[i].flags) ||
+				ITEM_VALUE_TYPE_BIN <= history[i].value_type)
+		{
+			continue;
+		}
+
+		num[history[i].value_type]++;
+	}
+
+	for (i = 1; i < ITEM_VALUE_TYPE_BIN; i++)
+		offset[i] = offset[i - 1] + num[i - 1];
+
+	for (i = 0; i < history_num; i++)
+	{
+		const zbx_dc_history_t	*h = &history[i];
+
+		if (0 != (ZBX_DC_FLAGS_NOT_FOR_MODULES & h->flags) || ITEM_VALUE_TYPE_BIN <= h->value_type)
+			continue;
+
+		pos = offset[h->value_type]++;
+
+		itemid[pos] = h->itemid;
+		clock[pos] = h->ts.sec;
+		ns[pos] = h->ts.ns;
+
+		switch (h->value_type)
+		{
+			case ITEM_VALUE_TYPE_FLOAT:
+				value_dbl[pos] = h->value.dbl;
+				break;
+			case ITEM_VALUE_TYPE_UINT64:
+				value_ui64[pos] = h->value.ui64;
+				break;
+			case ITEM_VALUE_TYPE_STR:
+			case ITEM_VALUE_TYPE_TEXT:
+				value_str[pos] = h->value.str;
+				break;
+			case ITEM_VALUE_TYPE_LOG:
+				value_str[pos] = h->value.log->value;
+				source[pos] = ZBX_NULL2EMPTY_STR(h->value.log->source);
+				timestamp[pos] = h->value.log->timestamp;
+				logeventid[pos] = h->value.log->logeventid;
+				severity[pos] = h->value.log->severity;
+				break;
+		}
+	}
+
+	/* offsets now point to the end of each value type segment */
+#define DC_COLUMNS_SET(columns, type)						\
+	(columns).values_num = num[type];					\
+	(columns).itemid = itemid + offset[type] - num[type];			\
+	(columns).clock = clock + offset[type] - num[type];			\
+	(columns).ns = ns + offset[type] - num[type]
+
+	DC_COLUMNS_SET(columns->history_float, ITEM_VALUE_TYPE_FLOAT);
+	columns->history_float.value = value_dbl + offset[ITEM_VALUE_TYPE_FLOAT] - num[ITEM_VALUE_TYPE_FLOAT];
+
+	DC_COLUMNS_SET(columns->history_integer, ITEM_VALUE_TYPE_UINT64);
+	columns->history_integer.value = value_ui64 + offset[ITEM_VALUE_TYPE_UINT64] - num[ITEM_VALUE_TYPE_UINT64];
+
+	DC_COLUMNS_SET(columns->history_string, ITEM_VALUE_TYPE_STR);
+	columns->history_string.value = value_str + offset[ITEM_VALUE_TYPE_STR] - num[ITEM_VALUE_TYPE_STR];
+
+	DC_COLUMNS_SET(columns->history_text, ITEM_VALUE_TYPE_TEXT);
+	columns->history_text.value = value_str + offset[ITEM_VALUE_TYPE_TEXT] - num[ITEM_VALUE_TYPE_TEXT];
+
+	DC_COLUMNS_SET(columns->history_log, ITEM_VALUE_TYPE_LOG);
+	pos = offset[ITEM_VALUE_TYPE_LOG] - num[ITEM_VALUE_TYPE_LOG];
+	columns->history_log.value = value_str + pos;
+	columns->history_log.source = source + pos;
+	columns->history_log.timestamp = timestamp + pos;
+	columns->history_log.logeventid = logeventid + pos;
+	columns->history_log.severity = severity + pos;
+#undef DC_COLUMNS_SET
+}
+
 static void	DCmodule_sync_history(int history_float_num, int history_integer_num, int history_string_num,
 		int history_text_num, int history_log_num, ZBX_HISTORY_FLOAT *history_float,
 		ZBX_HISTORY_INTEGER *history_integer, ZBX_HISTORY_STRING *history_string,
@@ -3307,11 +4312,15 @@ static void	proxy_prepare_history(zbx_dc_history_t *history, int history_num)
 
 static void	sync_proxy_history(int *total_num, int *more)
 {
-	int			history_num, txn_rc;
+	static zbx_dc_history_t	*history;
+	int			history_num, txn_rc, history_pb;
 	time_t			sync_start;
 	zbx_vector_ptr_t	history_items;
 	zbx_vector_ptr_t	item_diff;
-	zbx_dc_history_t		history[ZBX_HC_SYNC_MAX];
+	double			batch_start;
+
+	if (NULL == history)
+		history = (zbx_dc_history_t *)zbx_malloc(NULL, ZBX_HC_SYNC_BATCH_MAX * sizeof(zbx_dc_history_t));
 
 	zbx_vector_ptr_create(&history_items);
 	zbx_vector_ptr_reserve(&history_items, ZBX_HC_SYNC_MAX);
@@ -3323,12 +4332,10 @@ static void	sync_proxy_history(int *total_num, int *more)
 	{
 		*more = ZBX_SYNC_DONE;
 
-		LOCK_CACHE;
-
+		hc_ingest_sync();
 		hc_pop_items(&history_items);		/* select and take items out of history cache */
 		history_num = history_items.values_num;
-
-		UNLOCK_CACHE;
+		batch_start = zbx_time();
 
 		if (0 == history_num)
 			break;
@@ -3338,41 +4345,54 @@ static void	sync_proxy_history(int *total_num, int *more)
 
 		DCmass_proxy_prepare_itemdiff(history, history_num, &item_diff);
 
+		/* values are added to proxy memory buffer only after item changes are committed */
+		history_pb = zbx_pb_history_in_memory();
+
 		do
 		{
 			zbx_db_begin();
 
-			DBmass_proxy_add_history(history, history_num);
+			if (SUCCEED != history_pb)
+				DBmass_proxy_add_history(history, history_num);
+
 			DBmass_proxy_update_items(&item_diff);
 		}
 		while (ZBX_DB_DOWN == (txn_rc = zbx_db_commit()));
 
-		LOCK_CACHE;
-
-		hc_push_items(&history_items);	/* return items to history cache */
+		if (ZBX_DB_FAIL != txn_rc && SUCCEED == history_pb &&
+				SUCCEED != zbx_pb_history_add(history, history_num))
+		{
+			do
+			{
+				zbx_db_begin();
+				DBmass_proxy_add_history(history, history_num);
+			}
+			while (ZBX_DB_DOWN == zbx_db_commit());
+		}
 
 		if (ZBX_DB_FAIL != txn_rc)
 		{
+			/* apply item changes before returning items to history cache, */
+			/* so the next values of the same items are not synced before  */
 			if (0 != item_diff.values_num)
 				zbx_dc_config_items_apply_changes(&item_diff);
 
-			cache->history_num -= history_num;
+			hc_push_items(&history_items);	/* return items to history cache */
 
 			if (0 != hc_queue_get_size())
 				*more = ZBX_SYNC_MORE;
 
-			UNLOCK_CACHE;
-
 			*total_num += history_num;
 
 			hc_free_item_values(history, history_num);
 		}
 		else
 		{
+			hc_push_items(&history_items);	/* return items to history cache */
 			*more = ZBX_SYNC_MORE;
-			UNLOCK_CACHE;
 		}
 
+		hc_sync_batch_update(history_num, zbx_time() - batch_start);
 		zbx_vector_ptr_clear(&history_items);
 		zbx_vector_ptr_clear_ext(&item_diff, zbx_default_mem_free_func);
 
@@ -3388,177 +4408,561 @@ static void	sync_proxy_history(int *total_num, int *more)
 
 /******************************************************************************
  *                                                                            *
- * Purpose: flush history cache to database, process triggers of flushed      *
- *          and timer triggers from timer queue                               *
- *                                                                            *
- * Parameters:                                                                *
- *             values_num   - [IN/OUT] the number of synced values            *
- *             triggers_num - [IN/OUT] the number of processed timers         *
- *             events_cbs   - [IN]                                            *
- *             more         - [OUT] a flag indicating the cache emptiness:    *
- *                               ZBX_SYNC_DONE - nothing to sync, go idle     *
- *                               ZBX_SYNC_MORE - more data to sync            *
+ * Purpose: gets downsampled value of the aggregated period                   *
  *                                                                            *
- * Comments: This function loops syncing history values by 1k batches and     *
- *           processing timer triggers by batches of 500 triggers.            *
- *           Unless full sync is being done the loop is aborted if either     *
- *           timeout has passed or there are no more data to process.         *
- *           The last is assumed when the following is true:                  *
- *            a) history cache is empty or less than 10% of batch values were *
- *               processed (the other items were locked by triggers)          *
- *            b) less than 500 (full batch) timer triggers were processed     *
+ * Parameters: state - [IN] the item downsampling state                       *
+ *             h     - [OUT] the downsampled value                            *
  *                                                                            *
  ******************************************************************************/
-static void	sync_server_history(int *values_num, int *triggers_num,
-		const zbx_events_funcs_t *events_cbs, int *more)
+static void	hc_downsample_get_value(const zbx_hc_downsample_t *state, zbx_dc_history_t *h)
 {
-	static ZBX_HISTORY_FLOAT	*history_float;
-	static ZBX_HISTORY_INTEGER	*history_integer;
-	static ZBX_HISTORY_STRING	*history_string;
-	static ZBX_HISTORY_TEXT		*history_text;
-	static ZBX_HISTORY_LOG		*history_log;
-	static int			module_enabled = FAIL;
-	int				i, history_num, history_float_num, history_integer_num, history_string_num,
-					history_text_num, history_log_num, txn_error, compression_age,
-					connectors_retrieved = FAIL;
-	unsigned int			item_retrieve_mode;
-	time_t				sync_start;
-	zbx_vector_uint64_t		triggerids ;
-	zbx_vector_ptr_t		history_items, trigger_diff, item_diff, inventory_values, trigger_timers,
-					trigger_order;
-	zbx_vector_uint64_pair_t	trends_diff, proxy_subscriptions;
-	zbx_dc_history_t		history[ZBX_HC_SYNC_MAX];
-	zbx_uint64_t			trigger_itemids[ZBX_HC_SYNC_MAX];
-	zbx_timespec_t			trigger_timespecs[ZBX_HC_SYNC_MAX];
-	zbx_history_sync_item_t		*items = NULL;
-	int				*errcodes = NULL;
-	zbx_vector_uint64_t		itemids;
-	zbx_hashset_t			trigger_info;
-	unsigned char			*data = NULL;
-	size_t				data_alloc = 0, data_offset;
-	zbx_vector_connector_filter_t	connector_filters_history, connector_filters_events;
+	memset(h, 0, sizeof(zbx_dc_history_t));
 
-	if (NULL == history_float && NULL != history_float_cbs)
-	{
-		module_enabled = SUCCEED;
-		history_float = (ZBX_HISTORY_FLOAT *)zbx_malloc(history_float,
-				ZBX_HC_SYNC_MAX * sizeof(ZBX_HISTORY_FLOAT));
-	}
+	h->itemid = state->itemid;
+	h->value_type = state->value_type;
+	h->state = ITEM_STATE_NORMAL;
+	h->ts.sec = state->period_start;
+	h->ttl = state->ttl;
 
-	if (NULL == history_integer && NULL != history_integer_cbs)
+	if (ITEM_HISTORY_DOWNSAMPLE_AVG != state->mode)
 	{
-		module_enabled = SUCCEED;
-		history_integer = (ZBX_HISTORY_INTEGER *)zbx_malloc(history_integer,
-				ZBX_HC_SYNC_MAX * sizeof(ZBX_HISTORY_INTEGER));
+		h->value = state->value;
 	}
-
-	if (NULL == history_string && NULL != history_string_cbs)
+	else if (ITEM_VALUE_TYPE_FLOAT == state->value_type)
 	{
-		module_enabled = SUCCEED;
-		history_string = (ZBX_HISTORY_STRING *)zbx_malloc(history_string,
-				ZBX_HC_SYNC_MAX * sizeof(ZBX_HISTORY_STRING));
+		h->value.dbl = state->sum.dbl;
 	}
-
-	if (NULL == history_text && NULL != history_text_cbs)
+	else
 	{
-		module_enabled = SUCCEED;
-		history_text = (ZBX_HISTORY_TEXT *)zbx_malloc(history_text,
-				ZBX_HC_SYNC_MAX * sizeof(ZBX_HISTORY_TEXT));
-	}
+		zbx_uint128_t	avg;
 
-	if (NULL == history_log && NULL != history_log_cbs)
-	{
-		module_enabled = SUCCEED;
-		history_log = (ZBX_HISTORY_LOG *)zbx_malloc(history_log,
-				ZBX_HC_SYNC_MAX * sizeof(ZBX_HISTORY_LOG));
+		zbx_udiv128_64(&avg, &state->sum.ui64, (zbx_uint64_t)state->count);
+		h->value.ui64 = avg.lo;
 	}
+}
 
-	compression_age = hc_get_history_compression_age();
-
-	zbx_vector_connector_filter_create(&connector_filters_history);
-	zbx_vector_connector_filter_create(&connector_filters_events);
-	zbx_vector_ptr_create(&inventory_values);
-	zbx_vector_ptr_create(&item_diff);
-	zbx_vector_ptr_create(&trigger_diff);
-	zbx_vector_uint64_pair_create(&trends_diff);
-	zbx_vector_uint64_pair_create(&proxy_subscriptions);
-
-	zbx_vector_uint64_create(&triggerids);
-	zbx_vector_uint64_reserve(&triggerids, ZBX_HC_SYNC_MAX);
-
-	zbx_vector_ptr_create(&trigger_timers);
-	zbx_vector_ptr_reserve(&trigger_timers, ZBX_HC_TIMER_MAX);
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if the value change exceeds item deadband                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_downsample_exceeds_deadband(const zbx_hc_downsample_t *state, const zbx_dc_history_t *h,
+		double deadband)
+{
+	double	diff;
 
-	zbx_vector_ptr_create(&history_items);
-	zbx_vector_ptr_reserve(&history_items, ZBX_HC_SYNC_MAX);
+	if (ITEM_VALUE_TYPE_FLOAT == h->value_type)
+		diff = fabs(h->value.dbl - state->value.dbl);
+	else if (h->value.ui64 > state->value.ui64)
+		diff = (double)(h->value.ui64 - state->value.ui64);
+	else
+		diff = (double)(state->value.ui64 - h->value.ui64);
 
-	zbx_vector_ptr_create(&trigger_order);
-	zbx_hashset_create(&trigger_info, 100, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	return diff > deadband ? SUCCEED : FAIL;
+}
 
-	zbx_vector_uint64_create(&itemids);
+/******************************************************************************
+ *                                                                            *
+ * Purpose: passes history value through item downsampling state              *
+ *                                                                            *
+ * Parameters: h           - [IN/OUT] the history value, flagged with         *
+ *                                    ZBX_DC_FLAG_DOWNSAMPLED if it must not  *
+ *                                    be written to history storage           *
+ *             item        - [IN] the history value item                      *
+ *             now         - [IN] the current time                            *
+ *             downsampled - [OUT] the downsampled value of completed period  *
+ *                                                                            *
+ * Return value: 1 - a period was completed and its value returned            *
+ *               0 - otherwise                                                *
+ *                                                                            *
+ * Comments: The history cache shard of the item must be locked.              *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_downsample_value(zbx_dc_history_t *h, const zbx_history_sync_item_t *item, int now,
+		zbx_dc_history_t *downsampled)
+{
+	zbx_hc_downsample_t	*state;
+	int			period_start, ret = 0;
 
-	sync_start = time(NULL);
+	if (NULL == (state = (zbx_hc_downsample_t *)zbx_hashset_search(&hc_shard->downsample, &h->itemid)))
+	{
+		zbx_hc_downsample_t	state_local;
 
-	item_retrieve_mode = 0 == zbx_has_export_dir() ? ZBX_ITEM_GET_SYNC : ZBX_ITEM_GET_SYNC_EXPORT;
+		memset(&state_local, 0, sizeof(state_local));
+		state_local.itemid = h->itemid;
+		state = (zbx_hc_downsample_t *)zbx_hashset_insert(&hc_shard->downsample, &state_local,
+				sizeof(state_local));
+	}
 
-	do
+	/* write the pending period and start over if item downsampling configuration has changed */
+	if (state->mode != item->history_downsample || state->value_type != h->value_type ||
+			state->period != item->history_downsample_period)
 	{
-		int			trends_num = 0, timers_num = 0, ret = SUCCEED;
-		ZBX_DC_TREND		*trends = NULL;
+		if (0 != state->count && ITEM_HISTORY_DOWNSAMPLE_DEADBAND != state->mode)
+		{
+			hc_downsample_get_value(state, downsampled);
+			ret = 1;
+		}
 
-		*more = ZBX_SYNC_DONE;
+		state->mode = item->history_downsample;
+		state->value_type = h->value_type;
+		state->period = item->history_downsample_period;
+		state->period_start = 0;
+		state->count = 0;
+	}
 
-		LOCK_CACHE;
-		hc_pop_items(&history_items);		/* select and take items out of history cache */
-		UNLOCK_CACHE;
+	state->ttl = h->ttl;
+	state->lastupdate = now;
 
-		if (0 != history_items.values_num)
+	if (ITEM_HISTORY_DOWNSAMPLE_DEADBAND == state->mode)
+	{
+		if (0 != state->count && SUCCEED != hc_downsample_exceeds_deadband(state, h,
+				item->history_downsample_deadband))
 		{
-			if (0 == (history_num = zbx_dc_config_lock_triggers_by_history_items(&history_items, &triggerids)))
-			{
-				LOCK_CACHE;
-				hc_push_items(&history_items);
-				UNLOCK_CACHE;
-				zbx_vector_ptr_clear(&history_items);
-			}
+			h->flags |= ZBX_DC_FLAG_DOWNSAMPLED;
 		}
 		else
-			history_num = 0;
-
-		if (0 != history_num)
 		{
-			zbx_dc_um_handle_t	*um_handle;
+			state->value = h->value;
+			state->count = 1;
+		}
 
-			if (FAIL == connectors_retrieved)
-			{
-				zbx_dc_config_history_sync_get_connector_filters(&connector_filters_history,
-						&connector_filters_events);
+		return ret;
+	}
 
-				connectors_retrieved = SUCCEED;
+	h->flags |= ZBX_DC_FLAG_DOWNSAMPLED;
+	period_start = h->ts.sec - h->ts.sec % state->period;
 
-				if (0 != connector_filters_history.values_num)
-					item_retrieve_mode = ZBX_ITEM_GET_SYNC_EXPORT;
-			}
+	/* drop late values of the periods that were already written */
+	if (period_start < state->period_start || (period_start == state->period_start && 0 == state->count))
+		return ret;
 
-			zbx_vector_ptr_sort(&history_items, ZBX_DEFAULT_UINT64_PTR_COMPARE_FUNC);
-			hc_get_item_values(history, &history_items);	/* copy item data from history cache */
+	if (period_start != state->period_start)
+	{
+		if (0 != state->count)
+		{
+			hc_downsample_get_value(state, downsampled);
+			ret = 1;
+		}
 
-			if (NULL == items)
+		state->period_start = period_start;
+		state->count = 0;
+	}
+
+	if (0 == state->count)
+		memset(&state->sum, 0, sizeof(state->sum));
+
+	switch (state->mode)
+	{
+		case ITEM_HISTORY_DOWNSAMPLE_AVG:
+			if (ITEM_VALUE_TYPE_FLOAT == state->value_type)
 			{
-				items = (zbx_history_sync_item_t *)zbx_malloc(NULL, sizeof(zbx_history_sync_item_t) *
-						(size_t)ZBX_HC_SYNC_MAX);
+				state->sum.dbl += h->value.dbl / (state->count + 1) -
+						state->sum.dbl / (state->count + 1);
+			}
+			else
+				zbx_uinc128_64(&state->sum.ui64, h->value.ui64);
+			break;
+		case ITEM_HISTORY_DOWNSAMPLE_MIN:
+			if (0 == state->count || (ITEM_VALUE_TYPE_FLOAT == state->value_type ?
+					h->value.dbl < state->value.dbl : h->value.ui64 < state->value.ui64))
+			{
+				state->value = h->value;
+			}
+			break;
+		case ITEM_HISTORY_DOWNSAMPLE_MAX:
+			if (0 == state->count || (ITEM_VALUE_TYPE_FLOAT == state->value_type ?
+					h->value.dbl > state->value.dbl : h->value.ui64 > state->value.ui64))
+			{
+				state->value = h->value;
 			}
+			break;
+		default:
+			state->value = h->value;
+	}
 
-			if (NULL == errcodes)
-				errcodes = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)ZBX_HC_SYNC_MAX);
+	state->count++;
 
-			zbx_vector_uint64_reserve(&itemids, history_num);
+	return ret;
+}
 
-			for (i = 0; i < history_num; i++)
-				zbx_vector_uint64_append(&itemids, history[i].itemid);
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if history value is subject to downsampling                *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_downsample_required(const zbx_dc_history_t *h, const zbx_history_sync_item_t *item, int errcode)
+{
+	if (SUCCEED != errcode || ITEM_HISTORY_DOWNSAMPLE_NONE == item->history_downsample)
+		return FAIL;
 
-			zbx_dc_config_history_sync_get_items_by_itemids(items, itemids.values, errcodes,
-					(size_t)history_num, item_retrieve_mode);
+	if (0 != (ZBX_DC_FLAGS_NOT_FOR_HISTORY & h->flags))
+		return FAIL;
+
+	if (ITEM_VALUE_TYPE_FLOAT != h->value_type && ITEM_VALUE_TYPE_UINT64 != h->value_type)
+		return FAIL;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: passes history values through item downsampling stage             *
+ *                                                                            *
+ * Parameters: history     - [IN/OUT] the history values, the values not      *
+ *                                    written to history storage are flagged  *
+ *                                    with ZBX_DC_FLAG_DOWNSAMPLED            *
+ *             items       - [IN] the history values items                    *
+ *             errcodes    - [IN] item lookup error codes                     *
+ *             history_num - [IN] the number of history values                *
+ *             downsampled - [OUT] the downsampled values of completed        *
+ *                                 periods, must have space for history_num   *
+ *                                 values                                     *
+ *                                                                            *
+ * Return value: the number of downsampled values                             *
+ *                                                                            *
+ * Comments: The raw values are still added to value cache, so triggers are   *
+ *           calculated with full resolution data.                            *
+ *           Synchronization batch has at most one value per item, so each    *
+ *           value can complete at most one downsampling period.              *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_downsample_history(zbx_dc_history_t *history, const zbx_history_sync_item_t *items,
+		const int *errcodes, int history_num, zbx_dc_history_t *downsampled)
+{
+	int		i, shard_index, now, downsampled_num = 0;
+	zbx_uint32_t	shards = 0;
+
+	for (i = 0; i < history_num; i++)
+	{
+		if (SUCCEED == hc_downsample_required(&history[i], &items[i], errcodes[i]))
+			shards |= (zbx_uint32_t)1 << hc_get_shard_index(history[i].itemid);
+	}
+
+	if (0 == shards)
+		return 0;
+
+	now = (int)time(NULL);
+
+	for (shard_index = 0; shard_index < cache->shards_num; shard_index++)
+	{
+		if (0 == (shards & ((zbx_uint32_t)1 << shard_index)))
+			continue;
+
+		hc_lock_shard(shard_index);
+
+		for (i = 0; i < history_num; i++)
+		{
+			if (1 != cache->shards_num && shard_index != hc_get_shard_index(history[i].itemid))
+				continue;
+
+			if (SUCCEED != hc_downsample_required(&history[i], &items[i], errcodes[i]))
+				continue;
+
+			downsampled_num += hc_downsample_value(&history[i], &items[i], now,
+					&downsampled[downsampled_num]);
+		}
+
+		hc_unlock_shard();
+	}
+
+	return downsampled_num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: writes downsampled values of expired periods to history storage   *
+ *          and removes stale downsampling states                             *
+ *                                                                            *
+ * Parameters: now - [IN] the current time, 0 to write all pending periods    *
+ *                                                                            *
+ * Comments: Periods are written when the next period value is received, so   *
+ *           this is needed only for items that stopped receiving values and  *
+ *           when flushing history cache at exit.                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_downsample_flush(int now)
+{
+	int			i, history_num, history_alloc = 0, ret_flush;
+	zbx_hashset_iter_t	iter;
+	zbx_hc_downsample_t	*state;
+	zbx_dc_history_t	*history = NULL;
+	zbx_vector_ptr_t	history_values;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	zbx_vector_ptr_create(&history_values);
+
+	for (i = 0; i < cache->shards_num; i++)
+	{
+		history_num = 0;
+
+		hc_lock_shard(i);
+
+		zbx_hashset_iter_reset(&hc_shard->downsample, &iter);
+
+		while (NULL != (state = (zbx_hc_downsample_t *)zbx_hashset_iter_next(&iter)))
+		{
+			if (ITEM_HISTORY_DOWNSAMPLE_DEADBAND != state->mode && 0 != state->count &&
+					(0 == now || state->period_start + state->period * 2 <= now))
+			{
+				if (history_num == history_alloc)
+				{
+					history_alloc += ZBX_HC_SYNC_MAX;
+					history = (zbx_dc_history_t *)zbx_realloc(history,
+							sizeof(zbx_dc_history_t) * (size_t)history_alloc);
+				}
+
+				hc_downsample_get_value(state, &history[history_num++]);
+				state->count = 0;
+			}
+
+			if (0 != now && state->lastupdate + ZBX_HC_DOWNSAMPLE_STATE_TTL <= now &&
+					(ITEM_HISTORY_DOWNSAMPLE_DEADBAND == state->mode || 0 == state->count))
+			{
+				zbx_hashset_iter_remove(&iter);
+			}
+		}
+
+		hc_unlock_shard();
+
+		if (0 == history_num)
+			continue;
+
+		for (int j = 0; j < history_num; j++)
+			zbx_vector_ptr_append(&history_values, &history[j]);
+
+		if (SUCCEED != zbx_history_add_values(&history_values, &ret_flush))
+			zabbix_log(LOG_LEVEL_WARNING, "cannot write %d downsampled history values", history_num);
+
+		zbx_vector_ptr_clear(&history_values);
+	}
+
+	zbx_vector_ptr_destroy(&history_values);
+	zbx_free(history);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: account latency of synced values since their collection           *
+ *                                                                            *
+ * Parameters: stage       - [IN] value processing stage (ZBX_PROF_VALUE_*)   *
+ *             history     - [IN] the history values                          *
+ *             items       - [IN] the history values items                    *
+ *             errcodes    - [IN] item lookup error codes                     *
+ *             history_num - [IN] the number of history values                *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_add_value_latency(int stage, const zbx_dc_history_t *history, const zbx_history_sync_item_t *items,
+		const int *errcodes, int history_num)
+{
+	double	now;
+
+	if (SUCCEED != zbx_prof_probes_enabled())
+		return;
+
+	now = zbx_time();
+
+	for (int i = 0; i < history_num; i++)
+	{
+		if (SUCCEED != errcodes[i])
+			continue;
+
+		zbx_prof_value_latency_add(stage, items[i].type,
+				now - history[i].ts.sec - history[i].ts.ns / 1000000000.0);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: flush history cache to database, process triggers of flushed      *
+ *          and timer triggers from timer queue                               *
+ *                                                                            *
+ * Parameters:                                                                *
+ *             values_num   - [IN/OUT] the number of synced values            *
+ *             triggers_num - [IN/OUT] the number of processed timers         *
+ *             events_cbs   - [IN]                                            *
+ *             more         - [OUT] a flag indicating the cache emptiness:    *
+ *                               ZBX_SYNC_DONE - nothing to sync, go idle     *
+ *                               ZBX_SYNC_MORE - more data to sync            *
+ *                                                                            *
+ * Comments: This function loops syncing history values by 1k batches and     *
+ *           processing timer triggers by batches of 500 triggers.            *
+ *           Unless full sync is being done the loop is aborted if either     *
+ *           timeout has passed or there are no more data to process.         *
+ *           The last is assumed when the following is true:                  *
+ *            a) history cache is empty or less than 10% of batch values were *
+ *               processed (the other items were locked by triggers)          *
+ *            b) less than 500 (full batch) timer triggers were processed     *
+ *                                                                            *
+ ******************************************************************************/
+static void	sync_server_history(int *values_num, int *triggers_num,
+		const zbx_events_funcs_t *events_cbs, int *more)
+{
+	static ZBX_HISTORY_FLOAT	*history_float;
+	static ZBX_HISTORY_INTEGER	*history_integer;
+	static ZBX_HISTORY_STRING	*history_string;
+	static ZBX_HISTORY_TEXT		*history_text;
+	static ZBX_HISTORY_LOG		*history_log;
+	static zbx_dc_history_t		*history, *downsampled;
+	static zbx_uint64_t		*trigger_itemids;
+	static zbx_timespec_t		*trigger_timespecs;
+	static int			module_enabled = FAIL;
+	int				i, history_num, history_float_num, history_integer_num, history_string_num,
+					history_text_num, history_log_num, txn_error, compression_age,
+					connectors_retrieved = FAIL;
+	unsigned int			item_retrieve_mode;
+	time_t				sync_start;
+	zbx_vector_uint64_t		triggerids ;
+	zbx_vector_ptr_t		history_items, trigger_diff, item_diff, inventory_values, trigger_timers,
+					trigger_order;
+	zbx_vector_uint64_pair_t	trends_diff, proxy_subscriptions;
+	zbx_history_sync_item_t		*items = NULL;
+	int				*errcodes = NULL;
+	zbx_vector_uint64_t		itemids;
+	zbx_hashset_t			trigger_info;
+	unsigned char			*data = NULL;
+	size_t				data_alloc = 0, data_offset;
+	zbx_vector_connector_filter_t	connector_filters_history, connector_filters_events;
+
+	if (NULL == history)
+	{
+		history = (zbx_dc_history_t *)zbx_malloc(NULL, ZBX_HC_SYNC_BATCH_MAX * sizeof(zbx_dc_history_t));
+		downsampled = (zbx_dc_history_t *)zbx_malloc(NULL, ZBX_HC_SYNC_BATCH_MAX * sizeof(zbx_dc_history_t));
+		trigger_itemids = (zbx_uint64_t *)zbx_malloc(NULL, ZBX_HC_SYNC_BATCH_MAX * sizeof(zbx_uint64_t));
+		trigger_timespecs = (zbx_timespec_t *)zbx_malloc(NULL, ZBX_HC_SYNC_BATCH_MAX *
+				sizeof(zbx_timespec_t));
+	}
+
+	if (NULL == history_float && NULL != history_float_cbs)
+	{
+		module_enabled = SUCCEED;
+		history_float = (ZBX_HISTORY_FLOAT *)zbx_malloc(history_float,
+				ZBX_HC_SYNC_BATCH_MAX * sizeof(ZBX_HISTORY_FLOAT));
+	}
+
+	if (NULL == history_integer && NULL != history_integer_cbs)
+	{
+		module_enabled = SUCCEED;
+		history_integer = (ZBX_HISTORY_INTEGER *)zbx_malloc(history_integer,
+				ZBX_HC_SYNC_BATCH_MAX * sizeof(ZBX_HISTORY_INTEGER));
+	}
+
+	if (NULL == history_string && NULL != history_string_cbs)
+	{
+		module_enabled = SUCCEED;
+		history_string = (ZBX_HISTORY_STRING *)zbx_malloc(history_string,
+				ZBX_HC_SYNC_BATCH_MAX * sizeof(ZBX_HISTORY_STRING));
+	}
+
+	if (NULL == history_text && NULL != history_text_cbs)
+	{
+		module_enabled = SUCCEED;
+		history_text = (ZBX_HISTORY_TEXT *)zbx_malloc(history_text,
+				ZBX_HC_SYNC_BATCH_MAX * sizeof(ZBX_HISTORY_TEXT));
+	}
+
+	if (NULL == history_log && NULL != history_log_cbs)
+	{
+		module_enabled = SUCCEED;
+		history_log = (ZBX_HISTORY_LOG *)zbx_malloc(history_log,
+				ZBX_HC_SYNC_BATCH_MAX * sizeof(ZBX_HISTORY_LOG));
+	}
+
+	if (NULL != history_write_cbs_v2)
+		module_enabled = SUCCEED;
+
+	compression_age = hc_get_history_compression_age();
+
+	zbx_vector_connector_filter_create(&connector_filters_history);
+	zbx_vector_connector_filter_create(&connector_filters_events);
+	zbx_vector_ptr_create(&inventory_values);
+	zbx_vector_ptr_create(&item_diff);
+	zbx_vector_ptr_create(&trigger_diff);
+	zbx_vector_uint64_pair_create(&trends_diff);
+	zbx_vector_uint64_pair_create(&proxy_subscriptions);
+
+	zbx_vector_uint64_create(&triggerids);
+	zbx_vector_uint64_reserve(&triggerids, ZBX_HC_SYNC_MAX);
+
+	zbx_vector_ptr_create(&trigger_timers);
+	zbx_vector_ptr_reserve(&trigger_timers, ZBX_HC_TIMER_MAX);
+
+	zbx_vector_ptr_create(&history_items);
+	zbx_vector_ptr_reserve(&history_items, ZBX_HC_SYNC_MAX);
+
+	zbx_vector_ptr_create(&trigger_order);
+	zbx_hashset_create(&trigger_info, 100, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	zbx_vector_uint64_create(&itemids);
+
+	sync_start = time(NULL);
+
+	item_retrieve_mode = 0 == zbx_has_export_dir() ? ZBX_ITEM_GET_SYNC : ZBX_ITEM_GET_SYNC_EXPORT;
+
+	do
+	{
+		int			trends_num = 0, timers_num = 0, ret = SUCCEED, trends_queued = 0,
+					downsampled_num;
+		ZBX_DC_TREND		*trends = NULL;
+		double			batch_start;
+
+		*more = ZBX_SYNC_DONE;
+
+		hc_ingest_sync();
+		hc_pop_items(&history_items);		/* select and take items out of history cache */
+		batch_start = zbx_time();
+
+		if (0 != history_items.values_num)
+		{
+			if (0 == (history_num = zbx_dc_config_lock_triggers_by_history_items(&history_items,
+					hc_sync_batch * ZBX_HC_SYNC_TRIGGERS_PER_ITEM, &triggerids)))
+			{
+				hc_push_items(&history_items);
+				zbx_vector_ptr_clear(&history_items);
+			}
+		}
+		else
+			history_num = 0;
+
+		if (0 != history_num)
+		{
+			zbx_dc_um_handle_t	*um_handle;
+
+			if (FAIL == connectors_retrieved)
+			{
+				zbx_dc_config_history_sync_get_connector_filters(&connector_filters_history,
+						&connector_filters_events);
+
+				connectors_retrieved = SUCCEED;
+
+				if (0 != connector_filters_history.values_num)
+					item_retrieve_mode = ZBX_ITEM_GET_SYNC_EXPORT;
+			}
+
+			zbx_vector_ptr_sort(&history_items, ZBX_DEFAULT_UINT64_PTR_COMPARE_FUNC);
+			hc_get_item_values(history, &history_items);	/* copy item data from history cache */
+
+			if (NULL == items)
+			{
+				items = (zbx_history_sync_item_t *)zbx_malloc(NULL, sizeof(zbx_history_sync_item_t) *
+						(size_t)ZBX_HC_SYNC_BATCH_MAX);
+			}
+
+			if (NULL == errcodes)
+				errcodes = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)ZBX_HC_SYNC_BATCH_MAX);
+
+			zbx_vector_uint64_reserve(&itemids, history_num);
+
+			for (i = 0; i < history_num; i++)
+				zbx_vector_uint64_append(&itemids, history[i].itemid);
+
+			zbx_dc_config_history_sync_get_items_by_itemids(items, itemids.values, errcodes,
+					(size_t)history_num, item_retrieve_mode);
+
+			hc_add_value_latency(ZBX_PROF_VALUE_SYNC, history, items, errcodes, history_num);
 
 			um_handle = zbx_dc_open_user_macros();
 
@@ -3566,12 +4970,19 @@ static void	sync_server_history(int *values_num, int *triggers_num,
 					events_cbs->add_event_cb, &item_diff,
 					&inventory_values, compression_age, &proxy_subscriptions);
 
-			if (FAIL != (ret = DBmass_add_history(history, history_num)))
+			downsampled_num = hc_downsample_history(history, items, errcodes, history_num, downsampled);
+
+			if (FAIL != (ret = DBmass_add_history(history, history_num, downsampled, downsampled_num)))
 			{
+				hc_add_value_latency(ZBX_PROF_VALUE_HISTORY, history, items, errcodes, history_num);
+
 				zbx_dc_config_items_apply_changes(&item_diff);
 				DCmass_update_trends(history, history_num, &trends, &trends_num, compression_age);
 
-				if (0 != trends_num)
+				/* trend writer writes the completed trends unless it cannot take them */
+				if (0 != trends_num && SUCCEED == hc_queue_trends(trends, trends_num))
+					trends_queued = 1;
+				else if (0 != trends_num)
 					zbx_tfc_invalidate_trends(trends, trends_num);
 
 				do
@@ -3579,7 +4990,9 @@ static void	sync_server_history(int *values_num, int *triggers_num,
 					zbx_db_begin();
 
 					DBmass_update_items(&item_diff, &inventory_values);
-					DBmass_update_trends(trends, trends_num, &trends_diff);
+
+					if (0 == trends_queued)
+						DBmass_update_trends(trends, trends_num, &trends_diff);
 
 					if (NULL != events_cbs->process_events_cb)
 					{
@@ -3590,6 +5003,9 @@ static void	sync_server_history(int *values_num, int *triggers_num,
 					if (ZBX_DB_OK == (txn_error = zbx_db_commit()))
 					{
 						DCupdate_trends(&trends_diff);
+
+						if (NULL != events_cbs->events_notify_escalators_cb)
+							events_cbs->events_notify_escalators_cb();
 					}
 					else
 					{
@@ -3662,8 +5078,14 @@ static void	sync_server_history(int *values_num, int *triggers_num,
 				}
 				while (ZBX_DB_DOWN == txn_error);
 
+				if (ZBX_DB_OK == txn_error)
+					hc_add_value_latency(ZBX_PROF_VALUE_TRIGGERS, history, items, errcodes, history_num);
+
 				if (ZBX_DB_OK == txn_error && NULL != events_cbs->events_update_itservices_cb)
 					events_cbs->events_update_itservices_cb();
+
+				if (ZBX_DB_OK == txn_error && NULL != events_cbs->events_notify_escalators_cb)
+					events_cbs->events_notify_escalators_cb();
 			}
 		}
 
@@ -3689,9 +5111,7 @@ static void	sync_server_history(int *values_num, int *triggers_num,
 
 		if (0 != history_num)
 		{
-			LOCK_CACHE;
 			hc_push_items(&history_items);	/* return items to history cache */
-			cache->history_num -= history_num;
 
 			if (0 != hc_queue_get_size())
 			{
@@ -3704,8 +5124,6 @@ static void	sync_server_history(int *values_num, int *triggers_num,
 					*more = ZBX_SYNC_MORE;
 			}
 
-			UNLOCK_CACHE;
-
 			*values_num += history_num;
 		}
 
@@ -3730,6 +5148,14 @@ static void	sync_server_history(int *values_num, int *triggers_num,
 					DCmodule_sync_history(history_float_num, history_integer_num, history_string_num,
 							history_text_num, history_log_num, history_float,
 							history_integer, history_string, history_text, history_log);
+
+					if (NULL != history_write_cbs_v2)
+					{
+						zbx_history_columns_t	columns;
+
+						DCmodule_prepare_history_columns(history, history_num, &columns);
+						hc_modules_history_write(&columns);
+					}
 				}
 
 				if (SUCCEED == (history_export_enabled =
@@ -3807,6 +5233,7 @@ static void	sync_server_history(int *values_num, int *triggers_num,
 			hc_free_item_values(history, history_num);
 		}
 
+		hc_sync_batch_update(history_num, zbx_time() - batch_start);
 		zbx_vector_uint64_clear(&itemids);
 
 		/* Exit from sync loop if we have spent too much time here.       */
@@ -3849,12 +5276,12 @@ static void	sync_server_history(int *values_num, int *triggers_num,
  ******************************************************************************/
 static void	sync_history_cache_full(const zbx_events_funcs_t *events_cbs)
 {
-	int			values_num = 0, triggers_num = 0, more;
+	int			values_num = 0, triggers_num = 0, more, i;
 	zbx_hashset_iter_t	iter;
 	zbx_hc_item_t		*item;
-	zbx_binary_heap_t	tmp_history_queue;
+	zbx_binary_heap_t	tmp_history_queue[ZBX_HC_SHARDS_MAX];
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() history_num:%d", __func__, cache->history_num);
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() history_num:%d", __func__, hc_get_history_num());
 
 	/* History index cache might be full without any space left for queueing items from history index to  */
 	/* history queue. The solution: replace the shared-memory history queue with heap-allocated one. Add  */
@@ -3873,22 +5300,33 @@ static void	sync_history_cache_full(const zbx_events_funcs_t *events_cbs)
 		zbx_dc_config_unlock_all_triggers();
 	}
 
-	tmp_history_queue = cache->history_queue;
-
-	zbx_binary_heap_create(&cache->history_queue, hc_queue_elem_compare_func, ZBX_BINARY_HEAP_OPTION_EMPTY);
-	zbx_hashset_iter_reset(&cache->history_items, &iter);
+	/* move values left in ingestion rings to history cache before rebuilding history queue */
+	hc_ingest_sync();
 
-	/* add all items from history index to the new history queue */
-	while (NULL != (item = (zbx_hc_item_t *)zbx_hashset_iter_next(&iter)))
+	for (i = 0; i < cache->shards_num; i++)
 	{
-		if (NULL != item->tail)
+		hc_lock_shard(i);
+
+		tmp_history_queue[i] = hc_shard->history_queue;
+
+		zbx_binary_heap_create(&hc_shard->history_queue, hc_queue_elem_compare_func,
+				ZBX_BINARY_HEAP_OPTION_EMPTY);
+		zbx_hashset_iter_reset(&hc_shard->history_items, &iter);
+
+		/* add all items from history index to the new history queue */
+		while (NULL != (item = (zbx_hc_item_t *)zbx_hashset_iter_next(&iter)))
 		{
-			item->status = ZBX_HC_ITEM_STATUS_NORMAL;
-			hc_queue_item(item);
+			if (NULL != item->tail)
+			{
+				item->status = ZBX_HC_ITEM_STATUS_NORMAL;
+				hc_queue_item(item);
+			}
 		}
+
+		hc_unlock_shard();
 	}
 
-	if (0 != hc_queue_get_size())
+	if (0 != hc_queue_get_size() || SUCCEED == hc_ingest_pending())
 	{
 		zabbix_log(LOG_LEVEL_WARNING, "syncing history data...");
 
@@ -3900,15 +5338,26 @@ static void	sync_history_cache_full(const zbx_events_funcs_t *events_cbs)
 				sync_proxy_history(&values_num, &more);
 
 			zabbix_log(LOG_LEVEL_WARNING, "syncing history data... " ZBX_FS_DBL "%%",
-					(double)values_num / (cache->history_num + values_num) * 100);
+					(double)values_num / (hc_get_history_num() + values_num) * 100);
 		}
-		while (0 != hc_queue_get_size());
+		while (0 != hc_queue_get_size() || SUCCEED == hc_ingest_pending());
 
 		zabbix_log(LOG_LEVEL_WARNING, "syncing history data done");
 	}
 
-	zbx_binary_heap_destroy(&cache->history_queue);
-	cache->history_queue = tmp_history_queue;
+	/* write the pending periods of downsampled items */
+	if (0 != (get_program_type_cb() & ZBX_PROGRAM_TYPE_SERVER))
+		hc_downsample_flush(0);
+
+	for (i = 0; i < cache->shards_num; i++)
+	{
+		hc_lock_shard(i);
+
+		zbx_binary_heap_destroy(&hc_shard->history_queue);
+		hc_shard->history_queue = tmp_history_queue[i];
+
+		hc_unlock_shard();
+	}
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
@@ -3921,7 +5370,9 @@ static void	sync_history_cache_full(const zbx_events_funcs_t *events_cbs)
 void	zbx_log_sync_history_cache_progress(void)
 {
 	double		pcnt = -1.0;
-	int		ts_last, ts_next, sec;
+	int		ts_last, ts_next, sec, history_num;
+
+	history_num = hc_get_history_num();
 
 	LOCK_CACHE;
 
@@ -3936,16 +5387,16 @@ void	zbx_log_sync_history_cache_progress(void)
 
 	if (0 == cache->history_progress_ts)
 	{
-		cache->history_num_total = cache->history_num;
+		cache->history_num_total = history_num;
 		cache->history_progress_ts = sec;
 	}
 
-	if (ZBX_HC_SYNC_TIME_MAX <= sec - cache->history_progress_ts || 0 == cache->history_num)
+	if (ZBX_HC_SYNC_TIME_MAX <= sec - cache->history_progress_ts || 0 == history_num)
 	{
 		if (0 != cache->history_num_total)
-			pcnt = 100 * (double)(cache->history_num_total - cache->history_num) / cache->history_num_total;
+			pcnt = 100 * (double)(cache->history_num_total - history_num) / cache->history_num_total;
 
-		cache->history_progress_ts = (0 == cache->history_num ? INT_MAX : sec);
+		cache->history_progress_ts = (0 == history_num ? INT_MAX : sec);
 	}
 
 	ts_next = cache->history_progress_ts;
@@ -3977,13 +5428,25 @@ void	zbx_log_sync_history_cache_progress(void)
  ******************************************************************************/
 void	zbx_sync_history_cache(const zbx_events_funcs_t *events_cbs, int *values_num, int *triggers_num, int *more)
 {
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() history_num:%d", __func__, cache->history_num);
+	static int	downsample_flush_time;
+	int		now;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
 	*values_num = 0;
 	*triggers_num = 0;
 
 	if (0 != (get_program_type_cb() & ZBX_PROGRAM_TYPE_SERVER))
+	{
 		sync_server_history(values_num, triggers_num, events_cbs, more);
+
+		/* the first history syncer writes periods of downsampled items that stopped receiving values */
+		if (1 == hc_syncer_num && downsample_flush_time <= (now = (int)time(NULL)))
+		{
+			hc_downsample_flush(now);
+			downsample_flush_time = now + ZBX_HC_DOWNSAMPLE_FLUSH_INTERVAL;
+		}
+	}
 	else
 		sync_proxy_history(values_num, more);
 }
@@ -4007,6 +5470,58 @@ static void	dc_string_buffer_realloc(size_t len)
 	string_values = (char *)zbx_realloc(string_values, string_values_alloc);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: copies string value into local history cache string buffer        *
+ *                                                                            *
+ * Parameters: str      - [OUT] the string value location in buffer           *
+ *             value    - [IN] the string value                               *
+ *             len      - [IN] the string length including terminating zero   *
+ *             compress - [IN] 1 - compress large strings                     *
+ *                             0 - copy string as is                          *
+ *                                                                            *
+ * Comments: Strings are compressed before locking history cache to reduce    *
+ *           the time spent inside lock and the history cache memory usage.   *
+ *           String is stored as is if compression does not reduce its size.  *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_string_buffer_add(dc_value_str_t *str, const char *value, size_t len, unsigned char compress)
+{
+	str->len = len;
+	str->size = 0;
+
+#if defined(ZBX_HC_COMPRESS_CODEC)
+	if (0 != compress && ZBX_HC_COMPRESS_LEN_MIN <= len)
+	{
+		char	*out;
+		size_t	out_size;
+
+		if (SUCCEED == zbx_compress_ext(ZBX_HC_COMPRESS_CODEC, value, len - 1, &out, &out_size))
+		{
+			if (out_size + sizeof(zbx_hc_str_compressed_t) < len)
+			{
+				dc_string_buffer_realloc(out_size);
+				str->pvalue = string_values_offset;
+				str->size = out_size;
+				memcpy(&string_values[string_values_offset], out, out_size);
+				string_values_offset += out_size;
+				zbx_free(out);
+
+				return;
+			}
+
+			zbx_free(out);
+		}
+	}
+#else
+	ZBX_UNUSED(compress);
+#endif
+	dc_string_buffer_realloc(len);
+	str->pvalue = string_values_offset;
+	memcpy(&string_values[string_values_offset], value, len);
+	string_values_offset += len;
+}
+
 static dc_item_value_t	*dc_local_get_history_slot(void)
 {
 	if (ZBX_MAX_VALUES_LOCAL == item_values_num)
@@ -4089,12 +5604,10 @@ static void	dc_local_add_history_text_bin_helper(unsigned char value_type, zbx_u
 
 	if (0 == (item_value->flags & ZBX_DC_FLAG_NOVALUE))
 	{
-		item_value->value.value_str.len = zbx_db_strlen_n(value_orig, ZBX_HISTORY_VALUE_LEN) + 1;
-		dc_string_buffer_realloc(item_value->value.value_str.len);
-
-		item_value->value.value_str.pvalue = string_values_offset;
-		memcpy(&string_values[string_values_offset], value_orig, item_value->value.value_str.len);
-		string_values_offset += item_value->value.value_str.len;
+		/* binary values are base64 encoded and do not compress well */
+		dc_string_buffer_add(&item_value->value.value_str, value_orig,
+				zbx_db_strlen_n(value_orig, ZBX_HISTORY_VALUE_LEN) + 1,
+				ITEM_VALUE_TYPE_TEXT == value_type);
 	}
 	else
 		item_value->value.value_str.len = 0;
@@ -4139,10 +5652,14 @@ static void	dc_local_add_history_log(zbx_uint64_t itemid, unsigned char item_val
 		item_value->logeventid = log->logeventid;
 		item_value->timestamp = log->timestamp;
 
-		item_value->value.value_str.len = zbx_db_strlen_n(log->value, ZBX_HISTORY_VALUE_LEN) + 1;
+		dc_string_buffer_add(&item_value->value.value_str, log->value,
+				zbx_db_strlen_n(log->value, ZBX_HISTORY_VALUE_LEN) + 1, 1);
 
 		if (NULL != log->source && '\0' != *log->source)
-			item_value->source.len = zbx_db_strlen_n(log->source, ZBX_HISTORY_LOG_SOURCE_LEN) + 1;
+		{
+			dc_string_buffer_add(&item_value->source, log->source,
+					zbx_db_strlen_n(log->source, ZBX_HISTORY_LOG_SOURCE_LEN) + 1, 0);
+		}
 		else
 			item_value->source.len = 0;
 	}
@@ -4151,25 +5668,6 @@ static void	dc_local_add_history_log(zbx_uint64_t itemid, unsigned char item_val
 		item_value->value.value_str.len = 0;
 		item_value->source.len = 0;
 	}
-
-	if (0 != item_value->value.value_str.len + item_value->source.len)
-	{
-		dc_string_buffer_realloc(item_value->value.value_str.len + item_value->source.len);
-
-		if (0 != item_value->value.value_str.len)
-		{
-			item_value->value.value_str.pvalue = string_values_offset;
-			memcpy(&string_values[string_values_offset], log->value, item_value->value.value_str.len);
-			string_values_offset += item_value->value.value_str.len;
-		}
-
-		if (0 != item_value->source.len)
-		{
-			item_value->source.pvalue = string_values_offset;
-			memcpy(&string_values[string_values_offset], log->source, item_value->source.len);
-			string_values_offset += item_value->source.len;
-		}
-	}
 }
 
 static void	dc_local_add_history_notsupported(zbx_uint64_t itemid, const zbx_timespec_t *ts, const char *error,
@@ -4192,11 +5690,7 @@ static void	dc_local_add_history_notsupported(zbx_uint64_t itemid, const zbx_tim
 		item_value->mtime = mtime;
 	}
 
-	item_value->value.value_str.len = zbx_db_strlen_n(error, ZBX_ITEM_ERROR_LEN) + 1;
-	dc_string_buffer_realloc(item_value->value.value_str.len);
-	item_value->value.value_str.pvalue = string_values_offset;
-	memcpy(&string_values[string_values_offset], error, item_value->value.value_str.len);
-	string_values_offset += item_value->value.value_str.len;
+	dc_string_buffer_add(&item_value->value.value_str, error, zbx_db_strlen_n(error, ZBX_ITEM_ERROR_LEN) + 1, 0);
 }
 
 static void	dc_local_add_history_lld(zbx_uint64_t itemid, const zbx_timespec_t *ts, const char *value_orig)
@@ -4211,12 +5705,7 @@ static void	dc_local_add_history_lld(zbx_uint64_t itemid, const zbx_timespec_t *
 	item_value->item_value_type = ITEM_VALUE_TYPE_NONE;
 	item_value->value_type = ITEM_VALUE_TYPE_NONE;
 	item_value->flags = ZBX_DC_FLAG_LLD;
-	item_value->value.value_str.len = strlen(value_orig) + 1;
-
-	dc_string_buffer_realloc(item_value->value.value_str.len);
-	item_value->value.value_str.pvalue = string_values_offset;
-	memcpy(&string_values[string_values_offset], value_orig, item_value->value.value_str.len);
-	string_values_offset += item_value->value.value_str.len;
+	dc_string_buffer_add(&item_value->value.value_str, value_orig, strlen(value_orig) + 1, 0);
 }
 
 static void	dc_local_add_history_empty(zbx_uint64_t itemid, unsigned char item_value_type, const zbx_timespec_t *ts,
@@ -4484,46 +5973,489 @@ void	zbx_dc_add_history_variant(zbx_uint64_t itemid, unsigned char value_type, u
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds local history cache values directly to history cache         *
+ *          shards                                                            *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_flush_history_local(void)
+{
+	int		i;
+	zbx_uint32_t	shards = 0;
+
+	if (1 == cache->shards_num)
+	{
+		LOCK_CACHE;
+		hc_add_item_values(item_values, (int)item_values_num, string_values, 1);
+		UNLOCK_CACHE;
+	}
+	else
+	{
+		for (i = 0; i < (int)item_values_num; i++)
+			shards |= (zbx_uint32_t)1 << hc_get_shard_index(item_values[i].itemid);
+
+		for (i = 0; i < cache->shards_num; i++)
+		{
+			if (0 == (shards & ((zbx_uint32_t)1 << i)))
+				continue;
+
+			hc_lock_shard(i);
+			hc_add_item_values(item_values, (int)item_values_num, string_values, 1);
+			hc_unlock_shard();
+		}
+	}
+}
+
+#if defined(HAVE_ATOMIC_BUILTINS)
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets ingestion ring owned by the current process                  *
+ *                                                                            *
+ * Return value: the ingestion ring or NULL if there are no free rings left   *
+ *                                                                            *
+ * Comments: A free ring is claimed on the first call in each process.        *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_hc_ring_t	*hc_ring_get(void)
+{
+	pid_t	pid;
+	int	i;
+
+	if ((pid = getpid()) == hc_ring_pid)
+		return hc_ring;
+
+	hc_ring_pid = pid;
+	hc_ring = NULL;
+
+	zbx_mutex_lock(ingest_lock);
+
+	for (i = 0; i < hc_ingest->rings_num; i++)
+	{
+		if (0 == hc_ingest->rings[i].pid)
+		{
+			hc_ring = &hc_ingest->rings[i];
+			hc_ring->pid = pid;
+			break;
+		}
+	}
+
+	zbx_mutex_unlock(ingest_lock);
+
+	if (NULL == hc_ring)
+		zabbix_log(LOG_LEVEL_DEBUG, "no free history ingestion rings left");
+
+	return hc_ring;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: writes local history cache values into ingestion ring             *
+ *                                                                            *
+ * Parameters: ring - [IN] the ingestion ring owned by the current process    *
+ *                                                                            *
+ * Return value: SUCCEED - the values were written                            *
+ *               FAIL    - not enough free space in the ring                  *
+ *                                                                            *
+ * Comments: Only the ring owner writes into the ring, so no locking is       *
+ *           required. The values become visible to consumers after the ring  *
+ *           head is updated.                                                 *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_ring_write(zbx_hc_ring_t *ring)
+{
+	zbx_uint64_t		head, pos, size, skip = 0;
+	size_t			values_size;
+	zbx_hc_ring_chunk_t	*chunk;
+
+	values_size = item_values_num * sizeof(dc_item_value_t);
+	size = sizeof(zbx_hc_ring_chunk_t) + values_size + ZBX_HC_RING_ALIGN(string_values_offset);
+
+	head = ring->head;
+	pos = head % hc_ingest->ring_size;
+
+	/* chunks must be contiguous, skip the space left at the end of ring */
+	if (hc_ingest->ring_size - pos < size)
+		skip = hc_ingest->ring_size - pos;
+
+	if (hc_ingest->ring_size - (head - zbx_atomic_load(&ring->tail)) < skip + size)
+		return FAIL;
+
+	if (0 != skip)
+	{
+		chunk = (zbx_hc_ring_chunk_t *)(ring->data + pos);
+		chunk->size = (zbx_uint32_t)skip;
+		chunk->values_num = 0;
+		pos = 0;
+	}
+
+	chunk = (zbx_hc_ring_chunk_t *)(ring->data + pos);
+	chunk->size = (zbx_uint32_t)size;
+	chunk->values_num = (zbx_uint32_t)item_values_num;
+
+	memcpy(chunk + 1, item_values, values_size);
+	memcpy((char *)(chunk + 1) + values_size, string_values, string_values_offset);
+
+	zbx_atomic_store(&ring->head, head + skip + size);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: moves values from ingestion rings into history cache              *
+ *                                                                            *
+ * Parameters: ring - [IN] the ring to drain, NULL - drain all rings          *
+ *                                                                            *
+ * Return value: SUCCEED - the rings were drained                             *
+ *               FAIL    - history cache is full, some values were left in    *
+ *                         the rings                                          *
+ *                                                                            *
+ * Comments: Must be called with ingest lock locked. Each history cache shard *
+ *           is locked once for values collected from all rings. This         *
+ *           function never waits for free history cache space because it     *
+ *           is called by history syncers while holding ingest lock.          *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_ingest_drain(zbx_hc_ring_t *ring)
+{
+	int			i, j, first, last, ret = SUCCEED;
+	zbx_uint32_t		shards = 0;
+	zbx_uint64_t		tail, head;
+	zbx_hc_ring_chunk_t	*chunk;
+	dc_item_value_t		*values;
+	zbx_vector_ptr_t	chunks;
+	zbx_vector_uint64_t	tails;
+
+	if (NULL != ring)
+	{
+		first = last = (int)(ring - hc_ingest->rings);
+	}
+	else
+	{
+		first = 0;
+		last = hc_ingest->rings_num - 1;
+	}
+
+	zbx_vector_ptr_create(&chunks);
+	zbx_vector_uint64_create(&tails);
+
+	for (i = first; i <= last; i++)
+	{
+		ring = &hc_ingest->rings[i];
+		head = zbx_atomic_load(&ring->head);
+
+		for (tail = ring->tail; tail != head; tail += chunk->size)
+		{
+			chunk = (zbx_hc_ring_chunk_t *)(ring->data + tail % hc_ingest->ring_size);
+
+			if (0 == chunk->values_num)
+				continue;
+
+			zbx_vector_ptr_append(&chunks, chunk);
+
+			values = (dc_item_value_t *)(chunk + 1);
+
+			for (j = 0; j < (int)chunk->values_num; j++)
+			{
+				if (0 != values[j].itemid)
+					shards |= (zbx_uint32_t)1 << hc_get_shard_index(values[j].itemid);
+			}
+		}
+
+		zbx_vector_uint64_append(&tails, tail);
+	}
+
+	for (i = 0; i < cache->shards_num && SUCCEED == ret; i++)
+	{
+		if (0 == (shards & ((zbx_uint32_t)1 << i)))
+			continue;
+
+		hc_lock_shard(i);
+
+		for (j = 0; j < chunks.values_num; j++)
+		{
+			chunk = (zbx_hc_ring_chunk_t *)chunks.values[j];
+			values = (dc_item_value_t *)(chunk + 1);
+
+			if (SUCCEED != (ret = hc_add_item_values(values, (int)chunk->values_num,
+					(const char *)(values + chunk->values_num), 0)))
+			{
+				break;
+			}
+		}
+
+		hc_unlock_shard();
+	}
+
+	/* the added values are marked in rings, so on failure the same chunks are processed again later */
+	if (SUCCEED == ret)
+	{
+		for (i = first; i <= last; i++)
+			zbx_atomic_store(&hc_ingest->rings[i].tail, tails.values[i - first]);
+	}
+
+	zbx_vector_uint64_destroy(&tails);
+	zbx_vector_ptr_destroy(&chunks);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if there are values left in ingestion rings                *
+ *                                                                            *
+ * Return value: SUCCEED - there are values in ingestion rings                *
+ *               FAIL    - ingestion rings are empty or disabled              *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_ingest_pending(void)
+{
+	int	i;
+
+	if (NULL == hc_ingest)
+		return FAIL;
+
+	for (i = 0; i < hc_ingest->rings_num; i++)
+	{
+		if (zbx_atomic_load(&hc_ingest->rings[i].tail) != zbx_atomic_load(&hc_ingest->rings[i].head))
+			return SUCCEED;
+	}
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: moves values from ingestion rings into history cache              *
+ *                                                                            *
+ * Comments: Rings are checked without locking, so the ingest lock is taken   *
+ *           only if there are values to move.                                *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_ingest_sync(void)
+{
+	if (SUCCEED != hc_ingest_pending())
+		return;
+
+	zbx_mutex_lock(ingest_lock);
+	(void)hc_ingest_drain(NULL);
+	zbx_mutex_unlock(ingest_lock);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: passes local history cache values through the ingestion ring      *
+ *                                                                            *
+ * Parameters: ring - [IN] the ingestion ring owned by the current process    *
+ *                                                                            *
+ * Comments: If the values do not fit into ring, the ring is drained first to *
+ *           preserve order of item values and then the values are written    *
+ *           either into the ring or directly into history cache.             *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_ingest_flush(zbx_hc_ring_t *ring)
+{
+	if (SUCCEED == hc_ring_write(ring))
+		return;
+
+	zbx_mutex_lock(ingest_lock);
+
+	while (SUCCEED != hc_ingest_drain(ring))
+	{
+		zbx_mutex_unlock(ingest_lock);
+
+		zabbix_log(LOG_LEVEL_DEBUG, "History cache is full. Sleeping for 1 second.");
+		sleep(1);
+
+		zbx_mutex_lock(ingest_lock);
+	}
+
+	zbx_mutex_unlock(ingest_lock);
+
+	if (SUCCEED == hc_ring_write(ring))
+		return;
+
+	zbx_atomic_add(&ring->overflows, 1);
+	dc_flush_history_local();
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: retrieves ingestion ring statistics                               *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_ingest_get_stats(zbx_wcache_info_t *wcache_info)
+{
+	int		i;
+	zbx_uint64_t	tail;
+
+	if (NULL == hc_ingest)
+		return;
+
+	wcache_info->ingest_total = hc_ingest->ring_size * (zbx_uint64_t)hc_ingest->rings_num;
+	wcache_info->ingest_free = wcache_info->ingest_total;
+
+	for (i = 0; i < hc_ingest->rings_num; i++)
+	{
+		/* read tail before head, so the head is never behind it */
+		tail = zbx_atomic_load(&hc_ingest->rings[i].tail);
+		wcache_info->ingest_free -= zbx_atomic_load(&hc_ingest->rings[i].head) - tail;
+		wcache_info->ingest_overflows += zbx_atomic_load(&hc_ingest->rings[i].overflows);
+	}
+}
+
+#else
+
+static int	hc_ingest_pending(void)
+{
+	return FAIL;
+}
+
+static void	hc_ingest_sync(void)
+{
+}
+
+static void	hc_ingest_get_stats(zbx_wcache_info_t *wcache_info)
+{
+	ZBX_UNUSED(wcache_info);
+}
+
+#endif
+
 void	zbx_dc_flush_history(void)
 {
 	if (0 == item_values_num)
 		return;
 
-	LOCK_CACHE;
+#if defined(HAVE_ATOMIC_BUILTINS)
+	if (NULL != hc_ingest && NULL != hc_ring_get())
+		hc_ingest_flush(hc_ring);
+	else
+#endif
+		dc_flush_history_local();
+
+	item_values_num = 0;
+	string_values_offset = 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * history cache storage                                                      *
+ *                                                                            *
+ ******************************************************************************/
+ZBX_SHMEM_FUNC_IMPL(__hc_index, hc_index_mem)
+ZBX_SHMEM_FUNC_IMPL(__hc, hc_mem)
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compares history queue elements                                   *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_queue_elem_compare_func(const void *d1, const void *d2)
+{
+	const zbx_binary_heap_elem_t	*e1 = (const zbx_binary_heap_elem_t *)d1;
+	const zbx_binary_heap_elem_t	*e2 = (const zbx_binary_heap_elem_t *)d2;
+
+	const zbx_hc_item_t	*item1 = (const zbx_hc_item_t *)e1->data;
+	const zbx_hc_item_t	*item2 = (const zbx_hc_item_t *)e2->data;
+
+	/* compare by timestamp of the oldest value */
+	return zbx_timespec_compare(&item1->tail->ts, &item2->tail->ts);
+}
+
+static zbx_hash_t	hc_strpool_hash_func(const void *data)
+{
+	return ZBX_DEFAULT_STRING_HASH_FUNC((const char *)data + ZBX_HC_STRPOOL_REFCOUNT_SIZE);
+}
+
+static int	hc_strpool_compare_func(const void *d1, const void *d2)
+{
+	return strcmp((const char *)d1 + ZBX_HC_STRPOOL_REFCOUNT_SIZE,
+			(const char *)d2 + ZBX_HC_STRPOOL_REFCOUNT_SIZE);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: copies short string value to history cache string pool           *
+ *                                                                            *
+ * Parameters: str - [IN] the string value, not necessarily zero terminated   *
+ *             len - [IN] the string length including terminating zero        *
+ *                                                                            *
+ * Return value: the pooled string or NULL if there was not enough memory     *
+ *                                                                            *
+ * Comments: If the string pool already contains matching string, then its    *
+ *           reference counter is incremented and the string returned.        *
+ *                                                                            *
+ ******************************************************************************/
+static char	*hc_strpool_acquire(const char *str, size_t len)
+{
+	char	key[ZBX_HC_STRPOOL_REFCOUNT_SIZE + ZBX_HC_STRPOOL_STR_MAX];
+	void	*ptr;
+
+	memcpy(key + ZBX_HC_STRPOOL_REFCOUNT_SIZE, str, len - 1);
+	key[ZBX_HC_STRPOOL_REFCOUNT_SIZE + len - 1] = '\0';
 
-	hc_add_item_values(item_values, item_values_num);
+	if (NULL == (ptr = zbx_hashset_search(&hc_shard->strpool, key)))
+	{
+		if (NULL == (ptr = zbx_hashset_insert_ext(&hc_shard->strpool, key, ZBX_HC_STRPOOL_REFCOUNT_SIZE + len,
+				ZBX_HC_STRPOOL_REFCOUNT_SIZE)))
+		{
+			return NULL;
+		}
 
-	cache->history_num += item_values_num;
+		*(zbx_uint32_t *)ptr = 0;
+	}
 
-	UNLOCK_CACHE;
+	(*(zbx_uint32_t *)ptr)++;
 
-	item_values_num = 0;
-	string_values_offset = 0;
+	return (char *)ptr + ZBX_HC_STRPOOL_REFCOUNT_SIZE;
 }
 
 /******************************************************************************
  *                                                                            *
- * history cache storage                                                      *
+ * Purpose: frees string value allocated in history cache                    *
+ *                                                                            *
+ * Parameters: str - [IN] the string value created by hc_mem_value_str_dup()  *
+ *                                                                            *
+ * Comments: Pooled strings are removed from string pool when their reference *
+ *           counter becomes zero.                                            *
  *                                                                            *
  ******************************************************************************/
-ZBX_SHMEM_FUNC_IMPL(__hc_index, hc_index_mem)
-ZBX_SHMEM_FUNC_IMPL(__hc, hc_mem)
+static void	hc_mem_value_str_free(char *str)
+{
+	void	*ptr;
+
+	/* strings are never modified in cache, so short strings are always pooled */
+	if (NULL == memchr(str, '\0', ZBX_HC_STRPOOL_STR_MAX))
+	{
+		__hc_shmem_free_func(str);
+		return;
+	}
+
+	ptr = str - ZBX_HC_STRPOOL_REFCOUNT_SIZE;
+
+	if (0 == --(*(zbx_uint32_t *)ptr))
+		zbx_hashset_remove_direct(&hc_shard->strpool, ptr);
+}
 
 /******************************************************************************
  *                                                                            *
- * Purpose: compares history queue elements                                   *
+ * Purpose: frees text or log value string allocated in history cache         *
+ *                                                                            *
+ * Parameters: str        - [IN] the string value created by                  *
+ *                               hc_mem_value_str_dup()                       *
+ *             compressed - [IN] non-zero if the string is compressed         *
  *                                                                            *
  ******************************************************************************/
-static int	hc_queue_elem_compare_func(const void *d1, const void *d2)
+static void	hc_mem_value_free(char *str, unsigned char compressed)
 {
-	const zbx_binary_heap_elem_t	*e1 = (const zbx_binary_heap_elem_t *)d1;
-	const zbx_binary_heap_elem_t	*e2 = (const zbx_binary_heap_elem_t *)d2;
-
-	const zbx_hc_item_t	*item1 = (const zbx_hc_item_t *)e1->data;
-	const zbx_hc_item_t	*item2 = (const zbx_hc_item_t *)e2->data;
-
-	/* compare by timestamp of the oldest value */
-	return zbx_timespec_compare(&item1->tail->ts, &item2->tail->ts);
+	/* compressed strings are never pooled */
+	if (0 != compressed)
+		__hc_shmem_free_func(str);
+	else
+		hc_mem_value_str_free(str);
 }
 
 /******************************************************************************
@@ -4537,7 +6469,7 @@ static void	hc_free_data(zbx_hc_data_t *data)
 {
 	if (ITEM_STATE_NOTSUPPORTED == data->state)
 	{
-		__hc_shmem_free_func(data->value.str);
+		hc_mem_value_str_free(data->value.str);
 	}
 	else
 	{
@@ -4548,13 +6480,13 @@ static void	hc_free_data(zbx_hc_data_t *data)
 				case ITEM_VALUE_TYPE_STR:
 				case ITEM_VALUE_TYPE_TEXT:
 				case ITEM_VALUE_TYPE_BIN:
-					__hc_shmem_free_func(data->value.str);
+					hc_mem_value_free(data->value.str, data->compressed);
 					break;
 				case ITEM_VALUE_TYPE_LOG:
-					__hc_shmem_free_func(data->value.log->value);
+					hc_mem_value_free(data->value.log->value, data->compressed);
 
 					if (NULL != data->value.log->source)
-						__hc_shmem_free_func(data->value.log->source);
+						hc_mem_value_str_free(data->value.log->source);
 
 					__hc_shmem_free_func(data->value.log);
 					break;
@@ -4583,7 +6515,7 @@ static void	hc_queue_item(zbx_hc_item_t *item)
 {
 	zbx_binary_heap_elem_t	elem = {item->itemid, (const void *)item};
 
-	zbx_binary_heap_insert(&cache->history_queue, &elem);
+	zbx_binary_heap_insert(&hc_shard->history_queue, &elem);
 }
 
 /******************************************************************************
@@ -4598,7 +6530,7 @@ static void	hc_queue_item(zbx_hc_item_t *item)
  ******************************************************************************/
 static zbx_hc_item_t	*hc_get_item(zbx_uint64_t itemid)
 {
-	return (zbx_hc_item_t *)zbx_hashset_search(&cache->history_items, &itemid);
+	return (zbx_hc_item_t *)zbx_hashset_search(&hc_shard->history_items, &itemid);
 }
 
 /******************************************************************************
@@ -4615,26 +6547,52 @@ static zbx_hc_item_t	*hc_add_item(zbx_uint64_t itemid, zbx_hc_data_t *data)
 {
 	zbx_hc_item_t	item_local = {itemid, ZBX_HC_ITEM_STATUS_NORMAL, 0, data, data};
 
-	return (zbx_hc_item_t *)zbx_hashset_insert(&cache->history_items, &item_local, sizeof(item_local));
+	return (zbx_hc_item_t *)zbx_hashset_insert(&hc_shard->history_items, &item_local, sizeof(item_local));
 }
 
 /******************************************************************************
  *                                                                            *
  * Purpose: copies string value to history cache                              *
  *                                                                            *
- * Parameters: str - [IN] the string value                                    *
+ * Parameters: str     - [IN] the string value                                *
+ *             strings - [IN] the string data of item values                  *
  *                                                                            *
  * Return value: the copied string or NULL if there was not enough memory     *
  *                                                                            *
+ * Comments: Short strings are shared through history cache string pool, so   *
+ *           the returned string must be freed with hc_mem_value_str_free().  *
+ *           Compressed strings are copied together with their header and     *
+ *           must be freed with hc_mem_value_free().                          *
+ *                                                                            *
  ******************************************************************************/
-static char	*hc_mem_value_str_dup(const dc_value_str_t *str)
+static char	*hc_mem_value_str_dup(const dc_value_str_t *str, const char *strings)
 {
 	char	*ptr;
 
+	if (0 != str->size)
+	{
+		zbx_hc_str_compressed_t	*header;
+
+		if (NULL == (header = (zbx_hc_str_compressed_t *)__hc_shmem_malloc_func(NULL,
+				sizeof(zbx_hc_str_compressed_t) + str->size)))
+		{
+			return NULL;
+		}
+
+		header->len = (zbx_uint32_t)str->len;
+		header->size = (zbx_uint32_t)str->size;
+		memcpy(header + 1, &strings[str->pvalue], str->size);
+
+		return (char *)header;
+	}
+
+	if (ZBX_HC_STRPOOL_STR_MAX >= str->len)
+		return hc_strpool_acquire(&strings[str->pvalue], str->len);
+
 	if (NULL == (ptr = (char *)__hc_shmem_malloc_func(NULL, str->len)))
 		return NULL;
 
-	memcpy(ptr, &string_values[str->pvalue], str->len - 1);
+	memcpy(ptr, &strings[str->pvalue], str->len - 1);
 	ptr[str->len - 1] = '\0';
 
 	return ptr;
@@ -4644,8 +6602,9 @@ static char	*hc_mem_value_str_dup(const dc_value_str_t *str)
  *                                                                            *
  * Purpose: clones string value into history data memory                      *
  *                                                                            *
- * Parameters: dst - [IN/OUT] a reference to the cloned value                 *
- *             str - [IN] the string value to clone                           *
+ * Parameters: dst     - [IN/OUT] a reference to the cloned value             *
+ *             str     - [IN] the string value to clone                       *
+ *             strings - [IN] the string data of item values                  *
  *                                                                            *
  * Return value: SUCCESS - either there was no need to clone the string       *
  *                         (it was empty or already cloned) or the string was *
@@ -4656,7 +6615,7 @@ static char	*hc_mem_value_str_dup(const dc_value_str_t *str)
  *           until it finishes cloning string value.                          *
  *                                                                            *
  ******************************************************************************/
-static int	hc_clone_history_str_data(char **dst, const dc_value_str_t *str)
+static int	hc_clone_history_str_data(char **dst, const dc_value_str_t *str, const char *strings)
 {
 	if (0 == str->len)
 		return SUCCEED;
@@ -4664,7 +6623,7 @@ static int	hc_clone_history_str_data(char **dst, const dc_value_str_t *str)
 	if (NULL != *dst)
 		return SUCCEED;
 
-	if (NULL != (*dst = hc_mem_value_str_dup(str)))
+	if (NULL != (*dst = hc_mem_value_str_dup(str, strings)))
 		return SUCCEED;
 
 	return FAIL;
@@ -4676,6 +6635,7 @@ static int	hc_clone_history_str_data(char **dst, const dc_value_str_t *str)
  *                                                                            *
  * Parameters: dst        - [IN/OUT] a reference to the cloned value          *
  *             item_value - [IN] the log value to clone                       *
+ *             strings    - [IN] the string data of item values               *
  *                                                                            *
  * Return value: SUCCESS - the log value was cloned successfully              *
  *               FAIL    - not enough memory                                  *
@@ -4684,7 +6644,8 @@ static int	hc_clone_history_str_data(char **dst, const dc_value_str_t *str)
  *           until it finishes cloning log value.                             *
  *                                                                            *
  ******************************************************************************/
-static int	hc_clone_history_log_data(zbx_log_value_t **dst, const dc_item_value_t *item_value)
+static int	hc_clone_history_log_data(zbx_log_value_t **dst, const dc_item_value_t *item_value,
+		const char *strings)
 {
 	if (NULL == *dst)
 	{
@@ -4695,10 +6656,10 @@ static int	hc_clone_history_log_data(zbx_log_value_t **dst, const dc_item_value_
 		memset(*dst, 0, sizeof(zbx_log_value_t));
 	}
 
-	if (SUCCEED != hc_clone_history_str_data(&(*dst)->value, &item_value->value.value_str))
+	if (SUCCEED != hc_clone_history_str_data(&(*dst)->value, &item_value->value.value_str, strings))
 		return FAIL;
 
-	if (SUCCEED != hc_clone_history_str_data(&(*dst)->source, &item_value->source))
+	if (SUCCEED != hc_clone_history_str_data(&(*dst)->source, &item_value->source, strings))
 		return FAIL;
 
 	(*dst)->logeventid = item_value->logeventid;
@@ -4714,6 +6675,7 @@ static int	hc_clone_history_log_data(zbx_log_value_t **dst, const dc_item_value_
  *                                                                            *
  * Parameters: data       - [IN/OUT] a reference to the cloned value          *
  *             item_value - [IN] the item value                               *
+ *             strings    - [IN] the string data of item values               *
  *                                                                            *
  * Return value: SUCCESS - the item value was cloned successfully             *
  *               FAIL    - not enough memory                                  *
@@ -4722,7 +6684,7 @@ static int	hc_clone_history_log_data(zbx_log_value_t **dst, const dc_item_value_
  *           until it finishes cloning item value.                            *
  *                                                                            *
  ******************************************************************************/
-static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *item_value)
+static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *item_value, const char *strings)
 {
 	if (NULL == *data)
 	{
@@ -4744,24 +6706,24 @@ static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *it
 
 	if (ITEM_STATE_NOTSUPPORTED == item_value->state)
 	{
-		if (NULL == ((*data)->value.str = hc_mem_value_str_dup(&item_value->value.value_str)))
+		if (NULL == ((*data)->value.str = hc_mem_value_str_dup(&item_value->value.value_str, strings)))
 			return FAIL;
 
 		(*data)->value_type = item_value->value_type;
-		cache->stats.notsupported_counter++;
+		hc_shard->stats.notsupported_counter++;
 
 		return SUCCEED;
 	}
 
 	if (0 != (ZBX_DC_FLAG_LLD & item_value->flags))
 	{
-		if (NULL == ((*data)->value.str = hc_mem_value_str_dup(&item_value->value.value_str)))
+		if (NULL == ((*data)->value.str = hc_mem_value_str_dup(&item_value->value.value_str, strings)))
 			return FAIL;
 
 		(*data)->value_type = ITEM_VALUE_TYPE_TEXT;
 
-		cache->stats.history_text_counter++;
-		cache->stats.history_counter++;
+		hc_shard->stats.history_text_counter++;
+		hc_shard->stats.history_counter++;
 
 		return SUCCEED;
 	}
@@ -4780,14 +6742,16 @@ static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *it
 			case ITEM_VALUE_TYPE_TEXT:
 			case ITEM_VALUE_TYPE_BIN:
 				if (SUCCEED != hc_clone_history_str_data(&(*data)->value.str,
-						&item_value->value.value_str))
+						&item_value->value.value_str, strings))
 				{
 					return FAIL;
 				}
+				(*data)->compressed = (0 != item_value->value.value_str.size);
 				break;
 			case ITEM_VALUE_TYPE_LOG:
-				if (SUCCEED != hc_clone_history_log_data(&(*data)->value.log, item_value))
+				if (SUCCEED != hc_clone_history_log_data(&(*data)->value.log, item_value, strings))
 					return FAIL;
+				(*data)->compressed = (0 != item_value->value.value_str.size);
 				break;
 			case ITEM_VALUE_TYPE_NONE:
 			default:
@@ -4798,22 +6762,22 @@ static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *it
 		switch (item_value->item_value_type)
 		{
 			case ITEM_VALUE_TYPE_FLOAT:
-				cache->stats.history_float_counter++;
+				hc_shard->stats.history_float_counter++;
 				break;
 			case ITEM_VALUE_TYPE_UINT64:
-				cache->stats.history_uint_counter++;
+				hc_shard->stats.history_uint_counter++;
 				break;
 			case ITEM_VALUE_TYPE_STR:
-				cache->stats.history_str_counter++;
+				hc_shard->stats.history_str_counter++;
 				break;
 			case ITEM_VALUE_TYPE_TEXT:
-				cache->stats.history_text_counter++;
+				hc_shard->stats.history_text_counter++;
 				break;
 			case ITEM_VALUE_TYPE_LOG:
-				cache->stats.history_log_counter++;
+				hc_shard->stats.history_log_counter++;
 				break;
 			case ITEM_VALUE_TYPE_BIN:
-				cache->stats.history_bin_counter++;
+				hc_shard->stats.history_bin_counter++;
 				break;
 			case ITEM_VALUE_TYPE_NONE:
 			default:
@@ -4821,7 +6785,7 @@ static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *it
 				exit(EXIT_FAILURE);
 		}
 
-		cache->stats.history_counter++;
+		hc_shard->stats.history_counter++;
 	}
 
 	(*data)->value_type = item_value->value_type;
@@ -4831,28 +6795,73 @@ static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *it
 
 /******************************************************************************
  *                                                                            *
- * Purpose: adds item values to the history cache                             *
+ * Purpose: frees partially cloned item value                                 *
+ *                                                                            *
+ * Parameters: data       - [IN] the partially cloned value                   *
+ *             item_value - [IN] the item value being cloned                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_free_partial_data(zbx_hc_data_t *data, const dc_item_value_t *item_value)
+{
+	/* only log values can be left partially cloned after failing to allocate memory */
+	if (ITEM_STATE_NOTSUPPORTED != item_value->state &&
+			0 == (item_value->flags & (ZBX_DC_FLAG_LLD | ZBX_DC_FLAG_NOVALUE)) &&
+			ITEM_VALUE_TYPE_LOG == item_value->value_type && NULL != data->value.log)
+	{
+		if (NULL != data->value.log->value)
+			hc_mem_value_free(data->value.log->value, 0 != item_value->value.value_str.size);
+
+		if (NULL != data->value.log->source)
+			hc_mem_value_str_free(data->value.log->source);
+
+		__hc_shmem_free_func(data->value.log);
+	}
+
+	__hc_shmem_free_func(data);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds item values to the locked history cache shard                *
  *                                                                            *
- * Parameters: values     - [IN] the item values to add                       *
+ * Parameters: values     - [IN/OUT] the item values to add                   *
  *             values_num - [IN] the number of item values to add             *
+ *             strings    - [IN] the string data of item values               *
+ *             wait       - [IN] 1 - wait for free space if history cache is  *
+ *                                   full                                     *
+ *                               0 - fail if history cache is full            *
  *                                                                            *
- * Comments: If the history cache is full this function will wait until       *
- *           history syncers processes values freeing enough space to store   *
- *           the new value.                                                   *
+ * Return value: SUCCEED - the values were added                              *
+ *               FAIL    - history cache is full (only when not waiting)      *
+ *                                                                            *
+ * Comments: Values of items belonging to other shards are skipped.           *
+ *           The added values are marked by resetting their item identifiers, *
+ *           so the same values can be passed again after failure.            *
+ *           If the history cache is full and waiting is requested this       *
+ *           function will wait until history syncers processes values        *
+ *           freeing enough space to store the new value.                     *
  *                                                                            *
  ******************************************************************************/
-static void	hc_add_item_values(dc_item_value_t *values, int values_num)
+static int	hc_add_item_values(dc_item_value_t *values, int values_num, const char *strings, int wait)
 {
 	dc_item_value_t	*item_value;
-	int		i;
+	int		i, shard_index;
 	zbx_hc_item_t	*item;
 
+	shard_index = (int)(hc_shard - cache->shards);
+
 	for (i = 0; i < values_num; i++)
 	{
 		zbx_hc_data_t	*data = NULL;
 
 		item_value = &values[i];
 
+		if (0 == item_value->itemid)
+			continue;
+
+		if (1 != cache->shards_num && shard_index != hc_get_shard_index(item_value->itemid))
+			continue;
+
 		/* a record with metadata and no value can be dropped if  */
 		/* the metadata update is copied to the last queued value */
 		if (NULL != (item = hc_get_item(item_value->itemid)) &&
@@ -4866,22 +6875,31 @@ static void	hc_add_item_values(dc_item_value_t *values, int values_num)
 				item->head->lastlogsize = item_value->lastlogsize;
 				item->head->mtime = item_value->mtime;
 				item->head->flags |= ZBX_DC_FLAG_META;
+				item_value->itemid = 0;
 				continue;
 			}
 		}
 
-		if (SUCCEED != hc_clone_history_data(&data, item_value))
+		if (SUCCEED != hc_clone_history_data(&data, item_value, strings))
 		{
+			if (0 == wait)
+			{
+				if (NULL != data)
+					hc_free_partial_data(data, item_value);
+
+				return FAIL;
+			}
+
 			do
 			{
-				UNLOCK_CACHE;
+				hc_unlock_shard();
 
 				zabbix_log(LOG_LEVEL_DEBUG, "History cache is full. Sleeping for 1 second.");
 				sleep(1);
 
-				LOCK_CACHE;
+				hc_lock_shard(shard_index);
 			}
-			while (SUCCEED != hc_clone_history_data(&data, item_value));
+			while (SUCCEED != hc_clone_history_data(&data, item_value, strings));
 
 			item = hc_get_item(item_value->itemid);
 		}
@@ -4897,7 +6915,51 @@ static void	hc_add_item_values(dc_item_value_t *values, int values_num)
 			item->head = data;
 		}
 		item->values_num++;
+		hc_shard->history_num++;
+		item_value->itemid = 0;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: copies text or log value string from history cache                *
+ *                                                                            *
+ * Parameters: str        - [IN] the string value created by                  *
+ *                               hc_mem_value_str_dup()                       *
+ *             compressed - [IN] non-zero if the string is compressed         *
+ *                                                                            *
+ * Return value: the uncompressed copy of string value                        *
+ *                                                                            *
+ ******************************************************************************/
+static char	*hc_mem_value_copy(const char *str, unsigned char compressed)
+{
+	const zbx_hc_str_compressed_t	*header;
+	char				*out;
+	size_t				size;
+
+	if (0 == compressed)
+		return zbx_strdup(NULL, str);
+
+	header = (const zbx_hc_str_compressed_t *)str;
+	out = (char *)zbx_malloc(NULL, header->len);
+	size = header->len - 1;
+
+#if defined(ZBX_HC_COMPRESS_CODEC)
+	if (SUCCEED != zbx_uncompress_ext(ZBX_HC_COMPRESS_CODEC, (const char *)(header + 1), header->size, out,
+			&size))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot uncompress history cache value: %s", zbx_compress_strerror());
+		size = 0;
 	}
+#else
+	THIS_SHOULD_NEVER_HAPPEN;
+	size = 0;
+#endif
+	out[size] = '\0';
+
+	return out;
 }
 
 /******************************************************************************
@@ -4943,11 +7005,11 @@ static void	hc_copy_history_data(zbx_dc_history_t *history, zbx_uint64_t itemid,
 			case ITEM_VALUE_TYPE_STR:
 			case ITEM_VALUE_TYPE_TEXT:
 			case ITEM_VALUE_TYPE_BIN:
-				history->value.str = zbx_strdup(NULL, data->value.str);
+				history->value.str = hc_mem_value_copy(data->value.str, data->compressed);
 				break;
 			case ITEM_VALUE_TYPE_LOG:
 				history->value.log = (zbx_log_value_t *)zbx_malloc(NULL, sizeof(zbx_log_value_t));
-				history->value.log->value = zbx_strdup(NULL, data->value.log->value);
+				history->value.log->value = hc_mem_value_copy(data->value.log->value, data->compressed);
 
 				if (NULL != data->value.log->source)
 					history->value.log->source = zbx_strdup(NULL, data->value.log->source);
@@ -4975,20 +7037,38 @@ static void	hc_copy_history_data(zbx_dc_history_t *history, zbx_uint64_t itemid,
  *                                                                            *
  * Comments: The history_items must be returned back to history cache with    *
  *           hc_push_items() function after they have been processed.         *
+ *           Items are taken from the shard owned by history syncer first,    *
+ *           the remaining batch space is filled from the following shards.   *
  *                                                                            *
  ******************************************************************************/
 static void	hc_pop_items(zbx_vector_ptr_t *history_items)
 {
 	zbx_binary_heap_elem_t	*elem;
 	zbx_hc_item_t		*item;
+	int			i;
 
-	while (ZBX_HC_SYNC_MAX > history_items->values_num && FAIL == zbx_binary_heap_empty(&cache->history_queue))
+	for (i = 0; i < cache->shards_num && hc_sync_batch > history_items->values_num; i++)
 	{
-		elem = zbx_binary_heap_find_min(&cache->history_queue);
-		item = (zbx_hc_item_t *)elem->data;
-		zbx_vector_ptr_append(history_items, item);
+		hc_lock_shard((hc_sync_shard + i) % cache->shards_num);
+
+		while (hc_sync_batch > history_items->values_num &&
+				FAIL == zbx_binary_heap_empty(&hc_shard->history_queue))
+		{
+			elem = zbx_binary_heap_find_min(&hc_shard->history_queue);
+			item = (zbx_hc_item_t *)elem->data;
+			zbx_vector_ptr_append(history_items, item);
+
+			zbx_binary_heap_remove_min(&hc_shard->history_queue);
+		}
+
+		hc_unlock_shard();
+	}
 
-		zbx_binary_heap_remove_min(&cache->history_queue);
+	/* rotate between owned shards so that shards without own syncer are processed too */
+	if (0 != hc_sync_shard_step)
+	{
+		if (cache->shards_num <= (hc_sync_shard += hc_sync_shard_step))
+			hc_sync_shard = hc_sync_shard_home;
 	}
 }
 
@@ -5032,32 +7112,53 @@ static void	hc_get_item_values(zbx_dc_history_t *history, zbx_vector_ptr_t *hist
  ******************************************************************************/
 void	hc_push_items(zbx_vector_ptr_t *history_items)
 {
-	int		i;
+	int		i, shard_index;
+	zbx_uint32_t	shards = 0;
 	zbx_hc_item_t	*item;
 	zbx_hc_data_t	*data_free;
 
 	for (i = 0; i < history_items->values_num; i++)
 	{
 		item = (zbx_hc_item_t *)history_items->values[i];
+		shards |= (zbx_uint32_t)1 << hc_get_shard_index(item->itemid);
+	}
+
+	for (shard_index = 0; shard_index < cache->shards_num; shard_index++)
+	{
+		if (0 == (shards & ((zbx_uint32_t)1 << shard_index)))
+			continue;
+
+		hc_lock_shard(shard_index);
 
-		switch (item->status)
+		for (i = 0; i < history_items->values_num; i++)
 		{
-			case ZBX_HC_ITEM_STATUS_BUSY:
-				/* reset item status before returning it to queue */
-				item->status = ZBX_HC_ITEM_STATUS_NORMAL;
-				hc_queue_item(item);
-				break;
-			case ZBX_HC_ITEM_STATUS_NORMAL:
-				item->values_num--;
-				data_free = item->tail;
-				item->tail = item->tail->next;
-				hc_free_data(data_free);
-				if (NULL == item->tail)
-					zbx_hashset_remove(&cache->history_items, item);
-				else
+			item = (zbx_hc_item_t *)history_items->values[i];
+
+			if (1 != cache->shards_num && shard_index != hc_get_shard_index(item->itemid))
+				continue;
+
+			switch (item->status)
+			{
+				case ZBX_HC_ITEM_STATUS_BUSY:
+					/* reset item status before returning it to queue */
+					item->status = ZBX_HC_ITEM_STATUS_NORMAL;
 					hc_queue_item(item);
-				break;
+					break;
+				case ZBX_HC_ITEM_STATUS_NORMAL:
+					item->values_num--;
+					hc_shard->history_num--;
+					data_free = item->tail;
+					item->tail = item->tail->next;
+					hc_free_data(data_free);
+					if (NULL == item->tail)
+						zbx_hashset_remove(&hc_shard->history_items, item);
+					else
+						hc_queue_item(item);
+					break;
+			}
 		}
+
+		hc_unlock_shard();
 	}
 }
 
@@ -5068,7 +7169,35 @@ void	hc_push_items(zbx_vector_ptr_t *history_items)
  ******************************************************************************/
 int	hc_queue_get_size(void)
 {
-	return cache->history_queue.elems_num;
+	int	i, size = 0;
+
+	for (i = 0; i < cache->shards_num; i++)
+	{
+		hc_lock_shard(i);
+		size += hc_shard->history_queue.elems_num;
+		hc_unlock_shard();
+	}
+
+	return size;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: retrieve the number of values in history cache                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_get_history_num(void)
+{
+	int	i, history_num = 0;
+
+	for (i = 0; i < cache->shards_num; i++)
+	{
+		hc_lock_shard(i);
+		history_num += hc_shard->history_num;
+		hc_unlock_shard();
+	}
+
+	return history_num;
 }
 
 int	hc_get_history_compression_age(void)
@@ -5123,6 +7252,10 @@ static int	init_trend_cache(zbx_uint64_t trends_cache_size, char **error)
 
 	cache->trends_num = 0;
 	cache->trends_last_cleanup_hour = 0;
+	cache->trends_queue = NULL;
+	cache->trends_queue_num = 0;
+	cache->trends_queue_alloc = 0;
+	cache->trend_writers_num = 0;
 
 #define INIT_HASHSET_SIZE	100	/* Should be calculated dynamically based on trends size? */
 					/* Still does not make sense to have it more than initial */
@@ -5145,11 +7278,12 @@ out:
  *                                                                            *
  ******************************************************************************/
 int	zbx_init_database_cache(zbx_get_program_type_f get_program_type, zbx_uint64_t history_cache_size,
-		zbx_uint64_t history_index_cache_size,zbx_uint64_t trends_cache_size, char **error)
+		zbx_uint64_t history_index_cache_size, zbx_uint64_t trends_cache_size, int history_cache_shards,
+		char **error)
 {
-	int	ret;
+	int	ret, i;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() shards:%d", __func__, history_cache_shards);
 
 	get_program_type_cb = get_program_type;
 
@@ -5159,36 +7293,86 @@ int	zbx_init_database_cache(zbx_get_program_type_f get_program_type, zbx_uint64_
 		goto out;
 	}
 
+	if (1 > history_cache_shards || ZBX_HC_SHARDS_MAX < history_cache_shards)
+	{
+		*error = zbx_dsprintf(*error, "invalid number of history cache shards %d", history_cache_shards);
+		ret = FAIL;
+		goto out;
+	}
+
+	if (ZBX_HC_SHARD_SIZE_MIN > history_cache_size / (zbx_uint64_t)history_cache_shards ||
+			ZBX_HC_SHARD_SIZE_MIN > history_index_cache_size / (zbx_uint64_t)history_cache_shards)
+	{
+		*error = zbx_dsprintf(*error, "\"HistoryCacheSize\" and \"HistoryIndexCacheSize\" must be at least "
+				ZBX_FS_UI64 " bytes per history cache shard", ZBX_HC_SHARD_SIZE_MIN);
+		ret = FAIL;
+		goto out;
+	}
+
 	if (SUCCEED != (ret = zbx_mutex_create(&cache_lock, ZBX_MUTEX_CACHE, error)))
 		goto out;
 
 	if (SUCCEED != (ret = zbx_mutex_create(&cache_ids_lock, ZBX_MUTEX_CACHE_IDS, error)))
 		goto out;
 
-	if (SUCCEED != (ret = zbx_shmem_create(&hc_mem, history_cache_size, "history cache",
-			"HistoryCacheSize", 1, error)))
+	hc_shard_lock[0] = cache_lock;
+
+	for (i = 1; i < history_cache_shards; i++)
 	{
-		goto out;
+		if (SUCCEED != (ret = zbx_mutex_create(&hc_shard_lock[i], ZBX_MUTEX_CACHE_SHARD + i - 1, error)))
+			goto out;
 	}
 
-	if (SUCCEED != (ret = zbx_shmem_create(&hc_index_mem, history_index_cache_size, "history index cache",
-			"HistoryIndexCacheSize", 0, error)))
+	for (i = 0; i < history_cache_shards; i++)
 	{
-		goto out;
+		if (SUCCEED != (ret = zbx_shmem_create(&hc_shard_mem[i],
+				history_cache_size / (zbx_uint64_t)history_cache_shards, "history cache",
+				"HistoryCacheSize", 1, error)))
+		{
+			goto out;
+		}
+
+		if (SUCCEED != (ret = zbx_shmem_create(&hc_shard_index_mem[i],
+				history_index_cache_size / (zbx_uint64_t)history_cache_shards, "history index cache",
+				"HistoryIndexCacheSize", 0, error)))
+		{
+			goto out;
+		}
 	}
 
+	/* the data not bound to shards is stored in the first shard and protected by its lock */
+	hc_index_mem = hc_shard_index_mem[0];
+
 	cache = (ZBX_DC_CACHE *)__hc_index_shmem_malloc_func(NULL, sizeof(ZBX_DC_CACHE));
 	memset(cache, 0, sizeof(ZBX_DC_CACHE));
 
 	ids = (ZBX_DC_IDS *)__hc_index_shmem_malloc_func(NULL, sizeof(ZBX_DC_IDS));
 	memset(ids, 0, sizeof(ZBX_DC_IDS));
 
-	zbx_hashset_create_ext(&cache->history_items, ZBX_HC_ITEMS_INIT_SIZE,
-			ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC, NULL,
-			__hc_index_shmem_malloc_func, __hc_index_shmem_realloc_func, __hc_index_shmem_free_func);
+	cache->shards_num = history_cache_shards;
 
-	zbx_binary_heap_create_ext(&cache->history_queue, hc_queue_elem_compare_func, ZBX_BINARY_HEAP_OPTION_EMPTY,
-			__hc_index_shmem_malloc_func, __hc_index_shmem_realloc_func, __hc_index_shmem_free_func);
+	for (i = 0; i < history_cache_shards; i++)
+	{
+		hc_select_shard(i);
+
+		zbx_hashset_create_ext(&hc_shard->history_items, ZBX_HC_ITEMS_INIT_SIZE / history_cache_shards,
+				ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC, NULL,
+				__hc_index_shmem_malloc_func, __hc_index_shmem_realloc_func,
+				__hc_index_shmem_free_func);
+
+		zbx_binary_heap_create_ext(&hc_shard->history_queue, hc_queue_elem_compare_func,
+				ZBX_BINARY_HEAP_OPTION_EMPTY, __hc_index_shmem_malloc_func,
+				__hc_index_shmem_realloc_func, __hc_index_shmem_free_func);
+
+		zbx_hashset_create_ext(&hc_shard->downsample, 0, ZBX_DEFAULT_UINT64_HASH_FUNC,
+				ZBX_DEFAULT_UINT64_COMPARE_FUNC, NULL, __hc_index_shmem_malloc_func,
+				__hc_index_shmem_realloc_func, __hc_index_shmem_free_func);
+
+		zbx_hashset_create_ext(&hc_shard->strpool, 0, hc_strpool_hash_func, hc_strpool_compare_func, NULL,
+				__hc_shmem_malloc_func, __hc_shmem_realloc_func, __hc_shmem_free_func);
+	}
+
+	hc_select_shard(0);
 
 	if (0 != (get_program_type_cb() & ZBX_PROGRAM_TYPE_SERVER))
 	{
@@ -5211,6 +7395,7 @@ int	zbx_init_database_cache(zbx_get_program_type_f get_program_type, zbx_uint64_
 	cache->db_trigger_queue_lock = 1;
 
 	cache->proxy_history_count = 0;
+	cache->syncers_active = 0;
 
 	if (NULL == sql)
 		sql = (char *)zbx_malloc(sql, sql_alloc);
@@ -5220,6 +7405,87 @@ out:
 	return ret;
 }
 
+#if defined(HAVE_ATOMIC_BUILTINS)
+ZBX_SHMEM_FUNC1_IMPL_MALLOC(__hc_ring, hc_ring_mem)
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: allocates shared memory for history ingestion rings               *
+ *                                                                            *
+ * Parameters: ring_size - [IN] the size of each ring, 0 - rings are disabled *
+ *             rings_num - [IN] the number of rings                           *
+ *             error     - [OUT] the error message                            *
+ *                                                                            *
+ * Return value: SUCCEED - the rings were initialized or are disabled         *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: One ring is used by each process adding values to history cache. *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_init_history_ingest(zbx_uint64_t ring_size, int rings_num, char **error)
+{
+	int	ret = SUCCEED;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() ring_size:" ZBX_FS_UI64 " rings_num:%d", __func__, ring_size,
+			rings_num);
+
+	if (0 == ring_size || 0 >= rings_num || NULL != hc_ingest)
+		goto out;
+#if defined(HAVE_ATOMIC_BUILTINS)
+	{
+		int	i;
+		size_t	meta_size, size;
+		char	*data;
+
+		if (ZBX_HC_RING_SIZE_MIN > ring_size)
+		{
+			*error = zbx_dsprintf(*error, "\"HistoryIngestRingSize\" must be 0 or at least " ZBX_FS_UI64
+					" bytes", ZBX_HC_RING_SIZE_MIN);
+			ret = FAIL;
+			goto out;
+		}
+
+		ring_size &= ~__UINT64_C(7);
+
+		meta_size = ZBX_HC_RING_ALIGN(sizeof(zbx_hc_ingest_t) + (size_t)rings_num * sizeof(zbx_hc_ring_t));
+		size = zbx_shmem_required_size(2, "history ingestion rings", "HistoryIngestRingSize") + meta_size +
+				ring_size * (zbx_uint64_t)rings_num;
+
+		if (SUCCEED != (ret = zbx_mutex_create(&ingest_lock, ZBX_MUTEX_CACHE_INGEST, error)))
+			goto out;
+
+		if (SUCCEED != (ret = zbx_shmem_create(&hc_ring_mem, size, "history ingestion rings",
+				"HistoryIngestRingSize", 0, error)))
+		{
+			goto out;
+		}
+
+		hc_ingest = (zbx_hc_ingest_t *)__hc_ring_shmem_malloc_func(NULL, meta_size);
+		hc_ingest->rings = (zbx_hc_ring_t *)(hc_ingest + 1);
+		hc_ingest->rings_num = rings_num;
+		hc_ingest->ring_size = ring_size;
+
+		data = (char *)__hc_ring_shmem_malloc_func(NULL, ring_size * (zbx_uint64_t)rings_num);
+		memset(hc_ingest->rings, 0, (size_t)rings_num * sizeof(zbx_hc_ring_t));
+
+		for (i = 0; i < rings_num; i++)
+			hc_ingest->rings[i].data = data + (zbx_uint64_t)i * ring_size;
+
+		hc_ring = NULL;
+		hc_ring_pid = 0;
+	}
+#else
+	ZBX_UNUSED(error);
+	zabbix_log(LOG_LEVEL_WARNING, "history ingestion rings are disabled: compiler does not support"
+			" '__atomic' builtins");
+#endif
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: change proxy_history_count by count                               *
@@ -5277,6 +7543,8 @@ static void	DCsync_all(const zbx_events_funcs_t *events_cbs)
 	if (0 != (get_program_type_cb() & ZBX_PROGRAM_TYPE_SERVER))
 		DCsync_trends();
 
+	zbx_hc_modules_stop();
+
 	zabbix_log(LOG_LEVEL_DEBUG, "End of DCsync_all()");
 }
 
@@ -5287,21 +7555,43 @@ static void	DCsync_all(const zbx_events_funcs_t *events_cbs)
  ******************************************************************************/
 void	zbx_free_database_cache(int sync, const zbx_events_funcs_t *events_cbs)
 {
+	int	i;
+
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
 	if (ZBX_SYNC_ALL == sync)
 		DCsync_all(events_cbs);
 
-	cache = NULL;
+	zbx_free_proxy_buffer(sync);
+
+	for (i = 0; i < cache->shards_num; i++)
+	{
+		zbx_shmem_destroy(hc_shard_mem[i]);
+		hc_shard_mem[i] = NULL;
+		zbx_shmem_destroy(hc_shard_index_mem[i]);
+		hc_shard_index_mem[i] = NULL;
+
+		if (0 != i)
+			zbx_mutex_destroy(&hc_shard_lock[i]);
+	}
 
-	zbx_shmem_destroy(hc_mem);
+	cache = NULL;
+	hc_shard = NULL;
 	hc_mem = NULL;
-	zbx_shmem_destroy(hc_index_mem);
 	hc_index_mem = NULL;
 
 	zbx_mutex_destroy(&cache_lock);
 	zbx_mutex_destroy(&cache_ids_lock);
 
+	if (NULL != hc_ingest)
+	{
+		zbx_shmem_destroy(hc_ring_mem);
+		hc_ring_mem = NULL;
+		hc_ingest = NULL;
+		hc_ring = NULL;
+		zbx_mutex_destroy(&ingest_lock);
+	}
+
 	if (0 != (get_program_type_cb() & ZBX_PROGRAM_TYPE_SERVER))
 	{
 		zbx_shmem_destroy(trend_mem);
@@ -5420,12 +7710,20 @@ out:
  ******************************************************************************/
 void	zbx_hc_get_diag_stats(zbx_uint64_t *items_num, zbx_uint64_t *values_num)
 {
-	LOCK_CACHE;
+	int	i;
 
-	*values_num = cache->history_num;
-	*items_num = cache->history_items.num_data;
+	*values_num = 0;
+	*items_num = 0;
 
-	UNLOCK_CACHE;
+	for (i = 0; i < cache->shards_num; i++)
+	{
+		hc_lock_shard(i);
+
+		*values_num += (zbx_uint64_t)hc_shard->history_num;
+		*items_num += (zbx_uint64_t)hc_shard->history_items.num_data;
+
+		hc_unlock_shard();
+	}
 }
 
 /******************************************************************************
@@ -5433,17 +7731,55 @@ void	zbx_hc_get_diag_stats(zbx_uint64_t *items_num, zbx_uint64_t *values_num)
  * Purpose: get shared memory allocator statistics                            *
  *                                                                            *
  ******************************************************************************/
+static void	hc_shmem_stats_add(zbx_shmem_stats_t *dst, const zbx_shmem_stats_t *src, int first)
+{
+	int	i;
+
+	if (SUCCEED == first)
+	{
+		*dst = *src;
+		return;
+	}
+
+	dst->free_size += src->free_size;
+	dst->used_size += src->used_size;
+	dst->overhead += src->overhead;
+	dst->free_chunks += src->free_chunks;
+	dst->used_chunks += src->used_chunks;
+
+	if (dst->min_chunk_size > src->min_chunk_size)
+		dst->min_chunk_size = src->min_chunk_size;
+
+	if (dst->max_chunk_size < src->max_chunk_size)
+		dst->max_chunk_size = src->max_chunk_size;
+
+	for (i = 0; i < ZBX_SHMEM_BUCKET_COUNT; i++)
+		dst->chunks_num[i] += src->chunks_num[i];
+}
+
 void	zbx_hc_get_mem_stats(zbx_shmem_stats_t *data, zbx_shmem_stats_t *index)
 {
-	LOCK_CACHE;
+	int			i;
+	zbx_shmem_stats_t	stats;
 
-	if (NULL != data)
-		zbx_shmem_get_stats(hc_mem, data);
+	for (i = 0; i < cache->shards_num; i++)
+	{
+		hc_lock_shard(i);
 
-	if (NULL != index)
-		zbx_shmem_get_stats(hc_index_mem, index);
+		if (NULL != data)
+		{
+			zbx_shmem_get_stats(hc_mem, &stats);
+			hc_shmem_stats_add(data, &stats, 0 == i ? SUCCEED : FAIL);
+		}
 
-	UNLOCK_CACHE;
+		if (NULL != index)
+		{
+			zbx_shmem_get_stats(hc_index_mem, &stats);
+			hc_shmem_stats_add(index, &stats, 0 == i ? SUCCEED : FAIL);
+		}
+
+		hc_unlock_shard();
+	}
 }
 
 /******************************************************************************
@@ -5455,19 +7791,23 @@ void	zbx_hc_get_items(zbx_vector_uint64_pair_t *items)
 {
 	zbx_hashset_iter_t	iter;
 	zbx_hc_item_t		*item;
+	int			i;
 
-	LOCK_CACHE;
+	for (i = 0; i < cache->shards_num; i++)
+	{
+		hc_lock_shard(i);
 
-	zbx_vector_uint64_pair_reserve(items, cache->history_items.num_data);
+		zbx_vector_uint64_pair_reserve(items, (size_t)(items->values_num + hc_shard->history_items.num_data));
 
-	zbx_hashset_iter_reset(&cache->history_items, &iter);
-	while (NULL != (item = (zbx_hc_item_t *)zbx_hashset_iter_next(&iter)))
-	{
-		zbx_uint64_pair_t	pair = {item->itemid, item->values_num};
-		zbx_vector_uint64_pair_append_ptr(items, &pair);
-	}
+		zbx_hashset_iter_reset(&hc_shard->history_items, &iter);
+		while (NULL != (item = (zbx_hc_item_t *)zbx_hashset_iter_next(&iter)))
+		{
+			zbx_uint64_pair_t	pair = {item->itemid, item->values_num};
+			zbx_vector_uint64_pair_append_ptr(items, &pair);
+		}
 
-	UNLOCK_CACHE;
+		hc_unlock_shard();
+	}
 }
 
 /******************************************************************************
@@ -5580,14 +7920,23 @@ static void	zbx_hc_proxyqueue_clear(void)
  ******************************************************************************/
 int	zbx_hc_check_proxy(zbx_uint64_t proxyid)
 {
-	double	hc_pused;
-	int	ret;
+	double	hc_pused = 0, pused;
+	int	ret, i;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() proxyid:"ZBX_FS_UI64, __func__, proxyid);
 
-	LOCK_CACHE;
+	/* proxy data is spread through all shards, so the fullest shard is checked, */
+	/* the first shard is left locked for proxy queue processing                */
+	for (i = cache->shards_num - 1; 0 <= i; i--)
+	{
+		hc_lock_shard(i);
 
-	hc_pused = 100 * (double)(hc_mem->total_size - hc_mem->free_size) / hc_mem->total_size;
+		if (hc_pused < (pused = 100 * (double)(hc_mem->total_size - hc_mem->free_size) / hc_mem->total_size))
+			hc_pused = pused;
+
+		if (0 != i)
+			hc_unlock_shard();
+	}
 
 	if (20 >= hc_pused)
 	{
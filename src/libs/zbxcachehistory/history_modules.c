@@ -0,0 +1,448 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "history_modules.h"
+
+#include "zbxcachehistory.h"
+#include "zbxmodules.h"
+#include "log.h"
+#include "zbxstr.h"
+
+#define HC_MODULE_QUEUE_MAX		16	/* maximum number of history batches queued for a module */
+#define HC_MODULE_WARNING_PERIOD	SEC_PER_MIN
+
+/* history batch copied for asynchronous module */
+typedef struct
+{
+	zbx_history_columns_t	columns;
+}
+hc_module_batch_t;
+
+typedef struct
+{
+	const zbx_history_write_cbs_v2_t	*cbs;
+	pthread_t				thread;
+	pthread_mutex_t				lock;
+	pthread_cond_t				event;
+	hc_module_batch_t			*queue[HC_MODULE_QUEUE_MAX];
+	int					queue_head;
+	int					queue_num;
+	int					stop;
+	int					started;
+	zbx_uint64_t				dropped_num;
+	time_t					last_warning;
+}
+hc_module_worker_t;
+
+static hc_module_worker_t	*workers;
+static int			workers_num = -1;
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: passes history to module callbacks                                *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_module_history_write(const zbx_history_write_cbs_v2_t *cbs, const zbx_history_columns_t *columns)
+{
+	if (NULL != cbs->cbs.history_float_cb && 0 != columns->history_float.values_num)
+		cbs->cbs.history_float_cb(&columns->history_float);
+
+	if (NULL != cbs->cbs.history_integer_cb && 0 != columns->history_integer.values_num)
+		cbs->cbs.history_integer_cb(&columns->history_integer);
+
+	if (NULL != cbs->cbs.history_string_cb && 0 != columns->history_string.values_num)
+		cbs->cbs.history_string_cb(&columns->history_string);
+
+	if (NULL != cbs->cbs.history_text_cb && 0 != columns->history_text.values_num)
+		cbs->cbs.history_text_cb(&columns->history_text);
+
+	if (NULL != cbs->cbs.history_log_cb && 0 != columns->history_log.values_num)
+		cbs->cbs.history_log_cb(&columns->history_log);
+}
+
+static void	*hc_memdup(const void *src, size_t size)
+{
+	void	*dst;
+
+	dst = zbx_malloc(NULL, 0 != size ? size : 1);
+	memcpy(dst, src, size);
+
+	return dst;
+}
+
+static const char	**hc_strsdup(const char * const *src, int num)
+{
+	const char	**dst;
+
+	dst = (const char **)zbx_malloc(NULL, sizeof(char *) * (size_t)(0 != num ? num : 1));
+
+	for (int i = 0; i < num; i++)
+		dst[i] = zbx_strdup(NULL, src[i]);
+
+	return dst;
+}
+
+static void	hc_strsfree(const char * const *strs, int num)
+{
+	for (int i = 0; i < num; i++)
+		free((void *)strs[i]);
+
+	free((void *)strs);
+}
+
+#define HC_COLUMNS_DUP(dst, src)								\
+	(dst).itemid = hc_memdup((src).itemid, sizeof(zbx_uint64_t) * (size_t)(src).values_num);	\
+	(dst).clock = hc_memdup((src).clock, sizeof(int) * (size_t)(src).values_num);			\
+	(dst).ns = hc_memdup((src).ns, sizeof(int) * (size_t)(src).values_num);			\
+	(dst).values_num = (src).values_num
+
+#define HC_COLUMNS_FREE(columns)	\
+	free((void *)(columns).itemid);	\
+	free((void *)(columns).clock);	\
+	free((void *)(columns).ns)
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: copies history of value types processed by the module             *
+ *                                                                            *
+ * Comments: Asynchronous modules process history after history cache is     *
+ *           released, so the values must be copied.                          *
+ *                                                                            *
+ ******************************************************************************/
+static hc_module_batch_t	*hc_module_batch_create(const ZBX_HISTORY_WRITE_CBS_V2 *cbs,
+		const zbx_history_columns_t *src)
+{
+	hc_module_batch_t	*batch;
+	zbx_history_columns_t	*dst;
+
+	batch = (hc_module_batch_t *)zbx_malloc(NULL, sizeof(hc_module_batch_t));
+	memset(batch, 0, sizeof(hc_module_batch_t));
+	dst = &batch->columns;
+
+	if (NULL != cbs->history_float_cb && 0 != src->history_float.values_num)
+	{
+		HC_COLUMNS_DUP(dst->history_float, src->history_float);
+		dst->history_float.value = hc_memdup(src->history_float.value,
+				sizeof(double) * (size_t)src->history_float.values_num);
+	}
+
+	if (NULL != cbs->history_integer_cb && 0 != src->history_integer.values_num)
+	{
+		HC_COLUMNS_DUP(dst->history_integer, src->history_integer);
+		dst->history_integer.value = hc_memdup(src->history_integer.value,
+				sizeof(zbx_uint64_t) * (size_t)src->history_integer.values_num);
+	}
+
+	if (NULL != cbs->history_string_cb && 0 != src->history_string.values_num)
+	{
+		HC_COLUMNS_DUP(dst->history_string, src->history_string);
+		dst->history_string.value = hc_strsdup(src->history_string.value, src->history_string.values_num);
+	}
+
+	if (NULL != cbs->history_text_cb && 0 != src->history_text.values_num)
+	{
+		HC_COLUMNS_DUP(dst->history_text, src->history_text);
+		dst->history_text.value = hc_strsdup(src->history_text.value, src->history_text.values_num);
+	}
+
+	if (NULL != cbs->history_log_cb && 0 != src->history_log.values_num)
+	{
+		int	num = src->history_log.values_num;
+
+		HC_COLUMNS_DUP(dst->history_log, src->history_log);
+		dst->history_log.value = hc_strsdup(src->history_log.value, num);
+		dst->history_log.source = hc_strsdup(src->history_log.source, num);
+		dst->history_log.timestamp = hc_memdup(src->history_log.timestamp, sizeof(int) * (size_t)num);
+		dst->history_log.logeventid = hc_memdup(src->history_log.logeventid, sizeof(int) * (size_t)num);
+		dst->history_log.severity = hc_memdup(src->history_log.severity, sizeof(int) * (size_t)num);
+	}
+
+	return batch;
+}
+
+static void	hc_module_batch_free(hc_module_batch_t *batch)
+{
+	zbx_history_columns_t	*columns = &batch->columns;
+
+	if (0 != columns->history_float.values_num)
+	{
+		HC_COLUMNS_FREE(columns->history_float);
+		free((void *)columns->history_float.value);
+	}
+
+	if (0 != columns->history_integer.values_num)
+	{
+		HC_COLUMNS_FREE(columns->history_integer);
+		free((void *)columns->history_integer.value);
+	}
+
+	if (0 != columns->history_string.values_num)
+	{
+		HC_COLUMNS_FREE(columns->history_string);
+		hc_strsfree(columns->history_string.value, columns->history_string.values_num);
+	}
+
+	if (0 != columns->history_text.values_num)
+	{
+		HC_COLUMNS_FREE(columns->history_text);
+		hc_strsfree(columns->history_text.value, columns->history_text.values_num);
+	}
+
+	if (0 != columns->history_log.values_num)
+	{
+		HC_COLUMNS_FREE(columns->history_log);
+		hc_strsfree(columns->history_log.value, columns->history_log.values_num);
+		hc_strsfree(columns->history_log.source, columns->history_log.values_num);
+		free((void *)columns->history_log.timestamp);
+		free((void *)columns->history_log.logeventid);
+		free((void *)columns->history_log.severity);
+	}
+
+	zbx_free(batch);
+}
+
+#undef HC_COLUMNS_DUP
+#undef HC_COLUMNS_FREE
+
+static int	hc_module_batch_values_num(const hc_module_batch_t *batch)
+{
+	return batch->columns.history_float.values_num + batch->columns.history_integer.values_num +
+			batch->columns.history_string.values_num + batch->columns.history_text.values_num +
+			batch->columns.history_log.values_num;
+}
+
+static void	*hc_module_worker_entry(void *args)
+{
+	hc_module_worker_t	*worker = (hc_module_worker_t *)args;
+	sigset_t		mask;
+	int			err;
+
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGTERM);
+	sigaddset(&mask, SIGUSR1);
+	sigaddset(&mask, SIGUSR2);
+	sigaddset(&mask, SIGHUP);
+	sigaddset(&mask, SIGQUIT);
+	sigaddset(&mask, SIGINT);
+
+	if (0 != (err = pthread_sigmask(SIG_BLOCK, &mask, NULL)))
+		zabbix_log(LOG_LEVEL_WARNING, "cannot block signals: %s", zbx_strerror(err));
+
+	pthread_mutex_lock(&worker->lock);
+
+	while (1)
+	{
+		hc_module_batch_t	*batch;
+
+		while (0 == worker->queue_num && 0 == worker->stop)
+			pthread_cond_wait(&worker->event, &worker->lock);
+
+		/* queued history is written before stopping */
+		if (0 == worker->queue_num)
+			break;
+
+		batch = worker->queue[worker->queue_head];
+		worker->queue_head = (worker->queue_head + 1) % HC_MODULE_QUEUE_MAX;
+		worker->queue_num--;
+
+		pthread_mutex_unlock(&worker->lock);
+
+		hc_module_history_write(worker->cbs, &batch->columns);
+		hc_module_batch_free(batch);
+
+		pthread_mutex_lock(&worker->lock);
+	}
+
+	pthread_mutex_unlock(&worker->lock);
+
+	return NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: starts threads of asynchronous modules in the current process     *
+ *                                                                            *
+ * Comments: Modules are loaded before server processes are forked, so the    *
+ *           threads are started by the first process writing history.        *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_module_workers_init(void)
+{
+	int	err;
+
+	workers_num = 0;
+
+	for (int i = 0; NULL != history_write_cbs_v2[i].module; i++)
+	{
+		if (0 != (history_write_cbs_v2[i].cbs.flags & ZBX_MODULE_HISTORY_ASYNC))
+			workers_num++;
+	}
+
+	if (0 == workers_num)
+		return;
+
+	workers = (hc_module_worker_t *)zbx_malloc(NULL, sizeof(hc_module_worker_t) * (size_t)workers_num);
+	memset(workers, 0, sizeof(hc_module_worker_t) * (size_t)workers_num);
+
+	for (int i = 0, j = 0; NULL != history_write_cbs_v2[i].module; i++)
+	{
+		hc_module_worker_t	*worker;
+
+		if (0 == (history_write_cbs_v2[i].cbs.flags & ZBX_MODULE_HISTORY_ASYNC))
+			continue;
+
+		worker = &workers[j++];
+		worker->cbs = &history_write_cbs_v2[i];
+
+		if (0 != (err = pthread_mutex_init(&worker->lock, NULL)))
+		{
+			zabbix_log(LOG_LEVEL_CRIT, "cannot initialize module \"%s\" history mutex: %s",
+					worker->cbs->module->name, zbx_strerror(err));
+			exit(EXIT_FAILURE);
+		}
+
+		if (0 != (err = pthread_cond_init(&worker->event, NULL)))
+		{
+			zabbix_log(LOG_LEVEL_CRIT, "cannot initialize module \"%s\" history conditional variable:"
+					" %s", worker->cbs->module->name, zbx_strerror(err));
+			exit(EXIT_FAILURE);
+		}
+
+		if (0 != (err = pthread_create(&worker->thread, NULL, hc_module_worker_entry, (void *)worker)))
+		{
+			zabbix_log(LOG_LEVEL_CRIT, "cannot create module \"%s\" history thread: %s",
+					worker->cbs->module->name, zbx_strerror(err));
+			exit(EXIT_FAILURE);
+		}
+
+		worker->started = 1;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: queues history for asynchronous module                            *
+ *                                                                            *
+ * Comments: When the queue is full the history is dropped for the module,    *
+ *           so that slow module cannot stall history synchronization.        *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_module_worker_push(hc_module_worker_t *worker, const zbx_history_columns_t *columns)
+{
+	hc_module_batch_t	*batch;
+
+	batch = hc_module_batch_create(&worker->cbs->cbs, columns);
+
+	if (0 == hc_module_batch_values_num(batch))
+	{
+		hc_module_batch_free(batch);
+		return;
+	}
+
+	pthread_mutex_lock(&worker->lock);
+
+	if (HC_MODULE_QUEUE_MAX == worker->queue_num)
+	{
+		time_t	now;
+
+		worker->dropped_num += (zbx_uint64_t)hc_module_batch_values_num(batch);
+
+		if (HC_MODULE_WARNING_PERIOD <= (now = time(NULL)) - worker->last_warning)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "module \"%s\" is too slow to process history, dropped "
+					ZBX_FS_UI64 " values", worker->cbs->module->name, worker->dropped_num);
+			worker->last_warning = now;
+			worker->dropped_num = 0;
+		}
+
+		pthread_mutex_unlock(&worker->lock);
+		hc_module_batch_free(batch);
+
+		return;
+	}
+
+	worker->queue[(worker->queue_head + worker->queue_num) % HC_MODULE_QUEUE_MAX] = batch;
+	worker->queue_num++;
+
+	pthread_cond_signal(&worker->event);
+	pthread_mutex_unlock(&worker->lock);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: passes synchronized history to modules using columnar callbacks   *
+ *                                                                            *
+ * Parameters: columns - [IN] the history columns                             *
+ *                                                                            *
+ * Comments: Synchronous modules receive views of history cache values        *
+ *           shared by all modules. Asynchronous modules receive a copy from  *
+ *           a separate thread.                                               *
+ *                                                                            *
+ ******************************************************************************/
+void	hc_modules_history_write(const zbx_history_columns_t *columns)
+{
+	int	j = 0;
+
+	if (-1 == workers_num)
+		hc_module_workers_init();
+
+	for (int i = 0; NULL != history_write_cbs_v2[i].module; i++)
+	{
+		const zbx_history_write_cbs_v2_t	*cbs = &history_write_cbs_v2[i];
+
+		if (0 != (cbs->cbs.flags & ZBX_MODULE_HISTORY_ASYNC))
+		{
+			hc_module_worker_push(&workers[j++], columns);
+			continue;
+		}
+
+		zabbix_log(LOG_LEVEL_DEBUG, "syncing history data with module \"%s\"", cbs->module->name);
+		hc_module_history_write(cbs, columns);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: writes queued history and stops asynchronous module threads       *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_hc_modules_stop(void)
+{
+	for (int i = 0; i < workers_num; i++)
+	{
+		hc_module_worker_t	*worker = &workers[i];
+
+		if (0 == worker->started)
+			continue;
+
+		pthread_mutex_lock(&worker->lock);
+		worker->stop = 1;
+		pthread_cond_signal(&worker->event);
+		pthread_mutex_unlock(&worker->lock);
+
+		pthread_join(worker->thread, NULL);
+
+		pthread_cond_destroy(&worker->event);
+		pthread_mutex_destroy(&worker->lock);
+		worker->started = 0;
+	}
+
+	zbx_free(workers);
+	workers_num = -1;
+}
@@ -0,0 +1,37 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#ifndef ZABBIX_HISTORY_MODULES_H
+#define ZABBIX_HISTORY_MODULES_H
+
+#include "module.h"
+
+typedef struct
+{
+	ZBX_HISTORY_FLOAT_COLUMNS	history_float;
+	ZBX_HISTORY_INTEGER_COLUMNS	history_integer;
+	ZBX_HISTORY_STRING_COLUMNS	history_string;
+	ZBX_HISTORY_TEXT_COLUMNS	history_text;
+	ZBX_HISTORY_LOG_COLUMNS		history_log;
+}
+zbx_history_columns_t;
+
+void	hc_modules_history_write(const zbx_history_columns_t *columns);
+
+#endif
@@ -0,0 +1,761 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "proxy_buffer.h"
+#include "zbxcachehistory.h"
+
+#include "log.h"
+#include "zbxmutexs.h"
+#include "zbxdbhigh.h"
+#include "zbxnum.h"
+#include "zbx_item_constants.h"
+
+/* proxy buffer modes */
+#define ZBX_PB_MODE_DISK	0
+#define ZBX_PB_MODE_MEMORY	1
+#define ZBX_PB_MODE_HYBRID	2
+
+/* proxy buffer history states */
+#define ZBX_PB_STATE_MEMORY	0
+#define ZBX_PB_STATE_DATABASE	1
+
+typedef struct zbx_pb_history_s
+{
+	zbx_uint64_t			id;
+	zbx_uint64_t			itemid;
+	zbx_uint64_t			lastlogsize;
+	char				*value;
+	char				*source;
+	int				clock;
+	int				ns;
+	int				timestamp;
+	int				severity;
+	int				logeventid;
+	int				mtime;
+	int				write_clock;
+	unsigned char			state;
+	unsigned char			flags;
+	struct zbx_pb_history_s		*next;
+}
+zbx_pb_history_t;
+
+typedef struct
+{
+	zbx_pb_history_t	*head;
+	zbx_pb_history_t	*tail;
+	zbx_uint64_t		lastid;		/* the last assigned record identifier */
+	zbx_uint64_t		read_lastid;	/* the last record identifier read by data sender */
+	int			age;
+	unsigned char		mode;
+	unsigned char		state;
+	unsigned char		overflow;
+}
+zbx_pb_t;
+
+static zbx_shmem_info_t	*pb_mem = NULL;
+static zbx_mutex_t	pb_lock = ZBX_MUTEX_NULL;
+static zbx_pb_t		*pb = NULL;
+
+ZBX_SHMEM_FUNC1_IMPL_MALLOC(__pb, pb_mem)
+ZBX_SHMEM_FUNC1_IMPL_FREE(__pb, pb_mem)
+
+#define LOCK_PB		zbx_mutex_lock(pb_lock)
+#define UNLOCK_PB	zbx_mutex_unlock(pb_lock)
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: initialize proxy memory buffer                                    *
+ *                                                                            *
+ * Parameters: mode  - [IN] the buffer mode - disk, memory or hybrid          *
+ *             size  - [IN] the memory buffer size                            *
+ *             age   - [IN] the maximum age of data kept in memory buffer     *
+ *                          in hybrid mode, 0 - unlimited                     *
+ *             error - [OUT] the error message                                *
+ *                                                                            *
+ * Return value: SUCCEED - the buffer was initialized or is disabled          *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_init_proxy_buffer(const char *mode, zbx_uint64_t size, int age, char **error)
+{
+	int		ret = FAIL;
+	unsigned char	pb_mode;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() mode:%s size:" ZBX_FS_UI64 " age:%d", __func__, ZBX_NULL2STR(mode),
+			size, age);
+
+	if (NULL == mode || 0 == strcmp(mode, "disk"))
+		pb_mode = ZBX_PB_MODE_DISK;
+	else if (0 == strcmp(mode, "memory"))
+		pb_mode = ZBX_PB_MODE_MEMORY;
+	else if (0 == strcmp(mode, "hybrid"))
+		pb_mode = ZBX_PB_MODE_HYBRID;
+	else
+	{
+		*error = zbx_dsprintf(*error, "invalid \"ProxyBufferMode\" value \"%s\"", mode);
+		goto out;
+	}
+
+	if (ZBX_PB_MODE_DISK == pb_mode)
+	{
+		ret = SUCCEED;
+		goto out;
+	}
+
+	if (ZBX_PB_MEMORY_SIZE_MIN > size)
+	{
+		*error = zbx_dsprintf(*error, "\"ProxyMemoryBufferSize\" must be at least " ZBX_FS_UI64 " bytes"
+				" when \"ProxyBufferMode\" is \"%s\"", ZBX_PB_MEMORY_SIZE_MIN, mode);
+		goto out;
+	}
+
+	if (SUCCEED != zbx_mutex_create(&pb_lock, ZBX_MUTEX_PROXY_BUFFER, error))
+		goto out;
+
+	if (SUCCEED != zbx_shmem_create(&pb_mem, size, "proxy memory buffer", "ProxyMemoryBufferSize", 1, error))
+		goto out;
+
+	pb = (zbx_pb_t *)__pb_shmem_malloc_func(NULL, sizeof(zbx_pb_t));
+	memset(pb, 0, sizeof(zbx_pb_t));
+	pb->mode = pb_mode;
+	pb->age = age;
+	pb->state = ZBX_PB_STATE_MEMORY;
+
+	ret = SUCCEED;
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get history record value, source and flags as they would be       *
+ *          stored in proxy_history table                                     *
+ *                                                                            *
+ * Parameters: h      - [IN] the history value                                *
+ *             row    - [OUT] the history record                              *
+ *             value  - [OUT] the record value                                *
+ *             source - [OUT] the record log source                           *
+ *             buffer - [IN] the buffer for numeric value conversion          *
+ *             size   - [IN] the buffer size                                  *
+ *                                                                            *
+ * Return value: SUCCEED - the value must be stored                           *
+ *               FAIL    - the value must be skipped                          *
+ *                                                                            *
+ * Comments: See DBmass_proxy_add_history() for the database counterpart.     *
+ *                                                                            *
+ ******************************************************************************/
+static int	pb_history_prepare(const zbx_dc_history_t *h, zbx_pb_history_t *row, const char **value,
+		const char **source, char *buffer, size_t size)
+{
+	memset(row, 0, sizeof(zbx_pb_history_t));
+
+	row->itemid = h->itemid;
+	row->clock = h->ts.sec;
+	row->ns = h->ts.ns;
+	*value = "";
+	*source = "";
+
+	if (ITEM_STATE_NOTSUPPORTED == h->state)
+	{
+		row->state = h->state;
+		*value = ZBX_NULL2EMPTY_STR(h->value.err);
+
+		return SUCCEED;
+	}
+
+	if (0 != (h->flags & ZBX_DC_FLAG_META))
+	{
+		row->flags = ZBX_PROXY_HISTORY_FLAG_META;
+		row->lastlogsize = h->lastlogsize;
+		row->mtime = h->mtime;
+	}
+
+	if (0 != (h->flags & ZBX_DC_FLAG_NOVALUE))
+	{
+		if (ITEM_VALUE_TYPE_LOG == h->value_type)
+		{
+			row->flags = ZBX_PROXY_HISTORY_FLAG_META;
+			row->lastlogsize = h->lastlogsize;
+			row->mtime = h->mtime;
+		}
+		else if (0 != (h->flags & ZBX_DC_FLAG_UNDEF))
+			return FAIL;
+
+		row->flags |= ZBX_PROXY_HISTORY_FLAG_NOVALUE;
+
+		return SUCCEED;
+	}
+
+	switch (h->value_type)
+	{
+		case ITEM_VALUE_TYPE_FLOAT:
+			if (0 != (h->flags & ZBX_DC_FLAG_UNDEF))
+				return FAIL;
+			zbx_snprintf(buffer, size, ZBX_FS_DBL64, h->value.dbl);
+			*value = buffer;
+			break;
+		case ITEM_VALUE_TYPE_UINT64:
+			if (0 != (h->flags & ZBX_DC_FLAG_UNDEF))
+				return FAIL;
+			zbx_snprintf(buffer, size, ZBX_FS_UI64, h->value.ui64);
+			*value = buffer;
+			break;
+		case ITEM_VALUE_TYPE_STR:
+		case ITEM_VALUE_TYPE_TEXT:
+			if (0 != (h->flags & ZBX_DC_FLAG_UNDEF))
+				return FAIL;
+			*value = h->value.str;
+			break;
+		case ITEM_VALUE_TYPE_LOG:
+			row->timestamp = h->value.log->timestamp;
+			row->severity = h->value.log->severity;
+			row->logeventid = h->value.log->logeventid;
+			*value = h->value.log->value;
+			*source = ZBX_NULL2EMPTY_STR(h->value.log->source);
+			break;
+		case ITEM_VALUE_TYPE_BIN:
+		case ITEM_VALUE_TYPE_NONE:
+		default:
+			THIS_SHOULD_NEVER_HAPPEN;
+			return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: write detached history records to proxy_history table             *
+ *                                                                            *
+ * Parameters: rows - [IN] the history records                                *
+ *                                                                            *
+ * Return value: The number of written records.                               *
+ *                                                                            *
+ ******************************************************************************/
+static int	pb_history_write_db(const zbx_pb_history_t *rows)
+{
+	const zbx_pb_history_t	*row;
+	zbx_db_insert_t		db_insert;
+	int			rows_num;
+
+	do
+	{
+		zbx_db_begin();
+
+		zbx_db_insert_prepare(&db_insert, "proxy_history", "itemid", "clock", "ns", "timestamp", "source",
+				"severity", "value", "logeventid", "state", "lastlogsize", "mtime", "flags",
+				"write_clock", NULL);
+		zbx_db_insert_use_copy(&db_insert);
+
+		for (row = rows, rows_num = 0; NULL != row; row = row->next, rows_num++)
+		{
+			zbx_db_insert_add_values(&db_insert, row->itemid, row->clock, row->ns, row->timestamp,
+					row->source, row->severity, row->value, row->logeventid, (int)row->state,
+					row->lastlogsize, row->mtime, (int)row->flags, row->write_clock);
+		}
+
+		zbx_db_insert_execute(&db_insert);
+		zbx_db_insert_clean(&db_insert);
+	}
+	while (ZBX_DB_DOWN == zbx_db_commit());
+
+	return rows_num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: free history records                                              *
+ *                                                                            *
+ * Parameters: rows - [IN] the history records                                *
+ *                                                                            *
+ * Comments: This function must be called with proxy buffer locked.           *
+ *                                                                            *
+ ******************************************************************************/
+static void	pb_history_free(zbx_pb_history_t *rows)
+{
+	while (NULL != rows)
+	{
+		zbx_pb_history_t	*next = rows->next;
+
+		__pb_shmem_free_func(rows);
+		rows = next;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: detach history records not yet read by data sender                *
+ *                                                                            *
+ * Return value: The detached records.                                        *
+ *                                                                            *
+ * Comments: This function must be called with proxy buffer locked.           *
+ *           Records being sent by data sender are left in memory, they are   *
+ *           either removed after successful upload or read again.            *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_pb_history_t	*pb_history_detach_unread(void)
+{
+	zbx_pb_history_t	*rows, *prev = NULL;
+
+	for (rows = pb->head; NULL != rows && rows->id <= pb->read_lastid; rows = rows->next)
+		prev = rows;
+
+	if (NULL == prev)
+		pb->head = NULL;
+	else
+		prev->next = NULL;
+
+	pb->tail = prev;
+
+	return rows;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: move history records from memory to database and switch proxy     *
+ *          buffer to database state                                          *
+ *                                                                            *
+ * Comments: This function must be called with proxy buffer locked, the lock  *
+ *           is released during database operations.                          *
+ *                                                                            *
+ ******************************************************************************/
+static void	pb_history_spill(void)
+{
+	zbx_pb_history_t	*rows;
+	int			rows_num = 0;
+
+	pb->state = ZBX_PB_STATE_DATABASE;
+	rows = pb_history_detach_unread();
+
+	UNLOCK_PB;
+
+	if (NULL != rows)
+		rows_num = pb_history_write_db(rows);
+
+	LOCK_PB;
+
+	pb_history_free(rows);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() moved %d records from proxy memory buffer to database", __func__,
+			rows_num);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: check if history values are being stored in proxy memory buffer   *
+ *                                                                            *
+ * Return value: SUCCEED - history values are stored in memory                *
+ *               FAIL    - history values are stored in database              *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_pb_history_in_memory(void)
+{
+	int	ret;
+
+	if (NULL == pb)
+		return FAIL;
+
+	LOCK_PB;
+	ret = (ZBX_PB_STATE_MEMORY == pb->state ? SUCCEED : FAIL);
+	UNLOCK_PB;
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: add history values to proxy memory buffer                         *
+ *                                                                            *
+ * Parameters: history     - [IN] the history values                          *
+ *             history_num - [IN] the number of history values                *
+ *                                                                            *
+ * Return value: SUCCEED - the values were added to memory buffer             *
+ *               FAIL    - the values must be written to database             *
+ *                                                                            *
+ * Comments: In hybrid mode when memory buffer is full or the oldest record   *
+ *           exceeds the maximum age, the buffered records are moved to       *
+ *           database and the buffer is switched to database state until      *
+ *           data sender uploads all database records. In memory mode the     *
+ *           oldest records are discarded to free space for new values.       *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_pb_history_add(const zbx_dc_history_t *history, int history_num)
+{
+	int			i, now, added_num = 0, discarded_num = 0, ret = FAIL;
+	zbx_pb_history_t	*tail, *row, row_local;
+	zbx_uint64_t		lastid;
+	char			buffer[64];
+
+	if (NULL == pb)
+		return FAIL;
+
+	now = (int)time(NULL);
+
+	LOCK_PB;
+
+	if (ZBX_PB_STATE_MEMORY != pb->state)
+		goto out;
+
+	if (ZBX_PB_MODE_HYBRID == pb->mode && 0 != pb->age && NULL != pb->head &&
+			now - pb->head->write_clock > pb->age)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "proxy memory buffer data exceeds maximum age, switching to database");
+		pb_history_spill();
+		goto out;
+	}
+
+	tail = pb->tail;
+	lastid = pb->lastid;
+
+	for (i = 0; i < history_num; i++)
+	{
+		const char	*value, *source;
+		size_t		value_len, source_len;
+
+		if (SUCCEED != pb_history_prepare(&history[i], &row_local, &value, &source, buffer, sizeof(buffer)))
+			continue;
+
+		value_len = strlen(value) + 1;
+		source_len = strlen(source) + 1;
+
+		while (NULL == (row = (zbx_pb_history_t *)__pb_shmem_malloc_func(NULL,
+				sizeof(zbx_pb_history_t) + value_len + source_len)))
+		{
+			zbx_pb_history_t	*head;
+
+			if (ZBX_PB_MODE_HYBRID == pb->mode)
+			{
+				/* remove already added values, they will be written to database with the rest */
+				if (NULL == tail)
+				{
+					pb_history_free(pb->head);
+					pb->head = NULL;
+				}
+				else
+				{
+					pb_history_free(tail->next);
+					tail->next = NULL;
+				}
+
+				pb->tail = tail;
+				pb->lastid -= (zbx_uint64_t)added_num;
+				added_num = 0;
+
+				zabbix_log(LOG_LEVEL_DEBUG, "proxy memory buffer is full, switching to database");
+				pb_history_spill();
+				goto out;
+			}
+
+			if (NULL == (head = pb->head))
+				break;
+
+			if (NULL == (pb->head = head->next))
+				pb->tail = NULL;
+
+			/* values added by this call are counted only after the buffer is updated */
+			if (head->id > lastid)
+				added_num--;
+			else
+				discarded_num++;
+
+			head->next = NULL;
+			pb_history_free(head);
+		}
+
+		if (NULL == row)
+		{
+			discarded_num++;
+			continue;
+		}
+
+		*row = row_local;
+		row->id = ++pb->lastid;
+		row->write_clock = now;
+		row->value = (char *)(row + 1);
+		memcpy(row->value, value, value_len);
+		row->source = row->value + value_len;
+		memcpy(row->source, source, source_len);
+		row->next = NULL;
+
+		if (NULL == pb->tail)
+			pb->head = row;
+		else
+			pb->tail->next = row;
+
+		pb->tail = row;
+		added_num++;
+	}
+
+	if (0 != discarded_num && 0 == pb->overflow)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "proxy memory buffer is full, discarding the oldest values");
+		pb->overflow = 1;
+	}
+
+	ret = SUCCEED;
+out:
+	UNLOCK_PB;
+
+	if (0 != added_num || 0 != discarded_num)
+		zbx_change_proxy_history_count(added_num - discarded_num);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: check if proxy memory buffer has history records                  *
+ *                                                                            *
+ * Return value: SUCCEED - memory buffer has history records to upload        *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_pb_history_has_data(void)
+{
+	int	ret;
+
+	if (NULL == pb)
+		return FAIL;
+
+	LOCK_PB;
+	ret = (NULL != pb->head ? SUCCEED : FAIL);
+	UNLOCK_PB;
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: read history records from proxy memory buffer                     *
+ *                                                                            *
+ * Parameters: lastid             - [IN] the id of last processed record      *
+ *             data               - [IN/OUT] the proxy history data buffer    *
+ *             data_alloc         - [IN/OUT] the size of proxy history data   *
+ *                                           buffer                           *
+ *             string_buffer      - [IN/OUT] the string buffer                *
+ *             string_buffer_size - [IN/OUT] the size of string buffer        *
+ *             more               - [OUT] set to ZBX_PROXY_DATA_MORE if there *
+ *                                        is more data to read                *
+ *                                                                            *
+ * Return value: The number of records read.                                  *
+ *                                                                            *
+ * Comments: This is the memory buffer counterpart of                         *
+ *           proxy_get_history_data().                                        *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_pb_history_get_data(zbx_uint64_t lastid, zbx_proxy_history_data_t **data, size_t *data_alloc,
+		char **string_buffer, size_t *string_buffer_alloc, int *more)
+{
+	const zbx_pb_history_t		*row;
+	zbx_proxy_history_data_t	*hd;
+	size_t				data_num = 0, string_buffer_offset = 0;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() lastid:" ZBX_FS_UI64, __func__, lastid);
+
+	*more = ZBX_PROXY_DATA_DONE;
+
+	if (NULL == pb)
+		goto out;
+
+	LOCK_PB;
+
+	for (row = pb->head; NULL != row && row->id <= lastid; row = row->next)
+		;
+
+	for (; NULL != row && ZBX_MAX_HRECORDS > data_num; row = row->next)
+	{
+		if (*data_alloc == data_num)
+		{
+			*data_alloc *= 2;
+			*data = (zbx_proxy_history_data_t *)zbx_realloc(*data,
+					sizeof(zbx_proxy_history_data_t) * *data_alloc);
+		}
+
+		hd = *data + data_num++;
+		hd->id = row->id;
+		hd->itemid = row->itemid;
+		hd->flags = row->flags;
+		hd->clock = row->clock;
+		hd->ns = row->ns;
+		hd->state = row->state;
+		hd->timestamp = row->timestamp;
+		hd->severity = row->severity;
+		hd->logeventid = row->logeventid;
+		hd->lastlogsize = row->lastlogsize;
+		hd->mtime = row->mtime;
+
+		if (0 == (hd->flags & ZBX_PROXY_HISTORY_FLAG_NOVALUE))
+		{
+			size_t	len1, len2;
+
+			len1 = strlen(row->source) + 1;
+			len2 = strlen(row->value) + 1;
+
+			if (*string_buffer_alloc < string_buffer_offset + len1 + len2)
+			{
+				while (*string_buffer_alloc < string_buffer_offset + len1 + len2)
+					*string_buffer_alloc += ZBX_KIBIBYTE;
+
+				*string_buffer = (char *)zbx_realloc(*string_buffer, *string_buffer_alloc);
+			}
+
+			hd->source_offset = string_buffer_offset;
+			memcpy(*string_buffer + hd->source_offset, row->source, len1);
+			string_buffer_offset += len1;
+
+			hd->value_offset = string_buffer_offset;
+			memcpy(*string_buffer + hd->value_offset, row->value, len2);
+			string_buffer_offset += len2;
+		}
+
+		pb->read_lastid = row->id;
+	}
+
+	if (NULL != row)
+		*more = ZBX_PROXY_DATA_MORE;
+
+	UNLOCK_PB;
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() data_num:" ZBX_FS_SIZE_T, __func__, data_num);
+
+	return (int)data_num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: remove uploaded history records from proxy memory buffer          *
+ *                                                                            *
+ * Parameters: lastid - [IN] the id of last uploaded record                   *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_pb_history_set_lastid(zbx_uint64_t lastid)
+{
+	zbx_pb_history_t	*row;
+	int			removed_num = 0;
+
+	if (NULL == pb)
+		return;
+
+	LOCK_PB;
+
+	while (NULL != (row = pb->head) && row->id <= lastid)
+	{
+		if (NULL == (pb->head = row->next))
+			pb->tail = NULL;
+
+		row->next = NULL;
+		pb_history_free(row);
+		removed_num++;
+	}
+
+	pb->overflow = 0;
+
+	UNLOCK_PB;
+
+	if (0 != removed_num)
+		zbx_change_proxy_history_count(-removed_num);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get the age of the oldest history record in proxy memory buffer   *
+ *          that was not uploaded                                             *
+ *                                                                            *
+ * Parameters: lastid - [IN] the id of last uploaded record                   *
+ *                                                                            *
+ * Return value: The record age in seconds or 0 if there are no more records. *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_pb_history_get_delay(zbx_uint64_t lastid)
+{
+	const zbx_pb_history_t	*row;
+	int			delay = 0;
+
+	if (NULL == pb)
+		return 0;
+
+	LOCK_PB;
+
+	for (row = pb->head; NULL != row && row->id <= lastid; row = row->next)
+		;
+
+	if (NULL != row)
+		delay = (int)time(NULL) - row->write_clock;
+
+	UNLOCK_PB;
+
+	return delay;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: switch proxy buffer back to memory state after all history        *
+ *          records were uploaded from database                               *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_pb_history_set_memory_state(void)
+{
+	if (NULL == pb)
+		return;
+
+	LOCK_PB;
+
+	if (ZBX_PB_STATE_MEMORY != pb->state)
+	{
+		pb->state = ZBX_PB_STATE_MEMORY;
+		zabbix_log(LOG_LEVEL_DEBUG, "proxy buffer history database records uploaded, switching to memory");
+	}
+
+	UNLOCK_PB;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: free proxy memory buffer                                          *
+ *                                                                            *
+ * Parameters: sync - [IN] ZBX_SYNC_ALL - move buffered records to database   *
+ *                         in hybrid mode                                     *
+ *                                                                            *
+ * Comments: This function is called on shutdown when data sender and history *
+ *           syncers are already stopped.                                     *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_free_proxy_buffer(int sync)
+{
+	if (NULL == pb)
+		return;
+
+	LOCK_PB;
+
+	if (ZBX_SYNC_ALL == sync && ZBX_PB_MODE_HYBRID == pb->mode)
+	{
+		pb->read_lastid = 0;
+		pb_history_spill();
+	}
+
+	UNLOCK_PB;
+
+	zbx_shmem_destroy(pb_mem);
+	pb_mem = NULL;
+	pb = NULL;
+
+	zbx_mutex_destroy(&pb_lock);
+}
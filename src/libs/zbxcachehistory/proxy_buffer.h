@@ -0,0 +1,29 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#ifndef ZABBIX_PROXY_BUFFER_H
+#define ZABBIX_PROXY_BUFFER_H
+
+#include "zbxhistory.h"
+
+int	zbx_pb_history_in_memory(void);
+int	zbx_pb_history_add(const zbx_dc_history_t *history, int history_num);
+void	zbx_free_proxy_buffer(int sync);
+
+#endif
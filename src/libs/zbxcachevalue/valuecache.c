@@ -23,6 +23,7 @@
 #include "zbxmutexs.h"
 #include "zbxtime.h"
 #include "zbxvariant.h"
+#include "zbxcompress.h"
 
 /*
  * The cache (zbx_vc_cache_t) is organized as a hashset of item records (zbx_vc_item_t).
@@ -48,6 +49,19 @@
  *
  * The low memory mode can't be turned off - it will persist until server is rebooted.
  * In low memory mode a warning message is written into log every 5 minutes.
+ *
+ * Locking.
+ *
+ * The cache is protected by vc_lock read-write lock. It's locked in exclusive (write) mode
+ * only when the cached item set changes - items are added to or removed from cache, values
+ * read from database are cached, or the cache space is being released. Item values are read
+ * and new values are added while the cache is locked in shared (read) mode:
+ *   1) item data is protected by item lock, selected by item identifier from a fixed set of
+ *      shared mutexes, so requests for items in different locks never block each other.
+ *   2) memory allocator, string pool and cache statistics are protected by vc_mem_lock.
+ * When cache runs out of memory while locked in shared mode the required space is remembered
+ * and released later with the cache locked in exclusive mode, so eviction is not done from
+ * inside the requests of other items.
  */
 
 /* the period of low memory warning messages */
@@ -62,6 +76,19 @@ static zbx_shmem_info_t	*vc_mem = NULL;
 
 zbx_rwlock_t	vc_lock = ZBX_RWLOCK_NULL;
 
+static zbx_mutex_t	vc_mem_lock = ZBX_MUTEX_NULL;
+static zbx_mutex_t	vc_item_locks[ZBX_MUTEX_VALUECACHE_ITEMS_NUM];
+
+/* value cache lock modes of the current process */
+#define ZBX_VC_LOCK_NONE	0
+#define ZBX_VC_LOCK_SHARED	1
+#define ZBX_VC_LOCK_EXCLUSIVE	2
+
+static int	vc_lock_mode = ZBX_VC_LOCK_NONE;
+
+/* the space to release when cache is locked in exclusive mode */
+static size_t	vc_space_request = 0;
+
 /* value cache enable/disable flags */
 #define ZBX_VC_DISABLED		0
 #define ZBX_VC_ENABLED		1
@@ -101,11 +128,59 @@ typedef struct zbx_vc_chunk
 	/* the number of item value slots in chunk */
 	int			slots_num;
 
-	/* the item value data */
+	/* the size of compressed value data or 0 if chunk is not compressed */
+	int			compressed_size;
+
+	/* the compressed chunk identifier, used to find decoded chunk values */
+	zbx_uint64_t		serial;
+
+	/* the compressed chunk value type */
+	unsigned char		value_type;
+
+	/* the item value data, compressed chunks store encoded data stream here */
 	zbx_history_record_t	slots[1];
 }
 zbx_vc_chunk_t;
 
+/* the stream used to encode compressed chunk data */
+typedef struct
+{
+	unsigned char	*data;
+	size_t		data_alloc;
+	size_t		pos;
+}
+zbx_vc_stream_t;
+
+/* the decoded values of compressed chunk */
+typedef struct
+{
+	const zbx_vc_chunk_t	*chunk;
+	zbx_uint64_t		serial;
+	zbx_history_record_t	*slots;
+	int			slots_alloc;
+	zbx_uint64_t		lastused;
+
+	/* the decoded string and log value data of str, text and log chunks */
+	char			*strings;
+	size_t			strings_alloc;
+	zbx_log_value_t		*logs;
+	int			logs_alloc;
+}
+zbx_vc_decoded_chunk_t;
+
+/* the codec used to compress string values of str, text and log chunks */
+#if defined(HAVE_LZ4)
+#	define ZBX_VC_COMPRESS_CODEC	ZBX_COMPRESS_LZ4
+#elif defined(HAVE_ZLIB)
+#	define ZBX_VC_COMPRESS_CODEC	ZBX_COMPRESS_ZLIB
+#endif
+
+/* the number of decoded compressed chunks kept by process */
+#define ZBX_VC_DECODED_CHUNKS_NUM	4
+
+static zbx_vc_decoded_chunk_t	vc_decoded_chunks[ZBX_VC_DECODED_CHUNKS_NUM];
+static zbx_uint64_t		vc_decoded_clock = 0;
+
 /* min/max number of item history values to store in chunk */
 
 #define ZBX_VC_MIN_CHUNK_RECORDS	2
@@ -171,6 +246,11 @@ typedef struct
 	/* in low memory situation.                                   */
 	zbx_uint64_t	hits;
 
+	/* The item data revision, changed when item is added to cache */
+	/* or values are inserted or removed not at the head of cached */
+	/* data.                                                       */
+	zbx_uint64_t	revision;
+
 	/* the last (newest) chunk of item history data               */
 	zbx_vc_chunk_t	*head;
 
@@ -179,6 +259,26 @@ typedef struct
 }
 zbx_vc_item_t;
 
+/* the consumer of item history values retrieved from cache */
+typedef struct
+{
+	/* the vector to copy values into or NULL if values are passed to callback */
+	zbx_vector_history_record_t	*values;
+
+	/* the callback to pass blocks of values to */
+	zbx_vc_values_func_t		values_func;
+	void				*values_data;
+
+	unsigned char			value_type;
+
+	/* the number of values consumed */
+	int				values_num;
+
+	/* the timestamp seconds of the oldest consumed value */
+	int				oldest_sec;
+}
+zbx_vc_values_sink_t;
+
 /* the value cache data  */
 typedef struct
 {
@@ -200,6 +300,12 @@ typedef struct
 	/* the minimum number of bytes to be freed when cache runs out of space */
 	size_t		min_free_request;
 
+	/* the last assigned compressed chunk identifier */
+	zbx_uint64_t	chunk_serial;
+
+	/* the last assigned item data revision */
+	zbx_uint64_t	item_revision;
+
 	/* the cached items */
 	zbx_hashset_t	items;
 
@@ -271,9 +377,43 @@ static void	vc_cache_item_update(zbx_uint64_t itemid, zbx_vc_item_update_type_t
 /* the value cache */
 static zbx_vc_cache_t	*vc_cache = NULL;
 
-#define	RDLOCK_CACHE	zbx_rwlock_rdlock(vc_lock)
-#define	WRLOCK_CACHE	zbx_rwlock_wrlock(vc_lock)
-#define	UNLOCK_CACHE	zbx_rwlock_unlock(vc_lock)
+#define	RDLOCK_CACHE	do { zbx_rwlock_rdlock(vc_lock); vc_lock_mode = ZBX_VC_LOCK_SHARED; } while (0)
+#define	WRLOCK_CACHE	do { zbx_rwlock_wrlock(vc_lock); vc_lock_mode = ZBX_VC_LOCK_EXCLUSIVE; } while (0)
+#define	UNLOCK_CACHE	do { vc_lock_mode = ZBX_VC_LOCK_NONE; zbx_rwlock_unlock(vc_lock); } while (0)
+
+#define	LOCK_ITEM(itemid)	zbx_mutex_lock(vc_item_locks[(itemid) % ZBX_MUTEX_VALUECACHE_ITEMS_NUM])
+#define	UNLOCK_ITEM(itemid)	zbx_mutex_unlock(vc_item_locks[(itemid) % ZBX_MUTEX_VALUECACHE_ITEMS_NUM])
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: locks value cache memory when cache is locked in shared mode      *
+ *                                                                            *
+ * Comments: In exclusive mode the memory is already protected by cache lock. *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_mem_lock_shared(void)
+{
+	if (ZBX_VC_LOCK_SHARED == vc_lock_mode)
+		zbx_mutex_lock(vc_mem_lock);
+}
+
+static void	vc_mem_unlock_shared(void)
+{
+	if (ZBX_VC_LOCK_SHARED == vc_lock_mode)
+		zbx_mutex_unlock(vc_mem_lock);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: frees value cache memory                                          *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_mem_free(void *ptr)
+{
+	vc_mem_lock_shared();
+	__vc_shmem_free_func(ptr);
+	vc_mem_unlock_shared();
+}
 
 /* function prototypes */
 static void	vc_history_record_copy(zbx_history_record_t *dst, const zbx_history_record_t *src, int value_type);
@@ -672,8 +812,10 @@ static void	vc_update_statistics(zbx_vc_item_t *item, int hits, int misses, int
 
 	if (ZBX_VC_ENABLED == vc_state)
 	{
+		vc_mem_lock_shared();
 		vc_cache->hits += (zbx_uint64_t)hits;
 		vc_cache->misses += (zbx_uint64_t)misses;
+		vc_mem_unlock_shared();
 	}
 }
 
@@ -870,6 +1012,48 @@ static void	vc_release_space(zbx_vc_item_t *source_item, size_t space)
 	zbx_vector_vc_itemweight_destroy(&items);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: frees space in cache or requests it to be freed later if cache is *
+ *          locked in shared mode                                             *
+ *                                                                            *
+ * Parameters: item  - [IN] the item requesting more space to store its data  *
+ *             space - [IN] the number of bytes to free                       *
+ *                                                                            *
+ * Return value: SUCCEED - the space was freed                                *
+ *               FAIL    - the space will be freed when cache is locked in    *
+ *                         exclusive mode                                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_request_space(zbx_vc_item_t *item, size_t space)
+{
+	if (ZBX_VC_LOCK_SHARED == vc_lock_mode)
+	{
+		vc_space_request += space;
+		return FAIL;
+	}
+
+	vc_release_space(item, space);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: frees space requested while cache was locked in shared mode       *
+ *                                                                            *
+ * Comments: This function must be called with cache locked in exclusive mode.*
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_release_requested_space(void)
+{
+	if (0 == vc_space_request)
+		return;
+
+	vc_release_space(NULL, vc_space_request);
+	vc_space_request = 0;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: copies history value                                              *
@@ -913,7 +1097,7 @@ static void	vc_history_record_copy(zbx_history_record_t *dst, const zbx_history_
  *                                                                            *
  ******************************************************************************/
 static void	vc_history_record_vector_append(zbx_vector_history_record_t *vector, int value_type,
-		zbx_history_record_t *value)
+		const zbx_history_record_t *value)
 {
 	zbx_history_record_t	record;
 
@@ -940,13 +1124,17 @@ static void	*vc_item_malloc(zbx_vc_item_t *item, size_t size)
 {
 	char	*ptr;
 
-	if (NULL == (ptr = (char *)__vc_shmem_malloc_func(NULL, size)))
+	vc_mem_lock_shared();
+	ptr = (char *)__vc_shmem_malloc_func(NULL, size);
+	vc_mem_unlock_shared();
+
+	if (NULL == ptr)
 	{
 		/* If failed to allocate required memory, try to free space in      */
 		/* cache and allocate again. If there still is not enough space -   */
 		/* return NULL as failure.                                          */
-		vc_release_space(item, size);
-		ptr = (char *)__vc_shmem_malloc_func(NULL, size);
+		if (SUCCEED == vc_request_space(item, size))
+			ptr = (char *)__vc_shmem_malloc_func(NULL, size);
 	}
 
 	return ptr;
@@ -975,6 +1163,8 @@ static char	*vc_item_strdup(zbx_vc_item_t *item, const char *str)
 {
 	void	*ptr;
 
+	vc_mem_lock_shared();
+
 	ptr = zbx_hashset_search(&vc_cache->strpool, str - REFCOUNT_FIELD_SIZE);
 
 	if (NULL == ptr)
@@ -989,10 +1179,12 @@ static char	*vc_item_strdup(zbx_vc_item_t *item, const char *str)
 		{
 			/* If there is not enough space - free enough to store string + hashset entry overhead */
 			/* and try inserting one more time. If it fails again, then fail the function.         */
-			if (0 == tries++)
-				vc_release_space(item, len + REFCOUNT_FIELD_SIZE + sizeof(ZBX_HASHSET_ENTRY_T));
-			else
+			if (0 != tries++ || SUCCEED != vc_request_space(item,
+					len + REFCOUNT_FIELD_SIZE + sizeof(ZBX_HASHSET_ENTRY_T)))
+			{
+				vc_mem_unlock_shared();
 				return NULL;
+			}
 		}
 
 		*(zbx_uint32_t *)ptr = 0;
@@ -1000,6 +1192,8 @@ static char	*vc_item_strdup(zbx_vc_item_t *item, const char *str)
 
 	(*(zbx_uint32_t *)ptr)++;
 
+	vc_mem_unlock_shared();
+
 	return (char *)ptr + REFCOUNT_FIELD_SIZE;
 }
 
@@ -1026,11 +1220,15 @@ static size_t	vc_item_strfree(char *str)
 	{
 		void	*ptr = str - REFCOUNT_FIELD_SIZE;
 
+		vc_mem_lock_shared();
+
 		if (0 == --(*(zbx_uint32_t *)ptr))
 		{
 			freed = strlen(str) + REFCOUNT_FIELD_SIZE + 1;
 			zbx_hashset_remove_direct(&vc_cache->strpool, ptr);
 		}
+
+		vc_mem_unlock_shared();
 	}
 
 	return freed;
@@ -1078,7 +1276,7 @@ static zbx_log_value_t	*vc_item_logdup(zbx_vc_item_t *item, const zbx_log_value_
 fail:
 	vc_item_strfree(plog->source);
 
-	__vc_shmem_free_func(plog);
+	vc_mem_free(plog);
 
 	return NULL;
 }
@@ -1104,7 +1302,7 @@ static size_t	vc_item_logfree(zbx_log_value_t *log)
 		freed += vc_item_strfree(log->source);
 		freed += vc_item_strfree(log->value);
 
-		__vc_shmem_free_func(log);
+		vc_mem_free(log);
 		freed += sizeof(zbx_log_value_t);
 	}
 
@@ -1154,19 +1352,6 @@ static size_t	vc_item_free_values(zbx_vc_item_t *item, zbx_history_record_t *val
 	return freed;
 }
 
-/******************************************************************************
- *                                                                            *
- * Purpose: removes item from cache and frees resources allocated for it      *
- *                                                                            *
- * Parameters: item    - [IN] the item                                        *
- *                                                                            *
- ******************************************************************************/
-static void	vc_remove_item(zbx_vc_item_t *item)
-{
-	vch_item_free_cache(item);
-	zbx_hashset_remove_direct(&vc_cache->items, item);
-}
-
 /******************************************************************************
  *                                                                            *
  * Purpose: removes item from cache and frees resources allocated for it      *
@@ -1214,6 +1399,20 @@ void	zbx_vc_remove_items_by_ids(zbx_vector_uint64_t *itemids)
 	UNLOCK_CACHE;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: assigns new data revision to the item                             *
+ *                                                                            *
+ * Parameters: item - [IN] the item                                           *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_item_update_revision(zbx_vc_item_t *item)
+{
+	vc_mem_lock_shared();
+	item->revision = ++vc_cache->item_revision;
+	vc_mem_unlock_shared();
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: updates the timestamp from which the item is being cached         *
@@ -1401,1479 +1600,3428 @@ static int	vch_item_add_chunk(zbx_vc_item_t *item, int nslots, zbx_vc_chunk_t *i
 
 /******************************************************************************
  *                                                                            *
- * Purpose: find the index of the last value in chunk with timestamp less or  *
- *          equal to the specified timestamp.                                 *
- *                                                                            *
- * Parameters:  chunk - [IN] the chunk                                        *
- *              ts    - [IN] the target timestamp                             *
+ * Purpose: writes the lowest bits of value into compressed chunk data stream *
  *                                                                            *
- * Return value: The index of the last value in chunk with timestamp less or  *
- *               equal to the specified timestamp.                            *
- *               -1 is returned in the case of failure (meaning that all      *
- *               values have timestamps greater than the target timestamp).   *
+ * Parameters: stream - [IN/OUT] the data stream                              *
+ *             value  - [IN] the value to write                               *
+ *             bits   - [IN] the number of bits to write (1-64)               *
  *                                                                            *
  ******************************************************************************/
-static int	vch_chunk_find_last_value_before(const zbx_vc_chunk_t *chunk, const zbx_timespec_t *ts)
+static void	vc_stream_write(zbx_vc_stream_t *stream, zbx_uint64_t value, int bits)
 {
-	int	start = chunk->first_value, end = chunk->last_value, middle;
-
-	/* check if the last value timestamp is already greater or equal to the specified timestamp */
-	if (0 >= zbx_timespec_compare(&chunk->slots[end].timestamp, ts))
-		return end;
-
-	/* chunk contains only one value, which did not pass the above check, return failure */
-	if (start == end)
-		return -1;
-
-	/* perform value lookup using binary search */
-	while (start != end)
+	while (0 < bits)
 	{
-		middle = start + (end - start) / 2;
+		size_t		byte = stream->pos >> 3;
+		int		avail = 8 - (int)(stream->pos & 7), take = MIN(avail, bits);
+		unsigned int	data;
 
-		if (0 < zbx_timespec_compare(&chunk->slots[middle].timestamp, ts))
+		if (byte >= stream->data_alloc)
 		{
-			end = middle;
-			continue;
-		}
+			size_t	data_alloc = stream->data_alloc;
 
-		if (0 >= zbx_timespec_compare(&chunk->slots[middle + 1].timestamp, ts))
-		{
-			start = middle;
-			continue;
+			stream->data_alloc = (0 == data_alloc ? 1024 : data_alloc * 2);
+			stream->data = (unsigned char *)zbx_realloc(stream->data, stream->data_alloc);
+			memset(stream->data + data_alloc, 0, stream->data_alloc - data_alloc);
 		}
 
-		return middle;
-	}
+		data = (unsigned int)(value >> (bits - take)) & ((1u << take) - 1);
+		stream->data[byte] |= (unsigned char)(data << (avail - take));
 
-	return -1;
+		stream->pos += (size_t)take;
+		bits -= take;
+	}
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: gets the chunk and index of the last value with a timestamp less  *
- *          or equal to the specified timestamp                               *
- *                                                                            *
- * Parameters:  item          - [IN] the item                                 *
- *              ts            - [IN] the target timestamp                     *
- *                                   (NULL - current time)                    *
- *              pchunk        - [OUT] the chunk containing the target value   *
- *              pindex        - [OUT] the index of the target value           *
+ * Purpose: reads bits from compressed chunk data stream                      *
  *                                                                            *
- * Return value: SUCCEED - the last value was found successfully              *
- *               FAIL - all values in cache have timestamps greater than the  *
- *                      target (timeshift) timestamp.                         *
+ * Parameters: data - [IN] the data stream                                    *
+ *             pos  - [IN/OUT] the stream position in bits                    *
+ *             bits - [IN] the number of bits to read (1-64)                  *
  *                                                                            *
- * Comments: If end_timestamp value is 0, then simply the last item value in  *
- *           cache is returned.                                               *
+ * Return value: the value read                                               *
  *                                                                            *
  ******************************************************************************/
-static int	vch_item_get_last_value(const zbx_vc_item_t *item, const zbx_timespec_t *ts, zbx_vc_chunk_t **pchunk,
-		int *pindex)
+static zbx_uint64_t	vc_stream_read(const unsigned char *data, size_t *pos, int bits)
 {
-	zbx_vc_chunk_t	*chunk = item->head;
-	int		index;
+	zbx_uint64_t	value = 0;
 
-	if (NULL == chunk)
-		return FAIL;
+	while (0 < bits)
+	{
+		int		avail = 8 - (int)(*pos & 7), take = MIN(avail, bits);
+		unsigned int	byte = data[*pos >> 3];
 
-	index = chunk->last_value;
+		value = (value << take) | ((byte >> (avail - take)) & ((1u << take) - 1));
 
-	if (0 < zbx_timespec_compare(&chunk->slots[index].timestamp, ts))
-	{
-		while (0 < zbx_timespec_compare(&chunk->slots[chunk->first_value].timestamp, ts))
-		{
-			chunk = chunk->prev;
-			/* there are no values for requested range, return failure */
-			if (NULL == chunk)
-				return FAIL;
-		}
-		index = vch_chunk_find_last_value_before(chunk, ts);
+		*pos += (size_t)take;
+		bits -= take;
 	}
 
-	*pchunk = chunk;
-	*pindex = index;
-
-	return SUCCEED;
+	return value;
 }
 
+/* the bit widths of delta-of-delta encoding buckets, values not fitting into the last bucket are stored as is */
+static const int	vc_dod_bits[] = {7, 9, 12, 32};
+
 /******************************************************************************
  *                                                                            *
- * Purpose: copies value in the specified item's chunk slot                   *
+ * Purpose: writes delta-of-delta value into compressed chunk data stream     *
  *                                                                            *
- * Parameters: chunk        - [IN/OUT] the target chunk                       *
- *             index        - [IN] the target slot                            *
- *             source_value - [IN] the value to copy                          *
+ * Comments: The value is written as variable length prefix ('0', '10',       *
+ *           '110', ...) selecting the bucket, followed by the value biased   *
+ *           to fit bucket bit width.                                         *
  *                                                                            *
- * Return value: SUCCEED - the value was copied successfully                  *
- *               FAIL    - the value copying failed (not enough space for     *
- *                         string, text or log type data)                     *
+ ******************************************************************************/
+static void	vc_stream_write_dod(zbx_vc_stream_t *stream, zbx_int64_t dod)
+{
+	int	i;
+
+	if (0 == dod)
+	{
+		vc_stream_write(stream, 0, 1);
+		return;
+	}
+
+	for (i = 0; i < (int)ARRSIZE(vc_dod_bits); i++)
+	{
+		zbx_int64_t	bias = ((zbx_int64_t)1 << (vc_dod_bits[i] - 1)) - 1;
+
+		if (dod >= -bias && dod <= bias + 1)
+		{
+			/* prefix of i + 1 one bits followed by zero bit */
+			vc_stream_write(stream, ((zbx_uint64_t)1 << (i + 2)) - 2, i + 2);
+			vc_stream_write(stream, (zbx_uint64_t)(dod + bias), vc_dod_bits[i]);
+			return;
+		}
+	}
+
+	vc_stream_write(stream, ((zbx_uint64_t)1 << (i + 1)) - 1, i + 1);
+	vc_stream_write(stream, (zbx_uint64_t)dod, 64);
+}
+
+/******************************************************************************
  *                                                                            *
- * Comments: This function is used to copy data to cache. The contents of     *
- *           str, text and log type values are stored in cache string pool.   *
+ * Purpose: reads delta-of-delta value from compressed chunk data stream      *
  *                                                                            *
  ******************************************************************************/
-static int	vch_item_copy_value(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk, int index,
-		const zbx_history_record_t *source_value)
+static zbx_int64_t	vc_stream_read_dod(const unsigned char *data, size_t *pos)
 {
-	zbx_history_record_t	*value;
-	int			ret = FAIL;
+	int	i;
 
-	value = &chunk->slots[index];
+	for (i = 0; i < (int)ARRSIZE(vc_dod_bits); i++)
+	{
+		if (0 == vc_stream_read(data, pos, 1))
+		{
+			zbx_int64_t	bias;
 
-	switch (item->value_type)
+			if (0 == i)
+				return 0;
+
+			bias = ((zbx_int64_t)1 << (vc_dod_bits[i - 1] - 1)) - 1;
+
+			return (zbx_int64_t)vc_stream_read(data, pos, vc_dod_bits[i - 1]) - bias;
+		}
+	}
+
+	if (0 == vc_stream_read(data, pos, 1))
 	{
-		case ITEM_VALUE_TYPE_STR:
-		case ITEM_VALUE_TYPE_TEXT:
-			if (NULL == (value->value.str = vc_item_strdup(item, source_value->value.str)))
-				goto out;
-			break;
-		case ITEM_VALUE_TYPE_LOG:
-			if (NULL == (value->value.log = vc_item_logdup(item, source_value->value.log)))
-				goto out;
-			break;
-		default:
-			value->value = source_value->value;
+		zbx_int64_t	bias = ((zbx_int64_t)1 << (vc_dod_bits[i - 1] - 1)) - 1;
+
+		return (zbx_int64_t)vc_stream_read(data, pos, vc_dod_bits[i - 1]) - bias;
 	}
-	value->timestamp = source_value->timestamp;
 
-	ret = SUCCEED;
-out:
-	return ret;
+	return (zbx_int64_t)vc_stream_read(data, pos, 64);
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: copies values at the beginning of item tail chunk                 *
- *                                                                            *
- * Parameters: item       - [IN/OUT] the target item                          *
- *             values     - [IN] the values to copy                           *
- *             values_num - [IN] the number of values to copy                 *
+ * Purpose: encodes history values into compressed data stream                *
  *                                                                            *
- * Return value: SUCCEED - the values were copied successfully                *
- *               FAIL    - the value copying failed (not enough space for     *
- *                         string, text or log type data)                     *
+ * Parameters: stream     - [OUT] the data stream                             *
+ *             value_type - [IN] the value type                               *
+ *             slots      - [IN] the values to encode                         *
+ *             slots_num  - [IN] the number of values                         *
  *                                                                            *
- * Comments: This function is used to copy data to cache. The contents of     *
- *           str, text and log type values are stored in cache string pool.   *
+ * Comments: Timestamp seconds are stored as delta-of-delta, nanoseconds are  *
+ *           stored only when changed. Float values are XORed with previous   *
+ *           value storing only the meaningful bits, unsigned values are      *
+ *           stored as delta-of-delta. Only timestamps are encoded for str,   *
+ *           text and log values, their contents are stored with              *
+ *           vc_chunk_encode_strings().                                       *
  *                                                                            *
  ******************************************************************************/
-static int	vch_item_copy_values_at_tail(zbx_vc_item_t *item, const zbx_history_record_t *values, int values_num)
+static void	vc_chunk_encode(zbx_vc_stream_t *stream, unsigned char value_type, const zbx_history_record_t *slots,
+		int slots_num)
 {
-	int	i, ret = FAIL, first_value = item->tail->first_value;
+	int		i, leading = -1, trailing = 0;
+	zbx_int64_t	delta = 0;
+	zbx_uint64_t	value = 0, value_delta = 0;
 
-	switch (item->value_type)
-	{
-		case ITEM_VALUE_TYPE_STR:
-		case ITEM_VALUE_TYPE_TEXT:
-			for (i = values_num - 1; i >= 0; i--)
-			{
-				zbx_history_record_t	*value = &item->tail->slots[item->tail->first_value - 1];
+	stream->pos = 0;
 
-				if (NULL == (value->value.str = vc_item_strdup(item, values[i].value.str)))
-					goto out;
+	if (0 != stream->data_alloc)
+		memset(stream->data, 0, stream->data_alloc);
 
-				value->timestamp = values[i].timestamp;
-				item->tail->first_value--;
-			}
-			ret = SUCCEED;
+	vc_stream_write(stream, (zbx_uint64_t)(zbx_uint32_t)slots[0].timestamp.sec, 32);
+	vc_stream_write(stream, (zbx_uint64_t)slots[0].timestamp.ns, 30);
 
-			break;
-		case ITEM_VALUE_TYPE_LOG:
-			for (i = values_num - 1; i >= 0; i--)
+	if (ITEM_VALUE_TYPE_FLOAT == value_type)
+	{
+		memcpy(&value, &slots[0].value.dbl, sizeof(value));
+		vc_stream_write(stream, value, 64);
+	}
+	else if (ITEM_VALUE_TYPE_UINT64 == value_type)
+	{
+		value = slots[0].value.ui64;
+		vc_stream_write(stream, value, 64);
+	}
+
+	for (i = 1; i < slots_num; i++)
+	{
+		zbx_int64_t	sec_delta = (zbx_int64_t)slots[i].timestamp.sec - slots[i - 1].timestamp.sec;
+
+		vc_stream_write_dod(stream, sec_delta - delta);
+		delta = sec_delta;
+
+		if (slots[i].timestamp.ns == slots[i - 1].timestamp.ns)
+		{
+			vc_stream_write(stream, 0, 1);
+		}
+		else
+		{
+			vc_stream_write(stream, 1, 1);
+			vc_stream_write(stream, (zbx_uint64_t)slots[i].timestamp.ns, 30);
+		}
+
+		if (ITEM_VALUE_TYPE_FLOAT == value_type)
+		{
+			zbx_uint64_t	bits, xor;
+			int		lead, trail;
+
+			memcpy(&bits, &slots[i].value.dbl, sizeof(bits));
+			xor = bits ^ value;
+			value = bits;
+
+			if (0 == xor)
 			{
-				zbx_history_record_t	*value = &item->tail->slots[item->tail->first_value - 1];
+				vc_stream_write(stream, 0, 1);
+				continue;
+			}
 
-				if (NULL == (value->value.log = vc_item_logdup(item, values[i].value.log)))
-					goto out;
+			for (lead = 0; 0 == (xor & ((zbx_uint64_t)1 << (63 - lead))); lead++)
+				;
 
-				value->timestamp = values[i].timestamp;
-				item->tail->first_value--;
+			for (trail = 0; 0 == (xor & ((zbx_uint64_t)1 << trail)); trail++)
+				;
+
+			if (31 < lead)
+				lead = 31;
+
+			if (-1 != leading && lead >= leading && trail >= trailing)
+			{
+				/* meaningful bits fit into the previous window */
+				vc_stream_write(stream, 2, 2);
+				vc_stream_write(stream, xor >> trailing, 64 - leading - trailing);
 			}
-			ret = SUCCEED;
+			else
+			{
+				vc_stream_write(stream, 3, 2);
+				vc_stream_write(stream, (zbx_uint64_t)lead, 5);
+				vc_stream_write(stream, (zbx_uint64_t)((64 - lead - trail) & 63), 6);
+				vc_stream_write(stream, xor >> trail, 64 - lead - trail);
 
-			break;
-		default:
-			memcpy(&item->tail->slots[item->tail->first_value - values_num], values,
-					(size_t)values_num * sizeof(zbx_history_record_t));
-			item->tail->first_value -= values_num;
-			ret = SUCCEED;
-	}
-out:
-	item->values_total += first_value - item->tail->first_value;
+				leading = lead;
+				trailing = trail;
+			}
+		}
+		else if (ITEM_VALUE_TYPE_UINT64 == value_type)
+		{
+			zbx_uint64_t	ui64_delta = slots[i].value.ui64 - value;
 
-	return ret;
+			vc_stream_write_dod(stream, (zbx_int64_t)(ui64_delta - value_delta));
+			value_delta = ui64_delta;
+			value = slots[i].value.ui64;
+		}
+	}
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: frees chunk and all resources allocated to store its values       *
- *                                                                            *
- * Parameters: item    - [IN] the chunk owner item                            *
- *             chunk   - [IN] the chunk to free                               *
- *                                                                            *
- * Return value: the number of bytes freed                                    *
+ * Purpose: appends data to string value buffer                               *
  *                                                                            *
  ******************************************************************************/
-static size_t	vch_item_free_chunk(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk)
+static void	vc_buffer_append(char **buf, size_t *buf_alloc, size_t *buf_offset, const void *data, size_t size)
 {
-	size_t	freed;
-
-	freed = sizeof(zbx_vc_chunk_t) + (size_t)(chunk->slots_num - 1) * sizeof(zbx_history_record_t);
-	freed += vc_item_free_values(item, chunk->slots, chunk->first_value, chunk->last_value);
+	if (*buf_alloc < *buf_offset + size)
+	{
+		while (*buf_alloc < *buf_offset + size)
+			*buf_alloc = (0 == *buf_alloc ? ZBX_KIBIBYTE : *buf_alloc * 2);
 
-	__vc_shmem_free_func(chunk);
+		*buf = (char *)zbx_realloc(*buf, *buf_alloc);
+	}
 
-	return freed;
+	memcpy(*buf + *buf_offset, data, size);
+	*buf_offset += size;
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: removes item history data chunk                                   *
+ * Purpose: encodes str, text and log history values into compressed data     *
+ *          stream                                                            *
  *                                                                            *
- * Parameters: item    - [IN ] the chunk owner item                           *
- *             chunk   - [IN] the chunk to remove                             *
+ * Parameters: stream     - [IN/OUT] the data stream with encoded timestamps  *
+ *             value_type - [IN] the value type (str, text or log)            *
+ *             slots      - [IN] the values to encode                         *
+ *             slots_num  - [IN] the number of values                         *
+ *             size       - [OUT] the size of uncompressed value contents     *
+ *                                                                            *
+ * Return value: SUCCEED - the values were encoded                            *
+ *               FAIL    - compression failed                                 *
+ *                                                                            *
+ * Comments: Value contents (and log value attributes) are serialized into    *
+ *           a buffer which is compressed and appended to the byte aligned    *
+ *           stream after the uncompressed buffer size.                       *
  *                                                                            *
  ******************************************************************************/
-static void	vch_item_remove_chunk(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk)
+static int	vc_chunk_encode_strings(zbx_vc_stream_t *stream, unsigned char value_type,
+		const zbx_history_record_t *slots, int slots_num, size_t *size)
 {
-	if (NULL != chunk->next)
-		chunk->next->prev = chunk->prev;
+#if defined(ZBX_VC_COMPRESS_CODEC)
+	static char	*buf = NULL;
+	static size_t	buf_alloc = 0;
+	size_t		buf_offset = 0, out_size;
+	char		*out;
+	int		i;
+
+	for (i = 0; i < slots_num; i++)
+	{
+		const char	*str;
 
-	if (NULL != chunk->prev)
-		chunk->prev->next = chunk->next;
+		if (ITEM_VALUE_TYPE_LOG == value_type)
+		{
+			const zbx_log_value_t	*log = slots[i].value.log;
+			unsigned char		source = (NULL != log->source);
 
-	if (chunk == item->head)
-		item->head = chunk->prev;
+			vc_buffer_append(&buf, &buf_alloc, &buf_offset, &log->timestamp, sizeof(log->timestamp));
+			vc_buffer_append(&buf, &buf_alloc, &buf_offset, &log->severity, sizeof(log->severity));
+			vc_buffer_append(&buf, &buf_alloc, &buf_offset, &log->logeventid, sizeof(log->logeventid));
+			vc_buffer_append(&buf, &buf_alloc, &buf_offset, &source, sizeof(source));
 
-	if (chunk == item->tail)
-		item->tail = chunk->next;
+			if (0 != source)
+				vc_buffer_append(&buf, &buf_alloc, &buf_offset, log->source, strlen(log->source) + 1);
 
-	vch_item_free_chunk(item, chunk);
+			str = log->value;
+		}
+		else
+			str = slots[i].value.str;
+
+		vc_buffer_append(&buf, &buf_alloc, &buf_offset, str, strlen(str) + 1);
+	}
+
+	if (UINT32_MAX < buf_offset || SUCCEED != zbx_compress_ext(ZBX_VC_COMPRESS_CODEC, buf, buf_offset, &out,
+			&out_size))
+	{
+		return FAIL;
+	}
+
+	stream->pos = (stream->pos + 7) & ~(size_t)7;
+	vc_stream_write(stream, (zbx_uint64_t)buf_offset, 32);
+
+	if (stream->data_alloc < (stream->pos >> 3) + out_size)
+	{
+		size_t	data_alloc = stream->data_alloc;
+
+		while (stream->data_alloc < (stream->pos >> 3) + out_size)
+			stream->data_alloc *= 2;
+
+		stream->data = (unsigned char *)zbx_realloc(stream->data, stream->data_alloc);
+		memset(stream->data + data_alloc, 0, stream->data_alloc - data_alloc);
+	}
+
+	memcpy(stream->data + (stream->pos >> 3), out, out_size);
+	stream->pos += out_size << 3;
+	zbx_free(out);
+
+	*size = buf_offset;
+
+	return SUCCEED;
+#else
+	ZBX_UNUSED(stream);
+	ZBX_UNUSED(value_type);
+	ZBX_UNUSED(slots);
+	ZBX_UNUSED(slots_num);
+	ZBX_UNUSED(size);
+
+	return FAIL;
+#endif
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: removes item history data that are outside (older) the maximum    *
- *          request range                                                     *
+ * Purpose: decodes str, text and log values of compressed chunk              *
  *                                                                            *
- * Parameters:  item      - [IN] the target item                              *
- *              timestamp - [IN] last timestamp in active range               *
+ * Parameters: chunk   - [IN] the compressed chunk                            *
+ *             offset  - [IN] the offset of value contents in chunk data      *
+ *             decoded - [IN/OUT] the decoded values with timestamps already  *
+ *                                decoded                                     *
  *                                                                            *
  ******************************************************************************/
-static void	vch_item_clean_cache(zbx_vc_item_t *item, int timestamp)
+static void	vc_chunk_decode_strings(const zbx_vc_chunk_t *chunk, size_t offset, zbx_vc_decoded_chunk_t *decoded)
 {
-	zbx_vc_chunk_t	*next;
+	const unsigned char	*data = (const unsigned char *)chunk->slots;
+	size_t			pos = offset << 3, size;
+	const char		*ptr;
+	int			i;
 
-	if (0 != item->active_range)
+	size = (size_t)vc_stream_read(data, &pos, 32);
+
+	if (decoded->strings_alloc < size)
 	{
-		zbx_vc_chunk_t	*tail = item->tail;
-		zbx_vc_chunk_t	*chunk = tail;
+		decoded->strings_alloc = size;
+		decoded->strings = (char *)zbx_realloc(decoded->strings, decoded->strings_alloc);
+	}
 
-		timestamp -= item->active_range;
+#if defined(ZBX_VC_COMPRESS_CODEC)
+	if (SUCCEED != zbx_uncompress_ext(ZBX_VC_COMPRESS_CODEC, (const char *)data + (pos >> 3),
+			(size_t)chunk->compressed_size - (pos >> 3), decoded->strings, &size))
+#endif
+	{
+		THIS_SHOULD_NEVER_HAPPEN;
+		memset(decoded->strings, 0, decoded->strings_alloc);
+	}
 
-		/* Try to remove chunks with all history values older than maximum request range, maximum */
-		/* request range should be calculated from last received value with which active range    */
-		/* was calculated to avoid dropping of chunks that might be still used in count request.  */
-		while (NULL != chunk && chunk->slots[chunk->last_value].timestamp.sec < timestamp &&
-				chunk->slots[chunk->last_value].timestamp.sec !=
-						item->head->slots[item->head->last_value].timestamp.sec)
+	if (ITEM_VALUE_TYPE_LOG == chunk->value_type && decoded->logs_alloc < chunk->slots_num)
+	{
+		decoded->logs_alloc = chunk->slots_num;
+		decoded->logs = (zbx_log_value_t *)zbx_realloc(decoded->logs,
+				sizeof(zbx_log_value_t) * (size_t)decoded->logs_alloc);
+	}
+
+	for (i = 0, ptr = decoded->strings; i < chunk->slots_num; i++)
+	{
+		if (ITEM_VALUE_TYPE_LOG == chunk->value_type)
 		{
-			/* don't remove the head chunk */
-			if (NULL == (next = chunk->next))
-				break;
+			zbx_log_value_t	*log = &decoded->logs[i];
 
-			/* Values with the same timestamps (seconds resolution) always should be either   */
-			/* kept in cache or removed together. There should not be a case when one of them */
-			/* is in cache and the second is dropped.                                         */
-			/* Here we are handling rare case, when the last value of first chunk has the     */
-			/* same timestamp (seconds resolution) as the first value in the second chunk.    */
-			/* In this case increase the first value index of the next chunk until the first  */
-			/* value timestamp is greater.                                                    */
+			memcpy(&log->timestamp, ptr, sizeof(log->timestamp));
+			ptr += sizeof(log->timestamp);
+			memcpy(&log->severity, ptr, sizeof(log->severity));
+			ptr += sizeof(log->severity);
+			memcpy(&log->logeventid, ptr, sizeof(log->logeventid));
+			ptr += sizeof(log->logeventid);
 
-			if (next->slots[next->first_value].timestamp.sec != next->slots[next->last_value].timestamp.sec)
+			if (0 != *ptr++)
 			{
-				while (next->slots[next->first_value].timestamp.sec ==
-						chunk->slots[chunk->last_value].timestamp.sec)
-				{
-					vc_item_free_values(item, next->slots, next->first_value, next->first_value);
-					next->first_value++;
-				}
+				log->source = (char *)ptr;
+				ptr += strlen(ptr) + 1;
 			}
+			else
+				log->source = NULL;
 
-			/* set the database cached from timestamp to the last (oldest) removed value timestamp + 1 */
-			item->db_cached_from = chunk->slots[chunk->last_value].timestamp.sec + 1;
-
-			vch_item_remove_chunk(item, chunk);
-
-			chunk = next;
+			log->value = (char *)ptr;
+			decoded->slots[i].value.log = log;
 		}
+		else
+			decoded->slots[i].value.str = (char *)ptr;
 
-		/* reset the status flags if data was removed from cache */
-		if (tail != item->tail)
-			item->status = 0;
+		ptr += strlen(ptr) + 1;
 	}
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: removes item history data that are older than the specified       *
- *          timestamp                                                         *
+ * Purpose: decodes compressed chunk values                                   *
  *                                                                            *
- * Parameters:  item      - [IN] the target item                              *
- *              timestamp - [IN] the timestamp (number of seconds since the   *
- *                               Epoch)                                       *
+ * Parameters: chunk   - [IN] the compressed chunk                            *
+ *             decoded - [OUT] the decoded values                             *
  *                                                                            *
  ******************************************************************************/
-static void	vch_item_remove_values(zbx_vc_item_t *item, int timestamp)
+static void	vc_chunk_decode(const zbx_vc_chunk_t *chunk, zbx_vc_decoded_chunk_t *decoded)
 {
-	zbx_vc_chunk_t	*chunk = item->tail;
+	const unsigned char	*data = (const unsigned char *)chunk->slots;
+	size_t			pos = 0;
+	int			i, leading = 0, trailing = 0;
+	zbx_int64_t		delta = 0;
+	zbx_uint64_t		value = 0, value_delta = 0;
+	zbx_history_record_t	*slots = decoded->slots;
 
-	if (ZBX_ITEM_STATUS_CACHED_ALL == item->status)
-		item->status = 0;
+	slots[0].timestamp.sec = (int)(zbx_uint32_t)vc_stream_read(data, &pos, 32);
+	slots[0].timestamp.ns = (int)vc_stream_read(data, &pos, 30);
 
-	/* try to remove chunks with all history values older than the timestamp */
-	while (NULL != chunk && chunk->slots[chunk->first_value].timestamp.sec < timestamp)
+	if (ITEM_VALUE_TYPE_FLOAT == chunk->value_type)
 	{
-		zbx_vc_chunk_t	*next;
+		value = vc_stream_read(data, &pos, 64);
+		memcpy(&slots[0].value.dbl, &value, sizeof(value));
+	}
+	else if (ITEM_VALUE_TYPE_UINT64 == chunk->value_type)
+	{
+		value = vc_stream_read(data, &pos, 64);
+		slots[0].value.ui64 = value;
+	}
 
-		/* If chunk contains values with timestamp greater or equal - remove */
-		/* only the values with less timestamp. Otherwise remove the while   */
-		/* chunk and check next one.                                         */
-		if (chunk->slots[chunk->last_value].timestamp.sec >= timestamp)
+	for (i = 1; i < chunk->slots_num; i++)
+	{
+		delta += vc_stream_read_dod(data, &pos);
+		slots[i].timestamp.sec = (int)(slots[i - 1].timestamp.sec + delta);
+
+		if (0 == vc_stream_read(data, &pos, 1))
+			slots[i].timestamp.ns = slots[i - 1].timestamp.ns;
+		else
+			slots[i].timestamp.ns = (int)vc_stream_read(data, &pos, 30);
+
+		if (ITEM_VALUE_TYPE_FLOAT == chunk->value_type)
 		{
-			while (chunk->slots[chunk->first_value].timestamp.sec < timestamp)
+			if (0 != vc_stream_read(data, &pos, 1))
 			{
-				vc_item_free_values(item, chunk->slots, chunk->first_value, chunk->first_value);
-				chunk->first_value++;
+				if (0 != vc_stream_read(data, &pos, 1))
+				{
+					int	meaningful;
+
+					leading = (int)vc_stream_read(data, &pos, 5);
+
+					if (0 == (meaningful = (int)vc_stream_read(data, &pos, 6)))
+						meaningful = 64;
+
+					trailing = 64 - leading - meaningful;
+				}
+
+				value ^= vc_stream_read(data, &pos, 64 - leading - trailing) << trailing;
 			}
 
-			break;
+			memcpy(&slots[i].value.dbl, &value, sizeof(value));
+		}
+		else if (ITEM_VALUE_TYPE_UINT64 == chunk->value_type)
+		{
+			value_delta += (zbx_uint64_t)vc_stream_read_dod(data, &pos);
+			value += value_delta;
+			slots[i].value.ui64 = value;
 		}
-
-		next = chunk->next;
-		vch_item_remove_chunk(item, chunk);
-		chunk = next;
 	}
+
+	if (ITEM_VALUE_TYPE_FLOAT != chunk->value_type && ITEM_VALUE_TYPE_UINT64 != chunk->value_type)
+		vc_chunk_decode_strings(chunk, (pos + 7) >> 3, decoded);
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: adds one item history value at the end of current item's history  *
- *          data                                                              *
+ * Purpose: returns chunk values                                              *
  *                                                                            *
- * Parameters:  item   - [IN] the item to add history data to                 *
- *              value  - [IN] the item history data value                     *
+ * Parameters: chunk - [IN] the chunk                                         *
  *                                                                            *
- * Return value: SUCCEED - the history data value was added successfully      *
- *               FAIL - failed to add history data value (not enough memory)  *
+ * Return value: the chunk value slots                                        *
  *                                                                            *
- * Comments: In the case of failure the item will be removed from cache       *
- *           later.                                                           *
+ * Comments: Compressed chunks are decoded into process local buffers, which  *
+ *           are reused for the most recently accessed chunks. The returned   *
+ *           slots remain valid until ZBX_VC_DECODED_CHUNKS_NUM other         *
+ *           compressed chunks are accessed.                                  *
  *                                                                            *
  ******************************************************************************/
-static int	vch_item_add_value_at_head(zbx_vc_item_t *item, const zbx_history_record_t *value)
+static const zbx_history_record_t	*vch_chunk_slots(const zbx_vc_chunk_t *chunk)
 {
-	int		ret = FAIL, index, sindex, nslots = 0;
-	zbx_vc_chunk_t	*chunk, *schunk;
-
-	if (NULL != item->head &&
-			0 < zbx_history_record_compare_asc_func(&item->head->slots[item->head->last_value], value))
-	{
-		if (0 < zbx_history_record_compare_asc_func(&item->tail->slots[item->tail->first_value], value))
-		{
-			/* If the added value has the same or older timestamp as the first value in cache */
-			/* we can't add it to keep cache consistency. Additionally we must make sure no   */
-			/* values with matching timestamp seconds are kept in cache.                      */
-			vch_item_remove_values(item, value->timestamp.sec + 1);
+	zbx_vc_decoded_chunk_t	*decoded = &vc_decoded_chunks[0];
+	int			i;
 
-			/* empty items must be removed to avoid situation when a new value is added to cache */
-			/* while other values with matching timestamp seconds are not cached                 */
-			if (NULL == item->head)
-				goto out;
+	if (0 == chunk->compressed_size)
+		return chunk->slots;
 
-			/* if the value is newer than the database cached from timestamp we must */
-			/* adjust the cached from timestamp to exclude this value                */
-			if (item->db_cached_from <= value->timestamp.sec)
-				item->db_cached_from = value->timestamp.sec + 1;
+	vc_decoded_clock++;
 
-			ret = SUCCEED;
-			goto out;
+	for (i = 0; i < ZBX_VC_DECODED_CHUNKS_NUM; i++)
+	{
+		if (vc_decoded_chunks[i].chunk == chunk && vc_decoded_chunks[i].serial == chunk->serial)
+		{
+			vc_decoded_chunks[i].lastused = vc_decoded_clock;
+			return vc_decoded_chunks[i].slots;
 		}
 
-		sindex = item->head->last_value;
-		schunk = item->head;
+		if (vc_decoded_chunks[i].lastused < decoded->lastused)
+			decoded = &vc_decoded_chunks[i];
+	}
 
-		if (0 == item->head->slots_num - item->head->last_value - 1)
-		{
-			if (FAIL == vch_item_add_chunk(item, vch_item_chunk_slot_count(item, 1), NULL))
-				goto out;
-		}
-		else
-			item->head->last_value++;
+	if (decoded->slots_alloc < chunk->slots_num)
+	{
+		decoded->slots_alloc = chunk->slots_num;
+		decoded->slots = (zbx_history_record_t *)zbx_realloc(decoded->slots,
+				sizeof(zbx_history_record_t) * (size_t)decoded->slots_alloc);
+	}
 
-		item->values_total++;
+	vc_chunk_decode(chunk, decoded);
 
-		chunk = item->head;
-		index = item->head->last_value;
+	decoded->chunk = chunk;
+	decoded->serial = chunk->serial;
+	decoded->lastused = vc_decoded_clock;
 
-		do
-		{
-			chunk->slots[index] = schunk->slots[sindex];
+	return decoded->slots;
+}
 
-			chunk = schunk;
-			index = sindex;
+/******************************************************************************
+ *                                                                            *
+ * Purpose: replaces full item history data chunk with its compressed copy    *
+ *                                                                            *
+ * Parameters: item  - [IN/OUT] the chunk owner item                          *
+ *             chunk - [IN] the chunk to compress (optional)                  *
+ *                                                                            *
+ * Comments: Only full chunks, except the head chunk, are compressed.         *
+ *           Compressed chunks are never modified - new values are added to   *
+ *           the head chunk or to new chunks. Chunks are uncompressed when a  *
+ *           late value must be inserted before their values.                 *
+ *           String values of compressed str, text and log chunks are         *
+ *           released from the string pool.                                   *
+ *           If there is not enough memory or the compressed chunk would not  *
+ *           be smaller, the chunk is left uncompressed.                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_compress_chunk(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk)
+{
+	static zbx_vc_stream_t	stream;
+	zbx_vc_chunk_t		*cchunk;
+	size_t			size, data_size, values_size = 0;
 
-			if (--sindex < schunk->first_value)
-			{
-				if (NULL == (schunk = schunk->prev))
-				{
-					memset(&chunk->slots[index], 0, sizeof(zbx_vc_chunk_t));
-					THIS_SHOULD_NEVER_HAPPEN;
+	if (NULL == chunk || chunk == item->head || 0 != chunk->compressed_size)
+		return;
 
-					goto out;
-				}
+	if (0 != chunk->first_value || chunk->slots_num - 1 != chunk->last_value)
+		return;
 
-				sindex = schunk->last_value;
-			}
-		}
-		while (0 < zbx_timespec_compare(&schunk->slots[sindex].timestamp, &value->timestamp));
-	}
-	else
+	vc_chunk_encode(&stream, item->value_type, chunk->slots, chunk->slots_num);
+
+	switch (item->value_type)
+	{
+		case ITEM_VALUE_TYPE_FLOAT:
+		case ITEM_VALUE_TYPE_UINT64:
+			break;
+		case ITEM_VALUE_TYPE_STR:
+		case ITEM_VALUE_TYPE_TEXT:
+		case ITEM_VALUE_TYPE_LOG:
+			if (SUCCEED != vc_chunk_encode_strings(&stream, item->value_type, chunk->slots,
+					chunk->slots_num, &values_size))
+			{
+				return;
+			}
+			break;
+		default:
+			return;
+	}
+
+	data_size = (stream.pos + 7) >> 3;
+	size = offsetof(zbx_vc_chunk_t, slots) + data_size;
+
+	if (size >= sizeof(zbx_vc_chunk_t) + (size_t)(chunk->slots_num - 1) * sizeof(zbx_history_record_t) +
+			values_size)
+	{
+		return;
+	}
+
+	vc_mem_lock_shared();
+
+	if (NULL != (cchunk = (zbx_vc_chunk_t *)__vc_shmem_malloc_func(NULL, size)))
+		cchunk->serial = ++vc_cache->chunk_serial;
+
+	vc_mem_unlock_shared();
+
+	if (NULL == cchunk)
+		return;
+
+	cchunk->prev = chunk->prev;
+	cchunk->next = chunk->next;
+	cchunk->first_value = chunk->first_value;
+	cchunk->last_value = chunk->last_value;
+	cchunk->slots_num = chunk->slots_num;
+	cchunk->compressed_size = (int)data_size;
+	cchunk->value_type = item->value_type;
+	memcpy(cchunk->slots, stream.data, data_size);
+
+	if (NULL != cchunk->prev)
+		cchunk->prev->next = cchunk;
+	else
+		item->tail = cchunk;
+
+	cchunk->next->prev = cchunk;
+
+	if (0 != values_size)
+	{
+		vc_item_free_values(item, chunk->slots, chunk->first_value, chunk->last_value);
+
+		/* the values are kept in the compressed chunk */
+		item->values_total += chunk->slots_num;
+	}
+
+	vc_mem_free(chunk);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: find the index of the last value in chunk with timestamp less or  *
+ *          equal to the specified timestamp.                                 *
+ *                                                                            *
+ * Parameters:  chunk - [IN] the chunk                                        *
+ *              ts    - [IN] the target timestamp                             *
+ *                                                                            *
+ * Return value: The index of the last value in chunk with timestamp less or  *
+ *               equal to the specified timestamp.                            *
+ *               -1 is returned in the case of failure (meaning that all      *
+ *               values have timestamps greater than the target timestamp).   *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_chunk_find_last_value_before(const zbx_vc_chunk_t *chunk, const zbx_timespec_t *ts)
+{
+	int				start = chunk->first_value, end = chunk->last_value, middle;
+	const zbx_history_record_t	*slots = vch_chunk_slots(chunk);
+
+	/* check if the last value timestamp is already greater or equal to the specified timestamp */
+	if (0 >= zbx_timespec_compare(&slots[end].timestamp, ts))
+		return end;
+
+	/* chunk contains only one value, which did not pass the above check, return failure */
+	if (start == end)
+		return -1;
+
+	/* perform value lookup using binary search */
+	while (start != end)
+	{
+		middle = start + (end - start) / 2;
+
+		if (0 < zbx_timespec_compare(&slots[middle].timestamp, ts))
+		{
+			end = middle;
+			continue;
+		}
+
+		if (0 >= zbx_timespec_compare(&slots[middle + 1].timestamp, ts))
+		{
+			start = middle;
+			continue;
+		}
+
+		return middle;
+	}
+
+	return -1;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets the chunk and index of the last value with a timestamp less  *
+ *          or equal to the specified timestamp                               *
+ *                                                                            *
+ * Parameters:  item          - [IN] the item                                 *
+ *              ts            - [IN] the target timestamp                     *
+ *                                   (NULL - current time)                    *
+ *              pchunk        - [OUT] the chunk containing the target value   *
+ *              pindex        - [OUT] the index of the target value           *
+ *                                                                            *
+ * Return value: SUCCEED - the last value was found successfully              *
+ *               FAIL - all values in cache have timestamps greater than the  *
+ *                      target (timeshift) timestamp.                         *
+ *                                                                            *
+ * Comments: If end_timestamp value is 0, then simply the last item value in  *
+ *           cache is returned.                                               *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_get_last_value(const zbx_vc_item_t *item, const zbx_timespec_t *ts, zbx_vc_chunk_t **pchunk,
+		int *pindex)
+{
+	zbx_vc_chunk_t	*chunk = item->head;
+	int		index;
+
+	if (NULL == chunk)
+		return FAIL;
+
+	index = chunk->last_value;
+
+	if (0 < zbx_timespec_compare(&vch_chunk_slots(chunk)[index].timestamp, ts))
+	{
+		while (0 < zbx_timespec_compare(&vch_chunk_slots(chunk)[chunk->first_value].timestamp, ts))
+		{
+			chunk = chunk->prev;
+			/* there are no values for requested range, return failure */
+			if (NULL == chunk)
+				return FAIL;
+		}
+		index = vch_chunk_find_last_value_before(chunk, ts);
+	}
+
+	*pchunk = chunk;
+	*pindex = index;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: copies value in the specified item's chunk slot                   *
+ *                                                                            *
+ * Parameters: chunk        - [IN/OUT] the target chunk                       *
+ *             index        - [IN] the target slot                            *
+ *             source_value - [IN] the value to copy                          *
+ *                                                                            *
+ * Return value: SUCCEED - the value was copied successfully                  *
+ *               FAIL    - the value copying failed (not enough space for     *
+ *                         string, text or log type data)                     *
+ *                                                                            *
+ * Comments: This function is used to copy data to cache. The contents of     *
+ *           str, text and log type values are stored in cache string pool.   *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_copy_value(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk, int index,
+		const zbx_history_record_t *source_value)
+{
+	zbx_history_record_t	*value;
+	int			ret = FAIL;
+
+	value = &chunk->slots[index];
+
+	switch (item->value_type)
+	{
+		case ITEM_VALUE_TYPE_STR:
+		case ITEM_VALUE_TYPE_TEXT:
+			if (NULL == (value->value.str = vc_item_strdup(item, source_value->value.str)))
+				goto out;
+			break;
+		case ITEM_VALUE_TYPE_LOG:
+			if (NULL == (value->value.log = vc_item_logdup(item, source_value->value.log)))
+				goto out;
+			break;
+		default:
+			value->value = source_value->value;
+	}
+	value->timestamp = source_value->timestamp;
+
+	ret = SUCCEED;
+out:
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: copies values at the beginning of item tail chunk                 *
+ *                                                                            *
+ * Parameters: item       - [IN/OUT] the target item                          *
+ *             values     - [IN] the values to copy                           *
+ *             values_num - [IN] the number of values to copy                 *
+ *                                                                            *
+ * Return value: SUCCEED - the values were copied successfully                *
+ *               FAIL    - the value copying failed (not enough space for     *
+ *                         string, text or log type data)                     *
+ *                                                                            *
+ * Comments: This function is used to copy data to cache. The contents of     *
+ *           str, text and log type values are stored in cache string pool.   *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_copy_values_at_tail(zbx_vc_item_t *item, const zbx_history_record_t *values, int values_num)
+{
+	int	i, ret = FAIL, first_value = item->tail->first_value;
+
+	switch (item->value_type)
+	{
+		case ITEM_VALUE_TYPE_STR:
+		case ITEM_VALUE_TYPE_TEXT:
+			for (i = values_num - 1; i >= 0; i--)
+			{
+				zbx_history_record_t	*value = &item->tail->slots[item->tail->first_value - 1];
+
+				if (NULL == (value->value.str = vc_item_strdup(item, values[i].value.str)))
+					goto out;
+
+				value->timestamp = values[i].timestamp;
+				item->tail->first_value--;
+			}
+			ret = SUCCEED;
+
+			break;
+		case ITEM_VALUE_TYPE_LOG:
+			for (i = values_num - 1; i >= 0; i--)
+			{
+				zbx_history_record_t	*value = &item->tail->slots[item->tail->first_value - 1];
+
+				if (NULL == (value->value.log = vc_item_logdup(item, values[i].value.log)))
+					goto out;
+
+				value->timestamp = values[i].timestamp;
+				item->tail->first_value--;
+			}
+			ret = SUCCEED;
+
+			break;
+		default:
+			memcpy(&item->tail->slots[item->tail->first_value - values_num], values,
+					(size_t)values_num * sizeof(zbx_history_record_t));
+			item->tail->first_value -= values_num;
+			ret = SUCCEED;
+	}
+out:
+	item->values_total += first_value - item->tail->first_value;
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: frees cache resources of the specified chunk value range          *
+ *                                                                            *
+ * Parameters: item    - [IN] the chunk owner item                            *
+ *             chunk   - [IN] the chunk                                       *
+ *             first   - [IN] the first value to free                         *
+ *             last    - [IN] the last value to free                          *
+ *                                                                            *
+ * Return value: the number of bytes freed                                    *
+ *                                                                            *
+ * Comments: Values of compressed chunks are stored in chunk data, so only    *
+ *           the item value counter is updated for them.                      *
+ *                                                                            *
+ ******************************************************************************/
+static size_t	vch_chunk_free_values(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk, int first, int last)
+{
+	if (0 != chunk->compressed_size)
+	{
+		item->values_total -= (last - first + 1);
+		return 0;
+	}
+
+	return vc_item_free_values(item, chunk->slots, first, last);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: frees chunk and all resources allocated to store its values       *
+ *                                                                            *
+ * Parameters: item    - [IN] the chunk owner item                            *
+ *             chunk   - [IN] the chunk to free                               *
+ *                                                                            *
+ * Return value: the number of bytes freed                                    *
+ *                                                                            *
+ ******************************************************************************/
+static size_t	vch_item_free_chunk(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk)
+{
+	size_t	freed;
+
+	if (0 != chunk->compressed_size)
+		freed = offsetof(zbx_vc_chunk_t, slots) + (size_t)chunk->compressed_size;
+	else
+		freed = sizeof(zbx_vc_chunk_t) + (size_t)(chunk->slots_num - 1) * sizeof(zbx_history_record_t);
+
+	freed += vch_chunk_free_values(item, chunk, chunk->first_value, chunk->last_value);
+
+	vc_mem_free(chunk);
+
+	return freed;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: removes item history data chunk                                   *
+ *                                                                            *
+ * Parameters: item    - [IN ] the chunk owner item                           *
+ *             chunk   - [IN] the chunk to remove                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_remove_chunk(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk)
+{
+	if (NULL != chunk->next)
+		chunk->next->prev = chunk->prev;
+
+	if (NULL != chunk->prev)
+		chunk->prev->next = chunk->next;
+
+	if (chunk == item->head)
+		item->head = chunk->prev;
+
+	if (chunk == item->tail)
+		item->tail = chunk->next;
+
+	vch_item_free_chunk(item, chunk);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: removes item history data that are outside (older) the maximum    *
+ *          request range                                                     *
+ *                                                                            *
+ * Parameters:  item      - [IN] the target item                              *
+ *              timestamp - [IN] last timestamp in active range               *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_clean_cache(zbx_vc_item_t *item, int timestamp)
+{
+	zbx_vc_chunk_t	*next;
+
+	if (0 != item->active_range)
+	{
+		zbx_vc_chunk_t	*tail = item->tail;
+		zbx_vc_chunk_t	*chunk = tail;
+
+		timestamp -= item->active_range;
+
+		/* Try to remove chunks with all history values older than maximum request range, maximum */
+		/* request range should be calculated from last received value with which active range    */
+		/* was calculated to avoid dropping of chunks that might be still used in count request.  */
+		while (NULL != chunk && vch_chunk_slots(chunk)[chunk->last_value].timestamp.sec < timestamp &&
+				vch_chunk_slots(chunk)[chunk->last_value].timestamp.sec !=
+						item->head->slots[item->head->last_value].timestamp.sec)
+		{
+			/* don't remove the head chunk */
+			if (NULL == (next = chunk->next))
+				break;
+
+			/* Values with the same timestamps (seconds resolution) always should be either   */
+			/* kept in cache or removed together. There should not be a case when one of them */
+			/* is in cache and the second is dropped.                                         */
+			/* Here we are handling rare case, when the last value of first chunk has the     */
+			/* same timestamp (seconds resolution) as the first value in the second chunk.    */
+			/* In this case increase the first value index of the next chunk until the first  */
+			/* value timestamp is greater.                                                    */
+
+			if (vch_chunk_slots(next)[next->first_value].timestamp.sec !=
+					vch_chunk_slots(next)[next->last_value].timestamp.sec)
+			{
+				while (vch_chunk_slots(next)[next->first_value].timestamp.sec ==
+						vch_chunk_slots(chunk)[chunk->last_value].timestamp.sec)
+				{
+					vch_chunk_free_values(item, next, next->first_value, next->first_value);
+					next->first_value++;
+				}
+			}
+
+			/* set the database cached from timestamp to the last (oldest) removed value timestamp + 1 */
+			item->db_cached_from = vch_chunk_slots(chunk)[chunk->last_value].timestamp.sec + 1;
+
+			vch_item_remove_chunk(item, chunk);
+
+			chunk = next;
+		}
+
+		/* reset the status flags if data was removed from cache */
+		if (tail != item->tail)
+			item->status = 0;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: removes item history data that are older than the specified       *
+ *          timestamp                                                         *
+ *                                                                            *
+ * Parameters:  item      - [IN] the target item                              *
+ *              timestamp - [IN] the timestamp (number of seconds since the   *
+ *                               Epoch)                                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_remove_values(zbx_vc_item_t *item, int timestamp)
+{
+	zbx_vc_chunk_t	*chunk = item->tail;
+
+	vc_item_update_revision(item);
+
+	if (ZBX_ITEM_STATUS_CACHED_ALL == item->status)
+		item->status = 0;
+
+	/* try to remove chunks with all history values older than the timestamp */
+	while (NULL != chunk && vch_chunk_slots(chunk)[chunk->first_value].timestamp.sec < timestamp)
+	{
+		zbx_vc_chunk_t	*next;
+
+		/* If chunk contains values with timestamp greater or equal - remove */
+		/* only the values with less timestamp. Otherwise remove the while   */
+		/* chunk and check next one.                                         */
+		if (vch_chunk_slots(chunk)[chunk->last_value].timestamp.sec >= timestamp)
+		{
+			while (vch_chunk_slots(chunk)[chunk->first_value].timestamp.sec < timestamp)
+			{
+				vch_chunk_free_values(item, chunk, chunk->first_value, chunk->first_value);
+				chunk->first_value++;
+			}
+
+			break;
+		}
+
+		next = chunk->next;
+		vch_item_remove_chunk(item, chunk);
+		chunk = next;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: replaces compressed item history data chunk with its uncompressed *
+ *          copy                                                              *
+ *                                                                            *
+ * Parameters: item  - [IN/OUT] the chunk owner item                          *
+ *             chunk - [IN] the compressed chunk                              *
+ *                                                                            *
+ * Return value: SUCCEED - the chunk was uncompressed                         *
+ *               FAIL    - not enough memory to store uncompressed chunk      *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_uncompress_chunk(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk)
+{
+	const zbx_history_record_t	*slots;
+	zbx_vc_chunk_t			*uchunk;
+	int				i;
+
+	if (NULL == (uchunk = (zbx_vc_chunk_t *)vc_item_malloc(item, sizeof(zbx_vc_chunk_t) +
+			sizeof(zbx_history_record_t) * (size_t)(chunk->slots_num - 1))))
+	{
+		return FAIL;
+	}
+
+	memset(uchunk, 0, sizeof(zbx_vc_chunk_t));
+	uchunk->slots_num = chunk->slots_num;
+	uchunk->first_value = chunk->first_value;
+	uchunk->last_value = chunk->last_value;
+
+	slots = vch_chunk_slots(chunk);
+
+	for (i = chunk->first_value; i <= chunk->last_value; i++)
+	{
+		if (SUCCEED != vch_item_copy_value(item, uchunk, i, &slots[i]))
+		{
+			if (i != chunk->first_value)
+			{
+				vc_item_free_values(item, uchunk->slots, chunk->first_value, i - 1);
+
+				/* the values are still kept in the compressed chunk */
+				item->values_total += i - chunk->first_value;
+			}
+
+			vc_mem_free(uchunk);
+
+			return FAIL;
+		}
+	}
+
+	uchunk->prev = chunk->prev;
+	uchunk->next = chunk->next;
+
+	if (NULL != uchunk->prev)
+		uchunk->prev->next = uchunk;
+	else
+		item->tail = uchunk;
+
+	uchunk->next->prev = uchunk;
+
+	vc_mem_free(chunk);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: uncompresses item history data chunks with values newer than the  *
+ *          specified value                                                   *
+ *                                                                            *
+ * Parameters: item   - [IN/OUT] the item                                     *
+ *             value  - [IN] the value to be inserted                         *
+ *             oldest - [OUT] the oldest uncompressed chunk, NULL if no       *
+ *                            chunks were uncompressed                        *
+ *                                                                            *
+ * Return value: SUCCEED - the chunks were uncompressed                       *
+ *               FAIL    - not enough memory to uncompress chunks             *
+ *                                                                            *
+ * Comments: Values newer than the inserted value are moved by one slot, so   *
+ *           the chunks storing them must be uncompressed first.              *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_uncompress_chunks(zbx_vc_item_t *item, const zbx_history_record_t *value,
+		zbx_vc_chunk_t **oldest)
+{
+	zbx_vc_chunk_t	*chunk, *prev;
+
+	*oldest = NULL;
+
+	for (chunk = item->head; NULL != chunk; chunk = prev)
+	{
+		if (0 >= zbx_timespec_compare(&vch_chunk_slots(chunk)[chunk->last_value].timestamp, &value->timestamp))
+			break;
+
+		prev = chunk->prev;
+
+		if (0 != chunk->compressed_size)
+		{
+			if (SUCCEED != vch_item_uncompress_chunk(item, chunk))
+				return FAIL;
+
+			*oldest = (NULL != prev ? prev->next : item->tail);
+		}
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds one item history value at the end of current item's history  *
+ *          data                                                              *
+ *                                                                            *
+ * Parameters:  item   - [IN] the item to add history data to                 *
+ *              value  - [IN] the item history data value                     *
+ *                                                                            *
+ * Return value: SUCCEED - the history data value was added successfully      *
+ *               FAIL - failed to add history data value (not enough memory)  *
+ *                                                                            *
+ * Comments: In the case of failure the item will be removed from cache       *
+ *           later.                                                           *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_add_value_at_head(zbx_vc_item_t *item, const zbx_history_record_t *value)
+{
+	int		ret = FAIL, index, sindex, nslots = 0;
+	zbx_vc_chunk_t	*chunk, *schunk, *oldest = NULL;
+
+	if (NULL != item->head &&
+			0 < zbx_history_record_compare_asc_func(&item->head->slots[item->head->last_value], value))
+	{
+		if (0 < zbx_history_record_compare_asc_func(&vch_chunk_slots(item->tail)[item->tail->first_value], value))
+		{
+			/* If the added value has the same or older timestamp as the first value in cache */
+			/* we can't add it to keep cache consistency. Additionally we must make sure no   */
+			/* values with matching timestamp seconds are kept in cache.                      */
+			vch_item_remove_values(item, value->timestamp.sec + 1);
+
+			/* empty items must be removed to avoid situation when a new value is added to cache */
+			/* while other values with matching timestamp seconds are not cached                 */
+			if (NULL == item->head)
+				goto out;
+
+			/* if the value is newer than the database cached from timestamp we must */
+			/* adjust the cached from timestamp to exclude this value                */
+			if (item->db_cached_from <= value->timestamp.sec)
+				item->db_cached_from = value->timestamp.sec + 1;
+
+			ret = SUCCEED;
+			goto out;
+		}
+
+		if (SUCCEED != vch_item_uncompress_chunks(item, value, &oldest))
+			goto out;
+
+		vc_item_update_revision(item);
+
+		sindex = item->head->last_value;
+		schunk = item->head;
+
+		if (0 == item->head->slots_num - item->head->last_value - 1)
+		{
+			if (FAIL == vch_item_add_chunk(item, vch_item_chunk_slot_count(item, 1), NULL))
+				goto out;
+		}
+		else
+			item->head->last_value++;
+
+		item->values_total++;
+
+		chunk = item->head;
+		index = item->head->last_value;
+
+		do
+		{
+			chunk->slots[index] = schunk->slots[sindex];
+
+			chunk = schunk;
+			index = sindex;
+
+			if (--sindex < schunk->first_value)
+			{
+				if (NULL == (schunk = schunk->prev))
+				{
+					memset(&chunk->slots[index], 0, sizeof(zbx_vc_chunk_t));
+					THIS_SHOULD_NEVER_HAPPEN;
+
+					goto out;
+				}
+
+				sindex = schunk->last_value;
+			}
+		}
+		while (0 < zbx_timespec_compare(&vch_chunk_slots(schunk)[sindex].timestamp, &value->timestamp));
+	}
+	else
 	{
 		/* find the number of free slots on the right side in last (head) chunk */
 		if (NULL != item->head)
 			nslots = item->head->slots_num - item->head->last_value - 1;
 
-		if (0 == nslots)
+		if (0 == nslots)
+		{
+			if (FAIL == vch_item_add_chunk(item, vch_item_chunk_slot_count(item, 1), NULL))
+				goto out;
+		}
+		else
+			item->head->last_value++;
+
+		item->values_total++;
+
+		chunk = item->head;
+		index = item->head->last_value;
+	}
+
+	if (SUCCEED != vch_item_copy_value(item, chunk, index, value))
+		goto out;
+
+	/* compress back the chunks uncompressed to insert the value */
+	for (chunk = oldest; NULL != chunk && chunk != item->head; chunk = schunk)
+	{
+		schunk = chunk->next;
+		vch_item_compress_chunk(item, chunk);
+	}
+
+	/* the previous head chunk can be compressed after a new head chunk was added */
+	vch_item_compress_chunk(item, item->head->prev);
+
+	ret = SUCCEED;
+out:
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds item history values at the beginning of current item's       *
+ *          history data                                                      *
+ *                                                                            *
+ * Parameters:  item   - [IN] the item to add history data to                 *
+ *              values - [IN] the item history data values                    *
+ *              num    - [IN] the number of history data values to add        *
+ *                                                                            *
+ * Return value: SUCCEED - the history data values were added successfully    *
+ *               FAIL - failed to add history data values (not enough memory) *
+ *                                                                            *
+ * Comments: In the case of failure the item is removed from cache.           *
+ *           Overlapping values (by timestamp seconds) are ignored.           *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_add_values_at_tail(zbx_vc_item_t *item, const zbx_history_record_t *values, int values_num)
+{
+	int 		count = values_num, ret = FAIL;
+	zbx_vc_chunk_t	*chunk, *next;
+
+	/* skip values already added to the item cache by another process */
+	if (NULL != item->tail)
+	{
+		int	sec = vch_chunk_slots(item->tail)[item->tail->first_value].timestamp.sec;
+
+		while (--count >= 0 && values[count].timestamp.sec >= sec)
+			;
+		++count;
+	}
+
+	while (0 != count)
+	{
+		int	copy_slots, nslots = 0;
+
+		/* find the number of free slots on the left side in first (tail) chunk */
+		if (NULL != item->tail && 0 == item->tail->compressed_size)
+			nslots = item->tail->first_value;
+
+		if (0 == nslots)
+		{
+			nslots = vch_item_chunk_slot_count(item, count);
+
+			if (FAIL == vch_item_add_chunk(item, nslots, item->tail))
+				goto out;
+
+			item->tail->last_value = nslots - 1;
+			item->tail->first_value = nslots;
+		}
+
+		/* copy values to chunk */
+		copy_slots = MIN(nslots, count);
+		count -= copy_slots;
+
+		if (FAIL == vch_item_copy_values_at_tail(item, values + count, copy_slots))
+			goto out;
+	}
+
+	/* compress the filled chunks */
+	for (chunk = item->tail; NULL != chunk && chunk != item->head; chunk = next)
+	{
+		next = chunk->next;
+		vch_item_compress_chunk(item, chunk);
+	}
+
+	ret = SUCCEED;
+out:
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: locks cache and item after reading item values from database,     *
+ *          adding the item to cache if necessary                             *
+ *                                                                            *
+ * Parameters: itemid     - [IN] the item id                                  *
+ *             value_type - [IN] the item value type                          *
+ *             exclusive  - [IN] 1 - lock cache in exclusive mode             *
+ *                               0 - lock cache in shared mode                *
+ *                                                                            *
+ * Return value: the cached item or NULL if it could not be added to cache    *
+ *                                                                            *
+ * Comments: The cache and item are locked also when NULL is returned.        *
+ *           Values read from database are added to cache in exclusive mode,  *
+ *           so that other items can be removed in place if there is not      *
+ *           enough space to store them.                                      *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_vc_item_t	*vc_item_relock(zbx_uint64_t itemid, unsigned char value_type, int exclusive)
+{
+	zbx_vc_item_t	*item;
+
+	if (0 != exclusive)
+		WRLOCK_CACHE;
+	else
+		RDLOCK_CACHE;
+
+	if (NULL == (item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid)))
+	{
+		zbx_vc_item_t	new_item = {.itemid = itemid, .value_type = value_type};
+
+		/* adding item changes cached item set, which must be done in exclusive mode */
+		if (0 == exclusive)
+		{
+			UNLOCK_CACHE;
+			WRLOCK_CACHE;
+		}
+
+		if (NULL == zbx_hashset_search(&vc_cache->items, &itemid))
+		{
+			new_item.revision = ++vc_cache->item_revision;
+			(void)zbx_hashset_insert(&vc_cache->items, &new_item, sizeof(new_item));
+		}
+
+		if (0 == exclusive)
+		{
+			UNLOCK_CACHE;
+			RDLOCK_CACHE;
+		}
+
+		item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid);
+	}
+
+	LOCK_ITEM(itemid);
+
+	return item;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: cache item history data for the specified time period             *
+ *                                                                            *
+ * Parameters: item        - [IN] the item                                    *
+ *             range_start - [IN] the interval start time                     *
+ *                                                                            *
+ * Return value:  >=0    - the number of values read from database            *
+ *                FAIL   - an error occurred while trying to cache values     *
+ *                                                                            *
+ * Comments: This function checks if the requested value range is cached and  *
+ *           updates cache from database if necessary.                        *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_cache_values_by_time(zbx_vc_item_t **item, int range_start)
+{
+	int				ret, range_end;
+	zbx_vector_history_record_t	records;
+	zbx_uint64_t			itemid;
+	unsigned char			value_type;
+
+	if (ZBX_ITEM_STATUS_CACHED_ALL == (*item)->status)
+		return SUCCEED;
+
+	/* check if the requested period is in the cached range */
+	if (0 != (*item)->db_cached_from && range_start >= (*item)->db_cached_from)
+		return SUCCEED;
+
+	/* find if the cache should be updated to cover the required range */
+	if (NULL != (*item)->tail)
+	{
+		/* we need to get item values before the first cached value, but not including it */
+		range_end = vch_chunk_slots((*item)->tail)[(*item)->tail->first_value].timestamp.sec - 1;
+	}
+	else
+		range_end = ZBX_JAN_2038;
+
+	/* update cache if necessary */
+	if (range_start >= range_end)
+		return SUCCEED;
+
+	zbx_vector_history_record_create(&records);
+	itemid = (*item)->itemid;
+	value_type = (*item)->value_type;
+
+	UNLOCK_ITEM(itemid);
+	UNLOCK_CACHE;
+
+	if (SUCCEED == (ret = vc_db_read_values_by_time(itemid, value_type, &records, range_start, range_end)))
+	{
+		zbx_vector_history_record_sort(&records,
+				(zbx_compare_func_t)zbx_history_record_compare_asc_func);
+	}
+
+	*item = vc_item_relock(itemid, value_type, 0 < records.values_num);
+
+	if (SUCCEED != ret)
+		goto out;
+
+	if (NULL == *item)
+	{
+		ret = FAIL;
+		goto out;
+	}
+
+	/* when updating cache with time based request we can always reset status flags */
+	/* flag even if the requested period contains no data                           */
+	(*item)->status = 0;
+
+	if (0 < records.values_num)
+	{
+		if (SUCCEED != (ret = vch_item_add_values_at_tail(*item, records.values, records.values_num)))
+			goto out;
+	}
+
+	ret = records.values_num;
+	vc_item_update_db_cached_from(*item, range_start);
+out:
+	zbx_history_record_vector_destroy(&records, value_type);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: cache the specified number of history data values for time period *
+ *          since timestamp                                                   *
+ *                                                                            *
+ * Parameters: item        - [IN] the item                                    *
+ *             range_start - [IN] the interval start time                     *
+ *             count       - [IN] the number of history values to retrieve    *
+ *             ts          - [IN] the target timestamp                        *
+ *                                                                            *
+ * Return value:  >=0    - the number of values read from database            *
+ *                FAIL   - an error occurred while trying to cache values     *
+ *                                                                            *
+ * Comments: This function checks if the requested number of values is cached *
+ *           and updates cache from database if necessary.                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_cache_values_by_time_and_count(zbx_vc_item_t **item, int range_start, int count,
+		const zbx_timespec_t *ts)
+{
+	int				ret = SUCCEED, cached_records = 0, range_end, records_offset;
+	zbx_vector_history_record_t	records;
+	zbx_uint64_t			itemid;
+	unsigned char			value_type;
+
+	if (ZBX_ITEM_STATUS_CACHED_ALL == (*item)->status)
+		return SUCCEED;
+
+	/* check if the requested period is in the cached range */
+	if (0 != (*item)->db_cached_from && range_start >= (*item)->db_cached_from)
+		return SUCCEED;
+
+	/* find if the cache should be updated to cover the required count */
+	if (NULL != (*item)->head)
+	{
+		zbx_vc_chunk_t	*chunk;
+		int		index;
+
+		if (SUCCEED == vch_item_get_last_value(*item, ts, &chunk, &index))
+		{
+			cached_records = index - chunk->first_value + 1;
+
+			while (NULL != (chunk = chunk->prev) && cached_records < count)
+				cached_records += chunk->last_value - chunk->first_value + 1;
+		}
+	}
+
+	/* update cache if necessary */
+	if (cached_records >= count)
+		return SUCCEED;
+
+	/* get the end timestamp to which (including) the values should be cached */
+	if (NULL != (*item)->head)
+		range_end = vch_chunk_slots((*item)->tail)[(*item)->tail->first_value].timestamp.sec - 1;
+	else
+		range_end = ZBX_JAN_2038;
+
+	itemid = (*item)->itemid;
+	value_type = (*item)->value_type;
+
+	UNLOCK_ITEM(itemid);
+	UNLOCK_CACHE;
+
+	zbx_vector_history_record_create(&records);
+
+	if (range_end > ts->sec)
+	{
+		ret = vc_db_read_values_by_time(itemid, value_type, &records, ts->sec + 1, range_end);
+		range_end = ts->sec;
+	}
+
+	records_offset = records.values_num;
+
+	if (SUCCEED == ret && SUCCEED == (ret = vc_db_read_values_by_time_and_count(itemid, value_type, &records,
+			range_start, count - cached_records, range_end, ts)))
+	{
+		zbx_vector_history_record_sort(&records,
+				(zbx_compare_func_t)zbx_history_record_compare_asc_func);
+	}
+
+	*item = vc_item_relock(itemid, value_type, 0 < records.values_num);
+
+	if (SUCCEED != ret)
+		goto out;
+
+	if (NULL == *item)
+	{
+		ret = FAIL;
+		goto out;
+	}
+
+	if (0 < records.values_num)
+		ret = vch_item_add_values_at_tail(*item, records.values, records.values_num);
+
+	if (SUCCEED != ret)
+		goto out;
+
+	ret = records.values_num;
+
+	if (0 == range_start && count - cached_records > records.values_num - records_offset)
+	{
+		(*item)->active_range = 0;
+		(*item)->daily_range = 0;
+		(*item)->status = ZBX_ITEM_STATUS_CACHED_ALL;
+	}
+
+	if ((count <= records.values_num || 0 == range_start) && 0 != records.values_num)
+	{
+		vc_item_update_db_cached_from(*item,
+				vch_chunk_slots((*item)->tail)[(*item)->tail->first_value].timestamp.sec);
+	}
+	else if (0 != range_start)
+		vc_item_update_db_cached_from(*item, range_start);
+
+out:
+	zbx_history_record_vector_destroy(&records, value_type);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: passes block of item history values to the values consumer        *
+ *                                                                            *
+ * Parameters: sink  - [IN] the values consumer                               *
+ *             slots - [IN] the item history values                           *
+ *             first - [IN] the index of the first (oldest) value to pass     *
+ *             last  - [IN] the index of the last (newest) value to pass      *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_values_sink_put(zbx_vc_values_sink_t *sink, const zbx_history_record_t *slots, int first,
+		int last)
+{
+	if (NULL != sink->values)
+	{
+		int	i;
+
+		for (i = last; i >= first; i--)
+			vc_history_record_vector_append(sink->values, sink->value_type, &slots[i]);
+	}
+	else
+		sink->values_func(slots + first, last - first + 1, sink->values_data);
+
+	sink->values_num += last - first + 1;
+	sink->oldest_sec = slots[first].timestamp.sec;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: retrieves item history data from cache                            *
+ *                                                                            *
+ * Parameters: item      - [IN] the item                                      *
+ *             sink      - [OUT] the consumer of item history data            *
+ *             seconds   - [IN] the time period to retrieve data for          *
+ *             ts        - [IN] the requested period end timestamp            *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_get_values_by_time(const zbx_vc_item_t *item, zbx_vc_values_sink_t *sink, int seconds,
+		const zbx_timespec_t *ts)
+{
+	int				index, last, now;
+	zbx_timespec_t			start = {ts->sec - seconds, ts->ns};
+	zbx_vc_chunk_t			*chunk;
+	const zbx_history_record_t	*slots;
+
+	/* Check if maximum request range is not set and all data are cached.  */
+	/* Because that indicates there was a count based request with unknown */
+	/* range which might be greater than the current request range.        */
+	if (0 != item->active_range || ZBX_ITEM_STATUS_CACHED_ALL != item->status)
+	{
+		now = (int)time(NULL);
+		/* add another second to include nanosecond shifts */
+		vc_cache_item_update(item->itemid, ZBX_VC_UPDATE_RANGE, seconds + now - ts->sec + 1, now);
+	}
+
+	if (FAIL == vch_item_get_last_value(item, ts, &chunk, &index))
+	{
+		/* Cache does not contain records for the specified timeshift & seconds range. */
+		/* Return empty vector with success.                                           */
+		return;
+	}
+
+	/* pass item history values to the consumer until the start timestamp is reached */
+	while (0 < zbx_timespec_compare(&(slots = vch_chunk_slots(chunk))[chunk->last_value].timestamp, &start))
+	{
+		last = index;
+
+		while (index >= chunk->first_value && 0 < zbx_timespec_compare(&slots[index].timestamp, &start))
+			index--;
+
+		if (index != last)
+			vc_values_sink_put(sink, slots, index + 1, last);
+
+		if (NULL == (chunk = chunk->prev))
+			break;
+
+		index = chunk->last_value;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: retrieves item history data from cache                            *
+ *                                                                            *
+ * Parameters: item      - [IN] the item                                      *
+ *             sink      - [OUT] the consumer of item history data            *
+ *             seconds   - [IN] the time period                               *
+ *             count     - [IN] the number of history values to retrieve      *
+ *             timestamp - [IN] the target timestamp                          *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_get_values_by_time_and_count(zbx_vc_item_t *item, zbx_vc_values_sink_t *sink,
+		int seconds, int count, const zbx_timespec_t *ts)
+{
+	int				index, last, now, range_timestamp;
+	zbx_vc_chunk_t			*chunk;
+	zbx_timespec_t			start;
+	const zbx_history_record_t	*slots;
+
+	/* set start timestamp of the requested time period */
+	if (0 != seconds)
+	{
+		start.sec = ts->sec - seconds;
+		start.ns = ts->ns;
+	}
+	else
+	{
+		start.sec = 0;
+		start.ns = 0;
+	}
+
+	if (FAIL == vch_item_get_last_value(item, ts, &chunk, &index))
+	{
+		/* return empty vector with success */
+		goto out;
+	}
+
+	/* pass item history values to the consumer until the <count> values are read */
+	/* or no more values within specified time period                             */
+	while (0 < zbx_timespec_compare(&(slots = vch_chunk_slots(chunk))[chunk->last_value].timestamp, &start))
+	{
+		last = index;
+
+		while (index >= chunk->first_value && 0 < zbx_timespec_compare(&slots[index].timestamp, &start) &&
+				sink->values_num + last - index < count)
+		{
+			index--;
+		}
+
+		if (index != last)
+			vc_values_sink_put(sink, slots, index + 1, last);
+
+		if (sink->values_num == count)
+			goto out;
+
+		if (NULL == (chunk = chunk->prev))
+			break;
+
+		index = chunk->last_value;
+	}
+out:
+	if (count > sink->values_num)
+	{
+		if (0 == seconds)
+			return;
+
+		/* not enough data in the requested period, set the range equal to the period plus */
+		/* one second to include nanosecond shifts                                         */
+		range_timestamp = ts->sec - seconds;
+	}
+	else
+	{
+		/* the requested number of values was retrieved, set the range to the oldest value timestamp */
+		range_timestamp = sink->oldest_sec - 1;
+	}
+
+	now = (int)time(NULL);
+	vc_cache_item_update(item->itemid, ZBX_VC_UPDATE_RANGE, now - range_timestamp, now);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get item values for the specified range                           *
+ *                                                                            *
+ * Parameters: item      - [IN] the item                                      *
+ *             sink      - [OUT] the consumer of item history data            *
+ *             seconds   - [IN] the time period to retrieve data for          *
+ *             count     - [IN] the number of history values to retrieve      *
+ *             ts        - [IN] the target timestamp                          *
+ *                                                                            *
+ * Return value:  SUCCEED - the item history data was retrieved successfully  *
+ *                FAIL    - the item history data was not retrieved           *
+ *                                                                            *
+ * Comments: This function returns data from cache if necessary updating it   *
+ *           from DB. If cache update was required and failed (not enough     *
+ *           memory to cache DB values), then this function also fails.       *
+ *           No values are passed to the consumer when this function fails.   *
+ *                                                                            *
+ *           If <count> is set then value range is defined as <count> values  *
+ *           before <timestamp>. Otherwise the range is defined as <seconds>  *
+ *           seconds before <timestamp>.                                      *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_process_values(zbx_vc_item_t *item, zbx_vc_values_sink_t *sink, int seconds,
+		int count, const zbx_timespec_t *ts)
+{
+	int	ret, records_read, hits, misses, range_start;
+
+	if (NULL != sink->values)
+		zbx_vector_history_record_clear(sink->values);
+
+	sink->values_num = 0;
+
+	if (0 == count)
+	{
+		if (0 > (range_start = ts->sec - seconds))
+			range_start = 0;
+
+		if (FAIL == (ret = vch_item_cache_values_by_time(&item, range_start)))
+			goto out;
+
+		records_read = ret;
+
+		vch_item_get_values_by_time(item, sink, seconds, ts);
+	}
+	else
+	{
+		range_start = (0 == seconds ? 0 : ts->sec - seconds);
+
+		if (FAIL == (ret = vch_item_cache_values_by_time_and_count(&item, range_start, count, ts)))
+			goto out;
+
+		records_read = ret;
+
+		vch_item_get_values_by_time_and_count(item, sink, seconds, count, ts);
+	}
+
+	if (records_read > sink->values_num)
+		records_read = sink->values_num;
+
+	hits = sink->values_num - records_read;
+	misses = records_read;
+
+	vc_cache_item_update(item->itemid, ZBX_VC_UPDATE_STATS, hits, misses);
+
+	ret = SUCCEED;
+out:
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: frees resources allocated for item history data                   *
+ *                                                                            *
+ * Parameters: item    - [IN] the item                                        *
+ *                                                                            *
+ * Return value: the size of freed memory (bytes)                             *
+ *                                                                            *
+ ******************************************************************************/
+static size_t	vch_item_free_cache(zbx_vc_item_t *item)
+{
+	size_t	freed = 0;
+
+	zbx_vc_chunk_t	*chunk = item->tail;
+
+	while (NULL != chunk)
+	{
+		zbx_vc_chunk_t	*next = chunk->next;
+
+		freed += vch_item_free_chunk(item, chunk);
+		chunk = next;
+	}
+	item->values_total = 0;
+	item->head = NULL;
+	item->tail = NULL;
+
+	return freed;
+}
+
+/******************************************************************************************************************
+ *                                                                                                                *
+ * Public API                                                                                                     *
+ *                                                                                                                *
+ ******************************************************************************************************************/
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: initializes value cache                                           *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_vc_init(zbx_uint64_t value_cache_size, char **error)
+{
+	zbx_uint64_t	size_reserved;
+	int		i, ret = FAIL;
+
+	if (0 == value_cache_size)
+		return SUCCEED;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	if (SUCCEED != (ret = zbx_rwlock_create(&vc_lock, ZBX_RWLOCK_VALUECACHE, error)))
+		goto out;
+
+	if (SUCCEED != (ret = zbx_mutex_create(&vc_mem_lock, ZBX_MUTEX_VALUECACHE, error)))
+		goto out;
+
+	for (i = 0; i < ZBX_MUTEX_VALUECACHE_ITEMS_NUM; i++)
+	{
+		if (SUCCEED != (ret = zbx_mutex_create(&vc_item_locks[i], ZBX_MUTEX_VALUECACHE_ITEM + i, error)))
+			goto out;
+	}
+
+	size_reserved = zbx_shmem_required_size(1, "value cache size", "ValueCacheSize");
+
+	if (SUCCEED != zbx_shmem_create(&vc_mem, value_cache_size, "value cache size", "ValueCacheSize", 1,
+			error))
+	{
+		goto out;
+	}
+
+	value_cache_size -= size_reserved;
+
+	vc_cache = (zbx_vc_cache_t *)__vc_shmem_malloc_func(vc_cache, sizeof(zbx_vc_cache_t));
+
+	if (NULL == vc_cache)
+	{
+		*error = zbx_strdup(*error, "cannot allocate value cache header");
+		goto out;
+	}
+	memset(vc_cache, 0, sizeof(zbx_vc_cache_t));
+
+	zbx_hashset_create_ext(&vc_cache->items, VC_ITEMS_INIT_SIZE,
+			ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC, NULL,
+			__vc_shmem_malloc_func, __vc_shmem_realloc_func, __vc_shmem_free_func);
+
+	if (NULL == vc_cache->items.slots)
+	{
+		*error = zbx_strdup(*error, "cannot allocate value cache data storage");
+		goto out;
+	}
+
+	zbx_hashset_create_ext(&vc_cache->strpool, VC_STRPOOL_INIT_SIZE,
+			vc_strpool_hash_func, vc_strpool_compare_func, NULL,
+			__vc_shmem_malloc_func, __vc_shmem_realloc_func, __vc_shmem_free_func);
+
+	if (NULL == vc_cache->strpool.slots)
+	{
+		*error = zbx_strdup(*error, "cannot allocate string pool for value cache data storage");
+		goto out;
+	}
+
+	/* the free space request should be 5% of cache size, but no more than 128KB */
+	vc_cache->min_free_request = (value_cache_size / 100) * 5;
+	if (vc_cache->min_free_request > 128 * ZBX_KIBIBYTE)
+		vc_cache->min_free_request = 128 * ZBX_KIBIBYTE;
+
+	zbx_vector_vc_itemupdate_create(&vc_itemupdates);
+	zbx_vector_vc_itemupdate_reserve(&vc_itemupdates, 256);
+
+	ret = SUCCEED;
+out:
+	zbx_vc_disable();
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: destroys value cache                                              *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_vc_destroy(void)
+{
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	if (NULL != vc_cache)
+	{
+		zbx_vector_vc_itemupdate_destroy(&vc_itemupdates);
+
+		zbx_hashset_destroy(&vc_cache->items);
+		zbx_hashset_destroy(&vc_cache->strpool);
+
+		__vc_shmem_free_func(vc_cache);
+		vc_cache = NULL;
+
+		zbx_shmem_destroy(vc_mem);
+		vc_mem = NULL;
+
+		for (int i = 0; i < ZBX_MUTEX_VALUECACHE_ITEMS_NUM; i++)
+			zbx_mutex_destroy(&vc_item_locks[i]);
+
+		zbx_mutex_destroy(&vc_mem_lock);
+		zbx_rwlock_destroy(&vc_lock);
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: resets value cache                                                *
+ *                                                                            *
+ * Comments: All items and their historical data are removed,                 *
+ *           cache working mode, statistics reset.                            *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_vc_reset(void)
+{
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	if (NULL != vc_cache)
+	{
+		zbx_vc_item_t		*item;
+		zbx_hashset_iter_t	iter;
+
+		WRLOCK_CACHE;
+
+		zbx_hashset_iter_reset(&vc_cache->items, &iter);
+		while (NULL != (item = (zbx_vc_item_t *)zbx_hashset_iter_next(&iter)))
 		{
-			if (FAIL == vch_item_add_chunk(item, vch_item_chunk_slot_count(item, 1), NULL))
-				goto out;
+			vch_item_free_cache(item);
+			zbx_hashset_iter_remove(&iter);
 		}
-		else
-			item->head->last_value++;
 
-		item->values_total++;
+		vc_cache->hits = 0;
+		vc_cache->misses = 0;
+		vc_cache->min_free_request = 0;
+		vc_cache->mode = ZBX_VC_MODE_NORMAL;
+		vc_cache->mode_time = 0;
+		vc_cache->last_warning_time = 0;
 
-		chunk = item->head;
-		index = item->head->last_value;
+		UNLOCK_CACHE;
 	}
 
-	if (SUCCEED != vch_item_copy_value(item, chunk, index, value))
-		goto out;
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
 
-	ret = SUCCEED;
-out:
-	return ret;
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds item values to the history and value cache                   *
+ *                                                                            *
+ * Parameters: history - [IN] item history values                             *
+ *                                                                            *
+ * Return value: SUCCEED - the values were added successfully                 *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_vc_add_values(zbx_vector_ptr_t *history, int *ret_flush)
+{
+	if (SUCCEED != zbx_history_add_values(history, ret_flush))
+		return FAIL;
+
+	zbx_vc_cache_values(history);
+
+	return SUCCEED;
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: adds item history values at the beginning of current item's       *
- *          history data                                                      *
+ * Purpose: adds item values to the value cache without writing them to       *
+ *          history storage                                                   *
  *                                                                            *
- * Parameters:  item   - [IN] the item to add history data to                 *
- *              values - [IN] the item history data values                    *
- *              num    - [IN] the number of history data values to add        *
+ * Parameters: history - [IN] item history values                             *
  *                                                                            *
- * Return value: SUCCEED - the history data values were added successfully    *
- *               FAIL - failed to add history data values (not enough memory) *
+ * Comments: Used when history storage receives different values than the     *
+ *           value cache, for example when item history is downsampled.       *
  *                                                                            *
- * Comments: In the case of failure the item is removed from cache.           *
- *           Overlapping values (by timestamp seconds) are ignored.           *
+ ******************************************************************************/
+void	zbx_vc_cache_values(const zbx_vector_ptr_t *history)
+{
+	zbx_vc_item_t		*item;
+	int			i;
+	zbx_dc_history_t	*h;
+	zbx_vector_uint64_t	itemids;
+
+	if (ZBX_VC_DISABLED == vc_state)
+		return;
+
+	zbx_vector_uint64_create(&itemids);
+
+	RDLOCK_CACHE;
+
+	for (i = 0; i < history->values_num; i++)
+	{
+		h = (zbx_dc_history_t *)history->values[i];
+
+		LOCK_ITEM(h->itemid);
+
+		if (NULL != (item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &h->itemid)))
+		{
+			zbx_history_record_t	record = {h->ts, h->value};
+			zbx_vc_chunk_t		*head = item->head;
+			int			last_value_timestamp;
+
+			if (NULL != head)
+				last_value_timestamp = head->slots[head->last_value].timestamp.sec;
+			else
+				last_value_timestamp = (int)time(NULL);
+
+			/* If the new value type does not match the item's type in cache remove it, */
+			/* so it's cached with the correct type from correct tables when accessed   */
+			/* next time.                                                               */
+			/* Also remove item if the value adding failed. In this case we             */
+			/* won't have the latest data in cache - so the requests must go directly   */
+			/* to the database.                                                         */
+			/* Removing item changes cached item set, so until it's removed in exclusive mode    */
+			/* drop its data - the following requests will read values from database.            */
+			if (item->value_type != h->value_type || FAIL == vch_item_add_value_at_head(item, &record))
+			{
+				vch_item_free_cache(item);
+				item->status = 0;
+				item->db_cached_from = 0;
+				zbx_vector_uint64_append(&itemids, item->itemid);
+			}
+			else if (head != item->head)
+			{
+				/* try to remove old (unused) chunks if a new chunk was added */
+				vch_item_clean_cache(item, last_value_timestamp);
+			}
+		}
+
+		UNLOCK_ITEM(h->itemid);
+	}
+
+	UNLOCK_CACHE;
+
+	if (0 != itemids.values_num || 0 != vc_space_request)
+	{
+		WRLOCK_CACHE;
+
+		for (i = 0; i < itemids.values_num; i++)
+			vc_remove_item_by_id(itemids.values[i]);
+
+		vc_release_requested_space();
+
+		UNLOCK_CACHE;
+	}
+
+	zbx_vector_uint64_destroy(&itemids);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get item history data for the specified time period               *
+ *                                                                            *
+ * Parameters: itemid     - [IN] the item id                                  *
+ *             value_type - [IN] the item value type                          *
+ *             sink       - [OUT] the consumer of item history data           *
+ *             seconds    - [IN] the time period to retrieve data for         *
+ *             count      - [IN] the number of history values to retrieve     *
+ *             ts         - [IN] the period end timestamp                     *
+ *                                                                            *
+ * Return value:  SUCCEED - the item history data was retrieved successfully  *
+ *                FAIL    - the item history data was not retrieved           *
  *                                                                            *
  ******************************************************************************/
-static int	vch_item_add_values_at_tail(zbx_vc_item_t *item, const zbx_history_record_t *values, int values_num)
+static int	vc_get_values(zbx_uint64_t itemid, unsigned char value_type, zbx_vc_values_sink_t *sink,
+		int seconds, int count, const zbx_timespec_t *ts)
 {
-	int 	count = values_num, ret = FAIL;
+	zbx_vc_item_t			*item, new_item;
+	int 				ret = FAIL, cache_used = 1;
+	zbx_vector_history_record_t	records, *values = sink->values;
 
-	/* skip values already added to the item cache by another process */
-	if (NULL != item->tail)
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() itemid:" ZBX_FS_UI64 " value_type:%d count:%d period:%d end_timestamp"
+			" '%s'", __func__, itemid, value_type, count, seconds, zbx_timespec_str(ts));
+
+	sink->value_type = value_type;
+
+	RDLOCK_CACHE;
+
+	if (ZBX_VC_DISABLED == vc_state)
+		goto out;
+
+	if (ZBX_VC_MODE_LOWMEM == vc_cache->mode)
+	{
+		vc_mem_lock_shared();
+		vc_warn_low_memory();
+		vc_mem_unlock_shared();
+	}
+
+	LOCK_ITEM(itemid);
+
+	if (NULL == (item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid)))
 	{
-		int	sec = item->tail->slots[item->tail->first_value].timestamp.sec;
+		if (ZBX_VC_MODE_NORMAL != vc_cache->mode)
+			goto unlock;
 
-		while (--count >= 0 && values[count].timestamp.sec >= sec)
-			;
-		++count;
+		memset(&new_item, 0, sizeof(new_item));
+		new_item.itemid = itemid;
+		new_item.value_type = value_type;
+		item = &new_item;
 	}
+	else if (item->value_type != value_type)
+		goto unlock;
 
-	while (0 != count)
+	ret = vch_item_process_values(item, sink, seconds, count, ts);
+unlock:
+	UNLOCK_ITEM(itemid);
+out:
+	if (FAIL == ret)
 	{
-		int	copy_slots, nslots = 0;
+		cache_used = 0;
 
-		/* find the number of free slots on the left side in first (tail) chunk */
-		if (NULL != item->tail)
-			nslots = item->tail->first_value;
+		/* values read directly from database are passed to callback after unlocking cache */
+		if (NULL == values)
+		{
+			zbx_history_record_vector_create(&records);
+			values = &records;
+		}
+		else
+			zbx_vector_history_record_clear(values);
 
-		if (0 == nslots)
+		UNLOCK_CACHE;
+		ret = vc_db_get_values(itemid, value_type, values, seconds, count, ts);
+		WRLOCK_CACHE;
+
+		if (ZBX_VC_DISABLED != vc_state)
 		{
-			nslots = vch_item_chunk_slot_count(item, count);
+			vc_remove_item_by_id(itemid);
+			vc_release_requested_space();
+		}
 
-			if (FAIL == vch_item_add_chunk(item, nslots, item->tail))
-				goto out;
+		sink->values_num = values->values_num;
 
-			item->tail->last_value = nslots - 1;
-			item->tail->first_value = nslots;
+		if (SUCCEED == ret)
+			vc_update_statistics(NULL, 0, values->values_num, (int)time(NULL));
+	}
+
+	UNLOCK_CACHE;
+
+	if (&records == values)
+	{
+		if (SUCCEED == ret && 0 != records.values_num)
+		{
+			int	i;
+
+			/* the callback expects values in ascending order */
+			for (i = 0; i < records.values_num / 2; i++)
+			{
+				zbx_history_record_t	record = records.values[i];
+
+				records.values[i] = records.values[records.values_num - i - 1];
+				records.values[records.values_num - i - 1] = record;
+			}
+
+			sink->values_func(records.values, records.values_num, sink->values_data);
 		}
 
-		/* copy values to chunk */
-		copy_slots = MIN(nslots, count);
-		count -= copy_slots;
+		zbx_history_record_vector_destroy(&records, value_type);
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s count:%d cached:%d",
+			__func__, zbx_result_string(ret), sink->values_num, cache_used);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get item history data for the specified time period               *
+ *                                                                            *
+ * Parameters: itemid     - [IN] the item id                                  *
+ *             value_type - [IN] the item value type                          *
+ *             values     - [OUT] the item history data stored time/value     *
+ *                          pairs in descending order                         *
+ *             seconds    - [IN] the time period to retrieve data for         *
+ *             count      - [IN] the number of history values to retrieve     *
+ *             ts         - [IN] the period end timestamp                     *
+ *                                                                            *
+ * Return value:  SUCCEED - the item history data was retrieved successfully  *
+ *                FAIL    - the item history data was not retrieved           *
+ *                                                                            *
+ * Comments: If the data is not in cache, it's read from DB, so this function *
+ *           will always return the requested data, unless some error occurs. *
+ *                                                                            *
+ *           If <count> is set then value range is defined as <count> values  *
+ *           before <timestamp>. Otherwise the range is defined as <seconds>  *
+ *           seconds before <timestamp>.                                      *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_vc_get_values(zbx_uint64_t itemid, unsigned char value_type, zbx_vector_history_record_t *values,
+		int seconds, int count, const zbx_timespec_t *ts)
+{
+	zbx_vc_values_sink_t	sink = {.values = values};
+
+	return vc_get_values(itemid, value_type, &sink, seconds, count, ts);
+}
 
-		if (FAIL == vch_item_copy_values_at_tail(item, values + count, copy_slots))
-			goto out;
-	}
+/******************************************************************************
+ *                                                                            *
+ * Purpose: processes item history data for the specified time period         *
+ *          without copying it                                                *
+ *                                                                            *
+ * Parameters: itemid      - [IN] the item id                                 *
+ *             value_type  - [IN] the item value type                         *
+ *             seconds     - [IN] the time period to retrieve data for        *
+ *             count       - [IN] the number of history values to retrieve    *
+ *             ts          - [IN] the period end timestamp                    *
+ *             values_func - [IN] the callback to process values              *
+ *             values_data - [IN] the callback data                           *
+ *                                                                            *
+ * Return value:  SUCCEED - the item history data was processed successfully  *
+ *                FAIL    - the item history data was not retrieved           *
+ *                                                                            *
+ * Comments: The values are passed to callback in blocks of values sorted in  *
+ *           ascending order, starting with the newest block. So iterating    *
+ *           each block backwards processes values in the same order as they  *
+ *           are returned by zbx_vc_get_values() function.                    *
+ *                                                                            *
+ *           The callback is called with cache locked, so it must not call    *
+ *           value cache functions or keep references to the passed values.   *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_vc_iterate_values(zbx_uint64_t itemid, unsigned char value_type, int seconds, int count,
+		const zbx_timespec_t *ts, zbx_vc_values_func_t values_func, void *values_data)
+{
+	zbx_vc_values_sink_t	sink = {.values_func = values_func, .values_data = values_data};
 
-	ret = SUCCEED;
-out:
-	return ret;
+	return vc_get_values(itemid, value_type, &sink, seconds, count, ts);
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: cache item history data for the specified time period             *
+ * Purpose: gets the revision of cached item data                             *
  *                                                                            *
- * Parameters: item        - [IN] the item                                    *
- *             range_start - [IN] the interval start time                     *
+ * Parameters: itemid     - [IN] the item id                                  *
+ *             value_type - [IN] the item value type                          *
+ *             revision   - [OUT] the item data revision                      *
  *                                                                            *
- * Return value:  >=0    - the number of values read from database            *
- *                FAIL   - an error occurred while trying to cache values     *
+ * Return value:  SUCCEED - the item data revision was returned               *
+ *                FAIL    - the item is not cached                            *
  *                                                                            *
- * Comments: This function checks if the requested value range is cached and  *
- *           updates cache from database if necessary.                        *
+ * Comments: The revision is changed when item is added to cache or when      *
+ *           values are inserted or removed not at the head of cached data.   *
+ *           While revision is not changed any values added to the item are   *
+ *           newer than the already cached values, allowing callers to keep   *
+ *           aggregates of item values and updating them with new values.     *
  *                                                                            *
  ******************************************************************************/
-static int	vch_item_cache_values_by_time(zbx_vc_item_t **item, int range_start)
+int	zbx_vc_get_item_revision(zbx_uint64_t itemid, unsigned char value_type, zbx_uint64_t *revision)
 {
-	int				ret, range_end;
-	zbx_vector_history_record_t	records;
-	zbx_uint64_t			itemid;
-	unsigned char			value_type;
+	zbx_vc_item_t	*item;
+	int		ret = FAIL;
 
-	if (ZBX_ITEM_STATUS_CACHED_ALL == (*item)->status)
-		return SUCCEED;
+	if (ZBX_VC_DISABLED == vc_state)
+		return FAIL;
 
-	/* check if the requested period is in the cached range */
-	if (0 != (*item)->db_cached_from && range_start >= (*item)->db_cached_from)
-		return SUCCEED;
+	RDLOCK_CACHE;
+	LOCK_ITEM(itemid);
 
-	/* find if the cache should be updated to cover the required range */
-	if (NULL != (*item)->tail)
+	if (NULL != (item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid)) &&
+			item->value_type == value_type && NULL != item->head)
 	{
-		/* we need to get item values before the first cached value, but not including it */
-		range_end = (*item)->tail->slots[(*item)->tail->first_value].timestamp.sec - 1;
+		*revision = item->revision;
+		ret = SUCCEED;
 	}
-	else
-		range_end = ZBX_JAN_2038;
-
-	/* update cache if necessary */
-	if (range_start >= range_end)
-		return SUCCEED;
-
-	zbx_vector_history_record_create(&records);
-	itemid = (*item)->itemid;
-	value_type = (*item)->value_type;
 
+	UNLOCK_ITEM(itemid);
 	UNLOCK_CACHE;
 
-	if (SUCCEED == (ret = vc_db_read_values_by_time(itemid, value_type, &records, range_start, range_end)))
-	{
-		zbx_vector_history_record_sort(&records,
-				(zbx_compare_func_t)zbx_history_record_compare_asc_func);
-	}
-
-	WRLOCK_CACHE;
-
-	if (SUCCEED != ret)
-		goto out;
-
-	if (NULL == (*item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid)))
-	{
-		zbx_vc_item_t	new_item = {.itemid = itemid, .value_type = value_type};
-
-		if (NULL == (*item = (zbx_vc_item_t *)zbx_hashset_insert(&vc_cache->items, &new_item,
-				sizeof(new_item))))
-		{
-			ret = FAIL;
-			goto out;
-		}
-	}
-
-	/* when updating cache with time based request we can always reset status flags */
-	/* flag even if the requested period contains no data                           */
-	(*item)->status = 0;
-
-	if (0 < records.values_num)
-	{
-		if (SUCCEED != (ret = vch_item_add_values_at_tail(*item, records.values, records.values_num)))
-			goto out;
-	}
-
-	ret = records.values_num;
-	vc_item_update_db_cached_from(*item, range_start);
-out:
-	zbx_history_record_vector_destroy(&records, value_type);
-
 	return ret;
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: cache the specified number of history data values for time period *
- *          since timestamp                                                   *
- *                                                                            *
- * Parameters: item        - [IN] the item                                    *
- *             range_start - [IN] the interval start time                     *
- *             count       - [IN] the number of history values to retrieve    *
- *             ts          - [IN] the target timestamp                        *
+ * Purpose: cache history values of multiple items with batched history       *
+ *          storage reads                                                     *
  *                                                                            *
- * Return value:  >=0    - the number of values read from database            *
- *                FAIL   - an error occurred while trying to cache values     *
+ * Parameters: requests     - [IN] the prefetch requests                      *
+ *             requests_num - [IN] the number of requests                     *
  *                                                                            *
- * Comments: This function checks if the requested number of values is cached *
- *           and updates cache from database if necessary.                    *
+ * Comments: Values already cached are not read again. Missing ranges are     *
+ *           read with zbx_history_get_values_batch() per value type, so that *
+ *           a following zbx_vc_get_values() call for the same range is       *
+ *           served from cache instead of issuing a query per item.           *
  *                                                                            *
  ******************************************************************************/
-static int	vch_item_cache_values_by_time_and_count(zbx_vc_item_t **item, int range_start, int count,
-		const zbx_timespec_t *ts)
+void	zbx_vc_prefetch_values(const zbx_vc_prefetch_t *requests, int requests_num)
 {
-	int				ret = SUCCEED, cached_records = 0, range_end, records_offset;
-	zbx_vector_history_record_t	records;
-	zbx_uint64_t			itemid;
-	unsigned char			value_type;
+	zbx_history_query_t	*queries[ITEM_VALUE_TYPE_BIN + 1] = {0};
+	int			queries_num[ITEM_VALUE_TYPE_BIN + 1] = {0}, *range_starts[ITEM_VALUE_TYPE_BIN + 1] = {0};
+	int			i, j, value_type, cached = 0;
 
-	if (ZBX_ITEM_STATUS_CACHED_ALL == (*item)->status)
-		return SUCCEED;
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() requests:%d", __func__, requests_num);
 
-	/* check if the requested period is in the cached range */
-	if (0 != (*item)->db_cached_from && range_start >= (*item)->db_cached_from)
-		return SUCCEED;
+	if (ZBX_VC_DISABLED == vc_state)
+		goto out;
 
-	/* find if the cache should be updated to cover the required count */
-	if (NULL != (*item)->head)
+	RDLOCK_CACHE;
+
+	if (ZBX_VC_MODE_NORMAL != vc_cache->mode)
 	{
-		zbx_vc_chunk_t	*chunk;
-		int		index;
+		UNLOCK_CACHE;
+		goto out;
+	}
 
-		if (SUCCEED == vch_item_get_last_value(*item, ts, &chunk, &index))
-		{
-			cached_records = index - chunk->first_value + 1;
+	for (i = 0; i < requests_num; i++)
+	{
+		const zbx_vc_prefetch_t	*request = &requests[i];
+		zbx_vc_item_t		*item;
+		zbx_history_query_t	*query;
+		int			range_end = ZBX_JAN_2038;
 
-			while (NULL != (chunk = chunk->prev) && cached_records < count)
-				cached_records += chunk->last_value - chunk->first_value + 1;
+		if (ITEM_VALUE_TYPE_BIN < request->value_type || 0 >= request->range_start)
+			continue;
+
+		LOCK_ITEM(request->itemid);
+
+		if (NULL != (item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &request->itemid)))
+		{
+			if (item->value_type != request->value_type || ZBX_ITEM_STATUS_CACHED_ALL == item->status ||
+					(0 != item->db_cached_from && request->range_start >= item->db_cached_from))
+			{
+				range_end = 0;
+			}
+			else if (NULL != item->tail)
+				range_end = vch_chunk_slots(item->tail)[item->tail->first_value].timestamp.sec - 1;
 		}
-	}
 
-	/* update cache if necessary */
-	if (cached_records >= count)
-		return SUCCEED;
+		UNLOCK_ITEM(request->itemid);
 
-	/* get the end timestamp to which (including) the values should be cached */
-	if (NULL != (*item)->head)
-		range_end = (*item)->tail->slots[(*item)->tail->first_value].timestamp.sec - 1;
-	else
-		range_end = ZBX_JAN_2038;
+		if (request->range_start >= range_end)
+			continue;
 
-	itemid = (*item)->itemid;
-	value_type = (*item)->value_type;
-	UNLOCK_CACHE;
+		value_type = request->value_type;
 
-	zbx_vector_history_record_create(&records);
+		if (NULL == queries[value_type])
+		{
+			queries[value_type] = (zbx_history_query_t *)zbx_malloc(NULL,
+					sizeof(zbx_history_query_t) * (size_t)requests_num);
+			range_starts[value_type] = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)requests_num);
+		}
 
-	if (range_end > ts->sec)
-	{
-		ret = vc_db_read_values_by_time(itemid, value_type, &records, ts->sec + 1, range_end);
-		range_end = ts->sec;
+		query = &queries[value_type][queries_num[value_type]];
+		query->itemid = request->itemid;
+		/* interval starting point is excluded by history backend */
+		query->start = request->range_start - 1;
+		query->end = range_end;
+		zbx_history_record_vector_create(&query->values);
+
+		range_starts[value_type][queries_num[value_type]++] = request->range_start;
 	}
 
-	records_offset = records.values_num;
+	UNLOCK_CACHE;
 
-	if (SUCCEED == ret && SUCCEED == (ret = vc_db_read_values_by_time_and_count(itemid, value_type, &records,
-			range_start, count - cached_records, range_end, ts)))
+	for (value_type = 0; value_type <= ITEM_VALUE_TYPE_BIN; value_type++)
 	{
-		zbx_vector_history_record_sort(&records,
-				(zbx_compare_func_t)zbx_history_record_compare_asc_func);
-	}
+		if (0 == queries_num[value_type])
+			continue;
 
-	WRLOCK_CACHE;
+		zbx_history_get_values_batch(queries[value_type], queries_num[value_type], value_type);
 
-	if (SUCCEED != ret)
-		goto out;
+		for (j = 0; j < queries_num[value_type]; j++)
+		{
+			zbx_history_query_t	*query = &queries[value_type][j];
+			zbx_vc_item_t		*item;
 
-	if (NULL == (*item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid)))
-	{
-		zbx_vc_item_t	new_item = {.itemid = itemid, .value_type = value_type};
+			if (SUCCEED != query->ret)
+				goto next;
 
-		if (NULL == (*item = (zbx_vc_item_t *)zbx_hashset_insert(&vc_cache->items, &new_item, sizeof(new_item))))
-		{
-			ret = FAIL;
-			goto out;
-		}
-	}
+			zbx_vector_history_record_sort(&query->values,
+					(zbx_compare_func_t)zbx_history_record_compare_asc_func);
 
-	if (0 < records.values_num)
-		ret = vch_item_add_values_at_tail(*item, records.values, records.values_num);
+			if (NULL != (item = vc_item_relock(query->itemid, (unsigned char)value_type,
+					0 < query->values.values_num)) &&
+					item->value_type == value_type)
+			{
+				item->status = 0;
 
-	if (SUCCEED != ret)
-		goto out;
+				if (0 == query->values.values_num || SUCCEED == vch_item_add_values_at_tail(item,
+						query->values.values, query->values.values_num))
+				{
+					vc_item_update_db_cached_from(item, range_starts[value_type][j]);
+					cached++;
+				}
+			}
 
-	ret = records.values_num;
+			UNLOCK_ITEM(query->itemid);
+			UNLOCK_CACHE;
+next:
+			zbx_history_record_vector_destroy(&query->values, value_type);
+		}
 
-	if (0 == range_start && count - cached_records > records.values_num - records_offset)
-	{
-		(*item)->active_range = 0;
-		(*item)->daily_range = 0;
-		(*item)->status = ZBX_ITEM_STATUS_CACHED_ALL;
+		zbx_free(queries[value_type]);
+		zbx_free(range_starts[value_type]);
 	}
 
-	if ((count <= records.values_num || 0 == range_start) && 0 != records.values_num)
+	if (0 != vc_space_request)
 	{
-		vc_item_update_db_cached_from(*item,
-				(*item)->tail->slots[(*item)->tail->first_value].timestamp.sec);
+		WRLOCK_CACHE;
+		vc_release_requested_space();
+		UNLOCK_CACHE;
 	}
-	else if (0 != range_start)
-		vc_item_update_db_cached_from(*item, range_start);
-
 out:
-	zbx_history_record_vector_destroy(&records, value_type);
-
-	return ret;
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() cached:%d", __func__, cached);
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: retrieves item history data from cache                            *
+ * Purpose: get the last history value with a timestamp less or equal to the  *
+ *          target timestamp                                                  *
  *                                                                            *
- * Parameters: item      - [IN] the item                                      *
- *             values    - [OUT] the item history data stored time/value      *
- *                         pairs in undefined order                           *
- *             seconds   - [IN] the time period to retrieve data for          *
- *             ts        - [IN] the requested period end timestamp            *
+ * Parameters: itemid     - [IN] the item id                                  *
+ *             value_type - [IN] the item value type                          *
+ *             ts         - [IN] the target timestamp                         *
+ *             value      - [OUT] the value found                             *
+ *                                                                            *
+ * Return Value: SUCCEED - the item was retrieved                             *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Depending on the value type this function might allocate memory  *
+ *           to store value data. To free it use zbx_vc_history_value_clear() *
+ *           function.                                                        *
  *                                                                            *
  ******************************************************************************/
-static void	vch_item_get_values_by_time(const zbx_vc_item_t *item, zbx_vector_history_record_t *values, int seconds,
-		const zbx_timespec_t *ts)
+int	zbx_vc_get_value(zbx_uint64_t itemid, unsigned char value_type, const zbx_timespec_t *ts,
+		zbx_history_record_t *value)
 {
-	int		index, now;
-	zbx_timespec_t	start = {ts->sec - seconds, ts->ns};
-	zbx_vc_chunk_t	*chunk;
+	zbx_vector_history_record_t	values;
+	int				ret = FAIL;
 
-	/* Check if maximum request range is not set and all data are cached.  */
-	/* Because that indicates there was a count based request with unknown */
-	/* range which might be greater than the current request range.        */
-	if (0 != item->active_range || ZBX_ITEM_STATUS_CACHED_ALL != item->status)
-	{
-		now = (int)time(NULL);
-		/* add another second to include nanosecond shifts */
-		vc_cache_item_update(item->itemid, ZBX_VC_UPDATE_RANGE, seconds + now - ts->sec + 1, now);
-	}
+	zbx_history_record_vector_create(&values);
 
-	if (FAIL == vch_item_get_last_value(item, ts, &chunk, &index))
-	{
-		/* Cache does not contain records for the specified timeshift & seconds range. */
-		/* Return empty vector with success.                                           */
-		return;
-	}
+	if (SUCCEED != zbx_vc_get_values(itemid, value_type, &values, ts->sec, 1, ts) || 0 == values.values_num)
+		goto out;
 
-	/* fill the values vector with item history values until the start timestamp is reached */
-	while (0 < zbx_timespec_compare(&chunk->slots[chunk->last_value].timestamp, &start))
-	{
-		while (index >= chunk->first_value && 0 < zbx_timespec_compare(&chunk->slots[index].timestamp, &start))
-			vc_history_record_vector_append(values, item->value_type, &chunk->slots[index--]);
+	*value = values.values[0];
 
-		if (NULL == (chunk = chunk->prev))
-			break;
+	/* reset values vector size so the returned value is not cleared when destroying the vector */
+	values.values_num = 0;
+
+	ret = SUCCEED;
+out:
+	zbx_history_record_vector_destroy(&values, value_type);
 
-		index = chunk->last_value;
-	}
+	return ret;
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: retrieves item history data from cache                            *
+ * Purpose: retrieves usage cache statistics                                  *
  *                                                                            *
- * Parameters: item      - [IN] the item                                      *
- *             values    - [OUT] the item history data stored time/value      *
- *                         pairs in undefined order, optional                 *
- *                         If null then cache is updated if necessary, but no *
- *                         values are returned. Used to ensure that cache     *
- *                         contains a value of the specified timestamp.       *
- *             seconds   - [IN] the time period                               *
- *             count     - [IN] the number of history values to retrieve      *
- *             timestamp - [IN] the target timestamp                          *
+ * Parameters: stats     - [OUT] the cache usage statistics                   *
+ *                                                                            *
+ * Return value:  SUCCEED - the cache statistics were retrieved successfully  *
+ *                FAIL    - failed to retrieve cache statistics               *
+ *                          (cache was not initialized)                       *
  *                                                                            *
  ******************************************************************************/
-static void	vch_item_get_values_by_time_and_count(zbx_vc_item_t *item, zbx_vector_history_record_t *values,
-		int seconds, int count, const zbx_timespec_t *ts)
+int	zbx_vc_get_statistics(zbx_vc_stats_t *stats)
 {
-	int		index, now, range_timestamp;
-	zbx_vc_chunk_t	*chunk;
-	zbx_timespec_t	start;
-
-	/* set start timestamp of the requested time period */
-	if (0 != seconds)
-	{
-		start.sec = ts->sec - seconds;
-		start.ns = ts->ns;
-	}
-	else
-	{
-		start.sec = 0;
-		start.ns = 0;
-	}
-
-	if (FAIL == vch_item_get_last_value(item, ts, &chunk, &index))
-	{
-		/* return empty vector with success */
-		goto out;
-	}
-
-	/* fill the values vector with item history values until the <count> values are read    */
-	/* or no more values within specified time period                                       */
-	/* fill the values vector with item history values until the start timestamp is reached */
-	while (0 < zbx_timespec_compare(&chunk->slots[chunk->last_value].timestamp, &start))
-	{
-		while (index >= chunk->first_value && 0 < zbx_timespec_compare(&chunk->slots[index].timestamp, &start))
-		{
-			vc_history_record_vector_append(values, item->value_type, &chunk->slots[index--]);
+	if (ZBX_VC_DISABLED == vc_state)
+		return FAIL;
 
-			if (values->values_num == count)
-				goto out;
-		}
+	RDLOCK_CACHE;
+	vc_mem_lock_shared();
 
-		if (NULL == (chunk = chunk->prev))
-			break;
+	stats->hits = vc_cache->hits;
+	stats->misses = vc_cache->misses;
+	stats->mode = vc_cache->mode;
 
-		index = chunk->last_value;
-	}
-out:
-	if (count > values->values_num)
-	{
-		if (0 == seconds)
-			return;
+	stats->total_size = vc_mem->total_size;
+	stats->free_size = vc_mem->free_size;
 
-		/* not enough data in the requested period, set the range equal to the period plus */
-		/* one second to include nanosecond shifts                                         */
-		range_timestamp = ts->sec - seconds;
-	}
-	else
-	{
-		/* the requested number of values was retrieved, set the range to the oldest value timestamp */
-		range_timestamp = values->values[values->values_num - 1].timestamp.sec - 1;
-	}
+	vc_mem_unlock_shared();
+	UNLOCK_CACHE;
 
-	now = (int)time(NULL);
-	vc_cache_item_update(item->itemid, ZBX_VC_UPDATE_RANGE, now - range_timestamp, now);
+	return SUCCEED;
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: get item values for the specified range                           *
+ * Purpose: enables value caching for current process                         *
  *                                                                            *
- * Parameters: item      - [IN] the item                                      *
- *             values    - [OUT] the item history data stored time/value      *
- *                         pairs in undefined order, optional                 *
- *                         If null then cache is updated if necessary, but no *
- *                         values are returned. Used to ensure that cache     *
- *                         contains a value of the specified timestamp.       *
- *             seconds   - [IN] the time period to retrieve data for          *
- *             count     - [IN] the number of history values to retrieve      *
- *             ts        - [IN] the target timestamp                          *
+ ******************************************************************************/
+void	zbx_vc_enable(void)
+{
+	if (NULL != vc_cache)
+		vc_state = ZBX_VC_ENABLED;
+}
+
+/******************************************************************************
  *                                                                            *
- * Return value:  SUCCEED - the item history data was retrieved successfully  *
- *                FAIL    - the item history data was not retrieved           *
+ * Purpose: disables value caching for current process                        *
  *                                                                            *
- * Comments: This function returns data from cache if necessary updating it   *
- *           from DB. If cache update was required and failed (not enough     *
- *           memory to cache DB values), then this function also fails.       *
+ ******************************************************************************/
+void	zbx_vc_disable(void)
+{
+	vc_state = ZBX_VC_DISABLED;
+}
+
+/******************************************************************************
  *                                                                            *
- *           If <count> is set then value range is defined as <count> values  *
- *           before <timestamp>. Otherwise the range is defined as <seconds>  *
- *           seconds before <timestamp>.                                      *
+ * Purpose: get value cache diagnostic statistics                             *
  *                                                                            *
  ******************************************************************************/
-static int	vch_item_get_values(zbx_vc_item_t *item, zbx_vector_history_record_t *values, int seconds,
-		int count, const zbx_timespec_t *ts)
+void	zbx_vc_get_diag_stats(zbx_uint64_t *items_num, zbx_uint64_t *values_num, int *mode)
 {
-	int	ret, records_read, hits, misses, range_start;
+	zbx_hashset_iter_t	iter;
+	zbx_vc_item_t		*item;
 
-	zbx_vector_history_record_clear(values);
+	*values_num = 0;
 
-	if (0 == count)
+	if (ZBX_VC_DISABLED == vc_state)
 	{
-		if (0 > (range_start = ts->sec - seconds))
-			range_start = 0;
-
-		if (FAIL == (ret = vch_item_cache_values_by_time(&item, range_start)))
-			goto out;
-
-		records_read = ret;
-
-		vch_item_get_values_by_time(item, values, seconds, ts);
-
-		if (records_read > values->values_num)
-			records_read = values->values_num;
+		*items_num = 0;
+		*mode = -1;
+		return;
 	}
-	else
-	{
-		range_start = (0 == seconds ? 0 : ts->sec - seconds);
-
-		if (FAIL == (ret = vch_item_cache_values_by_time_and_count(&item, range_start, count, ts)))
-			goto out;
-
-		records_read = ret;
 
-		vch_item_get_values_by_time_and_count(item, values, seconds, count, ts);
-
-		if (records_read > values->values_num)
-			records_read = values->values_num;
-	}
+	RDLOCK_CACHE;
 
-	hits = values->values_num - records_read;
-	misses = records_read;
+	*items_num = (zbx_uint64_t)vc_cache->items.num_data;
+	*mode = vc_cache->mode;
 
-	vc_cache_item_update(item->itemid, ZBX_VC_UPDATE_STATS, hits, misses);
+	zbx_hashset_iter_reset(&vc_cache->items, &iter);
+	while (NULL != (item = (zbx_vc_item_t *)zbx_hashset_iter_next(&iter)))
+		*values_num += (zbx_uint64_t)item->values_total;
 
-	ret = SUCCEED;
-out:
-	return ret;
+	UNLOCK_CACHE;
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: frees resources allocated for item history data                   *
+ * Purpose: get value cache shared memory statistics                          *
  *                                                                            *
- * Parameters: item    - [IN] the item                                        *
+ ******************************************************************************/
+void	zbx_vc_get_mem_stats(zbx_shmem_stats_t *mem)
+{
+	if (ZBX_VC_DISABLED == vc_state)
+	{
+		memset(mem, 0, sizeof(zbx_shmem_stats_t));
+		return;
+	}
+
+	RDLOCK_CACHE;
+	vc_mem_lock_shared();
+	zbx_shmem_get_stats(vc_mem, mem);
+	vc_mem_unlock_shared();
+	UNLOCK_CACHE;
+}
+
+/******************************************************************************
  *                                                                            *
- * Return value: the size of freed memory (bytes)                             *
+ * Purpose: get statistics of cached items                                    *
  *                                                                            *
  ******************************************************************************/
-static size_t	vch_item_free_cache(zbx_vc_item_t *item)
+void	zbx_vc_get_item_stats(zbx_vector_ptr_t *stats)
 {
-	size_t	freed = 0;
+	zbx_hashset_iter_t	iter;
+	zbx_vc_item_t		*item;
+	zbx_vc_item_stats_t	*item_stats;
 
-	zbx_vc_chunk_t	*chunk = item->tail;
+	if (ZBX_VC_DISABLED == vc_state)
+		return;
 
-	while (NULL != chunk)
-	{
-		zbx_vc_chunk_t	*next = chunk->next;
+	RDLOCK_CACHE;
 
-		freed += vch_item_free_chunk(item, chunk);
-		chunk = next;
+	zbx_vector_ptr_reserve(stats, (size_t)vc_cache->items.num_data);
+
+	zbx_hashset_iter_reset(&vc_cache->items, &iter);
+	while (NULL != (item = (zbx_vc_item_t *)zbx_hashset_iter_next(&iter)))
+	{
+		item_stats = (zbx_vc_item_stats_t *)zbx_malloc(NULL, sizeof(zbx_vc_item_stats_t));
+		item_stats->itemid = item->itemid;
+		item_stats->values_num = item->values_total;
+		item_stats->hourly_num = item->last_hourly_num;
+		zbx_vector_ptr_append(stats, item_stats);
 	}
-	item->values_total = 0;
-	item->head = NULL;
-	item->tail = NULL;
 
-	return freed;
+	UNLOCK_CACHE;
 }
 
-/******************************************************************************************************************
- *                                                                                                                *
- * Public API                                                                                                     *
- *                                                                                                                *
- ******************************************************************************************************************/
-
 /******************************************************************************
  *                                                                            *
- * Purpose: initializes value cache                                           *
+ * Purpose: flush locally cached statistics                                   *
  *                                                                            *
  ******************************************************************************/
-int	zbx_vc_init(zbx_uint64_t value_cache_size, char **error)
+void	zbx_vc_flush_stats(void)
 {
-	zbx_uint64_t	size_reserved;
-	int		ret = FAIL;
+	int		i, now;
+	zbx_vc_item_t	*item = NULL;
+	zbx_uint64_t	itemid = 0;
 
-	if (0 == value_cache_size)
-		return SUCCEED;
+	if (ZBX_VC_DISABLED == vc_state || 0 == vc_itemupdates.values_num)
+		return;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+	zbx_vector_vc_itemupdate_sort(&vc_itemupdates, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 
-	if (SUCCEED != (ret = zbx_rwlock_create(&vc_lock, ZBX_RWLOCK_VALUECACHE, error)))
-		goto out;
+	now = (int)time(NULL);
 
-	size_reserved = zbx_shmem_required_size(1, "value cache size", "ValueCacheSize");
+	RDLOCK_CACHE;
 
-	if (SUCCEED != zbx_shmem_create(&vc_mem, value_cache_size, "value cache size", "ValueCacheSize", 1,
-			error))
+	for (i = 0; i < vc_itemupdates.values_num; i++)
 	{
-		goto out;
-	}
-
-	value_cache_size -= size_reserved;
+		zbx_vc_item_update_t	*update = &vc_itemupdates.values[i];
 
-	vc_cache = (zbx_vc_cache_t *)__vc_shmem_malloc_func(vc_cache, sizeof(zbx_vc_cache_t));
+		if (itemid != update->itemid)
+		{
+			if (0 != itemid)
+				UNLOCK_ITEM(itemid);
 
-	if (NULL == vc_cache)
-	{
-		*error = zbx_strdup(*error, "cannot allocate value cache header");
-		goto out;
-	}
-	memset(vc_cache, 0, sizeof(zbx_vc_cache_t));
+			itemid = update->itemid;
+			LOCK_ITEM(itemid);
+			item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid);
+		}
 
-	zbx_hashset_create_ext(&vc_cache->items, VC_ITEMS_INIT_SIZE,
-			ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC, NULL,
-			__vc_shmem_malloc_func, __vc_shmem_realloc_func, __vc_shmem_free_func);
+		if (NULL == item)
+			continue;
 
-	if (NULL == vc_cache->items.slots)
-	{
-		*error = zbx_strdup(*error, "cannot allocate value cache data storage");
-		goto out;
+		switch (update->type)
+		{
+			case ZBX_VC_UPDATE_RANGE:
+				vch_item_update_range(item, update->data[ZBX_VC_UPDATE_RANGE_SECONDS],
+						update->data[ZBX_VC_UPDATE_RANGE_NOW]);
+				break;
+			case ZBX_VC_UPDATE_STATS:
+				vc_update_statistics(item, update->data[ZBX_VC_UPDATE_STATS_HITS],
+						update->data[ZBX_VC_UPDATE_STATS_MISSES], now);
+				break;
+		}
 	}
 
-	zbx_hashset_create_ext(&vc_cache->strpool, VC_STRPOOL_INIT_SIZE,
-			vc_strpool_hash_func, vc_strpool_compare_func, NULL,
-			__vc_shmem_malloc_func, __vc_shmem_realloc_func, __vc_shmem_free_func);
+	if (0 != itemid)
+		UNLOCK_ITEM(itemid);
 
-	if (NULL == vc_cache->strpool.slots)
-	{
-		*error = zbx_strdup(*error, "cannot allocate string pool for value cache data storage");
-		goto out;
-	}
+	UNLOCK_CACHE;
 
-	/* the free space request should be 5% of cache size, but no more than 128KB */
-	vc_cache->min_free_request = (value_cache_size / 100) * 5;
-	if (vc_cache->min_free_request > 128 * ZBX_KIBIBYTE)
-		vc_cache->min_free_request = 128 * ZBX_KIBIBYTE;
+	zbx_vector_vc_itemupdate_clear(&vc_itemupdates);
+}
 
-	zbx_vector_vc_itemupdate_create(&vc_itemupdates);
-	zbx_vector_vc_itemupdate_reserve(&vc_itemupdates, 256);
+/* value cache snapshot file format */
+#define ZBX_VC_SNAPSHOT_MAGIC		"ZBXVCSN"
+#define ZBX_VC_SNAPSHOT_VERSION		1
 
-	ret = SUCCEED;
-out:
-	zbx_vc_disable();
+/* the null string marker in snapshot file */
+#define ZBX_VC_SNAPSHOT_NULL_STR	0xffffffff
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+/* the maximum length of string value accepted from snapshot file */
+#define ZBX_VC_SNAPSHOT_MAX_STR		(16 * ZBX_MEBIBYTE)
 
-	return ret;
+/* the number of snapshot items of the same value type loaded together */
+#define ZBX_VC_SNAPSHOT_BATCH_SIZE	100
+
+/* the snapshot file header */
+typedef struct
+{
+	char		magic[8];
+	int		version;
+	int		item_size;
+	int		timestamp;
+}
+zbx_vc_snapshot_header_t;
+
+/* the snapshot item record, followed by item values from tail to head */
+typedef struct
+{
+	zbx_uint64_t	itemid;
+	zbx_uint64_t	hits;
+	int		values_num;
+	int		last_accessed;
+	int		active_range;
+	int		daily_range;
+	int		db_cached_from;
+	unsigned char	value_type;
+	unsigned char	status;
+	unsigned char	range_sync_hour;
 }
+zbx_vc_snapshot_item_t;
+
+/* the snapshot items waiting for values stored in database after snapshot was taken */
+typedef struct
+{
+	zbx_vc_snapshot_item_t		items[ZBX_VC_SNAPSHOT_BATCH_SIZE];
+	zbx_vector_history_record_t	values[ZBX_VC_SNAPSHOT_BATCH_SIZE];
+	zbx_history_query_t		queries[ZBX_VC_SNAPSHOT_BATCH_SIZE];
+	int				items_num;
+}
+zbx_vc_snapshot_batch_t;
 
 /******************************************************************************
  *                                                                            *
- * Purpose: destroys value cache                                              *
+ * Purpose: writes data block to snapshot file                                *
  *                                                                            *
  ******************************************************************************/
-void	zbx_vc_destroy(void)
+static int	vc_snapshot_write(FILE *fp, const void *data, size_t size)
 {
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
-
-	if (NULL != vc_cache)
-	{
-		zbx_vector_vc_itemupdate_destroy(&vc_itemupdates);
-
-		zbx_hashset_destroy(&vc_cache->items);
-		zbx_hashset_destroy(&vc_cache->strpool);
-
-		__vc_shmem_free_func(vc_cache);
-		vc_cache = NULL;
-
-		zbx_shmem_destroy(vc_mem);
-		vc_mem = NULL;
-		zbx_rwlock_destroy(&vc_lock);
-	}
-
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+	return 1 == fwrite(data, size, 1, fp) ? SUCCEED : FAIL;
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: resets value cache                                                *
+ * Purpose: reads data block from snapshot file                               *
  *                                                                            *
- * Comments: All items and their historical data are removed,                 *
- *           cache working mode, statistics reset.                            *
+ ******************************************************************************/
+static int	vc_snapshot_read(FILE *fp, void *data, size_t size)
+{
+	return 1 == fread(data, size, 1, fp) ? SUCCEED : FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: writes length prefixed string to snapshot file                    *
  *                                                                            *
  ******************************************************************************/
-void	zbx_vc_reset(void)
+static int	vc_snapshot_write_str(FILE *fp, const char *str)
 {
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+	zbx_uint32_t	len;
 
-	if (NULL != vc_cache)
+	if (NULL == str)
 	{
-		zbx_vc_item_t		*item;
-		zbx_hashset_iter_t	iter;
-
-		WRLOCK_CACHE;
-
-		zbx_hashset_iter_reset(&vc_cache->items, &iter);
-		while (NULL != (item = (zbx_vc_item_t *)zbx_hashset_iter_next(&iter)))
-		{
-			vch_item_free_cache(item);
-			zbx_hashset_iter_remove(&iter);
-		}
+		len = ZBX_VC_SNAPSHOT_NULL_STR;
+		return vc_snapshot_write(fp, &len, sizeof(len));
+	}
 
-		vc_cache->hits = 0;
-		vc_cache->misses = 0;
-		vc_cache->min_free_request = 0;
-		vc_cache->mode = ZBX_VC_MODE_NORMAL;
-		vc_cache->mode_time = 0;
-		vc_cache->last_warning_time = 0;
+	len = (zbx_uint32_t)strlen(str);
 
-		UNLOCK_CACHE;
-	}
+	if (SUCCEED != vc_snapshot_write(fp, &len, sizeof(len)))
+		return FAIL;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+	return 0 == len ? SUCCEED : vc_snapshot_write(fp, str, len);
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: adds item values to the history and value cache                   *
- *                                                                            *
- * Parameters: history - [IN] item history values                             *
- *                                                                            *
- * Return value: SUCCEED - the values were added successfully                 *
- *               FAIL    - otherwise                                          *
+ * Purpose: reads length prefixed string from snapshot file                   *
  *                                                                            *
  ******************************************************************************/
-int	zbx_vc_add_values(zbx_vector_ptr_t *history, int *ret_flush)
+static int	vc_snapshot_read_str(FILE *fp, char **str)
 {
-	zbx_vc_item_t		*item;
-	int			i;
-	zbx_dc_history_t	*h;
+	zbx_uint32_t	len;
 
-	if (SUCCEED != zbx_history_add_values(history, ret_flush))
+	*str = NULL;
+
+	if (SUCCEED != vc_snapshot_read(fp, &len, sizeof(len)))
 		return FAIL;
 
-	if (ZBX_VC_DISABLED == vc_state)
+	if (ZBX_VC_SNAPSHOT_NULL_STR == len)
 		return SUCCEED;
 
-	WRLOCK_CACHE;
-
-	for (i = 0; i < history->values_num; i++)
-	{
-		h = (zbx_dc_history_t *)history->values[i];
-
-		if (NULL != (item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &h->itemid)))
-		{
-			zbx_history_record_t	record = {h->ts, h->value};
-			zbx_vc_chunk_t		*head = item->head;
-			int			last_value_timestamp;
-
-			if (NULL != head)
-				last_value_timestamp = head->slots[head->last_value].timestamp.sec;
-			else
-				last_value_timestamp = (int)time(NULL);
-
-			/* If the new value type does not match the item's type in cache remove it, */
-			/* so it's cached with the correct type from correct tables when accessed   */
-			/* next time.                                                               */
-			/* Also remove item if the value adding failed. In this case we             */
-			/* won't have the latest data in cache - so the requests must go directly   */
-			/* to the database.                                                         */
-			if (item->value_type != h->value_type || FAIL == vch_item_add_value_at_head(item, &record))
-			{
-				vc_remove_item(item);
-				continue;
-			}
-
-			/* try to remove old (unused) chunks if a new chunk was added */
-			if (head != item->head)
-				vch_item_clean_cache(item, last_value_timestamp);
-		}
-	}
+	if (ZBX_VC_SNAPSHOT_MAX_STR < len)
+		return FAIL;
 
-	UNLOCK_CACHE;
+	*str = (char *)zbx_malloc(NULL, len + 1);
+	(*str)[len] = '\0';
 
-	return SUCCEED;
+	return 0 == len ? SUCCEED : vc_snapshot_read(fp, *str, len);
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: get item history data for the specified time period               *
- *                                                                            *
- * Parameters: itemid     - [IN] the item id                                  *
- *             value_type - [IN] the item value type                          *
- *             values     - [OUT] the item history data stored time/value     *
- *                          pairs in descending order                         *
- *             seconds    - [IN] the time period to retrieve data for         *
- *             count      - [IN] the number of history values to retrieve     *
- *             ts         - [IN] the period end timestamp                     *
- *                                                                            *
- * Return value:  SUCCEED - the item history data was retrieved successfully  *
- *                FAIL    - the item history data was not retrieved           *
+ * Purpose: writes history value to snapshot file                             *
  *                                                                            *
- * Comments: If the data is not in cache, it's read from DB, so this function *
- *           will always return the requested data, unless some error occurs. *
+ * Parameters: fp         - [IN] the snapshot file                            *
+ *             value_type - [IN] the value type (see ITEM_VALUE_TYPE_* defs)  *
+ *             record     - [IN] the history value                            *
  *                                                                            *
- *           If <count> is set then value range is defined as <count> values  *
- *           before <timestamp>. Otherwise the range is defined as <seconds>  *
- *           seconds before <timestamp>.                                      *
+ * Return value: SUCCEED - the value was written successfully                 *
+ *               FAIL    - otherwise                                          *
  *                                                                            *
  ******************************************************************************/
-int	zbx_vc_get_values(zbx_uint64_t itemid, unsigned char value_type, zbx_vector_history_record_t *values,
-		int seconds, int count, const zbx_timespec_t *ts)
+static int	vc_snapshot_write_value(FILE *fp, unsigned char value_type, const zbx_history_record_t *record)
 {
-	zbx_vc_item_t	*item, new_item;
-	int 		ret = FAIL, cache_used = 1;
-
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() itemid:" ZBX_FS_UI64 " value_type:%d count:%d period:%d end_timestamp"
-			" '%s'", __func__, itemid, value_type, count, seconds, zbx_timespec_str(ts));
-
-	RDLOCK_CACHE;
-
-	if (ZBX_VC_DISABLED == vc_state)
-		goto out;
-
-	if (ZBX_VC_MODE_LOWMEM == vc_cache->mode)
-		vc_warn_low_memory();
+	const zbx_log_value_t	*log;
 
-	if (NULL == (item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid)))
+	if (SUCCEED != vc_snapshot_write(fp, &record->timestamp.sec, sizeof(record->timestamp.sec)) ||
+			SUCCEED != vc_snapshot_write(fp, &record->timestamp.ns, sizeof(record->timestamp.ns)))
 	{
-		if (ZBX_VC_MODE_NORMAL != vc_cache->mode)
-			goto out;
-
-		memset(&new_item, 0, sizeof(new_item));
-		new_item.itemid = itemid;
-		new_item.value_type = value_type;
-		item = &new_item;
+		return FAIL;
 	}
-	else if (item->value_type != value_type)
-		goto out;
 
-	ret = vch_item_get_values(item, values, seconds, count, ts);
-out:
-	if (FAIL == ret)
+	switch (value_type)
 	{
-		cache_used = 0;
-
-		UNLOCK_CACHE;
-		ret = vc_db_get_values(itemid, value_type, values, seconds, count, ts);
-		WRLOCK_CACHE;
+		case ITEM_VALUE_TYPE_FLOAT:
+			return vc_snapshot_write(fp, &record->value.dbl, sizeof(record->value.dbl));
+		case ITEM_VALUE_TYPE_UINT64:
+			return vc_snapshot_write(fp, &record->value.ui64, sizeof(record->value.ui64));
+		case ITEM_VALUE_TYPE_STR:
+		case ITEM_VALUE_TYPE_TEXT:
+		case ITEM_VALUE_TYPE_BIN:
+			return vc_snapshot_write_str(fp, record->value.str);
+		case ITEM_VALUE_TYPE_LOG:
+			log = record->value.log;
 
-		if (ZBX_VC_DISABLED != vc_state)
-			vc_remove_item_by_id(itemid);
+			if (SUCCEED != vc_snapshot_write(fp, &log->timestamp, sizeof(log->timestamp)) ||
+					SUCCEED != vc_snapshot_write(fp, &log->logeventid, sizeof(log->logeventid)) ||
+					SUCCEED != vc_snapshot_write(fp, &log->severity, sizeof(log->severity)) ||
+					SUCCEED != vc_snapshot_write_str(fp, log->source))
+			{
+				return FAIL;
+			}
 
-		if (SUCCEED == ret)
-			vc_update_statistics(NULL, 0, values->values_num, (int)time(NULL));
+			return vc_snapshot_write_str(fp, log->value);
+		default:
+			THIS_SHOULD_NEVER_HAPPEN;
+			return FAIL;
 	}
-
-	UNLOCK_CACHE;
-
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s count:%d cached:%d",
-			__func__, zbx_result_string(ret), values->values_num, cache_used);
-
-	return ret;
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: get the last history value with a timestamp less or equal to the  *
- *          target timestamp                                                  *
+ * Purpose: reads history value from snapshot file                            *
  *                                                                            *
- * Parameters: itemid     - [IN] the item id                                  *
- *             value_type - [IN] the item value type                          *
- *             ts         - [IN] the target timestamp                         *
- *             value      - [OUT] the value found                             *
+ * Parameters: fp         - [IN] the snapshot file                            *
+ *             value_type - [IN] the value type (see ITEM_VALUE_TYPE_* defs)  *
+ *             record     - [OUT] the history value                           *
  *                                                                            *
- * Return Value: SUCCEED - the item was retrieved                             *
+ * Return value: SUCCEED - the value was read successfully                    *
  *               FAIL    - otherwise                                          *
  *                                                                            *
- * Comments: Depending on the value type this function might allocate memory  *
- *           to store value data. To free it use zbx_vc_history_value_clear() *
- *           function.                                                        *
+ * Comments: String, text and log values are allocated on heap and must be    *
+ *           freed by the caller also when this function fails.               *
  *                                                                            *
  ******************************************************************************/
-int	zbx_vc_get_value(zbx_uint64_t itemid, unsigned char value_type, const zbx_timespec_t *ts,
-		zbx_history_record_t *value)
+static int	vc_snapshot_read_value(FILE *fp, unsigned char value_type, zbx_history_record_t *record)
 {
-	zbx_vector_history_record_t	values;
-	int				ret = FAIL;
+	zbx_log_value_t	*log;
 
-	zbx_history_record_vector_create(&values);
+	memset(record, 0, sizeof(zbx_history_record_t));
 
-	if (SUCCEED != zbx_vc_get_values(itemid, value_type, &values, ts->sec, 1, ts) || 0 == values.values_num)
-		goto out;
+	if (SUCCEED != vc_snapshot_read(fp, &record->timestamp.sec, sizeof(record->timestamp.sec)) ||
+			SUCCEED != vc_snapshot_read(fp, &record->timestamp.ns, sizeof(record->timestamp.ns)))
+	{
+		return FAIL;
+	}
 
-	*value = values.values[0];
+	switch (value_type)
+	{
+		case ITEM_VALUE_TYPE_FLOAT:
+			return vc_snapshot_read(fp, &record->value.dbl, sizeof(record->value.dbl));
+		case ITEM_VALUE_TYPE_UINT64:
+			return vc_snapshot_read(fp, &record->value.ui64, sizeof(record->value.ui64));
+		case ITEM_VALUE_TYPE_STR:
+		case ITEM_VALUE_TYPE_TEXT:
+		case ITEM_VALUE_TYPE_BIN:
+			if (SUCCEED != vc_snapshot_read_str(fp, &record->value.str))
+				return FAIL;
 
-	/* reset values vector size so the returned value is not cleared when destroying the vector */
-	values.values_num = 0;
+			/* string values cannot be null */
+			if (NULL == record->value.str)
+				return FAIL;
 
-	ret = SUCCEED;
-out:
-	zbx_history_record_vector_destroy(&values, value_type);
+			return SUCCEED;
+		case ITEM_VALUE_TYPE_LOG:
+			log = record->value.log = (zbx_log_value_t *)zbx_malloc(NULL, sizeof(zbx_log_value_t));
+			memset(log, 0, sizeof(zbx_log_value_t));
+
+			if (SUCCEED != vc_snapshot_read(fp, &log->timestamp, sizeof(log->timestamp)) ||
+					SUCCEED != vc_snapshot_read(fp, &log->logeventid, sizeof(log->logeventid)) ||
+					SUCCEED != vc_snapshot_read(fp, &log->severity, sizeof(log->severity)) ||
+					SUCCEED != vc_snapshot_read_str(fp, &log->source) ||
+					SUCCEED != vc_snapshot_read_str(fp, &log->value) || NULL == log->value)
+			{
+				return FAIL;
+			}
 
-	return ret;
+			return SUCCEED;
+		default:
+			return FAIL;
+	}
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: retrieves usage cache statistics                                  *
+ * Purpose: writes cached item and its values to snapshot file                *
  *                                                                            *
- * Parameters: stats     - [OUT] the cache usage statistics                   *
+ * Parameters: fp   - [IN] the snapshot file                                  *
+ *             item - [IN] the item                                           *
  *                                                                            *
- * Return value:  SUCCEED - the cache statistics were retrieved successfully  *
- *                FAIL    - failed to retrieve cache statistics               *
- *                          (cache was not initialized)                       *
+ * Return value: SUCCEED - the item was written successfully                  *
+ *               FAIL    - otherwise                                          *
  *                                                                            *
  ******************************************************************************/
-int	zbx_vc_get_statistics(zbx_vc_stats_t *stats)
+static int	vc_snapshot_write_item(FILE *fp, const zbx_vc_item_t *item)
 {
-	if (ZBX_VC_DISABLED == vc_state)
-		return FAIL;
+	zbx_vc_snapshot_item_t	snapshot;
+	const zbx_vc_chunk_t	*chunk;
+	int			i;
 
-	RDLOCK_CACHE;
+	memset(&snapshot, 0, sizeof(snapshot));
 
-	stats->hits = vc_cache->hits;
-	stats->misses = vc_cache->misses;
-	stats->mode = vc_cache->mode;
+	snapshot.itemid = item->itemid;
+	snapshot.hits = item->hits;
+	snapshot.last_accessed = item->last_accessed;
+	snapshot.active_range = item->active_range;
+	snapshot.daily_range = item->daily_range;
+	snapshot.db_cached_from = item->db_cached_from;
+	snapshot.value_type = item->value_type;
+	snapshot.status = item->status;
+	snapshot.range_sync_hour = item->range_sync_hour;
 
-	stats->total_size = vc_mem->total_size;
-	stats->free_size = vc_mem->free_size;
+	for (chunk = item->tail; NULL != chunk; chunk = chunk->next)
+		snapshot.values_num += chunk->last_value - chunk->first_value + 1;
 
-	UNLOCK_CACHE;
+	if (SUCCEED != vc_snapshot_write(fp, &snapshot, sizeof(snapshot)))
+		return FAIL;
+
+	for (chunk = item->tail; NULL != chunk; chunk = chunk->next)
+	{
+		const zbx_history_record_t	*slots = vch_chunk_slots(chunk);
+
+		for (i = chunk->first_value; i <= chunk->last_value; i++)
+		{
+			if (SUCCEED != vc_snapshot_write_value(fp, item->value_type, &slots[i]))
+				return FAIL;
+		}
+	}
 
 	return SUCCEED;
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: enables value caching for current process                         *
+ * Purpose: saves value cache contents into snapshot file                     *
  *                                                                            *
- ******************************************************************************/
-void	zbx_vc_enable(void)
-{
-	if (NULL != vc_cache)
-		vc_state = ZBX_VC_ENABLED;
-}
-
-/******************************************************************************
+ * Parameters: path  - [IN] the snapshot file path                            *
+ *             error - [OUT] the error message                                *
  *                                                                            *
- * Purpose: disables value caching for current process                        *
+ * Return value: SUCCEED - the snapshot was saved successfully                *
+ *               FAIL    - otherwise                                          *
  *                                                                            *
- ******************************************************************************/
-void	zbx_vc_disable(void)
-{
-	vc_state = ZBX_VC_DISABLED;
-}
-
-/******************************************************************************
+ * Comments: The snapshot is written into temporary file which replaces the   *
+ *           snapshot file after all items have been written. Items are       *
+ *           locked one by one, so the cache can be used while it's being     *
+ *           saved.                                                           *
  *                                                                            *
- * Purpose: get value cache diagnostic statistics                             *
+ *           The snapshot is stored in host byte order and is meant to be     *
+ *           loaded by the same server installation.                          *
  *                                                                            *
  ******************************************************************************/
-void	zbx_vc_get_diag_stats(zbx_uint64_t *items_num, zbx_uint64_t *values_num, int *mode)
+int	zbx_vc_snapshot_save(const char *path, char **error)
 {
-	zbx_hashset_iter_t	iter;
-	zbx_vc_item_t		*item;
+	zbx_vector_uint64_t		itemids;
+	zbx_hashset_iter_t		iter;
+	zbx_vc_item_t			*item;
+	zbx_vc_snapshot_header_t	header;
+	zbx_vc_snapshot_item_t		terminator;
+	FILE				*fp;
+	char				*path_tmp;
+	int				i, ret = FAIL, items_num = 0;
+	double				time_start;
 
-	*values_num = 0;
+	if (NULL == vc_cache)
+		return SUCCEED;
 
-	if (ZBX_VC_DISABLED == vc_state)
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() path:'%s'", __func__, path);
+
+	time_start = zbx_time();
+	path_tmp = zbx_dsprintf(NULL, "%s.tmp", path);
+	zbx_vector_uint64_create(&itemids);
+
+	if (NULL == (fp = fopen(path_tmp, "wb")))
 	{
-		*items_num = 0;
-		*mode = -1;
-		return;
+		*error = zbx_dsprintf(*error, "cannot open file \"%s\": %s", path_tmp, zbx_strerror(errno));
+		goto out;
 	}
 
-	RDLOCK_CACHE;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, ZBX_VC_SNAPSHOT_MAGIC, sizeof(ZBX_VC_SNAPSHOT_MAGIC));
+	header.version = ZBX_VC_SNAPSHOT_VERSION;
+	header.item_size = (int)sizeof(zbx_vc_snapshot_item_t);
+	header.timestamp = (int)time(NULL);
 
-	*items_num = (zbx_uint64_t)vc_cache->items.num_data;
-	*mode = vc_cache->mode;
+	if (SUCCEED != vc_snapshot_write(fp, &header, sizeof(header)))
+		goto write_error;
+
+	RDLOCK_CACHE;
 
+	zbx_vector_uint64_reserve(&itemids, (size_t)vc_cache->items.num_data);
 	zbx_hashset_iter_reset(&vc_cache->items, &iter);
+
 	while (NULL != (item = (zbx_vc_item_t *)zbx_hashset_iter_next(&iter)))
-		*values_num += (zbx_uint64_t)item->values_total;
+		zbx_vector_uint64_append(&itemids, item->itemid);
 
 	UNLOCK_CACHE;
+
+	for (i = 0; i < itemids.values_num; i++)
+	{
+		int	write_ret = SUCCEED;
+
+		RDLOCK_CACHE;
+		LOCK_ITEM(itemids.values[i]);
+
+		if (NULL != (item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemids.values[i])) &&
+				NULL != item->head)
+		{
+			if (SUCCEED == (write_ret = vc_snapshot_write_item(fp, item)))
+				items_num++;
+		}
+
+		UNLOCK_ITEM(itemids.values[i]);
+		UNLOCK_CACHE;
+
+		if (SUCCEED != write_ret)
+			goto write_error;
+	}
+
+	/* the item with zero identifier marks the end of snapshot */
+	memset(&terminator, 0, sizeof(terminator));
+
+	if (SUCCEED != vc_snapshot_write(fp, &terminator, sizeof(terminator)))
+		goto write_error;
+
+	if (0 != fclose(fp))
+	{
+		fp = NULL;
+		goto write_error;
+	}
+
+	fp = NULL;
+
+	if (0 != rename(path_tmp, path))
+	{
+		*error = zbx_dsprintf(*error, "cannot rename file \"%s\" to \"%s\": %s", path_tmp, path,
+				zbx_strerror(errno));
+		goto out;
+	}
+
+	zabbix_log(LOG_LEVEL_INFORMATION, "saved %d items to value cache snapshot in " ZBX_FS_DBL " sec",
+			items_num, zbx_time() - time_start);
+
+	ret = SUCCEED;
+	goto out;
+write_error:
+	*error = zbx_dsprintf(*error, "cannot write file \"%s\": %s", path_tmp, zbx_strerror(errno));
+out:
+	if (NULL != fp)
+		fclose(fp);
+
+	if (SUCCEED != ret)
+		(void)unlink(path_tmp);
+
+	zbx_vector_uint64_destroy(&itemids);
+	zbx_free(path_tmp);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: get value cache shared memory statistics                          *
+ * Purpose: adds item loaded from snapshot file to cache, adding the values   *
+ *          stored in database after the snapshot was taken                   *
+ *                                                                            *
+ * Parameters: snapshot - [IN] the snapshot item                              *
+ *             values   - [IN] the snapshot item values sorted by timestamp   *
+ *                             in ascending order                             *
+ *             records  - [IN] the item values read from database starting    *
+ *                             with the last snapshot value timestamp         *
+ *                                                                            *
+ * Return value: SUCCEED - the item was added to cache                        *
+ *               FAIL    - the item was not added to cache, because its       *
+ *                         last cached value was not found in database or     *
+ *                         there was not enough space in cache                *
+ *                                                                            *
+ * Comments: The snapshot values are trusted only if the last value is still  *
+ *           found in database, otherwise the history might have been changed *
+ *           while server was not running.                                    *
  *                                                                            *
  ******************************************************************************/
-void	zbx_vc_get_mem_stats(zbx_shmem_stats_t *mem)
+static int	vc_snapshot_load_item(const zbx_vc_snapshot_item_t *snapshot, zbx_vector_history_record_t *values,
+		zbx_vector_history_record_t *records)
 {
-	if (ZBX_VC_DISABLED == vc_state)
+	const zbx_history_record_t	*last = &values->values[values->values_num - 1];
+	zbx_vc_item_t			*item, new_item;
+	int				i, ret = FAIL;
+
+	zbx_vector_history_record_sort(records, (zbx_compare_func_t)zbx_history_record_compare_asc_func);
+
+	for (i = 0; i < records->values_num; i++)
 	{
-		memset(mem, 0, sizeof(zbx_shmem_stats_t));
-		return;
+		if (0 == zbx_timespec_compare(&records->values[i].timestamp, &last->timestamp))
+			break;
 	}
 
-	RDLOCK_CACHE;
-	zbx_shmem_get_stats(vc_mem, mem);
+	if (i == records->values_num)
+		return FAIL;
+
+	WRLOCK_CACHE;
+
+	memset(&new_item, 0, sizeof(new_item));
+	new_item.itemid = snapshot->itemid;
+	new_item.value_type = snapshot->value_type;
+	new_item.revision = ++vc_cache->item_revision;
+
+	if (NULL == (item = (zbx_vc_item_t *)zbx_hashset_insert(&vc_cache->items, &new_item, sizeof(new_item))))
+		goto unlock;
+
+	if (SUCCEED != vch_item_add_values_at_tail(item, values->values, values->values_num))
+		goto remove;
+
+	for (i++; i < records->values_num; i++)
+	{
+		if (SUCCEED != vch_item_add_value_at_head(item, &records->values[i]))
+			goto remove;
+	}
+
+	item->hits = snapshot->hits;
+	item->last_accessed = snapshot->last_accessed;
+	item->active_range = snapshot->active_range;
+	item->daily_range = snapshot->daily_range;
+	item->db_cached_from = snapshot->db_cached_from;
+	item->status = snapshot->status;
+	item->range_sync_hour = snapshot->range_sync_hour;
+
+	ret = SUCCEED;
+remove:
+	if (SUCCEED != ret)
+		vc_remove_item_by_id(snapshot->itemid);
+unlock:
 	UNLOCK_CACHE;
+
+	return ret;
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: get statistics of cached items                                    *
+ * Purpose: adds batch of items loaded from snapshot file to cache            *
+ *                                                                            *
+ * Parameters: batch         - [IN/OUT] the snapshot items of one value type  *
+ *             value_type    - [IN] the value type of batch items             *
+ *             items_loaded  - [IN/OUT] the number of items added to cache    *
+ *             items_dropped - [IN/OUT] the number of dropped items           *
+ *                                                                            *
+ * Return value: SUCCEED - the batch was processed                            *
+ *               FAIL    - the cache is filled, loading must be stopped       *
+ *                                                                            *
+ * Comments: The values stored in database after the snapshot was taken are   *
+ *           read for all batch items with a single history storage request.  *
  *                                                                            *
  ******************************************************************************/
-void	zbx_vc_get_item_stats(zbx_vector_ptr_t *stats)
+static int	vc_snapshot_load_batch(zbx_vc_snapshot_batch_t *batch, unsigned char value_type, int *items_loaded,
+		int *items_dropped)
 {
-	zbx_hashset_iter_t	iter;
-	zbx_vc_item_t		*item;
-	zbx_vc_item_stats_t	*item_stats;
+#define ZBX_VC_SNAPSHOT_FILL	90
+	int	i, ret = SUCCEED;
 
-	if (ZBX_VC_DISABLED == vc_state)
-		return;
+	if (0 == batch->items_num)
+		return SUCCEED;
 
-	RDLOCK_CACHE;
+	for (i = 0; i < batch->items_num; i++)
+	{
+		zbx_vector_history_record_t	*values = &batch->values[i];
 
-	zbx_vector_ptr_reserve(stats, (size_t)vc_cache->items.num_data);
+		batch->queries[i].itemid = batch->items[i].itemid;
+		/* decrement interval start point because interval starting point is excluded by history backend */
+		batch->queries[i].start = values->values[values->values_num - 1].timestamp.sec - 1;
+		batch->queries[i].end = ZBX_JAN_2038;
+	}
 
-	zbx_hashset_iter_reset(&vc_cache->items, &iter);
-	while (NULL != (item = (zbx_vc_item_t *)zbx_hashset_iter_next(&iter)))
+	zbx_history_get_values_batch(batch->queries, batch->items_num, value_type);
+
+	for (i = 0; i < batch->items_num; i++)
 	{
-		item_stats = (zbx_vc_item_stats_t *)zbx_malloc(NULL, sizeof(zbx_vc_item_stats_t));
-		item_stats->itemid = item->itemid;
-		item_stats->values_num = item->values_total;
-		item_stats->hourly_num = item->last_hourly_num;
-		zbx_vector_ptr_append(stats, item_stats);
+		if (SUCCEED == ret && (100 - ZBX_VC_SNAPSHOT_FILL) * vc_mem->total_size > vc_mem->free_size * 100)
+			ret = FAIL;
+
+		if (SUCCEED == ret)
+		{
+			if (SUCCEED == batch->queries[i].ret && SUCCEED == vc_snapshot_load_item(&batch->items[i],
+					&batch->values[i], &batch->queries[i].values))
+			{
+				(*items_loaded)++;
+			}
+			else
+				(*items_dropped)++;
+		}
+
+		zbx_history_record_vector_clean(&batch->values[i], value_type);
+		zbx_history_record_vector_clean(&batch->queries[i].values, value_type);
 	}
 
-	UNLOCK_CACHE;
+	batch->items_num = 0;
+
+	return ret;
+#undef ZBX_VC_SNAPSHOT_FILL
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: flush locally cached statistics                                   *
+ * Purpose: loads value cache contents from snapshot file                     *
+ *                                                                            *
+ * Parameters: path  - [IN] the snapshot file path                            *
+ *             error - [OUT] the error message                                *
+ *                                                                            *
+ * Return value: SUCCEED - the snapshot was loaded or there was no snapshot   *
+ *                         to load                                            *
+ *               FAIL    - the snapshot file could not be read                *
+ *                                                                            *
+ * Comments: This function must be called after value cache initialization    *
+ *           and before starting processes using the cache. Database          *
+ *           connection is required to read the values added after snapshot   *
+ *           was taken.                                                       *
+ *                                                                            *
+ *           Loading stops when cache is filled up to ZBX_VC_SNAPSHOT_FILL    *
+ *           percentage, leaving free space for the normal operations.        *
+ *           Snapshots older than item expiration period are ignored.         *
  *                                                                            *
  ******************************************************************************/
-void	zbx_vc_flush_stats(void)
+int	zbx_vc_snapshot_load(const char *path, char **error)
 {
-	int		i, now;
-	zbx_vc_item_t	*item = NULL;
-	zbx_uint64_t	itemid = 0;
+	zbx_vc_snapshot_header_t	header;
+	zbx_vc_snapshot_item_t		snapshot;
+	zbx_vc_snapshot_batch_t		*batches, *batch;
+	FILE				*fp;
+	int				i, j, ret = FAIL, items_loaded = 0, items_dropped = 0, now, full = 0;
+	double				time_start;
 
-	if (ZBX_VC_DISABLED == vc_state || 0 == vc_itemupdates.values_num)
-		return;
+	if (NULL == vc_cache)
+		return SUCCEED;
 
-	zbx_vector_vc_itemupdate_sort(&vc_itemupdates, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() path:'%s'", __func__, path);
+
+	time_start = zbx_time();
+
+	batches = (zbx_vc_snapshot_batch_t *)zbx_malloc(NULL, sizeof(zbx_vc_snapshot_batch_t) *
+			(ITEM_VALUE_TYPE_BIN + 1));
+
+	for (i = 0; i <= ITEM_VALUE_TYPE_BIN; i++)
+	{
+		batches[i].items_num = 0;
+
+		for (j = 0; j < ZBX_VC_SNAPSHOT_BATCH_SIZE; j++)
+		{
+			zbx_history_record_vector_create(&batches[i].values[j]);
+			zbx_history_record_vector_create(&batches[i].queries[j].values);
+		}
+	}
+
+	if (NULL == (fp = fopen(path, "rb")))
+	{
+		if (ENOENT == errno)
+		{
+			ret = SUCCEED;
+			goto out;
+		}
+
+		*error = zbx_dsprintf(*error, "cannot open file \"%s\": %s", path, zbx_strerror(errno));
+		goto out;
+	}
+
+	if (SUCCEED != vc_snapshot_read(fp, &header, sizeof(header)) ||
+			0 != memcmp(header.magic, ZBX_VC_SNAPSHOT_MAGIC, sizeof(ZBX_VC_SNAPSHOT_MAGIC)) ||
+			ZBX_VC_SNAPSHOT_VERSION != header.version ||
+			(int)sizeof(zbx_vc_snapshot_item_t) != header.item_size)
+	{
+		*error = zbx_dsprintf(*error, "file \"%s\" is not a compatible value cache snapshot", path);
+		goto out;
+	}
 
 	now = (int)time(NULL);
 
-	WRLOCK_CACHE;
+	if (header.timestamp + ZBX_VC_ITEM_EXPIRE_PERIOD < now)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "value cache snapshot \"%s\" is outdated, ignoring", path);
+		ret = SUCCEED;
+		goto out;
+	}
 
-	for (i = 0; i < vc_itemupdates.values_num; i++)
+	for (;;)
 	{
-		zbx_vc_item_update_t	*update = &vc_itemupdates.values[i];
+		if (SUCCEED != vc_snapshot_read(fp, &snapshot, sizeof(snapshot)))
+			break;
 
-		if (itemid != update->itemid)
+		if (0 == snapshot.itemid)
 		{
-			itemid = update->itemid;
-			item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid);
+			ret = SUCCEED;
+			break;
 		}
 
-		if (NULL == item)
-			continue;
+		if (ITEM_VALUE_TYPE_BIN < snapshot.value_type || 0 >= snapshot.values_num)
+			break;
 
-		switch (update->type)
+		batch = &batches[snapshot.value_type];
+
+		for (i = 0; i < snapshot.values_num; i++)
 		{
-			case ZBX_VC_UPDATE_RANGE:
-				vch_item_update_range(item, update->data[ZBX_VC_UPDATE_RANGE_SECONDS],
-						update->data[ZBX_VC_UPDATE_RANGE_NOW]);
-				break;
-			case ZBX_VC_UPDATE_STATS:
-				vc_update_statistics(item, update->data[ZBX_VC_UPDATE_STATS_HITS],
-						update->data[ZBX_VC_UPDATE_STATS_MISSES], now);
+			zbx_history_record_t	record;
+
+			if (SUCCEED != vc_snapshot_read_value(fp, snapshot.value_type, &record))
+			{
+				zbx_history_record_clear(&record, snapshot.value_type);
 				break;
+			}
+
+			zbx_vector_history_record_append_ptr(&batch->values[batch->items_num], &record);
+		}
+
+		if (i != snapshot.values_num)
+		{
+			zbx_history_record_vector_clean(&batch->values[batch->items_num], snapshot.value_type);
+			break;
+		}
+
+		batch->items[batch->items_num++] = snapshot;
+
+		if (ZBX_VC_SNAPSHOT_BATCH_SIZE == batch->items_num && SUCCEED != vc_snapshot_load_batch(batch,
+				snapshot.value_type, &items_loaded, &items_dropped))
+		{
+			full = 1;
+			ret = SUCCEED;
+			break;
 		}
 	}
 
-	UNLOCK_CACHE;
+	/* items read before the end of file or corrupted data are still loaded */
+	for (i = 0; i <= ITEM_VALUE_TYPE_BIN && 0 == full; i++)
+	{
+		if (SUCCEED != vc_snapshot_load_batch(&batches[i], (unsigned char)i, &items_loaded, &items_dropped))
+			full = 1;
+	}
 
-	zbx_vector_vc_itemupdate_clear(&vc_itemupdates);
+	if (SUCCEED != ret)
+		*error = zbx_dsprintf(*error, "file \"%s\" is truncated or corrupted", path);
+
+	zabbix_log(LOG_LEVEL_INFORMATION, "loaded %d items from value cache snapshot in " ZBX_FS_DBL " sec,"
+			" dropped %d items", items_loaded, zbx_time() - time_start, items_dropped);
+out:
+	for (i = 0; i <= ITEM_VALUE_TYPE_BIN; i++)
+	{
+		for (j = 0; j < ZBX_VC_SNAPSHOT_BATCH_SIZE; j++)
+		{
+			zbx_history_record_vector_destroy(&batches[i].values[j], i);
+			zbx_history_record_vector_destroy(&batches[i].queries[j].values, i);
+		}
+	}
+
+	zbx_free(batches);
+
+	if (NULL != fp)
+		fclose(fp);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
 }
 
 #ifdef HAVE_TESTS
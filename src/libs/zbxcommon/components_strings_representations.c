@@ -113,6 +113,14 @@ const char	*get_process_type_string(unsigned char proc_type)
 			return "connector manager";
 		case ZBX_PROCESS_TYPE_CONNECTORWORKER:
 			return "connector worker";
+		case ZBX_PROCESS_TYPE_AGENT_POLLER:
+			return "agent poller";
+		case ZBX_PROCESS_TYPE_SNMP_POLLER:
+			return "snmp poller";
+		case ZBX_PROCESS_TYPE_HTTPAGENT_POLLER:
+			return "http agent poller";
+		case ZBX_PROCESS_TYPE_TRENDWRITER:
+			return "trend writer";
 		case ZBX_PROCESS_TYPE_MAIN:
 			return "main";
 	}
@@ -57,7 +57,7 @@ extern int	CONFIG_TCP_MAX_BACKLOG_SIZE;
 static void	tcp_init_hints(struct addrinfo *hints, int socktype, int flags);
 static int	socket_set_nonblocking(ZBX_SOCKET s);
 static void	tcp_set_socket_strerror_from_getaddrinfo(const char *ip);
-static ssize_t	tcp_read(zbx_socket_t *s, char *buffer, size_t size);
+static ssize_t	tcp_read(zbx_socket_t *s, char *buffer, size_t size, short *event);
 
 zbx_config_tls_t	*zbx_config_tls_new(void)
 {
@@ -450,47 +450,256 @@ static int	zbx_socket_connect(zbx_socket_t *s, const struct sockaddr *addr, sock
 	return SUCCEED;
 }
 
+/* resolved address of the host to connect to */
+typedef struct
+{
+	ZBX_SOCKADDR	addr;
+	ZBX_SOCKLEN_T	addrlen;
+	int		family;
+	int		socktype;
+	int		protocol;
+}
+zbx_socket_addr_t;
+
+/* host name resolution cache entry */
+typedef struct
+{
+	char			*host;
+	int			socktype;
+	time_t			expires;
+	char			*error;		/* resolution error for negative entries, NULL otherwise */
+	zbx_socket_addr_t	addr;
+}
+zbx_dns_cache_entry_t;
+
+#define ZBX_DNS_CACHE_TTL		SEC_PER_MIN
+#define ZBX_DNS_CACHE_NEGATIVE_TTL	10
+
+/* The cache is process local and is disabled by default, it is enabled by single threaded processes */
+/* that connect to many hosts by DNS names.                                                           */
+static int		dns_cache_enabled = 0;
+static zbx_hashset_t	dns_cache;
+static time_t		dns_cache_purge_time;
+static zbx_uint64_t	dns_cache_hits, dns_cache_misses;
+
+static zbx_hash_t	dns_cache_hash_func(const void *data)
+{
+	const zbx_dns_cache_entry_t	*entry = (const zbx_dns_cache_entry_t *)data;
+	zbx_hash_t			hash;
+
+	hash = ZBX_DEFAULT_STRING_HASH_ALGO(entry->host, strlen(entry->host), ZBX_DEFAULT_HASH_SEED);
+
+	return ZBX_DEFAULT_HASH_ALGO(&entry->socktype, sizeof(entry->socktype), hash);
+}
+
+static int	dns_cache_compare_func(const void *d1, const void *d2)
+{
+	const zbx_dns_cache_entry_t	*e1 = (const zbx_dns_cache_entry_t *)d1;
+	const zbx_dns_cache_entry_t	*e2 = (const zbx_dns_cache_entry_t *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(e1->socktype, e2->socktype);
+
+	return strcmp(e1->host, e2->host);
+}
+
+static void	dns_cache_entry_clean(void *data)
+{
+	zbx_dns_cache_entry_t	*entry = (zbx_dns_cache_entry_t *)data;
+
+	zbx_free(entry->host);
+	zbx_free(entry->error);
+}
+
 /******************************************************************************
  *                                                                            *
- * Purpose: connect the socket of the specified type to external host         *
+ * Purpose: enable host name resolution cache for outgoing connections of     *
+ *          the current process                                               *
  *                                                                            *
- * Parameters: s - [OUT] socket descriptor                                    *
+ * Comments: Successful resolutions are cached for ZBX_DNS_CACHE_TTL seconds  *
+ *           and failed resolutions for ZBX_DNS_CACHE_NEGATIVE_TTL seconds.   *
+ *           The cache is not thread safe.                                    *
  *                                                                            *
- * Return value: SUCCEED - connected successfully                             *
- *               FAIL - an error occurred                                     *
+ ******************************************************************************/
+void	zbx_tcp_dns_cache_enable(void)
+{
+	if (0 != dns_cache_enabled)
+		return;
+
+	zbx_hashset_create_ext(&dns_cache, 100, dns_cache_hash_func, dns_cache_compare_func, dns_cache_entry_clean,
+			ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
+
+	dns_cache_purge_time = time(NULL);
+	dns_cache_enabled = 1;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: remove expired entries from host name resolution cache            *
  *                                                                            *
  ******************************************************************************/
-static int	zbx_socket_create(zbx_socket_t *s, int type, const char *source_ip, const char *ip, unsigned short port,
-		int timeout, unsigned int tls_connect, const char *tls_arg1, const char *tls_arg2)
+static void	dns_cache_purge(time_t now)
 {
-	int		ret = FAIL, flags;
-	struct addrinfo	*ai = NULL, hints;
-	struct addrinfo	*ai_bind = NULL;
-	char		service[8], *error = NULL;
-	void		(*func_socket_close)(zbx_socket_t *s);
-#if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
-	const char	*server_name = NULL;
-#endif
-	zbx_socket_clean(s);
+	zbx_hashset_iter_t	iter;
+	zbx_dns_cache_entry_t	*entry;
+	zbx_uint64_t		total;
 
-	if (SOCK_DGRAM == type && (ZBX_TCP_SEC_TLS_CERT == tls_connect || ZBX_TCP_SEC_TLS_PSK == tls_connect))
+	zbx_hashset_iter_reset(&dns_cache, &iter);
+	while (NULL != (entry = (zbx_dns_cache_entry_t *)zbx_hashset_iter_next(&iter)))
 	{
-		THIS_SHOULD_NEVER_HAPPEN;
-		return FAIL;
+		if (entry->expires <= now)
+			zbx_hashset_iter_remove(&iter);
 	}
-#if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
-	if (ZBX_TCP_SEC_TLS_PSK == tls_connect && '\0' == *tls_arg1)
+
+	total = dns_cache_hits + dns_cache_misses;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "DNS cache entries:%d hits:" ZBX_FS_UI64 " misses:" ZBX_FS_UI64
+			" hit rate:%.2f%%", dns_cache.num_data, dns_cache_hits, dns_cache_misses,
+			(0 == total ? 0.0 : 100.0 * (double)dns_cache_hits / (double)total));
+
+	dns_cache_purge_time = now;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: resolve host address for connection                               *
+ *                                                                            *
+ * Parameters: ip    - [IN] host address or DNS name                          *
+ *             type  - [IN] socket type (SOCK_STREAM or SOCK_DGRAM)           *
+ *             flags - [IN] getaddrinfo() flags                               *
+ *             port  - [IN] host port                                         *
+ *             addr  - [OUT] the resolved address                             *
+ *                                                                            *
+ * Return value: SUCCEED - the address was resolved                           *
+ *               FAIL    - otherwise, socket error message is set             *
+ *                                                                            *
+ * Comments: DNS names are looked up in the resolution cache when it is       *
+ *           enabled, numeric addresses are always converted directly.        *
+ *                                                                            *
+ ******************************************************************************/
+static int	socket_resolve(const char *ip, int type, int flags, unsigned short port, zbx_socket_addr_t *addr)
+{
+	struct addrinfo		hints, *ai = NULL;
+	zbx_dns_cache_entry_t	*entry = NULL, entry_local;
+	time_t			now = 0;
+	char			service[8];
+
+	if (0 != dns_cache_enabled && NULL != ip && 0 == (flags & AI_NUMERICHOST))
 	{
-		zbx_set_socket_strerror("cannot connect with PSK: PSK not available");
+		now = time(NULL);
+
+		if (ZBX_DNS_CACHE_TTL <= now - dns_cache_purge_time)
+			dns_cache_purge(now);
+
+		entry_local.host = (char *)ip;
+		entry_local.socktype = type;
+
+		if (NULL != (entry = (zbx_dns_cache_entry_t *)zbx_hashset_search(&dns_cache, &entry_local)))
+		{
+			if (now < entry->expires)
+			{
+				dns_cache_hits++;
+
+				if (NULL != entry->error)
+				{
+					zbx_set_socket_strerror("%s", entry->error);
+					return FAIL;
+				}
+
+				*addr = entry->addr;
+				goto out;
+			}
+
+			zbx_free(entry->error);
+		}
+		else
+		{
+			entry_local.host = zbx_strdup(NULL, ip);
+			entry_local.error = NULL;
+			entry = (zbx_dns_cache_entry_t *)zbx_hashset_insert(&dns_cache, &entry_local,
+					sizeof(entry_local));
+		}
+
+		dns_cache_misses++;
+	}
+
+	zbx_snprintf(service, sizeof(service), "%hu", port);
+	tcp_init_hints(&hints, type, flags);
+
+	if (0 != getaddrinfo(ip, service, &hints, &ai))
+	{
+		tcp_set_socket_strerror_from_getaddrinfo(ip);
+
+		if (NULL != entry)
+		{
+			entry->error = zbx_strdup(NULL, zbx_socket_strerror());
+			entry->expires = now + ZBX_DNS_CACHE_NEGATIVE_TTL;
+		}
+
 		return FAIL;
 	}
-#else
-	if (ZBX_TCP_SEC_TLS_CERT == tls_connect || ZBX_TCP_SEC_TLS_PSK == tls_connect)
+
+	if (sizeof(addr->addr) < (size_t)ai->ai_addrlen)
 	{
-		zbx_set_socket_strerror("support for TLS was not compiled in");
+		zbx_set_socket_strerror("unsupported address length for '%s'", ip);
+		freeaddrinfo(ai);
+
+		if (NULL != entry)
+			zbx_hashset_remove_direct(&dns_cache, entry);
+
 		return FAIL;
 	}
+
+	memcpy(&addr->addr, ai->ai_addr, (size_t)ai->ai_addrlen);
+	addr->addrlen = (ZBX_SOCKLEN_T)ai->ai_addrlen;
+	addr->family = ai->ai_family;
+	addr->socktype = ai->ai_socktype;
+	addr->protocol = ai->ai_protocol;
+
+	freeaddrinfo(ai);
+
+	if (NULL != entry)
+	{
+		entry->addr = *addr;
+		entry->expires = now + ZBX_DNS_CACHE_TTL;
+	}
+
+	return SUCCEED;
+out:
+	/* cached address can be used for connections to different ports */
+	if (AF_INET == addr->family)
+		((struct sockaddr_in *)&addr->addr)->sin_port = htons(port);
+#ifdef HAVE_IPV6
+	else if (AF_INET6 == addr->family)
+		((struct sockaddr_in6 *)&addr->addr)->sin6_port = htons(port);
 #endif
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: open non-blocking socket of the specified type for connection to  *
+ *          external host                                                     *
+ *                                                                            *
+ * Parameters: s         - [IN/OUT] socket descriptor                         *
+ *             type      - [IN] socket type (SOCK_STREAM or SOCK_DGRAM)       *
+ *             source_ip - [IN] source address to bind to (optional)          *
+ *             ip        - [IN] host address                                  *
+ *             port      - [IN] host port                                     *
+ *             timeout   - [IN] connection timeout                            *
+ *             addr      - [OUT] resolved host address                        *
+ *                                                                            *
+ * Return value: SUCCEED - socket was opened                                  *
+ *               FAIL - an error occurred                                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	zbx_socket_open(zbx_socket_t *s, int type, const char *source_ip, const char *ip, unsigned short port,
+		int timeout, zbx_socket_addr_t *addr)
+{
+	int		ret = FAIL, flags;
+	struct addrinfo	hints;
+	struct addrinfo	*ai_bind = NULL;
+	void		(*func_socket_close)(zbx_socket_t *s);
+
 	s->timeout = timeout;
 
 	if (SUCCEED == zbx_is_ip4(ip))
@@ -502,16 +711,10 @@ static int	zbx_socket_create(zbx_socket_t *s, int type, const char *source_ip, c
 	else
 		flags = 0;
 
-	zbx_snprintf(service, sizeof(service), "%hu", port);
-	tcp_init_hints(&hints, type, flags);
-
-	if (0 != getaddrinfo(ip, service, &hints, &ai))
-	{
-		tcp_set_socket_strerror_from_getaddrinfo(ip);
+	if (SUCCEED != socket_resolve(ip, type, flags, port, addr))
 		goto out;
-	}
 
-	if (ZBX_SOCKET_ERROR == (s->socket = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol)))
+	if (ZBX_SOCKET_ERROR == (s->socket = socket(addr->family, addr->socktype | SOCK_CLOEXEC, addr->protocol)))
 	{
 		zbx_set_socket_strerror("cannot create socket [[%s]:%hu]: %s",
 				ip, port, strerror_from_system(zbx_socket_last_error()));
@@ -557,7 +760,60 @@ static int	zbx_socket_create(zbx_socket_t *s, int type, const char *source_ip, c
 
 	zbx_socket_set_deadline(s, timeout);
 
-	if (SUCCEED != zbx_socket_connect(s, ai->ai_addr, (socklen_t)ai->ai_addrlen, &error))
+	ret = SUCCEED;
+out:
+	if (NULL != ai_bind)
+		freeaddrinfo(ai_bind);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: connect the socket of the specified type to external host         *
+ *                                                                            *
+ * Parameters: s - [OUT] socket descriptor                                    *
+ *                                                                            *
+ * Return value: SUCCEED - connected successfully                             *
+ *               FAIL - an error occurred                                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	zbx_socket_create(zbx_socket_t *s, int type, const char *source_ip, const char *ip, unsigned short port,
+		int timeout, unsigned int tls_connect, const char *tls_arg1, const char *tls_arg2)
+{
+	int			ret = FAIL;
+	zbx_socket_addr_t	addr;
+	char			*error = NULL;
+	void			(*func_socket_close)(zbx_socket_t *s);
+#if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
+	const char		*server_name = NULL;
+#endif
+	zbx_socket_clean(s);
+
+	if (SOCK_DGRAM == type && (ZBX_TCP_SEC_TLS_CERT == tls_connect || ZBX_TCP_SEC_TLS_PSK == tls_connect))
+	{
+		THIS_SHOULD_NEVER_HAPPEN;
+		return FAIL;
+	}
+#if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
+	if (ZBX_TCP_SEC_TLS_PSK == tls_connect && '\0' == *tls_arg1)
+	{
+		zbx_set_socket_strerror("cannot connect with PSK: PSK not available");
+		return FAIL;
+	}
+#else
+	if (ZBX_TCP_SEC_TLS_CERT == tls_connect || ZBX_TCP_SEC_TLS_PSK == tls_connect)
+	{
+		zbx_set_socket_strerror("support for TLS was not compiled in");
+		return FAIL;
+	}
+#endif
+	if (SUCCEED != zbx_socket_open(s, type, source_ip, ip, port, timeout, &addr))
+		goto out;
+
+	func_socket_close = (SOCK_STREAM == type ? zbx_tcp_close : zbx_udp_close);
+
+	if (SUCCEED != zbx_socket_connect(s, (struct sockaddr *)&addr.addr, (socklen_t)addr.addrlen, &error))
 	{
 		func_socket_close(s);
 		zbx_set_socket_strerror("cannot connect to [[%s]:%hu]: %s", ip, port, error);
@@ -572,7 +828,7 @@ static int	zbx_socket_create(zbx_socket_t *s, int type, const char *source_ip, c
 	}
 
 	if ((ZBX_TCP_SEC_TLS_CERT == tls_connect || ZBX_TCP_SEC_TLS_PSK == tls_connect) &&
-			SUCCEED != zbx_tls_connect(s, tls_connect, tls_arg1, tls_arg2, server_name, &error))
+			SUCCEED != zbx_tls_connect(s, tls_connect, tls_arg1, tls_arg2, server_name, NULL, &error))
 	{
 		zbx_tcp_close(s);
 		zbx_set_socket_strerror("TCP successful, cannot establish TLS to [[%s]:%hu]: %s", ip, port, error);
@@ -587,12 +843,6 @@ static int	zbx_socket_create(zbx_socket_t *s, int type, const char *source_ip, c
 
 	ret = SUCCEED;
 out:
-	if (NULL != ai)
-		freeaddrinfo(ai);
-
-	if (NULL != ai_bind)
-		freeaddrinfo(ai_bind);
-
 	return ret;
 }
 
@@ -609,7 +859,150 @@ int	zbx_tcp_connect(zbx_socket_t *s, const char *source_ip, const char *ip, unsi
 	return zbx_socket_create(s, SOCK_STREAM, source_ip, ip, port, timeout, tls_connect, tls_arg1, tls_arg2);
 }
 
-ssize_t	zbx_tcp_write(zbx_socket_t *s, const char *buf, size_t len)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: start connecting TCP socket to external host without waiting for  *
+ *          connection to be established                                      *
+ *                                                                            *
+ * Parameters: s         - [OUT] socket descriptor                            *
+ *             source_ip - [IN] source address to bind to (optional)          *
+ *             ip        - [IN] host address                                  *
+ *             port      - [IN] host port                                     *
+ *             timeout   - [IN] timeout used when closing connection          *
+ *                                                                            *
+ * Return value: SUCCEED - connection was initiated, the socket must be       *
+ *                         polled for POLLOUT and the result checked with     *
+ *                         zbx_tcp_connect_check()                            *
+ *               FAIL - an error occurred                                     *
+ *                                                                            *
+ * Comments: host name is resolved synchronously                              *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_tcp_connect_start(zbx_socket_t *s, const char *source_ip, const char *ip, unsigned short port,
+		int timeout)
+{
+	int			ret = FAIL;
+	zbx_socket_addr_t	addr;
+
+	zbx_socket_clean(s);
+
+	if (SUCCEED != zbx_socket_open(s, SOCK_STREAM, source_ip, ip, port, timeout, &addr))
+		goto out;
+
+	/* socket operations are limited by the caller */
+	zbx_socket_set_deadline(s, 0);
+
+	if (ZBX_PROTO_ERROR == connect(s->socket, (struct sockaddr *)&addr.addr, (socklen_t)addr.addrlen) &&
+			SUCCEED != zbx_socket_had_nonblocking_error())
+	{
+		zbx_set_socket_strerror("cannot connect to [[%s]:%hu]: %s", ip, port,
+				strerror_from_system(zbx_socket_last_error()));
+		zbx_tcp_close(s);
+		goto out;
+	}
+
+	zbx_strlcpy(s->peer, ip, sizeof(s->peer));
+
+	ret = SUCCEED;
+out:
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: check result of connection started by zbx_tcp_connect_start()     *
+ *                                                                            *
+ * Return value: SUCCEED - connection was established                         *
+ *               FAIL - connection failed                                     *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_tcp_connect_check(zbx_socket_t *s)
+{
+	int		err = 0;
+	socklen_t	err_len = sizeof(err);
+
+	if (ZBX_PROTO_ERROR == getsockopt(s->socket, SOL_SOCKET, SO_ERROR, (char *)&err, &err_len))
+	{
+		zbx_set_socket_strerror("cannot connect to [%s]: cannot get socket error: %s", s->peer,
+				strerror_from_system(zbx_socket_last_error()));
+		return FAIL;
+	}
+
+	if (0 != err)
+	{
+		zbx_set_socket_strerror("cannot connect to [%s]: %s", s->peer, strerror_from_system(err));
+		return FAIL;
+	}
+
+	s->connection_type = ZBX_TCP_SEC_UNENCRYPTED;
+
+	return SUCCEED;
+}
+
+#if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: establish TLS connection over TCP connection opened with          *
+ *          zbx_tcp_connect_start() without blocking                          *
+ *                                                                            *
+ * Parameters: s           - [IN] socket with established TCP connection      *
+ *             tls_connect - [IN] ZBX_TCP_SEC_TLS_CERT or ZBX_TCP_SEC_TLS_PSK *
+ *             tls_arg1    - [IN] see zbx_tls_connect()                       *
+ *             tls_arg2    - [IN] see zbx_tls_connect()                       *
+ *             event       - [OUT] socket event to wait for                   *
+ *                                                                            *
+ * Return value: SUCCEED - TLS connection was established                     *
+ *               FAIL - an error occurred or, if event is set, the function   *
+ *                      must be called again when socket is ready             *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_tcp_tls_connect(zbx_socket_t *s, unsigned int tls_connect, const char *tls_arg1, const char *tls_arg2,
+		short *event)
+{
+	char		*error = NULL;
+	const char	*server_name = NULL;
+
+	*event = 0;
+
+	if (ZBX_TCP_SEC_TLS_PSK == tls_connect && '\0' == *tls_arg1)
+	{
+		zbx_set_socket_strerror("cannot connect with PSK: PSK not available");
+		return FAIL;
+	}
+
+	if (SUCCEED != zbx_is_ip(s->peer))
+		server_name = s->peer;
+
+	if (SUCCEED != zbx_tls_connect(s, tls_connect, tls_arg1, tls_arg2, server_name, event, &error))
+	{
+		if (0 == *event)
+		{
+			zbx_set_socket_strerror("TCP successful, cannot establish TLS to [%s]: %s", s->peer, error);
+			zbx_free(error);
+		}
+
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: write data to socket                                              *
+ *                                                                            *
+ * Parameters: s     - [IN] socket                                            *
+ *             buf   - [IN] data to write                                     *
+ *             len   - [IN] data length                                       *
+ *             event - [OUT] socket event to wait for (optional), if set the  *
+ *                           function does not wait and returns number of     *
+ *                           bytes written so far                             *
+ *                                                                            *
+ * Return value: number of bytes written or ZBX_PROTO_ERROR on error          *
+ *                                                                            *
+ ******************************************************************************/
+ssize_t	zbx_tcp_write(zbx_socket_t *s, const char *buf, size_t len, short *event)
 {
 	zbx_pollfd_t	pd;
 	ssize_t		n, offset = 0;
@@ -619,7 +1012,7 @@ ssize_t	zbx_tcp_write(zbx_socket_t *s, const char *buf, size_t len)
 	{
 		char	*error = NULL;
 
-		if (ZBX_PROTO_ERROR == (n = zbx_tls_write(s, buf, len, &error)))
+		if (ZBX_PROTO_ERROR == (n = zbx_tls_write(s, buf, len, event, &error)))
 		{
 			zbx_set_socket_strerror("%s", error);
 			zbx_free(error);
@@ -632,6 +1025,25 @@ ssize_t	zbx_tcp_write(zbx_socket_t *s, const char *buf, size_t len)
 	if (0 < (n = ZBX_TCP_WRITE(s->socket, buf, len)) && (size_t)n == len)
 		return n;
 
+	if (NULL != event)
+	{
+		if (0 > n)
+		{
+			if (SUCCEED != zbx_socket_had_nonblocking_error())
+			{
+				zbx_set_socket_strerror("cannot write data: %s",
+						strerror_from_system(zbx_socket_last_error()));
+				return ZBX_PROTO_ERROR;
+			}
+
+			n = 0;
+		}
+
+		*event = POLLOUT;
+
+		return n;
+	}
+
 	pd.fd = s->socket;
 	pd.events = POLLOUT;
 
@@ -675,20 +1087,209 @@ ssize_t	zbx_tcp_write(zbx_socket_t *s, const char *buf, size_t len)
 		{
 			offset += n;
 
-			if (offset == (ssize_t)len)
-				break;
-		}
+			if (offset == (ssize_t)len)
+				break;
+		}
+
+		if (SUCCEED != zbx_socket_check_deadline(s))
+		{
+			zbx_set_socket_strerror("write timeout");
+			return ZBX_PROTO_ERROR;
+		}
+
+		n = ZBX_TCP_WRITE(s->socket, buf + offset, (len - (size_t)offset));
+	}
+
+	return offset;
+}
+
+#define ZBX_TCP_HEADER_DATA	"ZBXD"
+#define ZBX_TCP_HEADER_LEN	ZBX_CONST_STRLEN(ZBX_TCP_HEADER_DATA)
+#define ZBX_TCP_HEADER_LEN_MAX	(ZBX_TCP_HEADER_LEN + 1 + 2 * sizeof(zbx_uint64_t))
+
+#define ZBX_TLS_MAX_REC_LEN	16384
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns protocol flags for the specified compression codec        *
+ *                                                                            *
+ * Parameters: codec - [IN] the compression codec (ZBX_COMPRESS_*)            *
+ *                                                                            *
+ ******************************************************************************/
+unsigned char	zbx_tcp_compress_flags(unsigned char codec)
+{
+	switch (codec)
+	{
+		case ZBX_COMPRESS_ZSTD:
+			return ZBX_TCP_COMPRESS | ZBX_TCP_COMPRESS_ZSTD;
+		case ZBX_COMPRESS_LZ4:
+			return ZBX_TCP_COMPRESS | ZBX_TCP_COMPRESS_LZ4;
+		default:
+			return ZBX_TCP_COMPRESS;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns compression codec specified by protocol flags             *
+ *                                                                            *
+ ******************************************************************************/
+static unsigned char	tcp_flags_codec(unsigned char flags)
+{
+	if (0 != (flags & ZBX_TCP_COMPRESS_ZSTD))
+		return ZBX_COMPRESS_ZSTD;
+
+	if (0 != (flags & ZBX_TCP_COMPRESS_LZ4))
+		return ZBX_COMPRESS_LZ4;
+
+	return ZBX_COMPRESS_ZLIB;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if protocol version flags of received message are valid    *
+ *                                                                            *
+ * Parameters: version - [IN] the protocol version flags                      *
+ *             flags   - [IN] the additionally accepted flags                 *
+ *                                                                            *
+ * Return value: SUCCEED - the protocol version flags are valid               *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	tcp_check_protocol_version(unsigned char version, unsigned char flags)
+{
+	unsigned char	accepted = ZBX_TCP_PROTOCOL | ZBX_TCP_COMPRESS | flags;
+
+	if (SUCCEED == zbx_compress_codec_supported(ZBX_COMPRESS_ZSTD))
+		accepted |= ZBX_TCP_COMPRESS_ZSTD;
+
+	if (SUCCEED == zbx_compress_codec_supported(ZBX_COMPRESS_LZ4))
+		accepted |= ZBX_TCP_COMPRESS_LZ4;
+
+	if (0 == (version & ZBX_TCP_PROTOCOL) || 0 != (version & ~accepted))
+		return FAIL;
+
+	/* codec flags are valid only with compression flag and only one codec can be set */
+	if (0 != (version & (ZBX_TCP_COMPRESS_ZSTD | ZBX_TCP_COMPRESS_LZ4)) &&
+			(0 == (version & ZBX_TCP_COMPRESS) ||
+			(ZBX_TCP_COMPRESS_ZSTD | ZBX_TCP_COMPRESS_LZ4) ==
+			(version & (ZBX_TCP_COMPRESS_ZSTD | ZBX_TCP_COMPRESS_LZ4))))
+	{
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: prepare Zabbix protocol header, compress data if requested        *
+ *                                                                            *
+ * Parameters: data            - [IN/OUT] data to send, replaced with         *
+ *                                        compressed data if compression was  *
+ *                                        performed                           *
+ *             len             - [IN] data length                             *
+ *             reserved        - [IN] uncompressed data length if data is     *
+ *                                    already compressed                      *
+ *             flags           - [IN] protocol flags                          *
+ *             compressed_data - [OUT] compressed data, must be freed by      *
+ *                                     caller                                 *
+ *             send_len        - [OUT] length of data to send                 *
+ *             header_buf      - [OUT] buffer of at least                     *
+ *                                     ZBX_TCP_HEADER_LEN_MAX bytes           *
+ *             header_len      - [OUT] protocol header length                 *
+ *                                                                            *
+ * Return value: SUCCEED - header was prepared                                *
+ *               FAIL - an error occurred                                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	tcp_prepare_header(const char **data, size_t len, size_t reserved, unsigned char flags,
+		char **compressed_data, size_t *send_len, char *header_buf, size_t *header_len)
+{
+	size_t			offset;
+	const zbx_uint64_t	max_uint32 = ~(zbx_uint32_t)0;
+
+	*send_len = len;
+
+	if (ZBX_MAX_RECV_LARGE_DATA_SIZE < len)
+	{
+		zbx_set_socket_strerror("cannot send data: message size " ZBX_FS_UI64 " exceeds the maximum"
+				" size " ZBX_FS_UI64 " bytes.", len, ZBX_MAX_RECV_LARGE_DATA_SIZE);
+		return FAIL;
+	}
+
+	if (ZBX_MAX_RECV_LARGE_DATA_SIZE < reserved)
+	{
+		zbx_set_socket_strerror("cannot send data: uncompressed message size " ZBX_FS_UI64
+				" exceeds the maximum size " ZBX_FS_UI64 " bytes.", reserved,
+				ZBX_MAX_RECV_LARGE_DATA_SIZE);
+		return FAIL;
+	}
+
+	if (0 != (flags & ZBX_TCP_COMPRESS))
+	{
+		/* compress if not compressed yet */
+		if (0 == reserved)
+		{
+			unsigned char	codec = tcp_flags_codec(flags);
+			double		time_start;
+
+			time_start = zbx_time();
+
+			if (SUCCEED != zbx_compress_ext(codec, *data, len, compressed_data, send_len))
+			{
+				zbx_set_socket_strerror("cannot compress data: %s", zbx_compress_strerror());
+				return FAIL;
+			}
+
+			zabbix_log(LOG_LEVEL_DEBUG, "%s(): compressed " ZBX_FS_SIZE_T " bytes to " ZBX_FS_SIZE_T
+					" bytes using %s, ratio %.1f, time " ZBX_FS_DBL " sec", __func__,
+					(zbx_fs_size_t)len, (zbx_fs_size_t)*send_len, zbx_compress_codec_name(codec),
+					0 != *send_len ? (double)len / (double)*send_len : 0.0, zbx_time() - time_start);
+
+			*data = *compressed_data;
+			reserved = len;
+		}
+	}
+	else
+		flags &= ~ZBX_TCP_COMPRESS_MASK;
+
+	memcpy(header_buf, ZBX_TCP_HEADER_DATA, ZBX_CONST_STRLEN(ZBX_TCP_HEADER_DATA));
+	offset = ZBX_CONST_STRLEN(ZBX_TCP_HEADER_DATA);
+
+	if (max_uint32 <= len || max_uint32 <= reserved)
+		flags |= ZBX_TCP_LARGE;
+
+	header_buf[offset++] = flags;
+
+	if (0 != (flags & ZBX_TCP_LARGE))
+	{
+		zbx_uint64_t	len64_le;
+
+		len64_le = zbx_htole_uint64((zbx_uint64_t)*send_len);
+		memcpy(header_buf + offset, &len64_le, sizeof(len64_le));
+		offset += sizeof(len64_le);
+
+		len64_le = zbx_htole_uint64((zbx_uint64_t)reserved);
+		memcpy(header_buf + offset, &len64_le, sizeof(len64_le));
+		offset += sizeof(len64_le);
+	}
+	else
+	{
+		zbx_uint32_t	len32_le;
 
-		if (SUCCEED != zbx_socket_check_deadline(s))
-		{
-			zbx_set_socket_strerror("write timeout");
-			return ZBX_PROTO_ERROR;
-		}
+		len32_le = zbx_htole_uint32((zbx_uint32_t)*send_len);
+		memcpy(header_buf + offset, &len32_le, sizeof(len32_le));
+		offset += sizeof(len32_le);
 
-		n = ZBX_TCP_WRITE(s->socket, buf + offset, (len - (size_t)offset));
+		len32_le = zbx_htole_uint32((zbx_uint32_t)reserved);
+		memcpy(header_buf + offset, &len32_le, sizeof(len32_le));
+		offset += sizeof(len32_le);
 	}
 
-	return offset;
+	*header_len = offset;
+
+	return SUCCEED;
 }
 
 /******************************************************************************
@@ -709,20 +1310,13 @@ ssize_t	zbx_tcp_write(zbx_socket_t *s, const char *buf, size_t len)
  *     The same is applied for sending unencrypted messages.                  *
  *                                                                            *
  ******************************************************************************/
-
-#define ZBX_TCP_HEADER_DATA	"ZBXD"
-#define ZBX_TCP_HEADER_LEN	ZBX_CONST_STRLEN(ZBX_TCP_HEADER_DATA)
-
 int	zbx_tcp_send_ext(zbx_socket_t *s, const char *data, size_t len, size_t reserved, unsigned char flags,
 		int timeout)
 {
-#define ZBX_TLS_MAX_REC_LEN	16384
-
 	ssize_t			bytes_sent, written = 0;
 	size_t			send_bytes, offset, send_len = len;
 	int			ret = SUCCEED;
 	char			*compressed_data = NULL;
-	const zbx_uint64_t	max_uint32 = ~(zbx_uint32_t)0;
 
 	if (0 != timeout)
 		zbx_socket_set_deadline(s, timeout);
@@ -734,79 +1328,19 @@ int	zbx_tcp_send_ext(zbx_socket_t *s, const char *data, size_t len, size_t reser
 								/* will be short-lived in CPU cache. Static buffer is */
 								/* not used on purpose.				      */
 
-		if (ZBX_MAX_RECV_LARGE_DATA_SIZE < len)
-		{
-			zbx_set_socket_strerror("cannot send data: message size " ZBX_FS_UI64 " exceeds the maximum"
-					" size " ZBX_FS_UI64 " bytes.", len, ZBX_MAX_RECV_LARGE_DATA_SIZE);
-			ret = FAIL;
-			goto cleanup;
-		}
-
-		if (ZBX_MAX_RECV_LARGE_DATA_SIZE < reserved)
+		if (SUCCEED != tcp_prepare_header(&data, len, reserved, flags, &compressed_data, &send_len,
+				header_buf, &offset))
 		{
-			zbx_set_socket_strerror("cannot send data: uncompressed message size " ZBX_FS_UI64
-					" exceeds the maximum size " ZBX_FS_UI64 " bytes.", reserved,
-					ZBX_MAX_RECV_LARGE_DATA_SIZE);
 			ret = FAIL;
 			goto cleanup;
 		}
 
-		if (0 != (flags & ZBX_TCP_COMPRESS))
-		{
-			/* compress if not compressed yet */
-			if (0 == reserved)
-			{
-				if (SUCCEED != zbx_compress(data, len, &compressed_data, &send_len))
-				{
-					zbx_set_socket_strerror("cannot compress data: %s", zbx_compress_strerror());
-					ret = FAIL;
-					goto cleanup;
-				}
-
-				data = compressed_data;
-				reserved = len;
-			}
-		}
-
-		memcpy(header_buf, ZBX_TCP_HEADER_DATA, ZBX_CONST_STRLEN(ZBX_TCP_HEADER_DATA));
-		offset = ZBX_CONST_STRLEN(ZBX_TCP_HEADER_DATA);
-
-		if (max_uint32 <= len || max_uint32 <= reserved)
-			flags |= ZBX_TCP_LARGE;
-
-		header_buf[offset++] = flags;
-
-		if (0 != (flags & ZBX_TCP_LARGE))
-		{
-			zbx_uint64_t	len64_le;
-
-			len64_le = zbx_htole_uint64((zbx_uint64_t)send_len);
-			memcpy(header_buf + offset, &len64_le, sizeof(len64_le));
-			offset += sizeof(len64_le);
-
-			len64_le = zbx_htole_uint64((zbx_uint64_t)reserved);
-			memcpy(header_buf + offset, &len64_le, sizeof(len64_le));
-			offset += sizeof(len64_le);
-		}
-		else
-		{
-			zbx_uint32_t	len32_le;
-
-			len32_le = zbx_htole_uint32((zbx_uint32_t)send_len);
-			memcpy(header_buf + offset, &len32_le, sizeof(len32_le));
-			offset += sizeof(len32_le);
-
-			len32_le = zbx_htole_uint32((zbx_uint32_t)reserved);
-			memcpy(header_buf + offset, &len32_le, sizeof(len32_le));
-			offset += sizeof(len32_le);
-		}
-
 		take_bytes = MIN(send_len, ZBX_TLS_MAX_REC_LEN - offset);
 		memcpy(header_buf + offset, data, take_bytes);
 
 		send_bytes = offset + take_bytes;
 
-		if (ZBX_PROTO_ERROR == (written = zbx_tcp_write(s, header_buf, send_bytes)))
+		if (ZBX_PROTO_ERROR == (written = zbx_tcp_write(s, header_buf, send_bytes, NULL)))
 		{
 			ret = FAIL;
 			goto cleanup;
@@ -822,7 +1356,7 @@ int	zbx_tcp_send_ext(zbx_socket_t *s, const char *data, size_t len, size_t reser
 		else
 			send_bytes = MIN(ZBX_TLS_MAX_REC_LEN, send_len - (size_t)written);
 
-		if (ZBX_PROTO_ERROR == (bytes_sent = zbx_tcp_write(s, data + written, send_bytes)))
+		if (ZBX_PROTO_ERROR == (bytes_sent = zbx_tcp_write(s, data + written, send_bytes, NULL)))
 		{
 			ret = FAIL;
 			goto cleanup;
@@ -836,10 +1370,130 @@ cleanup:
 		zbx_socket_set_deadline(s, 0);
 
 	return ret;
+}
 
-#undef ZBX_TLS_MAX_REC_LEN
+/******************************************************************************
+ *                                                                            *
+ * Purpose: prepare data for sending over non-blocking connection             *
+ *                                                                            *
+ * Parameters: data     - [IN] data to send, must stay valid until sending is *
+ *                             finished                                       *
+ *             len      - [IN] data length                                    *
+ *             reserved - [IN] see zbx_tcp_send_ext()                         *
+ *             flags    - [IN] protocol flags                                 *
+ *             context  - [OUT] send context                                  *
+ *                                                                            *
+ * Return value: SUCCEED - context was initialized                            *
+ *               FAIL - an error occurred                                     *
+ *                                                                            *
+ * Comments: The context must be cleared with zbx_tcp_send_context_clear()    *
+ *           regardless of the return value.                                  *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_tcp_send_context_init(const char *data, size_t len, size_t reserved, unsigned char flags,
+		zbx_tcp_send_context_t *context)
+{
+	size_t	take_bytes, header_len;
+	char	header_buf[ZBX_TCP_HEADER_LEN_MAX];
+
+	context->compressed_data = NULL;
+	context->header_buf = NULL;
+	context->header_len = 0;
+	context->header_written = 0;
+	context->written = 0;
+
+	if (0 == (flags & ZBX_TCP_PROTOCOL))
+	{
+		context->data = data;
+		context->send_len = len;
+
+		return SUCCEED;
+	}
+
+	if (SUCCEED != tcp_prepare_header(&data, len, reserved, flags, &context->compressed_data, &context->send_len,
+			header_buf, &header_len))
+	{
+		return FAIL;
+	}
+
+	take_bytes = MIN(context->send_len, ZBX_TLS_MAX_REC_LEN - header_len);
+
+	context->header_buf = (char *)zbx_malloc(NULL, header_len + take_bytes);
+	memcpy(context->header_buf, header_buf, header_len);
+	memcpy(context->header_buf + header_len, data, take_bytes);
+
+	context->header_len = header_len + take_bytes;
+	context->written = take_bytes;
+	context->data = data;
+
+	return SUCCEED;
+}
+
+void	zbx_tcp_send_context_clear(zbx_tcp_send_context_t *context)
+{
+	zbx_free(context->header_buf);
+	zbx_free(context->compressed_data);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: send data prepared by zbx_tcp_send_context_init()                 *
+ *                                                                            *
+ * Parameters: s       - [IN] socket                                          *
+ *             context - [IN/OUT] send context                                *
+ *             event   - [OUT] socket event to wait for (optional)            *
+ *                                                                            *
+ * Return value: SUCCEED - all data was sent                                  *
+ *               FAIL - an error occurred or, if event is set, the function   *
+ *                      must be called again when socket is ready             *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_tcp_send_context(zbx_socket_t *s, zbx_tcp_send_context_t *context, short *event)
+{
+	ssize_t	bytes_sent;
+	size_t	send_bytes;
+
+	if (NULL != event)
+		*event = 0;
+
+	while (context->header_written < context->header_len)
+	{
+		if (ZBX_PROTO_ERROR == (bytes_sent = zbx_tcp_write(s, context->header_buf + context->header_written,
+				context->header_len - context->header_written, event)))
+		{
+			return FAIL;
+		}
+
+		context->header_written += (size_t)bytes_sent;
+
+		if (NULL != event && 0 != *event)
+			return FAIL;
+	}
+
+	while (context->written < context->send_len)
+	{
+		if (ZBX_TCP_SEC_UNENCRYPTED == s->connection_type)
+			send_bytes = context->send_len - context->written;
+		else
+			send_bytes = MIN(ZBX_TLS_MAX_REC_LEN, context->send_len - context->written);
+
+		if (ZBX_PROTO_ERROR == (bytes_sent = zbx_tcp_write(s, context->data + context->written, send_bytes,
+				event)))
+		{
+			return FAIL;
+		}
+
+		context->written += (size_t)bytes_sent;
+
+		if (NULL != event && 0 != *event)
+			return FAIL;
+	}
+
+	return SUCCEED;
 }
 
+#undef ZBX_TLS_MAX_REC_LEN
+
 /******************************************************************************
  *                                                                            *
  * Purpose: close open TCP socket                                             *
@@ -1102,7 +1756,7 @@ static ssize_t	tcp_peek(zbx_socket_t *s, char *buffer, size_t size)
  * Purpose: read data from socket                                             *
  *                                                                            *
  ******************************************************************************/
-static ssize_t	tcp_read(zbx_socket_t *s, char *buffer, size_t size)
+static ssize_t	tcp_read(zbx_socket_t *s, char *buffer, size_t size, short *event)
 {
 	ssize_t		n;
 	zbx_pollfd_t	pd;
@@ -1117,6 +1771,12 @@ static ssize_t	tcp_read(zbx_socket_t *s, char *buffer, size_t size)
 		return ZBX_PROTO_ERROR;
 	}
 
+	if (NULL != event)
+	{
+		*event = POLLIN;
+		return ZBX_PROTO_ERROR;
+	}
+
 	pd.fd = s->socket;
 	pd.events = POLLIN;
 
@@ -1410,6 +2070,67 @@ void	zbx_tcp_unlisten(zbx_socket_t *s)
 		zbx_socket_close(s->sockets[i]);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: set up security of accepted connection                            *
+ *                                                                            *
+ * Parameters: s          - [IN/OUT] socket with accepted connection          *
+ *             tls_accept - [IN] TLS configuration                            *
+ *             tls        - [IN] SUCCEED - TLS connection was detected,       *
+ *                               FAIL - unencrypted connection                *
+ *             event      - [OUT] socket event TLS handshake is waiting for   *
+ *                                in non-blocking mode (optional)             *
+ *                                                                            *
+ * Return value: SUCCEED - connection type was established                    *
+ *               FAIL - an error occurred or, if event is set, the function   *
+ *                      must be called again when socket is ready             *
+ *                                                                            *
+ ******************************************************************************/
+static int	tcp_accept_secure(zbx_socket_t *s, unsigned int tls_accept, int tls, short *event)
+{
+	if (SUCCEED == tls)
+	{
+#if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
+		if (0 != (tls_accept & (ZBX_TCP_SEC_TLS_CERT | ZBX_TCP_SEC_TLS_PSK)))
+		{
+			char	*error = NULL;
+
+			if (SUCCEED != zbx_tls_accept(s, tls_accept, event, &error))
+			{
+				if (NULL == event || 0 == *event)
+				{
+					zbx_set_socket_strerror("from %s: %s", s->peer, error);
+					zbx_free(error);
+				}
+
+				return FAIL;
+			}
+		}
+		else
+		{
+			zbx_set_socket_strerror("from %s: TLS connections are not allowed", s->peer);
+			return FAIL;
+		}
+#else
+		ZBX_UNUSED(event);
+		zbx_set_socket_strerror("from %s: support for TLS was not compiled in", s->peer);
+		return FAIL;
+#endif
+	}
+	else
+	{
+		if (0 == (tls_accept & ZBX_TCP_SEC_UNENCRYPTED))
+		{
+			zbx_set_socket_strerror("from %s: unencrypted connections are not allowed", s->peer);
+			return FAIL;
+		}
+
+		s->connection_type = ZBX_TCP_SEC_UNENCRYPTED;
+	}
+
+	return SUCCEED;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: permits an incoming connection attempt on a socket                *
@@ -1516,74 +2237,171 @@ int	zbx_tcp_accept(zbx_socket_t *s, unsigned int tls_accept, int poll_timeout)
 	}
 
 	/* if the 1st byte is 0x16 then assume it's a TLS connection */
-	if (1 == res && '\x16' == buf)
+	if (SUCCEED != tcp_accept_secure(s, tls_accept, 1 == res && '\x16' == buf ? SUCCEED : FAIL, NULL))
 	{
-#if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
-		if (0 != (tls_accept & (ZBX_TCP_SEC_TLS_CERT | ZBX_TCP_SEC_TLS_PSK)))
-		{
-			char	*error = NULL;
-
-			if (SUCCEED != zbx_tls_accept(s, tls_accept, &error))
-			{
-				zbx_set_socket_strerror("from %s: %s", s->peer, error);
-				zbx_tcp_unaccept(s);
-				zbx_free(error);
-				goto out;
-			}
-		}
-		else
-		{
-			zbx_set_socket_strerror("from %s: TLS connections are not allowed", s->peer);
-			zbx_tcp_unaccept(s);
-			goto out;
-		}
-#else
-		zbx_set_socket_strerror("from %s: support for TLS was not compiled in", s->peer);
 		zbx_tcp_unaccept(s);
 		goto out;
-#endif
 	}
-	else
+
+	zbx_socket_set_deadline(s, 0);
+
+	ret = SUCCEED;
+out:
+	zbx_free(pds);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: close accepted connection                                         *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_tcp_unaccept(zbx_socket_t *s)
+{
+#if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
+	zbx_tls_close(s);
+#endif
+	if (!s->accepted) return;
+
+	shutdown(s->socket, 2);
+
+	zbx_socket_free(s);
+	zbx_socket_close(s->socket);
+
+	s->socket = s->socket_orig;	/* restore main socket */
+	s->socket_orig = ZBX_SOCKET_ERROR;
+	s->accepted = 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: switch listening sockets to non-blocking mode                     *
+ *                                                                            *
+ * Comments: Listening sockets are shared between processes, so accept() of   *
+ *           a connection taken by another process must not block.            *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_tcp_listen_nonblocking(zbx_socket_t *s)
+{
+	int	i;
+
+	for (i = 0; i < s->num_socks; i++)
 	{
-		if (0 == (tls_accept & ZBX_TCP_SEC_UNENCRYPTED))
+		if (SUCCEED != socket_set_nonblocking(s->sockets[i]))
 		{
-			zbx_set_socket_strerror("from %s: unencrypted connections are not allowed", s->peer);
-			zbx_tcp_unaccept(s);
-			goto out;
+			zbx_set_socket_strerror("failed to set socket non-blocking mode: %s",
+					strerror_from_system(zbx_socket_last_error()));
+			return FAIL;
 		}
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: accept incoming connection without waiting for any data           *
+ *                                                                            *
+ * Parameters: listen_sock   - [IN] listening socket                          *
+ *             listen_socket - [IN] one of listening socket descriptors that  *
+ *                                  has pending connection                    *
+ *             s             - [OUT] socket with accepted connection          *
+ *                                                                            *
+ * Return value: SUCCEED       - connection was accepted, its security must   *
+ *                               be established with zbx_tcp_accept_check()   *
+ *               FAIL          - an error occurred                            *
+ *               TIMEOUT_ERROR - no pending connections                       *
+ *                                                                            *
+ * Comments: The accepted connection must be closed with zbx_tcp_unaccept().  *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_tcp_accept_start(const zbx_socket_t *listen_sock, ZBX_SOCKET listen_socket, zbx_socket_t *s)
+{
+	ZBX_SOCKADDR	serv_addr;
+	ZBX_SOCKET	accepted_socket;
+	ZBX_SOCKLEN_T	nlen = sizeof(serv_addr);
+
+	if (ZBX_SOCKET_ERROR == (accepted_socket = (ZBX_SOCKET)accept(listen_socket, (struct sockaddr *)&serv_addr,
+			&nlen)))
+	{
+		if (SUCCEED == zbx_socket_had_nonblocking_error())
+			return TIMEOUT_ERROR;
+
+		zbx_set_socket_strerror("accept() failed: %s", strerror_from_system(zbx_socket_last_error()));
+		return FAIL;
+	}
+
+	zbx_socket_clean(s);
+	s->socket = accepted_socket;
+	s->socket_orig = ZBX_SOCKET_ERROR;
+	s->accepted = 1;
+	s->timeout = listen_sock->timeout;
+	s->buffer = s->buf_stat;
+
+	if (SUCCEED != socket_set_nonblocking(accepted_socket))
+	{
+		zbx_set_socket_strerror("failed to set socket non-blocking mode: %s",
+				strerror_from_system(zbx_socket_last_error()));
+		zbx_tcp_unaccept(s);
+		return FAIL;
+	}
 
-		s->connection_type = ZBX_TCP_SEC_UNENCRYPTED;
+	if (SUCCEED != zbx_socket_peer_ip_save(s))
+	{
+		zbx_tcp_unaccept(s);
+		return FAIL;
 	}
 
+	/* socket operations are limited by the caller */
 	zbx_socket_set_deadline(s, 0);
 
-	ret = SUCCEED;
-out:
-	zbx_free(pds);
-
-	return ret;
+	return SUCCEED;
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: close accepted connection                                         *
+ * Purpose: establish security of connection accepted with                    *
+ *          zbx_tcp_accept_start() without blocking                           *
+ *                                                                            *
+ * Parameters: s          - [IN/OUT] socket with accepted connection          *
+ *             tls_accept - [IN] TLS configuration                            *
+ *             event      - [OUT] socket event to wait for                    *
+ *                                                                            *
+ * Return value: SUCCEED - connection is ready for receiving data             *
+ *               FAIL - an error occurred or, if event is set, the function   *
+ *                      must be called again when socket is ready             *
+ *                                                                            *
+ * Comments: The type of connection is detected by its first byte, TLS        *
+ *           handshake is performed if TLS connection is detected.            *
  *                                                                            *
  ******************************************************************************/
-void	zbx_tcp_unaccept(zbx_socket_t *s)
+int	zbx_tcp_accept_check(zbx_socket_t *s, unsigned int tls_accept, short *event)
 {
+	ssize_t	res;
+	char	buf;	/* 1 byte buffer */
+
+	*event = 0;
+
 #if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
-	zbx_tls_close(s);
+	if (NULL != s->tls_ctx)	/* continue TLS handshake */
+		return tcp_accept_secure(s, tls_accept, SUCCEED, event);
 #endif
-	if (!s->accepted) return;
-
-	shutdown(s->socket, 2);
+	if (ZBX_PROTO_ERROR == (res = ZBX_TCP_RECV(s->socket, &buf, 1, MSG_PEEK)))
+	{
+		if (SUCCEED == zbx_socket_had_nonblocking_error())
+		{
+			*event = POLLIN;
+			return FAIL;
+		}
 
-	zbx_socket_free(s);
-	zbx_socket_close(s->socket);
+		zbx_set_socket_strerror("from %s: reading first byte from connection failed: %s", s->peer,
+				strerror_from_system(zbx_socket_last_error()));
+		return FAIL;
+	}
 
-	s->socket = s->socket_orig;	/* restore main socket */
-	s->socket_orig = ZBX_SOCKET_ERROR;
-	s->accepted = 0;
+	/* if the 1st byte is 0x16 then assume it's a TLS connection */
+	return tcp_accept_secure(s, tls_accept, 1 == res && '\x16' == buf ? SUCCEED : FAIL, event);
 }
 
 /******************************************************************************
@@ -1663,7 +2481,7 @@ const char	*zbx_tcp_recv_line(zbx_socket_t *s)
 	s->buffer = s->buf_stat;
 
 	/* read more data into static buffer */
-	if (ZBX_PROTO_ERROR == (nbytes = tcp_read(s, s->buf_stat + left, ZBX_STAT_BUF_LEN - left - 1)))
+	if (ZBX_PROTO_ERROR == (nbytes = tcp_read(s, s->buf_stat + left, ZBX_STAT_BUF_LEN - left - 1, NULL)))
 		goto out;
 
 	s->buf_stat[left + (size_t)nbytes] = '\0';
@@ -1694,7 +2512,7 @@ const char	*zbx_tcp_recv_line(zbx_socket_t *s)
 	/* Lines larger than ZBX_TCP_LINE_LEN bytes will be truncated. */
 	do
 	{
-		if (ZBX_PROTO_ERROR == (nbytes = tcp_read(s, buffer, ZBX_STAT_BUF_LEN - 1)))
+		if (ZBX_PROTO_ERROR == (nbytes = tcp_read(s, buffer, ZBX_STAT_BUF_LEN - 1, NULL)))
 			goto out;
 
 		if (0 == nbytes)
@@ -1743,7 +2561,21 @@ out:
 	return line;
 }
 
-ssize_t	zbx_tcp_read(zbx_socket_t *s, char *buf, size_t len)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: read data from socket                                             *
+ *                                                                            *
+ * Parameters: s     - [IN] socket                                            *
+ *             buf   - [OUT] buffer for data                                  *
+ *             len   - [IN] buffer size                                       *
+ *             event - [OUT] socket event to wait for (optional), if set the  *
+ *                           function does not wait for data and returns      *
+ *                           ZBX_PROTO_ERROR with event set instead           *
+ *                                                                            *
+ * Return value: number of bytes read or ZBX_PROTO_ERROR                      *
+ *                                                                            *
+ ******************************************************************************/
+ssize_t	zbx_tcp_read(zbx_socket_t *s, char *buf, size_t len, short *event)
 {
 #if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
 	ssize_t	res;
@@ -1752,7 +2584,7 @@ ssize_t	zbx_tcp_read(zbx_socket_t *s, char *buf, size_t len)
 	{
 		char	*error = NULL;
 
-		if (ZBX_PROTO_ERROR == (res = zbx_tls_read(s, buf, len, &error)))
+		if (ZBX_PROTO_ERROR == (res = zbx_tls_read(s, buf, len, event, &error)) && NULL != error)
 		{
 			zbx_set_socket_strerror("%s", error);
 			zbx_free(error);
@@ -1761,7 +2593,7 @@ ssize_t	zbx_tcp_read(zbx_socket_t *s, char *buf, size_t len)
 		return res;
 	}
 #endif
-	return tcp_read(s, buf, len);
+	return tcp_read(s, buf, len, event);
 }
 
 /******************************************************************************
@@ -1794,62 +2626,104 @@ int	zbx_socket_check_deadline(zbx_socket_t *s)
 	return zbx_ts_check_deadline(&s->deadline);
 }
 
-/******************************************************************************
- *                                                                            *
- * Purpose: receive data                                                      *
- *                                                                            *
- * Return value: number of bytes received - success,                          *
- *               FAIL - an error occurred                                     *
- *                                                                            *
- ******************************************************************************/
-ssize_t	zbx_tcp_recv_ext(zbx_socket_t *s, int timeout, unsigned char flags)
-{
 #define ZBX_TCP_EXPECT_HEADER		1
 #define ZBX_TCP_EXPECT_VERSION		2
 #define ZBX_TCP_EXPECT_VERSION_VALIDATE	3
 #define ZBX_TCP_EXPECT_LENGTH		4
 #define ZBX_TCP_EXPECT_SIZE		5
 
-	ssize_t		nbytes;
-	size_t		buf_dyn_bytes = 0, buf_stat_bytes = 0, offset = 0;
-	zbx_uint64_t	expected_len = 16 * ZBX_MEBIBYTE, reserved = 0, max_len;
-	unsigned char	expect = ZBX_TCP_EXPECT_HEADER;
-	int		protocol_version;
+/******************************************************************************
+ *                                                                            *
+ * Purpose: initialize context for receiving data                             *
+ *                                                                            *
+ * Parameters: s       - [IN] socket                                          *
+ *             context - [OUT] receive context                                *
+ *             flags   - [IN] protocol flags                                  *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_tcp_recv_context_init(zbx_socket_t *s, zbx_tcp_recv_context_t *context, unsigned char flags)
+{
+	context->buf_dyn_bytes = 0;
+	context->buf_stat_bytes = 0;
+	context->offset = 0;
+	context->expected_len = 16 * ZBX_MEBIBYTE;
+	context->reserved = 0;
+	context->expect = ZBX_TCP_EXPECT_HEADER;
+	context->protocol_version = 0;
 #if defined(_WINDOWS)
-	max_len = ZBX_MAX_RECV_DATA_SIZE;
+	ZBX_UNUSED(flags);
+	context->max_len = ZBX_MAX_RECV_DATA_SIZE;
 #else
-	max_len = 0 != (flags & ZBX_TCP_LARGE) ? ZBX_MAX_RECV_LARGE_DATA_SIZE : ZBX_MAX_RECV_DATA_SIZE;
+	context->max_len = 0 != (flags & ZBX_TCP_LARGE) ? ZBX_MAX_RECV_LARGE_DATA_SIZE : ZBX_MAX_RECV_DATA_SIZE;
 #endif
 	zbx_socket_free(s);
 
 	s->buf_type = ZBX_BUF_TYPE_STAT;
 	s->buffer = s->buf_stat;
+}
 
-	if (0 != timeout)
-		zbx_socket_set_deadline(s, timeout);
+/******************************************************************************
+ *                                                                            *
+ * Purpose: receive data                                                      *
+ *                                                                            *
+ * Parameters: s       - [IN] socket                                          *
+ *             context - [IN/OUT] receive context                             *
+ *             flags   - [IN] protocol flags                                  *
+ *             event   - [OUT] socket event to wait for (optional)            *
+ *                                                                            *
+ * Return value: number of bytes received - success,                          *
+ *               FAIL - an error occurred or, if event is set, the function   *
+ *                      must be called again when socket is ready             *
+ *                                                                            *
+ ******************************************************************************/
+ssize_t	zbx_tcp_recv_context(zbx_socket_t *s, zbx_tcp_recv_context_t *context, unsigned char flags, short *event)
+{
+	ssize_t	nbytes;
+	char	*buf;
+	size_t	size;
 
-	while (0 != (nbytes = zbx_tcp_read(s, s->buf_stat + buf_stat_bytes, sizeof(s->buf_stat) - buf_stat_bytes)))
+	if (NULL != event)
+		*event = 0;
+
+	while (1)
 	{
+		if (ZBX_BUF_TYPE_STAT == s->buf_type)
+		{
+			buf = s->buf_stat + context->buf_stat_bytes;
+			size = sizeof(s->buf_stat) - context->buf_stat_bytes;
+		}
+		else
+		{
+			/* read payload directly into the buffer allocated for the size declared in header, */
+			/* requesting one byte more to detect messages longer than expected */
+			buf = s->buffer + context->buf_dyn_bytes;
+			size = context->expected_len + 1 - context->buf_dyn_bytes;
+		}
+
+		if (0 == (nbytes = zbx_tcp_read(s, buf, size, event)))
+			break;
+
 		if (ZBX_PROTO_ERROR == nbytes)
+		{
+			if (NULL != event && 0 != *event)
+				return FAIL;
+
 			goto out;
+		}
 
 		if (ZBX_BUF_TYPE_STAT == s->buf_type)
-			buf_stat_bytes += (size_t)nbytes;
+			context->buf_stat_bytes += (size_t)nbytes;
 		else
-		{
-			if (buf_dyn_bytes + (size_t)nbytes <= expected_len)
-				memcpy(s->buffer + buf_dyn_bytes, s->buf_stat, (size_t)nbytes);
-			buf_dyn_bytes += (size_t)nbytes;
-		}
+			context->buf_dyn_bytes += (size_t)nbytes;
 
-		if (buf_stat_bytes + buf_dyn_bytes >= expected_len)
+		if (context->buf_stat_bytes + context->buf_dyn_bytes >= context->expected_len)
 			break;
 
-		if (ZBX_TCP_EXPECT_HEADER == expect)
+		if (ZBX_TCP_EXPECT_HEADER == context->expect)
 		{
-			if (ZBX_TCP_HEADER_LEN > buf_stat_bytes)
+			if (ZBX_TCP_HEADER_LEN > context->buf_stat_bytes)
 			{
-				if (0 == strncmp(s->buf_stat, ZBX_TCP_HEADER_DATA, buf_stat_bytes))
+				if (0 == strncmp(s->buf_stat, ZBX_TCP_HEADER_DATA, context->buf_stat_bytes))
 					continue;
 
 				break;
@@ -1862,114 +2736,118 @@ ssize_t	zbx_tcp_recv_ext(zbx_socket_t *s, int timeout, unsigned char flags)
 					break;
 				}
 
-				expect = ZBX_TCP_EXPECT_VERSION;
-				offset += ZBX_TCP_HEADER_LEN;
+				context->expect = ZBX_TCP_EXPECT_VERSION;
+				context->offset += ZBX_TCP_HEADER_LEN;
 			}
 		}
 
-		if (ZBX_TCP_EXPECT_VERSION == expect)
+		if (ZBX_TCP_EXPECT_VERSION == context->expect)
 		{
-			if (offset + 1 > buf_stat_bytes)
+			if (context->offset + 1 > context->buf_stat_bytes)
 				continue;
 
-			expect = ZBX_TCP_EXPECT_VERSION_VALIDATE;
-			protocol_version = s->buf_stat[ZBX_TCP_HEADER_LEN];
+			context->expect = ZBX_TCP_EXPECT_VERSION_VALIDATE;
+			context->protocol_version = s->buf_stat[ZBX_TCP_HEADER_LEN];
 
-			if (0 == (protocol_version & ZBX_TCP_PROTOCOL) ||
-					protocol_version > (ZBX_TCP_PROTOCOL | ZBX_TCP_COMPRESS | flags))
+			if (SUCCEED != tcp_check_protocol_version(context->protocol_version, flags))
 			{
 				/* invalid protocol version, abort receiving */
 				break;
 			}
-			s->protocol = protocol_version;
-			expect = ZBX_TCP_EXPECT_LENGTH;
-			offset++;
+			s->protocol = context->protocol_version;
+			context->expect = ZBX_TCP_EXPECT_LENGTH;
+			context->offset++;
 		}
 
-		if (ZBX_TCP_EXPECT_LENGTH == expect)
+		if (ZBX_TCP_EXPECT_LENGTH == context->expect)
 		{
-			if (0 != (protocol_version & ZBX_TCP_LARGE))
+			if (0 != (context->protocol_version & ZBX_TCP_LARGE))
 			{
 				zbx_uint64_t	len64_le;
 
-				if (offset + 2 * sizeof(len64_le) > buf_stat_bytes)
+				if (context->offset + 2 * sizeof(len64_le) > context->buf_stat_bytes)
 					continue;
 
-				memcpy(&len64_le, s->buf_stat + offset, sizeof(len64_le));
-				offset += sizeof(len64_le);
-				expected_len = zbx_letoh_uint64(len64_le);
+				memcpy(&len64_le, s->buf_stat + context->offset, sizeof(len64_le));
+				context->offset += sizeof(len64_le);
+				context->expected_len = zbx_letoh_uint64(len64_le);
 
-				memcpy(&len64_le, s->buf_stat + offset, sizeof(len64_le));
-				offset += sizeof(len64_le);
-				reserved = zbx_letoh_uint64(len64_le);
+				memcpy(&len64_le, s->buf_stat + context->offset, sizeof(len64_le));
+				context->offset += sizeof(len64_le);
+				context->reserved = zbx_letoh_uint64(len64_le);
 			}
 			else
 			{
 				zbx_uint32_t	len32_le;
 
-				if (offset + 2 * sizeof(len32_le) > buf_stat_bytes)
+				if (context->offset + 2 * sizeof(len32_le) > context->buf_stat_bytes)
 					continue;
 
-				memcpy(&len32_le, s->buf_stat + offset, sizeof(len32_le));
-				offset += sizeof(len32_le);
-				expected_len = zbx_letoh_uint32(len32_le);
+				memcpy(&len32_le, s->buf_stat + context->offset, sizeof(len32_le));
+				context->offset += sizeof(len32_le);
+				context->expected_len = zbx_letoh_uint32(len32_le);
 
-				memcpy(&len32_le, s->buf_stat + offset, sizeof(len32_le));
-				offset += sizeof(len32_le);
-				reserved = zbx_letoh_uint32(len32_le);
+				memcpy(&len32_le, s->buf_stat + context->offset, sizeof(len32_le));
+				context->offset += sizeof(len32_le);
+				context->reserved = zbx_letoh_uint32(len32_le);
 			}
 
-			if (max_len < expected_len)
+			if (context->max_len < context->expected_len)
 			{
 				zabbix_log(LOG_LEVEL_WARNING, "Message size " ZBX_FS_UI64 " from %s exceeds the "
-						"maximum size " ZBX_FS_UI64 " bytes. Message ignored.", expected_len,
-						s->peer, max_len);
+						"maximum size " ZBX_FS_UI64 " bytes. Message ignored.",
+						context->expected_len, s->peer, context->max_len);
 				nbytes = ZBX_PROTO_ERROR;
 				goto out;
 			}
 
 			/* compressed protocol stores uncompressed packet size in the reserved data */
-			if (max_len < reserved)
+			if (context->max_len < context->reserved)
 			{
 				zabbix_log(LOG_LEVEL_WARNING, "Uncompressed message size " ZBX_FS_UI64 " from %s"
 						" exceeds the maximum size " ZBX_FS_UI64 " bytes. Message ignored.",
-						reserved, s->peer, max_len);
+						context->reserved, s->peer, context->max_len);
 				nbytes = ZBX_PROTO_ERROR;
 				goto out;
 			}
 
-			if (sizeof(s->buf_stat) > expected_len)
+			if (sizeof(s->buf_stat) > context->expected_len)
 			{
-				buf_stat_bytes -= offset;
-				memmove(s->buf_stat, s->buf_stat + offset, buf_stat_bytes);
+				context->buf_stat_bytes -= context->offset;
+				memmove(s->buf_stat, s->buf_stat + context->offset, context->buf_stat_bytes);
 			}
 			else
 			{
 				s->buf_type = ZBX_BUF_TYPE_DYN;
-				s->buffer = (char *)zbx_malloc(NULL, expected_len + 1);
-				buf_dyn_bytes = buf_stat_bytes - offset;
-				buf_stat_bytes = 0;
-				memcpy(s->buffer, s->buf_stat + offset, buf_dyn_bytes);
+				s->buffer = (char *)zbx_malloc(NULL, context->expected_len + 1);
+				context->buf_dyn_bytes = context->buf_stat_bytes - context->offset;
+				context->buf_stat_bytes = 0;
+				memcpy(s->buffer, s->buf_stat + context->offset, context->buf_dyn_bytes);
 			}
 
-			expect = ZBX_TCP_EXPECT_SIZE;
+			context->expect = ZBX_TCP_EXPECT_SIZE;
 
-			if (buf_stat_bytes + buf_dyn_bytes >= expected_len)
+			if (context->buf_stat_bytes + context->buf_dyn_bytes >= context->expected_len)
 				break;
 		}
 	}
 
-	if (ZBX_TCP_EXPECT_SIZE == expect)
+	if (ZBX_TCP_EXPECT_SIZE == context->expect)
 	{
-		if (buf_stat_bytes + buf_dyn_bytes == expected_len)
+		if (context->buf_stat_bytes + context->buf_dyn_bytes == context->expected_len)
 		{
-			if (0 != (protocol_version & ZBX_TCP_COMPRESS))
+			if (0 != (context->protocol_version & ZBX_TCP_COMPRESS))
 			{
-				char	*out;
-				size_t	out_size = reserved;
+				char		*out;
+				size_t		out_size = context->reserved;
+				unsigned char	codec = tcp_flags_codec(context->protocol_version);
+				double		time_start;
+
+				time_start = zbx_time();
 
-				out = (char *)zbx_malloc(NULL, reserved + 1);
-				if (FAIL == zbx_uncompress(s->buffer, buf_stat_bytes + buf_dyn_bytes, out, &out_size))
+				out = (char *)zbx_malloc(NULL, context->reserved + 1);
+				if (FAIL == zbx_uncompress_ext(codec, s->buffer, context->buf_stat_bytes +
+						context->buf_dyn_bytes, out, &out_size))
 				{
 					zbx_free(out);
 					zbx_set_socket_strerror("cannot uncompress data: %s", zbx_compress_strerror());
@@ -1977,7 +2855,7 @@ ssize_t	zbx_tcp_recv_ext(zbx_socket_t *s, int timeout, unsigned char flags)
 					goto out;
 				}
 
-				if (out_size != reserved)
+				if (out_size != context->reserved)
 				{
 					zbx_free(out);
 					zbx_set_socket_strerror("size of uncompressed data is less than expected");
@@ -1990,52 +2868,54 @@ ssize_t	zbx_tcp_recv_ext(zbx_socket_t *s, int timeout, unsigned char flags)
 
 				s->buf_type = ZBX_BUF_TYPE_DYN;
 				s->buffer = out;
-				s->read_bytes = reserved;
-
-				zabbix_log(LOG_LEVEL_TRACE, "%s(): received " ZBX_FS_SIZE_T " bytes with"
-						" compression ratio %.1f", __func__,
-						(zbx_fs_size_t)(buf_stat_bytes + buf_dyn_bytes),
-						(double)reserved / (double)(buf_stat_bytes + buf_dyn_bytes));
+				s->read_bytes = context->reserved;
+
+				zabbix_log(LOG_LEVEL_DEBUG, "%s(): received " ZBX_FS_SIZE_T " bytes from %s"
+						" using %s, compression ratio %.1f, time " ZBX_FS_DBL " sec", __func__,
+						(zbx_fs_size_t)(context->buf_stat_bytes + context->buf_dyn_bytes),
+						s->peer, zbx_compress_codec_name(codec), (double)context->reserved /
+						(double)(context->buf_stat_bytes + context->buf_dyn_bytes),
+						zbx_time() - time_start);
 			}
 			else
-				s->read_bytes = buf_stat_bytes + buf_dyn_bytes;
+				s->read_bytes = context->buf_stat_bytes + context->buf_dyn_bytes;
 
 			s->buffer[s->read_bytes] = '\0';
 		}
 		else
 		{
-			if (buf_stat_bytes + buf_dyn_bytes < expected_len)
+			if (context->buf_stat_bytes + context->buf_dyn_bytes < context->expected_len)
 			{
 				zabbix_log(LOG_LEVEL_WARNING, "Message from %s is shorter than expected " ZBX_FS_UI64
-						" bytes. Message ignored.", s->peer, (zbx_uint64_t)expected_len);
+						" bytes. Message ignored.", s->peer, context->expected_len);
 			}
 			else
 			{
 				zabbix_log(LOG_LEVEL_WARNING, "Message from %s is longer than expected " ZBX_FS_UI64
-						" bytes. Message ignored.", s->peer, (zbx_uint64_t)expected_len);
+						" bytes. Message ignored.", s->peer, context->expected_len);
 			}
 
 			nbytes = ZBX_PROTO_ERROR;
 		}
 	}
-	else if (ZBX_TCP_EXPECT_LENGTH == expect)
+	else if (ZBX_TCP_EXPECT_LENGTH == context->expect)
 	{
 		zabbix_log(LOG_LEVEL_WARNING, "Message from %s is missing data length. Message ignored.", s->peer);
 		nbytes = ZBX_PROTO_ERROR;
 	}
-	else if (ZBX_TCP_EXPECT_VERSION == expect)
+	else if (ZBX_TCP_EXPECT_VERSION == context->expect)
 	{
 		zabbix_log(LOG_LEVEL_WARNING, "Message from %s is missing protocol version. Message ignored.",
 				s->peer);
 		nbytes = ZBX_PROTO_ERROR;
 	}
-	else if (ZBX_TCP_EXPECT_VERSION_VALIDATE == expect)
+	else if (ZBX_TCP_EXPECT_VERSION_VALIDATE == context->expect)
 	{
 		zabbix_log(LOG_LEVEL_WARNING, "Message from %s is using unsupported protocol version \"%d\"."
-				" Message ignored.", s->peer, protocol_version);
+				" Message ignored.", s->peer, context->protocol_version);
 		nbytes = ZBX_PROTO_ERROR;
 	}
-	else if (0 != buf_stat_bytes)
+	else if (0 != context->buf_stat_bytes)
 	{
 		zabbix_log(LOG_LEVEL_WARNING, "Message from %s is missing header. Message ignored.", s->peer);
 		nbytes = ZBX_PROTO_ERROR;
@@ -2046,14 +2926,39 @@ ssize_t	zbx_tcp_recv_ext(zbx_socket_t *s, int timeout, unsigned char flags)
 		s->buffer[s->read_bytes] = '\0';
 	}
 out:
-	if (0 != timeout)
-		zbx_socket_set_deadline(s, 0);
-
-	return (ZBX_PROTO_ERROR == nbytes ? FAIL : (ssize_t)(s->read_bytes + offset));
+	return (ZBX_PROTO_ERROR == nbytes ? FAIL : (ssize_t)(s->read_bytes + context->offset));
+}
 
 #undef ZBX_TCP_EXPECT_HEADER
+#undef ZBX_TCP_EXPECT_VERSION
+#undef ZBX_TCP_EXPECT_VERSION_VALIDATE
 #undef ZBX_TCP_EXPECT_LENGTH
 #undef ZBX_TCP_EXPECT_SIZE
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: receive data                                                      *
+ *                                                                            *
+ * Return value: number of bytes received - success,                          *
+ *               FAIL - an error occurred                                     *
+ *                                                                            *
+ ******************************************************************************/
+ssize_t	zbx_tcp_recv_ext(zbx_socket_t *s, int timeout, unsigned char flags)
+{
+	zbx_tcp_recv_context_t	context;
+	ssize_t			ret;
+
+	zbx_tcp_recv_context_init(s, &context, flags);
+
+	if (0 != timeout)
+		zbx_socket_set_deadline(s, timeout);
+
+	ret = zbx_tcp_recv_context(s, &context, flags, NULL);
+
+	if (0 != timeout)
+		zbx_socket_set_deadline(s, 0);
+
+	return ret;
 }
 
 /******************************************************************************
@@ -2078,7 +2983,8 @@ ssize_t	zbx_tcp_recv_raw_ext(zbx_socket_t *s, int timeout)
 	if (0 != timeout)
 		zbx_socket_set_deadline(s, timeout);
 
-	while (0 != (nbytes = zbx_tcp_read(s, s->buf_stat + buf_stat_bytes, sizeof(s->buf_stat) - buf_stat_bytes)))
+	while (0 != (nbytes = zbx_tcp_read(s, s->buf_stat + buf_stat_bytes, sizeof(s->buf_stat) - buf_stat_bytes,
+			NULL)))
 	{
 		if (ZBX_PROTO_ERROR == nbytes)
 			goto out;
@@ -2317,26 +3223,59 @@ int	zbx_validate_peer_list(const char *peer_list, char **error)
 	return SUCCEED;
 }
 
+/* allowed peer list entry with resolved addresses */
+typedef struct
+{
+	int		prefix_size;	/* CIDR prefix size or -1 for single addresses */
+	struct addrinfo	*ai;
+}
+zbx_allowed_peer_t;
+
+ZBX_PTR_VECTOR_DECL(allowed_peer_ptr, zbx_allowed_peer_t *)
+ZBX_PTR_VECTOR_IMPL(allowed_peer_ptr, zbx_allowed_peer_t *)
+
+/* compiled allowed peer list cache entry */
+typedef struct
+{
+	char				*peer_list;
+	time_t				expires;	/* time to resolve DNS names again, 0 if there are none */
+	time_t				lastaccess;
+	zbx_vector_allowed_peer_ptr_t	peers;
+}
+zbx_allowed_peers_entry_t;
+
+#define ZBX_ALLOWED_PEERS_DNS_TTL	SEC_PER_MIN
+#define ZBX_ALLOWED_PEERS_PURGE_AGE	SEC_PER_HOUR
+
+/* The cache is process local and is disabled by default, it is enabled by single threaded processes */
+/* that accept connections and check the same peer lists repeatedly.                                 */
+static int		allowed_peers_cache_enabled = 0;
+static zbx_hashset_t	allowed_peers_cache;
+static time_t		allowed_peers_purge_time;
+
+static void	allowed_peer_free(zbx_allowed_peer_t *peer)
+{
+	if (NULL != peer->ai)
+		freeaddrinfo(peer->ai);
+
+	zbx_free(peer);
+}
+
 /******************************************************************************
  *                                                                            *
- * Purpose: check if connection initiator is in list of peers                 *
- *                                                                            *
- * Parameters: s         - [IN] socket descriptor                             *
- *             peer_list - [IN] comma-delimited list of allowed peers.        *
- *                              NULL not allowed. Empty string results in     *
- *                              return value FAIL.                            *
+ * Purpose: parse list of allowed peers and resolve its addresses             *
  *                                                                            *
- * Return value: SUCCEED - connection allowed                                 *
- *               FAIL - connection is not allowed                             *
+ * Parameters: peer_list - [IN] comma-delimited list of allowed peers         *
+ *             peers     - [OUT] resolved peers                               *
  *                                                                            *
- * Comments: standard, compatible and IPv4-mapped addresses are treated       *
- *           the same: 127.0.0.1 == ::127.0.0.1 == ::ffff:127.0.0.1           *
+ * Return value: SUCCEED - list contains DNS names                            *
+ *               FAIL    - list contains only IP addresses                    *
  *                                                                            *
  ******************************************************************************/
-int	zbx_tcp_check_allowed_peers(const zbx_socket_t *s, const char *peer_list)
+static int	allowed_peers_compile(const char *peer_list, zbx_vector_allowed_peer_ptr_t *peers)
 {
 	char	*start = NULL, *end = NULL, *cidr_sep, tmp[MAX_STRING_LEN];
-	int	prefix_size;
+	int	prefix_size, ret = FAIL;
 
 	/* examine list of allowed peers which may include DNS names, IPv4/6 addresses and addresses in CIDR notation */
 
@@ -2344,7 +3283,7 @@ int	zbx_tcp_check_allowed_peers(const zbx_socket_t *s, const char *peer_list)
 
 	for (start = tmp; '\0' != *start;)
 	{
-		struct addrinfo	hints, *ai = NULL, *current_ai;
+		struct addrinfo	hints, *ai = NULL;
 
 		prefix_size = -1;
 
@@ -2360,6 +3299,9 @@ int	zbx_tcp_check_allowed_peers(const zbx_socket_t *s, const char *peer_list)
 				*cidr_sep = '/';	/* CIDR is only supported for IP */
 		}
 
+		if (SUCCEED != zbx_is_ip(start))
+			ret = SUCCEED;
+
 		memset(&hints, 0, sizeof(hints));
 		hints.ai_family = AF_UNSPEC;
 		hints.ai_socktype = SOCK_STREAM;
@@ -2367,24 +3309,12 @@ int	zbx_tcp_check_allowed_peers(const zbx_socket_t *s, const char *peer_list)
 
 		if (0 == getaddrinfo(start, NULL, &hints, &ai))
 		{
-			for (current_ai = ai; NULL != current_ai; current_ai = current_ai->ai_next)
-			{
-				int	prefix_size_current = prefix_size;
-
-				if (-1 == prefix_size_current)
-				{
-					prefix_size_current = (current_ai->ai_family == AF_INET ?
-							ZBX_IPV4_MAX_CIDR_PREFIX : ZBX_IPV6_MAX_CIDR_PREFIX);
-				}
+			zbx_allowed_peer_t	*peer;
 
-				if (SUCCEED == zbx_ip_cmp((unsigned int)prefix_size_current, current_ai, s->peer_info,
-						0))
-				{
-					freeaddrinfo(ai);
-					return SUCCEED;
-				}
-			}
-			freeaddrinfo(ai);
+			peer = (zbx_allowed_peer_t *)zbx_malloc(NULL, sizeof(zbx_allowed_peer_t));
+			peer->prefix_size = prefix_size;
+			peer->ai = ai;
+			zbx_vector_allowed_peer_ptr_append(peers, peer);
 		}
 
 		if (NULL != end)
@@ -2393,11 +3323,178 @@ int	zbx_tcp_check_allowed_peers(const zbx_socket_t *s, const char *peer_list)
 			break;
 	}
 
-	zbx_set_socket_strerror("connection from \"%s\" rejected, allowed hosts: \"%s\"", s->peer, peer_list);
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: check if connection initiator matches any of resolved peers       *
+ *                                                                            *
+ ******************************************************************************/
+static int	allowed_peers_match(const zbx_vector_allowed_peer_ptr_t *peers, const zbx_socket_t *s)
+{
+	int	i;
+
+	for (i = 0; i < peers->values_num; i++)
+	{
+		const struct addrinfo	*current_ai;
+
+		for (current_ai = peers->values[i]->ai; NULL != current_ai; current_ai = current_ai->ai_next)
+		{
+			int	prefix_size_current = peers->values[i]->prefix_size;
+
+			if (-1 == prefix_size_current)
+			{
+				prefix_size_current = (current_ai->ai_family == AF_INET ?
+						ZBX_IPV4_MAX_CIDR_PREFIX : ZBX_IPV6_MAX_CIDR_PREFIX);
+			}
+
+			if (SUCCEED == zbx_ip_cmp((unsigned int)prefix_size_current, current_ai, s->peer_info, 0))
+				return SUCCEED;
+		}
+	}
 
 	return FAIL;
 }
 
+static zbx_hash_t	allowed_peers_hash_func(const void *data)
+{
+	const zbx_allowed_peers_entry_t	*entry = (const zbx_allowed_peers_entry_t *)data;
+
+	return ZBX_DEFAULT_STRING_HASH_ALGO(entry->peer_list, strlen(entry->peer_list), ZBX_DEFAULT_HASH_SEED);
+}
+
+static void	allowed_peers_entry_clean(void *data)
+{
+	zbx_allowed_peers_entry_t	*entry = (zbx_allowed_peers_entry_t *)data;
+
+	zbx_free(entry->peer_list);
+	zbx_vector_allowed_peer_ptr_clear_ext(&entry->peers, allowed_peer_free);
+	zbx_vector_allowed_peer_ptr_destroy(&entry->peers);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: enable compiled allowed peer list cache for incoming connections  *
+ *          of the current process                                            *
+ *                                                                            *
+ * Comments: Peer lists are parsed and resolved once and reused for the       *
+ *           following checks. Lists with DNS names are resolved again after  *
+ *           ZBX_ALLOWED_PEERS_DNS_TTL seconds, lists that were not used for  *
+ *           ZBX_ALLOWED_PEERS_PURGE_AGE seconds are removed.                 *
+ *           The cache is not thread safe.                                    *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_tcp_allowed_peers_cache_enable(void)
+{
+	if (0 != allowed_peers_cache_enabled)
+		return;
+
+	zbx_hashset_create_ext(&allowed_peers_cache, 10, allowed_peers_hash_func, ZBX_DEFAULT_STR_COMPARE_FUNC,
+			allowed_peers_entry_clean, ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC,
+			ZBX_DEFAULT_MEM_FREE_FUNC);
+
+	allowed_peers_purge_time = time(NULL);
+	allowed_peers_cache_enabled = 1;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get compiled allowed peer list from cache, compiling it if        *
+ *          necessary                                                         *
+ *                                                                            *
+ ******************************************************************************/
+static const zbx_vector_allowed_peer_ptr_t	*allowed_peers_cache_get(const char *peer_list)
+{
+	zbx_allowed_peers_entry_t	*entry, entry_local;
+	time_t				now;
+
+	now = time(NULL);
+
+	if (ZBX_ALLOWED_PEERS_PURGE_AGE <= now - allowed_peers_purge_time)
+	{
+		zbx_hashset_iter_t	iter;
+
+		zbx_hashset_iter_reset(&allowed_peers_cache, &iter);
+		while (NULL != (entry = (zbx_allowed_peers_entry_t *)zbx_hashset_iter_next(&iter)))
+		{
+			if (ZBX_ALLOWED_PEERS_PURGE_AGE <= now - entry->lastaccess)
+				zbx_hashset_iter_remove(&iter);
+		}
+
+		allowed_peers_purge_time = now;
+	}
+
+	entry_local.peer_list = (char *)peer_list;
+
+	if (NULL == (entry = (zbx_allowed_peers_entry_t *)zbx_hashset_search(&allowed_peers_cache, &entry_local)))
+	{
+		entry_local.peer_list = zbx_strdup(NULL, peer_list);
+		entry_local.expires = 0;
+		zbx_vector_allowed_peer_ptr_create(&entry_local.peers);
+
+		entry = (zbx_allowed_peers_entry_t *)zbx_hashset_insert(&allowed_peers_cache, &entry_local,
+				sizeof(entry_local));
+	}
+	else if (0 == entry->expires || now < entry->expires)
+		goto out;
+	else
+		zbx_vector_allowed_peer_ptr_clear_ext(&entry->peers, allowed_peer_free);
+
+	if (SUCCEED == allowed_peers_compile(peer_list, &entry->peers))
+		entry->expires = now + ZBX_ALLOWED_PEERS_DNS_TTL;
+	else
+		entry->expires = 0;
+out:
+	entry->lastaccess = now;
+
+	return &entry->peers;
+}
+
+#undef ZBX_ALLOWED_PEERS_DNS_TTL
+#undef ZBX_ALLOWED_PEERS_PURGE_AGE
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: check if connection initiator is in list of peers                 *
+ *                                                                            *
+ * Parameters: s         - [IN] socket descriptor                             *
+ *             peer_list - [IN] comma-delimited list of allowed peers.        *
+ *                              NULL not allowed. Empty string results in     *
+ *                              return value FAIL.                            *
+ *                                                                            *
+ * Return value: SUCCEED - connection allowed                                 *
+ *               FAIL - connection is not allowed                             *
+ *                                                                            *
+ * Comments: standard, compatible and IPv4-mapped addresses are treated       *
+ *           the same: 127.0.0.1 == ::127.0.0.1 == ::ffff:127.0.0.1           *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_tcp_check_allowed_peers(const zbx_socket_t *s, const char *peer_list)
+{
+	int	ret;
+
+	if (0 != allowed_peers_cache_enabled)
+	{
+		ret = allowed_peers_match(allowed_peers_cache_get(peer_list), s);
+	}
+	else
+	{
+		zbx_vector_allowed_peer_ptr_t	peers;
+
+		zbx_vector_allowed_peer_ptr_create(&peers);
+		allowed_peers_compile(peer_list, &peers);
+		ret = allowed_peers_match(&peers, s);
+		zbx_vector_allowed_peer_ptr_clear_ext(&peers, allowed_peer_free);
+		zbx_vector_allowed_peer_ptr_destroy(&peers);
+	}
+
+	if (SUCCEED != ret)
+		zbx_set_socket_strerror("connection from \"%s\" rejected, allowed hosts: \"%s\"", s->peer, peer_list);
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: translate connection type code to name                            *
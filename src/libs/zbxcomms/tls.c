@@ -32,6 +32,10 @@
 #include "zbxstr.h"
 #include "zbxtime.h"
 
+#if defined(HAVE_GNUTLS)
+#	include <gnutls/crypto.h>
+#endif
+
 #if defined(HAVE_OPENSSL) && OPENSSL_VERSION_NUMBER < 0x1010000fL || defined(LIBRESSL_VERSION_NUMBER)
 /* for OpenSSL 1.0.1/1.0.2 (before 1.1.0) or LibreSSL */
 
@@ -200,11 +204,24 @@ static ZBX_THREAD_LOCAL size_t		my_psk_len		= 0;
 /* but other components (e.g. agent) do not link dbconfig.o. */
 size_t	(*find_psk_in_cache)(const unsigned char *, unsigned char *, unsigned int *) = NULL;
 
-/* variable for passing information from callback functions if PSK was found among host PSKs or autoregistration PSK */
-static unsigned int	psk_usage;
-
 static zbx_tls_status_t	tls_status = ZBX_TLS_INIT_NONE;
 
+/* Certificate based sessions are resumed with session tickets. Ticket key is generated by parent process, */
+/* so tickets issued by one child process are accepted by others. PSK sessions are not resumed because    */
+/* PSK must be looked up on each handshake.                                                                */
+#if defined(HAVE_OPENSSL) && OPENSSL_VERSION_NUMBER >= 0x1010100fL && !defined(LIBRESSL_VERSION_NUMBER)
+#	define ZBX_TLS_SESSION_RESUMPTION
+#	define ZBX_TLS_TICKET_KEY_LEN	80	/* ticket key name, HMAC secret and AES key */
+#elif defined(HAVE_GNUTLS) && GNUTLS_VERSION_NUMBER >= 0x030600
+#	define ZBX_TLS_SESSION_RESUMPTION
+#	define ZBX_TLS_TICKET_KEY_LEN	64	/* ticket master key */
+#endif
+
+#if defined(ZBX_TLS_SESSION_RESUMPTION)
+static unsigned char	ticket_key[ZBX_TLS_TICKET_KEY_LEN];
+static int		ticket_key_set = 0;
+#endif
+
 #if defined(HAVE_GNUTLS)
 static ZBX_THREAD_LOCAL gnutls_certificate_credentials_t	my_cert_creds		= NULL;
 static ZBX_THREAD_LOCAL gnutls_psk_client_credentials_t		my_psk_client_creds	= NULL;
@@ -224,11 +241,6 @@ static ZBX_THREAD_LOCAL size_t			psk_identity_len_for_cb	= 0;
 static ZBX_THREAD_LOCAL char			*psk_for_cb		= NULL;
 static ZBX_THREAD_LOCAL size_t			psk_len_for_cb		= 0;
 #endif
-#ifdef HAVE_OPENSSL_WITH_PSK
-/* variables for capturing PSK identity from server callback function */
-static ZBX_THREAD_LOCAL int			incoming_connection_has_psk = 0;
-static ZBX_THREAD_LOCAL char			incoming_connection_psk_id[PSK_MAX_IDENTITY_LEN + 1];
-#endif
 /* buffer for messages produced by zbx_openssl_info_cb() */
 ZBX_THREAD_LOCAL char				info_buf[256];
 #endif
@@ -367,6 +379,18 @@ static int	tls_is_nonblocking_error(ssize_t err)
 	return FAIL;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get socket event required to continue unfinished operation        *
+ *                                                                            *
+ ******************************************************************************/
+static short	tls_get_event(gnutls_session_t session, ssize_t err)
+{
+	ZBX_UNUSED(err);
+
+	return (0 == gnutls_record_get_direction(session) ? POLLIN : POLLOUT);
+}
+
 #endif
 
 #if defined(HAVE_OPENSSL)
@@ -421,6 +445,18 @@ static int	tls_is_nonblocking_error(ssize_t err)
 	return FAIL;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get socket event required to continue unfinished operation        *
+ *                                                                            *
+ ******************************************************************************/
+static short	tls_get_event(SSL *ctx, ssize_t ssl_err)
+{
+	ZBX_UNUSED(ctx);
+
+	return (SSL_ERROR_WANT_READ == ssl_err ? POLLIN : POLLOUT);
+}
+
 #endif
 
 /******************************************************************************
@@ -473,7 +509,7 @@ static void	zbx_psk_warn_misconfig(const char *psk_identity)
  *     find and set the requested pre-shared key upon GnuTLS request          *
  *                                                                            *
  * Parameters:                                                                *
- *     session      - [IN] not used                                           *
+ *     session      - [IN] TLS session of the incoming connection             *
  *     psk_identity - [IN] PSK identity for which the PSK should be searched  *
  *                         and set                                            *
  *     key          - [OUT pre-shared key allocated and set                   *
@@ -489,17 +525,15 @@ static void	zbx_psk_warn_misconfig(const char *psk_identity)
  ******************************************************************************/
 static int	zbx_psk_cb(gnutls_session_t session, const char *psk_identity, gnutls_datum_t *key)
 {
-	char		*psk;
-	size_t		psk_len = 0;
-	int		psk_bin_len;
-	unsigned char	tls_psk_hex[HOST_TLS_PSK_LEN_MAX], psk_buf[HOST_TLS_PSK_LEN / 2];
-
-	ZBX_UNUSED(session);
+	char			*psk;
+	size_t			psk_len = 0;
+	int			psk_bin_len;
+	unsigned char		tls_psk_hex[HOST_TLS_PSK_LEN_MAX], psk_buf[HOST_TLS_PSK_LEN / 2];
+	unsigned int		psk_usage = 0;
+	zbx_tls_context_t	*tls_ctx = (zbx_tls_context_t *)gnutls_session_get_ptr(session);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "%s() requested PSK identity \"%s\"", __func__, psk_identity);
 
-	psk_usage = 0;
-
 	if (0 != (zbx_get_program_type_cb() & (ZBX_PROGRAM_TYPE_PROXY | ZBX_PROGRAM_TYPE_SERVER)))
 	{
 		/* call the function zbx_dc_get_psk_by_identity() by pointer */
@@ -571,6 +605,10 @@ static int	zbx_psk_cb(gnutls_session_t session, const char *psk_identity, gnutls
 		memcpy(key->data, psk, psk_len);
 		key->size = (unsigned int)psk_len;
 
+		/* PSK usage is kept in connection context, other connections can be accepted */
+		/* before this one is processed */
+		tls_ctx->psk_usage = psk_usage;
+
 		return 0;	/* success */
 	}
 
@@ -637,7 +675,7 @@ static unsigned int	zbx_psk_client_cb(SSL *ssl, const char *hint, char *identity
  *     set pre-shared key for incoming TLS connection upon OpenSSL request    *
  *                                                                            *
  * Parameters:                                                                *
- *     ssl              - [IN] not used                                       *
+ *     ssl              - [IN] TLS connection                                 *
  *     identity         - [IN] PSK identity sent by client                    *
  *     psk              - [OUT] buffer to write PSK into                      *
  *     max_psk_len      - [IN] size of the 'psk' buffer                       *
@@ -654,18 +692,15 @@ static unsigned int	zbx_psk_client_cb(SSL *ssl, const char *hint, char *identity
 static unsigned int	zbx_psk_server_cb(SSL *ssl, const char *identity, unsigned char *psk,
 		unsigned int max_psk_len)
 {
-	const char	*psk_loc;
-	size_t		psk_len = 0;
-	int		psk_bin_len;
-	unsigned char	tls_psk_hex[HOST_TLS_PSK_LEN_MAX], psk_buf[HOST_TLS_PSK_LEN / 2];
-
-	ZBX_UNUSED(ssl);
+	const char		*psk_loc;
+	size_t			psk_len = 0;
+	int			psk_bin_len;
+	unsigned char		tls_psk_hex[HOST_TLS_PSK_LEN_MAX], psk_buf[HOST_TLS_PSK_LEN / 2];
+	unsigned int		psk_usage = 0;
+	zbx_tls_context_t	*tls_ctx = (zbx_tls_context_t *)SSL_get_app_data(ssl);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "%s() requested PSK identity \"%s\"", __func__, identity);
 
-	incoming_connection_has_psk = 1;
-	psk_usage = 0;
-
 	if (0 != (zbx_get_program_type_cb() & (ZBX_PROGRAM_TYPE_PROXY | ZBX_PROGRAM_TYPE_SERVER)))
 	{
 		/* call the function zbx_dc_get_psk_by_identity() by pointer */
@@ -736,12 +771,16 @@ static unsigned int	zbx_psk_server_cb(SSL *ssl, const char *identity, unsigned c
 		}
 
 		memcpy(psk, psk_loc, psk_len);
-		zbx_strlcpy(incoming_connection_psk_id, identity, sizeof(incoming_connection_psk_id));
+
+		/* PSK identity and usage are kept in connection context, other connections can be */
+		/* accepted before this one is processed */
+		tls_ctx->psk_identity = zbx_strdup(tls_ctx->psk_identity, identity);
+		tls_ctx->psk_usage = psk_usage;
 
 		return (unsigned int)psk_len;	/* success */
 	}
 fail:
-	incoming_connection_psk_id[0] = '\0';
+	zbx_free(tls_ctx->psk_identity);
 	return 0;	/* PSK not found */
 }
 #endif
@@ -1672,6 +1711,46 @@ void	zbx_tls_library_deinit(zbx_tls_status_t status)
 #endif
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: generate session ticket key to be inherited by child processes    *
+ *                                                                            *
+ * Parameters: error - [OUT] error message                                    *
+ *                                                                            *
+ * Return value: SUCCEED - the key was generated or resumption is not         *
+ *                         supported by TLS library                           *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_tls_ticket_key_init(char **error)
+{
+#if defined(ZBX_TLS_SESSION_RESUMPTION)
+#if defined(HAVE_GNUTLS)
+	int	res;
+#endif
+	if (0 != ticket_key_set)
+		return SUCCEED;
+#if defined(HAVE_GNUTLS)
+	if (GNUTLS_E_SUCCESS != (res = gnutls_rnd(GNUTLS_RND_KEY, ticket_key, sizeof(ticket_key))))
+	{
+		*error = zbx_dsprintf(*error, "cannot generate TLS session ticket key: %d %s", res,
+				gnutls_strerror(res));
+		return FAIL;
+	}
+#elif defined(HAVE_OPENSSL)
+	if (1 != RAND_bytes(ticket_key, sizeof(ticket_key)))
+	{
+		*error = zbx_strdup(*error, "cannot generate TLS session ticket key");
+		return FAIL;
+	}
+#endif
+	ticket_key_set = 1;
+#else
+	ZBX_UNUSED(error);
+#endif
+	return SUCCEED;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: initialize TLS library in a parent process                        *
@@ -1679,9 +1758,17 @@ void	zbx_tls_library_deinit(zbx_tls_status_t status)
  ******************************************************************************/
 void	zbx_tls_init_parent(zbx_get_program_type_f zbx_get_program_type_cb_arg)
 {
+	char	*error = NULL;
+
 	zbx_get_program_type_cb = zbx_get_program_type_cb_arg;
 
 	zbx_tls_library_init(ZBX_TLS_INIT_THREADS);
+
+	if (SUCCEED != zbx_tls_ticket_key_init(&error))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "%s, TLS sessions will not be resumed", error);
+		zbx_free(error);
+	}
 }
 
 /******************************************************************************
@@ -2011,6 +2098,131 @@ static int	zbx_set_ecdhe_parameters(SSL_CTX *ctx)
 	return ret;
 }
 
+#if defined(ZBX_TLS_SESSION_RESUMPTION)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: decide whether session from decrypted ticket can be resumed       *
+ *                                                                            *
+ * Comments:                                                                  *
+ *     A callback function, its arguments are defined in OpenSSL.             *
+ *     Sessions without peer certificate were authenticated with PSK, they    *
+ *     are not resumed so that PSK is looked up on each handshake.            *
+ *                                                                            *
+ ******************************************************************************/
+static SSL_TICKET_RETURN	zbx_openssl_ticket_decrypt_cb(SSL *ssl, SSL_SESSION *session,
+		const unsigned char *keyname, size_t keyname_length, SSL_TICKET_STATUS status, void *arg)
+{
+	ZBX_UNUSED(ssl);
+	ZBX_UNUSED(keyname);
+	ZBX_UNUSED(keyname_length);
+	ZBX_UNUSED(arg);
+
+	switch (status)
+	{
+		case SSL_TICKET_EMPTY:
+		case SSL_TICKET_NO_DECRYPT:
+			return SSL_TICKET_RETURN_IGNORE_RENEW;
+		case SSL_TICKET_SUCCESS:
+		case SSL_TICKET_SUCCESS_RENEW:
+			if (NULL == SSL_SESSION_get0_peer(session))
+				return SSL_TICKET_RETURN_IGNORE;
+
+			return SSL_TICKET_SUCCESS == status ? SSL_TICKET_RETURN_USE : SSL_TICKET_RETURN_USE_RENEW;
+		default:
+			return SSL_TICKET_RETURN_ABORT;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: restore cached session of outgoing connection before handshake    *
+ *                                                                            *
+ ******************************************************************************/
+static void	zbx_openssl_session_restore(zbx_tls_context_t *tls_ctx)
+{
+	unsigned char		data[ZBX_TLS_SESSION_DATA_MAX];
+	const unsigned char	*ptr = data;
+	size_t			data_len;
+	SSL_SESSION		*session;
+
+	if (0 == (data_len = zbx_tls_session_get(tls_ctx->session_key, data, sizeof(data))))
+		return;
+
+	if (NULL == (session = d2i_SSL_SESSION(NULL, &ptr, (long)data_len)))
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "cannot restore cached TLS session");
+		return;
+	}
+
+	if (1 != SSL_set_session(tls_ctx->ctx, session))
+		zabbix_log(LOG_LEVEL_DEBUG, "cannot set cached TLS session");
+
+	SSL_SESSION_free(session);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: cache the latest session of outgoing connection                   *
+ *                                                                            *
+ * Comments: TLS 1.3 tickets are received after handshake, so the session is  *
+ *           cached when connection is being closed.                          *
+ *                                                                            *
+ ******************************************************************************/
+static void	zbx_openssl_session_save(const zbx_tls_context_t *tls_ctx)
+{
+	unsigned char	data[ZBX_TLS_SESSION_DATA_MAX], *ptr = data;
+	int		data_len, lifetime;
+	SSL_SESSION	*session;
+
+	if (NULL == (session = SSL_get1_session(tls_ctx->ctx)))
+		return;
+
+	lifetime = (int)(SSL_SESSION_get_time(session) + SSL_SESSION_get_timeout(session) - time(NULL));
+
+	if (1 == SSL_SESSION_is_resumable(session) && 0 < lifetime &&
+			0 < (data_len = i2d_SSL_SESSION(session, NULL)) && (int)sizeof(data) >= data_len)
+	{
+		i2d_SSL_SESSION(session, &ptr);
+		zbx_tls_session_put(tls_ctx->session_key, data, (size_t)data_len,
+				MIN(lifetime, ZBX_TLS_SESSION_LIFETIME));
+	}
+
+	SSL_SESSION_free(session);
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: enable resumption of certificate based sessions with tickets      *
+ *          encrypted by the key shared by all processes                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	zbx_openssl_tickets_enable(SSL_CTX *ctx)
+{
+#if defined(ZBX_TLS_SESSION_RESUMPTION)
+	if (0 == ticket_key_set)
+		return;
+
+	if (1 != SSL_CTX_set_tlsext_ticket_keys(ctx, ticket_key, sizeof(ticket_key)))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot set TLS session ticket key, TLS sessions will not be resumed");
+		return;
+	}
+
+	if (1 != SSL_CTX_set_session_ticket_cb(ctx, NULL, zbx_openssl_ticket_decrypt_cb, NULL))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot set TLS session ticket callback, TLS sessions will not be"
+				" resumed");
+		return;
+	}
+
+	SSL_CTX_set_timeout(ctx, ZBX_TLS_SESSION_LIFETIME);
+	SSL_CTX_clear_options(ctx, SSL_OP_NO_TICKET);
+#else
+	ZBX_UNUSED(ctx);
+#endif
+}
+
 void	zbx_tls_init_child(const zbx_config_tls_t *config_tls, zbx_get_program_type_f zbx_get_program_type_cb_arg)
 {
 #define ZBX_CIPHERS_CERT_ECDHE		"EECDH+aRSA+AES128:"
@@ -2294,8 +2506,9 @@ void	zbx_tls_init_child(const zbx_config_tls_t *config_tls, zbx_get_program_type
 		/* do not connect to unpatched servers */
 		SSL_CTX_clear_options(ctx_cert, SSL_OP_LEGACY_SERVER_CONNECT);
 
-		/* disable session caching */
+		/* disable session caching, sessions are resumed only with tickets */
 		SSL_CTX_set_session_cache_mode(ctx_cert, SSL_SESS_CACHE_OFF);
+		zbx_openssl_tickets_enable(ctx_cert);
 
 		/* try to enable ECDH ciphersuites */
 		if (SUCCEED == zbx_set_ecdhe_parameters(ctx_cert))
@@ -2464,6 +2677,7 @@ void	zbx_tls_init_child(const zbx_config_tls_t *config_tls, zbx_get_program_type
 		SSL_CTX_set_options(ctx_all, SSL_OP_CIPHER_SERVER_PREFERENCE | SSL_OP_NO_TICKET);
 		SSL_CTX_clear_options(ctx_all, SSL_OP_LEGACY_SERVER_CONNECT);
 		SSL_CTX_set_session_cache_mode(ctx_all, SSL_SESS_CACHE_OFF);
+		zbx_openssl_tickets_enable(ctx_all);
 
 		if (SUCCEED == zbx_set_ecdhe_parameters(ctx_all))
 			ciphers = ZBX_CIPHERS_CERT_ECDHE ZBX_CIPHERS_CERT ":" ZBX_CIPHERS_PSK_ECDHE ZBX_CIPHERS_PSK;
@@ -2694,18 +2908,28 @@ void	zbx_tls_free(void)
  *                        (in hex-string) to connect with depending on value  *
  *                        of 'tls_connect'.                                   *
  *     server_name - [IN] optional server name indication for TLS             *
- *     timeout     - [IN] the connection timeout                              *
+ *     event       - [OUT] socket event the handshake is waiting for in       *
+ *                         non-blocking mode (optional)                       *
  *                                                                            *
  * Return value:                                                              *
  *     SUCCEED - successful TLS handshake with a valid certificate or PSK     *
- *     FAIL - an error occurred                                               *
+ *     FAIL - an error occurred or, if event is set, the handshake must be    *
+ *            continued by calling this function again when the socket is     *
+ *            ready                                                           *
+ *                                                                            *
+ * Comments: If event is NULL the function waits for the handshake to finish  *
+ *           until socket deadline is reached.                                *
  *                                                                            *
  ******************************************************************************/
 #if defined(HAVE_GNUTLS)
 int	zbx_tls_connect(zbx_socket_t *s, unsigned int tls_connect, const char *tls_arg1, const char *tls_arg2,
-		const char *server_name, char **error)
+		const char *server_name, short *event, char **error)
 {
-	int	ret = FAIL, res;
+	int		ret = FAIL, res;
+	unsigned int	flags;
+
+	if (NULL != s->tls_ctx)	/* continue non-blocking handshake */
+		goto handshake;
 
 	if (ZBX_TCP_SEC_TLS_CERT == tls_connect)
 	{
@@ -2727,12 +2951,19 @@ int	zbx_tls_connect(zbx_socket_t *s, unsigned int tls_connect, const char *tls_a
 
 	s->tls_ctx = zbx_malloc(s->tls_ctx, sizeof(zbx_tls_context_t));
 	s->tls_ctx->ctx = NULL;
+	s->tls_ctx->session_key = 0;
 	s->tls_ctx->psk_client_creds = NULL;
 	s->tls_ctx->psk_server_creds = NULL;
 
-	if (GNUTLS_E_SUCCESS != (res = gnutls_init(&s->tls_ctx->ctx, GNUTLS_CLIENT | GNUTLS_NO_EXTENSIONS)))
+	flags = GNUTLS_CLIENT | GNUTLS_NO_EXTENSIONS;
+#if defined(ZBX_TLS_SESSION_RESUMPTION)
+	/* extensions are needed to resume certificate based sessions with tickets */
+	if (ZBX_TCP_SEC_TLS_CERT == tls_connect && SUCCEED == zbx_tls_session_cache_enabled())
+		flags = GNUTLS_CLIENT;
+#endif
+	if (GNUTLS_E_SUCCESS != (res = gnutls_init(&s->tls_ctx->ctx, flags)))
 			/* GNUTLS_NO_EXTENSIONS is used because we do not currently support extensions (e.g. session */
-			/* tickets and OCSP) */
+			/* tickets and OCSP) unless certificate based sessions are cached */
 	{
 		*error = zbx_dsprintf(*error, "gnutls_init() failed: %d %s", res, gnutls_strerror(res));
 		goto out;
@@ -2857,13 +3088,33 @@ int	zbx_tls_connect(zbx_socket_t *s, unsigned int tls_connect, const char *tls_a
 	gnutls_global_set_audit_log_function(zbx_gnutls_audit_cb);
 
 	gnutls_transport_set_int(s->tls_ctx->ctx, ZBX_SOCKET_TO_INT(s->socket));
+#if defined(ZBX_TLS_SESSION_RESUMPTION)
+	if (0 == (flags & GNUTLS_NO_EXTENSIONS) &&
+			0 != (s->tls_ctx->session_key = zbx_tls_session_key(s, tls_arg1, tls_arg2)))
+	{
+		unsigned char	data[ZBX_TLS_SESSION_DATA_MAX];
+		size_t		data_len;
 
+		if (0 != (data_len = zbx_tls_session_get(s->tls_ctx->session_key, data, sizeof(data))) &&
+				GNUTLS_E_SUCCESS != (res = gnutls_session_set_data(s->tls_ctx->ctx, data, data_len)))
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "%s(): cannot restore cached TLS session: %d %s", __func__, res,
+					gnutls_strerror(res));
+		}
+	}
+#endif
 	/* TLS handshake */
-
+handshake:
 	while (GNUTLS_E_SUCCESS != (res = gnutls_handshake(s->tls_ctx->ctx)))
 	{
 		if (GNUTLS_E_INTERRUPTED == res || GNUTLS_E_AGAIN == res)
 		{
+			if (NULL != event)
+			{
+				*event = tls_get_event(s->tls_ctx->ctx, res);
+				return FAIL;
+			}
+
 			if (FAIL == tls_socket_wait(s->socket, s->tls_ctx->ctx, 0))
 			{
 				*error = zbx_dsprintf(*error, "cannot wait for TLS handshake: %s",
@@ -2942,6 +3193,10 @@ int	zbx_tls_connect(zbx_socket_t *s, unsigned int tls_connect, const char *tls_a
 			zbx_tls_close(s);
 			goto out1;
 		}
+#if defined(ZBX_TLS_SESSION_RESUMPTION)
+		if (0 != s->tls_ctx->session_key)
+			zbx_tls_session_stats_update(0, gnutls_session_is_resumed(s->tls_ctx->ctx));
+#endif
 	}
 
 	s->connection_type = tls_connect;
@@ -3033,7 +3288,7 @@ static int	zbx_tls_get_error(const SSL *s, ssize_t res, const char *func, size_t
 }
 
 int	zbx_tls_connect(zbx_socket_t *s, unsigned int tls_connect, const char *tls_arg1, const char *tls_arg2,
-		const char *server_name, char **error)
+		const char *server_name, short *event, char **error)
 {
 	int		ret = FAIL, res;
 	size_t		error_alloc = 0, error_offset = 0;
@@ -3042,8 +3297,17 @@ int	zbx_tls_connect(zbx_socket_t *s, unsigned int tls_connect, const char *tls_a
 	char	psk_buf[HOST_TLS_PSK_LEN / 2];
 #endif
 
+	if (NULL != s->tls_ctx)	/* continue non-blocking handshake */
+		goto handshake;
+
 	s->tls_ctx = zbx_malloc(s->tls_ctx, sizeof(zbx_tls_context_t));
 	s->tls_ctx->ctx = NULL;
+	s->tls_ctx->session_key = 0;
+#if defined(HAVE_OPENSSL_WITH_PSK)
+	s->tls_ctx->psk_identity = NULL;
+	s->tls_ctx->psk = NULL;
+	s->tls_ctx->psk_len = 0;
+#endif
 
 	if (ZBX_TCP_SEC_TLS_CERT == tls_connect)
 	{
@@ -3110,13 +3374,13 @@ int	zbx_tls_connect(zbx_socket_t *s, unsigned int tls_connect, const char *tls_a
 				goto out;
 			}
 
-			/* some data reside in stack but it will be available at the time when a PSK client callback */
-			/* function copies the data into buffers provided by OpenSSL within the callback */
-			psk_identity_for_cb = tls_arg1;			/* string is on stack */
+			/* PSK is kept in connection context because in non-blocking mode the PSK client callback */
+			/* function can be called after this function has returned */
 			/* NULL check to silence analyzer warning */
-			psk_identity_len_for_cb = (NULL == tls_arg1 ? 0 : strlen(tls_arg1));
-			psk_for_cb = psk_buf;				/* buffer is on stack */
-			psk_len_for_cb = (size_t)psk_len;
+			s->tls_ctx->psk_identity = zbx_strdup(NULL, ZBX_NULL2EMPTY_STR(tls_arg1));
+			s->tls_ctx->psk = (char *)zbx_malloc(NULL, (size_t)psk_len);
+			memcpy(s->tls_ctx->psk, psk_buf, (size_t)psk_len);
+			s->tls_ctx->psk_len = (size_t)psk_len;
 		}
 #else
 		*error = zbx_strdup(*error, "cannot connect with TLS and PSK: support for PSK was not compiled in");
@@ -3142,9 +3406,25 @@ int	zbx_tls_connect(zbx_socket_t *s, unsigned int tls_connect, const char *tls_a
 		*error = zbx_strdup(*error, "cannot set socket for TLS context");
 		goto out;
 	}
-
+#if defined(ZBX_TLS_SESSION_RESUMPTION)
+	if (ZBX_TCP_SEC_TLS_CERT == tls_connect &&
+			0 != (s->tls_ctx->session_key = zbx_tls_session_key(s, tls_arg1, tls_arg2)))
+	{
+		zbx_openssl_session_restore(s->tls_ctx);
+	}
+#endif
 	/* TLS handshake */
-
+handshake:
+#if defined(HAVE_OPENSSL_WITH_PSK)
+	if (NULL != s->tls_ctx->psk)
+	{
+		/* point PSK client callback to the connection PSK, other connections might have changed it */
+		psk_identity_for_cb = s->tls_ctx->psk_identity;
+		psk_identity_len_for_cb = strlen(s->tls_ctx->psk_identity);
+		psk_for_cb = s->tls_ctx->psk;
+		psk_len_for_cb = s->tls_ctx->psk_len;
+	}
+#endif
 	info_buf[0] = '\0';	/* empty buffer for zbx_openssl_info_cb() messages */
 
 	while (-1 == (res = SSL_connect(s->tls_ctx->ctx)))
@@ -3156,6 +3436,12 @@ int	zbx_tls_connect(zbx_socket_t *s, unsigned int tls_connect, const char *tls_a
 		if (SSL_ERROR_WANT_READ != ssl_err && SSL_ERROR_WANT_WRITE != ssl_err)
 			break;
 
+		if (NULL != event)
+		{
+			*event = tls_get_event(s->tls_ctx->ctx, ssl_err);
+			return FAIL;
+		}
+
 		if (FAIL == tls_socket_wait(s->socket, s->tls_ctx->ctx, ssl_err))
 		{
 			*error = zbx_dsprintf(*error, "cannot wait for TLS handshake: %s",
@@ -3211,19 +3497,28 @@ int	zbx_tls_connect(zbx_socket_t *s, unsigned int tls_connect, const char *tls_a
 			zbx_tls_close(s);
 			goto out1;
 		}
+
+#if defined(ZBX_TLS_SESSION_RESUMPTION)
+		if (0 != s->tls_ctx->session_key)
+			zbx_tls_session_stats_update(0, SSL_session_reused(s->tls_ctx->ctx));
+#endif
 	}
 
 	s->connection_type = tls_connect;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():SUCCEED (established %s %s)", __func__,
-			SSL_get_version(s->tls_ctx->ctx), SSL_get_cipher(s->tls_ctx->ctx));
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():SUCCEED (established %s %s%s)", __func__,
+			SSL_get_version(s->tls_ctx->ctx), SSL_get_cipher(s->tls_ctx->ctx),
+			1 == SSL_session_reused(s->tls_ctx->ctx) ? ", resumed" : "");
 
 	return SUCCEED;
 
 out:	/* an error occurred */
 	if (NULL != s->tls_ctx->ctx)
 		SSL_free(s->tls_ctx->ctx);
-
+#if defined(HAVE_OPENSSL_WITH_PSK)
+	zbx_free(s->tls_ctx->psk_identity);
+	zbx_free(s->tls_ctx->psk);
+#endif
 	zbx_free(s->tls_ctx);
 out1:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s error:'%s'", __func__, zbx_result_string(ret),
@@ -3238,30 +3533,42 @@ out1:
  *                                                                            *
  * Parameters:                                                                *
  *     s          - [IN] socket with opened connection                        *
- *     error      - [OUT] dynamically allocated memory with error message     *
  *     tls_accept - [IN] type of connection to accept. Can be be either       *
  *                       ZBX_TCP_SEC_TLS_CERT or ZBX_TCP_SEC_TLS_PSK, or      *
  *                       a bitwise 'OR' of both.                              *
+ *     event      - [OUT] socket event the handshake is waiting for in        *
+ *                        non-blocking mode (optional)                        *
+ *     error      - [OUT] dynamically allocated memory with error message     *
  *                                                                            *
  * Return value:                                                              *
  *     SUCCEED - successful TLS handshake with a valid certificate or PSK     *
- *     FAIL - an error occurred                                               *
+ *     FAIL - an error occurred or, if event is set, the handshake must be    *
+ *            continued by calling this function again when the socket is     *
+ *            ready                                                           *
+ *                                                                            *
+ * Comments: If event is NULL the function waits for the handshake to finish  *
+ *           until socket deadline is reached.                                *
  *                                                                            *
  ******************************************************************************/
 #if defined(HAVE_GNUTLS)
-int	zbx_tls_accept(zbx_socket_t *s, unsigned int tls_accept, char **error)
+int	zbx_tls_accept(zbx_socket_t *s, unsigned int tls_accept, short *event, char **error)
 {
 	int				ret = FAIL, res;
 	gnutls_credentials_type_t	creds;
 
+	if (NULL != s->tls_ctx)	/* continue non-blocking handshake */
+		goto handshake;
+
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
 	/* set up TLS context */
 
 	s->tls_ctx = zbx_malloc(s->tls_ctx, sizeof(zbx_tls_context_t));
 	s->tls_ctx->ctx = NULL;
+	s->tls_ctx->session_key = 0;
 	s->tls_ctx->psk_client_creds = NULL;
 	s->tls_ctx->psk_server_creds = NULL;
+	s->tls_ctx->psk_usage = 0;
 
 	if (GNUTLS_E_SUCCESS != (res = gnutls_init(&s->tls_ctx->ctx, GNUTLS_SERVER)))
 	{
@@ -3269,6 +3576,24 @@ int	zbx_tls_accept(zbx_socket_t *s, unsigned int tls_accept, char **error)
 		goto out;
 	}
 
+	/* PSK callback function stores PSK usage in connection context */
+	gnutls_session_set_ptr(s->tls_ctx->ctx, s->tls_ctx);
+#if defined(ZBX_TLS_SESSION_RESUMPTION)
+	/* only certificate based sessions are resumed, PSK must be looked up on every handshake */
+	if (0 != ticket_key_set && 0 == (tls_accept & ZBX_TCP_SEC_TLS_PSK))
+	{
+		gnutls_datum_t	key = {ticket_key, sizeof(ticket_key)};
+
+		if (GNUTLS_E_SUCCESS != (res = gnutls_session_ticket_enable_server(s->tls_ctx->ctx, &key)))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "%s(): gnutls_session_ticket_enable_server() failed: %d %s",
+					__func__, res, gnutls_strerror(res));
+		}
+		else
+			gnutls_db_set_cache_expiration(s->tls_ctx->ctx, ZBX_TLS_SESSION_LIFETIME);
+	}
+#endif
+
 	/* prepare to accept with certificate */
 
 	if (0 != (tls_accept & ZBX_TCP_SEC_TLS_CERT))
@@ -3386,11 +3711,17 @@ int	zbx_tls_accept(zbx_socket_t *s, unsigned int tls_accept, char **error)
 	gnutls_transport_set_int(s->tls_ctx->ctx, ZBX_SOCKET_TO_INT(s->socket));
 
 	/* TLS handshake */
-
+handshake:
 	while (GNUTLS_E_SUCCESS != (res = gnutls_handshake(s->tls_ctx->ctx)))
 	{
 		if (GNUTLS_E_INTERRUPTED == res || GNUTLS_E_AGAIN == res)
 		{
+			if (NULL != event)
+			{
+				*event = tls_get_event(s->tls_ctx->ctx, res);
+				return FAIL;
+			}
+
 			if (FAIL == tls_socket_wait(s->socket, s->tls_ctx->ctx, 0))
 			{
 				*error = zbx_dsprintf(*error, "cannot wait for TLS handshake: %s",
@@ -3466,7 +3797,9 @@ int	zbx_tls_accept(zbx_socket_t *s, unsigned int tls_accept, char **error)
 			zbx_tls_close(s);
 			goto out1;
 		}
-
+#if defined(ZBX_TLS_SESSION_RESUMPTION)
+		zbx_tls_session_stats_update(1, gnutls_session_is_resumed(s->tls_ctx->ctx));
+#endif
 		/* Issuer and Subject will be verified later, after receiving sender type and host name */
 	}
 	else if (GNUTLS_CRD_PSK == creds)
@@ -3516,7 +3849,7 @@ out1:
 	return ret;
 }
 #elif defined(HAVE_OPENSSL)
-int	zbx_tls_accept(zbx_socket_t *s, unsigned int tls_accept, char **error)
+int	zbx_tls_accept(zbx_socket_t *s, unsigned int tls_accept, short *event, char **error)
 {
 	const char	*cipher_name;
 	int		ret = FAIL, res;
@@ -3526,13 +3859,21 @@ int	zbx_tls_accept(zbx_socket_t *s, unsigned int tls_accept, char **error)
 #if OPENSSL_VERSION_NUMBER >= 0x1010100fL	/* OpenSSL 1.1.1 or newer, or LibreSSL */
 	const unsigned char	session_id_context[] = {'Z', 'b', 'x'};
 #endif
+	if (NULL != s->tls_ctx)	/* continue non-blocking handshake */
+		goto handshake;
+
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
 	s->tls_ctx = zbx_malloc(s->tls_ctx, sizeof(zbx_tls_context_t));
 	s->tls_ctx->ctx = NULL;
+	s->tls_ctx->session_key = 0;
+	s->tls_ctx->psk_usage = 0;
 
 #if defined(HAVE_OPENSSL_WITH_PSK)
-	incoming_connection_has_psk = 0;	/* assume certificate-based connection by default */
+	/* PSK identity is set by PSK server callback, certificate-based connection is assumed by default */
+	s->tls_ctx->psk_identity = NULL;
+	s->tls_ctx->psk = NULL;
+	s->tls_ctx->psk_len = 0;
 #endif
 	if ((ZBX_TCP_SEC_TLS_CERT | ZBX_TCP_SEC_TLS_PSK) == (tls_accept & (ZBX_TCP_SEC_TLS_CERT | ZBX_TCP_SEC_TLS_PSK)))
 	{
@@ -3654,8 +3995,11 @@ int	zbx_tls_accept(zbx_socket_t *s, unsigned int tls_accept, char **error)
 		goto out;
 	}
 
-	/* TLS handshake */
+	/* PSK server callback function stores PSK identity and usage in connection context */
+	SSL_set_app_data(s->tls_ctx->ctx, s->tls_ctx);
 
+	/* TLS handshake */
+handshake:
 	info_buf[0] = '\0';	/* empty buffer for zbx_openssl_info_cb() messages */
 
 	while (-1 == (res = SSL_accept(s->tls_ctx->ctx)))
@@ -3667,6 +4011,12 @@ int	zbx_tls_accept(zbx_socket_t *s, unsigned int tls_accept, char **error)
 		if (SSL_ERROR_WANT_READ != ssl_err && SSL_ERROR_WANT_WRITE != ssl_err)
 			break;
 
+		if (NULL != event)
+		{
+			*event = tls_get_event(s->tls_ctx->ctx, ssl_err);
+			return FAIL;
+		}
+
 		if (FAIL == tls_socket_wait(s->socket, s->tls_ctx->ctx, ssl_err))
 		{
 			*error = zbx_dsprintf(*error, "cannot wait for TLS handshake: %s",
@@ -3718,7 +4068,7 @@ int	zbx_tls_accept(zbx_socket_t *s, unsigned int tls_accept, char **error)
 	cipher_name = SSL_get_cipher(s->tls_ctx->ctx);
 
 #if defined(HAVE_OPENSSL_WITH_PSK)
-	if (1 == incoming_connection_has_psk)
+	if (NULL != s->tls_ctx->psk_identity)
 	{
 		s->connection_type = ZBX_TCP_SEC_TLS_PSK;
 	}
@@ -3738,7 +4088,9 @@ int	zbx_tls_accept(zbx_socket_t *s, unsigned int tls_accept, char **error)
 			zbx_tls_close(s);
 			goto out1;
 		}
-
+#if defined(ZBX_TLS_SESSION_RESUMPTION)
+		zbx_tls_session_stats_update(1, SSL_session_reused(s->tls_ctx->ctx));
+#endif
 		/* Issuer and Subject will be verified later, after receiving sender type and host name */
 	}
 #if defined(HAVE_OPENSSL_WITH_PSK)
@@ -3757,7 +4109,10 @@ int	zbx_tls_accept(zbx_socket_t *s, unsigned int tls_accept, char **error)
 out:	/* an error occurred */
 	if (NULL != s->tls_ctx->ctx)
 		SSL_free(s->tls_ctx->ctx);
-
+#if defined(HAVE_OPENSSL_WITH_PSK)
+	zbx_free(s->tls_ctx->psk_identity);
+	zbx_free(s->tls_ctx->psk);
+#endif
 	zbx_free(s->tls_ctx);
 out1:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s error:'%s'", __func__, zbx_result_string(ret),
@@ -3786,7 +4141,25 @@ out1:
 /* SSL_MODE_AUTO_RETRY flag in zbx_tls_init_child() */
 #endif
 
-ssize_t	zbx_tls_write(zbx_socket_t *s, const char *buf, size_t len, char **error)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: write data to TLS connection                                      *
+ *                                                                            *
+ * Parameters: s     - [IN] socket with established TLS connection            *
+ *             buf   - [IN] data to write                                     *
+ *             len   - [IN] data length                                       *
+ *             event - [OUT] socket event to wait for in non-blocking mode    *
+ *                           (optional)                                       *
+ *             error - [OUT] error message                                    *
+ *                                                                            *
+ * Return value: number of bytes written or ZBX_PROTO_ERROR on error          *
+ *                                                                            *
+ * Comments: In non-blocking mode less than len bytes can be written, in this *
+ *           case event is set and writing must be continued when socket is   *
+ *           ready.                                                           *
+ *                                                                            *
+ ******************************************************************************/
+ssize_t	zbx_tls_write(zbx_socket_t *s, const char *buf, size_t len, short *event, char **error)
 {
 	ssize_t		offset = 0, n;
 
@@ -3806,6 +4179,12 @@ ssize_t	zbx_tls_write(zbx_socket_t *s, const char *buf, size_t len, char **error
 			if (SUCCEED != tls_is_nonblocking_error(err))
 				break;
 
+			if (NULL != event)
+			{
+				*event = tls_get_event(s->tls_ctx->ctx, err);
+				return offset;
+			}
+
 			if (FAIL == tls_socket_wait(s->socket, s->tls_ctx->ctx, err))
 			{
 				*error = zbx_dsprintf(*error, "cannot wait socket: %s",
@@ -3860,7 +4239,22 @@ ssize_t	zbx_tls_write(zbx_socket_t *s, const char *buf, size_t len, char **error
 	return offset;
 }
 
-ssize_t	zbx_tls_read(zbx_socket_t *s, char *buf, size_t len, char **error)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: read data from TLS connection                                     *
+ *                                                                            *
+ * Parameters: s     - [IN] socket with established TLS connection            *
+ *             buf   - [OUT] buffer for data                                  *
+ *             len   - [IN] buffer size                                       *
+ *             event - [OUT] socket event to wait for in non-blocking mode    *
+ *                           (optional)                                       *
+ *             error - [OUT] error message                                    *
+ *                                                                            *
+ * Return value: number of bytes read or ZBX_PROTO_ERROR on error or if event *
+ *               is set and reading must be repeated when socket is ready     *
+ *                                                                            *
+ ******************************************************************************/
+ssize_t	zbx_tls_read(zbx_socket_t *s, char *buf, size_t len, short *event, char **error)
 {
 	ssize_t		n = 0;
 
@@ -3878,6 +4272,12 @@ ssize_t	zbx_tls_read(zbx_socket_t *s, char *buf, size_t len, char **error)
 		if (SUCCEED != tls_is_nonblocking_error(err))
 			break;
 
+		if (NULL != event)
+		{
+			*event = tls_get_event(s->tls_ctx->ctx, err);
+			return ZBX_PROTO_ERROR;
+		}
+
 		if (FAIL == tls_socket_wait(s->socket, s->tls_ctx->ctx, err))
 		{
 			*error = zbx_dsprintf(*error, "cannot wait socket: %s",
@@ -3971,6 +4371,20 @@ void	zbx_tls_close(zbx_socket_t *s)
 			}
 		}
 
+#if defined(ZBX_TLS_SESSION_RESUMPTION)
+		if (0 != s->tls_ctx->session_key && ZBX_TCP_SEC_TLS_CERT == s->connection_type &&
+				0 != (gnutls_session_get_flags(s->tls_ctx->ctx) & GNUTLS_SFLAGS_SESSION_TICKET))
+		{
+			gnutls_datum_t	data;
+
+			if (GNUTLS_E_SUCCESS == gnutls_session_get_data2(s->tls_ctx->ctx, &data))
+			{
+				zbx_tls_session_put(s->tls_ctx->session_key, data.data, data.size,
+						ZBX_TLS_SESSION_LIFETIME);
+				gnutls_free(data.data);
+			}
+		}
+#endif
 		gnutls_credentials_clear(s->tls_ctx->ctx);
 		gnutls_deinit(s->tls_ctx->ctx);
 	}
@@ -4020,8 +4434,16 @@ void	zbx_tls_close(zbx_socket_t *s)
 			}
 		}
 
+#if defined(ZBX_TLS_SESSION_RESUMPTION)
+		if (0 != s->tls_ctx->session_key && ZBX_TCP_SEC_TLS_CERT == s->connection_type)
+			zbx_openssl_session_save(s->tls_ctx);
+#endif
 		SSL_free(s->tls_ctx->ctx);
 	}
+#if defined(HAVE_OPENSSL_WITH_PSK)
+	zbx_free(s->tls_ctx->psk_identity);
+	zbx_free(s->tls_ctx->psk);
+#endif
 #endif
 	zbx_free(s->tls_ctx);
 }
@@ -4139,14 +4561,12 @@ int	zbx_tls_get_attr_psk(const zbx_socket_t *s, zbx_tls_conn_attr_t *attr)
 #elif defined(HAVE_OPENSSL) && defined(HAVE_OPENSSL_WITH_PSK)
 int	zbx_tls_get_attr_psk(const zbx_socket_t *s, zbx_tls_conn_attr_t *attr)
 {
-	ZBX_UNUSED(s);
-
 	/* SSL_get_psk_identity() is not used here. It works with TLS 1.2, */
 	/* but returns NULL with TLS 1.3 in OpenSSL 1.1.1 */
-	if ('\0' == incoming_connection_psk_id[0])
+	if (NULL == s->tls_ctx->psk_identity)
 		return FAIL;
 
-	attr->psk_identity = incoming_connection_psk_id;
+	attr->psk_identity = s->tls_ctx->psk_identity;
 	attr->psk_identity_len = strlen(attr->psk_identity);
 	return SUCCEED;
 }
@@ -4302,8 +4722,8 @@ void	zbx_tls_take_vars(ZBX_THREAD_SENDVAL_TLS_ARGS *args)
 }
 #endif
 
-unsigned int	zbx_tls_get_psk_usage(void)
+unsigned int	zbx_tls_get_psk_usage(const zbx_socket_t *s)
 {
-	return	psk_usage;
+	return	s->tls_ctx->psk_usage;
 }
 #endif
@@ -24,11 +24,23 @@
 
 #if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
 int	zbx_tls_connect(zbx_socket_t *s, unsigned int tls_connect, const char *tls_arg1, const char *tls_arg2,
-		const char *server_name, char **error);
-int	zbx_tls_accept(zbx_socket_t *s, unsigned int tls_accept, char **error);
-ssize_t	zbx_tls_write(zbx_socket_t *s, const char *buf, size_t len, char **error);
-ssize_t	zbx_tls_read(zbx_socket_t *s, char *buf, size_t len, char **error);
+		const char *server_name, short *event, char **error);
+int	zbx_tls_accept(zbx_socket_t *s, unsigned int tls_accept, short *event, char **error);
+ssize_t	zbx_tls_write(zbx_socket_t *s, const char *buf, size_t len, short *event, char **error);
+ssize_t	zbx_tls_read(zbx_socket_t *s, char *buf, size_t len, short *event, char **error);
 void	zbx_tls_close(zbx_socket_t *s);
+
+/* sessions that do not fit are not cached, session includes peer certificate */
+#define ZBX_TLS_SESSION_DATA_MAX	(8 * ZBX_KIBIBYTE)
+/* lifetime of issued session tickets and cached sessions */
+#define ZBX_TLS_SESSION_LIFETIME	SEC_PER_HOUR
+
+int		zbx_tls_ticket_key_init(char **error);
+int		zbx_tls_session_cache_enabled(void);
+zbx_uint64_t	zbx_tls_session_key(const zbx_socket_t *s, const char *issuer, const char *subject);
+size_t		zbx_tls_session_get(zbx_uint64_t key, unsigned char *data, size_t size);
+void		zbx_tls_session_put(zbx_uint64_t key, const unsigned char *data, size_t data_len, int lifetime);
+void		zbx_tls_session_stats_update(int incoming, int resumed);
 #endif	/* #if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL) */
 
 #endif /* ZABBIX_TLS_H */
@@ -0,0 +1,352 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "tls.h"
+
+#include "zbxsysinc.h"
+#include "zbxalgo.h"
+#include "zbxmutexs.h"
+#include "zbxstr.h"
+#include "log.h"
+
+#if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
+
+/* Client sessions of certificate based connections are kept in shared memory, so a session */
+/* established by one process can be resumed by any other process connecting to the same   */
+/* peer. The cache is a direct-mapped table of fixed size slots, a newer session evicts an  */
+/* older one with the same slot index.                                                     */
+
+typedef struct
+{
+	zbx_uint64_t	key;		/* 0 - empty slot */
+	time_t		expires;
+	size_t		data_len;
+	unsigned char	data[ZBX_TLS_SESSION_DATA_MAX];
+}
+zbx_tls_session_slot_t;
+
+typedef struct
+{
+	zbx_tls_session_stats_t	stats;
+	zbx_uint64_t		slots_num;
+	zbx_tls_session_slot_t	slots[1];
+}
+zbx_tls_session_cache_t;
+
+static zbx_tls_session_cache_t	*session_cache = NULL;
+
+#ifndef _WINDOWS
+static zbx_mutex_t		session_lock = ZBX_MUTEX_NULL;
+
+#define LOCK_CACHE	zbx_mutex_lock(session_lock)
+#define UNLOCK_CACHE	zbx_mutex_unlock(session_lock)
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: create shared TLS session cache and session ticket key shared by  *
+ *          all child processes                                               *
+ *                                                                            *
+ * Parameters: size  - [IN] cache size in bytes                               *
+ *             error - [OUT] error message                                    *
+ *                                                                            *
+ * Return value: SUCCEED - the cache was created                              *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Must be called in the parent process before forking.             *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_tls_session_cache_init(zbx_uint64_t size, char **error)
+{
+	int		shm_id, ret = FAIL;
+	void		*base;
+	zbx_uint64_t	slots_num, i;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() size:" ZBX_FS_UI64, __func__, size);
+
+	slots_num = (size - offsetof(zbx_tls_session_cache_t, slots)) / sizeof(zbx_tls_session_slot_t);
+
+	if (size < sizeof(zbx_tls_session_cache_t) || 0 == slots_num)
+	{
+		*error = zbx_dsprintf(*error, "TLS session cache size must be at least " ZBX_FS_SIZE_T " bytes",
+				(zbx_fs_size_t)sizeof(zbx_tls_session_cache_t));
+		goto out;
+	}
+
+	if (SUCCEED != zbx_tls_ticket_key_init(error))
+		goto out;
+
+	if (SUCCEED != zbx_mutex_create(&session_lock, ZBX_MUTEX_TLS_SESSION, error))
+		goto out;
+
+	if (-1 == (shm_id = shmget(IPC_PRIVATE, (size_t)size, 0600)))
+	{
+		*error = zbx_dsprintf(*error, "cannot get private shared memory of size " ZBX_FS_UI64 " for TLS"
+				" session cache: %s", size, zbx_strerror(errno));
+		goto out;
+	}
+
+	if ((void *)(-1) == (base = shmat(shm_id, NULL, 0)))
+	{
+		*error = zbx_dsprintf(*error, "cannot attach shared memory for TLS session cache: %s",
+				zbx_strerror(errno));
+		goto out;
+	}
+
+	if (-1 == shmctl(shm_id, IPC_RMID, NULL))
+		zbx_error("cannot mark shared memory %d for destruction: %s", shm_id, zbx_strerror(errno));
+
+	session_cache = (zbx_tls_session_cache_t *)base;
+	memset(session_cache, 0, offsetof(zbx_tls_session_cache_t, slots));
+	session_cache->slots_num = slots_num;
+
+	for (i = 0; i < slots_num; i++)
+		session_cache->slots[i].key = 0;
+
+	ret = SUCCEED;
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s slots:" ZBX_FS_UI64, __func__, zbx_result_string(ret),
+			NULL == session_cache ? 0 : session_cache->slots_num);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: destroy shared TLS session cache                                  *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_tls_session_cache_destroy(void)
+{
+	if (NULL == session_cache)
+		return;
+
+	if (-1 == shmdt(session_cache))
+		zabbix_log(LOG_LEVEL_WARNING, "cannot detach TLS session cache: %s", zbx_strerror(errno));
+
+	session_cache = NULL;
+	zbx_mutex_destroy(&session_lock);
+}
+#else
+#define LOCK_CACHE
+#define UNLOCK_CACHE
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: check if sessions of outgoing connections are cached              *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_tls_session_cache_enabled(void)
+{
+	return NULL != session_cache ? SUCCEED : FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: calculate session cache key of outgoing connection                *
+ *                                                                            *
+ * Parameters: s       - [IN] connected socket                                *
+ *             issuer  - [IN] required issuer of peer certificate (optional)  *
+ *             subject - [IN] required subject of peer certificate (optional) *
+ *                                                                            *
+ * Return value: session key or 0 if the session cannot be cached             *
+ *                                                                            *
+ * Comments: Peer address and port identify the peer, certificate             *
+ *           requirements are included so that connections with different     *
+ *           requirements do not share sessions.                              *
+ *                                                                            *
+ ******************************************************************************/
+zbx_uint64_t	zbx_tls_session_key(const zbx_socket_t *s, const char *issuer, const char *subject)
+{
+	ZBX_SOCKADDR	addr;
+	ZBX_SOCKLEN_T	addr_len = sizeof(addr);
+	zbx_hash_t	hash_lo, hash_hi;
+	zbx_uint64_t	key;
+
+	if (NULL == session_cache)
+		return 0;
+
+	memset(&addr, 0, sizeof(addr));
+
+	if (ZBX_PROTO_ERROR == getpeername(s->socket, (struct sockaddr *)&addr, &addr_len))
+		return 0;
+
+	hash_lo = ZBX_DEFAULT_HASH_ALGO(&addr, (size_t)addr_len, ZBX_DEFAULT_HASH_SEED);
+	hash_lo = ZBX_DEFAULT_STRING_HASH_ALGO(ZBX_NULL2EMPTY_STR(issuer), strlen(ZBX_NULL2EMPTY_STR(issuer)),
+			hash_lo);
+	hash_lo = ZBX_DEFAULT_STRING_HASH_ALGO(ZBX_NULL2EMPTY_STR(subject), strlen(ZBX_NULL2EMPTY_STR(subject)),
+			hash_lo);
+
+	/* second hash with different seed reduces probability of collisions */
+	hash_hi = ZBX_DEFAULT_HASH_ALGO(&addr, (size_t)addr_len, hash_lo);
+
+	if (0 == (key = ((zbx_uint64_t)hash_hi << 32) | hash_lo))
+		key = 1;
+
+	return key;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get cached session of outgoing connection                         *
+ *                                                                            *
+ * Parameters: key  - [IN] session key                                        *
+ *             data - [OUT] serialized session                                *
+ *             size - [IN] size of data buffer                                *
+ *                                                                            *
+ * Return value: length of serialized session or 0 if the session was not     *
+ *               found or has expired                                         *
+ *                                                                            *
+ ******************************************************************************/
+size_t	zbx_tls_session_get(zbx_uint64_t key, unsigned char *data, size_t size)
+{
+	zbx_tls_session_slot_t	*slot;
+	size_t			data_len = 0;
+
+	if (NULL == session_cache || 0 == key)
+		return 0;
+
+	slot = &session_cache->slots[key % session_cache->slots_num];
+
+	LOCK_CACHE;
+
+	if (key == slot->key && time(NULL) < slot->expires && slot->data_len <= size)
+	{
+		memcpy(data, slot->data, slot->data_len);
+		data_len = slot->data_len;
+	}
+
+	UNLOCK_CACHE;
+
+	return data_len;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: cache session of outgoing connection                              *
+ *                                                                            *
+ * Parameters: key      - [IN] session key                                    *
+ *             data     - [IN] serialized session                             *
+ *             data_len - [IN] length of serialized session                   *
+ *             lifetime - [IN] session lifetime in seconds                    *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_tls_session_put(zbx_uint64_t key, const unsigned char *data, size_t data_len, int lifetime)
+{
+	zbx_tls_session_slot_t	*slot;
+
+	if (NULL == session_cache || 0 == key)
+		return;
+
+	if (ZBX_TLS_SESSION_DATA_MAX < data_len)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "cannot cache TLS session: " ZBX_FS_SIZE_T " bytes do not fit into"
+				" session slot", (zbx_fs_size_t)data_len);
+		return;
+	}
+
+	slot = &session_cache->slots[key % session_cache->slots_num];
+
+	LOCK_CACHE;
+
+	memcpy(slot->data, data, data_len);
+	slot->data_len = data_len;
+	slot->expires = time(NULL) + lifetime;
+	slot->key = key;
+
+	UNLOCK_CACHE;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: account certificate based TLS handshake                           *
+ *                                                                            *
+ * Parameters: incoming - [IN] 1 - accepted connection, 0 - outgoing          *
+ *             resumed  - [IN] 1 - session was resumed, 0 - full handshake    *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_tls_session_stats_update(int incoming, int resumed)
+{
+	if (NULL == session_cache)
+		return;
+
+	LOCK_CACHE;
+
+	if (0 != incoming)
+	{
+		if (0 != resumed)
+			session_cache->stats.server_hits++;
+		else
+			session_cache->stats.server_misses++;
+	}
+	else
+	{
+		if (0 != resumed)
+			session_cache->stats.client_hits++;
+		else
+			session_cache->stats.client_misses++;
+	}
+
+	UNLOCK_CACHE;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get TLS session resumption statistics                             *
+ *                                                                            *
+ * Parameters: stats - [OUT] session resumption statistics                    *
+ *             error - [OUT] error message                                    *
+ *                                                                            *
+ * Return value: SUCCEED - statistics were returned                           *
+ *               FAIL    - TLS session cache is disabled                      *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_tls_session_get_stats(zbx_tls_session_stats_t *stats, char **error)
+{
+	zbx_tls_session_slot_t	*slot;
+	zbx_uint64_t		i;
+	time_t			now;
+
+	if (NULL == session_cache)
+	{
+		*error = zbx_strdup(*error, "TLS session cache is disabled.");
+		return FAIL;
+	}
+
+	now = time(NULL);
+
+	LOCK_CACHE;
+
+	*stats = session_cache->stats;
+	stats->sessions_num = 0;
+
+	for (i = 0, slot = session_cache->slots; i < session_cache->slots_num; i++, slot++)
+	{
+		if (0 != slot->key && now < slot->expires)
+			stats->sessions_num++;
+	}
+
+	stats->slots_num = session_cache->slots_num;
+
+	UNLOCK_CACHE;
+
+	return SUCCEED;
+}
+
+#endif	/* defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL) */
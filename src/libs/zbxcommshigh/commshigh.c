@@ -175,38 +175,6 @@ exit:
 	return ret;
 }
 
-/******************************************************************************
- *                                                                            *
- * Purpose: send data to server                                               *
- *                                                                            *
- * Return value: SUCCEED - processed successfully                             *
- *               FAIL - an error occurred                                     *
- *                                                                            *
- ******************************************************************************/
-int	zbx_put_data_to_server(zbx_socket_t *sock, char **buffer, size_t buffer_size, size_t reserved, char **error)
-{
-	int	ret = FAIL;
-
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() datalen:" ZBX_FS_SIZE_T, __func__, (zbx_fs_size_t)buffer_size);
-
-	if (SUCCEED != zbx_tcp_send_ext(sock, *buffer, buffer_size, reserved, ZBX_TCP_PROTOCOL | ZBX_TCP_COMPRESS, 0))
-	{
-		*error = zbx_strdup(*error, zbx_socket_strerror());
-		goto out;
-	}
-
-	zbx_free(*buffer);
-
-	if (SUCCEED != zbx_recv_response(sock, 0, error))
-		goto out;
-
-	ret = SUCCEED;
-out:
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
-
-	return ret;
-}
-
 /******************************************************************************
  *                                                                            *
  * Purpose: send json SUCCEED or FAIL to socket along with an info message    *
@@ -259,6 +227,60 @@ int	zbx_send_response_ext(zbx_socket_t *sock, int result, const char *info, cons
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: check a response message (in JSON format), optionally extract     *
+ *          "info" value                                                      *
+ *                                                                            *
+ * Parameters: response - [IN] received response message                      *
+ *             error    - [OUT] pointer to error message                      *
+ *                                                                            *
+ * Return value: SUCCEED - "response":"success" successfully retrieved        *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: See zbx_recv_response() for error message handling.              *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_parse_response(const char *response, char **error)
+{
+	struct zbx_json_parse	jp;
+	char			value[16];
+
+	/* deal with empty string here because zbx_json_open() does not produce an error message in this case */
+	if ('\0' == *response)
+	{
+		*error = zbx_strdup(*error, "empty string received");
+		return FAIL;
+	}
+
+	if (SUCCEED != zbx_json_open(response, &jp))
+	{
+		*error = zbx_strdup(*error, zbx_json_strerror());
+		return FAIL;
+	}
+
+	if (SUCCEED != zbx_json_value_by_name(&jp, ZBX_PROTO_TAG_RESPONSE, value, sizeof(value), NULL))
+	{
+		*error = zbx_strdup(*error, "no \"" ZBX_PROTO_TAG_RESPONSE "\" tag");
+		return FAIL;
+	}
+
+	if (0 != strcmp(value, ZBX_PROTO_VALUE_SUCCESS))
+	{
+		char	*info = NULL;
+		size_t	info_alloc = 0;
+
+		if (SUCCEED == zbx_json_value_by_name_dyn(&jp, ZBX_PROTO_TAG_INFO, &info, &info_alloc, NULL))
+			*error = zbx_strdup(*error, info);
+		else
+			*error = zbx_dsprintf(*error, "negative response \"%s\"", value);
+		zbx_free(info);
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: read a response message (in JSON format) from socket, optionally  *
@@ -287,9 +309,7 @@ int	zbx_send_response_ext(zbx_socket_t *sock, int result, const char *info, cons
  ******************************************************************************/
 int	zbx_recv_response(zbx_socket_t *sock, int timeout, char **error)
 {
-	struct zbx_json_parse	jp;
-	char			value[16];
-	int			ret = FAIL;
+	int	ret = FAIL;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -303,39 +323,7 @@ int	zbx_recv_response(zbx_socket_t *sock, int timeout, char **error)
 
 	zabbix_log(LOG_LEVEL_DEBUG, "%s() '%s'", __func__, sock->buffer);
 
-	/* deal with empty string here because zbx_json_open() does not produce an error message in this case */
-	if ('\0' == *sock->buffer)
-	{
-		*error = zbx_strdup(*error, "empty string received");
-		goto out;
-	}
-
-	if (SUCCEED != zbx_json_open(sock->buffer, &jp))
-	{
-		*error = zbx_strdup(*error, zbx_json_strerror());
-		goto out;
-	}
-
-	if (SUCCEED != zbx_json_value_by_name(&jp, ZBX_PROTO_TAG_RESPONSE, value, sizeof(value), NULL))
-	{
-		*error = zbx_strdup(*error, "no \"" ZBX_PROTO_TAG_RESPONSE "\" tag");
-		goto out;
-	}
-
-	if (0 != strcmp(value, ZBX_PROTO_VALUE_SUCCESS))
-	{
-		char	*info = NULL;
-		size_t	info_alloc = 0;
-
-		if (SUCCEED == zbx_json_value_by_name_dyn(&jp, ZBX_PROTO_TAG_INFO, &info, &info_alloc, NULL))
-			*error = zbx_strdup(*error, info);
-		else
-			*error = zbx_dsprintf(*error, "negative response \"%s\"", value);
-		zbx_free(info);
-		goto out;
-	}
-
-	ret = SUCCEED;
+	ret = zbx_parse_response(sock->buffer, error);
 out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
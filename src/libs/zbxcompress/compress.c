@@ -23,11 +23,19 @@
 
 #ifdef HAVE_ZLIB
 #include "zlib.h"
-#include "log.h"
+#endif
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#ifdef HAVE_LZ4
+#include <lz4.h>
+#endif
 
 #define ZBX_COMPRESS_STRERROR_LEN	512
 
-static int	zbx_zlib_errno = 0;
+static char	compress_error[ZBX_COMPRESS_STRERROR_LEN];
 
 /******************************************************************************
  *                                                                            *
@@ -36,35 +44,319 @@ static int	zbx_zlib_errno = 0;
  ******************************************************************************/
 const char	*zbx_compress_strerror(void)
 {
-	static char	message[ZBX_COMPRESS_STRERROR_LEN];
+	return compress_error;
+}
 
+#ifdef HAVE_ZLIB
+static void	zlib_set_error(int zbx_zlib_errno)
+{
 	switch (zbx_zlib_errno)
 	{
 		case Z_ERRNO:
-			zbx_strlcpy(message, zbx_strerror(errno), sizeof(message));
+			zbx_strlcpy(compress_error, zbx_strerror(errno), sizeof(compress_error));
 			break;
 		case Z_MEM_ERROR:
-			zbx_strlcpy(message, "not enough memory", sizeof(message));
+			zbx_strlcpy(compress_error, "not enough memory", sizeof(compress_error));
 			break;
 		case Z_BUF_ERROR:
-			zbx_strlcpy(message, "not enough space in output buffer", sizeof(message));
+			zbx_strlcpy(compress_error, "not enough space in output buffer", sizeof(compress_error));
 			break;
 		case Z_DATA_ERROR:
-			zbx_strlcpy(message, "corrupted input data", sizeof(message));
+			zbx_strlcpy(compress_error, "corrupted input data", sizeof(compress_error));
 			break;
 		default:
-			zbx_snprintf(message, sizeof(message), "unknown error (%d)", zbx_zlib_errno);
+			zbx_snprintf(compress_error, sizeof(compress_error), "unknown error (%d)", zbx_zlib_errno);
 			break;
 	}
+}
 
-	return message;
+static int	zlib_compress(const char *in, size_t size_in, char **out, size_t *size_out)
+{
+	Bytef	*buf;
+	uLongf	buf_size;
+	int	zbx_zlib_errno;
+
+	buf_size = compressBound(size_in);
+	buf = (Bytef *)zbx_malloc(NULL, buf_size);
+
+	if (Z_OK != (zbx_zlib_errno = compress(buf, &buf_size, (const Bytef *)in, size_in)))
+	{
+		zlib_set_error(zbx_zlib_errno);
+		zbx_free(buf);
+		return FAIL;
+	}
+
+	*out = (char *)buf;
+	*size_out = buf_size;
+
+	return SUCCEED;
+}
+
+static int	zlib_uncompress(const char *in, size_t size_in, char *out, size_t *size_out)
+{
+	uLongf	size_o = *size_out;
+	int	zbx_zlib_errno;
+
+	if (Z_OK != (zbx_zlib_errno = uncompress((Bytef *)out, &size_o, (const Bytef *)in, size_in)))
+	{
+		zlib_set_error(zbx_zlib_errno);
+		return FAIL;
+	}
+
+	*size_out = size_o;
+
+	return SUCCEED;
+}
+#endif
+
+#ifdef HAVE_ZSTD
+#define ZBX_ZSTD_LEVEL	3
+
+/* Raw content dictionary with the protocol tags most often found in server-proxy messages. */
+/* It is a part of the Zstandard codec definition and must be the same on both sides, so it */
+/* must never be changed - a new dictionary would require a new protocol compression flag.  */
+static const char	zstd_dictionary[] =
+	"{\"request\":\"proxy data\",\"host\":\"\",\"session\":\"\",\"interface availability\":[{\"interfaceid\":"
+	",\"available\":1,\"error\":\"\"}],\"discovery data\":[{\"clock\":,\"druleid\":,\"dcheckid\":,\"type\":,"
+	"\"ip\":\"\",\"dns\":\"\",\"port\":,\"key_\":\"\",\"value\":\"\",\"status\":}],\"auto registration\":[{"
+	"\"clock\":,\"host\":\"\",\"ip\":\"\",\"dns\":\"\",\"port\":\"\",\"host_metadata\":\"\",\"flags\":,"
+	"\"tls_accepted\":}],\"host data\":[{\"hostid\":,\"active_status\":}],\"tasks\":[],\"more\":1,"
+	"\"version\":\"\",\"proxy_delay\":,\"response\":\"success\",\"upload\":\"enabled\",\"history data\":[{"
+	"\"id\":,\"itemid\":,\"clock\":,\"ns\":,\"state\":1,\"lastlogsize\":,\"mtime\":0,\"timestamp\":,"
+	"\"source\":\"\",\"severity\":,\"eventid\":,\"value\":\"\"},{\"id\":,\"itemid\":,\"clock\":,\"ns\":,"
+	"\"value\":\"\"},{\"id\":,\"itemid\":,\"clock\":,\"ns\":,\"value\":\"";
+
+static ZSTD_CDict	*zstd_cdict = NULL;
+static ZSTD_DDict	*zstd_ddict = NULL;
+
+static int	zstd_compress(const char *in, size_t size_in, char **out, size_t *size_out)
+{
+	ZSTD_CCtx	*cctx;
+	char		*buf;
+	size_t		buf_size, ret;
+
+	if (NULL == zstd_cdict &&
+			NULL == (zstd_cdict = ZSTD_createCDict(zstd_dictionary, sizeof(zstd_dictionary) - 1,
+			ZBX_ZSTD_LEVEL)))
+	{
+		zbx_strlcpy(compress_error, "cannot create compression dictionary", sizeof(compress_error));
+		return FAIL;
+	}
+
+	if (NULL == (cctx = ZSTD_createCCtx()))
+	{
+		zbx_strlcpy(compress_error, "not enough memory", sizeof(compress_error));
+		return FAIL;
+	}
+
+	buf_size = ZSTD_compressBound(size_in);
+	buf = (char *)zbx_malloc(NULL, buf_size);
+
+	ret = ZSTD_compress_usingCDict(cctx, buf, buf_size, in, size_in, zstd_cdict);
+	ZSTD_freeCCtx(cctx);
+
+	if (0 != ZSTD_isError(ret))
+	{
+		zbx_strlcpy(compress_error, ZSTD_getErrorName(ret), sizeof(compress_error));
+		zbx_free(buf);
+		return FAIL;
+	}
+
+	*out = buf;
+	*size_out = ret;
+
+	return SUCCEED;
+}
+
+static int	zstd_uncompress(const char *in, size_t size_in, char *out, size_t *size_out)
+{
+	ZSTD_DCtx	*dctx;
+	size_t		ret;
+
+	if (NULL == zstd_ddict &&
+			NULL == (zstd_ddict = ZSTD_createDDict(zstd_dictionary, sizeof(zstd_dictionary) - 1)))
+	{
+		zbx_strlcpy(compress_error, "cannot create compression dictionary", sizeof(compress_error));
+		return FAIL;
+	}
+
+	if (NULL == (dctx = ZSTD_createDCtx()))
+	{
+		zbx_strlcpy(compress_error, "not enough memory", sizeof(compress_error));
+		return FAIL;
+	}
+
+	ret = ZSTD_decompress_usingDDict(dctx, out, *size_out, in, size_in, zstd_ddict);
+	ZSTD_freeDCtx(dctx);
+
+	if (0 != ZSTD_isError(ret))
+	{
+		zbx_strlcpy(compress_error, ZSTD_getErrorName(ret), sizeof(compress_error));
+		return FAIL;
+	}
+
+	*size_out = ret;
+
+	return SUCCEED;
+}
+#undef ZBX_ZSTD_LEVEL
+#endif
+
+#ifdef HAVE_LZ4
+static int	lz4_compress(const char *in, size_t size_in, char **out, size_t *size_out)
+{
+	char	*buf;
+	int	buf_size, ret;
+
+	if (LZ4_MAX_INPUT_SIZE < size_in)
+	{
+		zbx_strlcpy(compress_error, "input data is too large", sizeof(compress_error));
+		return FAIL;
+	}
+
+	buf_size = LZ4_compressBound((int)size_in);
+	buf = (char *)zbx_malloc(NULL, (size_t)buf_size);
+
+	if (0 >= (ret = LZ4_compress_default(in, buf, (int)size_in, buf_size)))
+	{
+		zbx_strlcpy(compress_error, "not enough space in output buffer", sizeof(compress_error));
+		zbx_free(buf);
+		return FAIL;
+	}
+
+	*out = buf;
+	*size_out = (size_t)ret;
+
+	return SUCCEED;
+}
+
+static int	lz4_uncompress(const char *in, size_t size_in, char *out, size_t *size_out)
+{
+	int	ret;
+
+	if (INT_MAX < size_in || INT_MAX < *size_out)
+	{
+		zbx_strlcpy(compress_error, "input data is too large", sizeof(compress_error));
+		return FAIL;
+	}
+
+	if (0 > (ret = LZ4_decompress_safe(in, out, (int)size_in, (int)*size_out)))
+	{
+		zbx_strlcpy(compress_error, "corrupted input data", sizeof(compress_error));
+		return FAIL;
+	}
+
+	*size_out = (size_t)ret;
+
+	return SUCCEED;
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if compression codec is supported by this build            *
+ *                                                                            *
+ * Parameters: codec - [IN] the compression codec (ZBX_COMPRESS_*)            *
+ *                                                                            *
+ * Return value: SUCCEED - the codec is supported                             *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_compress_codec_supported(unsigned char codec)
+{
+	switch (codec)
+	{
+#ifdef HAVE_ZLIB
+		case ZBX_COMPRESS_ZLIB:
+			return SUCCEED;
+#endif
+#ifdef HAVE_ZSTD
+		case ZBX_COMPRESS_ZSTD:
+			return SUCCEED;
+#endif
+#ifdef HAVE_LZ4
+		case ZBX_COMPRESS_LZ4:
+			return SUCCEED;
+#endif
+		default:
+			return FAIL;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns compression codec name                                    *
+ *                                                                            *
+ ******************************************************************************/
+const char	*zbx_compress_codec_name(unsigned char codec)
+{
+	switch (codec)
+	{
+		case ZBX_COMPRESS_ZLIB:
+			return ZBX_COMPRESS_NAME_ZLIB;
+		case ZBX_COMPRESS_ZSTD:
+			return ZBX_COMPRESS_NAME_ZSTD;
+		case ZBX_COMPRESS_LZ4:
+			return ZBX_COMPRESS_NAME_LZ4;
+		default:
+			return "unknown";
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns comma separated list of additional compression codecs     *
+ *          supported by this build, ordered by preference                    *
+ *                                                                            *
+ * Comments: The zlib codec is supported by all peers and is not listed.      *
+ *                                                                            *
+ ******************************************************************************/
+const char	*zbx_compress_codecs(void)
+{
+#if defined(HAVE_ZSTD) && defined(HAVE_LZ4)
+	return ZBX_COMPRESS_NAME_ZSTD "," ZBX_COMPRESS_NAME_LZ4;
+#elif defined(HAVE_ZSTD)
+	return ZBX_COMPRESS_NAME_ZSTD;
+#elif defined(HAVE_LZ4)
+	return ZBX_COMPRESS_NAME_LZ4;
+#else
+	return "";
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: selects the preferred compression codec supported by this build   *
+ *          and by the peer                                                   *
+ *                                                                            *
+ * Parameters: codecs - [IN] comma separated list of compression codecs       *
+ *                           supported by the peer, can be NULL               *
+ *                                                                            *
+ * Return value: The selected compression codec, ZBX_COMPRESS_ZLIB if no      *
+ *               other codec is supported by both sides.                      *
+ *                                                                            *
+ ******************************************************************************/
+unsigned char	zbx_compress_select_codec(const char *codecs)
+{
+	if (NULL == codecs)
+		return ZBX_COMPRESS_ZLIB;
+#ifdef HAVE_ZSTD
+	if (SUCCEED == zbx_str_in_list(codecs, ZBX_COMPRESS_NAME_ZSTD, ','))
+		return ZBX_COMPRESS_ZSTD;
+#endif
+#ifdef HAVE_LZ4
+	if (SUCCEED == zbx_str_in_list(codecs, ZBX_COMPRESS_NAME_LZ4, ','))
+		return ZBX_COMPRESS_LZ4;
+#endif
+	return ZBX_COMPRESS_ZLIB;
 }
 
 /******************************************************************************
  *                                                                            *
  * Purpose: compress data                                                     *
  *                                                                            *
- * Parameters: in       - [IN] the data to compress                           *
+ * Parameters: codec    - [IN] the compression codec (ZBX_COMPRESS_*)         *
+ *             in       - [IN] the data to compress                           *
  *             size_in  - [IN] the input data size                            *
  *             out      - [OUT] the compressed data                           *
  *             size_out - [OUT] the compressed data size                      *
@@ -76,31 +368,39 @@ const char	*zbx_compress_strerror(void)
  *           caller.                                                          *
  *                                                                            *
  ******************************************************************************/
-int	zbx_compress(const char *in, size_t size_in, char **out, size_t *size_out)
+int	zbx_compress_ext(unsigned char codec, const char *in, size_t size_in, char **out, size_t *size_out)
 {
-	Bytef	*buf;
-	uLongf	buf_size;
-
-	buf_size = compressBound(size_in);
-	buf = (Bytef *)zbx_malloc(NULL, buf_size);
-
-	if (Z_OK != (zbx_zlib_errno = compress(buf, &buf_size, (const Bytef *)in, size_in)))
+	switch (codec)
 	{
-		zbx_free(buf);
-		return FAIL;
+#ifdef HAVE_ZLIB
+		case ZBX_COMPRESS_ZLIB:
+			return zlib_compress(in, size_in, out, size_out);
+#endif
+#ifdef HAVE_ZSTD
+		case ZBX_COMPRESS_ZSTD:
+			return zstd_compress(in, size_in, out, size_out);
+#endif
+#ifdef HAVE_LZ4
+		case ZBX_COMPRESS_LZ4:
+			return lz4_compress(in, size_in, out, size_out);
+#endif
+		default:
+			ZBX_UNUSED(in);
+			ZBX_UNUSED(size_in);
+			ZBX_UNUSED(out);
+			ZBX_UNUSED(size_out);
+			zbx_snprintf(compress_error, sizeof(compress_error), "unsupported compression codec \"%s\"",
+					zbx_compress_codec_name(codec));
+			return FAIL;
 	}
-
-	*out = (char *)buf;
-	*size_out = buf_size;
-
-	return SUCCEED;
 }
 
 /******************************************************************************
  *                                                                            *
  * Purpose: uncompress data                                                   *
  *                                                                            *
- * Parameters: in       - [IN] the data to uncompress                         *
+ * Parameters: codec    - [IN] the compression codec (ZBX_COMPRESS_*)         *
+ *             in       - [IN] the data to uncompress                         *
  *             size_in  - [IN] the input data size                            *
  *             out      - [OUT] the uncompressed data                         *
  *             size_out - [IN/OUT] the buffer and uncompressed data size      *
@@ -109,41 +409,39 @@ int	zbx_compress(const char *in, size_t size_in, char **out, size_t *size_out)
  *               FAIL    - otherwise                                          *
  *                                                                            *
  ******************************************************************************/
-int	zbx_uncompress(const char *in, size_t size_in, char *out, size_t *size_out)
+int	zbx_uncompress_ext(unsigned char codec, const char *in, size_t size_in, char *out, size_t *size_out)
 {
-	uLongf	size_o = *size_out;
-
-	if (Z_OK != (zbx_zlib_errno = uncompress((Bytef *)out, &size_o, (const Bytef *)in, size_in)))
-		return FAIL;
-
-	*size_out = size_o;
-
-	return SUCCEED;
+	switch (codec)
+	{
+#ifdef HAVE_ZLIB
+		case ZBX_COMPRESS_ZLIB:
+			return zlib_uncompress(in, size_in, out, size_out);
+#endif
+#ifdef HAVE_ZSTD
+		case ZBX_COMPRESS_ZSTD:
+			return zstd_uncompress(in, size_in, out, size_out);
+#endif
+#ifdef HAVE_LZ4
+		case ZBX_COMPRESS_LZ4:
+			return lz4_uncompress(in, size_in, out, size_out);
+#endif
+		default:
+			ZBX_UNUSED(in);
+			ZBX_UNUSED(size_in);
+			ZBX_UNUSED(out);
+			ZBX_UNUSED(size_out);
+			zbx_snprintf(compress_error, sizeof(compress_error), "unsupported compression codec \"%s\"",
+					zbx_compress_codec_name(codec));
+			return FAIL;
+	}
 }
 
-#else
-
 int	zbx_compress(const char *in, size_t size_in, char **out, size_t *size_out)
 {
-	ZBX_UNUSED(in);
-	ZBX_UNUSED(size_in);
-	ZBX_UNUSED(out);
-	ZBX_UNUSED(size_out);
-	return FAIL;
+	return zbx_compress_ext(ZBX_COMPRESS_ZLIB, in, size_in, out, size_out);
 }
 
 int	zbx_uncompress(const char *in, size_t size_in, char *out, size_t *size_out)
 {
-	ZBX_UNUSED(in);
-	ZBX_UNUSED(size_in);
-	ZBX_UNUSED(out);
-	ZBX_UNUSED(size_out);
-	return FAIL;
+	return zbx_uncompress_ext(ZBX_COMPRESS_ZLIB, in, size_in, out, size_out);
 }
-
-const char	*zbx_compress_strerror(void)
-{
-	return "";
-}
-
-#endif
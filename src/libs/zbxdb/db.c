@@ -22,6 +22,7 @@
 #include "zbxstr.h"
 #include "zbxtime.h"
 #include "log.h"
+#include "zbxprof.h"
 #include "zbx_dbversion_constants.h"
 
 #if defined(HAVE_MYSQL)
@@ -57,6 +58,7 @@ struct zbx_db_result
 	int		fld_num;
 	int		cursor;
 	zbx_db_row_t	values;
+	char		*cursor_name;	/* name of server side cursor for streamed results */
 #elif defined(HAVE_SQLITE3)
 	int		curow;
 	char		**data;
@@ -77,7 +79,18 @@ static int		config_log_slow_queries;
 static int		db_auto_increment;
 
 #if defined(HAVE_MYSQL)
+typedef struct
+{
+	char		*sql;
+	MYSQL_STMT	*stmt;
+}
+zbx_mysql_statement_t;
+
 static MYSQL			*conn = NULL;
+static MYSQL			*replica_conn = NULL;	/* read-only replica session */
+static zbx_vector_ptr_t		mysql_statements;	/* statements prepared in the current session, */
+							/* the least recently used first */
+static zbx_vector_ptr_t		replica_mysql_statements;
 static zbx_uint32_t		ZBX_MYSQL_SVERSION = ZBX_DBVERSION_UNDEFINED;
 static int			ZBX_MARIADB_SFORK = OFF;
 #elif defined(HAVE_ORACLE)
@@ -109,9 +122,21 @@ static int			ZBX_TSDB_VERSION = -1;
 static zbx_uint32_t		ZBX_PG_SVERSION = ZBX_DBVERSION_UNDEFINED;
 char				ZBX_PG_ESCAPE_BACKSLASH = 1;
 static int 			ZBX_TIMESCALE_COMPRESSION_AVAILABLE = OFF;
+static zbx_vector_str_t		pg_statements;	/* statements prepared in the current session */
+static PGconn			*replica_conn = NULL;	/* read-only replica session */
+static zbx_vector_str_t		replica_pg_statements;
 #elif defined(HAVE_SQLITE3)
+typedef struct
+{
+	char		*sql;
+	sqlite3_stmt	*stmt;
+}
+zbx_sqlite_statement_t;
+
 static sqlite3			*conn = NULL;
 static zbx_mutex_t		sqlite_access = ZBX_MUTEX_NULL;
+static int			sqlite_wal = 0;		/* write-ahead log journal mode is used */
+static zbx_vector_ptr_t		sqlite_statements;	/* statements prepared for the current connection */
 #endif
 
 #if defined(HAVE_ORACLE)
@@ -121,6 +146,10 @@ static void	OCI_DBclean_result(zbx_db_result_t result);
 
 static zbx_err_codes_t last_db_errcode;
 
+#if defined(HAVE_MYSQL) || defined(HAVE_POSTGRESQL)
+static int	replica_active = 0, replica_txn_level, replica_txn_error;
+#endif
+
 static void	zbx_db_errlog(zbx_err_codes_t zbx_errno, int db_errno, const char *db_error, const char *context)
 {
 	char	*s;
@@ -317,6 +346,13 @@ static zbx_db_result_t	zbx_db_select_basic(const char *fmt, ...)
 }
 
 #if defined(HAVE_MYSQL)
+static void	mysql_statement_free(zbx_mysql_statement_t *statement)
+{
+	mysql_stmt_close(statement->stmt);
+	zbx_free(statement->sql);
+	zbx_free(statement);
+}
+
 static int	is_recoverable_mysql_error(int err_no)
 {
 	if (0 == err_no)
@@ -362,6 +398,47 @@ static int	is_recoverable_postgresql_error(const PGconn *pg_conn, const PGresult
 }
 #endif
 
+#if defined(HAVE_SQLITE3)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: switch database to write-ahead log journal mode                   *
+ *                                                                            *
+ * Return value: SUCCEED - the journal mode is write-ahead log                *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: The mode is persistent, it is kept in the database file. The     *
+ *           pragma returns the resulting mode, which stays unchanged if the  *
+ *           file system does not support shared memory required by WAL.      *
+ *                                                                            *
+ ******************************************************************************/
+static int	sqlite_set_journal_mode_wal(void)
+{
+	sqlite3_stmt	*stmt;
+	const char	*mode;
+	int		ret = FAIL;
+
+	if (SQLITE_OK != sqlite3_prepare_v2(conn, "pragma journal_mode=wal", -1, &stmt, NULL))
+		return FAIL;
+
+	if (SQLITE_ROW == sqlite3_step(stmt) && NULL != (mode = (const char *)sqlite3_column_text(stmt, 0)) &&
+			0 == strcmp(mode, "wal"))
+	{
+		ret = SUCCEED;
+	}
+
+	sqlite3_finalize(stmt);
+
+	return ret;
+}
+
+static void	sqlite_statement_free(zbx_sqlite_statement_t *statement)
+{
+	sqlite3_finalize(statement->stmt);
+	zbx_free(statement->sql);
+	zbx_free(statement);
+}
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Purpose: specify the autoincrement options during db connect               *
@@ -426,6 +503,8 @@ int	zbx_db_connect_basic(const zbx_config_dbhigh_t *cfg)
 		exit(EXIT_FAILURE);
 	}
 
+	zbx_vector_ptr_create(&mysql_statements);
+
 	if (1 == db_auto_increment)
 	{
 		/* Shadow global auto_increment variables. */
@@ -767,6 +846,8 @@ int	zbx_db_connect_basic(const zbx_config_dbhigh_t *cfg)
 	keywords[i] = NULL;
 	values[i] = NULL;
 
+	zbx_vector_str_create(&pg_statements);
+
 	conn = PQconnectdbParams(keywords, values, 0);
 
 	zbx_free(cport);
@@ -839,6 +920,8 @@ int	zbx_db_connect_basic(const zbx_config_dbhigh_t *cfg)
 	}
 out:
 #elif defined(HAVE_SQLITE3)
+	zbx_vector_ptr_create(&sqlite_statements);
+
 #ifdef HAVE_FUNCTION_SQLITE3_OPEN_V2
 	if (SQLITE_OK != sqlite3_open_v2(cfg->config_dbname, &conn, SQLITE_OPEN_READWRITE, NULL))
 #else
@@ -865,6 +948,12 @@ out:
 	if (ZBX_DB_OK != ret)
 		goto out;
 
+	/* with write-ahead log readers do not block writers and writers do not block readers */
+	if (SUCCEED == sqlite_set_journal_mode_wal())
+		sqlite_wal = 1;
+	else
+		zabbix_log(LOG_LEVEL_WARNING, "cannot enable write-ahead log journal mode for SQLite database");
+
 	path = zbx_strdup(NULL, cfg->config_dbname);
 
 	if (NULL != (p = strrchr(path, '/')))
@@ -934,6 +1023,10 @@ void	zbx_db_deinit_basic(void)
 void	zbx_db_close_basic(void)
 {
 #if defined(HAVE_MYSQL)
+	/* statements must be closed before the connection can be closed */
+	zbx_vector_ptr_clear_ext(&mysql_statements, (zbx_clean_func_t)mysql_statement_free);
+	zbx_vector_ptr_destroy(&mysql_statements);
+
 	if (NULL != conn)
 	{
 		mysql_close(conn);
@@ -992,7 +1085,15 @@ void	zbx_db_close_basic(void)
 		PQfinish(conn);
 		conn = NULL;
 	}
+
+	/* prepared statements are destroyed together with session */
+	zbx_vector_str_clear_ext(&pg_statements, zbx_str_free);
+	zbx_vector_str_destroy(&pg_statements);
 #elif defined(HAVE_SQLITE3)
+	/* statements must be finalized before the connection can be closed */
+	zbx_vector_ptr_clear_ext(&sqlite_statements, (zbx_clean_func_t)sqlite_statement_free);
+	zbx_vector_ptr_destroy(&sqlite_statements);
+
 	if (NULL != conn)
 	{
 		sqlite3_close(conn);
@@ -1001,6 +1102,132 @@ void	zbx_db_close_basic(void)
 #endif
 }
 
+#if defined(HAVE_MYSQL) || defined(HAVE_POSTGRESQL)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: exchange primary and replica database sessions                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	db_swap_replica(void)
+{
+#if defined(HAVE_MYSQL)
+	MYSQL			*tmp_conn = conn;
+	zbx_vector_ptr_t	tmp_statements = mysql_statements;
+
+	mysql_statements = replica_mysql_statements;
+	replica_mysql_statements = tmp_statements;
+#else
+	PGconn			*tmp_conn = conn;
+	zbx_vector_str_t	tmp_statements = pg_statements;
+
+	pg_statements = replica_pg_statements;
+	replica_pg_statements = tmp_statements;
+#endif
+	conn = replica_conn;
+	replica_conn = tmp_conn;
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: connect to read-only replica database                             *
+ *                                                                            *
+ * Parameters: cfg - [IN] the replica connection configuration                *
+ *                                                                            *
+ * Return value: same as zbx_db_connect_basic()                               *
+ *                                                                            *
+ * Comments: The primary connection stays active, replica session is used     *
+ *           only between zbx_db_replica_switch_basic() and                   *
+ *           zbx_db_replica_restore_basic() calls.                            *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_db_connect_replica_basic(const zbx_config_dbhigh_t *cfg)
+{
+#if defined(HAVE_MYSQL) || defined(HAVE_POSTGRESQL)
+	int	ret, last_txn_level, last_txn_error;
+
+	if (0 != replica_active)
+		return ZBX_DB_FAIL;
+
+	zbx_db_close_replica_basic();
+
+	/* replica session must not inherit the transaction state of primary session */
+	last_txn_level = txn_level;
+	last_txn_error = txn_error;
+	txn_level = 0;
+
+	db_swap_replica();
+	ret = zbx_db_connect_basic(cfg);
+	db_swap_replica();
+
+	txn_level = last_txn_level;
+	txn_error = last_txn_error;
+
+	return ret;
+#else
+	ZBX_UNUSED(cfg);
+
+	return ZBX_DB_FAIL;
+#endif
+}
+
+void	zbx_db_close_replica_basic(void)
+{
+#if defined(HAVE_MYSQL) || defined(HAVE_POSTGRESQL)
+	if (NULL == replica_conn || 0 != replica_active)
+		return;
+
+	db_swap_replica();
+	zbx_db_close_basic();
+	db_swap_replica();
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: route following statements to replica database session            *
+ *                                                                            *
+ * Return value: SUCCEED - replica session is active                          *
+ *               FAIL    - replica is not connected                           *
+ *                                                                            *
+ * Comments: Transaction state of the primary session is preserved, so a      *
+ *           failed replica query does not affect the ongoing transaction.    *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_db_replica_switch_basic(void)
+{
+#if defined(HAVE_MYSQL) || defined(HAVE_POSTGRESQL)
+	if (NULL == replica_conn || 0 != replica_active)
+		return FAIL;
+
+	db_swap_replica();
+
+	replica_txn_level = txn_level;
+	replica_txn_error = txn_error;
+	txn_level = 0;
+	txn_error = ZBX_DB_OK;
+	replica_active = 1;
+
+	return SUCCEED;
+#else
+	return FAIL;
+#endif
+}
+
+void	zbx_db_replica_restore_basic(void)
+{
+#if defined(HAVE_MYSQL) || defined(HAVE_POSTGRESQL)
+	if (0 == replica_active)
+		return;
+
+	db_swap_replica();
+
+	txn_level = replica_txn_level;
+	txn_error = replica_txn_error;
+	replica_active = 0;
+#endif
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: start transaction                                                 *
@@ -1461,7 +1688,7 @@ int	zbx_db_vexecute(const char *fmt, va_list args)
 	char		*error = NULL;
 #endif
 
-	if (0 != config_log_slow_queries)
+	if (0 != config_log_slow_queries || SUCCEED == zbx_prof_probes_enabled())
 		sec = zbx_time();
 
 	sql = zbx_dvsprintf(sql, fmt, args);
@@ -1602,10 +1829,12 @@ lbl_exec:
 		zbx_mutex_unlock(sqlite_access);
 #endif	/* HAVE_SQLITE3 */
 
-	if (0 != config_log_slow_queries)
+	if (0.0 != sec)
 	{
 		sec = zbx_time() - sec;
-		if (sec > (double)config_log_slow_queries / 1000.0)
+		zbx_prof_probe_add(ZBX_PROF_PROBE_DB_QUERY, sec);
+
+		if (0 != config_log_slow_queries && sec > (double)config_log_slow_queries / 1000.0)
 			zabbix_log(LOG_LEVEL_WARNING, "slow query: " ZBX_FS_DBL " sec, \"%s\"", sec, sql);
 	}
 
@@ -1620,114 +1849,626 @@ clean:
 	return ret;
 }
 
+#if defined(HAVE_POSTGRESQL)
 /******************************************************************************
  *                                                                            *
- * Purpose: execute a select statement                                        *
+ * Purpose: checks result of statement which does not return rows             *
  *                                                                            *
- * Return value: data, NULL (on error) or (zbx_db_result_t)ZBX_DB_DOWN        *
+ * Parameters: result - [IN] the statement result                             *
+ *             status - [IN] the expected result status                       *
+ *             sql    - [IN] the statement, used for logging                  *
+ *                                                                            *
+ * Return value: ZBX_DB_OK, ZBX_DB_FAIL (on error) or ZBX_DB_DOWN (on         *
+ *               recoverable error)                                           *
  *                                                                            *
  ******************************************************************************/
-zbx_db_result_t	zbx_db_vselect(const char *fmt, va_list args)
+static int	zbx_postgresql_check_result(const PGresult *result, ExecStatusType status, const char *sql)
 {
-	char		*sql = NULL;
-	zbx_db_result_t	result = NULL;
-	double		sec = 0;
-#if defined(HAVE_ORACLE)
-	sword		err = OCI_SUCCESS;
-	ub4		prefetch_rows = 200, counter;
-
-	ZBX_UNUSED(counter);
-#elif defined(HAVE_POSTGRESQL)
-	char		*error = NULL;
-#elif defined(HAVE_SQLITE3)
-	int		ret = FAIL;
 	char		*error = NULL;
-#endif
+	zbx_err_codes_t	errcode;
+
+	if (NULL == result)
+	{
+		zbx_db_errlog(ERR_Z3005, 0, "result is NULL", sql);
+		return CONNECTION_OK == PQstatus(conn) ? ZBX_DB_FAIL : ZBX_DB_DOWN;
+	}
+
+	if (status == PQresultStatus(result))
+		return ZBX_DB_OK;
+
+	zbx_postgresql_error(&error, result);
+
+	if (0 == zbx_strcmp_null(PQresultErrorField(result, PG_DIAG_SQLSTATE), "23505"))
+		errcode = ERR_Z3008;
+	else
+		errcode = ERR_Z3005;
+
+	zbx_db_errlog(errcode, 0, error, sql);
+	zbx_free(error);
+
+	return SUCCEED == is_recoverable_postgresql_error(conn, result) ? ZBX_DB_DOWN : ZBX_DB_FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: copies data into table with COPY ... FROM STDIN statement         *
+ *                                                                            *
+ * Parameters: sql      - [IN] the COPY ... FROM STDIN statement              *
+ *             data     - [IN] the data in format specified by the statement  *
+ *             data_len - [IN] the data length                                *
+ *                                                                            *
+ * Return value: ZBX_DB_FAIL (on error) or ZBX_DB_DOWN (on recoverable error) *
+ *               or number of rows copied (on success)                        *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_db_copy_basic(const char *sql, const char *data, size_t data_len)
+{
+#define ZBX_PG_COPY_CHUNK_SIZE	ZBX_MEBIBYTE
+	PGresult	*result;
+	int		ret;
+	double		sec = 0;
 
 	if (0 != config_log_slow_queries)
 		sec = zbx_time();
 
-	sql = zbx_dvsprintf(sql, fmt, args);
+	if (0 == txn_level)
+		zabbix_log(LOG_LEVEL_DEBUG, "query without transaction detected");
 
 	if (ZBX_DB_OK != txn_error)
 	{
-		zabbix_log(LOG_LEVEL_DEBUG, "ignoring query [txnlev:%d] [%s] within failed transaction", txn_level, sql);
-		goto clean;
+		zabbix_log(LOG_LEVEL_DEBUG, "ignoring query [txnlev:%d] [%s] within failed transaction", txn_level,
+				sql);
+		return ZBX_DB_FAIL;
 	}
 
-	zabbix_log(LOG_LEVEL_DEBUG, "query [txnlev:%d] [%s]", txn_level, sql);
-
-#if defined(HAVE_MYSQL)
-	result = (zbx_db_result_t)zbx_malloc(NULL, sizeof(struct zbx_db_result));
-	result->result = NULL;
+	zabbix_log(LOG_LEVEL_DEBUG, "query [txnlev:%d] [%s] data:" ZBX_FS_SIZE_T " bytes", txn_level, sql,
+			(zbx_fs_size_t)data_len);
 
-	if (NULL == conn)
+	if (NULL != (result = PQexec(conn, sql)) && PGRES_COPY_IN == PQresultStatus(result))
 	{
-		zbx_db_errlog(ERR_Z3003, 0, NULL, NULL);
+		size_t	offset, size;
 
-		zbx_db_free_result(result);
-		result = NULL;
-	}
-	else
-	{
-		if (0 != mysql_query(conn, sql) || NULL == (result->result = mysql_store_result(conn)))
-		{
-			int err_no;
+		PQclear(result);
 
-			err_no = (int)mysql_errno(conn);
-			zbx_db_errlog(ERR_Z3005, err_no, mysql_error(conn), sql);
+		for (offset = 0; offset < data_len; offset += size)
+		{
+			size = MIN(data_len - offset, ZBX_PG_COPY_CHUNK_SIZE);
 
-			zbx_db_free_result(result);
-			result = (SUCCEED == is_recoverable_mysql_error(err_no) ? (zbx_db_result_t)ZBX_DB_DOWN : NULL);
+			if (1 != PQputCopyData(conn, data + offset, (int)size))
+				break;
 		}
+
+		/* the copy fails with the specified error message if not all data was sent */
+		(void)PQputCopyEnd(conn, offset < data_len ? "cannot send copy data" : NULL);
+
+		result = PQgetResult(conn);
 	}
-#elif defined(HAVE_ORACLE)
-	result = zbx_malloc(NULL, sizeof(struct zbx_db_result));
-	memset(result, 0, sizeof(struct zbx_db_result));
-	zbx_vector_ptr_append(&oracle.db_results, result);
 
-	err = OCIHandleAlloc((dvoid *)oracle.envhp, (dvoid **)&result->stmthp, OCI_HTYPE_STMT, (size_t)0, (dvoid **)0);
+	if (ZBX_DB_OK == (ret = zbx_postgresql_check_result(result, PGRES_COMMAND_OK, sql)))
+		ret = atoi(PQcmdTuples(result));
 
-	/* Prefetching when working with Oracle is needed because otherwise it fetches only 1 row at a time when doing */
-	/* selects (default behavior). There are 2 ways to do prefetching: memory based and rows based. Based on the   */
-	/* study optimal (speed-wise) memory based prefetch is 2 MB. But in case of many subsequent selects CPU usage  */
-	/* jumps up to 100 %. Using rows prefetch with up to 200 rows does not affect CPU usage, it is the same as     */
-	/* without prefetching at all. See ZBX-5920, ZBX-6493 for details.                                             */
-	/*                                                                                                             */
-	/* Tested on Oracle 11gR2.                                                                                     */
-	/*                                                                                                             */
-	/* Oracle info: docs.oracle.com/cd/B28359_01/appdev.111/b28395/oci04sql.htm                                    */
+	PQclear(result);
 
-	if (OCI_SUCCESS == err)
-	{
-		err = OCIAttrSet(result->stmthp, OCI_HTYPE_STMT, &prefetch_rows, sizeof(prefetch_rows),
-				OCI_ATTR_PREFETCH_ROWS, oracle.errhp);
-	}
+	/* consume the remaining results to return connection into idle state */
+	while (NULL != (result = PQgetResult(conn)))
+		PQclear(result);
 
-	if (OCI_SUCCESS == err)
+	if (0 != config_log_slow_queries)
 	{
-		err = OCIStmtPrepare(result->stmthp, oracle.errhp, (text *)sql, (ub4)strlen((char *)sql),
-				(ub4)OCI_NTV_SYNTAX, (ub4)OCI_DEFAULT);
+		sec = zbx_time() - sec;
+		if (sec > (double)config_log_slow_queries / 1000.0)
+			zabbix_log(LOG_LEVEL_WARNING, "slow query: " ZBX_FS_DBL " sec, \"%s\"", sec, sql);
 	}
 
-	if (OCI_SUCCESS == err)
+	if (ZBX_DB_FAIL == ret && 0 < txn_level)
 	{
-		err = OCIStmtExecute(oracle.svchp, result->stmthp, oracle.errhp, (ub4)0, (ub4)0,
-				(CONST OCISnapshot *)NULL, (OCISnapshot *)NULL,
-				0 == txn_level ? OCI_COMMIT_ON_SUCCESS : OCI_DEFAULT);
+		zabbix_log(LOG_LEVEL_DEBUG, "query [%s] failed, setting transaction as failed", sql);
+		txn_error = ZBX_DB_FAIL;
 	}
 
-	if (OCI_SUCCESS == err)
-	{
-		/* get the number of columns in the query */
-		err = OCIAttrGet((void *)result->stmthp, OCI_HTYPE_STMT, (void *)&result->ncolumn,
-				  (ub4 *)0, OCI_ATTR_PARAM_COUNT, oracle.errhp);
-	}
+	return ret;
+#undef ZBX_PG_COPY_CHUNK_SIZE
+}
 
-	if (OCI_SUCCESS != err)
-		goto error;
+/******************************************************************************
+ *                                                                            *
+ * Purpose: executes statement with parameters, preparing it on the first use *
+ *          in the database session                                           *
+ *                                                                            *
+ * Parameters: sql        - [IN] the statement with $1..$N parameters         *
+ *             params_num - [IN] the number of parameters                     *
+ *             params     - [IN] the parameter values in text format, NULL    *
+ *                               for SQL NULL                                 *
+ *                                                                            *
+ * Return value: ZBX_DB_FAIL (on error) or ZBX_DB_DOWN (on recoverable error) *
+ *               or number of rows affected (on success)                      *
+ *                                                                            *
+ * Comments: The prepared statements are identified by the statement text and *
+ *           are kept until the connection is closed, so the statement is     *
+ *           parsed and planned by server once per session, regardless of the *
+ *           number of executions.                                            *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_db_execute_prepared_basic(const char *sql, int params_num, const char * const *params)
+{
+	PGresult	*result;
+	char		name[32];
+	int		i, ret;
+	double		sec = 0;
 
-	assert(0 < result->ncolumn);
+	if (0 != config_log_slow_queries)
+		sec = zbx_time();
+
+	if (0 == txn_level)
+		zabbix_log(LOG_LEVEL_DEBUG, "query without transaction detected");
+
+	if (ZBX_DB_OK != txn_error)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "ignoring query [txnlev:%d] [%s] within failed transaction", txn_level,
+				sql);
+		return ZBX_DB_FAIL;
+	}
+
+	for (i = 0; i < pg_statements.values_num; i++)
+	{
+		if (0 == strcmp(pg_statements.values[i], sql))
+			break;
+	}
+
+	zbx_snprintf(name, sizeof(name), "zbx_stmt_%d", i);
+
+	if (i == pg_statements.values_num)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "prepare [txnlev:%d] [%s] [%s]", txn_level, name, sql);
+
+		result = PQprepare(conn, name, sql, params_num, NULL);
+
+		if (ZBX_DB_OK == (ret = zbx_postgresql_check_result(result, PGRES_COMMAND_OK, sql)))
+			zbx_vector_str_append(&pg_statements, zbx_strdup(NULL, sql));
+
+		PQclear(result);
+
+		if (ZBX_DB_OK != ret)
+			goto out;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "query [txnlev:%d] [%s]", txn_level, name);
+
+	result = PQexecPrepared(conn, name, params_num, params, NULL, NULL, 0);
+
+	if (ZBX_DB_OK == (ret = zbx_postgresql_check_result(result, PGRES_COMMAND_OK, sql)))
+		ret = atoi(PQcmdTuples(result));
+
+	PQclear(result);
+out:
+	if (0 != config_log_slow_queries)
+	{
+		sec = zbx_time() - sec;
+		if (sec > (double)config_log_slow_queries / 1000.0)
+			zabbix_log(LOG_LEVEL_WARNING, "slow query: " ZBX_FS_DBL " sec, \"%s\"", sec, sql);
+	}
+
+	if (ZBX_DB_FAIL == ret && 0 < txn_level)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "query [%s] failed, setting transaction as failed", sql);
+		txn_error = ZBX_DB_FAIL;
+	}
+
+	return ret;
+}
+#elif defined(HAVE_SQLITE3)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: executes statement with parameters, preparing it on the first use *
+ *          for the connection                                                *
+ *                                                                            *
+ * Parameters: sql        - [IN] the statement with $1..$N parameters         *
+ *             params_num - [IN] the number of parameters                     *
+ *             params     - [IN] the parameter values in text format, NULL    *
+ *                               for SQL NULL                                 *
+ *                                                                            *
+ * Return value: ZBX_DB_FAIL (on error) or ZBX_DB_DOWN (on recoverable error) *
+ *               or number of rows affected (on success)                      *
+ *                                                                            *
+ * Comments: The compiled statements are identified by the statement text and *
+ *           are kept until the connection is closed, so repeated inserts are *
+ *           not parsed again. Text parameters are converted by the column    *
+ *           affinity the same way as literals in statement text.             *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_db_execute_prepared_basic(const char *sql, int params_num, const char * const *params)
+{
+	zbx_sqlite_statement_t	*statement = NULL;
+	int			i, err, ret = ZBX_DB_OK;
+	double			sec = 0;
+
+	if (0 != config_log_slow_queries)
+		sec = zbx_time();
+
+	if (0 == txn_level)
+		zabbix_log(LOG_LEVEL_DEBUG, "query without transaction detected");
+
+	if (ZBX_DB_OK != txn_error)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "ignoring query [txnlev:%d] [%s] within failed transaction", txn_level,
+				sql);
+		return ZBX_DB_FAIL;
+	}
+
+	if (0 == txn_level)
+		zbx_mutex_lock(sqlite_access);
+
+	for (i = 0; i < sqlite_statements.values_num; i++)
+	{
+		if (0 == strcmp(((zbx_sqlite_statement_t *)sqlite_statements.values[i])->sql, sql))
+		{
+			statement = (zbx_sqlite_statement_t *)sqlite_statements.values[i];
+			break;
+		}
+	}
+
+	if (NULL == statement)
+	{
+		sqlite3_stmt	*stmt;
+
+		zabbix_log(LOG_LEVEL_DEBUG, "prepare [txnlev:%d] [%s]", txn_level, sql);
+
+		while (SQLITE_BUSY == (err = sqlite3_prepare_v2(conn, sql, -1, &stmt, NULL)))
+			;
+
+		if (SQLITE_OK != err)
+		{
+			zbx_db_errlog(ERR_Z3005, 0, sqlite3_errmsg(conn), sql);
+			ret = (SQLITE_ERROR == err || SQLITE_NOMEM == err || SQLITE_TOOBIG == err ? ZBX_DB_FAIL :
+					ZBX_DB_DOWN);
+			goto out;
+		}
+
+		statement = (zbx_sqlite_statement_t *)zbx_malloc(NULL, sizeof(zbx_sqlite_statement_t));
+		statement->sql = zbx_strdup(NULL, sql);
+		statement->stmt = stmt;
+		zbx_vector_ptr_append(&sqlite_statements, statement);
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "query [txnlev:%d] [%s]", txn_level, sql);
+
+	for (i = 0; i < params_num; i++)
+	{
+		if (NULL == params[i])
+			err = sqlite3_bind_null(statement->stmt, i + 1);
+		else
+			err = sqlite3_bind_text(statement->stmt, i + 1, params[i], -1, SQLITE_STATIC);
+
+		if (SQLITE_OK != err)
+		{
+			zbx_db_errlog(ERR_Z3005, 0, sqlite3_errmsg(conn), sql);
+			ret = ZBX_DB_FAIL;
+			goto reset;
+		}
+	}
+
+	while (SQLITE_BUSY == (err = sqlite3_step(statement->stmt)))
+		sqlite3_reset(statement->stmt);
+
+	if (SQLITE_DONE == err)
+	{
+		ret = sqlite3_changes(conn);
+		goto reset;
+	}
+
+	/* statements compiled with sqlite3_prepare_v2() return the specific error code from sqlite3_step() */
+	zbx_db_errlog(SQLITE_CONSTRAINT == err ? ERR_Z3008 : ERR_Z3005, 0, sqlite3_errmsg(conn), sql);
+
+	switch (err)
+	{
+		case SQLITE_ERROR:
+		case SQLITE_NOMEM:
+		case SQLITE_TOOBIG:
+		case SQLITE_CONSTRAINT:
+		case SQLITE_MISMATCH:
+			ret = ZBX_DB_FAIL;
+			break;
+		default:
+			ret = ZBX_DB_DOWN;
+			break;
+	}
+reset:
+	/* release the parameter values, they are owned by caller */
+	sqlite3_reset(statement->stmt);
+	sqlite3_clear_bindings(statement->stmt);
+out:
+	if (0 == txn_level)
+		zbx_mutex_unlock(sqlite_access);
+
+	if (0 != config_log_slow_queries)
+	{
+		sec = zbx_time() - sec;
+		if (sec > (double)config_log_slow_queries / 1000.0)
+			zabbix_log(LOG_LEVEL_WARNING, "slow query: " ZBX_FS_DBL " sec, \"%s\"", sec, sql);
+	}
+
+	if (ZBX_DB_FAIL == ret && 0 < txn_level)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "query [%s] failed, setting transaction as failed", sql);
+		txn_error = ZBX_DB_FAIL;
+	}
+
+	return ret;
+}
+#elif defined(HAVE_MYSQL)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: logs prepared statement error                                     *
+ *                                                                            *
+ * Parameters: stmt - [IN] the statement handle                               *
+ *             sql  - [IN] the statement, used for logging                    *
+ *                                                                            *
+ * Return value: ZBX_DB_FAIL (on error) or ZBX_DB_DOWN (on recoverable error) *
+ *                                                                            *
+ ******************************************************************************/
+static int	zbx_mysql_statement_error(MYSQL_STMT *stmt, const char *sql)
+{
+	int	err_no;
+
+	err_no = (int)mysql_stmt_errno(stmt);
+	zbx_db_errlog(ER_DUP_ENTRY == err_no ? ERR_Z3008 : ERR_Z3005, err_no, mysql_stmt_error(stmt), sql);
+
+	return SUCCEED == is_recoverable_mysql_error(err_no) ? ZBX_DB_DOWN : ZBX_DB_FAIL;
+}
+
+/* the maximum number of statements kept prepared in one session, limits use of max_prepared_stmt_count */
+#define ZBX_MYSQL_STATEMENTS_MAX	32
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: executes statement with parameters, preparing it on the first use *
+ *          in the database session                                           *
+ *                                                                            *
+ * Parameters: sql        - [IN] the statement with ? parameters              *
+ *             params_num - [IN] the number of parameters                     *
+ *             params     - [IN] the parameter values in text format, NULL    *
+ *                               for SQL NULL                                 *
+ *                                                                            *
+ * Return value: ZBX_DB_FAIL (on error) or ZBX_DB_DOWN (on recoverable error) *
+ *               or number of rows affected (on success)                      *
+ *                                                                            *
+ * Comments: The server-side prepared statements are identified by the        *
+ *           statement text and are kept until the connection is closed or    *
+ *           until the least recently used statement is closed to keep at     *
+ *           most ZBX_MYSQL_STATEMENTS_MAX statements per session.            *
+ *           Parameters are sent as strings and converted by server to the    *
+ *           column types the same way as literals in statement text.         *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_db_execute_prepared_basic(const char *sql, int params_num, const char * const *params)
+{
+	zbx_mysql_statement_t	*statement = NULL;
+	MYSQL_BIND		*binds;
+	unsigned long		*lengths;
+	int			i, ret;
+	double			sec = 0;
+
+	if (0 != config_log_slow_queries)
+		sec = zbx_time();
+
+	if (0 == txn_level)
+		zabbix_log(LOG_LEVEL_DEBUG, "query without transaction detected");
+
+	if (ZBX_DB_OK != txn_error)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "ignoring query [txnlev:%d] [%s] within failed transaction", txn_level,
+				sql);
+		return ZBX_DB_FAIL;
+	}
+
+	if (NULL == conn)
+	{
+		zbx_db_errlog(ERR_Z3003, 0, NULL, NULL);
+		ret = ZBX_DB_FAIL;
+		goto out;
+	}
+
+	for (i = 0; i < mysql_statements.values_num; i++)
+	{
+		if (0 == strcmp(((zbx_mysql_statement_t *)mysql_statements.values[i])->sql, sql))
+		{
+			statement = (zbx_mysql_statement_t *)mysql_statements.values[i];
+			zbx_vector_ptr_remove(&mysql_statements, i);
+			zbx_vector_ptr_append(&mysql_statements, statement);
+			break;
+		}
+	}
+
+	if (NULL == statement)
+	{
+		MYSQL_STMT	*stmt;
+
+		if (ZBX_MYSQL_STATEMENTS_MAX <= mysql_statements.values_num)
+		{
+			mysql_statement_free((zbx_mysql_statement_t *)mysql_statements.values[0]);
+			zbx_vector_ptr_remove(&mysql_statements, 0);
+		}
+
+		zabbix_log(LOG_LEVEL_DEBUG, "prepare [txnlev:%d] [%s]", txn_level, sql);
+
+		if (NULL == (stmt = mysql_stmt_init(conn)))
+		{
+			int	err_no = (int)mysql_errno(conn);
+
+			zbx_db_errlog(ERR_Z3005, err_no, mysql_error(conn), sql);
+			ret = (SUCCEED == is_recoverable_mysql_error(err_no) ? ZBX_DB_DOWN : ZBX_DB_FAIL);
+			goto out;
+		}
+
+		if (0 != mysql_stmt_prepare(stmt, sql, (unsigned long)strlen(sql)))
+		{
+			ret = zbx_mysql_statement_error(stmt, sql);
+			mysql_stmt_close(stmt);
+			goto out;
+		}
+
+		statement = (zbx_mysql_statement_t *)zbx_malloc(NULL, sizeof(zbx_mysql_statement_t));
+		statement->sql = zbx_strdup(NULL, sql);
+		statement->stmt = stmt;
+		zbx_vector_ptr_append(&mysql_statements, statement);
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "query [txnlev:%d] [%s]", txn_level, sql);
+
+	binds = (MYSQL_BIND *)zbx_malloc(NULL, sizeof(MYSQL_BIND) * (size_t)params_num);
+	lengths = (unsigned long *)zbx_malloc(NULL, sizeof(unsigned long) * (size_t)params_num);
+	memset(binds, 0, sizeof(MYSQL_BIND) * (size_t)params_num);
+
+	for (i = 0; i < params_num; i++)
+	{
+		if (NULL == params[i])
+		{
+			binds[i].buffer_type = MYSQL_TYPE_NULL;
+			continue;
+		}
+
+		lengths[i] = (unsigned long)strlen(params[i]);
+
+		binds[i].buffer_type = MYSQL_TYPE_STRING;
+		binds[i].buffer = (void *)params[i];
+		binds[i].buffer_length = lengths[i];
+		binds[i].length = &lengths[i];
+	}
+
+	if (0 != mysql_stmt_bind_param(statement->stmt, binds) || 0 != mysql_stmt_execute(statement->stmt))
+		ret = zbx_mysql_statement_error(statement->stmt, sql);
+	else
+		ret = (int)mysql_stmt_affected_rows(statement->stmt);
+
+	zbx_free(lengths);
+	zbx_free(binds);
+out:
+	if (0 != config_log_slow_queries)
+	{
+		sec = zbx_time() - sec;
+		if (sec > (double)config_log_slow_queries / 1000.0)
+			zabbix_log(LOG_LEVEL_WARNING, "slow query: " ZBX_FS_DBL " sec, \"%s\"", sec, sql);
+	}
+
+	if (ZBX_DB_FAIL == ret && 0 < txn_level)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "query [%s] failed, setting transaction as failed", sql);
+		txn_error = ZBX_DB_FAIL;
+	}
+
+	return ret;
+}
+#undef ZBX_MYSQL_STATEMENTS_MAX
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: execute a select statement                                        *
+ *                                                                            *
+ * Return value: data, NULL (on error) or (zbx_db_result_t)ZBX_DB_DOWN        *
+ *                                                                            *
+ ******************************************************************************/
+zbx_db_result_t	zbx_db_vselect(const char *fmt, va_list args)
+{
+	char		*sql = NULL;
+	zbx_db_result_t	result = NULL;
+	double		sec = 0;
+#if defined(HAVE_ORACLE)
+	sword		err = OCI_SUCCESS;
+	ub4		prefetch_rows = 200, counter;
+
+	ZBX_UNUSED(counter);
+#elif defined(HAVE_POSTGRESQL)
+	char		*error = NULL;
+#elif defined(HAVE_SQLITE3)
+	int		ret = FAIL;
+	char		*error = NULL;
+#endif
+
+	if (0 != config_log_slow_queries || SUCCEED == zbx_prof_probes_enabled())
+		sec = zbx_time();
+
+	sql = zbx_dvsprintf(sql, fmt, args);
+
+	if (ZBX_DB_OK != txn_error)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "ignoring query [txnlev:%d] [%s] within failed transaction", txn_level, sql);
+		goto clean;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "query [txnlev:%d] [%s]", txn_level, sql);
+
+#if defined(HAVE_MYSQL)
+	result = (zbx_db_result_t)zbx_malloc(NULL, sizeof(struct zbx_db_result));
+	result->result = NULL;
+
+	if (NULL == conn)
+	{
+		zbx_db_errlog(ERR_Z3003, 0, NULL, NULL);
+
+		zbx_db_free_result(result);
+		result = NULL;
+	}
+	else
+	{
+		if (0 != mysql_query(conn, sql) || NULL == (result->result = mysql_store_result(conn)))
+		{
+			int err_no;
+
+			err_no = (int)mysql_errno(conn);
+			zbx_db_errlog(ERR_Z3005, err_no, mysql_error(conn), sql);
+
+			zbx_db_free_result(result);
+			result = (SUCCEED == is_recoverable_mysql_error(err_no) ? (zbx_db_result_t)ZBX_DB_DOWN : NULL);
+		}
+	}
+#elif defined(HAVE_ORACLE)
+	result = zbx_malloc(NULL, sizeof(struct zbx_db_result));
+	memset(result, 0, sizeof(struct zbx_db_result));
+	zbx_vector_ptr_append(&oracle.db_results, result);
+
+	err = OCIHandleAlloc((dvoid *)oracle.envhp, (dvoid **)&result->stmthp, OCI_HTYPE_STMT, (size_t)0, (dvoid **)0);
+
+	/* Prefetching when working with Oracle is needed because otherwise it fetches only 1 row at a time when doing */
+	/* selects (default behavior). There are 2 ways to do prefetching: memory based and rows based. Based on the   */
+	/* study optimal (speed-wise) memory based prefetch is 2 MB. But in case of many subsequent selects CPU usage  */
+	/* jumps up to 100 %. Using rows prefetch with up to 200 rows does not affect CPU usage, it is the same as     */
+	/* without prefetching at all. See ZBX-5920, ZBX-6493 for details.                                             */
+	/*                                                                                                             */
+	/* Tested on Oracle 11gR2.                                                                                     */
+	/*                                                                                                             */
+	/* Oracle info: docs.oracle.com/cd/B28359_01/appdev.111/b28395/oci04sql.htm                                    */
+
+	if (OCI_SUCCESS == err)
+	{
+		err = OCIAttrSet(result->stmthp, OCI_HTYPE_STMT, &prefetch_rows, sizeof(prefetch_rows),
+				OCI_ATTR_PREFETCH_ROWS, oracle.errhp);
+	}
+
+	if (OCI_SUCCESS == err)
+	{
+		err = OCIStmtPrepare(result->stmthp, oracle.errhp, (text *)sql, (ub4)strlen((char *)sql),
+				(ub4)OCI_NTV_SYNTAX, (ub4)OCI_DEFAULT);
+	}
+
+	if (OCI_SUCCESS == err)
+	{
+		err = OCIStmtExecute(oracle.svchp, result->stmthp, oracle.errhp, (ub4)0, (ub4)0,
+				(CONST OCISnapshot *)NULL, (OCISnapshot *)NULL,
+				0 == txn_level ? OCI_COMMIT_ON_SUCCESS : OCI_DEFAULT);
+	}
+
+	if (OCI_SUCCESS == err)
+	{
+		/* get the number of columns in the query */
+		err = OCIAttrGet((void *)result->stmthp, OCI_HTYPE_STMT, (void *)&result->ncolumn,
+				  (ub4 *)0, OCI_ATTR_PARAM_COUNT, oracle.errhp);
+	}
+
+	if (OCI_SUCCESS != err)
+		goto error;
+
+	assert(0 < result->ncolumn);
 
 	result->values = zbx_malloc(NULL, result->ncolumn * sizeof(char *));
 	result->clobs = zbx_malloc(NULL, result->ncolumn * sizeof(OCILobLocator *));
@@ -1845,6 +2586,7 @@ error:
 	result->values = NULL;
 	result->cursor = 0;
 	result->row_num = 0;
+	result->cursor_name = NULL;
 
 	if (NULL == result->pg_result)
 		zbx_db_errlog(ERR_Z3005, 0, "result is NULL", sql);
@@ -1869,7 +2611,9 @@ error:
 	else	/* init rownum */
 		result->row_num = PQntuples(result->pg_result);
 #elif defined(HAVE_SQLITE3)
-	if (0 == txn_level)
+	/* in write-ahead log journal mode a read outside transaction sees a consistent snapshot */
+	/* without blocking writers, so it does not have to wait for other processes             */
+	if (0 == txn_level && 0 == sqlite_wal)
 		zbx_mutex_lock(sqlite_access);
 
 	result = zbx_malloc(NULL, sizeof(struct zbx_db_result));
@@ -1900,13 +2644,15 @@ lbl_get_table:
 		}
 	}
 
-	if (0 == txn_level)
+	if (0 == txn_level && 0 == sqlite_wal)
 		zbx_mutex_unlock(sqlite_access);
 #endif	/* HAVE_SQLITE3 */
-	if (0 != config_log_slow_queries)
+	if (0.0 != sec)
 	{
 		sec = zbx_time() - sec;
-		if (sec > (double)config_log_slow_queries / 1000.0)
+		zbx_prof_probe_add(ZBX_PROF_PROBE_DB_QUERY, sec);
+
+		if (0 != config_log_slow_queries && sec > (double)config_log_slow_queries / 1000.0)
 			zabbix_log(LOG_LEVEL_WARNING, "slow query: " ZBX_FS_DBL " sec, \"%s\"", sec, sql);
 	}
 
@@ -1983,7 +2729,7 @@ static size_t	zbx_db_bytea_unescape(u_char *io)
 }
 #endif
 
-#if defined(HAVE_ORACLE)
+#if defined(HAVE_ORACLE) || defined(HAVE_POSTGRESQL)
 static void	db_set_fetch_error(int dberr)
 {
 	if (0 < txn_level)
@@ -1994,6 +2740,139 @@ static void	db_set_fetch_error(int dberr)
 }
 #endif
 
+#if defined(HAVE_POSTGRESQL)
+#define ZBX_PG_CURSOR_FETCH_SIZE	10000
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: fetches next chunk of rows from server side cursor                *
+ *                                                                            *
+ * Parameters: result - [IN/OUT] the streamed select result                   *
+ *                                                                            *
+ * Return value: SUCCEED - rows were fetched or cursor is exhausted           *
+ *               FAIL    - fetch failed, the transaction is marked as failed  *
+ *                                                                            *
+ ******************************************************************************/
+static int	pg_cursor_fetch(zbx_db_result_t result)
+{
+	char	sql[ZBX_CONST_STRLEN("fetch  from ") + MAX_ID_LEN + 64 + 1], *error = NULL;
+
+	PQclear(result->pg_result);
+	result->cursor = 0;
+	result->row_num = 0;
+
+	zbx_snprintf(sql, sizeof(sql), "fetch %d from %s", ZBX_PG_CURSOR_FETCH_SIZE, result->cursor_name);
+	zabbix_log(LOG_LEVEL_DEBUG, "query [txnlev:%d] [%s]", txn_level, sql);
+
+	result->pg_result = PQexec(conn, sql);
+
+	if (PGRES_TUPLES_OK != PQresultStatus(result->pg_result))
+	{
+		zbx_postgresql_error(&error, result->pg_result);
+		zbx_db_errlog(ERR_Z3005, 0, error, sql);
+		zbx_free(error);
+
+		db_set_fetch_error(SUCCEED == is_recoverable_postgresql_error(conn, result->pg_result) ? ZBX_DB_DOWN :
+				ZBX_DB_FAIL);
+
+		PQclear(result->pg_result);
+		result->pg_result = NULL;
+
+		return FAIL;
+	}
+
+	result->row_num = PQntuples(result->pg_result);
+
+	return SUCCEED;
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: executes select statement, fetching rows from database in chunks  *
+ *          instead of receiving the whole result at once                     *
+ *                                                                            *
+ * Comments: On PostgreSQL the rows are read through server side cursor,      *
+ *           which requires a transaction. Outside of transaction and on      *
+ *           other databases this is the same as zbx_db_vselect(). Fetch      *
+ *           errors mark the transaction as failed, so the caller must check  *
+ *           transaction result to detect incomplete data.                    *
+ *           Other queries can be executed while reading streamed result.     *
+ *                                                                            *
+ ******************************************************************************/
+zbx_db_result_t	zbx_db_vselect_stream(const char *fmt, va_list args)
+{
+#if defined(HAVE_POSTGRESQL)
+	static unsigned int	cursor_num;
+	char			*sql, *cursor_name;
+	int			rc;
+	zbx_db_result_t		result;
+
+	if (0 == txn_level)
+		return zbx_db_vselect(fmt, args);
+
+	sql = zbx_dvsprintf(NULL, fmt, args);
+	cursor_name = zbx_dsprintf(NULL, "zbx_cursor_%u", ++cursor_num);
+
+	rc = zbx_db_execute_basic("declare %s no scroll cursor for %s", cursor_name, sql);
+	zbx_free(sql);
+
+	if (ZBX_DB_OK > rc)
+	{
+		zbx_free(cursor_name);
+		db_set_fetch_error(rc);
+
+		return ZBX_DB_DOWN == rc ? (zbx_db_result_t)ZBX_DB_DOWN : NULL;
+	}
+
+	result = (zbx_db_result_t)zbx_malloc(NULL, sizeof(struct zbx_db_result));
+	result->pg_result = NULL;
+	result->values = NULL;
+	result->cursor_name = cursor_name;
+
+	if (SUCCEED != pg_cursor_fetch(result))
+	{
+		zbx_db_free_result(result);
+		return NULL;
+	}
+
+	return result;
+#else
+	return zbx_db_vselect(fmt, args);
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get number of rows in select result                               *
+ *                                                                            *
+ * Return value: number of rows or -1 if it is not known before fetching all  *
+ *               rows                                                         *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_db_get_row_num(zbx_db_result_t result)
+{
+	if (NULL == result)
+		return -1;
+
+#if defined(HAVE_MYSQL)
+	if (NULL == result->result)
+		return -1;
+
+	return (int)mysql_num_rows(result->result);
+#elif defined(HAVE_POSTGRESQL)
+	/* streamed results are received in chunks */
+	if (NULL != result->cursor_name)
+		return -1;
+
+	return result->row_num;
+#elif defined(HAVE_SQLITE3)
+	return result->nrow;
+#else
+	return -1;
+#endif
+}
+
 zbx_db_row_t	zbx_db_fetch_basic(zbx_db_result_t result)
 {
 #if defined(HAVE_ORACLE)
@@ -2111,7 +2990,14 @@ zbx_db_row_t	zbx_db_fetch_basic(zbx_db_result_t result)
 
 	/* EOF */
 	if (result->cursor == result->row_num)
-		return NULL;
+	{
+		/* the last chunk is smaller than fetch size */
+		if (NULL == result->cursor_name || ZBX_PG_CURSOR_FETCH_SIZE != result->row_num)
+			return NULL;
+
+		if (SUCCEED != pg_cursor_fetch(result) || 0 == result->row_num)
+			return NULL;
+	}
 
 	/* init result */
 	result->fld_num = PQnfields(result->pg_result);
@@ -2248,6 +3134,16 @@ void	zbx_db_free_result(zbx_db_result_t result)
 	}
 
 	PQclear(result->pg_result);
+
+	if (NULL != result->cursor_name)
+	{
+		/* cursors are closed by the end of transaction, close it earlier to release resources */
+		if (NULL != conn && ZBX_DB_OK == txn_error)
+			zbx_db_execute_basic("close %s", result->cursor_name);
+
+		zbx_free(result->cursor_name);
+	}
+
 	zbx_free(result);
 #elif defined(HAVE_SQLITE3)
 	if (NULL == result)
@@ -61,14 +61,27 @@
 #	define ZBX_ROW_DL	";\n"
 #endif
 
+#define ZBX_DB_REPLICA_RETRY_DELAY	SEC_PER_MIN	/* delay before reconnecting to failed replica */
+#define ZBX_DB_REPLICA_LAG_PERIOD	10		/* replica lag check period */
+
 static int	connection_failure;
 
+/* the connection was closed by zbx_db_release_idle() and must be reopened on the next request */
+static int	connection_released;
+static time_t	connection_lastused;
+
+/* read-only replica state of the current process */
+static int	replica_connected, replica_nextcheck, replica_lag = -1, replica_reads;
+
 static const zbx_config_dbhigh_t	*zbx_cfg_dbhigh = NULL;
 
 static zbx_dc_get_nextid_func_t				zbx_cb_nextid;
 
 void	zbx_db_close(void)
 {
+	zbx_db_close_replica_basic();
+	replica_connected = 0;
+
 	zbx_db_close_basic();
 }
 
@@ -138,6 +151,7 @@ void	zbx_config_dbhigh_free(zbx_config_dbhigh_t *config_dbhigh)
 	zbx_free(config_dbhigh->config_db_tls_ca_file);
 	zbx_free(config_dbhigh->config_db_tls_cipher);
 	zbx_free(config_dbhigh->config_db_tls_cipher_13);
+	zbx_free(config_dbhigh->config_dbreplica_host);
 
 	zbx_free(config_dbhigh);
 }
@@ -246,6 +260,12 @@ int	zbx_db_connect(int flag)
 		connection_failure = 0;
 	}
 
+	if (ZBX_DB_OK == err)
+	{
+		connection_released = 0;
+		connection_lastused = time(NULL);
+	}
+
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%d", __func__, err);
 
 	return err;
@@ -269,6 +289,208 @@ void	zbx_db_deinit(void)
 	zbx_db_deinit_basic();
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: close replica connection and postpone reconnecting                *
+ *                                                                            *
+ ******************************************************************************/
+static void	db_replica_disconnect(void)
+{
+	zbx_db_close_replica_basic();
+	replica_connected = 0;
+	replica_lag = -1;
+	replica_nextcheck = (int)time(NULL) + ZBX_DB_REPLICA_RETRY_DELAY;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: check replica select result, disconnecting replica if it is down  *
+ *                                                                            *
+ * Return value: the select result or NULL if the select must be repeated on  *
+ *               primary database                                             *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_db_result_t	db_replica_check_result(zbx_db_result_t result)
+{
+	if ((zbx_db_result_t)ZBX_DB_DOWN == result)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "replica database is down: reading from primary database");
+		db_replica_disconnect();
+
+		return NULL;
+	}
+
+	return result;
+}
+
+static zbx_db_result_t	db_replica_vselect(const char *fmt, va_list args)
+{
+	zbx_db_result_t	result;
+
+	if (SUCCEED != zbx_db_replica_switch_basic())
+		return NULL;
+
+	result = zbx_db_vselect(fmt, args);
+	zbx_db_replica_restore_basic();
+
+	return db_replica_check_result(result);
+}
+
+static zbx_db_result_t	db_replica_select_n(const char *query, int n)
+{
+	zbx_db_result_t	result;
+
+	if (SUCCEED != zbx_db_replica_switch_basic())
+		return NULL;
+
+	result = zbx_db_select_n_basic(query, n);
+	zbx_db_replica_restore_basic();
+
+	return db_replica_check_result(result);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: estimate replication lag from HA node heartbeat                   *
+ *                                                                            *
+ * Comments: The nodes update lastaccess every few seconds, so the age of the *
+ *           latest lastaccess seen by replica is an upper estimate of lag.   *
+ *                                                                            *
+ ******************************************************************************/
+static void	db_replica_update_lag(int now)
+{
+	zbx_db_result_t	result;
+	zbx_db_row_t	row;
+
+	replica_lag = -1;
+	replica_nextcheck = now + ZBX_DB_REPLICA_LAG_PERIOD;
+
+	if (NULL == (result = db_replica_select_n("select " ZBX_DB_TIMESTAMP() "-max(lastaccess) from ha_node", 1)))
+		return;
+
+	if (NULL != (row = zbx_db_fetch(result)) && SUCCEED != zbx_db_is_null(row[0]))
+		replica_lag = MAX(0, atoi(row[0]));
+
+	zbx_db_free_result(result);
+
+	if (replica_lag > zbx_cfg_dbhigh->config_dbreplica_max_lag)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "replica database lag %d seconds exceeds %d seconds limit", replica_lag,
+				zbx_cfg_dbhigh->config_dbreplica_max_lag);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: route following selects to read-only replica database             *
+ *                                                                            *
+ * Parameters: clock - [IN] the newest data timestamp the selects depend on   *
+ *                                                                            *
+ * Comments: Replica is used only if it is configured, connected, its lag is  *
+ *           within DBReplicaMaxLag and it is known to contain the data up to *
+ *           the specified timestamp. Otherwise selects go to primary         *
+ *           database as usual. Selects failing on replica are repeated on    *
+ *           primary database.                                                *
+ *           Must be paired with zbx_db_end_replica_read().                   *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_db_begin_replica_read(int clock)
+{
+	int	now;
+
+	if (NULL == zbx_cfg_dbhigh || NULL == zbx_cfg_dbhigh->config_dbreplica_host)
+		return;
+
+	now = (int)time(NULL);
+
+	if (0 == replica_connected)
+	{
+		zbx_config_dbhigh_t	cfg;
+
+		if (now < replica_nextcheck)
+			return;
+
+		cfg = *zbx_cfg_dbhigh;
+		cfg.config_dbhost = cfg.config_dbreplica_host;
+		cfg.config_dbsocket = NULL;
+
+		if (0 != cfg.config_dbreplica_port)
+			cfg.config_dbport = cfg.config_dbreplica_port;
+
+		if (ZBX_DB_OK != zbx_db_connect_replica_basic(&cfg))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot connect to replica database: reading from primary"
+					" database");
+			replica_nextcheck = now + ZBX_DB_REPLICA_RETRY_DELAY;
+			return;
+		}
+
+		replica_connected = 1;
+		replica_nextcheck = now;
+	}
+
+	if (now >= replica_nextcheck)
+		db_replica_update_lag(now);
+
+	/* lag might grow until the next check, account for it */
+	if (0 == replica_connected || 0 > replica_lag || replica_lag > zbx_cfg_dbhigh->config_dbreplica_max_lag ||
+			clock > now - replica_lag - ZBX_DB_REPLICA_LAG_PERIOD)
+	{
+		return;
+	}
+
+	replica_reads = 1;
+}
+
+void	zbx_db_end_replica_read(void)
+{
+	replica_reads = 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: close database connection if it was not used for DBIdleTimeout    *
+ *          seconds                                                           *
+ *                                                                            *
+ * Comments: The connection is reopened on the next database request. Used by *
+ *           processes spending most of the time waiting for work to avoid    *
+ *           holding idle database sessions.                                  *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_db_release_idle(void)
+{
+	if (NULL == zbx_cfg_dbhigh || 0 == zbx_cfg_dbhigh->config_db_idle_timeout || 0 != connection_released)
+		return;
+
+	if (0 < zbx_db_txn_level() || time(NULL) - connection_lastused < zbx_cfg_dbhigh->config_db_idle_timeout)
+		return;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "closing idle database connection");
+
+	zbx_db_close();
+	connection_released = 1;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reopen database connection closed by zbx_db_release_idle()        *
+ *                                                                            *
+ ******************************************************************************/
+static void	db_reconnect_released(void)
+{
+	double	sec;
+
+	connection_lastused = time(NULL);
+
+	if (0 == connection_released)
+		return;
+
+	sec = zbx_time();
+	zbx_db_connect(ZBX_DB_CONNECT_NORMAL);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "reopened idle database connection in " ZBX_FS_DBL " sec", zbx_time() - sec);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: helper function to loop transaction operation while DB is down    *
@@ -303,6 +525,7 @@ static void	DBtxn_operation(int (*txn_operation)(void))
  ******************************************************************************/
 void	zbx_db_begin(void)
 {
+	db_reconnect_released();
 	DBtxn_operation(zbx_db_begin_basic);
 }
 
@@ -371,6 +594,8 @@ void	zbx_db_statement_prepare(const char *sql)
 {
 	int	rc;
 
+	db_reconnect_released();
+
 	rc = zbx_db_statement_prepare_basic(sql);
 
 	while (ZBX_DB_DOWN == rc)
@@ -400,6 +625,8 @@ int	zbx_db_execute(const char *fmt, ...)
 	va_list	args;
 	int	rc;
 
+	db_reconnect_released();
+
 	va_start(args, fmt);
 
 	rc = zbx_db_vexecute(fmt, args);
@@ -434,6 +661,8 @@ int	zbx_db_execute_once(const char *fmt, ...)
 	va_list	args;
 	int	rc;
 
+	db_reconnect_released();
+
 	va_start(args, fmt);
 
 	rc = zbx_db_vexecute(fmt, args);
@@ -479,8 +708,22 @@ zbx_db_result_t	zbx_db_select(const char *fmt, ...)
 	va_list		args;
 	zbx_db_result_t	rc;
 
+	db_reconnect_released();
+
 	va_start(args, fmt);
 
+	if (0 != replica_reads)
+	{
+		va_list	replica_args;
+
+		va_copy(replica_args, args);
+		rc = db_replica_vselect(fmt, replica_args);
+		va_end(replica_args);
+
+		if (NULL != rc)
+			goto out;
+	}
+
 	rc = zbx_db_vselect(fmt, args);
 
 	while ((zbx_db_result_t)ZBX_DB_DOWN == rc)
@@ -495,7 +738,54 @@ zbx_db_result_t	zbx_db_select(const char *fmt, ...)
 			sleep(ZBX_DB_WAIT_DOWN);
 		}
 	}
+out:
+	va_end(args);
+
+	return rc;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: execute a select statement, receiving rows in chunks              *
+ *                                                                            *
+ * Comments: Used for large selects to avoid holding the whole result in      *
+ *           memory, see zbx_db_vselect_stream(). Within transaction the      *
+ *           statement is not retried when database is down, instead the     *
+ *           transaction is marked as failed.                                 *
+ *                                                                            *
+ ******************************************************************************/
+zbx_db_result_t	zbx_db_select_stream(const char *fmt, ...)
+{
+	va_list		args;
+	zbx_db_result_t	rc;
+
+	db_reconnect_released();
+
+	va_start(args, fmt);
+
+	if (0 < zbx_db_txn_level())
+	{
+		if ((zbx_db_result_t)ZBX_DB_DOWN == (rc = zbx_db_vselect_stream(fmt, args)))
+			rc = NULL;
+
+		goto out;
+	}
+
+	rc = zbx_db_vselect(fmt, args);
+
+	while ((zbx_db_result_t)ZBX_DB_DOWN == rc)
+	{
+		zbx_db_close();
+		zbx_db_connect(ZBX_DB_CONNECT_NORMAL);
 
+		if ((zbx_db_result_t)ZBX_DB_DOWN == (rc = zbx_db_vselect(fmt, args)))
+		{
+			zabbix_log(LOG_LEVEL_ERR, "database is down: retrying in %d seconds", ZBX_DB_WAIT_DOWN);
+			connection_failure = 1;
+			sleep(ZBX_DB_WAIT_DOWN);
+		}
+	}
+out:
 	va_end(args);
 
 	return rc;
@@ -512,6 +802,11 @@ zbx_db_result_t	zbx_db_select_n(const char *query, int n)
 {
 	zbx_db_result_t	rc;
 
+	db_reconnect_released();
+
+	if (0 != replica_reads && NULL != (rc = db_replica_select_n(query, n)))
+		return rc;
+
 	rc = zbx_db_select_n_basic(query, n);
 
 	while ((zbx_db_result_t)ZBX_DB_DOWN == rc)
@@ -1196,10 +1491,30 @@ static void	DBadd_condition_alloc_btw(char **sql, size_t *sql_alloc, size_t *sql
  *                               ascending order to be included in WHERE      *
  *             num        - [IN] number of elements in 'values' array         *
  *                                                                            *
+ * Comments: On PostgreSQL large value lists are passed as a single array     *
+ *           literal "<fieldname>=any('{<id1>,<id2>,...}')", which is parsed  *
+ *           as one constant instead of thousands of IN list elements.        *
+ *                                                                            *
  ******************************************************************************/
 void	zbx_db_add_condition_alloc(char **sql, size_t *sql_alloc, size_t *sql_offset, const char *fieldname,
 		const zbx_uint64_t *values, const int num)
 {
+#ifdef HAVE_POSTGRESQL
+	if (MAX_EXPRESSIONS < num)
+	{
+		int	i;
+
+		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, " %s=any('{", fieldname);
+
+		for (i = 0; i < num; i++)
+			zbx_snprintf_alloc(sql, sql_alloc, sql_offset, ZBX_FS_UI64 ",", values[i]);
+
+		(*sql_offset)--;
+		zbx_strcpy_alloc(sql, sql_alloc, sql_offset, "}')");
+
+		return;
+	}
+#endif
 #ifdef HAVE_ORACLE
 	int		start, between_num = 0, in_num = 0, seq_num;
 	int		*seq_len = NULL;
@@ -2868,7 +3183,7 @@ out:
 #endif
 }
 
-#ifdef HAVE_ORACLE
+#if defined(HAVE_ORACLE) || defined(HAVE_POSTGRESQL) || defined(HAVE_SQLITE3) || defined(HAVE_MYSQL)
 /******************************************************************************
  *                                                                            *
  * Purpose: format bulk operation (insert, update) value list                 *
@@ -2967,6 +3282,34 @@ void	zbx_db_insert_clean(zbx_db_insert_t *self)
 	zbx_vector_ptr_destroy(&self->fields);
 }
 
+#if defined(HAVE_MYSQL) || defined(HAVE_POSTGRESQL) || defined(HAVE_SQLITE3)
+/* prepared statements are disabled for the process after insert fails for reasons other than duplicate rows */
+static unsigned char	db_prepared_disabled = 0;
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if bulk inserts can be made with prepared statement        *
+ *                                                                            *
+ * Return value: SUCCEED - prepared statements can be used                    *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Server-side prepared statements are kept in database session,    *
+ *           so on MySQL and PostgreSQL they must be enabled with             *
+ *           DBPreparedInserts configuration parameter.                       *
+ *                                                                            *
+ ******************************************************************************/
+static int	db_prepared_enabled(void)
+{
+	if (0 != db_prepared_disabled)
+		return FAIL;
+#if defined(HAVE_MYSQL) || defined(HAVE_POSTGRESQL)
+	if (NULL == zbx_cfg_dbhigh || 0 == zbx_cfg_dbhigh->config_db_prepared_inserts)
+		return FAIL;
+#endif
+	return SUCCEED;
+}
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Purpose: prepare for database bulk insert operation                        *
@@ -3002,6 +3345,12 @@ void	zbx_db_insert_prepare_dyn(zbx_db_insert_t *self, const zbx_db_table_t *tabl
 	}
 
 	self->autoincrement = -1;
+	self->copy = 0;
+#if defined(HAVE_MYSQL) || defined(HAVE_POSTGRESQL) || defined(HAVE_SQLITE3)
+	self->prepared = (SUCCEED == db_prepared_enabled() ? 1 : 0);
+#else
+	self->prepared = 0;
+#endif
 
 	zbx_vector_ptr_create(&self->fields);
 	zbx_vector_ptr_create(&self->rows);
@@ -3104,7 +3453,9 @@ void	zbx_db_insert_add_values_dyn(zbx_db_insert_t *self, zbx_db_value_t **values
 #ifdef HAVE_ORACLE
 				row[i].str = DBdyn_escape_field_len(field, value->str, ESCAPE_SEQUENCE_OFF);
 #else
-				row[i].str = DBdyn_escape_field_len(field, value->str, ESCAPE_SEQUENCE_ON);
+				row[i].str = DBdyn_escape_field_len(field, value->str,
+						0 == self->copy && 0 == self->prepared ? ESCAPE_SEQUENCE_ON :
+						ESCAPE_SEQUENCE_OFF);
 #endif
 				break;
 			case ZBX_TYPE_INT:
@@ -3223,56 +3574,960 @@ static void	decode_and_escape_binary_value_for_sql(char **sql_insert_data)
 }
 #endif
 
+#if defined(HAVE_MYSQL) || defined(HAVE_POSTGRESQL) || defined(HAVE_SQLITE3)
 /******************************************************************************
  *                                                                            *
- * Purpose: executes the prepared database bulk insert operation              *
+ * Purpose: escapes string values of bulk insert rows added for COPY or       *
+ *          prepared statement so they can be inserted with insert statement  *
  *                                                                            *
  * Parameters: self - [IN] the bulk insert data                               *
  *                                                                            *
- * Return value: Returns SUCCEED if the operation completed successfully or   *
- *               FAIL otherwise.                                              *
- *                                                                            *
  ******************************************************************************/
-int	zbx_db_insert_execute(zbx_db_insert_t *self)
+static void	db_insert_escape_rows(zbx_db_insert_t *self)
 {
-	int			ret = FAIL, i, j;
-	const zbx_db_field_t	*field;
-	char			*sql_command, delim[2] = {',', '('};
-	size_t			sql_command_alloc = 512, sql_command_offset = 0;
-
-#ifndef HAVE_ORACLE
-	char		*sql;
-	size_t		sql_alloc = 16 * ZBX_KIBIBYTE, sql_offset = 0;
-
-#	ifdef HAVE_MYSQL
-	char		*sql_values = NULL;
-	size_t		sql_values_alloc = 0, sql_values_offset = 0;
-#	endif
-#else
-	zbx_db_bind_context_t	*contexts;
-	int			rc, tries = 0;
-#endif
-
-	if (0 == self->rows.values_num)
-		return SUCCEED;
+	int	i, j;
+	char	*str;
 
-	/* process the auto increment field */
-	if (-1 != self->autoincrement)
+	for (i = 0; i < self->rows.values_num; i++)
 	{
-		zbx_uint64_t	id;
-
-		id = zbx_db_get_maxid_num(self->table->table, self->rows.values_num);
+		zbx_db_value_t	*row = (zbx_db_value_t *)self->rows.values[i];
 
-		for (i = 0; i < self->rows.values_num; i++)
+		for (j = 0; j < self->fields.values_num; j++)
 		{
-			zbx_db_value_t	*values = (zbx_db_value_t *)self->rows.values[i];
+			zbx_db_field_t	*field = (zbx_db_field_t *)self->fields.values[j];
 
-			values[self->autoincrement].ui64 = id++;
+			switch (field->type)
+			{
+				case ZBX_TYPE_CHAR:
+				case ZBX_TYPE_TEXT:
+				case ZBX_TYPE_SHORTTEXT:
+				case ZBX_TYPE_LONGTEXT:
+				case ZBX_TYPE_CUID:
+				case ZBX_TYPE_BLOB:
+					str = DBdyn_escape_field_len(field, row[j].str, ESCAPE_SEQUENCE_ON);
+					zbx_free(row[j].str);
+					row[j].str = str;
+					break;
+			}
 		}
 	}
 
-#ifndef HAVE_ORACLE
-	sql = (char *)zbx_malloc(NULL, sql_alloc);
+	self->copy = 0;
+	self->prepared = 0;
+}
+#endif
+
+#if defined(HAVE_POSTGRESQL)
+/* COPY is disabled for the process after it fails for reasons other than duplicate rows */
+static unsigned char	db_copy_disabled = 0;
+
+static void	db_copy_add_uint(char **data, size_t *data_alloc, size_t *data_offset, zbx_uint64_t value, int size)
+{
+	char	buf[sizeof(zbx_uint64_t)];
+	int	i;
+
+	/* binary COPY format uses network byte order */
+	for (i = size - 1; 0 <= i; i--)
+	{
+		buf[i] = (char)(value & 0xff);
+		value >>= 8;
+	}
+
+	zbx_str_memcpy_alloc(data, data_alloc, data_offset, buf, (size_t)size);
+}
+
+static void	db_copy_add_field(char **data, size_t *data_alloc, size_t *data_offset, const char *value,
+		size_t len)
+{
+	db_copy_add_uint(data, data_alloc, data_offset, (zbx_uint64_t)len, 4);
+	zbx_str_memcpy_alloc(data, data_alloc, data_offset, value, len);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds unsigned 64 bit integer as numeric value in binary COPY      *
+ *          format                                                            *
+ *                                                                            *
+ * Comments: Numeric value is stored as the number of base 10000 digits,      *
+ *           weight of the first digit, sign, display scale and the digits.   *
+ *                                                                            *
+ ******************************************************************************/
+static void	db_copy_add_numeric(char **data, size_t *data_alloc, size_t *data_offset, zbx_uint64_t value)
+{
+	zbx_uint64_t	digits[5];	/* 20 decimal digits of unsigned 64 bit integer */
+	int		digits_num = 0;
+
+	for (; 0 != value; value /= 10000)
+		digits[digits_num++] = value % 10000;
+
+	db_copy_add_uint(data, data_alloc, data_offset, (zbx_uint64_t)(8 + 2 * digits_num), 4);
+	db_copy_add_uint(data, data_alloc, data_offset, (zbx_uint64_t)digits_num, 2);
+	db_copy_add_uint(data, data_alloc, data_offset, (zbx_uint64_t)(0 == digits_num ? 0 : digits_num - 1), 2);
+	db_copy_add_uint(data, data_alloc, data_offset, 0, 2);	/* positive sign */
+	db_copy_add_uint(data, data_alloc, data_offset, 0, 2);	/* display scale */
+
+	while (0 < digits_num)
+		db_copy_add_uint(data, data_alloc, data_offset, digits[--digits_num], 2);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: executes the prepared database bulk insert operation with         *
+ *          binary COPY statement                                             *
+ *                                                                            *
+ * Parameters: self - [IN] the bulk insert data                               *
+ *                                                                            *
+ * Return value: Returns SUCCEED if the operation completed successfully or   *
+ *               FAIL otherwise.                                              *
+ *                                                                            *
+ * Comments: Duplicate rows fail the whole statement with the same error code *
+ *           as insert statement, so duplicate handling by callers does not   *
+ *           change.                                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	db_insert_execute_copy(zbx_db_insert_t *self)
+{
+	static const char	header[] = "PGCOPY\n\377\r\n";
+	const zbx_db_field_t	*field;
+	char			*sql = NULL, *data = NULL, *bin = NULL;
+	size_t			sql_alloc = 0, sql_offset = 0, data_alloc = 16 * ZBX_KIBIBYTE, data_offset = 0,
+				bin_alloc = 0, bin_len;
+	int			i, j, rc;
+	union
+	{
+		double		dbl;
+		zbx_uint64_t	ui64;
+	}
+	dbl;
+
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "copy %s (", self->table->table);
+
+	for (i = 0; i < self->fields.values_num; i++)
+	{
+		field = (zbx_db_field_t *)self->fields.values[i];
+
+		if (0 != i)
+			zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, ',');
+		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, field->name);
+	}
+
+	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, ") from stdin (format binary)");
+
+	data = (char *)zbx_malloc(NULL, data_alloc);
+
+	/* signature including terminating zero, flags and header extension length */
+	zbx_str_memcpy_alloc(&data, &data_alloc, &data_offset, header, sizeof(header));
+	db_copy_add_uint(&data, &data_alloc, &data_offset, 0, 4);
+	db_copy_add_uint(&data, &data_alloc, &data_offset, 0, 4);
+
+	for (i = 0; i < self->rows.values_num; i++)
+	{
+		zbx_db_value_t	*values = (zbx_db_value_t *)self->rows.values[i];
+
+		if (SUCCEED == ZBX_CHECK_LOG_LEVEL(LOG_LEVEL_DEBUG))
+		{
+			char	*str;
+
+			str = zbx_db_format_values((zbx_db_field_t **)self->fields.values, values,
+					self->fields.values_num);
+			zabbix_log(LOG_LEVEL_DEBUG, "copy [txnlev:%d] [%s]", zbx_db_txn_level(),
+					ZBX_NULL2EMPTY_STR(str));
+			zbx_free(str);
+		}
+
+		db_copy_add_uint(&data, &data_alloc, &data_offset, (zbx_uint64_t)self->fields.values_num, 2);
+
+		for (j = 0; j < self->fields.values_num; j++)
+		{
+			zbx_db_value_t	*value = &values[j];
+
+			field = (const zbx_db_field_t *)self->fields.values[j];
+
+			switch (field->type)
+			{
+				case ZBX_TYPE_CHAR:
+				case ZBX_TYPE_TEXT:
+				case ZBX_TYPE_SHORTTEXT:
+				case ZBX_TYPE_LONGTEXT:
+				case ZBX_TYPE_CUID:
+					db_copy_add_field(&data, &data_alloc, &data_offset, value->str,
+							strlen(value->str));
+					break;
+				case ZBX_TYPE_BLOB:
+					if (bin_alloc < strlen(value->str) * 3 / 4 + 1)
+					{
+						bin_alloc = strlen(value->str) * 3 / 4 + 1;
+						bin = (char *)zbx_realloc(bin, bin_alloc);
+					}
+
+					zbx_base64_decode(value->str, bin, bin_alloc, &bin_len);
+					db_copy_add_field(&data, &data_alloc, &data_offset, bin, bin_len);
+					break;
+				case ZBX_TYPE_INT:
+					db_copy_add_uint(&data, &data_alloc, &data_offset, 4, 4);
+					db_copy_add_uint(&data, &data_alloc, &data_offset, (zbx_uint32_t)value->i32, 4);
+					break;
+				case ZBX_TYPE_FLOAT:
+					dbl.dbl = value->dbl;
+					db_copy_add_uint(&data, &data_alloc, &data_offset, 8, 4);
+					db_copy_add_uint(&data, &data_alloc, &data_offset, dbl.ui64, 8);
+					break;
+				case ZBX_TYPE_UINT:
+					db_copy_add_numeric(&data, &data_alloc, &data_offset, value->ui64);
+					break;
+				case ZBX_TYPE_ID:
+					/* zero identifiers are inserted as NULL, see zbx_db_sql_id_ins() */
+					if (0 == value->ui64)
+					{
+						db_copy_add_uint(&data, &data_alloc, &data_offset, 0xffffffff, 4);
+						break;
+					}
+
+					db_copy_add_uint(&data, &data_alloc, &data_offset, 8, 4);
+					db_copy_add_uint(&data, &data_alloc, &data_offset, value->ui64, 8);
+					break;
+				default:
+					THIS_SHOULD_NEVER_HAPPEN;
+					exit(EXIT_FAILURE);
+			}
+		}
+	}
+
+	db_copy_add_uint(&data, &data_alloc, &data_offset, 0xffff, 2);	/* file trailer */
+
+	rc = zbx_db_copy_basic(sql, data, data_offset);
+
+	while (ZBX_DB_DOWN == rc)
+	{
+		zbx_db_close();
+		zbx_db_connect(ZBX_DB_CONNECT_NORMAL);
+
+		if (ZBX_DB_DOWN == (rc = zbx_db_copy_basic(sql, data, data_offset)))
+		{
+			zabbix_log(LOG_LEVEL_ERR, "database is down: retrying in %d seconds", ZBX_DB_WAIT_DOWN);
+			connection_failure = 1;
+			sleep(ZBX_DB_WAIT_DOWN);
+		}
+	}
+
+	if (ZBX_DB_FAIL == rc && ERR_Z3008 != zbx_db_last_errcode())
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot insert into table \"%s\" with COPY statement, using insert"
+				" statements instead", self->table->table);
+		db_copy_disabled = 1;
+	}
+
+	zbx_free(bin);
+	zbx_free(data);
+	zbx_free(sql);
+
+	return ZBX_DB_OK <= rc ? SUCCEED : FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: appends text representation of bulk insert column values as       *
+ *          PostgreSQL array literal                                          *
+ *                                                                            *
+ * Parameters: data        - [IN/OUT] the output buffer                       *
+ *             data_alloc  - [IN/OUT] the output buffer size                  *
+ *             data_offset - [IN/OUT] the output buffer offset                *
+ *             self        - [IN] the bulk insert data                        *
+ *             column      - [IN] the column index                            *
+ *                                                                            *
+ ******************************************************************************/
+static void	db_prepared_add_array(char **data, size_t *data_alloc, size_t *data_offset, const zbx_db_insert_t *self,
+		int column)
+{
+	const zbx_db_field_t	*field = (const zbx_db_field_t *)self->fields.values[column];
+	char			*bin = NULL;
+	size_t			bin_alloc = 0, bin_len, k;
+	const char		*ptr;
+	int			i;
+
+	zbx_chrcpy_alloc(data, data_alloc, data_offset, '{');
+
+	for (i = 0; i < self->rows.values_num; i++)
+	{
+		const zbx_db_value_t	*value = &((const zbx_db_value_t *)self->rows.values[i])[column];
+
+		if (0 != i)
+			zbx_chrcpy_alloc(data, data_alloc, data_offset, ',');
+
+		switch (field->type)
+		{
+			case ZBX_TYPE_CHAR:
+			case ZBX_TYPE_TEXT:
+			case ZBX_TYPE_SHORTTEXT:
+			case ZBX_TYPE_LONGTEXT:
+			case ZBX_TYPE_CUID:
+				zbx_chrcpy_alloc(data, data_alloc, data_offset, '"');
+
+				for (ptr = value->str; '\0' != *ptr; ptr++)
+				{
+					if ('"' == *ptr || '\\' == *ptr)
+						zbx_chrcpy_alloc(data, data_alloc, data_offset, '\\');
+					zbx_chrcpy_alloc(data, data_alloc, data_offset, *ptr);
+				}
+
+				zbx_chrcpy_alloc(data, data_alloc, data_offset, '"');
+				break;
+			case ZBX_TYPE_BLOB:
+				if (bin_alloc < strlen(value->str) * 3 / 4 + 1)
+				{
+					bin_alloc = strlen(value->str) * 3 / 4 + 1;
+					bin = (char *)zbx_realloc(bin, bin_alloc);
+				}
+
+				zbx_base64_decode(value->str, bin, bin_alloc, &bin_len);
+
+				/* bytea hex format with the backslash escaped for array literal */
+				zbx_strcpy_alloc(data, data_alloc, data_offset, "\"\\\\x");
+
+				for (k = 0; k < bin_len; k++)
+				{
+					zbx_snprintf_alloc(data, data_alloc, data_offset, "%02x",
+							(unsigned int)(unsigned char)bin[k]);
+				}
+
+				zbx_chrcpy_alloc(data, data_alloc, data_offset, '"');
+				break;
+			case ZBX_TYPE_INT:
+				zbx_snprintf_alloc(data, data_alloc, data_offset, "%d", value->i32);
+				break;
+			case ZBX_TYPE_FLOAT:
+				zbx_snprintf_alloc(data, data_alloc, data_offset, ZBX_FS_DBL64, value->dbl);
+				break;
+			case ZBX_TYPE_UINT:
+				zbx_snprintf_alloc(data, data_alloc, data_offset, ZBX_FS_UI64, value->ui64);
+				break;
+			case ZBX_TYPE_ID:
+				/* zero identifiers are inserted as NULL, see zbx_db_sql_id_ins() */
+				if (0 == value->ui64)
+					zbx_strcpy_alloc(data, data_alloc, data_offset, "NULL");
+				else
+					zbx_snprintf_alloc(data, data_alloc, data_offset, ZBX_FS_UI64, value->ui64);
+				break;
+			default:
+				THIS_SHOULD_NEVER_HAPPEN;
+				exit(EXIT_FAILURE);
+		}
+	}
+
+	zbx_chrcpy_alloc(data, data_alloc, data_offset, '}');
+
+	zbx_free(bin);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: executes bulk insert operation with prepared statement            *
+ *                                                                            *
+ * Parameters: self - [IN] the bulk insert data                               *
+ *                                                                            *
+ * Return value: Returns SUCCEED if the operation completed successfully or   *
+ *               FAIL otherwise.                                              *
+ *                                                                            *
+ * Comments: Each column is passed as a single array parameter and the rows   *
+ *           are expanded with unnest(), so the statement text depends only   *
+ *           on the table and column set and the same prepared statement is   *
+ *           reused regardless of the number of rows.                         *
+ *                                                                            *
+ ******************************************************************************/
+static int	db_insert_execute_prepared(zbx_db_insert_t *self)
+{
+	const zbx_db_field_t	*field;
+	const char		*type;
+	char			*sql = NULL, *data = NULL, **params;
+	size_t			sql_alloc = 0, sql_offset = 0, data_alloc = 16 * ZBX_KIBIBYTE, data_offset = 0,
+				*offsets;
+	int			i, rc;
+
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "insert into %s (", self->table->table);
+
+	for (i = 0; i < self->fields.values_num; i++)
+	{
+		field = (zbx_db_field_t *)self->fields.values[i];
+
+		if (0 != i)
+			zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, ',');
+		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, field->name);
+	}
+
+	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, ") select * from unnest(");
+
+	for (i = 0; i < self->fields.values_num; i++)
+	{
+		field = (zbx_db_field_t *)self->fields.values[i];
+
+		switch (field->type)
+		{
+			case ZBX_TYPE_CHAR:
+			case ZBX_TYPE_CUID:
+				type = "varchar";
+				break;
+			case ZBX_TYPE_TEXT:
+			case ZBX_TYPE_SHORTTEXT:
+			case ZBX_TYPE_LONGTEXT:
+				type = "text";
+				break;
+			case ZBX_TYPE_BLOB:
+				type = "bytea";
+				break;
+			case ZBX_TYPE_INT:
+				type = "integer";
+				break;
+			case ZBX_TYPE_FLOAT:
+				type = "double precision";
+				break;
+			case ZBX_TYPE_UINT:
+				type = "numeric";
+				break;
+			case ZBX_TYPE_ID:
+				type = "bigint";
+				break;
+			default:
+				THIS_SHOULD_NEVER_HAPPEN;
+				exit(EXIT_FAILURE);
+		}
+
+		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "%s$%d::%s[]", 0 == i ? "" : ",", i + 1, type);
+	}
+
+	zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, ')');
+
+	if (SUCCEED == ZBX_CHECK_LOG_LEVEL(LOG_LEVEL_DEBUG))
+	{
+		for (i = 0; i < self->rows.values_num; i++)
+		{
+			char	*str;
+
+			str = zbx_db_format_values((zbx_db_field_t **)self->fields.values,
+					(zbx_db_value_t *)self->rows.values[i], self->fields.values_num);
+			zabbix_log(LOG_LEVEL_DEBUG, "insert [txnlev:%d] [%s]", zbx_db_txn_level(),
+					ZBX_NULL2EMPTY_STR(str));
+			zbx_free(str);
+		}
+	}
+
+	/* all parameters are written into single buffer, pointers are set after the buffer stops growing */
+	data = (char *)zbx_malloc(NULL, data_alloc);
+	offsets = (size_t *)zbx_malloc(NULL, sizeof(size_t) * (size_t)self->fields.values_num);
+	params = (char **)zbx_malloc(NULL, sizeof(char *) * (size_t)self->fields.values_num);
+
+	for (i = 0; i < self->fields.values_num; i++)
+	{
+		offsets[i] = data_offset;
+		db_prepared_add_array(&data, &data_alloc, &data_offset, self, i);
+		zbx_str_memcpy_alloc(&data, &data_alloc, &data_offset, "", 1);
+	}
+
+	for (i = 0; i < self->fields.values_num; i++)
+		params[i] = data + offsets[i];
+
+	rc = zbx_db_execute_prepared_basic(sql, self->fields.values_num, (const char * const *)params);
+
+	while (ZBX_DB_DOWN == rc)
+	{
+		zbx_db_close();
+		zbx_db_connect(ZBX_DB_CONNECT_NORMAL);
+
+		if (ZBX_DB_DOWN == (rc = zbx_db_execute_prepared_basic(sql, self->fields.values_num,
+				(const char * const *)params)))
+		{
+			zabbix_log(LOG_LEVEL_ERR, "database is down: retrying in %d seconds", ZBX_DB_WAIT_DOWN);
+			connection_failure = 1;
+			sleep(ZBX_DB_WAIT_DOWN);
+		}
+	}
+
+	if (ZBX_DB_FAIL == rc && ERR_Z3008 != zbx_db_last_errcode())
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot insert into table \"%s\" with prepared statement, using"
+				" insert statements instead", self->table->table);
+		db_prepared_disabled = 1;
+	}
+
+	zbx_free(params);
+	zbx_free(offsets);
+	zbx_free(data);
+	zbx_free(sql);
+
+	return ZBX_DB_OK <= rc ? SUCCEED : FAIL;
+}
+#elif defined(HAVE_SQLITE3)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: executes bulk insert operation with prepared statement            *
+ *                                                                            *
+ * Parameters: self - [IN] the bulk insert data                               *
+ *                                                                            *
+ * Return value: Returns SUCCEED if the operation completed successfully or   *
+ *               FAIL otherwise.                                              *
+ *                                                                            *
+ * Comments: The statement is compiled once per connection and executed for   *
+ *           every row with the row values bound as parameters, instead of    *
+ *           parsing a separate insert statement for each row.                *
+ *                                                                            *
+ ******************************************************************************/
+static int	db_insert_execute_prepared(zbx_db_insert_t *self)
+{
+	const zbx_db_field_t	*field;
+	char			*sql = NULL, *data = NULL, **params;
+	size_t			sql_alloc = 0, sql_offset = 0, data_alloc = ZBX_KIBIBYTE, data_offset, *offsets;
+	int			i, j, rc = ZBX_DB_OK;
+
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "insert into %s (", self->table->table);
+
+	for (i = 0; i < self->fields.values_num; i++)
+	{
+		field = (zbx_db_field_t *)self->fields.values[i];
+
+		if (0 != i)
+			zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, ',');
+		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, field->name);
+	}
+
+	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, ") values (");
+
+	for (i = 0; i < self->fields.values_num; i++)
+		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "%s$%d", 0 == i ? "" : ",", i + 1);
+
+	zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, ')');
+
+	data = (char *)zbx_malloc(NULL, data_alloc);
+	offsets = (size_t *)zbx_malloc(NULL, sizeof(size_t) * (size_t)self->fields.values_num);
+	params = (char **)zbx_malloc(NULL, sizeof(char *) * (size_t)self->fields.values_num);
+
+	for (i = 0; i < self->rows.values_num && ZBX_DB_OK <= rc; i++)
+	{
+		zbx_db_value_t	*values = (zbx_db_value_t *)self->rows.values[i];
+
+		if (SUCCEED == ZBX_CHECK_LOG_LEVEL(LOG_LEVEL_DEBUG))
+		{
+			char	*str;
+
+			str = zbx_db_format_values((zbx_db_field_t **)self->fields.values, values,
+					self->fields.values_num);
+			zabbix_log(LOG_LEVEL_DEBUG, "insert [txnlev:%d] [%s]", zbx_db_txn_level(),
+					ZBX_NULL2EMPTY_STR(str));
+			zbx_free(str);
+		}
+
+		/* numeric values are formatted into single buffer, pointers are set after it stops growing */
+		data_offset = 0;
+
+		for (j = 0; j < self->fields.values_num; j++)
+		{
+			zbx_db_value_t	*value = &values[j];
+
+			field = (const zbx_db_field_t *)self->fields.values[j];
+			offsets[j] = data_offset;
+
+			switch (field->type)
+			{
+				case ZBX_TYPE_CHAR:
+				case ZBX_TYPE_TEXT:
+				case ZBX_TYPE_SHORTTEXT:
+				case ZBX_TYPE_LONGTEXT:
+				case ZBX_TYPE_CUID:
+				case ZBX_TYPE_BLOB:
+					continue;
+				case ZBX_TYPE_INT:
+					zbx_snprintf_alloc(&data, &data_alloc, &data_offset, "%d", value->i32);
+					break;
+				case ZBX_TYPE_FLOAT:
+					zbx_snprintf_alloc(&data, &data_alloc, &data_offset, ZBX_FS_DBL64, value->dbl);
+					break;
+				case ZBX_TYPE_UINT:
+					zbx_snprintf_alloc(&data, &data_alloc, &data_offset, ZBX_FS_UI64, value->ui64);
+					break;
+				case ZBX_TYPE_ID:
+					/* zero identifiers are inserted as NULL, see zbx_db_sql_id_ins() */
+					if (0 == value->ui64)
+						continue;
+
+					zbx_snprintf_alloc(&data, &data_alloc, &data_offset, ZBX_FS_UI64, value->ui64);
+					break;
+				default:
+					THIS_SHOULD_NEVER_HAPPEN;
+					exit(EXIT_FAILURE);
+			}
+
+			zbx_str_memcpy_alloc(&data, &data_alloc, &data_offset, "", 1);
+		}
+
+		for (j = 0; j < self->fields.values_num; j++)
+		{
+			field = (const zbx_db_field_t *)self->fields.values[j];
+
+			switch (field->type)
+			{
+				case ZBX_TYPE_CHAR:
+				case ZBX_TYPE_TEXT:
+				case ZBX_TYPE_SHORTTEXT:
+				case ZBX_TYPE_LONGTEXT:
+				case ZBX_TYPE_CUID:
+				case ZBX_TYPE_BLOB:
+					params[j] = values[j].str;
+					break;
+				case ZBX_TYPE_ID:
+					params[j] = (0 == values[j].ui64 ? NULL : data + offsets[j]);
+					break;
+				default:
+					params[j] = data + offsets[j];
+			}
+		}
+
+		rc = zbx_db_execute_prepared_basic(sql, self->fields.values_num, (const char * const *)params);
+
+		while (ZBX_DB_DOWN == rc)
+		{
+			zbx_db_close();
+			zbx_db_connect(ZBX_DB_CONNECT_NORMAL);
+
+			if (ZBX_DB_DOWN == (rc = zbx_db_execute_prepared_basic(sql, self->fields.values_num,
+					(const char * const *)params)))
+			{
+				zabbix_log(LOG_LEVEL_ERR, "database is down: retrying in %d seconds", ZBX_DB_WAIT_DOWN);
+				connection_failure = 1;
+				sleep(ZBX_DB_WAIT_DOWN);
+			}
+		}
+	}
+
+	if (ZBX_DB_FAIL == rc && ERR_Z3008 != zbx_db_last_errcode())
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot insert into table \"%s\" with prepared statement, using"
+				" insert statements instead", self->table->table);
+		db_prepared_disabled = 1;
+	}
+
+	zbx_free(params);
+	zbx_free(offsets);
+	zbx_free(data);
+	zbx_free(sql);
+
+	return ZBX_DB_OK <= rc ? SUCCEED : FAIL;
+}
+#elif defined(HAVE_MYSQL)
+/* the maximum number of rows inserted with one prepared statement execution */
+#define ZBX_MYSQL_PREPARED_ROWS_MAX	256
+/* the maximum number of parameters in MySQL prepared statement */
+#define ZBX_MYSQL_PREPARED_PARAMS_MAX	65535
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: creates multi-row insert statement with parameter placeholders    *
+ *                                                                            *
+ * Parameters: self     - [IN] the bulk insert data                           *
+ *             rows_num - [IN] the number of rows in statement                *
+ *                                                                            *
+ * Return value: the insert statement                                         *
+ *                                                                            *
+ * Comments: Binary values are passed in base64 format and decoded by server. *
+ *           Text fields that are not inserted are set to empty string, like  *
+ *           in insert statements, because MySQL text columns have no default *
+ *           values.                                                          *
+ *                                                                            *
+ ******************************************************************************/
+static char	*db_mysql_prepared_sql(const zbx_db_insert_t *self, int rows_num)
+{
+	const zbx_db_field_t	*field;
+	char			*sql = NULL, *row = NULL;
+	size_t			sql_alloc = 0, sql_offset = 0, row_alloc = 0, row_offset = 0;
+	int			i;
+
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "insert into %s (", self->table->table);
+	zbx_chrcpy_alloc(&row, &row_alloc, &row_offset, '(');
+
+	for (i = 0; i < self->fields.values_num; i++)
+	{
+		field = (const zbx_db_field_t *)self->fields.values[i];
+
+		if (0 != i)
+		{
+			zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, ',');
+			zbx_chrcpy_alloc(&row, &row_alloc, &row_offset, ',');
+		}
+
+		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, field->name);
+		zbx_strcpy_alloc(&row, &row_alloc, &row_offset, ZBX_TYPE_BLOB == field->type ? "from_base64(?)" : "?");
+	}
+
+	for (field = (const zbx_db_field_t *)self->table->fields; NULL != field->name; field++)
+	{
+		switch (field->type)
+		{
+			case ZBX_TYPE_BLOB:
+			case ZBX_TYPE_TEXT:
+			case ZBX_TYPE_SHORTTEXT:
+			case ZBX_TYPE_LONGTEXT:
+			case ZBX_TYPE_CUID:
+				if (FAIL != zbx_vector_ptr_search(&self->fields, (void *)field,
+						ZBX_DEFAULT_PTR_COMPARE_FUNC))
+				{
+					continue;
+				}
+
+				zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, ',');
+				zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, field->name);
+				zbx_strcpy_alloc(&row, &row_alloc, &row_offset, ",''");
+				break;
+		}
+	}
+
+	zbx_chrcpy_alloc(&row, &row_alloc, &row_offset, ')');
+	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, ") values ");
+
+	for (i = 0; i < rows_num; i++)
+	{
+		if (0 != i)
+			zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, ',');
+		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, row);
+	}
+
+	zbx_free(row);
+
+	return sql;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: executes bulk insert operation with prepared statement            *
+ *                                                                            *
+ * Parameters: self - [IN] the bulk insert data                               *
+ *                                                                            *
+ * Return value: Returns SUCCEED if the operation completed successfully or   *
+ *               FAIL otherwise.                                              *
+ *                                                                            *
+ * Comments: Rows are inserted with multi-row statements of power of two      *
+ *           rows, so only a few statements are prepared by server for each   *
+ *           table and column set and reused across flushes.                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	db_insert_execute_prepared(zbx_db_insert_t *self)
+{
+	const zbx_db_field_t	*field;
+	char			*sql, *data = NULL, **params;
+	size_t			data_alloc = 16 * ZBX_KIBIBYTE, data_offset, *offsets;
+	int			i, j, k, rows_max, rows_num, params_num, rc = ZBX_DB_OK;
+
+	for (rows_max = ZBX_MYSQL_PREPARED_ROWS_MAX; 1 < rows_max &&
+			ZBX_MYSQL_PREPARED_PARAMS_MAX < rows_max * self->fields.values_num; rows_max /= 2)
+		;
+
+	data = (char *)zbx_malloc(NULL, data_alloc);
+	offsets = (size_t *)zbx_malloc(NULL, sizeof(size_t) * (size_t)(rows_max * self->fields.values_num));
+	params = (char **)zbx_malloc(NULL, sizeof(char *) * (size_t)(rows_max * self->fields.values_num));
+
+	for (i = 0; i < self->rows.values_num && ZBX_DB_OK <= rc; i += rows_num)
+	{
+		for (rows_num = rows_max; rows_num > self->rows.values_num - i; rows_num /= 2)
+			;
+
+		/* numeric values are formatted into single buffer, pointers are set after it stops growing */
+		data_offset = 0;
+
+		for (j = 0; j < rows_num; j++)
+		{
+			zbx_db_value_t	*values = (zbx_db_value_t *)self->rows.values[i + j];
+
+			if (SUCCEED == ZBX_CHECK_LOG_LEVEL(LOG_LEVEL_DEBUG))
+			{
+				char	*str;
+
+				str = zbx_db_format_values((zbx_db_field_t **)self->fields.values, values,
+						self->fields.values_num);
+				zabbix_log(LOG_LEVEL_DEBUG, "insert [txnlev:%d] [%s]", zbx_db_txn_level(),
+						ZBX_NULL2EMPTY_STR(str));
+				zbx_free(str);
+			}
+
+			for (k = 0; k < self->fields.values_num; k++)
+			{
+				zbx_db_value_t	*value = &values[k];
+
+				field = (const zbx_db_field_t *)self->fields.values[k];
+				offsets[j * self->fields.values_num + k] = data_offset;
+
+				switch (field->type)
+				{
+					case ZBX_TYPE_CHAR:
+					case ZBX_TYPE_TEXT:
+					case ZBX_TYPE_SHORTTEXT:
+					case ZBX_TYPE_LONGTEXT:
+					case ZBX_TYPE_CUID:
+					case ZBX_TYPE_BLOB:
+						continue;
+					case ZBX_TYPE_INT:
+						zbx_snprintf_alloc(&data, &data_alloc, &data_offset, "%d", value->i32);
+						break;
+					case ZBX_TYPE_FLOAT:
+						zbx_snprintf_alloc(&data, &data_alloc, &data_offset, ZBX_FS_DBL64,
+								value->dbl);
+						break;
+					case ZBX_TYPE_UINT:
+						zbx_snprintf_alloc(&data, &data_alloc, &data_offset, ZBX_FS_UI64,
+								value->ui64);
+						break;
+					case ZBX_TYPE_ID:
+						/* zero identifiers are inserted as NULL, see zbx_db_sql_id_ins() */
+						if (0 == value->ui64)
+							continue;
+
+						zbx_snprintf_alloc(&data, &data_alloc, &data_offset, ZBX_FS_UI64,
+								value->ui64);
+						break;
+					default:
+						THIS_SHOULD_NEVER_HAPPEN;
+						exit(EXIT_FAILURE);
+				}
+
+				zbx_str_memcpy_alloc(&data, &data_alloc, &data_offset, "", 1);
+			}
+		}
+
+		for (j = 0; j < rows_num; j++)
+		{
+			zbx_db_value_t	*values = (zbx_db_value_t *)self->rows.values[i + j];
+
+			for (k = 0; k < self->fields.values_num; k++)
+			{
+				int	n = j * self->fields.values_num + k;
+
+				field = (const zbx_db_field_t *)self->fields.values[k];
+
+				switch (field->type)
+				{
+					case ZBX_TYPE_CHAR:
+					case ZBX_TYPE_TEXT:
+					case ZBX_TYPE_SHORTTEXT:
+					case ZBX_TYPE_LONGTEXT:
+					case ZBX_TYPE_CUID:
+					case ZBX_TYPE_BLOB:
+						params[n] = values[k].str;
+						break;
+					case ZBX_TYPE_ID:
+						params[n] = (0 == values[k].ui64 ? NULL : data + offsets[n]);
+						break;
+					default:
+						params[n] = data + offsets[n];
+				}
+			}
+		}
+
+		sql = db_mysql_prepared_sql(self, rows_num);
+		params_num = rows_num * self->fields.values_num;
+
+		rc = zbx_db_execute_prepared_basic(sql, params_num, (const char * const *)params);
+
+		while (ZBX_DB_DOWN == rc)
+		{
+			zbx_db_close();
+			zbx_db_connect(ZBX_DB_CONNECT_NORMAL);
+
+			if (ZBX_DB_DOWN == (rc = zbx_db_execute_prepared_basic(sql, params_num,
+					(const char * const *)params)))
+			{
+				zabbix_log(LOG_LEVEL_ERR, "database is down: retrying in %d seconds", ZBX_DB_WAIT_DOWN);
+				connection_failure = 1;
+				sleep(ZBX_DB_WAIT_DOWN);
+			}
+		}
+
+		zbx_free(sql);
+	}
+
+	if (ZBX_DB_FAIL == rc && ERR_Z3008 != zbx_db_last_errcode())
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot insert into table \"%s\" with prepared statement, using"
+				" insert statements instead", self->table->table);
+		db_prepared_disabled = 1;
+	}
+
+	zbx_free(params);
+	zbx_free(offsets);
+	zbx_free(data);
+
+	return ZBX_DB_OK <= rc ? SUCCEED : FAIL;
+}
+#undef ZBX_MYSQL_PREPARED_PARAMS_MAX
+#undef ZBX_MYSQL_PREPARED_ROWS_MAX
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: executes the prepared database bulk insert operation              *
+ *                                                                            *
+ * Parameters: self - [IN] the bulk insert data                               *
+ *                                                                            *
+ * Return value: Returns SUCCEED if the operation completed successfully or   *
+ *               FAIL otherwise.                                              *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_db_insert_execute(zbx_db_insert_t *self)
+{
+	int			ret = FAIL, i, j;
+	const zbx_db_field_t	*field;
+	char			*sql_command, delim[2] = {',', '('};
+	size_t			sql_command_alloc = 512, sql_command_offset = 0;
+
+#ifndef HAVE_ORACLE
+	char		*sql;
+	size_t		sql_alloc = 16 * ZBX_KIBIBYTE, sql_offset = 0;
+
+#	ifdef HAVE_MYSQL
+	char		*sql_values = NULL;
+	size_t		sql_values_alloc = 0, sql_values_offset = 0;
+#	endif
+#else
+	zbx_db_bind_context_t	*contexts;
+	int			rc, tries = 0;
+#endif
+
+	if (0 == self->rows.values_num)
+		return SUCCEED;
+
+	/* process the auto increment field */
+	if (-1 != self->autoincrement)
+	{
+		zbx_uint64_t	id;
+
+		id = zbx_db_get_maxid_num(self->table->table, self->rows.values_num);
+
+		for (i = 0; i < self->rows.values_num; i++)
+		{
+			zbx_db_value_t	*values = (zbx_db_value_t *)self->rows.values[i];
+
+			values[self->autoincrement].ui64 = id++;
+		}
+	}
+
+#if defined(HAVE_POSTGRESQL)
+	if (0 != self->copy && 0 == db_copy_disabled)
+		return db_insert_execute_copy(self);
+
+	/* rows added for COPY statement are also suitable for prepared statement */
+	if (0 != self->copy || 0 != self->prepared)
+	{
+		if (SUCCEED == db_prepared_enabled())
+			return db_insert_execute_prepared(self);
+
+		db_insert_escape_rows(self);
+	}
+#elif defined(HAVE_MYSQL) || defined(HAVE_SQLITE3)
+	if (0 != self->prepared)
+	{
+		if (SUCCEED == db_prepared_enabled())
+			return db_insert_execute_prepared(self);
+
+		db_insert_escape_rows(self);
+	}
+#endif
+
+#ifndef HAVE_ORACLE
+	sql = (char *)zbx_malloc(NULL, sql_alloc);
 #endif
 	sql_command = (char *)zbx_malloc(NULL, sql_command_alloc);
 
@@ -3507,6 +4762,29 @@ void	zbx_db_insert_autoincrement(zbx_db_insert_t *self, const char *field_name)
 	exit(EXIT_FAILURE);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: makes bulk insert operation use COPY statement                    *
+ *                                                                            *
+ * Parameters: self - [IN] the bulk insert data                               *
+ *                                                                            *
+ * Comments: COPY is supported only by PostgreSQL, for other databases the    *
+ *           rows are inserted with insert statements. This function must be  *
+ *           called before adding rows. If COPY statement fails for reasons   *
+ *           other than duplicate rows, the process falls back to insert      *
+ *           statements.                                                      *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_db_insert_use_copy(zbx_db_insert_t *self)
+{
+#if defined(HAVE_POSTGRESQL)
+	if (0 == self->rows.values_num)
+		self->copy = 1;
+#else
+	ZBX_UNUSED(self);
+#endif
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: determine is it a server or a proxy database                      *
@@ -139,6 +139,8 @@ ZBX_THREAD_ENTRY(zbx_dbsyncer_thread, args)
 	if (1 == process_num)
 		db_trigger_queue_cleanup();
 
+	zbx_hc_set_sync_shards(process_num, dbsyncer_args->config_histsyncer_forks);
+
 	zbx_unblock_signals(&orig_mask);
 
 	if (SUCCEED == zbx_is_export_enabled(ZBX_FLAG_EXPTYPE_HISTORY))
@@ -156,6 +158,21 @@ ZBX_THREAD_ENTRY(zbx_dbsyncer_thread, args)
 
 		zbx_prof_update(get_process_type_string(process_type), sec);
 
+		if (1 == process_num && 0 != dbsyncer_args->config_histsyncer_min)
+		{
+			zbx_hc_scale_syncers(dbsyncer_args->config_histsyncer_min,
+					dbsyncer_args->config_histsyncer_forks);
+		}
+
+		/* parked syncer waits until it is activated again by the first syncer */
+		if (ZBX_IS_RUNNING() && SUCCEED != zbx_hc_sync_is_active())
+		{
+			zbx_setproctitle("%s #%d [parked]", process_name, process_num);
+			sleeptime = dbsyncer_args->config_histsyncer_frequency;
+			zbx_sleep_loop(info, sleeptime);
+			continue;
+		}
+
 		if (0 != sleeptime)
 			zbx_setproctitle("%s #%d [%s, syncing history]", process_name, process_num, stats);
 
@@ -177,7 +194,11 @@ ZBX_THREAD_ENTRY(zbx_dbsyncer_thread, args)
 
 		total_values_num += values_num;
 		total_triggers_num += triggers_num;
-		total_sec += zbx_time() - sec;
+		sec = zbx_time() - sec;
+		total_sec += sec;
+
+		if (0 != values_num)
+			zbx_prof_probe_add(ZBX_PROF_PROBE_HISTORY_SYNC, sec);
 
 		sleeptime = (ZBX_SYNC_MORE == more ? 0 : dbsyncer_args->config_histsyncer_frequency);
 
@@ -229,6 +250,7 @@ ZBX_THREAD_ENTRY(zbx_dbsyncer_thread, args)
 	zbx_unblock_signals(&orig_mask);
 
 	zbx_log_sync_history_cache_progress();
+	zbx_hc_modules_stop();
 
 	if (SUCCEED == zbx_is_export_enabled(ZBX_FLAG_EXPTYPE_HISTORY))
 		zbx_export_deinit(history_export);
@@ -0,0 +1,144 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxdbsyncer.h"
+
+#include "log.h"
+#include "zbxnix.h"
+#include "zbxself.h"
+#include "zbxtime.h"
+#include "zbxcachehistory.h"
+#include "zbxprof.h"
+#include "zbxdbhigh.h"
+#include "zbxstr.h"
+#include "zbxthreads.h"
+
+static sigset_t	orig_mask;
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: writes trends of completed hours passed by history syncers to     *
+ *          database, so history syncers do not wait for trend updates        *
+ *                                                                            *
+ * Comments: never returns                                                    *
+ *                                                                            *
+ ******************************************************************************/
+ZBX_THREAD_ENTRY(zbx_trendwriter_thread, args)
+{
+	int			sleeptime = -1, total_trends_num = 0, trends_num, more;
+	double			sec, total_sec = 0.0;
+	time_t			last_stat_time;
+	char			*stats = NULL;
+	const char		*process_name;
+	size_t			stats_alloc = 0, stats_offset = 0;
+	const zbx_thread_info_t	*info = &((zbx_thread_args_t *)args)->info;
+	int			server_num = ((zbx_thread_args_t *)args)->info.server_num;
+	int			process_num = ((zbx_thread_args_t *)args)->info.process_num;
+	unsigned char		process_type = ((zbx_thread_args_t *)args)->info.process_type;
+
+	zbx_thread_dbsyncer_args	*dbsyncer_args = (zbx_thread_dbsyncer_args *)
+			(((zbx_thread_args_t *)args)->args);
+
+	zabbix_log(LOG_LEVEL_INFORMATION, "%s #%d started [%s #%d]", get_program_type_string(info->program_type),
+			server_num, (process_name = get_process_type_string(process_type)), process_num);
+
+	zbx_update_selfmon_counter(info, ZBX_PROCESS_STATE_BUSY);
+
+#define STAT_INTERVAL	5	/* if a process is busy and does not sleep then update status not faster than */
+				/* once in STAT_INTERVAL seconds */
+
+	zbx_setproctitle("%s #%d [connecting to the database]", process_name, process_num);
+	last_stat_time = time(NULL);
+
+	zbx_strcpy_alloc(&stats, &stats_alloc, &stats_offset, "started");
+
+	/* database APIs might not handle signals correctly and hang, block signals to avoid hanging */
+	zbx_block_signals(&orig_mask);
+	zbx_db_connect(ZBX_DB_CONNECT_NORMAL);
+	zbx_unblock_signals(&orig_mask);
+
+	zbx_dc_set_trend_writer(1);
+
+	for (;;)
+	{
+		sec = zbx_time();
+
+		zbx_prof_update(process_name, sec);
+
+		if (0 != sleeptime)
+			zbx_setproctitle("%s #%d [%s, writing trends]", process_name, process_num, stats);
+
+		/* history syncers write trends themselves while the queue is drained at exit */
+		if (!ZBX_IS_RUNNING())
+			zbx_dc_set_trend_writer(0);
+
+		/* database APIs might not handle signals correctly and hang, block signals to avoid hanging */
+		zbx_block_signals(&orig_mask);
+
+		zbx_prof_start(__func__, ZBX_PROF_PROCESSING);
+		zbx_dc_write_queued_trends(&trends_num, &more);
+		zbx_prof_end();
+
+		zbx_unblock_signals(&orig_mask);
+
+		total_trends_num += trends_num;
+		total_sec += zbx_time() - sec;
+
+		sleeptime = (ZBX_SYNC_MORE == more ? 0 : dbsyncer_args->config_histsyncer_frequency);
+
+		if (0 != sleeptime || STAT_INTERVAL <= time(NULL) - last_stat_time)
+		{
+			stats_offset = 0;
+			zbx_snprintf_alloc(&stats, &stats_alloc, &stats_offset, "written %d trends in " ZBX_FS_DBL
+					" sec", total_trends_num, total_sec);
+
+			if (0 == sleeptime)
+			{
+				zbx_setproctitle("%s #%d [%s, writing trends]", process_name, process_num, stats);
+			}
+			else
+			{
+				zbx_setproctitle("%s #%d [%s, idle %d sec]", process_name, process_num, stats,
+						sleeptime);
+			}
+
+			total_trends_num = 0;
+			total_sec = 0.0;
+			last_stat_time = time(NULL);
+		}
+
+		if (ZBX_SYNC_MORE == more)
+			continue;
+
+		if (!ZBX_IS_RUNNING())
+			break;
+
+		zbx_sleep_loop(info, sleeptime);
+	}
+
+	/* database APIs might not handle signals correctly and hang, block signals to avoid hanging */
+	zbx_block_signals(&orig_mask);
+	zbx_db_close();
+	zbx_unblock_signals(&orig_mask);
+
+	zbx_free(stats);
+
+	exit(EXIT_SUCCESS);
+#undef STAT_INTERVAL
+}
@@ -0,0 +1,567 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "history_binary.h"
+
+#include "zbxserialize.h"
+#include "zbxcrypto.h"
+#include "zbxnum.h"
+#include "zbx_item_constants.h"
+
+/******************************************************************************
+ *                                                                            *
+ * Binary history data is a compact alternative to the JSON 'history data'    *
+ * array sent by proxy to server. Records are split into columns, so values   *
+ * of the same kind are stored together:                                      *
+ *                                                                            *
+ *   id, itemid, clock - delta from the previous record, zigzag encoded       *
+ *   ns                - value                                                *
+ *   flags             - one byte per record, see ZBX_HISTORY_BINARY_FLAG_*   *
+ *   numeric           - unsigned integer values or 8 byte little endian      *
+ *                       IEEE 754 floating point values                       *
+ *   attributes        - state, log attributes and meta information           *
+ *   strings           - length prefixed string values and log sources        *
+ *                                                                            *
+ * Integers are stored with zbx_serialize_uint64_compact(). The block starts  *
+ * with format version and number of records followed by the columns, each    *
+ * prefixed with its size. The block is base64 encoded to be sent in JSON.    *
+ *                                                                            *
+ ******************************************************************************/
+
+#define ZBX_HISTORY_BINARY_VERSION	1
+
+#define ZBX_HISTORY_BINARY_VALUE_NONE	0x00
+#define ZBX_HISTORY_BINARY_VALUE_STR	0x01
+#define ZBX_HISTORY_BINARY_VALUE_UI64	0x02
+#define ZBX_HISTORY_BINARY_VALUE_DBL	0x03
+#define ZBX_HISTORY_BINARY_VALUE_MASK	0x03
+
+#define ZBX_HISTORY_BINARY_FLAG_STATE	0x04
+#define ZBX_HISTORY_BINARY_FLAG_META	0x08
+#define ZBX_HISTORY_BINARY_FLAG_LOG	0x10
+
+#define ZBX_HISTORY_BINARY_ZIGZAG_ENCODE(delta)	\
+	(((delta) << 1) ^ (0 != ((delta) >> 63) ? ~__UINT64_C(0) : __UINT64_C(0)))
+#define ZBX_HISTORY_BINARY_ZIGZAG_DECODE(value)	\
+	(((value) >> 1) ^ (0 != ((value) & 1) ? ~__UINT64_C(0) : __UINT64_C(0)))
+
+static void	history_binary_column_reserve(zbx_history_binary_column_t *column, size_t size)
+{
+	if (column->data_alloc - column->data_offset >= size)
+		return;
+
+	while (column->data_alloc - column->data_offset < size)
+		column->data_alloc = 0 == column->data_alloc ? ZBX_KIBIBYTE : column->data_alloc * 2;
+
+	column->data = (unsigned char *)zbx_realloc(column->data, column->data_alloc);
+}
+
+static void	history_binary_column_add_uint64(zbx_history_binary_column_t *column, zbx_uint64_t value)
+{
+	history_binary_column_reserve(column, ZBX_SERIALIZE_UINT64_COMPACT_MAX);
+	column->data_offset += zbx_serialize_uint64_compact(column->data + column->data_offset, value);
+}
+
+static void	history_binary_column_add_int(zbx_history_binary_column_t *column, int value)
+{
+	zbx_uint64_t	value_ui64 = (zbx_uint64_t)(zbx_int64_t)value;
+
+	history_binary_column_add_uint64(column, ZBX_HISTORY_BINARY_ZIGZAG_ENCODE(value_ui64));
+}
+
+static void	history_binary_column_add_delta(zbx_history_binary_column_t *column, zbx_uint64_t *last,
+		zbx_uint64_t value)
+{
+	zbx_uint64_t	delta = value - *last;
+
+	history_binary_column_add_uint64(column, ZBX_HISTORY_BINARY_ZIGZAG_ENCODE(delta));
+	*last = value;
+}
+
+static void	history_binary_column_add_str(zbx_history_binary_column_t *column, const char *str)
+{
+	size_t	len;
+
+	len = strlen(str);
+	history_binary_column_add_uint64(column, (zbx_uint64_t)len);
+	history_binary_column_reserve(column, len);
+	memcpy(column->data + column->data_offset, str, len);
+	column->data_offset += len;
+}
+
+static void	history_binary_column_add_double(zbx_history_binary_column_t *column, double value)
+{
+	zbx_uint64_t	bits;
+
+	memcpy(&bits, &value, sizeof(bits));
+	bits = zbx_htole_uint64(bits);
+
+	history_binary_column_reserve(column, sizeof(bits));
+	memcpy(column->data + column->data_offset, &bits, sizeof(bits));
+	column->data_offset += sizeof(bits);
+}
+
+void	zbx_history_binary_writer_init(zbx_history_binary_writer_t *writer)
+{
+	memset(writer, 0, sizeof(zbx_history_binary_writer_t));
+}
+
+void	zbx_history_binary_writer_destroy(zbx_history_binary_writer_t *writer)
+{
+	int	i;
+
+	for (i = 0; i < ZBX_HISTORY_BINARY_COLUMN_COUNT; i++)
+		zbx_free(writer->columns[i].data);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds proxy history record to binary history data                  *
+ *                                                                            *
+ * Parameters: writer        - [IN/OUT] the binary history data writer        *
+ *             hd            - [IN] the history record                        *
+ *             string_buffer - [IN] the string buffer holding string values   *
+ *             value_type    - [IN] the item value type                       *
+ *                                                                            *
+ * Comments: The record fields are stored under the same conditions as they   *
+ *           are added to JSON history data. Values of numeric items are      *
+ *           stored in numeric form if they can be converted.                 *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_history_binary_writer_add(zbx_history_binary_writer_t *writer, const zbx_proxy_history_data_t *hd,
+		const char *string_buffer, unsigned char value_type)
+{
+	zbx_history_binary_column_t	*columns = writer->columns;
+	unsigned char			flags = ZBX_HISTORY_BINARY_VALUE_NONE;
+	const char			*value = NULL, *source = NULL;
+	zbx_uint64_t			value_ui64 = 0;
+	double				value_dbl = 0;
+
+	if (ZBX_PROXY_HISTORY_FLAG_NOVALUE != (hd->flags & ZBX_PROXY_HISTORY_MASK_NOVALUE))
+	{
+		if (ITEM_STATE_NORMAL != hd->state)
+			flags |= ZBX_HISTORY_BINARY_FLAG_STATE;
+
+		if (0 == (hd->flags & ZBX_PROXY_HISTORY_FLAG_NOVALUE))
+		{
+			value = string_buffer + hd->value_offset;
+			source = string_buffer + hd->source_offset;
+
+			if (0 != hd->timestamp || '\0' != *source || 0 != hd->severity || 0 != hd->logeventid)
+				flags |= ZBX_HISTORY_BINARY_FLAG_LOG;
+
+			if (ITEM_STATE_NORMAL == hd->state && ITEM_VALUE_TYPE_UINT64 == value_type &&
+					SUCCEED == zbx_is_uint64(value, &value_ui64))
+			{
+				flags |= ZBX_HISTORY_BINARY_VALUE_UI64;
+			}
+			else if (ITEM_STATE_NORMAL == hd->state && ITEM_VALUE_TYPE_FLOAT == value_type &&
+					SUCCEED == zbx_is_double(value, &value_dbl))
+			{
+				flags |= ZBX_HISTORY_BINARY_VALUE_DBL;
+			}
+			else
+				flags |= ZBX_HISTORY_BINARY_VALUE_STR;
+		}
+
+		if (0 != (hd->flags & ZBX_PROXY_HISTORY_FLAG_META))
+			flags |= ZBX_HISTORY_BINARY_FLAG_META;
+	}
+
+	history_binary_column_add_delta(&columns[ZBX_HISTORY_BINARY_COLUMN_ID], &writer->last_id, hd->id);
+	history_binary_column_add_delta(&columns[ZBX_HISTORY_BINARY_COLUMN_ITEMID], &writer->last_itemid,
+			hd->itemid);
+	history_binary_column_add_delta(&columns[ZBX_HISTORY_BINARY_COLUMN_CLOCK], &writer->last_clock,
+			(zbx_uint64_t)hd->clock);
+	history_binary_column_add_uint64(&columns[ZBX_HISTORY_BINARY_COLUMN_NS], (zbx_uint64_t)hd->ns);
+
+	history_binary_column_reserve(&columns[ZBX_HISTORY_BINARY_COLUMN_FLAGS], 1);
+	columns[ZBX_HISTORY_BINARY_COLUMN_FLAGS].data[columns[ZBX_HISTORY_BINARY_COLUMN_FLAGS].data_offset++] =
+			flags;
+
+	if (0 != (flags & ZBX_HISTORY_BINARY_FLAG_STATE))
+		history_binary_column_add_int(&columns[ZBX_HISTORY_BINARY_COLUMN_ATTRIBUTES], hd->state);
+
+	if (0 != (flags & ZBX_HISTORY_BINARY_FLAG_LOG))
+	{
+		history_binary_column_add_int(&columns[ZBX_HISTORY_BINARY_COLUMN_ATTRIBUTES], hd->timestamp);
+		history_binary_column_add_int(&columns[ZBX_HISTORY_BINARY_COLUMN_ATTRIBUTES], hd->severity);
+		history_binary_column_add_int(&columns[ZBX_HISTORY_BINARY_COLUMN_ATTRIBUTES], hd->logeventid);
+		history_binary_column_add_str(&columns[ZBX_HISTORY_BINARY_COLUMN_STRINGS], source);
+	}
+
+	switch (flags & ZBX_HISTORY_BINARY_VALUE_MASK)
+	{
+		case ZBX_HISTORY_BINARY_VALUE_STR:
+			history_binary_column_add_str(&columns[ZBX_HISTORY_BINARY_COLUMN_STRINGS], value);
+			break;
+		case ZBX_HISTORY_BINARY_VALUE_UI64:
+			history_binary_column_add_uint64(&columns[ZBX_HISTORY_BINARY_COLUMN_NUMERIC], value_ui64);
+			break;
+		case ZBX_HISTORY_BINARY_VALUE_DBL:
+			history_binary_column_add_double(&columns[ZBX_HISTORY_BINARY_COLUMN_NUMERIC], value_dbl);
+			break;
+	}
+
+	if (0 != (flags & ZBX_HISTORY_BINARY_FLAG_META))
+	{
+		history_binary_column_add_uint64(&columns[ZBX_HISTORY_BINARY_COLUMN_ATTRIBUTES], hd->lastlogsize);
+		history_binary_column_add_int(&columns[ZBX_HISTORY_BINARY_COLUMN_ATTRIBUTES], hd->mtime);
+	}
+
+	writer->rows_num++;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns approximate size of encoded binary history data           *
+ *                                                                            *
+ ******************************************************************************/
+size_t	zbx_history_binary_writer_size(const zbx_history_binary_writer_t *writer)
+{
+	size_t	size = 0;
+	int	i;
+
+	for (i = 0; i < ZBX_HISTORY_BINARY_COLUMN_COUNT; i++)
+		size += writer->columns[i].data_offset;
+
+	/* base64 encoding adds 4 bytes per 3 input bytes */
+	return size / 3 * 4 + 4;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds binary history data to output json                           *
+ *                                                                            *
+ * Parameters: writer - [IN] the binary history data writer                   *
+ *             j      - [OUT] the json output buffer                          *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_history_binary_writer_flush(zbx_history_binary_writer_t *writer, struct zbx_json *j)
+{
+	unsigned char	*data, *ptr;
+	size_t		data_size = 1 + ZBX_SERIALIZE_UINT64_COMPACT_MAX * (1 + ZBX_HISTORY_BINARY_COLUMN_COUNT);
+	char		*b64 = NULL;
+	int		i;
+
+	for (i = 0; i < ZBX_HISTORY_BINARY_COLUMN_COUNT; i++)
+		data_size += writer->columns[i].data_offset;
+
+	ptr = data = (unsigned char *)zbx_malloc(NULL, data_size);
+
+	*ptr++ = ZBX_HISTORY_BINARY_VERSION;
+	ptr += zbx_serialize_uint64_compact(ptr, writer->rows_num);
+
+	for (i = 0; i < ZBX_HISTORY_BINARY_COLUMN_COUNT; i++)
+	{
+		ptr += zbx_serialize_uint64_compact(ptr, (zbx_uint64_t)writer->columns[i].data_offset);
+
+		if (0 != writer->columns[i].data_offset)
+		{
+			memcpy(ptr, writer->columns[i].data, writer->columns[i].data_offset);
+			ptr += writer->columns[i].data_offset;
+		}
+	}
+
+	zbx_base64_encode_dyn((const char *)data, &b64, (int)(ptr - data));
+	zbx_free(data);
+
+	zbx_json_addstring(j, ZBX_PROTO_TAG_HISTORY_DATA_BINARY, b64, ZBX_JSON_TYPE_STRING);
+	zbx_free(b64);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: opens binary history data received in json                        *
+ *                                                                            *
+ * Parameters: reader - [OUT] the binary history data reader                  *
+ *             jp     - [IN] the json data                                    *
+ *             error  - [OUT] the error message                               *
+ *                                                                            *
+ * Return value:  SUCCEED - the binary history data was opened                *
+ *                FAIL    - the data is missing or malformed                  *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_history_binary_reader_open(zbx_history_binary_reader_t *reader, const struct zbx_json_parse *jp,
+		char **error)
+{
+	char			*b64 = NULL;
+	size_t			b64_alloc = 0, size;
+	const unsigned char	*ptr, *end;
+	zbx_uint64_t		len;
+	zbx_uint32_t		ret;
+	int			i;
+
+	memset(reader, 0, sizeof(zbx_history_binary_reader_t));
+
+	if (SUCCEED != zbx_json_value_by_name_dyn(jp, ZBX_PROTO_TAG_HISTORY_DATA_BINARY, &b64, &b64_alloc, NULL))
+	{
+		*error = zbx_strdup(*error, "cannot find binary history data");
+		return FAIL;
+	}
+
+	size = strlen(b64) / 4 * 3 + 3;
+	reader->buffer = (char *)zbx_malloc(NULL, size);
+	zbx_base64_decode(b64, reader->buffer, size, &size);
+	zbx_free(b64);
+
+	ptr = (const unsigned char *)reader->buffer;
+	end = ptr + size;
+
+	if (0 == size || ZBX_HISTORY_BINARY_VERSION != *ptr++)
+	{
+		*error = zbx_strdup(*error, "unsupported binary history data format");
+		goto fail;
+	}
+
+	if (0 == (ret = zbx_deserialize_uint64_compact(ptr, end, &reader->rows_left)))
+		goto invalid;
+
+	ptr += ret;
+
+	for (i = 0; i < ZBX_HISTORY_BINARY_COLUMN_COUNT; i++)
+	{
+		if (0 == (ret = zbx_deserialize_uint64_compact(ptr, end, &len)))
+			goto invalid;
+
+		ptr += ret;
+
+		if ((zbx_uint64_t)(end - ptr) < len)
+			goto invalid;
+
+		reader->pos[i] = ptr;
+		reader->end[i] = ptr += len;
+	}
+
+	if ((zbx_uint64_t)(reader->end[ZBX_HISTORY_BINARY_COLUMN_FLAGS] - reader->pos[ZBX_HISTORY_BINARY_COLUMN_FLAGS]) !=
+			reader->rows_left)
+	{
+		goto invalid;
+	}
+
+	return SUCCEED;
+invalid:
+	*error = zbx_strdup(*error, "invalid binary history data");
+fail:
+	zbx_history_binary_reader_close(reader);
+
+	return FAIL;
+}
+
+static int	history_binary_read_uint64(zbx_history_binary_reader_t *reader, int column, zbx_uint64_t *value)
+{
+	zbx_uint32_t	len;
+
+	if (0 == (len = zbx_deserialize_uint64_compact(reader->pos[column], reader->end[column], value)))
+		return FAIL;
+
+	reader->pos[column] += len;
+
+	return SUCCEED;
+}
+
+static int	history_binary_read_int(zbx_history_binary_reader_t *reader, int column, int *value)
+{
+	zbx_uint64_t	value_ui64;
+
+	if (SUCCEED != history_binary_read_uint64(reader, column, &value_ui64))
+		return FAIL;
+
+	*value = (int)(zbx_int64_t)ZBX_HISTORY_BINARY_ZIGZAG_DECODE(value_ui64);
+
+	return SUCCEED;
+}
+
+static int	history_binary_read_delta(zbx_history_binary_reader_t *reader, int column, zbx_uint64_t *last)
+{
+	zbx_uint64_t	delta;
+
+	if (SUCCEED != history_binary_read_uint64(reader, column, &delta))
+		return FAIL;
+
+	*last += ZBX_HISTORY_BINARY_ZIGZAG_DECODE(delta);
+
+	return SUCCEED;
+}
+
+static int	history_binary_read_str(zbx_history_binary_reader_t *reader, zbx_arena_t *arena, char **str)
+{
+	zbx_uint64_t	len;
+
+	if (SUCCEED != history_binary_read_uint64(reader, ZBX_HISTORY_BINARY_COLUMN_STRINGS, &len))
+		return FAIL;
+
+	if ((zbx_uint64_t)(reader->end[ZBX_HISTORY_BINARY_COLUMN_STRINGS] -
+			reader->pos[ZBX_HISTORY_BINARY_COLUMN_STRINGS]) < len)
+	{
+		return FAIL;
+	}
+
+	*str = zbx_arena_strndup(arena, (const char *)reader->pos[ZBX_HISTORY_BINARY_COLUMN_STRINGS], (size_t)len);
+	reader->pos[ZBX_HISTORY_BINARY_COLUMN_STRINGS] += len;
+
+	return SUCCEED;
+}
+
+static int	history_binary_read_double(zbx_history_binary_reader_t *reader, double *value)
+{
+	zbx_uint64_t	bits;
+
+	if ((size_t)(reader->end[ZBX_HISTORY_BINARY_COLUMN_NUMERIC] - reader->pos[ZBX_HISTORY_BINARY_COLUMN_NUMERIC]) <
+			sizeof(bits))
+	{
+		return FAIL;
+	}
+
+	memcpy(&bits, reader->pos[ZBX_HISTORY_BINARY_COLUMN_NUMERIC], sizeof(bits));
+	reader->pos[ZBX_HISTORY_BINARY_COLUMN_NUMERIC] += sizeof(bits);
+
+	bits = zbx_letoh_uint64(bits);
+	memcpy(value, &bits, sizeof(bits));
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reads next record from binary history data                        *
+ *                                                                            *
+ * Parameters: reader - [IN/OUT] the binary history data reader               *
+ *             itemid - [OUT] the item identifier                             *
+ *             arena  - [IN/OUT] the arena to allocate value strings from     *
+ *             av     - [OUT] the agent value                                 *
+ *             error  - [OUT] the error message                               *
+ *                                                                            *
+ * Return value:  SUCCEED - the record was read successfully                  *
+ *                FAIL    - the data is malformed                             *
+ *                                                                            *
+ * Comments: The agent value is filled the same way as when parsing JSON      *
+ *           history data row, numeric values are converted to strings.       *
+ *           The value strings are released together with the arena.          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_history_binary_reader_next(zbx_history_binary_reader_t *reader, zbx_uint64_t *itemid,
+		zbx_arena_t *arena, zbx_agent_value_t *av, char **error)
+{
+	unsigned char	flags;
+	zbx_uint64_t	value_ui64;
+	double		value_dbl;
+	int		state;
+	char		buffer[ZBX_MAX_DOUBLE_LEN + 1];
+
+	memset(av, 0, sizeof(zbx_agent_value_t));
+
+	if (0 == reader->rows_left)
+		goto fail;
+
+	reader->rows_left--;
+	flags = *reader->pos[ZBX_HISTORY_BINARY_COLUMN_FLAGS]++;
+
+	if (SUCCEED != history_binary_read_delta(reader, ZBX_HISTORY_BINARY_COLUMN_ID, &reader->last_id) ||
+			SUCCEED != history_binary_read_delta(reader, ZBX_HISTORY_BINARY_COLUMN_ITEMID,
+					&reader->last_itemid) ||
+			SUCCEED != history_binary_read_delta(reader, ZBX_HISTORY_BINARY_COLUMN_CLOCK,
+					&reader->last_clock) ||
+			SUCCEED != history_binary_read_uint64(reader, ZBX_HISTORY_BINARY_COLUMN_NS, &value_ui64))
+	{
+		goto fail;
+	}
+
+	if (ZBX_MAX_UINT31_1 < reader->last_clock || 999999999 < value_ui64)
+		goto fail;
+
+	av->id = reader->last_id;
+	*itemid = reader->last_itemid;
+	av->ts.sec = (int)reader->last_clock;
+	av->ts.ns = (int)value_ui64;
+
+	if (0 != (flags & ZBX_HISTORY_BINARY_FLAG_STATE))
+	{
+		if (SUCCEED != history_binary_read_int(reader, ZBX_HISTORY_BINARY_COLUMN_ATTRIBUTES, &state))
+			goto fail;
+
+		av->state = (unsigned char)state;
+	}
+
+	if (0 != (flags & ZBX_HISTORY_BINARY_FLAG_LOG))
+	{
+		if (SUCCEED != history_binary_read_int(reader, ZBX_HISTORY_BINARY_COLUMN_ATTRIBUTES, &av->timestamp) ||
+				SUCCEED != history_binary_read_int(reader, ZBX_HISTORY_BINARY_COLUMN_ATTRIBUTES,
+						&av->severity) ||
+				SUCCEED != history_binary_read_int(reader, ZBX_HISTORY_BINARY_COLUMN_ATTRIBUTES,
+						&av->logeventid) ||
+				SUCCEED != history_binary_read_str(reader, arena, &av->source))
+		{
+			goto fail;
+		}
+	}
+
+	switch (flags & ZBX_HISTORY_BINARY_VALUE_MASK)
+	{
+		case ZBX_HISTORY_BINARY_VALUE_STR:
+			if (SUCCEED != history_binary_read_str(reader, arena, &av->value))
+				goto fail;
+			break;
+		case ZBX_HISTORY_BINARY_VALUE_UI64:
+			if (SUCCEED != history_binary_read_uint64(reader, ZBX_HISTORY_BINARY_COLUMN_NUMERIC,
+					&value_ui64))
+			{
+				goto fail;
+			}
+			zbx_snprintf(buffer, sizeof(buffer), ZBX_FS_UI64, value_ui64);
+			av->value = zbx_arena_strdup(arena, buffer);
+			break;
+		case ZBX_HISTORY_BINARY_VALUE_DBL:
+			if (SUCCEED != history_binary_read_double(reader, &value_dbl))
+				goto fail;
+			zbx_snprintf(buffer, sizeof(buffer), ZBX_FS_DBL64, value_dbl);
+			av->value = zbx_arena_strdup(arena, buffer);
+			break;
+	}
+
+	if (0 != (flags & ZBX_HISTORY_BINARY_FLAG_META))
+	{
+		if (SUCCEED != history_binary_read_uint64(reader, ZBX_HISTORY_BINARY_COLUMN_ATTRIBUTES,
+				&av->lastlogsize) ||
+				SUCCEED != history_binary_read_int(reader, ZBX_HISTORY_BINARY_COLUMN_ATTRIBUTES,
+						&av->mtime))
+		{
+			goto fail;
+		}
+
+		/* unsupported item meta information is ignored, the same as in JSON history data */
+		if (ITEM_STATE_NOTSUPPORTED != av->state)
+			av->meta = 1;
+		else
+			av->lastlogsize = av->mtime = 0;
+	}
+
+	return SUCCEED;
+fail:
+	av->value = NULL;
+	av->source = NULL;
+	*error = zbx_strdup(*error, "invalid binary history data record");
+
+	return FAIL;
+}
+
+void	zbx_history_binary_reader_close(zbx_history_binary_reader_t *reader)
+{
+	zbx_free(reader->buffer);
+}
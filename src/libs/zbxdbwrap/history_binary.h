@@ -0,0 +1,82 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#ifndef ZABBIX_HISTORY_BINARY_H
+#define ZABBIX_HISTORY_BINARY_H
+
+#include "zbxalgo.h"
+#include "zbxcacheconfig.h"
+#include "zbxcachehistory.h"
+#include "zbxjson.h"
+
+/* binary history data columns */
+#define ZBX_HISTORY_BINARY_COLUMN_ID		0
+#define ZBX_HISTORY_BINARY_COLUMN_ITEMID	1
+#define ZBX_HISTORY_BINARY_COLUMN_CLOCK		2
+#define ZBX_HISTORY_BINARY_COLUMN_NS		3
+#define ZBX_HISTORY_BINARY_COLUMN_FLAGS		4
+#define ZBX_HISTORY_BINARY_COLUMN_NUMERIC	5
+#define ZBX_HISTORY_BINARY_COLUMN_ATTRIBUTES	6
+#define ZBX_HISTORY_BINARY_COLUMN_STRINGS	7
+#define ZBX_HISTORY_BINARY_COLUMN_COUNT		8
+
+typedef struct
+{
+	unsigned char	*data;
+	size_t		data_alloc;
+	size_t		data_offset;
+}
+zbx_history_binary_column_t;
+
+typedef struct
+{
+	zbx_history_binary_column_t	columns[ZBX_HISTORY_BINARY_COLUMN_COUNT];
+	zbx_uint64_t			last_id;
+	zbx_uint64_t			last_itemid;
+	zbx_uint64_t			last_clock;
+	zbx_uint64_t			rows_num;
+}
+zbx_history_binary_writer_t;
+
+typedef struct
+{
+	char			*buffer;
+	const unsigned char	*pos[ZBX_HISTORY_BINARY_COLUMN_COUNT];
+	const unsigned char	*end[ZBX_HISTORY_BINARY_COLUMN_COUNT];
+	zbx_uint64_t		last_id;
+	zbx_uint64_t		last_itemid;
+	zbx_uint64_t		last_clock;
+	zbx_uint64_t		rows_left;
+}
+zbx_history_binary_reader_t;
+
+void	zbx_history_binary_writer_init(zbx_history_binary_writer_t *writer);
+void	zbx_history_binary_writer_destroy(zbx_history_binary_writer_t *writer);
+void	zbx_history_binary_writer_add(zbx_history_binary_writer_t *writer, const zbx_proxy_history_data_t *hd,
+		const char *string_buffer, unsigned char value_type);
+size_t	zbx_history_binary_writer_size(const zbx_history_binary_writer_t *writer);
+void	zbx_history_binary_writer_flush(zbx_history_binary_writer_t *writer, struct zbx_json *j);
+
+int	zbx_history_binary_reader_open(zbx_history_binary_reader_t *reader, const struct zbx_json_parse *jp,
+		char **error);
+int	zbx_history_binary_reader_next(zbx_history_binary_reader_t *reader, zbx_uint64_t *itemid,
+		zbx_arena_t *arena, zbx_agent_value_t *av, char **error);
+void	zbx_history_binary_reader_close(zbx_history_binary_reader_t *reader);
+
+#endif
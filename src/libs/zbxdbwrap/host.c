@@ -1396,6 +1396,8 @@ void	zbx_db_delete_items(zbx_vector_uint64_t *itemids)
 	{
 		zbx_vector_str_append(&hk_history, "trends");
 		zbx_vector_str_append(&hk_history, "trends_uint");
+		zbx_vector_str_append(&hk_history, "trends_day");
+		zbx_vector_str_append(&hk_history, "trends_uint_day");
 	}
 
 	if (0 != hk_history.values_num)
@@ -5367,6 +5369,86 @@ static void	DBcopy_template_httptests(zbx_uint64_t hostid, const zbx_vector_uint
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/* template sets already validated for collisions during linking of multiple hosts */
+struct zbx_template_link_cache
+{
+	zbx_vector_ptr_t	templatesets;
+};
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: creates template link cache                                       *
+ *                                                                            *
+ * Comments: The cache is used when the same templates are linked to many     *
+ *           hosts within one transaction, so template collisions are checked *
+ *           once per template set instead of once per host.                  *
+ *                                                                            *
+ ******************************************************************************/
+zbx_template_link_cache_t	*zbx_template_link_cache_create(void)
+{
+	zbx_template_link_cache_t	*cache;
+
+	cache = (zbx_template_link_cache_t *)zbx_malloc(NULL, sizeof(zbx_template_link_cache_t));
+	zbx_vector_ptr_create(&cache->templatesets);
+
+	return cache;
+}
+
+static void	template_set_free(zbx_vector_uint64_t *templateids)
+{
+	zbx_vector_uint64_destroy(templateids);
+	zbx_free(templateids);
+}
+
+void	zbx_template_link_cache_free(zbx_template_link_cache_t *cache)
+{
+	zbx_vector_ptr_clear_ext(&cache->templatesets, (zbx_clean_func_t)template_set_free);
+	zbx_vector_ptr_destroy(&cache->templatesets);
+	zbx_free(cache);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if template set was already validated                      *
+ *                                                                            *
+ * Parameters: cache       - [IN] template link cache                         *
+ *             templateids - [IN] sorted template IDs                         *
+ *                                                                            *
+ * Return value: SUCCEED - template set was validated                         *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	template_link_cache_validated(const zbx_template_link_cache_t *cache,
+		const zbx_vector_uint64_t *templateids)
+{
+	int	i;
+
+	for (i = 0; i < cache->templatesets.values_num; i++)
+	{
+		const zbx_vector_uint64_t	*templateset;
+
+		templateset = (const zbx_vector_uint64_t *)cache->templatesets.values[i];
+
+		if (templateset->values_num == templateids->values_num && 0 == memcmp(templateset->values,
+				templateids->values, sizeof(zbx_uint64_t) * (size_t)templateids->values_num))
+		{
+			return SUCCEED;
+		}
+	}
+
+	return FAIL;
+}
+
+static void	template_link_cache_add(zbx_template_link_cache_t *cache, const zbx_vector_uint64_t *templateids)
+{
+	zbx_vector_uint64_t	*templateset;
+
+	templateset = (zbx_vector_uint64_t *)zbx_malloc(NULL, sizeof(zbx_vector_uint64_t));
+	zbx_vector_uint64_create(templateset);
+	zbx_vector_uint64_append_array(templateset, templateids->values, templateids->values_num);
+	zbx_vector_ptr_append(&cache->templatesets, templateset);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: copy elements from specified template                             *
@@ -5374,13 +5456,14 @@ static void	DBcopy_template_httptests(zbx_uint64_t hostid, const zbx_vector_uint
  * Parameters: hostid          - [IN] host identifier from database           *
  *             lnk_templateids - [IN] array of template IDs                   *
  *             link_type       - [IN] link type 0 - manual, 1 - LLD automatic *
+ *             cache           - [IN/OUT] template link cache (optional)      *
  *             error           - [OUT] error message                          *
  *                                                                            *
  * Return value: upon successful completion return SUCCEED                    *
  *                                                                            *
  ******************************************************************************/
 int	zbx_db_copy_template_elements(zbx_uint64_t hostid, zbx_vector_uint64_t *lnk_templateids,
-		zbx_host_template_link_type link_type, char **error)
+		zbx_host_template_link_type link_type, zbx_template_link_cache_t *cache, char **error)
 {
 	zbx_vector_uint64_t	templateids;
 	zbx_uint64_t		hosttemplateid;
@@ -5412,14 +5495,21 @@ int	zbx_db_copy_template_elements(zbx_uint64_t hostid, zbx_vector_uint64_t *lnk_
 
 	zbx_vector_uint64_sort(&templateids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 
-	if (SUCCEED != (res = validate_linked_templates(&templateids, err, sizeof(err))))
+	if (NULL == cache || SUCCEED != template_link_cache_validated(cache, &templateids))
 	{
-		template_names = get_template_names(lnk_templateids);
+		if (SUCCEED != (res = validate_linked_templates(&templateids, err, sizeof(err))))
+		{
+			template_names = get_template_names(lnk_templateids);
 
-		*error = zbx_dsprintf(NULL, "%s to host \"%s\": %s", template_names, zbx_host_string(hostid), err);
+			*error = zbx_dsprintf(NULL, "%s to host \"%s\": %s", template_names, zbx_host_string(hostid),
+					err);
 
-		zbx_free(template_names);
-		goto clean;
+			zbx_free(template_names);
+			goto clean;
+		}
+
+		if (NULL != cache)
+			template_link_cache_add(cache, &templateids);
 	}
 
 	if (SUCCEED != (res = validate_host(hostid, lnk_templateids, err, sizeof(err))))
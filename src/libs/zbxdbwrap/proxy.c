@@ -39,6 +39,7 @@
 #include "zbx_item_constants.h"
 #include "zbxcachehistory.h"
 #include "zbxpreproc.h"
+#include "history_binary.h"
 
 /* the space reserved in json buffer to hold at least one record plus service data */
 #define ZBX_DATA_JSON_RESERVED		(ZBX_HISTORY_TEXT_VALUE_LEN * 4 + ZBX_KIBIBYTE * 4)
@@ -86,13 +87,6 @@ zbx_history_table_t;
 typedef int	(*zbx_client_item_validator_t)(zbx_history_recv_item_t *item, zbx_socket_t *sock, void *args,
 		char **error);
 
-typedef struct
-{
-	zbx_uint64_t	hostid;
-	int		value;
-}
-zbx_host_rights_t;
-
 static zbx_history_table_t	dht = {
 	"proxy_dhistory", "dhistory_lastid",
 		{
@@ -123,8 +117,53 @@ static zbx_history_table_t	areg = {
 		}
 };
 
+/* the source of history data returned by the last zbx_proxy_get_hist_data() call */
+#define PROXY_HISTORY_SOURCE_DATABASE	0
+#define PROXY_HISTORY_SOURCE_MEMORY	1
+
+static unsigned char	history_source = PROXY_HISTORY_SOURCE_DATABASE;
+
+typedef int	(*zbx_proxy_history_get_func_t)(zbx_uint64_t lastid, zbx_proxy_history_data_t **data,
+		size_t *data_alloc, char **string_buffer, size_t *string_buffer_alloc, int *more);
+
+/* history data row tags, parsed in a single pass over the row */
+typedef enum
+{
+	HISTORY_ROW_TAG_CLOCK = 0,
+	HISTORY_ROW_TAG_NS,
+	HISTORY_ROW_TAG_STATE,
+	HISTORY_ROW_TAG_LASTLOGSIZE,
+	HISTORY_ROW_TAG_MTIME,
+	HISTORY_ROW_TAG_VALUE,
+	HISTORY_ROW_TAG_LOGTIMESTAMP,
+	HISTORY_ROW_TAG_LOGSOURCE,
+	HISTORY_ROW_TAG_LOGSEVERITY,
+	HISTORY_ROW_TAG_LOGEVENTID,
+	HISTORY_ROW_TAG_ID,
+	HISTORY_ROW_TAG_ITEMID,
+	HISTORY_ROW_TAG_HOST,
+	HISTORY_ROW_TAG_KEY,
+	HISTORY_ROW_TAG_COUNT
+}
+zbx_history_row_tag_t;
+
+static const char	*history_row_tags[HISTORY_ROW_TAG_COUNT] = {ZBX_PROTO_TAG_CLOCK, ZBX_PROTO_TAG_NS,
+		ZBX_PROTO_TAG_STATE, ZBX_PROTO_TAG_LASTLOGSIZE, ZBX_PROTO_TAG_MTIME, ZBX_PROTO_TAG_VALUE,
+		ZBX_PROTO_TAG_LOGTIMESTAMP, ZBX_PROTO_TAG_LOGSOURCE, ZBX_PROTO_TAG_LOGSEVERITY,
+		ZBX_PROTO_TAG_LOGEVENTID, ZBX_PROTO_TAG_ID, ZBX_PROTO_TAG_ITEMID, ZBX_PROTO_TAG_HOST,
+		ZBX_PROTO_TAG_KEY};
+
 static zbx_lld_process_agent_result_func_t	lld_process_agent_result_cb = NULL;
 
+/* received history value strings are allocated from arena, which is reset after each processed batch */
+#define ZBX_HISTORY_ARENA_BLOCK_SIZE	(64 * ZBX_KIBIBYTE)
+
+static zbx_arena_t	*history_arena = NULL;
+
+/* buffer for decoding history data row tag values */
+static char	*history_row_buf = NULL;
+static size_t	history_row_buf_alloc = 0;
+
 void	zbx_init_library_dbwrap(zbx_lld_process_agent_result_func_t lld_process_agent_result_func)
 {
 	lld_process_agent_result_cb = lld_process_agent_result_func;
@@ -417,7 +456,7 @@ int	zbx_check_access_passive_proxy(zbx_socket_t *sock, int send_response, const
 	}
 	else if (ZBX_TCP_SEC_TLS_PSK == sock->connection_type)
 	{
-		if (0 != (ZBX_PSK_FOR_PROXY & zbx_tls_get_psk_usage()))
+		if (0 != (ZBX_PSK_FOR_PROXY & zbx_tls_get_psk_usage(sock)))
 			return SUCCEED;
 
 		zabbix_log(LOG_LEVEL_WARNING, "%s from server \"%s\" is not allowed: it used PSK which is not"
@@ -604,8 +643,38 @@ static void	proxy_set_lastid(const char *table_name, const char *lastidfield, co
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: mark history records up to the specified id as uploaded           *
+ *                                                                            *
+ * Parameters: lastid - [IN] the id of last uploaded record returned by       *
+ *                           zbx_proxy_get_hist_data()                        *
+ *                                                                            *
+ * Comments: Must be called inside database transaction.                      *
+ *                                                                            *
+ ******************************************************************************/
 void	zbx_proxy_set_hist_lastid(const zbx_uint64_t lastid)
 {
+	zbx_uint64_t	history_maxid;
+	zbx_db_result_t	result;
+	zbx_db_row_t	row;
+
+	if (PROXY_HISTORY_SOURCE_MEMORY == history_source)
+	{
+		zbx_pb_history_set_lastid(lastid);
+		return;
+	}
+
+	result = zbx_db_select("select max(id) from proxy_history");
+
+	if (NULL == (row = zbx_db_fetch(result)) || SUCCEED == zbx_db_is_null(row[0]))
+		history_maxid = lastid;
+	else
+		ZBX_STR2UINT64(history_maxid, row[0]);
+
+	zbx_db_free_result(result);
+
+	zbx_reset_proxy_history_count(history_maxid - lastid);
 	proxy_set_lastid("proxy_history", "history_lastid", lastid);
 }
 
@@ -628,6 +697,12 @@ int	zbx_proxy_get_delay(const zbx_uint64_t lastid)
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() [lastid=" ZBX_FS_UI64 "]", __func__, lastid);
 
+	if (PROXY_HISTORY_SOURCE_MEMORY == history_source)
+	{
+		ts = zbx_pb_history_get_delay(lastid);
+		goto out;
+	}
+
 	sql = zbx_dsprintf(sql, "select write_clock from proxy_history where id>" ZBX_FS_UI64 " order by id asc",
 			lastid);
 
@@ -638,7 +713,7 @@ int	zbx_proxy_get_delay(const zbx_uint64_t lastid)
 		ts = (int)time(NULL) - atoi(row[0]);
 
 	zbx_db_free_result(result);
-
+out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 
 	return ts;
@@ -734,24 +809,6 @@ try_again:
 			(zbx_fs_size_t)j->buffer_offset);
 }
 
-typedef struct
-{
-	zbx_uint64_t	id;
-	zbx_uint64_t	itemid;
-	zbx_uint64_t	lastlogsize;
-	size_t		source_offset;
-	size_t		value_offset;
-	int		clock;
-	int		ns;
-	int		timestamp;
-	int		severity;
-	int		logeventid;
-	int		mtime;
-	unsigned char	state;
-	unsigned char	flags;
-}
-zbx_history_data_t;
-
 /******************************************************************************
  *                                                                            *
  * Purpose: read proxy history data from the database                         *
@@ -769,18 +826,18 @@ zbx_history_data_t;
  * Return value: The number of records read.                                  *
  *                                                                            *
  ******************************************************************************/
-static int	proxy_get_history_data(zbx_uint64_t lastid, zbx_history_data_t **data, size_t *data_alloc,
+static int	proxy_get_history_data(zbx_uint64_t lastid, zbx_proxy_history_data_t **data, size_t *data_alloc,
 		char **string_buffer, size_t *string_buffer_alloc, int *more)
 {
-	zbx_db_result_t		result;
-	zbx_db_row_t		row;
-	char			*sql = NULL;
-	size_t			sql_alloc = 0, sql_offset = 0, data_num = 0;
-	size_t			string_buffer_offset = 0;
-	zbx_uint64_t		id;
-	int			retries = 1, total_retries = 10;
-	struct timespec		t_sleep = { 0, 100000000L }, t_rem;
-	zbx_history_data_t	*hd;
+	zbx_db_result_t			result;
+	zbx_db_row_t			row;
+	char				*sql = NULL;
+	size_t				sql_alloc = 0, sql_offset = 0, data_num = 0;
+	size_t				string_buffer_offset = 0;
+	zbx_uint64_t			id;
+	int				retries = 1, total_retries = 10;
+	struct timespec			t_sleep = { 0, 100000000L }, t_rem;
+	zbx_proxy_history_data_t	*hd;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() lastid:" ZBX_FS_UI64, __func__, lastid);
 
@@ -832,7 +889,8 @@ try_again:
 		if (*data_alloc == data_num)
 		{
 			*data_alloc *= 2;
-			*data = (zbx_history_data_t *)zbx_realloc(*data, sizeof(zbx_history_data_t) * *data_alloc);
+			*data = (zbx_proxy_history_data_t *)zbx_realloc(*data,
+					sizeof(zbx_proxy_history_data_t) * *data_alloc);
 		}
 
 		hd = *data + data_num++;
@@ -893,30 +951,55 @@ try_again:
 	return data_num;
 }
 
+/* history data batch, filled with records of items assigned to it */
+typedef struct
+{
+	struct zbx_json			*j;
+	zbx_history_binary_writer_t	*writer;
+	int				records_num;
+	zbx_uint64_t			firstid;
+}
+zbx_proxy_hist_batch_t;
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get the size of history data added to batch                       *
+ *                                                                            *
+ ******************************************************************************/
+static size_t	proxy_hist_batch_size(const zbx_proxy_hist_batch_t *batch)
+{
+	return batch->j->buffer_offset + (NULL != batch->writer ? zbx_history_binary_writer_size(batch->writer) : 0);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: add history records to output json                                *
  *                                                                            *
- * Parameters: j             - [IN] the json output buffer                    *
- *             records_num   - [IN] the total number of records added         *
+ * Parameters: batches       - [IN/OUT] the history data batches              *
+ *             batches_num   - [IN] the number of batches                     *
  *             dc_items      - [IN] the item configuration data               *
  *             errcodes      - [IN] the item configuration status codes       *
  *             records       - [IN] the records to add                        *
  *             string_buffer - [IN] the string buffer holding string values   *
  *             lastid        - [OUT] the id of last added record              *
  *                                                                            *
- * Return value: The total number of records added.                           *
+ * Return value: The number of records added.                                 *
+ *                                                                            *
+ * Comments: Records are distributed between batches by item identifiers, so  *
+ *           all values of an item are always added to the same batch.        *
  *                                                                            *
  ******************************************************************************/
-static int	proxy_add_hist_data(struct zbx_json *j, int records_num, const zbx_dc_item_t *dc_items, const int *errcodes,
-		const zbx_vector_ptr_t *records, const char *string_buffer, zbx_uint64_t *lastid)
+static int	proxy_add_hist_data(zbx_proxy_hist_batch_t *batches, int batches_num, const zbx_dc_item_t *dc_items,
+		const int *errcodes, const zbx_vector_ptr_t *records, const char *string_buffer, zbx_uint64_t *lastid)
 {
-	int				i;
-	const zbx_history_data_t	*hd;
+	int				i, records_num = 0;
+	const zbx_proxy_history_data_t	*hd;
+	zbx_proxy_hist_batch_t		*batch;
+	struct zbx_json			*j;
 
 	for (i = records->values_num - 1; i >= 0; i--)
 	{
-		hd = (const zbx_history_data_t *)records->values[i];
+		hd = (const zbx_proxy_history_data_t *)records->values[i];
 		*lastid = hd->id;
 
 		if (SUCCEED != errcodes[i])
@@ -934,7 +1017,27 @@ static int	proxy_add_hist_data(struct zbx_json *j, int records_num, const zbx_dc
 				continue;
 		}
 
-		if (0 == records_num)
+		batch = &batches[hd->itemid % (zbx_uint64_t)batches_num];
+		j = batch->j;
+
+		if (0 == batch->records_num)
+			batch->firstid = hd->id;
+
+		records_num++;
+
+		if (NULL != batch->writer)
+		{
+			zbx_history_binary_writer_add(batch->writer, hd, string_buffer, dc_items[i].value_type);
+			batch->records_num++;
+
+			/* stop gathering data to avoid exceeding the maximum packet size */
+			if (ZBX_DATA_JSON_RECORD_LIMIT < proxy_hist_batch_size(batch))
+				break;
+
+			continue;
+		}
+
+		if (0 == batch->records_num++)
 			zbx_json_addarray(j, ZBX_PROTO_TAG_HISTORY_DATA);
 
 		zbx_json_addobject(j, NULL);
@@ -942,7 +1045,6 @@ static int	proxy_add_hist_data(struct zbx_json *j, int records_num, const zbx_dc
 		zbx_json_adduint64(j, ZBX_PROTO_TAG_ITEMID, hd->itemid);
 		zbx_json_adduint64(j, ZBX_PROTO_TAG_CLOCK, hd->clock);
 		zbx_json_adduint64(j, ZBX_PROTO_TAG_NS, hd->ns);
-
 		if (ZBX_PROXY_HISTORY_FLAG_NOVALUE != (hd->flags & ZBX_PROXY_HISTORY_MASK_NOVALUE))
 		{
 			if (ITEM_STATE_NORMAL != hd->state)
@@ -977,7 +1079,6 @@ static int	proxy_add_hist_data(struct zbx_json *j, int records_num, const zbx_dc
 		}
 
 		zbx_json_close(j);
-		records_num++;
 
 		/* stop gathering data to avoid exceeding the maximum packet size */
 		if (ZBX_DATA_JSON_RECORD_LIMIT < j->buffer_offset)
@@ -987,27 +1088,96 @@ static int	proxy_add_hist_data(struct zbx_json *j, int records_num, const zbx_dc
 	return records_num;
 }
 
-int	zbx_proxy_get_hist_data(struct zbx_json *j, zbx_uint64_t *lastid, int *more)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get history data from proxy memory buffer or database split in    *
+ *          several batches                                                   *
+ *                                                                            *
+ * Parameters: jsons       - [OUT] the json output buffers, one per batch     *
+ *             batches_num - [IN] the number of batches                       *
+ *             format      - [IN] the history data format -                   *
+ *                                ZBX_PROXY_HISTORY_FORMAT_JSON or            *
+ *                                ZBX_PROXY_HISTORY_FORMAT_BINARY             *
+ *             lastid      - [OUT] the id of last read record                 *
+ *             firstids    - [OUT] the id of first record added to each       *
+ *                                 batch, 0 if batch is empty                 *
+ *             more        - [OUT] set to ZBX_PROXY_DATA_MORE if there might  *
+ *                                 be more data to read                       *
+ *                                                                            *
+ * Return value: The number of records added.                                 *
+ *                                                                            *
+ * Comments: Records buffered in memory are older than database records, so   *
+ *           they are uploaded first. The returned lastid must be passed to   *
+ *           zbx_proxy_get_delay() and zbx_proxy_set_hist_lastid() by the     *
+ *           same process.                                                    *
+ *                                                                            *
+ *           Records are distributed between batches by item identifiers, so  *
+ *           the values of each item stay in one batch and in their original  *
+ *           order. All records with ids below the first id of a batch belong *
+ *           to other batches.                                                *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_proxy_get_hist_data_batches(struct zbx_json **jsons, int batches_num, int format, zbx_uint64_t *lastid,
+		zbx_uint64_t *firstids, int *more)
 {
-	int			records_num = 0, data_num, i, *errcodes = NULL, items_alloc = 0;
-	zbx_uint64_t		id;
-	zbx_hashset_t		itemids_added;
-	zbx_history_data_t	*data;
-	char			*string_buffer;
-	size_t			data_alloc = 16, string_buffer_alloc = ZBX_KIBIBYTE;
-	zbx_vector_uint64_t	itemids;
-	zbx_vector_ptr_t	records;
-	zbx_dc_item_t		*dc_items = 0;
+	int				records_num = 0, data_num, i, *errcodes = NULL, items_alloc = 0;
+	zbx_uint64_t			id;
+	zbx_hashset_t			itemids_added;
+	zbx_proxy_history_data_t	*data;
+	char				*string_buffer;
+	size_t				data_alloc = 16, string_buffer_alloc = ZBX_KIBIBYTE;
+	zbx_vector_uint64_t		itemids;
+	zbx_vector_ptr_t		records;
+	zbx_dc_item_t			*dc_items = 0;
+	zbx_proxy_history_get_func_t	get_history_data;
+	zbx_proxy_hist_batch_t		*batches;
+	zbx_history_binary_writer_t	*writers = NULL;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() batches_num:%d", __func__, batches_num);
+
+	batches = (zbx_proxy_hist_batch_t *)zbx_malloc(NULL, sizeof(zbx_proxy_hist_batch_t) * (size_t)batches_num);
+
+	if (ZBX_PROXY_HISTORY_FORMAT_BINARY == format)
+	{
+		writers = (zbx_history_binary_writer_t *)zbx_malloc(NULL,
+				sizeof(zbx_history_binary_writer_t) * (size_t)batches_num);
+	}
+
+	for (i = 0; i < batches_num; i++)
+	{
+		batches[i].j = jsons[i];
+		batches[i].records_num = 0;
+		batches[i].firstid = 0;
+
+		if (NULL != writers)
+		{
+			batches[i].writer = &writers[i];
+			zbx_history_binary_writer_init(batches[i].writer);
+		}
+		else
+			batches[i].writer = NULL;
+	}
 
 	zbx_vector_uint64_create(&itemids);
 	zbx_vector_ptr_create(&records);
-	data = (zbx_history_data_t *)zbx_malloc(NULL, data_alloc * sizeof(zbx_history_data_t));
+	data = (zbx_proxy_history_data_t *)zbx_malloc(NULL, data_alloc * sizeof(zbx_proxy_history_data_t));
 	string_buffer = (char *)zbx_malloc(NULL, string_buffer_alloc);
 
+	*lastid = 0;
 	*more = ZBX_PROXY_DATA_MORE;
-	proxy_get_lastid("proxy_history", "history_lastid", &id);
+
+	if (SUCCEED == zbx_pb_history_has_data())
+	{
+		history_source = PROXY_HISTORY_SOURCE_MEMORY;
+		get_history_data = zbx_pb_history_get_data;
+		id = 0;
+	}
+	else
+	{
+		history_source = PROXY_HISTORY_SOURCE_DATABASE;
+		get_history_data = proxy_get_history_data;
+		proxy_get_lastid("proxy_history", "history_lastid", &id);
+	}
 
 	zbx_hashset_create(&itemids_added, data_alloc, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 
@@ -1015,10 +1185,23 @@ int	zbx_proxy_get_hist_data(struct zbx_json *j, zbx_uint64_t *lastid, int *more)
 	/*   1) there are no more data to read                                  */
 	/*   2) we have retrieved more than the total maximum number of records */
 	/*   3) we have gathered more than half of the maximum packet size      */
-	while (ZBX_DATA_JSON_BATCH_LIMIT > j->buffer_offset && ZBX_MAX_HRECORDS_TOTAL > records_num &&
-			0 != (data_num = proxy_get_history_data(id, &data, &data_alloc, &string_buffer,
-					&string_buffer_alloc, more)))
+	while (ZBX_MAX_HRECORDS_TOTAL * batches_num > records_num)
 	{
+		for (i = 0; i < batches_num; i++)
+		{
+			if (ZBX_DATA_JSON_BATCH_LIMIT <= proxy_hist_batch_size(&batches[i]))
+				break;
+		}
+
+		if (i != batches_num)
+			break;
+
+		if (0 == (data_num = get_history_data(id, &data, &data_alloc, &string_buffer, &string_buffer_alloc,
+				more)))
+		{
+			break;
+		}
+
 		zbx_vector_uint64_reserve(&itemids, data_num);
 		zbx_vector_ptr_reserve(&records, data_num);
 
@@ -1048,7 +1231,8 @@ int	zbx_proxy_get_hist_data(struct zbx_json *j, zbx_uint64_t *lastid, int *more)
 
 		zbx_dc_config_get_items_by_itemids(dc_items, itemids.values, errcodes, itemids.values_num);
 
-		records_num = proxy_add_hist_data(j, records_num, dc_items, errcodes, &records, string_buffer, lastid);
+		records_num += proxy_add_hist_data(batches, batches_num, dc_items, errcodes, &records, string_buffer,
+				lastid);
 		zbx_dc_config_clean_items(dc_items, errcodes, itemids.values_num);
 
 		/* got less data than requested - either no more data to read or the history is full of */
@@ -1062,11 +1246,30 @@ int	zbx_proxy_get_hist_data(struct zbx_json *j, zbx_uint64_t *lastid, int *more)
 		id = *lastid;
 	}
 
-	if (0 != records_num)
-		zbx_json_close(j);
+	for (i = 0; i < batches_num; i++)
+	{
+		if (0 != batches[i].records_num)
+		{
+			if (NULL != batches[i].writer)
+				zbx_history_binary_writer_flush(batches[i].writer, batches[i].j);
+			else
+				zbx_json_close(batches[i].j);
+		}
+
+		if (NULL != batches[i].writer)
+			zbx_history_binary_writer_destroy(batches[i].writer);
+
+		firstids[i] = batches[i].firstid;
+	}
+
+	/* all database records are uploaded, new values can be buffered in memory again */
+	if (PROXY_HISTORY_SOURCE_DATABASE == history_source && 0 == *lastid && ZBX_PROXY_DATA_DONE == *more)
+		zbx_pb_history_set_memory_state();
 
 	zbx_hashset_destroy(&itemids_added);
 
+	zbx_free(writers);
+	zbx_free(batches);
 	zbx_free(dc_items);
 	zbx_free(errcodes);
 	zbx_free(data);
@@ -1074,12 +1277,34 @@ int	zbx_proxy_get_hist_data(struct zbx_json *j, zbx_uint64_t *lastid, int *more)
 	zbx_vector_ptr_destroy(&records);
 	zbx_vector_uint64_destroy(&itemids);
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() lastid:" ZBX_FS_UI64 " records_num:%d size:~" ZBX_FS_SIZE_T " more:%d",
-			__func__, *lastid, records_num, j->buffer_offset, *more);
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() lastid:" ZBX_FS_UI64 " records_num:%d more:%d", __func__, *lastid,
+			records_num, *more);
 
 	return records_num;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get history data from proxy memory buffer or database             *
+ *                                                                            *
+ * Parameters: j      - [OUT] the json output buffer                          *
+ *             format - [IN] the history data format -                        *
+ *                           ZBX_PROXY_HISTORY_FORMAT_JSON or                 *
+ *                           ZBX_PROXY_HISTORY_FORMAT_BINARY                  *
+ *             lastid - [OUT] the id of last added record                     *
+ *             more   - [OUT] set to ZBX_PROXY_DATA_MORE if there might be    *
+ *                            more data to read                               *
+ *                                                                            *
+ * Return value: The number of records added.                                 *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_proxy_get_hist_data(struct zbx_json *j, int format, zbx_uint64_t *lastid, int *more)
+{
+	zbx_uint64_t	firstid;
+
+	return zbx_proxy_get_hist_data_batches(&j, 1, format, lastid, &firstid, more);
+}
+
 int	zbx_proxy_get_dhis_data(struct zbx_json *j, zbx_uint64_t *lastid, int *more)
 {
 	int		records_num = 0;
@@ -1369,21 +1594,36 @@ int	zbx_process_history_data(zbx_history_recv_item_t *items, zbx_agent_value_t *
 
 /******************************************************************************
  *                                                                            *
- * Purpose: frees resources allocated to store agent values                   *
- *                                                                            *
- * Parameters: values     - [IN] the values to clean                          *
- *             values_num - [IN] the number of items in values array          *
+ * Purpose: returns arena for allocating received history value strings       *
  *                                                                            *
  ******************************************************************************/
-static void	zbx_agent_values_clean(zbx_agent_value_t *values, size_t values_num)
+static zbx_arena_t	*history_arena_get(void)
 {
-	size_t	i;
-
-	for (i = 0; i < values_num; i++)
+	if (NULL == history_arena)
 	{
-		zbx_free(values[i].value);
-		zbx_free(values[i].source);
+		history_arena = (zbx_arena_t *)zbx_malloc(NULL, sizeof(zbx_arena_t));
+		zbx_arena_create(history_arena, ZBX_HISTORY_ARENA_BLOCK_SIZE);
 	}
+
+	return history_arena;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: releases memory used to parse received history data               *
+ *                                                                            *
+ * Comments: The memory is kept between batches of the same request and is    *
+ *           released when the request has been processed, keeping only the   *
+ *           first arena block.                                               *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_history_data_arena_release(void)
+{
+	if (NULL != history_arena)
+		zbx_arena_clear(history_arena);
+
+	zbx_free(history_row_buf);
+	history_row_buf_alloc = 0;
 }
 
 /******************************************************************************
@@ -1438,11 +1678,72 @@ static void	log_client_timediff(int level, struct zbx_json_parse *jp, const zbx_
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: locates known tags in history data json row                       *
+ *                                                                            *
+ * Parameters: jp_row - [IN] JSON with history data row                       *
+ *             tags   - [OUT] pointers to the tag values in json, NULL if     *
+ *                            the tag is not present                          *
+ *                                                                            *
+ * Comments: The row is scanned only once instead of searching every tag by   *
+ *           name, which rescans the row from the beginning for each tag.     *
+ *           When a tag is repeated the first occurrence is used, the same as *
+ *           with zbx_json_pair_by_name().                                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	parse_history_data_row_tags(const struct zbx_json_parse *jp_row, const char **tags)
+{
+	char		name[MAX_STRING_LEN];
+	const char	*p = NULL;
+	int		i;
+
+	memset(tags, 0, sizeof(const char *) * HISTORY_ROW_TAG_COUNT);
+
+	while (NULL != (p = zbx_json_pair_next(jp_row, p, name, sizeof(name))))
+	{
+		for (i = 0; i < HISTORY_ROW_TAG_COUNT; i++)
+		{
+			if (0 == strcmp(name, history_row_tags[i]))
+			{
+				if (NULL == tags[i])
+					tags[i] = p;
+				break;
+			}
+		}
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: decodes history data row tag value                                *
+ *                                                                            *
+ * Parameters: tags         - [IN] the row tag values                         *
+ *             tag          - [IN] the tag to decode                          *
+ *             string       - [IN/OUT] the decoded value                      *
+ *             string_alloc - [IN/OUT] the decoded value buffer size          *
+ *                                                                            *
+ * Return value:  SUCCEED - the tag value was decoded successfully            *
+ *                FAIL    - the tag is missing or has non-primitive value     *
+ *                                                                            *
+ ******************************************************************************/
+static int	history_row_tag_value(const char **tags, zbx_history_row_tag_t tag, char **string,
+		size_t *string_alloc)
+{
+	if (NULL == tags[tag])
+		return FAIL;
+
+	if (NULL == zbx_json_decodevalue_dyn(tags[tag], string, string_alloc, NULL))
+		return FAIL;
+
+	return SUCCEED;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: parses agent value from history data json row                     *
  *                                                                            *
- * Parameters: jp_row       - [IN] JSON with history data row                 *
+ * Parameters: tags         - [IN] the row tag values                         *
  *             unique_shift - [IN/OUT] auto increment nanoseconds to ensure   *
  *                                     unique value of timestamps             *
  *             av           - [OUT] the agent value                           *
@@ -1450,27 +1751,27 @@ static void	log_client_timediff(int level, struct zbx_json_parse *jp, const zbx_
  * Return value:  SUCCEED - the value was parsed successfully                 *
  *                FAIL    - otherwise                                         *
  *                                                                            *
+ * Comments: The value strings are allocated from history arena.              *
+ *                                                                            *
  ******************************************************************************/
-static int	parse_history_data_row_value(const struct zbx_json_parse *jp_row, zbx_timespec_t *unique_shift,
-		zbx_agent_value_t *av)
+static int	parse_history_data_row_value(const char **tags, zbx_timespec_t *unique_shift, zbx_agent_value_t *av)
 {
-	char	*tmp = NULL;
-	size_t	tmp_alloc = 0;
-	int	ret = FAIL;
+	char	**tmp = &history_row_buf;
+	size_t	*tmp_alloc = &history_row_buf_alloc;
 
 	memset(av, 0, sizeof(zbx_agent_value_t));
 
-	if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_CLOCK, &tmp, &tmp_alloc, NULL))
+	if (SUCCEED == history_row_tag_value(tags, HISTORY_ROW_TAG_CLOCK, tmp, tmp_alloc))
 	{
-		if (FAIL == zbx_is_uint31(tmp, &av->ts.sec))
-			goto out;
+		if (FAIL == zbx_is_uint31(*tmp, &av->ts.sec))
+			return FAIL;
 
-		if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_NS, &tmp, &tmp_alloc, NULL))
+		if (SUCCEED == history_row_tag_value(tags, HISTORY_ROW_TAG_NS, tmp, tmp_alloc))
 		{
-			if (FAIL == zbx_is_uint_n_range(tmp, tmp_alloc, &av->ts.ns, sizeof(av->ts.ns),
+			if (FAIL == zbx_is_uint_n_range(*tmp, *tmp_alloc, &av->ts.ns, sizeof(av->ts.ns),
 				0LL, 999999999LL))
 			{
-				goto out;
+				return FAIL;
 			}
 		}
 		else
@@ -1490,68 +1791,67 @@ static int	parse_history_data_row_value(const struct zbx_json_parse *jp_row, zbx
 	else
 		zbx_timespec(&av->ts);
 
-	if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_STATE, &tmp, &tmp_alloc, NULL))
-		av->state = (unsigned char)atoi(tmp);
+	if (SUCCEED == history_row_tag_value(tags, HISTORY_ROW_TAG_STATE, tmp, tmp_alloc))
+		av->state = (unsigned char)atoi(*tmp);
 
 	/* Unsupported item meta information must be ignored for backwards compatibility. */
 	/* New agents will not send meta information for items in unsupported state.      */
 	if (ITEM_STATE_NOTSUPPORTED != av->state)
 	{
-		if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_LASTLOGSIZE, &tmp, &tmp_alloc, NULL))
+		if (SUCCEED == history_row_tag_value(tags, HISTORY_ROW_TAG_LASTLOGSIZE, tmp, tmp_alloc))
 		{
 			av->meta = 1;	/* contains meta information */
 
-			zbx_is_uint64(tmp, &av->lastlogsize);
+			zbx_is_uint64(*tmp, &av->lastlogsize);
 
-			if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_MTIME, &tmp, &tmp_alloc, NULL))
-				av->mtime = atoi(tmp);
+			if (SUCCEED == history_row_tag_value(tags, HISTORY_ROW_TAG_MTIME, tmp, tmp_alloc))
+				av->mtime = atoi(*tmp);
 		}
 	}
 
-	if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_VALUE, &tmp, &tmp_alloc, NULL))
-		av->value = zbx_strdup(av->value, tmp);
+	if (SUCCEED == history_row_tag_value(tags, HISTORY_ROW_TAG_VALUE, tmp, tmp_alloc))
+		av->value = zbx_arena_strdup(history_arena_get(), *tmp);
 
-	if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_LOGTIMESTAMP, &tmp, &tmp_alloc, NULL))
-		av->timestamp = atoi(tmp);
+	if (SUCCEED == history_row_tag_value(tags, HISTORY_ROW_TAG_LOGTIMESTAMP, tmp, tmp_alloc))
+		av->timestamp = atoi(*tmp);
 
-	if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_LOGSOURCE, &tmp, &tmp_alloc, NULL))
-		av->source = zbx_strdup(av->source, tmp);
+	if (SUCCEED == history_row_tag_value(tags, HISTORY_ROW_TAG_LOGSOURCE, tmp, tmp_alloc))
+		av->source = zbx_arena_strdup(history_arena_get(), *tmp);
 
-	if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_LOGSEVERITY, &tmp, &tmp_alloc, NULL))
-		av->severity = atoi(tmp);
+	if (SUCCEED == history_row_tag_value(tags, HISTORY_ROW_TAG_LOGSEVERITY, tmp, tmp_alloc))
+		av->severity = atoi(*tmp);
 
-	if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_LOGEVENTID, &tmp, &tmp_alloc, NULL))
-		av->logeventid = atoi(tmp);
+	if (SUCCEED == history_row_tag_value(tags, HISTORY_ROW_TAG_LOGEVENTID, tmp, tmp_alloc))
+		av->logeventid = atoi(*tmp);
 
-	if (SUCCEED != zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_ID, &tmp, &tmp_alloc, NULL) ||
-			SUCCEED != zbx_is_uint64(tmp, &av->id))
+	if (SUCCEED != history_row_tag_value(tags, HISTORY_ROW_TAG_ID, tmp, tmp_alloc) ||
+			SUCCEED != zbx_is_uint64(*tmp, &av->id))
 	{
 		av->id = 0;
 	}
 
-	zbx_free(tmp);
-
-	ret = SUCCEED;
-out:
-	return ret;
+	return SUCCEED;
 }
 
 /******************************************************************************
  *                                                                            *
  * Purpose: parses item identifier from history data json row                 *
  *                                                                            *
- * Parameters: jp_row - [IN] JSON with history data row                       *
+ * Parameters: tags   - [IN] the row tag values                               *
  *             itemid - [OUT] the item identifier                             *
  *                                                                            *
  * Return value:  SUCCEED - the item identifier was parsed successfully       *
  *                FAIL    - otherwise                                         *
  *                                                                            *
  ******************************************************************************/
-static int	parse_history_data_row_itemid(const struct zbx_json_parse *jp_row, zbx_uint64_t *itemid)
+static int	parse_history_data_row_itemid(const char **tags, zbx_uint64_t *itemid)
 {
 	char	buffer[MAX_ID_LEN + 1];
 
-	if (SUCCEED != zbx_json_value_by_name(jp_row, ZBX_PROTO_TAG_ITEMID, buffer, sizeof(buffer), NULL))
+	if (NULL == tags[HISTORY_ROW_TAG_ITEMID])
+		return FAIL;
+
+	if (NULL == zbx_json_decodevalue(tags[HISTORY_ROW_TAG_ITEMID], buffer, sizeof(buffer), NULL))
 		return FAIL;
 
 	if (SUCCEED != zbx_is_uint64(buffer, itemid))
@@ -1563,31 +1863,26 @@ static int	parse_history_data_row_itemid(const struct zbx_json_parse *jp_row, zb
  *                                                                            *
  * Purpose: parses host,key pair from history data json row                   *
  *                                                                            *
- * Parameters: jp_row - [IN] JSON with history data row                       *
- *             hk     - [OUT] the host,key pair                               *
+ * Parameters: tags - [IN] the row tag values                                 *
+ *             hk   - [OUT] the host,key pair                                 *
  *                                                                            *
  * Return value:  SUCCEED - the host,key pair was parsed successfully         *
  *                FAIL    - otherwise                                         *
  *                                                                            *
  ******************************************************************************/
-static int	parse_history_data_row_hostkey(const struct zbx_json_parse *jp_row, zbx_host_key_t *hk)
+static int	parse_history_data_row_hostkey(const char **tags, zbx_host_key_t *hk)
 {
-	size_t str_alloc;
+	zbx_arena_t	*arena = history_arena_get();
 
-	str_alloc = 0;
-	zbx_free(hk->host);
-
-	if (SUCCEED != zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_HOST, &hk->host, &str_alloc, NULL))
+	if (SUCCEED != history_row_tag_value(tags, HISTORY_ROW_TAG_HOST, &history_row_buf, &history_row_buf_alloc))
 		return FAIL;
 
-	str_alloc = 0;
-	zbx_free(hk->key);
+	hk->host = zbx_arena_strdup(arena, history_row_buf);
 
-	if (SUCCEED != zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_KEY, &hk->key, &str_alloc, NULL))
-	{
-		zbx_free(hk->host);
+	if (SUCCEED != history_row_tag_value(tags, HISTORY_ROW_TAG_KEY, &history_row_buf, &history_row_buf_alloc))
 		return FAIL;
-	}
+
+	hk->key = zbx_arena_strdup(arena, history_row_buf);
 
 	return SUCCEED;
 }
@@ -1616,6 +1911,7 @@ static int	parse_history_data(struct zbx_json_parse *jp_data, const char **pnext
 		zbx_host_key_t *hostkeys, int *values_num, int *parsed_num, zbx_timespec_t *unique_shift)
 {
 	struct zbx_json_parse	jp_row;
+	const char		*tags[HISTORY_ROW_TAG_COUNT];
 	int			ret = FAIL;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
@@ -1643,10 +1939,12 @@ static int	parse_history_data(struct zbx_json_parse *jp_data, const char **pnext
 
 		(*parsed_num)++;
 
-		if (SUCCEED != parse_history_data_row_hostkey(&jp_row, &hostkeys[*values_num]))
+		parse_history_data_row_tags(&jp_row, tags);
+
+		if (SUCCEED != parse_history_data_row_hostkey(tags, &hostkeys[*values_num]))
 			continue;
 
-		if (SUCCEED != parse_history_data_row_value(&jp_row, unique_shift, &values[*values_num]))
+		if (SUCCEED != parse_history_data_row_value(tags, unique_shift, &values[*values_num]))
 			continue;
 
 		(*values_num)++;
@@ -1691,6 +1989,7 @@ static int	parse_history_data_by_itemids(struct zbx_json_parse *jp_data, const c
 		zbx_timespec_t *unique_shift, char **error)
 {
 	struct zbx_json_parse	jp_row;
+	const char		*tags[HISTORY_ROW_TAG_COUNT];
 	int			ret = FAIL;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
@@ -1718,10 +2017,12 @@ static int	parse_history_data_by_itemids(struct zbx_json_parse *jp_data, const c
 
 		(*parsed_num)++;
 
-		if (SUCCEED != parse_history_data_row_itemid(&jp_row, &itemids[*values_num]))
+		parse_history_data_row_tags(&jp_row, tags);
+
+		if (SUCCEED != parse_history_data_row_itemid(tags, &itemids[*values_num]))
 			continue;
 
-		if (SUCCEED != parse_history_data_row_value(&jp_row, unique_shift, &values[*values_num]))
+		if (SUCCEED != parse_history_data_row_value(tags, unique_shift, &values[*values_num]))
 			continue;
 
 		(*values_num)++;
@@ -1736,6 +2037,54 @@ out:
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reads up to ZBX_HISTORY_VALUES_MAX item values and item           *
+ *          identifiers from binary history data                              *
+ *                                                                            *
+ * Parameters: reader       - [IN/OUT] the binary history data reader         *
+ *             values       - [OUT] the item values                           *
+ *             itemids      - [OUT] the corresponding item identifiers        *
+ *             values_num   - [OUT] number of elements in values and itemids  *
+ *                                  arrays                                    *
+ *             parsed_num   - [OUT] the number of values parsed               *
+ *             error        - [OUT] the error message                         *
+ *                                                                            *
+ * Return value:  SUCCEED - values were read successfully                     *
+ *                FAIL    - an error occurred                                 *
+ *                                                                            *
+ ******************************************************************************/
+static int	parse_history_data_binary(zbx_history_binary_reader_t *reader, zbx_agent_value_t *values,
+		zbx_uint64_t *itemids, int *values_num, int *parsed_num, char **error)
+{
+	int	ret = SUCCEED;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	*values_num = 0;
+	*parsed_num = 0;
+
+	while (0 != reader->rows_left && *values_num < ZBX_HISTORY_VALUES_MAX)
+	{
+		if (SUCCEED != zbx_history_binary_reader_next(reader, &itemids[*values_num], history_arena_get(),
+				&values[*values_num], error))
+		{
+			zbx_arena_reset(history_arena_get());
+			*values_num = 0;
+			ret = FAIL;
+			break;
+		}
+
+		(*parsed_num)++;
+		(*values_num)++;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s processed:%d/%d", __func__, zbx_result_string(ret),
+			*values_num, *parsed_num);
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: validates item received from proxy                                *
@@ -1775,7 +2124,10 @@ static int	proxy_item_validator(zbx_history_recv_item_t *item, zbx_socket_t *soc
  * Parameters: sock           - [IN]  socket for host permission validation   *
  *             validator_func - [IN]  function to validate item permission    *
  *             validator_args - [IN]  validator function arguments            *
- *             jp_data        - [IN]  JSON with history data array            *
+ *             jp_data        - [IN]  JSON with history data array, NULL if   *
+ *                                    binary history data is processed        *
+ *             reader         - [IN]  binary history data reader, NULL if     *
+ *                                    JSON history data is processed          *
  *             session        - [IN]  the data session                        *
  *             nodata_win     - [OUT] counter of delayed values               *
  *             info           - [OUT] address of a pointer to the info        *
@@ -1792,8 +2144,8 @@ static int	proxy_item_validator(zbx_history_recv_item_t *item, zbx_socket_t *soc
  *                                                                            *
  ******************************************************************************/
 static int	process_history_data_by_itemids(zbx_socket_t *sock, zbx_client_item_validator_t validator_func,
-		void *validator_args, struct zbx_json_parse *jp_data, zbx_session_t *session,
-		zbx_proxy_suppress_t *nodata_win, char **info, unsigned int mode)
+		void *validator_args, struct zbx_json_parse *jp_data, zbx_history_binary_reader_t *reader,
+		zbx_session_t *session, zbx_proxy_suppress_t *nodata_win, char **info, unsigned int mode)
 {
 	const char		*pnext = NULL;
 	int			ret = SUCCEED, processed_num = 0, total_num = 0, values_num, read_num, i, *errcodes;
@@ -1811,8 +2163,10 @@ static int	process_history_data_by_itemids(zbx_socket_t *sock, zbx_client_item_v
 
 	sec = zbx_time();
 
-	while (SUCCEED == parse_history_data_by_itemids(jp_data, &pnext, values, itemids, &values_num, &read_num,
-			&unique_shift, &error) && 0 != values_num)
+	while (SUCCEED == (NULL != reader ?
+			parse_history_data_binary(reader, values, itemids, &values_num, &read_num, &error) :
+			parse_history_data_by_itemids(jp_data, &pnext, values, itemids, &values_num, &read_num,
+			&unique_shift, &error)) && 0 != values_num)
 	{
 		zbx_dc_config_history_recv_get_items_by_itemids(items, itemids, errcodes, (size_t)values_num, mode);
 
@@ -1846,9 +2200,9 @@ static int	process_history_data_by_itemids(zbx_socket_t *sock, zbx_client_item_v
 
 		last_valueid = values[values_num - 1].id;
 
-		zbx_agent_values_clean(values, values_num);
+		zbx_arena_reset(history_arena_get());
 
-		if (NULL == pnext)
+		if (NULL != reader ? 0 == reader->rows_left : NULL == pnext)
 			break;
 	}
 
@@ -1906,9 +2260,10 @@ static int	agent_item_validator(zbx_history_recv_item_t *item, zbx_socket_t *soc
 	if (ITEM_TYPE_ZABBIX_ACTIVE != item->type)
 		return FAIL;
 
-	if (rights->hostid != item->host.hostid)
+	if (rights->hostid != item->host.hostid || rights->revision != item->host.revision)
 	{
 		rights->hostid = item->host.hostid;
+		rights->revision = item->host.revision;
 		rights->value = zbx_host_check_permissions(&item->host, sock, error);
 	}
 
@@ -2063,18 +2418,12 @@ static void	process_history_data_by_keys(zbx_socket_t *sock, zbx_client_item_val
 		processed_num += zbx_process_history_data(items, values, errcodes, values_num, NULL);
 		total_num += read_num;
 
-		zbx_agent_values_clean(values, values_num);
+		zbx_arena_reset(history_arena_get());
 
 		if (NULL == pnext)
 			break;
 	}
 
-	for (i = 0; i < ZBX_HISTORY_VALUES_MAX; i++)
-	{
-		zbx_free(hostkeys[i].host);
-		zbx_free(hostkeys[i].key);
-	}
-
 	zbx_free(hostkeys);
 	zbx_free(items);
 
@@ -2156,7 +2505,7 @@ static int	process_client_history_data(zbx_socket_t *sock, struct zbx_json_parse
 			session = zbx_dc_get_or_create_session(hostid, token, ZBX_SESSION_TYPE_DATA);
 
 		if (SUCCEED != (ret = process_history_data_by_itemids(sock, validator_func, validator_args, &jp_data,
-				session, NULL, info, ZBX_ITEM_GET_DEFAULT)))
+				NULL, session, NULL, info, ZBX_ITEM_GET_DEFAULT)))
 		{
 			goto out;
 		}
@@ -2178,18 +2527,25 @@ out:
  * Parameters: sock         - [IN] the connection socket                      *
  *             jp           - [IN] the JSON with history data                 *
  *             ts           - [IN] the connection timestamp                   *
+ *             rights       - [IN/OUT] host permissions checked by previous   *
+ *                                     requests of the same connection        *
+ *                                     (optional)                             *
  *             info         - [OUT] address of a pointer to the info string   *
  *                                  (should be freed by the caller)           *
  *                                                                            *
  * Return value:  SUCCEED - processed successfully                            *
  *                FAIL - an error occurred                                    *
  *                                                                            *
+ * Comments: Permissions are checked again when host configuration changes.   *
+ *                                                                            *
  ******************************************************************************/
-int	zbx_process_agent_history_data(zbx_socket_t *sock, struct zbx_json_parse *jp, zbx_timespec_t *ts, char **info)
+int	zbx_process_agent_history_data(zbx_socket_t *sock, struct zbx_json_parse *jp, zbx_timespec_t *ts,
+		zbx_host_rights_t *rights, char **info)
 {
-	zbx_host_rights_t	rights = {0};
+	zbx_host_rights_t	rights_local = {0};
 
-	return process_client_history_data(sock, jp, ts, agent_item_validator, &rights, info);
+	return process_client_history_data(sock, jp, ts, agent_item_validator, NULL != rights ? rights : &rights_local,
+			info);
 }
 
 /******************************************************************************
@@ -2593,7 +2949,8 @@ json_parse_error:
 		if (NULL != events_cbs->clean_events_cb)
 			events_cbs->clean_events_cb();
 
-		zbx_db_commit();
+		if (ZBX_DB_OK == zbx_db_commit() && NULL != events_cbs->events_notify_escalators_cb)
+			events_cbs->events_notify_escalators_cb();
 	}
 json_parse_return:
 	zbx_free(value);
@@ -2749,7 +3106,10 @@ static int	process_autoregistration_contents(struct zbx_json_parse *jp_data, zbx
 	{
 		zbx_db_begin();
 		zbx_db_register_host_flush(&autoreg_hosts, proxy_hostid, events_cbs);
-		zbx_db_commit();
+
+		if (ZBX_DB_OK == zbx_db_commit() && NULL != events_cbs->events_notify_escalators_cb)
+			events_cbs->events_notify_escalators_cb();
+
 		zbx_dc_config_delete_autoreg_host(&autoreg_hosts);
 	}
 
@@ -2925,7 +3285,7 @@ int	zbx_process_proxy_data(const zbx_dc_proxy_t *proxy, struct zbx_json_parse *j
 		char **error)
 {
 	struct zbx_json_parse	jp_data;
-	int			ret = SUCCEED, flags_old;
+	int			ret = SUCCEED, flags_old, history_json;
 	char			*error_step = NULL, value[MAX_STRING_LEN];
 	size_t			error_alloc = 0, error_offset = 0;
 	zbx_proxy_diff_t	proxy_diff;
@@ -2978,9 +3338,11 @@ int	zbx_process_proxy_data(const zbx_dc_proxy_t *proxy, struct zbx_json_parse *j
 
 	flags_old = proxy_diff.nodata_win.flags;
 
-	if (SUCCEED == zbx_json_brackets_by_name(jp, ZBX_PROTO_TAG_HISTORY_DATA, &jp_data))
+	if (SUCCEED == (history_json = zbx_json_brackets_by_name(jp, ZBX_PROTO_TAG_HISTORY_DATA, &jp_data)) ||
+			NULL != zbx_json_pair_by_name(jp, ZBX_PROTO_TAG_HISTORY_DATA_BINARY))
 	{
-		zbx_session_t	*session = NULL;
+		zbx_session_t			*session = NULL;
+		zbx_history_binary_reader_t	reader;
 
 		if (SUCCEED == zbx_json_value_by_name(jp, ZBX_PROTO_TAG_SESSION, value, sizeof(value), NULL))
 		{
@@ -2996,12 +3358,22 @@ int	zbx_process_proxy_data(const zbx_dc_proxy_t *proxy, struct zbx_json_parse *j
 			session = zbx_dc_get_or_create_session(proxy->hostid, value, ZBX_SESSION_TYPE_DATA);
 		}
 
-		if (SUCCEED != (ret = process_history_data_by_itemids(NULL, proxy_item_validator,
-				(void *)&proxy->hostid, &jp_data, session, &proxy_diff.nodata_win, &error_step,
-				ZBX_ITEM_GET_PROCESS)))
+		if (SUCCEED == history_json)
 		{
-			zbx_strcatnl_alloc(error, &error_alloc, &error_offset, error_step);
+			ret = process_history_data_by_itemids(NULL, proxy_item_validator, (void *)&proxy->hostid,
+					&jp_data, NULL, session, &proxy_diff.nodata_win, &error_step,
+					ZBX_ITEM_GET_PROCESS);
 		}
+		else if (SUCCEED == (ret = zbx_history_binary_reader_open(&reader, jp, &error_step)))
+		{
+			ret = process_history_data_by_itemids(NULL, proxy_item_validator, (void *)&proxy->hostid,
+					NULL, &reader, session, &proxy_diff.nodata_win, &error_step,
+					ZBX_ITEM_GET_PROCESS);
+			zbx_history_binary_reader_close(&reader);
+		}
+
+		if (SUCCEED != ret)
+			zbx_strcatnl_alloc(error, &error_alloc, &error_offset, error_step);
 	}
 
 	if (0 != (proxy_diff.nodata_win.flags & ZBX_PROXY_SUPPRESS_ACTIVE))
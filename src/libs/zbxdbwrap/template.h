@@ -83,6 +83,8 @@ typedef struct
 #define ZBX_FLAG_TEMPLATE_ITEM_UPDATE_VERIFY_HOST	__UINT64_C(0x200000000000)
 #define ZBX_FLAG_TEMPLATE_ITEM_UPDATE_ALLOW_TRAPS	__UINT64_C(0x400000000000)
 #define ZBX_FLAG_TEMPLATE_ITEM_UPDATE_DISCOVER		__UINT64_C(0x800000000000)
+#define ZBX_FLAG_TEMPLATE_ITEM_UPDATE_DOWNSAMPLE		__UINT64_C(0x1000000000000)
+#define ZBX_FLAG_TEMPLATE_ITEM_UPDATE_DOWNSAMPLE_PARAM	__UINT64_C(0x2000000000000)
 
 	zbx_uint64_t			upd_flags;
 	zbx_uint64_t			valuemapid_orig;
@@ -150,6 +152,8 @@ typedef struct
 	char				*ssl_key_file;
 	char				*ssl_key_password_orig;
 	char				*ssl_key_password;
+	char				*history_downsample_param_orig;
+	char				*history_downsample_param;
 	unsigned char			verify_peer_orig;
 	unsigned char			verify_peer;
 	unsigned char			verify_host_orig;
@@ -182,6 +186,8 @@ typedef struct
 	unsigned char			allow_traps;
 	unsigned char			discover_orig;
 	unsigned char			discover;
+	unsigned char			history_downsample_orig;
+	unsigned char			history_downsample;
 	zbx_vector_ptr_t		dependent_items;
 	zbx_vector_item_preproc_ptr_t	item_preprocs;
 	zbx_vector_item_preproc_ptr_t	template_preprocs;
@@ -208,7 +208,9 @@ static void	get_template_items(zbx_uint64_t hostid, const zbx_vector_uint64_t *t
 				"hi.jmx_endpoint,hi.master_itemid,hi.timeout,hi.url,hi.query_fields,hi.posts,"
 				"hi.status_codes,hi.follow_redirects,hi.post_type,hi.http_proxy,hi.headers,"
 				"hi.retrieve_mode,hi.request_method,hi.output_format,hi.ssl_cert_file,hi.ssl_key_file,"
-				"hi.ssl_key_password,hi.verify_peer,hi.verify_host,hi.allow_traps,hi.discover"
+				"hi.ssl_key_password,hi.verify_peer,hi.verify_host,hi.allow_traps,hi.discover,"
+				"ti.history_downsample,ti.history_downsample_param,hi.history_downsample,"
+				"hi.history_downsample_param"
 			" from items ti"
 			" left join items hi on hi.key_=ti.key_"
 				" and hi.hostid=" ZBX_FS_UI64
@@ -382,6 +384,12 @@ static void	get_template_items(zbx_uint64_t hostid, const zbx_vector_uint64_t *t
 		item->discover_orig = 0;
 		ZBX_STR2UCHAR(item->discover, row[48]);
 
+		item->history_downsample_orig = 0;
+		ZBX_STR2UCHAR(item->history_downsample, row[97]);
+
+		item->history_downsample_param_orig = NULL;
+		item->history_downsample_param = zbx_strdup(NULL, row[98]);
+
 		item->upd_flags = ZBX_FLAG_TEMPLATE_ITEM_UPDATE_RESET_FLAG;
 
 		if (SUCCEED != zbx_db_is_null(row[26]))
@@ -473,6 +481,9 @@ static void	get_template_items(zbx_uint64_t hostid, const zbx_vector_uint64_t *t
 			SET_FLAG_UCHAR(row[94], item->verify_host, ZBX_FLAG_TEMPLATE_ITEM_UPDATE_VERIFY_HOST);
 			SET_FLAG_UCHAR(row[95], item->allow_traps, ZBX_FLAG_TEMPLATE_ITEM_UPDATE_ALLOW_TRAPS);
 			SET_FLAG_UCHAR(row[96], item->discover, ZBX_FLAG_TEMPLATE_ITEM_UPDATE_DISCOVER);
+			SET_FLAG_UCHAR(row[99], item->history_downsample, ZBX_FLAG_TEMPLATE_ITEM_UPDATE_DOWNSAMPLE);
+			SET_FLAG_STR(row[100], item->history_downsample_param,
+					ZBX_FLAG_TEMPLATE_ITEM_UPDATE_DOWNSAMPLE_PARAM);
 		}
 		else
 		{
@@ -906,6 +917,8 @@ static void	save_template_item(zbx_uint64_t hostid, zbx_uint64_t *itemid, zbx_te
 		PREPARE_UPDATE_UC(VERIFY_HOST, verify_host)
 		PREPARE_UPDATE_UC(ALLOW_TRAPS, allow_traps)
 		PREPARE_UPDATE_UC(DISCOVER, discover)
+		PREPARE_UPDATE_UC(DOWNSAMPLE, history_downsample)
+		PREPARE_UPDATE_STR(DOWNSAMPLE_PARAM, history_downsample_param)
 		ZBX_UNUSED(d);
 
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, " where itemid=" ZBX_FS_UI64 ";\n", item->itemid);
@@ -923,7 +936,8 @@ static void	save_template_item(zbx_uint64_t hostid, zbx_uint64_t *itemid, zbx_te
 				item->posts, item->status_codes, item->follow_redirects, item->post_type,
 				item->http_proxy, item->headers, item->retrieve_mode, item->request_method,
 				item->output_format, item->ssl_cert_file, item->ssl_key_file, item->ssl_key_password,
-				item->verify_peer, item->verify_host, item->allow_traps, item->discover);
+				item->verify_peer, item->verify_host, item->allow_traps, item->discover,
+				(int)item->history_downsample, item->history_downsample_param);
 
 		zbx_db_insert_add_values(db_insert_irtdata, *itemid);
 
@@ -991,7 +1005,8 @@ static void	save_template_items(zbx_uint64_t hostid, zbx_vector_ptr_t *items)
 				"timeout", "url", "query_fields", "posts", "status_codes", "follow_redirects",
 				"post_type", "http_proxy", "headers", "retrieve_mode", "request_method",
 				"output_format", "ssl_cert_file", "ssl_key_file", "ssl_key_password", "verify_peer",
-				"verify_host", "allow_traps", "discover", NULL);
+				"verify_host", "allow_traps", "discover", "history_downsample", "history_downsample_param",
+				NULL);
 
 		zbx_db_insert_prepare(&db_insert_irtdata, "item_rtdata", "itemid", NULL);
 	}
@@ -1420,6 +1435,7 @@ static void	free_template_item(zbx_template_item_t *item)
 	CLEAN_ORIG(SSL_CERT_FILE, ssl_cert_file)
 	CLEAN_ORIG(SSL_KEY_FILE, ssl_key_file)
 	CLEAN_ORIG(SSL_KEY_PASSWORD, ssl_key_password)
+	CLEAN_ORIG(DOWNSAMPLE_PARAM, history_downsample_param)
 #undef CLEAN_ORIG
 	zbx_free(item->key);
 
@@ -24,11 +24,13 @@
 #include "zbxshmem.h"
 #include "zbxcachehistory.h"
 #include "zbxconnector.h"
+#include "zbxcacheconfig.h"
 #include "log.h"
 #include "zbxmutexs.h"
 #include "zbxtime.h"
 #include "zbxnum.h"
 #include "zbxpreproc.h"
+#include "zbxprof.h"
 
 #define ZBX_DIAG_SECTION_MAX	64
 #define ZBX_DIAG_FIELD_MAX	64
@@ -45,12 +47,16 @@
 					ZBX_DIAG_HISTORYCACHE_MEMORY_INDEX)
 
 #define ZBX_DIAG_PREPROC_INFO			0x00000001
+#define ZBX_DIAG_PREPROC_WORKERS		0x00000002
 
 #define ZBX_DIAG_PREPROC_SIMPLE		(ZBX_DIAG_PREPROC_INFO)
 
 #define ZBX_DIAG_CONNECTOR_VALUES			0x00000001
 #define ZBX_DIAG_CONNECTOR_SIMPLE		(ZBX_DIAG_CONNECTOR_VALUES)
 
+#define ZBX_DIAG_DISCOVERY_VALUES			0x00000001
+#define ZBX_DIAG_DISCOVERY_SIMPLE		(ZBX_DIAG_DISCOVERY_VALUES)
+
 static zbx_diag_add_section_info_func_t	add_diag_cb;
 
 void	zbx_diag_map_free(zbx_diag_map_t *map)
@@ -194,8 +200,8 @@ void	zbx_diag_add_mem_stats(struct zbx_json *json, const char *name, const zbx_s
 		{
 			char	buf[MAX_ID_LEN + 2];
 
-			zbx_snprintf(buf, sizeof(buf), "%d%s", ZBX_SHMEM_MIN_BUCKET_SIZE + 8 * i,
-					(ZBX_SHMEM_BUCKET_COUNT - 1 == i ? "+" : ""));
+			zbx_snprintf(buf, sizeof(buf), ZBX_FS_UI64 "%s", zbx_shmem_bucket_size(i),
+					(ZBX_SHMEM_EXACT_BUCKET_COUNT <= i ? "+" : ""));
 			zbx_json_addobject(json, NULL);
 			zbx_json_adduint64(json, buf, stats->chunks_num[i]);
 			zbx_json_close(json);
@@ -392,6 +398,41 @@ static void	diag_add_preproc_sequences(struct zbx_json *json, const char *field,
 	zbx_json_close(json);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: add preprocessing worker task steal and idle wait counters to     *
+ *          output json                                                       *
+ *                                                                            *
+ * Parameters: json   - [OUT] the output json                                 *
+ *             steals - [IN] worker task steal counters                       *
+ *             idles  - [IN] worker idle wait counters                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	diag_add_preproc_workers(struct zbx_json *json, const zbx_vector_uint64_t *steals,
+		const zbx_vector_uint64_t *idles)
+{
+	zbx_uint64_t	steals_total = 0, idles_total = 0;
+
+	zbx_json_addarray(json, "workers");
+
+	for (int i = 0; i < steals->values_num && i < idles->values_num; i++)
+	{
+		zbx_json_addobject(json, NULL);
+		zbx_json_addint64(json, "id", i + 1);
+		zbx_json_adduint64(json, "stolen tasks", steals->values[i]);
+		zbx_json_adduint64(json, "idle waits", idles->values[i]);
+		zbx_json_close(json);
+
+		steals_total += steals->values[i];
+		idles_total += idles->values[i];
+	}
+
+	zbx_json_close(json);
+
+	zbx_json_adduint64(json, "stolen tasks", steals_total);
+	zbx_json_adduint64(json, "idle waits", idles_total);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: add requested preprocessing diagnostic information to json data   *
@@ -411,7 +452,8 @@ int	zbx_diag_add_preproc_info(const struct zbx_json_parse *jp, struct zbx_json *
 	double			time1, time2, time_total = 0;
 	zbx_uint64_t		fields;
 	zbx_diag_map_t		field_map[] = {
-					{"", ZBX_DIAG_PREPROC_INFO},
+					{"", ZBX_DIAG_PREPROC_SIMPLE},
+					{"workers", ZBX_DIAG_PREPROC_WORKERS},
 					{NULL, 0}
 					};
 
@@ -423,11 +465,13 @@ int	zbx_diag_add_preproc_info(const struct zbx_json_parse *jp, struct zbx_json *
 
 		if (0 != (fields & ZBX_DIAG_PREPROC_SIMPLE))
 		{
-			zbx_uint64_t	preproc_num, pending_num, finished_num, sequences_num;
+			zbx_uint64_t			preproc_num, pending_num, finished_num, sequences_num;
+			zbx_pp_script_stats_t		scripts;
+			zbx_regexp_cache_stats_t	regexps;
 
 			time1 = zbx_time();
 			if (FAIL == (ret = zbx_preprocessor_get_diag_stats(&preproc_num, &pending_num, &finished_num,
-					&sequences_num, error)))
+					&sequences_num, &scripts, &regexps, error)))
 			{
 				goto out;
 			}
@@ -441,7 +485,37 @@ int	zbx_diag_add_preproc_info(const struct zbx_json_parse *jp, struct zbx_json *
 				zbx_json_adduint64(json, "pending tasks", pending_num);
 				zbx_json_adduint64(json, "finished tasks", finished_num);
 				zbx_json_adduint64(json, "task sequences", sequences_num);
+				zbx_json_adduint64(json, "cached scripts", scripts.scripts_num);
+				zbx_json_adduint64(json, "script compilations", scripts.compiled_num);
+				zbx_json_adduint64(json, "script cache hits", scripts.hits_num);
+				zbx_json_adduint64(json, "script environment resets", scripts.resets_num);
+				zbx_json_adduint64(json, "regexp cache hits", regexps.hits_num);
+				zbx_json_adduint64(json, "regexp cache misses", regexps.misses_num);
+			}
+		}
+
+		if (0 != (fields & ZBX_DIAG_PREPROC_WORKERS))
+		{
+			zbx_vector_uint64_t	steals, idles;
+
+			zbx_vector_uint64_create(&steals);
+			zbx_vector_uint64_create(&idles);
+
+			time1 = zbx_time();
+			if (FAIL == (ret = zbx_preprocessor_get_worker_stats(&steals, &idles, error)))
+			{
+				zbx_vector_uint64_destroy(&idles);
+				zbx_vector_uint64_destroy(&steals);
+				goto out;
 			}
+
+			time2 = zbx_time();
+			time_total += time2 - time1;
+
+			diag_add_preproc_workers(json, &steals, &idles);
+
+			zbx_vector_uint64_destroy(&idles);
+			zbx_vector_uint64_destroy(&steals);
 		}
 
 		if (0 != tops.values_num)
@@ -531,6 +605,46 @@ static void	diag_add_connector_items(struct zbx_json *json, const char *field,
 	zbx_json_close(json);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: add running discovery rule list to output json                    *
+ *                                                                            *
+ * Parameters: json        - [OUT] the output json                            *
+ *             field       - [IN] the field name                              *
+ *             drule_stats - [IN] a running discovery rule list               *
+ *             now         - [IN] the current timestamp                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	diag_add_discovery_rules(struct zbx_json *json, const char *field,
+		const zbx_vector_ptr_t *drule_stats, time_t now)
+{
+	int	i;
+
+	zbx_json_addarray(json, field);
+
+	for (i = 0; i < drule_stats->values_num; i++)
+	{
+		const zbx_dc_drule_stats_t	*stat = (const zbx_dc_drule_stats_t *)drule_stats->values[i];
+
+		zbx_json_addobject(json, NULL);
+		zbx_json_adduint64(json, "druleid", stat->druleid);
+		zbx_json_addint64(json, "addresses", stat->addresses_num);
+		zbx_json_addint64(json, "processed", stat->processed_num);
+		zbx_json_addint64(json, "elapsed", now - stat->started);
+		zbx_json_close(json);
+	}
+
+	zbx_json_close(json);
+}
+
+static int	diag_compare_drule_stats_remaining(const void *d1, const void *d2)
+{
+	const zbx_dc_drule_stats_t	*s1 = *(const zbx_dc_drule_stats_t * const *)d1;
+	const zbx_dc_drule_stats_t	*s2 = *(const zbx_dc_drule_stats_t * const *)d2;
+
+	return (s2->addresses_num - s2->processed_num) - (s1->addresses_num - s1->processed_num);
+}
+
 static void	zbx_json_addhex(struct zbx_json *j, const char *name, zbx_uint64_t value)
 {
 	char	buffer[MAX_ID_LEN];
@@ -548,40 +662,94 @@ static void	zbx_json_addhex(struct zbx_json *j, const char *name, zbx_uint64_t v
  ******************************************************************************/
 void	zbx_diag_add_locks_info(struct zbx_json *json)
 {
-	int		i;
-#ifdef HAVE_VMINFO_T_UPDATES
-	const char	*names[ZBX_MUTEX_COUNT] = {"ZBX_MUTEX_LOG", "ZBX_MUTEX_CACHE", "ZBX_MUTEX_TRENDS",
-				"ZBX_MUTEX_CACHE_IDS", "ZBX_MUTEX_SELFMON", "ZBX_MUTEX_CPUSTATS", "ZBX_MUTEX_DISKSTATS",
-				"ZBX_MUTEX_VALUECACHE", "ZBX_MUTEX_VMWARE", "ZBX_MUTEX_SQLITE3",
-				"ZBX_MUTEX_PROCSTAT", "ZBX_MUTEX_PROXY_HISTORY", "ZBX_MUTEX_KSTAT", "ZBX_MUTEX_MODBUS",
-				"ZBX_MUTEX_TREND_FUNC"};
-#else
-	const char	*names[ZBX_MUTEX_COUNT] = {"ZBX_MUTEX_LOG", "ZBX_MUTEX_CACHE", "ZBX_MUTEX_TRENDS",
-				"ZBX_MUTEX_CACHE_IDS", "ZBX_MUTEX_SELFMON", "ZBX_MUTEX_CPUSTATS", "ZBX_MUTEX_DISKSTATS",
-				"ZBX_MUTEX_VALUECACHE", "ZBX_MUTEX_VMWARE", "ZBX_MUTEX_SQLITE3",
-				"ZBX_MUTEX_PROCSTAT", "ZBX_MUTEX_PROXY_HISTORY", "ZBX_MUTEX_MODBUS",
-				"ZBX_MUTEX_TREND_FUNC"};
-#endif
 	zbx_json_addarray(json, ZBX_DIAG_LOCKS);
 
-	for (i = 0; i < ZBX_MUTEX_COUNT; i++)
+	for (int i = 0; i < ZBX_LOCKS_NUM; i++)
 	{
+		char			name[64];
+		zbx_uint64_t		addr;
+		zbx_lock_stats_t	stats;
+
+		if (ZBX_MUTEX_COUNT > i)
+			addr = (zbx_uint64_t)zbx_mutex_addr_get((zbx_mutex_name_t)i);
+		else
+			addr = (zbx_uint64_t)zbx_rwlock_addr_get((zbx_rwlock_name_t)(i - ZBX_MUTEX_COUNT));
+
+		zbx_lock_name_get(i, name, sizeof(name));
+
 		zbx_json_addobject(json, NULL);
-		zbx_json_addhex(json, names[i], (zbx_uint64_t)zbx_mutex_addr_get(i));
+		zbx_json_addhex(json, name, addr);
+
+		if (SUCCEED == zbx_lock_get_stats(i, &stats))
+		{
+			zbx_json_adduint64(json, "locks", stats.locks);
+			zbx_json_adduint64(json, "contended", stats.contended);
+			zbx_json_addfloat(json, "wait", (double)stats.wait_ns / 1000000000.0);
+			zbx_json_addfloat(json, "wait_max", (double)stats.wait_max_ns / 1000000000.0);
+			zbx_json_addfloat(json, "hold", (double)stats.hold_ns / 1000000000.0);
+			zbx_json_addfloat(json, "hold_p99", zbx_lock_stats_hold_percentile(&stats, 99));
+		}
+
 		zbx_json_close(json);
 	}
 
-	zbx_json_addobject(json, NULL);
-	zbx_json_addhex(json, "ZBX_RWLOCK_CONFIG", (zbx_uint64_t)zbx_rwlock_addr_get(ZBX_RWLOCK_CONFIG));
 	zbx_json_close(json);
+}
 
-	zbx_json_addobject(json, NULL);
-	zbx_json_addhex(json, "ZBX_RWLOCK_CONFIG_HISTORY", (zbx_uint64_t)zbx_rwlock_addr_get(ZBX_RWLOCK_CONFIG_HISTORY));
-	zbx_json_close(json);
+/******************************************************************************
+ *                                                                            *
+ * Purpose: add latency probe statistics to json                              *
+ *                                                                            *
+ ******************************************************************************/
+static void	diag_add_probe_stats(struct zbx_json *json, const zbx_prof_probe_stats_t *stats)
+{
+	zbx_json_adduint64(json, "count", stats->count);
+	zbx_json_addfloat(json, "avg", 0 == stats->count ? 0.0 :
+			(double)stats->total_us / (double)stats->count / 1000000.0);
+	zbx_json_addfloat(json, "p50", zbx_prof_probe_percentile(stats, 50));
+	zbx_json_addfloat(json, "p90", zbx_prof_probe_percentile(stats, 90));
+	zbx_json_addfloat(json, "p99", zbx_prof_probe_percentile(stats, 99));
+}
 
-	zbx_json_addobject(json, NULL);
-	zbx_json_addhex(json, "ZBX_RWLOCK_VALUECACHE", (zbx_uint64_t)zbx_rwlock_addr_get(ZBX_RWLOCK_VALUECACHE));
-	zbx_json_close(json);
+/******************************************************************************
+ *                                                                            *
+ * Purpose: add latency probe statistics to json data                         *
+ *                                                                            *
+ * Parameters: json  - [IN/OUT] the json to update                            *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_diag_add_profiling_info(struct zbx_json *json)
+{
+	zbx_prof_probe_stats_t	stats;
+
+	zbx_json_addarray(json, ZBX_DIAG_PROFILING);
+
+	for (int i = 0; i < ZBX_PROF_PROBE_COUNT; i++)
+	{
+		if (SUCCEED != zbx_prof_probe_get_stats(i, &stats))
+			break;
+
+		zbx_json_addobject(json, NULL);
+		zbx_json_addstring(json, "probe", zbx_prof_probe_name(i), ZBX_JSON_TYPE_STRING);
+		diag_add_probe_stats(json, &stats);
+		zbx_json_close(json);
+	}
+
+	/* value latency is reported only for the item types that have values */
+	for (int i = 0; i < ZBX_PROF_VALUE_STAGE_COUNT; i++)
+	{
+		for (int type = 0; type < ZBX_PROF_ITEM_TYPES_NUM; type++)
+		{
+			if (SUCCEED != zbx_prof_value_latency_get_stats(i, type, &stats) || 0 == stats.count)
+				continue;
+
+			zbx_json_addobject(json, NULL);
+			zbx_json_addstring(json, "value_latency", zbx_prof_value_stage_name(i), ZBX_JSON_TYPE_STRING);
+			zbx_json_addint64(json, "item_type", type);
+			diag_add_probe_stats(json, &stats);
+			zbx_json_close(json);
+		}
+	}
 
 	zbx_json_close(json);
 }
@@ -676,7 +844,7 @@ static void	diag_prepare_default_request(struct zbx_json *j, unsigned int flags)
 		diag_add_section_request(j, ZBX_DIAG_PREPROCESSING, "sequences", NULL);
 
 	if (0 != (flags & (1 << ZBX_DIAGINFO_LLD)))
-		diag_add_section_request(j, ZBX_DIAG_LLD, "values", NULL);
+		diag_add_section_request(j, ZBX_DIAG_LLD, "values", "time", NULL);
 
 	if (0 != (flags & (1 << ZBX_DIAGINFO_ALERTING)))
 		diag_add_section_request(j, ZBX_DIAG_ALERTING, "media.alerts", "source.alerts", NULL);
@@ -686,6 +854,12 @@ static void	diag_prepare_default_request(struct zbx_json *j, unsigned int flags)
 
 	if (0 != (flags & (1 << ZBX_DIAGINFO_CONNECTOR)))
 		diag_add_section_request(j, ZBX_DIAG_CONNECTOR, "values", NULL);
+
+	if (0 != (flags & (1 << ZBX_DIAGINFO_DISCOVERY)))
+		diag_add_section_request(j, ZBX_DIAG_DISCOVERY, "rules", NULL);
+
+	if (0 != (flags & (1 << ZBX_DIAGINFO_PROFILING)))
+		diag_add_section_request(j, ZBX_DIAG_PROFILING, NULL);
 }
 
 /******************************************************************************
@@ -899,6 +1073,7 @@ static void	diag_log_lld(struct zbx_json_parse *jp, char **out, size_t *out_allo
 	zbx_free(msg);
 
 	diag_log_top_view(jp, "top.values", "$.top.values", out, out_alloc, out_offset);
+	diag_log_top_view(jp, "top.time", "$.top.time", out, out_alloc, out_offset);
 
 	zbx_strlog_alloc(LOG_LEVEL_INFORMATION, out, out_alloc, out_offset, "==");
 }
@@ -944,6 +1119,26 @@ static void	diag_log_connector(struct zbx_json_parse *jp, char **out, size_t *ou
 	zbx_strlog_alloc(LOG_LEVEL_INFORMATION, out, out_alloc, out_offset, "==");
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: log discovery diagnostic information                              *
+ *                                                                            *
+ ******************************************************************************/
+static void	diag_log_discovery(struct zbx_json_parse *jp, char **out, size_t *out_alloc, size_t *out_offset)
+{
+	char	*msg = NULL;
+
+	zbx_strlog_alloc(LOG_LEVEL_INFORMATION, out, out_alloc, out_offset, "== discovery diagnostic information ==");
+
+	diag_get_simple_values(jp, &msg);
+	zbx_strlog_alloc(LOG_LEVEL_INFORMATION, out, out_alloc, out_offset, "%s", msg);
+	zbx_free(msg);
+
+	diag_log_top_view(jp, "top.rules", "$.top.rules", out, out_alloc, out_offset);
+
+	zbx_strlog_alloc(LOG_LEVEL_INFORMATION, out, out_alloc, out_offset, "==");
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: log diagnostic information                                        *
@@ -1008,6 +1203,16 @@ void	zbx_diag_log_info(unsigned int flags, char **result)
 			}
 			else if (0 == strcmp(section, ZBX_DIAG_CONNECTOR))
 				diag_log_connector(&jp_section, result, &result_alloc, &result_offset);
+			else if (0 == strcmp(section, ZBX_DIAG_DISCOVERY))
+				diag_log_discovery(&jp_section, result, &result_alloc, &result_offset);
+			else if (0 == strcmp(section, ZBX_DIAG_PROFILING))
+			{
+				zbx_strlog_alloc(LOG_LEVEL_INFORMATION, result, &result_alloc, &result_offset,
+						"== profiling diagnostic information ==");
+				diag_log_top_view(&jp_section, ZBX_DIAG_PROFILING, NULL, result, &result_alloc,
+						&result_offset);
+				zbx_strlog_alloc(LOG_LEVEL_INFORMATION, result, &result_alloc, &result_offset, "==");
+			}
 		}
 	}
 	else
@@ -1131,3 +1336,92 @@ void	zbx_diag_init(zbx_diag_add_section_info_func_t cb)
 {
 	add_diag_cb = cb;
 }
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: add requested discovery diagnostic information to json data       *
+ *                                                                            *
+ * Parameters: jp    - [IN] the request                                       *
+ *             json  - [IN/OUT] the json to update                            *
+ *             error - [OUT] error message                                    *
+ *                                                                            *
+ * Return value: SUCCEED - the information was added successfully             *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_diag_add_discovery_info(const struct zbx_json_parse *jp, struct zbx_json *json, char **error)
+{
+	zbx_vector_ptr_t	tops, drule_stats;
+	int			ret, queued_num, overdue_num;
+	double			time1, time_total;
+	time_t			now;
+	zbx_uint64_t		fields;
+	zbx_diag_map_t		field_map[] = {
+					{(char *)"", ZBX_DIAG_DISCOVERY_VALUES},
+					{(char *)"values", ZBX_DIAG_DISCOVERY_VALUES},
+					{NULL, 0}
+					};
+
+	zbx_vector_ptr_create(&tops);
+	zbx_vector_ptr_create(&drule_stats);
+
+	if (SUCCEED == (ret = zbx_diag_parse_request(jp, field_map, &fields, &tops, error)))
+	{
+		int	i;
+
+		zbx_json_addobject(json, ZBX_DIAG_DISCOVERY);
+
+		now = time(NULL);
+		time1 = zbx_time();
+		zbx_dc_get_drule_stats(now, &drule_stats, &queued_num, &overdue_num);
+		time_total = zbx_time() - time1;
+
+		if (0 != (fields & ZBX_DIAG_DISCOVERY_SIMPLE))
+		{
+			zbx_json_addint64(json, "queued", queued_num);
+			zbx_json_addint64(json, "overdue", overdue_num);
+			zbx_json_addint64(json, "running", drule_stats.values_num);
+		}
+
+		if (0 != tops.values_num)
+		{
+			zbx_json_addobject(json, "top");
+
+			for (i = 0; i < tops.values_num; i++)
+			{
+				zbx_diag_map_t	*map = (zbx_diag_map_t *)tops.values[i];
+
+				if (0 == strcmp(map->name, "rules"))
+				{
+					zbx_vector_ptr_sort(&drule_stats, diag_compare_drule_stats_remaining);
+
+					while ((int)map->value < drule_stats.values_num)
+					{
+						zbx_free(drule_stats.values[drule_stats.values_num - 1]);
+						zbx_vector_ptr_remove(&drule_stats, drule_stats.values_num - 1);
+					}
+
+					diag_add_discovery_rules(json, map->name, &drule_stats, now);
+				}
+				else
+				{
+					*error = zbx_dsprintf(*error, "Unsupported top field: %s", map->name);
+					ret = FAIL;
+					goto out;
+				}
+			}
+
+			zbx_json_close(json);
+		}
+
+		zbx_json_addfloat(json, "time", time_total);
+		zbx_json_close(json);
+	}
+out:
+	zbx_vector_ptr_clear_ext(&drule_stats, zbx_ptr_free);
+	zbx_vector_ptr_destroy(&drule_stats);
+	zbx_vector_ptr_clear_ext(&tops, (zbx_ptr_free_func_t)zbx_diag_map_free);
+	zbx_vector_ptr_destroy(&tops);
+
+	return ret;
+}
@@ -36994,6 +36994,223 @@ DUK_LOCAL void duk__json_dec_buffer(duk_json_dec_ctx *js_ctx) {
 }
 #endif  /* DUK_USE_JX */
 
+/*
+ *  Zabbix patch begin: fast paths for JSON number conversion.
+ *
+ *  Local addition to the upstream amalgamation.  Everything except the two
+ *  call sites marked "Zabbix patch" in duk__json_dec_number() and
+ *  duk__json_enc_double() is in this block, so it can be reapplied when
+ *  Duktape is upgraded.  The JSON.parse() and JSON.stringify() results are
+ *  pinned by JavaScript preprocessing tests in tests/libs/zbxpreproc.
+ */
+
+/* Exact conversion of short decimal numbers, which are the common case
+ * in JSON data, without interning the number text and going through the big
+ * integer based generic number parser.  A mantissa of at most 15 digits and a
+ * power of ten up to 1e22 are exact doubles, so the single multiplication or
+ * division is correctly rounded (Clinger's fast path).  Anything else,
+ * including invalid input, is left to the generic parser.
+ */
+DUK_LOCAL const duk_double_t duk__json_dec_pow10[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+DUK_LOCAL duk_bool_t duk__json_dec_number_fast(const duk_uint8_t *p, const duk_uint8_t *p_end, duk_double_t *out) {
+	duk_double_t m = 0.0;
+	duk_small_int_t digits = 0;
+	duk_int_t e10 = 0;
+	duk_int_t exp = 0;
+	duk_bool_t neg = 0;
+	duk_bool_t exp_neg = 0;
+
+	if (p < p_end && *p == DUK_ASC_MINUS) {
+		neg = 1;
+		p++;
+	}
+
+	if (p >= p_end) {
+		return 0;
+	}
+
+	if (*p == DUK_ASC_0) {
+		p++;
+		if (p < p_end && *p >= DUK_ASC_0 && *p <= DUK_ASC_9) {
+			return 0;  /* leading zero */
+		}
+	} else if (*p >= DUK_ASC_1 && *p <= DUK_ASC_9) {
+		while (p < p_end && *p >= DUK_ASC_0 && *p <= DUK_ASC_9) {
+			if (++digits > 15) {
+				return 0;
+			}
+			m = m * 10.0 + (duk_double_t) (*p++ - DUK_ASC_0);
+		}
+	} else {
+		return 0;
+	}
+
+	if (p < p_end && *p == DUK_ASC_PERIOD) {
+		p++;
+		if (p >= p_end || *p < DUK_ASC_0 || *p > DUK_ASC_9) {
+			return 0;
+		}
+		while (p < p_end && *p >= DUK_ASC_0 && *p <= DUK_ASC_9) {
+			/* leading zeroes of fraction are not significant */
+			if ((m != 0.0 || *p != DUK_ASC_0) && ++digits > 15) {
+				return 0;
+			}
+			m = m * 10.0 + (duk_double_t) (*p++ - DUK_ASC_0);
+			e10--;
+		}
+	}
+
+	if (p < p_end && (*p == DUK_ASC_LC_E || *p == DUK_ASC_UC_E)) {
+		p++;
+		if (p < p_end && (*p == DUK_ASC_PLUS || *p == DUK_ASC_MINUS)) {
+			exp_neg = (*p++ == DUK_ASC_MINUS);
+		}
+		if (p >= p_end || *p < DUK_ASC_0 || *p > DUK_ASC_9) {
+			return 0;
+		}
+		while (p < p_end && *p >= DUK_ASC_0 && *p <= DUK_ASC_9) {
+			if ((exp = exp * 10 + (*p++ - DUK_ASC_0)) > 1000) {
+				return 0;
+			}
+		}
+		e10 += exp_neg ? -exp : exp;
+	}
+
+	if (p != p_end) {
+		return 0;
+	}
+
+	if (m != 0.0) {
+		if (e10 > 22 || e10 < -22) {
+			return 0;
+		}
+		if (e10 > 0) {
+			m *= duk__json_dec_pow10[e10];
+		} else if (e10 < 0) {
+			m /= duk__json_dec_pow10[-e10];
+		}
+	}
+
+	*out = neg ? -m : m;
+	return 1;
+}
+
+/* Format a finite double like Number.prototype.toString() does, using
+ * the C library instead of the slow big integer based generic conversion.  The
+ * shortest round-trip digit string is found by trying 15, 16 and 17 significant
+ * digits: if fewer than 15 digits are enough for a normal double, the correctly
+ * rounded 15 digit string is that shorter string padded with zeroes.  Returns 0
+ * if the value must be formatted by the generic conversion.
+ */
+DUK_LOCAL duk_bool_t duk__json_enc_double_fast(duk_double_t d, char *out, duk_size_t out_size) {
+	char buf[32];
+	char digits[20];
+	const char *p;
+	char *q;
+	duk_small_int_t prec;
+	duk_small_int_t k = 0;
+	duk_small_int_t n;
+	duk_small_int_t i;
+
+	if (out_size < 32) {
+		return 0;
+	}
+
+	if (d == DUK_FLOOR(d) && d >= -9007199254740991.0 && d <= 9007199254740991.0) {
+		DUK_SNPRINTF(out, out_size, "%.0f", (double) (d == 0.0 ? 0.0 : d));
+		return 1;
+	}
+
+	/* subnormals have less precision, so fewer digits than 15 can be enough */
+	if (d > -2.2250738585072014e-308 && d < 2.2250738585072014e-308) {
+		return 0;
+	}
+
+	for (prec = 15; prec <= 17; prec++) {
+		DUK_SNPRINTF(buf, sizeof(buf), "%.*e", (int) (prec - 1), (double) d);
+		if (strtod(buf, NULL) == d) {
+			break;
+		}
+	}
+	if (prec > 17) {
+		return 0;
+	}
+
+	/* with 16 or 17 digits two candidates can be equally close, the C library
+	 * and the generic conversion resolve such ties differently
+	 */
+	if (prec > 15) {
+		char tie[32];
+
+		DUK_SNPRINTF(tie, sizeof(tie), "%.*e", (int) prec, (double) d);
+		if (strchr(tie, DUK_ASC_LC_E)[-1] == DUK_ASC_5) {
+			return 0;
+		}
+	}
+
+	q = out;
+	p = buf;
+	if (*p == DUK_ASC_MINUS) {
+		*q++ = *p++;
+	}
+
+	for (; *p != DUK_ASC_LC_E; p++) {
+		if (*p == DUK_ASC_PERIOD) {
+			continue;
+		}
+		if (*p < DUK_ASC_0 || *p > DUK_ASC_9 || k >= (duk_small_int_t) sizeof(digits)) {
+			return 0;
+		}
+		digits[k++] = *p;
+	}
+	while (k > 1 && digits[k - 1] == DUK_ASC_0) {
+		k--;
+	}
+	n = (duk_small_int_t) atoi(p + 1) + 1;
+
+	if (k <= n && n <= 21) {
+		for (i = 0; i < n; i++) {
+			*q++ = i < k ? digits[i] : DUK_ASC_0;
+		}
+	} else if (0 < n && n <= 21) {
+		for (i = 0; i < k; i++) {
+			if (i == n) {
+				*q++ = DUK_ASC_PERIOD;
+			}
+			*q++ = digits[i];
+		}
+	} else if (-6 < n && n <= 0) {
+		*q++ = DUK_ASC_0;
+		*q++ = DUK_ASC_PERIOD;
+		for (i = n; i < 0; i++) {
+			*q++ = DUK_ASC_0;
+		}
+		for (i = 0; i < k; i++) {
+			*q++ = digits[i];
+		}
+	} else {
+		*q++ = digits[0];
+		if (k > 1) {
+			*q++ = DUK_ASC_PERIOD;
+			for (i = 1; i < k; i++) {
+				*q++ = digits[i];
+			}
+		}
+		DUK_SNPRINTF(q, out_size - (duk_size_t) (q - out), "e%c%d", n - 1 < 0 ? '-' : '+',
+		             (int) (n - 1 < 0 ? 1 - n : n - 1));
+		return 1;
+	}
+
+	*q = 0;
+	return 1;
+}
+
+/* Zabbix patch end */
+
 /* Parse a number, other than NaN or +/- Infinity */
 DUK_LOCAL void duk__json_dec_number(duk_json_dec_ctx *js_ctx) {
 	duk_hthread *thr = js_ctx->thr;
@@ -37041,6 +37258,17 @@ DUK_LOCAL void duk__json_dec_number(duk_json_dec_ctx *js_ctx) {
 	js_ctx->p = p;
 
 	DUK_ASSERT(js_ctx->p > p_start);
+
+	/* Zabbix patch: fast path for short decimal numbers, see duk__json_dec_number_fast() */
+	{
+		duk_double_t d;
+
+		if (duk__json_dec_number_fast(p_start, p, &d)) {
+			duk_push_number(thr, d);
+			return;
+		}
+	}
+
 	duk_push_lstring(thr, (const char *) p_start, (duk_size_t) (p - p_start));
 
 	s2n_flags = DUK_S2N_FLAG_ALLOW_EXP |
@@ -37729,6 +37957,14 @@ DUK_LOCAL void duk__json_enc_double(duk_json_enc_ctx *js_ctx) {
 		} else
 #endif  /* DUK_USE_JX || DUK_USE_JC */
 		{
+			/* Zabbix patch: fast path for common numbers, see duk__json_enc_double_fast() */
+			char buf[32];
+
+			if (duk__json_enc_double_fast(d, buf, sizeof(buf))) {
+				DUK__EMIT_CSTR(js_ctx, buf);
+				return;
+			}
+
 			n2s_flags = 0;
 			/* [ ... number ] -> [ ... string ] */
 			duk_numconv_stringify(thr, 10 /*radix*/, 0 /*digits*/, n2s_flags);
@@ -72,6 +72,43 @@ zbx_es_httprequest_t;
 	}													\
 	while(0)
 
+/* share handle for DNS cache, TLS sessions and connection cache of all HttpRequest objects in the process */
+static CURLSH	*es_curl_share = NULL;
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get cURL share handle, creating it on first use                   *
+ *                                                                            *
+ * Return value: the share handle or NULL if it cannot be created             *
+ *                                                                            *
+ * Comments: Sharing connections allows HttpRequest objects of the following  *
+ *           script runs to reuse keep-alive connections and TLS sessions to  *
+ *           the same endpoints. Cookies are not shared. Scripts run in       *
+ *           single threaded processes, so no share locking is set.           *
+ *                                                                            *
+ ******************************************************************************/
+static CURLSH	*es_httprequest_share(void)
+{
+	if (NULL != es_curl_share)
+		return es_curl_share;
+
+	if (NULL == (es_curl_share = curl_share_init()))
+		return NULL;
+
+	if (CURLSHE_OK != curl_share_setopt(es_curl_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS) ||
+			CURLSHE_OK != curl_share_setopt(es_curl_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION))
+	{
+		curl_share_cleanup(es_curl_share);
+		es_curl_share = NULL;
+		return NULL;
+	}
+#if LIBCURL_VERSION_NUM >= 0x073900
+	/* connection cache sharing is supported starting with version 7.57.0 (0x073900) */
+	curl_share_setopt(es_curl_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+#endif
+	return es_curl_share;
+}
+
 static size_t	curl_write_cb(void *ptr, size_t size, size_t nmemb, void *userdata)
 {
 	size_t			r_size = size * nmemb;
@@ -188,6 +225,9 @@ static duk_ret_t	es_httprequest_ctor(duk_context *ctx)
 	ZBX_CURL_SETOPT(ctx, request->handle, CURLOPT_HEADERDATA, request, err);
 	ZBX_CURL_SETOPT(ctx, request->handle, CURLOPT_INTERFACE, CONFIG_SOURCE_IP, err);
 
+	if (NULL != es_httprequest_share())
+		ZBX_CURL_SETOPT(ctx, request->handle, CURLOPT_SHARE, es_curl_share, err);
+
 	duk_push_pointer(ctx, request);
 	duk_put_prop_string(ctx, -2, "\xff""\xff""d");
 
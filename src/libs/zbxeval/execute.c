@@ -196,6 +196,41 @@ static int	eval_execute_op_logic_err(const zbx_eval_token_t *token, const zbx_va
 	return FAIL;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compare two numeric (floating point or unsigned integer) values   *
+ *                                                                            *
+ * Return value: <0 - the first value is less than the second                 *
+ *               >0 - the first value is greater than the second              *
+ *               0  - the values are equal                                    *
+ *                                                                            *
+ * Comments: This is a fast path of zbx_variant_compare() for numeric values  *
+ *           produced by functions and operators, returning the same results. *
+ *                                                                            *
+ ******************************************************************************/
+static int	eval_numeric_compare(const zbx_variant_t *left, const zbx_variant_t *right)
+{
+	double	left_dbl, right_dbl;
+
+	if (ZBX_VARIANT_UI64 == left->type && ZBX_VARIANT_UI64 == right->type)
+	{
+		ZBX_RETURN_IF_NOT_EQUAL(left->data.ui64, right->data.ui64);
+		return 0;
+	}
+
+	left_dbl = (ZBX_VARIANT_UI64 == left->type ? (double)left->data.ui64 : left->data.dbl);
+	right_dbl = (ZBX_VARIANT_UI64 == right->type ? (double)right->data.ui64 : right->data.dbl);
+
+	if (SUCCEED == zbx_double_compare(left_dbl, right_dbl))
+		return 0;
+
+	ZBX_RETURN_IF_NOT_EQUAL(left_dbl, right_dbl);
+
+	return 0;
+}
+
+#define EVAL_VARIANT_IS_NUMERIC(value)	(ZBX_VARIANT_DBL == (value)->type || ZBX_VARIANT_UI64 == (value)->type)
+
 /******************************************************************************
  *                                                                            *
  * Purpose: compare two variant values supporting suffixed numbers            *
@@ -210,6 +245,9 @@ static int	eval_variant_compare(const zbx_variant_t *left, const zbx_variant_t *
 	zbx_variant_t	val_l, val_r;
 	int		ret;
 
+	if (EVAL_VARIANT_IS_NUMERIC(left) && EVAL_VARIANT_IS_NUMERIC(right))
+		return eval_numeric_compare(left, right);
+
 	zbx_variant_set_none(&val_l);
 	zbx_variant_set_none(&val_r);
 
@@ -353,16 +391,16 @@ static int	eval_execute_op_binary(const zbx_eval_context_t *ctx, const zbx_eval_
 	switch (token->type)
 	{
 		case ZBX_EVAL_TOKEN_OP_LT:
-			value = (0 > zbx_variant_compare(left, right) ? 1 : 0);
+			value = (0 > eval_numeric_compare(left, right) ? 1 : 0);
 			break;
 		case ZBX_EVAL_TOKEN_OP_LE:
-			value = (0 >= zbx_variant_compare(left, right) ? 1 : 0);
+			value = (0 >= eval_numeric_compare(left, right) ? 1 : 0);
 			break;
 		case ZBX_EVAL_TOKEN_OP_GT:
-			value = (0 < zbx_variant_compare(left, right) ? 1 : 0);
+			value = (0 < eval_numeric_compare(left, right) ? 1 : 0);
 			break;
 		case ZBX_EVAL_TOKEN_OP_GE:
-			value = (0 <= zbx_variant_compare(left, right) ? 1 : 0);
+			value = (0 <= eval_numeric_compare(left, right) ? 1 : 0);
 			break;
 		case ZBX_EVAL_TOKEN_OP_ADD:
 			value = left->data.dbl + right->data.dbl;
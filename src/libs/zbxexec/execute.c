@@ -113,6 +113,78 @@ static int	zbx_read_from_pipe(HANDLE hRead, char **buf, size_t *buf_size, size_t
 
 #else	/* not _WINDOWS */
 
+#if defined(HAVE_POSIX_SPAWN)
+#include <spawn.h>
+
+extern char	**environ;
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: starts shell with the command, redirecting its output to pipe     *
+ *                                                                            *
+ * Parameters: pid     - [OUT] child process PID                              *
+ *             command - [IN] a pointer to a null-terminated string           *
+ *                       containing a shell command line                      *
+ *             fd      - [IN] the pipe file descriptors, the write end is     *
+ *                       closed by this function                              *
+ *                                                                            *
+ * Return value: on success, reading file descriptor is returned. On error,   *
+ *               -1 is returned, and errno is set appropriately               *
+ *                                                                            *
+ * Comments: Unlike fork() posix_spawn() does not copy page tables of the     *
+ *           calling process, which is expensive for server processes with    *
+ *           large shared memory mappings.                                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	zbx_popen_spawn(pid_t *pid, const char *command, int fd[2])
+{
+	posix_spawn_file_actions_t	actions;
+	posix_spawnattr_t		attr;
+	char				*argv[] = {"sh", "-c", (char *)command, NULL};
+	int				err;
+
+	if (0 != (err = posix_spawn_file_actions_init(&actions)))
+		goto out;
+
+	if (0 != (err = posix_spawnattr_init(&attr)))
+	{
+		posix_spawn_file_actions_destroy(&actions);
+		goto out;
+	}
+
+	/* set the child as the process group leader, otherwise orphans may be left after timeout */
+	if (0 == (err = posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP)) &&
+			0 == (err = posix_spawnattr_setpgroup(&attr, 0)) &&
+			0 == (err = posix_spawn_file_actions_addclose(&actions, fd[0])) &&
+			0 == (err = posix_spawn_file_actions_adddup2(&actions, fd[1], STDOUT_FILENO)) &&
+			0 == (err = posix_spawn_file_actions_adddup2(&actions, fd[1], STDERR_FILENO)) &&
+			0 == (err = posix_spawn_file_actions_addclose(&actions, fd[1])))
+	{
+		fflush(stdout);
+		fflush(stderr);
+
+		err = posix_spawn(pid, "/bin/sh", &actions, &attr, argv, environ);
+	}
+
+	posix_spawnattr_destroy(&attr);
+	posix_spawn_file_actions_destroy(&actions);
+out:
+	close(fd[1]);
+
+	if (0 != err)
+	{
+		close(fd[0]);
+		errno = err;
+
+		return -1;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%d", __func__, fd[0]);
+
+	return fd[0];
+}
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Purpose: this function opens a process by creating a pipe, forking,        *
@@ -147,6 +219,12 @@ static int	zbx_popen(pid_t *pid, const char *command, const char *dir)
 	if (-1 == pipe(fd))
 		return -1;
 
+#if defined(HAVE_POSIX_SPAWN)
+	/* changing directory of spawned process is not portable, fork is used for commands with directory */
+	if (NULL == dir)
+		return zbx_popen_spawn(pid, command, fd);
+#endif
+
 	if (-1 == (*pid = zbx_fork()))
 	{
 		close(fd[0]);
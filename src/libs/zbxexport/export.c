@@ -203,19 +203,49 @@ void	zbx_deinit_library_export(void)
 	get_problems_file = NULL;
 }
 
+#define ZBX_EXPORT_BUFFER_SIZE	ZBX_MEBIBYTE
+
 static int	open_export_file(zbx_export_file_t *file, char **error)
 {
-	if (NULL == (file->file = fopen(file->name, "a")))
+	zbx_stat_t	fs;
+
+	if (-1 == (file->fd = open(file->name, O_WRONLY | O_APPEND | O_CREAT, 0666)))
 	{
 		*error = zbx_dsprintf(*error, "cannot open export file '%s': %s", file->name, zbx_strerror(errno));
 		return FAIL;
 	}
 
+	if (0 != zbx_fstat(file->fd, &fs))
+	{
+		*error = zbx_dsprintf(*error, "cannot get size of export file '%s': %s",
+				file->name, zbx_strerror(errno));
+		close(file->fd);
+		file->fd = -1;
+		return FAIL;
+	}
+
+	file->size = (zbx_uint64_t)fs.st_size;
+
 	zabbix_log(LOG_LEVEL_DEBUG, "successfully created export file '%s'", file->name);
 
 	return SUCCEED;
 }
 
+static int	close_export_file(zbx_export_file_t *file, char **error)
+{
+	int	ret = SUCCEED;
+
+	if (-1 != file->fd && 0 != close(file->fd))
+	{
+		*error = zbx_dsprintf(*error, "cannot close export file '%s': %s", file->name, zbx_strerror(errno));
+		ret = FAIL;
+	}
+
+	file->fd = -1;
+
+	return ret;
+}
+
 static zbx_export_file_t	*export_init(const char *process_type, const char *process_name, int process_num)
 {
 	char			*export_dir, *error = NULL;
@@ -243,6 +273,9 @@ static zbx_export_file_t	*export_init(const char *process_type, const char *proc
 	}
 
 	file->missing = 0;
+	file->buffer_alloc = ZBX_EXPORT_BUFFER_SIZE;
+	file->buffer = (char *)zbx_malloc(NULL, file->buffer_alloc);
+	file->buffer_offset = 0;
 
 	return file;
 }
@@ -271,41 +304,65 @@ zbx_export_file_t	*zbx_problems_export_init(zbx_get_export_file_f get_export_fil
 	return export_init("problems", process_name, process_num);
 }
 
-void	zbx_export_deinit(zbx_export_file_t *file)
-{
-	zbx_fclose(file->file);
-	zbx_free(file->name);
-	zbx_free(file);
-}
-
-static void	export_write(const char *buf, size_t count, zbx_export_file_t *file)
+static void	export_log_error(zbx_export_file_t *file, char *error_msg)
 {
 #define ZBX_LOGGING_SUSPEND_TIME	10
 
 	static time_t	last_log_time = 0;
 	time_t		now;
-	char		*error_msg = NULL;
-	long		file_offset;
 
-	if (NULL == config_export)
+	if (FAIL == close_export_file(file, &error_msg))
+		zabbix_log(LOG_LEVEL_DEBUG, "%s", error_msg);
+
+	/* buffered records are lost the same way as they would be with a failed write */
+	file->buffer_offset = 0;
+	now = time(NULL);
+
+	if (ZBX_LOGGING_SUSPEND_TIME < now - last_log_time)
 	{
-		zabbix_log(LOG_LEVEL_CRIT, "export library is not initialized");
-		exit(EXIT_FAILURE);
+		zabbix_log(LOG_LEVEL_ERR, "%s", error_msg);
+		last_log_time = now;
 	}
 
+	zbx_free(error_msg);
+
+#undef ZBX_LOGGING_SUSPEND_TIME
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: writes buffered records to export file                            *
+ *                                                                            *
+ * Parameters: file  - [IN] the export file                                   *
+ *             error - [OUT] the error message                                *
+ *                                                                            *
+ * Return value: SUCCEED - the buffered records were written                  *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: The export file is reopened if it was removed by external tools. *
+ *           Records of the whole batch are written with single system call   *
+ *           in most cases.                                                   *
+ *                                                                            *
+ ******************************************************************************/
+static int	export_write_buffer(zbx_export_file_t *file, char **error)
+{
+	size_t	offset = 0;
+
 	if (0 == file->missing && 0 != access(file->name, F_OK))
 	{
-		if (NULL != file->file && 0 != fclose(file->file))
-			zabbix_log(LOG_LEVEL_DEBUG, "cannot close export file '%s': %s",file->name,
-					zbx_strerror(errno));
+		char	*error_close = NULL;
 
-		file->file = NULL;
+		if (FAIL == close_export_file(file, &error_close))
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "%s", error_close);
+			zbx_free(error_close);
+		}
 	}
 
-	if (NULL == file->file && FAIL == open_export_file(file, &error_msg))
+	if (-1 == file->fd && FAIL == open_export_file(file, error))
 	{
 		file->missing = 1;
-		goto error;
+		return FAIL;
 	}
 
 	if (1 == file->missing)
@@ -314,74 +371,116 @@ static void	export_write(const char *buf, size_t count, zbx_export_file_t *file)
 		zabbix_log(LOG_LEVEL_ERR, "regained access to export file '%s'", file->name);
 	}
 
-	if (-1 == (file_offset = ftell(file->file)))
+	while (offset < file->buffer_offset)
 	{
-		error_msg = zbx_dsprintf(error_msg, "cannot get current position in export file '%s': %s",
-				file->name, zbx_strerror(errno));
-		goto error;
-	}
-
-	if (config_export->file_size <= count + (size_t)file_offset + 1)
-	{
-		char	filename_old[MAX_STRING_LEN];
-
-		zbx_strscpy(filename_old, file->name);
-		zbx_strlcat(filename_old, ".old", MAX_STRING_LEN);
-
-		if (0 == access(filename_old, F_OK) && 0 != remove(filename_old))
-		{
-			error_msg = zbx_dsprintf(error_msg, "cannot remove export file '%s': %s",
-					filename_old, zbx_strerror(errno));
-			goto error;
-		}
+		ssize_t	n;
 
-		if (0 != fclose(file->file))
+		if (-1 == (n = write(file->fd, file->buffer + offset, file->buffer_offset - offset)))
 		{
-			error_msg = zbx_dsprintf(error_msg, "cannot close export file %s': %s",
-					file->name, zbx_strerror(errno));
-			file->file = NULL;
-			goto error;
-		}
-		file->file = NULL;
+			if (EINTR == errno)
+				continue;
 
-		if (0 != rename(file->name, filename_old))
-		{
-			error_msg = zbx_dsprintf(error_msg, "cannot rename export file '%s': %s",
-					file->name, zbx_strerror(errno));
-			goto error;
+			*error = zbx_dsprintf(*error, "cannot write to export file '%s': %s", file->name,
+					zbx_strerror(errno));
+			return FAIL;
 		}
 
-		if (FAIL == open_export_file(file, &error_msg))
-			goto error;
+		offset += (size_t)n;
 	}
 
-	if (count != fwrite(buf, 1, count, file->file) || '\n' != fputc('\n', file->file))
+	file->size += file->buffer_offset;
+	file->buffer_offset = 0;
+
+	return SUCCEED;
+}
+
+static int	export_rotate(zbx_export_file_t *file, char **error)
+{
+	char	filename_old[MAX_STRING_LEN];
+
+	zbx_strscpy(filename_old, file->name);
+	zbx_strlcat(filename_old, ".old", MAX_STRING_LEN);
+
+	if (0 == access(filename_old, F_OK) && 0 != remove(filename_old))
 	{
-		error_msg = zbx_dsprintf(error_msg, "cannot write to export file '%s': %s", file->name,
+		*error = zbx_dsprintf(*error, "cannot remove export file '%s': %s", filename_old,
 				zbx_strerror(errno));
-		goto error;
+		return FAIL;
 	}
 
-	return;
-error:
-	if (NULL != file->file && 0 != fclose(file->file))
+	if (FAIL == close_export_file(file, error))
+		return FAIL;
+
+	if (0 != rename(file->name, filename_old))
 	{
-		error_msg = zbx_dsprintf(error_msg, "%s; cannot close export file %s': %s",
-				error_msg, file->name, zbx_strerror(errno));
+		*error = zbx_dsprintf(*error, "cannot rename export file '%s': %s", file->name, zbx_strerror(errno));
+		return FAIL;
 	}
 
-	file->file = NULL;
-	now = time(NULL);
+	return open_export_file(file, error);
+}
 
-	if (ZBX_LOGGING_SUSPEND_TIME < now - last_log_time)
+void	zbx_export_deinit(zbx_export_file_t *file)
+{
+	char	*error = NULL;
+
+	if (0 != file->buffer_offset && FAIL == export_write_buffer(file, &error))
+		export_log_error(file, error);
+
+	if (-1 != file->fd)
+		close(file->fd);
+
+	zbx_free(file->buffer);
+	zbx_free(file->name);
+	zbx_free(file);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds record to export file buffer                                 *
+ *                                                                            *
+ * Parameters: buf   - [IN] the record                                        *
+ *             count - [IN] the record length                                 *
+ *             file  - [IN] the export file                                   *
+ *                                                                            *
+ * Comments: Records are written to export file when the buffer is full,      *
+ *           before the file is rotated and on export flush.                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	export_write(const char *buf, size_t count, zbx_export_file_t *file)
+{
+	char	*error_msg = NULL;
+
+	if (NULL == config_export)
 	{
-		zabbix_log(LOG_LEVEL_ERR, "%s", error_msg);
-		last_log_time = now;
+		zabbix_log(LOG_LEVEL_CRIT, "export library is not initialized");
+		exit(EXIT_FAILURE);
 	}
 
-	zbx_free(error_msg);
+	if (config_export->file_size <= file->size + file->buffer_offset + count + 1)
+	{
+		if (FAIL == export_write_buffer(file, &error_msg) || FAIL == export_rotate(file, &error_msg))
+			goto error;
+	}
+	else if (file->buffer_alloc < file->buffer_offset + count + 1)
+	{
+		if (FAIL == export_write_buffer(file, &error_msg))
+			goto error;
+	}
 
-#undef ZBX_LOGGING_SUSPEND_TIME
+	if (file->buffer_alloc < count + 1)
+	{
+		file->buffer_alloc = count + 1;
+		file->buffer = (char *)zbx_realloc(file->buffer, file->buffer_alloc);
+	}
+
+	memcpy(file->buffer + file->buffer_offset, buf, count);
+	file->buffer_offset += count;
+	file->buffer[file->buffer_offset++] = '\n';
+
+	return;
+error:
+	export_log_error(file, error_msg);
 }
 
 void	zbx_problems_export_write(const char *buf, size_t count)
@@ -401,8 +500,10 @@ void	zbx_trends_export_write(const char *buf, size_t count)
 
 static void	export_flush(zbx_export_file_t *file)
 {
-	if (NULL != file && NULL != file->file && 0 != fflush(file->file))
-		zabbix_log(LOG_LEVEL_ERR, "cannot flush export file '%s': %s", file->name, zbx_strerror(errno));
+	char	*error = NULL;
+
+	if (NULL != file && 0 != file->buffer_offset && FAIL == export_write_buffer(file, &error))
+		export_log_error(file, error);
 }
 
 void	zbx_problems_export_flush(void)
@@ -69,10 +69,22 @@ typedef struct zbx_flexible_interval
 }
 zbx_flexible_interval_t;
 
+/* part of week with the same applicable flexible intervals */
+typedef struct
+{
+	int	start;	/* number of seconds from the beginning of week (Monday 00:00) when segment starts */
+	int	delay;	/* minimum delay of flexible intervals active during segment, -1 if none are active */
+}
+zbx_flexible_segment_t;
+
 struct zbx_custom_interval
 {
 	zbx_flexible_interval_t		*flexible;
 	zbx_scheduler_interval_t	*scheduling;
+
+	/* flexible intervals precomputed as weekly schedule, sorted by segment start */
+	zbx_flexible_segment_t		*segments;
+	int				segments_num;
 };
 
 /******************************************************************************
@@ -96,90 +108,182 @@ static int	check_time_period(const zbx_time_period_t period, struct tm *tm)
 			SUCCEED : FAIL;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: find flexible schedule segment for the specified time             *
+ *                                                                            *
+ * Parameters: custom_intervals - [IN] preprocessed custom intervals          *
+ *             now              - [IN] time to look up                        *
+ *             week_time        - [OUT] number of seconds since the beginning *
+ *                                      of week                               *
+ *                                                                            *
+ * Return value: index of the segment containing the specified time           *
+ *                                                                            *
+ * Comments: The last segment wraps around the end of week and covers also    *
+ *           the time before the first segment start.                         *
+ *                                                                            *
+ ******************************************************************************/
+static int	flexible_schedule_find(const zbx_custom_interval_t *custom_intervals, time_t now, int *week_time)
+{
+	const struct tm	*tm;
+	int		day, lo = 0, hi = custom_intervals->segments_num - 1;
+
+	tm = localtime(&now);
+	day = 0 == tm->tm_wday ? 7 : tm->tm_wday;
+	*week_time = SEC_PER_DAY * (day - 1) + SEC_PER_HOUR * tm->tm_hour + SEC_PER_MIN * tm->tm_min + tm->tm_sec;
+
+	if (*week_time < custom_intervals->segments[0].start)
+		return hi;
+
+	while (lo < hi)
+	{
+		int	mid = (lo + hi + 1) / 2;
+
+		if (custom_intervals->segments[mid].start <= *week_time)
+			lo = mid;
+		else
+			hi = mid - 1;
+	}
+
+	return lo;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: return delay value that is currently applicable                   *
  *                                                                            *
- * Parameters: default_delay  - [IN] default delay value, can be overridden   *
- *             flex_intervals - [IN] preprocessed flexible intervals          *
- *             now            - [IN] current time                             *
+ * Parameters: default_delay    - [IN] default delay value, can be overridden *
+ *             custom_intervals - [IN] preprocessed custom intervals          *
+ *             now              - [IN] current time                           *
  *                                                                            *
  * Return value: delay value - either default or minimum delay value          *
  *                             out of all applicable intervals                *
  *                                                                            *
  ******************************************************************************/
-static int	get_current_delay(int default_delay, const zbx_flexible_interval_t *flex_intervals, time_t now)
+static int	get_current_delay(int default_delay, const zbx_custom_interval_t *custom_intervals, time_t now)
 {
-	int		current_delay = -1;
+	int	week_time, delay;
 
-	while (NULL != flex_intervals)
-	{
-		if ((-1 == current_delay || flex_intervals->delay < current_delay) &&
-				SUCCEED == check_time_period(flex_intervals->period, localtime(&now)))
-		{
-			current_delay = flex_intervals->delay;
-		}
+	if (0 == custom_intervals->segments_num)
+		return default_delay;
 
-		flex_intervals = flex_intervals->next;
-	}
+	delay = custom_intervals->segments[flexible_schedule_find(custom_intervals, now, &week_time)].delay;
 
-	return -1 == current_delay ? default_delay : current_delay;
+	return -1 == delay ? default_delay : delay;
 }
 
 /******************************************************************************
  *                                                                            *
  * Purpose: return time when next delay settings take effect                  *
  *                                                                            *
- * Parameters: flex_intervals - [IN] preprocessed flexible intervals          *
- *             now            - [IN] current time                             *
- *             next_interval  - [OUT] start of next delay interval            *
+ * Parameters: custom_intervals - [IN] preprocessed custom intervals          *
+ *             now              - [IN] current time                           *
+ *             next_interval    - [OUT] start of next delay interval          *
  *                                                                            *
  * Return value: SUCCEED - there is a next interval                           *
  *               FAIL - otherwise (in this case, next_interval is unaffected) *
  *                                                                            *
  ******************************************************************************/
-static int	get_next_delay_interval(const zbx_flexible_interval_t *flex_intervals, time_t now, time_t *next_interval)
+static int	get_next_delay_interval(const zbx_custom_interval_t *custom_intervals, time_t now,
+		time_t *next_interval)
 {
-	int		day, time, next = 0, candidate;
-	struct tm	*tm;
+	int	index, week_time, next;
 
-	if (NULL == flex_intervals)
+	if (0 == custom_intervals->segments_num)
 		return FAIL;
 
-	tm = localtime(&now);
-	day = 0 == tm->tm_wday ? 7 : tm->tm_wday;
-	time = SEC_PER_HOUR * tm->tm_hour + SEC_PER_MIN * tm->tm_min + tm->tm_sec;
+	index = flexible_schedule_find(custom_intervals, now, &week_time);
+
+	if (index + 1 < custom_intervals->segments_num)
+		next = custom_intervals->segments[index + 1].start;
+	else
+		next = custom_intervals->segments[0].start;
 
-	for (; NULL != flex_intervals; flex_intervals = flex_intervals->next)
+	if (next <= week_time)
+		next += SEC_PER_WEEK;
+
+	*next_interval = now - week_time + next;
+	return SUCCEED;
+}
+
+static int	flexible_segment_compare(const void *d1, const void *d2)
+{
+	const zbx_flexible_segment_t	*s1 = (const zbx_flexible_segment_t *)d1;
+	const zbx_flexible_segment_t	*s2 = (const zbx_flexible_segment_t *)d2;
+
+	return s1->start - s2->start;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: precompute weekly schedule of flexible intervals                  *
+ *                                                                            *
+ * Parameters: custom_intervals - [IN/OUT] preprocessed custom intervals      *
+ *                                                                            *
+ * Comments: Every day of a flexible interval period starts and ends a        *
+ *           segment. The delay of each segment is the minimum delay of the   *
+ *           flexible intervals active during it, so the applicable delay and *
+ *           the next change of it can be looked up instead of checking all   *
+ *           flexible intervals on every nextcheck calculation.               *
+ *                                                                            *
+ ******************************************************************************/
+static void	flexible_schedule_build(zbx_custom_interval_t *custom_intervals)
+{
+	const zbx_flexible_interval_t	*flex;
+	int				i, num = 0, segments_alloc = 0;
+
+	custom_intervals->segments = NULL;
+	custom_intervals->segments_num = 0;
+
+	for (flex = custom_intervals->flexible; NULL != flex; flex = flex->next)
+		segments_alloc += (flex->period.end_day - flex->period.start_day + 1) * 2;
+
+	if (0 == segments_alloc)
+		return;
+
+	custom_intervals->segments = (zbx_flexible_segment_t *)zbx_malloc(NULL,
+			sizeof(zbx_flexible_segment_t) * (size_t)segments_alloc);
+
+	for (flex = custom_intervals->flexible; NULL != flex; flex = flex->next)
 	{
-		const zbx_time_period_t	*p = &flex_intervals->period;
+		int	day;
 
-		if (p->start_day <= day && day <= p->end_day && time < p->end_time)	/* will be active today */
-		{
-			if (time < p->start_time)	/* hasn't been active today yet */
-				candidate = p->start_time;
-			else	/* currently active */
-				candidate = p->end_time;
-		}
-		else if (day < p->end_day)	/* will be active this week */
+		for (day = flex->period.start_day; day <= flex->period.end_day; day++)
 		{
-			if (day < p->start_day)	/* hasn't been active this week yet */
-				candidate = SEC_PER_DAY * (p->start_day - day) + p->start_time;
-			else	/* has been active this week and will be active at least once more by the end of it */
-				candidate = SEC_PER_DAY + p->start_time;	/* therefore will be active tomorrow */
+			custom_intervals->segments[num++].start = SEC_PER_DAY * (day - 1) + flex->period.start_time;
+			custom_intervals->segments[num++].start = (SEC_PER_DAY * (day - 1) + flex->period.end_time) %
+					SEC_PER_WEEK;
 		}
-		else	/* will be active next week */
-			candidate = SEC_PER_DAY * (p->start_day + 7 - day) + p->start_time;
+	}
+
+	qsort(custom_intervals->segments, (size_t)num, sizeof(zbx_flexible_segment_t), flexible_segment_compare);
 
-		if (0 == next || next > candidate)
-			next = candidate;
+	for (i = 1, custom_intervals->segments_num = 1; i < num; i++)
+	{
+		if (custom_intervals->segments[i].start != custom_intervals->segments[i - 1].start)
+			custom_intervals->segments[custom_intervals->segments_num++] = custom_intervals->segments[i];
 	}
 
-	if (0 == next)
-		return FAIL;
+	for (i = 0; i < custom_intervals->segments_num; i++)
+	{
+		zbx_flexible_segment_t	*segment = &custom_intervals->segments[i];
+		int			day, time;
 
-	*next_interval = now - time + next;
-	return SUCCEED;
+		day = segment->start / SEC_PER_DAY + 1;
+		time = segment->start % SEC_PER_DAY;
+		segment->delay = -1;
+
+		for (flex = custom_intervals->flexible; NULL != flex; flex = flex->next)
+		{
+			const zbx_time_period_t	*p = &flex->period;
+
+			if (p->start_day <= day && day <= p->end_day && p->start_time <= time && time < p->end_time &&
+					(-1 == segment->delay || flex->delay < segment->delay))
+			{
+				segment->delay = flex->delay;
+			}
+		}
+	}
 }
 
 /******************************************************************************
@@ -717,6 +821,7 @@ int	zbx_interval_preproc(const char *interval_str, int *simple_interval, zbx_cus
 	*custom_intervals = (zbx_custom_interval_t *)zbx_malloc(NULL, sizeof(zbx_custom_interval_t));
 	(*custom_intervals)->flexible = flexible;
 	(*custom_intervals)->scheduling = scheduling;
+	flexible_schedule_build(*custom_intervals);
 
 	return SUCCEED;
 fail:
@@ -936,6 +1041,7 @@ void	zbx_custom_interval_free(zbx_custom_interval_t *custom_intervals)
 {
 	flexible_interval_free(custom_intervals->flexible);
 	scheduler_interval_free(custom_intervals->scheduling);
+	zbx_free(custom_intervals->segments);
 	zbx_free(custom_intervals);
 }
 
@@ -1511,7 +1617,7 @@ int	zbx_calculate_item_nextcheck(zbx_uint64_t seed, int item_type, int simple_in
 		{
 			/* calculate 'nextcheck' value for the current interval */
 			if (NULL != custom_intervals)
-				current_delay = get_current_delay(simple_interval, custom_intervals->flexible, t);
+				current_delay = get_current_delay(simple_interval, custom_intervals, t);
 			else
 				current_delay = simple_interval;
 
@@ -1539,7 +1645,7 @@ int	zbx_calculate_item_nextcheck(zbx_uint64_t seed, int item_type, int simple_in
 
 			/* 'nextcheck' < end of the current interval ? */
 			/* the end of the current interval is the beginning of the next interval - 1 */
-			if (FAIL != get_next_delay_interval(custom_intervals->flexible, t, &next_interval) &&
+			if (FAIL != get_next_delay_interval(custom_intervals, t, &next_interval) &&
 					nextcheck >= next_interval)
 			{
 				/* 'nextcheck' is beyond the current interval */
@@ -1589,11 +1695,11 @@ int	zbx_calculate_item_nextcheck_unreachable(int simple_interval, const zbx_cust
 	{
 		while (nextcheck < tmax)
 		{
-			if (0 != get_current_delay(simple_interval, custom_intervals->flexible, nextcheck))
+			if (0 != get_current_delay(simple_interval, custom_intervals, nextcheck))
 				break;
 
 			/* find the flexible interval change */
-			if (FAIL == get_next_delay_interval(custom_intervals->flexible, nextcheck, &next_interval))
+			if (FAIL == get_next_delay_interval(custom_intervals, nextcheck, &next_interval))
 			{
 				nextcheck = ZBX_JAN_2038;
 				break;
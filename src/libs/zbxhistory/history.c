@@ -185,6 +185,42 @@ int	zbx_history_get_values(zbx_uint64_t itemid, int value_type, int start, int c
 	return ret;
 }
 
+/************************************************************************************
+ *                                                                                  *
+ * Purpose: gets values of multiple items from history storage                      *
+ *                                                                                  *
+ * Parameters:  queries     - [IN/OUT] the item history read requests               *
+ *              queries_num - [IN] the number of read requests                      *
+ *              value_type  - [IN] the value type of requested items                *
+ *                                                                                  *
+ * Comments: This function reads all values from ]<start>,<end>] interval of each   *
+ *           request into its values vector and sets the request result. Storage    *
+ *           backends without batch read support are queried item by item.          *
+ *                                                                                  *
+ ************************************************************************************/
+void	zbx_history_get_values_batch(zbx_history_query_t *queries, int queries_num, int value_type)
+{
+	int			i;
+	zbx_history_iface_t	*writer = &history_ifaces[value_type];
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() value_type:%d queries:%d", __func__, value_type, queries_num);
+
+	if (NULL != writer->get_values_batch)
+	{
+		writer->get_values_batch(writer, queries, queries_num);
+	}
+	else
+	{
+		for (i = 0; i < queries_num; i++)
+		{
+			queries[i].ret = writer->get_values(writer, queries[i].itemid, queries[i].start, 0,
+					queries[i].end, &queries[i].values);
+		}
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
 /************************************************************************************
  *                                                                                  *
  * Purpose: checks if the value type requires trends data calculations              *
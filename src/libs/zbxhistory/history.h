@@ -33,23 +33,26 @@ typedef void (*zbx_history_destroy_func_t)(struct zbx_history_iface *hist);
 typedef int (*zbx_history_add_values_func_t)(struct zbx_history_iface *hist, const zbx_vector_ptr_t *history);
 typedef int (*zbx_history_get_values_func_t)(struct zbx_history_iface *hist, zbx_uint64_t itemid, int start,
 		int count, int end, zbx_vector_history_record_t *values);
+typedef void (*zbx_history_get_values_batch_func_t)(struct zbx_history_iface *hist, zbx_history_query_t *queries,
+		int queries_num);
 typedef int (*zbx_history_flush_func_t)(struct zbx_history_iface *hist);
 
 typedef void (*zbx_history_func_t)(const zbx_vector_ptr_t *);
 
 struct zbx_history_iface
 {
-	unsigned char			value_type;
-	unsigned char			requires_trends;
+	unsigned char						value_type;
+	unsigned char						requires_trends;
 	union
 	{
-		void				*elastic_data;
-		zbx_history_func_t		sql_history_func;
+		void							*elastic_data;
+		zbx_history_func_t				sql_history_func;
 	} data;
-	zbx_history_destroy_func_t	destroy;
-	zbx_history_add_values_func_t	add_values;
-	zbx_history_get_values_func_t	get_values;
-	zbx_history_flush_func_t	flush;
+	zbx_history_destroy_func_t			destroy;
+	zbx_history_add_values_func_t		add_values;
+	zbx_history_get_values_func_t		get_values;
+	zbx_history_get_values_batch_func_t	get_values_batch;
+	zbx_history_flush_func_t			flush;
 };
 
 /* SQL hist */
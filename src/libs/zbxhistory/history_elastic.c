@@ -28,6 +28,10 @@
 #include "zbxvariant.h"
 #include "zbx_dbversion_constants.h"
 
+#ifdef HAVE_ZLIB
+#include "zlib.h"
+#endif
+
 /* curl_multi_wait() is supported starting with version 7.28.0 (0x071c00) */
 #if defined(HAVE_LIBCURL) && LIBCURL_VERSION_NUM >= 0x071c00
 
@@ -36,6 +40,13 @@
 #define		ZBX_IDX_JSON_ALLOCATE		256
 #define		ZBX_JSON_ALLOCATE		2048
 
+/* bulk request bodies smaller than this are sent uncompressed */
+#define		ZBX_ELASTIC_GZIP_MIN_SIZE	4096
+
+/* the maximum number of hits returned for an item by multi search, */
+/* matches the default index.max_result_window setting              */
+#define		ZBX_ELASTIC_MSEARCH_SIZE	10000
+
 const char	*value_type_str[] = {"dbl", "str", "log", "uint", "text"};
 
 extern char	*CONFIG_HISTORY_STORAGE_URL;
@@ -46,10 +57,18 @@ static zbx_uint32_t	ZBX_ELASTIC_SVERSION = ZBX_DBVERSION_UNDEFINED;
 
 typedef struct
 {
-	char	*base_url;
-	char	*post_url;
-	char	*buf;
-	CURL	*handle;
+	char		*base_url;
+	char		*post_url;
+	char		*bulk_action;
+	char		*buf;
+	size_t		buf_alloc;
+	size_t		buf_offset;
+	char		*zbuf;
+	size_t		zbuf_alloc;
+	size_t		zbuf_offset;
+	unsigned char	gzip;
+	CURL		*handle;
+	CURL		*read_handle;
 }
 zbx_elastic_data_t;
 
@@ -64,6 +83,9 @@ zbx_elastic_writer_t;
 
 static zbx_elastic_writer_t	writer;
 
+/* connection cache and resolved addresses shared by all handles of the process */
+static CURLSH	*share;
+
 typedef struct
 {
 	char	*data;
@@ -234,7 +256,7 @@ static void	elastic_log_error(CURL *handle, CURLcode error, const char *errbuf)
 
 /************************************************************************************
  *                                                                                  *
- * Purpose: closes connection and releases allocated resources                      *
+ * Purpose: finishes bulk request, keeping the connection open for next requests    *
  *                                                                                  *
  * Parameters:  hist - [IN] the history storage interface                           *
  *                                                                                  *
@@ -243,19 +265,119 @@ static void	elastic_close(zbx_history_iface_t *hist)
 {
 	zbx_elastic_data_t	*data = hist->data.elastic_data;
 
-	zbx_free(data->buf);
-	zbx_free(data->post_url);
+	data->buf_offset = 0;
+	data->zbuf_offset = 0;
+	data->gzip = 0;
 
-	if (NULL != data->handle)
+	if (NULL != data->handle && NULL != writer.handle)
+		curl_multi_remove_handle(writer.handle, data->handle);
+}
+
+/************************************************************************************
+ *                                                                                  *
+ * Purpose: prepares persistent cURL handle for a new request                       *
+ *                                                                                  *
+ * Parameters:  handle - [IN/OUT] the cURL handle, created if not initialized yet   *
+ *                                                                                  *
+ * Return value: SUCCEED - the handle was prepared                                  *
+ *               FAIL    - otherwise                                                *
+ *                                                                                  *
+ * Comments: Handles are reset instead of being recreated, so the established       *
+ *           connections are reused by the following requests.                      *
+ *                                                                                  *
+ ************************************************************************************/
+static int	elastic_handle_prepare(CURL **handle)
+{
+	CURLoption	opt;
+	CURLcode	err;
+
+	if (NULL == *handle)
 	{
-		if (NULL != writer.handle)
-			curl_multi_remove_handle(writer.handle, data->handle);
+		if (NULL == (*handle = curl_easy_init()))
+		{
+			zabbix_log(LOG_LEVEL_ERR, "cannot initialize cURL session");
+			return FAIL;
+		}
+	}
+	else
+		curl_easy_reset(*handle);
 
-		curl_easy_cleanup(data->handle);
-		data->handle = NULL;
+#if LIBCURL_VERSION_NUM >= 0x073900
+	/* connection cache sharing is supported starting with version 7.57.0 (0x073900) */
+	if (NULL == share && NULL != (share = curl_share_init()))
+	{
+		curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+		curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+	}
+
+	if (NULL != share && CURLE_OK != (err = curl_easy_setopt(*handle, opt = CURLOPT_SHARE, share)))
+		goto fail;
+#endif
+	if (CURLE_OK != (err = curl_easy_setopt(*handle, opt = CURLOPT_FAILONERROR, 1L)) ||
+			CURLE_OK != (err = curl_easy_setopt(*handle, opt = CURLOPT_TCP_KEEPALIVE, 1L)) ||
+			CURLE_OK != (err = curl_easy_setopt(*handle, opt = ZBX_CURLOPT_ACCEPT_ENCODING, "")))
+	{
+		goto fail;
 	}
+
+#if LIBCURL_VERSION_NUM >= 0x071304
+	/* CURLOPT_PROTOCOLS is supported starting with version 7.19.4 (0x071304) */
+	if (CURLE_OK != (err = curl_easy_setopt(*handle, opt = CURLOPT_PROTOCOLS, CURLPROTO_HTTP | CURLPROTO_HTTPS)))
+		goto fail;
+#endif
+	return SUCCEED;
+fail:
+	zabbix_log(LOG_LEVEL_ERR, "cannot set cURL option %d: [%s]", (int)opt, curl_easy_strerror(err));
+
+	return FAIL;
 }
 
+#ifdef HAVE_ZLIB
+/************************************************************************************
+ *                                                                                  *
+ * Purpose: compresses bulk request body with gzip                                  *
+ *                                                                                  *
+ * Parameters:  data - [IN/OUT] the elastic data with request body to compress      *
+ *                                                                                  *
+ * Return value: SUCCEED - the compressed body was written to zbuf                  *
+ *               FAIL    - otherwise                                                *
+ *                                                                                  *
+ ************************************************************************************/
+static int	elastic_gzip(zbx_elastic_data_t *data)
+{
+	z_stream	zs;
+	size_t		bound;
+	int		ret = FAIL;
+
+	memset(&zs, 0, sizeof(zs));
+
+	/* adding 16 to window bits selects gzip header and trailer instead of zlib ones */
+	if (Z_OK != deflateInit2(&zs, Z_BEST_SPEED, Z_DEFLATED, MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY))
+		return FAIL;
+
+	if (data->zbuf_alloc < (bound = deflateBound(&zs, (uLong)data->buf_offset)))
+	{
+		data->zbuf_alloc = bound;
+		data->zbuf = (char *)zbx_realloc(data->zbuf, data->zbuf_alloc);
+	}
+
+	zs.next_in = (Bytef *)data->buf;
+	zs.avail_in = (uInt)data->buf_offset;
+	zs.next_out = (Bytef *)data->zbuf;
+	zs.avail_out = (uInt)data->zbuf_alloc;
+
+	if (Z_STREAM_END == deflate(&zs, Z_FINISH))
+	{
+		data->zbuf_offset = zs.total_out;
+		ret = SUCCEED;
+	}
+
+	deflateEnd(&zs);
+
+	return ret;
+}
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Purpose: check an error from Elastic json response                         *
@@ -342,7 +464,7 @@ static void	elastic_writer_init(void)
 
 	zbx_vector_ptr_create(&writer.ifaces);
 
-	if (NULL == (writer.handle = curl_multi_init()))
+	if (NULL == writer.handle && NULL == (writer.handle = curl_multi_init()))
 	{
 		zbx_error("Cannot initialize cURL multi session");
 		exit(EXIT_FAILURE);
@@ -353,9 +475,12 @@ static void	elastic_writer_init(void)
 
 /************************************************************************************
  *                                                                                  *
- * Purpose: releases initialized elastic writer by freeing allocated resources and  *
+ * Purpose: releases initialized elastic writer by finishing the requests and       *
  *          setting its state to uninitialized.                                     *
  *                                                                                  *
+ * Comments: The multi handle is kept, so its connections are reused by the next    *
+ *           batch of history values.                                               *
+ *                                                                                  *
  ************************************************************************************/
 static void	elastic_writer_release(void)
 {
@@ -364,9 +489,6 @@ static void	elastic_writer_release(void)
 	for (i = 0; i < writer.ifaces.values_num; i++)
 		elastic_close((zbx_history_iface_t *)writer.ifaces.values[i]);
 
-	curl_multi_cleanup(writer.handle);
-	writer.handle = NULL;
-
 	zbx_vector_ptr_destroy(&writer.ifaces);
 
 	writer.initialized = 0;
@@ -384,40 +506,37 @@ static void	elastic_writer_add_iface(zbx_history_iface_t *hist)
 	zbx_elastic_data_t	*data = hist->data.elastic_data;
 	CURLoption		opt;
 	CURLcode		err;
+	const char		*body = data->buf;
+	size_t			body_size = data->buf_offset;
 
 	elastic_writer_init();
 
-	if (NULL == (data->handle = curl_easy_init()))
+	if (SUCCEED != elastic_handle_prepare(&data->handle))
+		goto out;
+
+#ifdef HAVE_ZLIB
+	if (ZBX_ELASTIC_GZIP_MIN_SIZE <= data->buf_offset && SUCCEED == elastic_gzip(data))
 	{
-		zabbix_log(LOG_LEVEL_ERR, "cannot initialize cURL session");
-		return;
+		body = data->zbuf;
+		body_size = data->zbuf_offset;
+		data->gzip = 1;
 	}
+#endif
 
 	if (CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_URL, data->post_url)) ||
 			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_POST, 1L)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_POSTFIELDS, data->buf)) ||
+			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_POSTFIELDSIZE, (long)body_size)) ||
+			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_POSTFIELDS, body)) ||
 			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_WRITEFUNCTION,
 					curl_write_cb)) ||
 			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_WRITEDATA,
 					&page_w[hist->value_type].page)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_FAILONERROR, 1L)) ||
 			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_ERRORBUFFER,
-					page_w[hist->value_type].errbuf)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = ZBX_CURLOPT_ACCEPT_ENCODING, "")))
-	{
-		zabbix_log(LOG_LEVEL_ERR, "cannot set cURL option %d: [%s]", (int)opt, curl_easy_strerror(err));
-		goto out;
-	}
-
-#if LIBCURL_VERSION_NUM >= 0x071304
-	/* CURLOPT_PROTOCOLS is supported starting with version 7.19.4 (0x071304) */
-	if (CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_PROTOCOLS,
-			CURLPROTO_HTTP | CURLPROTO_HTTPS)))
+					page_w[hist->value_type].errbuf)))
 	{
 		zabbix_log(LOG_LEVEL_ERR, "cannot set cURL option %d: [%s]", (int)opt, curl_easy_strerror(err));
 		goto out;
 	}
-#endif
 
 	*page_w[hist->value_type].errbuf = '\0';
 
@@ -448,7 +567,7 @@ out:
  ************************************************************************************/
 static int	elastic_writer_flush(void)
 {
-	struct curl_slist	*curl_headers = NULL;
+	struct curl_slist	*curl_headers = NULL, *curl_headers_gzip = NULL;
 	int			i, running, previous, msgnum;
 	CURLMsg			*msg;
 	zbx_vector_ptr_t	retries;
@@ -465,13 +584,16 @@ static int	elastic_writer_flush(void)
 	zbx_vector_ptr_create(&retries);
 
 	curl_headers = curl_slist_append(curl_headers, "Content-Type: application/x-ndjson");
+	curl_headers_gzip = curl_slist_append(curl_headers_gzip, "Content-Type: application/x-ndjson");
+	curl_headers_gzip = curl_slist_append(curl_headers_gzip, "Content-Encoding: gzip");
 
 	for (i = 0; i < writer.ifaces.values_num; i++)
 	{
 		zbx_history_iface_t	*hist = (zbx_history_iface_t *)writer.ifaces.values[i];
 		zbx_elastic_data_t	*data = hist->data.elastic_data;
 
-		if (CURLE_OK != (err = curl_easy_setopt(data->handle, CURLOPT_HTTPHEADER, curl_headers)))
+		if (CURLE_OK != (err = curl_easy_setopt(data->handle, CURLOPT_HTTPHEADER,
+				0 != data->gzip ? curl_headers_gzip : curl_headers)))
 		{
 			zabbix_log(LOG_LEVEL_ERR, "cannot set cURL option %d: [%s]", (int)CURLOPT_HTTPHEADER,
 					curl_easy_strerror(err));
@@ -479,7 +601,7 @@ static int	elastic_writer_flush(void)
 			goto clean;
 		}
 
-		zabbix_log(LOG_LEVEL_DEBUG, "sending %s", data->buf);
+		zabbix_log(LOG_LEVEL_DEBUG, "sending%s %s", 0 != data->gzip ? " compressed" : "", data->buf);
 	}
 
 try_again:
@@ -593,6 +715,7 @@ try_again:
 	}
 clean:
 	curl_slist_free_all(curl_headers);
+	curl_slist_free_all(curl_headers_gzip);
 
 	zbx_vector_ptr_destroy(&retries);
 
@@ -623,10 +746,76 @@ static void	elastic_destroy(zbx_history_iface_t *hist)
 
 	elastic_close(hist);
 
+	if (NULL != data->handle)
+		curl_easy_cleanup(data->handle);
+
+	if (NULL != data->read_handle)
+		curl_easy_cleanup(data->read_handle);
+
+	/* outside of flush no handles are attached to the multi handle, so it can be released */
+	/* with the first destroyed interface and is recreated if more data is written later  */
+	if (NULL != writer.handle && 0 == writer.initialized)
+	{
+		curl_multi_cleanup(writer.handle);
+		writer.handle = NULL;
+	}
+
+	/* the share cleanup fails while handles of other interfaces are still using it */
+	if (NULL != share && CURLSHE_OK == curl_share_cleanup(share))
+		share = NULL;
+
+	zbx_free(data->zbuf);
+	zbx_free(data->buf);
+	zbx_free(data->bulk_action);
+	zbx_free(data->post_url);
 	zbx_free(data->base_url);
 	zbx_free(data);
 }
 
+/************************************************************************************
+ *                                                                                  *
+ * Purpose: adds item values query to elastic search request                        *
+ *                                                                                  *
+ * Parameters:  json   - [IN/OUT] the search request being built                    *
+ *              itemid - [IN] the itemid                                            *
+ *              start  - [IN] the period start timestamp (excluded)                 *
+ *              end    - [IN] the period end timestamp                              *
+ *                                                                                  *
+ * Comments: The query is the last element of request, the request json is closed   *
+ *           after adding it.                                                       *
+ *                                                                                  *
+ ************************************************************************************/
+static void	elastic_json_add_item_query(struct zbx_json *json, zbx_uint64_t itemid, int start, int end)
+{
+	zbx_json_addobject(json, "query");
+	zbx_json_addobject(json, "bool");
+	zbx_json_addarray(json, "must");
+	zbx_json_addobject(json, NULL);
+	zbx_json_addobject(json, "match");
+	zbx_json_adduint64(json, "itemid", itemid);
+	zbx_json_close(json);
+	zbx_json_close(json);
+	zbx_json_close(json);
+	zbx_json_addarray(json, "filter");
+	zbx_json_addobject(json, NULL);
+	zbx_json_addobject(json, "range");
+	zbx_json_addobject(json, "clock");
+
+	if (0 < start)
+		zbx_json_adduint64(json, "gt", start);
+
+	if (0 < end)
+		zbx_json_adduint64(json, "lte", end);
+
+	zbx_json_close(json);
+	zbx_json_close(json);
+	zbx_json_close(json);
+	zbx_json_close(json);
+	zbx_json_close(json);
+	zbx_json_close(json);
+	zbx_json_close(json);
+}
+
 /************************************************************************************
  *                                                                                  *
  * Purpose: gets item history data from history storage                             *
@@ -654,21 +843,17 @@ static int	elastic_get_values(zbx_history_iface_t *hist, zbx_uint64_t itemid, in
 	CURLcode		err;
 	struct zbx_json		query;
 	struct curl_slist	*curl_headers = NULL;
-	char			*scroll_id = NULL, *scroll_query = NULL, errbuf[CURL_ERROR_SIZE];
+	char			*url = NULL, *scroll_id = NULL, *scroll_query = NULL, errbuf[CURL_ERROR_SIZE];
 	CURLoption		opt;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
 	ret = FAIL;
 
-	if (NULL == (data->handle = curl_easy_init()))
-	{
-		zabbix_log(LOG_LEVEL_ERR, "cannot initialize cURL session");
-
+	if (SUCCEED != elastic_handle_prepare(&data->read_handle))
 		return FAIL;
-	}
 
-	zbx_snprintf_alloc(&data->post_url, &url_alloc, &url_offset, "%s/%s*/_search?scroll=10s", data->base_url,
+	zbx_snprintf_alloc(&url, &url_alloc, &url_offset, "%s/%s*/_search?scroll=10s", data->base_url,
 			value_type_str[hist->value_type]);
 
 	/* prepare the json query for elasticsearch, apply ranges if needed */
@@ -686,74 +871,37 @@ static int	elastic_get_values(zbx_history_iface_t *hist, zbx_uint64_t itemid, in
 		zbx_json_close(&query);
 	}
 
-	zbx_json_addobject(&query, "query");
-	zbx_json_addobject(&query, "bool");
-	zbx_json_addarray(&query, "must");
-	zbx_json_addobject(&query, NULL);
-	zbx_json_addobject(&query, "match");
-	zbx_json_adduint64(&query, "itemid", itemid);
-	zbx_json_close(&query);
-	zbx_json_close(&query);
-	zbx_json_close(&query);
-	zbx_json_addarray(&query, "filter");
-	zbx_json_addobject(&query, NULL);
-	zbx_json_addobject(&query, "range");
-	zbx_json_addobject(&query, "clock");
-
-	if (0 < start)
-		zbx_json_adduint64(&query, "gt", start);
-
-	if (0 < end)
-		zbx_json_adduint64(&query, "lte", end);
-
-	zbx_json_close(&query);
-	zbx_json_close(&query);
-	zbx_json_close(&query);
-	zbx_json_close(&query);
-	zbx_json_close(&query);
-	zbx_json_close(&query);
-	zbx_json_close(&query);
+	elastic_json_add_item_query(&query, itemid, start, end);
 
 	curl_headers = curl_slist_append(curl_headers, "Content-Type: application/json");
 
-	if (CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_URL, data->post_url)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_POSTFIELDS, query.buffer)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_WRITEFUNCTION,
+	if (CURLE_OK != (err = curl_easy_setopt(data->read_handle, opt = CURLOPT_URL, url)) ||
+			CURLE_OK != (err = curl_easy_setopt(data->read_handle, opt = CURLOPT_POSTFIELDS, query.buffer)) ||
+			CURLE_OK != (err = curl_easy_setopt(data->read_handle, opt = CURLOPT_WRITEFUNCTION,
 					curl_write_cb)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_WRITEDATA, &page_r)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_HTTPHEADER, curl_headers)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_FAILONERROR, 1L)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_ERRORBUFFER, errbuf)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = ZBX_CURLOPT_ACCEPT_ENCODING, "")))
-	{
-		zabbix_log(LOG_LEVEL_ERR, "cannot set cURL option %d: [%s]", (int)opt, curl_easy_strerror(err));
-		goto out;
-	}
-
-#if LIBCURL_VERSION_NUM >= 0x071304
-	/* CURLOPT_PROTOCOLS is supported starting with version 7.19.4 (0x071304) */
-	if (CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_PROTOCOLS,
-			CURLPROTO_HTTP | CURLPROTO_HTTPS)))
+			CURLE_OK != (err = curl_easy_setopt(data->read_handle, opt = CURLOPT_WRITEDATA, &page_r)) ||
+			CURLE_OK != (err = curl_easy_setopt(data->read_handle, opt = CURLOPT_HTTPHEADER,
+					curl_headers)) ||
+			CURLE_OK != (err = curl_easy_setopt(data->read_handle, opt = CURLOPT_ERRORBUFFER, errbuf)))
 	{
 		zabbix_log(LOG_LEVEL_ERR, "cannot set cURL option %d: [%s]", (int)opt, curl_easy_strerror(err));
 		goto out;
 	}
-#endif
 
-	zabbix_log(LOG_LEVEL_DEBUG, "sending query to %s; post data: %s", data->post_url, query.buffer);
+	zabbix_log(LOG_LEVEL_DEBUG, "sending query to %s; post data: %s", url, query.buffer);
 
 	page_r.offset = 0;
 	*errbuf = '\0';
-	if (CURLE_OK != (err = curl_easy_perform(data->handle)))
+	if (CURLE_OK != (err = curl_easy_perform(data->read_handle)))
 	{
-		elastic_log_error(data->handle, err, errbuf);
+		elastic_log_error(data->read_handle, err, errbuf);
 		goto out;
 	}
 
 	url_offset = 0;
-	zbx_snprintf_alloc(&data->post_url, &url_alloc, &url_offset, "%s/_search/scroll", data->base_url);
+	zbx_snprintf_alloc(&url, &url_alloc, &url_offset, "%s/_search/scroll", data->base_url);
 
-	if (CURLE_OK != (err = curl_easy_setopt(data->handle, CURLOPT_URL, data->post_url)))
+	if (CURLE_OK != (err = curl_easy_setopt(data->read_handle, CURLOPT_URL, url)))
 	{
 		zabbix_log(LOG_LEVEL_ERR, "cannot set cURL option %d: [%s]", (int)CURLOPT_URL,
 				curl_easy_strerror(err));
@@ -824,7 +972,7 @@ static int	elastic_get_values(zbx_history_iface_t *hist, zbx_uint64_t itemid, in
 		zbx_snprintf_alloc(&scroll_query, &scroll_alloc, &scroll_offset,
 				"{\"scroll\":\"10s\",\"scroll_id\":\"%s\"}\n", ZBX_NULL2EMPTY_STR(scroll_id));
 
-		if (CURLE_OK != (err = curl_easy_setopt(data->handle, CURLOPT_POSTFIELDS, scroll_query)))
+		if (CURLE_OK != (err = curl_easy_setopt(data->read_handle, CURLOPT_POSTFIELDS, scroll_query)))
 		{
 			zabbix_log(LOG_LEVEL_ERR, "cannot set cURL option %d: [%s]", (int)CURLOPT_POSTFIELDS,
 					curl_easy_strerror(err));
@@ -833,9 +981,9 @@ static int	elastic_get_values(zbx_history_iface_t *hist, zbx_uint64_t itemid, in
 
 		page_r.offset = 0;
 		*errbuf = '\0';
-		if (CURLE_OK != (err = curl_easy_perform(data->handle)))
+		if (CURLE_OK != (err = curl_easy_perform(data->read_handle)))
 		{
-			elastic_log_error(data->handle, err, errbuf);
+			elastic_log_error(data->read_handle, err, errbuf);
 			break;
 		}
 	}
@@ -845,12 +993,12 @@ static int	elastic_get_values(zbx_history_iface_t *hist, zbx_uint64_t itemid, in
 	if (NULL != scroll_id)
 	{
 		url_offset = 0;
-		zbx_snprintf_alloc(&data->post_url, &url_alloc, &url_offset, "%s/_search/scroll/%s", data->base_url,
-				scroll_id);
+		zbx_snprintf_alloc(&url, &url_alloc, &url_offset, "%s/_search/scroll/%s", data->base_url, scroll_id);
 
-		if (CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_URL, data->post_url)) ||
-				CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_POSTFIELDS, "")) ||
-				CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_CUSTOMREQUEST, "DELETE")))
+		if (CURLE_OK != (err = curl_easy_setopt(data->read_handle, opt = CURLOPT_URL, url)) ||
+				CURLE_OK != (err = curl_easy_setopt(data->read_handle, opt = CURLOPT_POSTFIELDS, "")) ||
+				CURLE_OK != (err = curl_easy_setopt(data->read_handle, opt = CURLOPT_CUSTOMREQUEST,
+						"DELETE")))
 		{
 			zabbix_log(LOG_LEVEL_ERR, "cannot set cURL option %d: [%s]", (int)opt,
 					curl_easy_strerror(err));
@@ -858,21 +1006,20 @@ static int	elastic_get_values(zbx_history_iface_t *hist, zbx_uint64_t itemid, in
 			goto out;
 		}
 
-		zabbix_log(LOG_LEVEL_DEBUG, "elasticsearch closing scroll %s", data->post_url);
+		zabbix_log(LOG_LEVEL_DEBUG, "elasticsearch closing scroll %s", url);
 
 		page_r.offset = 0;
 		*errbuf = '\0';
-		if (CURLE_OK != (err = curl_easy_perform(data->handle)))
-			elastic_log_error(data->handle, err, errbuf);
+		if (CURLE_OK != (err = curl_easy_perform(data->read_handle)))
+			elastic_log_error(data->read_handle, err, errbuf);
 	}
 
 out:
-	elastic_close(hist);
-
 	curl_slist_free_all(curl_headers);
 
 	zbx_json_free(&query);
 
+	zbx_free(url);
 	zbx_free(scroll_id);
 	zbx_free(scroll_query);
 
@@ -883,6 +1030,156 @@ out:
 	return ret;
 }
 
+/************************************************************************************
+ *                                                                                  *
+ * Purpose: gets values of multiple items from history storage with single multi    *
+ *          search request                                                          *
+ *                                                                                  *
+ * Parameters:  hist        - [IN] the history storage interface                    *
+ *              queries     - [IN/OUT] the item history read requests               *
+ *              queries_num - [IN] the number of read requests                      *
+ *                                                                                  *
+ * Comments: Multi search does not support scrolling, so values of items having     *
+ *           more hits than returned by multi search are read again with            *
+ *           elastic_get_values().                                                  *
+ *                                                                                  *
+ ************************************************************************************/
+static void	elastic_get_values_batch(zbx_history_iface_t *hist, zbx_history_query_t *queries, int queries_num)
+{
+	zbx_elastic_data_t	*data = hist->data.elastic_data;
+	size_t			body_alloc = 0, body_offset = 0;
+	int			i;
+	CURLcode		err;
+	CURLoption		opt;
+	struct zbx_json		query;
+	struct zbx_json_parse	jp, jp_responses;
+	struct curl_slist	*curl_headers = NULL;
+	char			*url = NULL, *body = NULL, errbuf[CURL_ERROR_SIZE];
+	const char		*pr = NULL;
+	zbx_vector_uint32_t	truncated;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() queries:%d", __func__, queries_num);
+
+	zbx_vector_uint32_create(&truncated);
+	zbx_json_init(&query, ZBX_JSON_ALLOCATE);
+
+	for (i = 0; i < queries_num; i++)
+	{
+		queries[i].ret = FAIL;
+
+		zbx_snprintf_alloc(&body, &body_alloc, &body_offset, "{\"index\":\"%s*\"}\n",
+				value_type_str[hist->value_type]);
+
+		zbx_json_clean(&query);
+		zbx_json_adduint64(&query, "size", ZBX_ELASTIC_MSEARCH_SIZE);
+		elastic_json_add_item_query(&query, queries[i].itemid, queries[i].start, queries[i].end);
+
+		zbx_strncpy_alloc(&body, &body_alloc, &body_offset, query.buffer, query.buffer_size);
+		zbx_chrcpy_alloc(&body, &body_alloc, &body_offset, '\n');
+	}
+
+	if (0 == queries_num || SUCCEED != elastic_handle_prepare(&data->read_handle))
+		goto out;
+
+	url = zbx_dsprintf(NULL, "%s/_msearch", data->base_url);
+	curl_headers = curl_slist_append(curl_headers, "Content-Type: application/x-ndjson");
+
+	if (CURLE_OK != (err = curl_easy_setopt(data->read_handle, opt = CURLOPT_URL, url)) ||
+			CURLE_OK != (err = curl_easy_setopt(data->read_handle, opt = CURLOPT_POSTFIELDS, body)) ||
+			CURLE_OK != (err = curl_easy_setopt(data->read_handle, opt = CURLOPT_WRITEFUNCTION,
+					curl_write_cb)) ||
+			CURLE_OK != (err = curl_easy_setopt(data->read_handle, opt = CURLOPT_WRITEDATA, &page_r)) ||
+			CURLE_OK != (err = curl_easy_setopt(data->read_handle, opt = CURLOPT_HTTPHEADER,
+					curl_headers)) ||
+			CURLE_OK != (err = curl_easy_setopt(data->read_handle, opt = CURLOPT_ERRORBUFFER, errbuf)))
+	{
+		zabbix_log(LOG_LEVEL_ERR, "cannot set cURL option %d: [%s]", (int)opt, curl_easy_strerror(err));
+		goto out;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "sending multi search to %s; post data: %s", url, body);
+
+	page_r.offset = 0;
+	*errbuf = '\0';
+	if (CURLE_OK != (err = curl_easy_perform(data->read_handle)))
+	{
+		elastic_log_error(data->read_handle, err, errbuf);
+		goto out;
+	}
+
+	zabbix_log(LOG_LEVEL_TRACE, "received from elasticsearch: %s", page_r.data);
+
+	if (SUCCEED != zbx_json_open(page_r.data, &jp) ||
+			SUCCEED != zbx_json_brackets_by_name(&jp, "responses", &jp_responses))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "elasticsearch version is not compatible with zabbix server. "
+				"responses tag is absent");
+		goto out;
+	}
+
+	/* responses are returned in the same order as searches in request */
+	for (i = 0; i < queries_num && NULL != (pr = zbx_json_next(&jp_responses, pr)); i++)
+	{
+		struct zbx_json_parse	jp_response, jp_sub, jp_hits, jp_item, jp_source;
+		zbx_history_record_t	hr;
+		const char		*p = NULL;
+		int			hits_num = 0;
+
+		if (SUCCEED != zbx_json_brackets_open(pr, &jp_response) ||
+				SUCCEED != zbx_json_brackets_by_name(&jp_response, "hits", &jp_sub) ||
+				SUCCEED != zbx_json_brackets_by_name(&jp_sub, "hits", &jp_hits))
+		{
+			continue;
+		}
+
+		while (NULL != (p = zbx_json_next(&jp_hits, p)))
+		{
+			hits_num++;
+
+			if (SUCCEED != zbx_json_brackets_open(p, &jp_item))
+				continue;
+
+			if (SUCCEED != zbx_json_brackets_by_name(&jp_item, "_source", &jp_source))
+				continue;
+
+			if (SUCCEED != history_parse_value(&jp_source, hist->value_type, &hr))
+				continue;
+
+			zbx_vector_history_record_append_ptr(&queries[i].values, &hr);
+		}
+
+		if (ZBX_ELASTIC_MSEARCH_SIZE <= hits_num)
+		{
+			zbx_vector_uint32_append(&truncated, (zbx_uint32_t)i);
+			continue;
+		}
+
+		zbx_vector_history_record_sort(&queries[i].values,
+				(zbx_compare_func_t)zbx_history_record_compare_desc_func);
+		queries[i].ret = SUCCEED;
+	}
+
+	/* the read buffer is reused by scroll queries, so they are done after parsing whole response */
+	for (i = 0; i < truncated.values_num; i++)
+	{
+		zbx_history_query_t	*q = &queries[truncated.values[i]];
+
+		zbx_history_record_vector_clean(&q->values, hist->value_type);
+		q->ret = elastic_get_values(hist, q->itemid, q->start, 0, q->end, &q->values);
+	}
+out:
+	curl_slist_free_all(curl_headers);
+
+	zbx_json_free(&query);
+
+	zbx_free(url);
+	zbx_free(body);
+
+	zbx_vector_uint32_destroy(&truncated);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
 /************************************************************************************
  *                                                                                  *
  * Purpose: sends history data to the storage                                       *
@@ -896,26 +1193,16 @@ static int	elastic_add_values(zbx_history_iface_t *hist, const zbx_vector_ptr_t
 	zbx_elastic_data_t	*data = hist->data.elastic_data;
 	int			i, num = 0;
 	zbx_dc_history_t	*h;
-	struct zbx_json		json_idx, json;
-	size_t			buf_alloc = 0, buf_offset = 0;
-	char			pipeline[14]; /* index name length + suffix "-pipeline" */
+	struct zbx_json		json;
+	size_t			action_len;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	zbx_json_init(&json_idx, ZBX_IDX_JSON_ALLOCATE);
-
-	zbx_json_addobject(&json_idx, "index");
-	zbx_json_addstring(&json_idx, "_index", value_type_str[hist->value_type], ZBX_JSON_TYPE_STRING);
-
-	if (1 == CONFIG_HISTORY_STORAGE_PIPELINES)
-	{
-		zbx_snprintf(pipeline, sizeof(pipeline), "%s-pipeline", value_type_str[hist->value_type]);
-		zbx_json_addstring(&json_idx, "pipeline", pipeline, ZBX_JSON_TYPE_STRING);
-	}
-
-	zbx_json_close(&json_idx);
-	zbx_json_close(&json_idx);
+	zbx_json_init(&json, ZBX_JSON_ALLOCATE);
+	action_len = strlen(data->bulk_action);
 
+	/* the bulk request body is written directly into the buffer kept between batches, */
+	/* reusing the same json buffer for all documents                                  */
 	for (i = 0; i < history->values_num; i++)
 	{
 		h = (zbx_dc_history_t *)history->values[i];
@@ -923,7 +1210,7 @@ static int	elastic_add_values(zbx_history_iface_t *hist, const zbx_vector_ptr_t
 		if (hist->value_type != h->value_type)
 			continue;
 
-		zbx_json_init(&json, ZBX_JSON_ALLOCATE);
+		zbx_json_clean(&json);
 
 		zbx_json_adduint64(&json, "itemid", h->itemid);
 
@@ -947,20 +1234,17 @@ static int	elastic_add_values(zbx_history_iface_t *hist, const zbx_vector_ptr_t
 
 		zbx_json_close(&json);
 
-		zbx_snprintf_alloc(&data->buf, &buf_alloc, &buf_offset, "%s\n%s\n", json_idx.buffer, json.buffer);
-
-		zbx_json_free(&json);
+		zbx_strncpy_alloc(&data->buf, &data->buf_alloc, &data->buf_offset, data->bulk_action, action_len);
+		zbx_strncpy_alloc(&data->buf, &data->buf_alloc, &data->buf_offset, json.buffer, json.buffer_size);
+		zbx_chrcpy_alloc(&data->buf, &data->buf_alloc, &data->buf_offset, '\n');
 
 		num++;
 	}
 
 	if (num > 0)
-	{
-		data->post_url = zbx_dsprintf(NULL, "%s/_bulk?refresh=true", data->base_url);
 		elastic_writer_add_iface(hist);
-	}
 
-	zbx_json_free(&json_idx);
+	zbx_json_free(&json);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 
@@ -999,6 +1283,8 @@ static int	elastic_flush(zbx_history_iface_t *hist)
 int	zbx_history_elastic_init(zbx_history_iface_t *hist, unsigned char value_type, char **error)
 {
 	zbx_elastic_data_t	*data;
+	struct zbx_json		json_idx;
+	char			pipeline[14]; /* index name length + suffix "-pipeline" */
 
 	if (0 != curl_global_init(CURL_GLOBAL_ALL))
 	{
@@ -1010,9 +1296,30 @@ int	zbx_history_elastic_init(zbx_history_iface_t *hist, unsigned char value_type
 	memset(data, 0, sizeof(zbx_elastic_data_t));
 	data->base_url = zbx_strdup(NULL, CONFIG_HISTORY_STORAGE_URL);
 	zbx_rtrim(data->base_url, "/");
+	data->post_url = zbx_dsprintf(NULL, "%s/_bulk?refresh=true", data->base_url);
 	data->buf = NULL;
-	data->post_url = NULL;
+	data->zbuf = NULL;
 	data->handle = NULL;
+	data->read_handle = NULL;
+
+	/* the bulk action line is the same for all documents of the value type */
+	zbx_json_init(&json_idx, ZBX_IDX_JSON_ALLOCATE);
+
+	zbx_json_addobject(&json_idx, "index");
+	zbx_json_addstring(&json_idx, "_index", value_type_str[value_type], ZBX_JSON_TYPE_STRING);
+
+	if (1 == CONFIG_HISTORY_STORAGE_PIPELINES)
+	{
+		zbx_snprintf(pipeline, sizeof(pipeline), "%s-pipeline", value_type_str[value_type]);
+		zbx_json_addstring(&json_idx, "pipeline", pipeline, ZBX_JSON_TYPE_STRING);
+	}
+
+	zbx_json_close(&json_idx);
+	zbx_json_close(&json_idx);
+
+	data->bulk_action = zbx_dsprintf(NULL, "%s\n", json_idx.buffer);
+
+	zbx_json_free(&json_idx);
 
 	hist->value_type = value_type;
 	hist->data.elastic_data = data;
@@ -1020,6 +1327,7 @@ int	zbx_history_elastic_init(zbx_history_iface_t *hist, unsigned char value_type
 	hist->add_values = elastic_add_values;
 	hist->flush = elastic_flush;
 	hist->get_values = elastic_get_values;
+	hist->get_values_batch = elastic_get_values_batch;
 	hist->requires_trends = 0;
 
 	return SUCCEED;
@@ -197,6 +197,7 @@ static void	add_history_dbl(const zbx_vector_ptr_t *history)
 	zbx_db_insert_t	*db_insert = (zbx_db_insert_t *)zbx_malloc(NULL, sizeof(zbx_db_insert_t));
 
 	zbx_db_insert_prepare(db_insert, "history", "itemid", "clock", "ns", "value", NULL);
+	zbx_db_insert_use_copy(db_insert);
 
 	for (int i = 0; i < history->values_num; i++)
 	{
@@ -216,6 +217,7 @@ static void	add_history_uint(const zbx_vector_ptr_t *history)
 	zbx_db_insert_t	*db_insert = (zbx_db_insert_t *)zbx_malloc(NULL, sizeof(zbx_db_insert_t));
 
 	zbx_db_insert_prepare(db_insert, "history_uint", "itemid", "clock", "ns", "value", NULL);
+	zbx_db_insert_use_copy(db_insert);
 
 	for (int i = 0; i < history->values_num; i++)
 	{
@@ -235,6 +237,7 @@ static void	add_history_str(const zbx_vector_ptr_t *history)
 	zbx_db_insert_t	*db_insert = (zbx_db_insert_t *)zbx_malloc(NULL, sizeof(zbx_db_insert_t));
 
 	zbx_db_insert_prepare(db_insert, "history_str", "itemid", "clock", "ns", "value", NULL);
+	zbx_db_insert_use_copy(db_insert);
 
 	for (int i = 0; i < history->values_num; i++)
 	{
@@ -254,6 +257,7 @@ static void	add_history_text(const zbx_vector_ptr_t *history)
 	zbx_db_insert_t	*db_insert = (zbx_db_insert_t *)zbx_malloc(NULL, sizeof(zbx_db_insert_t));
 
 	zbx_db_insert_prepare(db_insert, "history_text", "itemid", "clock", "ns", "value", NULL);
+	zbx_db_insert_use_copy(db_insert);
 
 	for (int i = 0; i < history->values_num; i++)
 	{
@@ -274,6 +278,7 @@ static void	add_history_log(const zbx_vector_ptr_t *history)
 
 	zbx_db_insert_prepare(db_insert, "history_log", "itemid", "clock", "ns", "timestamp", "source", "severity",
 			"value", "logeventid", NULL);
+	zbx_db_insert_use_copy(db_insert);
 
 	for (int i = 0; i < history->values_num; i++)
 	{
@@ -297,6 +302,7 @@ static void	add_history_bin(const zbx_vector_ptr_t *history)
 	zbx_db_insert_t	*db_insert = (zbx_db_insert_t *)zbx_malloc(NULL, sizeof(zbx_db_insert_t));
 
 	zbx_db_insert_prepare(db_insert, "history_bin", "itemid", "clock", "ns", "value", NULL);
+	zbx_db_insert_use_copy(db_insert);
 
 	for (int i = 0; i < history->values_num; i++)
 	{
@@ -635,15 +641,174 @@ static void	sql_destroy(zbx_history_iface_t *hist)
 static int	sql_get_values(zbx_history_iface_t *hist, zbx_uint64_t itemid, int start, int count, int end,
 		zbx_vector_history_record_t *values)
 {
+	int	ret;
+
+	/* history older than the requested period end does not change, so it can be read from replica */
+	zbx_db_begin_replica_read(end);
+
 	if (0 == count)
-		return db_read_values_by_time(itemid, hist->value_type, values, end - start, end);
+		ret = db_read_values_by_time(itemid, hist->value_type, values, end - start, end);
+	else if (0 == start)
+		ret = db_read_values_by_count(itemid, hist->value_type, values, count, end);
+	else
+		ret = db_read_values_by_time_and_count(itemid, hist->value_type, values, end - start, count, end);
+
+	zbx_db_end_replica_read();
+
+	return ret;
+}
+
+/* the maximum number of items read with a single batch query */
+#define ZBX_HISTORY_BATCH_ITEMS_MAX	1000
+
+static int	history_query_compare_range(const void *d1, const void *d2)
+{
+	const zbx_history_query_t	*q1 = *(const zbx_history_query_t * const *)d1;
+	const zbx_history_query_t	*q2 = *(const zbx_history_query_t * const *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(q1->end, q2->end);
+	ZBX_RETURN_IF_NOT_EQUAL(q1->start, q2->start);
+	ZBX_RETURN_IF_NOT_EQUAL(q1->itemid, q2->itemid);
+
+	return 0;
+}
+
+/************************************************************************************
+ *                                                                                  *
+ * Purpose: reads history data of items having the same read range with a single   *
+ *          query                                                                   *
+ *                                                                                  *
+ * Parameters:  value_type  - [IN] the value type of requested items                *
+ *              queries     - [IN/OUT] the read requests, sorted by itemid          *
+ *              queries_num - [IN] the number of read requests                      *
+ *                                                                                  *
+ ************************************************************************************/
+static void	db_read_values_by_time_batch(int value_type, zbx_history_query_t **queries, int queries_num)
+{
+	char			*sql = NULL;
+	size_t			sql_alloc = 0, sql_offset = 0;
+	zbx_db_result_t		result;
+	zbx_db_row_t		row;
+	zbx_vc_history_table_t	*table = &vc_history_tables[value_type];
+	time_t			time_from;
+	zbx_vector_uint64_t	itemids;
+	int			i, end = queries[0]->end;
+
+	zbx_vector_uint64_create(&itemids);
+	zbx_vector_uint64_reserve(&itemids, (size_t)queries_num);
+
+	for (i = 0; i < queries_num; i++)
+		zbx_vector_uint64_append(&itemids, queries[i]->itemid);
+
+	zbx_vector_uint64_uniq(&itemids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	time_from = queries[0]->start;
+	zbx_recalc_time_period(&time_from, ZBX_RECALC_TIME_PERIOD_HISTORY);
+
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
+			"select itemid,clock,ns,%s"
+			" from %s"
+			" where clock>" ZBX_FS_I64,
+			table->fields, table->name, time_from);
+
+	if (ZBX_JAN_2038 != end)
+		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, " and clock<=%d", end);
+
+	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " and");
+	zbx_db_add_condition_alloc(&sql, &sql_alloc, &sql_offset, "itemid", itemids.values, itemids.values_num);
+
+	result = zbx_db_select("%s", sql);
+
+	zbx_free(sql);
+	zbx_vector_uint64_destroy(&itemids);
+
+	if (NULL == result)
+		return;
+
+	while (NULL != (row = zbx_db_fetch(result)))
+	{
+		zbx_uint64_t		itemid, *pitemid = &itemid;
+		zbx_history_query_t	**pquery;
+		zbx_history_record_t	value;
+
+		ZBX_STR2UINT64(itemid, row[0]);
+
+		if (NULL == (pquery = (zbx_history_query_t **)bsearch(&pitemid, queries, (size_t)queries_num,
+				sizeof(zbx_history_query_t *), ZBX_DEFAULT_UINT64_PTR_COMPARE_FUNC)))
+		{
+			continue;
+		}
 
-	if (0 == start)
-		return db_read_values_by_count(itemid, hist->value_type, values, count, end);
+		/* the same item might be requested more than once */
+		while (pquery > queries && (*(pquery - 1))->itemid == itemid)
+			pquery--;
 
-	return db_read_values_by_time_and_count(itemid, hist->value_type, values, end - start, count, end);
+		for (; pquery < queries + queries_num && (*pquery)->itemid == itemid; pquery++)
+		{
+			value.timestamp.sec = atoi(row[1]);
+			value.timestamp.ns = atoi(row[2]);
+			table->rtov(&value.value, row + 3);
+
+			zbx_vector_history_record_append_ptr(&(*pquery)->values, &value);
+		}
+	}
+	zbx_db_free_result(result);
+
+	for (i = 0; i < queries_num; i++)
+		queries[i]->ret = SUCCEED;
 }
 
+/************************************************************************************
+ *                                                                                  *
+ * Purpose: gets history data of multiple items from history storage               *
+ *                                                                                  *
+ * Parameters:  hist        - [IN] the history storage interface                    *
+ *              queries     - [IN/OUT] the item history read requests               *
+ *              queries_num - [IN] the number of read requests                      *
+ *                                                                                  *
+ * Comments: Requests with the same ]<start>,<end>] interval are read with one      *
+ *           query per ZBX_HISTORY_BATCH_ITEMS_MAX items instead of a query per     *
+ *           item.                                                                  *
+ *                                                                                  *
+ ************************************************************************************/
+static void	sql_get_values_batch(zbx_history_iface_t *hist, zbx_history_query_t *queries, int queries_num)
+{
+	zbx_vector_ptr_t	sorted;
+	int			i, j;
+
+	zbx_vector_ptr_create(&sorted);
+	zbx_vector_ptr_reserve(&sorted, (size_t)queries_num);
+
+	for (i = 0; i < queries_num; i++)
+	{
+		queries[i].ret = FAIL;
+		zbx_vector_ptr_append(&sorted, &queries[i]);
+	}
+
+	zbx_vector_ptr_sort(&sorted, history_query_compare_range);
+
+	for (i = 0; i < sorted.values_num; i = j)
+	{
+		const zbx_history_query_t	*first = (const zbx_history_query_t *)sorted.values[i];
+
+		for (j = i + 1; j < sorted.values_num && j - i < ZBX_HISTORY_BATCH_ITEMS_MAX; j++)
+		{
+			const zbx_history_query_t	*query = (const zbx_history_query_t *)sorted.values[j];
+
+			if (query->start != first->start || query->end != first->end)
+				break;
+		}
+
+		zbx_db_begin_replica_read(first->end);
+		db_read_values_by_time_batch(hist->value_type, (zbx_history_query_t **)sorted.values + i, j - i);
+		zbx_db_end_replica_read();
+	}
+
+	zbx_vector_ptr_destroy(&sorted);
+}
+
+#undef ZBX_HISTORY_BATCH_ITEMS_MAX
+
 /************************************************************************************
  *                                                                                  *
  * Purpose: sends history data to the storage                                       *
@@ -702,6 +867,7 @@ void	zbx_history_sql_init(zbx_history_iface_t *hist, unsigned char value_type)
 	hist->add_values = sql_add_values;
 	hist->flush = sql_flush;
 	hist->get_values = sql_get_values;
+	hist->get_values_batch = sql_get_values_batch;
 
 	switch (value_type)
 	{
@@ -32,6 +32,9 @@ extern char	*CONFIG_SSL_CA_LOCATION;
 extern char	*CONFIG_SSL_CERT_LOCATION;
 extern char	*CONFIG_SSL_KEY_LOCATION;
 
+/* DNS cache shared by all HTTP requests of the process */
+static CURLSH	*share = NULL;
+
 size_t	zbx_curl_write_cb(void *ptr, size_t size, size_t nmemb, void *userdata)
 {
 	size_t			r_size = size * nmemb;
@@ -313,58 +316,43 @@ char	*zbx_http_parse_header(char **headers)
 	return NULL;
 }
 
-int	zbx_http_get(const char *url, const char *header, long timeout, const char *ssl_cert_file,
-		const char *ssl_key_file, char **out, long *response_code, char **error)
+static int	http_get_prepare(CURL *easyhandle, const char *url, struct curl_slist *headers_slist, long timeout,
+		const char *ssl_cert_file, const char *ssl_key_file, zbx_http_response_t *header,
+		zbx_http_response_t *body, char *errbuf, char **error)
 {
-	CURL			*easyhandle;
-	CURLcode		err;
-	char			errbuf[CURL_ERROR_SIZE];
-	int			ret = FAIL;
-	struct curl_slist	*headers_slist = NULL;
-	zbx_http_response_t	body = {0}, response_header = {0};
-
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() URL '%s'", __func__, url);
-
-	*errbuf = '\0';
-
-	if (NULL == (easyhandle = curl_easy_init()))
-	{
-		*error = zbx_strdup(NULL, "Cannot initialize cURL library");
-		goto clean;
-	}
+	CURLcode	err;
 
-	if (SUCCEED != zbx_http_prepare_callbacks(easyhandle, &response_header, &body, zbx_curl_ignore_cb,
-			zbx_curl_write_cb, errbuf, error))
+	if (SUCCEED != zbx_http_prepare_callbacks(easyhandle, header, body, zbx_curl_ignore_cb, zbx_curl_write_cb,
+			errbuf, error))
 	{
-		goto clean;
+		return FAIL;
 	}
 
 	if (SUCCEED != zbx_http_prepare_ssl(easyhandle, ssl_cert_file, ssl_key_file, "", 1, 1, error))
-		goto clean;
+		return FAIL;
 
 	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_USERAGENT, "Zabbix " ZABBIX_VERSION)))
 	{
 		*error = zbx_dsprintf(NULL, "Cannot set user agent: %s", curl_easy_strerror(err));
-		goto clean;
+		return FAIL;
 	}
 
 	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_PROXY, "")))
 	{
 		*error = zbx_dsprintf(NULL, "Cannot set proxy: %s", curl_easy_strerror(err));
-		goto clean;
+		return FAIL;
 	}
 
 	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_TIMEOUT, timeout)))
 	{
 		*error = zbx_dsprintf(NULL, "Cannot specify timeout: %s", curl_easy_strerror(err));
-		goto clean;
+		return FAIL;
 	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_HTTPHEADER,
-			(headers_slist = curl_slist_append(headers_slist, header)))))
+	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_HTTPHEADER, headers_slist)))
 	{
 		*error = zbx_dsprintf(NULL, "Cannot specify headers: %s", curl_easy_strerror(err));
-		goto clean;
+		return FAIL;
 	}
 
 #if LIBCURL_VERSION_NUM >= 0x071304
@@ -372,45 +360,83 @@ int	zbx_http_get(const char *url, const char *header, long timeout, const char *
 	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_PROTOCOLS, CURLPROTO_HTTP | CURLPROTO_HTTPS)))
 	{
 		*error = zbx_dsprintf(NULL, "Cannot set allowed protocols: %s", curl_easy_strerror(err));
-		goto clean;
+		return FAIL;
 	}
 #endif
 
 	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_URL, url)))
 	{
 		*error = zbx_dsprintf(NULL, "Cannot specify URL: %s", curl_easy_strerror(err));
-		goto clean;
+		return FAIL;
 	}
 
 	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, ZBX_CURLOPT_ACCEPT_ENCODING, "")))
 	{
 		*error = zbx_dsprintf(NULL, "Cannot set cURL encoding option: %s", curl_easy_strerror(err));
-		goto clean;
+		return FAIL;
 	}
 
-	if (CURLE_OK != (err = curl_easy_perform(easyhandle)))
+	return SUCCEED;
+}
+
+static int	http_get_response(CURL *easyhandle, CURLcode result, const char *errbuf, zbx_http_response_t *body,
+		char **out, long *response_code, char **error)
+{
+	CURLcode	err;
+
+	if (CURLE_OK != result)
 	{
-		*error = zbx_dsprintf(NULL, "Cannot perform request: %s", '\0' == *errbuf ? curl_easy_strerror(err) :
-				errbuf);
-		goto clean;
+		*error = zbx_dsprintf(NULL, "Cannot perform request: %s", '\0' == *errbuf ?
+				curl_easy_strerror(result) : errbuf);
+		return FAIL;
 	}
 
 	if (CURLE_OK != (err = curl_easy_getinfo(easyhandle, CURLINFO_RESPONSE_CODE, response_code)))
 	{
 		*error = zbx_dsprintf(NULL, "Cannot get the response code: %s", curl_easy_strerror(err));
-		goto clean;
+		return FAIL;
 	}
 
-	if (NULL != body.data)
+	if (NULL != body->data)
 	{
-		*out = body.data;
-		body.data = NULL;
+		*out = body->data;
+		body->data = NULL;
 	}
-
 	else
 		*out = zbx_strdup(NULL, "");
 
-	ret = SUCCEED;
+	return SUCCEED;
+}
+
+int	zbx_http_get(const char *url, const char *header, long timeout, const char *ssl_cert_file,
+		const char *ssl_key_file, char **out, long *response_code, char **error)
+{
+	CURL			*easyhandle;
+	char			errbuf[CURL_ERROR_SIZE];
+	int			ret = FAIL;
+	struct curl_slist	*headers_slist = NULL;
+	zbx_http_response_t	body = {0}, response_header = {0};
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() URL '%s'", __func__, url);
+
+	*errbuf = '\0';
+
+	if (NULL == (easyhandle = curl_easy_init()))
+	{
+		*error = zbx_strdup(NULL, "Cannot initialize cURL library");
+		goto clean;
+	}
+
+	headers_slist = curl_slist_append(headers_slist, header);
+
+	if (SUCCEED != http_get_prepare(easyhandle, url, headers_slist, timeout, ssl_cert_file, ssl_key_file,
+			&response_header, &body, errbuf, error))
+	{
+		goto clean;
+	}
+
+	ret = http_get_response(easyhandle, curl_easy_perform(easyhandle), errbuf, &body, out, response_code,
+			error);
 clean:
 	curl_slist_free_all(headers_slist);	/* must be called after curl_easy_perform() */
 	curl_easy_cleanup(easyhandle);
@@ -421,6 +447,161 @@ clean:
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: performs multiple GET requests in parallel                        *
+ *                                                                            *
+ * Parameters: requests        - [IN/OUT] the requests                        *
+ *             requests_num    - [IN] the number of requests                  *
+ *             header          - [IN] the header sent with all requests       *
+ *             timeout         - [IN] the timeout of a single request         *
+ *             ssl_cert_file   - [IN]                                         *
+ *             ssl_key_file    - [IN]                                         *
+ *             max_connections - [IN] the maximum number of requests          *
+ *                                    performed at the same time              *
+ *                                                                            *
+ * Comments: Results are returned in the request ret, out, response_code and  *
+ *           error fields the same way as zbx_http_get() returns them.        *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_http_get_multi(zbx_http_get_request_t *requests, int requests_num, const char *header, long timeout,
+		const char *ssl_cert_file, const char *ssl_key_file, int max_connections)
+{
+	typedef struct
+	{
+		CURL			*easyhandle;
+		zbx_http_response_t	body;
+		zbx_http_response_t	header;
+		char			errbuf[CURL_ERROR_SIZE];
+		int			active;
+	}
+	zbx_http_get_handle_t;
+
+	CURLM			*multi;
+	CURLMcode		merr;
+	struct curl_slist	*headers_slist = NULL;
+	zbx_http_get_handle_t	*handles;
+	int			next = 0, active_num = 0, i;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() requests:%d", __func__, requests_num);
+
+	for (i = 0; i < requests_num; i++)
+	{
+		requests[i].ret = FAIL;
+		requests[i].out = NULL;
+		requests[i].error = NULL;
+		requests[i].response_code = 0;
+	}
+
+	handles = (zbx_http_get_handle_t *)zbx_calloc(NULL, (size_t)requests_num, sizeof(zbx_http_get_handle_t));
+
+	if (NULL == (multi = curl_multi_init()))
+	{
+		for (i = 0; i < requests_num; i++)
+			requests[i].error = zbx_strdup(NULL, "Cannot initialize cURL multi session");
+		goto out;
+	}
+
+	headers_slist = curl_slist_append(headers_slist, header);
+
+	while (next < requests_num || 0 != active_num)
+	{
+		CURLMsg	*msg;
+		int	running, msgnum;
+
+		for (; next < requests_num && active_num < max_connections; next++)
+		{
+			zbx_http_get_handle_t	*handle = &handles[next];
+
+			if (NULL == (handle->easyhandle = curl_easy_init()))
+			{
+				requests[next].error = zbx_strdup(NULL, "Cannot initialize cURL library");
+				continue;
+			}
+
+			if (SUCCEED != http_get_prepare(handle->easyhandle, requests[next].url, headers_slist, timeout,
+					ssl_cert_file, ssl_key_file, &handle->header, &handle->body, handle->errbuf,
+					&requests[next].error))
+			{
+				continue;
+			}
+
+			(void)curl_easy_setopt(handle->easyhandle, CURLOPT_PRIVATE, handle);
+
+			if (CURLM_OK != (merr = curl_multi_add_handle(multi, handle->easyhandle)))
+			{
+				requests[next].error = zbx_dsprintf(NULL, "Cannot add cURL handle: %s",
+						curl_multi_strerror(merr));
+				continue;
+			}
+
+			handle->active = 1;
+			active_num++;
+		}
+
+		if (CURLM_OK != (merr = curl_multi_perform(multi, &running)))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot perform on cURL multi handle: %s",
+					curl_multi_strerror(merr));
+			break;
+		}
+
+		while (NULL != (msg = curl_multi_info_read(multi, &msgnum)))
+		{
+			zbx_http_get_handle_t	*handle;
+			zbx_http_get_request_t	*request;
+
+			if (CURLMSG_DONE != msg->msg)
+				continue;
+
+			curl_multi_remove_handle(multi, msg->easy_handle);
+			active_num--;
+
+			if (CURLE_OK != curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char **)&handle))
+			{
+				THIS_SHOULD_NEVER_HAPPEN;
+				continue;
+			}
+
+			handle->active = 0;
+
+			request = &requests[handle - handles];
+			request->ret = http_get_response(handle->easyhandle, msg->data.result, handle->errbuf,
+					&handle->body, &request->out, &request->response_code, &request->error);
+		}
+
+		if (0 != active_num && CURLM_OK != (merr = curl_multi_wait(multi, NULL, 0, 1000, NULL)))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot wait on cURL multi handle: %s",
+					curl_multi_strerror(merr));
+			break;
+		}
+	}
+
+	for (i = 0; i < requests_num; i++)
+	{
+		if (0 != handles[i].active)
+		{
+			curl_multi_remove_handle(multi, handles[i].easyhandle);
+			requests[i].error = zbx_strdup(requests[i].error, "Cannot perform request");
+		}
+		else if (i >= next)
+			requests[i].error = zbx_strdup(requests[i].error, "Request was not performed");
+
+		if (NULL != handles[i].easyhandle)
+			curl_easy_cleanup(handles[i].easyhandle);
+
+		zbx_free(handles[i].body.data);
+	}
+
+	curl_slist_free_all(headers_slist);
+	curl_multi_cleanup(multi);
+out:
+	zbx_free(handles);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
 static const char	*zbx_request_string(int result)
 {
 	switch (result)
@@ -569,21 +750,44 @@ static void	http_output_json(unsigned char retrieve_mode, char **buffer, zbx_htt
 	zbx_json_free(&json);
 }
 
-int	zbx_http_request(unsigned char request_method, const char *url, const char *query_fields, char *headers,
-		const char *posts, unsigned char retrieve_mode, const char *http_proxy, unsigned char follow_redirects,
-		const char *timeout, int max_attempts, const char *ssl_cert_file, const char *ssl_key_file,
-		const char *ssl_key_password, unsigned char verify_peer, unsigned char verify_host,
-		unsigned char authtype, const char *username, const char *password, const char *token,
-		unsigned char post_type, char *status_codes, unsigned char output_format, char **out, char **error)
+void	zbx_http_context_create(zbx_http_context_t *context)
+{
+	memset(context, 0, sizeof(zbx_http_context_t));
+}
+
+void	zbx_http_context_destroy(zbx_http_context_t *context)
+{
+	curl_slist_free_all(context->headers_slist);	/* must be called after curl_easy_perform() */
+	curl_easy_cleanup(context->easyhandle);
+	zbx_free(context->body.data);
+	zbx_free(context->header.data);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: create and set up cURL easy handle for HTTP request               *
+ *                                                                            *
+ * Parameters: context - [IN/OUT] the HTTP request context, must be created   *
+ *                                with zbx_http_context_create() and must not *
+ *                                be moved until it is destroyed              *
+ *             ...     - [IN] the request parameters, see zbx_http_request()  *
+ *             error   - [OUT] the error message                              *
+ *                                                                            *
+ * Return value: SUCCEED - the easy handle is ready to be performed           *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_http_request_prepare(zbx_http_context_t *context, unsigned char request_method, const char *url,
+		const char *query_fields, char *headers, const char *posts, unsigned char retrieve_mode,
+		const char *http_proxy, unsigned char follow_redirects, const char *timeout, int max_attempts,
+		const char *ssl_cert_file, const char *ssl_key_file, const char *ssl_key_password,
+		unsigned char verify_peer, unsigned char verify_host, unsigned char authtype, const char *username,
+		const char *password, const char *token, unsigned char post_type, unsigned char output_format,
+		char **error)
 {
-	CURL			*easyhandle;
 	CURLcode		err;
-	char			url_buffer[ZBX_ITEM_URL_LEN_MAX], errbuf[CURL_ERROR_SIZE], *headers_ptr, *line, *buffer;
-	int			ret = NOTSUPPORTED, timeout_seconds, found = FAIL;
-	long			response_code;
-	struct curl_slist	*headers_slist = NULL;
-	struct zbx_json		json;
-	zbx_http_response_t	body = {0}, header = {0};
+	char			url_buffer[ZBX_ITEM_URL_LEN_MAX], *headers_ptr, *line;
+	int			timeout_seconds, found = FAIL;
 	zbx_curl_cb_t		curl_body_cb;
 	char			application_json[] = {"Content-Type: application/json"};
 	char			application_ndjson[] = {"Content-Type: application/x-ndjson"};
@@ -594,10 +798,14 @@ int	zbx_http_request(unsigned char request_method, const char *url, const char *
 
 	zabbix_log(LOG_LEVEL_TRACE, "message body '%s'", posts);
 
-	if (NULL == (easyhandle = curl_easy_init()))
+	context->max_attempts = max_attempts;
+	context->retrieve_mode = retrieve_mode;
+	context->output_format = output_format;
+
+	if (NULL == (context->easyhandle = curl_easy_init()))
 	{
 		*error = zbx_strdup(NULL, "Cannot initialize cURL library");;
-		goto clean;
+		return FAIL;
 	}
 
 	switch (retrieve_mode)
@@ -612,65 +820,73 @@ int	zbx_http_request(unsigned char request_method, const char *url, const char *
 		default:
 			THIS_SHOULD_NEVER_HAPPEN;
 			*error = zbx_strdup(NULL, "Invalid retrieve mode");
-			goto clean;
+			return FAIL;
 	}
 
-	if (SUCCEED != zbx_http_prepare_callbacks(easyhandle, &header, &body, zbx_curl_write_cb, curl_body_cb, errbuf,
-			error))
+	if (SUCCEED != zbx_http_prepare_callbacks(context->easyhandle, &context->header, &context->body,
+			zbx_curl_write_cb, curl_body_cb, context->errbuf, error))
 	{
-		goto clean;
+		return FAIL;
 	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_PROXY, http_proxy)))
+	if (CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_PROXY, http_proxy)))
 	{
 		*error = zbx_dsprintf(NULL, "Cannot set proxy: %s", curl_easy_strerror(err));
-		goto clean;
+		return FAIL;
+	}
+
+	/* resolved host names are reused by subsequent requests until DNS cache timeout expires */
+	if (NULL == share && NULL != (share = curl_share_init()))
+		curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+
+	if (NULL != share && CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_SHARE, share)))
+	{
+		*error = zbx_dsprintf(NULL, "Cannot set cURL share handle: %s", curl_easy_strerror(err));
+		return FAIL;
 	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_FOLLOWLOCATION,
+	if (CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_FOLLOWLOCATION,
 			0 == follow_redirects ? 0L : 1L)))
 	{
 		*error = zbx_dsprintf(NULL, "Cannot set follow redirects: %s", curl_easy_strerror(err));
-		goto clean;
+		return FAIL;
 	}
 
-	if (0 != follow_redirects &&
-			CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_MAXREDIRS, ZBX_CURLOPT_MAXREDIRS)))
+	if (0 != follow_redirects && CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_MAXREDIRS,
+			ZBX_CURLOPT_MAXREDIRS)))
 	{
 		*error = zbx_dsprintf(NULL, "Cannot set number of redirects allowed: %s", curl_easy_strerror(err));
-		goto clean;
+		return FAIL;
 	}
 
 	if (FAIL == zbx_is_time_suffix(timeout, &timeout_seconds, (int)strlen(timeout)))
 	{
 		*error = zbx_dsprintf(NULL, "Invalid timeout: %s", timeout);
-		goto clean;
+		return FAIL;
 	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_TIMEOUT, (long)timeout_seconds)))
+	if (CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_TIMEOUT, (long)timeout_seconds)))
 	{
 		*error = zbx_dsprintf(NULL, "Cannot specify timeout: %s", curl_easy_strerror(err));
-		goto clean;
+		return FAIL;
 	}
 
-	if (SUCCEED != zbx_http_prepare_ssl(easyhandle, ssl_cert_file, ssl_key_file, ssl_key_password,
+	if (SUCCEED != zbx_http_prepare_ssl(context->easyhandle, ssl_cert_file, ssl_key_file, ssl_key_password,
 			verify_peer, verify_host, error))
 	{
-		goto clean;
+		return FAIL;
 	}
 
-	if (SUCCEED != zbx_http_prepare_auth(easyhandle, authtype, username, password, token, error))
-		goto clean;
+	if (SUCCEED != zbx_http_prepare_auth(context->easyhandle, authtype, username, password, token, error))
+		return FAIL;
 
-	if (SUCCEED != http_prepare_request(easyhandle, posts, request_method, error))
-	{
-		goto clean;
-	}
+	if (SUCCEED != http_prepare_request(context->easyhandle, posts, request_method, error))
+		return FAIL;
 
 	headers_ptr = headers;
 	while (NULL != (line = zbx_http_parse_header(&headers_ptr)))
 	{
-		headers_slist = curl_slist_append(headers_slist, line);
+		context->headers_slist = curl_slist_append(context->headers_slist, line);
 
 		if (FAIL == found && 0 == strncmp(line, "Content-Type:", ZBX_CONST_STRLEN("Content-Type:")))
 			found = SUCCEED;
@@ -681,74 +897,79 @@ int	zbx_http_request(unsigned char request_method, const char *url, const char *
 	if (FAIL == found)
 	{
 		if (ZBX_POSTTYPE_JSON == post_type)
-			headers_slist = curl_slist_append(headers_slist, application_json);
+			context->headers_slist = curl_slist_append(context->headers_slist, application_json);
 		else if (ZBX_POSTTYPE_XML == post_type)
-			headers_slist = curl_slist_append(headers_slist, application_xml);
+			context->headers_slist = curl_slist_append(context->headers_slist, application_xml);
 		else if (ZBX_POSTTYPE_NDJSON == post_type)
-			headers_slist = curl_slist_append(headers_slist, application_ndjson);
+			context->headers_slist = curl_slist_append(context->headers_slist, application_ndjson);
 	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_HTTPHEADER, headers_slist)))
+	if (CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_HTTPHEADER, context->headers_slist)))
 	{
 		*error = zbx_dsprintf(NULL, "Cannot specify headers: %s", curl_easy_strerror(err));
-		goto clean;
+		return FAIL;
 	}
 
 #if LIBCURL_VERSION_NUM >= 0x071304
 	/* CURLOPT_PROTOCOLS is supported starting with version 7.19.4 (0x071304) */
 	/* CURLOPT_PROTOCOLS was deprecated in favor of CURLOPT_PROTOCOLS_STR starting with version 7.85.0 (0x075500) */
 #	if LIBCURL_VERSION_NUM >= 0x075500
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_PROTOCOLS_STR, "HTTP,HTTPS")))
+	if (CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_PROTOCOLS_STR, "HTTP,HTTPS")))
 #	else
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_PROTOCOLS, CURLPROTO_HTTP | CURLPROTO_HTTPS)))
+	if (CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_PROTOCOLS,
+			CURLPROTO_HTTP | CURLPROTO_HTTPS)))
 #	endif
 	{
 		*error = zbx_dsprintf(NULL, "Cannot set allowed protocols: %s", curl_easy_strerror(err));
-		goto clean;
+		return FAIL;
 	}
 #endif
 
 	zbx_snprintf(url_buffer, sizeof(url_buffer),"%s%s", url, query_fields);
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_URL, url_buffer)))
+	if (CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_URL, url_buffer)))
 	{
 		*error = zbx_dsprintf(NULL, "Cannot specify URL: %s", curl_easy_strerror(err));
-		goto clean;
+		return FAIL;
 	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, ZBX_CURLOPT_ACCEPT_ENCODING, "")))
+	if (CURLE_OK != (err = curl_easy_setopt(context->easyhandle, ZBX_CURLOPT_ACCEPT_ENCODING, "")))
 	{
 		*error = zbx_dsprintf(NULL, "Cannot set cURL encoding option: %s", curl_easy_strerror(err));
-		goto clean;
+		return FAIL;
 	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_COOKIEFILE, "")))
+	if (CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_COOKIEFILE, "")))
 	{
 		*error =  zbx_dsprintf(NULL, "Cannot enable cURL cookie engine: %s", curl_easy_strerror(err));
-		goto clean;
+		return FAIL;
 	}
 
-	/* try to retrieve page several times depending on number of retries */
-	do
-	{
-		*errbuf = '\0';
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 
-		if (CURLE_OK == (err = curl_easy_perform(easyhandle)))
-		{
-			break;
-		}
-		else
-		{
-			if (1 != max_attempts)
-			{
-				zabbix_log(LOG_LEVEL_INFORMATION, "cannot perform request: %s",
-						'\0' == *errbuf ? curl_easy_strerror(err) : errbuf);
-			}
-		}
+	return SUCCEED;
+}
 
-		header.offset = 0;
-		body.offset = 0;
-	}
-	while (0 < --max_attempts);
+/******************************************************************************
+ *                                                                            *
+ * Purpose: process the result of performed HTTP request                      *
+ *                                                                            *
+ * Parameters: context      - [IN/OUT] the HTTP request context               *
+ *             err          - [IN] the result of the transfer                 *
+ *             status_codes - [IN] the required status codes                  *
+ *             out          - [OUT] the response formatted according to       *
+ *                                  retrieve mode and output format           *
+ *             error        - [OUT] the error message                         *
+ *                                                                            *
+ * Return value: SUCCEED - the response was processed successfully            *
+ *               NOTSUPPORTED - otherwise                                     *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_http_handle_response(zbx_http_context_t *context, CURLcode err, char *status_codes, char **out,
+		char **error)
+{
+	long		response_code;
+	char		*headers_ptr, *line, *buffer;
+	struct zbx_json	json;
 
 	if (CURLE_OK != err)
 	{
@@ -759,60 +980,60 @@ int	zbx_http_request(unsigned char request_method, const char *url, const char *
 		else
 		{
 			*error = zbx_dsprintf(NULL, "Cannot perform request: %s",
-					'\0' == *errbuf ? curl_easy_strerror(err) : errbuf);
+					'\0' == *context->errbuf ? curl_easy_strerror(err) : context->errbuf);
 		}
-		goto clean;
+		return NOTSUPPORTED;
 	}
 
-	if (CURLE_OK != (err = curl_easy_getinfo(easyhandle, CURLINFO_RESPONSE_CODE, &response_code)))
+	if (CURLE_OK != (err = curl_easy_getinfo(context->easyhandle, CURLINFO_RESPONSE_CODE, &response_code)))
 	{
 		*error = zbx_dsprintf(NULL, "Cannot get the response code: %s", curl_easy_strerror(err));
-		goto clean;
+		return NOTSUPPORTED;
 	}
 
-	if (NULL == header.data)
+	if (NULL == context->header.data)
 	{
 		*error = zbx_dsprintf(NULL, "Server returned empty header");
-		goto clean;
+		return NOTSUPPORTED;
 	}
 
-	switch (retrieve_mode)
+	switch (context->retrieve_mode)
 	{
 		case ZBX_RETRIEVE_MODE_CONTENT:
-			if (NULL != body.data && FAIL == zbx_is_utf8(body.data))
+			if (NULL != context->body.data && FAIL == zbx_is_utf8(context->body.data))
 			{
 				*error = zbx_dsprintf(NULL, "Server returned invalid UTF-8 sequence");
-				goto clean;
+				return NOTSUPPORTED;
 			}
 
-			if (HTTP_STORE_JSON == output_format)
+			if (HTTP_STORE_JSON == context->output_format)
 			{
-				http_output_json(retrieve_mode, &buffer, &header, &body);
+				http_output_json(context->retrieve_mode, &buffer, &context->header, &context->body);
 				*out = buffer;
 			}
 			else
 			{
-				if (NULL != body.data)
+				if (NULL != context->body.data)
 				{
-					*out = body.data;
-					body.data = NULL;
+					*out = context->body.data;
+					context->body.data = NULL;
 				}
 				else
 					*out = zbx_strdup(NULL, "");
 			}
 			break;
 		case ZBX_RETRIEVE_MODE_HEADERS:
-			if (FAIL == zbx_is_utf8(header.data))
+			if (FAIL == zbx_is_utf8(context->header.data))
 			{
 				*error = zbx_dsprintf(NULL, "Server returned invalid UTF-8 sequence");
-				goto clean;
+				return NOTSUPPORTED;
 			}
 
-			if (HTTP_STORE_JSON == output_format)
+			if (HTTP_STORE_JSON == context->output_format)
 			{
 				zbx_json_init(&json, ZBX_JSON_STAT_BUF_LEN);
 				zbx_json_addobject(&json, "header");
-				headers_ptr = header.data;
+				headers_ptr = context->header.data;
 				while (NULL != (line = zbx_http_parse_header(&headers_ptr)))
 				{
 					http_add_json_header(&json, line);
@@ -823,32 +1044,33 @@ int	zbx_http_request(unsigned char request_method, const char *url, const char *
 			}
 			else
 			{
-				*out = header.data;
-				header.data = NULL;
+				*out = context->header.data;
+				context->header.data = NULL;
 			}
 			break;
 		case ZBX_RETRIEVE_MODE_BOTH:
-			if (FAIL == zbx_is_utf8(header.data) || (NULL != body.data && FAIL == zbx_is_utf8(body.data)))
+			if (FAIL == zbx_is_utf8(context->header.data) || (NULL != context->body.data &&
+					FAIL == zbx_is_utf8(context->body.data)))
 			{
 				*error = zbx_dsprintf(NULL, "Server returned invalid UTF-8 sequence");
-				goto clean;
+				return NOTSUPPORTED;
 			}
 
-			if (HTTP_STORE_JSON == output_format)
+			if (HTTP_STORE_JSON == context->output_format)
 			{
-				http_output_json(retrieve_mode, &buffer, &header, &body);
+				http_output_json(context->retrieve_mode, &buffer, &context->header, &context->body);
 				*out = buffer;
 			}
 			else
 			{
-				if (NULL != body.data)
+				if (NULL != context->body.data)
 				{
-					zbx_strncpy_alloc(&header.data, &header.allocated, &header.offset, body.data,
-							body.offset);
+					zbx_strncpy_alloc(&context->header.data, &context->header.allocated,
+							&context->header.offset, context->body.data, context->body.offset);
 				}
 
-				*out = header.data;
-				header.data = NULL;
+				*out = context->header.data;
+				context->header.data = NULL;
 			}
 			break;
 	}
@@ -857,15 +1079,61 @@ int	zbx_http_request(unsigned char request_method, const char *url, const char *
 	{
 		*error = zbx_dsprintf(NULL, "Response code \"%ld\" did not match any of the"
 				" required status codes \"%s\"", response_code, status_codes);
+		return NOTSUPPORTED;
+	}
+
+	return SUCCEED;
+}
+
+int	zbx_http_request(unsigned char request_method, const char *url, const char *query_fields, char *headers,
+		const char *posts, unsigned char retrieve_mode, const char *http_proxy, unsigned char follow_redirects,
+		const char *timeout, int max_attempts, const char *ssl_cert_file, const char *ssl_key_file,
+		const char *ssl_key_password, unsigned char verify_peer, unsigned char verify_host,
+		unsigned char authtype, const char *username, const char *password, const char *token,
+		unsigned char post_type, char *status_codes, unsigned char output_format, char **out, char **error)
+{
+	CURLcode		err;
+	int			ret = NOTSUPPORTED;
+	zbx_http_context_t	context;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	zbx_http_context_create(&context);
+
+	if (SUCCEED != zbx_http_request_prepare(&context, request_method, url, query_fields, headers, posts,
+			retrieve_mode, http_proxy, follow_redirects, timeout, max_attempts, ssl_cert_file, ssl_key_file,
+			ssl_key_password, verify_peer, verify_host, authtype, username, password, token, post_type,
+			output_format, error))
+	{
 		goto clean;
 	}
 
-	ret = SUCCEED;
+	/* try to retrieve page several times depending on number of retries */
+	do
+	{
+		*context.errbuf = '\0';
+
+		if (CURLE_OK == (err = curl_easy_perform(context.easyhandle)))
+		{
+			break;
+		}
+		else
+		{
+			if (1 != context.max_attempts)
+			{
+				zabbix_log(LOG_LEVEL_INFORMATION, "cannot perform request: %s",
+						'\0' == *context.errbuf ? curl_easy_strerror(err) : context.errbuf);
+			}
+		}
+
+		context.header.offset = 0;
+		context.body.offset = 0;
+	}
+	while (0 < --context.max_attempts);
+
+	ret = zbx_http_handle_response(&context, err, status_codes, out, error);
 clean:
-	curl_slist_free_all(headers_slist);	/* must be called after curl_easy_perform() */
-	curl_easy_cleanup(easyhandle);
-	zbx_free(body.data);
-	zbx_free(header.data);
+	zbx_http_context_destroy(&context);
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
 	return ret;
@@ -28,6 +28,7 @@
 #include "zbxip.h"
 #include "zbxthreads.h"
 #include "zbxfile.h"
+#include "zbxnix.h"
 
 static const zbx_config_icmpping_t	*config_icmpping;
 
@@ -964,6 +965,617 @@ out:
 	return ret;
 }
 
+#define ICMP_NATIVE_ECHO_REQUEST	8
+#define ICMP_NATIVE_ECHO_REPLY		0
+#ifdef HAVE_IPV6
+#	define ICMP6_NATIVE_ECHO_REQUEST	128
+#	define ICMP6_NATIVE_ECHO_REPLY		129
+#endif
+#define ICMP_NATIVE_HEADER_LEN		8
+#define ICMP_NATIVE_MAGIC		0x5a425850
+#define ICMP_NATIVE_DEFAULT_SIZE	56	/* same defaults as fping -C */
+#define ICMP_NATIVE_DEFAULT_PERIOD	1000
+#define ICMP_NATIVE_MAX_TIMEOUT		2000
+#define ICMP_NATIVE_RECV_LEN		128	/* maximum IPv4 header, ICMP header and the payload, */
+						/* the rest of the reply is not needed               */
+
+#define ICMP_REQUEST_UNSENT	0
+#define ICMP_REQUEST_PENDING	1
+#define ICMP_REQUEST_RECEIVED	2
+#define ICMP_REQUEST_LOST	3
+
+#define ICMP_SOCKET_IPV4	0
+#ifdef HAVE_IPV6
+#	define ICMP_SOCKET_IPV6	1
+#	define ICMP_SOCKET_COUNT	2
+#else
+#	define ICMP_SOCKET_COUNT	1
+#endif
+
+typedef struct
+{
+	int	fd;
+	int	family;
+	int	raw;	/* raw IPv4 sockets receive IP header, identifier of raw socket requests is not */
+			/* replaced by the kernel                                                           */
+}
+zbx_icmp_socket_t;
+
+/* payload is sent in host byte order as it is read back by the same process */
+typedef struct
+{
+	zbx_uint32_t	magic;
+	zbx_uint32_t	target;
+	zbx_uint32_t	request;
+}
+zbx_icmp_payload_t;
+
+typedef struct
+{
+	ZBX_FPING_HOST		*host;
+	struct sockaddr_storage	addr;
+	socklen_t		addrlen;
+	int			socket;
+	int			next_request;
+	int			sent_num;
+	double			next_send;
+	double			*sent;
+	unsigned char		*status;
+}
+zbx_icmp_target_t;
+
+/* requests in the order they were sent (and so in the order of their timeouts) */
+typedef struct
+{
+	int	target;
+	int	request;
+}
+zbx_icmp_request_t;
+
+static unsigned short	icmp_checksum(const unsigned char *data, size_t len)
+{
+	zbx_uint32_t	sum = 0;
+
+	for (; 1 < len; data += 2, len -= 2)
+		sum += (zbx_uint32_t)(data[0] << 8 | data[1]);
+
+	if (0 != len)
+		sum += (zbx_uint32_t)(data[0] << 8);
+
+	while (0 != (sum >> 16))
+		sum = (sum & 0xffff) + (sum >> 16);
+
+	return (unsigned short)~sum;
+}
+
+static int	icmp_addr_compare(const struct sockaddr_storage *a1, const struct sockaddr_storage *a2)
+{
+	if (a1->ss_family != a2->ss_family)
+		return FAIL;
+
+	if (AF_INET == a1->ss_family)
+	{
+		return 0 == memcmp(&((const struct sockaddr_in *)a1)->sin_addr,
+				&((const struct sockaddr_in *)a2)->sin_addr, sizeof(struct in_addr)) ? SUCCEED : FAIL;
+	}
+#ifdef HAVE_IPV6
+	if (AF_INET6 == a1->ss_family)
+	{
+		return 0 == memcmp(&((const struct sockaddr_in6 *)a1)->sin6_addr,
+				&((const struct sockaddr_in6 *)a2)->sin6_addr, sizeof(struct in6_addr)) ? SUCCEED : FAIL;
+	}
+#endif
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: open ICMP socket of the specified address family                  *
+ *                                                                            *
+ * Parameters: sock          - [OUT] opened socket                            *
+ *             family        - [IN] AF_INET or AF_INET6                       *
+ *             error         - [OUT] error string if function fails           *
+ *             max_error_len - [IN] length of error buffer                    *
+ *                                                                            *
+ * Return value: SUCCEED - socket was opened successfully                     *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Unprivileged ICMP datagram sockets are preferred, raw sockets    *
+ *           are used when the system does not allow them.                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	icmp_socket_open(zbx_icmp_socket_t *sock, int family, char *error, size_t max_error_len)
+{
+	int		protocol, flags;
+	const char	*source_ip;
+
+#ifdef HAVE_IPV6
+	protocol = (AF_INET == family ? IPPROTO_ICMP : IPPROTO_ICMPV6);
+#else
+	protocol = IPPROTO_ICMP;
+#endif
+	sock->family = family;
+	sock->raw = 0;
+
+	if (-1 == (sock->fd = socket(family, SOCK_DGRAM, protocol)))
+	{
+		if (-1 == (sock->fd = socket(family, SOCK_RAW, protocol)))
+		{
+			zbx_snprintf(error, max_error_len, "cannot create ICMP%s socket: %s",
+					AF_INET == family ? "" : "v6", zbx_strerror(errno));
+			return FAIL;
+		}
+
+		sock->raw = 1;
+	}
+
+	if (-1 == (flags = fcntl(sock->fd, F_GETFL, 0)) || -1 == fcntl(sock->fd, F_SETFL, flags | O_NONBLOCK))
+	{
+		zbx_snprintf(error, max_error_len, "cannot set ICMP socket to non-blocking mode: %s",
+				zbx_strerror(errno));
+		goto fail;
+	}
+
+	if (NULL != (source_ip = config_icmpping->get_source_ip()))
+	{
+		struct addrinfo	hints, *ai = NULL;
+		int		rc;
+
+		memset(&hints, 0, sizeof(hints));
+		hints.ai_family = family;
+		hints.ai_flags = AI_NUMERICHOST;
+
+		if (0 != (rc = getaddrinfo(source_ip, NULL, &hints, &ai)))
+		{
+			zbx_snprintf(error, max_error_len, "cannot use source IP address \"%s\": %s", source_ip,
+					gai_strerror(rc));
+			goto fail;
+		}
+
+		rc = bind(sock->fd, ai->ai_addr, ai->ai_addrlen);
+		freeaddrinfo(ai);
+
+		if (-1 == rc)
+		{
+			zbx_snprintf(error, max_error_len, "cannot bind ICMP socket to \"%s\": %s", source_ip,
+					zbx_strerror(errno));
+			goto fail;
+		}
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "opened %s ICMP%s socket", 0 == sock->raw ? "datagram" : "raw",
+			AF_INET == family ? "" : "v6");
+
+	return SUCCEED;
+fail:
+	close(sock->fd);
+	sock->fd = -1;
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: send echo request to target                                       *
+ *                                                                            *
+ * Return value: SUCCEED       - request was sent                             *
+ *               FAIL          - request cannot be sent                       *
+ *               TIMEOUT_ERROR - socket buffer is full, retry later           *
+ *                                                                            *
+ ******************************************************************************/
+static int	icmp_send(const zbx_icmp_socket_t *sock, const zbx_icmp_target_t *target, int target_idx,
+		unsigned short id, unsigned short seq, unsigned char *packet, size_t packet_len)
+{
+	zbx_icmp_payload_t	payload;
+	unsigned short		checksum;
+
+#ifdef HAVE_IPV6
+	packet[0] = (AF_INET == sock->family ? ICMP_NATIVE_ECHO_REQUEST : ICMP6_NATIVE_ECHO_REQUEST);
+#else
+	packet[0] = ICMP_NATIVE_ECHO_REQUEST;
+#endif
+	packet[1] = 0;
+	packet[2] = packet[3] = 0;
+	packet[4] = (unsigned char)(id >> 8);
+	packet[5] = (unsigned char)id;
+	packet[6] = (unsigned char)(seq >> 8);
+	packet[7] = (unsigned char)seq;
+
+	payload.magic = ICMP_NATIVE_MAGIC;
+	payload.target = (zbx_uint32_t)target_idx;
+	payload.request = (zbx_uint32_t)target->next_request;
+	memcpy(packet + ICMP_NATIVE_HEADER_LEN, &payload, sizeof(payload));
+
+	/* ICMPv6 checksum covers pseudo header and is calculated by the kernel */
+	if (AF_INET == sock->family)
+	{
+		checksum = icmp_checksum(packet, packet_len);
+		packet[2] = (unsigned char)(checksum >> 8);
+		packet[3] = (unsigned char)checksum;
+	}
+
+	if (-1 == sendto(sock->fd, packet, packet_len, 0, (const struct sockaddr *)&target->addr, target->addrlen))
+	{
+		if (EAGAIN == errno || EWOULDBLOCK == errno || ENOBUFS == errno)
+			return TIMEOUT_ERROR;
+
+		zabbix_log(LOG_LEVEL_DEBUG, "cannot send ICMP echo request to \"%s\": %s", target->host->addr,
+				zbx_strerror(errno));
+
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: read all echo replies waiting on the socket                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	icmp_recv(const zbx_icmp_socket_t *sock, int sock_idx, zbx_icmp_target_t *targets, int targets_num,
+		int requests_count, unsigned short id, unsigned char allow_redirect, unsigned char *buf,
+		size_t buf_len)
+{
+	struct sockaddr_storage	from;
+	socklen_t		from_len;
+	ssize_t			n;
+	unsigned char		*p, reply_type;
+	zbx_icmp_payload_t	payload;
+	zbx_icmp_target_t	*target;
+	double			sec;
+
+#ifdef HAVE_IPV6
+	reply_type = (AF_INET == sock->family ? ICMP_NATIVE_ECHO_REPLY : ICMP6_NATIVE_ECHO_REPLY);
+#else
+	reply_type = ICMP_NATIVE_ECHO_REPLY;
+#endif
+
+	while (1)
+	{
+		from_len = sizeof(from);
+
+		if (-1 == (n = recvfrom(sock->fd, buf, buf_len, 0, (struct sockaddr *)&from, &from_len)))
+			break;
+
+		sec = zbx_time();
+		p = buf;
+
+		if (AF_INET == sock->family && 0 != sock->raw)
+		{
+			size_t	ip_header_len;
+
+			if (1 > n || (ssize_t)(ip_header_len = (size_t)(buf[0] & 0x0f) * 4) > n)
+				continue;
+
+			p += ip_header_len;
+			n -= (ssize_t)ip_header_len;
+		}
+
+		if ((ssize_t)(ICMP_NATIVE_HEADER_LEN + sizeof(payload)) > n || reply_type != p[0])
+			continue;
+
+		/* datagram sockets receive only replies to their own requests */
+		if (0 != sock->raw && id != (unsigned short)(p[4] << 8 | p[5]))
+			continue;
+
+		memcpy(&payload, p + ICMP_NATIVE_HEADER_LEN, sizeof(payload));
+
+		if (ICMP_NATIVE_MAGIC != payload.magic || (zbx_uint32_t)targets_num <= payload.target ||
+				(zbx_uint32_t)requests_count <= payload.request)
+		{
+			continue;
+		}
+
+		target = &targets[payload.target];
+
+		if (sock_idx != target->socket || ICMP_REQUEST_PENDING != target->status[payload.request])
+			continue;
+
+		if (SUCCEED != icmp_addr_compare(&from, &target->addr))
+		{
+			/* the same as the redirected response reported by fping */
+			if (0 == allow_redirect)
+			{
+				zabbix_log(LOG_LEVEL_DEBUG, "treating redirected response as target host down: \"%s\"",
+						target->host->addr);
+				continue;
+			}
+		}
+
+		target->status[payload.request] = ICMP_REQUEST_RECEIVED;
+		sec -= target->sent[payload.request];
+
+		if (0 == target->host->rcv || target->host->min > sec)
+			target->host->min = sec;
+		if (0 == target->host->rcv || target->host->max < sec)
+			target->host->max = sec;
+		target->host->sum += sec;
+		target->host->rcv++;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: resolve target host address                                       *
+ *                                                                            *
+ ******************************************************************************/
+static int	icmp_target_resolve(zbx_icmp_target_t *target)
+{
+	struct addrinfo	hints, *ai = NULL;
+	int		rc;
+
+	memset(&hints, 0, sizeof(hints));
+#ifdef HAVE_IPV6
+	hints.ai_family = PF_UNSPEC;
+#else
+	hints.ai_family = PF_INET;
+#endif
+	hints.ai_socktype = SOCK_RAW;
+
+	if (0 != (rc = getaddrinfo(target->host->addr, NULL, &hints, &ai)))
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "cannot resolve \"%s\": %s", target->host->addr, gai_strerror(rc));
+		return FAIL;
+	}
+
+	memcpy(&target->addr, ai->ai_addr, ai->ai_addrlen);
+	target->addrlen = ai->ai_addrlen;
+#ifdef HAVE_IPV6
+	target->socket = (AF_INET == ai->ai_family ? ICMP_SOCKET_IPV4 : ICMP_SOCKET_IPV6);
+#else
+	target->socket = ICMP_SOCKET_IPV4;
+#endif
+	freeaddrinfo(ai);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: ping hosts using ICMP sockets                                     *
+ *                                                                            *
+ * Parameters: hosts          - [IN/OUT] list of target hosts                 *
+ *             hosts_count    - [IN] number of target hosts                   *
+ *             requests_count - [IN] number of pings to send to each target   *
+ *             interval       - [IN] interval between ping packets to one     *
+ *                                   target, in milliseconds                  *
+ *             size           - [IN] amount of ping data to send, in bytes    *
+ *             timeout        - [IN] timeout of individual ping, in           *
+ *                                   milliseconds                             *
+ *             allow_redirect - [IN] treat redirected response as host up:    *
+ *                                   0 - no, 1 - yes                          *
+ *             error          - [OUT] error string if function fails          *
+ *             max_error_len  - [IN] length of error buffer                   *
+ *                                                                            *
+ * Return value: SUCCEED      - successfully processed hosts                  *
+ *               NOTSUPPORTED - ICMP sockets cannot be used                   *
+ *               FAIL         - pinging was interrupted by shutdown           *
+ *                                                                            *
+ * Comments: Requests to all targets are in flight at the same time, the      *
+ *           requests to one target are sent every interval milliseconds.     *
+ *           Defaults of the optional parameters and the resulting            *
+ *           statistics are the same as with fping -C.                        *
+ *                                                                            *
+ ******************************************************************************/
+static int	hosts_ping_native(ZBX_FPING_HOST *hosts, int hosts_count, int requests_count, int interval,
+		int size, int timeout, unsigned char allow_redirect, char *error, size_t max_error_len)
+{
+	zbx_icmp_socket_t	sockets[ICMP_SOCKET_COUNT];
+	zbx_icmp_target_t	*targets;
+	zbx_icmp_request_t	*requests;
+	zbx_pollfd_t		pds[ICMP_SOCKET_COUNT];
+	int			i, *queue, queue_head = 0, queue_num = 0, requests_head = 0, requests_num = 0,
+				sent_num = 0, ret = NOTSUPPORTED, socket_failed = 0;
+	unsigned short		id, seq = 0;
+	unsigned char		*packet, buf[ICMP_NATIVE_RECV_LEN];
+	size_t			packet_len;
+	double			sec, period, wait;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() hosts_count:%d", __func__, hosts_count);
+
+	*error = '\0';
+
+	period = (0 != interval ? interval : ICMP_NATIVE_DEFAULT_PERIOD) / 1000.0;
+	wait = (0 != timeout ? timeout : MIN(period * 1000, ICMP_NATIVE_MAX_TIMEOUT)) / 1000.0;
+
+	packet_len = ICMP_NATIVE_HEADER_LEN + (size_t)(0 != size ? size : ICMP_NATIVE_DEFAULT_SIZE);
+	if (ICMP_NATIVE_HEADER_LEN + sizeof(zbx_icmp_payload_t) > packet_len)
+		packet_len = ICMP_NATIVE_HEADER_LEN + sizeof(zbx_icmp_payload_t);
+
+	packet = (unsigned char *)zbx_malloc(NULL, packet_len);
+	memset(packet, 0, packet_len);
+
+	for (i = 0; i < ICMP_SOCKET_COUNT; i++)
+		sockets[i].fd = -1;
+
+	id = (unsigned short)getpid();
+
+	targets = (zbx_icmp_target_t *)zbx_malloc(NULL, sizeof(zbx_icmp_target_t) * (size_t)hosts_count);
+	queue = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)hosts_count);
+	requests = (zbx_icmp_request_t *)zbx_malloc(NULL, sizeof(zbx_icmp_request_t) * (size_t)hosts_count *
+			(size_t)requests_count);
+
+	sec = zbx_time();
+
+	for (i = 0; i < hosts_count; i++)
+	{
+		zbx_icmp_target_t	*target = &targets[i];
+
+		target->host = &hosts[i];
+		target->next_request = 0;
+		target->sent_num = 0;
+		target->next_send = sec;
+		target->sent = (double *)zbx_malloc(NULL, sizeof(double) * (size_t)requests_count);
+		target->status = (unsigned char *)zbx_malloc(NULL, (size_t)requests_count);
+		memset(target->status, ICMP_REQUEST_UNSENT, (size_t)requests_count);
+
+		if (SUCCEED != icmp_target_resolve(target))
+			continue;
+
+		if (-1 == sockets[target->socket].fd && 0 == (socket_failed & (1 << target->socket)))
+		{
+			if (SUCCEED != icmp_socket_open(&sockets[target->socket], target->addr.ss_family, error,
+					max_error_len))
+			{
+				zabbix_log(LOG_LEVEL_DEBUG, "%s", error);
+				socket_failed |= 1 << target->socket;
+			}
+		}
+
+		if (-1 == sockets[target->socket].fd)
+			continue;
+
+		queue[queue_num++] = i;
+	}
+
+	while (1)
+	{
+		int	nfds = 0, blocked = 0, timeout_ms;
+		double	next = -1;
+
+		if (!ZBX_IS_RUNNING())
+		{
+			ret = FAIL;
+			goto out;
+		}
+
+		sec = zbx_time();
+
+		/* targets are queued in the order of their next requests */
+		while (0 != queue_num && targets[queue[queue_head]].next_send <= sec)
+		{
+			int			idx = queue[queue_head], rc;
+			zbx_icmp_target_t	*target = &targets[idx];
+
+			if (TIMEOUT_ERROR == (rc = icmp_send(&sockets[target->socket], target, idx, id, seq, packet,
+					packet_len)))
+			{
+				blocked = 1;
+				break;
+			}
+
+			seq++;
+
+			if (SUCCEED == rc)
+			{
+				target->sent[target->next_request] = sec;
+				target->status[target->next_request] = ICMP_REQUEST_PENDING;
+				target->sent_num++;
+				requests[requests_num].target = idx;
+				requests[requests_num].request = target->next_request;
+				requests_num++;
+				sent_num++;
+			}
+			else
+				target->status[target->next_request] = ICMP_REQUEST_LOST;
+
+			queue_head = (queue_head + 1) % hosts_count;
+			queue_num--;
+
+			if (++target->next_request < requests_count)
+			{
+				target->next_send = sec + period;
+				queue[(queue_head + queue_num) % hosts_count] = idx;
+				queue_num++;
+			}
+		}
+
+		/* requests time out in the order they were sent */
+		for (; requests_head < requests_num; requests_head++)
+		{
+			zbx_icmp_request_t	*request = &requests[requests_head];
+			zbx_icmp_target_t	*target = &targets[request->target];
+
+			if (ICMP_REQUEST_PENDING != target->status[request->request])
+				continue;
+
+			if (target->sent[request->request] + wait > sec)
+			{
+				next = target->sent[request->request] + wait;
+				break;
+			}
+
+			target->status[request->request] = ICMP_REQUEST_LOST;
+		}
+
+		if (0 == queue_num && requests_head == requests_num)
+			break;
+
+		if (0 != blocked)
+			next = sec + 0.001;
+		else if (0 != queue_num && (-1 == next || targets[queue[queue_head]].next_send < next))
+			next = targets[queue[queue_head]].next_send;
+
+		timeout_ms = (int)((next - sec) * 1000) + 1;
+
+		for (i = 0; i < ICMP_SOCKET_COUNT; i++)
+		{
+			if (-1 == sockets[i].fd)
+				continue;
+
+			pds[nfds].fd = sockets[i].fd;
+			pds[nfds].events = POLLIN;
+			pds[nfds].revents = 0;
+			nfds++;
+		}
+
+		if (-1 == zbx_socket_poll(pds, (unsigned long)nfds, timeout_ms))
+		{
+			if (EINTR == errno && SUCCEED != zbx_alarm_timed_out())
+				continue;
+
+			zbx_snprintf(error, max_error_len, "cannot wait for ICMP replies: %s", zbx_strerror(errno));
+			goto out;
+		}
+
+		for (i = 0, nfds = 0; i < ICMP_SOCKET_COUNT; i++)
+		{
+			if (-1 == sockets[i].fd)
+				continue;
+
+			if (0 != (pds[nfds++].revents & POLLIN))
+			{
+				icmp_recv(&sockets[i], i, targets, hosts_count, requests_count, id, allow_redirect, buf,
+						sizeof(buf));
+			}
+		}
+	}
+
+	for (i = 0; i < hosts_count; i++)
+	{
+		if (0 != targets[i].sent_num)
+			hosts[i].cnt += requests_count;
+	}
+
+	/* report socket errors only when no host could be pinged at all */
+	if (0 == sent_num && 0 != socket_failed)
+		goto out;
+
+	ret = SUCCEED;
+out:
+	for (i = 0; i < ICMP_SOCKET_COUNT; i++)
+	{
+		if (-1 != sockets[i].fd)
+			close(sockets[i].fd);
+	}
+
+	for (i = 0; i < hosts_count; i++)
+	{
+		zbx_free(targets[i].sent);
+		zbx_free(targets[i].status);
+	}
+
+	zbx_free(requests);
+	zbx_free(queue);
+	zbx_free(targets);
+	zbx_free(packet);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s sent:%d", __func__, zbx_result_string(ret), sent_num);
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: initialize library                                                *
@@ -1001,6 +1613,7 @@ void	zbx_init_library_icmpping(const zbx_config_icmpping_t *config)
  *               NOTSUPPORTED - otherwise                                     *
  *                                                                            *
  * Comments: use external binary 'fping' to avoid superuser privileges        *
+ *           unless native ICMP sockets are enabled in configuration          *
  *                                                                            *
  ******************************************************************************/
 int	zbx_ping(ZBX_FPING_HOST *hosts, int hosts_count, int requests_count, int period, int size, int timeout,
@@ -1010,8 +1623,18 @@ int	zbx_ping(ZBX_FPING_HOST *hosts, int hosts_count, int requests_count, int per
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() hosts_count:%d", __func__, hosts_count);
 
-	if (NOTSUPPORTED == (ret = hosts_ping(hosts, hosts_count, requests_count, period, size, timeout,
-			allow_redirect, error, max_error_len)))
+	if (1 == config_icmpping->get_native_icmpping())
+	{
+		ret = hosts_ping_native(hosts, hosts_count, requests_count, period, size, timeout, allow_redirect,
+				error, max_error_len);
+	}
+	else
+	{
+		ret = hosts_ping(hosts, hosts_count, requests_count, period, size, timeout, allow_redirect, error,
+				max_error_len);
+	}
+
+	if (NOTSUPPORTED == ret)
 	{
 		zabbix_log(LOG_LEVEL_ERR, "%s", error);
 	}
@@ -16,6 +16,10 @@
 
 #define ZBX_IPC_DATA_DUMP_SIZE		128
 
+/* limits of coalesced outgoing messages, see zbx_ipc_socket_write_batch() */
+#define ZBX_IPC_BATCH_SIZE_MAX		(256 * ZBX_KIBIBYTE)
+#define ZBX_IPC_BATCH_DELAY_MAX		0.001
+
 static char	ipc_path[ZBX_IPC_PATH_MAX] = {0};
 static size_t	ipc_path_root_len = 0;
 
@@ -189,6 +193,66 @@ static int	ipc_write_data(int fd, const unsigned char *data, zbx_uint32_t size,
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: writes data vector to a socket                                    *
+ *                                                                            *
+ * Parameters: fd        - [IN] the socket file descriptor                    *
+ *             iov       - [IN/OUT] the data vector, on partial write it is   *
+ *                                  updated to point at the unsent data       *
+ *             iovcnt    - [IN] the number of data vector elements            *
+ *             size_sent - [OUT] the actual size written to socket            *
+ *                                                                            *
+ * Return value: SUCCEED - no socket errors were detected. Either the data or *
+ *                         a part of it was written to socket or a write to   *
+ *                         non-blocking socket would block                    *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Message header and data are written with a single system call    *
+ *           without copying them into intermediate buffer.                   *
+ *                                                                            *
+ ******************************************************************************/
+static int	ipc_writev_data(int fd, struct iovec *iov, int iovcnt, zbx_uint32_t *size_sent)
+{
+	int	ret = SUCCEED;
+	ssize_t	n;
+
+	*size_sent = 0;
+
+	while (0 < iovcnt)
+	{
+		if (-1 == (n = writev(fd, iov, iovcnt)))
+		{
+			if (EINTR == errno)
+				continue;
+
+			if (EWOULDBLOCK == errno || EAGAIN == errno)
+				break;
+
+			zabbix_log(LOG_LEVEL_WARNING, "cannot write to IPC socket: %s", strerror(errno));
+			ret = FAIL;
+			break;
+		}
+
+		*size_sent += (zbx_uint32_t)n;
+
+		while (0 < iovcnt && (size_t)n >= iov->iov_len)
+		{
+			n -= (ssize_t)iov->iov_len;
+			iov++;
+			iovcnt--;
+		}
+
+		if (0 < iovcnt)
+		{
+			iov->iov_base = (unsigned char *)iov->iov_base + n;
+			iov->iov_len -= (size_t)n;
+		}
+	}
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: reads data from a socket                                          *
@@ -295,31 +359,68 @@ out:
 static int	ipc_socket_write_message(zbx_ipc_socket_t *csocket, zbx_uint32_t code, const unsigned char *data,
 		zbx_uint32_t size, zbx_uint32_t *tx_size)
 {
-	int		ret;
-	zbx_uint32_t	size_data, buffer[ZBX_IPC_SOCKET_BUFFER_SIZE / sizeof(zbx_uint32_t)];
+	zbx_uint32_t	header[2];
+	struct iovec	iov[2];
+
+	header[ZBX_IPC_MESSAGE_CODE] = code;
+	header[ZBX_IPC_MESSAGE_SIZE] = size;
+
+	iov[0].iov_base = header;
+	iov[0].iov_len = ZBX_IPC_HEADER_SIZE;
+	iov[1].iov_base = (void *)data;
+	iov[1].iov_len = size;
 
-	buffer[0] = code;
-	buffer[1] = size;
+	return ipc_writev_data(csocket->fd, iov, 0 != size ? 2 : 1, tx_size);
+}
 
-	if (ZBX_IPC_SOCKET_BUFFER_SIZE - ZBX_IPC_HEADER_SIZE >= size)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: writes coalesced messages and optionally one more message to      *
+ *          socket                                                            *
+ *                                                                            *
+ * Parameters: csocket - [IN] the IPC socket                                  *
+ *             header  - [IN] the header of message to write after coalesced  *
+ *                            messages (can be NULL)                          *
+ *             data    - [IN] the data of message to write after coalesced    *
+ *                            messages                                        *
+ *                                                                            *
+ * Return value: SUCCEED - the data was successfully written                  *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Coalesced messages are discarded also if the write fails. Only   *
+ *           blocking sockets can have coalesced messages.                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	ipc_socket_write_batch(zbx_ipc_socket_t *csocket, const zbx_uint32_t *header,
+		const unsigned char *data)
+{
+	struct iovec	iov[3];
+	int		iovcnt = 0;
+	zbx_uint32_t	size = csocket->tx_batch_size, size_sent;
+
+	iov[iovcnt].iov_base = csocket->tx_batch;
+	iov[iovcnt++].iov_len = csocket->tx_batch_size;
+
+	if (NULL != header)
 	{
-		if (0 != size)
-			memcpy(buffer + 2, data, size);
+		iov[iovcnt].iov_base = (void *)header;
+		iov[iovcnt++].iov_len = ZBX_IPC_HEADER_SIZE;
+		size += ZBX_IPC_HEADER_SIZE;
 
-		return ipc_write_data(csocket->fd, (unsigned char *)buffer, size + ZBX_IPC_HEADER_SIZE, tx_size);
+		if (0 != header[ZBX_IPC_MESSAGE_SIZE])
+		{
+			iov[iovcnt].iov_base = (void *)data;
+			iov[iovcnt++].iov_len = header[ZBX_IPC_MESSAGE_SIZE];
+			size += header[ZBX_IPC_MESSAGE_SIZE];
+		}
 	}
 
-	if (FAIL == ipc_write_data(csocket->fd, (unsigned char *)buffer, ZBX_IPC_HEADER_SIZE, tx_size))
-		return FAIL;
+	csocket->tx_batch_size = 0;
 
-	/* in the case of non-blocking sockets only a part of the header might be sent */
-	if (ZBX_IPC_HEADER_SIZE != *tx_size)
-		return SUCCEED;
-
-	ret = ipc_write_data(csocket->fd, data, size, &size_data);
-	*tx_size += size_data;
+	if (SUCCEED != ipc_writev_data(csocket->fd, iov, iovcnt, &size_sent) || size != size_sent)
+		return FAIL;
 
-	return ret;
+	return SUCCEED;
 }
 
 /******************************************************************************
@@ -630,15 +731,18 @@ static int	ipc_client_write(zbx_ipc_client_t *client)
 	if (data_size < client->tx_bytes)
 	{
 		zbx_uint32_t	size, offset;
+		struct iovec	iov[2];
 
 		size = client->tx_bytes - data_size;
 		offset = ZBX_IPC_HEADER_SIZE - size;
 
-		if (SUCCEED != ipc_write_data(client->csocket.fd, (unsigned char *)client->tx_header + offset, size,
-				&write_size))
-		{
+		iov[0].iov_base = (unsigned char *)client->tx_header + offset;
+		iov[0].iov_len = size;
+		iov[1].iov_base = client->tx_data;
+		iov[1].iov_len = data_size;
+
+		if (SUCCEED != ipc_writev_data(client->csocket.fd, iov, 0 != data_size ? 2 : 1, &write_size))
 			return FAIL;
-		}
 
 		client->tx_bytes -= write_size;
 
@@ -743,6 +847,9 @@ static void	ipc_service_add_client(zbx_ipc_service_t *service, int fd)
 	client->csocket.fd = fd;
 	client->csocket.rx_buffer_bytes = 0;
 	client->csocket.rx_buffer_offset = 0;
+	client->csocket.tx_batch = NULL;
+	client->csocket.tx_batch_size = 0;
+	client->csocket.tx_batch_alloc = 0;
 	client->id = next_clientid++;
 	client->state = ZBX_IPC_CLIENT_STATE_NONE;
 	client->refcount = 1;
@@ -1093,6 +1200,10 @@ int	zbx_ipc_socket_open(zbx_ipc_socket_t *csocket, const char *service_name, int
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
+	csocket->tx_batch = NULL;
+	csocket->tx_batch_size = 0;
+	csocket->tx_batch_alloc = 0;
+
 	if (NULL == (socket_path = ipc_make_path(service_name, error)))
 		goto out;
 
@@ -1143,10 +1254,17 @@ void	zbx_ipc_socket_close(zbx_ipc_socket_t *csocket)
 
 	if (-1 != csocket->fd)
 	{
+		if (0 != csocket->tx_batch_size)
+			(void)zbx_ipc_socket_flush(csocket);
+
 		close(csocket->fd);
 		csocket->fd = -1;
 	}
 
+	zbx_free(csocket->tx_batch);
+	csocket->tx_batch_size = 0;
+	csocket->tx_batch_alloc = 0;
+
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
@@ -1166,11 +1284,18 @@ void	zbx_ipc_socket_close(zbx_ipc_socket_t *csocket)
 int	zbx_ipc_socket_write(zbx_ipc_socket_t *csocket, zbx_uint32_t code, const unsigned char *data, zbx_uint32_t size)
 {
 	int		ret;
-	zbx_uint32_t	size_sent;
+	zbx_uint32_t	size_sent, header[2];
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	if (SUCCEED == ipc_socket_write_message(csocket, code, data, size, &size_sent) &&
+	if (0 != csocket->tx_batch_size)
+	{
+		/* send the coalesced messages first to keep the message order */
+		header[ZBX_IPC_MESSAGE_CODE] = code;
+		header[ZBX_IPC_MESSAGE_SIZE] = size;
+		ret = ipc_socket_write_batch(csocket, header, data);
+	}
+	else if (SUCCEED == ipc_socket_write_message(csocket, code, data, size, &size_sent) &&
 			size_sent == size + ZBX_IPC_HEADER_SIZE)
 	{
 		ret = SUCCEED;
@@ -1183,6 +1308,95 @@ int	zbx_ipc_socket_write(zbx_ipc_socket_t *csocket, zbx_uint32_t code, const uns
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: coalesces a message with other messages to be sent to IPC service *
+ *                                                                            *
+ * Parameters: csocket - [IN] an opened IPC socket to the service             *
+ *             code    - [IN] the message code                                *
+ *             data    - [IN] the data                                        *
+ *             size    - [IN] the data size                                   *
+ *                                                                            *
+ * Return value: SUCCEED - the message was successfully coalesced or written  *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: The coalesced messages are written with a single system call     *
+ *           when their total size reaches ZBX_IPC_BATCH_SIZE_MAX, when the   *
+ *           oldest message has waited for more than ZBX_IPC_BATCH_DELAY_MAX  *
+ *           seconds, or with the next zbx_ipc_socket_write(),                *
+ *           zbx_ipc_socket_read(), zbx_ipc_socket_flush() or                 *
+ *           zbx_ipc_socket_close() call. The delay is checked only when      *
+ *           messages are added, so callers must flush the socket once they   *
+ *           are done with the current batch of messages.                     *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_ipc_socket_write_batch(zbx_ipc_socket_t *csocket, zbx_uint32_t code, const unsigned char *data,
+		zbx_uint32_t size)
+{
+	zbx_uint32_t	header[2], batch_size;
+
+	if (ZBX_IPC_BATCH_SIZE_MAX - ZBX_IPC_HEADER_SIZE < size)
+		return zbx_ipc_socket_write(csocket, code, data, size);
+
+	batch_size = csocket->tx_batch_size + ZBX_IPC_HEADER_SIZE + size;
+
+	if (ZBX_IPC_BATCH_SIZE_MAX < batch_size)
+	{
+		if (FAIL == zbx_ipc_socket_flush(csocket))
+			return FAIL;
+
+		batch_size = ZBX_IPC_HEADER_SIZE + size;
+	}
+
+	if (batch_size > csocket->tx_batch_alloc)
+	{
+		zbx_uint32_t	alloc = (0 == csocket->tx_batch_alloc ? ZBX_IPC_SOCKET_BUFFER_SIZE * 4 :
+				csocket->tx_batch_alloc);
+
+		while (batch_size > alloc)
+			alloc *= 2;
+
+		csocket->tx_batch = (unsigned char *)zbx_realloc(csocket->tx_batch, alloc);
+		csocket->tx_batch_alloc = alloc;
+	}
+
+	if (0 == csocket->tx_batch_size)
+		csocket->tx_batch_time = zbx_time();
+
+	header[ZBX_IPC_MESSAGE_CODE] = code;
+	header[ZBX_IPC_MESSAGE_SIZE] = size;
+	memcpy(csocket->tx_batch + csocket->tx_batch_size, header, ZBX_IPC_HEADER_SIZE);
+
+	if (0 != size)
+		memcpy(csocket->tx_batch + csocket->tx_batch_size + ZBX_IPC_HEADER_SIZE, data, size);
+
+	csocket->tx_batch_size = batch_size;
+
+	if (ZBX_IPC_BATCH_DELAY_MAX <= zbx_time() - csocket->tx_batch_time)
+		return zbx_ipc_socket_flush(csocket);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: writes coalesced messages to IPC service                          *
+ *                                                                            *
+ * Parameters: csocket - [IN] an opened IPC socket to the service             *
+ *                                                                            *
+ * Return value: SUCCEED - the messages were successfully written or there    *
+ *                         were no coalesced messages                         *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_ipc_socket_flush(zbx_ipc_socket_t *csocket)
+{
+	if (0 == csocket->tx_batch_size)
+		return SUCCEED;
+
+	return ipc_socket_write_batch(csocket, NULL, NULL);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: reads a message from IPC service                                  *
@@ -1205,6 +1419,10 @@ int	zbx_ipc_socket_read(zbx_ipc_socket_t *csocket, zbx_ipc_message_t *message)
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
+	/* the response might depend on the coalesced messages */
+	if (SUCCEED != zbx_ipc_socket_flush(csocket))
+		goto out;
+
 	if (SUCCEED != ipc_socket_read_message(csocket, header, &data, &rx_bytes))
 		goto out;
 
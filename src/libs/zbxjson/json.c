@@ -158,15 +158,80 @@ void	zbx_json_free(struct zbx_json *j)
 		zbx_free(j->buffer);
 }
 
+/* SWAR (SIMD within a register) constants used to scan 8 string bytes at once */
+#define ZBX_JSON_SWAR_ONES	__UINT64_C(0x0101010101010101)
+#define ZBX_JSON_SWAR_HIGHS	__UINT64_C(0x8080808080808080)
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if character must be escaped in JSON string                *
+ *                                                                            *
+ ******************************************************************************/
+static int	zbx_json_char_needs_escape(unsigned char c)
+{
+	/* RFC 8259 requires escaping quotation mark, reverse solidus and control characters U+0000 - U+001F */
+	return 0x1f >= c || '"' == c || '\\' == c;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: finds the length of string prefix that does not need escaping     *
+ *                                                                            *
+ * Parameters: str - [IN] the string                                          *
+ *             len - [IN] the string length                                   *
+ *                                                                            *
+ * Return value: the number of leading characters that can be copied as is    *
+ *                                                                            *
+ * Comments: The string is scanned by 8 byte words, checking all bytes of a   *
+ *           word for control characters, quotation marks and reverse         *
+ *           solidus at once. The checks can report false positives only in   *
+ *           words that contain a matching byte, so the exact position is     *
+ *           found by checking the remaining bytes one by one.                *
+ *                                                                            *
+ ******************************************************************************/
+static size_t	zbx_json_escape_span(const char *str, size_t len)
+{
+	size_t	pos;
+
+	for (pos = 0; pos + sizeof(zbx_uint64_t) <= len; pos += sizeof(zbx_uint64_t))
+	{
+		zbx_uint64_t	v, quote, backslash, mask;
+
+		memcpy(&v, str + pos, sizeof(v));
+
+		quote = v ^ (ZBX_JSON_SWAR_ONES * '"');
+		backslash = v ^ (ZBX_JSON_SWAR_ONES * '\\');
+
+		mask = ((v - ZBX_JSON_SWAR_ONES * 0x20) & ~v) |
+				((quote - ZBX_JSON_SWAR_ONES) & ~quote) |
+				((backslash - ZBX_JSON_SWAR_ONES) & ~backslash);
+
+		if (0 != (mask & ZBX_JSON_SWAR_HIGHS))
+			break;
+	}
+
+	for (; pos < len; pos++)
+	{
+		if (0 != zbx_json_char_needs_escape((unsigned char)str[pos]))
+			break;
+	}
+
+	return pos;
+}
+
+#undef ZBX_JSON_SWAR_ONES
+#undef ZBX_JSON_SWAR_HIGHS
+
 static size_t	__zbx_json_stringsize(const char *string, zbx_json_type_t type)
 {
-	size_t		len = 0;
-	const char	*sptr;
-	char		buffer[] = {"null"};
+	const char	*sptr = (NULL != string ? string : "null");
+	size_t		len, size, pos = 0;
+
+	size = len = strlen(sptr);
 
-	for (sptr = (NULL != string ? string : buffer); '\0' != *sptr; sptr++)
+	while ((pos += zbx_json_escape_span(sptr + pos, len - pos)) < len)
 	{
-		switch (*sptr)
+		switch (sptr[pos++])
 		{
 			case '"':  /* quotation mark */
 			case '\\': /* reverse solidus */
@@ -177,21 +242,18 @@ static size_t	__zbx_json_stringsize(const char *string, zbx_json_type_t type)
 			case '\n': /* newline */
 			case '\r': /* carriage return */
 			case '\t': /* horizontal tab */
-				len += 2;
+				size += 1;
 				break;
 			default:
-				/* RFC 8259 requires escaping control characters U+0000 - U+001F */
-				if (0x1f >= (unsigned char)*sptr)
-					len += 6;
-				else
-					len++;
+				/* other control characters are escaped as \u00XX */
+				size += 5;
 		}
 	}
 
 	if (NULL != string && ZBX_JSON_TYPE_STRING == type)
-		len += 2; /* "" */
+		size += 2; /* "" */
 
-	return len;
+	return size;
 }
 
 /******************************************************************************
@@ -215,15 +277,29 @@ static char	zbx_num2hex(unsigned char c)
 
 static char	*__zbx_json_insstring(char *p, const char *string, zbx_json_type_t type)
 {
-	const char	*sptr;
-	char		buffer[] = {"null"};
+	const char	*sptr = (NULL != string ? string : "null");
+	size_t		len, pos = 0;
 
 	if (NULL != string && ZBX_JSON_TYPE_STRING == type)
 		*p++ = '"';
 
-	for (sptr = (NULL != string ? string : buffer); '\0' != *sptr; sptr++)
+	len = strlen(sptr);
+
+	while (pos < len)
 	{
-		switch (*sptr)
+		size_t	span;
+
+		/* copy characters that do not need escaping at once */
+		if (0 != (span = zbx_json_escape_span(sptr + pos, len - pos)))
+		{
+			memcpy(p, sptr + pos, span);
+			p += span;
+
+			if (len == (pos += span))
+				break;
+		}
+
+		switch (sptr[pos])
 		{
 			case '"':		/* quotation mark */
 				*p++ = '\\';
@@ -257,18 +333,15 @@ static char	*__zbx_json_insstring(char *p, const char *string, zbx_json_type_t t
 				break;
 			default:
 				/* RFC 8259 requires escaping control characters U+0000 - U+001F */
-				if (0x1f >= (unsigned char)*sptr)
-				{
-					*p++ = '\\';
-					*p++ = 'u';
-					*p++ = '0';
-					*p++ = '0';
-					*p++ = zbx_num2hex((((unsigned char)*sptr) >> 4) & 0xf);
-					*p++ = zbx_num2hex(((unsigned char)*sptr) & 0xf);
-				}
-				else
-					*p++ = *sptr;
+				*p++ = '\\';
+				*p++ = 'u';
+				*p++ = '0';
+				*p++ = '0';
+				*p++ = zbx_num2hex((((unsigned char)sptr[pos]) >> 4) & 0xf);
+				*p++ = zbx_num2hex(((unsigned char)sptr[pos]) & 0xf);
 		}
+
+		pos++;
 	}
 
 	if (NULL != string && ZBX_JSON_TYPE_STRING == type)
@@ -553,6 +626,9 @@ static const char	*__zbx_json_rbracket(const char *p)
 				break;
 		}
 		p++;
+
+		/* jump to the next character that can change state or nesting level */
+		p += strcspn(p, 0 == state ? "\"[]{}" : "\"\\");
 	}
 
 	return NULL;
@@ -660,6 +736,10 @@ const char	*zbx_json_next(const struct zbx_json_parse *jp, const char *p)
 				break;
 		}
 		p++;
+
+		/* jump to the next character that can change state or nesting level, the closing bracket */
+		/* at jp->end always stops the jump                                                        */
+		p += strcspn(p, 0 == state ? "\"[]{}," : "\"\\");
 	}
 
 	return NULL;
@@ -856,6 +936,7 @@ const char	*json_copy_string(const char *p, char *out, size_t size)
 	{
 		unsigned int	nbytes, i;
 		unsigned char	uc[4];	/* decoded Unicode character takes 1-4 bytes in UTF-8 */
+		size_t		len;
 
 		switch (*p)
 		{
@@ -875,7 +956,15 @@ const char	*json_copy_string(const char *p, char *out, size_t size)
 				*out = '\0';
 				return ++p;
 			default:
-				*out++ = *p++;
+				/* copy plain characters up to the closing quote or escape sequence at once */
+				len = strcspn(p, "\"\\");
+
+				if (len > size - (size_t)(out - start))
+					len = size - (size_t)(out - start);
+
+				memcpy(out, p, len);
+				out += len;
+				p += len;
 		}
 
 		if ((size_t)(out - start) == size)
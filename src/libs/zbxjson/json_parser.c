@@ -53,6 +53,63 @@ zbx_int64_t	json_error(const char *message, const char *ptr, char **error)
 	return 0;
 }
 
+static zbx_int64_t	json_parse_value_ext(const char *start, zbx_jsonobj_t *obj, int lazy, char **error);
+static zbx_int64_t	json_parse_object_ext(const char *start, zbx_jsonobj_t *obj, int lazy, char **error);
+
+/* non-zero if any byte of the machine word is less than 0x20 */
+#define JSON_WORD_HAS_CONTROL(x)	(((x) - ~(zbx_uint64_t)0 / 255 * 0x20) & ~(x) & ~(zbx_uint64_t)0 / 255 * 0x80)
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: find control character U+0001 - U+001F in string data             *
+ *                                                                            *
+ * Parameters: ptr - [IN] the string data                                     *
+ *             len - [IN] the string data length                              *
+ *                                                                            *
+ * Return value: The first control character or NULL if there are none.       *
+ *                                                                            *
+ * Comments: The data is checked a machine word at a time, only the word      *
+ *           containing control character is checked by byte.                 *
+ *                                                                            *
+ ******************************************************************************/
+static const char	*json_find_control_char(const char *ptr, size_t len)
+{
+	const char	*end = ptr + len;
+
+	while (ptr < end)
+	{
+		zbx_uint64_t	word;
+
+		if ((size_t)(end - ptr) >= sizeof(word))
+		{
+			memcpy(&word, ptr, sizeof(word));
+
+			if (0 == JSON_WORD_HAS_CONTROL(word))
+			{
+				ptr += sizeof(word);
+				continue;
+			}
+
+			for (const char *word_end = ptr + sizeof(word); ptr < word_end; ptr++)
+			{
+				if (0x1f >= (unsigned char)*ptr)
+					return ptr;
+			}
+
+			continue;
+		}
+
+		if (0x1f >= (unsigned char)*ptr)
+			return ptr;
+
+		ptr++;
+	}
+
+	return NULL;
+}
+
+#undef JSON_WORD_HAS_CONTROL
+
 /******************************************************************************
  *                                                                            *
  * Purpose: Parses JSON string value or object name                           *
@@ -68,66 +125,69 @@ zbx_int64_t	json_error(const char *message, const char *ptr, char **error)
  ******************************************************************************/
 static zbx_int64_t	json_parse_string(const char *start, char **str, char **error)
 {
-	const char	*ptr = start;
+	const char	*ptr = start, *ctrl;
 
 	/* skip starting '"' */
 	ptr++;
 
-	while ('"' != *ptr)
+	while (1)
 	{
+		size_t		len;
+		const char	*escape_start;
+		unsigned char	uc[4];	/* decoded Unicode character takes 1-4 bytes in UTF-8 */
+
+		/* skip plain characters up to the closing quote, escape sequence or end of data */
+		len = strcspn(ptr, "\"\\");
+
+		/* Control character U+0000 - U+001F? It should have been escaped according to RFC 8259. */
+		if (NULL != (ctrl = json_find_control_char(ptr, len)))
+			return json_error("invalid control character in string data", ctrl, error);
+
+		ptr += len;
+
+		if ('"' == *ptr)
+			break;
+
 		/* unexpected end of string data, failing */
 		if ('\0' == *ptr)
 			return json_error("unexpected end of string data", NULL, error);
 
-		if ('\\' == *ptr)
-		{
-			const char	*escape_start = ptr;
-			unsigned char	uc[4];	/* decoded Unicode character takes 1-4 bytes in UTF-8 */
+		escape_start = ptr;
 
-			/* unexpected end of string data, failing */
-			if ('\0' == *(++ptr))
-				return json_error("invalid escape sequence in string", escape_start, error);
+		/* unexpected end of string data, failing */
+		if ('\0' == *(++ptr))
+			return json_error("invalid escape sequence in string", escape_start, error);
 
-			switch (*ptr)
-			{
-				case '"':
-				case '\\':
-				case '/':
-				case 'b':
-				case 'f':
-				case 'n':
-				case 'r':
-				case 't':
-					break;
-				case 'u':
-					/* check if the \u is followed with 4 hex digits */
-					if (0 == zbx_json_decode_character(&ptr, uc))
-					{
-						return json_error("invalid escape sequence in string",
-								escape_start, error);
-					}
-
-					continue;
-				default:
-					return json_error("invalid escape sequence in string data",
-							escape_start, error);
-			}
+		switch (*ptr)
+		{
+			case '"':
+			case '\\':
+			case '/':
+			case 'b':
+			case 'f':
+			case 'n':
+			case 'r':
+			case 't':
+				ptr++;
+				break;
+			case 'u':
+				/* check if the \u is followed with 4 hex digits */
+				if (0 == zbx_json_decode_character(&ptr, uc))
+					return json_error("invalid escape sequence in string", escape_start, error);
+				break;
+			default:
+				return json_error("invalid escape sequence in string data", escape_start, error);
 		}
-
-		/* Control character U+0000 - U+001F? It should have been escaped according to RFC 8259. */
-		if (0x1f >= (unsigned char)*ptr)
-			return json_error("invalid control character in string data", ptr, error);
-
-		ptr++;
 	}
 
 	if (NULL != str)
 	{
-		*str = (char *)zbx_malloc(NULL, (size_t)(ptr - start));
+		*str = (char *)jsonobj_malloc((size_t)(ptr - start));
 
 		if (NULL == json_copy_string(start, *str, (size_t)(ptr - start)))
 		{
-			zbx_free(*str);
+			jsonobj_release(*str);
+			*str = NULL;
 			return json_error("invalid string data", start, error);
 		}
 	}
@@ -141,6 +201,8 @@ static zbx_int64_t	json_parse_string(const char *start, char **str, char **error
  *                                                                            *
  * Parameters: start - [IN] the JSON data without leading whitespace          *
  *             obj   - [IN/OUT] the JSON object (can be NULL)                 *
+ *             lazy  - [IN] 1 - defer parsing of nested objects and arrays    *
+ *                          0 - parse the whole array                         *
  *             error - [OUT] the parsing error message (can be NULL)          *
  *                                                                            *
  * Return value: The number of characters parsed. On error 0 is returned and  *
@@ -148,7 +210,7 @@ static zbx_int64_t	json_parse_string(const char *start, char **str, char **error
  *               message.                                                     *
  *                                                                            *
  ******************************************************************************/
-zbx_int64_t	json_parse_array(const char *start, zbx_jsonobj_t *obj, char **error)
+static zbx_int64_t	json_parse_array_ext(const char *start, zbx_jsonobj_t *obj, int lazy, char **error)
 {
 	const char	*ptr = start;
 	zbx_int64_t	len;
@@ -167,19 +229,19 @@ zbx_int64_t	json_parse_array(const char *start, zbx_jsonobj_t *obj, char **error
 
 			if (NULL != obj)
 			{
-				value = zbx_malloc(NULL, sizeof(zbx_jsonobj_t));
+				value = (zbx_jsonobj_t *)jsonobj_malloc(sizeof(zbx_jsonobj_t));
 				jsonobj_init(value, ZBX_JSON_TYPE_UNKNOWN);
 			}
 			else
 				value = NULL;
 
 			/* json_parse_value strips leading whitespace, so we don't have to do it here */
-			if (0 == (len = json_parse_value(ptr, value, error)))
+			if (0 == (len = json_parse_value_ext(ptr, value, lazy, error)))
 			{
 				if (NULL != obj)
 				{
 					zbx_jsonobj_clear(value);
-					zbx_free(value);
+					jsonobj_release(value);
 				}
 				return 0;
 			}
@@ -312,9 +374,12 @@ static zbx_int64_t	json_parse_literal(const char *start, const char *text, char
 
 /******************************************************************************
  *                                                                            *
- * Purpose: Parses JSON object value                                          *
+ * Purpose: Parses JSON value                                                 *
  *                                                                            *
  * Parameters: start - [IN] the JSON data                                     *
+ *             obj   - [IN/OUT] the JSON object (can be NULL)                 *
+ *             lazy  - [IN] 1 - defer parsing of objects and arrays           *
+ *                          0 - parse the whole value                         *
  *             error - [OUT] the parsing error message (can be NULL)          *
  *                                                                            *
  * Return value: The number of characters parsed. On error 0 is returned and  *
@@ -322,7 +387,7 @@ static zbx_int64_t	json_parse_literal(const char *start, const char *text, char
  *               message.                                                     *
  *                                                                            *
  ******************************************************************************/
-zbx_int64_t	json_parse_value(const char *start, zbx_jsonobj_t *obj, char **error)
+static zbx_int64_t	json_parse_value_ext(const char *start, zbx_jsonobj_t *obj, int lazy, char **error)
 {
 	const char	*ptr = start;
 	zbx_int64_t	len;
@@ -343,12 +408,28 @@ zbx_int64_t	json_parse_value(const char *start, zbx_jsonobj_t *obj, char **error
 				jsonobj_set_string(obj, str);
 			break;
 		case '{':
-			if (0 == (len = json_parse_object(ptr, obj, error)))
-				return 0;
-			break;
 		case '[':
-			if (0 == (len = json_parse_array(ptr, obj, error)))
-				return 0;
+			if (0 != lazy && NULL != obj)
+			{
+				struct zbx_json_parse	jp;
+
+				/* the data was validated when opening lazy json object, only find its end */
+				if (SUCCEED != zbx_json_brackets_open(ptr, &jp))
+					return json_error("invalid nested object or array", ptr, error);
+
+				jsonobj_init_lazy(obj, '{' == *ptr ? ZBX_JSON_TYPE_OBJECT : ZBX_JSON_TYPE_ARRAY, ptr);
+				len = jp.end - ptr + 1;
+			}
+			else if ('{' == *ptr)
+			{
+				if (0 == (len = json_parse_object_ext(ptr, obj, 0, error)))
+					return 0;
+			}
+			else
+			{
+				if (0 == (len = json_parse_array_ext(ptr, obj, 0, error)))
+					return 0;
+			}
 			break;
 		case 't':
 			if (0 == (len = json_parse_literal(ptr, "true", error)))
@@ -402,6 +483,8 @@ zbx_int64_t	json_parse_value(const char *start, zbx_jsonobj_t *obj, char **error
  *                                                                            *
  * Parameters: start - [IN] the JSON data                                     *
  *             obj   - [IN/OUT] the JSON object (can be NULL)                 *
+ *             lazy  - [IN] 1 - defer parsing of nested objects and arrays    *
+ *                          0 - parse the whole object                        *
  *             error - [OUT] the parsing error message (can be NULL)          *
  *                                                                            *
  * Return value: The number of characters parsed. On error 0 is returned and  *
@@ -409,7 +492,7 @@ zbx_int64_t	json_parse_value(const char *start, zbx_jsonobj_t *obj, char **error
  *               message.                                                     *
  *                                                                            *
  ******************************************************************************/
-zbx_int64_t	json_parse_object(const char *start, zbx_jsonobj_t *obj, char **error)
+static zbx_int64_t	json_parse_object_ext(const char *start, zbx_jsonobj_t *obj, int lazy, char **error)
 {
 	const char		*ptr = start;
 	zbx_int64_t		len;
@@ -451,7 +534,7 @@ zbx_int64_t	json_parse_object(const char *start, zbx_jsonobj_t *obj, char **erro
 
 			ptr++;
 
-			if (0 == (len = json_parse_value(ptr, (NULL != obj ? &el.value : NULL), error)))
+			if (0 == (len = json_parse_value_ext(ptr, (NULL != obj ? &el.value : NULL), lazy, error)))
 			{
 				jsonobj_el_clear(&el);
 				return 0;
@@ -467,7 +550,7 @@ zbx_int64_t	json_parse_object(const char *start, zbx_jsonobj_t *obj, char **erro
 				/* by overwriting old data                                       */
 				if (pel->name != el.name)
 				{
-					zbx_free(pel->name);
+					jsonobj_release(pel->name);
 					zbx_jsonobj_clear(&pel->value);
 					*pel = el;
 				}
@@ -492,6 +575,58 @@ zbx_int64_t	json_parse_object(const char *start, zbx_jsonobj_t *obj, char **erro
 	return ptr - start + 1;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: Parses JSON value, see json_parse_value_ext()                     *
+ *                                                                            *
+ ******************************************************************************/
+zbx_int64_t	json_parse_value(const char *start, zbx_jsonobj_t *obj, char **error)
+{
+	return json_parse_value_ext(start, obj, 0, error);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: Parses JSON object, see json_parse_object_ext()                   *
+ *                                                                            *
+ ******************************************************************************/
+zbx_int64_t	json_parse_object(const char *start, zbx_jsonobj_t *obj, char **error)
+{
+	return json_parse_object_ext(start, obj, 0, error);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: Parses JSON array, see json_parse_array_ext()                     *
+ *                                                                            *
+ ******************************************************************************/
+zbx_int64_t	json_parse_array(const char *start, zbx_jsonobj_t *obj, char **error)
+{
+	return json_parse_array_ext(start, obj, 0, error);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: Parses members of JSON object or array, leaving nested objects    *
+ *          and arrays unparsed                                               *
+ *                                                                            *
+ * Parameters: start - [IN] the validated JSON object or array data           *
+ *             obj   - [OUT] the JSON object                                  *
+ *             error - [OUT] the parsing error message (can be NULL)          *
+ *                                                                            *
+ * Return value: The number of characters parsed. On error 0 is returned and  *
+ *               error parameter (if not NULL) contains allocated error       *
+ *               message.                                                     *
+ *                                                                            *
+ ******************************************************************************/
+zbx_int64_t	json_parse_members(const char *start, zbx_jsonobj_t *obj, char **error)
+{
+	if ('{' == *start)
+		return json_parse_object_ext(start, obj, 1, error);
+
+	return json_parse_array_ext(start, obj, 1, error);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: Validates JSON object                                             *
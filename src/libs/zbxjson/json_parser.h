@@ -31,5 +31,6 @@ zbx_int64_t	json_error(const char *message, const char *ptr, char **error);
 
 zbx_int64_t	json_parse_object(const char *start, zbx_jsonobj_t *obj, char **error);
 zbx_int64_t	json_parse_array(const char *start, zbx_jsonobj_t *obj, char **error);
+zbx_int64_t	json_parse_members(const char *start, zbx_jsonobj_t *obj, char **error);
 
 #endif
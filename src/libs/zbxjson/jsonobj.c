@@ -60,6 +60,141 @@ static int	jsonobj_el_compare(const void *v1, const void *v2)
 	return strcmp(el1->name, el2->name);
 }
 
+/* json object arena support */
+
+#define JSONOBJ_ARENA_BLOCK_SIZE	(256 * ZBX_KIBIBYTE)
+#define JSONOBJ_ARENA_ALIGN(size)	(((size) + sizeof(zbx_uint64_t) - 1) & ~(sizeof(zbx_uint64_t) - 1))
+
+typedef struct zbx_jsonobj_arena_block
+{
+	struct zbx_jsonobj_arena_block	*next;
+	size_t				size;
+	size_t				used;
+	zbx_uint64_t			data[1];
+}
+zbx_jsonobj_arena_block_t;
+
+struct zbx_jsonobj_arena
+{
+	zbx_jsonobj_arena_block_t	*blocks;	/* the first block is used for new allocations */
+	zbx_vector_jsonobj_ptr_t	indexed;	/* objects with indexes allocated outside arena */
+};
+
+/* the arena of json object being parsed by zbx_jsonobj_open_arena() */
+static ZBX_THREAD_LOCAL zbx_jsonobj_arena_t	*jsonobj_arena = NULL;
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: allocate memory from the arena of json object being parsed        *
+ *                                                                            *
+ * Comments: Every allocation is prefixed with its size, so the allocations   *
+ *           can be reallocated by hashsets and vectors.                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	*jsonobj_arena_malloc_func(void *old, size_t size)
+{
+	zbx_jsonobj_arena_block_t	*block = jsonobj_arena->blocks;
+	size_t				*ptr;
+
+	ZBX_UNUSED(old);
+
+	size = JSONOBJ_ARENA_ALIGN(size) + sizeof(zbx_uint64_t);
+
+	if (NULL == block || block->size - block->used < size)
+	{
+		size_t	block_size = MAX(JSONOBJ_ARENA_BLOCK_SIZE, size);
+
+		block = (zbx_jsonobj_arena_block_t *)zbx_malloc(NULL, offsetof(zbx_jsonobj_arena_block_t, data) +
+				block_size);
+		block->size = block_size;
+		block->used = 0;
+
+		/* keep using the current block for small allocations after a large one */
+		if (JSONOBJ_ARENA_BLOCK_SIZE / 4 < size && NULL != jsonobj_arena->blocks)
+		{
+			block->next = jsonobj_arena->blocks->next;
+			jsonobj_arena->blocks->next = block;
+		}
+		else
+		{
+			block->next = jsonobj_arena->blocks;
+			jsonobj_arena->blocks = block;
+		}
+	}
+
+	ptr = (size_t *)((char *)block->data + block->used);
+	block->used += size;
+	*ptr = size - sizeof(zbx_uint64_t);
+
+	return (char *)ptr + sizeof(zbx_uint64_t);
+}
+
+static void	*jsonobj_arena_realloc_func(void *old, size_t size)
+{
+	zbx_jsonobj_arena_block_t	*block = jsonobj_arena->blocks;
+	size_t				*old_size;
+	void				*ptr;
+
+	if (NULL == old)
+		return jsonobj_arena_malloc_func(NULL, size);
+
+	old_size = (size_t *)((char *)old - sizeof(zbx_uint64_t));
+
+	if (size <= *old_size)
+		return old;
+
+	size = JSONOBJ_ARENA_ALIGN(size);
+
+	/* grow the last allocation of current block in place */
+	if ((char *)old + *old_size == (char *)block->data + block->used && block->size - block->used >=
+			size - *old_size)
+	{
+		block->used += size - *old_size;
+		*old_size = size;
+		return old;
+	}
+
+	ptr = jsonobj_arena_malloc_func(NULL, size);
+	memcpy(ptr, old, *old_size);
+
+	return ptr;
+}
+
+static void	jsonobj_arena_free_func(void *ptr)
+{
+	/* arena memory is released with the whole arena */
+	ZBX_UNUSED(ptr);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: allocate memory for json object data                              *
+ *                                                                            *
+ * Parameters: size - [IN] the number of bytes to allocate                    *
+ *                                                                            *
+ * Return value: memory allocated from the arena of json object being parsed  *
+ *               or from heap if the arena is not used                        *
+ *                                                                            *
+ ******************************************************************************/
+void	*jsonobj_malloc(size_t size)
+{
+	if (NULL != jsonobj_arena)
+		return jsonobj_arena_malloc_func(NULL, size);
+
+	return zbx_malloc(NULL, size);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: release memory allocated by jsonobj_malloc()                      *
+ *                                                                            *
+ ******************************************************************************/
+void	jsonobj_release(void *ptr)
+{
+	if (NULL == jsonobj_arena)
+		zbx_free(ptr);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: initialize json object structure                                  *
@@ -75,10 +210,23 @@ void	jsonobj_init(zbx_jsonobj_t *obj, zbx_json_type_t type)
 	switch (type)
 	{
 		case ZBX_JSON_TYPE_ARRAY:
-			zbx_vector_jsonobj_ptr_create(&obj->data.array);
+			if (NULL != jsonobj_arena)
+			{
+				zbx_vector_jsonobj_ptr_create_ext(&obj->data.array, jsonobj_arena_malloc_func,
+						jsonobj_arena_realloc_func, jsonobj_arena_free_func);
+			}
+			else
+				zbx_vector_jsonobj_ptr_create(&obj->data.array);
 			break;
 		case ZBX_JSON_TYPE_OBJECT:
-			zbx_hashset_create(&obj->data.object, 0, jsonobj_el_hash, jsonobj_el_compare);
+			if (NULL != jsonobj_arena)
+			{
+				zbx_hashset_create_ext(&obj->data.object, 0, jsonobj_el_hash, jsonobj_el_compare, NULL,
+						jsonobj_arena_malloc_func, jsonobj_arena_realloc_func,
+						jsonobj_arena_free_func);
+			}
+			else
+				zbx_hashset_create(&obj->data.object, 0, jsonobj_el_hash, jsonobj_el_compare);
 			break;
 		default:
 			memset(&obj->data, 0, sizeof(obj->data));
@@ -87,6 +235,62 @@ void	jsonobj_init(zbx_jsonobj_t *obj, zbx_json_type_t type)
 
 	obj->index = NULL;
 	obj->index_num = 0;
+	obj->lazy = NULL;
+	obj->arena = NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: initialize json object or array which will be parsed on first     *
+ *          access                                                            *
+ *                                                                            *
+ * Parameters: obj  - [IN/OUT] the json object to initialize                  *
+ *             type - [IN] the json object type (object or array)             *
+ *             data - [IN] the validated object or array data                 *
+ *                                                                            *
+ ******************************************************************************/
+void	jsonobj_init_lazy(zbx_jsonobj_t *obj, zbx_json_type_t type, const char *data)
+{
+	obj->type = type;
+	memset(&obj->data, 0, sizeof(obj->data));
+	obj->index = NULL;
+	obj->index_num = 0;
+	obj->lazy = data;
+	obj->arena = NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: parse members of lazily opened json object or array               *
+ *                                                                            *
+ * Parameters: obj - [IN/OUT] the json object                                 *
+ *                                                                            *
+ * Comments: Nested objects and arrays are left unparsed until accessed.      *
+ *           This function does nothing for already parsed objects.           *
+ *                                                                            *
+ ******************************************************************************/
+void	jsonobj_parse_lazy(zbx_jsonobj_t *obj)
+{
+	const char	*data;
+	zbx_json_type_t	type;
+	int		index_num;
+
+	if (NULL == (data = obj->lazy))
+		return;
+
+	type = obj->type;
+	index_num = obj->index_num;
+
+	if (0 == json_parse_members(data, obj, NULL))
+	{
+		/* the data was validated when opening the object, parsing cannot fail */
+		THIS_SHOULD_NEVER_HAPPEN;
+		zbx_jsonobj_clear(obj);
+		jsonobj_init(obj, type);
+	}
+
+	/* keep the indexing state of root object */
+	obj->index_num = index_num;
 }
 
 /******************************************************************************
@@ -120,17 +324,61 @@ static void	jsonobj_index_el_clear(void *v)
  *                                                                            *
  * Purpose: initialize json object index                                      *
  *                                                                            *
- * Parameters: obj  - [IN/OUT] the json object                                *
+ * Parameters: root - [IN/OUT] the root object                                *
+ *             obj  - [IN/OUT] the json object                                *
  *             path - [IN] the indexed relative path                          *
  *                                                                            *
  ******************************************************************************/
-void	jsonobj_init_index(zbx_jsonobj_t *obj, const char *path)
+void	jsonobj_init_index(zbx_jsonobj_t *root, zbx_jsonobj_t *obj, const char *path)
 {
 	obj->index = (zbx_jsonobj_index_t *)zbx_malloc(NULL, sizeof(zbx_jsonobj_index_t));
 	obj->index->path = zbx_strdup(NULL, path);
 	zbx_hashset_create_ext(&obj->index->objects, 0, jsonobj_index_el_hash, jsonobj_index_el_compare,
 			jsonobj_index_el_clear, ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC,
 			ZBX_DEFAULT_MEM_FREE_FUNC);
+
+	/* objects in arena are not cleared one by one, so their indexes must be tracked */
+	if (NULL != root->arena)
+		zbx_vector_jsonobj_ptr_append(&root->arena->indexed, obj);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: free json object index                                            *
+ *                                                                            *
+ ******************************************************************************/
+static void	jsonobj_clear_index(zbx_jsonobj_t *obj)
+{
+	if (NULL != obj->index)
+	{
+		zbx_free(obj->index->path);
+		zbx_hashset_destroy(&obj->index->objects);
+		zbx_free(obj->index);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: free json object arena together with all objects allocated in it  *
+ *                                                                            *
+ ******************************************************************************/
+static void	jsonobj_arena_free(zbx_jsonobj_arena_t *arena)
+{
+	zbx_jsonobj_arena_block_t	*block;
+	int				i;
+
+	for (i = 0; i < arena->indexed.values_num; i++)
+		jsonobj_clear_index(arena->indexed.values[i]);
+
+	zbx_vector_jsonobj_ptr_destroy(&arena->indexed);
+
+	while (NULL != (block = arena->blocks))
+	{
+		arena->blocks = block->next;
+		zbx_free(block);
+	}
+
+	zbx_free(arena);
 }
 
 /******************************************************************************
@@ -203,7 +451,7 @@ void	jsonobj_el_init(zbx_jsonobj_el_t *el)
  ******************************************************************************/
 void	jsonobj_el_clear(zbx_jsonobj_el_t *el)
 {
-	zbx_free(el->name);
+	jsonobj_release(el->name);
 	zbx_jsonobj_clear(&el->value);
 }
 
@@ -228,6 +476,25 @@ void	zbx_jsonobj_clear(zbx_jsonobj_t *obj)
 	zbx_jsonobj_el_t	*el;
 	zbx_hashset_iter_t	iter;
 
+	/* objects being parsed into arena are freed together with the arena */
+	if (NULL != jsonobj_arena)
+		return;
+
+	if (NULL != obj->arena)
+	{
+		jsonobj_arena_free(obj->arena);
+		jsonobj_init(obj, ZBX_JSON_TYPE_UNKNOWN);
+		return;
+	}
+
+	/* unparsed objects have no allocated data */
+	if (NULL != obj->lazy)
+	{
+		obj->lazy = NULL;
+		obj->type = ZBX_JSON_TYPE_UNKNOWN;
+		return;
+	}
+
 	switch (obj->type)
 	{
 		case ZBX_JSON_TYPE_STRING:
@@ -250,12 +517,7 @@ void	zbx_jsonobj_clear(zbx_jsonobj_t *obj)
 			break;
 	}
 
-	if (NULL != obj->index)
-	{
-		zbx_free(obj->index->path);
-		zbx_hashset_destroy(&obj->index->objects);
-		zbx_free(obj->index);
-	}
+	jsonobj_clear_index(obj);
 }
 
 /******************************************************************************
@@ -270,6 +532,8 @@ int	zbx_jsonobj_to_string(char **str, size_t *str_alloc, size_t *str_offset, zbx
 	zbx_hashset_iter_t	iter;
 	zbx_jsonobj_el_t	*el;
 
+	jsonobj_parse_lazy(obj);
+
 	switch (obj->type)
 	{
 		case ZBX_JSON_TYPE_TRUE:
@@ -369,6 +633,98 @@ out:
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: parses json formatted data into json object structure allocated   *
+ *          in arena                                                          *
+ *                                                                            *
+ * Parameters: data - [IN] the json data                                      *
+ *             obj  - [OUT] the json object                                   *
+ *                                                                            *
+ * Return value: SUCCEED - the data was parsed successfully                   *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Object nodes, elements and strings are allocated in few large    *
+ *           memory blocks which are freed at once when the object is         *
+ *           cleared, instead of freeing the object tree node by node.        *
+ *           The parsed object must not be modified, except for indexing      *
+ *           during jsonpath queries.                                         *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_jsonobj_open_arena(const char *data, zbx_jsonobj_t *obj)
+{
+	zbx_jsonobj_arena_t	*arena;
+	int			ret;
+
+	arena = (zbx_jsonobj_arena_t *)zbx_malloc(NULL, sizeof(zbx_jsonobj_arena_t));
+	arena->blocks = NULL;
+	zbx_vector_jsonobj_ptr_create(&arena->indexed);
+
+	jsonobj_arena = arena;
+	ret = zbx_jsonobj_open(data, obj);
+	jsonobj_arena = NULL;
+
+	if (SUCCEED == ret)
+	{
+		obj->arena = arena;
+	}
+	else
+	{
+		jsonobj_arena_free(arena);
+		jsonobj_init(obj, ZBX_JSON_TYPE_UNKNOWN);
+	}
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: open json formatted data for queries without parsing it into      *
+ *          json object structure                                             *
+ *                                                                            *
+ * Parameters: data - [IN] the json data                                      *
+ *             obj  - [OUT] the json object                                   *
+ *                                                                            *
+ * Return value: SUCCEED - the data is valid json object or array             *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: The data is validated, but objects and arrays are parsed only    *
+ *           when a query descends into them, so queries touching a small     *
+ *           part of large data do not build the whole object structure.      *
+ *           The data must not be freed or changed until the object is        *
+ *           cleared.                                                         *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_jsonobj_open_lazy(const char *data, zbx_jsonobj_t *obj)
+{
+	char	*error = NULL;
+
+	SKIP_WHITESPACE(data);
+
+	switch (*data)
+	{
+		case '{':
+			if (0 == json_parse_object(data, NULL, &error))
+				goto out;
+			jsonobj_init_lazy(obj, ZBX_JSON_TYPE_OBJECT, data);
+			return SUCCEED;
+		case '[':
+			if (0 == json_parse_array(data, NULL, &error))
+				goto out;
+			jsonobj_init_lazy(obj, ZBX_JSON_TYPE_ARRAY, data);
+			return SUCCEED;
+		default:
+			/* not json data, failing */
+			(void)json_error("invalid object format, expected opening character '{' or '['", data, &error);
+	}
+out:
+	jsonobj_init(obj, ZBX_JSON_TYPE_UNKNOWN);
+	zbx_set_json_strerror("%s", error);
+	zbx_free(error);
+
+	return FAIL;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: disable automatic json object indexing during jsonpath query      *
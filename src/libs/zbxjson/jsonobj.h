@@ -42,9 +42,14 @@ typedef struct
 zbx_jsonobj_index_el_t;
 
 void	jsonobj_init(zbx_jsonobj_t *obj, zbx_json_type_t type);
+void	jsonobj_init_lazy(zbx_jsonobj_t *obj, zbx_json_type_t type, const char *data);
+void	jsonobj_parse_lazy(zbx_jsonobj_t *obj);
+
+void	*jsonobj_malloc(size_t size);
+void	jsonobj_release(void *ptr);
 
 void	jsonobj_el_init(zbx_jsonobj_el_t *el);
-void	jsonobj_init_index(zbx_jsonobj_t *obj, const char *path);
+void	jsonobj_init_index(zbx_jsonobj_t *root, zbx_jsonobj_t *obj, const char *path);
 void	jsonobj_el_clear(zbx_jsonobj_el_t *el);
 
 void	jsonobj_set_string(zbx_jsonobj_t *obj, char *str);
@@ -1976,7 +1976,8 @@ static void	jsonpath_create_index(zbx_jsonobj_t *root, zbx_jsonobj_t *obj,
 	if (0 != root->index_num)
 		return;
 
-	jsonobj_init_index(obj, index_token->text);
+	jsonobj_parse_lazy(obj);
+	jsonobj_init_index(root, obj, index_token->text);
 
 	ctx.root = obj;
 	ctx.path = index_token->path;
@@ -2304,6 +2305,8 @@ static int	jsonpath_query_object(zbx_jsonpath_context_t *ctx, zbx_jsonobj_t *obj
 	zbx_hashset_iter_t		iter;
 	zbx_jsonobj_el_t		*el;
 
+	jsonobj_parse_lazy(obj);
+
 	segment = &ctx->path->segments[path_depth];
 
 	if (ZBX_JSONPATH_SEGMENT_MATCH_LIST == segment->type)
@@ -2453,6 +2456,8 @@ static int	jsonpath_query_array(zbx_jsonpath_context_t *ctx, zbx_jsonobj_t *arra
 	int			ret = SUCCEED, i;
 	zbx_jsonpath_segment_t	*segment;
 
+	jsonobj_parse_lazy(array);
+
 	segment = &ctx->path->segments[path_depth];
 
 	switch (segment->type)
@@ -2611,6 +2616,8 @@ static int	jsonpath_apply_function(const zbx_vector_jsonobj_ref_t *in, zbx_jsonp
 			goto out;
 		}
 
+		jsonobj_parse_lazy(in->values[0].value);
+
 		for (i = 0; i < in->values[0].value->data.array.values_num; i++)
 		{
 			char	name[MAX_ID_LEN + 1];
@@ -2925,7 +2932,7 @@ int	zbx_jsonpath_query(const struct zbx_json_parse *jp, const char *path, char *
 	int		ret;
 	zbx_jsonobj_t	obj;
 
-	if (SUCCEED != zbx_jsonobj_open(jp->start, &obj))
+	if (SUCCEED != zbx_jsonobj_open_lazy(jp->start, &obj))
 		return FAIL;
 
 	ret = zbx_jsonobj_query(&obj, path, output);
@@ -2935,6 +2942,34 @@ int	zbx_jsonpath_query(const struct zbx_json_parse *jp, const char *path, char *
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: perform compiled jsonpath query on the specified json data        *
+ *                                                                            *
+ * Parameters: jp       - [IN] the json data                                  *
+ *             jsonpath - [IN] the compiled jsonpath                          *
+ *             output   - [OUT] the output value                              *
+ *                                                                            *
+ * Return value: SUCCEED - the query was performed successfully (empty result *
+ *                         being counted as successful query)                 *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_jsonpath_query_ext(const struct zbx_json_parse *jp, zbx_jsonpath_t *jsonpath, char **output)
+{
+	int		ret;
+	zbx_jsonobj_t	obj;
+
+	if (SUCCEED != zbx_jsonobj_open_lazy(jp->start, &obj))
+		return FAIL;
+
+	ret = zbx_jsonobj_query_ext(&obj, jsonpath, output);
+
+	zbx_jsonobj_clear(&obj);
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: perform jsonpath query on the specified json object               *
@@ -2950,16 +2985,43 @@ int	zbx_jsonpath_query(const struct zbx_json_parse *jp, const char *path, char *
  ******************************************************************************/
 int	zbx_jsonobj_query(zbx_jsonobj_t *obj, const char *path, char **output)
 {
-	zbx_jsonpath_context_t	ctx;
-	zbx_jsonpath_t		jsonpath;
-	int			ret = SUCCEED;
+	zbx_jsonpath_t	jsonpath;
+	int		ret;
 
 	if (FAIL == zbx_jsonpath_compile(path, &jsonpath))
 		return FAIL;
 
+	ret = zbx_jsonobj_query_ext(obj, &jsonpath, output);
+
+	zbx_jsonpath_clear(&jsonpath);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: perform compiled jsonpath query on the specified json object      *
+ *                                                                            *
+ * Parameters: obj      - [IN] the json object                                *
+ *             jsonpath - [IN] the compiled jsonpath                          *
+ *             output   - [OUT] the output value                              *
+ *                                                                            *
+ * Return value: SUCCEED - the query was performed successfully (empty result *
+ *                         being counted as successful query)                 *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: The compiled jsonpath is not modified by queries, so it can be   *
+ *           reused for any number of queries until it's cleared.             *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_jsonobj_query_ext(zbx_jsonobj_t *obj, zbx_jsonpath_t *jsonpath, char **output)
+{
+	zbx_jsonpath_context_t	ctx;
+	int			ret = SUCCEED;
+
 	ctx.found = 0;
 	ctx.root = obj;
-	ctx.path = &jsonpath;
+	ctx.path = jsonpath;
 	zbx_vector_jsonobj_ref_create(&ctx.objects);
 
 	switch (obj->type)
@@ -2977,15 +3039,15 @@ int	zbx_jsonobj_query(zbx_jsonobj_t *obj, const char *path, char **output)
 	if (SUCCEED == ret)
 	{
 		zbx_vector_jsonobj_ref_t	out;
-		int				definite_path = jsonpath.definite, path_depth;
+		int				definite_path = jsonpath->definite, path_depth;
 
 		zbx_vector_jsonobj_ref_create(&out);
 
-		path_depth = jsonpath.segments_num;
-		while (0 < path_depth && ZBX_JSONPATH_SEGMENT_FUNCTION == jsonpath.segments[path_depth - 1].type)
+		path_depth = jsonpath->segments_num;
+		while (0 < path_depth && ZBX_JSONPATH_SEGMENT_FUNCTION == jsonpath->segments[path_depth - 1].type)
 			path_depth--;
 
-		if (path_depth < jsonpath.segments_num)
+		if (path_depth < jsonpath->segments_num)
 		{
 			if (SUCCEED == (ret = jsonpath_apply_functions(&ctx, path_depth, &definite_path, &out)))
 				ret = jsonpath_format_query_result(&out, definite_path, output);
@@ -2999,7 +3061,6 @@ int	zbx_jsonobj_query(zbx_jsonobj_t *obj, const char *path, char **output)
 
 	zbx_vector_jsonobj_ref_clear_ext(&ctx.objects);
 	zbx_vector_jsonobj_ref_destroy(&ctx.objects);
-	zbx_jsonpath_clear(&jsonpath);
 
 	return ret;
 }
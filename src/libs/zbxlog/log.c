@@ -44,6 +44,24 @@ static ZBX_THREAD_LOCAL char	log_component_name[LOG_COMPONENT_NAME_LEN + 1];
 
 static int			config_log_file_size = -1;	/* max log file size in MB */
 
+#ifndef _WINDOWS
+/* Log file lines are written with a single write() to a descriptor opened in append mode, which does not */
+/* require locking. Debug level lines are collected in per thread buffer and written in batches.          */
+#define ZBX_LOG_BUFFER_SIZE	(32 * ZBX_KIBIBYTE)
+#define ZBX_LOG_FLUSH_PERIOD	1	/* maximum time debug lines are kept in buffer, seconds */
+
+static int			log_fd = -1;
+
+static ZBX_THREAD_LOCAL char	log_buffer[ZBX_LOG_BUFFER_SIZE];
+static ZBX_THREAD_LOCAL size_t	log_buffer_offset;
+static ZBX_THREAD_LOCAL pid_t	log_buffer_pid;		/* process the buffered lines were logged by */
+static ZBX_THREAD_LOCAL time_t	log_buffer_time;	/* time when the oldest buffered line was logged */
+static ZBX_THREAD_LOCAL int	log_busy;		/* detects nested calls from signal handlers */
+static ZBX_THREAD_LOCAL time_t	log_rotate_time;	/* time when log file size was last checked */
+static ZBX_THREAD_LOCAL time_t	log_time_sec = -1;	/* cached timestamp text of the current second */
+static ZBX_THREAD_LOCAL char	log_time_str[32];
+#endif
+
 static int	get_config_log_file_size(void)
 {
 	if (-1 != config_log_file_size)
@@ -214,6 +232,123 @@ int	zbx_redirect_stdio(const char *filename)
 	return SUCCEED;
 }
 
+#ifndef _WINDOWS
+/******************************************************************************
+ *                                                                            *
+ * Purpose: (re)open log file descriptor                                      *
+ *                                                                            *
+ * Comments: The descriptor number is preserved with dup2(), so that other    *
+ *           threads writing to the old file are not affected.                *
+ *                                                                            *
+ ******************************************************************************/
+static int	log_file_reopen(void)
+{
+	int	fd;
+
+	if (-1 == (fd = open(log_filename, O_WRONLY | O_APPEND | O_CREAT, 0666)))
+		return FAIL;
+
+	if (-1 == log_fd)
+	{
+		log_fd = fd;
+	}
+	else
+	{
+		(void)dup2(fd, log_fd);
+		close(fd);
+	}
+
+	return SUCCEED;
+}
+
+static void	log_file_write(const char *data, size_t size)
+{
+	ssize_t	n;
+
+	while (0 != size)
+	{
+		if (-1 == log_fd && SUCCEED != log_file_reopen())
+		{
+			zbx_error("failed to open log file: %s", zbx_strerror(errno));
+			zbx_error("failed to write [%.*s] into log file", (int)size, data);
+			return;
+		}
+
+		if (-1 == (n = write(log_fd, data, size)))
+		{
+			if (EINTR == errno)
+				continue;
+
+			zbx_error("failed to write into log file: %s", zbx_strerror(errno));
+			return;
+		}
+
+		data += n;
+		size -= (size_t)n;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: write buffered log lines                                          *
+ *                                                                            *
+ * Comments: Lines inherited from parent process after fork are discarded,    *
+ *           they will be written by the parent.                              *
+ *                                                                            *
+ ******************************************************************************/
+static void	log_buffer_flush(void)
+{
+	if (0 == log_buffer_offset)
+		return;
+
+	if (getpid() == log_buffer_pid)
+		log_file_write(log_buffer, log_buffer_offset);
+
+	log_buffer_offset = 0;
+}
+
+static void	log_buffer_flush_atexit(void)
+{
+	if (0 == log_busy)
+		log_buffer_flush();
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: format log line prefix with process id and timestamp              *
+ *                                                                            *
+ * Parameters: buf  - [OUT] the output buffer                                 *
+ *             size - [IN] the output buffer size                             *
+ *             now  - [OUT] the current time                                  *
+ *                                                                            *
+ * Return value: the prefix length                                            *
+ *                                                                            *
+ * Comments: Date and time is formatted only once per second.                 *
+ *                                                                            *
+ ******************************************************************************/
+static size_t	log_format_prefix(char *buf, size_t size, time_t *now)
+{
+	struct timeval	current_time;
+
+	gettimeofday(&current_time, NULL);
+
+	if (log_time_sec != current_time.tv_sec)
+	{
+		struct tm	tm;
+
+		localtime_r(&current_time.tv_sec, &tm);
+		zbx_snprintf(log_time_str, sizeof(log_time_str), "%.4d%.2d%.2d:%.2d%.2d%.2d", tm.tm_year + 1900,
+				tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec);
+		log_time_sec = current_time.tv_sec;
+	}
+
+	*now = current_time.tv_sec;
+
+	return zbx_snprintf(buf, size, "%6li:%s.%03ld %s", zbx_get_thread_id(), log_time_str,
+			(long)(current_time.tv_usec / 1000), log_component_name);
+}
+#endif
+
 static void	rotate_log(const char *filename)
 {
 	zbx_stat_t		buf;
@@ -291,13 +426,19 @@ static void	rotate_log(const char *filename)
 	}
 
 	if (old_size > new_size)
+	{
 		zbx_redirect_stdio(filename);
+#if !defined(_WINDOWS)
+		log_file_reopen();
+#endif
+	}
 #if !defined(_WINDOWS)
 	else if (st_ino != buf.st_ino || st_dev != buf.st_dev)
 	{
 		st_ino = buf.st_ino;
 		st_dev = buf.st_dev;
 		zbx_redirect_stdio(filename);
+		log_file_reopen();
 	}
 #endif
 
@@ -356,6 +497,13 @@ void	zbx_handle_log(void)
 	if (LOG_TYPE_FILE != log_type)
 		return;
 
+#ifndef _WINDOWS
+	if (0 != log_busy)
+		return;
+
+	log_buffer_flush();
+	log_rotate_time = time(NULL);
+#endif
 	LOCK_LOG;
 
 	rotate_log(log_filename);
@@ -363,6 +511,68 @@ void	zbx_handle_log(void)
 	UNLOCK_LOG;
 }
 
+#ifndef _WINDOWS
+/******************************************************************************
+ *                                                                            *
+ * Purpose: write formatted line into log file                                *
+ *                                                                            *
+ * Parameters: level - [IN] the log level                                     *
+ *             line  - [IN] the line, including terminating newline           *
+ *             len   - [IN] the line length                                   *
+ *             now   - [IN] the current time                                  *
+ *                                                                            *
+ * Comments: Log file size is checked at most once per second per thread,     *
+ *           instead of doing it for every line under log mutex.              *
+ *                                                                            *
+ ******************************************************************************/
+static void	log_file_line(int level, const char *line, size_t len, time_t now)
+{
+	if (0 != log_busy)
+	{
+		/* logging from signal handler while buffer is being updated, write directly */
+		log_file_write(line, len);
+		return;
+	}
+
+	log_busy = 1;
+
+	if (0 != get_config_log_file_size() && now != log_rotate_time)
+	{
+		log_buffer_flush();
+		log_rotate_time = now;
+
+		LOCK_LOG;
+		rotate_log(log_filename);
+		UNLOCK_LOG;
+	}
+
+	if (len > sizeof(log_buffer) - log_buffer_offset)
+		log_buffer_flush();
+
+	if (len > sizeof(log_buffer))
+	{
+		log_file_write(line, len);
+	}
+	else
+	{
+		if (0 == log_buffer_offset)
+		{
+			log_buffer_pid = getpid();
+			log_buffer_time = now;
+		}
+
+		memcpy(log_buffer + log_buffer_offset, line, len);
+		log_buffer_offset += len;
+	}
+
+	/* only debug lines are delayed, other lines are written immediately together with buffered lines */
+	if ((LOG_LEVEL_DEBUG != level && LOG_LEVEL_TRACE != level) || ZBX_LOG_FLUSH_PERIOD <= now - log_buffer_time)
+		log_buffer_flush();
+
+	log_busy = 0;
+}
+#endif
+
 int	zabbix_open_log(const zbx_config_log_t *log_file_cfg, int level, char **error)
 {
 	const char	*filename = log_file_cfg->log_file_name;
@@ -406,6 +616,21 @@ int	zabbix_open_log(const zbx_config_log_t *log_file_cfg, int level, char **erro
 
 		zbx_strscpy(log_filename, filename);
 		zbx_fclose(log_file);
+#ifndef _WINDOWS
+		{
+			static int	atexit_registered;
+
+			if (SUCCEED != log_file_reopen())
+			{
+				*error = zbx_dsprintf(*error, "unable to open log file [%s]: %s", filename,
+						zbx_strerror(errno));
+				return FAIL;
+			}
+
+			if (0 == atexit_registered && 0 == atexit(log_buffer_flush_atexit))
+				atexit_registered = 1;
+		}
+#endif
 	}
 	else if (LOG_TYPE_CONSOLE == type || LOG_TYPE_UNDEFINED == type)
 	{
@@ -441,6 +666,18 @@ void	zabbix_close_log(void)
 	}
 	else if (LOG_TYPE_FILE == log_type || LOG_TYPE_CONSOLE == log_type || LOG_TYPE_UNDEFINED == log_type)
 	{
+#ifndef _WINDOWS
+		if (LOG_TYPE_FILE == log_type)
+		{
+			log_buffer_flush();
+
+			if (-1 != log_fd)
+			{
+				close(log_fd);
+				log_fd = -1;
+			}
+		}
+#endif
 		zbx_mutex_destroy(&log_access);
 	}
 
@@ -462,6 +699,40 @@ void	__zbx_zabbix_log(int level, const char *fmt, ...)
 #endif
 	if (LOG_TYPE_FILE == log_type)
 	{
+#ifndef _WINDOWS
+		char	*line = message;
+		size_t	len;
+		int	n;
+		time_t	now;
+
+		len = log_format_prefix(message, sizeof(message), &now);
+
+		va_start(args, fmt);
+		n = vsnprintf(message + len, sizeof(message) - len, fmt, args);
+		va_end(args);
+
+		if (0 > n)
+			n = 0;
+
+		if ((size_t)n >= sizeof(message) - len)
+		{
+			/* the message does not fit in stack buffer, format it again in allocated buffer */
+			line = (char *)zbx_malloc(NULL, len + (size_t)n + 2);
+			memcpy(line, message, len);
+
+			va_start(args, fmt);
+			vsnprintf(line + len, (size_t)n + 1, fmt, args);
+			va_end(args);
+		}
+
+		len += (size_t)n;
+		line[len++] = '\n';
+
+		log_file_line(level, line, len, now);
+
+		if (line != message)
+			zbx_free(line);
+#else
 		FILE	*log_file;
 
 		LOCK_LOG;
@@ -509,7 +780,7 @@ void	__zbx_zabbix_log(int level, const char *fmt, ...)
 		}
 
 		UNLOCK_LOG;
-
+#endif
 		return;
 	}
 
@@ -407,6 +407,10 @@ typedef struct
 }
 smtp_payload_status_t;
 
+/* The handle is kept between emails, so that libcurl can reuse connection to the */
+/* same SMTP server instead of connecting and authenticating for every message.   */
+static CURL	*smtp_easyhandle = NULL;
+
 static size_t	smtp_provide_payload(void *buffer, size_t size, size_t nmemb, void *instream)
 {
 	size_t			current_len;
@@ -735,12 +739,14 @@ static int	send_email_curl(const char *smtp_server, unsigned short smtp_port, co
 	struct curl_slist	*recipients = NULL;
 	smtp_payload_status_t	payload_status;
 
-	if (NULL == (easyhandle = curl_easy_init()))
+	if (NULL == smtp_easyhandle && NULL == (smtp_easyhandle = curl_easy_init()))
 	{
 		zbx_strlcpy(error, "cannot initialize cURL library", max_error_len);
 		goto out;
 	}
 
+	easyhandle = smtp_easyhandle;
+
 	memset(&payload_status, 0, sizeof(payload_status));
 
 	if (SMTP_SECURITY_SSL == smtp_security)
@@ -892,7 +898,9 @@ clean:
 	zbx_free(payload_status.payload);
 
 	curl_slist_free_all(recipients);
-	curl_easy_cleanup(easyhandle);
+
+	/* reset options referencing local data, open connections are kept */
+	curl_easy_reset(easyhandle);
 out:
 	return ret;
 #else
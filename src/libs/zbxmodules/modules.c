@@ -32,6 +32,7 @@
 #define ZBX_MODULE_FUNC_ITEM_TIMEOUT		"zbx_module_item_timeout"
 #define ZBX_MODULE_FUNC_UNINIT			"zbx_module_uninit"
 #define ZBX_MODULE_FUNC_HISTORY_WRITE_CBS	"zbx_module_history_write_cbs"
+#define ZBX_MODULE_FUNC_HISTORY_WRITE_CBS_V2	"zbx_module_history_write_cbs_v2"
 
 static zbx_vector_ptr_t	modules;
 
@@ -41,6 +42,8 @@ zbx_history_string_cb_t		*history_string_cbs = NULL;
 zbx_history_text_cb_t		*history_text_cbs = NULL;
 zbx_history_log_cb_t		*history_log_cbs = NULL;
 
+zbx_history_write_cbs_v2_t	*history_write_cbs_v2 = NULL;
+
 /******************************************************************************
  *                                                                            *
  * Purpose: add items supported by module                                     *
@@ -204,6 +207,42 @@ static void	zbx_register_history_write_cbs(zbx_module_t *module, ZBX_HISTORY_WRI
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: registers columnar callback functions for history export          *
+ *                                                                            *
+ * Parameters: module            - module pointer for later reference         *
+ *             history_write_cbs - callbacks                                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	zbx_register_history_write_cbs_v2(zbx_module_t *module, ZBX_HISTORY_WRITE_CBS_V2 history_write_cbs)
+{
+	int	j = 0;
+
+	if (NULL == history_write_cbs.history_float_cb && NULL == history_write_cbs.history_integer_cb &&
+			NULL == history_write_cbs.history_string_cb && NULL == history_write_cbs.history_text_cb &&
+			NULL == history_write_cbs.history_log_cb)
+	{
+		return;
+	}
+
+	if (NULL == history_write_cbs_v2)
+	{
+		history_write_cbs_v2 = (zbx_history_write_cbs_v2_t *)zbx_malloc(history_write_cbs_v2,
+				sizeof(zbx_history_write_cbs_v2_t));
+		history_write_cbs_v2[0].module = NULL;
+	}
+
+	while (NULL != history_write_cbs_v2[j].module)
+		j++;
+
+	history_write_cbs_v2 = (zbx_history_write_cbs_v2_t *)zbx_realloc(history_write_cbs_v2, (j + 2) *
+			sizeof(zbx_history_write_cbs_v2_t));
+	history_write_cbs_v2[j].module = module;
+	history_write_cbs_v2[j].cbs = history_write_cbs;
+	history_write_cbs_v2[j + 1].module = NULL;
+}
+
 static int	zbx_module_compare_func(const void *d1, const void *d2)
 {
 	const zbx_module_t	*m1 = *(const zbx_module_t **)d1;
@@ -235,6 +274,7 @@ static int	zbx_load_module(const char *path, char *name, int timeout)
 	ZBX_METRIC		*(*func_list)(void);
 	void			(*func_timeout)(int);
 	ZBX_HISTORY_WRITE_CBS	(*func_history_write_cbs)(void);
+	ZBX_HISTORY_WRITE_CBS_V2	(*func_history_write_cbs_v2)(void);
 	zbx_module_t		*module, module_tmp;
 
 	if ('/' != *name)
@@ -306,7 +346,12 @@ static int	zbx_load_module(const char *path, char *name, int timeout)
 	/* module passed validation and can now be registered */
 	module = zbx_register_module(lib, name);
 
-	if (NULL == (*(void **)(&func_history_write_cbs) = dlsym(lib, ZBX_MODULE_FUNC_HISTORY_WRITE_CBS)))
+	/* columnar callbacks take precedence, the old ones can be kept for older server versions */
+	if (NULL != (*(void **)(&func_history_write_cbs_v2) = dlsym(lib, ZBX_MODULE_FUNC_HISTORY_WRITE_CBS_V2)))
+	{
+		zbx_register_history_write_cbs_v2(module, func_history_write_cbs_v2());
+	}
+	else if (NULL == (*(void **)(&func_history_write_cbs) = dlsym(lib, ZBX_MODULE_FUNC_HISTORY_WRITE_CBS)))
 	{
 		zabbix_log(LOG_LEVEL_DEBUG, "cannot find \"" ZBX_MODULE_FUNC_HISTORY_WRITE_CBS "()\""
 				" function in module \"%s\": %s", name, dlerror());
@@ -413,6 +458,7 @@ void	zbx_unload_modules(void)
 	zbx_free(history_string_cbs);
 	zbx_free(history_text_cbs);
 	zbx_free(history_log_cbs);
+	zbx_free(history_write_cbs_v2);
 
 	zbx_vector_ptr_clear_ext(&modules, zbx_unload_module);
 	zbx_vector_ptr_destroy(&modules);
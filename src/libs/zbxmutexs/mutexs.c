@@ -23,16 +23,52 @@
 #	include "zbxsysinfo.h"
 #	include "log.h"
 #else
+static const char	*mutex_names[ZBX_MUTEX_CACHE_SHARD] = {"ZBX_MUTEX_LOG", "ZBX_MUTEX_CACHE",
+		"ZBX_MUTEX_TRENDS", "ZBX_MUTEX_CACHE_IDS", "ZBX_MUTEX_SELFMON", "ZBX_MUTEX_CPUSTATS",
+		"ZBX_MUTEX_DISKSTATS", "ZBX_MUTEX_VALUECACHE", "ZBX_MUTEX_VMWARE", "ZBX_MUTEX_SQLITE3",
+		"ZBX_MUTEX_PROCSTAT", "ZBX_MUTEX_PROXY_HISTORY",
+#ifdef HAVE_VMINFO_T_UPDATES
+		"ZBX_MUTEX_KSTAT",
+#endif
+		"ZBX_MUTEX_MODBUS", "ZBX_MUTEX_TREND_FUNC", "ZBX_MUTEX_CACHE_INGEST", "ZBX_MUTEX_PROXY_BUFFER",
+		"ZBX_MUTEX_TLS_SESSION"};
+
+static const char	*rwlock_names[ZBX_RWLOCK_COUNT] = {"ZBX_RWLOCK_CONFIG", "ZBX_RWLOCK_CONFIG_HISTORY",
+		"ZBX_RWLOCK_VALUECACHE"};
+
 #ifdef HAVE_PTHREAD_PROCESS_SHARED
+/* Lock usage is accounted in shared memory next to the locks. Exclusive locks update their */
+/* statistics while being held, so only read locks need atomic operations.                 */
+typedef struct
+{
+	zbx_lock_stats_t	stats;
+	zbx_uint64_t		locked_ns;	/* acquisition time of the exclusive lock holder */
+}
+zbx_lock_usage_t;
+
 typedef struct
 {
 	pthread_mutex_t		mutexes[ZBX_MUTEX_COUNT];
 	pthread_rwlock_t	rwlocks[ZBX_RWLOCK_COUNT];
+	zbx_lock_usage_t	mutex_usage[ZBX_MUTEX_COUNT];
+	zbx_lock_usage_t	rwlock_usage[ZBX_RWLOCK_COUNT];		/* write locks */
+	zbx_lock_stats_t	rwlock_rd_stats[ZBX_RWLOCK_COUNT];	/* read locks */
 }
 zbx_shared_lock_t;
 
 static zbx_shared_lock_t	*shared_lock;
 static int			shm_id, locks_disabled;
+
+/* acquisition times of read locks held by the thread */
+static ZBX_THREAD_LOCAL zbx_uint64_t	rwlock_rdlocked_ns[ZBX_RWLOCK_COUNT];
+
+#if defined(HAVE_ATOMIC_BUILTINS)
+#	define LOCK_STATS_ADD(counter, value)	zbx_atomic_add(&counter, value)
+#	define LOCK_STATS_GET(counter)		zbx_atomic_load(&counter)
+#else
+#	define LOCK_STATS_ADD(counter, value)	counter += value
+#	define LOCK_STATS_GET(counter)		counter
+#endif
 #else
 #	if !HAVE_SEMUN
 		union semun
@@ -257,6 +293,113 @@ int	zbx_rwlock_create(zbx_rwlock_t *rwlock, zbx_rwlock_name_t name, char **error
 	return SUCCEED;
 }
 #ifdef HAVE_PTHREAD_PROCESS_SHARED
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get monotonic time for lock usage accounting                      *
+ *                                                                            *
+ * Return value: time in nanoseconds                                          *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint64_t	lock_time_ns(void)
+{
+#ifdef HAVE_TIME_CLOCK_GETTIME
+	struct timespec	ts;
+
+	if (0 == clock_gettime(CLOCK_MONOTONIC, &ts))
+		return (zbx_uint64_t)ts.tv_sec * 1000000000 + (zbx_uint64_t)ts.tv_nsec;
+#endif
+	{
+		struct timeval	tv;
+
+		gettimeofday(&tv, NULL);
+
+		return (zbx_uint64_t)tv.tv_sec * 1000000000 + (zbx_uint64_t)tv.tv_usec * 1000;
+	}
+}
+
+static int	lock_hold_bucket(zbx_uint64_t ns)
+{
+	int	bucket;
+
+	for (bucket = 0; ZBX_LOCK_HOLD_BUCKETS_NUM - 1 > bucket && 0 != (ns >> bucket); bucket++)
+		;
+
+	return bucket;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: account acquired exclusive lock                                   *
+ *                                                                            *
+ * Parameters: usage     - [IN/OUT] lock usage                                *
+ *             start_ns  - [IN] time when the acquisition was started         *
+ *             contended - [IN] 1 - the lock was busy, 0 - otherwise          *
+ *                                                                            *
+ * Comments: Must be called while holding the lock.                           *
+ *                                                                            *
+ ******************************************************************************/
+static void	lock_usage_acquired(zbx_lock_usage_t *usage, zbx_uint64_t start_ns, int contended)
+{
+	usage->stats.locks++;
+	usage->locked_ns = start_ns;
+
+	if (0 != contended)
+	{
+		zbx_uint64_t	wait_ns;
+
+		usage->locked_ns = lock_time_ns();
+		wait_ns = usage->locked_ns - start_ns;
+
+		usage->stats.contended++;
+		usage->stats.wait_ns += wait_ns;
+
+		if (usage->stats.wait_max_ns < wait_ns)
+			usage->stats.wait_max_ns = wait_ns;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: account released exclusive lock                                   *
+ *                                                                            *
+ * Parameters: usage - [IN/OUT] lock usage                                    *
+ *                                                                            *
+ * Comments: Must be called before the lock is released.                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	lock_usage_released(zbx_lock_usage_t *usage)
+{
+	zbx_uint64_t	hold_ns;
+
+	if (0 == usage->locked_ns)
+		return;
+
+	hold_ns = lock_time_ns() - usage->locked_ns;
+	usage->locked_ns = 0;
+
+	usage->stats.hold_ns += hold_ns;
+	usage->stats.hold_buckets[lock_hold_bucket(hold_ns)]++;
+}
+
+static zbx_lock_usage_t	*mutex_usage_get(zbx_mutex_t mutex)
+{
+	if (NULL == shared_lock || mutex < shared_lock->mutexes || mutex >= shared_lock->mutexes + ZBX_MUTEX_COUNT)
+		return NULL;
+
+	return &shared_lock->mutex_usage[mutex - shared_lock->mutexes];
+}
+
+static int	rwlock_index_get(zbx_rwlock_t rwlock)
+{
+	if (NULL == shared_lock || rwlock < shared_lock->rwlocks ||
+			rwlock >= shared_lock->rwlocks + ZBX_RWLOCK_COUNT)
+	{
+		return FAIL;
+	}
+
+	return (int)(rwlock - shared_lock->rwlocks);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: acquire write lock for read-write lock (exclusive access)         *
@@ -268,17 +411,82 @@ int	zbx_rwlock_create(zbx_rwlock_t *rwlock, zbx_rwlock_name_t name, char **error
  ******************************************************************************/
 void	__zbx_rwlock_wrlock(const char *filename, int line, zbx_rwlock_t rwlock)
 {
+	int		err, index, contended = 0;
+	zbx_uint64_t	start_ns;
+
 	if (ZBX_RWLOCK_NULL == rwlock)
 		return;
 
 	if (0 != locks_disabled)
 		return;
 
-	if (0 != pthread_rwlock_wrlock(rwlock))
+	start_ns = lock_time_ns();
+
+	if (EBUSY == (err = pthread_rwlock_trywrlock(rwlock)))
+	{
+		contended = 1;
+		err = pthread_rwlock_wrlock(rwlock);
+	}
+
+	if (0 != err)
 	{
-		zbx_error("[file:'%s',line:%d] write lock failed: %s", filename, line, zbx_strerror(errno));
+		zbx_error("[file:'%s',line:%d] write lock failed: %s", filename, line, zbx_strerror(err));
 		exit(EXIT_FAILURE);
 	}
+
+	if (FAIL != (index = rwlock_index_get(rwlock)))
+		lock_usage_acquired(&shared_lock->rwlock_usage[index], start_ns, contended);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: account acquired read lock                                        *
+ *                                                                            *
+ * Parameters: index     - [IN] read-write lock index                         *
+ *             start_ns  - [IN] time when the acquisition was started         *
+ *             contended - [IN] 1 - the lock was busy, 0 - otherwise          *
+ *                                                                            *
+ ******************************************************************************/
+static void	rwlock_rd_acquired(int index, zbx_uint64_t start_ns, int contended)
+{
+	zbx_lock_stats_t	*stats = &shared_lock->rwlock_rd_stats[index];
+
+	LOCK_STATS_ADD(stats->locks, 1);
+	rwlock_rdlocked_ns[index] = start_ns;
+
+	if (0 != contended)
+	{
+		zbx_uint64_t	wait_ns;
+
+		rwlock_rdlocked_ns[index] = lock_time_ns();
+		wait_ns = rwlock_rdlocked_ns[index] - start_ns;
+
+		LOCK_STATS_ADD(stats->contended, 1);
+		LOCK_STATS_ADD(stats->wait_ns, wait_ns);
+
+		/* readers can update the maximum concurrently, so it is approximate */
+		if (stats->wait_max_ns < wait_ns)
+			stats->wait_max_ns = wait_ns;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: account released read lock                                        *
+ *                                                                            *
+ * Parameters: index - [IN] read-write lock index                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	rwlock_rd_released(int index)
+{
+	zbx_lock_stats_t	*stats = &shared_lock->rwlock_rd_stats[index];
+	zbx_uint64_t		hold_ns;
+
+	hold_ns = lock_time_ns() - rwlock_rdlocked_ns[index];
+	rwlock_rdlocked_ns[index] = 0;
+
+	LOCK_STATS_ADD(stats->hold_ns, hold_ns);
+	LOCK_STATS_ADD(stats->hold_buckets[lock_hold_bucket(hold_ns)], 1);
 }
 
 /******************************************************************************
@@ -292,17 +500,31 @@ void	__zbx_rwlock_wrlock(const char *filename, int line, zbx_rwlock_t rwlock)
  ******************************************************************************/
 void	__zbx_rwlock_rdlock(const char *filename, int line, zbx_rwlock_t rwlock)
 {
+	int		err, index, contended = 0;
+	zbx_uint64_t	start_ns;
+
 	if (ZBX_RWLOCK_NULL == rwlock)
 		return;
 
 	if (0 != locks_disabled)
 		return;
 
-	if (0 != pthread_rwlock_rdlock(rwlock))
+	start_ns = lock_time_ns();
+
+	if (EBUSY == (err = pthread_rwlock_tryrdlock(rwlock)))
+	{
+		contended = 1;
+		err = pthread_rwlock_rdlock(rwlock);
+	}
+
+	if (0 != err)
 	{
-		zbx_error("[file:'%s',line:%d] read lock failed: %s", filename, line, zbx_strerror(errno));
+		zbx_error("[file:'%s',line:%d] read lock failed: %s", filename, line, zbx_strerror(err));
 		exit(EXIT_FAILURE);
 	}
+
+	if (FAIL != (index = rwlock_index_get(rwlock)))
+		rwlock_rd_acquired(index, start_ns, contended);
 }
 
 /******************************************************************************
@@ -316,12 +538,23 @@ void	__zbx_rwlock_rdlock(const char *filename, int line, zbx_rwlock_t rwlock)
  ******************************************************************************/
 void	__zbx_rwlock_unlock(const char *filename, int line, zbx_rwlock_t rwlock)
 {
+	int	index;
+
 	if (ZBX_RWLOCK_NULL == rwlock)
 		return;
 
 	if (0 != locks_disabled)
 		return;
 
+	if (FAIL != (index = rwlock_index_get(rwlock)))
+	{
+		/* a thread holding read lock cannot hold write lock of the same read-write lock */
+		if (0 != rwlock_rdlocked_ns[index])
+			rwlock_rd_released(index);
+		else
+			lock_usage_released(&shared_lock->rwlock_usage[index]);
+	}
+
 	if (0 != pthread_rwlock_unlock(rwlock))
 	{
 		zbx_error("[file:'%s',line:%d] read-write lock unlock failed: %s", filename, line, zbx_strerror(errno));
@@ -367,6 +600,143 @@ void	zbx_locks_enable(void)
 }
 
 #endif
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get lock name                                                     *
+ *                                                                            *
+ * Parameters: lock - [IN] lock index (mutex name or ZBX_MUTEX_COUNT + rwlock *
+ *                         name)                                              *
+ *             name - [OUT] lock name                                         *
+ *             size - [IN] size of name buffer                                *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_lock_name_get(int lock, char *name, size_t size)
+{
+	if (0 > lock || ZBX_LOCKS_NUM <= lock)
+		zbx_strlcpy(name, "unknown", size);
+	else if (ZBX_MUTEX_CACHE_SHARD > lock)
+		zbx_strlcpy(name, mutex_names[lock], size);
+	else if (ZBX_MUTEX_CACHE_SHARD_LAST >= lock)
+		zbx_snprintf(name, size, "ZBX_MUTEX_CACHE_SHARD_%d", lock - ZBX_MUTEX_CACHE_SHARD + 1);
+	else if (ZBX_MUTEX_VALUECACHE_ITEM_LAST >= lock)
+		zbx_snprintf(name, size, "ZBX_MUTEX_VALUECACHE_ITEM_%d", lock - ZBX_MUTEX_VALUECACHE_ITEM + 1);
+	else
+		zbx_strlcpy(name, rwlock_names[lock - ZBX_MUTEX_COUNT], size);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get lock index by its name                                        *
+ *                                                                            *
+ * Return value: lock index or FAIL if the name is unknown                    *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_lock_get_by_name(const char *name)
+{
+	char	buf[64];
+
+	for (int i = 0; i < ZBX_LOCKS_NUM; i++)
+	{
+		zbx_lock_name_get(i, buf, sizeof(buf));
+
+		if (0 == strcmp(buf, name))
+			return i;
+	}
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get lock usage statistics                                         *
+ *                                                                            *
+ * Parameters: lock  - [IN] lock index                                        *
+ *             stats - [OUT] lock usage statistics                            *
+ *                                                                            *
+ * Return value: SUCCEED - statistics were returned                           *
+ *               FAIL    - lock usage is not accounted                        *
+ *                                                                            *
+ * Comments: Statistics of read and write locks are summed up. Counters are   *
+ *           read without locking, so the snapshot might be inconsistent.     *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_lock_get_stats(int lock, zbx_lock_stats_t *stats)
+{
+#ifdef HAVE_PTHREAD_PROCESS_SHARED
+	const zbx_lock_stats_t	*src, *src_rd = NULL;
+
+	if (NULL == shared_lock || 0 > lock || ZBX_LOCKS_NUM <= lock)
+		return FAIL;
+
+	if (ZBX_MUTEX_COUNT > lock)
+	{
+		src = &shared_lock->mutex_usage[lock].stats;
+	}
+	else
+	{
+		src = &shared_lock->rwlock_usage[lock - ZBX_MUTEX_COUNT].stats;
+		src_rd = &shared_lock->rwlock_rd_stats[lock - ZBX_MUTEX_COUNT];
+	}
+
+	*stats = *src;
+
+	if (NULL != src_rd)
+	{
+		stats->locks += LOCK_STATS_GET(src_rd->locks);
+		stats->contended += LOCK_STATS_GET(src_rd->contended);
+		stats->wait_ns += LOCK_STATS_GET(src_rd->wait_ns);
+		stats->hold_ns += LOCK_STATS_GET(src_rd->hold_ns);
+
+		if (stats->wait_max_ns < src_rd->wait_max_ns)
+			stats->wait_max_ns = src_rd->wait_max_ns;
+
+		for (int i = 0; i < ZBX_LOCK_HOLD_BUCKETS_NUM; i++)
+			stats->hold_buckets[i] += LOCK_STATS_GET(src_rd->hold_buckets[i]);
+	}
+
+	return SUCCEED;
+#else
+	ZBX_UNUSED(lock);
+	ZBX_UNUSED(stats);
+
+	return FAIL;
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: estimate lock hold time percentile from hold time histogram       *
+ *                                                                            *
+ * Parameters: stats      - [IN] lock usage statistics                        *
+ *             percentile - [IN] percentile (0-100)                           *
+ *                                                                            *
+ * Return value: upper bound of the histogram bucket containing the           *
+ *               percentile in seconds or 0 if the lock was not released yet  *
+ *                                                                            *
+ ******************************************************************************/
+double	zbx_lock_stats_hold_percentile(const zbx_lock_stats_t *stats, double percentile)
+{
+	zbx_uint64_t	total = 0, rank, sum = 0;
+	int		i;
+
+	for (i = 0; i < ZBX_LOCK_HOLD_BUCKETS_NUM; i++)
+		total += stats->hold_buckets[i];
+
+	if (0 == total)
+		return 0.0;
+
+	if (1 > (rank = (zbx_uint64_t)ceil((double)total * percentile / 100.0)))
+		rank = 1;
+
+	for (i = 0; i < ZBX_LOCK_HOLD_BUCKETS_NUM - 1; i++)
+	{
+		if (rank <= (sum += stats->hold_buckets[i]))
+			break;
+	}
+
+	return (double)((zbx_uint64_t)1 << i) / 1000000000.0;
+}
 #endif	/* _WINDOWS */
 
 /******************************************************************************
@@ -415,6 +785,10 @@ void	__zbx_mutex_lock(const char *filename, int line, zbx_mutex_t mutex)
 #ifndef _WINDOWS
 #ifndef	HAVE_PTHREAD_PROCESS_SHARED
 	struct sembuf	sem_lock;
+#else
+	int			err, contended = 0;
+	zbx_uint64_t		start_ns;
+	zbx_lock_usage_t	*usage;
 #endif
 #else
 	DWORD   dwWaitResult;
@@ -451,11 +825,22 @@ void	__zbx_mutex_lock(const char *filename, int line, zbx_mutex_t mutex)
 	if (0 != locks_disabled)
 		return;
 
-	if (0 != pthread_mutex_lock(mutex))
+	start_ns = lock_time_ns();
+
+	if (EBUSY == (err = pthread_mutex_trylock(mutex)))
 	{
-		zbx_error("[file:'%s',line:%d] lock failed: %s", filename, line, zbx_strerror(errno));
+		contended = 1;
+		err = pthread_mutex_lock(mutex);
+	}
+
+	if (0 != err)
+	{
+		zbx_error("[file:'%s',line:%d] lock failed: %s", filename, line, zbx_strerror(err));
 		exit(EXIT_FAILURE);
 	}
+
+	if (NULL != (usage = mutex_usage_get(mutex)))
+		lock_usage_acquired(usage, start_ns, contended);
 #else
 	sem_lock.sem_num = mutex;
 	sem_lock.sem_op = -1;
@@ -487,6 +872,8 @@ void	__zbx_mutex_unlock(const char *filename, int line, zbx_mutex_t mutex)
 #ifndef _WINDOWS
 #ifndef	HAVE_PTHREAD_PROCESS_SHARED
 	struct sembuf	sem_unlock;
+#else
+	zbx_lock_usage_t	*usage;
 #endif
 #endif
 
@@ -505,6 +892,9 @@ void	__zbx_mutex_unlock(const char *filename, int line, zbx_mutex_t mutex)
 	if (0 != locks_disabled)
 		return;
 
+	if (NULL != (usage = mutex_usage_get(mutex)))
+		lock_usage_released(usage);
+
 	if (0 != pthread_mutex_unlock(mutex))
 	{
 		zbx_error("[file:'%s',line:%d] unlock failed: %s", filename, line, zbx_strerror(errno));
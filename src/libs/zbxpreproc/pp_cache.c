@@ -22,6 +22,7 @@
 #include "pp_cache.h"
 #include "zbxjson.h"
 #include "zbxprometheus.h"
+#include "zbxxml.h"
 #include "preproc_snmp.h"
 
 /******************************************************************************
@@ -69,6 +70,10 @@ static void	pp_cache_free(zbx_pp_cache_t *cache)
 			case ZBX_PREPROC_SNMP_WALK_TO_VALUE:
 				zbx_snmp_value_cache_clear((zbx_snmp_value_cache_t *)cache->data);
 				break;
+			case ZBX_PREPROC_XPATH:
+				zbx_xml_doc_free((zbx_xml_doc_t *)cache->data);
+				cache->data = NULL;
+				break;
 		}
 
 		zbx_free(cache->data);
@@ -146,6 +151,7 @@ int	pp_cache_is_supported(zbx_pp_item_preproc_t *preproc)
 			case ZBX_PREPROC_JSONPATH:
 			case ZBX_PREPROC_PROMETHEUS_PATTERN:
 			case ZBX_PREPROC_SNMP_WALK_TO_VALUE:
+			case ZBX_PREPROC_XPATH:
 				return SUCCEED;
 		}
 	}
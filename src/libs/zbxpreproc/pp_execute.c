@@ -226,45 +226,73 @@ static int	pp_execute_regsub(zbx_variant_t *value, const char *params)
 	return FAIL;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: execute jsonpath query on json text without caching it            *
+ *                                                                            *
+ * Parameters: text   - [IN] json text                                        *
+ *             step   - [IN] the jsonpath step                                *
+ *             data   - [OUT] the query result                                *
+ *             errmsg - [OUT]                                                 *
+ *                                                                            *
+ * Result value: SUCCEED - the query was executed successfully.               *
+ *               FAIL    - otherwise.                                         *
+ *                                                                            *
+ * Comments: The json text is not modified, so it can be shared with other   *
+ *           preprocessing workers.                                           *
+ *                                                                            *
+ ******************************************************************************/
+static int	pp_jsonpath_query_text(const char *text, const zbx_pp_step_t *step, char **data, char **errmsg)
+{
+	zbx_jsonobj_t	obj;
+	int		ret;
+
+	/* the value is queried once, so parse only the part of it traversed by the query */
+	if (FAIL == zbx_jsonobj_open_lazy(text, &obj))
+	{
+		*errmsg = zbx_strdup(*errmsg, zbx_json_strerror());
+		return FAIL;
+	}
+
+	if (NULL != step->jsonpath)
+		ret = zbx_jsonobj_query_ext(&obj, step->jsonpath, data);
+	else
+		ret = zbx_jsonobj_query(&obj, step->params, data);
+
+	if (FAIL == ret)
+		*errmsg = zbx_strdup(*errmsg, zbx_json_strerror());
+
+	zbx_jsonobj_clear(&obj);
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: execute jsonpath query                                            *
  *                                                                            *
  * Parameters: cache  - [IN] preprocessing cache                              *
  *             value  - [IN/OUT] value to process                             *
- *             params - [IN] step parameters                                  *
+ *             step   - [IN] the jsonpath step                                *
  *             errmsg - [OUT]                                                 *
  *                                                                            *
  * Result value: SUCCEED - the query was executed successfully.               *
  *               FAIL    - otherwise.                                         *
  *                                                                            *
  ******************************************************************************/
-static int	pp_excute_jsonpath_query(zbx_pp_cache_t *cache, zbx_variant_t *value, const char *params,
+static int	pp_excute_jsonpath_query(zbx_pp_cache_t *cache, zbx_variant_t *value, const zbx_pp_step_t *step,
 		char **errmsg)
 {
 	char	*data = NULL;
+	int	ret;
 
 	if (NULL == cache || ZBX_PREPROC_JSONPATH != cache->type)
 	{
-		zbx_jsonobj_t	obj;
-
 		if (FAIL == item_preproc_convert_value(value, ZBX_VARIANT_STR, errmsg))
 			return FAIL;
 
-		if (FAIL == zbx_jsonobj_open(value->data.str, &obj))
-		{
-			*errmsg = zbx_strdup(*errmsg, zbx_json_strerror());
-			return FAIL;
-		}
-
-		if (FAIL == zbx_jsonobj_query(&obj, params, &data))
-		{
-			zbx_jsonobj_clear(&obj);
-			*errmsg = zbx_strdup(*errmsg, zbx_json_strerror());
+		if (FAIL == pp_jsonpath_query_text(value->data.str, step, &data, errmsg))
 			return FAIL;
-		}
-
-		zbx_jsonobj_clear(&obj);
 	}
 	else
 	{
@@ -277,7 +305,11 @@ static int	pp_excute_jsonpath_query(zbx_pp_cache_t *cache, zbx_variant_t *value,
 
 			obj = (zbx_jsonobj_t *)zbx_malloc(NULL, sizeof(zbx_jsonobj_t));
 
-			if (SUCCEED != zbx_jsonobj_open(value->data.str, obj))
+			/* Cached object is parsed fully as it's queried by other preprocessing */
+			/* workers at the same time, while lazy parsing modifies the object.    */
+			/* It is allocated in arena to be freed at once with the cache.         */
+
+			if (SUCCEED != zbx_jsonobj_open_arena(value->data.str, obj))
 			{
 				*errmsg = zbx_strdup(*errmsg, zbx_json_strerror());
 				zbx_free(obj);
@@ -288,7 +320,12 @@ static int	pp_excute_jsonpath_query(zbx_pp_cache_t *cache, zbx_variant_t *value,
 			cache->data = (void *)obj;
 		}
 
-		if (FAIL == zbx_jsonobj_query(obj, params, &data))
+		if (NULL != step->jsonpath)
+			ret = zbx_jsonobj_query_ext(obj, step->jsonpath, &data);
+		else
+			ret = zbx_jsonobj_query(obj, step->params, &data);
+
+		if (FAIL == ret)
 		{
 			*errmsg = zbx_strdup(*errmsg, zbx_json_strerror());
 			return FAIL;
@@ -315,22 +352,60 @@ static int	pp_excute_jsonpath_query(zbx_pp_cache_t *cache, zbx_variant_t *value,
  *                                                                            *
  * Parameters: cache  - [IN] preprocessing cache                              *
  *             value  - [IN/OUT] value to process                             *
- *             params - [IN] step parameters                                  *
+ *             step   - [IN] the jsonpath step                                *
  *                                                                            *
  * Result value: SUCCEED - the preprocessing step was executed successfully.  *
  *               FAIL    - otherwise. The error message is stored in value.   *
  *                                                                            *
  ******************************************************************************/
-static int	pp_execute_jsonpath(zbx_pp_cache_t *cache, zbx_variant_t *value, const char *params)
+static int	pp_execute_jsonpath(zbx_pp_cache_t *cache, zbx_variant_t *value, const zbx_pp_step_t *step)
 {
 	char	*errmsg = NULL;
 
-	if (SUCCEED == pp_excute_jsonpath_query(cache, value, params, &errmsg))
+	if (SUCCEED == pp_excute_jsonpath_query(cache, value, step, &errmsg))
 		return SUCCEED;
 
 	zbx_variant_clear(value);
-	zbx_variant_set_error(value, zbx_dsprintf(NULL, "cannot extract value from json by path \"%s\": %s", params,
-			errmsg));
+	zbx_variant_set_error(value, zbx_dsprintf(NULL, "cannot extract value from json by path \"%s\": %s",
+			step->params, errmsg));
+
+	zbx_free(errmsg);
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: execute 'jsonpath' step on value shared with other dependent      *
+ *          items                                                             *
+ *                                                                            *
+ * Parameters: value     - [IN] shared string value, it is not modified       *
+ *             step      - [IN] the jsonpath step                             *
+ *             value_out - [OUT] the step result                              *
+ *                                                                            *
+ * Result value: SUCCEED - the preprocessing step was executed successfully.  *
+ *               FAIL    - otherwise. The error message is stored in          *
+ *                         value_out.                                         *
+ *                                                                            *
+ ******************************************************************************/
+static int	pp_execute_jsonpath_shared(const zbx_variant_t *value, const zbx_pp_step_t *step,
+		zbx_variant_t *value_out)
+{
+	char	*errmsg = NULL, *data = NULL;
+
+	if (SUCCEED == pp_jsonpath_query_text(value->data.str, step, &data, &errmsg))
+	{
+		if (NULL != data)
+		{
+			zbx_variant_set_str(value_out, data);
+			return SUCCEED;
+		}
+
+		errmsg = zbx_strdup(errmsg, "no data matches the specified path");
+	}
+
+	zbx_variant_set_error(value_out, zbx_dsprintf(NULL, "cannot extract value from json by path \"%s\": %s",
+			step->params, errmsg));
 
 	zbx_free(errmsg);
 
@@ -391,50 +466,77 @@ static int	pp_execute_2dec(int type, zbx_variant_t *value)
  *                                                                            *
  * Purpose: execute xpath query                                               *
  *                                                                            *
- * Parameters: value  - [IN/OUT] value to process                             *
- *             params - [IN] step parameters                                  *
- *             error  - [OUT]                                                 *
+ * Parameters: cache  - [IN] preprocessing cache                              *
+ *             value  - [IN/OUT] value to process                             *
+ *             step   - [IN] the xpath step                                   *
+ *             errmsg - [OUT]                                                 *
  *                                                                            *
  * Result value: SUCCEED - the query was executed successfully.               *
  *               FAIL    - otherwise.                                         *
  *                                                                            *
  ******************************************************************************/
-static int	pp_execute_xpath_query(zbx_variant_t *value, const char *params, char **error)
+static int	pp_execute_xpath_query(zbx_pp_cache_t *cache, zbx_variant_t *value, const zbx_pp_step_t *step,
+		char **errmsg)
 {
-	char	*errmsg = NULL;
+	zbx_xml_doc_t	*doc;
+	int		ret;
 
-	if (FAIL == item_preproc_convert_value(value, ZBX_VARIANT_STR, error))
-		return FAIL;
+	if (NULL == cache || ZBX_PREPROC_XPATH != cache->type)
+	{
+		if (FAIL == item_preproc_convert_value(value, ZBX_VARIANT_STR, errmsg))
+			return FAIL;
 
-	if (SUCCEED == zbx_query_xpath(value, params, &errmsg))
-		return SUCCEED;
+		if (SUCCEED != zbx_xml_doc_parse(value->data.str, &doc, errmsg))
+			return FAIL;
 
-	*error = zbx_dsprintf(NULL, "cannot extract XML value with xpath \"%s\": %s", params, errmsg);
-	zbx_free(errmsg);
+		ret = zbx_xml_doc_query_xpath(doc, step->params, step->xpath, value, errmsg);
+		zbx_xml_doc_free(doc);
 
-	return FAIL;
+		return ret;
+	}
+
+	if (NULL == (doc = (zbx_xml_doc_t *)cache->data))
+	{
+		if (FAIL == item_preproc_convert_value(value, ZBX_VARIANT_STR, errmsg))
+			return FAIL;
+
+		/* the parsed document is queried by other preprocessing workers without modifying it */
+		if (SUCCEED != zbx_xml_doc_parse(value->data.str, &doc, errmsg))
+		{
+			cache->type = ZBX_PREPROC_NONE;
+			return FAIL;
+		}
+
+		cache->data = (void *)doc;
+	}
+
+	return zbx_xml_doc_query_xpath(doc, step->params, step->xpath, value, errmsg);
 }
 
 /******************************************************************************
  *                                                                            *
  * Purpose: execute 'xpath' step                                              *
  *                                                                            *
- * Parameters: value  - [IN/OUT] value to process                             *
- *             params - [IN] step parameters                                  *
+ * Parameters: cache  - [IN] preprocessing cache                              *
+ *             value  - [IN/OUT] value to process                             *
+ *             step   - [IN] the xpath step                                   *
  *                                                                            *
  * Result value: SUCCEED - the preprocessing step was executed successfully.  *
  *               FAIL    - otherwise. The error message is stored in value.   *
  *                                                                            *
  ******************************************************************************/
-static int	pp_execute_xpath(zbx_variant_t *value, const char *params)
+static int	pp_execute_xpath(zbx_pp_cache_t *cache, zbx_variant_t *value, const zbx_pp_step_t *step)
 {
 	char	*errmsg = NULL;
 
-	if (SUCCEED == pp_execute_xpath_query(value, params, &errmsg))
+	if (SUCCEED == pp_execute_xpath_query(cache, value, step, &errmsg))
 		return SUCCEED;
 
 	zbx_variant_clear(value);
-	zbx_variant_set_error(value, errmsg);
+	zbx_variant_set_error(value, zbx_dsprintf(NULL, "cannot extract XML value with xpath \"%s\": %s",
+			step->params, errmsg));
+
+	zbx_free(errmsg);
 
 	return FAIL;
 }
@@ -640,11 +742,40 @@ static int	pp_throttle_timed_value(zbx_variant_t *value, zbx_timespec_t ts, cons
 static int	pp_execute_script(zbx_pp_context_t *ctx, zbx_variant_t *value, const char *params,
 		zbx_variant_t *history_value)
 {
-	char	*errmsg = NULL;
+	char		*errmsg = NULL;
+	int		ret, compile = 0;
+	zbx_es_t	*es;
 
-	if (SUCCEED == item_preproc_script(pp_context_es_engine(ctx), value, params, history_value, &errmsg))
-		return SUCCEED;
+	es = pp_context_es_engine(ctx);
+
+	/* initialize environment beforehand to detect when it's reset after fatal error */
+	if (SUCCEED != zbx_es_is_env_initialized(es) && SUCCEED != zbx_es_init_env(es, &errmsg))
+		goto out;
 
+	ctx->es_reset = 0;
+
+	if (NULL != ctx->scripts && ZBX_VARIANT_BIN != history_value->type)
+	{
+		if (SUCCEED != pp_script_cache_get(ctx->scripts, params, history_value))
+			compile = 1;
+	}
+
+	ret = item_preproc_script(es, value, params, history_value, &errmsg);
+
+	if (0 != compile)
+		pp_script_cache_put(ctx->scripts, params, history_value);
+
+	if (SUCCEED != zbx_es_is_env_initialized(es))
+	{
+		ctx->es_reset = 1;
+
+		if (NULL != ctx->scripts)
+			pp_script_cache_add_reset(ctx->scripts);
+	}
+
+	if (SUCCEED == ret)
+		return SUCCEED;
+out:
 	zbx_variant_clear(value);
 	zbx_variant_set_error(value, errmsg);
 
@@ -657,20 +788,20 @@ static int	pp_execute_script(zbx_pp_context_t *ctx, zbx_variant_t *value, const
  *                                                                            *
  * Parameters: cache  - [IN] preprocessing cache                              *
  *             value  - [IN/OUT] value to process                             *
- *             params - [IN] step parameters                                  *
+ *             step   - [IN] the prometheus pattern step                      *
  *             errmsg - [OUT]                                                 *
  *                                                                            *
  * Return value: SUCCEED - the query was performed successfully               *
  *               FAIL - otherwise                                             *
  *                                                                            *
  ******************************************************************************/
-static int	pp_execute_prometheus_query(zbx_pp_cache_t *cache, zbx_variant_t *value, const char *params,
+static int	pp_execute_prometheus_query(zbx_pp_cache_t *cache, zbx_variant_t *value, const zbx_pp_step_t *step,
 		char **errmsg)
 {
 	char	*pattern, *request, *output, *value_out = NULL, *err = NULL;
 	int	ret = FAIL;
 
-	pattern = zbx_strdup(NULL, params);
+	pattern = zbx_strdup(NULL, step->params);
 
 	if (NULL == (request = strchr(pattern, '\n')))
 	{
@@ -714,7 +845,13 @@ static int	pp_execute_prometheus_query(zbx_pp_cache_t *cache, zbx_variant_t *val
 			cache->data = (void *)prom_cache;
 		}
 
-		ret = zbx_prometheus_pattern_ex(prom_cache, pattern, request, output, &value_out, &err);
+		if (NULL != step->prometheus)
+		{
+			ret = zbx_prometheus_pattern_prepared(prom_cache, step->prometheus, request, output, &value_out,
+					&err);
+		}
+		else
+			ret = zbx_prometheus_pattern_ex(prom_cache, pattern, request, output, &value_out, &err);
 	}
 out:
 	zbx_free(pattern);
@@ -738,19 +875,19 @@ out:
  *                                                                            *
  * Purpose: execute 'prometheus pattern' step                                 *
  *                                                                            *
- * Parameters: cache  - [IN] preprocessing cache                              *
- *             value  - [IN/OUT] value to process                             *
- *             params - [IN] step parameters                                  *
+ * Parameters: cache - [IN] preprocessing cache                               *
+ *             value - [IN/OUT] value to process                              *
+ *             step  - [IN] the prometheus pattern step                       *
  *                                                                            *
  * Result value: SUCCEED - the preprocessing step was executed successfully.  *
  *               FAIL    - otherwise. The error message is stored in value.   *
  *                                                                            *
  ******************************************************************************/
-static int	pp_execute_prometheus_pattern(zbx_pp_cache_t *cache, zbx_variant_t *value, const char *params)
+static int	pp_execute_prometheus_pattern(zbx_pp_cache_t *cache, zbx_variant_t *value, const zbx_pp_step_t *step)
 {
 	char	*errmsg = NULL;
 
-	if (SUCCEED == pp_execute_prometheus_query(cache, value, params, &errmsg))
+	if (SUCCEED == pp_execute_prometheus_query(cache, value, step, &errmsg))
 		return SUCCEED;
 
 	zbx_variant_clear(value);
@@ -952,10 +1089,10 @@ int	pp_execute_step(zbx_pp_context_t *ctx, zbx_pp_cache_t *cache, unsigned char
 			ret = pp_execute_delta(step->type, value_type, value, ts, history_value, history_ts);
 			goto out;
 		case ZBX_PREPROC_XPATH:
-			ret = pp_execute_xpath(value, step->params);
+			ret = pp_execute_xpath(cache, value, step);
 			goto out;
 		case ZBX_PREPROC_JSONPATH:
-			ret = pp_execute_jsonpath(cache, value, step->params);
+			ret = pp_execute_jsonpath(cache, value, step);
 			goto out;
 		case ZBX_PREPROC_VALIDATE_RANGE:
 			ret = pp_validate_range(value_type, value, step->params);
@@ -988,7 +1125,7 @@ int	pp_execute_step(zbx_pp_context_t *ctx, zbx_pp_cache_t *cache, unsigned char
 			ret = pp_execute_script(ctx, value, step->params, history_value);
 			goto out;
 		case ZBX_PREPROC_PROMETHEUS_PATTERN:
-			ret = pp_execute_prometheus_pattern(cache, value, step->params);
+			ret = pp_execute_prometheus_pattern(cache, value, step);
 			goto out;
 		case ZBX_PREPROC_PROMETHEUS_TO_JSON:
 			ret = pp_execute_prometheus_to_json(value, step->params);
@@ -1020,38 +1157,63 @@ out:
 	return ret;
 }
 
+/* preprocessing steps execution state of a single value */
+typedef struct
+{
+	zbx_pp_item_preproc_t	*preproc;
+	zbx_pp_cache_t		*cache;
+	zbx_variant_t		*value_in;
+	zbx_timespec_t		ts;
+	zbx_variant_t		*value_out;
+
+	/* cached value shared with other dependent items, the first step reads it */
+	/* directly instead of working on a private copy                           */
+	const zbx_variant_t	*value_shared;
+
+	zbx_pp_result_t		*results;
+	int			results_num;
+	zbx_pp_history_t	*history;
+	int			quote_error;
+	int			action;
+	zbx_variant_t		value_raw;
+	int			done;
+}
+zbx_pp_execution_t;
+
 /******************************************************************************
  *                                                                            *
- * Purpose: execute preprocessing steps                                       *
+ * Purpose: prepare value for preprocessing steps execution                   *
  *                                                                            *
- * Parameters: ctx             - [IN] worker specific execution context       *
- *             preproc         - [IN] item preprocessing data                 *
- *             cache           - [IN] preprocessing cache                     *
- *             value_in        - [IN]                                         *
- *             ts              - [IN] value timestamp                         *
- *             value_out       - [OUT]                                        *
- *             results_out     - [OUT] results for each step (optional)       *
- *             results_num_out - [OUT] number of results (optional)           *
+ * Parameters: ex        - [OUT] execution state                              *
+ *             preproc   - [IN] item preprocessing data                       *
+ *             cache     - [IN] preprocessing cache                           *
+ *             value_in  - [IN]                                               *
+ *             ts        - [IN] value timestamp                               *
+ *             value_out - [OUT]                                              *
  *                                                                            *
  ******************************************************************************/
-void	pp_execute(zbx_pp_context_t *ctx, zbx_pp_item_preproc_t *preproc, zbx_pp_cache_t *cache,
-		zbx_variant_t *value_in, zbx_timespec_t ts, zbx_variant_t *value_out, zbx_pp_result_t **results_out,
-		int *results_num_out)
+static void	pp_execution_init(zbx_pp_execution_t *ex, zbx_pp_item_preproc_t *preproc, zbx_pp_cache_t *cache,
+		zbx_variant_t *value_in, zbx_timespec_t ts, zbx_variant_t *value_out)
 {
-	zbx_pp_result_t		*results;
-	zbx_pp_history_t	*history;
-	int			quote_error, results_num, action;
-	zbx_variant_t		value_raw;
-
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s(): value:%s type:%s", __func__,
-			zbx_variant_value_desc(NULL == cache ? value_in : &cache->value),
-			zbx_variant_type_desc(NULL == cache ? value_in : &cache->value));
+	ex->preproc = preproc;
+	ex->cache = cache;
+	ex->value_in = value_in;
+	ex->ts = ts;
+	ex->value_out = value_out;
+	ex->value_shared = NULL;
+	ex->results = NULL;
+	ex->results_num = 0;
+	ex->history = NULL;
+	ex->quote_error = 0;
+	ex->action = ZBX_PREPROC_FAIL_DEFAULT;
+	zbx_variant_set_none(&ex->value_raw);
 
 	if (NULL == preproc || 0 == preproc->steps_num)
 	{
 		zbx_variant_copy(value_out, NULL != cache ? &cache->value : value_in);
+		ex->done = 1;
 
-		goto out;
+		return;
 	}
 
 	if (NULL == cache)
@@ -1060,99 +1222,249 @@ void	pp_execute(zbx_pp_context_t *ctx, zbx_pp_item_preproc_t *preproc, zbx_pp_ca
 	}
 	else
 	{
-		/* preprocessing cache is enabled only for the first step, */
-		/* so prepare output value based on first step type        */
-		pp_cache_prepare_output_value(cache, preproc->steps[0].type, value_out);
+		/* Jsonpath step does not modify its input, so unless it's cached the first step */
+		/* can query the shared value. The value is copied only when the step must work */
+		/* on its own copy - this avoids copying large master item values for each      */
+		/* dependent item.                                                              */
+		if (ZBX_PREPROC_JSONPATH == preproc->steps[0].type && ZBX_PREPROC_JSONPATH != cache->type &&
+				ZBX_VARIANT_STR == cache->value.type)
+		{
+			ex->value_shared = &cache->value;
+		}
+		else
+		{
+			/* preprocessing cache is enabled only for the first step, */
+			/* so prepare output value based on first step type        */
+			pp_cache_prepare_output_value(cache, preproc->steps[0].type, value_out);
+		}
 
 		/* set input value for error reporting */
-		value_in = &cache->value;
+		ex->value_in = &cache->value;
 	}
 
-	results = (zbx_pp_result_t *)zbx_malloc(NULL, sizeof(zbx_pp_result_t) * (size_t)preproc->steps_num);
-	history = (0 != preproc->history_num ? zbx_pp_history_create(preproc->history_num) : NULL);
-	results_num = 0;
+	ex->results = (zbx_pp_result_t *)zbx_malloc(NULL, sizeof(zbx_pp_result_t) * (size_t)preproc->steps_num);
+	ex->history = (0 != preproc->history_num ? zbx_pp_history_create(preproc->history_num) : NULL);
+	ex->done = 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: execute the specified preprocessing step of value                 *
+ *                                                                            *
+ * Parameters: ctx   - [IN] worker specific execution context                 *
+ *             ex    - [IN/OUT] execution state                               *
+ *             index - [IN] the step index                                    *
+ *                                                                            *
+ * Comments: Steps must be executed in order, the execution is marked as done *
+ *           when the remaining steps must be skipped.                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	pp_execution_step(zbx_pp_context_t *ctx, zbx_pp_execution_t *ex, int index)
+{
+	zbx_pp_item_preproc_t	*preproc = ex->preproc;
+	zbx_pp_step_t		*step;
+	zbx_variant_t		history_value;
+	zbx_timespec_t		history_ts;
+	int			ret;
 
-	zbx_variant_set_none(&value_raw);
+	if (0 != ex->done)
+		return;
 
-	for (int i = 0; i < preproc->steps_num; i++)
+	if (index >= preproc->steps_num)
 	{
-		zbx_variant_t	history_value;
-		zbx_timespec_t	history_ts;
+		ex->done = 1;
+		return;
+	}
 
-		if (ZBX_VARIANT_ERR == value_out->type && ZBX_PREPROC_VALIDATE_NOT_SUPPORTED != preproc->steps[i].type)
-			break;
+	step = preproc->steps + index;
 
-		action = ZBX_PREPROC_FAIL_DEFAULT;
-		quote_error = 0;
+	if (ZBX_VARIANT_ERR == ex->value_out->type && ZBX_PREPROC_VALIDATE_NOT_SUPPORTED != step->type)
+	{
+		ex->done = 1;
+		return;
+	}
 
-		pp_history_pop(preproc->history, i, &history_value, &history_ts);
+	ex->action = ZBX_PREPROC_FAIL_DEFAULT;
+	ex->quote_error = 0;
 
-		if (SUCCEED != pp_execute_step(ctx, cache, preproc->value_type, value_out, ts, preproc->steps + i,
-				&history_value, &history_ts))
-		{
-			zbx_variant_copy(&value_raw, value_out);
-			if (ZBX_PREPROC_FAIL_DEFAULT == (action = pp_error_on_fail(value_out, preproc->steps + i)))
-				zbx_variant_clear(&value_raw);
-		}
-		else
-		{
-			if (ZBX_VARIANT_ERR == value_out->type)
-				quote_error = 1;
-		}
+	pp_history_pop(preproc->history, index, &history_value, &history_ts);
 
-		pp_result_set(results + results_num++, value_out, action, &value_raw);
-
-		if (NULL != history && ZBX_VARIANT_NONE != history_value.type && ZBX_VARIANT_ERR != value_out->type)
-		{
-			if (SUCCEED == zbx_pp_preproc_has_history(preproc->steps[i].type))
-				zbx_pp_history_add(history, i, &history_value, history_ts);
-		}
+	if (NULL != ex->value_shared)
+	{
+		ret = pp_execute_jsonpath_shared(ex->value_shared, step, ex->value_out);
+		ex->value_shared = NULL;
+	}
+	else
+	{
+		ret = pp_execute_step(ctx, ex->cache, preproc->value_type, ex->value_out, ex->ts, step, &history_value,
+				&history_ts);
+	}
 
-		zbx_variant_clear(&history_value);
+	if (SUCCEED != ret)
+	{
+		zbx_variant_copy(&ex->value_raw, ex->value_out);
+		if (ZBX_PREPROC_FAIL_DEFAULT == (ex->action = pp_error_on_fail(ex->value_out, step)))
+			zbx_variant_clear(&ex->value_raw);
+	}
+	else
+	{
+		if (ZBX_VARIANT_ERR == ex->value_out->type)
+			ex->quote_error = 1;
+	}
 
-		cache = NULL;
+	pp_result_set(ex->results + ex->results_num++, ex->value_out, ex->action, &ex->value_raw);
 
-		if (ZBX_VARIANT_NONE == value_out->type)
-			break;
+	if (NULL != ex->history && ZBX_VARIANT_NONE != history_value.type && ZBX_VARIANT_ERR != ex->value_out->type)
+	{
+		if (SUCCEED == zbx_pp_preproc_has_history(step->type))
+			zbx_pp_history_add(ex->history, index, &history_value, history_ts);
 	}
 
-	if (ZBX_VARIANT_ERR == value_out->type)
+	zbx_variant_clear(&history_value);
+
+	ex->cache = NULL;
+
+	if (ZBX_VARIANT_NONE == ex->value_out->type)
+		ex->done = 1;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: finish preprocessing steps execution of value                     *
+ *                                                                            *
+ * Parameters: ex              - [IN] execution state                         *
+ *             results_out     - [OUT] results for each step (optional)       *
+ *             results_num_out - [OUT] number of results (optional)           *
+ *                                                                            *
+ ******************************************************************************/
+static void	pp_execution_finish(zbx_pp_execution_t *ex, zbx_pp_result_t **results_out, int *results_num_out)
+{
+	if (NULL == ex->results)
+		return;
+
+	if (ZBX_VARIANT_ERR == ex->value_out->type)
 	{
 		/* reset preprocessing history in the case of error */
-		if (NULL != history)
+		if (NULL != ex->history)
 		{
-			pp_history_free(history);
-			history = NULL;
+			pp_history_free(ex->history);
+			ex->history = NULL;
 		}
 
-		if (0 != results_num && ZBX_PREPROC_FAIL_SET_ERROR != action && 0 == quote_error)
+		if (0 != ex->results_num && ZBX_PREPROC_FAIL_SET_ERROR != ex->action && 0 == ex->quote_error)
 		{
 			char	*error = NULL;
 
-			pp_format_error(value_in, results, results_num, &error);
-			zbx_variant_clear(value_out);
-			zbx_variant_set_error(value_out, error);
+			pp_format_error(ex->value_in, ex->results, ex->results_num, &error);
+			zbx_variant_clear(ex->value_out);
+			zbx_variant_set_error(ex->value_out, error);
 		}
 	}
 
 	/* replace preprocessing history */
 
-	if (NULL != preproc->history)
-		pp_history_free(preproc->history);
+	if (NULL != ex->preproc->history)
+		pp_history_free(ex->preproc->history);
 
-	preproc->history = history;
+	ex->preproc->history = ex->history;
 
 	if (NULL != results_out)
 	{
-		*results_out = results;
-		*results_num_out = results_num;
+		*results_out = ex->results;
+		*results_num_out = ex->results_num;
 	}
 	else
-		pp_free_results(results, results_num);
-out:
+		pp_free_results(ex->results, ex->results_num);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: execute preprocessing steps                                       *
+ *                                                                            *
+ * Parameters: ctx             - [IN] worker specific execution context       *
+ *             preproc         - [IN] item preprocessing data                 *
+ *             cache           - [IN] preprocessing cache                     *
+ *             value_in        - [IN]                                         *
+ *             ts              - [IN] value timestamp                         *
+ *             value_out       - [OUT]                                        *
+ *             results_out     - [OUT] results for each step (optional)       *
+ *             results_num_out - [OUT] number of results (optional)           *
+ *                                                                            *
+ ******************************************************************************/
+void	pp_execute(zbx_pp_context_t *ctx, zbx_pp_item_preproc_t *preproc, zbx_pp_cache_t *cache,
+		zbx_variant_t *value_in, zbx_timespec_t ts, zbx_variant_t *value_out, zbx_pp_result_t **results_out,
+		int *results_num_out)
+{
+	zbx_pp_execution_t	ex;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s(): value:%s type:%s", __func__,
+			zbx_variant_value_desc(NULL == cache ? value_in : &cache->value),
+			zbx_variant_type_desc(NULL == cache ? value_in : &cache->value));
+
+	pp_execution_init(&ex, preproc, cache, value_in, ts, value_out);
+
+	for (int i = 0; 0 == ex.done; i++)
+		pp_execution_step(ctx, &ex, i);
+
+	pp_execution_finish(&ex, results_out, results_num_out);
+
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s(): value:'%s' type:%s", __func__,
 			zbx_variant_value_desc(value_out), zbx_variant_type_desc(value_out));
+}
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: execute preprocessing steps of multiple values                    *
+ *                                                                            *
+ * Parameters: ctx        - [IN] worker specific execution context            *
+ *             values     - [IN/OUT] the values to preprocess                 *
+ *             values_num - [IN] the number of values                         *
+ *                                                                            *
+ * Comments: The values are processed step by step - each step is executed    *
+ *           for all values before proceeding with the next step. This keeps  *
+ *           the code and data used by a step hot when the values have        *
+ *           similar preprocessing steps. The result of each value is the     *
+ *           same as if it was preprocessed with pp_execute().                *
+ *                                                                            *
+ *           Values of the same item must not be preprocessed in one batch    *
+ *           if the item preprocessing has history.                           *
+ *                                                                            *
+ ******************************************************************************/
+void	pp_execute_batch(zbx_pp_context_t *ctx, zbx_pp_batch_value_t *values, int values_num)
+{
+	zbx_pp_execution_t	*exs;
+	int			i, active_num = 0;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() values:%d", __func__, values_num);
+
+	exs = (zbx_pp_execution_t *)zbx_malloc(NULL, sizeof(zbx_pp_execution_t) * (size_t)values_num);
+
+	for (i = 0; i < values_num; i++)
+	{
+		pp_execution_init(&exs[i], values[i].preproc, values[i].cache, values[i].value_in, values[i].ts,
+				values[i].value_out);
+
+		if (0 == exs[i].done)
+			active_num++;
+	}
+
+	for (int index = 0; 0 != active_num; index++)
+	{
+		for (i = 0, active_num = 0; i < values_num; i++)
+		{
+			pp_execution_step(ctx, &exs[i], index);
+
+			if (0 == exs[i].done)
+				active_num++;
+		}
+	}
+
+	for (i = 0; i < values_num; i++)
+		pp_execution_finish(&exs[i], NULL, NULL);
+
+	zbx_free(exs);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
 void	pp_context_init(zbx_pp_context_t *ctx)
@@ -1176,3 +1488,29 @@ zbx_es_t	*pp_context_es_engine(zbx_pp_context_t *ctx)
 
 	return &ctx->es_engine;
 }
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: rebuild scripting environment destroyed after fatal error, so     *
+ *          the next script step does not have to wait for it                 *
+ *                                                                            *
+ * Comments: This function is called by worker when there are no tasks to     *
+ *           process.                                                         *
+ *                                                                            *
+ ******************************************************************************/
+void	pp_context_warmup(zbx_pp_context_t *ctx)
+{
+	char	*error = NULL;
+
+	if (0 == ctx->es_reset)
+		return;
+
+	ctx->es_reset = 0;
+
+	if (SUCCEED != zbx_es_is_env_initialized(&ctx->es_engine) &&
+			SUCCEED != zbx_es_init_env(&ctx->es_engine, &error))
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "cannot initialize scripting environment: %s", error);
+		zbx_free(error);
+	}
+}
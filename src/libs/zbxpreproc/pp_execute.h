@@ -21,6 +21,7 @@
 #define ZABBIX_PP_EXECUTE_H
 
 #include "pp_cache.h"
+#include "pp_script.h"
 #include "zbxembed.h"
 #include "zbxpreproc.h"
 #include "zbxtime.h"
@@ -28,18 +29,34 @@
 
 typedef struct
 {
-	int		es_initialized;
-	zbx_es_t	es_engine;
+	int			es_initialized;
+	int			es_reset;	/* 1 - scripting environment was destroyed after fatal error */
+	zbx_es_t		es_engine;
+
+	zbx_pp_script_cache_t	*scripts;	/* shared script bytecode cache (optional) */
 }
 zbx_pp_context_t;
 
 void		pp_context_init(zbx_pp_context_t *ctx);
 void		pp_context_destroy(zbx_pp_context_t *ctx);
 zbx_es_t	*pp_context_es_engine(zbx_pp_context_t *ctx);
+void		pp_context_warmup(zbx_pp_context_t *ctx);
+
+/* value to be preprocessed in batch */
+typedef struct
+{
+	zbx_pp_item_preproc_t	*preproc;
+	zbx_pp_cache_t		*cache;
+	zbx_variant_t		*value_in;
+	zbx_timespec_t		ts;
+	zbx_variant_t		*value_out;
+}
+zbx_pp_batch_value_t;
 
 void	pp_execute(zbx_pp_context_t *ctx, zbx_pp_item_preproc_t *preproc, zbx_pp_cache_t *cache,
 		zbx_variant_t *value_in, zbx_timespec_t ts, zbx_variant_t *value_out, zbx_pp_result_t **results_out,
 		int *results_num_out);
+void	pp_execute_batch(zbx_pp_context_t *ctx, zbx_pp_batch_value_t *values, int values_num);
 
 int	pp_execute_step(zbx_pp_context_t *ctx, zbx_pp_cache_t *cache, unsigned char value_type,
 		zbx_variant_t *value, zbx_timespec_t ts, zbx_pp_step_t *step, zbx_variant_t *history_value,
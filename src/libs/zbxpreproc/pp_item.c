@@ -21,6 +21,7 @@
 
 #include "pp_history.h"
 #include "zbxalgo.h"
+#include "zbxxml.h"
 
 ZBX_PTR_VECTOR_IMPL(pp_step_ptr, zbx_pp_step_t *)
 
@@ -57,8 +58,87 @@ zbx_pp_item_preproc_t	*zbx_pp_item_preproc_create(unsigned char type, unsigned c
 	return preproc;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: free compiled data of preprocessing step                          *
+ *                                                                            *
+ ******************************************************************************/
+static void	pp_step_clear_compiled(zbx_pp_step_t *step)
+{
+	if (NULL != step->jsonpath)
+	{
+		zbx_jsonpath_clear(step->jsonpath);
+		zbx_free(step->jsonpath);
+	}
+
+	if (NULL != step->prometheus)
+	{
+		zbx_prometheus_filter_free(step->prometheus);
+		step->prometheus = NULL;
+	}
+
+	if (NULL != step->xpath)
+	{
+		zbx_xpath_free(step->xpath);
+		step->xpath = NULL;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile preprocessing step parameters so they are not parsed on   *
+ *          every execution                                                   *
+ *                                                                            *
+ * Parameters: step - [IN/OUT] the preprocessing step                         *
+ *                                                                            *
+ * Comments: Steps are compiled when item preprocessing data is synced from   *
+ *           configuration cache and shared by preprocessing workers, so      *
+ *           compiled data must not be modified during execution. Parameters  *
+ *           failing to compile are left to be reported by step execution.    *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_pp_step_compile(zbx_pp_step_t *step)
+{
+	zbx_jsonpath_t	jsonpath;
+	const char	*ptr;
+	char		*pattern, *error = NULL;
+
+	pp_step_clear_compiled(step);
+
+	if (NULL == step->params)
+		return;
+
+	switch (step->type)
+	{
+		case ZBX_PREPROC_JSONPATH:
+			if (SUCCEED != zbx_jsonpath_compile(step->params, &jsonpath))
+				return;
+
+			step->jsonpath = (zbx_jsonpath_t *)zbx_malloc(NULL, sizeof(zbx_jsonpath_t));
+			*step->jsonpath = jsonpath;
+			break;
+		case ZBX_PREPROC_PROMETHEUS_PATTERN:
+			/* the first parameter line contains the pattern */
+			if (NULL == (ptr = strchr(step->params, '\n')))
+				return;
+
+			pattern = zbx_dsprintf(NULL, "%.*s", (int)(ptr - step->params), step->params);
+
+			if (SUCCEED != zbx_prometheus_filter_create(pattern, &step->prometheus, &error))
+				zbx_free(error);
+
+			zbx_free(pattern);
+			break;
+		case ZBX_PREPROC_XPATH:
+			if (SUCCEED != zbx_xpath_compile(step->params, &step->xpath, &error))
+				zbx_free(error);
+			break;
+	}
+}
+
 void	zbx_pp_step_free(zbx_pp_step_t *step)
 {
+	pp_step_clear_compiled(step);
 	zbx_free(step->params);
 	zbx_free(step->error_handler_params);
 	zbx_free(step);
@@ -73,6 +153,7 @@ static void	pp_item_preproc_free(zbx_pp_item_preproc_t *preproc)
 {
 	for (int i = 0; i < preproc->steps_num; i++)
 	{
+		pp_step_clear_compiled(&preproc->steps[i]);
 		zbx_free(preproc->steps[i].params);
 		zbx_free(preproc->steps[i].error_handler_params);
 	}
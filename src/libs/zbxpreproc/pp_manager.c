@@ -49,6 +49,7 @@
 #endif
 
 static zbx_flush_value_func_t	flush_value_func_cb = NULL;
+static zbx_flush_values_func_t	flush_values_func_cb = NULL;
 
 /******************************************************************************
  *                                                                            *
@@ -98,9 +99,10 @@ static void	pp_curl_destroy(void)
 #endif
 }
 
-void	zbx_init_library_preproc(zbx_flush_value_func_t flush_value_cb)
+void	zbx_init_library_preproc(zbx_flush_value_func_t flush_value_cb, zbx_flush_values_func_t flush_values_cb)
 {
 	flush_value_func_cb = flush_value_cb;
+	flush_values_func_cb = flush_values_cb;
 }
 
 /******************************************************************************
@@ -134,7 +136,10 @@ zbx_pp_manager_t	*zbx_pp_manager_create(int workers_num, zbx_pp_notify_cb_t fini
 	manager = (zbx_pp_manager_t *)zbx_malloc(NULL, sizeof(zbx_pp_manager_t));
 	memset(manager, 0, sizeof(zbx_pp_manager_t));
 
-	if (SUCCEED != pp_task_queue_init(&manager->queue, error))
+	if (SUCCEED != pp_task_queue_init(&manager->queue, workers_num, error))
+		goto out;
+
+	if (SUCCEED != pp_script_cache_init(&manager->scripts, error))
 		goto out;
 
 	manager->timekeeper = zbx_timekeeper_create(workers_num, NULL);
@@ -144,8 +149,8 @@ zbx_pp_manager_t	*zbx_pp_manager_create(int workers_num, zbx_pp_notify_cb_t fini
 
 	for (i = 0; i < workers_num; i++)
 	{
-		if (SUCCEED != pp_worker_init(&manager->workers[i], i + 1, &manager->queue, manager->timekeeper,
-				error))
+		if (SUCCEED != pp_worker_init(&manager->workers[i], i + 1, &manager->queue, &manager->scripts,
+				manager->timekeeper, error))
 		{
 			goto out;
 		}
@@ -187,6 +192,7 @@ out:
 			pp_worker_stop(&manager->workers[i]);
 
 		pp_task_queue_destroy(&manager->queue);
+		pp_script_cache_destroy(&manager->scripts);
 		zbx_free(manager);
 
 		manager = NULL;
@@ -220,6 +226,7 @@ void	zbx_pp_manager_free(zbx_pp_manager_t *manager)
 	zbx_free(manager->workers);
 
 	pp_task_queue_destroy(&manager->queue);
+	pp_script_cache_destroy(&manager->scripts);
 	zbx_hashset_destroy(&manager->items);
 
 	zbx_timekeeper_free(manager->timekeeper);
@@ -558,9 +565,7 @@ void	zbx_pp_manager_process_finished(zbx_pp_manager_t *manager, zbx_vector_pp_ta
 		zbx_vector_pp_task_ptr_append(tasks, task);
 	}
 
-	*pending_num = manager->queue.pending_num;
-	*finished_num = manager->queue.finished_num;
-	*processing_num = manager->queue.processing_num;
+	pp_task_queue_get_stats(&manager->queue, pending_num, processing_num, finished_num);
 
 	pp_task_queue_unlock(&manager->queue);
 	zbx_prof_end();
@@ -651,7 +656,13 @@ zbx_hashset_t	*zbx_pp_manager_items(zbx_pp_manager_t *manager)
  ******************************************************************************/
 zbx_uint64_t	zbx_pp_manager_get_pending_num(zbx_pp_manager_t *manager)
 {
-	return manager->queue.pending_num;
+	zbx_uint64_t	pending_num, processing_num, finished_num;
+
+	pp_task_queue_lock(&manager->queue);
+	pp_task_queue_get_stats(&manager->queue, &pending_num, &processing_num, &finished_num);
+	pp_task_queue_unlock(&manager->queue);
+
+	return pending_num;
 }
 
 /******************************************************************************
@@ -662,12 +673,25 @@ zbx_uint64_t	zbx_pp_manager_get_pending_num(zbx_pp_manager_t *manager)
 void	zbx_pp_manager_get_diag_stats(zbx_pp_manager_t *manager, zbx_uint64_t *preproc_num, zbx_uint64_t *pending_num,
 		zbx_uint64_t *finished_num, zbx_uint64_t *sequences_num)
 {
+	zbx_uint64_t	processing_num;
+
 	*preproc_num = (zbx_uint64_t)manager->items.num_data;
-	*pending_num = manager->queue.pending_num;
-	*finished_num = manager->queue.finished_num;
+	pp_task_queue_lock(&manager->queue);
+	pp_task_queue_get_stats(&manager->queue, pending_num, &processing_num, finished_num);
+	pp_task_queue_unlock(&manager->queue);
 	*sequences_num = (zbx_uint64_t)manager->queue.sequences.num_data;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get script bytecode cache statistics                              *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_pp_manager_get_script_stats(zbx_pp_manager_t *manager, zbx_pp_script_stats_t *stats)
+{
+	pp_script_cache_get_stats(&manager->scripts, stats);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: get task sequence statistics                                      *
@@ -682,10 +706,21 @@ void	zbx_pp_manager_get_sequence_stats(zbx_pp_manager_t *manager, zbx_vector_pp_
  *                                                                            *
  * Purpose: get worker usage statistics                                       *
  *                                                                            *
+ * Parameters: manager       - [IN] manager                                   *
+ *             worker_usage  - [OUT] busy percentage of each worker           *
+ *             worker_steals - [OUT] tasks stolen by each worker from other   *
+ *                                   workers (optional)                       *
+ *             worker_idles  - [OUT] times each worker waited for new tasks   *
+ *                                   (optional)                               *
+ *                                                                            *
  ******************************************************************************/
-void	zbx_pp_manager_get_worker_usage(zbx_pp_manager_t *manager, zbx_vector_dbl_t *worker_usage)
+void	zbx_pp_manager_get_worker_usage(zbx_pp_manager_t *manager, zbx_vector_dbl_t *worker_usage,
+		zbx_vector_uint64_t *worker_steals, zbx_vector_uint64_t *worker_idles)
 {
 	(void)zbx_timekeeper_get_usage(manager->timekeeper, worker_usage);
+
+	if (NULL != worker_steals || NULL != worker_idles)
+		pp_task_queue_get_worker_stats(&manager->queue, worker_steals, worker_idles);
 }
 
 /******************************************************************************
@@ -846,6 +881,78 @@ static void	preprocessing_flush_value(zbx_pp_manager_t *manager, zbx_uint64_t it
 	flush_value_func_cb(manager, itemid, value_type, flags, value, ts, value_opt);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: check if value is discarded by throttling step without passing    *
+ *          it to workers                                                     *
+ *                                                                            *
+ * Parameters: manager - [IN]                                                 *
+ *             itemid  - [IN] item identifier                                 *
+ *             value   - [IN] value to check                                  *
+ *             ts      - [IN] value timestamp                                 *
+ *                                                                            *
+ * Return value: SUCCEED - the value is discarded                             *
+ *               FAIL    - the value must be preprocessed by workers          *
+ *                                                                            *
+ * Comments: Only items having throttling as the first step and no other      *
+ *           steps with history are checked. Discarding value in this case    *
+ *           does not change preprocessing history, so the result is the same *
+ *           as if the value was preprocessed by worker.                      *
+ *                                                                            *
+ *           Preprocessing history is checked only when no tasks reference    *
+ *           item preprocessing data, otherwise it can be changed by workers  *
+ *           or by the previous values not yet preprocessed.                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	pp_manager_throttle_value(zbx_pp_manager_t *manager, zbx_uint64_t itemid, const zbx_variant_t *value,
+		zbx_timespec_t ts)
+{
+	zbx_pp_item_t		*item;
+	zbx_pp_item_preproc_t	*preproc;
+	zbx_pp_step_t		*step;
+	zbx_pp_step_history_t	*step_history = NULL;
+	int			timeout;
+
+	if (ZBX_VARIANT_NONE == value->type || ZBX_VARIANT_ERR == value->type)
+		return FAIL;
+
+	if (NULL == (item = (zbx_pp_item_t *)zbx_hashset_search(&manager->items, &itemid)))
+		return FAIL;
+
+	preproc = item->preproc;
+
+	if (1 != preproc->refcount || 1 != preproc->history_num || NULL == preproc->history)
+		return FAIL;
+
+	step = &preproc->steps[0];
+
+	if (ZBX_PREPROC_THROTTLE_VALUE != step->type && ZBX_PREPROC_THROTTLE_TIMED_VALUE != step->type)
+		return FAIL;
+
+	for (int i = 0; i < preproc->history->step_history.values_num; i++)
+	{
+		if (0 == preproc->history->step_history.values[i].index)
+		{
+			step_history = &preproc->history->step_history.values[i];
+			break;
+		}
+	}
+
+	if (NULL == step_history || 0 != zbx_variant_compare(value, &step_history->value))
+		return FAIL;
+
+	if (ZBX_PREPROC_THROTTLE_VALUE == step->type)
+		return SUCCEED;
+
+	if (FAIL == zbx_is_time_suffix(step->params, &timeout, (int)strlen(step->params)))
+		return FAIL;
+
+	if (ts.sec - step_history->ts.sec >= timeout)
+		return FAIL;
+
+	return SUCCEED;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: handle new preprocessing request                                  *
@@ -876,9 +983,22 @@ static zbx_uint64_t	preprocessor_add_request(zbx_pp_manager_t *manager, zbx_ipc_
 		zbx_pp_value_opt_t	var_opt;
 		zbx_timespec_t		ts;
 		zbx_pp_task_t		*task;
+		zbx_uint32_t		size;
 
-		offset += zbx_preprocessor_unpack_value(&value, message->data + offset);
-		preproc_item_value_extract_data(&value, &var, &ts, &var_opt);
+		if (0 != (size = zbx_preprocessor_unpack_numeric_value(&value, &var, &ts, message->data + offset)))
+		{
+			offset += size;
+			var_opt.flags = ZBX_PP_VALUE_OPT_NONE;
+		}
+		else
+		{
+			offset += zbx_preprocessor_unpack_value(&value, message->data + offset);
+			preproc_item_value_extract_data(&value, &var, &ts, &var_opt);
+		}
+
+		/* discarded values are flushed without value to update item metadata */
+		if (SUCCEED == pp_manager_throttle_value(manager, value.itemid, &var, ts))
+			zbx_variant_clear(&var);
 
 		if (NULL == (task = zbx_pp_manager_create_task(manager, value.itemid, &var, ts, &var_opt)))
 		{
@@ -1020,12 +1140,20 @@ static void	preprocessor_flush_tasks(zbx_pp_manager_t *manager, zbx_vector_pp_ta
  ******************************************************************************/
 static void	preprocessor_reply_diag_info(zbx_pp_manager_t *manager, zbx_ipc_client_t *client)
 {
-	zbx_uint64_t	preproc_num, pending_num, finished_num, sequences_num;
-	unsigned char	*data;
-	zbx_uint32_t	data_len;
+	zbx_uint64_t			preproc_num, pending_num, finished_num, sequences_num;
+	zbx_pp_script_stats_t		scripts;
+	zbx_regexp_cache_stats_t	regexps;
+	unsigned char			*data;
+	zbx_uint32_t			data_len;
 
 	zbx_pp_manager_get_diag_stats(manager, &preproc_num, &pending_num, &finished_num, &sequences_num);
-	data_len = zbx_preprocessor_pack_diag_stats(&data, preproc_num, pending_num, finished_num, sequences_num);
+	zbx_pp_manager_get_script_stats(manager, &scripts);
+
+	/* regular expressions are matched by preprocessing workers running in manager process */
+	zbx_regexp_get_cache_stats(&regexps);
+
+	data_len = zbx_preprocessor_pack_diag_stats(&data, preproc_num, pending_num, finished_num, sequences_num,
+			&scripts, &regexps);
 
 	zbx_ipc_client_send(client, ZBX_IPC_PREPROCESSOR_DIAG_STATS_RESULT, data, data_len);
 
@@ -1090,17 +1218,22 @@ static void	preprocessor_reply_top_sequences(zbx_pp_manager_t *manager, zbx_ipc_
 static void	preprocessor_reply_usage_stats(zbx_pp_manager_t *manager, int workers_num, zbx_ipc_client_t *client)
 {
 	zbx_vector_dbl_t	usage;
+	zbx_vector_uint64_t	steals, idles;
 	unsigned char		*data;
 	zbx_uint32_t		data_len;
 
 	zbx_vector_dbl_create(&usage);
-	zbx_pp_manager_get_worker_usage(manager, &usage);
+	zbx_vector_uint64_create(&steals);
+	zbx_vector_uint64_create(&idles);
+	zbx_pp_manager_get_worker_usage(manager, &usage, &steals, &idles);
 
-	data_len = zbx_preprocessor_pack_usage_stats(&data, &usage, workers_num);
+	data_len = zbx_preprocessor_pack_usage_stats(&data, &usage, &steals, &idles, workers_num);
 
 	zbx_ipc_client_send(client, ZBX_IPC_PREPROCESSOR_DIAG_STATS_RESULT, data, data_len);
 
 	zbx_free(data);
+	zbx_vector_uint64_destroy(&idles);
+	zbx_vector_uint64_destroy(&steals);
 	zbx_vector_dbl_destroy(&usage);
 }
 
@@ -1229,6 +1362,10 @@ ZBX_THREAD_ENTRY(zbx_pp_manager_thread, args)
 			zbx_pp_tasks_clear(&tasks);
 		}
 
+		/* send values coalesced by flush value callback during this iteration */
+		if (NULL != flush_values_func_cb)
+			flush_values_func_cb();
+
 		if (0 != finished_num)
 		{
 			timeout.sec = 0;
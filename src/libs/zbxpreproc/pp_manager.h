@@ -22,6 +22,7 @@
 
 #include "pp_worker.h"
 #include "pp_queue.h"
+#include "pp_script.h"
 #include "zbxpreproc.h"
 #include "zbxalgo.h"
 #include "zbxtimekeeper.h"
@@ -36,6 +37,7 @@ struct zbx_pp_manager
 	zbx_uint64_t		revision;
 
 	zbx_pp_queue_t		queue;
+	zbx_pp_script_cache_t	scripts;
 
 	zbx_timekeeper_t	*timekeeper;
 };
@@ -34,6 +34,14 @@
 #define PACKED_FIELD(value, size)	\
 		(zbx_packed_field_t){(value), (size), (0 == (size) ? PACKED_FIELD_STRING : PACKED_FIELD_RAW)}
 
+/* item value record formats */
+#define PP_VALUE_FORMAT_FULL	0
+#define PP_VALUE_FORMAT_UI64	1
+#define PP_VALUE_FORMAT_DBL	2
+
+/* format, itemid, hostid, value type, flags, seconds, nanoseconds (up to 6 bytes) and value */
+#define PP_VALUE_NUMERIC_SIZE_MAX	(1 + 8 + 8 + 1 + 1 + 4 + 6 + 8)
+
 static zbx_ipc_message_t	cached_message;
 static int			cached_values;
 
@@ -129,6 +137,65 @@ static zbx_uint32_t	message_pack_data(zbx_ipc_message_t *message, zbx_packed_fie
 	return data_size;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: pack numeric item value without error and log metadata into       *
+ *          fixed layout record                                               *
+ *                                                                            *
+ * Parameters: message - [OUT] IPC message                                    *
+ *             value   - [IN] value to be packed                              *
+ *                                                                            *
+ * Return value: size of packed data or 0 if the value cannot be packed in    *
+ *               numeric format or the message size would exceed 4GB limit    *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint32_t	preprocessor_pack_numeric_value(zbx_ipc_message_t *message,
+		const zbx_preproc_item_value_t *value)
+{
+	unsigned char	*ptr, format;
+	zbx_uint32_t	size;
+
+	if (ITEM_STATE_NORMAL != value->state || NULL != value->error || NULL == value->ts || NULL == value->result)
+		return 0;
+
+	if (0 != ZBX_ISSET_LOG(value->result) || 0 != ZBX_ISSET_META(value->result))
+		return 0;
+
+	if (0 != ZBX_ISSET_UI64(value->result))
+		format = PP_VALUE_FORMAT_UI64;
+	else if (0 != ZBX_ISSET_DBL(value->result))
+		format = PP_VALUE_FORMAT_DBL;
+	else
+		return 0;
+
+	if (0 > value->ts->ns)
+		return 0;
+
+	if (UINT32_MAX - message->size < PP_VALUE_NUMERIC_SIZE_MAX)
+		return 0;
+
+	message->data = (unsigned char *)zbx_realloc(message->data, message->size + PP_VALUE_NUMERIC_SIZE_MAX);
+	ptr = message->data + message->size;
+
+	ptr += zbx_serialize_char(ptr, format);
+	ptr += zbx_serialize_uint64(ptr, value->itemid);
+	ptr += zbx_serialize_uint64(ptr, value->hostid);
+	ptr += zbx_serialize_char(ptr, value->item_value_type);
+	ptr += zbx_serialize_char(ptr, value->item_flags);
+	ptr += zbx_serialize_int(ptr, value->ts->sec);
+	ptr += zbx_serialize_uint31_compact(ptr, (zbx_uint32_t)value->ts->ns);
+
+	if (PP_VALUE_FORMAT_UI64 == format)
+		ptr += zbx_serialize_uint64(ptr, value->result->ui64);
+	else
+		ptr += zbx_serialize_double(ptr, value->result->dbl);
+
+	size = (zbx_uint32_t)(ptr - (message->data + message->size));
+	message->size += size;
+
+	return size;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: pack item value data into a single buffer that can be used in IPC *
@@ -141,12 +208,17 @@ static zbx_uint32_t	message_pack_data(zbx_ipc_message_t *message, zbx_packed_fie
  ******************************************************************************/
 static zbx_uint32_t	preprocessor_pack_value(zbx_ipc_message_t *message, zbx_preproc_item_value_t *value)
 {
-	zbx_packed_field_t	fields[24], *offset = fields;	/* 24 - max field count */
-	unsigned char		ts_marker, result_marker, log_marker;
+	zbx_packed_field_t	fields[25], *offset = fields;	/* 25 - max field count */
+	unsigned char		format = PP_VALUE_FORMAT_FULL, ts_marker, result_marker, log_marker;
+	zbx_uint32_t		size;
+
+	if (0 != (size = preprocessor_pack_numeric_value(message, value)))
+		return size;
 
 	ts_marker = (NULL != value->ts);
 	result_marker = (NULL != value->result);
 
+	*offset++ = PACKED_FIELD(&format, sizeof(unsigned char));
 	*offset++ = PACKED_FIELD(&value->itemid, sizeof(zbx_uint64_t));
 	*offset++ = PACKED_FIELD(&value->hostid, sizeof(zbx_uint64_t));
 	*offset++ = PACKED_FIELD(&value->item_value_type, sizeof(unsigned char));
@@ -395,6 +467,9 @@ static int	preprocessor_unpack_step(const unsigned char *data, zbx_pp_step_t *st
 	offset += zbx_deserialize_str(offset, &step->params, value_len);
 	offset += zbx_deserialize_char(offset, &step->error_handler);
 	offset += zbx_deserialize_str(offset, &step->error_handler_params, value_len);
+	step->jsonpath = NULL;
+	step->prometheus = NULL;
+	step->xpath = NULL;
 
 	return (int)(offset - data);
 }
@@ -484,10 +559,13 @@ zbx_uint32_t	zbx_preprocessor_pack_test_result(unsigned char **data, const zbx_p
  *                               preprocessed                                 *
  *             finished_num  - [IN] number of values being preprocessed       *
  *             sequences_num - [IN] number of registered task sequences       *
+ *             scripts       - [IN] script bytecode cache statistics          *
+ *             regexps       - [IN] compiled regexp cache statistics          *
  *                                                                            *
  ******************************************************************************/
 zbx_uint32_t	zbx_preprocessor_pack_diag_stats(unsigned char **data, zbx_uint64_t preproc_num,
-		zbx_uint64_t pending_num, zbx_uint64_t finished_num, zbx_uint64_t sequences_num)
+		zbx_uint64_t pending_num, zbx_uint64_t finished_num, zbx_uint64_t sequences_num,
+		const zbx_pp_script_stats_t *scripts, const zbx_regexp_cache_stats_t *regexps)
 {
 	unsigned char	*ptr;
 	zbx_uint32_t	data_len = 0;
@@ -496,6 +574,12 @@ zbx_uint32_t	zbx_preprocessor_pack_diag_stats(unsigned char **data, zbx_uint64_t
 	zbx_serialize_prepare_value(data_len, pending_num);
 	zbx_serialize_prepare_value(data_len, finished_num);
 	zbx_serialize_prepare_value(data_len, sequences_num);
+	zbx_serialize_prepare_value(data_len, scripts->scripts_num);
+	zbx_serialize_prepare_value(data_len, scripts->compiled_num);
+	zbx_serialize_prepare_value(data_len, scripts->hits_num);
+	zbx_serialize_prepare_value(data_len, scripts->resets_num);
+	zbx_serialize_prepare_value(data_len, regexps->hits_num);
+	zbx_serialize_prepare_value(data_len, regexps->misses_num);
 
 	*data = (unsigned char *)zbx_malloc(NULL, data_len);
 
@@ -503,7 +587,13 @@ zbx_uint32_t	zbx_preprocessor_pack_diag_stats(unsigned char **data, zbx_uint64_t
 	ptr += zbx_serialize_value(ptr, preproc_num);
 	ptr += zbx_serialize_value(ptr, pending_num);
 	ptr += zbx_serialize_value(ptr, finished_num);
-	(void)zbx_serialize_value(ptr, sequences_num);
+	ptr += zbx_serialize_value(ptr, sequences_num);
+	ptr += zbx_serialize_value(ptr, scripts->scripts_num);
+	ptr += zbx_serialize_value(ptr, scripts->compiled_num);
+	ptr += zbx_serialize_value(ptr, scripts->hits_num);
+	ptr += zbx_serialize_value(ptr, scripts->resets_num);
+	ptr += zbx_serialize_value(ptr, regexps->hits_num);
+	(void)zbx_serialize_value(ptr, regexps->misses_num);
 
 	return data_len;
 }
@@ -513,17 +603,22 @@ zbx_uint32_t	zbx_preprocessor_pack_diag_stats(unsigned char **data, zbx_uint64_t
  * Purpose: pack diagnostic statistics data into a single buffer that can be  *
  *          used in IPC                                                       *
  *                                                                            *
- * Parameters: data  - [OUT] memory buffer for packed data                    *
- *             usage - [IN] worker usage statistics                           *
- *             count - [IN]                                                   *
+ * Parameters: data   - [OUT] memory buffer for packed data                   *
+ *             usage  - [IN] worker usage statistics                          *
+ *             steals - [IN] worker task steal counters                       *
+ *             idles  - [IN] worker idle wait counters                        *
+ *             count  - [IN]                                                  *
  *                                                                            *
  ******************************************************************************/
-zbx_uint32_t	zbx_preprocessor_pack_usage_stats(unsigned char **data, const zbx_vector_dbl_t *usage, int count)
+zbx_uint32_t	zbx_preprocessor_pack_usage_stats(unsigned char **data, const zbx_vector_dbl_t *usage,
+		const zbx_vector_uint64_t *steals, const zbx_vector_uint64_t *idles, int count)
 {
 	unsigned char	*ptr;
 	zbx_uint32_t	data_len;
 
-	data_len = (zbx_uint32_t)((unsigned int)usage->values_num * sizeof(double) + sizeof(int) + sizeof(int));
+	data_len = (zbx_uint32_t)((unsigned int)usage->values_num * sizeof(double) + sizeof(int) + sizeof(int) +
+			(unsigned int)(steals->values_num + idles->values_num) * sizeof(zbx_uint64_t) +
+			sizeof(int) + sizeof(int));
 
 	ptr = *data = (unsigned char *)zbx_malloc(NULL, data_len);
 
@@ -532,7 +627,17 @@ zbx_uint32_t	zbx_preprocessor_pack_usage_stats(unsigned char **data, const zbx_v
 	for (int i = 0; i < usage->values_num; i++)
 		ptr += zbx_serialize_value(ptr, usage->values[i]);
 
-	(void)zbx_serialize_value(ptr, count);
+	ptr += zbx_serialize_value(ptr, count);
+
+	ptr += zbx_serialize_value(ptr, steals->values_num);
+
+	for (int i = 0; i < steals->values_num; i++)
+		ptr += zbx_serialize_value(ptr, steals->values[i]);
+
+	ptr += zbx_serialize_value(ptr, idles->values_num);
+
+	for (int i = 0; i < idles->values_num; i++)
+		ptr += zbx_serialize_value(ptr, idles->values[i]);
 
 	return data_len;
 }
@@ -593,6 +698,64 @@ zbx_uint32_t	zbx_preprocessor_pack_top_sequences_result(unsigned char **data,
 	return data_len;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: unpack item value packed in numeric format from IPC data buffer   *
+ *                                                                            *
+ * Parameters: value - [OUT] unpacked item value properties                   *
+ *             var   - [OUT] unpacked value                                   *
+ *             ts    - [OUT] value timestamp                                  *
+ *             data  - [IN]  IPC data buffer                                  *
+ *                                                                            *
+ * Return value: size of packed data or 0 if the value is not packed in       *
+ *               numeric format                                               *
+ *                                                                            *
+ * Comments: The value is unpacked without allocating memory - the item value *
+ *           timestamp, result and error are set to NULL.                     *
+ *           Values packed in full format must be unpacked with               *
+ *           zbx_preprocessor_unpack_value() function.                        *
+ *                                                                            *
+ ******************************************************************************/
+zbx_uint32_t	zbx_preprocessor_unpack_numeric_value(zbx_preproc_item_value_t *value, zbx_variant_t *var,
+		zbx_timespec_t *ts, const unsigned char *data)
+{
+	const unsigned char	*offset = data + 1;
+	zbx_uint32_t		ns;
+
+	if (PP_VALUE_FORMAT_UI64 != *data && PP_VALUE_FORMAT_DBL != *data)
+		return 0;
+
+	offset += zbx_deserialize_uint64(offset, &value->itemid);
+	offset += zbx_deserialize_uint64(offset, &value->hostid);
+	offset += zbx_deserialize_char(offset, &value->item_value_type);
+	offset += zbx_deserialize_char(offset, &value->item_flags);
+	offset += zbx_deserialize_int(offset, &ts->sec);
+	offset += zbx_deserialize_uint31_compact(offset, &ns);
+	ts->ns = (int)ns;
+
+	value->state = ITEM_STATE_NORMAL;
+	value->error = NULL;
+	value->ts = NULL;
+	value->result = NULL;
+
+	if (PP_VALUE_FORMAT_UI64 == *data)
+	{
+		zbx_uint64_t	value_ui64;
+
+		offset += zbx_deserialize_uint64(offset, &value_ui64);
+		zbx_variant_set_ui64(var, value_ui64);
+	}
+	else
+	{
+		double	value_dbl;
+
+		offset += zbx_deserialize_double(offset, &value_dbl);
+		zbx_variant_set_dbl(var, value_dbl);
+	}
+
+	return (zbx_uint32_t)(offset - data);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: unpack item value data from IPC data buffer                       *
@@ -602,6 +765,9 @@ zbx_uint32_t	zbx_preprocessor_pack_top_sequences_result(unsigned char **data,
  *                                                                            *
  * Return value: size of packed data                                          *
  *                                                                            *
+ * Comments: Values packed in numeric format must be unpacked with            *
+ *           zbx_preprocessor_unpack_numeric_value() function.                *
+ *                                                                            *
  ******************************************************************************/
 zbx_uint32_t	zbx_preprocessor_unpack_value(zbx_preproc_item_value_t *value, unsigned char *data)
 {
@@ -609,7 +775,7 @@ zbx_uint32_t	zbx_preprocessor_unpack_value(zbx_preproc_item_value_t *value, unsi
 	zbx_timespec_t	*timespec = NULL;
 	AGENT_RESULT	*agent_result = NULL;
 	zbx_log_t	*log = NULL;
-	unsigned char	*offset = data, ts_marker, result_marker, log_marker;
+	unsigned char	*offset = data + 1, ts_marker, result_marker, log_marker;
 
 	offset += zbx_deserialize_uint64(offset, &value->itemid);
 	offset += zbx_deserialize_uint64(offset, &value->hostid);
@@ -706,46 +872,83 @@ void	zbx_preprocessor_unpack_test_result(zbx_vector_pp_result_ptr_t *results, zb
  *                               preprocessed                                 *
  *             finished_num  - [OUT] number of values being preprocessed      *
  *             sequences_num - [OUT] number of registered task sequences      *
+ *             scripts       - [OUT] script bytecode cache statistics         *
+ *             regexps       - [OUT] compiled regexp cache statistics         *
  *             data          - [OUT] data buffer                              *
  *                                                                            *
  ******************************************************************************/
 void	zbx_preprocessor_unpack_diag_stats(zbx_uint64_t *preproc_num, zbx_uint64_t *pending_num,
-		zbx_uint64_t *finished_num, zbx_uint64_t *sequences_num, const unsigned char *data)
+		zbx_uint64_t *finished_num, zbx_uint64_t *sequences_num, zbx_pp_script_stats_t *scripts,
+		zbx_regexp_cache_stats_t *regexps, const unsigned char *data)
 {
 	const unsigned char	*offset = data;
 
 	offset += zbx_deserialize_value(offset, preproc_num);
 	offset += zbx_deserialize_value(offset, pending_num);
 	offset += zbx_deserialize_value(offset, finished_num);
-	(void)zbx_deserialize_value(offset, sequences_num);
+	offset += zbx_deserialize_value(offset, sequences_num);
+	offset += zbx_deserialize_value(offset, &scripts->scripts_num);
+	offset += zbx_deserialize_value(offset, &scripts->compiled_num);
+	offset += zbx_deserialize_value(offset, &scripts->hits_num);
+	offset += zbx_deserialize_value(offset, &scripts->resets_num);
+	offset += zbx_deserialize_value(offset, &regexps->hits_num);
+	(void)zbx_deserialize_value(offset, &regexps->misses_num);
 }
 
 /******************************************************************************
  *                                                                            *
  * Purpose: unpack worker usage statistics                                    *
  *                                                                            *
- * Parameters: usage - [OUT] worker usage statistics                          *
- *             count - [OUT]                                                  *
- *             data  - [IN] input data                                        *
+ * Parameters: usage  - [OUT] worker usage statistics (optional)              *
+ *             steals - [OUT] worker task steal counters (optional)           *
+ *             idles  - [OUT] worker idle wait counters (optional)            *
+ *             count  - [OUT]                                                 *
+ *             data   - [IN] input data                                       *
  *                                                                            *
  ******************************************************************************/
-static void	preprocessor_unpack_usage_stats(zbx_vector_dbl_t *usage, int *count, const unsigned char *data)
+static void	preprocessor_unpack_usage_stats(zbx_vector_dbl_t *usage, zbx_vector_uint64_t *steals,
+		zbx_vector_uint64_t *idles, int *count, const unsigned char *data)
 {
 	const unsigned char	*offset = data;
-	int			usage_num;
+	int			usage_num, values_num;
 
 	offset += zbx_deserialize_value(offset, &usage_num);
-	zbx_vector_dbl_reserve(usage, (size_t)usage_num);
 
 	for (int i = 0; i < usage_num; i++)
 	{
 		double	busy;
 
 		offset += zbx_deserialize_value(offset, &busy);
-		zbx_vector_dbl_append(usage, busy);
+
+		if (NULL != usage)
+			zbx_vector_dbl_append(usage, busy);
 	}
 
-	(void)zbx_deserialize_value(offset, count);
+	offset += zbx_deserialize_value(offset, count);
+
+	offset += zbx_deserialize_value(offset, &values_num);
+
+	for (int i = 0; i < values_num; i++)
+	{
+		zbx_uint64_t	value;
+
+		offset += zbx_deserialize_value(offset, &value);
+
+		if (NULL != steals)
+			zbx_vector_uint64_append(steals, value);
+	}
+
+	offset += zbx_deserialize_value(offset, &values_num);
+
+	for (int i = 0; i < values_num; i++)
+	{
+		zbx_uint64_t	value;
+
+		offset += zbx_deserialize_value(offset, &value);
+
+		if (NULL != idles)
+			zbx_vector_uint64_append(idles, value);
+	}
 }
 
 /******************************************************************************
@@ -1063,7 +1266,8 @@ out:
  *                                                                            *
  ******************************************************************************/
 int	zbx_preprocessor_get_diag_stats(zbx_uint64_t *preproc_num, zbx_uint64_t *pending_num,
-		zbx_uint64_t *finished_num, zbx_uint64_t *sequences_num, char **error)
+		zbx_uint64_t *finished_num, zbx_uint64_t *sequences_num, zbx_pp_script_stats_t *scripts,
+		zbx_regexp_cache_stats_t *regexps, char **error)
 {
 	unsigned char	*result;
 
@@ -1073,7 +1277,8 @@ int	zbx_preprocessor_get_diag_stats(zbx_uint64_t *preproc_num, zbx_uint64_t *pen
 		return FAIL;
 	}
 
-	zbx_preprocessor_unpack_diag_stats(preproc_num, pending_num, finished_num, sequences_num, result);
+	zbx_preprocessor_unpack_diag_stats(preproc_num, pending_num, finished_num, sequences_num, scripts, regexps,
+			result);
 	zbx_free(result);
 
 	return SUCCEED;
@@ -1132,7 +1337,29 @@ int	zbx_preprocessor_get_usage_stats(zbx_vector_dbl_t *usage, int *count, char *
 		return FAIL;
 	}
 
-	preprocessor_unpack_usage_stats(usage, count, result);
+	preprocessor_unpack_usage_stats(usage, NULL, NULL, count, result);
+	zbx_free(result);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get preprocessing worker task steal and idle wait counters        *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_preprocessor_get_worker_stats(zbx_vector_uint64_t *steals, zbx_vector_uint64_t *idles, char **error)
+{
+	unsigned char	*result;
+	int		count;
+
+	if (SUCCEED != zbx_ipc_async_exchange(ZBX_IPC_SERVICE_PREPROCESSING, ZBX_IPC_PREPROCESSOR_USAGE_STATS,
+			SEC_PER_MIN, NULL, 0, &result, error))
+	{
+		return FAIL;
+	}
+
+	preprocessor_unpack_usage_stats(NULL, steals, idles, &count, result);
 	zbx_free(result);
 
 	return SUCCEED;
@@ -27,6 +27,12 @@
 #define PP_TASK_QUEUE_INIT_LOCK		0x01
 #define PP_TASK_QUEUE_INIT_EVENT	0x02
 
+/* the maximum number of tasks to check when looking for a task to steal */
+#define PP_TASK_QUEUE_STEAL_SCAN_MAX	16
+
+/* the maximum number of tasks to check when looking for tasks to batch */
+#define PP_TASK_QUEUE_BATCH_SCAN_MAX	64
+
 ZBX_PTR_VECTOR_IMPL(pp_sequence_stats_ptr, zbx_pp_sequence_stats_t *)
 
 /* task sequence registry by itemid */
@@ -39,42 +45,121 @@ zbx_pp_item_task_sequence_t;
 
 /******************************************************************************
  *                                                                            *
- * Purpose: initialize task queue                                             *
+ * Purpose: clear task list                                                   *
  *                                                                            *
- * Parameters: queue - [IN] task queue                                        *
+ ******************************************************************************/
+static void	pp_task_queue_clear_tasks(zbx_list_t *tasks)
+{
+	zbx_pp_task_t	*task = NULL;
+
+	while (SUCCEED == zbx_list_pop(tasks, (void **)&task))
+		pp_task_free(task);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: initialize worker task deque                                      *
+ *                                                                            *
+ * Parameters: deque - [IN] worker task deque                                 *
  *             error - [OUT]                                                  *
  *                                                                            *
+ * Return value: SUCCEED - the task deque was initialized successfully        *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	pp_task_deque_init(zbx_pp_deque_t *deque, char **error)
+{
+	int	err;
+
+	memset(deque, 0, sizeof(zbx_pp_deque_t));
+
+	zbx_list_create(&deque->immediate);
+	zbx_list_create(&deque->pending);
+	zbx_list_create(&deque->finished);
+
+	if (0 != (err = pthread_mutex_init(&deque->lock, NULL)))
+	{
+		*error = zbx_dsprintf(NULL, "cannot initialize task deque mutex: %s", zbx_strerror(err));
+		return FAIL;
+	}
+	deque->init_flags |= PP_TASK_QUEUE_INIT_LOCK;
+
+	if (0 != (err = pthread_cond_init(&deque->event, NULL)))
+	{
+		*error = zbx_dsprintf(NULL, "cannot initialize task deque conditional variable: %s",
+				zbx_strerror(err));
+		return FAIL;
+	}
+	deque->init_flags |= PP_TASK_QUEUE_INIT_EVENT;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: destroy worker task deque                                         *
+ *                                                                            *
+ ******************************************************************************/
+static void	pp_task_deque_destroy(zbx_pp_deque_t *deque)
+{
+	if (0 != (deque->init_flags & PP_TASK_QUEUE_INIT_LOCK))
+		pthread_mutex_destroy(&deque->lock);
+
+	if (0 != (deque->init_flags & PP_TASK_QUEUE_INIT_EVENT))
+		pthread_cond_destroy(&deque->event);
+
+	pp_task_queue_clear_tasks(&deque->immediate);
+	zbx_list_destroy(&deque->immediate);
+
+	pp_task_queue_clear_tasks(&deque->pending);
+	zbx_list_destroy(&deque->pending);
+
+	pp_task_queue_clear_tasks(&deque->finished);
+	zbx_list_destroy(&deque->finished);
+
+	deque->init_flags = PP_TASK_QUEUE_INIT_NONE;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: initialize task queue                                             *
+ *                                                                            *
+ * Parameters: queue       - [IN] task queue                                  *
+ *             workers_num - [IN] number of workers                           *
+ *             error       - [OUT]                                            *
+ *                                                                            *
  * Return value: SUCCEED - the task queue was initialized successfully        *
  *               FAIL    - otherwise                                          *
  *                                                                            *
  ******************************************************************************/
-int	pp_task_queue_init(zbx_pp_queue_t *queue, char **error)
+int	pp_task_queue_init(zbx_pp_queue_t *queue, int workers_num, char **error)
 {
 	int	err, ret = FAIL;
 
 	queue->workers_num = 0;
-	queue->pending_num = 0;
-	queue->finished_num = 0;
-	queue->processing_num = 0;
-	zbx_list_create(&queue->pending);
-	zbx_list_create(&queue->immediate);
-	zbx_list_create(&queue->finished);
+	queue->queued_num = 0;
+	queue->returned_num = 0;
+	queue->deque_next = 0;
+	queue->finished_next = 0;
+	queue->steal_hint = 0;
 
 	zbx_hashset_create(&queue->sequences, 100, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 
-	if (0 != (err = pthread_mutex_init(&queue->lock, NULL)))
+	queue->deques = (zbx_pp_deque_t *)zbx_calloc(NULL, (size_t)workers_num, sizeof(zbx_pp_deque_t));
+	queue->deques_num = 0;
+
+	while (queue->deques_num < workers_num)
 	{
-		*error = zbx_dsprintf(NULL, "cannot initialize task queue mutex: %s", zbx_strerror(err));
-		goto out;
+		if (SUCCEED != pp_task_deque_init(&queue->deques[queue->deques_num++], error))
+			goto out;
 	}
-	queue->init_flags |= PP_TASK_QUEUE_INIT_LOCK;
 
-	if (0 != (err = pthread_cond_init(&queue->event, NULL)))
+	if (0 != (err = pthread_mutex_init(&queue->lock, NULL)))
 	{
-		*error = zbx_dsprintf(NULL, "cannot initialize task queue conditional variable: %s", zbx_strerror(err));
+		*error = zbx_dsprintf(NULL, "cannot initialize task queue mutex: %s", zbx_strerror(err));
 		goto out;
 	}
-	queue->init_flags |= PP_TASK_QUEUE_INIT_EVENT;
+	queue->init_flags |= PP_TASK_QUEUE_INIT_LOCK;
 
 	ret = SUCCEED;
 out:
@@ -84,19 +169,6 @@ out:
 	return ret;
 }
 
-/******************************************************************************
- *                                                                            *
- * Purpose: clear task list                                                   *
- *                                                                            *
- ******************************************************************************/
-static void	pp_task_queue_clear_tasks(zbx_list_t *tasks)
-{
-	zbx_pp_task_t	*task = NULL;
-
-	while (SUCCEED == zbx_list_pop(tasks, (void **)&task))
-		pp_task_free(task);
-}
-
 /******************************************************************************
  *                                                                            *
  * Purpose: destroy task queue                                                *
@@ -104,20 +176,16 @@ static void	pp_task_queue_clear_tasks(zbx_list_t *tasks)
  ******************************************************************************/
 void	pp_task_queue_destroy(zbx_pp_queue_t *queue)
 {
+	int	i;
+
 	if (0 != (queue->init_flags & PP_TASK_QUEUE_INIT_LOCK))
 		pthread_mutex_destroy(&queue->lock);
 
-	if (0 != (queue->init_flags & PP_TASK_QUEUE_INIT_EVENT))
-		pthread_cond_destroy(&queue->event);
-
-	pp_task_queue_clear_tasks(&queue->pending);
-	zbx_list_destroy(&queue->pending);
+	for (i = 0; i < queue->deques_num; i++)
+		pp_task_deque_destroy(&queue->deques[i]);
 
-	pp_task_queue_clear_tasks(&queue->immediate);
-	zbx_list_destroy(&queue->immediate);
-
-	pp_task_queue_clear_tasks(&queue->finished);
-	zbx_list_destroy(&queue->finished);
+	zbx_free(queue->deques);
+	queue->deques_num = 0;
 
 	zbx_hashset_destroy(&queue->sequences);
 
@@ -128,6 +196,10 @@ void	pp_task_queue_destroy(zbx_pp_queue_t *queue)
  *                                                                            *
  * Purpose: lock task queue                                                   *
  *                                                                            *
+ * Comments: The task queue lock protects task sequences and queue counters   *
+ *           used by manager. Workers use only their own deque locks, except  *
+ *           when stealing tasks.                                             *
+ *                                                                            *
  ******************************************************************************/
 void	pp_task_queue_lock(zbx_pp_queue_t *queue)
 {
@@ -164,6 +236,62 @@ void	pp_task_queue_deregister_worker(zbx_pp_queue_t *queue)
 	queue->workers_num--;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: add task to worker deque                                          *
+ *                                                                            *
+ * Parameters: queue     - [IN] task queue                                    *
+ *             index     - [IN] worker deque index                            *
+ *             immediate - [IN] 1 - task must be processed before normal      *
+ *                                  tasks                                     *
+ *                              0 - normal task                               *
+ *             task      - [IN] task to add                                   *
+ *                                                                            *
+ ******************************************************************************/
+static void	pp_task_queue_push_deque(zbx_pp_queue_t *queue, int index, int immediate, zbx_pp_task_t *task)
+{
+	zbx_pp_deque_t	*deque = &queue->deques[index];
+
+	pthread_mutex_lock(&deque->lock);
+
+	zbx_list_append(0 != immediate ? &deque->immediate : &deque->pending, task, NULL);
+
+	if (0 != deque->idle)
+		pthread_cond_signal(&deque->event);
+	else if (ZBX_PP_TASK_SEQUENCE != task->type)
+		queue->steal_hint = 1;
+
+	pthread_mutex_unlock(&deque->lock);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get deque index for tasks without worker affinity                 *
+ *                                                                            *
+ ******************************************************************************/
+static int	pp_task_queue_next_deque(zbx_pp_queue_t *queue)
+{
+	int	index = queue->deque_next++;
+
+	if (queue->deque_next == queue->deques_num)
+		queue->deque_next = 0;
+
+	return index;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get deque index for sequence tasks                                *
+ *                                                                            *
+ * Comments: All tasks of the same item sequence are processed by the same    *
+ *           worker.                                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	pp_task_queue_sequence_deque(const zbx_pp_queue_t *queue, zbx_uint64_t itemid)
+{
+	return (int)(itemid % (zbx_uint64_t)queue->deques_num);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: add task to an existing sequence or create/append to a new one    *
@@ -214,20 +342,21 @@ void	pp_task_queue_push_immediate(zbx_pp_queue_t *queue, zbx_pp_task_t *task)
 	{
 		case ZBX_PP_TASK_VALUE_SEQ:
 		case ZBX_PP_TASK_DEPENDENT:
-			queue->pending_num++;
+			queue->queued_num++;
 			if (NULL == (task = pp_task_queue_add_sequence(queue, task)))
 				return;
 			break;
 		case ZBX_PP_TASK_SEQUENCE:
 			/* sequence task is just a container for other tasks - it does not affect statistics, */
-			/* so there is no need to increment queue->pending_num                                */
+			/* so there is no need to increment queue->queued_num                                 */
 			break;
 		default:
-			queue->pending_num++;
-			break;
+			queue->queued_num++;
+			pp_task_queue_push_deque(queue, pp_task_queue_next_deque(queue), 1, task);
+			return;
 	}
 
-	zbx_list_append(&queue->immediate, task, NULL);
+	pp_task_queue_push_deque(queue, pp_task_queue_sequence_deque(queue, task->itemid), 1, task);
 }
 
 /******************************************************************************
@@ -253,8 +382,8 @@ void	pp_task_queue_remove_sequence(zbx_pp_queue_t *queue, zbx_uint64_t itemid)
  ******************************************************************************/
 void	pp_task_queue_push_test(zbx_pp_queue_t *queue, zbx_pp_task_t *task)
 {
-	queue->pending_num++;
-	zbx_list_append(&queue->immediate, task, NULL);
+	queue->queued_num++;
+	pp_task_queue_push_deque(queue, pp_task_queue_next_deque(queue), 1, task);
 }
 
 /******************************************************************************
@@ -271,24 +400,99 @@ void	pp_task_queue_push_test(zbx_pp_queue_t *queue, zbx_pp_task_t *task)
 void	pp_task_queue_push(zbx_pp_queue_t *queue, zbx_pp_task_t *task)
 {
 	zbx_pp_task_value_t	*d = (zbx_pp_task_value_t *)PP_TASK_DATA(task);
-	queue->pending_num++;
+	zbx_pp_task_t		*seq_task;
+	int			immediate;
+
+	queue->queued_num++;
 
-	if (ITEM_TYPE_INTERNAL != d->preproc->type)
+	immediate = (ITEM_TYPE_INTERNAL == d->preproc->type ? 1 : 0);
+
+	if (ZBX_PP_TASK_VALUE == task->type)
 	{
-		zbx_list_append(&queue->pending, task, NULL);
+		pp_task_queue_push_deque(queue, pp_task_queue_next_deque(queue), immediate, task);
 		return;
 	}
 
-	if (ZBX_PP_TASK_VALUE == task->type)
+	if (NULL != (seq_task = pp_task_queue_add_sequence(queue, task)))
 	{
-		zbx_list_append(&queue->immediate, task, NULL);
-		return;
+		pp_task_queue_push_deque(queue, pp_task_queue_sequence_deque(queue, seq_task->itemid), immediate,
+				seq_task);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: pop the first task that is allowed to be stolen                   *
+ *                                                                            *
+ * Parameters: tasks - [IN] task list                                         *
+ *                                                                            *
+ * Return value: The popped task or NULL if there are no tasks to steal.      *
+ *                                                                            *
+ * Comments: Sequence tasks are bound to their worker and cannot be stolen.   *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_pp_task_t	*pp_task_queue_pop_stealable(zbx_list_t *tasks)
+{
+	zbx_list_iterator_t	li;
+	zbx_pp_task_t		*task;
+	int			scanned_num = 0;
+
+	if (FAIL == zbx_list_peek(tasks, (void **)&task))
+		return NULL;
+
+	if (ZBX_PP_TASK_SEQUENCE != task->type)
+	{
+		(void)zbx_list_pop(tasks, NULL);
+		return task;
 	}
 
-	zbx_pp_task_t	*seq_task;
+	zbx_list_iterator_init(tasks, &li);
+	(void)zbx_list_iterator_next(&li);
 
-	if (NULL != (seq_task = pp_task_queue_add_sequence(queue, task)))
-		zbx_list_append(&queue->immediate, seq_task, NULL);
+	while (NULL != li.next && PP_TASK_QUEUE_STEAL_SCAN_MAX > ++scanned_num)
+	{
+		task = (zbx_pp_task_t *)li.next->data;
+
+		if (ZBX_PP_TASK_SEQUENCE != task->type)
+			return (zbx_pp_task_t *)zbx_list_iterator_remove_next(&li);
+
+		(void)zbx_list_iterator_next(&li);
+	}
+
+	return NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: steal task from other worker deques                               *
+ *                                                                            *
+ * Parameters: queue - [IN] task queue                                        *
+ *             index - [IN] the thief worker deque index                      *
+ *                                                                            *
+ * Return value: The stolen task or NULL if there are no tasks to steal.      *
+ *                                                                            *
+ * Comments: Busy deques are skipped instead of waiting for their locks.      *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_pp_task_t	*pp_task_queue_steal(zbx_pp_queue_t *queue, int index)
+{
+	zbx_pp_task_t	*task = NULL;
+	int		i;
+
+	for (i = 1; i < queue->deques_num && NULL == task; i++)
+	{
+		zbx_pp_deque_t	*victim = &queue->deques[(index + i) % queue->deques_num];
+
+		if (0 != pthread_mutex_trylock(&victim->lock))
+			continue;
+
+		if (NULL == (task = pp_task_queue_pop_stealable(&victim->immediate)))
+			task = pp_task_queue_pop_stealable(&victim->pending);
+
+		pthread_mutex_unlock(&victim->lock);
+	}
+
+	return task;
 }
 
 /******************************************************************************
@@ -296,48 +500,155 @@ void	pp_task_queue_push(zbx_pp_queue_t *queue, zbx_pp_task_t *task)
  * Purpose: pop task from task queue                                          *
  *                                                                            *
  * Parameters: queue - [IN] task queue                                        *
+ *             index - [IN] the worker deque index                            *
  *                                                                            *
  * Return value: The popped task or NULL if there are no tasks to be          *
  *               processed.                                                   *
  *                                                                            *
  * Comments: This function is used by workers to pop tasks for processing.    *
- *           Sequence tasks will be moved to existing tasks sequences or      *
- *           returned if there are no registered sequences for this item.     *
+ *           Tasks are taken from the worker deque first and stolen from      *
+ *           other worker deques if the worker deque is empty.                *
  *                                                                            *
  ******************************************************************************/
-zbx_pp_task_t	*pp_task_queue_pop_new(zbx_pp_queue_t *queue)
+zbx_pp_task_t	*pp_task_queue_pop_new(zbx_pp_queue_t *queue, int index)
 {
+	zbx_pp_deque_t	*deque = &queue->deques[index];
 	zbx_pp_task_t	*task = NULL;
 
-	if (SUCCEED == zbx_list_pop(&queue->immediate, (void **)&task))
+	pthread_mutex_lock(&deque->lock);
+
+	if (SUCCEED == zbx_list_pop(&deque->immediate, (void **)&task) ||
+			SUCCEED == zbx_list_pop(&deque->pending, (void **)&task))
 	{
 		/* while sequence tasks do not affect statistics, the first task in sequence */
 		/* does, so the statistics can be updated for all tasks                      */
-		queue->pending_num--;
-		queue->processing_num++;
+		deque->started_num++;
+		pthread_mutex_unlock(&deque->lock);
 
-		return (zbx_pp_task_t *)task;
+		return task;
 	}
 
-	while (SUCCEED == zbx_list_pop(&queue->pending, (void **)&task))
+	pthread_mutex_unlock(&deque->lock);
+
+	if (NULL != (task = pp_task_queue_steal(queue, index)))
 	{
-		if (ZBX_PP_TASK_VALUE_SEQ == task->type)
-		{
-			/* task is being moved from pending to immediate queue */
-			/* while still pending, so statistics are not affected */
-			task = pp_task_queue_add_sequence(queue, task);
-		}
+		pthread_mutex_lock(&deque->lock);
+		deque->started_num++;
+		deque->steal_num++;
+		pthread_mutex_unlock(&deque->lock);
+	}
 
-		if (NULL != task)
-		{
-			queue->pending_num--;
-			queue->processing_num++;
+	return task;
+}
 
-			return task;
-		}
+/******************************************************************************
+ *                                                                            *
+ * Purpose: check if task can be processed in batch with the specified        *
+ *          preprocessing steps                                               *
+ *                                                                            *
+ ******************************************************************************/
+static int	pp_task_queue_batch_match(zbx_pp_task_t *task, const zbx_pp_item_preproc_t *preproc)
+{
+	zbx_pp_task_value_t	*d;
+
+	if (NULL == (d = pp_task_get_batch_value(task)) || d->preproc->steps_num != preproc->steps_num)
+		return FAIL;
+
+	for (int i = 0; i < preproc->steps_num; i++)
+	{
+		if (d->preproc->steps[i].type != preproc->steps[i].type)
+			return FAIL;
 	}
 
-	return NULL;
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: pop tasks matching the specified preprocessing steps              *
+ *                                                                            *
+ * Parameters: tasks       - [IN] task list                                   *
+ *             preproc     - [IN] preprocessing steps to match                *
+ *             batch       - [OUT] the popped tasks                           *
+ *             batch_max   - [IN] the maximum number of tasks to pop          *
+ *             scanned_num - [IN/OUT] the number of checked tasks             *
+ *                                                                            *
+ * Return value: The number of popped tasks.                                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	pp_task_queue_pop_matching(zbx_list_t *tasks, const zbx_pp_item_preproc_t *preproc,
+		zbx_pp_task_t **batch, int batch_max, int *scanned_num)
+{
+	zbx_list_iterator_t	li;
+	zbx_pp_task_t		*task;
+	int			num = 0;
+
+	while (num < batch_max && PP_TASK_QUEUE_BATCH_SCAN_MAX > *scanned_num &&
+			SUCCEED == zbx_list_peek(tasks, (void **)&task))
+	{
+		(*scanned_num)++;
+
+		if (SUCCEED != pp_task_queue_batch_match(task, preproc))
+			break;
+
+		(void)zbx_list_pop(tasks, NULL);
+		batch[num++] = task;
+	}
+
+	zbx_list_iterator_init(tasks, &li);
+
+	if (FAIL == zbx_list_iterator_next(&li))
+		return num;
+
+	while (NULL != li.next && num < batch_max && PP_TASK_QUEUE_BATCH_SCAN_MAX > (*scanned_num)++)
+	{
+		task = (zbx_pp_task_t *)li.next->data;
+
+		if (SUCCEED == pp_task_queue_batch_match(task, preproc))
+			batch[num++] = (zbx_pp_task_t *)zbx_list_iterator_remove_next(&li);
+		else
+			(void)zbx_list_iterator_next(&li);
+	}
+
+	return num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: pop tasks to be processed in batch with the specified task        *
+ *                                                                            *
+ * Parameters: queue     - [IN] task queue                                    *
+ *             index     - [IN] the worker deque index                        *
+ *             task      - [IN] the task already popped for processing        *
+ *             batch     - [OUT] the popped tasks                             *
+ *             batch_max - [IN] the maximum number of tasks to pop            *
+ *                                                                            *
+ * Return value: The number of popped tasks.                                  *
+ *                                                                            *
+ * Comments: Tasks with the same sequence of preprocessing step types are     *
+ *           taken only from the worker deque - a sequence task contributes   *
+ *           only its first task, so the order of item values is kept.        *
+ *                                                                            *
+ ******************************************************************************/
+int	pp_task_queue_pop_batch(zbx_pp_queue_t *queue, int index, zbx_pp_task_t *task, zbx_pp_task_t **batch,
+		int batch_max)
+{
+	zbx_pp_deque_t		*deque = &queue->deques[index];
+	zbx_pp_task_value_t	*d;
+	int			num, scanned_num = 0;
+
+	if (NULL == (d = pp_task_get_batch_value(task)))
+		return 0;
+
+	pthread_mutex_lock(&deque->lock);
+
+	num = pp_task_queue_pop_matching(&deque->immediate, d->preproc, batch, batch_max, &scanned_num);
+	num += pp_task_queue_pop_matching(&deque->pending, d->preproc, batch + num, batch_max - num, &scanned_num);
+	deque->started_num += (zbx_uint64_t)num;
+
+	pthread_mutex_unlock(&deque->lock);
+
+	return num;
 }
 
 /******************************************************************************
@@ -345,14 +656,18 @@ zbx_pp_task_t	*pp_task_queue_pop_new(zbx_pp_queue_t *queue)
  * Purpose: push finished task into queue                                     *
  *                                                                            *
  * Parameters: queue - [IN] task queue                                        *
+ *             index - [IN] the worker deque index                            *
  *             task  - [IN] task                                              *
  *                                                                            *
  ******************************************************************************/
-void	pp_task_queue_push_finished(zbx_pp_queue_t *queue, zbx_pp_task_t *task)
+void	pp_task_queue_push_finished(zbx_pp_queue_t *queue, int index, zbx_pp_task_t *task)
 {
-	queue->finished_num++;
-	queue->processing_num--;
-	zbx_list_append(&queue->finished, task, NULL);
+	zbx_pp_deque_t	*deque = &queue->deques[index];
+
+	pthread_mutex_lock(&deque->lock);
+	deque->finished_num++;
+	zbx_list_append(&deque->finished, task, NULL);
+	pthread_mutex_unlock(&deque->lock);
 }
 
 /******************************************************************************
@@ -367,11 +682,24 @@ void	pp_task_queue_push_finished(zbx_pp_queue_t *queue, zbx_pp_task_t *task)
 zbx_pp_task_t	*pp_task_queue_pop_finished(zbx_pp_queue_t *queue)
 {
 	zbx_pp_task_t	*task;
+	int		i, ret;
 
-	if (SUCCEED == zbx_list_pop(&queue->finished, (void **)&task))
+	for (i = 0; i < queue->deques_num; i++)
 	{
-		queue->finished_num--;
-		return task;
+		zbx_pp_deque_t	*deque = &queue->deques[queue->finished_next];
+
+		pthread_mutex_lock(&deque->lock);
+		ret = zbx_list_pop(&deque->finished, (void **)&task);
+		pthread_mutex_unlock(&deque->lock);
+
+		if (SUCCEED == ret)
+		{
+			queue->returned_num++;
+			return task;
+		}
+
+		if (++queue->finished_next == queue->deques_num)
+			queue->finished_next = 0;
 	}
 
 	return NULL;
@@ -382,6 +710,8 @@ zbx_pp_task_t	*pp_task_queue_pop_finished(zbx_pp_queue_t *queue)
  * Purpose: wait for queue notifications                                      *
  *                                                                            *
  * Parameters: queue - [IN] task queue                                        *
+ *             index - [IN] the worker deque index                            *
+ *             stop  - [IN] the worker stop flag                              *
  *             error - [IN]                                                   *
  *                                                                            *
  * Return value: SUCCEED - the wait succeeded                                 *
@@ -390,36 +720,71 @@ zbx_pp_task_t	*pp_task_queue_pop_finished(zbx_pp_queue_t *queue)
  * Comments: This function is used by workers to wait for new tasks.          *
  *                                                                            *
  ******************************************************************************/
-int	pp_task_queue_wait(zbx_pp_queue_t *queue, char **error)
+int	pp_task_queue_wait(zbx_pp_queue_t *queue, int index, const int *stop, char **error)
 {
-	int	err;
+	zbx_pp_deque_t	*deque = &queue->deques[index];
+	int		err, ret = SUCCEED;
+
+	pthread_mutex_lock(&deque->lock);
 
-	if (0 != (err = pthread_cond_wait(&queue->event, &queue->lock)))
+	/* tasks could have been pushed while trying to steal */
+	if (0 == *stop && NULL == deque->immediate.head && NULL == deque->pending.head)
 	{
-		*error = zbx_dsprintf(NULL, "cannot wait for conditional variable: %s", zbx_strerror(err));
-		return FAIL;
+		deque->idle = 1;
+		deque->idle_num++;
+
+		if (0 != (err = pthread_cond_wait(&deque->event, &deque->lock)))
+		{
+			*error = zbx_dsprintf(NULL, "cannot wait for conditional variable: %s", zbx_strerror(err));
+			ret = FAIL;
+		}
+
+		deque->idle = 0;
 	}
 
-	return SUCCEED;
+	pthread_mutex_unlock(&deque->lock);
+
+	return ret;
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: notify one worker                                                 *
+ * Purpose: notify idle worker about tasks that can be stolen                 *
  *                                                                            *
  * Parameters: queue - [IN] task queue                                        *
  *                                                                            *
- * Comments: This function is used by manager to notify a worker when a new   *
- *           task has been queued.                                            *
+ * Comments: This function is used by manager after new tasks have been       *
+ *           queued. Workers owning the task deques are notified when the     *
+ *           tasks are pushed, so an idle worker is woken up only if tasks    *
+ *           were pushed to deques of busy workers.                           *
  *                                                                            *
  ******************************************************************************/
 void	pp_task_queue_notify(zbx_pp_queue_t *queue)
 {
-	int	err;
+	int	i, err;
+
+	if (0 == queue->steal_hint)
+		return;
 
-	if (0 != (err = pthread_cond_signal(&queue->event)))
+	queue->steal_hint = 0;
+
+	for (i = 0; i < queue->deques_num; i++)
 	{
-		zabbix_log(LOG_LEVEL_WARNING, "cannot signal conditional variable: %s", zbx_strerror(err));
+		zbx_pp_deque_t	*deque = &queue->deques[i];
+		int		idle;
+
+		pthread_mutex_lock(&deque->lock);
+
+		if (0 != (idle = deque->idle))
+		{
+			if (0 != (err = pthread_cond_signal(&deque->event)))
+				zabbix_log(LOG_LEVEL_WARNING, "cannot signal conditional variable: %s", zbx_strerror(err));
+		}
+
+		pthread_mutex_unlock(&deque->lock);
+
+		if (0 != idle)
+			break;
 	}
 }
 
@@ -429,17 +794,88 @@ void	pp_task_queue_notify(zbx_pp_queue_t *queue)
  *                                                                            *
  * Parameters: queue - [IN] task queue                                        *
  *                                                                            *
- * Comments: This function is used by manager to notify workers when either   *
- *           multiple tasks have been pushed or when stopping workers.        *
+ * Comments: This function is used by manager to notify workers when          *
+ *           stopping them.                                                   *
  *                                                                            *
  ******************************************************************************/
 void	pp_task_queue_notify_all(zbx_pp_queue_t *queue)
 {
-	int	err;
+	int	i, err;
+
+	for (i = 0; i < queue->deques_num; i++)
+	{
+		zbx_pp_deque_t	*deque = &queue->deques[i];
+
+		pthread_mutex_lock(&deque->lock);
+
+		if (0 != (err = pthread_cond_broadcast(&deque->event)))
+			zabbix_log(LOG_LEVEL_WARNING, "cannot broadcast conditional variable: %s", zbx_strerror(err));
+
+		pthread_mutex_unlock(&deque->lock);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get task queue statistics                                         *
+ *                                                                            *
+ * Parameters: queue          - [IN] task queue                               *
+ *             pending_num    - [OUT] tasks waiting to be processed           *
+ *             processing_num - [OUT] tasks being processed                   *
+ *             finished_num   - [OUT] finished tasks not yet returned to      *
+ *                                    manager                                 *
+ *                                                                            *
+ * Comments: This function is called by manager within task queue lock.       *
+ *                                                                            *
+ ******************************************************************************/
+void	pp_task_queue_get_stats(zbx_pp_queue_t *queue, zbx_uint64_t *pending_num, zbx_uint64_t *processing_num,
+		zbx_uint64_t *finished_num)
+{
+	zbx_uint64_t	started_num = 0, done_num = 0;
+	int		i;
+
+	for (i = 0; i < queue->deques_num; i++)
+	{
+		zbx_pp_deque_t	*deque = &queue->deques[i];
+
+		pthread_mutex_lock(&deque->lock);
+		started_num += deque->started_num;
+		done_num += deque->finished_num;
+		pthread_mutex_unlock(&deque->lock);
+	}
+
+	*pending_num = queue->queued_num - started_num;
+	*processing_num = started_num - done_num;
+	*finished_num = done_num - queue->returned_num;
+}
 
-	if (0 != (err = pthread_cond_broadcast(&queue->event)))
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get per worker task steal and idle wait counters                  *
+ *                                                                            *
+ * Parameters: queue  - [IN] task queue                                       *
+ *             steals - [OUT] tasks stolen by each worker (optional)          *
+ *             idles  - [OUT] idle waits of each worker (optional)            *
+ *                                                                            *
+ ******************************************************************************/
+void	pp_task_queue_get_worker_stats(zbx_pp_queue_t *queue, zbx_vector_uint64_t *steals,
+		zbx_vector_uint64_t *idles)
+{
+	int	i;
+
+	for (i = 0; i < queue->deques_num; i++)
 	{
-		zabbix_log(LOG_LEVEL_WARNING, "cannot broadcast conditional variable: %s", zbx_strerror(err));
+		zbx_pp_deque_t	*deque = &queue->deques[i];
+
+		pthread_mutex_lock(&deque->lock);
+
+		if (NULL != steals)
+			zbx_vector_uint64_append(steals, deque->steal_num);
+
+		if (NULL != idles)
+			zbx_vector_uint64_append(idles, deque->idle_num);
+
+		pthread_mutex_unlock(&deque->lock);
 	}
 }
 
@@ -23,26 +23,46 @@
 #include "zbxpreproc.h"
 #include "zbxalgo.h"
 
+/* worker task deque */
 typedef struct
 {
 	zbx_uint32_t	init_flags;
-	int		workers_num;
-	zbx_uint64_t	pending_num;
-	zbx_uint64_t	finished_num;
-	zbx_uint64_t	processing_num;
-
-	zbx_hashset_t	sequences;
 
-	zbx_list_t	pending;
 	zbx_list_t	immediate;
+	zbx_list_t	pending;
 	zbx_list_t	finished;
 
+	zbx_uint64_t	started_num;	/* the number of tasks taken for processing by the worker */
+	zbx_uint64_t	finished_num;	/* the number of tasks finished by the worker */
+	zbx_uint64_t	steal_num;	/* the number of tasks stolen from other workers */
+	zbx_uint64_t	idle_num;	/* the number of times worker waited for new tasks */
+	int		idle;
+
 	pthread_mutex_t	lock;
 	pthread_cond_t	event;
 }
+zbx_pp_deque_t;
+
+typedef struct
+{
+	zbx_uint32_t	init_flags;
+	int		workers_num;
+	zbx_uint64_t	queued_num;	/* the number of tasks queued by manager */
+	zbx_uint64_t	returned_num;	/* the number of finished tasks returned to manager */
+
+	zbx_hashset_t	sequences;
+
+	zbx_pp_deque_t	*deques;
+	int		deques_num;
+	int		deque_next;
+	int		finished_next;
+	int		steal_hint;
+
+	pthread_mutex_t	lock;
+}
 zbx_pp_queue_t;
 
-int	pp_task_queue_init(zbx_pp_queue_t *queue, char **error);
+int	pp_task_queue_init(zbx_pp_queue_t *queue, int workers_num, char **error);
 void	pp_task_queue_destroy(zbx_pp_queue_t *queue);
 
 void	pp_task_queue_lock(zbx_pp_queue_t *queue);
@@ -51,18 +71,24 @@ void	pp_task_queue_register_worker(zbx_pp_queue_t *queue);
 void	pp_task_queue_deregister_worker(zbx_pp_queue_t *queue);
 void	pp_task_queue_remove_sequence(zbx_pp_queue_t *queue, zbx_uint64_t itemid);
 
-int	pp_task_queue_wait(zbx_pp_queue_t *queue, char **error);
+int	pp_task_queue_wait(zbx_pp_queue_t *queue, int index, const int *stop, char **error);
 void	pp_task_queue_notify(zbx_pp_queue_t *queue);
 void	pp_task_queue_notify_all(zbx_pp_queue_t *queue);
 
 void	pp_task_queue_push_test(zbx_pp_queue_t *queue, zbx_pp_task_t *task);
 void	pp_task_queue_push(zbx_pp_queue_t *queue, zbx_pp_task_t *task);
 
-zbx_pp_task_t	*pp_task_queue_pop_new(zbx_pp_queue_t *queue);
+zbx_pp_task_t	*pp_task_queue_pop_new(zbx_pp_queue_t *queue, int index);
+int	pp_task_queue_pop_batch(zbx_pp_queue_t *queue, int index, zbx_pp_task_t *task, zbx_pp_task_t **batch,
+		int batch_max);
 void	pp_task_queue_push_immediate(zbx_pp_queue_t *queue, zbx_pp_task_t *task);
-void	pp_task_queue_push_finished(zbx_pp_queue_t *queue, zbx_pp_task_t *task);
+void	pp_task_queue_push_finished(zbx_pp_queue_t *queue, int index, zbx_pp_task_t *task);
 zbx_pp_task_t	*pp_task_queue_pop_finished(zbx_pp_queue_t *queue);
 
+void	pp_task_queue_get_stats(zbx_pp_queue_t *queue, zbx_uint64_t *pending_num, zbx_uint64_t *processing_num,
+		zbx_uint64_t *finished_num);
+void	pp_task_queue_get_worker_stats(zbx_pp_queue_t *queue, zbx_vector_uint64_t *steals,
+		zbx_vector_uint64_t *idles);
 void	pp_task_queue_get_sequence_stats(zbx_pp_queue_t *queue, zbx_vector_pp_sequence_stats_ptr_t *stats);
 
 #endif
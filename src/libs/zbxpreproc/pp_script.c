@@ -0,0 +1,240 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "pp_script.h"
+
+#include "zbxcommon.h"
+
+#define PP_SCRIPT_CACHE_INIT_NONE	0x00
+#define PP_SCRIPT_CACHE_INIT_LOCK	0x01
+#define PP_SCRIPT_CACHE_INIT_SCRIPTS	0x02
+
+/* bytecode of scripts not used during this period is removed from cache */
+#define PP_SCRIPT_CACHE_TTL		SEC_PER_DAY
+#define PP_SCRIPT_CACHE_PRUNE_PERIOD	SEC_PER_HOUR
+
+typedef struct
+{
+	char	*script;
+	void	*bytecode;
+	time_t	lastaccess;
+}
+zbx_pp_script_t;
+
+static zbx_hash_t	pp_script_hash(const void *d)
+{
+	const zbx_pp_script_t	*script = (const zbx_pp_script_t *)d;
+
+	return ZBX_DEFAULT_STRING_HASH_FUNC(script->script);
+}
+
+static int	pp_script_compare(const void *d1, const void *d2)
+{
+	const zbx_pp_script_t	*script1 = (const zbx_pp_script_t *)d1;
+	const zbx_pp_script_t	*script2 = (const zbx_pp_script_t *)d2;
+
+	return strcmp(script1->script, script2->script);
+}
+
+static void	pp_script_clear(void *d)
+{
+	zbx_pp_script_t	*script = (zbx_pp_script_t *)d;
+
+	zbx_free(script->script);
+	zbx_free(script->bytecode);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: initialize script bytecode cache                                  *
+ *                                                                            *
+ * Parameters: cache - [IN] script bytecode cache                             *
+ *             error - [OUT]                                                  *
+ *                                                                            *
+ * Return value: SUCCEED - the cache was initialized successfully             *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	pp_script_cache_init(zbx_pp_script_cache_t *cache, char **error)
+{
+	int	err;
+
+	memset(cache, 0, sizeof(zbx_pp_script_cache_t));
+
+	zbx_hashset_create_ext(&cache->scripts, 0, pp_script_hash, pp_script_compare, pp_script_clear,
+			ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
+	cache->init_flags |= PP_SCRIPT_CACHE_INIT_SCRIPTS;
+
+	if (0 != (err = pthread_mutex_init(&cache->lock, NULL)))
+	{
+		*error = zbx_dsprintf(NULL, "cannot initialize script cache mutex: %s", zbx_strerror(err));
+		return FAIL;
+	}
+	cache->init_flags |= PP_SCRIPT_CACHE_INIT_LOCK;
+
+	cache->prune_time = time(NULL);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: destroy script bytecode cache                                     *
+ *                                                                            *
+ ******************************************************************************/
+void	pp_script_cache_destroy(zbx_pp_script_cache_t *cache)
+{
+	if (0 != (cache->init_flags & PP_SCRIPT_CACHE_INIT_LOCK))
+		pthread_mutex_destroy(&cache->lock);
+
+	if (0 != (cache->init_flags & PP_SCRIPT_CACHE_INIT_SCRIPTS))
+		zbx_hashset_destroy(&cache->scripts);
+
+	cache->init_flags = PP_SCRIPT_CACHE_INIT_NONE;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get cached script bytecode                                        *
+ *                                                                            *
+ * Parameters: cache    - [IN] script bytecode cache                          *
+ *             script   - [IN] the script                                     *
+ *             bytecode - [OUT] copy of the script bytecode                   *
+ *                                                                            *
+ * Return value: SUCCEED - the bytecode was found in cache                    *
+ *               FAIL    - the script must be compiled                        *
+ *                                                                            *
+ ******************************************************************************/
+int	pp_script_cache_get(zbx_pp_script_cache_t *cache, const char *script, zbx_variant_t *bytecode)
+{
+	zbx_pp_script_t	script_local, *cached;
+	int		ret = FAIL;
+
+	script_local.script = (char *)script;
+
+	pthread_mutex_lock(&cache->lock);
+
+	if (NULL != (cached = (zbx_pp_script_t *)zbx_hashset_search(&cache->scripts, &script_local)))
+	{
+		void		*code;
+		zbx_uint32_t	size;
+
+		size = zbx_variant_data_bin_get(cached->bytecode, &code);
+		zbx_variant_clear(bytecode);
+		zbx_variant_set_bin(bytecode, zbx_variant_data_bin_create(code, size));
+
+		cached->lastaccess = time(NULL);
+		cache->stats.hits_num++;
+		ret = SUCCEED;
+	}
+
+	pthread_mutex_unlock(&cache->lock);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: remove bytecode of scripts that have not been used for a while    *
+ *                                                                            *
+ * Comments: The cache must be locked.                                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	pp_script_cache_prune(zbx_pp_script_cache_t *cache, time_t now)
+{
+	zbx_hashset_iter_t	iter;
+	zbx_pp_script_t		*script;
+
+	zbx_hashset_iter_reset(&cache->scripts, &iter);
+	while (NULL != (script = (zbx_pp_script_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (script->lastaccess + PP_SCRIPT_CACHE_TTL < now)
+			zbx_hashset_iter_remove(&iter);
+	}
+
+	cache->prune_time = now;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: cache compiled script bytecode                                    *
+ *                                                                            *
+ * Parameters: cache    - [IN] script bytecode cache                          *
+ *             script   - [IN] the compiled script                            *
+ *             bytecode - [IN] the script bytecode                            *
+ *                                                                            *
+ ******************************************************************************/
+void	pp_script_cache_put(zbx_pp_script_cache_t *cache, const char *script, const zbx_variant_t *bytecode)
+{
+	zbx_pp_script_t	script_local, *cached;
+	void		*code;
+	zbx_uint32_t	size;
+	time_t		now;
+
+	if (ZBX_VARIANT_BIN != bytecode->type)
+		return;
+
+	now = time(NULL);
+	size = zbx_variant_data_bin_get(bytecode->data.bin, &code);
+	script_local.script = (char *)script;
+
+	pthread_mutex_lock(&cache->lock);
+
+	cache->stats.compiled_num++;
+
+	if (cache->prune_time + PP_SCRIPT_CACHE_PRUNE_PERIOD < now)
+		pp_script_cache_prune(cache, now);
+
+	/* another worker could have compiled the same script meanwhile */
+	if (NULL == (cached = (zbx_pp_script_t *)zbx_hashset_search(&cache->scripts, &script_local)))
+	{
+		script_local.script = zbx_strdup(NULL, script);
+		script_local.bytecode = zbx_variant_data_bin_create(code, size);
+		cached = (zbx_pp_script_t *)zbx_hashset_insert(&cache->scripts, &script_local, sizeof(script_local));
+	}
+
+	cached->lastaccess = now;
+
+	pthread_mutex_unlock(&cache->lock);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: account scripting environment reset after fatal error             *
+ *                                                                            *
+ ******************************************************************************/
+void	pp_script_cache_add_reset(zbx_pp_script_cache_t *cache)
+{
+	pthread_mutex_lock(&cache->lock);
+	cache->stats.resets_num++;
+	pthread_mutex_unlock(&cache->lock);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get script bytecode cache statistics                              *
+ *                                                                            *
+ ******************************************************************************/
+void	pp_script_cache_get_stats(zbx_pp_script_cache_t *cache, zbx_pp_script_stats_t *stats)
+{
+	pthread_mutex_lock(&cache->lock);
+	*stats = cache->stats;
+	stats->scripts_num = (zbx_uint64_t)cache->scripts.num_data;
+	pthread_mutex_unlock(&cache->lock);
+}
@@ -0,0 +1,48 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#ifndef ZABBIX_PP_SCRIPT_H
+#define ZABBIX_PP_SCRIPT_H
+
+#include "zbxpreproc.h"
+#include "zbxalgo.h"
+#include "zbxvariant.h"
+
+/* bytecode cache of preprocessing scripts shared by workers */
+typedef struct
+{
+	zbx_uint32_t		init_flags;
+
+	zbx_hashset_t		scripts;
+	time_t			prune_time;
+	zbx_pp_script_stats_t	stats;
+
+	pthread_mutex_t		lock;
+}
+zbx_pp_script_cache_t;
+
+int	pp_script_cache_init(zbx_pp_script_cache_t *cache, char **error);
+void	pp_script_cache_destroy(zbx_pp_script_cache_t *cache);
+
+int	pp_script_cache_get(zbx_pp_script_cache_t *cache, const char *script, zbx_variant_t *bytecode);
+void	pp_script_cache_put(zbx_pp_script_cache_t *cache, const char *script, const zbx_variant_t *bytecode);
+void	pp_script_cache_add_reset(zbx_pp_script_cache_t *cache);
+void	pp_script_cache_get_stats(zbx_pp_script_cache_t *cache, zbx_pp_script_stats_t *stats);
+
+#endif
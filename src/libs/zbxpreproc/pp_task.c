@@ -296,6 +296,44 @@ void	pp_task_free(zbx_pp_task_t *task)
 	zbx_free(task);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get value task data of task that can be processed in batch        *
+ *                                                                            *
+ * Parameters: task - [IN] the task                                           *
+ *                                                                            *
+ * Return value: The value task data or NULL if the task cannot be batched.   *
+ *                                                                            *
+ * Comments: Value tasks and sequences starting with value task can be        *
+ *           batched. Dependent tasks are not batched as they must populate   *
+ *           preprocessing cache before other dependent items are processed.  *
+ *                                                                            *
+ ******************************************************************************/
+zbx_pp_task_value_t	*pp_task_get_batch_value(zbx_pp_task_t *task)
+{
+	zbx_pp_task_t	*task_first;
+
+	switch (task->type)
+	{
+		case ZBX_PP_TASK_VALUE:
+		case ZBX_PP_TASK_VALUE_SEQ:
+			return (zbx_pp_task_value_t *)PP_TASK_DATA(task);
+		case ZBX_PP_TASK_SEQUENCE:
+			if (SUCCEED != zbx_list_peek(&((zbx_pp_task_sequence_t *)PP_TASK_DATA(task))->tasks,
+					(void **)&task_first))
+			{
+				return NULL;
+			}
+
+			if (ZBX_PP_TASK_VALUE != task_first->type && ZBX_PP_TASK_VALUE_SEQ != task_first->type)
+				return NULL;
+
+			return (zbx_pp_task_value_t *)PP_TASK_DATA(task_first);
+		default:
+			return NULL;
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: clear tasks                                                       *
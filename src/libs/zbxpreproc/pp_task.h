@@ -82,4 +82,6 @@ zbx_pp_task_t	*pp_task_value_seq_create(zbx_uint64_t itemid, zbx_pp_item_preproc
 		zbx_timespec_t ts, const zbx_pp_value_opt_t *value_opt, zbx_pp_cache_t *cache);
 zbx_pp_task_t	*pp_task_sequence_create(zbx_uint64_t itemid);
 
+zbx_pp_task_value_t	*pp_task_get_batch_value(zbx_pp_task_t *task);
+
 #endif
@@ -27,10 +27,15 @@
 #include "zbxself.h"
 #include "zbxpreproc.h"
 #include "zbxalgo.h"
+#include "zbxprof.h"
+#include "zbxtime.h"
 
 #define PP_WORKER_INIT_NONE	0x00
 #define PP_WORKER_INIT_THREAD	0x01
 
+/* the maximum number of tasks processed in one batch */
+#define PP_WORKER_BATCH_MAX	32
+
 /******************************************************************************
  *                                                                            *
  * Purpose: process preprocessing testing task                                *
@@ -96,6 +101,33 @@ static	void	pp_task_process_sequence(zbx_pp_context_t *ctx, zbx_pp_task_t *task_
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: process value tasks with the same preprocessing steps in batch    *
+ *                                                                            *
+ * Parameters: ctx       - [IN] worker specific execution context             *
+ *             tasks     - [IN] the tasks to process                          *
+ *             tasks_num - [IN] the number of tasks                           *
+ *                                                                            *
+ ******************************************************************************/
+static void	pp_task_process_batch(zbx_pp_context_t *ctx, zbx_pp_task_t **tasks, int tasks_num)
+{
+	zbx_pp_batch_value_t	values[PP_WORKER_BATCH_MAX];
+
+	for (int i = 0; i < tasks_num; i++)
+	{
+		zbx_pp_task_value_t	*d = pp_task_get_batch_value(tasks[i]);
+
+		values[i].preproc = d->preproc;
+		values[i].cache = d->cache;
+		values[i].value_in = &d->value;
+		values[i].ts = d->ts;
+		values[i].value_out = &d->result;
+	}
+
+	pp_execute_batch(ctx, values, tasks_num);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: preprocessing worker thread entry                                 *
@@ -105,10 +137,11 @@ static void	*pp_worker_entry(void *args)
 {
 	zbx_pp_worker_t		*worker = (zbx_pp_worker_t *)args;
 	zbx_pp_queue_t		*queue = worker->queue;
-	zbx_pp_task_t		*in;
+	zbx_pp_task_t		*in, *batch[PP_WORKER_BATCH_MAX];
 	char			*error = NULL, component[MAX_ID_LEN + 1];
 	sigset_t		mask;
-	int			err;
+	int			err, batch_num;
+	double			sec;
 
 	zbx_snprintf(component, sizeof(component), "%d", worker->id);
 	zbx_set_log_component(component, &worker->logger);
@@ -130,41 +163,59 @@ static void	*pp_worker_entry(void *args)
 	worker->stop = 0;
 
 	pp_context_init(&worker->execute_ctx);
+	worker->execute_ctx.scripts = worker->scripts;
+
 	pp_task_queue_lock(queue);
 	pp_task_queue_register_worker(queue);
+	pp_task_queue_unlock(queue);
 
 	while (0 == worker->stop)
 	{
-		if (NULL != (in = pp_task_queue_pop_new(queue)))
+		if (NULL != (in = pp_task_queue_pop_new(queue, worker->id - 1)))
 		{
-			pp_task_queue_unlock(queue);
-
 			zbx_timekeeper_update(worker->timekeeper, worker->id - 1, ZBX_PROCESS_STATE_BUSY);
 
+			sec = (SUCCEED == zbx_prof_probes_enabled() ? zbx_time() : 0.0);
+
 			zabbix_log(LOG_LEVEL_TRACE, "%s() process task type:%u itemid:" ZBX_FS_UI64, __func__,
 					in->type, in->itemid);
 
-			switch (in->type)
+			batch[0] = in;
+			batch_num = 1 + pp_task_queue_pop_batch(queue, worker->id - 1, in, batch + 1,
+					PP_WORKER_BATCH_MAX - 1);
+
+			if (1 < batch_num)
 			{
-				case ZBX_PP_TASK_TEST:
-					pp_task_process_test(&worker->execute_ctx, in);
-					break;
-				case ZBX_PP_TASK_VALUE:
-				case ZBX_PP_TASK_VALUE_SEQ:
-					pp_task_process_value(&worker->execute_ctx, in);
-					break;
-				case ZBX_PP_TASK_DEPENDENT:
-					pp_task_process_dependent(&worker->execute_ctx, in);
-					break;
-				case ZBX_PP_TASK_SEQUENCE:
-					pp_task_process_sequence(&worker->execute_ctx, in);
-					break;
+				zabbix_log(LOG_LEVEL_TRACE, "%s() process batch of %d tasks", __func__, batch_num);
+				pp_task_process_batch(&worker->execute_ctx, batch, batch_num);
 			}
+			else
+			{
+				switch (in->type)
+				{
+					case ZBX_PP_TASK_TEST:
+						pp_task_process_test(&worker->execute_ctx, in);
+						break;
+					case ZBX_PP_TASK_VALUE:
+					case ZBX_PP_TASK_VALUE_SEQ:
+						pp_task_process_value(&worker->execute_ctx, in);
+						break;
+					case ZBX_PP_TASK_DEPENDENT:
+						pp_task_process_dependent(&worker->execute_ctx, in);
+						break;
+					case ZBX_PP_TASK_SEQUENCE:
+						pp_task_process_sequence(&worker->execute_ctx, in);
+						break;
+				}
+			}
+
+			if (0.0 != sec)
+				zbx_prof_probe_add(ZBX_PROF_PROBE_PREPROCESSING, zbx_time() - sec);
 
 			zbx_timekeeper_update(worker->timekeeper, worker->id - 1, ZBX_PROCESS_STATE_IDLE);
 
-			pp_task_queue_lock(queue);
-			pp_task_queue_push_finished(queue, in);
+			for (int i = 0; i < batch_num; i++)
+				pp_task_queue_push_finished(queue, worker->id - 1, batch[i]);
 
 			if (NULL != worker->finished_cb)
 				worker->finished_cb(worker->finished_data);
@@ -172,17 +223,17 @@ static void	*pp_worker_entry(void *args)
 			continue;
 		}
 
-		if (SUCCEED != pp_task_queue_wait(queue, &error))
+		pp_context_warmup(&worker->execute_ctx);
+
+		if (SUCCEED != pp_task_queue_wait(queue, worker->id - 1, &worker->stop, &error))
 		{
 			zabbix_log(LOG_LEVEL_WARNING, "[%d] %s", worker->id, error);
 			zbx_free(error);
 			worker->stop = 1;
 		}
-
-		if (1 < queue->pending_num)
-			pp_task_queue_notify(queue);
 	}
 
+	pp_task_queue_lock(queue);
 	pp_task_queue_deregister_worker(queue);
 	pp_task_queue_unlock(queue);
 
@@ -199,6 +250,7 @@ static void	*pp_worker_entry(void *args)
  * Parameters: worker     - [IN] preprocessing worker                         *
  *             id         - [IN] worker id (index)                            *
  *             queue      - [IN] task queue                                   *
+ *             scripts    - [IN] shared script bytecode cache                 *
  *             timekeeper - [IN] timekeeper object for busy/idle worker       *
  *                               state reporting                              *
  *             error      - [OUT]                                             *
@@ -207,13 +259,14 @@ static void	*pp_worker_entry(void *args)
  *               FAIL    - otherwise                                          *
  *                                                                            *
  ******************************************************************************/
-int	pp_worker_init(zbx_pp_worker_t *worker, int id, zbx_pp_queue_t *queue, zbx_timekeeper_t *timekeeper,
-		char **error)
+int	pp_worker_init(zbx_pp_worker_t *worker, int id, zbx_pp_queue_t *queue, zbx_pp_script_cache_t *scripts,
+		zbx_timekeeper_t *timekeeper, char **error)
 {
 	int	err, ret = FAIL;
 
 	worker->id = id;
 	worker->queue = queue;
+	worker->scripts = scripts;
 	worker->timekeeper = timekeeper;
 
 	if (0 != (err = pthread_create(&worker->thread, NULL, pp_worker_entry, (void *)worker)))
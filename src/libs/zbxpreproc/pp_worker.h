@@ -34,6 +34,7 @@ typedef struct
 	int				stop;
 
 	zbx_pp_queue_t			*queue;
+	zbx_pp_script_cache_t		*scripts;
 	pthread_t			thread;
 
 	zbx_pp_context_t		execute_ctx;
@@ -47,8 +48,8 @@ typedef struct
 }
 zbx_pp_worker_t;
 
-int	pp_worker_init(zbx_pp_worker_t *worker, int id, zbx_pp_queue_t *queue, zbx_timekeeper_t *timekeeper,
-		char **error);
+int	pp_worker_init(zbx_pp_worker_t *worker, int id, zbx_pp_queue_t *queue, zbx_pp_script_cache_t *scripts,
+		zbx_timekeeper_t *timekeeper, char **error);
 void	pp_worker_set_finished_cb(zbx_pp_worker_t *worker, zbx_pp_notify_cb_t finished_cb, void *finished_data);
 void	pp_worker_stop(zbx_pp_worker_t *worker);
 void	pp_worker_destroy(zbx_pp_worker_t *worker);
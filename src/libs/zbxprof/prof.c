@@ -2,6 +2,8 @@
 #include "zbxalgo.h"
 #include "log.h"
 #include "zbxtime.h"
+#include "zbxmutexs.h"
+#include "zbxsysinc.h"
 
 #define PROF_LEVEL_MAX	10
 
@@ -241,3 +243,320 @@ void	zbx_prof_update(const char *info, double time_now)
 	}
 #undef PROF_UPDATE_INTERVAL
 }
+
+/* Latency probes are kept in private shared memory created by the parent process, so that */
+/* statistics of all processes and threads are available to diaginfo and internal items.   */
+/* Updating a probe takes a few relaxed atomic additions - no locks and no allocations.    */
+
+typedef struct
+{
+	zbx_prof_probe_stats_t	probes[ZBX_PROF_PROBE_COUNT];
+	zbx_prof_probe_stats_t	values[ZBX_PROF_VALUE_STAGE_COUNT][ZBX_PROF_ITEM_TYPES_NUM];
+}
+zbx_prof_probes_t;
+
+static zbx_prof_probes_t	*prof_probes = NULL;
+
+static const char	*prof_probe_names[ZBX_PROF_PROBE_COUNT] = {"history_sync", "poller", "preprocessing",
+		"db_query"};
+
+static const char	*prof_value_stage_names[ZBX_PROF_VALUE_STAGE_COUNT] = {"sync", "history", "triggers"};
+
+#if defined(HAVE_ATOMIC_BUILTINS)
+#	define PROF_PROBE_ADD(counter, value)	zbx_atomic_add(&counter, value)
+#	define PROF_PROBE_GET(counter)		zbx_atomic_load(&counter)
+#else
+#	define PROF_PROBE_ADD(counter, value)	counter += value
+#	define PROF_PROBE_GET(counter)		counter
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: create latency probes shared by all child processes               *
+ *                                                                            *
+ * Parameters: error - [OUT] error message                                    *
+ *                                                                            *
+ * Return value: SUCCEED - the probes were created                            *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Must be called in the parent process before forking.             *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_prof_probes_init(char **error)
+{
+#ifndef _WINDOWS
+	int	shm_id;
+	void	*base;
+	size_t	size = sizeof(zbx_prof_probes_t);
+
+	if (-1 == (shm_id = shmget(IPC_PRIVATE, size, 0600)))
+	{
+		*error = zbx_dsprintf(*error, "cannot get private shared memory of size " ZBX_FS_SIZE_T " for"
+				" profiling probes: %s", (zbx_fs_size_t)size, zbx_strerror(errno));
+		return FAIL;
+	}
+
+	if ((void *)(-1) == (base = shmat(shm_id, NULL, 0)))
+	{
+		*error = zbx_dsprintf(*error, "cannot attach shared memory for profiling probes: %s",
+				zbx_strerror(errno));
+		return FAIL;
+	}
+
+	if (-1 == shmctl(shm_id, IPC_RMID, NULL))
+		zbx_error("cannot mark shared memory %d for destruction: %s", shm_id, zbx_strerror(errno));
+
+	prof_probes = (zbx_prof_probes_t *)base;
+	memset(prof_probes, 0, size);
+#else
+	ZBX_UNUSED(error);
+#endif
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: destroy latency probes                                            *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_prof_probes_destroy(void)
+{
+	if (NULL == prof_probes)
+		return;
+#ifndef _WINDOWS
+	if (-1 == shmdt(prof_probes))
+		zabbix_log(LOG_LEVEL_WARNING, "cannot detach profiling probes: %s", zbx_strerror(errno));
+#endif
+	prof_probes = NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: check if latency probes are available                             *
+ *                                                                            *
+ * Comments: Callers can use it to avoid measuring time for nothing.          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_prof_probes_enabled(void)
+{
+	return NULL != prof_probes ? SUCCEED : FAIL;
+}
+
+static void	prof_stats_add(zbx_prof_probe_stats_t *stats, double sec)
+{
+	zbx_uint64_t	us;
+	int		bucket;
+
+	us = (0.0 < sec ? (zbx_uint64_t)(sec * 1000000.0) : 0);
+
+	for (bucket = 0; ZBX_PROF_PROBE_BUCKETS_NUM - 1 > bucket && 0 != (us >> bucket); bucket++)
+		;
+
+	PROF_PROBE_ADD(stats->count, 1);
+	PROF_PROBE_ADD(stats->total_us, us);
+	PROF_PROBE_ADD(stats->buckets[bucket], 1);
+}
+
+static void	prof_stats_sum(zbx_prof_probe_stats_t *stats, zbx_prof_probe_stats_t *src)
+{
+	stats->count += PROF_PROBE_GET(src->count);
+	stats->total_us += PROF_PROBE_GET(src->total_us);
+
+	for (int i = 0; i < ZBX_PROF_PROBE_BUCKETS_NUM; i++)
+		stats->buckets[i] += PROF_PROBE_GET(src->buckets[i]);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: account duration of one probed operation                          *
+ *                                                                            *
+ * Parameters: probe - [IN] probe identifier (ZBX_PROF_PROBE_*)               *
+ *             sec   - [IN] duration in seconds                               *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_prof_probe_add(int probe, double sec)
+{
+	if (NULL == prof_probes || 0 > probe || ZBX_PROF_PROBE_COUNT <= probe)
+		return;
+
+	prof_stats_add(&prof_probes->probes[probe], sec);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get snapshot of probe statistics                                  *
+ *                                                                            *
+ * Parameters: probe - [IN] probe identifier (ZBX_PROF_PROBE_*)               *
+ *             stats - [OUT] probe statistics                                 *
+ *                                                                            *
+ * Return value: SUCCEED - statistics were returned                           *
+ *               FAIL    - the probes are not available                       *
+ *                                                                            *
+ * Comments: Counters are read one by one while other processes can update    *
+ *           them, so the snapshot is not guaranteed to be consistent.        *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_prof_probe_get_stats(int probe, zbx_prof_probe_stats_t *stats)
+{
+	if (NULL == prof_probes || 0 > probe || ZBX_PROF_PROBE_COUNT <= probe)
+		return FAIL;
+
+	memset(stats, 0, sizeof(zbx_prof_probe_stats_t));
+	prof_stats_sum(stats, &prof_probes->probes[probe]);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: account latency of value from its collection to processing stage  *
+ *                                                                            *
+ * Parameters: stage     - [IN] value processing stage (ZBX_PROF_VALUE_*)     *
+ *             item_type - [IN] type of the value item                        *
+ *             sec       - [IN] time since the value was collected            *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_prof_value_latency_add(int stage, unsigned char item_type, double sec)
+{
+	if (NULL == prof_probes || 0 > stage || ZBX_PROF_VALUE_STAGE_COUNT <= stage ||
+			ZBX_PROF_ITEM_TYPES_NUM <= item_type)
+	{
+		return;
+	}
+
+	prof_stats_add(&prof_probes->values[stage][item_type], sec);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get snapshot of value latency statistics                          *
+ *                                                                            *
+ * Parameters: stage     - [IN] value processing stage (ZBX_PROF_VALUE_*)     *
+ *             item_type - [IN] item type or -1 for all item types            *
+ *             stats     - [OUT] value latency statistics                     *
+ *                                                                            *
+ * Return value: SUCCEED - statistics were returned                           *
+ *               FAIL    - the probes are not available                       *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_prof_value_latency_get_stats(int stage, int item_type, zbx_prof_probe_stats_t *stats)
+{
+	if (NULL == prof_probes || 0 > stage || ZBX_PROF_VALUE_STAGE_COUNT <= stage ||
+			ZBX_PROF_ITEM_TYPES_NUM <= item_type)
+	{
+		return FAIL;
+	}
+
+	memset(stats, 0, sizeof(zbx_prof_probe_stats_t));
+
+	if (0 <= item_type)
+	{
+		prof_stats_sum(stats, &prof_probes->values[stage][item_type]);
+	}
+	else
+	{
+		for (int i = 0; i < ZBX_PROF_ITEM_TYPES_NUM; i++)
+			prof_stats_sum(stats, &prof_probes->values[stage][i]);
+	}
+
+	return SUCCEED;
+}
+
+#undef PROF_PROBE_ADD
+#undef PROF_PROBE_GET
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get probe identifier by its name                                  *
+ *                                                                            *
+ * Return value: probe identifier or FAIL if the name is unknown              *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_prof_probe_by_name(const char *name)
+{
+	for (int i = 0; i < ZBX_PROF_PROBE_COUNT; i++)
+	{
+		if (0 == strcmp(prof_probe_names[i], name))
+			return i;
+	}
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get probe name                                                    *
+ *                                                                            *
+ ******************************************************************************/
+const char	*zbx_prof_probe_name(int probe)
+{
+	if (0 > probe || ZBX_PROF_PROBE_COUNT <= probe)
+		return "unknown";
+
+	return prof_probe_names[probe];
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get value processing stage by its name                            *
+ *                                                                            *
+ * Return value: stage identifier or FAIL if the name is unknown              *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_prof_value_stage_by_name(const char *name)
+{
+	for (int i = 0; i < ZBX_PROF_VALUE_STAGE_COUNT; i++)
+	{
+		if (0 == strcmp(prof_value_stage_names[i], name))
+			return i;
+	}
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get value processing stage name                                   *
+ *                                                                            *
+ ******************************************************************************/
+const char	*zbx_prof_value_stage_name(int stage)
+{
+	if (0 > stage || ZBX_PROF_VALUE_STAGE_COUNT <= stage)
+		return "unknown";
+
+	return prof_value_stage_names[stage];
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: estimate duration percentile from probe histogram                 *
+ *                                                                            *
+ * Parameters: stats      - [IN] probe statistics                             *
+ *             percentile - [IN] percentile (0-100)                           *
+ *                                                                            *
+ * Return value: upper bound of the histogram bucket containing the           *
+ *               percentile in seconds or 0 if nothing was accounted yet      *
+ *                                                                            *
+ ******************************************************************************/
+double	zbx_prof_probe_percentile(const zbx_prof_probe_stats_t *stats, double percentile)
+{
+	zbx_uint64_t	total = 0, rank, sum = 0;
+	int		i;
+
+	for (i = 0; i < ZBX_PROF_PROBE_BUCKETS_NUM; i++)
+		total += stats->buckets[i];
+
+	if (0 == total)
+		return 0.0;
+
+	if (1 > (rank = (zbx_uint64_t)ceil((double)total * percentile / 100.0)))
+		rank = 1;
+
+	for (i = 0; i < ZBX_PROF_PROBE_BUCKETS_NUM - 1; i++)
+	{
+		if (rank <= (sum += stats->buckets[i]))
+			break;
+	}
+
+	return (double)((zbx_uint64_t)1 << i) / 1000000.0;
+}
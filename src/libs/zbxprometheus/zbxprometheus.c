@@ -57,7 +57,7 @@ zbx_prometheus_condition_t;
 ZBX_PTR_VECTOR_DECL(prometheus_condition, zbx_prometheus_condition_t *)
 
 /* the prometheus pattern filter */
-typedef struct
+struct zbx_prometheus_filter
 {
 	/* metric filter, optional - can be NULL */
 	zbx_prometheus_condition_t		*metric;
@@ -65,8 +65,7 @@ typedef struct
 	zbx_prometheus_condition_t		*value;
 	/* label filters */
 	zbx_vector_prometheus_condition_t	labels;
-}
-zbx_prometheus_filter_t;
+};
 
 /* the prometheus metric HELP, TYPE hints in comments */
 typedef struct
@@ -815,6 +814,37 @@ static void	prometheus_row_free(zbx_prometheus_row_t *row)
 	zbx_free(row);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: creates prometheus pattern filter to be reused by queries         *
+ *                                                                            *
+ * Parameters: data   - [IN] the filter data                                  *
+ *             filter - [OUT] the created filter                              *
+ *             error  - [OUT] the error message                               *
+ *                                                                            *
+ * Return value: SUCCEED - the filter was created successfully                *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_prometheus_filter_create(const char *data, zbx_prometheus_filter_t **filter, char **error)
+{
+	zbx_prometheus_filter_t	filter_local;
+
+	if (SUCCEED != prometheus_filter_init(&filter_local, data, error))
+		return FAIL;
+
+	*filter = (zbx_prometheus_filter_t *)zbx_malloc(NULL, sizeof(zbx_prometheus_filter_t));
+	**filter = filter_local;
+
+	return SUCCEED;
+}
+
+void	zbx_prometheus_filter_free(zbx_prometheus_filter_t *filter)
+{
+	prometheus_filter_clear(filter);
+	zbx_free(filter);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: matches key,value against filter condition                        *
@@ -1591,7 +1621,7 @@ static int	prometheus_query_rows(const zbx_vector_prometheus_row_t *rows, const
  *             rows_out - [OUT] the filtered rows                             *
  *                                                                            *
  ******************************************************************************/
-static void	prometheus_filter_rows(zbx_vector_prometheus_row_t *rows, zbx_prometheus_filter_t *filter,
+static void	prometheus_filter_rows(const zbx_vector_prometheus_row_t *rows, const zbx_prometheus_filter_t *filter,
 		zbx_vector_prometheus_row_t *rows_out)
 {
 	int			i, j, k;
@@ -1643,6 +1673,58 @@ static void	prometheus_filter_rows(zbx_vector_prometheus_row_t *rows, zbx_promet
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() rows:%d", __func__, rows_out->values_num);
 }
 
+static zbx_hash_t	prometheus_index_hash_func(const void *d)
+{
+	const zbx_prometheus_index_t	*index = (const zbx_prometheus_index_t *)d;
+
+	return ZBX_DEFAULT_STRING_HASH_FUNC(index->value);
+}
+
+static int	prometheus_index_compare_func(const void *d1, const void *d2)
+{
+	const zbx_prometheus_index_t	*i1 = (const zbx_prometheus_index_t *)d1;
+	const zbx_prometheus_index_t	*i2 = (const zbx_prometheus_index_t *)d2;
+
+	return strcmp(i1->value, i2->value);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: group rows by metric name                                         *
+ *                                                                            *
+ * Parameters: rows    - [IN] the prometheus rows                             *
+ *             metrics - [OUT] the rows indexed by metric name                *
+ *                                                                            *
+ * Comments: The index is built once together with the cache, so queries for  *
+ *           a specific metric check only the rows of that metric.            *
+ *                                                                            *
+ ******************************************************************************/
+static void	prometheus_index_rows_by_metric(const zbx_vector_prometheus_row_t *rows, zbx_hashset_t *metrics)
+{
+	int			i;
+	zbx_prometheus_index_t	*index = NULL, index_local;
+
+	for (i = 0; i < rows->values_num; i++)
+	{
+		zbx_prometheus_row_t	*row = rows->values[i];
+
+		/* rows of the same metric normally follow each other */
+		if (NULL == index || 0 != strcmp(index->value, row->metric))
+		{
+			index_local.value = row->metric;
+
+			if (NULL == (index = (zbx_prometheus_index_t *)zbx_hashset_search(metrics, &index_local)))
+			{
+				index = (zbx_prometheus_index_t *)zbx_hashset_insert(metrics, &index_local,
+						sizeof(index_local));
+				zbx_vector_prometheus_row_create(&index->rows);
+			}
+		}
+
+		zbx_vector_prometheus_row_append(&index->rows, row);
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: parse prometheus input and initialize cache                       *
@@ -1661,6 +1743,7 @@ int	zbx_prometheus_init(zbx_prometheus_t *prom, const char *data, char **error)
 	int			ret = FAIL;
 
 	zbx_vector_prometheus_row_create(&prom->rows);
+	zbx_hashset_create(&prom->metrics, 0, prometheus_index_hash_func, prometheus_index_compare_func);
 	zbx_vector_prometheus_label_index_create(&prom->indexes);
 
 	if (0 != pthread_rwlock_init(&prom->index_lock, NULL))
@@ -1675,6 +1758,8 @@ int	zbx_prometheus_init(zbx_prometheus_t *prom, const char *data, char **error)
 	if (FAIL == prometheus_parse_rows(&filter, data, &prom->rows, NULL, error))
 		goto out;
 
+	prometheus_index_rows_by_metric(&prom->rows, &prom->metrics);
+
 	ret = SUCCEED;
 out:
 	prometheus_filter_clear(&filter);
@@ -1685,18 +1770,22 @@ out:
 	return ret;
 }
 
-static void	prometheus_label_index_free(zbx_prometheus_label_index_t *label_index)
+static void	prometheus_index_destroy(zbx_hashset_t *index_set)
 {
 	zbx_hashset_iter_t	iter;
 	zbx_prometheus_index_t	*index;
 
-	zbx_free(label_index->label);
-
-	zbx_hashset_iter_reset(&label_index->index, &iter);
+	zbx_hashset_iter_reset(index_set, &iter);
 	while (NULL != (index = (zbx_prometheus_index_t *)zbx_hashset_iter_next(&iter)))
 		zbx_vector_prometheus_row_destroy(&index->rows);
 
-	zbx_hashset_destroy(&label_index->index);
+	zbx_hashset_destroy(index_set);
+}
+
+static void	prometheus_label_index_free(zbx_prometheus_label_index_t *label_index)
+{
+	zbx_free(label_index->label);
+	prometheus_index_destroy(&label_index->index);
 	zbx_free(label_index);
 }
 
@@ -1712,6 +1801,8 @@ void	zbx_prometheus_clear(zbx_prometheus_t *prom)
 	zbx_vector_prometheus_label_index_clear_ext(&prom->indexes, prometheus_label_index_free);
 	zbx_vector_prometheus_label_index_destroy(&prom->indexes);
 
+	prometheus_index_destroy(&prom->metrics);
+
 	zbx_vector_prometheus_row_clear_ext(&prom->rows, prometheus_row_free);
 	zbx_vector_prometheus_row_destroy(&prom->rows);
 
@@ -1775,26 +1866,35 @@ static	zbx_prometheus_label_index_t	*prometheus_get_index(zbx_prometheus_t *prom
 	return label_index;
 }
 
-static void	prometheus_add_index(zbx_prometheus_t *prom, zbx_prometheus_label_index_t *index)
+static zbx_prometheus_label_index_t	*prometheus_add_index(zbx_prometheus_t *prom,
+		zbx_prometheus_label_index_t *index)
 {
+	int				i;
+	zbx_prometheus_label_index_t	*label_index = NULL;
+
 	prometheus_wrlock(prom);
-	zbx_vector_prometheus_label_index_append(&prom->indexes, index);
-	prometheus_unlock(prom);
-}
 
-static zbx_hash_t	prometheus_index_hash_func(const void *d)
-{
-	const zbx_prometheus_index_t	*index = (const zbx_prometheus_index_t *)d;
+	/* another worker could have indexed the same label meanwhile */
+	for (i = 0; i < prom->indexes.values_num; i++)
+	{
+		if (0 == strcmp(prom->indexes.values[i]->label, index->label))
+		{
+			label_index = prom->indexes.values[i];
+			break;
+		}
+	}
 
-	return ZBX_DEFAULT_STRING_HASH_FUNC(index->value);
-}
+	if (NULL == label_index)
+		zbx_vector_prometheus_label_index_append(&prom->indexes, index);
 
-static int	prometheus_index_compare_func(const void *d1, const void *d2)
-{
-	const zbx_prometheus_index_t	*i1 = (const zbx_prometheus_index_t *)d1;
-	const zbx_prometheus_index_t	*i2 = (const zbx_prometheus_index_t *)d2;
+	prometheus_unlock(prom);
 
-	return strcmp(i1->value, i2->value);
+	if (NULL == label_index)
+		return index;
+
+	prometheus_label_index_free(index);
+
+	return label_index;
 }
 
 /******************************************************************************
@@ -1841,11 +1941,11 @@ static zbx_prometheus_label_t	*prometheus_get_row_label(zbx_prometheus_row_t *ro
  *           label are requested.                                             *
  *                                                                            *
  ******************************************************************************/
-static int	prometheus_get_indexed_rows_by_label(zbx_prometheus_t *prom, zbx_prometheus_filter_t *filter,
+static int	prometheus_get_indexed_rows_by_label(zbx_prometheus_t *prom, const zbx_prometheus_filter_t *filter,
 		zbx_vector_prometheus_row_t **rows)
 {
 	int				i;
-	zbx_prometheus_condition_t	*condition;
+	zbx_prometheus_condition_t	*condition = NULL;
 	zbx_prometheus_label_index_t	*label_index;
 	zbx_prometheus_index_t		*index, index_local;
 
@@ -1888,7 +1988,7 @@ static int	prometheus_get_indexed_rows_by_label(zbx_prometheus_t *prom, zbx_prom
 			zbx_vector_prometheus_row_append(&index->rows, row);
 		}
 
-		prometheus_add_index(prom, label_index);
+		label_index = prometheus_add_index(prom, label_index);
 	}
 
 	index_local.value = condition->pattern;
@@ -1934,6 +2034,47 @@ static int	prometheus_validate_request(const char *request, const char *output,
 	return SUCCEED;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get rows that can match the filter                                *
+ *                                                                            *
+ * Parameters: prom   - [IN] the prometheus cache                             *
+ *             filter - [IN] the filter                                       *
+ *                                                                            *
+ * Return value: The smallest set of indexed rows containing all rows         *
+ *               matching the filter or NULL if no rows can match it.         *
+ *                                                                            *
+ ******************************************************************************/
+static const zbx_vector_prometheus_row_t	*prometheus_get_indexed_rows(zbx_prometheus_t *prom,
+		const zbx_prometheus_filter_t *filter)
+{
+	const zbx_vector_prometheus_row_t	*rows = &prom->rows;
+	zbx_vector_prometheus_row_t		*label_rows;
+
+	if (NULL != filter->metric && ZBX_PROMETHEUS_CONDITION_OP_EQUAL == filter->metric->op)
+	{
+		zbx_prometheus_index_t	*index, index_local;
+
+		index_local.value = filter->metric->pattern;
+
+		if (NULL == (index = (zbx_prometheus_index_t *)zbx_hashset_search(&prom->metrics, &index_local)))
+			return NULL;
+
+		rows = &index->rows;
+	}
+
+	if (SUCCEED == prometheus_get_indexed_rows_by_label(prom, filter, &label_rows))
+	{
+		if (NULL == label_rows)
+			return NULL;
+
+		if (label_rows->values_num < rows->values_num)
+			rows = label_rows;
+	}
+
+	return rows;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: extract value from prometheus cache by the specified filter       *
@@ -1952,29 +2093,56 @@ static int	prometheus_validate_request(const char *request, const char *output,
 int	zbx_prometheus_pattern_ex(zbx_prometheus_t *prom, const char *filter_data, const char *request,
 		const char *output, char **value, char **error)
 {
-	zbx_prometheus_filter_t		filter;
-	int				ret = FAIL;
-	char				*errmsg = NULL;
-	zbx_vector_prometheus_row_t	rows, *prows;
-
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+	zbx_prometheus_filter_t	filter;
+	int			ret;
+	char			*errmsg = NULL;
 
 	if (FAIL == prometheus_filter_init(&filter, filter_data, &errmsg))
 	{
 		*error = zbx_dsprintf(*error, "pattern error: %s", errmsg);
 		zbx_free(errmsg);
-		goto out;
+		return FAIL;
 	}
 
-	zbx_vector_prometheus_row_create(&rows);
+	ret = zbx_prometheus_pattern_prepared(prom, &filter, request, output, value, error);
+
+	prometheus_filter_clear(&filter);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: extract value from prometheus cache by prepared filter            *
+ *                                                                            *
+ * Parameters: prom    - [IN] the prometheus cache                            *
+ *             filter  - [IN] the filter                                      *
+ *             request - [IN] the data request - value, label, function       *
+ *             output  - [IN] the output template/function name               *
+ *             value   - [OUT] the extracted value                            *
+ *             error   - [OUT] the error message                              *
+ *                                                                            *
+ * Return value: SUCCEED - the value was extracted successfully               *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_prometheus_pattern_prepared(zbx_prometheus_t *prom, const zbx_prometheus_filter_t *filter,
+		const char *request, const char *output, char **value, char **error)
+{
+	int					ret = FAIL;
+	char					*errmsg = NULL;
+	zbx_vector_prometheus_row_t		rows;
+	const zbx_vector_prometheus_row_t	*prows;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
 	if (SUCCEED != prometheus_validate_request(request, output, error))
-		return FAIL;
+		goto out;
 
-	if (SUCCEED != prometheus_get_indexed_rows_by_label(prom, &filter, &prows) || NULL == prows)
-		prows = &prom->rows;
+	zbx_vector_prometheus_row_create(&rows);
 
-	prometheus_filter_rows(prows, &filter, &rows);
+	if (NULL != (prows = prometheus_get_indexed_rows(prom, filter)))
+		prometheus_filter_rows(prows, filter, &rows);
 
 	if (FAIL == (ret = prometheus_query_rows(&rows, request, output, value, &errmsg)))
 	{
@@ -1982,7 +2150,6 @@ int	zbx_prometheus_pattern_ex(zbx_prometheus_t *prom, const char *filter_data, c
 		zbx_free(errmsg);
 	}
 
-	prometheus_filter_clear(&filter);
 	zbx_vector_prometheus_row_destroy(&rows);
 out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
@@ -21,6 +21,7 @@
 
 #include "log.h"
 #include "zbxstr.h"
+#include "zbxmutexs.h"
 
 #ifdef HAVE_PCRE_H
 #ifdef HAVE_PCRE2_H
@@ -71,6 +72,44 @@ zbx_regmatch_t;
 
 ZBX_PTR_VECTOR_IMPL(expression, zbx_expression_t *)
 
+/* per thread cache of compiled regular expressions, least recently used expression is replaced */
+#define ZBX_REGEXP_CACHE_SIZE	16
+
+typedef struct
+{
+	char		*pattern;
+	int		flags;
+	zbx_hash_t	hash;
+	zbx_uint64_t	lastused;
+	zbx_regexp_t	*regexp;
+}
+zbx_regexp_cache_entry_t;
+
+static ZBX_THREAD_LOCAL zbx_regexp_cache_entry_t	regexp_cache[ZBX_REGEXP_CACHE_SIZE];
+static ZBX_THREAD_LOCAL zbx_uint64_t		regexp_cache_clock = 0;
+
+/* cache statistics of all threads in the process */
+static zbx_uint64_t	regexp_cache_hits = 0, regexp_cache_misses = 0;
+
+#if defined(HAVE_ATOMIC_BUILTINS)
+#	define REGEXP_CACHE_STATS_INC(counter)	zbx_atomic_add(&counter, 1)
+#	define REGEXP_CACHE_STATS_GET(counter)	zbx_atomic_load(&counter)
+#else
+#	define REGEXP_CACHE_STATS_INC(counter)	counter++
+#	define REGEXP_CACHE_STATS_GET(counter)	counter
+#endif
+
+#ifdef HAVE_PCRE2_H
+/* JIT stack of the thread, shared by all regular expressions matched by it */
+static ZBX_THREAD_LOCAL pcre2_jit_stack	*regexp_jit_stack = NULL;
+#endif
+#if defined(HAVE_PCRE_H) && defined(PCRE_STUDY_JIT_COMPILE)
+static ZBX_THREAD_LOCAL pcre_jit_stack	*regexp_jit_stack = NULL;
+#endif
+
+#define ZBX_REGEXP_JIT_STACK_MIN	(32 * ZBX_KIBIBYTE)
+#define ZBX_REGEXP_JIT_STACK_MAX	(512 * ZBX_KIBIBYTE)
+
 /******************************************************************************
  *                                                                            *
  * Purpose: compiles a regular expression                                     *
@@ -136,7 +175,13 @@ static int	regexp_compile(const char *pattern, int flags, zbx_regexp_t **regexp,
 
 	if (NULL != regexp)
 	{
-		if (NULL == (extra = pcre_study(pcre_regexp, 0, err_msg)) && NULL != *err_msg)
+#ifdef PCRE_STUDY_JIT_COMPILE
+		/* falls back to interpreted matching if JIT is not supported */
+		extra = pcre_study(pcre_regexp, PCRE_STUDY_JIT_COMPILE, err_msg);
+#else
+		extra = pcre_study(pcre_regexp, 0, err_msg);
+#endif
+		if (NULL == extra && NULL != *err_msg)
 		{
 			pcre_free(pcre_regexp);
 			return FAIL;
@@ -177,6 +222,9 @@ static int	regexp_compile(const char *pattern, int flags, zbx_regexp_t **regexp,
 			return FAIL;
 		}
 
+		/* falls back to interpreted matching if JIT is not supported */
+		(void)pcre2_jit_compile(pcre2_regexp, PCRE2_JIT_COMPLETE);
+
 		*regexp = (zbx_regexp_t *)zbx_malloc(NULL, sizeof(zbx_regexp_t));
 		(*regexp)->pcre2_regexp = pcre2_regexp;
 		(*regexp)->match_ctx = match_ctx;
@@ -236,39 +284,74 @@ int	zbx_regexp_compile_ext(const char *pattern, zbx_regexp_t **regexp, int flags
 
 /****************************************************************************************************
  *                                                                                                  *
- * Purpose: wrapper for zbx_regexp_compile. Caches and reuses the last used regexp.                 *
+ * Purpose: wrapper for zbx_regexp_compile. Caches and reuses recently used regexps.                *
+ *                                                                                                  *
+ * Comments: The returned regexp is owned by cache and stays valid until the next call.             *
  *                                                                                                  *
  ****************************************************************************************************/
 static int	regexp_prepare(const char *pattern, int flags, zbx_regexp_t **regexp, const char **err_msg)
 {
-	static ZBX_THREAD_LOCAL zbx_regexp_t	*curr_regexp = NULL;
-	static ZBX_THREAD_LOCAL char		*curr_pattern = NULL;
-	static ZBX_THREAD_LOCAL int		curr_flags = 0;
-	int					ret = SUCCEED;
+	zbx_regexp_cache_entry_t	*entry, *lru = &regexp_cache[0];
+	zbx_hash_t			hash;
+	int				i;
+
+	hash = ZBX_DEFAULT_STRING_HASH_FUNC(pattern);
 
-	if (NULL == curr_regexp || 0 != strcmp(curr_pattern, pattern) || curr_flags != flags)
+	for (i = 0; i < ZBX_REGEXP_CACHE_SIZE; i++)
 	{
-		if (NULL != curr_regexp)
+		entry = &regexp_cache[i];
+
+		if (NULL != entry->regexp && hash == entry->hash && flags == entry->flags &&
+				0 == strcmp(entry->pattern, pattern))
 		{
-			zbx_regexp_free(curr_regexp);
-			zbx_free(curr_pattern);
+			REGEXP_CACHE_STATS_INC(regexp_cache_hits);
+			entry->lastused = ++regexp_cache_clock;
+			*regexp = entry->regexp;
+
+			return SUCCEED;
 		}
 
-		curr_regexp = NULL;
-		curr_pattern = NULL;
-		curr_flags = 0;
+		/* unused entries have zero last use time */
+		if (entry->lastused < lru->lastused)
+			lru = entry;
+	}
+
+	REGEXP_CACHE_STATS_INC(regexp_cache_misses);
 
-		if (SUCCEED == regexp_compile(pattern, flags, &curr_regexp, err_msg))
-		{
-			curr_pattern = zbx_strdup(curr_pattern, pattern);
-			curr_flags = flags;
-		}
-		else
-			ret = FAIL;
+	if (NULL != lru->regexp)
+	{
+		zbx_regexp_free(lru->regexp);
+		zbx_free(lru->pattern);
+		lru->regexp = NULL;
+		lru->lastused = 0;
 	}
 
-	*regexp = curr_regexp;
-	return ret;
+	if (SUCCEED != regexp_compile(pattern, flags, &lru->regexp, err_msg))
+	{
+		lru->regexp = NULL;
+		return FAIL;
+	}
+
+	lru->pattern = zbx_strdup(NULL, pattern);
+	lru->flags = flags;
+	lru->hash = hash;
+	lru->lastused = ++regexp_cache_clock;
+	*regexp = lru->regexp;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get statistics of compiled regular expression cache               *
+ *                                                                            *
+ * Parameters: stats - [OUT] the cache statistics of all process threads      *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_regexp_get_cache_stats(zbx_regexp_cache_stats_t *stats)
+{
+	stats->hits_num = REGEXP_CACHE_STATS_GET(regexp_cache_hits);
+	stats->misses_num = REGEXP_CACHE_STATS_GET(regexp_cache_misses);
 }
 
 static unsigned long int	compute_recursion_limit(void)
@@ -330,7 +413,17 @@ static int	regexp_exec(const char *string, const zbx_regexp_t *regexp, int flags
 		pextra->flags = 0;
 	}
 	else
+	{
 		pextra = regexp->extra;
+#ifdef PCRE_STUDY_JIT_COMPILE
+		if (NULL == regexp_jit_stack)
+			regexp_jit_stack = pcre_jit_stack_alloc(ZBX_REGEXP_JIT_STACK_MIN, ZBX_REGEXP_JIT_STACK_MAX);
+
+		/* without JIT stack the default 32K machine stack is used */
+		if (NULL != regexp_jit_stack)
+			pcre_assign_jit_stack(pextra, NULL, regexp_jit_stack);
+#endif
+	}
 #if defined(PCRE_EXTRA_MATCH_LIMIT) && defined(PCRE_EXTRA_MATCH_LIMIT_RECURSION)
 	pextra->flags |= PCRE_EXTRA_MATCH_LIMIT | PCRE_EXTRA_MATCH_LIMIT_RECURSION;
 	pextra->match_limit = 1000000;
@@ -368,6 +461,14 @@ static int	regexp_exec(const char *string, const zbx_regexp_t *regexp, int flags
 	pcre2_set_match_limit(regexp->match_ctx, 1000000);
 
 	pcre2_set_recursion_limit(regexp->match_ctx, compute_recursion_limit());
+
+	if (NULL == regexp_jit_stack)
+		regexp_jit_stack = pcre2_jit_stack_create(ZBX_REGEXP_JIT_STACK_MIN, ZBX_REGEXP_JIT_STACK_MAX, NULL);
+
+	/* without JIT stack the default 32K machine stack is used */
+	if (NULL != regexp_jit_stack)
+		pcre2_jit_stack_assign(regexp->match_ctx, NULL, regexp_jit_stack);
+
 	match_data = pcre2_match_data_create(count, NULL);
 
 	if (NULL == match_data)
@@ -1270,6 +1371,185 @@ void	zbx_regexp_escape(char **string)
 	*string = buffer;
 }
 
+/**********************************************************************************
+ *                                                                                *
+ * Purpose: find literal substring present in every string matching the regular   *
+ *          expression                                                            *
+ *                                                                                *
+ * Parameters: pattern - [IN] the regular expression                              *
+ *                                                                                *
+ * Return value: the longest required literal (must be freed by caller) or NULL   *
+ *               if the expression requires no literal or uses syntax the         *
+ *               function does not analyze                                        *
+ *                                                                                *
+ * Comments: Strings which do not contain the literal cannot match the case       *
+ *           sensitive expression, so they may be rejected without running the    *
+ *           regular expression engine. Expressions with groups, alternatives and *
+ *           escape sequences other than character types and assertions are not   *
+ *           analyzed.                                                            *
+ *                                                                                *
+ **********************************************************************************/
+char	*zbx_regexp_get_literal(const char *pattern)
+{
+#define FLUSH_RUN()						\
+	do							\
+	{							\
+		if (run_len > literal_len)			\
+		{						\
+			memcpy(literal, run, run_len);		\
+			literal_len = run_len;			\
+		}						\
+		run_len = 0;					\
+	}							\
+	while (0)
+
+	const char	*p;
+	char		*run, *literal;
+	size_t		run_len = 0, literal_len = 0;
+	int		atom = 0, quantifier = 0, is_char = 0;
+
+	if (NULL == pattern || '\0' == *pattern || SUCCEED != zbx_is_utf8(pattern))
+		return NULL;
+
+	run = (char *)zbx_malloc(NULL, strlen(pattern) + 1);
+	literal = (char *)zbx_malloc(NULL, strlen(pattern) + 1);
+
+	for (p = pattern; '\0' != *p; p++)
+	{
+		switch (*p)
+		{
+			case '(':
+			case ')':
+			case '|':
+				goto fail;
+			case '^':
+			case '$':
+				FLUSH_RUN();
+				atom = quantifier = is_char = 0;
+				break;
+			case '.':
+				FLUSH_RUN();
+				atom = 1;
+				quantifier = is_char = 0;
+				break;
+			case '[':
+				FLUSH_RUN();
+
+				if ('^' == *(++p))
+					p++;
+
+				if (']' == *p)
+					p++;
+
+				for (; ']' != *p; p++)
+				{
+					if ('\0' == *p)
+						goto fail;
+
+					if ('\\' == *p)
+					{
+						if ('\0' == *(++p))
+							goto fail;
+					}
+					else if ('[' == *p && ':' == p[1])
+					{
+						if (NULL == (p = strstr(p + 2, ":]")))
+							goto fail;
+						p++;
+					}
+				}
+
+				atom = 1;
+				quantifier = is_char = 0;
+				break;
+			case '?':
+			case '*':
+			case '+':
+				if (0 != quantifier)
+				{
+					/* lazy or possessive quantifier */
+					if ('*' == *p)
+						goto fail;
+
+					quantifier = 0;
+					break;
+				}
+				ZBX_FALLTHROUGH;
+			case '{':
+				if (0 == atom)
+					goto fail;
+
+				if ('{' == *p && NULL == (p = strchr(p, '}')))
+					goto fail;
+
+				/* character repeated zero or more times is not required */
+				if (0 != is_char && '+' != *p)
+				{
+					do
+					{
+						run_len--;
+					}
+					while (0 < run_len && 0x80 == (run[run_len] & 0xc0));
+				}
+
+				FLUSH_RUN();
+				atom = is_char = 0;
+				quantifier = 1;
+				break;
+			case '\\':
+				if ('\0' == *(++p))
+					goto fail;
+
+				if (0 == isalnum((unsigned char)*p))
+				{
+					run[run_len++] = *p;
+					atom = is_char = 1;
+					quantifier = 0;
+					break;
+				}
+
+				if (NULL != strchr("dDsSwWhHvVRX", *p))
+					atom = 1;
+				else if (NULL != strchr("bBAzZG", *p))
+					atom = 0;
+				else
+					goto fail;
+
+				FLUSH_RUN();
+				quantifier = is_char = 0;
+				break;
+			default:
+				run[run_len++] = *p;
+
+				/* continuation bytes belong to the preceding character */
+				if (0x80 != (*p & 0xc0))
+				{
+					atom = is_char = 1;
+					quantifier = 0;
+				}
+		}
+	}
+
+	FLUSH_RUN();
+	zbx_free(run);
+
+	if (0 == literal_len)
+	{
+		zbx_free(literal);
+		return NULL;
+	}
+
+	literal[literal_len] = '\0';
+
+	return literal;
+fail:
+	zbx_free(run);
+	zbx_free(literal);
+
+	return NULL;
+#undef FLUSH_RUN
+}
+
 /**********************************************************************************
  *                                                                                *
  * Purpose: remove repeated wildcard characters from the expression               *
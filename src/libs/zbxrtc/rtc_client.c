@@ -401,6 +401,38 @@ int	zbx_rtc_wait(zbx_ipc_async_socket_t *rtc, const zbx_thread_info_t *info, zbx
 	return SUCCEED;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: wake up escalators to process new or updated escalations          *
+ *                                                                            *
+ * Comments: The notification is only a hint - escalators still check the    *
+ *           escalations table periodically, so failures are not fatal.       *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_rtc_notify_escalators(void)
+{
+	static zbx_ipc_socket_t	socket;
+
+	/* each process has a permanent connection to RTC service */
+	if (FAIL == zbx_ipc_socket_connected(&socket))
+	{
+		char	*error = NULL;
+
+		if (FAIL == zbx_ipc_socket_open(&socket, ZBX_IPC_SERVICE_RTC, SEC_PER_MIN, &error))
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "cannot connect to runtime control service: %s", error);
+			zbx_free(error);
+			return;
+		}
+	}
+
+	if (FAIL == zbx_ipc_socket_write(&socket, ZBX_RTC_ESCALATOR_NOTIFY, NULL, 0))
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "cannot send escalator notification to runtime control service");
+		zbx_ipc_socket_close(&socket);
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: notify RTC service about finishing initial configuration sync     *
@@ -225,7 +225,8 @@ static void	rtc_process_diaginfo(const char *data, char **result)
 	if (0 == strcmp(buf, "all"))
 	{
 		scope = (1 << ZBX_DIAGINFO_HISTORYCACHE) | (1 << ZBX_DIAGINFO_PREPROCESSING) |
-				(1 << ZBX_DIAGINFO_LOCKS);
+				(1 << ZBX_DIAGINFO_LOCKS) | (1 << ZBX_DIAGINFO_DISCOVERY) |
+				(1 << ZBX_DIAGINFO_PROFILING);
 	}
 	else if (0 == strcmp(buf, ZBX_DIAG_HISTORYCACHE))
 	{
@@ -243,6 +244,14 @@ static void	rtc_process_diaginfo(const char *data, char **result)
 	{
 		scope = 1 << ZBX_DIAGINFO_CONNECTOR;
 	}
+	else if (0 == strcmp(buf, ZBX_DIAG_DISCOVERY))
+	{
+		scope = 1 << ZBX_DIAGINFO_DISCOVERY;
+	}
+	else if (0 == strcmp(buf, ZBX_DIAG_PROFILING))
+	{
+		scope = 1 << ZBX_DIAGINFO_PROFILING;
+	}
 	else
 	{
 		if (NULL == *result)
@@ -575,6 +584,10 @@ void	zbx_rtc_dispatch(zbx_rtc_t *rtc, zbx_ipc_client_t *client, zbx_ipc_message_
 		case ZBX_RTC_CONFIG_SYNC_NOTIFY:
 			rtc_notify_hooks(rtc, message->code, message->data, message->size);
 			break;
+		case ZBX_RTC_ESCALATOR_NOTIFY:
+			/* wakeup notification - forwarded without response to the sender */
+			zbx_rtc_notify(rtc, ZBX_PROCESS_TYPE_ESCALATOR, 0, ZBX_RTC_ESCALATOR_NOTIFY, NULL, 0);
+			break;
 		default:
 			rtc_process(rtc, client, message->code, message->data, cb_proc_req);
 			break;
@@ -97,3 +97,72 @@ zbx_uint32_t	zbx_deserialize_uint31_compact(const unsigned char *ptr, zbx_uint32
 		return pos;
 	}
 }
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: serialize 64 bit unsigned integer into variable length byte       *
+ *          stream                                                            *
+ *                                                                            *
+ * Parameters: ptr   - [OUT] the output buffer, must have space for at least  *
+ *                           ZBX_SERIALIZE_UINT64_COMPACT_MAX bytes           *
+ *             value - [IN] the value to serialize                            *
+ *                                                                            *
+ * Return value: The number of bytes written to the buffer.                   *
+ *                                                                            *
+ * Comments: Values are stored by 7 bits per byte starting with the least     *
+ *           significant bits, the high bit of each byte is set if more bytes *
+ *           follow. The byte order does not depend on the host, so the       *
+ *           stream can be exchanged between different systems.               *
+ *                                                                            *
+ ******************************************************************************/
+zbx_uint32_t	zbx_serialize_uint64_compact(unsigned char *ptr, zbx_uint64_t value)
+{
+	zbx_uint32_t	len = 0;
+
+	while (0x7f < value)
+	{
+		ptr[len++] = (unsigned char)(0x80 | (value & 0x7f));
+		value >>= 7;
+	}
+
+	ptr[len++] = (unsigned char)value;
+
+	return len;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: deserialize 64 bit unsigned integer from variable length byte     *
+ *          stream                                                            *
+ *                                                                            *
+ * Parameters: ptr   - [IN] the byte stream                                   *
+ *             end   - [IN] the end of byte stream                            *
+ *             value - [OUT] the deserialized value                           *
+ *                                                                            *
+ * Return value: The number of bytes read from byte stream or 0 if the stream *
+ *               is truncated or does not contain valid value.                *
+ *                                                                            *
+ ******************************************************************************/
+zbx_uint32_t	zbx_deserialize_uint64_compact(const unsigned char *ptr, const unsigned char *end,
+		zbx_uint64_t *value)
+{
+	zbx_uint32_t	len = 0, shift = 0;
+
+	*value = 0;
+
+	while (ptr + len < end && ZBX_SERIALIZE_UINT64_COMPACT_MAX > len)
+	{
+		/* the last byte can hold only the most significant bit of the value */
+		if (ZBX_SERIALIZE_UINT64_COMPACT_MAX - 1 == len && 1 < ptr[len])
+			return 0;
+
+		*value |= (zbx_uint64_t)(ptr[len] & 0x7f) << shift;
+
+		if (0 == (ptr[len++] & 0x80))
+			return len;
+
+		shift += 7;
+	}
+
+	return 0;
+}
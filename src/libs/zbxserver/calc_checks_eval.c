@@ -96,6 +96,175 @@ typedef struct
 }
 zbx_expression_item_t;
 
+/* Items matching many item queries are cached between evaluations in process memory and */
+/* are reused while hosts, items, host groups and tags in configuration cache are not    */
+/* changed. Queries that are not used for a while are dropped from the cache.            */
+typedef struct
+{
+	zbx_uint64_t		hostid;		/* hostid of self referencing queries, 0 otherwise */
+	char			*host;
+	char			*key;
+	char			*filter;
+	zbx_uint64_t		revision;
+	zbx_vector_uint64_t	itemids;
+	time_t			lastaccess;
+}
+zbx_expression_query_cache_t;
+
+#define ZBX_EXPRESSION_QUERY_CACHE_TTL	SEC_PER_HOUR
+
+static zbx_hashset_t	query_cache;
+static int		query_cache_initialized = 0;
+static time_t		query_cache_cleanup_time = 0;
+
+static zbx_hash_t	expression_query_cache_hash(const void *data)
+{
+	const zbx_expression_query_cache_t	*entry = (const zbx_expression_query_cache_t *)data;
+	zbx_hash_t				hash;
+
+	hash = ZBX_DEFAULT_UINT64_HASH_FUNC(&entry->hostid);
+	hash = ZBX_DEFAULT_STRING_HASH_ALGO(entry->host, strlen(entry->host), hash);
+	hash = ZBX_DEFAULT_STRING_HASH_ALGO(entry->key, strlen(entry->key), hash);
+
+	return ZBX_DEFAULT_STRING_HASH_ALGO(entry->filter, strlen(entry->filter), hash);
+}
+
+static int	expression_query_cache_compare(const void *d1, const void *d2)
+{
+	const zbx_expression_query_cache_t	*e1 = (const zbx_expression_query_cache_t *)d1;
+	const zbx_expression_query_cache_t	*e2 = (const zbx_expression_query_cache_t *)d2;
+	int					ret;
+
+	ZBX_RETURN_IF_NOT_EQUAL(e1->hostid, e2->hostid);
+
+	if (0 != (ret = strcmp(e1->host, e2->host)))
+		return ret;
+
+	if (0 != (ret = strcmp(e1->key, e2->key)))
+		return ret;
+
+	return strcmp(e1->filter, e2->filter);
+}
+
+static void	expression_query_cache_clean(void *data)
+{
+	zbx_expression_query_cache_t	*entry = (zbx_expression_query_cache_t *)data;
+
+	zbx_free(entry->host);
+	zbx_free(entry->key);
+	zbx_free(entry->filter);
+	zbx_vector_uint64_destroy(&entry->itemids);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: prepare many item query cache lookup key                          *
+ *                                                                            *
+ * Parameters: eval  - [IN] the evaluation data                               *
+ *             query - [IN] the expression item query                         *
+ *             local - [OUT] the lookup key                                   *
+ *                                                                            *
+ ******************************************************************************/
+static void	expression_query_cache_key(const zbx_expression_eval_t *eval, const zbx_expression_query_t *query,
+		zbx_expression_query_cache_t *local)
+{
+	local->hostid = (0 != (query->flags & ZBX_ITEM_QUERY_HOST_SELF) ? eval->hostid : 0);
+	local->host = (char *)ZBX_NULL2EMPTY_STR(query->ref.host);
+	local->key = (char *)ZBX_NULL2EMPTY_STR(query->ref.key);
+	local->filter = (char *)ZBX_NULL2EMPTY_STR(query->ref.filter);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get items matching many item query from cache                     *
+ *                                                                            *
+ * Parameters: eval     - [IN] the evaluation data                            *
+ *             query    - [IN] the expression item query                      *
+ *             revision - [IN] the current items revision                     *
+ *             itemids  - [OUT] the matching item identifiers                 *
+ *                                                                            *
+ * Return value: SUCCEED - the items were found in cache                      *
+ *               FAIL    - the query is not cached or is outdated             *
+ *                                                                            *
+ ******************************************************************************/
+static int	expression_query_cache_get(const zbx_expression_eval_t *eval, const zbx_expression_query_t *query,
+		zbx_uint64_t revision, zbx_vector_uint64_t *itemids)
+{
+	zbx_expression_query_cache_t	local, *entry;
+	time_t				now;
+
+	if (0 == query_cache_initialized)
+	{
+		zbx_hashset_create_ext(&query_cache, 0, expression_query_cache_hash, expression_query_cache_compare,
+				expression_query_cache_clean, ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC,
+				ZBX_DEFAULT_MEM_FREE_FUNC);
+		query_cache_initialized = 1;
+	}
+
+	now = time(NULL);
+
+	if (query_cache_cleanup_time + ZBX_EXPRESSION_QUERY_CACHE_TTL <= now)
+	{
+		zbx_hashset_iter_t	iter;
+
+		zbx_hashset_iter_reset(&query_cache, &iter);
+		while (NULL != (entry = (zbx_expression_query_cache_t *)zbx_hashset_iter_next(&iter)))
+		{
+			if (entry->lastaccess + ZBX_EXPRESSION_QUERY_CACHE_TTL <= now)
+				zbx_hashset_iter_remove(&iter);
+		}
+
+		query_cache_cleanup_time = now;
+	}
+
+	expression_query_cache_key(eval, query, &local);
+
+	if (NULL == (entry = (zbx_expression_query_cache_t *)zbx_hashset_search(&query_cache, &local)) ||
+			entry->revision != revision)
+	{
+		return FAIL;
+	}
+
+	entry->lastaccess = now;
+	zbx_vector_uint64_append_array(itemids, entry->itemids.values, entry->itemids.values_num);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: cache items matching many item query                              *
+ *                                                                            *
+ * Parameters: eval     - [IN] the evaluation data                            *
+ *             query    - [IN] the expression item query                      *
+ *             revision - [IN] the items revision the query was resolved at   *
+ *             itemids  - [IN] the matching item identifiers                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	expression_query_cache_set(const zbx_expression_eval_t *eval, const zbx_expression_query_t *query,
+		zbx_uint64_t revision, const zbx_vector_uint64_t *itemids)
+{
+	zbx_expression_query_cache_t	local, *entry;
+
+	expression_query_cache_key(eval, query, &local);
+
+	if (NULL == (entry = (zbx_expression_query_cache_t *)zbx_hashset_search(&query_cache, &local)))
+	{
+		local.host = zbx_strdup(NULL, local.host);
+		local.key = zbx_strdup(NULL, local.key);
+		local.filter = zbx_strdup(NULL, local.filter);
+		zbx_vector_uint64_create(&local.itemids);
+
+		entry = (zbx_expression_query_cache_t *)zbx_hashset_insert(&query_cache, &local, sizeof(local));
+	}
+	else
+		zbx_vector_uint64_clear(&entry->itemids);
+
+	zbx_vector_uint64_append_array(&entry->itemids, itemids->values, itemids->values_num);
+	entry->revision = revision;
+	entry->lastaccess = time(NULL);
+}
+
 static void	expression_query_free_one(zbx_expression_query_one_t *query)
 {
 	zbx_free(query);
@@ -663,6 +832,7 @@ static void	expression_init_query_many(zbx_expression_eval_t *eval, zbx_expressi
 	zbx_vector_uint64_pair_t	itemhosts;
 	zbx_vector_str_t		groups;
 	zbx_vector_uint64_t		itemids;
+	zbx_uint64_t			revision;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() /%s/%s?[%s]", __func__, ZBX_NULL2EMPTY_STR(query->ref.host),
 			ZBX_NULL2EMPTY_STR(query->ref.key), ZBX_NULL2EMPTY_STR(query->ref.filter));
@@ -679,6 +849,14 @@ static void	expression_init_query_many(zbx_expression_eval_t *eval, zbx_expressi
 		goto out;
 	}
 
+	revision = zbx_dc_get_items_revision();
+
+	if (SUCCEED == expression_query_cache_get(eval, query, revision, &itemids))
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "%s() using cached items", __func__);
+		goto done;
+	}
+
 	if (0 != (query->flags & ZBX_ITEM_QUERY_FILTER))
 	{
 		if (SUCCEED != zbx_eval_parse_expression(&ctx, query->ref.filter, ZBX_EVAL_PARSE_QUERY_EXPRESSION,
@@ -741,6 +919,8 @@ static void	expression_init_query_many(zbx_expression_eval_t *eval, zbx_expressi
 			zbx_vector_uint64_append(&itemids, itemhosts.values[i].first);
 	}
 
+	expression_query_cache_set(eval, query, revision, &itemids);
+done:
 	if (SUCCEED == ZBX_CHECK_LOG_LEVEL(LOG_LEVEL_DEBUG))
 	{
 		for (i = 0; i < itemids.values_num; i++)
@@ -1522,27 +1702,31 @@ err:
 	return ret;
 }
 
-static int	evaluate_count_many(char *operator, char *pattern, zbx_dc_item_t *dcitem, zbx_vector_history_record_t *values, int seconds,
-		int count, const zbx_timespec_t *ts, zbx_vector_dbl_t *results_vector, char **error)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: count item values matching pattern for count_foreach function     *
+ *                                                                            *
+ * Parameters: pdata          - [IN] the validated count pattern              *
+ *             pattern        - [IN] the pattern                              *
+ *             dcitem         - [IN] the item                                 *
+ *             values         - [IN/OUT] the buffer for item values           *
+ *             seconds        - [IN] the time period                          *
+ *             count          - [IN] the number of values                     *
+ *             ts             - [IN] the function execution time              *
+ *             results_vector - [OUT] the count, if not zero                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	evaluate_count_many(zbx_eval_count_pattern_data_t *pdata, char *pattern, zbx_dc_item_t *dcitem,
+		zbx_vector_history_record_t *values, int seconds, int count, const zbx_timespec_t *ts,
+		zbx_vector_dbl_t *results_vector)
 {
-	int				ret = SUCCEED;
-	zbx_eval_count_pattern_data_t	pdata;
-
-	zbx_vector_expression_create(&pdata.regexps);
-
-	if (FAIL == zbx_validate_count_pattern(operator, pattern, dcitem->value_type, &pdata, error))
-	{
-		ret = FAIL;
-		goto out;
-	}
-
 	if (SUCCEED == zbx_vc_get_values(dcitem->itemid, dcitem->value_type, values, seconds, count, ts) &&
 			0 < values->values_num)
 	{
 		int	result_tmp = 0;
 		double	result;
 
-		zbx_execute_count_with_pattern(pattern, dcitem->value_type, ZBX_MAX_UINT31_1, &pdata, values, &result_tmp);
+		zbx_execute_count_with_pattern(pattern, dcitem->value_type, ZBX_MAX_UINT31_1, pdata, values, &result_tmp);
 
 		if (0 != result_tmp)
 		{
@@ -1550,12 +1734,6 @@ static int	evaluate_count_many(char *operator, char *pattern, zbx_dc_item_t *dci
 			zbx_vector_dbl_append(results_vector, result);
 		}
 	}
-
-out:
-	zbx_regexp_clean_expressions(&pdata.regexps);
-	zbx_vector_expression_destroy(&pdata.regexps);
-
-	return ret;
 }
 
 /******************************************************************************
@@ -1582,11 +1760,13 @@ static int	expression_eval_many(zbx_expression_eval_t *eval, zbx_expression_quer
 		char **error)
 {
 	zbx_expression_query_many_t	*data;
-	int				ret = FAIL, item_func, count, seconds, i;
+	int				ret = FAIL, item_func, count, seconds, i, pdata_dbl_valid = 0,
+					pdata_ui64_valid = 0;
 	zbx_vector_history_record_t	values;
 	zbx_vector_dbl_t		*results_vector;
 	double				result;
 	char				*operator = NULL, *pattern = NULL;
+	zbx_eval_count_pattern_data_t	pdata_dbl, pdata_ui64;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() %.*s(/%s/%s?[%s],...)", __func__, (int)len, name,
 			ZBX_NULL2EMPTY_STR(query->ref.host), ZBX_NULL2EMPTY_STR(query->ref.key),
@@ -1700,6 +1880,11 @@ static int	expression_eval_many(zbx_expression_eval_t *eval, zbx_expression_quer
 	results_vector = (zbx_vector_dbl_t *)zbx_malloc(NULL, sizeof(zbx_vector_dbl_t));
 	zbx_vector_dbl_create(results_vector);
 
+	/* the value buffer and the count patterns are shared by all items */
+	zbx_history_record_vector_create(&values);
+	zbx_vector_expression_create(&pdata_dbl.regexps);
+	zbx_vector_expression_create(&pdata_ui64.regexps);
+
 	for (i = 0; i < data->itemids.values_num; i++)
 	{
 		zbx_dc_item_t			*dcitem;
@@ -1719,17 +1904,36 @@ static int	expression_eval_many(zbx_expression_eval_t *eval, zbx_expression_quer
 		if (ITEM_VALUE_TYPE_FLOAT != dcitem->value_type && ITEM_VALUE_TYPE_UINT64 != dcitem->value_type)
 			continue;
 
-		zbx_history_record_vector_create(&values);
-
 		if (ZBX_VALUE_FUNC_COUNT == item_func)
 		{
-			if (FAIL == (ret = evaluate_count_many(operator, pattern, dcitem, &values, seconds, count, ts,
-					results_vector, error)))
+			zbx_eval_count_pattern_data_t	*pdata;
+			int				*pdata_valid;
+
+			if (ITEM_VALUE_TYPE_FLOAT == dcitem->value_type)
 			{
-				zbx_vector_dbl_destroy(results_vector);
-				zbx_free(results_vector);
-				goto out;
+				pdata = &pdata_dbl;
+				pdata_valid = &pdata_dbl_valid;
 			}
+			else
+			{
+				pdata = &pdata_ui64;
+				pdata_valid = &pdata_ui64_valid;
+			}
+
+			if (0 == *pdata_valid)
+			{
+				if (FAIL == zbx_validate_count_pattern(operator, pattern, dcitem->value_type, pdata,
+						error))
+				{
+					zbx_vector_dbl_destroy(results_vector);
+					zbx_free(results_vector);
+					goto clean;
+				}
+
+				*pdata_valid = 1;
+			}
+
+			evaluate_count_many(pdata, pattern, dcitem, &values, seconds, count, ts, results_vector);
 		}
 		else if (SUCCEED == zbx_vc_get_values(dcitem->itemid, dcitem->value_type, &values, seconds, count, ts)
 				&& 0 < values.values_num)
@@ -1739,12 +1943,18 @@ static int	expression_eval_many(zbx_expression_eval_t *eval, zbx_expression_quer
 			zbx_vector_dbl_append(results_vector, result);
 		}
 
-		zbx_history_record_vector_destroy(&values, dcitem->value_type);
+		zbx_history_record_vector_clean(&values, dcitem->value_type);
 	}
 
 	zbx_variant_set_dbl_vector(value, results_vector);
 
 	ret = SUCCEED;
+clean:
+	zbx_regexp_clean_expressions(&pdata_ui64.regexps);
+	zbx_vector_expression_destroy(&pdata_ui64.regexps);
+	zbx_regexp_clean_expressions(&pdata_dbl.regexps);
+	zbx_vector_expression_destroy(&pdata_dbl.regexps);
+	zbx_history_record_vector_destroy(&values, ITEM_VALUE_TYPE_FLOAT);
 out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s value:%s flags:%s", __func__, zbx_result_string(ret),
 			zbx_variant_value_desc(value), zbx_variant_type_desc(value));
@@ -26,6 +26,7 @@
 #include "zbxcachevalue.h"
 #include "zbxtrends.h"
 #include "anomalystl.h"
+#include "evalwindow.h"
 #include "zbxnum.h"
 #include "zbxstr.h"
 #include "zbxexpr.h"
@@ -1386,6 +1387,42 @@ void	zbx_execute_count_with_pattern(char *pattern, unsigned char value_type, int
 	}
 }
 
+/* the data of counting values processed directly in value cache */
+typedef struct
+{
+	const zbx_eval_count_pattern_data_t	*pdata;
+	int					count;
+}
+zbx_count_values_t;
+
+static void	count_values(const zbx_history_record_t *values, int values_num, void *data)
+{
+	ZBX_UNUSED(values);
+
+	((zbx_count_values_t *)data)->count += values_num;
+}
+
+static void	count_values_ui64(const zbx_history_record_t *values, int values_num, void *data)
+{
+	zbx_count_values_t	*cv = (zbx_count_values_t *)data;
+	int			i;
+
+	for (i = 0; i < values_num; i++)
+	{
+		count_one_ui64(&cv->count, cv->pdata->op, values[i].value.ui64, cv->pdata->pattern_ui64,
+				cv->pdata->pattern2_ui64);
+	}
+}
+
+static void	count_values_dbl(const zbx_history_record_t *values, int values_num, void *data)
+{
+	zbx_count_values_t	*cv = (zbx_count_values_t *)data;
+	int			i;
+
+	for (i = 0; i < values_num; i++)
+		count_one_dbl(&cv->count, cv->pdata->op, values[i].value.dbl, cv->pdata->pattern_dbl);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: evaluate functions 'count' and 'find' for the item                *
@@ -1416,7 +1453,8 @@ void	zbx_execute_count_with_pattern(char *pattern, unsigned char value_type, int
 static int	evaluate_COUNT(zbx_variant_t *value, const zbx_dc_evaluate_item_t *item, const char *parameters,
 		const zbx_timespec_t *ts, int limit, int unique, char **error)
 {
-	int				arg1, nparams, count = 0, ret = FAIL, seconds = 0, nvalues = 0, time_shift;
+	int				arg1, nparams, count = 0, ret = FAIL, seconds = 0, nvalues = 0, time_shift,
+					count_pattern;
 	char				*operator = NULL, *pattern = NULL;
 	zbx_value_type_t		arg1_type;
 	zbx_vector_history_record_t	values;
@@ -1477,6 +1515,42 @@ static int	evaluate_COUNT(zbx_variant_t *value, const zbx_dc_evaluate_item_t *it
 			THIS_SHOULD_NEVER_HAPPEN;
 	}
 
+	/* skip counting values one by one if both pattern and operator are empty or "" is searched in text values */
+	count_pattern = ((NULL != pattern && '\0' != *pattern) || (NULL != operator && '\0' != *operator &&
+			OP_LIKE != pdata.op && OP_REGEXP != pdata.op && OP_IREGEXP != pdata.op));
+
+	/* numeric values are counted in value cache without copying them */
+	if (COUNT_ALL == unique && (0 == count_pattern || 0 != pdata.numeric_search))
+	{
+		zbx_count_values_t	cv = {.pdata = &pdata};
+		zbx_vc_values_func_t	values_func;
+		zbx_history_value_t	result;
+
+		if (0 == count_pattern)
+			values_func = count_values;
+		else if (ITEM_VALUE_TYPE_UINT64 == item->value_type)
+			values_func = count_values_ui64;
+		else
+			values_func = count_values_dbl;
+
+		if (0 != count_pattern || ZBX_VALUE_SECONDS != arg1_type ||
+				SUCCEED != zbx_evalwindow_aggregate(ZBX_EVALWINDOW_COUNT, item->itemid, item->value_type,
+				seconds, time_shift, &ts_end, &result, &cv.count))
+		{
+			if (FAIL == zbx_vc_iterate_values(item->itemid, item->value_type, seconds, nvalues, &ts_end,
+					values_func, &cv))
+			{
+				*error = zbx_strdup(*error, "cannot get values from value cache");
+				goto out;
+			}
+		}
+
+		if ((count = cv.count) > limit)
+			count = limit;
+
+		goto finish;
+	}
+
 	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
 	{
 		*error = zbx_strdup(*error, "cannot get values from value cache");
@@ -1513,9 +1587,7 @@ static int	evaluate_COUNT(zbx_variant_t *value, const zbx_dc_evaluate_item_t *it
 		}
 	}
 
-	/* skip counting values one by one if both pattern and operator are empty or "" is searched in text values */
-	if ((NULL != pattern && '\0' != *pattern) || (NULL != operator && '\0' != *operator &&
-			OP_LIKE != pdata.op && OP_REGEXP != pdata.op && OP_IREGEXP != pdata.op))
+	if (0 != count_pattern)
 	{
 		zbx_execute_count_with_pattern(pattern, item->value_type, limit, &pdata, &values, &count);
 
@@ -1530,7 +1602,7 @@ static int	evaluate_COUNT(zbx_variant_t *value, const zbx_dc_evaluate_item_t *it
 		if ((count = values.values_num) > limit)
 			count = limit;
 	}
-
+finish:
 	zbx_variant_set_dbl(value, count);
 
 	ret = SUCCEED;
@@ -1560,6 +1632,112 @@ out:
 #undef OP_IREGEXP
 #undef OP_BITAND
 
+/* the aggregate of numeric item values processed directly in value cache */
+typedef struct
+{
+	zbx_history_value_t	value;
+	int			values_num;
+}
+zbx_aggregate_values_t;
+
+/* The aggregate functions process values in the order they are returned by zbx_vc_get_values(), */
+/* newest first, iterating value blocks backwards. This keeps floating point results identical    */
+/* to the ones calculated from value vector.                                                      */
+
+static void	aggregate_sum_dbl(const zbx_history_record_t *values, int values_num, void *data)
+{
+	zbx_aggregate_values_t	*av = (zbx_aggregate_values_t *)data;
+	double			sum = av->value.dbl;
+	int			i;
+
+	for (i = values_num - 1; i >= 0; i--)
+		sum += values[i].value.dbl;
+
+	av->value.dbl = sum;
+	av->values_num += values_num;
+}
+
+static void	aggregate_sum_ui64(const zbx_history_record_t *values, int values_num, void *data)
+{
+	zbx_aggregate_values_t	*av = (zbx_aggregate_values_t *)data;
+	zbx_uint64_t		sum = 0;
+	int			i;
+
+	/* integer addition does not depend on order, so values can be summed forwards */
+	for (i = 0; i < values_num; i++)
+		sum += values[i].value.ui64;
+
+	av->value.ui64 += sum;
+	av->values_num += values_num;
+}
+
+static void	aggregate_avg_dbl(const zbx_history_record_t *values, int values_num, void *data)
+{
+	zbx_aggregate_values_t	*av = (zbx_aggregate_values_t *)data;
+	double			avg = av->value.dbl;
+	int			i, num = av->values_num;
+
+	for (i = values_num - 1; i >= 0; i--, num++)
+		avg += values[i].value.dbl / (num + 1) - avg / (num + 1);
+
+	av->value.dbl = avg;
+	av->values_num = num;
+}
+
+static void	aggregate_sum_ui64_dbl(const zbx_history_record_t *values, int values_num, void *data)
+{
+	zbx_aggregate_values_t	*av = (zbx_aggregate_values_t *)data;
+	double			sum = av->value.dbl;
+	int			i;
+
+	for (i = values_num - 1; i >= 0; i--)
+		sum += (double)values[i].value.ui64;
+
+	av->value.dbl = sum;
+	av->values_num += values_num;
+}
+
+#define AGGREGATE_MIN_OR_MAX(type, mode_op)							\
+	do											\
+	{											\
+		zbx_aggregate_values_t	*av = (zbx_aggregate_values_t *)data;			\
+		int			i = values_num - 1;					\
+												\
+		if (0 == av->values_num)							\
+			av->value.type = values[i--].value.type;				\
+												\
+		for (; i >= 0; i--)								\
+		{										\
+			if (values[i].value.type mode_op av->value.type)			\
+				av->value.type = values[i].value.type;				\
+		}										\
+												\
+		av->values_num += values_num;							\
+	}											\
+	while(0)
+
+static void	aggregate_min_dbl(const zbx_history_record_t *values, int values_num, void *data)
+{
+	AGGREGATE_MIN_OR_MAX(dbl, <);
+}
+
+static void	aggregate_max_dbl(const zbx_history_record_t *values, int values_num, void *data)
+{
+	AGGREGATE_MIN_OR_MAX(dbl, >);
+}
+
+static void	aggregate_min_ui64(const zbx_history_record_t *values, int values_num, void *data)
+{
+	AGGREGATE_MIN_OR_MAX(ui64, <);
+}
+
+static void	aggregate_max_ui64(const zbx_history_record_t *values, int values_num, void *data)
+{
+	AGGREGATE_MIN_OR_MAX(ui64, >);
+}
+
+#undef AGGREGATE_MIN_OR_MAX
+
 /******************************************************************************
  *                                                                            *
  * Purpose: evaluate function 'sum' for the item                              *
@@ -1578,16 +1756,14 @@ out:
 static int	evaluate_SUM(zbx_variant_t *value, const zbx_dc_evaluate_item_t *item, const char *parameters,
 		const zbx_timespec_t *ts, char **error)
 {
-	int				arg1, i, ret = FAIL, seconds = 0, nvalues = 0, time_shift;
-	zbx_value_type_t		arg1_type;
-	zbx_vector_history_record_t	values;
-	zbx_history_value_t		result;
-	zbx_timespec_t			ts_end = *ts;
+	int			arg1, ret = FAIL, seconds = 0, nvalues = 0, time_shift;
+	zbx_value_type_t	arg1_type;
+	zbx_aggregate_values_t	av = {0};
+	zbx_timespec_t		ts_end = *ts;
+	zbx_vc_values_func_t	values_func;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	zbx_history_record_vector_create(&values);
-
 	if (ITEM_VALUE_TYPE_FLOAT != item->value_type && ITEM_VALUE_TYPE_UINT64 != item->value_type)
 	{
 		*error = zbx_strdup(*error, "invalid value type");
@@ -1621,32 +1797,25 @@ static int	evaluate_SUM(zbx_variant_t *value, const zbx_dc_evaluate_item_t *item
 			THIS_SHOULD_NEVER_HAPPEN;
 	}
 
-	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
-	{
-		*error = zbx_strdup(*error, "cannot get values from value cache");
-		goto out;
-	}
-
-	if (ITEM_VALUE_TYPE_FLOAT == item->value_type)
-	{
-		result.dbl = 0;
-
-		for (i = 0; i < values.values_num; i++)
-			result.dbl += values.values[i].value.dbl;
-	}
-	else
+	if (ZBX_VALUE_SECONDS != arg1_type || SUCCEED != zbx_evalwindow_aggregate(ZBX_EVALWINDOW_SUM,
+			item->itemid, item->value_type, seconds, time_shift, &ts_end, &av.value, &av.values_num))
 	{
-		result.ui64 = 0;
+		if (ITEM_VALUE_TYPE_FLOAT == item->value_type)
+			values_func = aggregate_sum_dbl;
+		else
+			values_func = aggregate_sum_ui64;
 
-		for (i = 0; i < values.values_num; i++)
-			result.ui64 += values.values[i].value.ui64;
+		if (FAIL == zbx_vc_iterate_values(item->itemid, item->value_type, seconds, nvalues, &ts_end,
+				values_func, &av))
+		{
+			*error = zbx_strdup(*error, "cannot get values from value cache");
+			goto out;
+		}
 	}
 
-	zbx_history_value2variant(&result, item->value_type, value);
+	zbx_history_value2variant(&av.value, item->value_type, value);
 	ret = SUCCEED;
 out:
-	zbx_history_record_vector_destroy(&values, item->value_type);
-
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
 	return ret;
@@ -1670,15 +1839,14 @@ out:
 static int	evaluate_AVG(zbx_variant_t *value, const zbx_dc_evaluate_item_t *item, const char *parameters,
 		const zbx_timespec_t *ts, char **error)
 {
-	int				arg1, ret = FAIL, i, seconds = 0, nvalues = 0, time_shift;
-	zbx_value_type_t		arg1_type;
-	zbx_vector_history_record_t	values;
-	zbx_timespec_t			ts_end = *ts;
+	int			arg1, ret = FAIL, seconds = 0, nvalues = 0, time_shift;
+	zbx_value_type_t	arg1_type;
+	zbx_aggregate_values_t	av = {0};
+	zbx_timespec_t		ts_end = *ts;
+	zbx_vc_values_func_t	values_func;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	zbx_history_record_vector_create(&values);
-
 	if (ITEM_VALUE_TYPE_FLOAT != item->value_type && ITEM_VALUE_TYPE_UINT64 != item->value_type)
 	{
 		*error = zbx_strdup(*error, "invalid value type");
@@ -1712,29 +1880,28 @@ static int	evaluate_AVG(zbx_variant_t *value, const zbx_dc_evaluate_item_t *item
 			THIS_SHOULD_NEVER_HAPPEN;
 	}
 
-	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
-	{
-		*error = zbx_strdup(*error, "cannot get values from value cache");
-		goto out;
-	}
-
-	if (0 < values.values_num)
+	if (ZBX_VALUE_SECONDS != arg1_type || SUCCEED != zbx_evalwindow_aggregate(ZBX_EVALWINDOW_AVG,
+			item->itemid, item->value_type, seconds, time_shift, &ts_end, &av.value, &av.values_num))
 	{
-		double	avg = 0;
-
 		if (ITEM_VALUE_TYPE_FLOAT == item->value_type)
-		{
-			for (i = 0; i < values.values_num; i++)
-				avg += values.values[i].value.dbl / (i + 1) - avg / (i + 1);
-		}
+			values_func = aggregate_avg_dbl;
 		else
-		{
-			for (i = 0; i < values.values_num; i++)
-				avg += (double)values.values[i].value.ui64;
+			values_func = aggregate_sum_ui64_dbl;
 
-			avg = avg / values.values_num;
+		if (FAIL == zbx_vc_iterate_values(item->itemid, item->value_type, seconds, nvalues, &ts_end,
+				values_func, &av))
+		{
+			*error = zbx_strdup(*error, "cannot get values from value cache");
+			goto out;
 		}
-		zbx_variant_set_dbl(value, avg);
+
+		if (ITEM_VALUE_TYPE_UINT64 == item->value_type && 0 < av.values_num)
+			av.value.dbl = av.value.dbl / av.values_num;
+	}
+
+	if (0 < av.values_num)
+	{
+		zbx_variant_set_dbl(value, av.value.dbl);
 
 		ret = SUCCEED;
 	}
@@ -1744,8 +1911,6 @@ static int	evaluate_AVG(zbx_variant_t *value, const zbx_dc_evaluate_item_t *item
 		*error = zbx_strdup(*error, "not enough data");
 	}
 out:
-	zbx_history_record_vector_destroy(&values, item->value_type);
-
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
 	return ret;
@@ -1788,17 +1953,6 @@ static int	evaluate_LAST(zbx_variant_t *value, const zbx_dc_evaluate_item_t *ite
 #define EVALUATE_MIN	0
 #define EVALUATE_MAX	1
 
-#define LOOP_FIND_MIN_OR_MAX(type, mode_op)							\
-	do											\
-	{											\
-		for (i = 1; i < values.values_num; i++)							\
-		{											\
-			if (values.values[i].value.type mode_op values.values[index].value.type)	\
-				index = i;								\
-		}											\
-	}												\
-	while(0)
-
 /******************************************************************************
  *                                                                            *
  * Purpose: evaluate function 'min' or 'max' for the item                     *
@@ -1818,15 +1972,14 @@ static int	evaluate_LAST(zbx_variant_t *value, const zbx_dc_evaluate_item_t *ite
 static int	evaluate_MIN_or_MAX(zbx_variant_t *value, const zbx_dc_evaluate_item_t *item, const char *parameters,
 		const zbx_timespec_t *ts, char **error, int min_or_max)
 {
-	int				arg1, i, ret = FAIL, seconds = 0, nvalues = 0, time_shift;
-	zbx_value_type_t		arg1_type;
-	zbx_vector_history_record_t	values;
-	zbx_timespec_t			ts_end = *ts;
+	int			arg1, ret = FAIL, seconds = 0, nvalues = 0, time_shift;
+	zbx_value_type_t	arg1_type;
+	zbx_aggregate_values_t	av = {0};
+	zbx_timespec_t		ts_end = *ts;
+	zbx_vc_values_func_t	values_func;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	zbx_history_record_vector_create(&values);
-
 	if (ITEM_VALUE_TYPE_FLOAT != item->value_type && ITEM_VALUE_TYPE_UINT64 != item->value_type)
 	{
 		*error = zbx_strdup(*error, "invalid value type");
@@ -1860,40 +2013,26 @@ static int	evaluate_MIN_or_MAX(zbx_variant_t *value, const zbx_dc_evaluate_item_
 			THIS_SHOULD_NEVER_HAPPEN;
 	}
 
-	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
-	{
-		*error = zbx_strdup(*error, "cannot get values from value cache");
-		goto out;
-	}
-
-	if (0 < values.values_num)
+	if (ZBX_VALUE_SECONDS != arg1_type || SUCCEED != zbx_evalwindow_aggregate(
+			EVALUATE_MIN == min_or_max ? ZBX_EVALWINDOW_MIN : ZBX_EVALWINDOW_MAX, item->itemid,
+			item->value_type, seconds, time_shift, &ts_end, &av.value, &av.values_num))
 	{
-		int	index = 0;
-
 		if (ITEM_VALUE_TYPE_UINT64 == item->value_type)
-		{
-			if (EVALUATE_MIN == min_or_max)
-			{
-				LOOP_FIND_MIN_OR_MAX(ui64, <);
-			}
-			else
-			{
-				LOOP_FIND_MIN_OR_MAX(ui64, >);
-			}
-		}
+			values_func = (EVALUATE_MIN == min_or_max ? aggregate_min_ui64 : aggregate_max_ui64);
 		else
+			values_func = (EVALUATE_MIN == min_or_max ? aggregate_min_dbl : aggregate_max_dbl);
+
+		if (FAIL == zbx_vc_iterate_values(item->itemid, item->value_type, seconds, nvalues, &ts_end,
+				values_func, &av))
 		{
-			if (EVALUATE_MIN == min_or_max)
-			{
-				LOOP_FIND_MIN_OR_MAX(dbl, <);
-			}
-			else
-			{
-				LOOP_FIND_MIN_OR_MAX(dbl, >);
-			}
+			*error = zbx_strdup(*error, "cannot get values from value cache");
+			goto out;
 		}
+	}
 
-		zbx_history_value2variant(&values.values[index].value, item->value_type, value);
+	if (0 < av.values_num)
+	{
+		zbx_history_value2variant(&av.value, item->value_type, value);
 		ret = SUCCEED;
 	}
 	else
@@ -1902,8 +2041,6 @@ static int	evaluate_MIN_or_MAX(zbx_variant_t *value, const zbx_dc_evaluate_item_
 		*error = zbx_strdup(*error, "not enough data");
 	}
 out:
-	zbx_history_record_vector_destroy(&values, item->value_type);
-
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
 	return ret;
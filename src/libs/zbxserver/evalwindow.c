@@ -0,0 +1,553 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+
+#include "evalwindow.h"
+
+#include "zbxcachevalue.h"
+#include "zbxhistory.h"
+#include "log.h"
+
+/*
+ * The sliding window aggregates are kept by every process evaluating functions. When a function
+ * is evaluated again with later window end, only the values that entered and left the window
+ * since the last evaluation are read from value cache and applied to the aggregate:
+ *   sum, avg, count - running sum and number of values,
+ *   min, max        - monotonic deque of values that can become window minimum/maximum.
+ *
+ * The aggregate is recalculated from all window values when the item revision in value cache
+ * has changed (values were inserted not at the head of cached data), the window end has moved
+ * backwards or further than the window size. Floating point sums are also periodically
+ * recalculated to avoid accumulating rounding errors.
+ */
+
+/* the period after which unused windows are removed */
+#define ZBX_EVALWINDOW_EXPIRE_PERIOD	SEC_PER_HOUR
+
+/* the period of removing unused windows */
+#define ZBX_EVALWINDOW_CLEANUP_PERIOD	(10 * SEC_PER_MIN)
+
+typedef struct
+{
+	/* the window identification - item, function and its parameters */
+	zbx_uint64_t			itemid;
+	int				func;
+	int				seconds;
+	int				time_shift;
+
+	unsigned char			value_type;
+
+	/* the item data revision in value cache when the window was updated */
+	zbx_uint64_t			revision;
+
+	/* the window end timestamp */
+	zbx_timespec_t			end;
+
+	/* the sum of window values, stored as double for avg function */
+	zbx_history_value_t		sum;
+
+	/* the number of window values */
+	int				values_num;
+
+	/* the number of values added and removed since window was calculated */
+	int				updates;
+
+	/* the monotonic deque of min/max candidates sorted by timestamps */
+	zbx_vector_history_record_t	deque;
+	int				deque_first;
+
+	int				lastused;
+}
+zbx_evalwindow_t;
+
+static zbx_hashset_t	evalwindows;
+static int		evalwindows_init = 0;
+static int		evalwindows_cleanup_time = 0;
+
+static zbx_hash_t	evalwindow_hash_func(const void *data)
+{
+	const zbx_evalwindow_t	*window = (const zbx_evalwindow_t *)data;
+	zbx_hash_t		hash;
+
+	hash = ZBX_DEFAULT_UINT64_HASH_FUNC(&window->itemid);
+	hash = ZBX_DEFAULT_HASH_ALGO(&window->func, sizeof(window->func), hash);
+	hash = ZBX_DEFAULT_HASH_ALGO(&window->seconds, sizeof(window->seconds), hash);
+
+	return ZBX_DEFAULT_HASH_ALGO(&window->time_shift, sizeof(window->time_shift), hash);
+}
+
+static int	evalwindow_compare_func(const void *d1, const void *d2)
+{
+	const zbx_evalwindow_t	*w1 = (const zbx_evalwindow_t *)d1;
+	const zbx_evalwindow_t	*w2 = (const zbx_evalwindow_t *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(w1->itemid, w2->itemid);
+	ZBX_RETURN_IF_NOT_EQUAL(w1->func, w2->func);
+	ZBX_RETURN_IF_NOT_EQUAL(w1->seconds, w2->seconds);
+	ZBX_RETURN_IF_NOT_EQUAL(w1->time_shift, w2->time_shift);
+
+	return 0;
+}
+
+static void	evalwindow_clean_func(void *data)
+{
+	zbx_evalwindow_t	*window = (zbx_evalwindow_t *)data;
+
+	zbx_vector_history_record_destroy(&window->deque);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: removes windows not used for the expiration period                *
+ *                                                                            *
+ ******************************************************************************/
+static void	evalwindows_cleanup(int now)
+{
+	zbx_hashset_iter_t	iter;
+	zbx_evalwindow_t	*window;
+
+	zbx_hashset_iter_reset(&evalwindows, &iter);
+
+	while (NULL != (window = (zbx_evalwindow_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (window->lastused + ZBX_EVALWINDOW_EXPIRE_PERIOD < now)
+			zbx_hashset_iter_remove(&iter);
+	}
+
+	evalwindows_cleanup_time = now;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if value is better min/max candidate than the other value  *
+ *                                                                            *
+ ******************************************************************************/
+static int	evalwindow_is_better(const zbx_evalwindow_t *window, const zbx_history_value_t *value,
+		const zbx_history_value_t *other)
+{
+	if (ITEM_VALUE_TYPE_UINT64 == window->value_type)
+	{
+		if (ZBX_EVALWINDOW_MIN == window->func)
+			return value->ui64 < other->ui64 ? SUCCEED : FAIL;
+
+		return value->ui64 > other->ui64 ? SUCCEED : FAIL;
+	}
+
+	if (ZBX_EVALWINDOW_MIN == window->func)
+		return value->dbl < other->dbl ? SUCCEED : FAIL;
+
+	return value->dbl > other->dbl ? SUCCEED : FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds value to or removes it from the window sum                   *
+ *                                                                            *
+ * Parameters: window - [IN] the window                                       *
+ *             value  - [IN] the value                                        *
+ *             sign   - [IN] 1 to add value, -1 to remove it                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	evalwindow_sum_value(zbx_evalwindow_t *window, const zbx_history_value_t *value, int sign)
+{
+	window->values_num += sign;
+
+	switch (window->func)
+	{
+		case ZBX_EVALWINDOW_SUM:
+			if (ITEM_VALUE_TYPE_UINT64 == window->value_type)
+			{
+				if (0 < sign)
+					window->sum.ui64 += value->ui64;
+				else
+					window->sum.ui64 -= value->ui64;
+				break;
+			}
+			ZBX_FALLTHROUGH;
+		case ZBX_EVALWINDOW_AVG:
+			if (ITEM_VALUE_TYPE_UINT64 == window->value_type)
+				window->sum.dbl += sign * (double)value->ui64;
+			else
+				window->sum.dbl += sign * value->dbl;
+			break;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds value, newer than the existing ones, to the min/max deque    *
+ *                                                                            *
+ ******************************************************************************/
+static void	evalwindow_deque_push(zbx_evalwindow_t *window, const zbx_history_record_t *record)
+{
+	zbx_vector_history_record_t	*deque = &window->deque;
+
+	/* drop older candidates that cannot become min/max while the new value is in window */
+	while (deque->values_num > window->deque_first &&
+			SUCCEED != evalwindow_is_better(window, &deque->values[deque->values_num - 1].value,
+			&record->value))
+	{
+		deque->values_num--;
+	}
+
+	zbx_vector_history_record_append_ptr(deque, (zbx_history_record_t *)record);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: removes min/max candidates that have left the window              *
+ *                                                                            *
+ ******************************************************************************/
+static void	evalwindow_deque_pop(zbx_evalwindow_t *window, const zbx_timespec_t *start)
+{
+	zbx_vector_history_record_t	*deque = &window->deque;
+
+	while (window->deque_first < deque->values_num &&
+			0 >= zbx_timespec_compare(&deque->values[window->deque_first].timestamp, start))
+	{
+		window->deque_first++;
+	}
+
+	if (window->deque_first == deque->values_num)
+	{
+		zbx_vector_history_record_clear(deque);
+		window->deque_first = 0;
+	}
+	else if (window->deque_first > deque->values_num / 2)
+	{
+		deque->values_num -= window->deque_first;
+		memmove(deque->values, deque->values + window->deque_first,
+				sizeof(zbx_history_record_t) * (size_t)deque->values_num);
+		window->deque_first = 0;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: value cache callback to calculate window sum                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	evalwindow_sum_values(const zbx_history_record_t *values, int values_num, void *data)
+{
+	zbx_evalwindow_t	*window = (zbx_evalwindow_t *)data;
+	int			i;
+
+	/* process values from the newest to keep the order of floating point additions */
+	for (i = values_num - 1; i >= 0; i--)
+		evalwindow_sum_value(window, &values[i].value, 1);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: value cache callback to collect min/max candidates                *
+ *                                                                            *
+ * Comments: The values are processed from the newest and value is kept as    *
+ *           candidate only if it's better than all newer values. The         *
+ *           candidates are collected in descending timestamp order.          *
+ *                                                                            *
+ ******************************************************************************/
+static void	evalwindow_deque_values(const zbx_history_record_t *values, int values_num, void *data)
+{
+	zbx_evalwindow_t		*window = (zbx_evalwindow_t *)data;
+	zbx_vector_history_record_t	*deque = &window->deque;
+	int				i;
+
+	for (i = values_num - 1; i >= 0; i--)
+	{
+		if (0 == deque->values_num || SUCCEED == evalwindow_is_better(window, &values[i].value,
+				&deque->values[deque->values_num - 1].value))
+		{
+			zbx_vector_history_record_append_ptr(deque, (zbx_history_record_t *)&values[i]);
+		}
+	}
+}
+
+/* the value cache callback data to collect values newer than the specified timestamp */
+typedef struct
+{
+	zbx_timespec_t			from;
+	zbx_vector_history_record_t	*values;
+}
+zbx_evalwindow_collect_t;
+
+static void	evalwindow_collect_values(const zbx_history_record_t *values, int values_num, void *data)
+{
+	zbx_evalwindow_collect_t	*collect = (zbx_evalwindow_collect_t *)data;
+	int				i;
+
+	for (i = values_num - 1; i >= 0 && 0 < zbx_timespec_compare(&values[i].timestamp, &collect->from); i--)
+		zbx_vector_history_record_append_ptr(collect->values, (zbx_history_record_t *)&values[i]);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reads item values in the specified time interval                  *
+ *                                                                            *
+ * Parameters: window - [IN] the window                                       *
+ *             from   - [IN] the interval start (exclusive)                   *
+ *             to     - [IN] the interval end (inclusive)                     *
+ *             values - [OUT] the values sorted by timestamp in ascending     *
+ *                            order                                           *
+ *                                                                            *
+ * Return value: SUCCEED - the values were read successfully                  *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	evalwindow_read_values(const zbx_evalwindow_t *window, const zbx_timespec_t *from,
+		const zbx_timespec_t *to, zbx_vector_history_record_t *values)
+{
+	zbx_evalwindow_collect_t	collect = {.from = *from, .values = values};
+
+	/* request one more second to include values with nanoseconds after the interval start */
+	if (FAIL == zbx_vc_iterate_values(window->itemid, window->value_type, to->sec - from->sec + 1, 0, to,
+			evalwindow_collect_values, &collect))
+	{
+		return FAIL;
+	}
+
+	zbx_vector_history_record_sort(values, (zbx_compare_func_t)zbx_history_record_compare_asc_func);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: calculates window aggregate from all window values                *
+ *                                                                            *
+ * Parameters: window - [IN] the window                                       *
+ *             ts     - [IN] the window end timestamp                         *
+ *                                                                            *
+ * Return value: SUCCEED - the window was calculated successfully             *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	evalwindow_calculate(zbx_evalwindow_t *window, const zbx_timespec_t *ts)
+{
+	zbx_vector_history_record_t	*deque = &window->deque;
+	zbx_vc_values_func_t		values_func;
+	int				i;
+
+	memset(&window->sum, 0, sizeof(window->sum));
+	window->values_num = 0;
+	window->updates = 0;
+	zbx_vector_history_record_clear(deque);
+	window->deque_first = 0;
+
+	if (ZBX_EVALWINDOW_MIN == window->func || ZBX_EVALWINDOW_MAX == window->func)
+		values_func = evalwindow_deque_values;
+	else
+		values_func = evalwindow_sum_values;
+
+	if (FAIL == zbx_vc_iterate_values(window->itemid, window->value_type, window->seconds, 0, ts, values_func,
+			window))
+	{
+		return FAIL;
+	}
+
+	/* min/max candidates were collected in descending order */
+	for (i = 0; i < deque->values_num / 2; i++)
+	{
+		zbx_history_record_t	record = deque->values[i];
+
+		deque->values[i] = deque->values[deque->values_num - i - 1];
+		deque->values[deque->values_num - i - 1] = record;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: updates window aggregate with values that entered and left the    *
+ *          window since the last update                                      *
+ *                                                                            *
+ * Parameters: window - [IN] the window                                       *
+ *             ts     - [IN] the new window end timestamp                     *
+ *                                                                            *
+ * Return value: SUCCEED - the window was updated successfully                *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	evalwindow_update(zbx_evalwindow_t *window, const zbx_timespec_t *ts)
+{
+	zbx_vector_history_record_t	values;
+	zbx_timespec_t			start_old = {window->end.sec - window->seconds, window->end.ns},
+					start_new = {ts->sec - window->seconds, ts->ns};
+	int				i, ret = FAIL;
+
+	zbx_history_record_vector_create(&values);
+
+	if (SUCCEED != evalwindow_read_values(window, &window->end, ts, &values))
+		goto out;
+
+	if (ZBX_EVALWINDOW_MIN == window->func || ZBX_EVALWINDOW_MAX == window->func)
+	{
+		for (i = 0; i < values.values_num; i++)
+			evalwindow_deque_push(window, &values.values[i]);
+
+		evalwindow_deque_pop(window, &start_new);
+		ret = SUCCEED;
+		goto out;
+	}
+
+	for (i = 0; i < values.values_num; i++)
+		evalwindow_sum_value(window, &values.values[i].value, 1);
+
+	window->updates += values.values_num;
+	zbx_vector_history_record_clear(&values);
+
+	if (0 < zbx_timespec_compare(&start_new, &start_old))
+	{
+		if (SUCCEED != evalwindow_read_values(window, &start_old, &start_new, &values))
+			goto out;
+
+		for (i = 0; i < values.values_num; i++)
+			evalwindow_sum_value(window, &values.values[i].value, -1);
+
+		window->updates += values.values_num;
+	}
+
+	/* removed values not matching the added ones means that window data has changed */
+	if (0 <= window->values_num)
+		ret = SUCCEED;
+out:
+	zbx_vector_history_record_destroy(&values);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if window sum must be recalculated to drop accumulated     *
+ *          floating point rounding errors                                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	evalwindow_recalculate_sum(const zbx_evalwindow_t *window)
+{
+	if (ZBX_EVALWINDOW_AVG != window->func && (ZBX_EVALWINDOW_SUM != window->func ||
+			ITEM_VALUE_TYPE_FLOAT != window->value_type))
+	{
+		return FAIL;
+	}
+
+	/* recalculate after the window values were replaced, keeping amortized update cost constant */
+	return window->updates > window->values_num ? SUCCEED : FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: evaluates aggregate function over sliding time window             *
+ *                                                                            *
+ * Parameters: func       - [IN] the function (ZBX_EVALWINDOW_*)              *
+ *             itemid     - [IN] the item id                                  *
+ *             value_type - [IN] the item value type                          *
+ *             seconds    - [IN] the window size                              *
+ *             time_shift - [IN] the function time shift                      *
+ *             ts         - [IN] the window end timestamp                     *
+ *             value      - [OUT] the function result (not set for count)     *
+ *             values_num - [OUT] the number of values in window              *
+ *                                                                            *
+ * Return value: SUCCEED - the function was evaluated                         *
+ *               FAIL    - the item is not cached in value cache or its       *
+ *                         values could not be read, the function must be     *
+ *                         evaluated from all window values                   *
+ *                                                                            *
+ * Comments: For min/max functions the values_num is set to the number of     *
+ *           min/max candidates, which is zero only if window is empty.       *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_evalwindow_aggregate(int func, zbx_uint64_t itemid, unsigned char value_type, int seconds,
+		int time_shift, const zbx_timespec_t *ts, zbx_history_value_t *value, int *values_num)
+{
+	zbx_evalwindow_t	*window, window_local;
+	zbx_uint64_t		revision;
+	int			now, ret;
+
+	if (SUCCEED != zbx_vc_get_item_revision(itemid, value_type, &revision))
+		return FAIL;
+
+	now = (int)time(NULL);
+
+	if (0 == evalwindows_init)
+	{
+		zbx_hashset_create_ext(&evalwindows, 100, evalwindow_hash_func, evalwindow_compare_func,
+				evalwindow_clean_func, ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC,
+				ZBX_DEFAULT_MEM_FREE_FUNC);
+		evalwindows_init = 1;
+		evalwindows_cleanup_time = now;
+	}
+	else if (evalwindows_cleanup_time + ZBX_EVALWINDOW_CLEANUP_PERIOD <= now)
+		evalwindows_cleanup(now);
+
+	memset(&window_local, 0, sizeof(window_local));
+	window_local.itemid = itemid;
+	window_local.func = func;
+	window_local.seconds = seconds;
+	window_local.time_shift = time_shift;
+
+	if (NULL == (window = (zbx_evalwindow_t *)zbx_hashset_search(&evalwindows, &window_local)))
+	{
+		window_local.value_type = value_type;
+		zbx_history_record_vector_create(&window_local.deque);
+
+		window = (zbx_evalwindow_t *)zbx_hashset_insert(&evalwindows, &window_local, sizeof(window_local));
+		ret = evalwindow_calculate(window, ts);
+	}
+	else if (window->value_type != value_type || window->revision != revision ||
+			0 > zbx_timespec_compare(ts, &window->end) || ts->sec - window->end.sec >= seconds ||
+			SUCCEED == evalwindow_recalculate_sum(window))
+	{
+		window->value_type = value_type;
+		ret = evalwindow_calculate(window, ts);
+	}
+	else
+		ret = evalwindow_update(window, ts);
+
+	if (SUCCEED != ret)
+	{
+		zbx_hashset_remove_direct(&evalwindows, window);
+		return FAIL;
+	}
+
+	/* keep the revision read before values, so changes made while reading are detected next time */
+	window->revision = revision;
+	window->end = *ts;
+	window->lastused = now;
+
+	switch (func)
+	{
+		case ZBX_EVALWINDOW_SUM:
+			*value = window->sum;
+			*values_num = window->values_num;
+			break;
+		case ZBX_EVALWINDOW_AVG:
+			if (0 != (*values_num = window->values_num))
+				value->dbl = window->sum.dbl / window->values_num;
+			break;
+		case ZBX_EVALWINDOW_MIN:
+		case ZBX_EVALWINDOW_MAX:
+			if (0 != (*values_num = window->deque.values_num - window->deque_first))
+				*value = window->deque.values[window->deque_first].value;
+			break;
+		default:
+			*values_num = window->values_num;
+	}
+
+	return SUCCEED;
+}
@@ -0,0 +1,37 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#ifndef ZABBIX_EVALWINDOW_H
+#define ZABBIX_EVALWINDOW_H
+
+#include "zbxtypes.h"
+#include "zbxtime.h"
+#include "zbxvariant.h"
+
+/* the functions aggregated over sliding time windows */
+#define ZBX_EVALWINDOW_SUM	0
+#define ZBX_EVALWINDOW_AVG	1
+#define ZBX_EVALWINDOW_MIN	2
+#define ZBX_EVALWINDOW_MAX	3
+#define ZBX_EVALWINDOW_COUNT	4
+
+int	zbx_evalwindow_aggregate(int func, zbx_uint64_t itemid, unsigned char value_type, int seconds,
+		int time_shift, const zbx_timespec_t *ts, zbx_history_value_t *value, int *values_num);
+
+#endif
@@ -20,6 +20,7 @@
 #include "expression.h"
 #include "zbxserver.h"
 #include "evalfunc.h"
+#include "evalfunc_common.h"
 
 #include "log.h"
 #include "zbxregexp.h"
@@ -5476,13 +5477,49 @@ static void	func_clean(void *ptr)
 	zbx_variant_clear(&func->value);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: normalize function parameters by removing whitespace ignored by   *
+ *          parameter parser                                                  *
+ *                                                                            *
+ * Parameters: parameter - [IN] function parameters                           *
+ *             out       - [IN/OUT] normalized parameters                     *
+ *             out_alloc - [IN/OUT] size of normalized parameters buffer      *
+ *                                                                            *
+ * Comments: Leading whitespace of parameters and trailing whitespace of      *
+ *           quoted parameters is removed, so the same function referenced by *
+ *           different triggers with differently formatted parameters, for    *
+ *           example "$,5m" and "$, 5m", is evaluated only once.              *
+ *                                                                            *
+ ******************************************************************************/
+static void	func_normalize_parameter(const char *parameter, char **out, size_t *out_alloc)
+{
+	size_t		out_offset = 0, param_pos, param_len, sep_pos;
+	const char	*ptr = parameter;
+
+	while (1)
+	{
+		zbx_function_param_parse(ptr, &param_pos, &param_len, &sep_pos);
+		zbx_strncpy_alloc(out, out_alloc, &out_offset, ptr + param_pos, param_len);
+
+		if (',' != ptr[sep_pos])
+			break;
+
+		zbx_chrcpy_alloc(out, out_alloc, &out_offset, ',');
+		ptr += sep_pos + 1;
+	}
+
+	/* keep anything following the last parsed parameter to avoid matching malformed parameters */
+	zbx_strcpy_alloc(out, out_alloc, &out_offset, ptr + sep_pos);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: prepare hashset of functions to evaluate                          *
  *                                                                            *
  * Parameters: functionids - [IN] function identifiers                        *
  *             funcs       - [OUT] functions indexed by itemid, name,         *
- *                                 parameter, timestamp                       *
+ *                                 normalized parameter, timestamp            *
  *             ifuncs      - [OUT] function index by functionid               *
  *             trigger     - [IN] vector of triggers, sorted by triggerid     *
  *                                                                            *
@@ -5496,6 +5533,8 @@ static void	zbx_populate_function_items(const zbx_vector_uint64_t *functionids,
 	int			*errcodes = NULL;
 	zbx_ifunc_t		ifunc_local;
 	zbx_func_t		*func, func_local;
+	char			*parameter = NULL;
+	size_t			parameter_alloc = 0;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() functionids_num:%d", __func__, functionids->values_num);
 
@@ -5527,8 +5566,10 @@ static void	zbx_populate_function_items(const zbx_vector_uint64_t *functionids,
 			func_local.timespec.ns = 0;
 		}
 
+		func_normalize_parameter(functions[i].parameter, &parameter, &parameter_alloc);
+
 		func_local.function = functions[i].function;
-		func_local.parameter = functions[i].parameter;
+		func_local.parameter = parameter;
 
 		if (NULL == (func = (zbx_func_t *)zbx_hashset_search(funcs, &func_local)))
 		{
@@ -5546,10 +5587,117 @@ static void	zbx_populate_function_items(const zbx_vector_uint64_t *functionids,
 
 	zbx_dc_config_clean_functions(functions, errcodes, functionids->values_num);
 
+	zbx_free(parameter);
 	zbx_free(errcodes);
 	zbx_free(functions);
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() ifuncs_num:%d", __func__, ifuncs->num_data);
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() ifuncs_num:%d funcs_num:%d", __func__, ifuncs->num_data,
+			funcs->num_data);
+}
+
+static int	vc_prefetch_compare(const void *d1, const void *d2)
+{
+	const zbx_vc_prefetch_t	*r1 = (const zbx_vc_prefetch_t *)d1;
+	const zbx_vc_prefetch_t	*r2 = (const zbx_vc_prefetch_t *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(r1->itemid, r2->itemid);
+
+	return r1->range_start - r2->range_start;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: caches history of items used by time based history functions      *
+ *          with batched reads before the functions are evaluated             *
+ *                                                                            *
+ * Parameters: funcs            - [IN] the functions to evaluate              *
+ *             history_itemids  - [IN] the sorted identifiers of items        *
+ *                                     retrieved when saving history          *
+ *             history_items    - [IN] the items retrieved when saving history*
+ *             history_errcodes - [IN] the item retrieval error codes         *
+ *             itemids          - [IN] the sorted identifiers of other items  *
+ *             items            - [IN] the other items                        *
+ *             items_err        - [IN] the other item retrieval error codes   *
+ *                                                                            *
+ * Comments: Only functions with a time based range in the first parameter    *
+ *           are prefetched, count based ranges are left to the value cache.  *
+ *                                                                            *
+ ******************************************************************************/
+static void	prefetch_item_values(zbx_hashset_t *funcs, const zbx_vector_uint64_t *history_itemids,
+		const zbx_history_sync_item_t *history_items, const int *history_errcodes,
+		const zbx_vector_uint64_t *itemids, zbx_history_sync_item_t * const *items, int * const *items_err)
+{
+	zbx_hashset_iter_t	iter;
+	zbx_func_t		*func;
+	zbx_vc_prefetch_t	*requests;
+	int			i, requests_num = 0;
+
+	requests = (zbx_vc_prefetch_t *)zbx_malloc(NULL, sizeof(zbx_vc_prefetch_t) * (size_t)funcs->num_data);
+
+	zbx_hashset_iter_reset(funcs, &iter);
+	while (NULL != (func = (zbx_func_t *)zbx_hashset_iter_next(&iter)))
+	{
+		const zbx_history_sync_item_t	*item;
+		int				errcode, value, timeshift, range_start;
+		zbx_value_type_t		type;
+
+		if (ZBX_FUNCTION_TYPE_HISTORY != func->type || NULL != strchr(func->parameter, '{'))
+			continue;
+
+		if (FAIL != (i = zbx_vector_uint64_bsearch(history_itemids, func->itemid,
+				ZBX_DEFAULT_UINT64_COMPARE_FUNC)))
+		{
+			item = history_items + i;
+			errcode = history_errcodes[i];
+		}
+		else
+		{
+			i = zbx_vector_uint64_bsearch(itemids, func->itemid, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+			item = *items + i;
+			errcode = (*items_err)[i];
+		}
+
+		if (SUCCEED != errcode || ITEM_VALUE_TYPE_BIN == item->value_type ||
+				ITEM_STATUS_ACTIVE != item->status || 0 == item->history ||
+				HOST_STATUS_MONITORED != item->host.status)
+		{
+			continue;
+		}
+
+		if (SUCCEED != get_function_parameter_hist_range(func->timespec.sec, func->parameter, 1, &value,
+				&type, &timeshift) || ZBX_VALUE_SECONDS != type || 0 >= value)
+		{
+			continue;
+		}
+
+		if (0 >= (range_start = func->timespec.sec - timeshift - value))
+			continue;
+
+		requests[requests_num].itemid = item->itemid;
+		requests[requests_num].value_type = item->value_type;
+		requests[requests_num++].range_start = range_start;
+	}
+
+	if (1 < requests_num)
+	{
+		int	j;
+
+		/* merge requests for the same item keeping the widest range */
+		qsort(requests, (size_t)requests_num, sizeof(zbx_vc_prefetch_t), vc_prefetch_compare);
+
+		for (i = 0, j = 1; j < requests_num; j++)
+		{
+			if (requests[i].itemid != requests[j].itemid)
+				requests[++i] = requests[j];
+		}
+
+		requests_num = i + 1;
+	}
+
+	if (1 < requests_num)
+		zbx_vc_prefetch_values(requests, requests_num);
+
+	zbx_free(requests);
 }
 
 static void	zbx_evaluate_item_functions(zbx_hashset_t *funcs, const zbx_vector_uint64_t *history_itemids,
@@ -5587,6 +5735,8 @@ static void	zbx_evaluate_item_functions(zbx_hashset_t *funcs, const zbx_vector_u
 				(size_t)itemids.values_num, ZBX_ITEM_GET_SYNC);
 	}
 
+	prefetch_item_values(funcs, history_itemids, history_items, history_errcodes, &itemids, items, items_err);
+
 	zbx_hashset_iter_reset(funcs, &iter);
 	while (NULL != (func = (zbx_func_t *)zbx_hashset_iter_next(&iter)))
 	{
@@ -59,6 +59,11 @@
  *                                                                            *
  * (*) free chunks are stored in doubly-linked lists according to their sizes *
  *                                                                            *
+ *     chunks smaller than SHMEM_MAX_BUCKET_SIZE are kept in buckets of exact *
+ *     size, larger chunks - in buckets of sizes from 2^n up to 2^(n+1) - 1,  *
+ *     so any chunk from a bucket above the requested size is big enough and  *
+ *     the smallest such chunk is used, which keeps large chunks unsplit      *
+ *                                                                            *
  *     a typical situation is thus as follows (1 used chunk, 2 free chunks)   *
  *                                                                            *
  *  +--------------------------- shared memory ----------------------------+  *
@@ -108,6 +113,8 @@ static void	*__mem_malloc(zbx_shmem_info_t *info, zbx_uint64_t size);
 static void	*__mem_realloc(zbx_shmem_info_t *info, void *old, zbx_uint64_t size);
 static void	__mem_free(zbx_shmem_info_t *info, void *ptr);
 
+static int	mem_shmget(zbx_uint64_t size, const char *descr);
+
 #define SHMEM_SIZE_FIELD	sizeof(zbx_uint64_t)
 
 #define SHMEM_FLG_USED		((__UINT64_C(1))<<63)
@@ -118,6 +125,8 @@ static void	__mem_free(zbx_shmem_info_t *info, void *ptr);
 #define SHMEM_MIN_SIZE		__UINT64_C(128)
 #define SHMEM_MAX_SIZE		__UINT64_C(0x1000000000)	/* 64 GB */
 
+static int	shmem_huge_pages = 0;
+
 /* helper functions */
 
 static void	*ALIGN4(void *ptr)
@@ -149,11 +158,20 @@ static zbx_uint64_t	mem_proper_alloc_size(zbx_uint64_t size)
 
 static int	mem_bucket_by_size(zbx_uint64_t size)
 {
+	int		index;
+	zbx_uint64_t	limit;
+
 	if (size < ZBX_SHMEM_MIN_BUCKET_SIZE)
 		return 0;
 	if (size < SHMEM_MAX_BUCKET_SIZE)
 		return (size - ZBX_SHMEM_MIN_BUCKET_SIZE) >> 3;
-	return ZBX_SHMEM_BUCKET_COUNT - 1;
+
+	index = ZBX_SHMEM_EXACT_BUCKET_COUNT;
+
+	for (limit = SHMEM_MAX_BUCKET_SIZE << 1; limit <= size && index < ZBX_SHMEM_BUCKET_COUNT - 1; limit <<= 1)
+		index++;
+
+	return index;
 }
 
 static void	mem_set_chunk_size(void *chunk, zbx_uint64_t size)
@@ -236,28 +254,24 @@ static void	mem_unlink_chunk(zbx_shmem_info_t *info, void *chunk)
 
 static void	*__mem_malloc(zbx_shmem_info_t *info, zbx_uint64_t size)
 {
-	int		index;
+	int		index, counter = 0;
 	void		*chunk;
-	zbx_uint64_t	chunk_size;
+	zbx_uint64_t	chunk_size, skip_min = __UINT64_C(0xffffffffffffffff), skip_max = __UINT64_C(0);
 
 	size = mem_proper_alloc_size(size);
 
 	/* try to find an appropriate chunk in special buckets */
 
-	index = mem_bucket_by_size(size);
-
-	while (index < ZBX_SHMEM_BUCKET_COUNT - 1 && NULL == info->buckets[index])
-		index++;
-
-	chunk = info->buckets[index];
-
-	if (index == ZBX_SHMEM_BUCKET_COUNT - 1)
+	for (index = mem_bucket_by_size(size), chunk = NULL; index < ZBX_SHMEM_BUCKET_COUNT; index++)
 	{
-		/* otherwise, find a chunk big enough according to first-fit strategy */
+		if (NULL == (chunk = info->buckets[index]))
+			continue;
 
-		int		counter = 0;
-		zbx_uint64_t	skip_min = __UINT64_C(0xffffffffffffffff), skip_max = __UINT64_C(0);
+		/* all chunks in bucket are big enough */
+		if (zbx_shmem_bucket_size(index) >= size)
+			break;
 
+		/* otherwise, find a chunk big enough according to first-fit strategy */
 		while (NULL != chunk && CHUNK_SIZE(chunk) < size)
 		{
 			counter++;
@@ -266,21 +280,24 @@ static void	*__mem_malloc(zbx_shmem_info_t *info, zbx_uint64_t size)
 			chunk = mem_get_next_chunk(chunk);
 		}
 
-		/* don't log errors if malloc can return null in low memory situations */
-		if (0 == info->allow_oom)
+		if (NULL != chunk)
+			break;
+	}
+
+	/* don't log errors if malloc can return null in low memory situations */
+	if (0 == info->allow_oom)
+	{
+		if (NULL == chunk)
 		{
-			if (NULL == chunk)
-			{
-				zabbix_log(LOG_LEVEL_CRIT, "__mem_malloc: skipped %d asked " ZBX_FS_UI64 " skip_min "
-						ZBX_FS_UI64 " skip_max " ZBX_FS_UI64,
-						counter, size, skip_min, skip_max);
-			}
-			else if (counter >= 100)
-			{
-				zabbix_log(LOG_LEVEL_DEBUG, "__mem_malloc: skipped %d asked " ZBX_FS_UI64 " skip_min "
-						ZBX_FS_UI64 " skip_max " ZBX_FS_UI64 " size " ZBX_FS_UI64, counter,
-						size, skip_min, skip_max, CHUNK_SIZE(chunk));
-			}
+			zabbix_log(LOG_LEVEL_CRIT, "__mem_malloc: skipped %d asked " ZBX_FS_UI64 " skip_min "
+					ZBX_FS_UI64 " skip_max " ZBX_FS_UI64,
+					counter, size, skip_min, skip_max);
+		}
+		else if (counter >= 100)
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "__mem_malloc: skipped %d asked " ZBX_FS_UI64 " skip_min "
+					ZBX_FS_UI64 " skip_max " ZBX_FS_UI64 " size " ZBX_FS_UI64, counter,
+					size, skip_min, skip_max, CHUNK_SIZE(chunk));
 		}
 	}
 
@@ -524,8 +541,60 @@ static void	__mem_free(zbx_shmem_info_t *info, void *ptr)
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get private shared memory segment, backed by huge pages if they   *
+ *          are enabled and available                                         *
+ *                                                                            *
+ * Parameters: size  - [IN] segment size in bytes                             *
+ *             descr - [IN] segment description for log messages              *
+ *                                                                            *
+ * Return value: shared memory identifier or -1 on error                      *
+ *                                                                            *
+ * Comments: Huge pages are a limited resource reserved by administrator, so  *
+ *           segment falls back to normal pages if they cannot be used.       *
+ *                                                                            *
+ ******************************************************************************/
+static int	mem_shmget(zbx_uint64_t size, const char *descr)
+{
+#ifdef SHM_HUGETLB
+	int	shm_id;
+
+	if (0 != shmem_huge_pages)
+	{
+		if (-1 != (shm_id = shmget(IPC_PRIVATE, size, 0600 | SHM_HUGETLB)))
+			return shm_id;
+
+		zabbix_log(LOG_LEVEL_WARNING, "cannot get huge pages of size " ZBX_FS_UI64 " for %s: %s, using"
+				" normal pages", size, descr, zbx_strerror(errno));
+	}
+#else
+	ZBX_UNUSED(descr);
+#endif
+	return shmget(IPC_PRIVATE, size, 0600);
+}
+
 /* public memory interface */
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: enable backing of shared memory created afterwards by huge pages  *
+ *                                                                            *
+ * Parameters: enable - [IN] 1 - use huge pages, 0 - use normal pages         *
+ *                                                                            *
+ * Comments: Huge pages reduce TLB misses on large caches. They are supported *
+ *           on Linux only, elsewhere the setting is ignored.                 *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_shmem_set_huge_pages(int enable)
+{
+#ifndef SHM_HUGETLB
+	if (0 != enable)
+		zabbix_log(LOG_LEVEL_WARNING, "huge pages are not supported on this platform");
+#endif
+	shmem_huge_pages = enable;
+}
+
 int	zbx_shmem_create(zbx_shmem_info_t **info, zbx_uint64_t size, const char *descr, const char *param,
 		int allow_oom, char **error)
 {
@@ -553,7 +622,7 @@ int	zbx_shmem_create(zbx_shmem_info_t **info, zbx_uint64_t size, const char *des
 		goto out;
 	}
 
-	if (-1 == (shm_id = shmget(IPC_PRIVATE, size, 0600)))
+	if (-1 == (shm_id = mem_shmget(size, descr)))
 	{
 		*error = zbx_dsprintf(*error, "cannot get private shared memory of size " ZBX_FS_SIZE_T " for %s: %s",
 				(zbx_fs_size_t)size, descr, zbx_strerror(errno));
@@ -814,8 +883,8 @@ void	zbx_shmem_dump_stats(int level, zbx_shmem_info_t *info)
 		if (0 == stats.chunks_num[i])
 			continue;
 
-		zabbix_log(level, "free chunks of size %2s %3d bytes: %8u", i == ZBX_SHMEM_BUCKET_COUNT - 1 ? ">=" : "",
-			ZBX_SHMEM_MIN_BUCKET_SIZE + 8 * i, stats.chunks_num[i]);
+		zabbix_log(level, "free chunks of size %2s %10llu bytes: %8u", i >= ZBX_SHMEM_EXACT_BUCKET_COUNT ?
+				">=" : "", (unsigned long long)zbx_shmem_bucket_size(i), stats.chunks_num[i]);
 	}
 
 	zabbix_log(level, "min chunk size: %10llu bytes", (unsigned long long)stats.min_chunk_size);
@@ -869,3 +938,18 @@ zbx_uint64_t	zbx_shmem_required_chunk_size(zbx_uint64_t size)
 
 	return mem_proper_alloc_size(size) + SHMEM_SIZE_FIELD * 2;
 }
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get the smallest size of free chunks kept in the bucket           *
+ *                                                                            *
+ * Parameters: index - [IN] bucket index                                      *
+ *                                                                            *
+ ******************************************************************************/
+zbx_uint64_t	zbx_shmem_bucket_size(int index)
+{
+	if (index < ZBX_SHMEM_EXACT_BUCKET_COUNT)
+		return ZBX_SHMEM_MIN_BUCKET_SIZE + 8 * index;
+
+	return (zbx_uint64_t)SHMEM_MAX_BUCKET_SIZE << (index - ZBX_SHMEM_EXACT_BUCKET_COUNT);
+}
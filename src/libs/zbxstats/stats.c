@@ -218,6 +218,20 @@ void	zbx_zabbix_stats_get(struct zbx_json *json, int config_startup_time)
 		zbx_json_close(json);
 	}
 
+	if (0 != wcache_info.ingest_total)
+	{
+		zbx_json_addobject(json, "ingest");
+		zbx_json_addfloat(json, "pfree", 100 * (double)wcache_info.ingest_free /
+				(double)wcache_info.ingest_total);
+		zbx_json_adduint64(json, "free", wcache_info.ingest_free);
+		zbx_json_adduint64(json, "total", wcache_info.ingest_total);
+		zbx_json_adduint64(json, "used", wcache_info.ingest_total - wcache_info.ingest_free);
+		zbx_json_addfloat(json, "pused", 100 * (double)(wcache_info.ingest_total - wcache_info.ingest_free) /
+				(double)wcache_info.ingest_total);
+		zbx_json_adduint64(json, "overflows", wcache_info.ingest_overflows);
+		zbx_json_close(json);
+	}
+
 	zbx_json_close(json);
 
 	for (i = 0; i < stats_ext_funcs.values_num; i++)
@@ -694,51 +694,73 @@ err:
 	return ret;
 }
 
-static int	vfs_file_cksum_md5(char *filename, AGENT_RESULT *result)
+#define ZBX_CKSUM_BUF_SIZE	(256 * ZBX_KIBIBYTE)
+
+#define ZBX_CKSUM_CRC32		0
+#define ZBX_CKSUM_MD5		1
+#define ZBX_CKSUM_SHA256	2
+
+static int	vfs_file_cksum_ext(const char *filename, int method, AGENT_RESULT *result);
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: read next chunk of file being checksummed                         *
+ *                                                                            *
+ * Parameters: f      - [IN] the file descriptor                              *
+ *             buf    - [OUT] the data read                                   *
+ *             ts     - [IN] the check start time                             *
+ *             result - [OUT] the error message                               *
+ *                                                                            *
+ * Return value: the number of bytes read, 0 at the end of file or -1 on      *
+ *               error or timeout                                             *
+ *                                                                            *
+ ******************************************************************************/
+static ssize_t	vfs_file_cksum_read(int f, u_char **buf, double ts, AGENT_RESULT *result)
 {
-	int		i, nbytes, f, ret = SYSINFO_RET_FAIL;
-	md5_state_t	state;
-	u_char		buf[16 * ZBX_KIBIBYTE];
-	char		*hash_text = NULL;
-	size_t		sz;
-	md5_byte_t	hash[ZBX_MD5_DIGEST_SIZE];
-	double		ts;
+	static u_char	*cksum_buf = NULL;
+	ssize_t		nr;
 
-	ts = zbx_time();
+	/* the buffer is large enough to keep the number of read() calls low on large files */
+	if (NULL == cksum_buf)
+		cksum_buf = (u_char *)zbx_malloc(NULL, ZBX_CKSUM_BUF_SIZE);
 
-	if (-1 == (f = zbx_open(filename, O_RDONLY)))
+	if (sysinfo_get_config_timeout() < zbx_time() - ts)
 	{
-		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot open file: %s", zbx_strerror(errno)));
-		goto err;
+		SET_MSG_RESULT(result, zbx_strdup(NULL, "Timeout while processing item."));
+		return -1;
 	}
 
-	if (sysinfo_get_config_timeout() < zbx_time() - ts)
+	if (-1 == (nr = read(f, cksum_buf, ZBX_CKSUM_BUF_SIZE)))
 	{
-		SET_MSG_RESULT(result, zbx_strdup(NULL, "Timeout while processing item."));
-		goto err;
+		SET_MSG_RESULT(result, zbx_strdup(NULL, "Cannot read from file."));
+		return -1;
 	}
 
+	*buf = cksum_buf;
+
+	return nr;
+}
+
+static int	vfs_file_cksum_md5(int f, double ts, AGENT_RESULT *result)
+{
+	int		i;
+	ssize_t		nr;
+	md5_state_t	state;
+	u_char		*buf;
+	char		*hash_text = NULL;
+	size_t		sz;
+	md5_byte_t	hash[ZBX_MD5_DIGEST_SIZE];
+
 	zbx_md5_init(&state);
 
-	while (0 < (nbytes = (int)read(f, buf, sizeof(buf))))
-	{
-		if (sysinfo_get_config_timeout() < zbx_time() - ts)
-		{
-			SET_MSG_RESULT(result, zbx_strdup(NULL, "Timeout while processing item."));
-			goto err;
-		}
+	while (0 < (nr = vfs_file_cksum_read(f, &buf, ts, result)))
+		zbx_md5_append(&state, (const md5_byte_t *)buf, (int)nr);
 
-		zbx_md5_append(&state, (const md5_byte_t *)buf, nbytes);
-	}
+	if (0 > nr)
+		return SYSINFO_RET_FAIL;
 
 	zbx_md5_finish(&state, hash);
 
-	if (0 > nbytes)
-	{
-		SET_MSG_RESULT(result, zbx_strdup(NULL, "Cannot read from file."));
-		goto err;
-	}
-
 	/* convert MD5 hash to text form */
 
 	sz = ZBX_MD5_DIGEST_SIZE * 2 + 1;
@@ -749,12 +771,7 @@ static int	vfs_file_cksum_md5(char *filename, AGENT_RESULT *result)
 
 	SET_STR_RESULT(result, hash_text);
 
-	ret = SYSINFO_RET_OK;
-err:
-	if (-1 != f)
-		close(f);
-
-	return ret;
+	return SYSINFO_RET_OK;
 }
 
 int	vfs_file_md5sum(AGENT_REQUEST *request, AGENT_RESULT *result)
@@ -775,7 +792,7 @@ int	vfs_file_md5sum(AGENT_REQUEST *request, AGENT_RESULT *result)
 		return SYSINFO_RET_FAIL;
 	}
 
-	return vfs_file_cksum_md5(filename, result);
+	return vfs_file_cksum_ext(filename, ZBX_CKSUM_MD5, result);
 }
 
 static u_long	crctab[] =
@@ -834,50 +851,70 @@ static u_long	crctab[] =
 	0xa2f33668, 0xbcb4666d, 0xb8757bda, 0xb5365d03, 0xb1f740b4
 };
 
-static int	vfs_file_cksum_crc32(char *filename, AGENT_RESULT *result)
+/* crctab extended for processing 8 bytes per step (slice-by-8) */
+static zbx_uint32_t	crctab8[8][256];
+
+static void	crctab8_init(void)
 {
-	int		i, nr, f, ret = SYSINFO_RET_FAIL;
-	zbx_uint32_t	crc, flen;
-	u_char		buf[16 * ZBX_KIBIBYTE];
-	u_long		cval;
-	double		ts;
+	int	i, k;
 
-	ts = zbx_time();
+	for (i = 0; i < 256; i++)
+		crctab8[0][i] = (zbx_uint32_t)crctab[i];
 
-	if (-1 == (f = zbx_open(filename, O_RDONLY)))
+	for (k = 1; k < 8; k++)
 	{
-		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot open file: %s", zbx_strerror(errno)));
-		goto err;
-	}
+		for (i = 0; i < 256; i++)
+		{
+			zbx_uint32_t	crc = crctab8[k - 1][i];
 
-	if (sysinfo_get_config_timeout() < zbx_time() - ts)
-	{
-		SET_MSG_RESULT(result, zbx_strdup(NULL, "Timeout while processing item."));
-		goto err;
+			crctab8[k][i] = (crc << 8) ^ crctab8[0][crc >> 24];
+		}
 	}
+}
 
-	crc = flen = 0;
+static zbx_uint32_t	crc32_update(zbx_uint32_t crc, const u_char *buf, size_t len)
+{
+	static int	crctab8_ready = 0;
 
-	while (0 < (nr = (int)read(f, buf, sizeof(buf))))
+	if (0 == crctab8_ready)
 	{
-		if (sysinfo_get_config_timeout() < zbx_time() - ts)
-		{
-			SET_MSG_RESULT(result, zbx_strdup(NULL, "Timeout while processing item."));
-			goto err;
-		}
+		crctab8_init();
+		crctab8_ready = 1;
+	}
 
-		flen += nr;
+	for (; 8 <= len; buf += 8, len -= 8)
+	{
+		crc ^= (zbx_uint32_t)buf[0] << 24 | (zbx_uint32_t)buf[1] << 16 | (zbx_uint32_t)buf[2] << 8 | buf[3];
 
-		for (i = 0; i < nr; i++)
-			crc = (crc << 8) ^ crctab[((crc >> 24) ^ buf[i]) & 0xff];
+		crc = crctab8[7][crc >> 24] ^ crctab8[6][(crc >> 16) & 0xff] ^ crctab8[5][(crc >> 8) & 0xff] ^
+				crctab8[4][crc & 0xff] ^ crctab8[3][buf[4]] ^ crctab8[2][buf[5]] ^
+				crctab8[1][buf[6]] ^ crctab8[0][buf[7]];
 	}
 
-	if (0 > nr)
+	for (; 0 < len; buf++, len--)
+		crc = (crc << 8) ^ crctab8[0][((crc >> 24) ^ *buf) & 0xff];
+
+	return crc;
+}
+
+static int	vfs_file_cksum_crc32(int f, double ts, AGENT_RESULT *result)
+{
+	ssize_t		nr;
+	zbx_uint32_t	crc, flen;
+	u_char		*buf;
+	u_long		cval;
+
+	crc = flen = 0;
+
+	while (0 < (nr = vfs_file_cksum_read(f, &buf, ts, result)))
 	{
-		SET_MSG_RESULT(result, zbx_strdup(NULL, "Cannot read from file."));
-		goto err;
+		flen += (zbx_uint32_t)nr;
+		crc = crc32_update(crc, buf, (size_t)nr);
 	}
 
+	if (0 > nr)
+		return SYSINFO_RET_FAIL;
+
 	/* include the length of the file */
 	for (; 0 != flen; flen >>= 8)
 		crc = (crc << 8) ^ crctab[((crc >> 24) ^ flen) & 0xff];
@@ -886,23 +923,185 @@ static int	vfs_file_cksum_crc32(char *filename, AGENT_RESULT *result)
 
 	SET_UI64_RESULT(result, cval);
 
-	ret = SYSINFO_RET_OK;
-err:
-	if (-1 != f)
-		close(f);
-
-	return ret;
+	return SYSINFO_RET_OK;
 }
 
-static int	vfs_file_cksum_sha256(char *filename, AGENT_RESULT *result)
+static int	vfs_file_cksum_sha256(int f, double ts, AGENT_RESULT *result)
 {
-	int		i, f, ret = SYSINFO_RET_FAIL;
-	char		buf[16 * ZBX_KIBIBYTE];
+	int		i;
+	u_char		*buf;
 	char		hash_res[ZBX_SHA256_DIGEST_SIZE], hash_res_stringhexes[ZBX_SHA256_DIGEST_SIZE * 2 + 1];
-	double		ts;
 	ssize_t		nr;
 	sha256_ctx	ctx;
 
+	zbx_sha256_init(&ctx);
+
+	while (0 < (nr = vfs_file_cksum_read(f, &buf, ts, result)))
+		zbx_sha256_process_bytes(buf, (size_t)nr, &ctx);
+
+	if (0 > nr)
+		return SYSINFO_RET_FAIL;
+
+	zbx_sha256_finish(&ctx, hash_res);
+
+	for (i = 0 ; i < ZBX_SHA256_DIGEST_SIZE; i++)
+	{
+		char z[3];
+
+		zbx_snprintf(z, 3, "%02x", (unsigned char)hash_res[i]);
+		hash_res_stringhexes[i * 2] = z[0];
+		hash_res_stringhexes[i * 2 + 1] = z[1];
+	}
+
+	hash_res_stringhexes[ZBX_SHA256_DIGEST_SIZE * 2] = '\0';
+
+	SET_STR_RESULT(result, zbx_strdup(NULL, hash_res_stringhexes));
+
+	return SYSINFO_RET_OK;
+}
+
+#if !defined(_WINDOWS) && !defined(__MINGW32__)
+/* the maximum number of cached checksums, the cache is reset when it is full */
+#define ZBX_CKSUM_CACHE_MAX	1000
+
+typedef struct
+{
+	zbx_uint64_t	dev;
+	zbx_uint64_t	ino;
+	int		method;
+	zbx_uint64_t	size;
+	time_t		mtime;
+	time_t		ctime;
+	time_t		calculated;
+	zbx_uint64_t	ui64;
+	char		*str;
+}
+zbx_cksum_cache_t;
+
+static zbx_hashset_t	cksum_cache;
+static int		cksum_cache_init = 0;
+
+static zbx_hash_t	cksum_cache_hash(const void *data)
+{
+	const zbx_cksum_cache_t	*cksum = (const zbx_cksum_cache_t *)data;
+	zbx_hash_t		hash;
+
+	hash = ZBX_DEFAULT_UINT64_HASH_ALGO(&cksum->dev, sizeof(cksum->dev), ZBX_DEFAULT_HASH_SEED);
+	hash = ZBX_DEFAULT_UINT64_HASH_ALGO(&cksum->ino, sizeof(cksum->ino), hash);
+
+	return ZBX_DEFAULT_UINT64_HASH_ALGO(&cksum->method, sizeof(cksum->method), hash);
+}
+
+static int	cksum_cache_compare(const void *d1, const void *d2)
+{
+	const zbx_cksum_cache_t	*c1 = (const zbx_cksum_cache_t *)d1;
+	const zbx_cksum_cache_t	*c2 = (const zbx_cksum_cache_t *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(c1->dev, c2->dev);
+	ZBX_RETURN_IF_NOT_EQUAL(c1->ino, c2->ino);
+	ZBX_RETURN_IF_NOT_EQUAL(c1->method, c2->method);
+
+	return 0;
+}
+
+static void	cksum_cache_clean(void *data)
+{
+	zbx_free(((zbx_cksum_cache_t *)data)->str);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get checksum of unchanged file from cache                         *
+ *                                                                            *
+ * Comments: Checksum is reused only if the file has the same size, mtime and *
+ *           ctime as when it was calculated and was last changed before the  *
+ *           second the checksum was calculated in, so that changes within    *
+ *           the same second are not missed.                                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	cksum_cache_get(const zbx_stat_t *st, int method, AGENT_RESULT *result)
+{
+	zbx_cksum_cache_t	local, *cksum;
+
+	if (0 == cksum_cache_init)
+		return FAIL;
+
+	local.dev = (zbx_uint64_t)st->st_dev;
+	local.ino = (zbx_uint64_t)st->st_ino;
+	local.method = method;
+
+	if (NULL == (cksum = (zbx_cksum_cache_t *)zbx_hashset_search(&cksum_cache, &local)))
+		return FAIL;
+
+	if (cksum->size != (zbx_uint64_t)st->st_size || cksum->mtime != st->st_mtime ||
+			cksum->ctime != st->st_ctime || cksum->calculated <= st->st_ctime)
+	{
+		return FAIL;
+	}
+
+	if (NULL != cksum->str)
+		SET_STR_RESULT(result, zbx_strdup(NULL, cksum->str));
+	else
+		SET_UI64_RESULT(result, cksum->ui64);
+
+	return SUCCEED;
+}
+
+static void	cksum_cache_set(const zbx_stat_t *st, int method, time_t calculated, AGENT_RESULT *result)
+{
+	zbx_cksum_cache_t	local, *cksum;
+
+	if (0 == cksum_cache_init)
+	{
+		zbx_hashset_create_ext(&cksum_cache, 100, cksum_cache_hash, cksum_cache_compare, cksum_cache_clean,
+				ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
+		cksum_cache_init = 1;
+	}
+
+	local.dev = (zbx_uint64_t)st->st_dev;
+	local.ino = (zbx_uint64_t)st->st_ino;
+	local.method = method;
+
+	if (NULL == (cksum = (zbx_cksum_cache_t *)zbx_hashset_search(&cksum_cache, &local)))
+	{
+		if (ZBX_CKSUM_CACHE_MAX <= cksum_cache.num_data)
+			zbx_hashset_clear(&cksum_cache);
+
+		local.str = NULL;
+		cksum = (zbx_cksum_cache_t *)zbx_hashset_insert(&cksum_cache, &local, sizeof(local));
+	}
+
+	cksum->size = (zbx_uint64_t)st->st_size;
+	cksum->mtime = st->st_mtime;
+	cksum->ctime = st->st_ctime;
+	cksum->calculated = calculated;
+
+	if (ZBX_ISSET_STR(result))
+	{
+		cksum->str = zbx_strdup(cksum->str, result->str);
+	}
+	else
+	{
+		zbx_free(cksum->str);
+		cksum->ui64 = result->ui64;
+	}
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: calculate file checksum, reusing checksum of unchanged file       *
+ *                                                                            *
+ ******************************************************************************/
+static int	vfs_file_cksum_ext(const char *filename, int method, AGENT_RESULT *result)
+{
+	int		f, ret = SYSINFO_RET_FAIL;
+	double		ts;
+#if !defined(_WINDOWS) && !defined(__MINGW32__)
+	zbx_stat_t	st;
+	time_t		now;
+#endif
+
 	ts = zbx_time();
 
 	if (-1 == (f = zbx_open(filename, O_RDONLY)))
@@ -917,41 +1116,48 @@ static int	vfs_file_cksum_sha256(char *filename, AGENT_RESULT *result)
 		goto err;
 	}
 
-	zbx_sha256_init(&ctx);
-
-	while (0 < (nr = read(f, buf, sizeof(buf))))
+#if !defined(_WINDOWS) && !defined(__MINGW32__)
+	/* take the file state before reading, so that changes made while reading invalidate the checksum */
+	if (0 != zbx_fstat(f, &st))
 	{
-		if (sysinfo_get_config_timeout() < zbx_time() - ts)
-		{
-			SET_MSG_RESULT(result, zbx_strdup(NULL, "Timeout while processing item."));
-			goto err;
-		}
-
-		zbx_sha256_process_bytes(buf, (size_t)nr, &ctx);
+		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot obtain file information: %s",
+				zbx_strerror(errno)));
+		goto err;
 	}
 
-	if (0 > nr)
+	if (SUCCEED == cksum_cache_get(&st, method, result))
 	{
-		SET_MSG_RESULT(result, zbx_strdup(NULL, "Cannot read from file."));
+		ret = SYSINFO_RET_OK;
 		goto err;
 	}
 
-	zbx_sha256_finish(&ctx, hash_res);
+	now = time(NULL);
+#endif
 
-	for (i = 0 ; i < ZBX_SHA256_DIGEST_SIZE; i++)
-	{
-		char z[3];
+#ifdef POSIX_FADV_SEQUENTIAL
+	(void)posix_fadvise(f, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
 
-		zbx_snprintf(z, 3, "%02x", (unsigned char)hash_res[i]);
-		hash_res_stringhexes[i * 2] = z[0];
-		hash_res_stringhexes[i * 2 + 1] = z[1];
+	switch (method)
+	{
+		case ZBX_CKSUM_CRC32:
+			ret = vfs_file_cksum_crc32(f, ts, result);
+			break;
+		case ZBX_CKSUM_MD5:
+			ret = vfs_file_cksum_md5(f, ts, result);
+			break;
+		case ZBX_CKSUM_SHA256:
+			ret = vfs_file_cksum_sha256(f, ts, result);
+			break;
+		default:
+			THIS_SHOULD_NEVER_HAPPEN;
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid checksum method."));
 	}
 
-	hash_res_stringhexes[ZBX_SHA256_DIGEST_SIZE * 2] = '\0';
-
-	SET_STR_RESULT(result, zbx_strdup(NULL, hash_res_stringhexes));
-
-	ret = SYSINFO_RET_OK;
+#if !defined(_WINDOWS) && !defined(__MINGW32__)
+	if (SYSINFO_RET_OK == ret)
+		cksum_cache_set(&st, method, now, result);
+#endif
 err:
 	if (-1 != f)
 		close(f);
@@ -985,11 +1191,11 @@ int	vfs_file_cksum(AGENT_REQUEST *request, AGENT_RESULT *result)
 	}
 
 	if (NULL == method || '\0' == *method || 0 == strcmp(method, "crc32"))
-		ret = vfs_file_cksum_crc32(filename, result);
+		ret = vfs_file_cksum_ext(filename, ZBX_CKSUM_CRC32, result);
 	else if (0 == strcmp(method, "md5"))
-		ret = vfs_file_cksum_md5(filename, result);
+		ret = vfs_file_cksum_ext(filename, ZBX_CKSUM_MD5, result);
 	else if (0 == strcmp(method, "sha256"))
-		ret = vfs_file_cksum_sha256(filename, result);
+		ret = vfs_file_cksum_ext(filename, ZBX_CKSUM_SHA256, result);
 	else
 		SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid second parameter."));
 err:
@@ -22,6 +22,7 @@
 
 #include "zbxjson.h"
 #include "zbxstr.h"
+#include "zbxtime.h"
 
 #include "stats.h"
 #include "diskdevices.h"
@@ -73,20 +74,124 @@
 				) continue
 #endif
 
-int	zbx_get_diskstat(const char *devname, zbx_uint64_t *dstat)
+/* the maximum age of disk statistics snapshot in seconds */
+#define ZBX_DISKSTATS_SNAPSHOT_TTL	1
+
+typedef struct
+{
+	char		*name;
+	zbx_uint64_t	rdev_major;
+	zbx_uint64_t	rdev_minor;
+	zbx_uint64_t	ds[ZBX_DSTAT_MAX];
+}
+zbx_diskstat_t;
+
+static zbx_hashset_t	diskstats;
+static double		diskstats_time = 0;
+
+static zbx_hash_t	diskstat_hash(const void *data)
+{
+	const zbx_diskstat_t	*diskstat = (const zbx_diskstat_t *)data;
+
+	return ZBX_DEFAULT_STRING_HASH_FUNC(diskstat->name);
+}
+
+static void	diskstat_clean(void *data)
+{
+	zbx_free(((zbx_diskstat_t *)data)->name);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get snapshot of INFO_FILE_NAME indexed by device name             *
+ *                                                                            *
+ * Return value: SUCCEED - the snapshot is available                          *
+ *               FAIL    - the file cannot be read                            *
+ *                                                                            *
+ * Comments: The file is parsed at most once per ZBX_DISKSTATS_SNAPSHOT_TTL   *
+ *           seconds, all disk device checks and the disk device collector    *
+ *           within this period are served from the snapshot.                 *
+ *                                                                            *
+ ******************************************************************************/
+static int	get_diskstats_snapshot(void)
 {
 	FILE		*f;
-	char		tmp[MAX_STRING_LEN], name[MAX_STRING_LEN], dev_path[MAX_STRING_LEN];
-	int		i, ret = FAIL, dev_exists = FAIL;
+	char		tmp[MAX_STRING_LEN], name[MAX_STRING_LEN];
 	zbx_uint64_t	ds[ZBX_DSTAT_MAX], rdev_major, rdev_minor;
-	zbx_stat_t	dev_st;
-	int		found = 0;
+	zbx_diskstat_t	diskstat_local, *diskstat;
+	double		now;
+
+	now = zbx_time();
+
+	if (0 < diskstats_time && now >= diskstats_time && ZBX_DISKSTATS_SNAPSHOT_TTL > now - diskstats_time)
+		return SUCCEED;
+
+	if (0 == diskstats_time)
+	{
+		zbx_hashset_create_ext(&diskstats, 16, diskstat_hash, ZBX_DEFAULT_STR_COMPARE_FUNC, diskstat_clean,
+				ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
+	}
+	else
+		zbx_hashset_clear(&diskstats);
+
+	diskstats_time = now;
+
+	if (NULL == (f = fopen(INFO_FILE_NAME, "r")))
+	{
+		/* force rereading on the next call */
+		diskstats_time = -1;
+		return FAIL;
+	}
+
+	while (NULL != fgets(tmp, sizeof(tmp), f))
+	{
+		PARSE(tmp);
+
+		diskstat_local.name = name;
+
+		if (NULL != zbx_hashset_search(&diskstats, &diskstat_local))
+			continue;
+
+		diskstat_local.name = zbx_strdup(NULL, name);
+		diskstat = (zbx_diskstat_t *)zbx_hashset_insert(&diskstats, &diskstat_local, sizeof(diskstat_local));
+
+		diskstat->rdev_major = rdev_major;
+		diskstat->rdev_minor = rdev_minor;
+		memcpy(diskstat->ds, ds, sizeof(ds));
+	}
+	zbx_fclose(f);
+
+	return SUCCEED;
+}
+
+int	zbx_get_diskstat(const char *devname, zbx_uint64_t *dstat)
+{
+	char			dev_path[MAX_STRING_LEN];
+	int			i, ret = FAIL, dev_exists = FAIL;
+	zbx_stat_t		dev_st;
+	zbx_diskstat_t		diskstat_local, *diskstat;
+	zbx_hashset_iter_t	iter;
 
 	for (i = 0; i < ZBX_DSTAT_MAX; i++)
 		dstat[i] = (zbx_uint64_t)__UINT64_C(0);
 
+	if (SUCCEED != get_diskstats_snapshot())
+		return FAIL;
+
 	if (NULL != devname && '\0' != *devname && 0 != strcmp(devname, "all"))
 	{
+		diskstat_local.name = (char *)devname;
+
+		if (NULL != (diskstat = (zbx_diskstat_t *)zbx_hashset_search(&diskstats, &diskstat_local)))
+		{
+			dstat[ZBX_DSTAT_R_OPER] = diskstat->ds[ZBX_DSTAT_R_OPER];
+			dstat[ZBX_DSTAT_R_SECT] = diskstat->ds[ZBX_DSTAT_R_SECT];
+			dstat[ZBX_DSTAT_W_OPER] = diskstat->ds[ZBX_DSTAT_W_OPER];
+			dstat[ZBX_DSTAT_W_SECT] = diskstat->ds[ZBX_DSTAT_W_SECT];
+
+			return SUCCEED;
+		}
+
 		*dev_path = '\0';
 		if (0 != strncmp(devname, ZBX_DEV_PFX, ZBX_CONST_STRLEN(ZBX_DEV_PFX)))
 			zbx_strscpy(dev_path, ZBX_DEV_PFX);
@@ -94,39 +199,27 @@ int	zbx_get_diskstat(const char *devname, zbx_uint64_t *dstat)
 
 		if (zbx_stat(dev_path, &dev_st) == 0)
 			dev_exists = SUCCEED;
+		else
+			return FAIL;
 	}
 
-	if (NULL == (f = fopen(INFO_FILE_NAME, "r")))
-		return FAIL;
+	zbx_hashset_iter_reset(&diskstats, &iter);
 
-	while (NULL != fgets(tmp, sizeof(tmp), f))
+	while (NULL != (diskstat = (zbx_diskstat_t *)zbx_hashset_iter_next(&iter)))
 	{
-		PARSE(tmp);
-
-		if (NULL != devname && '\0' != *devname && 0 != strcmp(devname, "all"))
+		if (SUCCEED == dev_exists && (major(dev_st.st_rdev) != diskstat->rdev_major ||
+				minor(dev_st.st_rdev) != diskstat->rdev_minor))
 		{
-			if (0 != strcmp(name, devname))
-			{
-				if (SUCCEED != dev_exists
-					|| major(dev_st.st_rdev) != rdev_major
-					|| minor(dev_st.st_rdev) != rdev_minor)
-					continue;
-			}
-			else
-				found = 1;
+			continue;
 		}
 
-		dstat[ZBX_DSTAT_R_OPER] += ds[ZBX_DSTAT_R_OPER];
-		dstat[ZBX_DSTAT_R_SECT] += ds[ZBX_DSTAT_R_SECT];
-		dstat[ZBX_DSTAT_W_OPER] += ds[ZBX_DSTAT_W_OPER];
-		dstat[ZBX_DSTAT_W_SECT] += ds[ZBX_DSTAT_W_SECT];
+		dstat[ZBX_DSTAT_R_OPER] += diskstat->ds[ZBX_DSTAT_R_OPER];
+		dstat[ZBX_DSTAT_R_SECT] += diskstat->ds[ZBX_DSTAT_R_SECT];
+		dstat[ZBX_DSTAT_W_OPER] += diskstat->ds[ZBX_DSTAT_W_OPER];
+		dstat[ZBX_DSTAT_W_SECT] += diskstat->ds[ZBX_DSTAT_W_SECT];
 
 		ret = SUCCEED;
-
-		if (1 == found)
-			break;
 	}
-	zbx_fclose(f);
 
 	return ret;
 }
@@ -141,36 +234,35 @@ int	zbx_get_diskstat(const char *devname, zbx_uint64_t *dstat)
  ******************************************************************************/
 static int	get_kernel_devname(const char *devname, char *kernel_devname, size_t max_kernel_devname_len)
 {
-	FILE		*f;
-	char		tmp[MAX_STRING_LEN], name[MAX_STRING_LEN], dev_path[MAX_STRING_LEN];
-	int		ret = FAIL;
-	zbx_uint64_t	ds[ZBX_DSTAT_MAX], rdev_major, rdev_minor;
-	zbx_stat_t	dev_st;
+	char			dev_path[MAX_STRING_LEN];
+	zbx_stat_t		dev_st;
+	zbx_diskstat_t		*diskstat;
+	zbx_hashset_iter_t	iter;
 
 	if ('\0' == *devname)
-		return ret;
+		return FAIL;
 
 	*dev_path = '\0';
 	if (0 != strncmp(devname, ZBX_DEV_PFX, ZBX_CONST_STRLEN(ZBX_DEV_PFX)))
 		zbx_strscpy(dev_path, ZBX_DEV_PFX);
 	zbx_strscat(dev_path, devname);
 
-	if (zbx_stat(dev_path, &dev_st) < 0 || NULL == (f = fopen(INFO_FILE_NAME, "r")))
-		return ret;
+	if (zbx_stat(dev_path, &dev_st) < 0 || SUCCEED != get_diskstats_snapshot())
+		return FAIL;
 
-	while (NULL != fgets(tmp, sizeof(tmp), f))
+	zbx_hashset_iter_reset(&diskstats, &iter);
+
+	while (NULL != (diskstat = (zbx_diskstat_t *)zbx_hashset_iter_next(&iter)))
 	{
-		PARSE(tmp);
-		if (major(dev_st.st_rdev) != rdev_major || minor(dev_st.st_rdev) != rdev_minor)
+		if (major(dev_st.st_rdev) != diskstat->rdev_major || minor(dev_st.st_rdev) != diskstat->rdev_minor)
 			continue;
 
-		zbx_strlcpy(kernel_devname, name, max_kernel_devname_len);
-		ret = SUCCEED;
-		break;
+		zbx_strlcpy(kernel_devname, diskstat->name, max_kernel_devname_len);
+
+		return SUCCEED;
 	}
-	zbx_fclose(f);
 
-	return ret;
+	return FAIL;
 }
 
 static int	vfs_dev_rw(AGENT_REQUEST *request, AGENT_RESULT *result, int rw)
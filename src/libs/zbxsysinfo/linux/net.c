@@ -78,6 +78,7 @@ enum
 	STATE_LAST_ACK,
 	STATE_LISTEN,
 	STATE_CLOSING,
+	STATE_NEW_SYN_RECV,
 	STATE_MAXSTATES
 };
 
@@ -96,7 +97,22 @@ enum
 
 static int	nlerr;
 
-static int	find_tcp_port_by_state_nl(unsigned short port, int state, int *found)
+typedef int	(*zbx_tcp_diag_cb_t)(const struct inet_diag_msg *r, void *data);
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: dumps TCP sockets in the specified states over netlink            *
+ *                                                                            *
+ * Parameters: states - [IN] the bitmask of socket states to dump             *
+ *             cb     - [IN] the callback called for each socket, the dump is *
+ *                           stopped when it returns FAIL                     *
+ *             data   - [IN] the callback data                                *
+ *                                                                            *
+ * Return value: SUCCEED - the sockets were dumped                            *
+ *               FAIL    - netlink error occurred, see nlerr                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	tcp_diag_dump_nl(unsigned int states, zbx_tcp_diag_cb_t cb, void *data)
 {
 	struct
 	{
@@ -122,8 +138,6 @@ static int	find_tcp_port_by_state_nl(unsigned short port, int state, int *found)
 
 	struct nlmsghdr		*r_hdr;
 
-	*found = 0;
-
 	request.nlhdr.nlmsg_len = sizeof(request);
 	request.nlhdr.nlmsg_flags = NLM_F_REQUEST | NLM_F_ROOT | NLM_F_MATCH;
 	request.nlhdr.nlmsg_pid = 0;
@@ -131,7 +145,7 @@ static int	find_tcp_port_by_state_nl(unsigned short port, int state, int *found)
 	request.nlhdr.nlmsg_type = TCPDIAG_GETSOCK;
 
 	memset(&request.r, 0, sizeof(request.r));
-	request.r.idiag_states = (1 << state);
+	request.r.idiag_states = states;
 
 	if (-1 == (fd = socket(AF_NETLINK, SOCK_DGRAM, NETLINK_INET_DIAG)) ||
 			0 != setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, (char *)&timeout, sizeof(struct timeval)))
@@ -180,6 +194,7 @@ static int	find_tcp_port_by_state_nl(unsigned short port, int state, int *found)
 				switch (r_hdr->nlmsg_type)
 				{
 					case NLMSG_DONE:
+						/* legacy request dumps sockets of all address families at once */
 						goto out;
 					case NLMSG_ERROR:
 					{
@@ -198,11 +213,8 @@ static int	find_tcp_port_by_state_nl(unsigned short port, int state, int *found)
 						goto out;
 					}
 					case 0x12:
-						if (state == r->idiag_state && port == ntohs(r->id.idiag_sport))
-						{
-							*found = 1;
+						if (SUCCEED != cb(r, data))
 							goto out;
-						}
 						break;
 					default:
 						nlerr = NLERR_UNKNOWNMSGTYPE;
@@ -220,32 +232,155 @@ out:
 
 	return ret;
 }
+
+typedef struct
+{
+	unsigned short	port;
+	int		state;
+	int		found;
+}
+zbx_tcp_port_find_t;
+
+static int	tcp_port_find_cb(const struct inet_diag_msg *r, void *data)
+{
+	zbx_tcp_port_find_t	*port_find = (zbx_tcp_port_find_t *)data;
+
+	if (port_find->state == r->idiag_state && port_find->port == ntohs(r->id.idiag_sport))
+	{
+		port_find->found = 1;
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+static int	find_tcp_port_by_state_nl(unsigned short port, int state, int *found)
+{
+	zbx_tcp_port_find_t	port_find = {port, state, 0};
+	int			ret;
+
+	ret = tcp_diag_dump_nl(1 << state, tcp_port_find_cb, &port_find);
+	*found = port_find.found;
+
+	return ret;
+}
+
+static const char	*nlerr_string(void)
+{
+	switch (nlerr)
+	{
+		case NLERR_UNKNOWN:
+			return "unrecognized netlink error occurred";
+		case NLERR_SOCKCREAT:
+			return "cannot create netlink socket";
+		case NLERR_BADSEND:
+			return "cannot send netlink message to kernel";
+		case NLERR_BADRECV:
+			return "cannot receive netlink message from kernel";
+		case NLERR_RECVTIMEOUT:
+			return "receiving netlink response timed out";
+		case NLERR_RESPTRUNCAT:
+			return "received truncated netlink response from kernel";
+		case NLERR_OPNOTSUPPORTED:
+			return "netlink operation not supported";
+		case NLERR_UNKNOWNMSGTYPE:
+			return "received message of unrecognized type from kernel";
+		default:
+			return "unknown error";
+	}
+}
 #endif
 
-static int	get_net_stat(const char *if_name, net_stat_t *result, char **error)
+/* the maximum age of network interface statistics snapshot in seconds */
+#define ZBX_NET_DEV_SNAPSHOT_TTL	1
+
+typedef struct
 {
-	int	ret = SYSINFO_RET_FAIL;
-	char	line[MAX_STRING_LEN], name[MAX_STRING_LEN], *p;
-	FILE	*f;
+	char		*name;
+	net_stat_t	ns;
+}
+zbx_net_if_t;
 
-	if (NULL == if_name || '\0' == *if_name)
+static zbx_hashset_t	net_ifs;
+static zbx_vector_str_t	net_if_names;
+static double		net_ifs_time = 0;
+
+static zbx_hash_t	net_if_hash(const void *data)
+{
+	const zbx_net_if_t	*net_if = (const zbx_net_if_t *)data;
+
+	return ZBX_DEFAULT_STRING_HASH_FUNC(net_if->name);
+}
+
+static void	net_if_clean(void *data)
+{
+	zbx_free(((zbx_net_if_t *)data)->name);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get snapshot of /proc/net/dev indexed by interface name           *
+ *                                                                            *
+ * Parameters: error - [OUT] the error message                                *
+ *                                                                            *
+ * Return value: SUCCEED - the snapshot is available                          *
+ *               FAIL    - the file cannot be read                            *
+ *                                                                            *
+ * Comments: The file is parsed at most once per ZBX_NET_DEV_SNAPSHOT_TTL     *
+ *           seconds, all network interface checks within this period are     *
+ *           served from the snapshot.                                        *
+ *                                                                            *
+ ******************************************************************************/
+static int	get_net_dev_snapshot(char **error)
+{
+	char		line[MAX_STRING_LEN], name[MAX_STRING_LEN], *p;
+	FILE		*f;
+	double		now;
+	zbx_net_if_t	net_if_local;
+	net_stat_t	*ns = &net_if_local.ns;
+
+	now = zbx_time();
+
+	if (0 < net_ifs_time && now >= net_ifs_time && ZBX_NET_DEV_SNAPSHOT_TTL > now - net_ifs_time)
+		return SUCCEED;
+
+	if (0 == net_ifs_time)
 	{
-		*error = zbx_strdup(NULL, "Network interface name cannot be empty.");
-		return SYSINFO_RET_FAIL;
+		zbx_hashset_create_ext(&net_ifs, 16, net_if_hash, ZBX_DEFAULT_STR_COMPARE_FUNC, net_if_clean,
+				ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
+		zbx_vector_str_create(&net_if_names);
+	}
+	else
+	{
+		zbx_hashset_clear(&net_ifs);
+		zbx_vector_str_clear_ext(&net_if_names, zbx_str_free);
 	}
 
 	if (NULL == (f = fopen("/proc/net/dev", "r")))
 	{
 		*error = zbx_dsprintf(NULL, "Cannot open /proc/net/dev: %s", zbx_strerror(errno));
-		return SYSINFO_RET_FAIL;
+
+		/* force rereading on the next call */
+		net_ifs_time = -1;
+		return FAIL;
 	}
 
+	net_ifs_time = now;
+
 	while (NULL != fgets(line, sizeof(line), f))
 	{
 		if (NULL == (p = strstr(line, ":")))
 			continue;
 
-		*p = '\t';
+		*p = '\0';
+
+		/* trim left spaces */
+		for (p = line; ' ' == *p && '\0' != *p; p++)
+			;
+
+		zbx_vector_str_append(&net_if_names, zbx_strdup(NULL, p));
+
+		line[strlen(line)] = '\t';
 
 		if (17 == sscanf(line, "%s\t" ZBX_FS_UI64 "\t" ZBX_FS_UI64 "\t"
 				ZBX_FS_UI64 "\t" ZBX_FS_UI64 "\t"
@@ -256,39 +391,61 @@ static int	get_net_stat(const char *if_name, net_stat_t *result, char **error)
 				ZBX_FS_UI64 "\t" ZBX_FS_UI64 "\t"
 				ZBX_FS_UI64 "\t" ZBX_FS_UI64 "\n",
 				name,
-				&result->ibytes,	/* bytes */
-				&result->ipackets,	/* packets */
-				&result->ierr,		/* errs */
-				&result->idrop,		/* drop */
-				&result->ififo,		/* fifo (overruns) */
-				&result->iframe,	/* frame */
-				&result->icompressed,	/* compressed */
-				&result->imulticast,	/* multicast */
-				&result->obytes,	/* bytes */
-				&result->opackets,	/* packets */
-				&result->oerr,		/* errs */
-				&result->odrop,		/* drop */
-				&result->ofifo,		/* fifo (overruns)*/
-				&result->ocolls,	/* colls (collisions) */
-				&result->ocarrier,	/* carrier */
-				&result->ocompressed))	/* compressed */
+				&ns->ibytes,		/* bytes */
+				&ns->ipackets,		/* packets */
+				&ns->ierr,		/* errs */
+				&ns->idrop,		/* drop */
+				&ns->ififo,		/* fifo (overruns) */
+				&ns->iframe,		/* frame */
+				&ns->icompressed,	/* compressed */
+				&ns->imulticast,	/* multicast */
+				&ns->obytes,		/* bytes */
+				&ns->opackets,		/* packets */
+				&ns->oerr,		/* errs */
+				&ns->odrop,		/* drop */
+				&ns->ofifo,		/* fifo (overruns)*/
+				&ns->ocolls,		/* colls (collisions) */
+				&ns->ocarrier,		/* carrier */
+				&ns->ocompressed))	/* compressed */
 		{
-			if (0 == strcmp(name, if_name))
-			{
-				ret = SYSINFO_RET_OK;
-				break;
-			}
+			net_if_local.name = name;
+
+			if (NULL != zbx_hashset_search(&net_ifs, &net_if_local))
+				continue;
+
+			net_if_local.name = zbx_strdup(NULL, name);
+			zbx_hashset_insert(&net_ifs, &net_if_local, sizeof(net_if_local));
 		}
 	}
 
 	zbx_fclose(f);
 
-	if (SYSINFO_RET_FAIL == ret)
+	return SUCCEED;
+}
+
+static int	get_net_stat(const char *if_name, net_stat_t *result, char **error)
+{
+	zbx_net_if_t	net_if_local, *net_if;
+
+	if (NULL == if_name || '\0' == *if_name)
+	{
+		*error = zbx_strdup(NULL, "Network interface name cannot be empty.");
+		return SYSINFO_RET_FAIL;
+	}
+
+	if (SUCCEED != get_net_dev_snapshot(error))
+		return SYSINFO_RET_FAIL;
+
+	net_if_local.name = (char *)if_name;
+
+	if (NULL == (net_if = (zbx_net_if_t *)zbx_hashset_search(&net_ifs, &net_if_local)))
 	{
 		*error = zbx_strdup(NULL, "Cannot find information for this network interface in /proc/net/dev.");
 		return SYSINFO_RET_FAIL;
 	}
 
+	*result = net_if->ns;
+
 	return SYSINFO_RET_OK;
 }
 
@@ -573,38 +730,27 @@ int	net_if_collisions(AGENT_REQUEST *request, AGENT_RESULT *result)
 
 int	net_if_discovery(AGENT_REQUEST *request, AGENT_RESULT *result)
 {
-	char		line[MAX_STRING_LEN], *p;
-	FILE		*f;
+	int		i;
+	char		*error;
 	struct zbx_json	j;
 
 	ZBX_UNUSED(request);
 
-	if (NULL == (f = fopen("/proc/net/dev", "r")))
+	if (SUCCEED != get_net_dev_snapshot(&error))
 	{
-		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot open /proc/net/dev: %s", zbx_strerror(errno)));
+		SET_MSG_RESULT(result, error);
 		return SYSINFO_RET_FAIL;
 	}
 
 	zbx_json_initarray(&j, ZBX_JSON_STAT_BUF_LEN);
 
-	while (NULL != fgets(line, sizeof(line), f))
+	for (i = 0; i < net_if_names.values_num; i++)
 	{
-		if (NULL == (p = strstr(line, ":")))
-			continue;
-
-		*p = '\0';
-
-		/* trim left spaces */
-		for (p = line; ' ' == *p && '\0' != *p; p++)
-			;
-
 		zbx_json_addobject(&j, NULL);
-		zbx_json_addstring(&j, "{#IFNAME}", p, ZBX_JSON_TYPE_STRING);
+		zbx_json_addstring(&j, "{#IFNAME}", net_if_names.values[i], ZBX_JSON_TYPE_STRING);
 		zbx_json_close(&j);
 	}
 
-	zbx_fclose(f);
-
 	zbx_json_close(&j);
 
 	SET_STR_RESULT(result, strdup(j.buffer));
@@ -645,39 +791,7 @@ int	net_tcp_listen(AGENT_REQUEST *request, AGENT_RESULT *result)
 	}
 	else
 	{
-		const char	*error;
-
-		switch (nlerr)
-		{
-			case NLERR_UNKNOWN:
-				error = "unrecognized netlink error occurred";
-				break;
-			case NLERR_SOCKCREAT:
-				error = "cannot create netlink socket";
-				break;
-			case NLERR_BADSEND:
-				error = "cannot send netlink message to kernel";
-				break;
-			case NLERR_BADRECV:
-				error = "cannot receive netlink message from kernel";
-				break;
-			case NLERR_RECVTIMEOUT:
-				error = "receiving netlink response timed out";
-				break;
-			case NLERR_RESPTRUNCAT:
-				error = "received truncated netlink response from kernel";
-				break;
-			case NLERR_OPNOTSUPPORTED:
-				error = "netlink operation not supported";
-				break;
-			case NLERR_UNKNOWNMSGTYPE:
-				error = "received message of unrecognized type from kernel";
-				break;
-			default:
-				error = "unknown error";
-		}
-
-		zabbix_log(LOG_LEVEL_DEBUG, "netlink interface error: %s", error);
+		zabbix_log(LOG_LEVEL_DEBUG, "netlink interface error: %s", nlerr_string());
 		zabbix_log(LOG_LEVEL_DEBUG, "falling back on reading /proc/net/tcp...");
 #endif
 		buffer = (char *)zbx_malloc(NULL, buffer_alloc);
@@ -819,6 +933,108 @@ static unsigned char	get_connection_state_udp(const char *name)
 	return state;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if socket matches the requested addresses, ports and state *
+ *                                                                            *
+ ******************************************************************************/
+static int	net_socket_match(unsigned char state, const net_count_info_t *exp_l, const net_count_info_t *exp_r,
+		unsigned short lport, unsigned short rport, unsigned char state_f, const ZBX_SOCKADDR *sockaddr_l,
+		const ZBX_SOCKADDR *sockaddr_r)
+{
+	if ((0 != exp_l->port && exp_l->port != lport) ||
+			(0 != exp_r->port && exp_r->port != rport) ||
+			(0 != state && state != state_f) ||
+			(NULL != exp_l->ai &&
+			FAIL == zbx_ip_cmp(exp_l->prefix_sz, exp_l->ai, *sockaddr_l,
+			1 == exp_l->mapped && 0 != exp_l->prefix_sz ? 0 : 1)) ||
+			(NULL != exp_r->ai &&
+			FAIL == zbx_ip_cmp(exp_r->prefix_sz, exp_r->ai, *sockaddr_r,
+			1 == exp_r->mapped && 0 != exp_r->prefix_sz ? 0 : 1)))
+	{
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+#ifdef HAVE_INET_DIAG
+typedef struct
+{
+	unsigned char		state;
+	const net_count_info_t	*exp_l;
+	const net_count_info_t	*exp_r;
+	zbx_uint64_t		count;
+}
+zbx_tcp_count_t;
+
+static int	tcp_count_cb(const struct inet_diag_msg *r, void *data)
+{
+	zbx_tcp_count_t	*tcp_count = (zbx_tcp_count_t *)data;
+	ZBX_SOCKADDR	sockaddr_l, sockaddr_r;
+
+	memset(&sockaddr_l, 0, sizeof(sockaddr_l));
+	memset(&sockaddr_r, 0, sizeof(sockaddr_r));
+
+	if (AF_INET == r->idiag_family)
+	{
+		struct sockaddr_in	*sa_l = (struct sockaddr_in *)&sockaddr_l, *sa_r = (struct sockaddr_in *)&sockaddr_r;
+
+		sa_l->sin_family = sa_r->sin_family = AF_INET;
+		sa_l->sin_addr.s_addr = r->id.idiag_src[0];
+		sa_r->sin_addr.s_addr = r->id.idiag_dst[0];
+	}
+#ifdef HAVE_IPV6
+	else if (AF_INET6 == r->idiag_family)
+	{
+		struct sockaddr_in6	*sa_l = (struct sockaddr_in6 *)&sockaddr_l,
+					*sa_r = (struct sockaddr_in6 *)&sockaddr_r;
+
+		sa_l->sin6_family = sa_r->sin6_family = AF_INET6;
+		memcpy(sa_l->sin6_addr.s6_addr, r->id.idiag_src, sizeof(sa_l->sin6_addr.s6_addr));
+		memcpy(sa_r->sin6_addr.s6_addr, r->id.idiag_dst, sizeof(sa_r->sin6_addr.s6_addr));
+	}
+#endif
+	else
+		return SUCCEED;
+
+	if (SUCCEED == net_socket_match(tcp_count->state, tcp_count->exp_l, tcp_count->exp_r,
+			ntohs(r->id.idiag_sport), ntohs(r->id.idiag_dport), r->idiag_state, &sockaddr_l, &sockaddr_r))
+	{
+		tcp_count->count++;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: counts TCP sockets over netlink instead of parsing /proc/net/tcp  *
+ *          and /proc/net/tcp6                                                *
+ *                                                                            *
+ ******************************************************************************/
+static int	get_nl_tcp_count(unsigned char state, const net_count_info_t *exp_l, const net_count_info_t *exp_r,
+		zbx_uint64_t *count)
+{
+	zbx_tcp_count_t	tcp_count = {state, exp_l, exp_r, 0};
+	unsigned int	states;
+
+	if (0 == state)
+		states = (1 << STATE_MAXSTATES) - 1;
+	else if (STATE_SYN_RECV == state)
+		states = (1 << STATE_SYN_RECV) | (1 << STATE_NEW_SYN_RECV);	/* request sockets */
+	else
+		states = 1 << state;
+
+	if (SUCCEED != tcp_diag_dump_nl(states, tcp_count_cb, &tcp_count))
+		return FAIL;
+
+	*count += tcp_count.count;
+
+	return SUCCEED;
+}
+#endif
+
 #ifdef HAVE_IPV6
 static int	scan_ipv6_addr(const char *addr, struct sockaddr_in6 *sa6)
 {
@@ -889,20 +1105,8 @@ static int	get_proc_net_count_ipv6(const char *filename, unsigned char state, ne
 		if (2 != sscanf(p, ":%hx %hhx", &rport, &state_f))
 			continue;
 
-		if ((0 != exp_l->port && exp_l->port != lport) ||
-				(0 != exp_r->port && exp_r->port != rport) ||
-				(0 != state && state != state_f) ||
-				(NULL != exp_l->ai &&
-				FAIL == zbx_ip_cmp(exp_l->prefix_sz, exp_l->ai, sockaddr_l,
-				1 == exp_l->mapped && 0 != exp_l->prefix_sz ? 0 : 1)) ||
-				(NULL != exp_r->ai &&
-				FAIL == zbx_ip_cmp(exp_r->prefix_sz, exp_r->ai, sockaddr_r,
-				1 == exp_r->mapped && 0 != exp_r->prefix_sz ? 0 : 1)))
-		{
-			continue;
-		}
-
-		(*count)++;
+		if (SUCCEED == net_socket_match(state, exp_l, exp_r, lport, rport, state_f, &sockaddr_l, &sockaddr_r))
+			(*count)++;
 	}
 
 	zbx_fclose(f);
@@ -949,20 +1153,8 @@ static int	get_proc_net_count_ipv4(const char *filename, unsigned char state, ne
 			continue;
 		}
 
-		if ((0 != exp_l->port && exp_l->port != lport) ||
-				(0 != exp_r->port && exp_r->port != rport) ||
-				(0 != state && state != state_f) ||
-				(NULL != exp_l->ai &&
-				FAIL == zbx_ip_cmp(exp_l->prefix_sz, exp_l->ai, sockaddr_l,
-				1 == exp_l->mapped && 0 != exp_l->prefix_sz ? 0 : 1)) ||
-				(NULL != exp_r->ai &&
-				FAIL == zbx_ip_cmp(exp_r->prefix_sz, exp_r->ai, sockaddr_r,
-				1 == exp_r->mapped && 0 != exp_r->prefix_sz ? 0 : 1)))
-		{
-			continue;
-		}
-
-		(*count)++;
+		if (SUCCEED == net_socket_match(state, exp_l, exp_r, lport, rport, state_f, &sockaddr_l, &sockaddr_r))
+			(*count)++;
 	}
 
 	zbx_fclose(f);
@@ -1132,6 +1324,16 @@ static int	net_socket_count(int conn_type, AGENT_REQUEST *request, AGENT_RESULT
 		goto err;
 	}
 
+#ifdef HAVE_INET_DIAG
+	if (NET_CONN_TYPE_TCP == conn_type)
+	{
+		if (SUCCEED == get_nl_tcp_count(state_num, &info_l, &info_r, &count))
+			goto out;
+
+		zabbix_log(LOG_LEVEL_DEBUG, "netlink interface error: %s", nlerr_string());
+		zabbix_log(LOG_LEVEL_DEBUG, "falling back on reading /proc/net/tcp...");
+	}
+#endif
 	if (SUCCEED != get_proc_net_count_ipv4(NET_CONN_TYPE_TCP == conn_type ? "/proc/net/tcp" : "/proc/net/udp",
 			state_num, &info_l, &info_r, &count, &error))
 	{
@@ -1147,7 +1349,9 @@ static int	net_socket_count(int conn_type, AGENT_REQUEST *request, AGENT_RESULT
 		goto err;
 	}
 #endif
-
+#ifdef HAVE_INET_DIAG
+out:
+#endif
 	SET_UI64_RESULT(result, count);
 
 	ret = SYSINFO_RET_OK;
@@ -271,129 +271,436 @@ static int	get_cmdline(FILE *f_cmd, char **line, size_t *line_offset)
 	return FAIL;
 }
 
-static int	cmp_status(FILE *f_stat, const char *procname)
+#define PROC_SNAPSHOT_TTL	1	/* seconds during which proc.num[] and proc.mem[] reuse process snapshot */
+
+#define PROC_SNAPSHOT_NAME	0x01
+#define PROC_SNAPSHOT_UID	0x02
+
+/* memory fields of /proc/[pid]/status kept in process snapshot */
+static const char	*proc_mem_labels[] = {"VmSize:\t", "VmRSS:\t", "VmPeak:\t", "VmSwap:\t", "VmLib:\t", "VmLck:\t",
+		"VmPin:\t", "VmHWM:\t", "VmData:\t", "VmStk:\t", "VmExe:\t", "VmPTE:\t"};
+
+#define PROC_MEM_FIELDS_NUM	ARRSIZE(proc_mem_labels)
+
+typedef struct
 {
-	char	tmp[MAX_STRING_LEN];
+	pid_t		pid;
+	uid_t		uid;
+	unsigned char	flags;
+	char		state;				/* the first character of State field, '\0' if missing */
+	size_t		name;				/* offsets of strings in snapshot buffer: */
+	size_t		name_arg0;			/* base name of the 0th argument */
+	size_t		cmdline;			/* arguments separated by spaces */
+	zbx_uint64_t	mem[PROC_MEM_FIELDS_NUM];	/* memory fields in bytes */
+	zbx_uint32_t	mem_found;			/* bit is set for every field present in status */
+	zbx_uint32_t	mem_invalid;			/* bit is set for every field that cannot be parsed */
+}
+proc_snapshot_entry_t;
 
-	rewind(f_stat);
+typedef struct
+{
+	double			time;
+	proc_snapshot_entry_t	*entries;
+	int			entries_num;
+	int			entries_alloc;
+
+	/* strings of all entries */
+	char			*buf;
+	size_t			buf_alloc;
+	size_t			buf_offset;
+
+	/* contents of the file being parsed */
+	char			*file;
+	size_t			file_alloc;
+}
+proc_snapshot_t;
 
-	while (NULL != fgets(tmp, (int)sizeof(tmp), f_stat))
-	{
-		if (0 != strncmp(tmp, "Name:\t", 6))
-			continue;
+static ZBX_THREAD_LOCAL proc_snapshot_t	snapshot;
 
-		zbx_rtrim(tmp + 6, "\n");
-		if (0 == strcmp(tmp + 6, procname))
-			return SUCCEED;
-		break;
-	}
+#define PROC_SNAPSHOT_STR(offset)	(snapshot.buf + (offset))
 
-	return FAIL;
+/******************************************************************************
+ *                                                                            *
+ * Purpose: parse memory amount with unit, for example "  176712 kB"          *
+ *                                                                            *
+ * Parameters: p_value - [IN/OUT] text after the field label, modified        *
+ *             bytes   - [OUT] amount in bytes                                *
+ *                                                                            *
+ * Return value: SUCCEED or FAIL                                              *
+ *                                                                            *
+ ******************************************************************************/
+static int	proc_parse_bytes(char *p_value, zbx_uint64_t *bytes)
+{
+	char	*p_unit;
+
+	if (NULL == (p_unit = strrchr(p_value, ' ')))
+		return FAIL;
+
+	*p_unit++ = '\0';
+
+	while (' ' == *p_value)
+		p_value++;
+
+	if (FAIL == zbx_is_uint64(p_value, bytes))
+		return FAIL;
+
+	zbx_rtrim(p_unit, "\n");
+
+	if (0 == strcasecmp(p_unit, "kB"))
+		*bytes <<= 10;
+	else if (0 == strcasecmp(p_unit, "mB"))
+		*bytes <<= 20;
+	else if (0 == strcasecmp(p_unit, "GB"))
+		*bytes <<= 30;
+	else if (0 == strcasecmp(p_unit, "TB"))
+		*bytes <<= 40;
+
+	return SUCCEED;
 }
 
-static int	check_procname(FILE *f_cmd, FILE *f_stat, const char *procname)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: read whole /proc file into snapshot file buffer                   *
+ *                                                                            *
+ * Parameters: path - [IN] file path                                          *
+ *             len  - [OUT] number of bytes read                              *
+ *                                                                            *
+ * Return value: SUCCEED or FAIL                                              *
+ *                                                                            *
+ * Comments: Contents are terminated with NUL character, there is space for   *
+ *           one more character after it.                                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	proc_snapshot_read_file(const char *path, size_t *len)
 {
-	char	*tmp = NULL, *p;
-	size_t	l;
-	int	ret = SUCCEED;
+	int	fd;
+	ssize_t	n;
 
-	if (NULL == procname || '\0' == *procname)
-		return SUCCEED;
+	if (-1 == (fd = open(path, O_RDONLY)))
+		return FAIL;
 
-	/* process name in /proc/[pid]/status contains limited number of characters */
-	if (SUCCEED == cmp_status(f_stat, procname))
-		return SUCCEED;
+	*len = 0;
 
-	if (SUCCEED == get_cmdline(f_cmd, &tmp, &l))
+	/* keep space for two terminating NUL characters */
+	while (0 < (n = read(fd, snapshot.file + *len, snapshot.file_alloc - *len - 2)))
 	{
-		if (NULL == (p = strrchr(tmp, '/')))
-			p = tmp;
-		else
-			p++;
+		*len += (size_t)n;
 
-		if (0 == strcmp(p, procname))
-			goto clean;
+		if (*len == snapshot.file_alloc - 2)
+		{
+			snapshot.file_alloc *= 2;
+			snapshot.file = (char *)zbx_realloc(snapshot.file, snapshot.file_alloc);
+		}
 	}
 
-	ret = FAIL;
-clean:
-	zbx_free(tmp);
+	close(fd);
 
-	return ret;
+	if (-1 == n)
+		return FAIL;
+
+	snapshot.file[*len] = '\0';
+
+	return SUCCEED;
 }
 
-static int	check_user(FILE *f_stat, struct passwd *usrinfo)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: copy string into snapshot buffer                                  *
+ *                                                                            *
+ * Return value: offset of the copied string                                  *
+ *                                                                            *
+ ******************************************************************************/
+static size_t	proc_snapshot_add_str(const char *str, size_t len)
 {
-	zbx_uint64_t	uid;
+	size_t	offset = snapshot.buf_offset;
 
-	if (NULL == usrinfo || (SUCCEED == proc_read_id(f_stat, PROC_ID_TYPE_USER, &uid) && usrinfo->pw_uid == uid))
-		return SUCCEED;
+	if (snapshot.buf_alloc - snapshot.buf_offset < len + 1)
+	{
+		while (snapshot.buf_alloc - snapshot.buf_offset < len + 1)
+			snapshot.buf_alloc *= 2;
 
-	return FAIL;
+		snapshot.buf = (char *)zbx_realloc(snapshot.buf, snapshot.buf_alloc);
+	}
+
+	memcpy(snapshot.buf + offset, str, len);
+	snapshot.buf[offset + len] = '\0';
+	snapshot.buf_offset += len + 1;
+
+	return offset;
 }
 
-static int	check_proccomm(FILE *f_cmd, const char *proccomm)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: parse process name, state, user and memory fields from            *
+ *          /proc/[pid]/status contents in snapshot file buffer               *
+ *                                                                            *
+ ******************************************************************************/
+static void	proc_snapshot_parse_status(proc_snapshot_entry_t *entry)
 {
-	char	*tmp = NULL;
-	size_t	i, l;
-	int	ret = SUCCEED;
+	char	*line, *next;
+	size_t	i;
 
-	if (NULL == proccomm || '\0' == *proccomm)
-		return SUCCEED;
-
-	if (SUCCEED == get_cmdline(f_cmd, &tmp, &l))
+	for (line = snapshot.file; '\0' != *line; line = next)
 	{
-		for (i = 0, l -= 2; i < l; i++)
-			if ('\0' == tmp[i])
-				tmp[i] = ' ';
+		if (NULL != (next = strchr(line, '\n')))
+			*next++ = '\0';
+		else
+			next = line + strlen(line);
 
-		if (NULL != zbx_regexp_match(tmp, proccomm, NULL))
-			goto clean;
+		if (0 == strncmp(line, "Name:\t", 6))
+		{
+			if (0 == (entry->flags & PROC_SNAPSHOT_NAME))
+			{
+				entry->name = proc_snapshot_add_str(line + 6, strlen(line + 6));
+				entry->flags |= PROC_SNAPSHOT_NAME;
+			}
+		}
+		else if (0 == strncmp(line, "State:\t", 7))
+		{
+			if ('\0' == entry->state)
+				entry->state = line[7];
+		}
+		else if (0 == strncmp(line, "Uid:", 4))
+		{
+			if (0 == (entry->flags & PROC_SNAPSHOT_UID))
+			{
+				entry->uid = (uid_t)atoi(line + 4 + strspn(line + 4, " \t"));
+				entry->flags |= PROC_SNAPSHOT_UID;
+			}
+		}
+		else if (0 == strncmp(line, "Vm", 2))
+		{
+			for (i = 0; i < PROC_MEM_FIELDS_NUM; i++)
+			{
+				size_t	label_len = strlen(proc_mem_labels[i]);
+
+				if (0 != strncmp(line, proc_mem_labels[i], label_len) || 0 != (entry->mem_found & (1 << i)))
+					continue;
+
+				entry->mem_found |= 1 << i;
+
+				if (SUCCEED != proc_parse_bytes(line + label_len, &entry->mem[i]))
+					entry->mem_invalid |= 1 << i;
+
+				break;
+			}
+		}
 	}
+}
 
-	ret = FAIL;
-clean:
-	zbx_free(tmp);
+/******************************************************************************
+ *                                                                            *
+ * Purpose: keep base name of the 0th argument and arguments joined with      *
+ *          spaces from /proc/[pid]/cmdline contents in snapshot file buffer  *
+ *                                                                            *
+ ******************************************************************************/
+static void	proc_snapshot_parse_cmdline(proc_snapshot_entry_t *entry, size_t len)
+{
+	char	*arg0;
+	size_t	i;
 
-	return ret;
+	if (NULL == (arg0 = strrchr(snapshot.file, '/')))
+		arg0 = snapshot.file;
+	else
+		arg0++;
+
+	entry->name_arg0 = proc_snapshot_add_str(arg0, strlen(arg0));
+
+	/* terminate arguments with double NUL the same way as get_cmdline() does */
+	if (0 == len || '\0' != snapshot.file[len - 1])
+		snapshot.file[len++] = '\0';
+	if (1 == len || '\0' != snapshot.file[len - 2])
+		snapshot.file[len++] = '\0';
+
+	for (i = 0, len -= 2; i < len; i++)
+	{
+		if ('\0' == snapshot.file[i])
+			snapshot.file[i] = ' ';
+	}
+
+	entry->cmdline = proc_snapshot_add_str(snapshot.file, len);
 }
 
-static int	check_procstate(FILE *f_stat, int zbx_proc_stat)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get process snapshot not older than PROC_SNAPSHOT_TTL seconds     *
+ *                                                                            *
+ * Parameters: error - [OUT] error message                                    *
+ *                                                                            *
+ * Return value: SUCCEED or FAIL                                              *
+ *                                                                            *
+ * Comments: All processes are read once with raw read() calls into buffers   *
+ *           which are reused by subsequent snapshots, so many proc.num[] and *
+ *           proc.mem[] items checked at the same time walk /proc only once.  *
+ *                                                                            *
+ ******************************************************************************/
+static int	proc_snapshot_get(char **error)
 {
-	char	tmp[MAX_STRING_LEN], *p;
+	DIR		*dir;
+	struct dirent	*entries;
+	double		now;
+	char		path[MAX_STRING_LEN];
 
-	if (ZBX_PROC_STAT_ALL == zbx_proc_stat)
+	now = zbx_time();
+
+	if (NULL != snapshot.entries && now - snapshot.time < PROC_SNAPSHOT_TTL && now >= snapshot.time)
 		return SUCCEED;
 
-	rewind(f_stat);
+	if (NULL == (dir = opendir("/proc")))
+	{
+		*error = zbx_dsprintf(NULL, "Cannot open /proc: %s", zbx_strerror(errno));
+		return FAIL;
+	}
 
-	while (NULL != fgets(tmp, (int)sizeof(tmp), f_stat))
+	if (NULL == snapshot.entries)
 	{
-		if (0 != strncmp(tmp, "State:\t", 7))
-			continue;
+		snapshot.entries_alloc = 64;
+		snapshot.entries = (proc_snapshot_entry_t *)zbx_malloc(NULL,
+				(size_t)snapshot.entries_alloc * sizeof(proc_snapshot_entry_t));
+		snapshot.buf_alloc = 16 * ZBX_KIBIBYTE;
+		snapshot.buf = (char *)zbx_malloc(NULL, snapshot.buf_alloc);
+		snapshot.file_alloc = 4 * ZBX_KIBIBYTE;
+		snapshot.file = (char *)zbx_malloc(NULL, snapshot.file_alloc);
+	}
+
+	snapshot.entries_num = 0;
+	snapshot.buf_offset = 0;
 
-		p = tmp + 7;
+	while (NULL != (entries = readdir(dir)))
+	{
+		proc_snapshot_entry_t	*entry;
+		size_t			len;
+		int			pid;
 
-		switch (zbx_proc_stat)
+		if (0 == (pid = atoi(entries->d_name)))
+			continue;
+
+		if (snapshot.entries_num == snapshot.entries_alloc)
 		{
-			case ZBX_PROC_STAT_RUN:
-				return ('R' == *p) ? SUCCEED : FAIL;
-			case ZBX_PROC_STAT_SLEEP:
-				return ('S' == *p) ? SUCCEED : FAIL;
-			case ZBX_PROC_STAT_ZOMB:
-				return ('Z' == *p) ? SUCCEED : FAIL;
-			case ZBX_PROC_STAT_DISK:
-				return ('D' == *p) ? SUCCEED : FAIL;
-			case ZBX_PROC_STAT_TRACE:
-				return ('T' == *p) ? SUCCEED : FAIL;
-			default:
-				return FAIL;
+			snapshot.entries_alloc *= 2;
+			snapshot.entries = (proc_snapshot_entry_t *)zbx_realloc(snapshot.entries,
+					(size_t)snapshot.entries_alloc * sizeof(proc_snapshot_entry_t));
 		}
+
+		entry = &snapshot.entries[snapshot.entries_num];
+		memset(entry, 0, sizeof(proc_snapshot_entry_t));
+		entry->pid = (pid_t)pid;
+
+		zbx_snprintf(path, sizeof(path), "/proc/%s/cmdline", entries->d_name);
+
+		if (SUCCEED != proc_snapshot_read_file(path, &len))
+			continue;
+
+		proc_snapshot_parse_cmdline(entry, len);
+
+		zbx_snprintf(path, sizeof(path), "/proc/%s/status", entries->d_name);
+
+		if (SUCCEED != proc_snapshot_read_file(path, &len))
+			continue;
+
+		proc_snapshot_parse_status(entry);
+
+		snapshot.entries_num++;
 	}
 
+	closedir(dir);
+
+	snapshot.time = now;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get memory field of process from snapshot                         *
+ *                                                                            *
+ * Parameters: entry - [IN] process snapshot entry                            *
+ *             label - [IN] field label, e.g. "VmData:\t"                     *
+ *             bytes - [OUT] field value in bytes                             *
+ *                                                                            *
+ * Return value: SUCCEED - the value was returned,                            *
+ *               NOTSUPPORTED - the field was not found,                      *
+ *               FAIL - the field was found but could not be parsed           *
+ *                                                                            *
+ ******************************************************************************/
+static int	proc_snapshot_get_mem(const proc_snapshot_entry_t *entry, const char *label, zbx_uint64_t *bytes)
+{
+	size_t	i;
+
+	for (i = 0; i < PROC_MEM_FIELDS_NUM; i++)
+	{
+		if (0 != strcmp(label, proc_mem_labels[i]))
+			continue;
+
+		if (0 == (entry->mem_found & (1 << i)))
+			return NOTSUPPORTED;
+
+		if (0 != (entry->mem_invalid & (1 << i)))
+			return FAIL;
+
+		*bytes = entry->mem[i];
+
+		return SUCCEED;
+	}
+
+	return NOTSUPPORTED;
+}
+
+static int	check_procname(const proc_snapshot_entry_t *entry, const char *procname)
+{
+	if (NULL == procname || '\0' == *procname)
+		return SUCCEED;
+
+	/* process name in /proc/[pid]/status contains limited number of characters */
+	if (0 != (entry->flags & PROC_SNAPSHOT_NAME) && 0 == strcmp(PROC_SNAPSHOT_STR(entry->name), procname))
+		return SUCCEED;
+
+	if (0 == strcmp(PROC_SNAPSHOT_STR(entry->name_arg0), procname))
+		return SUCCEED;
+
 	return FAIL;
 }
 
+static int	check_user(const proc_snapshot_entry_t *entry, struct passwd *usrinfo)
+{
+	if (NULL == usrinfo || (0 != (entry->flags & PROC_SNAPSHOT_UID) && usrinfo->pw_uid == entry->uid))
+		return SUCCEED;
+
+	return FAIL;
+}
+
+static int	check_proccomm(const proc_snapshot_entry_t *entry, const char *proccomm)
+{
+	if (NULL == proccomm || '\0' == *proccomm)
+		return SUCCEED;
+
+	if (NULL != zbx_regexp_match(PROC_SNAPSHOT_STR(entry->cmdline), proccomm, NULL))
+		return SUCCEED;
+
+	return FAIL;
+}
+
+static int	check_procstate(const proc_snapshot_entry_t *entry, int zbx_proc_stat)
+{
+	switch (zbx_proc_stat)
+	{
+		case ZBX_PROC_STAT_ALL:
+			return SUCCEED;
+		case ZBX_PROC_STAT_RUN:
+			return ('R' == entry->state) ? SUCCEED : FAIL;
+		case ZBX_PROC_STAT_SLEEP:
+			return ('S' == entry->state) ? SUCCEED : FAIL;
+		case ZBX_PROC_STAT_ZOMB:
+			return ('Z' == entry->state) ? SUCCEED : FAIL;
+		case ZBX_PROC_STAT_DISK:
+			return ('D' == entry->state) ? SUCCEED : FAIL;
+		case ZBX_PROC_STAT_TRACE:
+			return ('T' == entry->state) ? SUCCEED : FAIL;
+		default:
+			return FAIL;
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: Read amount of memory in bytes from a string in /proc file.       *
@@ -415,7 +722,7 @@ static int	check_procstate(FILE *f_stat, int zbx_proc_stat)
  ******************************************************************************/
 int	byte_value_from_proc_file(FILE *f, const char *label, const char *guard, zbx_uint64_t *bytes)
 {
-	char	buf[MAX_STRING_LEN], *p_value, *p_unit;
+	char	buf[MAX_STRING_LEN], *p_value;
 	size_t	label_len, guard_len;
 	long	pos = 0;
 	int	ret = NOTSUPPORTED;
@@ -451,35 +758,7 @@ int	byte_value_from_proc_file(FILE *f, const char *label, const char *guard, zbx
 		if (0 != strncmp(buf, label, label_len))
 			continue;
 
-		if (NULL == (p_unit = strrchr(p_value, ' ')))
-		{
-			ret = FAIL;
-			break;
-		}
-
-		*p_unit++ = '\0';
-
-		while (' ' == *p_value)
-			p_value++;
-
-		if (FAIL == zbx_is_uint64(p_value, bytes))
-		{
-			ret = FAIL;
-			break;
-		}
-
-		zbx_rtrim(p_unit, "\n");
-
-		if (0 == strcasecmp(p_unit, "kB"))
-			*bytes <<= 10;
-		else if (0 == strcasecmp(p_unit, "mB"))
-			*bytes <<= 20;
-		else if (0 == strcasecmp(p_unit, "GB"))
-			*bytes <<= 30;
-		else if (0 == strcasecmp(p_unit, "TB"))
-			*bytes <<= 40;
-
-		ret = SUCCEED;
+		ret = proc_parse_bytes(p_value, bytes);
 		break;
 	}
 
@@ -517,14 +796,11 @@ int	proc_mem(AGENT_REQUEST *request, AGENT_RESULT *result)
 #define ZBX_VMEXE	12
 #define ZBX_VMPTE	13
 
-	char		tmp[MAX_STRING_LEN], *procname, *proccomm, *param;
-	DIR		*dir;
-	struct dirent	*entries;
+	char		*procname, *proccomm, *param, *error = NULL;
 	struct passwd	*usrinfo;
-	FILE		*f_cmd = NULL, *f_stat = NULL;
 	zbx_uint64_t	mem_size = 0, byte_value = 0, total_memory;
 	double		pct_size = 0.0, pct_value = 0.0;
-	int		do_task, res, proccount = 0, invalid_user = 0, invalid_read = 0;
+	int		i, do_task, res, proccount = 0, invalid_user = 0, invalid_read = 0;
 	int		mem_type_tried = 0, mem_type_code;
 	char		*mem_type = NULL;
 	const char	*mem_type_search = NULL;
@@ -674,41 +950,25 @@ int	proc_mem(AGENT_REQUEST *request, AGENT_RESULT *result)
 		}
 	}
 
-	if (NULL == (dir = opendir("/proc")))
+	if (SUCCEED != proc_snapshot_get(&error))
 	{
-		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot open /proc: %s", zbx_strerror(errno)));
+		SET_MSG_RESULT(result, error);
 		return SYSINFO_RET_FAIL;
 	}
 
-	while (NULL != (entries = readdir(dir)))
+	for (i = 0; i < snapshot.entries_num; i++)
 	{
-		zbx_fclose(f_cmd);
-		zbx_fclose(f_stat);
+		const proc_snapshot_entry_t	*entry = &snapshot.entries[i];
 
-		if (0 == atoi(entries->d_name))
+		if (FAIL == check_procname(entry, procname))
 			continue;
 
-		zbx_snprintf(tmp, sizeof(tmp), "/proc/%s/cmdline", entries->d_name);
-
-		if (NULL == (f_cmd = fopen(tmp, "r")))
+		if (FAIL == check_user(entry, usrinfo))
 			continue;
 
-		zbx_snprintf(tmp, sizeof(tmp), "/proc/%s/status", entries->d_name);
-
-		if (NULL == (f_stat = fopen(tmp, "r")))
+		if (FAIL == check_proccomm(entry, proccomm))
 			continue;
 
-		if (FAIL == check_procname(f_cmd, f_stat, procname))
-			continue;
-
-		if (FAIL == check_user(f_stat, usrinfo))
-			continue;
-
-		if (FAIL == check_proccomm(f_cmd, proccomm))
-			continue;
-
-		rewind(f_stat);
-
 		if (0 == mem_type_tried)
 			mem_type_tried = 1;
 
@@ -726,7 +986,7 @@ int	proc_mem(AGENT_REQUEST *request, AGENT_RESULT *result)
 			case ZBX_VMSTK:
 			case ZBX_VMEXE:
 			case ZBX_VMPTE:
-				res = byte_value_from_proc_file(f_stat, mem_type_search, NULL, &byte_value);
+				res = proc_snapshot_get_mem(entry, mem_type_search, &byte_value);
 
 				if (NOTSUPPORTED == res)
 					continue;
@@ -741,24 +1001,19 @@ int	proc_mem(AGENT_REQUEST *request, AGENT_RESULT *result)
 				{
 					zbx_uint64_t	m;
 
-					/* VmData, VmStk and VmExe follow in /proc/PID/status file in that order. */
-					/* Therefore we do not rewind f_stat between calls. */
-
 					mem_type_search = "VmData:\t";
 
-					if (SUCCEED == (res = byte_value_from_proc_file(f_stat, mem_type_search, NULL,
-							&byte_value)))
+					if (SUCCEED == (res = proc_snapshot_get_mem(entry, mem_type_search, &byte_value)))
 					{
 						mem_type_search = "VmStk:\t";
 
-						if (SUCCEED == (res = byte_value_from_proc_file(f_stat, mem_type_search,
-								NULL, &m)))
+						if (SUCCEED == (res = proc_snapshot_get_mem(entry, mem_type_search, &m)))
 						{
 							byte_value += m;
 							mem_type_search = "VmExe:\t";
 
-							if (SUCCEED == (res = byte_value_from_proc_file(f_stat,
-									mem_type_search, NULL, &m)))
+							if (SUCCEED == (res = proc_snapshot_get_mem(entry, mem_type_search,
+									&m)))
 							{
 								byte_value += m;
 							}
@@ -783,7 +1038,7 @@ int	proc_mem(AGENT_REQUEST *request, AGENT_RESULT *result)
 				break;
 			case ZBX_PMEM:
 				mem_type_search = "VmRSS:\t";
-				res = byte_value_from_proc_file(f_stat, mem_type_search, NULL, &byte_value);
+				res = proc_snapshot_get_mem(entry, mem_type_search, &byte_value);
 
 				if (SUCCEED == res)
 				{
@@ -831,10 +1086,6 @@ int	proc_mem(AGENT_REQUEST *request, AGENT_RESULT *result)
 		}
 	}
 clean:
-	zbx_fclose(f_cmd);
-	zbx_fclose(f_stat);
-	closedir(dir);
-
 	if ((0 == proccount && 0 != mem_type_tried) || 0 != invalid_read)
 	{
 		char	*s;
@@ -880,12 +1131,9 @@ out:
 
 int	proc_num(AGENT_REQUEST *request, AGENT_RESULT *result)
 {
-	char		tmp[MAX_STRING_LEN], *procname, *proccomm, *param;
-	DIR		*dir;
-	struct dirent	*entries;
+	char		*procname, *proccomm, *param, *error = NULL;
 	struct passwd	*usrinfo;
-	FILE		*f_cmd = NULL, *f_stat = NULL;
-	int		proccount = 0, invalid_user = 0, zbx_proc_stat;
+	int		i, proccount = 0, invalid_user = 0, zbx_proc_stat;
 
 	if (4 < request->nparam)
 	{
@@ -940,47 +1188,30 @@ int	proc_num(AGENT_REQUEST *request, AGENT_RESULT *result)
 	if (1 == invalid_user)	/* handle 0 for non-existent user after all parameters have been parsed and validated */
 		goto out;
 
-	if (NULL == (dir = opendir("/proc")))
+	if (SUCCEED != proc_snapshot_get(&error))
 	{
-		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot open /proc: %s", zbx_strerror(errno)));
+		SET_MSG_RESULT(result, error);
 		return SYSINFO_RET_FAIL;
 	}
 
-	while (NULL != (entries = readdir(dir)))
+	for (i = 0; i < snapshot.entries_num; i++)
 	{
-		zbx_fclose(f_cmd);
-		zbx_fclose(f_stat);
-
-		if (0 == atoi(entries->d_name))
-			continue;
-
-		zbx_snprintf(tmp, sizeof(tmp), "/proc/%s/cmdline", entries->d_name);
-
-		if (NULL == (f_cmd = fopen(tmp, "r")))
-			continue;
-
-		zbx_snprintf(tmp, sizeof(tmp), "/proc/%s/status", entries->d_name);
-
-		if (NULL == (f_stat = fopen(tmp, "r")))
-			continue;
+		const proc_snapshot_entry_t	*entry = &snapshot.entries[i];
 
-		if (FAIL == check_procname(f_cmd, f_stat, procname))
+		if (FAIL == check_procname(entry, procname))
 			continue;
 
-		if (FAIL == check_user(f_stat, usrinfo))
+		if (FAIL == check_user(entry, usrinfo))
 			continue;
 
-		if (FAIL == check_proccomm(f_cmd, proccomm))
+		if (FAIL == check_proccomm(entry, proccomm))
 			continue;
 
-		if (FAIL == check_procstate(f_stat, zbx_proc_stat))
+		if (FAIL == check_procstate(entry, zbx_proc_stat))
 			continue;
 
 		proccount++;
 	}
-	zbx_fclose(f_cmd);
-	zbx_fclose(f_stat);
-	closedir(dir);
 out:
 	SET_UI64_RESULT(result, proccount);
 
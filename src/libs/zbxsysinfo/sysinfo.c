@@ -1779,134 +1779,424 @@ static int	deserialize_agent_result(char *data, AGENT_RESULT *result)
 
 /******************************************************************************
  *                                                                            *
- * Purpose: execute metric in a separate process/thread so it can be          *
- *          killed/terminated when timeout is detected                        *
+ * Purpose: serialize agent request to transfer over pipe                     *
  *                                                                            *
- * Parameters: metric_func - [IN] the metric function to execute              *
- *             ...                the metric function parameters              *
+ * Parameters: data        - [IN/OUT] the data buffer                         *
+ *             data_alloc  - [IN/OUT] the data buffer allocated size          *
+ *             data_offset - [IN/OUT] the data buffer data size               *
+ *             metric_func - [IN] the metric function to execute              *
+ *             request     - [IN] the agent request                           *
  *                                                                            *
- * Return value:                                                              *
- *         SYSINFO_RET_OK - the metric was executed successfully              *
- *         SYSINFO_RET_FAIL - otherwise                                       *
+ * Comments: The request is serialized as                                     *
+ *           [func][lastlogsize][mtime][nparam][key]([type][param])...        *
+ *           where strings are null terminated. The metric function address   *
+ *           is valid in the data process because it is forked from the       *
+ *           requesting process.                                              *
  *                                                                            *
  ******************************************************************************/
-int	zbx_execute_threaded_metric(zbx_metric_func_t metric_func, AGENT_REQUEST *request, AGENT_RESULT *result)
+static void	serialize_agent_request(char **data, size_t *data_alloc, size_t *data_offset,
+		zbx_metric_func_t metric_func, const AGENT_REQUEST *request)
 {
-	int	ret = SYSINFO_RET_OK;
-	pid_t	pid;
-	int	fds[2], n, status;
-	char	buffer[MAX_STRING_LEN], *data;
-	size_t	data_alloc = MAX_STRING_LEN, data_offset = 0;
+	size_t	size;
+	int	i;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() key:'%s'", __func__, request->key);
+	size = sizeof(metric_func) + sizeof(request->lastlogsize) + sizeof(int) * 2 + strlen(request->key) + 1;
+
+	for (i = 0; i < request->nparam; i++)
+		size += sizeof(int) + strlen(request->params[i]) + 1;
 
-	if (-1 == pipe(fds))
+	if (*data_alloc - *data_offset < size)
 	{
-		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot create data pipe: %s", strerror_from_system(errno)));
-		ret = SYSINFO_RET_FAIL;
-		goto out;
+		while (*data_alloc - *data_offset < size)
+			*data_alloc = (size_t)(*data_alloc * 1.5);
+
+		*data = (char *)zbx_realloc(*data, *data_alloc);
 	}
 
-	if (-1 == (pid = zbx_fork()))
+#define SERIALIZE_VALUE(value)							\
+	do									\
+	{									\
+		memcpy(*data + *data_offset, &(value), sizeof(value));		\
+		*data_offset += sizeof(value);					\
+	}									\
+	while (0)
+
+#define SERIALIZE_STR(str)							\
+	do									\
+	{									\
+		size_t	len = strlen(str) + 1;					\
+		memcpy(*data + *data_offset, str, len);				\
+		*data_offset += len;						\
+	}									\
+	while (0)
+
+	SERIALIZE_VALUE(metric_func);
+	SERIALIZE_VALUE(request->lastlogsize);
+	SERIALIZE_VALUE(request->mtime);
+	SERIALIZE_VALUE(request->nparam);
+	SERIALIZE_STR(request->key);
+
+	for (i = 0; i < request->nparam; i++)
 	{
-		close(fds[0]);
-		close(fds[1]);
-		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot fork data process: %s", strerror_from_system(errno)));
-		ret = SYSINFO_RET_FAIL;
-		goto out;
+		int	type = REQUEST_PARAMETER_TYPE_UNDEFINED;
+
+		if (NULL != request->types)
+			type = (int)request->types[i];
+
+		SERIALIZE_VALUE(type);
+		SERIALIZE_STR(request->params[i]);
 	}
 
-	data = (char *)zbx_malloc(NULL, data_alloc);
+#undef SERIALIZE_VALUE
+#undef SERIALIZE_STR
+}
 
-	if (0 == pid)
-	{
-		zabbix_log(LOG_LEVEL_DEBUG, "executing in data process for key:'%s'", request->key);
+/******************************************************************************
+ *                                                                            *
+ * Purpose: deserialize agent request                                         *
+ *                                                                            *
+ * Parameters: data        - [IN] the data to deserialize                     *
+ *             metric_func - [OUT] the metric function to execute             *
+ *             request     - [OUT] the agent request                          *
+ *                                                                            *
+ ******************************************************************************/
+static void	deserialize_agent_request(const char *data, zbx_metric_func_t *metric_func, AGENT_REQUEST *request)
+{
+	int	i;
 
-		zbx_set_metric_thread_signal_handler();
+	memcpy(metric_func, data, sizeof(*metric_func));
+	data += sizeof(*metric_func);
+	memcpy(&request->lastlogsize, data, sizeof(request->lastlogsize));
+	data += sizeof(request->lastlogsize);
+	memcpy(&request->mtime, data, sizeof(request->mtime));
+	data += sizeof(request->mtime);
+	memcpy(&request->nparam, data, sizeof(request->nparam));
+	data += sizeof(request->nparam);
 
-		close(fds[0]);
+	request->key = zbx_strdup(NULL, data);
+	data += strlen(data) + 1;
 
-		ret = metric_func(request, result);
-		serialize_agent_result(&data, &data_alloc, &data_offset, ret, result);
+	if (0 == request->nparam)
+		return;
 
-		ret = zbx_write_all(fds[1], data, data_offset);
+	request->params = (char **)zbx_malloc(NULL, sizeof(char *) * request->nparam);
+	request->types = (zbx_request_parameter_type_t *)zbx_malloc(NULL,
+			sizeof(zbx_request_parameter_type_t) * request->nparam);
 
-		zbx_free(data);
-		zbx_free_agent_result(result);
+	for (i = 0; i < request->nparam; i++)
+	{
+		int	type;
 
-		close(fds[1]);
+		memcpy(&type, data, sizeof(type));
+		data += sizeof(type);
+		request->types[i] = (zbx_request_parameter_type_t)type;
 
-		exit(SUCCEED == ret ? EXIT_SUCCESS : EXIT_FAILURE);
+		request->params[i] = zbx_strdup(NULL, data);
+		data += strlen(data) + 1;
 	}
+}
 
-	close(fds[1]);
+/* the data process executing metrics of the current process */
+static pid_t	metric_helper_pid = -1;
+static int	metric_helper_in = -1;		/* pipe for reading results from data process */
+static int	metric_helper_out = -1;		/* pipe for writing requests to data process */
 
-	zbx_alarm_on(sysinfo_get_config_timeout());
+/******************************************************************************
+ *                                                                            *
+ * Purpose: read the specified number of bytes from pipe                      *
+ *                                                                            *
+ * Return value: SUCCEED - the data was read                                  *
+ *               FAIL    - end of file, read error or timeout                 *
+ *                                                                            *
+ ******************************************************************************/
+static int	metric_helper_read(int fd, char *buf, size_t len)
+{
+	ssize_t	n;
 
-	while (0 != (n = read(fds[0], buffer, sizeof(buffer))))
+	while (0 < len)
 	{
-		if (SUCCEED == zbx_alarm_timed_out())
+		if (0 >= (n = read(fd, buf, len)))
 		{
-			SET_MSG_RESULT(result, zbx_strdup(NULL, "Timeout while waiting for data."));
-			kill(pid, SIGKILL);
-			ret = SYSINFO_RET_FAIL;
-			break;
+			if (-1 == n && EINTR == errno && SUCCEED != zbx_alarm_timed_out())
+				continue;
+
+			if (0 == n)
+				errno = 0;
+
+			return FAIL;
 		}
 
-		if (-1 == n)
-		{
-			SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Error while reading data: %s", zbx_strerror(errno)));
-			kill(pid, SIGKILL);
-			ret = SYSINFO_RET_FAIL;
+		buf += n;
+		len -= (size_t)n;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: write frame of the data process protocol                          *
+ *                                                                            *
+ * Comments: The frame is [len][data] where len is 4 bytes.                   *
+ *                                                                            *
+ ******************************************************************************/
+static int	metric_helper_write_frame(int fd, const char *data, size_t data_len)
+{
+	zbx_uint32_t	len = (zbx_uint32_t)data_len;
+
+	if (SUCCEED != zbx_write_all(fd, (const char *)&len, sizeof(len)))
+		return FAIL;
+
+	return zbx_write_all(fd, data, data_len);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: read frame of the data process protocol                           *
+ *                                                                            *
+ * Parameters: fd         - [IN] the pipe to read                             *
+ *             data       - [IN/OUT] the data buffer                          *
+ *             data_alloc - [IN/OUT] the data buffer allocated size           *
+ *                                                                            *
+ ******************************************************************************/
+static int	metric_helper_read_frame(int fd, char **data, size_t *data_alloc)
+{
+	zbx_uint32_t	len;
+
+	if (SUCCEED != metric_helper_read(fd, (char *)&len, sizeof(len)))
+		return FAIL;
+
+	if (*data_alloc < (size_t)len + 1)
+	{
+		*data_alloc = (size_t)len + 1;
+		*data = (char *)zbx_realloc(*data, *data_alloc);
+	}
+
+	if (SUCCEED != metric_helper_read(fd, *data, len))
+		return FAIL;
+
+	(*data)[len] = '\0';
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: data process main loop - execute metrics until the requesting     *
+ *          process closes the pipe                                           *
+ *                                                                            *
+ ******************************************************************************/
+static void	metric_helper_run(int fd_in, int fd_out)
+{
+	char		*data;
+	size_t		data_alloc = MAX_STRING_LEN, data_offset;
+	long		fd, fd_max;
+
+	zbx_set_metric_thread_signal_handler();
+
+	/* do not keep connections of the requesting process open */
+	if (-1 == (fd_max = sysconf(_SC_OPEN_MAX)))
+		fd_max = 1024;
+
+	for (fd = 3; fd < fd_max; fd++)
+	{
+		if (fd != fd_in && fd != fd_out)
+			close((int)fd);
+	}
+
+	data = (char *)zbx_malloc(NULL, data_alloc);
+
+	while (SUCCEED == metric_helper_read_frame(fd_in, &data, &data_alloc))
+	{
+		zbx_metric_func_t	metric_func;
+		AGENT_REQUEST		request;
+		AGENT_RESULT		result;
+		int			ret;
+
+		zbx_init_agent_request(&request);
+		zbx_init_agent_result(&result);
+
+		deserialize_agent_request(data, &metric_func, &request);
+
+		zabbix_log(LOG_LEVEL_DEBUG, "executing in data process for key:'%s'", request.key);
+
+		ret = metric_func(&request, &result);
+
+		data_offset = 0;
+		serialize_agent_result(&data, &data_alloc, &data_offset, ret, &result);
+
+		zbx_free_agent_result(&result);
+		zbx_free_agent_request(&request);
+
+		if (SUCCEED != metric_helper_write_frame(fd_out, data, data_offset))
 			break;
-		}
+	}
 
-		if ((int)(data_alloc - data_offset) < n + 1)
-		{
-			while ((int)(data_alloc - data_offset) < n + 1)
-				data_alloc = (size_t)(data_alloc * 1.5);
+	zbx_free(data);
 
-			data = (char *)zbx_realloc(data, data_alloc);
-		}
+	exit(EXIT_SUCCESS);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: fork the data process                                             *
+ *                                                                            *
+ ******************************************************************************/
+static int	metric_helper_start(char **error)
+{
+	int	fds_req[2], fds_res[2];
 
-		memcpy(data + data_offset, buffer, n);
-		data_offset += n;
-		data[data_offset] = '\0';
+	if (-1 == pipe(fds_req))
+	{
+		*error = zbx_dsprintf(NULL, "Cannot create data pipe: %s", strerror_from_system(errno));
+		return FAIL;
 	}
 
-	zbx_alarm_off();
+	if (-1 == pipe(fds_res))
+	{
+		*error = zbx_dsprintf(NULL, "Cannot create data pipe: %s", strerror_from_system(errno));
+		close(fds_req[0]);
+		close(fds_req[1]);
+		return FAIL;
+	}
 
-	close(fds[0]);
+	if (-1 == (metric_helper_pid = zbx_fork()))
+	{
+		*error = zbx_dsprintf(NULL, "Cannot fork data process: %s", strerror_from_system(errno));
+		close(fds_req[0]);
+		close(fds_req[1]);
+		close(fds_res[0]);
+		close(fds_res[1]);
+		return FAIL;
+	}
 
-	while (-1 == waitpid(pid, &status, 0))
+	if (0 == metric_helper_pid)
+	{
+		close(fds_req[1]);
+		close(fds_res[0]);
+
+		metric_helper_run(fds_req[0], fds_res[1]);
+	}
+
+	close(fds_req[0]);
+	close(fds_res[1]);
+
+	metric_helper_out = fds_req[1];
+	metric_helper_in = fds_res[0];
+
+	zabbix_log(LOG_LEVEL_DEBUG, "started data process pid:%d", (int)metric_helper_pid);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: terminate the data process, the next metric will start a new one  *
+ *                                                                            *
+ * Return value: the data process exit status                                 *
+ *                                                                            *
+ ******************************************************************************/
+static int	metric_helper_stop(int force)
+{
+	int	status = 0;
+
+	close(metric_helper_out);
+	close(metric_helper_in);
+
+	if (0 != force)
+		kill(metric_helper_pid, SIGKILL);
+
+	while (-1 == waitpid(metric_helper_pid, &status, 0))
 	{
 		if (EINTR != errno)
 		{
 			zabbix_log(LOG_LEVEL_ERR, "failed to wait on child processes: %s", zbx_strerror(errno));
-			ret = SYSINFO_RET_FAIL;
 			break;
 		}
 	}
 
-	if (SYSINFO_RET_OK == ret)
+	metric_helper_pid = -1;
+	metric_helper_in = -1;
+	metric_helper_out = -1;
+
+	return status;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: execute metric in a separate process so it can be killed when     *
+ *          timeout is detected                                               *
+ *                                                                            *
+ * Parameters: metric_func - [IN] the metric function to execute              *
+ *             ...                the metric function parameters              *
+ *                                                                            *
+ * Return value:                                                              *
+ *         SYSINFO_RET_OK - the metric was executed successfully              *
+ *         SYSINFO_RET_FAIL - otherwise                                       *
+ *                                                                            *
+ * Comments: The data process is forked on first use and serves the following *
+ *           metrics of the calling process. It is replaced only after a      *
+ *           timeout or failure.                                              *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_execute_threaded_metric(zbx_metric_func_t metric_func, AGENT_REQUEST *request, AGENT_RESULT *result)
+{
+	int	ret = SYSINFO_RET_OK, status;
+	char	*data, *error = NULL;
+	size_t	data_alloc = MAX_STRING_LEN, data_offset = 0;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() key:'%s'", __func__, request->key);
+
+	if (-1 == metric_helper_pid && SUCCEED != metric_helper_start(&error))
+	{
+		SET_MSG_RESULT(result, error);
+		ret = SYSINFO_RET_FAIL;
+		goto out;
+	}
+
+	data = (char *)zbx_malloc(NULL, data_alloc);
+
+	serialize_agent_request(&data, &data_alloc, &data_offset, metric_func, request);
+
+	if (SUCCEED != metric_helper_write_frame(metric_helper_out, data, data_offset))
+	{
+		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot send request to data process: %s",
+				zbx_strerror(errno)));
+		metric_helper_stop(1);
+		ret = SYSINFO_RET_FAIL;
+		goto clean;
+	}
+
+	zbx_alarm_on(sysinfo_get_config_timeout());
+
+	if (SUCCEED != metric_helper_read_frame(metric_helper_in, &data, &data_alloc))
 	{
-		if (0 == WIFEXITED(status))
+		if (SUCCEED == zbx_alarm_timed_out())
 		{
-			SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Data gathering process terminated unexpectedly with"
-					" error %d.", status));
-			kill(pid, SIGKILL);
-			ret = SYSINFO_RET_FAIL;
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Timeout while waiting for data."));
+			metric_helper_stop(1);
 		}
-		else if (EXIT_SUCCESS != WEXITSTATUS(status))
+		else if (0 != errno)
 		{
-			SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Data gathering process terminated with error %d.",
-					status));
-			ret = SYSINFO_RET_FAIL;
+			SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Error while reading data: %s",
+					zbx_strerror(errno)));
+			metric_helper_stop(1);
 		}
 		else
-			ret = deserialize_agent_result(data, result);
+		{
+			status = metric_helper_stop(0);
+			SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Data gathering process terminated unexpectedly"
+					" with error %d.", status));
+		}
+
+		ret = SYSINFO_RET_FAIL;
 	}
 
+	zbx_alarm_off();
+
+	if (SYSINFO_RET_OK == ret)
+		ret = deserialize_agent_result(data, result);
+clean:
 	zbx_free(data);
 out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s '%s'", __func__, zbx_sysinfo_ret_string(ret),
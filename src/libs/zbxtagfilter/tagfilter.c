@@ -24,6 +24,15 @@
 #include "zbxalgo.h"
 
 ZBX_PTR_VECTOR_IMPL(match_tags, zbx_match_tag_t*)
+ZBX_VECTOR_IMPL(match_tags_filter, zbx_match_tags_filter_t)
+
+/* tag filter index entry, referencing filters by their index in the filter vector */
+typedef struct
+{
+	const char		*tag;
+	zbx_vector_uint32_t	filters;
+}
+zbx_match_tags_name_t;
 
 static int	match_single_tag(const zbx_match_tag_t *mtag, zbx_tag_t * const *tags, int tags_num)
 {
@@ -251,3 +260,220 @@ void	zbx_match_tag_free(zbx_match_tag_t *tag)
 	zbx_free(tag->value);
 	zbx_free(tag);
 }
+
+static zbx_hash_t	match_tags_name_hash_func(const void *data)
+{
+	const zbx_match_tags_name_t	*name = (const zbx_match_tags_name_t *)data;
+
+	return ZBX_DEFAULT_STRING_HASH_ALGO(name->tag, strlen(name->tag), ZBX_DEFAULT_HASH_SEED);
+}
+
+static void	match_tags_name_clean(void *data)
+{
+	zbx_match_tags_name_t	*name = (zbx_match_tags_name_t *)data;
+
+	zbx_vector_uint32_destroy(&name->filters);
+}
+
+static int	match_tags_filterid_compare(const void *d1, const void *d2)
+{
+	const zbx_uint32_t	*id1 = (const zbx_uint32_t *)d1;
+	const zbx_uint32_t	*id2 = (const zbx_uint32_t *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(*id1, *id2);
+
+	return 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: initialize tag filter index                                       *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_match_tags_index_init(zbx_match_tags_index_t *index)
+{
+	zbx_vector_match_tags_filter_create(&index->filters);
+	zbx_hashset_create_ext(&index->names, 0, match_tags_name_hash_func, ZBX_DEFAULT_STR_COMPARE_FUNC,
+			match_tags_name_clean, ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC,
+			ZBX_DEFAULT_MEM_FREE_FUNC);
+	zbx_vector_uint32_create(&index->always);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: destroy tag filter index                                          *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_match_tags_index_destroy(zbx_match_tags_index_t *index)
+{
+	zbx_vector_uint32_destroy(&index->always);
+	zbx_hashset_destroy(&index->names);
+	zbx_vector_match_tags_filter_destroy(&index->filters);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: register filter under the specified tag name                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	match_tags_index_add_name(zbx_match_tags_index_t *index, const char *tag, zbx_uint32_t filter)
+{
+	zbx_match_tags_name_t	*name, name_local;
+
+	name_local.tag = tag;
+
+	if (NULL == (name = (zbx_match_tags_name_t *)zbx_hashset_search(&index->names, &name_local)))
+	{
+		name = (zbx_match_tags_name_t *)zbx_hashset_insert(&index->names, &name_local, sizeof(name_local));
+		zbx_vector_uint32_create(&name->filters);
+	}
+
+	zbx_vector_uint32_append(&name->filters, filter);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: check if match tag can succeed for entity without tag having the  *
+ *          match tag name                                                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	match_tag_accepts_missing(const zbx_match_tag_t *mtag)
+{
+	switch (mtag->op)
+	{
+		case ZBX_CONDITION_OPERATOR_NOT_EXIST:
+		case ZBX_CONDITION_OPERATOR_NOT_EQUAL:
+		case ZBX_CONDITION_OPERATOR_NOT_LIKE:
+			return SUCCEED;
+		default:
+			return FAIL;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: add filter to tag filter index                                    *
+ *                                                                            *
+ * Parameters: index      - [IN] the tag filter index                         *
+ *             eval_type  - [IN] evaluation type (and/or, or)                 *
+ *             match_tags - [IN] filter tags, sorted by tag names. They are   *
+ *                               referenced by the index and must not be      *
+ *                               freed while the index is used.               *
+ *                                                                            *
+ * Comments: The filters are identified by the order they were added in,      *
+ *           starting with 0.                                                 *
+ *                                                                            *
+ *           Filter is indexed by tag names that an entity must have to match *
+ *           it. For and/or evaluation it is enough to index filter by one of *
+ *           the tag names having only positive conditions, for or evaluation *
+ *           filter is indexed by all its tag names unless it has negative    *
+ *           conditions. Other filters are checked for all entities.          *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_match_tags_index_add(zbx_match_tags_index_t *index, int eval_type,
+		const zbx_vector_match_tags_t *match_tags)
+{
+	zbx_match_tags_filter_t	filter = {.eval_type = eval_type, .match_tags = match_tags};
+	zbx_uint32_t		filterid = (zbx_uint32_t)index->filters.values_num;
+	int			i, start;
+
+	zbx_vector_match_tags_filter_append(&index->filters, filter);
+
+	if (0 == match_tags->values_num)
+		goto always;
+
+	if (ZBX_CONDITION_EVAL_TYPE_AND_OR == eval_type)
+	{
+		for (start = 0; start < match_tags->values_num; start = i)
+		{
+			int	required = SUCCEED;
+
+			for (i = start; i < match_tags->values_num &&
+					0 == strcmp(match_tags->values[i]->tag, match_tags->values[start]->tag); i++)
+			{
+				if (SUCCEED == match_tag_accepts_missing(match_tags->values[i]))
+					required = FAIL;
+			}
+
+			if (SUCCEED == required)
+			{
+				match_tags_index_add_name(index, match_tags->values[start]->tag, filterid);
+				return;
+			}
+		}
+
+		goto always;
+	}
+
+	if (ZBX_CONDITION_EVAL_TYPE_OR == eval_type)
+	{
+		for (i = 0; i < match_tags->values_num; i++)
+		{
+			if (SUCCEED == match_tag_accepts_missing(match_tags->values[i]))
+				goto always;
+		}
+
+		for (i = 0; i < match_tags->values_num; i++)
+		{
+			if (0 == i || 0 != strcmp(match_tags->values[i]->tag, match_tags->values[i - 1]->tag))
+				match_tags_index_add_name(index, match_tags->values[i]->tag, filterid);
+		}
+
+		return;
+	}
+always:
+	zbx_vector_uint32_append(&index->always, filterid);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get filters matching entity tags                                  *
+ *                                                                            *
+ * Parameters: index       - [IN] the tag filter index                        *
+ *             entity_tags - [IN] entity tags, sorted by tag names            *
+ *             filters     - [OUT] the matching filters, in the order they    *
+ *                                 were added to index                        *
+ *                                                                            *
+ * Comments: Only filters that can match the entity tag names are checked.    *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_match_tags_index_match(const zbx_match_tags_index_t *index, const zbx_vector_tags_t *entity_tags,
+		zbx_vector_uint32_t *filters)
+{
+	zbx_vector_uint32_t	candidates;
+	int			i;
+
+	zbx_vector_uint32_create(&candidates);
+	zbx_vector_uint32_append_array(&candidates, index->always.values, index->always.values_num);
+
+	if (0 != index->names.num_data)
+	{
+		for (i = 0; i < entity_tags->values_num; i++)
+		{
+			zbx_match_tags_name_t	*name, name_local;
+
+			if (0 != i && 0 == strcmp(entity_tags->values[i]->tag, entity_tags->values[i - 1]->tag))
+				continue;
+
+			name_local.tag = entity_tags->values[i]->tag;
+
+			if (NULL == (name = (zbx_match_tags_name_t *)zbx_hashset_search(&index->names, &name_local)))
+				continue;
+
+			zbx_vector_uint32_append_array(&candidates, name->filters.values, name->filters.values_num);
+		}
+
+		zbx_vector_uint32_sort(&candidates, match_tags_filterid_compare);
+		zbx_vector_uint32_uniq(&candidates, match_tags_filterid_compare);
+	}
+
+	for (i = 0; i < candidates.values_num; i++)
+	{
+		const zbx_match_tags_filter_t	*filter = &index->filters.values[candidates.values[i]];
+
+		if (SUCCEED == zbx_match_tags(filter->eval_type, filter->match_tags, entity_tags))
+			zbx_vector_uint32_append(filters, candidates.values[i]);
+	}
+
+	zbx_vector_uint32_destroy(&candidates);
+}
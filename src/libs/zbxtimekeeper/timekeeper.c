@@ -21,25 +21,40 @@
 #include "zbxcommon.h"
 #include "zbxalgo.h"
 #include "zbxtimekeeper.h"
+#include "zbxmutexs.h"
 
 #define MAX_HISTORY	60
 
-#define ZBX_TIMEKEEPER_FLUSH_DELAY		(ZBX_TIMEKEEPER_DELAY * 0.5)
+/* the number of attempts to read consistent unit state before using whatever was read */
+#define TIMEKEEPER_READ_RETRIES		10
 
-/* unit state cache, updated only by the execution units themselves */
+#define TIMEKEEPER_CACHE_LINE_SIZE	64
+
+#if defined(HAVE_ATOMIC_BUILTINS)
+#	define TIMEKEEPER_LOAD(var)		zbx_atomic_load(&(var))
+#	define TIMEKEEPER_STORE(var, value)	zbx_atomic_store(&(var), value)
+#else
+#	define TIMEKEEPER_LOAD(var)		(var)
+#	define TIMEKEEPER_STORE(var, value)	(var) = (value)
+#endif
+
+/* unit state, written only by the execution units themselves and read by collector without locking */
 typedef struct
 {
-	/* the current usage statistics */
-	zbx_uint64_t	counter[ZBX_PROCESS_STATE_COUNT];
+	/* the number of started updates, odd while update is in progress */
+	zbx_uint64_t	seq;
 
-	/* ticks of the last timekeeper update */
-	clock_t		ticks;
+	/* the total ticks spent in each state up to the last update */
+	zbx_uint64_t	total[ZBX_PROCESS_STATE_COUNT];
 
-	/* ticks of the last timekeeper cache flush */
-	clock_t		ticks_flush;
+	/* ticks of the last timekeeper update, 0 if the unit has not reported its state yet */
+	clock_t		ticks;
 
 	/* the current process state (see ZBX_PROCESS_STATE_* defines) */
 	unsigned char	state;
+
+	/* keep the frequently written unit state apart from data written by other units and collector */
+	char		pad[TIMEKEEPER_CACHE_LINE_SIZE];
 }
 zbx_timekeeper_unit_cache_t;
 
@@ -49,11 +64,10 @@ typedef struct
 	/* historical unit state data */
 	zbx_uint64_t		h_counter[ZBX_PROCESS_STATE_COUNT][MAX_HISTORY];
 
-	/* unit state data for the current data gathering cycle */
-	zbx_uint64_t		counter[ZBX_PROCESS_STATE_COUNT];
+	/* the unit total ticks that were already applied to the historical state data */
+	zbx_uint64_t		collected[ZBX_PROCESS_STATE_COUNT];
 
-	/* the unit state that was already applied to the historical state data */
-	zbx_uint64_t		counter_used[ZBX_PROCESS_STATE_COUNT];
+	char			pad[TIMEKEEPER_CACHE_LINE_SIZE];
 
 	/* the unit state cache */
 	zbx_timekeeper_unit_cache_t	cache;
@@ -270,68 +284,73 @@ void	zbx_timekeeper_free(zbx_timekeeper_t *timekeeper)
  *                                (see  ZBX_PROCESS_STATE_* defines)          *
  *                                                                            *
  * Comments: This function is called by process/threads whenever they         *
- *           busy/idle state changes. It updates local cache and flushes it   *
- *           once per half timekeeper delay interval.                         *
+ *           busy/idle state changes. The unit state is written only by its   *
+ *           owner, so it is published without locking. The sequence          *
+ *           counter allows collector to detect and retry torn reads.         *
  *                                                                            *
  ******************************************************************************/
 void	zbx_timekeeper_update(zbx_timekeeper_t *timekeeper, int index, unsigned char state)
 {
-	zbx_timekeeper_unit_t	*unit;
-	clock_t			ticks;
+	zbx_timekeeper_unit_cache_t	*cache;
+	clock_t				ticks;
 
 	if (0 > index || index >= timekeeper->units_num)
 		return;
 
-	unit = timekeeper->units + index;
+	cache = &timekeeper->units[index].cache;
 
 	if (-1 == (ticks = zbx_times()))
 	{
 		zabbix_log(LOG_LEVEL_WARNING, "cannot get process times: %s", zbx_strerror(errno));
-		unit->cache.state = state;
+		TIMEKEEPER_STORE(cache->state, state);
 		return;
 	}
 
-	if (0 == unit->cache.ticks_flush)
-	{
-		unit->cache.ticks_flush = ticks;
-		unit->cache.state = state;
-		unit->cache.ticks = ticks;
+	if (cache->state == state && 0 != cache->ticks)
 		return;
+
+	TIMEKEEPER_STORE(cache->seq, cache->seq + 1);
+
+	if (0 != cache->ticks && ticks > cache->ticks)
+	{
+		TIMEKEEPER_STORE(cache->total[cache->state],
+				cache->total[cache->state] + (zbx_uint64_t)(ticks - cache->ticks));
 	}
 
-	/* update process statistics in local cache */
-	unit->cache.counter[unit->cache.state] += (zbx_uint64_t)(ticks - unit->cache.ticks);
+	TIMEKEEPER_STORE(cache->ticks, ticks);
+	TIMEKEEPER_STORE(cache->state, state);
 
-	if (ZBX_TIMEKEEPER_FLUSH_DELAY < (double)(ticks - unit->cache.ticks_flush) / (double)timekeeper->ticks_per_sec)
+	TIMEKEEPER_STORE(cache->seq, cache->seq + 1);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: read unit state published by the unit owner                       *
+ *                                                                            *
+ * Parameters: cache - [IN] the unit state cache                              *
+ *             total - [OUT] the total ticks spent in each state              *
+ *             ticks - [OUT] the ticks of the last unit update                *
+ *             state - [OUT] the current unit state                           *
+ *                                                                            *
+ ******************************************************************************/
+static void	timekeeper_read_unit(const zbx_timekeeper_unit_cache_t *cache, zbx_uint64_t *total, clock_t *ticks,
+		unsigned char *state)
+{
+	for (int i = 0; i < TIMEKEEPER_READ_RETRIES; i++)
 	{
-		timekeeper->sync->lock(timekeeper->sync->data);
+		zbx_uint64_t	seq;
 
-		for (int s = 0; s < ZBX_PROCESS_STATE_COUNT; s++)
-		{
-			/* If process did not update statistic counter during one timekeeper data         */
-			/* collection interval, then self timekeeper will collect statistics based on the */
-			/* current process state and the ticks passed since last timekeeper data          */
-			/* collection. This value is stored in counter_used and the local statistics      */
-			/* must be adjusted by this (already collected) value.                            */
-			if (unit->cache.counter[s] > unit->counter_used[s])
-			{
-				unit->cache.counter[s] -= unit->counter_used[s];
-				unit->counter[s] += unit->cache.counter[s];
-			}
+		seq = TIMEKEEPER_LOAD(cache->seq);
 
-			/* reset current cache statistics */
-			unit->counter_used[s] = 0;
-			unit->cache.counter[s] = 0;
-		}
+		for (int s = 0; s < ZBX_PROCESS_STATE_COUNT; s++)
+			total[s] = TIMEKEEPER_LOAD(cache->total[s]);
 
-		unit->cache.ticks_flush = ticks;
+		*ticks = TIMEKEEPER_LOAD(cache->ticks);
+		*state = TIMEKEEPER_LOAD(cache->state);
 
-		timekeeper->sync->unlock(timekeeper->sync->data);
+		if (0 == (seq & 1) && seq == TIMEKEEPER_LOAD(cache->seq))
+			break;
 	}
-
-	/* update local timekeeper cache */
-	unit->cache.state = state;
-	unit->cache.ticks = ticks;
 }
 
 /******************************************************************************
@@ -367,43 +386,56 @@ void	zbx_timekeeper_collect(zbx_timekeeper_t *timekeeper)
 	if (MAX_HISTORY <= (index = timekeeper->first + timekeeper->count))
 		index -= MAX_HISTORY;
 
-	if (timekeeper->count < MAX_HISTORY)
-		timekeeper->count++;
-	else if (++timekeeper->first == MAX_HISTORY)
-		timekeeper->first = 0;
-
 	if (0 > (last = index - 1))
 		last += MAX_HISTORY;
 
+	ticks_done = ticks - timekeeper->ticks_sync;
+
 	timekeeper->sync->lock(timekeeper->sync->data);
 
-	ticks_done = ticks - timekeeper->ticks_sync;
+	if (timekeeper->count < MAX_HISTORY)
+		timekeeper->count++;
+	else if (++timekeeper->first == MAX_HISTORY)
+		timekeeper->first = 0;
 
 	for (i = 0; i < timekeeper->units_num; i++)
 	{
+		zbx_uint64_t	total[ZBX_PROCESS_STATE_COUNT];
+		clock_t		unit_ticks;
+		unsigned char	state;
+
 		unit = timekeeper->units + i;
 
-		if (unit->cache.ticks_flush < timekeeper->ticks_sync)
+		timekeeper_read_unit(&unit->cache, total, &unit_ticks, &state);
+
+		for (int s = 0; s < ZBX_PROCESS_STATE_COUNT; s++)
+			unit->h_counter[s][index] = unit->h_counter[s][last];
+
+		/* units that have not reported their state yet are considered idle */
+		if (0 == unit_ticks)
 		{
-			/* If the process local cache was not flushed during the last timekeeper       */
-			/* data collection interval update the process statistics based on the current */
-			/* process state and ticks passed during the collection interval.              */
-			/* This will serve as good estimate until the timekeeper cache is flushed and  */
-			/* its counters adjusted by those values.                                      */
-			unit->counter[unit->cache.state] += (zbx_uint64_t)ticks_done;
-
-			/* store the estimated ticks to adjust the counters when flushing local cache */
-			unit->counter_used[unit->cache.state] += (zbx_uint64_t)ticks_done;
+			unit->h_counter[ZBX_PROCESS_STATE_IDLE][index] += (zbx_uint64_t)ticks_done;
+			continue;
 		}
 
+		/* The unit totals are updated only on state changes, so the time spent in */
+		/* the current state since the last update is estimated. Counters are not  */
+		/* allowed to go back, which will adjust the estimates once the unit       */
+		/* reports its real state.                                                 */
+		if (ZBX_PROCESS_STATE_COUNT > state && ticks > unit_ticks)
+			total[state] += (zbx_uint64_t)(ticks - unit_ticks);
+
 		for (int s = 0; s < ZBX_PROCESS_STATE_COUNT; s++)
 		{
 			/* The data is gathered as ticks spent in corresponding states during the */
 			/* timekeeper data collection interval. But in history the data are       */
 			/* stored as relative values. To achieve it we add the collected data to  */
 			/* the last values.                                                       */
-			unit->h_counter[s][index] = unit->h_counter[s][last] + unit->counter[s];
-			unit->counter[s] = 0;
+			if (total[s] > unit->collected[s])
+			{
+				unit->h_counter[s][index] += total[s] - unit->collected[s];
+				unit->collected[s] = total[s];
+			}
 		}
 	}
 
@@ -404,6 +404,174 @@ int	zbx_trends_parse_nextcheck(time_t from, const char *period_shift, time_t *ne
 	return SUCCEED;
 }
 
+#if defined(HAVE_POSTGRESQL) || defined(HAVE_MYSQL)
+/* aggregated values of the rollup periods (days) covered by the requested trends period */
+typedef struct
+{
+	double	min;
+	double	max;
+	double	avg;
+	double	num;
+	double	sum;
+}
+zbx_trends_rollup_t;
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get aggregated values of full days within trends period from      *
+ *          daily rollup table and build condition selecting the remaining    *
+ *          hours from hourly trends table                                    *
+ *                                                                            *
+ * Parameters: table      - [IN] trends table name                            *
+ *             itemid     - [IN]                                              *
+ *             start      - [IN] period start time in seconds since Epoch     *
+ *             end        - [IN] period end time in seconds since Epoch       *
+ *             rollup     - [OUT] aggregated values of found days             *
+ *             sql        - [IN/OUT] hourly trends query to append the        *
+ *                                   condition to                             *
+ *             sql_alloc  - [IN/OUT]                                          *
+ *             sql_offset - [IN/OUT]                                          *
+ *             hours_num  - [OUT] number of hour ranges in the condition,     *
+ *                                hourly trends must not be queried if 0      *
+ *                                                                            *
+ * Return value: SUCCEED - daily rollups were found, condition was appended   *
+ *               FAIL    - period has no daily rollups, hourly trends must be *
+ *                         queried for the whole period                       *
+ *                                                                            *
+ * Comments: Days without rollup (written before rollups were introduced or   *
+ *           invalidated by trend updates outside of trend writer) are        *
+ *           queried from hourly trends.                                      *
+ *                                                                            *
+ ******************************************************************************/
+static int	trends_rollup_get(const char *table, zbx_uint64_t itemid, time_t start, time_t end,
+		zbx_trends_rollup_t *rollup, char **sql, size_t *sql_alloc, size_t *sql_offset, int *hours_num)
+{
+	zbx_db_result_t	result;
+	zbx_db_row_t	row;
+	time_t		first, last, clock, from;
+	double		num;
+	int		days_num = 0;
+
+	/* the period must contain at least one full rollup period */
+	first = (start + ZBX_TRENDS_ROLLUP_PERIOD - 1) / ZBX_TRENDS_ROLLUP_PERIOD * ZBX_TRENDS_ROLLUP_PERIOD;
+	last = (end + SEC_PER_HOUR) / ZBX_TRENDS_ROLLUP_PERIOD * ZBX_TRENDS_ROLLUP_PERIOD;
+
+	if (first >= last)
+		return FAIL;
+
+	result = zbx_db_select("select clock,num,value_min,value_avg,value_max from %s" ZBX_TRENDS_ROLLUP_SUFFIX
+			" where itemid=" ZBX_FS_UI64
+				" and clock>=" ZBX_FS_I64
+				" and clock<" ZBX_FS_I64
+			" order by clock",
+			table, itemid, first, last);
+
+	*hours_num = 0;
+	from = start;
+
+	while (NULL != (row = zbx_db_fetch(result)))
+	{
+		clock = atoi(row[0]);
+		num = atof(row[1]);
+
+		if (0 == days_num++)
+		{
+			rollup->min = atof(row[2]);
+			rollup->avg = atof(row[3]);
+			rollup->max = atof(row[4]);
+			rollup->num = num;
+			rollup->sum = rollup->avg * num;
+
+			zbx_strcpy_alloc(sql, sql_alloc, sql_offset, " and (");
+		}
+		else
+		{
+			double	avg = atof(row[3]);
+
+			rollup->min = MIN(rollup->min, atof(row[2]));
+			rollup->max = MAX(rollup->max, atof(row[4]));
+			rollup->avg = rollup->avg / (rollup->num + num) * rollup->num + avg / (rollup->num + num) * num;
+			rollup->num += num;
+			rollup->sum += avg * num;
+		}
+
+		if (from < clock)
+		{
+			zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%s(clock>=" ZBX_FS_I64 " and clock<" ZBX_FS_I64
+					")", 0 == (*hours_num)++ ? "" : " or ", from, clock);
+		}
+
+		from = clock + ZBX_TRENDS_ROLLUP_PERIOD;
+	}
+
+	zbx_db_free_result(result);
+
+	if (0 == days_num)
+		return FAIL;
+
+	if (from <= end)
+	{
+		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%s(clock>=" ZBX_FS_I64 " and clock<=" ZBX_FS_I64 ")",
+				0 == (*hours_num)++ ? "" : " or ", from, end);
+	}
+
+	zbx_chrcpy_alloc(sql, sql_alloc, sql_offset, ')');
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: merge value of hourly trends with value of daily rollups          *
+ *                                                                            *
+ * Parameters: function - [IN] trend function                                 *
+ *             rollup   - [IN] aggregated values of daily rollups             *
+ *             state    - [IN/OUT] hourly trends value state                  *
+ *             value    - [IN/OUT] hourly trends value                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	trends_rollup_merge(zbx_trend_function_t function, const zbx_trends_rollup_t *rollup,
+		zbx_trend_state_t *state, double *value)
+{
+	double	rollup_value;
+
+	switch (function)
+	{
+		case ZBX_TREND_FUNCTION_MIN:
+			rollup_value = rollup->min;
+			break;
+		case ZBX_TREND_FUNCTION_MAX:
+			rollup_value = rollup->max;
+			break;
+		case ZBX_TREND_FUNCTION_COUNT:
+			rollup_value = rollup->num;
+			break;
+		default:
+			THIS_SHOULD_NEVER_HAPPEN;
+			return;
+	}
+
+	if (ZBX_TREND_STATE_NORMAL != *state)
+	{
+		*value = rollup_value;
+		*state = ZBX_TREND_STATE_NORMAL;
+		return;
+	}
+
+	switch (function)
+	{
+		case ZBX_TREND_FUNCTION_MIN:
+			*value = MIN(*value, rollup_value);
+			break;
+		case ZBX_TREND_FUNCTION_MAX:
+			*value = MAX(*value, rollup_value);
+			break;
+		default:
+			*value += rollup_value;
+	}
+}
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Purpose: evaluate expression with trends data                              *
@@ -412,6 +580,7 @@ int	zbx_trends_parse_nextcheck(time_t from, const char *period_shift, time_t *ne
  *             itemid      - [IN]                                             *
  *             start       - [OUT] period start time in seconds since Epoch   *
  *             end         - [OUT] period end time in seconds since Epoch     *
+ *             function    - [IN] trend function (min, max or count)          *
  *             eval_single - [IN] sql expression to evaluate for single       *
  *                                 record                                     *
  *             eval_multi  - [IN] sql expression to evaluate for multiple     *
@@ -422,13 +591,19 @@ int	zbx_trends_parse_nextcheck(time_t from, const char *period_shift, time_t *ne
  *                                                                            *
  ******************************************************************************/
 static zbx_trend_state_t	trends_eval(const char *table, zbx_uint64_t itemid, time_t start, time_t end,
-		const char *eval_single, const char *eval_multi, double *value)
+		zbx_trend_function_t function, const char *eval_single, const char *eval_multi, double *value)
 {
 	zbx_db_result_t		result;
 	zbx_db_row_t		row;
 	char			*sql = NULL;
 	size_t			sql_alloc = 0, sql_offset = 0;
-	zbx_trend_state_t	state;
+	zbx_trend_state_t	state = ZBX_TREND_STATE_NODATA;
+#if defined(HAVE_POSTGRESQL) || defined(HAVE_MYSQL)
+	zbx_trends_rollup_t	rollup;
+	int			rollup_found = FAIL, hours_num = 1;
+#else
+	ZBX_UNUSED(function);
+#endif
 
 	zbx_recalc_time_period(&start, ZBX_RECALC_TIME_PERIOD_TRENDS);
 
@@ -437,12 +612,16 @@ static zbx_trend_state_t	trends_eval(const char *table, zbx_uint64_t itemid, tim
 
 	if (start != end)
 	{
-		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
-				"select %s from %s"
-				" where itemid=" ZBX_FS_UI64
-					" and clock>=" ZBX_FS_I64
-					" and clock<=" ZBX_FS_I64,
-				eval_multi, table, itemid, start, end);
+		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "select %s from %s where itemid=" ZBX_FS_UI64,
+				eval_multi, table, itemid);
+#if defined(HAVE_POSTGRESQL) || defined(HAVE_MYSQL)
+		if (SUCCEED != (rollup_found = trends_rollup_get(table, itemid, start, end, &rollup, &sql, &sql_alloc,
+				&sql_offset, &hours_num)))
+#endif
+		{
+			zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, " and clock>=" ZBX_FS_I64
+					" and clock<=" ZBX_FS_I64, start, end);
+		}
 	}
 	else
 	{
@@ -453,19 +632,27 @@ static zbx_trend_state_t	trends_eval(const char *table, zbx_uint64_t itemid, tim
 				eval_single, table, itemid, start);
 	}
 
-	result = zbx_db_select("%s", sql);
-	zbx_free(sql);
-
-	if (NULL != (row = zbx_db_fetch(result)) && SUCCEED != zbx_db_is_null(row[0]))
+#if defined(HAVE_POSTGRESQL) || defined(HAVE_MYSQL)
+	if (0 != hours_num)
+#endif
 	{
-		*value = atof(row[0]);
-		state = ZBX_TREND_STATE_NORMAL;
+		result = zbx_db_select("%s", sql);
+
+		if (NULL != (row = zbx_db_fetch(result)) && SUCCEED != zbx_db_is_null(row[0]))
+		{
+			*value = atof(row[0]);
+			state = ZBX_TREND_STATE_NORMAL;
+		}
+
+		zbx_db_free_result(result);
 	}
-	else
-		state = ZBX_TREND_STATE_NODATA;
 
-	zbx_db_free_result(result);
+	zbx_free(sql);
 
+#if defined(HAVE_POSTGRESQL) || defined(HAVE_MYSQL)
+	if (SUCCEED == rollup_found)
+		trends_rollup_merge(function, &rollup, &state, value);
+#endif
 	return state;
 }
 
@@ -489,8 +676,12 @@ static zbx_trend_state_t	trends_eval_avg(const char *table, zbx_uint64_t itemid,
 	zbx_db_row_t		row;
 	char			*sql = NULL;
 	size_t			sql_alloc = 0, sql_offset = 0;
-	zbx_trend_state_t	state;
-	double			avg, num, num2, avg2;
+	zbx_trend_state_t	state = ZBX_TREND_STATE_NODATA;
+	double			avg = 0, num = 0, num2, avg2;
+#if defined(HAVE_POSTGRESQL) || defined(HAVE_MYSQL)
+	zbx_trends_rollup_t	rollup;
+	int			hours_num = 1;
+#endif
 
 	zbx_recalc_time_period(&start, ZBX_RECALC_TIME_PERIOD_TRENDS);
 
@@ -502,35 +693,54 @@ static zbx_trend_state_t	trends_eval_avg(const char *table, zbx_uint64_t itemid,
 
 	if (start != end)
 	{
-		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, " and clock>=" ZBX_FS_I64 " and clock<=" ZBX_FS_I64,
-				start, end);
+#if defined(HAVE_POSTGRESQL) || defined(HAVE_MYSQL)
+		if (SUCCEED == trends_rollup_get(table, itemid, start, end, &rollup, &sql, &sql_alloc, &sql_offset,
+				&hours_num))
+		{
+			avg = rollup.avg;
+			num = rollup.num;
+			state = ZBX_TREND_STATE_NORMAL;
+		}
+		else
+#endif
+		{
+			zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, " and clock>=" ZBX_FS_I64
+					" and clock<=" ZBX_FS_I64, start, end);
+		}
 	}
 	else
 		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, " and clock=" ZBX_FS_I64, start);
 
-	result = zbx_db_select("%s", sql);
-	zbx_free(sql);
-
-	if (NULL != (row = zbx_db_fetch(result)))
+#if defined(HAVE_POSTGRESQL) || defined(HAVE_MYSQL)
+	if (0 != hours_num)
+#endif
 	{
-		avg = atof(row[0]);
-		num = atof(row[1]);
+		result = zbx_db_select("%s", sql);
 
 		while (NULL != (row = zbx_db_fetch(result)))
 		{
 			avg2 = atof(row[0]);
 			num2 = atof(row[1]);
+
+			if (ZBX_TREND_STATE_NORMAL != state)
+			{
+				avg = avg2;
+				num = num2;
+				state = ZBX_TREND_STATE_NORMAL;
+				continue;
+			}
+
 			avg = avg / (num + num2) * num + avg2 / (num + num2) * num2;
 			num += num2;
 		}
 
-		*value = avg;
-		state = ZBX_TREND_STATE_NORMAL;
+		zbx_db_free_result(result);
 	}
-	else
-		state = ZBX_TREND_STATE_NODATA;
 
-	zbx_db_free_result(result);
+	zbx_free(sql);
+
+	if (ZBX_TREND_STATE_NORMAL == state)
+		*value = avg;
 
 	return state;
 }
@@ -556,6 +766,10 @@ static zbx_trend_state_t	trends_eval_sum(const char *table, zbx_uint64_t itemid,
 	char		*sql = NULL;
 	size_t		sql_alloc = 0, sql_offset = 0;
 	double		sum = 0;
+#if defined(HAVE_POSTGRESQL) || defined(HAVE_MYSQL)
+	zbx_trends_rollup_t	rollup;
+	int			hours_num = 1;
+#endif
 
 	zbx_recalc_time_period(&start, ZBX_RECALC_TIME_PERIOD_TRENDS);
 
@@ -567,19 +781,35 @@ static zbx_trend_state_t	trends_eval_sum(const char *table, zbx_uint64_t itemid,
 
 	if (start != end)
 	{
-		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, " and clock>=" ZBX_FS_I64 " and clock<=" ZBX_FS_I64,
-				start, end);
+#if defined(HAVE_POSTGRESQL) || defined(HAVE_MYSQL)
+		if (SUCCEED == trends_rollup_get(table, itemid, start, end, &rollup, &sql, &sql_alloc, &sql_offset,
+				&hours_num))
+		{
+			sum = rollup.sum;
+		}
+		else
+#endif
+		{
+			zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, " and clock>=" ZBX_FS_I64
+					" and clock<=" ZBX_FS_I64, start, end);
+		}
 	}
 	else
 		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, " and clock=" ZBX_FS_I64, start);
 
-	result = zbx_db_select("%s", sql);
-	zbx_free(sql);
+#if defined(HAVE_POSTGRESQL) || defined(HAVE_MYSQL)
+	if (0 != hours_num)
+#endif
+	{
+		result = zbx_db_select("%s", sql);
 
-	while (NULL != (row = zbx_db_fetch(result)))
-		sum += atof(row[0]) * atof(row[1]);
+		while (NULL != (row = zbx_db_fetch(result)))
+			sum += atof(row[0]) * atof(row[1]);
 
-	zbx_db_free_result(result);
+		zbx_db_free_result(result);
+	}
+
+	zbx_free(sql);
 
 	if (ZBX_INFINITY == sum)
 		return ZBX_TREND_STATE_OVERFLOW;
@@ -589,6 +819,20 @@ static zbx_trend_state_t	trends_eval_sum(const char *table, zbx_uint64_t itemid,
 	return ZBX_TREND_STATE_NORMAL;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: route trends reads of the specified period to replica database    *
+ *                                                                            *
+ * Parameters: end - [IN] the start time of the last hour in period           *
+ *                                                                            *
+ * Comments: Trends of an hour are written after the hour has passed.         *
+ *                                                                            *
+ ******************************************************************************/
+static void	trends_begin_read(time_t end)
+{
+	zbx_db_begin_replica_read((int)end + SEC_PER_HOUR);
+}
+
 int	zbx_trends_eval_avg(const char *table, zbx_uint64_t itemid, time_t start, time_t end, double *value,
 		char **error)
 {
@@ -596,7 +840,9 @@ int	zbx_trends_eval_avg(const char *table, zbx_uint64_t itemid, time_t start, ti
 
 	if (FAIL == zbx_tfc_get_value(itemid, start, end, ZBX_TREND_FUNCTION_AVG, value, &state))
 	{
+		trends_begin_read(end);
 		state = trends_eval_avg(table, itemid, start, end, value);
+		zbx_db_end_replica_read();
 		zbx_tfc_put_value(itemid, start, end, ZBX_TREND_FUNCTION_AVG, *value, state);
 	}
 
@@ -618,8 +864,11 @@ int	zbx_trends_eval_count(const char *table, zbx_uint64_t itemid, time_t start,
 
 	if (FAIL == zbx_tfc_get_value(itemid, start, end, ZBX_TREND_FUNCTION_COUNT, value, &state))
 	{
-		if (ZBX_TREND_STATE_NORMAL != (state = trends_eval(table, itemid, start, end, "num", "sum(num)",
-				value)))
+		trends_begin_read(end);
+		state = trends_eval(table, itemid, start, end, ZBX_TREND_FUNCTION_COUNT, "num", "sum(num)", value);
+		zbx_db_end_replica_read();
+
+		if (ZBX_TREND_STATE_NORMAL != state)
 		{
 			state = ZBX_TREND_STATE_NORMAL;
 			*value = 0;
@@ -638,7 +887,10 @@ int	zbx_trends_eval_max(const char *table, zbx_uint64_t itemid, time_t start, ti
 
 	if (FAIL == zbx_tfc_get_value(itemid, start, end, ZBX_TREND_FUNCTION_MAX, value, &state))
 	{
-		state = trends_eval(table, itemid, start, end, "value_max", "max(value_max)", value);
+		trends_begin_read(end);
+		state = trends_eval(table, itemid, start, end, ZBX_TREND_FUNCTION_MAX, "value_max",
+				"max(value_max)", value);
+		zbx_db_end_replica_read();
 		zbx_tfc_put_value(itemid, start, end, ZBX_TREND_FUNCTION_MAX, *value, state);
 	}
 
@@ -658,7 +910,10 @@ int	zbx_trends_eval_min(const char *table, zbx_uint64_t itemid, time_t start, ti
 
 	if (FAIL == zbx_tfc_get_value(itemid, start, end, ZBX_TREND_FUNCTION_MIN, value, &state))
 	{
-		state = trends_eval(table, itemid, start, end, "value_min", "min(value_min)", value);
+		trends_begin_read(end);
+		state = trends_eval(table, itemid, start, end, ZBX_TREND_FUNCTION_MIN, "value_min",
+				"min(value_min)", value);
+		zbx_db_end_replica_read();
 		zbx_tfc_put_value(itemid, start, end, ZBX_TREND_FUNCTION_MIN, *value, state);
 	}
 
@@ -678,7 +933,9 @@ int	zbx_trends_eval_sum(const char *table, zbx_uint64_t itemid, time_t start, ti
 
 	if (FAIL == zbx_tfc_get_value(itemid, start, end, ZBX_TREND_FUNCTION_SUM, value, &state))
 	{
+		trends_begin_read(end);
 		state = trends_eval_sum(table, itemid, start, end, value);
+		zbx_db_end_replica_read();
 		zbx_tfc_put_value(itemid, start, end, ZBX_TREND_FUNCTION_SUM, *value, state);
 	}
 
@@ -698,7 +955,9 @@ zbx_trend_state_t	zbx_trends_get_avg(const char *table, zbx_uint64_t itemid, tim
 
 	if (FAIL == zbx_tfc_get_value(itemid, start, end, ZBX_TREND_FUNCTION_AVG, value, &state))
 	{
+		trends_begin_read(end);
 		state = trends_eval_avg(table, itemid, start, end, value);
+		zbx_db_end_replica_read();
 		zbx_tfc_put_value(itemid, start, end, ZBX_TREND_FUNCTION_AVG, *value, state);
 	}
 
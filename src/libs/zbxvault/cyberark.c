@@ -22,58 +22,80 @@
 #include "zbxjson.h"
 #include "zbxhttp.h"
 
-int	zbx_cyberark_kvs_get(const char *vault_url, const char *token, const char *ssl_cert_file,
-		const char *ssl_key_file, const char *path, long timeout, zbx_kvs_t *kvs, char **error)
+int	zbx_cyberark_header_get(const char *token, char **header, char **error)
 {
-#ifndef HAVE_LIBCURL
-	ZBX_UNUSED(vault_url);
 	ZBX_UNUSED(token);
-	ZBX_UNUSED(ssl_cert_file);
-	ZBX_UNUSED(ssl_key_file);
-	ZBX_UNUSED(path);
-	ZBX_UNUSED(timeout);
-	ZBX_UNUSED(kvs);
+	ZBX_UNUSED(error);
 
-	*error = zbx_dsprintf(*error, "missing cURL library");
-	return FAIL;
-#else
-	char			*out = NULL, *url;
-	struct zbx_json_parse	jp, jp_data;
-	int			ret = FAIL;
-	long			response_code;
+	*header = zbx_strdup(*header, "Content-Type: application/json");
 
-	ZBX_UNUSED(token);
+	return SUCCEED;
+}
 
-	url = zbx_dsprintf(NULL, "%s/AIMWebService/api/Accounts?%s", vault_url, path);
+int	zbx_cyberark_url_get(const char *vault_url, const char *path, char **url, char **error)
+{
+	ZBX_UNUSED(error);
 
-	if (SUCCEED != zbx_http_get(url, "Content-Type: application/json", timeout, ssl_cert_file, ssl_key_file, &out,
-			&response_code, error))
-	{
-		goto fail;
-	}
+	*url = zbx_dsprintf(*url, "%s/AIMWebService/api/Accounts?%s", vault_url, path);
+
+	return SUCCEED;
+}
+
+int	zbx_cyberark_kvs_parse(const char *out, long response_code, zbx_kvs_t *kvs, char **error)
+{
+	struct zbx_json_parse	jp, jp_data;
 
 	if (200 != response_code)
 	{
 		*error = zbx_dsprintf(*error, "unsuccessful response code \"%ld\"", response_code);
-		goto fail;
+		return FAIL;
 	}
 
 	if (SUCCEED != zbx_json_open(out, &jp))
 	{
 		*error = zbx_dsprintf(*error, "cannot parse secrets from vault: %s", zbx_json_strerror());
-		goto fail;
+		return FAIL;
 	}
 
 	if (SUCCEED != zbx_json_brackets_open(out, &jp_data))
 	{
 		*error = zbx_dsprintf(*error, "cannot parse secrets from vault: %s", zbx_json_strerror());
-		goto fail;
+		return FAIL;
 	}
 
 	zbx_kvs_from_json_get(&jp_data, kvs);
 
-	ret = SUCCEED;
+	return SUCCEED;
+}
+
+int	zbx_cyberark_kvs_get(const char *vault_url, const char *token, const char *ssl_cert_file,
+		const char *ssl_key_file, const char *path, long timeout, zbx_kvs_t *kvs, char **error)
+{
+#ifndef HAVE_LIBCURL
+	ZBX_UNUSED(vault_url);
+	ZBX_UNUSED(token);
+	ZBX_UNUSED(ssl_cert_file);
+	ZBX_UNUSED(ssl_key_file);
+	ZBX_UNUSED(path);
+	ZBX_UNUSED(timeout);
+	ZBX_UNUSED(kvs);
+
+	*error = zbx_dsprintf(*error, "missing cURL library");
+	return FAIL;
+#else
+	char	*out = NULL, *url = NULL, *header = NULL;
+	int	ret = FAIL;
+	long	response_code;
+
+	zbx_cyberark_header_get(token, &header, error);
+	zbx_cyberark_url_get(vault_url, path, &url, error);
+
+	if (SUCCEED != zbx_http_get(url, header, timeout, ssl_cert_file, ssl_key_file, &out, &response_code, error))
+		goto fail;
+
+	ret = zbx_cyberark_kvs_parse(out, response_code, kvs, error);
 fail:
+	zbx_free(header);
 	zbx_free(url);
 	zbx_free(out);
 
@@ -24,25 +24,8 @@
 #include "zbxhttp.h"
 #include "zbxstr.h"
 
-int	zbx_hashicorp_kvs_get(const char *vault_url, const char *token, const char *ssl_cert_file,
-		const char *ssl_key_file, const char *path, long timeout, zbx_kvs_t *kvs, char **error)
+int	zbx_hashicorp_header_get(const char *token, char **header, char **error)
 {
-#ifndef HAVE_LIBCURL
-	ZBX_UNUSED(vault_url);
-	ZBX_UNUSED(token);
-	ZBX_UNUSED(ssl_cert_file);
-	ZBX_UNUSED(ssl_key_file);
-	ZBX_UNUSED(path);
-	ZBX_UNUSED(timeout);
-	ZBX_UNUSED(kvs);
-	*error = zbx_dsprintf(*error, "missing cURL library");
-	return FAIL;
-#else
-	char			*out = NULL, *url, header[MAX_STRING_LEN], *left, *right;
-	struct zbx_json_parse	jp, jp_data, jp_data_data;
-	int			ret = FAIL;
-	long			response_code;
-
 	if (NULL == token)
 	{
 		*error = zbx_dsprintf(*error, "\"VaultToken\" configuration parameter or \"VAULT_TOKEN\" environment"
@@ -50,6 +33,15 @@ int	zbx_hashicorp_kvs_get(const char *vault_url, const char *token, const char *
 		return FAIL;
 	}
 
+	*header = zbx_dsprintf(*header, "X-Vault-Token: %s", token);
+
+	return SUCCEED;
+}
+
+int	zbx_hashicorp_url_get(const char *vault_url, const char *path, char **url, char **error)
+{
+	char	*left, *right;
+
 	zbx_strsplit_first(path, '/', &left, &right);
 	if (NULL == right)
 	{
@@ -57,45 +49,78 @@ int	zbx_hashicorp_kvs_get(const char *vault_url, const char *token, const char *
 		free(left);
 		return FAIL;
 	}
-	url = zbx_dsprintf(NULL, "%s/v1/%s/data/%s", vault_url, left, right);
+	*url = zbx_dsprintf(*url, "%s/v1/%s/data/%s", vault_url, left, right);
 	zbx_free(right);
 	zbx_free(left);
 
-	zbx_snprintf(header, sizeof(header), "X-Vault-Token: %s", token);
+	return SUCCEED;
+}
 
-	if (SUCCEED != zbx_http_get(url, header, timeout, ssl_cert_file, ssl_key_file, &out, &response_code, error))
-		goto fail;
+int	zbx_hashicorp_kvs_parse(const char *out, long response_code, zbx_kvs_t *kvs, char **error)
+{
+	struct zbx_json_parse	jp, jp_data, jp_data_data;
 
 	if (200 != response_code && 204 != response_code)
 	{
 		*error = zbx_dsprintf(*error, "unsuccessful response code \"%ld\"", response_code);
-		goto fail;
+		return FAIL;
 	}
 
 	if (SUCCEED != zbx_json_open(out, &jp))
 	{
 		*error = zbx_dsprintf(*error, "cannot parse secrets from vault: %s", zbx_json_strerror());
-		goto fail;
+		return FAIL;
 	}
 
 	if (SUCCEED != zbx_json_brackets_by_name(&jp, "data", &jp_data))
 	{
 		*error = zbx_dsprintf(*error, "cannot find the \"%s\" object in the received JSON object.",
 				ZBX_PROTO_TAG_DATA);
-		goto fail;
+		return FAIL;
 	}
 
 	if (SUCCEED != zbx_json_brackets_by_name(&jp_data, "data", &jp_data_data))
 	{
 		*error = zbx_dsprintf(*error, "cannot find the \"%s\" object in the received \"%s\" JSON object.",
 				ZBX_PROTO_TAG_DATA, ZBX_PROTO_TAG_DATA);
-		goto fail;
+		return FAIL;
 	}
 
 	zbx_kvs_from_json_get(&jp_data_data, kvs);
 
-	ret = SUCCEED;
+	return SUCCEED;
+}
+
+int	zbx_hashicorp_kvs_get(const char *vault_url, const char *token, const char *ssl_cert_file,
+		const char *ssl_key_file, const char *path, long timeout, zbx_kvs_t *kvs, char **error)
+{
+#ifndef HAVE_LIBCURL
+	ZBX_UNUSED(vault_url);
+	ZBX_UNUSED(token);
+	ZBX_UNUSED(ssl_cert_file);
+	ZBX_UNUSED(ssl_key_file);
+	ZBX_UNUSED(path);
+	ZBX_UNUSED(timeout);
+	ZBX_UNUSED(kvs);
+	*error = zbx_dsprintf(*error, "missing cURL library");
+	return FAIL;
+#else
+	char	*out = NULL, *url = NULL, *header = NULL;
+	int	ret = FAIL;
+	long	response_code;
+
+	if (SUCCEED != zbx_hashicorp_header_get(token, &header, error))
+		return FAIL;
+
+	if (SUCCEED != zbx_hashicorp_url_get(vault_url, path, &url, error))
+		goto fail;
+
+	if (SUCCEED != zbx_http_get(url, header, timeout, ssl_cert_file, ssl_key_file, &out, &response_code, error))
+		goto fail;
+
+	ret = zbx_hashicorp_kvs_parse(out, response_code, kvs, error);
 fail:
+	zbx_free(header);
 	zbx_free(url);
 	zbx_free(out);
 
@@ -20,8 +20,11 @@
 #ifndef ZABBIX_HASHICORP_H
 #define ZABBIX_HASHICORP_H
 
-#include "zbxalgo.h"
+#include "zbxkvs.h"
 
+int	zbx_hashicorp_header_get(const char *token, char **header, char **error);
+int	zbx_hashicorp_url_get(const char *vault_url, const char *path, char **url, char **error);
+int	zbx_hashicorp_kvs_parse(const char *out, long response_code, zbx_kvs_t *kvs, char **error);
 int	zbx_hashicorp_kvs_get(const char *vault_url, const char *token, const char *ssl_cert_file,
 		const char *ssl_key_file, const char *path, long timeout, zbx_hashset_t *kvs, char **error);
 
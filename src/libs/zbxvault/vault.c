@@ -23,13 +23,21 @@
 
 #include "zbxkvs.h"
 #include "zbxstr.h"
+#include "zbxhttp.h"
 
-#define ZBX_VAULT_TIMEOUT	SEC_PER_MIN
+#define ZBX_VAULT_TIMEOUT		SEC_PER_MIN
+#define ZBX_VAULT_MAX_CONNECTIONS	16
 
 typedef	int (*zbx_vault_kvs_get_cb_t)(const char *vault_url, const char *token, const char *ssl_cert_file,
 		const char *ssl_key_file, const char *path, long timeout, zbx_kvs_t *kvs, char **error);
+typedef	int (*zbx_vault_header_get_cb_t)(const char *token, char **header, char **error);
+typedef	int (*zbx_vault_url_get_cb_t)(const char *vault_url, const char *path, char **url, char **error);
+typedef	int (*zbx_vault_kvs_parse_cb_t)(const char *out, long response_code, zbx_kvs_t *kvs, char **error);
 
-static zbx_vault_kvs_get_cb_t	zbx_vault_kvs_get_cb;
+static zbx_vault_kvs_get_cb_t		zbx_vault_kvs_get_cb;
+static zbx_vault_header_get_cb_t	zbx_vault_header_get_cb;
+static zbx_vault_url_get_cb_t		zbx_vault_url_get_cb;
+static zbx_vault_kvs_parse_cb_t		zbx_vault_kvs_parse_cb;
 static const char		*zbx_vault_dbuser_key, *zbx_vault_dbpassword_key;
 
 int	zbx_vault_init(const zbx_config_vault_t *config_vault, char **error)
@@ -52,6 +60,9 @@ int	zbx_vault_init(const zbx_config_vault_t *config_vault, char **error)
 		}
 
 		zbx_vault_kvs_get_cb = zbx_hashicorp_kvs_get;
+		zbx_vault_header_get_cb = zbx_hashicorp_header_get;
+		zbx_vault_url_get_cb = zbx_hashicorp_url_get;
+		zbx_vault_kvs_parse_cb = zbx_hashicorp_kvs_parse;
 		zbx_vault_dbuser_key = ZBX_HASHICORP_DBUSER_KEY;
 		zbx_vault_dbpassword_key = ZBX_HASHICORP_DBPASSWORD_KEY;
 	}
@@ -66,6 +77,9 @@ int	zbx_vault_init(const zbx_config_vault_t *config_vault, char **error)
 		}
 
 		zbx_vault_kvs_get_cb = zbx_cyberark_kvs_get;
+		zbx_vault_header_get_cb = zbx_cyberark_header_get;
+		zbx_vault_url_get_cb = zbx_cyberark_url_get;
+		zbx_vault_kvs_parse_cb = zbx_cyberark_kvs_parse;
 		zbx_vault_dbuser_key = ZBX_CYBERARK_DBUSER_KEY;
 		zbx_vault_dbpassword_key = ZBX_CYBERARK_DBPASSWORD_KEY;
 	}
@@ -91,6 +105,93 @@ int	zbx_vault_kvs_get(const char *path, zbx_kvs_t *kvs, const zbx_config_vault_t
 			config_vault->tls_key_file, path, ZBX_VAULT_TIMEOUT, kvs, error);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: retrieves secrets of multiple paths with parallel requests        *
+ *                                                                            *
+ * Parameters: requests     - [IN/OUT] the requests, kvs of each request must *
+ *                                     be created by caller                   *
+ *             requests_num - [IN] the number of requests                     *
+ *             config_vault - [IN]                                            *
+ *                                                                            *
+ * Comments: The request ret field is set to SUCCEED if secrets of the path   *
+ *           were retrieved, otherwise it is set to FAIL and the error field  *
+ *           contains the error message.                                      *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_vault_kvs_get_multi(zbx_vault_kvs_request_t *requests, int requests_num,
+		const zbx_config_vault_t *config_vault)
+{
+	int	i;
+
+	for (i = 0; i < requests_num; i++)
+	{
+		requests[i].ret = FAIL;
+		requests[i].error = NULL;
+	}
+#ifndef HAVE_LIBCURL
+	ZBX_UNUSED(config_vault);
+
+	for (i = 0; i < requests_num; i++)
+		requests[i].error = zbx_strdup(NULL, "missing cURL library");
+#else
+	zbx_http_get_request_t	*http_requests;
+	int			*http_index, http_num = 0;
+	char			*header = NULL, *error = NULL;
+
+	if (SUCCEED != zbx_vault_header_get_cb(config_vault->token, &header, &error))
+	{
+		for (i = 0; i < requests_num; i++)
+			requests[i].error = zbx_strdup(NULL, error);
+
+		zbx_free(error);
+		return;
+	}
+
+	http_requests = (zbx_http_get_request_t *)zbx_malloc(NULL, sizeof(zbx_http_get_request_t) *
+			(size_t)requests_num);
+	http_index = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)requests_num);
+
+	for (i = 0; i < requests_num; i++)
+	{
+		char	*url = NULL;
+
+		if (SUCCEED != zbx_vault_url_get_cb(config_vault->url, requests[i].path, &url, &requests[i].error))
+			continue;
+
+		http_requests[http_num].url = url;
+		http_index[http_num++] = i;
+	}
+
+	zbx_http_get_multi(http_requests, http_num, header, ZBX_VAULT_TIMEOUT, config_vault->tls_cert_file,
+			config_vault->tls_key_file, ZBX_VAULT_MAX_CONNECTIONS);
+
+	for (i = 0; i < http_num; i++)
+	{
+		zbx_vault_kvs_request_t	*request = &requests[http_index[i]];
+
+		if (SUCCEED == http_requests[i].ret)
+		{
+			request->ret = zbx_vault_kvs_parse_cb(http_requests[i].out, http_requests[i].response_code,
+					&request->kvs, &request->error);
+		}
+		else
+		{
+			request->error = http_requests[i].error;
+			http_requests[i].error = NULL;
+		}
+
+		zbx_free(http_requests[i].out);
+		zbx_free(http_requests[i].error);
+		zbx_free(http_requests[i].url);
+	}
+
+	zbx_free(http_index);
+	zbx_free(http_requests);
+	zbx_free(header);
+#endif
+}
+
 int	zbx_vault_db_credentials_get(const zbx_config_vault_t *config_vault, char **dbuser, char **dbpassword,
 		char **error)
 {
@@ -44,6 +44,18 @@ struct _zbx_xml_node_t
 
 ZBX_PTR_VECTOR_IMPL(xml_node_ptr, zbx_xml_node_t *)
 
+#ifdef HAVE_LIBXML2
+struct zbx_xml_doc
+{
+	xmlDoc	*doc;
+};
+
+struct zbx_xpath
+{
+	xmlXPathCompExpr	*comp;
+};
+#endif
+
 static char	data_static[ZBX_MAX_B64_LEN];
 
 /******************************************************************************
@@ -258,34 +270,31 @@ void zbx_xml_escape_xpath(char **data)
 
 /******************************************************************************
  *                                                                            *
- * Purpose: execute xpath query                                               *
+ * Purpose: parse xml document to be queried with xpath                       *
  *                                                                            *
- * Parameters: value  - [IN/OUT] the value to process                         *
- *             params - [IN] the operation parameters                         *
+ * Parameters: data   - [IN] the xml data                                     *
+ *             doc    - [OUT] the parsed document                             *
  *             errmsg - [OUT] error message                                   *
  *                                                                            *
- * Return value: SUCCEED - the value was processed successfully               *
+ * Return value: SUCCEED - the document was parsed successfully               *
  *               FAIL - otherwise                                             *
  *                                                                            *
+ * Comments: The parsed document is not modified by xpath queries, so it can  *
+ *           be queried by several threads at the same time.                  *
+ *                                                                            *
  ******************************************************************************/
-int	zbx_query_xpath(zbx_variant_t *value, const char *params, char **errmsg)
+int	zbx_xml_doc_parse(const char *data, zbx_xml_doc_t **doc, char **errmsg)
 {
 #ifndef HAVE_LIBXML2
-	ZBX_UNUSED(value);
-	ZBX_UNUSED(params);
+	ZBX_UNUSED(data);
+	ZBX_UNUSED(doc);
 	*errmsg = zbx_dsprintf(*errmsg, "Zabbix was compiled without libxml2 support");
 	return FAIL;
 #else
-	int		i, ret = FAIL;
-	char		buffer[32], *ptr;
-	xmlDoc		*doc = NULL;
-	xmlXPathContext	*xpathCtx;
-	xmlXPathObject	*xpathObj;
-	xmlNodeSetPtr	nodeset;
+	xmlDoc		*xdoc;
 	xmlErrorPtr	pErr;
-	xmlBufferPtr	xmlBufferLocal;
 
-	if (NULL == (doc = xmlReadMemory(value->data.str, strlen(value->data.str), "noname.xml", NULL, 0)))
+	if (NULL == (xdoc = xmlReadMemory(data, strlen(data), "noname.xml", NULL, 0)))
 	{
 		if (NULL != (pErr = xmlGetLastError()))
 			*errmsg = zbx_dsprintf(*errmsg, "cannot parse xml value: %s", pErr->message);
@@ -294,9 +303,65 @@ int	zbx_query_xpath(zbx_variant_t *value, const char *params, char **errmsg)
 		return FAIL;
 	}
 
-	xpathCtx = xmlXPathNewContext(doc);
+	*doc = (zbx_xml_doc_t *)zbx_malloc(NULL, sizeof(zbx_xml_doc_t));
+	(*doc)->doc = xdoc;
+
+	return SUCCEED;
+#endif
+}
+
+void	zbx_xml_doc_free(zbx_xml_doc_t *doc)
+{
+#ifdef HAVE_LIBXML2
+	xmlFreeDoc(doc->doc);
+#endif
+	zbx_free(doc);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: execute xpath query on parsed xml document                        *
+ *                                                                            *
+ * Parameters: doc    - [IN] the parsed xml document                          *
+ *             params - [IN] the xpath expression                             *
+ *             xpath  - [IN] the compiled xpath expression (optional)         *
+ *             value  - [OUT] the query result                                *
+ *             errmsg - [OUT] error message                                   *
+ *                                                                            *
+ * Return value: SUCCEED - the query was executed successfully                *
+ *               FAIL - otherwise                                             *
+ *                                                                            *
+ * Comments: The compiled expression is used if specified, otherwise the      *
+ *           xpath expression is compiled from params.                        *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_xml_doc_query_xpath(const zbx_xml_doc_t *doc, const char *params, const zbx_xpath_t *xpath,
+		zbx_variant_t *value, char **errmsg)
+{
+#ifndef HAVE_LIBXML2
+	ZBX_UNUSED(doc);
+	ZBX_UNUSED(params);
+	ZBX_UNUSED(xpath);
+	ZBX_UNUSED(value);
+	*errmsg = zbx_dsprintf(*errmsg, "Zabbix was compiled without libxml2 support");
+	return FAIL;
+#else
+	int		i, ret = FAIL;
+	char		buffer[32], *ptr;
+	xmlXPathContext	*xpathCtx;
+	xmlXPathObject	*xpathObj;
+	xmlNodeSetPtr	nodeset;
+	xmlErrorPtr	pErr;
+	xmlBufferPtr	xmlBufferLocal;
+
+	xpathCtx = xmlXPathNewContext(doc->doc);
 
-	if (NULL == (xpathObj = xmlXPathEvalExpression((xmlChar *)params, xpathCtx)))
+	if (NULL != xpath)
+		xpathObj = xmlXPathCompiledEval(xpath->comp, xpathCtx);
+	else
+		xpathObj = xmlXPathEvalExpression((const xmlChar *)params, xpathCtx);
+
+	if (NULL == xpathObj)
 	{
 		if (NULL != (pErr = xmlGetLastError()))
 			*errmsg = zbx_dsprintf(*errmsg, "cannot parse xpath: %s", pErr->message);
@@ -316,7 +381,7 @@ int	zbx_query_xpath(zbx_variant_t *value, const char *params, char **errmsg)
 				nodeset = xpathObj->nodesetval;
 
 				for (i = 0; i < nodeset->nodeNr; i++)
-					xmlNodeDump(xmlBufferLocal, doc, nodeset->nodeTab[i], 0, 0);
+					xmlNodeDump(xmlBufferLocal, doc->doc, nodeset->nodeTab[i], 0, 0);
 			}
 			zbx_variant_clear(value);
 			zbx_variant_set_str(value, zbx_strdup(NULL, (const char *)xmlBufferLocal->content));
@@ -358,12 +423,37 @@ int	zbx_query_xpath(zbx_variant_t *value, const char *params, char **errmsg)
 out:
 	xmlXPathFreeObject(xpathObj);
 	xmlXPathFreeContext(xpathCtx);
-	xmlFreeDoc(doc);
 
 	return ret;
 #endif
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: execute xpath query                                               *
+ *                                                                            *
+ * Parameters: value  - [IN/OUT] the value to process                         *
+ *             params - [IN] the operation parameters                         *
+ *             errmsg - [OUT] error message                                   *
+ *                                                                            *
+ * Return value: SUCCEED - the value was processed successfully               *
+ *               FAIL - otherwise                                             *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_query_xpath(zbx_variant_t *value, const char *params, char **errmsg)
+{
+	zbx_xml_doc_t	*doc;
+	int		ret;
+
+	if (SUCCEED != zbx_xml_doc_parse(value->data.str, &doc, errmsg))
+		return FAIL;
+
+	ret = zbx_xml_doc_query_xpath(doc, params, NULL, value, errmsg);
+	zbx_xml_doc_free(doc);
+
+	return ret;
+}
+
 #ifdef HAVE_LIBXML2
 
 #define XML_TEXT_NAME	"text"
@@ -1072,6 +1162,62 @@ int	zbx_xml_xpath_check(const char *xpath, char *error, size_t errlen)
 #endif
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile xpath expression to be used by multiple queries           *
+ *                                                                            *
+ * Parameters: expression - [IN] the xpath expression                         *
+ *             xpath      - [OUT] the compiled xpath expression               *
+ *             errmsg     - [OUT] error message                               *
+ *                                                                            *
+ * Return value: SUCCEED - the expression was compiled successfully           *
+ *               FAIL    - xpath parsing error                                *
+ *                                                                            *
+ * Comments: The compiled expression is not modified by queries, so it can be *
+ *           used by several threads at the same time.                        *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_xpath_compile(const char *expression, zbx_xpath_t **xpath, char **errmsg)
+{
+#ifndef HAVE_LIBXML2
+	ZBX_UNUSED(expression);
+	ZBX_UNUSED(xpath);
+	*errmsg = zbx_dsprintf(*errmsg, "Zabbix was compiled without libxml2 support");
+	return FAIL;
+#else
+	char			buffer[MAX_STRING_LEN];
+	zbx_libxml_error_t	err;
+	xmlXPathCompExpr	*comp;
+
+	*buffer = '\0';
+	err.buf = buffer;
+	err.len = sizeof(buffer);
+
+	xmlSetStructuredErrorFunc(&err, &libxml_handle_error_xpath_check);
+	comp = xmlXPathCompile((const xmlChar *)expression);
+	xmlSetStructuredErrorFunc(NULL, NULL);
+
+	if (NULL == comp)
+	{
+		*errmsg = zbx_dsprintf(*errmsg, "cannot parse xpath: %s", buffer);
+		return FAIL;
+	}
+
+	*xpath = (zbx_xpath_t *)zbx_malloc(NULL, sizeof(zbx_xpath_t));
+	(*xpath)->comp = comp;
+
+	return SUCCEED;
+#endif
+}
+
+void	zbx_xpath_free(zbx_xpath_t *xpath)
+{
+#ifdef HAVE_LIBXML2
+	xmlXPathFreeCompExpr(xpath->comp);
+#endif
+	zbx_free(xpath);
+}
+
 #if defined(HAVE_LIBXML2) && defined(HAVE_LIBCURL)
 /******************************************************************************
  *                                                                            *
@@ -1161,11 +1307,12 @@ static void	libxml_handle_error_try_read_value(void *user_data, xmlErrorPtr err)
 	ZBX_UNUSED(err);
 }
 
-/* according to libxml2 changelog XML_PARSE_HUGE option was introduced in version 2.7.0 */
+/* according to libxml2 changelog XML_PARSE_HUGE option was introduced in version 2.7.0, */
+/* XML_PARSE_COMPACT stores short text nodes inline reducing memory used by large responses */
 #if 20700 <= LIBXML_VERSION	/* version 2.7.0 */
-#	define ZBX_XML_PARSE_OPTS	XML_PARSE_HUGE
+#	define ZBX_XML_PARSE_OPTS	(XML_PARSE_HUGE | XML_PARSE_COMPACT)
 #else
-#	define ZBX_XML_PARSE_OPTS	0
+#	define ZBX_XML_PARSE_OPTS	XML_PARSE_COMPACT
 #endif
 
 /******************************************************************************
@@ -38,6 +38,7 @@
 #include "zbx_rtc_constants.h"
 #include "zbx_item_constants.h"
 #include "zbxalgo.h"
+#include "zbxcompress.h"
 
 #if defined(ZABBIX_SERVICE)
 #	include "zbxwinservice.h"
@@ -52,6 +53,14 @@ extern char			*CONFIG_HOST_INTERFACE;
 extern char			*CONFIG_HOST_INTERFACE_ITEM;
 extern int			CONFIG_BUFFER_SEND;
 extern int			CONFIG_BUFFER_SIZE;
+extern int			CONFIG_PERSISTENT_ACTIVE_CONNECTION;
+#if !defined(_WINDOWS) && !defined(__MINGW32__)
+extern char			*CONFIG_BUFFER_SPILL_FILE;
+extern int			CONFIG_BUFFER_SPILL_SIZE;
+#endif
+
+/* the maximum idle sleep, bounds the reaction time to shutdown and configuration changes */
+#define ZBX_ACTIVE_CHECKS_IDLE_MAX	5
 
 typedef struct
 {
@@ -83,6 +92,8 @@ active_buffer_t;
 
 static ZBX_THREAD_LOCAL active_buffer_t			buffer;
 static ZBX_THREAD_LOCAL zbx_vector_ptr_t		active_metrics;
+static ZBX_THREAD_LOCAL zbx_binary_heap_t		active_schedule;	/* active metrics ordered by */
+										/* next check time           */
 static ZBX_THREAD_LOCAL zbx_vector_expression_t		regexps;
 static ZBX_THREAD_LOCAL char				*session_token;
 static ZBX_THREAD_LOCAL zbx_uint64_t			last_valueid = 0;
@@ -91,10 +102,26 @@ static ZBX_THREAD_LOCAL zbx_vector_pre_persistent_t	pre_persistent_vec;	/* used
 /* used for deleting inactive persistent files */
 static ZBX_THREAD_LOCAL zbx_vector_persistent_inactive_t	persistent_inactive_vec;
 
+/* connection kept open between requests when persistent connections are enabled */
+static ZBX_THREAD_LOCAL zbx_socket_t	active_sock;
+static ZBX_THREAD_LOCAL int		active_sock_connected = 0;
+
 #ifndef _WINDOWS
 static volatile sig_atomic_t	need_update_userparam;
 #endif
 
+static int	active_metric_nextcheck_compare(const void *d1, const void *d2)
+{
+	const zbx_binary_heap_elem_t	*e1 = (const zbx_binary_heap_elem_t *)d1;
+	const zbx_binary_heap_elem_t	*e2 = (const zbx_binary_heap_elem_t *)d2;
+	const ZBX_ACTIVE_METRIC		*m1 = (const ZBX_ACTIVE_METRIC *)e1->data;
+	const ZBX_ACTIVE_METRIC		*m2 = (const ZBX_ACTIVE_METRIC *)e2->data;
+
+	ZBX_RETURN_IF_NOT_EQUAL(m1->nextcheck, m2->nextcheck);
+
+	return 0;
+}
+
 static void	init_active_metrics(void)
 {
 	size_t	sz;
@@ -114,6 +141,7 @@ static void	init_active_metrics(void)
 	}
 
 	zbx_vector_ptr_create(&active_metrics);
+	zbx_binary_heap_create(&active_schedule, active_metric_nextcheck_compare, ZBX_BINARY_HEAP_OPTION_EMPTY);
 	zbx_vector_expression_create(&regexps);
 	zbx_vector_pre_persistent_create(&pre_persistent_vec);
 	zbx_vector_persistent_inactive_create(&persistent_inactive_vec);
@@ -146,6 +174,8 @@ static void	free_active_metrics(void)
 	zbx_regexp_clean_expressions(&regexps);
 	zbx_vector_expression_destroy(&regexps);
 
+	zbx_binary_heap_destroy(&active_schedule);
+
 	zbx_vector_ptr_clear_ext(&active_metrics, (zbx_clean_func_t)free_active_metric);
 	zbx_vector_ptr_destroy(&active_metrics);
 
@@ -153,35 +183,53 @@ static void	free_active_metrics(void)
 }
 #endif
 
-static int	get_min_nextcheck(void)
+static void	schedule_active_metric(ZBX_ACTIVE_METRIC *metric)
 {
-	int	i, min = -1;
+	zbx_binary_heap_elem_t	elem = {0, (const void *)metric};
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+	zbx_binary_heap_insert(&active_schedule, &elem);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: rebuild active check schedule after the list of active metrics    *
+ *          has been updated                                                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	reschedule_active_metrics(void)
+{
+	int	i;
+
+	zbx_binary_heap_clear(&active_schedule);
 
 	for (i = 0; i < active_metrics.values_num; i++)
-	{
-		const ZBX_ACTIVE_METRIC	*metric = (const ZBX_ACTIVE_METRIC *)active_metrics.values[i];
+		schedule_active_metric((ZBX_ACTIVE_METRIC *)active_metrics.values[i]);
+}
 
-		if (metric->nextcheck < min || -1 == min)
-			min = metric->nextcheck;
-	}
+static int	get_min_nextcheck(void)
+{
+	int	min;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	if (-1 == min)
+	if (SUCCEED == zbx_binary_heap_empty(&active_schedule))
 		min = FAIL;
+	else
+		min = ((const ZBX_ACTIVE_METRIC *)zbx_binary_heap_find_min(&active_schedule)->data)->nextcheck;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%d", __func__, min);
 
 	return min;
 }
 
-static void	add_check(const char *key, const char *key_orig, int refresh, zbx_uint64_t lastlogsize, int mtime)
+static void	add_check(zbx_uint64_t itemid, const char *key, const char *key_orig, int refresh,
+		zbx_uint64_t lastlogsize, int mtime)
 {
 	ZBX_ACTIVE_METRIC	*metric;
 	int			i;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() key:'%s' refresh:%d lastlogsize:" ZBX_FS_UI64 " mtime:%d",
-			__func__, key, refresh, lastlogsize, mtime);
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() itemid:" ZBX_FS_UI64 " key:'%s' refresh:%d lastlogsize:" ZBX_FS_UI64
+			" mtime:%d", __func__, itemid, key, refresh, lastlogsize, mtime);
 
 	for (i = 0; i < active_metrics.values_num; i++)
 	{
@@ -239,6 +287,8 @@ static void	add_check(const char *key, const char *key_orig, int refresh, zbx_ui
 		}
 #endif
 		/* replace metric */
+		metric->itemid = itemid;
+
 		if (metric->refresh != refresh)
 		{
 			metric->nextcheck = 0;
@@ -251,6 +301,7 @@ static void	add_check(const char *key, const char *key_orig, int refresh, zbx_ui
 	metric = (ZBX_ACTIVE_METRIC *)zbx_malloc(NULL, sizeof(ZBX_ACTIVE_METRIC));
 
 	/* add new metric */
+	metric->itemid = itemid;
 	metric->key = zbx_strdup(NULL, key);
 	metric->key_orig = zbx_strdup(NULL, key_orig);
 	metric->refresh = refresh;
@@ -339,6 +390,8 @@ static int	mode_parameter_is_skip(unsigned char flags, const char *itemkey)
  *    With '\n' delimiter between elements.                                   *
  *    Each element represented as:                                            *
  *           <key>:<refresh time>:<last log size>:<modification time>         *
+ *    In delta response only changed items are sent in data, items that have  *
+ *    not changed are listed by identifiers in unchanged_itemids.             *
  *                                                                            *
  ******************************************************************************/
 static void	parse_list_of_checks(char *str, const char *host, unsigned short port,
@@ -348,9 +401,9 @@ static void	parse_list_of_checks(char *str, const char *host, unsigned short por
 	size_t			name_alloc = 0, key_orig_alloc = 0;
 	char			*name = NULL, *key_orig = NULL, expression[MAX_STRING_LEN],
 				tmp[MAX_STRING_LEN], exp_delimiter;
-	zbx_uint64_t		lastlogsize;
+	zbx_uint64_t		lastlogsize, itemid;
 	struct zbx_json_parse	jp, jp_data, jp_row;
-	ZBX_ACTIVE_METRIC	*metric;
+	ZBX_ACTIVE_METRIC	*metric = NULL;
 	zbx_vector_str_t	received_metrics;
 	int			delay, mtime, expression_type, case_sensitive, i, j, ret = FAIL;
 	zbx_uint32_t		config_revision;
@@ -452,12 +505,48 @@ static void	parse_list_of_checks(char *str, const char *host, unsigned short por
 		else
 			mtime = atoi(tmp);
 
-		add_check(zbx_alias_get(name), key_orig, delay, lastlogsize, mtime);
+		if (SUCCEED != zbx_json_value_by_name(&jp_row, ZBX_PROTO_TAG_ITEMID, tmp, sizeof(tmp), NULL) ||
+				SUCCEED != zbx_is_uint64(tmp, &itemid))
+		{
+			itemid = 0;
+		}
+
+		add_check(itemid, zbx_alias_get(name), key_orig, delay, lastlogsize, mtime);
 
 		/* remember what was received */
 		zbx_vector_str_append(&received_metrics, zbx_strdup(NULL, key_orig));
 	}
 
+	/* delta response - items not changed since the acknowledged revision are listed by identifiers only */
+	if (SUCCEED == zbx_json_brackets_by_name(&jp, ZBX_PROTO_TAG_UNCHANGED_ITEMIDS, &jp_data))
+	{
+		p = NULL;
+		while (NULL != (p = zbx_json_next_value(&jp_data, p, tmp, sizeof(tmp), NULL)))
+		{
+			if (SUCCEED != zbx_is_uint64(tmp, &itemid))
+				continue;
+
+			for (i = 0; i < active_metrics.values_num; i++)
+			{
+				metric = (ZBX_ACTIVE_METRIC *)active_metrics.values[i];
+
+				if (metric->itemid == itemid)
+					break;
+			}
+
+			if (i == active_metrics.values_num)
+			{
+				/* local state does not match the server view, request full configuration next time */
+				zabbix_log(LOG_LEVEL_DEBUG, "%s() unknown unchanged itemid:" ZBX_FS_UI64, __func__,
+						itemid);
+				*config_revision_local = 0;
+				continue;
+			}
+
+			zbx_vector_str_append(&received_metrics, zbx_strdup(NULL, metric->key_orig));
+		}
+	}
+
 	/* remove what wasn't received */
 	for (i = 0; i < active_metrics.values_num; i++)
 	{
@@ -561,6 +650,8 @@ static void	parse_list_of_checks(char *str, const char *host, unsigned short por
 success:
 	ret = SUCCEED;
 out:
+	reschedule_active_metrics();
+
 	zbx_vector_str_clear_ext(&received_metrics, zbx_str_free);
 	zbx_vector_str_destroy(&received_metrics);
 	zbx_free(key_orig);
@@ -630,6 +721,98 @@ static void	process_config_item(struct zbx_json *json, char *config, size_t leng
 	zbx_free_agent_result(&result);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: check if persistent connection was not closed by server           *
+ *                                                                            *
+ * Comments: Server does not send anything without a request, so a readable   *
+ *           idle connection means it was closed or reset by the peer.        *
+ *                                                                            *
+ ******************************************************************************/
+static int	active_connection_is_alive(zbx_socket_t *s)
+{
+	zbx_pollfd_t	pd;
+
+	pd.fd = s->socket;
+	pd.events = POLLIN;
+	pd.revents = 0;
+
+	return 0 == zbx_socket_poll(&pd, 1, 0) ? SUCCEED : FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: connect to server or reuse persistent connection                  *
+ *                                                                            *
+ * Parameters: addrs           - [IN] Zabbix server/proxy addresses           *
+ *             timeout         - [IN] timeout of the whole exchange           *
+ *             connect_timeout - [IN] connection timeout                      *
+ *             level           - [IN] connection error log level              *
+ *             config_tls      - [IN]                                         *
+ *             s               - [OUT] connection to use                      *
+ *                                                                            *
+ * Return value: SUCCEED - connection is established                          *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	active_connect(zbx_vector_addr_ptr_t *addrs, int timeout, int connect_timeout, int level,
+		const zbx_config_tls_t *config_tls, zbx_socket_t **s)
+{
+	*s = &active_sock;
+
+	if (0 != active_sock_connected)
+	{
+		if (SUCCEED == active_connection_is_alive(&active_sock))
+		{
+			zbx_socket_set_deadline(&active_sock, timeout);
+			return SUCCEED;
+		}
+
+		zabbix_log(LOG_LEVEL_DEBUG, "persistent connection to [%s]:%d was closed by peer",
+				((zbx_addr_t *)addrs->values[0])->ip, ((zbx_addr_t *)addrs->values[0])->port);
+
+		zbx_tcp_close(&active_sock);
+		active_sock_connected = 0;
+	}
+
+	if (SUCCEED != zbx_connect_to_server(&active_sock, CONFIG_SOURCE_IP, addrs, timeout, connect_timeout, 0,
+			level, config_tls))
+	{
+		return FAIL;
+	}
+
+	if (0 != CONFIG_PERSISTENT_ACTIVE_CONNECTION)
+		active_sock_connected = 1;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: close connection unless it is persistent and the exchange         *
+ *          succeeded                                                         *
+ *                                                                            *
+ ******************************************************************************/
+static void	active_disconnect(zbx_socket_t *s, int ret)
+{
+	if (SUCCEED == ret && 0 != active_sock_connected)
+		return;
+
+	zbx_tcp_close(s);
+	active_sock_connected = 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: ask server to keep connection open after response                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	active_request_persistent(struct zbx_json *json)
+{
+	if (0 != CONFIG_PERSISTENT_ACTIVE_CONNECTION)
+		zbx_json_addint64(json, ZBX_PROTO_TAG_PERSISTENT, 1);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: Retrieve from Zabbix server list of active checks                 *
@@ -643,7 +826,7 @@ static int	refresh_active_checks(zbx_vector_addr_ptr_t *addrs, const zbx_config_
 {
 	static ZBX_THREAD_LOCAL int	last_ret = SUCCEED;
 	int				ret, level;
-	zbx_socket_t			s;
+	zbx_socket_t			*s;
 	struct zbx_json			json;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() host:'%s' port:%hu", __func__, ((zbx_addr_t *)addrs->values[0])->ip,
@@ -691,22 +874,23 @@ static int	refresh_active_checks(zbx_vector_addr_ptr_t *addrs, const zbx_config_
 		zbx_json_adduint64(&json, ZBX_PROTO_TAG_PORT, (zbx_uint64_t)CONFIG_LISTEN_PORT);
 
 	zbx_json_adduint64(&json, ZBX_PROTO_TAG_CONFIG_REVISION, (zbx_uint64_t)*config_revision_local);
+	zbx_json_adduint64(&json, ZBX_PROTO_TAG_CONFIG_DELTA, 1);
 	zbx_json_addstring(&json, ZBX_PROTO_TAG_SESSION, session_token, ZBX_JSON_TYPE_STRING);
+	active_request_persistent(&json);
 
 	level = SUCCEED != last_ret ? LOG_LEVEL_DEBUG : LOG_LEVEL_WARNING;
 
-	if (SUCCEED == (ret = zbx_connect_to_server(&s, CONFIG_SOURCE_IP, addrs, config_timeout, config_timeout,
-			0, level, config_tls)))
+	if (SUCCEED == (ret = active_connect(addrs, config_timeout, config_timeout, level, config_tls, &s)))
 	{
 		zabbix_log(LOG_LEVEL_DEBUG, "sending [%s]", json.buffer);
 
-		if (SUCCEED == (ret = zbx_tcp_send(&s, json.buffer)))
+		if (SUCCEED == (ret = zbx_tcp_send(s, json.buffer)))
 		{
 			zabbix_log(LOG_LEVEL_DEBUG, "before read");
 
-			if (SUCCEED == (ret = zbx_tcp_recv(&s)))
+			if (SUCCEED == (ret = zbx_tcp_recv(s)))
 			{
-				zabbix_log(LOG_LEVEL_DEBUG, "got [%s]", s.buffer);
+				zabbix_log(LOG_LEVEL_DEBUG, "got [%s]", s->buffer);
 
 				if (SUCCEED != last_ret)
 				{
@@ -714,7 +898,7 @@ static int	refresh_active_checks(zbx_vector_addr_ptr_t *addrs, const zbx_config_
 							" is working again", ((zbx_addr_t *)addrs->values[0])->ip,
 							((zbx_addr_t *)addrs->values[0])->port);
 				}
-				parse_list_of_checks(s.buffer, ((zbx_addr_t *)addrs->values[0])->ip,
+				parse_list_of_checks(s->buffer, ((zbx_addr_t *)addrs->values[0])->ip,
 						((zbx_addr_t *)addrs->values[0])->port, config_revision_local);
 			}
 			else
@@ -733,7 +917,7 @@ static int	refresh_active_checks(zbx_vector_addr_ptr_t *addrs, const zbx_config_
 					zbx_socket_strerror());
 		}
 
-		zbx_tcp_close(&s);
+		active_disconnect(s, ret);
 	}
 
 	if (SUCCEED != ret && SUCCEED == last_ret)
@@ -784,6 +968,481 @@ static int	check_response(char *response)
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: add buffered value to agent data JSON                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	add_buffer_element_json(struct zbx_json *json, const active_buffer_element_t *el)
+{
+	zbx_json_addobject(json, NULL);
+	zbx_json_addstring(json, ZBX_PROTO_TAG_HOST, el->host, ZBX_JSON_TYPE_STRING);
+	zbx_json_addstring(json, ZBX_PROTO_TAG_KEY, el->key, ZBX_JSON_TYPE_STRING);
+
+	if (NULL != el->value)
+		zbx_json_addstring(json, ZBX_PROTO_TAG_VALUE, el->value, ZBX_JSON_TYPE_STRING);
+
+	if (ITEM_STATE_NOTSUPPORTED == el->state)
+	{
+		zbx_json_adduint64(json, ZBX_PROTO_TAG_STATE, ITEM_STATE_NOTSUPPORTED);
+	}
+	else
+	{
+		/* add item meta information only for items in normal state */
+		if (0 != (ZBX_METRIC_FLAG_LOG & el->flags))
+			zbx_json_adduint64(json, ZBX_PROTO_TAG_LASTLOGSIZE, el->lastlogsize);
+		if (0 != (ZBX_METRIC_FLAG_LOG_LOGRT & el->flags))
+			zbx_json_adduint64(json, ZBX_PROTO_TAG_MTIME, el->mtime);
+	}
+
+	if (0 != el->timestamp)
+		zbx_json_adduint64(json, ZBX_PROTO_TAG_LOGTIMESTAMP, el->timestamp);
+
+	if (NULL != el->source)
+		zbx_json_addstring(json, ZBX_PROTO_TAG_LOGSOURCE, el->source, ZBX_JSON_TYPE_STRING);
+
+	if (0 != el->severity)
+		zbx_json_adduint64(json, ZBX_PROTO_TAG_LOGSEVERITY, el->severity);
+
+	if (0 != el->logeventid)
+		zbx_json_adduint64(json, ZBX_PROTO_TAG_LOGEVENTID, el->logeventid);
+
+	zbx_json_adduint64(json, ZBX_PROTO_TAG_ID, el->id);
+
+	zbx_json_adduint64(json, ZBX_PROTO_TAG_CLOCK, el->ts.sec);
+	zbx_json_adduint64(json, ZBX_PROTO_TAG_NS, el->ts.ns);
+	zbx_json_close(json);
+}
+
+#if !defined(_WINDOWS) && !defined(__MINGW32__)
+/******************************************************************************
+ *                                                                            *
+ * Spill file keeps values that did not fit into the memory buffer while      *
+ * server was unavailable. It starts with header containing magic and offset  *
+ * of the first record not sent yet, followed by appended records:            *
+ *                                                                            *
+ *   <size><size_raw><lastid><data>                                           *
+ *                                                                            *
+ * where data is comma separated list of agent data JSON objects, compressed  *
+ * if size differs from size_raw, and lastid is the largest value id in it.   *
+ *                                                                            *
+ ******************************************************************************/
+
+#define ZBX_SPILL_MAGIC		"ZBXSPILL"
+#define ZBX_SPILL_MAGIC_LEN	ZBX_CONST_STRLEN(ZBX_SPILL_MAGIC)
+#define ZBX_SPILL_HEADER_SIZE	(ZBX_SPILL_MAGIC_LEN + sizeof(zbx_uint64_t))
+
+/* uncompressed size of values replayed in a single request */
+#define ZBX_SPILL_BATCH_SIZE	(4 * ZBX_MEBIBYTE)
+
+typedef struct
+{
+	zbx_uint32_t	size;
+	zbx_uint32_t	size_raw;
+	zbx_uint64_t	lastid;
+}
+active_spill_record_t;
+
+typedef struct
+{
+	int		fd;
+	char		*path;
+	zbx_uint64_t	read_offset;
+	zbx_uint64_t	write_offset;
+	int		lastfail;
+	int		full;
+}
+active_spill_t;
+
+static ZBX_THREAD_LOCAL active_spill_t	spill = {-1, NULL, 0, 0, 0, 0};
+
+static void	active_spill_disable(const char *action)
+{
+	zabbix_log(LOG_LEVEL_WARNING, "cannot %s buffer spill file \"%s\": %s, values will not be stored on disk",
+			action, spill.path, zbx_strerror(errno));
+
+	close(spill.fd);
+	spill.fd = -1;
+}
+
+static int	active_spill_pending(void)
+{
+	return -1 != spill.fd && spill.read_offset < spill.write_offset ? SUCCEED : FAIL;
+}
+
+static int	active_spill_reset(void)
+{
+	char	header[ZBX_SPILL_HEADER_SIZE];
+
+	memcpy(header, ZBX_SPILL_MAGIC, ZBX_SPILL_MAGIC_LEN);
+	spill.read_offset = spill.write_offset = ZBX_SPILL_HEADER_SIZE;
+	memcpy(header + ZBX_SPILL_MAGIC_LEN, &spill.read_offset, sizeof(spill.read_offset));
+
+	if (0 != ftruncate(spill.fd, 0) || sizeof(header) != pwrite(spill.fd, header, sizeof(header), 0))
+		return FAIL;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: open buffer spill file and find values left from previous run     *
+ *                                                                            *
+ * Parameters: path - [IN] the spill file path                                *
+ *                                                                            *
+ ******************************************************************************/
+static void	active_spill_open(const char *path)
+{
+	char			header[ZBX_SPILL_HEADER_SIZE];
+	zbx_uint64_t		offset;
+	zbx_stat_t		st;
+	active_spill_record_t	record;
+
+	spill.path = zbx_strdup(spill.path, path);
+
+	if (-1 == (spill.fd = open(path, O_RDWR | O_CREAT, 0640)))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot open buffer spill file \"%s\": %s", path, zbx_strerror(errno));
+		return;
+	}
+
+	if (0 != zbx_fstat(spill.fd, &st))
+	{
+		active_spill_disable("obtain information of");
+		return;
+	}
+
+	if (ZBX_SPILL_HEADER_SIZE > st.st_size ||
+			sizeof(header) != pread(spill.fd, header, sizeof(header), 0) ||
+			0 != memcmp(header, ZBX_SPILL_MAGIC, ZBX_SPILL_MAGIC_LEN))
+	{
+		if (SUCCEED != active_spill_reset())
+			active_spill_disable("initialize");
+
+		return;
+	}
+
+	memcpy(&spill.read_offset, header + ZBX_SPILL_MAGIC_LEN, sizeof(spill.read_offset));
+
+	if (ZBX_SPILL_HEADER_SIZE > spill.read_offset || (zbx_uint64_t)st.st_size < spill.read_offset)
+	{
+		if (SUCCEED != active_spill_reset())
+			active_spill_disable("initialize");
+
+		return;
+	}
+
+	/* skip to the end of the last complete record, a partially written one is discarded */
+	for (offset = spill.read_offset; offset + sizeof(record) <= (zbx_uint64_t)st.st_size;
+			offset += sizeof(record) + record.size)
+	{
+		if (sizeof(record) != pread(spill.fd, &record, sizeof(record), (off_t)offset) ||
+				offset + sizeof(record) + record.size > (zbx_uint64_t)st.st_size)
+		{
+			break;
+		}
+
+		if (last_valueid < record.lastid)
+			last_valueid = record.lastid;
+	}
+
+	spill.write_offset = offset;
+
+	if ((zbx_uint64_t)st.st_size != offset && 0 != ftruncate(spill.fd, (off_t)offset))
+	{
+		active_spill_disable("truncate");
+		return;
+	}
+
+	if (spill.read_offset == spill.write_offset)
+	{
+		if (SUCCEED != active_spill_reset())
+			active_spill_disable("initialize");
+	}
+	else
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "buffer spill file \"%s\" contains " ZBX_FS_UI64 " bytes of unsent values",
+				path, spill.write_offset - spill.read_offset);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: move values from full memory buffer to the spill file             *
+ *                                                                            *
+ * Return value: SUCCEED - the values were moved and buffer has free space    *
+ *               FAIL    - spill file is not available or full                *
+ *                                                                            *
+ * Comments: Values of persistent items stay in memory, their ids are         *
+ *           renumbered so that the ids stay increasing in the order the      *
+ *           values are sent - spill file first.                              *
+ *                                                                            *
+ ******************************************************************************/
+static int	active_spill_write(void)
+{
+	struct zbx_json		json;
+	active_spill_record_t	record;
+	char			*data, *compressed = NULL;
+	size_t			size_raw, size;
+	int			i, j, ret = FAIL;
+
+	if (-1 == spill.fd)
+		return FAIL;
+
+	zbx_json_initarray(&json, ZBX_JSON_STAT_BUF_LEN);
+	record.lastid = 0;
+
+	for (i = 0; i < buffer.count; i++)
+	{
+		if (0 != (ZBX_METRIC_FLAG_PERSISTENT & buffer.data[i].flags))
+			continue;
+
+		add_buffer_element_json(&json, &buffer.data[i]);
+
+		if (record.lastid < buffer.data[i].id)
+			record.lastid = buffer.data[i].id;
+	}
+
+	zbx_json_close(&json);
+
+	if (0 == record.lastid)
+		goto out;
+
+	/* strip array brackets, records are concatenated into a single array on replay */
+	data = json.buffer + 1;
+	size_raw = size = json.buffer_size - 2;
+
+	if (SUCCEED == zbx_compress(data, size_raw, &compressed, &size) && size < size_raw)
+		data = compressed;
+	else
+		size = size_raw;
+
+	if (spill.write_offset + sizeof(record) + size > (zbx_uint64_t)CONFIG_BUFFER_SPILL_SIZE * ZBX_MEBIBYTE)
+	{
+		if (0 == spill.full)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "buffer spill file \"%s\" is full, values will be dropped",
+					spill.path);
+			spill.full = 1;
+		}
+
+		goto out;
+	}
+
+	record.size = (zbx_uint32_t)size;
+	record.size_raw = (zbx_uint32_t)size_raw;
+
+	if (sizeof(record) != pwrite(spill.fd, &record, sizeof(record), (off_t)spill.write_offset) ||
+			(ssize_t)size != pwrite(spill.fd, data, size, (off_t)(spill.write_offset + sizeof(record))))
+	{
+		active_spill_disable("write to");
+		goto out;
+	}
+
+	spill.write_offset += sizeof(record) + size;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "buffer: moved values up to id " ZBX_FS_UI64 " to spill file, " ZBX_FS_SIZE_T
+			" bytes, " ZBX_FS_SIZE_T " compressed", record.lastid, (zbx_fs_size_t)size_raw,
+			(zbx_fs_size_t)size);
+
+	for (i = 0, j = 0; i < buffer.count; i++)
+	{
+		active_buffer_element_t	*el = &buffer.data[i];
+
+		if (0 == (ZBX_METRIC_FLAG_PERSISTENT & el->flags))
+		{
+			zbx_free(el->host);
+			zbx_free(el->key);
+			zbx_free(el->value);
+			zbx_free(el->source);
+			continue;
+		}
+
+		el->id = ++last_valueid;
+
+		if (i != j)
+			buffer.data[j] = *el;
+
+		j++;
+	}
+
+	buffer.count = j;
+	ret = SUCCEED;
+out:
+	zbx_free(compressed);
+	zbx_json_free(&json);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: read spilled values into agent data JSON                          *
+ *                                                                            *
+ * Parameters: json   - [IN/OUT] the agent data JSON with open data array     *
+ *             offset - [IN/OUT] the spill file offset                        *
+ *                                                                            *
+ * Return value: SUCCEED - the values were read                               *
+ *               FAIL    - read error or corrupted record                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	active_spill_read(struct zbx_json *json, zbx_uint64_t *offset)
+{
+	active_spill_record_t	record;
+	char			*data = NULL, *raw = NULL;
+	size_t			size_raw, batch = 0;
+	int			ret = SUCCEED;
+
+	while (*offset < spill.write_offset && ZBX_SPILL_BATCH_SIZE > batch)
+	{
+		if (sizeof(record) != pread(spill.fd, &record, sizeof(record), (off_t)*offset) ||
+				spill.write_offset - *offset - sizeof(record) < record.size)
+		{
+			ret = FAIL;
+			break;
+		}
+
+		data = (char *)zbx_realloc(data, record.size + 1);
+		raw = (char *)zbx_realloc(raw, record.size_raw + 1);
+
+		if ((ssize_t)record.size != pread(spill.fd, data, record.size, (off_t)(*offset + sizeof(record))))
+		{
+			ret = FAIL;
+			break;
+		}
+
+		if (record.size != record.size_raw)
+		{
+			size_raw = record.size_raw;
+
+			if (SUCCEED != zbx_uncompress(data, record.size, raw, &size_raw) ||
+					size_raw != record.size_raw)
+			{
+				zabbix_log(LOG_LEVEL_WARNING, "cannot uncompress buffer spill file record: %s",
+						zbx_compress_strerror());
+				ret = FAIL;
+				break;
+			}
+		}
+		else
+			memcpy(raw, data, record.size);
+
+		raw[record.size_raw] = '\0';
+		zbx_json_addraw(json, NULL, raw);
+
+		*offset += sizeof(record) + record.size;
+		batch += record.size_raw;
+	}
+
+	zbx_free(raw);
+	zbx_free(data);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: send values from spill file to server in large compressed batches *
+ *                                                                            *
+ * Return value: SUCCEED - spill file is empty                                *
+ *               FAIL    - the values cannot be sent now                      *
+ *                                                                            *
+ * Comments: Memory buffer must not be sent before the spill file is empty,   *
+ *           otherwise server would discard the older spilled values as       *
+ *           duplicates.                                                      *
+ *                                                                            *
+ ******************************************************************************/
+static int	active_spill_replay(zbx_vector_addr_ptr_t *addrs, const zbx_config_tls_t *config_tls,
+		int config_timeout)
+{
+	int		ret = SUCCEED, now;
+	zbx_uint64_t	offset;
+	zbx_timespec_t	ts;
+	zbx_socket_t	*s;
+	struct zbx_json	json;
+
+	if (SUCCEED != active_spill_pending())
+		return SUCCEED;
+
+	now = (int)time(NULL);
+
+	if (0 != spill.lastfail && CONFIG_BUFFER_SEND > now - spill.lastfail)
+		return FAIL;
+
+	while (SUCCEED == active_spill_pending())
+	{
+		offset = spill.read_offset;
+
+		zbx_json_init(&json, ZBX_JSON_STAT_BUF_LEN);
+		zbx_json_addstring(&json, ZBX_PROTO_TAG_REQUEST, ZBX_PROTO_VALUE_AGENT_DATA, ZBX_JSON_TYPE_STRING);
+		zbx_json_addstring(&json, ZBX_PROTO_TAG_SESSION, session_token, ZBX_JSON_TYPE_STRING);
+		active_request_persistent(&json);
+		zbx_json_addarray(&json, ZBX_PROTO_TAG_DATA);
+
+		if (SUCCEED != active_spill_read(&json, &offset))
+		{
+			zbx_json_free(&json);
+			zabbix_log(LOG_LEVEL_WARNING, "cannot read buffer spill file \"%s\", discarding unsent values",
+					spill.path);
+
+			if (SUCCEED != active_spill_reset())
+				active_spill_disable("initialize");
+
+			break;
+		}
+
+		zbx_json_close(&json);
+
+		if (SUCCEED == (ret = active_connect(addrs, 60, config_timeout, LOG_LEVEL_DEBUG, config_tls, &s)))
+		{
+			zbx_timespec(&ts);
+			zbx_json_adduint64(&json, ZBX_PROTO_TAG_CLOCK, ts.sec);
+			zbx_json_adduint64(&json, ZBX_PROTO_TAG_NS, ts.ns);
+
+			if (SUCCEED == (ret = zbx_tcp_send_ext(s, json.buffer, json.buffer_size, 0,
+					ZBX_TCP_PROTOCOL | ZBX_TCP_COMPRESS, 0)) && SUCCEED == (ret = zbx_tcp_recv(s)))
+			{
+				if (NULL == s->buffer || SUCCEED != check_response(s->buffer))
+					ret = FAIL;
+			}
+
+			active_disconnect(s, ret);
+		}
+
+		zbx_json_free(&json);
+
+		if (SUCCEED != ret)
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "cannot send values from buffer spill file: %s",
+					zbx_socket_strerror());
+			spill.lastfail = now;
+			return FAIL;
+		}
+
+		zabbix_log(LOG_LEVEL_DEBUG, "sent " ZBX_FS_UI64 " bytes from buffer spill file",
+				offset - spill.read_offset);
+
+		spill.read_offset = offset;
+
+		if (spill.read_offset == spill.write_offset)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "all values from buffer spill file \"%s\" have been sent",
+					spill.path);
+
+			if (SUCCEED != active_spill_reset())
+				active_spill_disable("initialize");
+		}
+		else if (sizeof(offset) != pwrite(spill.fd, &offset, sizeof(offset), ZBX_SPILL_MAGIC_LEN))
+			active_spill_disable("write to");
+	}
+
+	spill.lastfail = 0;
+	spill.full = 0;
+
+	return SUCCEED;
+}
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Purpose: Send value stored in the buffer to Zabbix server                  *
@@ -809,13 +1468,21 @@ static int	send_buffer(zbx_vector_addr_ptr_t *addrs, zbx_vector_pre_persistent_t
 	active_buffer_element_t	*el;
 	int			ret = SUCCEED, i, now, level;
 	zbx_timespec_t		ts;
-	zbx_socket_t		s;
+	zbx_socket_t		*s;
 	struct zbx_json		json;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() host:'%s' port:%d entries:%d/%d",
 			__func__, ((zbx_addr_t *)addrs->values[0])->ip, ((zbx_addr_t *)addrs->values[0])->port,
 			buffer.count, CONFIG_BUFFER_SIZE);
 
+#if !defined(_WINDOWS) && !defined(__MINGW32__)
+	/* spilled values are older than the ones in memory and must be sent first */
+	if (SUCCEED != active_spill_replay(addrs, config_tls, config_timeout))
+	{
+		ret = FAIL;
+		goto ret;
+	}
+#endif
 	if (0 == buffer.count)
 		goto ret;
 
@@ -832,57 +1499,18 @@ static int	send_buffer(zbx_vector_addr_ptr_t *addrs, zbx_vector_pre_persistent_t
 	zbx_json_init(&json, ZBX_JSON_STAT_BUF_LEN);
 	zbx_json_addstring(&json, ZBX_PROTO_TAG_REQUEST, ZBX_PROTO_VALUE_AGENT_DATA, ZBX_JSON_TYPE_STRING);
 	zbx_json_addstring(&json, ZBX_PROTO_TAG_SESSION, session_token, ZBX_JSON_TYPE_STRING);
+	active_request_persistent(&json);
 	zbx_json_addarray(&json, ZBX_PROTO_TAG_DATA);
 
 	for (i = 0; i < buffer.count; i++)
-	{
-		el = &buffer.data[i];
-
-		zbx_json_addobject(&json, NULL);
-		zbx_json_addstring(&json, ZBX_PROTO_TAG_HOST, el->host, ZBX_JSON_TYPE_STRING);
-		zbx_json_addstring(&json, ZBX_PROTO_TAG_KEY, el->key, ZBX_JSON_TYPE_STRING);
-
-		if (NULL != el->value)
-			zbx_json_addstring(&json, ZBX_PROTO_TAG_VALUE, el->value, ZBX_JSON_TYPE_STRING);
-
-		if (ITEM_STATE_NOTSUPPORTED == el->state)
-		{
-			zbx_json_adduint64(&json, ZBX_PROTO_TAG_STATE, ITEM_STATE_NOTSUPPORTED);
-		}
-		else
-		{
-			/* add item meta information only for items in normal state */
-			if (0 != (ZBX_METRIC_FLAG_LOG & el->flags))
-				zbx_json_adduint64(&json, ZBX_PROTO_TAG_LASTLOGSIZE, el->lastlogsize);
-			if (0 != (ZBX_METRIC_FLAG_LOG_LOGRT & el->flags))
-				zbx_json_adduint64(&json, ZBX_PROTO_TAG_MTIME, el->mtime);
-		}
-
-		if (0 != el->timestamp)
-			zbx_json_adduint64(&json, ZBX_PROTO_TAG_LOGTIMESTAMP, el->timestamp);
-
-		if (NULL != el->source)
-			zbx_json_addstring(&json, ZBX_PROTO_TAG_LOGSOURCE, el->source, ZBX_JSON_TYPE_STRING);
-
-		if (0 != el->severity)
-			zbx_json_adduint64(&json, ZBX_PROTO_TAG_LOGSEVERITY, el->severity);
-
-		if (0 != el->logeventid)
-			zbx_json_adduint64(&json, ZBX_PROTO_TAG_LOGEVENTID, el->logeventid);
-
-		zbx_json_adduint64(&json, ZBX_PROTO_TAG_ID, el->id);
-
-		zbx_json_adduint64(&json, ZBX_PROTO_TAG_CLOCK, el->ts.sec);
-		zbx_json_adduint64(&json, ZBX_PROTO_TAG_NS, el->ts.ns);
-		zbx_json_close(&json);
-	}
+		add_buffer_element_json(&json, &buffer.data[i]);
 
 	zbx_json_close(&json);
 
 	level = 0 == buffer.first_error ? LOG_LEVEL_WARNING : LOG_LEVEL_DEBUG;
 
-	if (SUCCEED == (ret = zbx_connect_to_server(&s, CONFIG_SOURCE_IP, addrs, MIN(buffer.count * config_timeout, 60),
-			config_timeout, 0, level, config_tls)))
+	if (SUCCEED == (ret = active_connect(addrs, MIN(buffer.count * config_timeout, 60), config_timeout, level,
+			config_tls, &s)))
 	{
 		zbx_timespec(&ts);
 		zbx_json_adduint64(&json, ZBX_PROTO_TAG_CLOCK, ts.sec);
@@ -890,13 +1518,13 @@ static int	send_buffer(zbx_vector_addr_ptr_t *addrs, zbx_vector_pre_persistent_t
 
 		zabbix_log(LOG_LEVEL_DEBUG, "JSON before sending [%s]", json.buffer);
 
-		if (SUCCEED == (ret = zbx_tcp_send(&s, json.buffer)))
+		if (SUCCEED == (ret = zbx_tcp_send(s, json.buffer)))
 		{
-			if (SUCCEED == (ret = zbx_tcp_recv(&s)))
+			if (SUCCEED == (ret = zbx_tcp_recv(s)))
 			{
-				zabbix_log(LOG_LEVEL_DEBUG, "JSON back [%s]", s.buffer);
+				zabbix_log(LOG_LEVEL_DEBUG, "JSON back [%s]", s->buffer);
 
-				if (NULL == s.buffer || SUCCEED != check_response(s.buffer))
+				if (NULL == s->buffer || SUCCEED != check_response(s->buffer))
 				{
 					ret = FAIL;
 					zabbix_log(LOG_LEVEL_DEBUG, "NOT OK");
@@ -919,7 +1547,7 @@ static int	send_buffer(zbx_vector_addr_ptr_t *addrs, zbx_vector_pre_persistent_t
 					zbx_socket_strerror());
 		}
 
-		zbx_tcp_close(&s);
+		active_disconnect(s, ret);
 	}
 
 	zbx_json_free(&json);
@@ -1053,6 +1681,11 @@ static int	process_value(zbx_vector_addr_ptr_t *addrs, zbx_vector_ptr_t *agent2_
 		goto out;
 	}
 
+#if !defined(_WINDOWS) && !defined(__MINGW32__)
+	/* keep the values on disk instead of dropping them when server is not available */
+	if (CONFIG_BUFFER_SIZE <= buffer.count)
+		active_spill_write();
+#endif
 	if (CONFIG_BUFFER_SIZE > buffer.count)
 	{
 		zabbix_log(LOG_LEVEL_DEBUG, "buffer: new element %d", buffer.count);
@@ -1269,21 +1902,26 @@ static void	process_active_checks(zbx_vector_addr_ptr_t *addrs, const zbx_config
 		int config_timeout)
 {
 	char	*error = NULL;
-	int	i, now;
+	int	now;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() server:'%s' port:%hu", __func__, addrs->values[0]->ip,
 			addrs->values[0]->port);
 
 	now = (int)time(NULL);
 
-	for (i = 0; i < active_metrics.values_num; i++)
+	/* only the due metrics are visited, in the order of their next check time */
+	while (FAIL == zbx_binary_heap_empty(&active_schedule))
 	{
 		zbx_uint64_t		lastlogsize_last, lastlogsize_sent;
 		int			mtime_last, mtime_sent, ret;
-		ZBX_ACTIVE_METRIC	*metric = (ZBX_ACTIVE_METRIC *)active_metrics.values[i];
+		ZBX_ACTIVE_METRIC	*metric;
+
+		metric = (ZBX_ACTIVE_METRIC *)zbx_binary_heap_find_min(&active_schedule)->data;
 
 		if (metric->nextcheck > now)
-			continue;
+			break;
+
+		zbx_binary_heap_remove_min(&active_schedule);
 
 		/* for meta information update we need to know if something was sent at all during the check */
 		lastlogsize_last = metric->lastlogsize;
@@ -1389,6 +2027,7 @@ static void	process_active_checks(zbx_vector_addr_ptr_t *addrs, const zbx_config
 
 		send_buffer(addrs, &pre_persistent_vec, config_tls, config_timeout);
 		metric->nextcheck = (int)time(NULL) + metric->refresh;
+		schedule_active_metric(metric);
 	}
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
@@ -1418,6 +2057,49 @@ static void	update_schedule(int delta)
 	buffer.lastsent += delta;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: calculate how long to sleep until the next scheduled event        *
+ *                                                                            *
+ * Parameters: now                 - [IN] the current time                    *
+ *             nextcheck           - [IN] the next active check time          *
+ *             nextrefresh         - [IN] the next active check list refresh  *
+ *             heartbeat_nextcheck - [IN] the next heartbeat time, 0 if       *
+ *                                        heartbeats are disabled             *
+ *                                                                            *
+ * Return value: the number of seconds to sleep                               *
+ *                                                                            *
+ * Comments: Buffered values are flushed either when the buffer fills up or   *
+ *           BufferSend seconds after the last send, so the process wakes up  *
+ *           for the latter only when there is something in the buffer.       *
+ *                                                                            *
+ ******************************************************************************/
+static int	get_idle_sleeptime(time_t now, time_t nextcheck, time_t nextrefresh, time_t heartbeat_nextcheck)
+{
+	time_t	next = now + ZBX_ACTIVE_CHECKS_IDLE_MAX;
+
+	if (nextcheck < next)
+		next = nextcheck;
+
+	if (nextrefresh < next)
+		next = nextrefresh;
+
+	if (0 != heartbeat_nextcheck && heartbeat_nextcheck < next)
+		next = heartbeat_nextcheck;
+
+	if (0 != buffer.count && buffer.lastsent + CONFIG_BUFFER_SEND < next)
+		next = buffer.lastsent + CONFIG_BUFFER_SEND;
+#if !defined(_WINDOWS) && !defined(__MINGW32__)
+	if (SUCCEED == active_spill_pending() && spill.lastfail + CONFIG_BUFFER_SEND < next)
+		next = spill.lastfail + CONFIG_BUFFER_SEND;
+#endif
+
+	if (next <= now)
+		return 1;
+
+	return (int)(next - now);
+}
+
 #ifndef _WINDOWS
 static void	zbx_active_checks_sigusr_handler(int flags)
 {
@@ -1429,8 +2111,8 @@ static void	zbx_active_checks_sigusr_handler(int flags)
 static void	send_heartbeat_msg(zbx_vector_addr_ptr_t *addrs, const zbx_config_tls_t *config_tls, int config_timeout)
 {
 	static ZBX_THREAD_LOCAL int	last_ret = SUCCEED;
-	int				ret, level;
-	zbx_socket_t			s;
+	int				ret, level, keep = FAIL;
+	zbx_socket_t			*s;
 	struct zbx_json			json;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
@@ -1440,17 +2122,19 @@ static void	send_heartbeat_msg(zbx_vector_addr_ptr_t *addrs, const zbx_config_tl
 	zbx_json_addstring(&json, ZBX_PROTO_TAG_REQUEST, ZBX_PROTO_VALUE_ACTIVE_CHECK_HEARTBEAT, ZBX_JSON_TYPE_STRING);
 	zbx_json_addstring(&json, ZBX_PROTO_TAG_HOST, CONFIG_HOSTNAME, ZBX_JSON_TYPE_STRING);
 	zbx_json_addint64(&json, ZBX_PROTO_TAG_HEARTBEAT_FREQ, CONFIG_HEARTBEAT_FREQUENCY);
+	active_request_persistent(&json);
 
 	level = SUCCEED != last_ret ? LOG_LEVEL_DEBUG : LOG_LEVEL_WARNING;
 
-	if (SUCCEED == (ret = zbx_connect_to_server(&s, CONFIG_SOURCE_IP, addrs, config_timeout, config_timeout,
-			0, level, config_tls)))
+	if (SUCCEED == (ret = active_connect(addrs, config_timeout, config_timeout, level, config_tls, &s)))
 	{
 		zabbix_log(LOG_LEVEL_DEBUG, "sending [%s]", json.buffer);
 
-		if (SUCCEED == (ret = zbx_tcp_send(&s, json.buffer)))
+		if (SUCCEED == (ret = zbx_tcp_send(s, json.buffer)))
 		{
-			(void)zbx_tcp_recv(&s);	/* allow Zabbix server or Zabbix proxy to close connection */
+			/* allow Zabbix server or Zabbix proxy to close connection, over persistent connection */
+			/* the response confirms that the connection can be used for next request             */
+			keep = zbx_tcp_recv(s);
 
 			if (last_ret == FAIL)
 			{
@@ -1468,7 +2152,7 @@ static void	send_heartbeat_msg(zbx_vector_addr_ptr_t *addrs, const zbx_config_tl
 				zbx_socket_strerror());
 	}
 
-	zbx_tcp_close(&s);
+	active_disconnect(s, SUCCEED == ret ? keep : ret);
 	last_ret = ret;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "Out %s()", __func__);
@@ -1479,6 +2163,7 @@ ZBX_THREAD_ENTRY(active_checks_thread, args)
 	zbx_thread_activechk_args	activechk_args, *activechks_args_in;
 	time_t				nextcheck = 0, nextrefresh = 0, nextsend = 0, now, delta, lastcheck = 0,
 					heartbeat_nextcheck = 0;
+	int				sleeptime;
 	zbx_uint32_t			config_revision_local = 0;
 	zbx_thread_info_t		*info = &((zbx_thread_args_t *)args)->info;
 	unsigned char			process_type = ((zbx_thread_args_t *)args)->info.process_type;
@@ -1505,6 +2190,16 @@ ZBX_THREAD_ENTRY(active_checks_thread, args)
 	init_active_metrics();
 
 #ifndef _WINDOWS
+	if (NULL != CONFIG_BUFFER_SPILL_FILE)
+	{
+		char	*path;
+
+		/* each ServerActive entry has its own spill file */
+		path = zbx_dsprintf(NULL, "%s.%d", CONFIG_BUFFER_SPILL_FILE, process_num);
+		active_spill_open(path);
+		zbx_free(path);
+	}
+
 	zbx_set_sigusr_handler(zbx_active_checks_sigusr_handler);
 #endif
 
@@ -1589,13 +2284,18 @@ ZBX_THREAD_ENTRY(active_checks_thread, args)
 					heartbeat_nextcheck += delta;
 			}
 
-			zbx_setproctitle("active checks #%d [idle 1 sec]", process_num);
-			zbx_sleep(1);
+			sleeptime = get_idle_sleeptime(now, nextcheck, nextrefresh, heartbeat_nextcheck);
+
+			zbx_setproctitle("active checks #%d [idle %d sec]", process_num, sleeptime);
+			zbx_sleep(sleeptime);
 		}
 
 		lastcheck = now;
 	}
 
+	if (0 != active_sock_connected)
+		zbx_tcp_close(&active_sock);
+
 	zbx_free(session_token);
 
 #ifdef _WINDOWS
@@ -357,6 +357,60 @@ static int	get_cpu_perf_counter_status(zbx_perf_counter_status_t pc_status)
 	return ZBX_CPU_STATUS_OFFLINE;
 }
 #else	/* not _WINDOWS */
+/******************************************************************************
+ *                                                                            *
+ * Purpose: calculate CPU utilization over all averaging intervals from the   *
+ *          latest history entry, so that requests do not need to walk the    *
+ *          history                                                           *
+ *                                                                            *
+ * Parameters: cpu      - [IN/OUT] CPU statistics                             *
+ *             idx_curr - [IN] index of the latest history entry              *
+ *                                                                            *
+ * Comments: must be called with CPU statistics locked                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	update_cpu_util(ZBX_SINGLE_CPU_STAT_DATA *cpu, int idx_curr)
+{
+	static const int	intervals[ZBX_AVG_COUNT] = {SEC_PER_MIN, 5 * SEC_PER_MIN, 15 * SEC_PER_MIN};
+	zbx_uint64_t		delta[ZBX_CPU_STATE_COUNT], total;
+	int			i, mode, idx_base;
+
+	for (mode = 0; mode < ZBX_AVG_COUNT; mode++)
+	{
+		total = 0;
+
+		if (1 == cpu->h_count)
+		{
+			for (i = 0; i < ZBX_CPU_STATE_COUNT; i++)
+				total += (delta[i] = cpu->h_counter[i][idx_curr]);
+		}
+		else
+		{
+			if (0 > (idx_base = idx_curr - MIN(cpu->h_count - 1, intervals[mode])))
+				idx_base += ZBX_MAX_COLLECTOR_HISTORY;
+
+			while (SYSINFO_RET_OK != cpu->h_status[idx_base])
+				if (ZBX_MAX_COLLECTOR_HISTORY == ++idx_base)
+					idx_base -= ZBX_MAX_COLLECTOR_HISTORY;
+
+			/* current counter might be less than previous due to guest time sometimes not being fully */
+			/* included in user time by "/proc/stat" */
+			for (i = 0; i < ZBX_CPU_STATE_COUNT; i++)
+			{
+				if (cpu->h_counter[i][idx_curr] > cpu->h_counter[i][idx_base])
+					delta[i] = cpu->h_counter[i][idx_curr] - cpu->h_counter[i][idx_base];
+				else
+					delta[i] = 0;
+
+				total += delta[i];
+			}
+		}
+
+		for (i = 0; i < ZBX_CPU_STATE_COUNT; i++)
+			cpu->h_util[mode][i] = 0 == total ? 0 : 100. * (double)delta[i] / (double)total;
+	}
+}
+
 static void	update_cpu_counters(ZBX_SINGLE_CPU_STAT_DATA *cpu, zbx_uint64_t *counter)
 {
 	int	i, index;
@@ -377,6 +431,8 @@ static void	update_cpu_counters(ZBX_SINGLE_CPU_STAT_DATA *cpu, zbx_uint64_t *cou
 			cpu->h_counter[i][index] = counter[i];
 
 		cpu->h_status[index] = SYSINFO_RET_OK;
+
+		update_cpu_util(cpu, index);
 	}
 	else
 		cpu->h_status[index] = SYSINFO_RET_FAIL;
@@ -1091,6 +1147,13 @@ static ZBX_SINGLE_CPU_STAT_DATA	*get_cpustat_by_num(ZBX_CPUS_STAT_DATA *pcpus, i
 {
 	int	idx;
 
+	/* CPUs are normally stored by number, starting with index 1 */
+	if (ZBX_CPUNUM_ALL == cpu_num)
+		return &pcpus->cpu[0];
+
+	if (0 <= cpu_num && cpu_num < pcpus->count && cpu_num == pcpus->cpu[cpu_num + 1].cpu_num)
+		return &pcpus->cpu[cpu_num + 1];
+
 	for (idx = 0; idx <= pcpus->count; idx++)
 	{
 		if (pcpus->cpu[idx].cpu_num == cpu_num)
@@ -1102,27 +1165,15 @@ static ZBX_SINGLE_CPU_STAT_DATA	*get_cpustat_by_num(ZBX_CPUS_STAT_DATA *pcpus, i
 
 int	get_cpustat(AGENT_RESULT *result, int cpu_num, int state, int mode)
 {
-	int				i, time, idx_curr, idx_base;
-	zbx_uint64_t			counter, total = 0;
+	int				idx_curr;
+	double				util;
 	ZBX_SINGLE_CPU_STAT_DATA	*cpu;
 
 	if (0 > state || state >= ZBX_CPU_STATE_COUNT)
 		return SYSINFO_RET_FAIL;
 
-	switch (mode)
-	{
-		case ZBX_AVG1:
-			time = SEC_PER_MIN;
-			break;
-		case ZBX_AVG5:
-			time = 5 * SEC_PER_MIN;
-			break;
-		case ZBX_AVG15:
-			time = 15 * SEC_PER_MIN;
-			break;
-		default:
-			return SYSINFO_RET_FAIL;
-	}
+	if (0 > mode || mode >= ZBX_AVG_COUNT)
+		return SYSINFO_RET_FAIL;
 
 	if (0 == CPU_COLLECTOR_STARTED(collector))
 	{
@@ -1154,38 +1205,11 @@ int	get_cpustat(AGENT_RESULT *result, int cpu_num, int state, int mode)
 		return SYSINFO_RET_FAIL;
 	}
 
-	if (1 == cpu->h_count)
-	{
-		for (i = 0; i < ZBX_CPU_STATE_COUNT; i++)
-			total += cpu->h_counter[i][idx_curr];
-		counter = cpu->h_counter[state][idx_curr];
-	}
-	else
-	{
-		if (0 > (idx_base = idx_curr - MIN(cpu->h_count - 1, time)))
-			idx_base += ZBX_MAX_COLLECTOR_HISTORY;
-
-		while (SYSINFO_RET_OK != cpu->h_status[idx_base])
-			if (ZBX_MAX_COLLECTOR_HISTORY == ++idx_base)
-				idx_base -= ZBX_MAX_COLLECTOR_HISTORY;
-
-		for (i = 0; i < ZBX_CPU_STATE_COUNT; i++)
-		{
-			if (cpu->h_counter[i][idx_curr] > cpu->h_counter[i][idx_base])
-				total += cpu->h_counter[i][idx_curr] - cpu->h_counter[i][idx_base];
-		}
-
-		/* current counter might be less than previous due to guest time sometimes not being fully included */
-		/* in user time by "/proc/stat" */
-		if (cpu->h_counter[state][idx_curr] > cpu->h_counter[state][idx_base])
-			counter = cpu->h_counter[state][idx_curr] - cpu->h_counter[state][idx_base];
-		else
-			counter = 0;
-	}
+	util = cpu->h_util[mode][state];
 
 	UNLOCK_CPUSTATS;
 
-	SET_DBL_RESULT(result, 0 == total ? 0 : 100. * (double)counter / (double)total);
+	SET_DBL_RESULT(result, util);
 
 	return SYSINFO_RET_OK;
 }
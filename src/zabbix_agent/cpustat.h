@@ -43,6 +43,8 @@ int	get_cpu_perf_counter_value(int cpu_num, int interval, double *value, char **
 typedef struct
 {
 	zbx_uint64_t	h_counter[ZBX_CPU_STATE_COUNT][ZBX_MAX_COLLECTOR_HISTORY];
+	double		h_util[ZBX_AVG_COUNT][ZBX_CPU_STATE_COUNT];	/* utilization over 1, 5 and 15 minutes */
+								/* calculated from the latest history entry */
 	unsigned char	h_status[ZBX_MAX_COLLECTOR_HISTORY];
 #if (ZBX_MAX_COLLECTOR_HISTORY % 8) > 0
 	unsigned char	padding0[8 - (ZBX_MAX_COLLECTOR_HISTORY % 8)];	/* for 8-byte alignment */
@@ -546,26 +546,77 @@ out:
 	return ret;
 }
 
-/* expand the string message from a specific event handler */
-static char	*expand_message6(const wchar_t *pname, EVT_HANDLE event)
+/* publisher metadata handle, cached while processing one event log batch */
+typedef struct
 {
-	wchar_t		*pmessage = NULL;
-	EVT_HANDLE	provider = NULL;
-	DWORD		require = 0;
-	char		*out_message = NULL;
-	char		*tmp_pname = NULL;
+	wchar_t		*name;
+	EVT_HANDLE	handle;		/* NULL if the publisher metadata could not be opened */
+}
+zbx_evt_publisher_t;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+static void	evt_publisher_free(zbx_evt_publisher_t *publisher)
+{
+	if (NULL != publisher->handle)
+		EvtClose(publisher->handle);
+
+	zbx_free(publisher->name);
+	zbx_free(publisher);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get publisher metadata handle, opening it only once per batch     *
+ *                                                                            *
+ * Parameters: pname      - [IN] the publisher name                           *
+ *             publishers - [IN/OUT] the already opened publishers            *
+ *                                                                            *
+ * Return value: The publisher metadata handle or NULL if it cannot be        *
+ *               opened.                                                      *
+ *                                                                            *
+ ******************************************************************************/
+static EVT_HANDLE	get_publisher6(const wchar_t *pname, zbx_vector_ptr_t *publishers)
+{
+	zbx_evt_publisher_t	*publisher;
+	int			i;
 
-	if (NULL == (provider = EvtOpenPublisherMetadata(NULL, pname, NULL, 0, 0)))
+	for (i = 0; i < publishers->values_num; i++)
 	{
+		publisher = (zbx_evt_publisher_t *)publishers->values[i];
+
+		if (0 == wcscmp(publisher->name, pname))
+			return publisher->handle;
+	}
+
+	publisher = (zbx_evt_publisher_t *)zbx_malloc(NULL, sizeof(zbx_evt_publisher_t));
+	publisher->name = wcsdup(pname);
+
+	if (NULL == (publisher->handle = EvtOpenPublisherMetadata(NULL, pname, NULL, 0, 0)))
+	{
+		char	*tmp_pname;
+
 		tmp_pname = zbx_unicode_to_utf8(pname);
 		zabbix_log(LOG_LEVEL_DEBUG, "provider '%s' could not be opened: %s",
 				tmp_pname, strerror_from_system(GetLastError()));
 		zbx_free(tmp_pname);
-		goto out;
 	}
 
+	zbx_vector_ptr_append(publishers, publisher);
+
+	return publisher->handle;
+}
+
+/* expand the string message from a specific event handler */
+static char	*expand_message6(EVT_HANDLE provider, EVT_HANDLE event)
+{
+	wchar_t		*pmessage = NULL;
+	DWORD		require = 0;
+	char		*out_message = NULL;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	if (NULL == provider)
+		goto out;
+
 	if (TRUE != EvtFormatMessage(provider, event, 0, 0, NULL, EvtFormatMessageEvent, 0, NULL, &require))
 	{
 		if (ERROR_INSUFFICIENT_BUFFER == GetLastError())
@@ -595,8 +646,6 @@ static char	*expand_message6(const wchar_t *pname, EVT_HANDLE event)
 		}
 	}
 out:
-	if (NULL != provider)
-		EvtClose(provider);
 	zbx_free(pmessage);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, out_message);
@@ -649,17 +698,13 @@ static void	replace_sid_to_account(PSID sidVal, char **out_message)
 	zbx_free(tmp);
 }
 
-static void	replace_sids_to_accounts(EVT_HANDLE event_bookmark, char **out_message)
+static void	replace_sids_to_accounts(EVT_HANDLE render_context, EVT_HANDLE event_bookmark, char **out_message)
 {
 	DWORD		status, dwBufferSize = 0, dwBufferUsed = 0, dwPropertyCount = 0, i;
 	PEVT_VARIANT	renderedContent = NULL;
-	EVT_HANDLE	render_context;
 
-	if (NULL == (render_context = EvtCreateRenderContext(0, NULL, EvtRenderContextUser)))
-	{
-		zabbix_log(LOG_LEVEL_WARNING, "EvtCreateRenderContext failed:%s", strerror_from_system(GetLastError()));
-		goto cleanup;
-	}
+	if (NULL == render_context)
+		return;
 
 	if (TRUE != EvtRender(render_context, event_bookmark, EvtRenderEventValues, dwBufferSize, renderedContent,
 			&dwBufferUsed, &dwPropertyCount))
@@ -687,9 +732,6 @@ static void	replace_sids_to_accounts(EVT_HANDLE event_bookmark, char **out_messa
 			replace_sid_to_account(renderedContent[i].SidVal, out_message);
 	}
 cleanup:
-	if (NULL != render_context)
-		EvtClose(render_context);
-
 	zbx_free(renderedContent);
 }
 
@@ -699,28 +741,32 @@ cleanup:
  *                                                                            *
  * Parameters: wsource        - [IN] EventLog file name                       *
  *             render_context - [IN] the handle to the rendering context      *
- *             event_bookmark - [IN/OUT] the handle of Event record for parse *
+ *             event_bookmark - [IN] the handle of Event record for parse     *
  *             which          - [IN/OUT] the position of the EventLog record  *
  *             out_severity   - [OUT] the ELR detail                          *
  *             out_timestamp  - [OUT] the ELR detail                          *
  *             out_provider   - [OUT] the ELR detail                          *
  *             out_source     - [OUT] the ELR detail                          *
- *             out_message    - [OUT] the ELR detail                          *
  *             out_eventid    - [OUT] the ELR detail                          *
  *             out_keywords   - [OUT] the ELR detail                          *
+ *             out_content    - [OUT] the rendered event values, must be      *
+ *                                    freed by caller                         *
  *             error          - [OUT] the error message in the case of        *
  *                                    failure                                 *
  *                                                                            *
  * Return value: SUCCEED or FAIL                                              *
  *                                                                            *
+ * Comments: The event message is not formatted here, as it is the most       *
+ *           expensive part. Use zbx_get_eventlog_message6() to get it only   *
+ *           for events that passed the other filters.                        *
+ *                                                                            *
  ******************************************************************************/
 static int	zbx_parse_eventlog_message6(const wchar_t *wsource, EVT_HANDLE *render_context,
-		EVT_HANDLE *event_bookmark, zbx_uint64_t *which, unsigned short *out_severity,
-		unsigned long *out_timestamp, char **out_provider, char **out_source, char **out_message,
-		unsigned long *out_eventid, zbx_uint64_t *out_keywords, char **error)
+		EVT_HANDLE event_bookmark, zbx_uint64_t *which, unsigned short *out_severity,
+		unsigned long *out_timestamp, char **out_provider, char **out_source, unsigned long *out_eventid,
+		zbx_uint64_t *out_keywords, EVT_VARIANT **out_content, char **error)
 {
 	EVT_VARIANT*		renderedContent = NULL;
-	const wchar_t		*pprovider = NULL;
 	char			*tmp_str = NULL;
 	DWORD			size = 0, bookmarkedCount = 0, require = 0, error_code;
 	const zbx_uint64_t	sec_1970 = 116444736000000000;
@@ -731,7 +777,7 @@ static int	zbx_parse_eventlog_message6(const wchar_t *wsource, EVT_HANDLE *rende
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() EventRecordID:" ZBX_FS_UI64, __func__, *which);
 
 	/* obtain the information from the selected events */
-	if (TRUE != EvtRender(*render_context, *event_bookmark, EvtRenderEventValues, size, renderedContent,
+	if (TRUE != EvtRender(*render_context, event_bookmark, EvtRenderEventValues, size, renderedContent,
 			&require, &bookmarkedCount))
 	{
 		/* information exceeds the space allocated */
@@ -744,7 +790,7 @@ static int	zbx_parse_eventlog_message6(const wchar_t *wsource, EVT_HANDLE *rende
 		size = require;
 		renderedContent = (EVT_VARIANT *)zbx_malloc(NULL, size);
 
-		if (TRUE != EvtRender(*render_context, *event_bookmark, EvtRenderEventValues, size, renderedContent,
+		if (TRUE != EvtRender(*render_context, event_bookmark, EvtRenderEventValues, size, renderedContent,
 				&require, &bookmarkedCount))
 		{
 			*error = zbx_dsprintf(*error, "EvtRender failed: %s", strerror_from_system(GetLastError()));
@@ -752,8 +798,7 @@ static int	zbx_parse_eventlog_message6(const wchar_t *wsource, EVT_HANDLE *rende
 		}
 	}
 
-	pprovider = VAR_PROVIDER_NAME(renderedContent);
-	*out_provider = zbx_unicode_to_utf8(pprovider);
+	*out_provider = zbx_unicode_to_utf8(VAR_PROVIDER_NAME(renderedContent));
 	*out_source = NULL;
 
 	if (NULL != VAR_SOURCE_NAME(renderedContent))
@@ -765,76 +810,98 @@ static int	zbx_parse_eventlog_message6(const wchar_t *wsource, EVT_HANDLE *rende
 	*out_severity = VAR_LEVEL(renderedContent);
 	*out_timestamp = (unsigned long)((VAR_TIME_CREATED(renderedContent) - sec_1970) / 10000000);
 	*out_eventid = VAR_EVENT_ID(renderedContent);
-	*out_message = expand_message6(pprovider, *event_bookmark);
-
-	if (NULL != *out_message)
-		replace_sids_to_accounts(*event_bookmark, out_message);
-
-	tmp_str = zbx_unicode_to_utf8(wsource);
 
 	if (VAR_RECORD_NUMBER(renderedContent) != *which)
 	{
+		tmp_str = zbx_unicode_to_utf8(wsource);
 		zabbix_log(LOG_LEVEL_DEBUG, "%s() Overwriting expected EventRecordID:" ZBX_FS_UI64 " with the real"
 				" EventRecordID:" ZBX_FS_UI64 " in eventlog '%s'", __func__, *which,
 				VAR_RECORD_NUMBER(renderedContent), tmp_str);
 		*which = VAR_RECORD_NUMBER(renderedContent);
 	}
 
+	*out_content = renderedContent;
+	renderedContent = NULL;
+
+	ret = SUCCEED;
+out:
+	zbx_free(tmp_str);
+	zbx_free(renderedContent);
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: format message of a single EventLog record                        *
+ *                                                                            *
+ * Parameters: event_bookmark - [IN] the handle of Event record               *
+ *             content        - [IN] the rendered event values                *
+ *             eventid        - [IN] the event identifier                     *
+ *             provider       - [IN] the event provider name                  *
+ *             publishers     - [IN/OUT] the opened publisher metadata        *
+ *             user_context   - [IN] the user rendering context for SID       *
+ *                                   replacement, optional                    *
+ *                                                                            *
+ * Return value: The event message, must be freed by caller.                  *
+ *                                                                            *
+ ******************************************************************************/
+static char	*zbx_get_eventlog_message6(EVT_HANDLE event_bookmark, const EVT_VARIANT *content,
+		unsigned long eventid, const char *provider, zbx_vector_ptr_t *publishers, EVT_HANDLE user_context)
+{
+	char	*out_message;
+
+	out_message = expand_message6(get_publisher6(VAR_PROVIDER_NAME(content), publishers), event_bookmark);
+
+	if (NULL != out_message)
+	{
+		replace_sids_to_accounts(user_context, event_bookmark, &out_message);
+		return out_message;
+	}
+
 	/* some events don't have enough information for making event message */
-	if (NULL == *out_message)
+	out_message = zbx_dsprintf(NULL, "The description for Event ID:%lu in Source:'%s'"
+			" cannot be found. Either the component that raises this event is not installed"
+			" on your local computer or the installation is corrupted. You can install or repair"
+			" the component on the local computer. If the event originated on another computer,"
+			" the display information had to be saved with the event.", eventid,
+			NULL == provider ? "" : provider);
+
+	if (EvtVarTypeString == (VAR_EVENT_DATA_TYPE(content) & EVT_VARIANT_TYPE_MASK))
 	{
-		*out_message = zbx_strdcatf(*out_message, "The description for Event ID:%lu in Source:'%s'"
-				" cannot be found. Either the component that raises this event is not installed"
-				" on your local computer or the installation is corrupted. You can install or repair"
-				" the component on the local computer. If the event originated on another computer,"
-				" the display information had to be saved with the event.", *out_eventid,
-				NULL == *out_provider ? "" : *out_provider);
+		unsigned int	i;
+		char		*data = NULL;
 
-		if (EvtVarTypeString == (VAR_EVENT_DATA_TYPE(renderedContent) & EVT_VARIANT_TYPE_MASK))
+		if (0 != (VAR_EVENT_DATA_TYPE(content) & EVT_VARIANT_TYPE_ARRAY) &&
+			0 < VAR_EVENT_DATA_COUNT(content))
 		{
-			unsigned int	i;
-			char		*data = NULL;
+			out_message = zbx_strdcatf(out_message, " The following information was included"
+					" with the event: ");
 
-			if (0 != (VAR_EVENT_DATA_TYPE(renderedContent) & EVT_VARIANT_TYPE_ARRAY) &&
-				0 < VAR_EVENT_DATA_COUNT(renderedContent))
+			for (i = 0; i < VAR_EVENT_DATA_COUNT(content); i++)
 			{
-				*out_message = zbx_strdcatf(*out_message, " The following information was included"
-						" with the event: ");
-
-				for (i = 0; i < VAR_EVENT_DATA_COUNT(renderedContent); i++)
+				if (NULL != VAR_EVENT_DATA_STRING_ARRAY(content, i))
 				{
-					if (NULL != VAR_EVENT_DATA_STRING_ARRAY(renderedContent, i))
-					{
-						if (0 < i)
-							*out_message = zbx_strdcat(*out_message, "; ");
+					if (0 < i)
+						out_message = zbx_strdcat(out_message, "; ");
 
-						data = zbx_unicode_to_utf8(VAR_EVENT_DATA_STRING_ARRAY(renderedContent,
-								i));
-						*out_message = zbx_strdcatf(*out_message, "%s", data);
-						zbx_free(data);
-					}
+					data = zbx_unicode_to_utf8(VAR_EVENT_DATA_STRING_ARRAY(content, i));
+					out_message = zbx_strdcatf(out_message, "%s", data);
+					zbx_free(data);
 				}
 			}
-			else if (NULL != VAR_EVENT_DATA_STRING(renderedContent))
-			{
-				data = zbx_unicode_to_utf8(VAR_EVENT_DATA_STRING(renderedContent));
-				*out_message = zbx_strdcatf(*out_message, "The following information was included"
-						" with the event: %s", data);
-				zbx_free(data);
-			}
+		}
+		else if (NULL != VAR_EVENT_DATA_STRING(content))
+		{
+			data = zbx_unicode_to_utf8(VAR_EVENT_DATA_STRING(content));
+			out_message = zbx_strdcatf(out_message, "The following information was included"
+					" with the event: %s", data);
+			zbx_free(data);
 		}
 	}
 
-	ret = SUCCEED;
-out:
-	EvtClose(*event_bookmark);
-	*event_bookmark = NULL;
-
-	zbx_free(tmp_str);
-	zbx_free(renderedContent);
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
-
-	return ret;
+	return out_message;
 }
 
 /******************************************************************************
@@ -881,13 +948,16 @@ static int	process_eventslog6(zbx_vector_ptr_t *addrs, zbx_vector_ptr_t *agent2_
 		zbx_process_value_func_t process_value_cb, const zbx_config_tls_t *config_tls, int config_timeout,
 		ZBX_ACTIVE_METRIC *metric, zbx_uint64_t *lastlogsize_sent, char **error)
 {
-#	define EVT_ARRAY_SIZE	100
+#	define EVT_ARRAY_SIZE	1000
 
-	const char	*str_severity;
-	zbx_uint64_t	keywords, i, reading_startpoint = 0;
-	wchar_t		*eventlog_name_w = NULL;
-	int		s_count = 0, p_count = 0, send_err = SUCCEED, ret = FAIL, match = SUCCEED;
-	DWORD		required_buf_size = 0, error_code = ERROR_SUCCESS;
+	const char		*str_severity;
+	zbx_uint64_t		keywords, i, reading_startpoint = 0;
+	wchar_t			*eventlog_name_w = NULL;
+	int			s_count = 0, p_count = 0, send_err = SUCCEED, ret = FAIL, match = SUCCEED;
+	DWORD			required_buf_size = 0, error_code = ERROR_SUCCESS, batch_size;
+	zbx_vector_ptr_t	publishers;
+	EVT_HANDLE		user_context = NULL;
+	EVT_VARIANT		*evt_content;
 
 	unsigned long	evt_timestamp, evt_eventid = 0;
 	char		*evt_provider, *evt_source, *evt_message, str_logeventid[8];
@@ -898,6 +968,8 @@ static int	process_eventslog6(zbx_vector_ptr_t *addrs, zbx_vector_ptr_t *agent2_
 			ZBX_FS_UI64 ", LastID: " ZBX_FS_UI64, __func__, eventlog_name, lastlogsize, FirstID,
 			LastID);
 
+	zbx_vector_ptr_create(&publishers);
+
 	/* update counters */
 	if (1 == metric->skip_old_data)
 	{
@@ -923,10 +995,16 @@ static int	process_eventslog6(zbx_vector_ptr_t *addrs, zbx_vector_ptr_t *agent2_
 
 	eventlog_name_w = zbx_utf8_to_unicode(eventlog_name);
 
+	if (NULL == (user_context = EvtCreateRenderContext(0, NULL, EvtRenderContextUser)))
+		zabbix_log(LOG_LEVEL_WARNING, "EvtCreateRenderContext failed:%s", strerror_from_system(GetLastError()));
+
 	while (ERROR_SUCCESS == error_code)
 	{
+		/* do not fetch more entries than can be processed during this check */
+		batch_size = (DWORD)MAX(1, MIN(EVT_ARRAY_SIZE, 4 * rate * metric->refresh - p_count));
+
 		/* get the entries */
-		if (TRUE != EvtNext(*query, EVT_ARRAY_SIZE, event_bookmarks, INFINITE, 0, &required_buf_size))
+		if (TRUE != EvtNext(*query, batch_size, event_bookmarks, INFINITE, 0, &required_buf_size))
 		{
 			/* The event reading query had less items than we calculated before. */
 			/* Either the eventlog was cleaned or our calculations were wrong.   */
@@ -944,13 +1022,15 @@ static int	process_eventslog6(zbx_vector_ptr_t *addrs, zbx_vector_ptr_t *agent2_
 		{
 			lastlogsize += 1;
 
-			if (SUCCEED != zbx_parse_eventlog_message6(eventlog_name_w, render_context, &event_bookmarks[i],
+			if (SUCCEED != zbx_parse_eventlog_message6(eventlog_name_w, render_context, event_bookmarks[i],
 					&lastlogsize, &evt_severity, &evt_timestamp, &evt_provider, &evt_source,
-					&evt_message, &evt_eventid, &keywords, error))
+					&evt_eventid, &keywords, &evt_content, error))
 			{
 				goto out;
 			}
 
+			evt_message = NULL;
+
 			switch (evt_severity)
 			{
 				case WINEVENT_LEVEL_LOG_ALWAYS:
@@ -995,6 +1075,10 @@ static int	process_eventslog6(zbx_vector_ptr_t *addrs, zbx_vector_ptr_t *agent2_
 			{
 				int	ret1, ret2, ret3, ret4;
 
+				/* format the first message to validate all regular expressions */
+				evt_message = zbx_get_eventlog_message6(event_bookmarks[i], evt_content, evt_eventid,
+						evt_provider, &publishers, user_context);
+
 				if (FAIL == (ret1 = zbx_regexp_match_ex(regexps, evt_message, pattern,
 						ZBX_CASE_SENSITIVE)))
 				{
@@ -1026,6 +1110,7 @@ static int	process_eventslog6(zbx_vector_ptr_t *addrs, zbx_vector_ptr_t *agent2_
 
 				if (FAIL == match)
 				{
+					zbx_free(evt_content);
 					zbx_free(evt_source);
 					zbx_free(evt_provider);
 					zbx_free(evt_message);
@@ -1039,16 +1124,28 @@ static int	process_eventslog6(zbx_vector_ptr_t *addrs, zbx_vector_ptr_t *agent2_
 			}
 			else
 			{
-				match = ZBX_REGEXP_MATCH == zbx_regexp_match_ex(regexps, evt_message, pattern,
-							ZBX_CASE_SENSITIVE) &&
-						ZBX_REGEXP_MATCH == zbx_regexp_match_ex(regexps, str_severity,
+				/* check the cheap fields first, formatting the message is expensive */
+				match = ZBX_REGEXP_MATCH == zbx_regexp_match_ex(regexps, str_severity,
 							key_severity, ZBX_IGNORE_CASE) &&
 						ZBX_REGEXP_MATCH == zbx_regexp_match_ex(regexps, evt_provider,
 							key_source, ZBX_IGNORE_CASE) &&
 						ZBX_REGEXP_MATCH == zbx_regexp_match_ex(regexps, str_logeventid,
 							key_logeventid, ZBX_CASE_SENSITIVE);
+
+				if (0 != match)
+				{
+					evt_message = zbx_get_eventlog_message6(event_bookmarks[i], evt_content,
+							evt_eventid, evt_provider, &publishers, user_context);
+
+					match = ZBX_REGEXP_MATCH == zbx_regexp_match_ex(regexps, evt_message, pattern,
+							ZBX_CASE_SENSITIVE);
+				}
 			}
 
+			zbx_free(evt_content);
+			EvtClose(event_bookmarks[i]);
+			event_bookmarks[i] = NULL;
+
 			if (1 == match)
 			{
 				send_err = process_value_cb(addrs, agent2_result, CONFIG_HOSTNAME, metric->key_orig,
@@ -1101,6 +1198,12 @@ out:
 			EvtClose(event_bookmarks[i]);
 	}
 
+	if (NULL != user_context)
+		EvtClose(user_context);
+
+	zbx_vector_ptr_clear_ext(&publishers, (zbx_clean_func_t)evt_publisher_free);
+	zbx_vector_ptr_destroy(&publishers);
+
 	zbx_free(eventlog_name_w);
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s last eventid:%lu", __func__, zbx_result_string(ret), evt_eventid);
 
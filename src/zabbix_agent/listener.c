@@ -24,7 +24,9 @@
 #include "log.h"
 #include "zbxstr.h"
 #include "zbxtime.h"
+#include "zbxjson.h"
 #include "zbx_rtc_constants.h"
+#include "version.h"
 
 #if defined(ZABBIX_SERVICE)
 #	include "zbxwinservice.h"
@@ -36,63 +38,196 @@
 static volatile sig_atomic_t	need_update_userparam;
 #endif
 
-static void	process_listener(zbx_socket_t *s, int config_timeout)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: check if request is a batch of passive checks                     *
+ *                                                                            *
+ * Comments: Item keys cannot start with '{', so requests of older servers    *
+ *           are never mistaken for a batch.                                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	is_passive_checks_request(const char *buffer, struct zbx_json_parse *jp)
+{
+	char	request[MAX_STRING_LEN];
+
+	if ('{' != *buffer || SUCCEED != zbx_json_open(buffer, jp))
+		return FAIL;
+
+	if (SUCCEED != zbx_json_value_by_name(jp, ZBX_PROTO_TAG_REQUEST, request, sizeof(request), NULL))
+		return FAIL;
+
+	return 0 == strcmp(request, ZBX_PROTO_VALUE_GET_PASSIVE_CHECKS) ? SUCCEED : FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: execute a batch of passive checks received in one request         *
+ *                                                                            *
+ * Parameters: s              - [IN] the connection to respond to             *
+ *             jp             - [IN] the request                              *
+ *             config_timeout - [IN]                                          *
+ *                                                                            *
+ * Comments: Request:                                                         *
+ *             {"request":"passive checks","data":[{"key":"..."},...]}        *
+ *           Response, one object per requested key in the same order:        *
+ *             {"version":"...","data":[{"value":"..."},{"error":"..."},...]} *
+ *                                                                            *
+ ******************************************************************************/
+static int	process_passive_checks(zbx_socket_t *s, const struct zbx_json_parse *jp, int config_timeout)
 {
-	AGENT_RESULT	result;
-	char		**value = NULL;
-	int		ret;
+	struct zbx_json_parse	jp_data, jp_row;
+	struct zbx_json		j;
+	const char		*p = NULL;
+	char			*key = NULL, **value;
+	size_t			key_alloc = 0;
+	int			ret;
+	AGENT_RESULT		result;
+
+	zbx_json_init(&j, ZBX_JSON_STAT_BUF_LEN);
+	zbx_json_addstring(&j, ZBX_PROTO_TAG_VERSION, ZABBIX_VERSION, ZBX_JSON_TYPE_STRING);
+	zbx_json_addarray(&j, ZBX_PROTO_TAG_DATA);
+
+	if (SUCCEED != zbx_json_brackets_by_name(jp, ZBX_PROTO_TAG_DATA, &jp_data))
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "cannot parse passive checks request: %s", zbx_json_strerror());
+		goto out;
+	}
 
-	if (SUCCEED == (ret = zbx_tcp_recv_to(s, config_timeout)))
+	while (NULL != (p = zbx_json_next(&jp_data, p)))
 	{
-		zbx_rtrim(s->buffer, "\r\n");
+		zbx_json_addobject(&j, NULL);
 
-		zabbix_log(LOG_LEVEL_DEBUG, "Requested [%s]", s->buffer);
+		if (SUCCEED != zbx_json_brackets_open(p, &jp_row) ||
+				SUCCEED != zbx_json_value_by_name_dyn(&jp_row, ZBX_PROTO_TAG_KEY, &key, &key_alloc,
+				NULL))
+		{
+			zbx_json_addstring(&j, ZBX_PROTO_TAG_ERROR, "Cannot parse item key.", ZBX_JSON_TYPE_STRING);
+			zbx_json_close(&j);
+			continue;
+		}
+
+		zabbix_log(LOG_LEVEL_DEBUG, "Requested [%s]", key);
 
 		zbx_init_agent_result(&result);
 
-		if (SUCCEED == zbx_execute_agent_check(s->buffer, ZBX_PROCESS_WITH_ALIAS, &result))
+		if (SUCCEED == zbx_execute_agent_check(key, ZBX_PROCESS_WITH_ALIAS, &result) &&
+				NULL != (value = ZBX_GET_TEXT_RESULT(&result)))
 		{
-			if (NULL != (value = ZBX_GET_TEXT_RESULT(&result)))
-			{
-				zabbix_log(LOG_LEVEL_DEBUG, "Sending back [%s]", *value);
-				ret = zbx_tcp_send_to(s, *value, config_timeout);
-			}
+			zabbix_log(LOG_LEVEL_DEBUG, "Sending back [%s]", *value);
+			zbx_json_addstring(&j, ZBX_PROTO_TAG_VALUE, *value, ZBX_JSON_TYPE_STRING);
+		}
+		else if (NULL != (value = ZBX_GET_MSG_RESULT(&result)))
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "Sending back [" ZBX_NOTSUPPORTED ": %s]", *value);
+			zbx_json_addstring(&j, ZBX_PROTO_TAG_ERROR, *value, ZBX_JSON_TYPE_STRING);
 		}
 		else
 		{
-			value = ZBX_GET_MSG_RESULT(&result);
+			zabbix_log(LOG_LEVEL_DEBUG, "Sending back [" ZBX_NOTSUPPORTED "]");
+			zbx_json_addstring(&j, ZBX_PROTO_TAG_ERROR, ZBX_NOTSUPPORTED, ZBX_JSON_TYPE_STRING);
+		}
 
-			if (NULL != value)
-			{
-				static char	*buffer = NULL;
-				static size_t	buffer_alloc = 256;
-				size_t		buffer_offset = 0;
+		zbx_free_agent_result(&result);
+		zbx_json_close(&j);
+	}
+out:
+	ret = zbx_tcp_send_to(s, j.buffer, config_timeout);
 
-				zabbix_log(LOG_LEVEL_DEBUG, "Sending back [" ZBX_NOTSUPPORTED ": %s]", *value);
+	zbx_free(key);
+	zbx_json_free(&j);
 
-				if (NULL == buffer)
-					buffer = (char *)zbx_malloc(buffer, buffer_alloc);
+	return ret;
+}
 
-				zbx_strncpy_alloc(&buffer, &buffer_alloc, &buffer_offset,
-						ZBX_NOTSUPPORTED, ZBX_CONST_STRLEN(ZBX_NOTSUPPORTED));
-				buffer_offset++;
-				zbx_strcpy_alloc(&buffer, &buffer_alloc, &buffer_offset, *value);
+static int	process_request(zbx_socket_t *s, int config_timeout)
+{
+	AGENT_RESULT		result;
+	char			**value = NULL;
+	int			ret = SUCCEED;
+	struct zbx_json_parse	jp;
 
-				ret = zbx_tcp_send_bytes_to(s, buffer, buffer_offset, config_timeout);
-			}
-			else
-			{
-				zabbix_log(LOG_LEVEL_DEBUG, "Sending back [" ZBX_NOTSUPPORTED "]");
+	zbx_rtrim(s->buffer, "\r\n");
 
-				ret = zbx_tcp_send_to(s, ZBX_NOTSUPPORTED, config_timeout);
-			}
+	if (SUCCEED == is_passive_checks_request(s->buffer, &jp))
+		return process_passive_checks(s, &jp, config_timeout);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "Requested [%s]", s->buffer);
+
+	zbx_init_agent_result(&result);
+
+	if (SUCCEED == zbx_execute_agent_check(s->buffer, ZBX_PROCESS_WITH_ALIAS, &result))
+	{
+		if (NULL != (value = ZBX_GET_TEXT_RESULT(&result)))
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "Sending back [%s]", *value);
+			ret = zbx_tcp_send_to(s, *value, config_timeout);
 		}
+	}
+	else
+	{
+		value = ZBX_GET_MSG_RESULT(&result);
 
-		zbx_free_agent_result(&result);
+		if (NULL != value)
+		{
+			static char	*buffer = NULL;
+			static size_t	buffer_alloc = 256;
+			size_t		buffer_offset = 0;
+
+			zabbix_log(LOG_LEVEL_DEBUG, "Sending back [" ZBX_NOTSUPPORTED ": %s]", *value);
+
+			if (NULL == buffer)
+				buffer = (char *)zbx_malloc(buffer, buffer_alloc);
+
+			zbx_strncpy_alloc(&buffer, &buffer_alloc, &buffer_offset,
+					ZBX_NOTSUPPORTED, ZBX_CONST_STRLEN(ZBX_NOTSUPPORTED));
+			buffer_offset++;
+			zbx_strcpy_alloc(&buffer, &buffer_alloc, &buffer_offset, *value);
+
+			ret = zbx_tcp_send_bytes_to(s, buffer, buffer_offset, config_timeout);
+		}
+		else
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "Sending back [" ZBX_NOTSUPPORTED "]");
+
+			ret = zbx_tcp_send_to(s, ZBX_NOTSUPPORTED, config_timeout);
+		}
+	}
+
+	zbx_free_agent_result(&result);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: serve requests of the accepted connection                         *
+ *                                                                            *
+ * Comments: Servers may send further requests over the same connection       *
+ *           instead of reconnecting. They are awaited for a short time, so   *
+ *           a listener is not held by idle connection. Peers sending one     *
+ *           request close the connection and the loop ends at once.          *
+ *                                                                            *
+ ******************************************************************************/
+static void	process_listener(zbx_socket_t *s, int config_timeout)
+{
+#define ZBX_LISTENER_KEEPALIVE_TIMEOUT	3
+	int	ret, requests = 0;
+
+	while (SUCCEED == (ret = zbx_tcp_recv_to(s, 0 == requests ? config_timeout : ZBX_LISTENER_KEEPALIVE_TIMEOUT)))
+	{
+		if (0 != requests && 0 == s->read_bytes)
+			break;
+
+		requests++;
+
+		if (SUCCEED != (ret = process_request(s, config_timeout)) || !ZBX_IS_RUNNING())
+			break;
 	}
 
-	if (FAIL == ret)
+	/* waiting for the next request is not an error */
+	if (FAIL == ret && 0 == requests)
 		zabbix_log(LOG_LEVEL_DEBUG, "Process listener error: %s", zbx_socket_strerror());
+#undef ZBX_LISTENER_KEEPALIVE_TIMEOUT
 }
 
 #ifndef _WINDOWS
@@ -132,6 +267,9 @@ ZBX_THREAD_ENTRY(listener_thread, args)
 
 #ifndef _WINDOWS
 	zbx_set_sigusr_handler(zbx_listener_sigusr_handler);
+
+	/* listeners are threads on Windows and the cache is not thread safe */
+	zbx_tcp_allowed_peers_cache_enable();
 #endif
 
 	while (ZBX_IS_RUNNING())
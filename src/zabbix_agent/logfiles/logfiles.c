@@ -1600,16 +1600,16 @@ static void	pick_logfile(const char *directory, const char *filename, int mtime,
 	char		*logfile_candidate;
 	zbx_stat_t	file_buf;
 
+	/* match the name first to avoid stat() of unrelated files in large directories */
+	if (0 != zbx_regexp_match_precompiled(filename, re))
+		return;
+
 	logfile_candidate = zbx_dsprintf(NULL, "%s%s", directory, filename);
 
 	if (0 == zbx_stat(logfile_candidate, &file_buf))
 	{
-		if (S_ISREG(file_buf.st_mode) &&
-				mtime <= file_buf.st_mtime &&
-				0 == zbx_regexp_match_precompiled(filename, re))
-		{
+		if (S_ISREG(file_buf.st_mode) && mtime <= file_buf.st_mtime)
 			add_logfile(logfiles, logfiles_alloc, logfiles_num, logfile_candidate, &file_buf);
-		}
 	}
 	else
 		zabbix_log(LOG_LEVEL_DEBUG, "cannot process entry '%s': %s", logfile_candidate, zbx_strerror(errno));
@@ -1744,15 +1744,85 @@ static int	compile_filename_regexp(const char *filename_regexp, zbx_regexp_t **r
 	return SUCCEED;
 }
 
+#if !defined(_WINDOWS) && !defined(__MINGW32__)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compare position of log files in sorted list                      *
+ *                                                                            *
+ * Return value: <0 - file1 is placed before file2, 0 - same place,           *
+ *               >0 - file1 is placed after file2                             *
+ *                                                                            *
+ * Comments: Log file lists are sorted by ascending mtime and descending name *
+ *           (see add_logfile()).                                             *
+ *                                                                            *
+ ******************************************************************************/
+static int	compare_logfile_order(const struct st_logfile *file1, const struct st_logfile *file2)
+{
+	if (file1->mtime != file2->mtime)
+		return file1->mtime < file2->mtime ? -1 : 1;
+
+	return strcmp(file2->filename, file1->filename);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: copy MD5 sums from the previous check if file did not change      *
+ *                                                                            *
+ * Parameters:                                                                *
+ *     logfile          - [IN/OUT] log file from the new list                 *
+ *     logfiles_old     - [IN] log file list from the previous check          *
+ *     logfiles_num_old - [IN] number of elements in 'logfiles_old'           *
+ *     idx_old          - [IN/OUT] position in the old list, advanced as the  *
+ *                        new list is walked in its sort order                *
+ *                                                                            *
+ * Return value: SUCCEED - MD5 sums were copied                               *
+ *               FAIL    - MD5 sums must be calculated                        *
+ *                                                                            *
+ * Comments: File with the same name, device, inode, size and modification    *
+ *           time as in the previous check is considered unchanged, there is  *
+ *           no need to read its first and last blocks again.                 *
+ *                                                                            *
+ ******************************************************************************/
+static int	reuse_file_details(struct st_logfile *logfile, const struct st_logfile *logfiles_old,
+		int logfiles_num_old, int *idx_old)
+{
+	const struct st_logfile	*old;
+
+	while (*idx_old < logfiles_num_old && 0 > compare_logfile_order(logfiles_old + *idx_old, logfile))
+		(*idx_old)++;
+
+	if (*idx_old == logfiles_num_old)
+		return FAIL;
+
+	old = logfiles_old + *idx_old;
+
+	if (0 != compare_logfile_order(old, logfile) || old->dev != logfile->dev || old->ino_lo != logfile->ino_lo ||
+			old->size != logfile->size || -1 == old->md5_block_size)
+	{
+		return FAIL;
+	}
+
+	logfile->md5_block_size = old->md5_block_size;
+	logfile->last_block_offset = old->last_block_offset;
+	memcpy(logfile->first_block_md5, old->first_block_md5, sizeof(logfile->first_block_md5));
+	memcpy(logfile->last_block_md5, old->last_block_md5, sizeof(logfile->last_block_md5));
+
+	return SUCCEED;
+}
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Purpose: fill-in MD5 sums, device and inode numbers for files in the list  *
  *                                                                            *
  * Parameters:                                                                *
- *     logfiles     - [IN/OUT] list of log files                              *
- *     logfiles_num - [IN] number of elements in 'logfiles'                   *
- *     use_ino      - [IN] how to get file IDs in file_id()                   *
- *     err_msg      - [IN/OUT] error message why operation failed             *
+ *     logfiles         - [IN/OUT] list of log files                          *
+ *     logfiles_num     - [IN] number of elements in 'logfiles'               *
+ *     use_ino          - [IN] how to get file IDs in file_id()               *
+ *     logfiles_old     - [IN] log file list from the previous check whose    *
+ *                        MD5 sums can be reused (optional)                   *
+ *     logfiles_num_old - [IN] number of elements in 'logfiles_old'           *
+ *     err_msg          - [IN/OUT] error message why operation failed         *
  *                                                                            *
  * Return value: SUCCEED or FAIL                                              *
  *                                                                            *
@@ -1762,10 +1832,14 @@ static int	compile_filename_regexp(const char *filename_regexp, zbx_regexp_t **r
 #if defined(_WINDOWS) || defined(__MINGW32__)
 static int	fill_file_details(struct st_logfile *logfiles, int logfiles_num, int use_ino, char **err_msg)
 #else
-static int	fill_file_details(struct st_logfile *logfiles, int logfiles_num, char **err_msg)
+static int	fill_file_details(struct st_logfile *logfiles, int logfiles_num, const struct st_logfile *logfiles_old,
+		int logfiles_num_old, char **err_msg)
 #endif
 {
 	int	i, ret = SUCCEED;
+#if !defined(_WINDOWS) && !defined(__MINGW32__)
+	int	idx_old = 0;
+#endif
 
 	/* Fill in MD5 sums and file indexes in the logfile list. */
 	/* These operations require opening of file, therefore we group them together. */
@@ -1775,6 +1849,13 @@ static int	fill_file_details(struct st_logfile *logfiles, int logfiles_num, char
 		int			f;
 		struct st_logfile	*p = logfiles + i;
 
+#if !defined(_WINDOWS) && !defined(__MINGW32__)
+		if (NULL != logfiles_old && SUCCEED == reuse_file_details(p, logfiles_old, logfiles_num_old,
+				&idx_old))
+		{
+			continue;
+		}
+#endif
 		if (-1 == (f = open_file_helper(p->filename, err_msg)))
 			return FAIL;
 
@@ -1824,6 +1905,8 @@ clean:
  *     logfiles_alloc - [IN/OUT] number of logfiles memory was allocated for  *
  *     logfiles_num   - [IN/OUT] number of already inserted logfiles          *
  *     use_ino        - [IN/OUT] how to use inode numbers                     *
+ *     logfiles_old   - [IN] log file list from the previous check            *
+ *     logfiles_num_old - [IN] number of elements in 'logfiles_old'           *
  *     err_msg        - [IN/OUT] error message (if FAIL or ZBX_NO_FILE_ERROR  *
  *                      is returned)                                          *
  *                                                                            *
@@ -1835,7 +1918,8 @@ clean:
  *                                                                            *
  ******************************************************************************/
 static int	make_logfile_list(unsigned char flags, const char *filename, int mtime,
-		struct st_logfile **logfiles, int *logfiles_alloc, int *logfiles_num, int *use_ino, char **err_msg)
+		struct st_logfile **logfiles, int *logfiles_alloc, int *logfiles_num, int *use_ino,
+		const struct st_logfile *logfiles_old, int logfiles_num_old, char **err_msg)
 {
 	int	ret = SUCCEED;
 
@@ -1861,6 +1945,9 @@ static int	make_logfile_list(unsigned char flags, const char *filename, int mtim
 		/* mtime is not used for log, log.count items, reset to ignore */
 		file_buf.st_mtime = 0;
 
+		/* without mtime a rewritten file of the same size could not be told apart */
+		logfiles_old = NULL;
+
 		add_logfile(logfiles, logfiles_alloc, logfiles_num, filename, &file_buf);
 #if defined(_WINDOWS) || defined(__MINGW32__)
 		if (SUCCEED != (ret = set_use_ino_by_fs_type(filename, use_ino, err_msg)))
@@ -1931,9 +2018,12 @@ clean1:
 	}
 
 #if defined(_WINDOWS) || defined(__MINGW32__)
+	ZBX_UNUSED(logfiles_old);
+	ZBX_UNUSED(logfiles_num_old);
+
 	ret = fill_file_details(*logfiles, *logfiles_num, *use_ino, err_msg);
 #else
-	ret = fill_file_details(*logfiles, *logfiles_num, err_msg);
+	ret = fill_file_details(*logfiles, *logfiles_num, logfiles_old, logfiles_num_old, err_msg);
 #endif
 clean:
 	if ((FAIL == ret || ZBX_NO_FILE_ERROR == ret) && NULL != *logfiles)
@@ -1942,6 +2032,78 @@ clean:
 	return	ret;
 }
 
+#define ZBX_WORD_ONES	__UINT64_C(0x0101010101010101)
+#define ZBX_WORD_HIGHS	__UINT64_C(0x8080808080808080)
+
+/* nonzero if any byte of word is zero */
+#define ZBX_WORD_HAS_ZERO(w)	(((w) - ZBX_WORD_ONES) & ~(w) & ZBX_WORD_HIGHS)
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: skip single-byte characters which need no attention of newline    *
+ *          search (anything except NUL, LF and CR)                           *
+ *                                                                            *
+ * Parameters: p     - [IN] start of data                                     *
+ *             p_end - [IN] end of data                                       *
+ *                                                                            *
+ * Return value: position of the first 8-byte word with NUL, LF or CR or      *
+ *               position within the last 8 bytes of data                     *
+ *                                                                            *
+ * Comments: Data are examined one word at a time, so long lines are scanned  *
+ *           several times faster than byte by byte.                          *
+ *                                                                            *
+ ******************************************************************************/
+static char	*buf_skip_plain_bytes(char *p, const char *p_end)
+{
+	zbx_uint64_t	word;
+
+	while (p_end - p >= (ptrdiff_t)sizeof(word))
+	{
+		memcpy(&word, p, sizeof(word));
+
+		if (0 != (ZBX_WORD_HAS_ZERO(word) | ZBX_WORD_HAS_ZERO(word ^ (ZBX_WORD_ONES * 0xa)) |
+				ZBX_WORD_HAS_ZERO(word ^ (ZBX_WORD_ONES * 0xd))))
+		{
+			break;
+		}
+
+		p += sizeof(word);
+	}
+
+	return p;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: check if record consists of 7-bit ASCII characters only           *
+ *                                                                            *
+ ******************************************************************************/
+static int	buf_is_ascii(const char *p, size_t len)
+{
+	const char	*p_end = p + len;
+	zbx_uint64_t	word;
+
+	for (; p_end - p >= (ptrdiff_t)sizeof(word); p += sizeof(word))
+	{
+		memcpy(&word, p, sizeof(word));
+
+		if (0 != (word & ZBX_WORD_HIGHS))
+			return FAIL;
+	}
+
+	for (; p < p_end; p++)
+	{
+		if (0 != (*p & 0x80))
+			return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+#undef ZBX_WORD_HAS_ZERO
+#undef ZBX_WORD_HIGHS
+#undef ZBX_WORD_ONES
+
 static char	*buf_find_newline(char *p, char **p_next, const char *p_end, const char *cr, const char *lf,
 		size_t szbyte)
 {
@@ -1949,6 +2111,9 @@ static char	*buf_find_newline(char *p, char **p_next, const char *p_end, const c
 	{
 		for (; p < p_end; p++)
 		{
+			if (p_end == (p = buf_skip_plain_bytes(p, p_end)))
+				break;
+
 			/* detect NULL byte and replace it with '?' character */
 			if (0x0 == *p)
 			{
@@ -2017,11 +2182,58 @@ static char	*buf_find_newline(char *p, char **p_next, const char *p_end, const c
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get log record value in UTF-8                                     *
+ *                                                                            *
+ * Parameters: rec      - [IN] NUL terminated record                          *
+ *             rec_len  - [IN] record length in bytes                         *
+ *             encoding - [IN] record encoding, empty string if unknown       *
+ *             is_utf8  - [IN] 1 - records are expected in UTF-8              *
+ *                                                                            *
+ * Return value: the record itself if it needs no conversion or a converted   *
+ *               copy that must be freed by caller                            *
+ *                                                                            *
+ * Comments: Valid UTF-8 records without byte order mark are matched in place *
+ *           instead of converting them into identical copy.                  *
+ *                                                                            *
+ ******************************************************************************/
+static char	*log_rec_to_utf8(char *rec, size_t rec_len, const char *encoding, int is_utf8)
+{
+	if ('\0' == *encoding)
+		return rec;
+
+	if (0 != is_utf8 && (SUCCEED == buf_is_ascii(rec, rec_len) || (0 != strncmp(rec, "\xef\xbb\xbf", 3) &&
+			SUCCEED == zbx_is_utf8(rec))))
+	{
+		return rec;
+	}
+
+	return zbx_convert_to_utf8(rec, rec_len, encoding);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: match log record against item pattern                             *
+ *                                                                            *
+ * Parameters: regexps         - [IN] global regular expressions              *
+ *             value           - [IN] log record                              *
+ *             pattern         - [IN] item pattern                            *
+ *             literal         - [IN] substring required by pattern, optional *
+ *             output_template - [IN] output template (optional)              *
+ *             output          - [OUT] output value (optional)                *
+ *             err_msg         - [OUT] error message                          *
+ *                                                                            *
+ ******************************************************************************/
 static int	zbx_match_log_rec(const zbx_vector_expression_t *regexps, const char *value, const char *pattern,
-		const char *output_template, char **output, char **err_msg)
+		const char *literal, const char *output_template, char **output, char **err_msg)
 {
 	int	ret;
 
+	/* records without required literal cannot match, skip regular expression engine for them */
+	if (NULL != literal && NULL == strstr(value, literal))
+		return ZBX_REGEXP_NO_MATCH;
+
 	if (FAIL == (ret = zbx_regexp_sub_ex(regexps, value, pattern, ZBX_CASE_SENSITIVE, output_template, output)))
 		*err_msg = zbx_dsprintf(*err_msg, "cannot compile regular expression");
 
@@ -2045,10 +2257,12 @@ static int	zbx_read2(int fd, unsigned char flags, struct st_logfile *logfile, zb
 
 	int				ret, nbytes, regexp_ret;
 	const char			*cr, *lf, *p_end;
-	char				*p_start, *p, *p_nl, *p_next, *item_value = NULL;
+	char				*p_start, *p, *p_nl, *p_next, *item_value = NULL, *literal = NULL;
 	size_t				szbyte;
 	zbx_offset_t			offset;
 	const int			is_count_item = (0 != (ZBX_METRIC_FLAG_LOG_COUNT & flags)) ? 1 : 0;
+	const int			is_utf8 = (0 == strcasecmp(encoding, "UTF-8") ||
+							0 == strcasecmp(encoding, "UTF8")) ? 1 : 0;
 #if !defined(_WINDOWS) && !defined(__MINGW32__)
 	int				prep_vec_idx = -1;	/* index in 'prep_vec' vector */
 #endif
@@ -2062,6 +2276,10 @@ static int	zbx_read2(int fd, unsigned char flags, struct st_logfile *logfile, zb
 
 	zbx_find_cr_lf_szbyte(encoding, &cr, &lf, &szbyte);
 
+	/* global regular expressions are not prefiltered */
+	if (NULL != pattern && '@' != *pattern)
+		literal = zbx_regexp_get_literal(pattern);
+
 	for (;;)
 	{
 		if (0 >= *p_count || 0 >= *s_count)
@@ -2129,10 +2347,7 @@ static int	zbx_read2(int fd, unsigned char flags, struct st_logfile *logfile, zb
 
 					buf[BUF_SIZE] = '\0';
 
-					if ('\0' != *encoding)
-						value = zbx_convert_to_utf8(buf, (size_t)BUF_SIZE, encoding);
-					else
-						value = buf;
+					value = log_rec_to_utf8(buf, (size_t)BUF_SIZE, encoding, is_utf8);
 
 					zabbix_log(LOG_LEVEL_WARNING, "Logfile contains a large record: \"%.64s\""
 							" (showing only the first 64 characters). Only the first 256 kB"
@@ -2142,7 +2357,7 @@ static int	zbx_read2(int fd, unsigned char flags, struct st_logfile *logfile, zb
 					processed_size = (size_t)offset + (size_t)nbytes;
 					send_err = FAIL;
 
-					regexp_ret = zbx_match_log_rec(regexps, value, pattern,
+					regexp_ret = zbx_match_log_rec(regexps, value, pattern, literal,
 							(0 == is_count_item) ? output_template : NULL,
 							(0 == is_count_item) ? &item_value : NULL, err_msg);
 #if !defined(_WINDOWS) && !defined(__MINGW32__)
@@ -2191,7 +2406,7 @@ static int	zbx_read2(int fd, unsigned char flags, struct st_logfile *logfile, zb
 							{
 								zbx_free(item_value);
 
-								if ('\0' != *encoding)
+								if (buf != value)
 									zbx_free(value);
 
 								/* Sending of buffer failed. */
@@ -2204,7 +2419,7 @@ static int	zbx_read2(int fd, unsigned char flags, struct st_logfile *logfile, zb
 							(*s_count)--;
 					}
 
-					if ('\0' != *encoding)
+					if (buf != value)
 						zbx_free(value);
 
 					if (FAIL == regexp_ret)
@@ -2252,15 +2467,12 @@ static int	zbx_read2(int fd, unsigned char flags, struct st_logfile *logfile, zb
 
 					*p_nl = '\0';
 
-					if ('\0' != *encoding)
-						value = zbx_convert_to_utf8(p_start, (size_t)(p_nl - p_start), encoding);
-					else
-						value = p_start;
+					value = log_rec_to_utf8(p_start, (size_t)(p_nl - p_start), encoding, is_utf8);
 
 					processed_size = (size_t)offset + (size_t)(p_next - buf);
 					send_err = FAIL;
 
-					regexp_ret = zbx_match_log_rec(regexps, value, pattern,
+					regexp_ret = zbx_match_log_rec(regexps, value, pattern, literal,
 							(0 == is_count_item) ? output_template : NULL,
 							(0 == is_count_item) ? &item_value : NULL, err_msg);
 #if !defined(_WINDOWS) && !defined(__MINGW32__)
@@ -2306,7 +2518,7 @@ static int	zbx_read2(int fd, unsigned char flags, struct st_logfile *logfile, zb
 							{
 								zbx_free(item_value);
 
-								if ('\0' != *encoding)
+								if (p_start != value)
 									zbx_free(value);
 
 								/* Sending of buffer failed. */
@@ -2319,7 +2531,7 @@ static int	zbx_read2(int fd, unsigned char flags, struct st_logfile *logfile, zb
 							(*s_count)--;
 					}
 
-					if ('\0' != *encoding)
+					if (p_start != value)
 						zbx_free(value);
 
 					if (FAIL == regexp_ret)
@@ -2370,6 +2582,8 @@ static int	zbx_read2(int fd, unsigned char flags, struct st_logfile *logfile, zb
 		}
 	}
 out:
+	zbx_free(literal);
+
 	return ret;
 
 #undef BUF_SIZE
@@ -3318,7 +3532,7 @@ static int	process_logrt(unsigned char flags, const char *filename, zbx_uint64_t
 	adjust_mtime_to_clock(mtime);
 
 	if (SUCCEED != (res = make_logfile_list(flags, filename, *mtime, &logfiles, &logfiles_alloc, &logfiles_num,
-			use_ino, err_msg)))
+			use_ino, *logfiles_old, logfiles_num_old, err_msg)))
 	{
 		if (ZBX_NO_FILE_ERROR == res)
 		{
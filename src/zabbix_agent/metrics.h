@@ -40,6 +40,7 @@
 
 typedef struct
 {
+	zbx_uint64_t		itemid;	/* 0 if not provided by server (older than 4.4) */
 	char			*key;
 	char			*key_orig;
 	zbx_uint64_t		lastlogsize;
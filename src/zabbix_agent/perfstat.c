@@ -24,19 +24,43 @@
 #include "zbxmutexs.h"
 #include "zbxsysinfo.h"
 #include "zbxstr.h"
+#include "zbxalgo.h"
 
 #define OBJECT_CACHE_REFRESH_INTERVAL	60
 #define NAMES_UPDATE_INTERVAL		60
 
+/* the maximum number of validated counter paths to keep, the cache is reset when it is full */
+#define COUNTER_PATH_CACHE_MAX		10000
+
 struct object_name_ref
 {
 	char		*eng_name;
 	wchar_t		*loc_name;
 };
 
+/* performance counter index entry, references the most recently added counter with the path and language */
+typedef struct
+{
+	const char		*counterpath;
+	zbx_perf_counter_lang_t	lang;
+	zbx_perf_counter_data_t	*counter;
+}
+zbx_perf_counter_ref_t;
+
+/* validated counter path cache entry */
+typedef struct
+{
+	char	*counterpath;
+	char	*resolved;
+	int	convert_from_numeric;
+}
+zbx_counter_path_t;
+
 typedef struct
 {
 	zbx_perf_counter_data_t	*pPerfCounterList;
+	zbx_hashset_t		counters;		/* counter index by path and language */
+	zbx_hashset_t		paths;			/* validated counter paths */
 	PDH_HQUERY		pdh_query;
 	time_t			lastrefresh_objects;	/* last refresh time of object cache */
 	time_t			lastupdate_names;	/* last update time of object names */
@@ -57,6 +81,106 @@ static int	perf_collector_started(void)
 	return (NULL != ppsd.pdh_query ? SUCCEED : FAIL);
 }
 
+static zbx_hash_t	perf_counter_ref_hash(const void *data)
+{
+	const zbx_perf_counter_ref_t	*ref = (const zbx_perf_counter_ref_t *)data;
+	zbx_hash_t			hash;
+
+	hash = ZBX_DEFAULT_STRING_HASH_FUNC(ref->counterpath);
+
+	return ZBX_DEFAULT_HASH_ALGO(&ref->lang, sizeof(ref->lang), hash);
+}
+
+static int	perf_counter_ref_compare(const void *d1, const void *d2)
+{
+	const zbx_perf_counter_ref_t	*ref1 = (const zbx_perf_counter_ref_t *)d1;
+	const zbx_perf_counter_ref_t	*ref2 = (const zbx_perf_counter_ref_t *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(ref1->lang, ref2->lang);
+
+	return strcmp(ref1->counterpath, ref2->counterpath);
+}
+
+static zbx_hash_t	counter_path_hash(const void *data)
+{
+	const zbx_counter_path_t	*path = (const zbx_counter_path_t *)data;
+	zbx_hash_t			hash;
+
+	hash = ZBX_DEFAULT_STRING_HASH_FUNC(path->counterpath);
+
+	return ZBX_DEFAULT_HASH_ALGO(&path->convert_from_numeric, sizeof(path->convert_from_numeric), hash);
+}
+
+static int	counter_path_compare(const void *d1, const void *d2)
+{
+	const zbx_counter_path_t	*path1 = (const zbx_counter_path_t *)d1;
+	const zbx_counter_path_t	*path2 = (const zbx_counter_path_t *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(path1->convert_from_numeric, path2->convert_from_numeric);
+
+	return strcmp(path1->counterpath, path2->counterpath);
+}
+
+static void	counter_path_clean(void *data)
+{
+	zbx_counter_path_t	*path = (zbx_counter_path_t *)data;
+
+	zbx_free(path->counterpath);
+	zbx_free(path->resolved);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: find the most recently added counter with the specified path and  *
+ *          language                                                          *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_perf_counter_data_t	*find_perf_counter(const char *counterpath, zbx_perf_counter_lang_t lang)
+{
+	zbx_perf_counter_ref_t	*ref, ref_local;
+
+	ref_local.counterpath = counterpath;
+	ref_local.lang = lang;
+
+	if (NULL == (ref = (zbx_perf_counter_ref_t *)zbx_hashset_search(&ppsd.counters, &ref_local)))
+		return NULL;
+
+	return ref->counter;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: update counter index after counter was removed from counter list  *
+ *                                                                            *
+ ******************************************************************************/
+static void	unindex_perf_counter(const zbx_perf_counter_data_t *counter)
+{
+	zbx_perf_counter_ref_t	*ref, ref_local;
+	zbx_perf_counter_data_t	*cptr;
+
+	ref_local.counterpath = counter->counterpath;
+	ref_local.lang = counter->lang;
+
+	if (NULL == (ref = (zbx_perf_counter_ref_t *)zbx_hashset_search(&ppsd.counters, &ref_local)) ||
+			ref->counter != counter)
+	{
+		return;
+	}
+
+	/* the list is ordered from the most recently added counters */
+	for (cptr = ppsd.pPerfCounterList; NULL != cptr; cptr = cptr->next)
+	{
+		if (cptr->lang == counter->lang && 0 == strcmp(cptr->counterpath, counter->counterpath))
+		{
+			ref->counter = cptr;
+			ref->counterpath = cptr->counterpath;
+			return;
+		}
+	}
+
+	zbx_hashset_remove_direct(&ppsd.counters, ref);
+}
+
 /******************************************************************************
  *                                                                            *
  * Comments: counter failed or disappeared, dismiss all previous values       *
@@ -83,6 +207,7 @@ zbx_perf_counter_data_t	*add_perf_counter(const char *name, const char *counterp
 		zbx_perf_counter_lang_t lang, char **error)
 {
 	zbx_perf_counter_data_t	*cptr = NULL;
+	zbx_perf_counter_ref_t	*ref, ref_local;
 	PDH_STATUS		pdh_status;
 	int			added = FAIL;
 
@@ -120,6 +245,18 @@ zbx_perf_counter_data_t	*add_perf_counter(const char *name, const char *counterp
 			cptr->next = ppsd.pPerfCounterList;
 			ppsd.pPerfCounterList = cptr;
 
+			ref_local.counterpath = cptr->counterpath;
+			ref_local.lang = cptr->lang;
+
+			if (NULL == (ref = (zbx_perf_counter_ref_t *)zbx_hashset_search(&ppsd.counters, &ref_local)))
+			{
+				ref = (zbx_perf_counter_ref_t *)zbx_hashset_insert(&ppsd.counters, &ref_local,
+						sizeof(ref_local));
+			}
+
+			ref->counterpath = cptr->counterpath;
+			ref->counter = cptr;
+
 			if (ERROR_SUCCESS != pdh_status && PDH_CSTATUS_NO_INSTANCE != pdh_status)
 			{
 				*error = zbx_dsprintf(*error, "Invalid performance counter format.");
@@ -365,6 +502,8 @@ void	remove_perf_counter(zbx_perf_counter_data_t *counter)
 		}
 	}
 
+	unindex_perf_counter(counter);
+
 	PdhRemoveCounter(counter->handle);
 	zbx_free(counter->name);
 	zbx_free(counter->counterpath);
@@ -379,6 +518,8 @@ static void	free_perf_counter_list(void)
 {
 	zbx_perf_counter_data_t	*cptr;
 
+	zbx_hashset_clear(&ppsd.counters);
+
 	while (NULL != ppsd.pPerfCounterList)
 	{
 		cptr = ppsd.pPerfCounterList;
@@ -445,6 +586,10 @@ int	init_perf_collector(zbx_threadedness_t threadedness, char **error)
 		goto out;
 	}
 
+	zbx_hashset_create(&ppsd.counters, 100, perf_counter_ref_hash, perf_counter_ref_compare);
+	zbx_hashset_create_ext(&ppsd.paths, 100, counter_path_hash, counter_path_compare, counter_path_clean,
+			ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
+
 	ppsd.lastrefresh_objects = 0;
 	ppsd.lastupdate_names = 0;
 
@@ -488,6 +633,9 @@ void	free_perf_collector(void)
 	free_perf_counter_list();
 	free_object_names();
 
+	zbx_hashset_destroy(&ppsd.counters);
+	zbx_hashset_destroy(&ppsd.paths);
+
 	UNLOCK_PERFCOUNTERS;
 
 	zbx_mutex_destroy(&perfstat_access);
@@ -730,16 +878,13 @@ int	get_perf_counter_value_by_path(const char *counterpath, int interval, zbx_pe
 		goto out;
 	}
 
-	for (perfs = ppsd.pPerfCounterList; NULL != perfs; perfs = perfs->next)
+	if (NULL != (perfs = find_perf_counter(counterpath, lang)))
 	{
-		if (0 == strcmp(perfs->counterpath, counterpath) && perfs->lang == lang)
-		{
-			if (perfs->interval < interval)
-				extend_perf_counter_interval(perfs, interval);
-
-			if (PERF_COUNTER_ACTIVE != perfs->status)
-				break;
+		if (perfs->interval < interval)
+			extend_perf_counter_interval(perfs, interval);
 
+		if (PERF_COUNTER_ACTIVE == perfs->status)
+		{
 			/* the counter data is already being collected, return it */
 			*value = compute_average_value(perfs, interval);
 			ret = SUCCEED;
@@ -808,6 +953,66 @@ out:
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: validate performance counter path and convert numeric object and  *
+ *          counter names, using previously validated paths when possible     *
+ *                                                                            *
+ * Parameters: counterpath          - [IN/OUT] the counter path, must have    *
+ *                                             PDH_MAX_COUNTER_PATH size      *
+ *             convert_from_numeric - [IN] 1 - convert numeric object and     *
+ *                                             counter indexes to names       *
+ *                                                                            *
+ * Return value: SUCCEED - the counter path is valid                          *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Only valid paths are cached, so the counters which become        *
+ *           available later are not affected.                                *
+ *                                                                            *
+ ******************************************************************************/
+int	check_counter_path_cached(char *counterpath, int convert_from_numeric)
+{
+	zbx_counter_path_t	*path, path_local;
+	char			*counterpath_orig;
+	int			ret;
+
+	LOCK_PERFCOUNTERS;
+
+	if (SUCCEED == perf_collector_started())
+	{
+		path_local.counterpath = counterpath;
+		path_local.convert_from_numeric = convert_from_numeric;
+
+		if (NULL != (path = (zbx_counter_path_t *)zbx_hashset_search(&ppsd.paths, &path_local)))
+		{
+			zbx_strlcpy(counterpath, path->resolved, PDH_MAX_COUNTER_PATH);
+			UNLOCK_PERFCOUNTERS;
+
+			return SUCCEED;
+		}
+	}
+
+	counterpath_orig = zbx_strdup(NULL, counterpath);
+
+	if (SUCCEED == (ret = zbx_check_counter_path(counterpath, convert_from_numeric)) &&
+			SUCCEED == perf_collector_started())
+	{
+		if (COUNTER_PATH_CACHE_MAX <= ppsd.paths.num_data)
+			zbx_hashset_clear(&ppsd.paths);
+
+		path_local.counterpath = counterpath_orig;
+		path_local.resolved = zbx_strdup(NULL, counterpath);
+		path_local.convert_from_numeric = convert_from_numeric;
+		zbx_hashset_insert(&ppsd.paths, &path_local, sizeof(path_local));
+	}
+	else
+		zbx_free(counterpath_orig);
+
+	UNLOCK_PERFCOUNTERS;
+
+	return ret;
+}
+
 int	refresh_object_cache(void)
 {
 	DWORD	sz = 0;
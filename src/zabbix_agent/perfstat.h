@@ -45,6 +45,7 @@ int	get_perf_counter_value_by_name(const char *name, double *value, char **error
 int	get_perf_counter_value_by_path(const char *counterpath, int interval, zbx_perf_counter_lang_t lang,
 		double *value, char **error);
 int	get_perf_counter_value(zbx_perf_counter_data_t *counter, int interval, double *value, char **error);
+int	check_counter_path_cached(char *counterpath, int convert_from_numeric);
 int	refresh_object_cache(void);
 wchar_t	*get_object_name_local(char *eng_name);
 
@@ -52,6 +52,11 @@ int	CONFIG_LOG_LEVEL		= LOG_LEVEL_WARNING;
 
 int	CONFIG_BUFFER_SIZE		= 100;
 int	CONFIG_BUFFER_SEND		= 5;
+int	CONFIG_PERSISTENT_ACTIVE_CONNECTION	= 0;
+#ifndef _WINDOWS
+char	*CONFIG_BUFFER_SPILL_FILE	= NULL;
+int	CONFIG_BUFFER_SPILL_SIZE	= 64;
+#endif
 
 int	CONFIG_MAX_LINES_PER_SECOND		= 20;
 int	CONFIG_EVENTLOG_MAX_LINES_PER_SECOND	= 20;
@@ -861,6 +866,14 @@ static void	zbx_load_config(int requirement, ZBX_TASK_EX *task)
 			PARM_OPT,	2,			65535},
 		{"BufferSend",			&CONFIG_BUFFER_SEND,			TYPE_INT,
 			PARM_OPT,	1,			SEC_PER_HOUR},
+		{"PersistentActiveConnection",	&CONFIG_PERSISTENT_ACTIVE_CONNECTION,	TYPE_INT,
+			PARM_OPT,	0,			1},
+#ifndef _WINDOWS
+		{"BufferSpillFile",		&CONFIG_BUFFER_SPILL_FILE,		TYPE_STRING,
+			PARM_OPT,	0,			0},
+		{"BufferSpillSize",		&CONFIG_BUFFER_SPILL_SIZE,		TYPE_INT,
+			PARM_OPT,	1,			1024},
+#endif
 #ifndef _WINDOWS
 		{"PidFile",			&CONFIG_PID_FILE,			TYPE_STRING,
 			PARM_OPT,	0,			0},
@@ -22,6 +22,8 @@
 #include "zbxcomms.h"
 #include "zbxgetopt.h"
 #include "zbxcrypto.h"
+#include "zbxalgo.h"
+#include "zbxtime.h"
 
 #ifndef _WINDOWS
 #	include "zbxnix.h"
@@ -31,7 +33,10 @@ const char	*progname = NULL;
 const char	title_message[] = "zabbix_get";
 const char	syslog_app_name[] = "zabbix_get";
 const char	*usage_message[] = {
-	"-s host-name-or-IP", "[-p port-number]", "[-I IP-address]", "[-t timeout]", "-k item-key", NULL,
+	"-s host-name-or-IP", "[-p port-number]", "[-I IP-address]", "[-t timeout]", "[-r repeat-count]",
+	"-k item-key", NULL,
+	"-s host-name-or-IP", "[-p port-number]", "[-I IP-address]", "[-t timeout]", "[-r repeat-count]",
+	"-i input-file", NULL,
 #if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
 	"-s host-name-or-IP", "[-p port-number]", "[-I IP-address]", "[-t timeout]", "--tls-connect cert",
 	"--tls-ca-file CA-file", "[--tls-crl-file CRL-file]", "[--tls-agent-cert-issuer cert-issuer]",
@@ -70,6 +75,11 @@ static unsigned char	get_program_type(void)
 #define CONFIG_GET_TIMEOUT_MIN_STR	ZBX_STR(CONFIG_GET_TIMEOUT_MIN)
 #define CONFIG_GET_TIMEOUT_MAX_STR	ZBX_STR(CONFIG_GET_TIMEOUT_MAX)
 
+#define CONFIG_GET_REPEAT_MIN		1
+#define CONFIG_GET_REPEAT_MAX		100000
+#define CONFIG_GET_REPEAT_MIN_STR	ZBX_STR(CONFIG_GET_REPEAT_MIN)
+#define CONFIG_GET_REPEAT_MAX_STR	ZBX_STR(CONFIG_GET_REPEAT_MAX)
+
 static int	CONFIG_GET_TIMEOUT = CONFIG_GET_TIMEOUT_MAX;
 
 const char	*help_message[] = {
@@ -85,7 +95,18 @@ const char	*help_message[] = {
 			CONFIG_GET_TIMEOUT_MAX_STR " seconds",
 	"                             (default: " CONFIG_GET_TIMEOUT_MAX_STR " seconds)",
 	"",
-	"  -k --key item-key          Specify key of the item to retrieve value for",
+	"  -k --key item-key          Specify key of the item to retrieve value for.",
+	"                             Can be specified multiple times, then each value",
+	"                             is prefixed with its key",
+	"",
+	"  -i --input-file input-file Load item keys from input file, one key per line.",
+	"                             Specify - for standard input",
+	"",
+	"  -r --repeat repeat-count   Request each key the specified number of times and",
+	"                             print response time statistics of each key.",
+	"                             Values are printed only for the first request.",
+	"                             Valid range: " CONFIG_GET_REPEAT_MIN_STR "-" CONFIG_GET_REPEAT_MAX_STR,
+	"                             (default: " CONFIG_GET_REPEAT_MIN_STR ")",
 	"",
 	"  -h --help                  Display this help message",
 	"  -V --version               Display version number",
@@ -141,6 +162,8 @@ const char	*help_message[] = {
 	"",
 	"Example(s):",
 	"  zabbix_get -s 127.0.0.1 -p " ZBX_DEFAULT_AGENT_PORT_STR " -k \"system.cpu.load[all,avg1]\"",
+	"",
+	"  zabbix_get -s 127.0.0.1 -k \"system.cpu.load[all,avg1]\" -k \"vfs.fs.size[/,free]\" -r 100",
 #if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
 	"",
 	"  zabbix_get -s 127.0.0.1 -p " ZBX_DEFAULT_AGENT_PORT_STR " -k \"system.cpu.load[all,avg1]\" \\",
@@ -173,6 +196,8 @@ struct zbx_option	longopts[] =
 	{"key",				1,	NULL,	'k'},
 	{"source-address",		1,	NULL,	'I'},
 	{"timeout",			1,	NULL,	't'},
+	{"input-file",			1,	NULL,	'i'},
+	{"repeat",			1,	NULL,	'r'},
 	{"help",			0,	NULL,	'h'},
 	{"version",			0,	NULL,	'V'},
 	{"tls-connect",			1,	NULL,	'1'},
@@ -190,7 +215,7 @@ struct zbx_option	longopts[] =
 };
 
 /* short options */
-static char	shortopts[] = "s:p:k:I:t:hV";
+static char	shortopts[] = "s:p:k:I:t:i:r:hV";
 
 /* end of COMMAND LINE OPTIONS */
 
@@ -220,16 +245,46 @@ static void	get_signal_handler(int sig)
 
 #endif /* not WINDOWS */
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: print value received from Zabbix agent                            *
+ *                                                                            *
+ * Parameters: buffer     - [IN/OUT] received data                            *
+ *             read_bytes - [IN] number of received bytes                     *
+ *             prefix     - [IN] value prefix (optional)                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	print_value(char *buffer, size_t read_bytes, const char *prefix)
+{
+	if (NULL != prefix)
+		printf("%s: ", prefix);
+
+	if (0 == strcmp(buffer, ZBX_NOTSUPPORTED) && sizeof(ZBX_NOTSUPPORTED) < read_bytes)
+	{
+		zbx_rtrim(buffer + sizeof(ZBX_NOTSUPPORTED), "\r\n");
+		printf("%s: %s\n", buffer, buffer + sizeof(ZBX_NOTSUPPORTED));
+	}
+	else
+	{
+		zbx_rtrim(buffer, "\r\n");
+		printf("%s\n", buffer);
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: connect to Zabbix agent, receive and print value                  *
  *                                                                            *
- * Parameters: host - server name or IP address                               *
- *             port - port number                                             *
- *             key  - item's key                                              *
+ * Parameters: source_ip - source IP address                                  *
+ *             host      - server name or IP address                          *
+ *             port      - port number                                        *
+ *             key       - item's key                                         *
+ *             prefix    - [IN] value prefix (optional)                       *
+ *             print     - [IN] 1 - print the received value, 0 - otherwise   *
  *                                                                            *
  ******************************************************************************/
-static int	get_value(const char *source_ip, const char *host, unsigned short port, const char *key)
+static int	get_value(const char *source_ip, const char *host, unsigned short port, const char *key,
+		const char *prefix, int print)
 {
 	zbx_socket_t	s;
 	int		ret;
@@ -264,16 +319,8 @@ static int	get_value(const char *source_ip, const char *host, unsigned short por
 		{
 			if (0 < (bytes_received = zbx_tcp_recv_ext(&s, 0, 0)))
 			{
-				if (0 == strcmp(s.buffer, ZBX_NOTSUPPORTED) && sizeof(ZBX_NOTSUPPORTED) < s.read_bytes)
-				{
-					zbx_rtrim(s.buffer + sizeof(ZBX_NOTSUPPORTED), "\r\n");
-					printf("%s: %s\n", s.buffer, s.buffer + sizeof(ZBX_NOTSUPPORTED));
-				}
-				else
-				{
-					zbx_rtrim(s.buffer, "\r\n");
-					printf("%s\n", s.buffer);
-				}
+				if (0 != print)
+					print_value(s.buffer, s.read_bytes, prefix);
 			}
 			else
 			{
@@ -297,19 +344,193 @@ static int	get_value(const char *source_ip, const char *host, unsigned short por
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: read item keys from file, one key per line                        *
+ *                                                                            *
+ * Parameters: path - [IN] input file path, "-" for standard input            *
+ *             keys - [OUT] loaded keys                                       *
+ *                                                                            *
+ * Return value: SUCCEED - keys were loaded successfully                      *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: empty lines are skipped                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	load_keys(const char *path, zbx_vector_str_t *keys)
+{
+	FILE	*in;
+	char	line[MAX_BUFFER_LEN];
+	int	line_num = 0, ret = SUCCEED;
+
+	if (0 == strcmp(path, "-"))
+	{
+		in = stdin;
+	}
+	else if (NULL == (in = fopen(path, "r")))
+	{
+		zbx_error("cannot open \"%s\": %s", path, zbx_strerror(errno));
+		return FAIL;
+	}
+
+	while (NULL != fgets(line, sizeof(line), in))
+	{
+		line_num++;
+
+		if (NULL == strchr(line, '\n') && 0 == feof(in))
+		{
+			zbx_error("[line %d] key is too long", line_num);
+			ret = FAIL;
+			break;
+		}
+
+		zbx_rtrim(line, "\r\n");
+
+		if ('\0' != *line)
+			zbx_vector_str_append(keys, zbx_strdup(NULL, line));
+	}
+
+	if (SUCCEED == ret && 0 != ferror(in))
+	{
+		zbx_error("cannot read \"%s\": %s", path, zbx_strerror(errno));
+		ret = FAIL;
+	}
+
+	if (stdin != in)
+		fclose(in);
+
+	if (SUCCEED == ret && 0 == keys->values_num)
+	{
+		zbx_error("no item keys found in \"%s\"", path);
+		ret = FAIL;
+	}
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get value of nearest rank percentile from sorted values           *
+ *                                                                            *
+ ******************************************************************************/
+static double	get_percentile(const zbx_vector_dbl_t *values, int percent)
+{
+	int	index;
+
+	if (0 > (index = (values->values_num * percent + 99) / 100 - 1))
+		index = 0;
+
+	return values->values[index];
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: print response time statistics of a key                           *
+ *                                                                            *
+ * Parameters: key       - [IN] item key                                      *
+ *             latencies - [IN/OUT] response times of successful requests in  *
+ *                                  seconds                                   *
+ *             requests  - [IN] total number of requests                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	print_statistics(const char *key, zbx_vector_dbl_t *latencies, int requests)
+{
+	double	sum = 0;
+	int	i;
+
+	printf("%s: requests %d, failed %d", key, requests, requests - latencies->values_num);
+
+	if (0 == latencies->values_num)
+	{
+		printf("\n");
+		return;
+	}
+
+	zbx_vector_dbl_sort(latencies, ZBX_DEFAULT_DBL_COMPARE_FUNC);
+
+	for (i = 0; i < latencies->values_num; i++)
+		sum += latencies->values[i];
+
+	printf(", min %.3f ms, avg %.3f ms, p50 %.3f ms, p90 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+			latencies->values[0] * 1000, sum / latencies->values_num * 1000,
+			get_percentile(latencies, 50) * 1000, get_percentile(latencies, 90) * 1000,
+			get_percentile(latencies, 99) * 1000, latencies->values[latencies->values_num - 1] * 1000);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: request values of all keys the specified number of times          *
+ *                                                                            *
+ * Parameters: source_ip - [IN] source IP address                             *
+ *             host      - [IN] server name or IP address                     *
+ *             port      - [IN] port number                                   *
+ *             keys      - [IN] item keys                                     *
+ *             repeat    - [IN] number of requests per key                    *
+ *                                                                            *
+ * Return value: SUCCEED - all requests succeeded                             *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Values are printed for the first round of requests only, each    *
+ *           value prefixed with its key when more than one key is requested. *
+ *           When requests are repeated, response time statistics of each key *
+ *           are printed at the end.                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	get_values(const char *source_ip, const char *host, unsigned short port, const zbx_vector_str_t *keys,
+		int repeat)
+{
+	zbx_vector_dbl_t	*latencies;
+	int			i, j, ret = SUCCEED;
+
+	latencies = (zbx_vector_dbl_t *)zbx_malloc(NULL, sizeof(zbx_vector_dbl_t) * (size_t)keys->values_num);
+
+	for (i = 0; i < keys->values_num; i++)
+		zbx_vector_dbl_create(&latencies[i]);
+
+	for (j = 0; j < repeat; j++)
+	{
+		for (i = 0; i < keys->values_num; i++)
+		{
+			const char	*prefix = (1 < keys->values_num ? keys->values[i] : NULL);
+			double		time_start = zbx_time();
+
+			if (SUCCEED == get_value(source_ip, host, port, keys->values[i], prefix, 0 == j))
+				zbx_vector_dbl_append(&latencies[i], zbx_time() - time_start);
+			else
+				ret = FAIL;
+		}
+	}
+
+	if (1 < repeat)
+	{
+		printf("\n");
+
+		for (i = 0; i < keys->values_num; i++)
+			print_statistics(keys->values[i], &latencies[i], repeat);
+	}
+
+	for (i = 0; i < keys->values_num; i++)
+		zbx_vector_dbl_destroy(&latencies[i]);
+
+	zbx_free(latencies);
+
+	return ret;
+}
+
 int	main(int argc, char **argv)
 {
-	int		i, ret = SUCCEED;
-	char		*host = NULL, *key = NULL, *source_ip = NULL, ch;
-	unsigned short	opt_count[256] = {0}, port = ZBX_DEFAULT_AGENT_PORT;
+	int			i, ret = SUCCEED, repeat = CONFIG_GET_REPEAT_MIN;
+	char			*host = NULL, *source_ip = NULL, *input_file = NULL, ch;
+	zbx_vector_str_t	keys;
+	unsigned short		opt_count[256] = {0}, port = ZBX_DEFAULT_AGENT_PORT;
 #if defined(_WINDOWS)
-	char		*error = NULL;
+	char			*error = NULL;
 #endif
 	/* see description of 'optarg' in 'man 3 getopt' */
-	char		*zbx_optarg = NULL;
+	char			*zbx_optarg = NULL;
 
 	/* see description of 'optind' in 'man 3 getopt' */
-	int		zbx_optind = 0;
+	int			zbx_optind = 0;
 
 #if !defined(_WINDOWS) && (defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL))
 	if (SUCCEED != zbx_coredump_disable())
@@ -319,6 +540,7 @@ int	main(int argc, char **argv)
 	}
 #endif
 	zbx_config_tls = zbx_config_tls_new();
+	zbx_vector_str_create(&keys);
 
 	progname = get_program_name(argv[0]);
 
@@ -331,8 +553,20 @@ int	main(int argc, char **argv)
 		switch (ch)
 		{
 			case 'k':
-				if (NULL == key)
-					key = zbx_strdup(NULL, zbx_optarg);
+				zbx_vector_str_append(&keys, zbx_strdup(NULL, zbx_optarg));
+				break;
+			case 'i':
+				if (NULL == input_file)
+					input_file = zbx_strdup(NULL, zbx_optarg);
+				break;
+			case 'r':
+				if (FAIL == zbx_is_uint_n_range(zbx_optarg, ZBX_MAX_UINT64_LEN, &repeat, sizeof(repeat),
+						CONFIG_GET_REPEAT_MIN, CONFIG_GET_REPEAT_MAX))
+				{
+					zbx_error("Invalid repeat count, valid range %d:%d", CONFIG_GET_REPEAT_MIN,
+							CONFIG_GET_REPEAT_MAX);
+					exit(EXIT_FAILURE);
+				}
 				break;
 			case 'p':
 				port = (unsigned short)atoi(zbx_optarg);
@@ -448,19 +682,19 @@ int	main(int argc, char **argv)
 	}
 #endif
 
-	if (NULL == host || NULL == key)
+	if (NULL == host || (0 == keys.values_num && NULL == input_file))
 	{
 		zbx_usage();
 		ret = FAIL;
 	}
 
-	/* every option may be specified only once */
+	/* every option except item key may be specified only once */
 
 	for (i = 0; NULL != longopts[i].name; i++)
 	{
 		ch = longopts[i].val;
 
-		if (1 < opt_count[(unsigned char)ch])
+		if ('k' != ch && 1 < opt_count[(unsigned char)ch])
 		{
 			if (NULL == strchr(shortopts, ch))
 				zbx_error("option \"--%s\" specified multiple times", longopts[i].name);
@@ -490,6 +724,9 @@ int	main(int argc, char **argv)
 		goto out;
 	}
 
+	if (NULL != input_file && SUCCEED != (ret = load_keys(input_file, &keys)))
+		goto out;
+
 	if (NULL != zbx_config_tls->connect || NULL != zbx_config_tls->ca_file || NULL != zbx_config_tls->crl_file ||
 			NULL != zbx_config_tls->server_cert_issuer || NULL != zbx_config_tls->server_cert_subject ||
 			NULL != zbx_config_tls->cert_file || NULL != zbx_config_tls->key_file ||
@@ -518,11 +755,13 @@ int	main(int argc, char **argv)
 	signal(SIGALRM, get_signal_handler);
 	signal(SIGPIPE, get_signal_handler);
 #endif
-	ret = get_value(source_ip, host, port, key);
+	ret = get_values(source_ip, host, port, &keys, repeat);
 out:
 	zbx_free(host);
-	zbx_free(key);
 	zbx_free(source_ip);
+	zbx_free(input_file);
+	zbx_vector_str_clear_ext(&keys, zbx_str_free);
+	zbx_vector_str_destroy(&keys);
 #if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
 	if (ZBX_TCP_SEC_UNENCRYPTED != zbx_config_tls->connect_mode)
 	{
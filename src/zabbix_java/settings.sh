@@ -42,6 +42,16 @@ PID_FILE="/tmp/zabbix_java.pid"
 # Default:
 # TIMEOUT=3
 
+### Option: zabbix.connectionTTL
+#	How long (in seconds) to keep an idle JMX connection open for reuse by the next request to the same
+#	JMX endpoint with the same credentials.
+#	0 - close connections after each request.
+#
+# Mandatory: no
+# Range: 0-3600
+# Default:
+# CONNECTION_TTL=60
+
 ### Option: zabbix.propertiesFile
 #	Name of properties file. Can be used to set additional properties in a such way that they are not visible on
 #	a command line or to overwrite existing ones.
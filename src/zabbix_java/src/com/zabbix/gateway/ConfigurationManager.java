@@ -36,6 +36,7 @@ class ConfigurationManager
 	static final String LISTEN_PORT = "listenPort";
 	static final String START_POLLERS = "startPollers";
 	static final String TIMEOUT = "timeout";
+	static final String CONNECTION_TTL = "connectionTTL";
 	static final String PROPERTIES_FILE = "propertiesFile";
 
 	private static ConfigurationParameter[] parameters =
@@ -77,6 +78,9 @@ class ConfigurationManager
 		new ConfigurationParameter(TIMEOUT, ConfigurationParameter.TYPE_INTEGER, 3,
 				new IntegerValidator(1, 30),
 				null),
+		new ConfigurationParameter(CONNECTION_TTL, ConfigurationParameter.TYPE_INTEGER, 60,
+				new IntegerValidator(0, 3600),
+				null),
 		new ConfigurationParameter(PROPERTIES_FILE, ConfigurationParameter.TYPE_FILE, null,
 				null,
 				new PostInputValidator()
@@ -0,0 +1,212 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+package com.zabbix.gateway;
+
+import java.io.IOException;
+import java.util.ArrayDeque;
+import java.util.ArrayList;
+import java.util.HashMap;
+import java.util.Iterator;
+import java.util.Map;
+
+import javax.management.MBeanServerConnection;
+import javax.management.remote.JMXConnector;
+
+import org.slf4j.Logger;
+import org.slf4j.LoggerFactory;
+
+// Keeps JMX connections open between requests, so that polling the same JMX endpoint does not repeat the RMI
+// lookup, SSL and authentication handshake every time. A connection is used by one request at a time and is
+// closed after it has been idle for longer than the configured connection TTL.
+class JMXConnectionPool
+{
+	private static final Logger logger = LoggerFactory.getLogger(JMXConnectionPool.class);
+
+	private static final long CLEANUP_INTERVAL = 1000;
+
+	private static final HashMap<String, ArrayDeque<Connection>> idleConnections =
+			new HashMap<String, ArrayDeque<Connection>>();
+	private static long cleanupTime = 0;
+
+	static class Connection
+	{
+		private final String key;
+		private final JMXConnector jmxc;
+		private final MBeanServerConnection mbsc;
+		private long lastAccess;
+
+		Connection(String key, JMXConnector jmxc) throws IOException
+		{
+			this.key = key;
+			this.jmxc = jmxc;
+
+			try
+			{
+				this.mbsc = jmxc.getMBeanServerConnection();
+			}
+			catch (IOException e)
+			{
+				close();
+				throw e;
+			}
+		}
+
+		MBeanServerConnection getMBeanServerConnection()
+		{
+			return mbsc;
+		}
+
+		void close()
+		{
+			try { jmxc.close(); } catch (IOException e) { }
+		}
+	}
+
+	static String getKey(String endpoint, String username, String password)
+	{
+		return endpoint + '\n' + username + '\n' + password;
+	}
+
+	// Returns an idle connection to the specified endpoint or null if there is none. The connection is checked
+	// with a lightweight remote call before being returned, broken connections are closed.
+	static Connection acquire(String key)
+	{
+		if (0 == getTTL())
+			return null;
+
+		Connection connection;
+
+		while (null != (connection = poll(key)))
+		{
+			try
+			{
+				connection.jmxc.getConnectionId();
+				logger.debug("reusing JMX connection to '{}'", key.substring(0, key.indexOf('\n')));
+
+				return connection;
+			}
+			catch (IOException e)
+			{
+				logger.debug("closing broken JMX connection: {}", ZabbixException.getRootCauseMessage(e));
+				connection.close();
+			}
+		}
+
+		return null;
+	}
+
+	// Returns the connection to the pool after successful use.
+	static void release(Connection connection)
+	{
+		long ttl = getTTL();
+
+		if (0 == ttl)
+		{
+			connection.close();
+			return;
+		}
+
+		ArrayList<Connection> expired = new ArrayList<Connection>();
+		long now = System.currentTimeMillis();
+
+		connection.lastAccess = now;
+
+		synchronized (idleConnections)
+		{
+			ArrayDeque<Connection> connections = idleConnections.get(connection.key);
+
+			if (null == connections)
+			{
+				connections = new ArrayDeque<Connection>();
+				idleConnections.put(connection.key, connections);
+			}
+
+			connections.push(connection);
+
+			if (now >= cleanupTime)
+			{
+				removeExpired(now - ttl, expired);
+				cleanupTime = now + CLEANUP_INTERVAL;
+			}
+		}
+
+		// closing may involve network communication, do it outside of the lock
+		for (Connection c : expired)
+			c.close();
+
+		if (0 != expired.size())
+			logger.debug("closed {} idle JMX connections", expired.size());
+	}
+
+	// Closes the connection that must not be reused, e.g. because of a communication error.
+	static void discard(Connection connection)
+	{
+		connection.close();
+	}
+
+	private static Connection poll(String key)
+	{
+		Connection connection = null;
+		ArrayList<Connection> expired = new ArrayList<Connection>();
+		long expiration = System.currentTimeMillis() - getTTL();
+
+		synchronized (idleConnections)
+		{
+			ArrayDeque<Connection> connections = idleConnections.get(key);
+
+			if (null == connections)
+				return null;
+
+			// the most recently used connections are at the head, expired ones are at the tail
+			while (!connections.isEmpty() && connections.peekLast().lastAccess < expiration)
+				expired.add(connections.pollLast());
+
+			connection = connections.poll();
+
+			if (connections.isEmpty())
+				idleConnections.remove(key);
+		}
+
+		for (Connection c : expired)
+			c.close();
+
+		return connection;
+	}
+
+	private static void removeExpired(long expiration, ArrayList<Connection> expired)
+	{
+		for (Iterator<Map.Entry<String, ArrayDeque<Connection>>> it = idleConnections.entrySet().iterator();
+				it.hasNext(); )
+		{
+			ArrayDeque<Connection> connections = it.next().getValue();
+
+			while (!connections.isEmpty() && connections.peekLast().lastAccess < expiration)
+				expired.add(connections.pollLast());
+
+			if (connections.isEmpty())
+				it.remove();
+		}
+	}
+
+	private static long getTTL()
+	{
+		return ConfigurationManager.getIntegerParameterValue(ConfigurationManager.CONNECTION_TTL) * 1000L;
+	}
+}
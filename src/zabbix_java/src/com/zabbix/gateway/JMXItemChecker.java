@@ -48,8 +48,8 @@ class JMXItemChecker extends ItemChecker
 	private static final Logger logger = LoggerFactory.getLogger(JMXItemChecker.class);
 
 	private JMXServiceURL url;
-	private JMXConnector jmxc;
 	private MBeanServerConnection mbsc;
+	private HashMap<ObjectName, HashMap<String, Object>> attributeValues;
 
 	private String username;
 	private String password;
@@ -78,8 +78,8 @@ class JMXItemChecker extends ItemChecker
 		try
 		{
 			url = new JMXServiceURL(jmx_endpoint);
-			jmxc = null;
 			mbsc = null;
+			attributeValues = new HashMap<ObjectName, HashMap<String, Object>>();
 
 			username = request.optString(JSON_TAG_USERNAME, null);
 			password = request.optString(JSON_TAG_PASSWORD, null);
@@ -90,56 +90,73 @@ class JMXItemChecker extends ItemChecker
 		}
 	}
 
-	@Override
-	JSONArray getValues() throws ZabbixException
+	private JMXConnector connect() throws Exception
 	{
-		JSONArray values = new JSONArray();
+		JMXConnector jmxc;
+		HashMap<String, Object> env = new HashMap<String, Object>();
 
-		try
+		if (null != username && null != password)
 		{
-			HashMap<String, Object> env = new HashMap<String, Object>();
+			env.put(JMXConnector.CREDENTIALS, new String[] {username, password});
+		}
 
-			if (null != username && null != password)
+		if (!useRMISSLforURLHintCache.containsKey(url.getURLPath()) ||
+				!useRMISSLforURLHintCache.get(url.getURLPath()))
+		{
+			try
 			{
-				env.put(JMXConnector.CREDENTIALS, new String[] {username, password});
+				jmxc = ZabbixJMXConnectorFactory.connect(url, env);
+				useRMISSLforURLHintCache.put(url.getURLPath(), false);
 			}
-
-			if (!useRMISSLforURLHintCache.containsKey(url.getURLPath()) ||
-					!useRMISSLforURLHintCache.get(url.getURLPath()))
+			catch (IOException e)
 			{
-				try
-				{
-					jmxc = ZabbixJMXConnectorFactory.connect(url, env);
-					useRMISSLforURLHintCache.put(url.getURLPath(), false);
-				}
-				catch (IOException e)
-				{
-					env.put("com.sun.jndi.rmi.factory.socket", new SslRMIClientSocketFactory());
-					jmxc = ZabbixJMXConnectorFactory.connect(url, env);
-					useRMISSLforURLHintCache.put(url.getURLPath(), true);
-				}
+				env.put("com.sun.jndi.rmi.factory.socket", new SslRMIClientSocketFactory());
+				jmxc = ZabbixJMXConnectorFactory.connect(url, env);
+				useRMISSLforURLHintCache.put(url.getURLPath(), true);
 			}
-			else
+		}
+		else
+		{
+			try
 			{
-				try
-				{
-					env.put("com.sun.jndi.rmi.factory.socket", new SslRMIClientSocketFactory());
-					jmxc = ZabbixJMXConnectorFactory.connect(url, env);
-					useRMISSLforURLHintCache.put(url.getURLPath(), true);
-				}
-				catch (IOException e)
-				{
-					env.remove("com.sun.jndi.rmi.factory.socket");
-					jmxc = ZabbixJMXConnectorFactory.connect(url, env);
-					useRMISSLforURLHintCache.put(url.getURLPath(), false);
-				}
+				env.put("com.sun.jndi.rmi.factory.socket", new SslRMIClientSocketFactory());
+				jmxc = ZabbixJMXConnectorFactory.connect(url, env);
+				useRMISSLforURLHintCache.put(url.getURLPath(), true);
 			}
+			catch (IOException e)
+			{
+				env.remove("com.sun.jndi.rmi.factory.socket");
+				jmxc = ZabbixJMXConnectorFactory.connect(url, env);
+				useRMISSLforURLHintCache.put(url.getURLPath(), false);
+			}
+		}
+
+		logger.debug("using RMI SSL for " + url.getURLPath() + ": " + useRMISSLforURLHintCache.get(url.getURLPath()));
+
+		return jmxc;
+	}
+
+	@Override
+	JSONArray getValues() throws ZabbixException
+	{
+		JSONArray values = new JSONArray();
+		String poolKey = JMXConnectionPool.getKey(jmx_endpoint, username, password);
+		JMXConnectionPool.Connection connection = null;
+		boolean reusable = false;
+
+		try
+		{
+			if (null == (connection = JMXConnectionPool.acquire(poolKey)))
+				connection = new JMXConnectionPool.Connection(poolKey, connect());
+
+			mbsc = connection.getMBeanServerConnection();
 
-			mbsc = jmxc.getMBeanServerConnection();
-			logger.debug("using RMI SSL for " + url.getURLPath() + ": " + useRMISSLforURLHintCache.get(url.getURLPath()));
+			prefetchAttributes();
 
 			for (String key : keys)
 				values.put(getJSONValue(key));
+
+			reusable = true;
 		}
 		catch (SecurityException e1)
 		{
@@ -170,10 +187,16 @@ class JMXItemChecker extends ItemChecker
 		}
 		finally
 		{
-			try { if (null != jmxc) jmxc.close(); } catch (java.io.IOException exception) { }
+			if (null != connection)
+			{
+				if (reusable)
+					JMXConnectionPool.release(connection);
+				else
+					JMXConnectionPool.discard(connection);
+			}
 
-			jmxc = null;
 			mbsc = null;
+			attributeValues.clear();
 		}
 
 		return values;
@@ -220,7 +243,13 @@ class JMXItemChecker extends ItemChecker
 
 			try
 			{
-				Object dataObject = mbsc.getAttribute(objectName, realAttributeName);
+				Object dataObject;
+				HashMap<String, Object> objectValues = attributeValues.get(objectName);
+
+				if (null != objectValues && objectValues.containsKey(realAttributeName))
+					dataObject = objectValues.get(realAttributeName);
+				else
+					dataObject = mbsc.getAttribute(objectName, realAttributeName);
 
 				if (dataObject instanceof TabularData)
 				{
@@ -293,6 +322,74 @@ class JMXItemChecker extends ItemChecker
 			throw new ZabbixException("key ID '%s' is not supported", item.getKeyId());
 	}
 
+	// Retrieves attributes requested by jmx[] keys of the same object with a single getAttributes() call instead
+	// of a remote call per attribute. Attributes that cannot be read in bulk are retrieved by getStringValue().
+	private void prefetchAttributes()
+	{
+		HashMap<ObjectName, HashSet<String>> attributeNames = new HashMap<ObjectName, HashSet<String>>();
+
+		for (String key : keys)
+		{
+			try
+			{
+				ZabbixItem item = new ZabbixItem(key);
+				int argumentCount = item.getArgumentCount();
+
+				if (!item.getKeyId().equals("jmx") || (2 != argumentCount && 3 != argumentCount))
+					continue;
+
+				ObjectName objectName = new ObjectName(item.getArgument(1));
+
+				if (objectName.isPattern())
+					continue;
+
+				String attributeName = item.getArgument(2);
+				int sep = HelperFunctionChest.separatorIndex(attributeName);
+
+				if (-1 != sep)
+					attributeName = attributeName.substring(0, sep);
+
+				HashSet<String> names = attributeNames.get(objectName);
+
+				if (null == names)
+				{
+					names = new HashSet<String>();
+					attributeNames.put(objectName, names);
+				}
+
+				names.add(HelperFunctionChest.unescapeUserInput(attributeName));
+			}
+			catch (Exception e)
+			{
+				// invalid keys are reported when their values are retrieved
+			}
+		}
+
+		for (Map.Entry<ObjectName, HashSet<String>> entry : attributeNames.entrySet())
+		{
+			if (2 > entry.getValue().size())
+				continue;
+
+			try
+			{
+				HashMap<String, Object> objectValues = new HashMap<String, Object>();
+				AttributeList attributes = mbsc.getAttributes(entry.getKey(),
+						entry.getValue().toArray(new String[entry.getValue().size()]));
+
+				for (javax.management.Attribute attribute : attributes.asList())
+					objectValues.put(attribute.getName(), attribute.getValue());
+
+				attributeValues.put(entry.getKey(), objectValues);
+				logger.trace("retrieved {} attributes of '{}' in bulk", objectValues.size(), entry.getKey());
+			}
+			catch (Exception e)
+			{
+				logger.debug("cannot retrieve attributes of '{}' in bulk: {}", entry.getKey(),
+						ZabbixException.getRootCauseMessage(e));
+			}
+		}
+	}
+
 	private String getPrimitiveAttributeValue(Object dataObject, String fieldNames) throws Exception
 	{
 		logger.trace("drilling down with data object '{}' and field names '{}'", dataObject, fieldNames);
@@ -40,6 +40,9 @@ fi
 if [ -n "$TIMEOUT" ]; then
 	ZABBIX_OPTIONS="$ZABBIX_OPTIONS -Dzabbix.timeout=$TIMEOUT"
 fi
+if [ -n "$CONNECTION_TTL" ]; then
+	ZABBIX_OPTIONS="$ZABBIX_OPTIONS -Dzabbix.connectionTTL=$CONNECTION_TTL"
+fi
 if [ -n "$PROPERTIES_FILE" ]; then
 	ZABBIX_OPTIONS="$ZABBIX_OPTIONS -Dzabbix.propertiesFile=$PROPERTIES_FILE"
 fi
@@ -31,6 +31,7 @@
 #include "zbxtime.h"
 #include "../taskmanager/taskmanager.h"
 #include "zbxjson.h"
+#include "zbxcrypto.h"
 
 #define ZBX_DATASENDER_AVAILABILITY		0x0001
 #define ZBX_DATASENDER_HISTORY			0x0002
@@ -72,27 +73,281 @@ static void	get_hist_upload_state(const char *buffer, int *state)
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get history data format supported by server                       *
+ *                                                                            *
+ * Parameters: buffer - [IN] contents of a packet (JSON)                      *
+ *                                                                            *
+ * Return value: ZBX_PROXY_HISTORY_FORMAT_BINARY - server accepts binary      *
+ *                                                 history data               *
+ *               ZBX_PROXY_HISTORY_FORMAT_JSON   - otherwise                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	get_hist_data_format(const char *buffer)
+{
+	struct zbx_json_parse	jp;
+	char			value[MAX_STRING_LEN];
+
+	if (NULL == buffer || '\0' == *buffer || SUCCEED != zbx_json_open(buffer, &jp))
+		return ZBX_PROXY_HISTORY_FORMAT_JSON;
+
+	if (SUCCEED == zbx_json_value_by_name(&jp, ZBX_PROTO_TAG_HISTORY_FORMAT, value, sizeof(value), NULL) &&
+			0 == strcmp(value, ZBX_PROTO_VALUE_HISTORY_FORMAT_BINARY))
+	{
+		return ZBX_PROXY_HISTORY_FORMAT_BINARY;
+	}
+
+	return ZBX_PROXY_HISTORY_FORMAT_JSON;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get compression codec to be used with server                      *
+ *                                                                            *
+ * Parameters: buffer - [IN] contents of a packet (JSON)                      *
+ *                                                                            *
+ * Return value: The preferred compression codec supported by both server and *
+ *               proxy.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+static unsigned char	get_compress_codec(const char *buffer)
+{
+	struct zbx_json_parse	jp;
+	char			value[MAX_STRING_LEN];
+
+	if (NULL == buffer || '\0' == *buffer || SUCCEED != zbx_json_open(buffer, &jp))
+		return ZBX_COMPRESS_ZLIB;
+
+	if (SUCCEED != zbx_json_value_by_name(&jp, ZBX_PROTO_TAG_COMPRESSION, value, sizeof(value), NULL))
+		return ZBX_COMPRESS_ZLIB;
+
+	return zbx_compress_select_codec(value);
+}
+
+/* additional history data batch, uploaded over a separate connection */
+typedef struct
+{
+	struct zbx_json	j;
+	zbx_socket_t	sock;
+	zbx_uint64_t	firstid;
+	int		state;
+}
+zbx_datasender_batch_t;
+
+#define ZBX_DATASENDER_BATCH_EMPTY	0
+#define ZBX_DATASENDER_BATCH_SENT	1
+#define ZBX_DATASENDER_BATCH_FAILED	2
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get session token of the specified history data batch             *
+ *                                                                            *
+ * Parameters: index       - [IN] the batch index                             *
+ *             batches_num - [IN] the number of batches                       *
+ *                                                                            *
+ * Comments: Server drops already processed records by comparing their ids    *
+ *           with the last id processed in the same session. Batches are      *
+ *           processed by server in parallel, so each batch is sent in its    *
+ *           own session. The first batch is sent together with other proxy   *
+ *           data in the proxy session.                                       *
+ *                                                                            *
+ ******************************************************************************/
+static const char	*get_batch_session_token(int index, int batches_num)
+{
+	static char	**tokens = NULL;
+
+	if (0 == index)
+		return zbx_dc_get_session_token();
+
+	if (NULL == tokens)
+		tokens = (char **)zbx_calloc(NULL, (size_t)batches_num, sizeof(char *));
+
+	if (NULL == tokens[index])
+		tokens[index] = zbx_create_token((zbx_uint64_t)index);
+
+	return tokens[index];
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: send data to server without waiting for response                  *
+ *                                                                            *
+ * Parameters: sock        - [IN] connection socket                           *
+ *             buffer      - [IN] the compressed data                         *
+ *             buffer_size - [IN] the compressed data size                    *
+ *             reserved    - [IN] the uncompressed data size                  *
+ *             codec       - [IN] the compression codec used for data         *
+ *             error       - [OUT] the error message                          *
+ *                                                                            *
+ * Return value: SUCCEED - the data was sent                                  *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	send_proxy_data(zbx_socket_t *sock, char *buffer, size_t buffer_size, size_t reserved,
+		unsigned char codec, char **error)
+{
+	if (SUCCEED != zbx_tcp_send_ext(sock, buffer, buffer_size, reserved,
+			ZBX_TCP_PROTOCOL | zbx_tcp_compress_flags(codec), 0))
+	{
+		*error = zbx_strdup(*error, zbx_socket_strerror());
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: send additional history data batches over separate connections    *
+ *                                                                            *
+ * Parameters: batches     - [IN/OUT] the additional history data batches     *
+ *             batches_num - [IN] the number of additional batches            *
+ *             codec       - [IN] the compression codec                       *
+ *             args        - [IN] the data sender configuration               *
+ *                                                                            *
+ * Comments: Batches are sent one after another without waiting for server    *
+ *           responses, so they are in flight simultaneously.                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	send_proxy_data_batches(zbx_datasender_batch_t *batches, int batches_num, unsigned char codec,
+		const zbx_thread_datasender_args *args)
+{
+	zbx_vector_addr_ptr_t	addrs;
+	int			i;
+
+	/* connect only to the server that accepted the first batch, without failover */
+	zbx_vector_addr_ptr_create(&addrs);
+	zbx_vector_addr_ptr_append(&addrs, args->config_server_addrs->values[0]);
+
+	for (i = 0; i < batches_num; i++)
+	{
+		zbx_datasender_batch_t	*batch = &batches[i];
+		char			*buffer = NULL, *error = NULL;
+		size_t			buffer_size, reserved;
+
+		if (0 == batch->firstid)
+			continue;
+
+		batch->state = ZBX_DATASENDER_BATCH_FAILED;
+
+		if (SUCCEED != zbx_compress_ext(codec, batch->j.buffer, batch->j.buffer_size, &buffer, &buffer_size))
+		{
+			zabbix_log(LOG_LEVEL_ERR,"cannot compress data: %s", zbx_compress_strerror());
+			continue;
+		}
+
+		reserved = batch->j.buffer_size;
+		zbx_json_free(&batch->j);
+
+		if (FAIL == zbx_connect_to_server(&batch->sock, args->config_source_ip, &addrs, 600,
+				args->config_timeout, 0, LOG_LEVEL_DEBUG, args->zbx_config_tls))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot connect to server to send history data batch: %s",
+					zbx_socket_strerror());
+			zbx_free(buffer);
+			continue;
+		}
+
+		if (SUCCEED != send_proxy_data(&batch->sock, buffer, buffer_size, reserved, codec, &error))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot send history data batch to server at \"%s\": %s",
+					batch->sock.peer, error);
+			zbx_disconnect_from_server(&batch->sock);
+			zbx_free(error);
+		}
+		else
+			batch->state = ZBX_DATASENDER_BATCH_SENT;
+
+		zbx_free(buffer);
+	}
+
+	zbx_vector_addr_ptr_destroy(&addrs);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: receive server responses for additional history data batches      *
+ *                                                                            *
+ * Parameters: batches     - [IN/OUT] the additional history data batches     *
+ *             batches_num - [IN] the number of additional batches            *
+ *             format      - [IN] the history format used to send batches     *
+ *                                                                            *
+ * Return value: The id of the first record of the earliest failed batch or 0 *
+ *               if all batches were accepted by server.                      *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint64_t	recv_proxy_data_batches(zbx_datasender_batch_t *batches, int batches_num, int format)
+{
+	int		i;
+	zbx_uint64_t	failed_firstid = 0;
+
+	for (i = 0; i < batches_num; i++)
+	{
+		zbx_datasender_batch_t	*batch = &batches[i];
+		char			*error = NULL;
+
+		if (ZBX_DATASENDER_BATCH_SENT == batch->state)
+		{
+			if (SUCCEED != zbx_recv_response(&batch->sock, 0, &error))
+			{
+				zabbix_log(LOG_LEVEL_WARNING, "cannot send history data batch to server at \"%s\": %s",
+						batch->sock.peer, error);
+				batch->state = ZBX_DATASENDER_BATCH_FAILED;
+				zbx_free(error);
+			}
+			else if (ZBX_PROXY_HISTORY_FORMAT_BINARY == format &&
+					ZBX_PROXY_HISTORY_FORMAT_BINARY != get_hist_data_format(batch->sock.buffer))
+			{
+				batch->state = ZBX_DATASENDER_BATCH_FAILED;
+			}
+
+			zbx_disconnect_from_server(&batch->sock);
+		}
+
+		if (ZBX_DATASENDER_BATCH_FAILED == batch->state && (0 == failed_firstid ||
+				batch->firstid < failed_firstid))
+		{
+			failed_firstid = batch->firstid;
+		}
+	}
+
+	return failed_firstid;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: collects host availability, history, discovery, autoregistration  *
  *          data and sends 'proxy data' request                               *
  *                                                                            *
+ * Comments: With several data sender connections configured the history      *
+ *           data is split by items into batches. The first batch is sent     *
+ *           with the rest of proxy data, the others over own connections,    *
+ *           and all of them are in flight at the same time. The history      *
+ *           lastid is advanced only up to the first record of the first      *
+ *           batch not accepted by server.                                    *
+ *                                                                            *
  ******************************************************************************/
 static int	proxy_data_sender(int *more, int now, int *hist_upload_state, const zbx_thread_info_t *info,
 		zbx_thread_datasender_args *args)
 {
-	static int		data_timestamp = 0, task_timestamp = 0, upload_state = SUCCEED;
+	static int		data_timestamp = 0, task_timestamp = 0, upload_state = SUCCEED,
+				history_format = ZBX_PROXY_HISTORY_FORMAT_JSON;
 
 	zbx_socket_t		sock;
-	struct zbx_json		j;
+	struct zbx_json		j, **jsons;
 	struct zbx_json_parse	jp, jp_tasks;
 	int			availability_ts, history_records = 0, discovery_records = 0,
-				areg_records = 0, more_history = 0, more_discovery = 0, more_areg = 0, proxy_delay,
-				host_avail_records = 0;
-	zbx_uint64_t		history_lastid = 0, discovery_lastid = 0, areg_lastid = 0, flags = 0;
+				areg_records = 0, more_history = 0, more_discovery = 0, more_areg = 0, proxy_delay = 0,
+				host_avail_records = 0, history_format_sent = history_format, i,
+				batches_num = args->config_datasender_connections - 1;
+	zbx_uint64_t		history_lastid = 0, discovery_lastid = 0, areg_lastid = 0, flags = 0,
+				*firstids, failed_firstid;
 	zbx_timespec_t		ts;
 	char			*error = NULL, *buffer = NULL;
 	zbx_vector_tm_task_t	tasks;
+	static unsigned char	codec = ZBX_COMPRESS_ZLIB;
+	zbx_datasender_batch_t	*batches = NULL;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -103,13 +358,48 @@ static int	proxy_data_sender(int *more, int now, int *hist_upload_state, const z
 	zbx_json_addstring(&j, ZBX_PROTO_TAG_HOST, args->config_hostname, ZBX_JSON_TYPE_STRING);
 	zbx_json_addstring(&j, ZBX_PROTO_TAG_SESSION, zbx_dc_get_session_token(), ZBX_JSON_TYPE_STRING);
 
+	if (0 != batches_num)
+		batches = (zbx_datasender_batch_t *)zbx_calloc(NULL, (size_t)batches_num, sizeof(zbx_datasender_batch_t));
+
 	if (SUCCEED == upload_state && args->config_proxydata_frequency <= now - data_timestamp &&
 			ZBX_PROXY_UPLOAD_DISABLED != *hist_upload_state)
 	{
 		if (SUCCEED == zbx_get_interface_availability_data(&j, &availability_ts))
 			flags |= ZBX_DATASENDER_AVAILABILITY;
 
-		history_records = zbx_proxy_get_hist_data(&j, &history_lastid, &more_history);
+		if (0 == batches_num)
+		{
+			history_records = zbx_proxy_get_hist_data(&j, history_format_sent, &history_lastid,
+					&more_history);
+		}
+		else
+		{
+			jsons = (struct zbx_json **)zbx_malloc(NULL, sizeof(struct zbx_json *) * (size_t)(batches_num + 1));
+			firstids = (zbx_uint64_t *)zbx_malloc(NULL, sizeof(zbx_uint64_t) * (size_t)(batches_num + 1));
+			jsons[0] = &j;
+
+			for (i = 0; i < batches_num; i++)
+			{
+				zbx_json_init(&batches[i].j, 16 * ZBX_KIBIBYTE);
+				zbx_json_addstring(&batches[i].j, ZBX_PROTO_TAG_REQUEST, ZBX_PROTO_VALUE_PROXY_DATA,
+						ZBX_JSON_TYPE_STRING);
+				zbx_json_addstring(&batches[i].j, ZBX_PROTO_TAG_HOST, args->config_hostname,
+						ZBX_JSON_TYPE_STRING);
+				zbx_json_addstring(&batches[i].j, ZBX_PROTO_TAG_SESSION,
+						get_batch_session_token(i + 1, batches_num + 1), ZBX_JSON_TYPE_STRING);
+				jsons[i + 1] = &batches[i].j;
+			}
+
+			history_records = zbx_proxy_get_hist_data_batches(jsons, batches_num + 1, history_format_sent,
+					&history_lastid, firstids, &more_history);
+
+			for (i = 0; i < batches_num; i++)
+				batches[i].firstid = firstids[i + 1];
+
+			zbx_free(firstids);
+			zbx_free(jsons);
+		}
+
 		if (0 != history_lastid)
 			flags |= ZBX_DATASENDER_HISTORY;
 
@@ -157,20 +447,44 @@ static int	proxy_data_sender(int *more, int now, int *hist_upload_state, const z
 		if (ZBX_PROXY_DATA_MORE == more_history || ZBX_PROXY_DATA_MORE == more_discovery ||
 				ZBX_PROXY_DATA_MORE == more_areg)
 		{
-			zbx_json_adduint64(&j, ZBX_PROTO_TAG_MORE, ZBX_PROXY_DATA_MORE);
 			*more = ZBX_PROXY_DATA_MORE;
 		}
 
-		zbx_json_addstring(&j, ZBX_PROTO_TAG_VERSION, ZABBIX_VERSION, ZBX_JSON_TYPE_STRING);
-
 		zbx_timespec(&ts);
+
+		if (0 != (flags & ZBX_DATASENDER_HISTORY))
+			proxy_delay = zbx_proxy_get_delay(history_lastid);
+
+		/* additional batches carry the same request attributes as the first one */
+		for (i = 0; i < batches_num; i++)
+		{
+			struct zbx_json	*jb = &batches[i].j;
+
+			if (0 == batches[i].firstid)
+				continue;
+
+			if (ZBX_PROXY_DATA_MORE == *more)
+				zbx_json_adduint64(jb, ZBX_PROTO_TAG_MORE, ZBX_PROXY_DATA_MORE);
+
+			zbx_json_addstring(jb, ZBX_PROTO_TAG_VERSION, ZABBIX_VERSION, ZBX_JSON_TYPE_STRING);
+			zbx_json_adduint64(jb, ZBX_PROTO_TAG_CLOCK, ts.sec);
+			zbx_json_adduint64(jb, ZBX_PROTO_TAG_NS, ts.ns);
+
+			if (0 != proxy_delay)
+				zbx_json_adduint64(jb, ZBX_PROTO_TAG_PROXY_DELAY, proxy_delay);
+		}
+
+		if (ZBX_PROXY_DATA_MORE == *more)
+			zbx_json_adduint64(&j, ZBX_PROTO_TAG_MORE, ZBX_PROXY_DATA_MORE);
+
+		zbx_json_addstring(&j, ZBX_PROTO_TAG_VERSION, ZABBIX_VERSION, ZBX_JSON_TYPE_STRING);
 		zbx_json_adduint64(&j, ZBX_PROTO_TAG_CLOCK, ts.sec);
 		zbx_json_adduint64(&j, ZBX_PROTO_TAG_NS, ts.ns);
 
-		if (0 != (flags & ZBX_DATASENDER_HISTORY) && 0 != (proxy_delay = zbx_proxy_get_delay(history_lastid)))
+		if (0 != proxy_delay)
 			zbx_json_adduint64(&j, ZBX_PROTO_TAG_PROXY_DELAY, proxy_delay);
 
-		if (SUCCEED != zbx_compress(j.buffer, j.buffer_size, &buffer, &buffer_size))
+		if (SUCCEED != zbx_compress_ext(codec, j.buffer, j.buffer_size, &buffer, &buffer_size))
 		{
 			zabbix_log(LOG_LEVEL_ERR,"cannot compress data: %s", zbx_compress_strerror());
 			goto clean;
@@ -193,11 +507,25 @@ static int	proxy_data_sender(int *more, int now, int *hist_upload_state, const z
 
 		zbx_update_selfmon_counter(info, ZBX_PROCESS_STATE_BUSY);
 
-		upload_state = zbx_put_data_to_server(&sock, &buffer, buffer_size, reserved, &error);
+		if (SUCCEED == (upload_state = send_proxy_data(&sock, buffer, buffer_size, reserved, codec, &error)))
+		{
+			zbx_free(buffer);
+
+			/* send additional batches while the first one is being processed by server */
+			if (0 != batches_num)
+				send_proxy_data_batches(batches, batches_num, codec, args);
+
+			upload_state = zbx_recv_response(&sock, 0, &error);
+		}
+
+		failed_firstid = recv_proxy_data_batches(batches, batches_num, history_format_sent);
+
 		get_hist_upload_state(sock.buffer, hist_upload_state);
 
 		if (SUCCEED != upload_state)
 		{
+			/* fall back to zlib until server confirms other codecs again */
+			codec = ZBX_COMPRESS_ZLIB;
 			*more = ZBX_PROXY_DATA_DONE;
 			if (ZBX_PROXY_UPLOAD_DISABLED != *hist_upload_state)
 			{
@@ -211,6 +539,26 @@ static int	proxy_data_sender(int *more, int now, int *hist_upload_state, const z
 			if (0 != (flags & ZBX_DATASENDER_AVAILABILITY))
 				zbx_set_availability_diff_ts(availability_ts);
 
+			history_format = get_hist_data_format(sock.buffer);
+			codec = get_compress_codec(sock.buffer);
+
+			/* server that does not confirm binary format support has ignored binary history data, */
+			/* keep it to be sent again in JSON format                                                */
+			if (0 != (flags & ZBX_DATASENDER_HISTORY) && ZBX_PROXY_HISTORY_FORMAT_BINARY == history_format_sent &&
+					ZBX_PROXY_HISTORY_FORMAT_BINARY != history_format)
+			{
+				zabbix_log(LOG_LEVEL_WARNING, "server at \"%s\" does not support binary history data,"
+						" history data will be sent in JSON format", sock.peer);
+				flags &= ~ZBX_DATASENDER_HISTORY;
+				*more = ZBX_PROXY_DATA_MORE;
+			}
+			else if (0 != failed_firstid)
+			{
+				/* records before the failed batch were accepted, the rest will be sent again */
+				history_lastid = failed_firstid - 1;
+				*more = ZBX_PROXY_DATA_DONE;
+			}
+
 			if (SUCCEED == zbx_json_open(sock.buffer, &jp))
 			{
 				if (SUCCEED == zbx_json_brackets_by_name(&jp, ZBX_PROTO_TAG_TASKS, &jp_tasks))
@@ -234,23 +582,7 @@ static int	proxy_data_sender(int *more, int now, int *hist_upload_state, const z
 				}
 
 				if (0 != (flags & ZBX_DATASENDER_HISTORY))
-				{
-					zbx_uint64_t	history_maxid;
-					zbx_db_result_t	result;
-					zbx_db_row_t	row;
-
-					result = zbx_db_select("select max(id) from proxy_history");
-
-					if (NULL == (row = zbx_db_fetch(result)) || SUCCEED == zbx_db_is_null(row[0]))
-						history_maxid = history_lastid;
-					else
-						ZBX_STR2UINT64(history_maxid, row[0]);
-
-					zbx_db_free_result(result);
-
-					zbx_reset_proxy_history_count(history_maxid - history_lastid);
 					zbx_proxy_set_hist_lastid(history_lastid);
-				}
 
 				if (0 != (flags & ZBX_DATASENDER_DISCOVERY))
 					zbx_proxy_set_dhis_lastid(discovery_lastid);
@@ -268,6 +600,10 @@ clean:
 	zbx_vector_tm_task_clear_ext(&tasks, zbx_tm_task_free);
 	zbx_vector_tm_task_destroy(&tasks);
 
+	for (i = 0; i < batches_num; i++)
+		zbx_json_free(&batches[i].j);
+
+	zbx_free(batches);
 	zbx_json_free(&j);
 	zbx_free(buffer);
 
@@ -33,6 +33,7 @@ typedef struct
 	const char		*config_source_ip;
 	const char		*config_hostname;
 	int			config_proxydata_frequency;
+	int			config_datasender_connections;
 }
 zbx_thread_datasender_args;
 
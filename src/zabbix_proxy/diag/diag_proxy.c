@@ -49,6 +49,13 @@ int	diag_add_section_info(const char *section, const struct zbx_json_parse *jp,
 		zbx_diag_add_locks_info(json);
 		ret = SUCCEED;
 	}
+	else if (0 == strcmp(section, ZBX_DIAG_DISCOVERY))
+		ret = zbx_diag_add_discovery_info(jp, json, error);
+	else if (0 == strcmp(section, ZBX_DIAG_PROFILING))
+	{
+		zbx_diag_add_profiling_info(json);
+		ret = SUCCEED;
+	}
 	else
 		*error = zbx_dsprintf(*error, "Unsupported diagnostics section: %s", section);
 
@@ -27,12 +27,14 @@
 #include "log.h"
 #include "zbxgetopt.h"
 #include "zbxmutexs.h"
+#include "zbxshmem.h"
 
 #include "zbxsysinfo.h"
 #include "zbxmodules.h"
 
 #include "zbxnix.h"
 #include "zbxself.h"
+#include "zbxprof.h"
 
 #include "zbxdbsyncer.h"
 #include "../zabbix_server/discoverer/discoverer.h"
@@ -98,8 +100,9 @@ const char	*help_message[] = {
 	"                                   target is not specified",
 	"      " ZBX_SNMP_CACHE_RELOAD "          Reload SNMP cache",
 	"      " ZBX_DIAGINFO "=section           Log internal diagnostic information of the",
-	"                                 section (historycache, preprocessing, locks) or",
-	"                                 everything if section is not specified",
+	"                                 section (historycache, preprocessing, locks,",
+	"                                 discovery, profiling) or everything if section",
+	"                                 is not specified",
 	"      " ZBX_PROF_ENABLE "=target         Enable profiling, affects all processes if",
 	"                                   target is not specified",
 	"      " ZBX_PROF_DISABLE "=target        Disable profiling, affects all processes if",
@@ -200,6 +203,12 @@ static const char	*get_fping6_location(void)
 }
 #endif
 
+static int	config_native_icmpping = 0;
+static int	get_native_icmpping(void)
+{
+	return config_native_icmpping;
+}
+
 static int	config_proxymode		= ZBX_PROXYMODE_ACTIVE;
 
 int	CONFIG_FORKS[ZBX_PROCESS_TYPE_COUNT] = {
@@ -241,7 +250,11 @@ int	CONFIG_FORKS[ZBX_PROCESS_TYPE_COUNT] = {
 	0, /* ZBX_PROCESS_TYPE_TRIGGERHOUSEKEEPER */
 	1, /* ZBX_PROCESS_TYPE_ODBCPOLLER */
 	0, /* ZBX_PROCESS_TYPE_CONNECTORMANAGER */
-	0 /* ZBX_PROCESS_TYPE_CONNECTORWORKER */
+	0, /* ZBX_PROCESS_TYPE_CONNECTORWORKER */
+	1, /* ZBX_PROCESS_TYPE_AGENT_POLLER */
+	1, /* ZBX_PROCESS_TYPE_SNMP_POLLER */
+	1, /* ZBX_PROCESS_TYPE_HTTPAGENT_POLLER */
+	0 /* ZBX_PROCESS_TYPE_TRENDWRITER */
 };
 
 static int	get_config_forks(unsigned char process_type)
@@ -257,9 +270,14 @@ ZBX_PROPERTY_DECL(int, zbx_config_timeout, 3)
 static int	config_startup_time		= 0;
 static int	config_unavailable_delay	=60;
 static int	config_housekeeping_frequency = 1;
+static int	config_availability_flush_delay = 5;
 static int	config_proxy_local_buffer = 0;
 static int	config_proxy_offline_buffer = 1;
+static char	*config_proxy_buffer_mode = NULL;
+static zbx_uint64_t	config_proxy_memory_buffer_size = 0;
+static int	config_proxy_memory_buffer_age = 0;
 static int	config_histsyncer_frequency = 1;
+static int	config_histsyncer_min = 0;
 
 int	CONFIG_LISTEN_PORT		= ZBX_DEFAULT_SERVER_PORT;
 char	*CONFIG_LISTEN_IP		= NULL;
@@ -270,6 +288,8 @@ int	CONFIG_HEARTBEAT_FREQUENCY	= -1;
 /* how often active Zabbix proxy requests configuration data from server, in seconds */
 static int	config_proxyconfig_frequency	= 0;	/* will be set to default 5 seconds if not configured */
 static int	config_proxydata_frequency	= 1;
+static int	config_datasender_connections	= 1;
+static int	config_max_concurrent_trapper_connections	= 0;
 
 int	CONFIG_CONFSYNCER_FREQUENCY	= 0;
 
@@ -280,11 +300,16 @@ int	CONFIG_VMWARE_TIMEOUT		= 10;
 static zbx_uint64_t	config_conf_cache_size		= 8 * ZBX_MEBIBYTE;
 static zbx_uint64_t	config_history_cache_size	= 16 * ZBX_MEBIBYTE;
 static zbx_uint64_t	config_history_index_cache_size	= 4 * ZBX_MEBIBYTE;
+static int		config_history_cache_shards	= 1;
+static zbx_uint64_t	config_history_ingest_ring_size	= 0;
 static zbx_uint64_t	config_trends_cache_size	= 0;
+static int		config_shmem_huge_pages		= 0;
+static zbx_uint64_t	config_tls_session_cache_size	= 0;
 zbx_uint64_t	CONFIG_VMWARE_CACHE_SIZE	= 8 * ZBX_MEBIBYTE;
 
 static int	config_unreachable_period	= 45;
 static int	config_unreachable_delay	= 15;
+static int	config_max_concurrent_checks_per_poller	= 1000;
 int	CONFIG_LOG_LEVEL		= LOG_LEVEL_WARNING;
 char	*CONFIG_EXTERNALSCRIPTS		= NULL;
 int	CONFIG_ALLOW_UNSUPPORTED_DB_VERSIONS = 0;
@@ -299,6 +324,7 @@ char	*CONFIG_HOSTNAME		= NULL;
 char	*CONFIG_HOSTNAME_ITEM		= NULL;
 
 char	*CONFIG_SNMPTRAP_FILE		= NULL;
+char	*CONFIG_SNMPTRAP_SOCKET		= NULL;
 
 char	*CONFIG_JAVA_GATEWAY		= NULL;
 int	CONFIG_JAVA_GATEWAY_PORT	= ZBX_DEFAULT_GATEWAY_PORT;
@@ -344,7 +370,8 @@ static const zbx_events_funcs_t	events_cbs = {
 	.clean_events_cb		= NULL,
 	.reset_event_recovery_cb	= NULL,
 	.export_events_cb		= NULL,
-	.events_update_itservices_cb	= NULL
+	.events_update_itservices_cb	= NULL,
+	.events_notify_escalators_cb	= NULL
 };
 
 int	get_process_info_by_thread(int local_server_num, unsigned char *local_process_type, int *local_process_num);
@@ -460,6 +487,21 @@ int	get_process_info_by_thread(int local_server_num, unsigned char *local_proces
 		*local_process_type = ZBX_PROCESS_TYPE_ODBCPOLLER;
 		*local_process_num = local_server_num - server_count + CONFIG_FORKS[ZBX_PROCESS_TYPE_ODBCPOLLER];
 	}
+	else if (local_server_num <= (server_count += CONFIG_FORKS[ZBX_PROCESS_TYPE_AGENT_POLLER]))
+	{
+		*local_process_type = ZBX_PROCESS_TYPE_AGENT_POLLER;
+		*local_process_num = local_server_num - server_count + CONFIG_FORKS[ZBX_PROCESS_TYPE_AGENT_POLLER];
+	}
+	else if (local_server_num <= (server_count += CONFIG_FORKS[ZBX_PROCESS_TYPE_SNMP_POLLER]))
+	{
+		*local_process_type = ZBX_PROCESS_TYPE_SNMP_POLLER;
+		*local_process_num = local_server_num - server_count + CONFIG_FORKS[ZBX_PROCESS_TYPE_SNMP_POLLER];
+	}
+	else if (local_server_num <= (server_count += CONFIG_FORKS[ZBX_PROCESS_TYPE_HTTPAGENT_POLLER]))
+	{
+		*local_process_type = ZBX_PROCESS_TYPE_HTTPAGENT_POLLER;
+		*local_process_num = local_server_num - server_count + CONFIG_FORKS[ZBX_PROCESS_TYPE_HTTPAGENT_POLLER];
+	}
 	else
 		return FAIL;
 
@@ -552,6 +594,14 @@ static void	zbx_set_defaults(void)
 
 	if (0 != CONFIG_FORKS[ZBX_PROCESS_TYPE_IPMIPOLLER])
 		CONFIG_FORKS[ZBX_PROCESS_TYPE_IPMIMANAGER] = 1;
+#ifndef HAVE_NETSNMP
+	/* without SNMP support SNMP items are left to regular pollers that report them as not supported */
+	CONFIG_FORKS[ZBX_PROCESS_TYPE_SNMP_POLLER] = 0;
+#endif
+#ifndef HAVE_LIBCURL
+	/* without cURL support HTTP agent items are left to regular pollers that report them as not supported */
+	CONFIG_FORKS[ZBX_PROCESS_TYPE_HTTPAGENT_POLLER] = 0;
+#endif
 
 	if (NULL == zbx_config_vault.url)
 		zbx_config_vault.url = zbx_strdup(zbx_config_vault.url, "https://127.0.0.1:8200");
@@ -594,10 +644,11 @@ static void	zbx_validate_config(ZBX_TASK_EX *task)
 	}
 
 	if (0 == CONFIG_FORKS[ZBX_PROCESS_TYPE_UNREACHABLE] &&
-			0 != CONFIG_FORKS[ZBX_PROCESS_TYPE_POLLER] + CONFIG_FORKS[ZBX_PROCESS_TYPE_JAVAPOLLER])
+			0 != CONFIG_FORKS[ZBX_PROCESS_TYPE_POLLER] + CONFIG_FORKS[ZBX_PROCESS_TYPE_JAVAPOLLER] +
+			CONFIG_FORKS[ZBX_PROCESS_TYPE_AGENT_POLLER] + CONFIG_FORKS[ZBX_PROCESS_TYPE_SNMP_POLLER])
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "\"StartPollersUnreachable\" configuration parameter must not be 0"
-				" if regular or Java pollers are started");
+				" if regular, Java, agent or SNMP pollers are started");
 		err = 1;
 	}
 
@@ -624,6 +675,13 @@ static void	zbx_validate_config(ZBX_TASK_EX *task)
 		err = 1;
 	}
 
+	if (config_histsyncer_min > CONFIG_FORKS[ZBX_PROCESS_TYPE_HISTSYNCER])
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "\"StartDBSyncersMin\" configuration parameter must not be greater"
+				" than \"StartDBSyncers\"");
+		err = 1;
+	}
+
 	if (NULL != CONFIG_SOURCE_IP && SUCCEED != zbx_is_supported_ip(CONFIG_SOURCE_IP))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "invalid \"SourceIP\" configuration parameter: '%s'", CONFIG_SOURCE_IP);
@@ -658,6 +716,17 @@ static void	zbx_validate_config(ZBX_TASK_EX *task)
 	if (SUCCEED != zbx_validate_log_parameters(task, &log_file_cfg))
 		err = 1;
 
+#if !(defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL))
+	err |= (FAIL == check_cfg_feature_int("TLSSessionCacheSize", 0 != config_tls_session_cache_size,
+			"TLS support"));
+#else
+	if (0 != config_tls_session_cache_size && 128 * ZBX_KIBIBYTE > config_tls_session_cache_size)
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "\"TLSSessionCacheSize\" configuration parameter must be either 0"
+				" or greater than 128KB");
+		err = 1;
+	}
+#endif
 #if !(defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL))
 	err |= (FAIL == check_cfg_feature_str("TLSConnect", zbx_config_tls->connect, "TLS support"));
 	err |= (FAIL == check_cfg_feature_str("TLSAccept", zbx_config_tls->accept, "TLS support"));
@@ -755,6 +824,8 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	0,			0},
 		{"StartDBSyncers",		&CONFIG_FORKS[ZBX_PROCESS_TYPE_HISTSYNCER],		TYPE_INT,
 			PARM_OPT,	1,			100},
+		{"StartDBSyncersMin",		&config_histsyncer_min,			TYPE_INT,
+			PARM_OPT,	0,			100},
 		{"StartDiscoverers",		&CONFIG_FORKS[ZBX_PROCESS_TYPE_DISCOVERER],		TYPE_INT,
 			PARM_OPT,	0,			250},
 		{"StartHTTPPollers",		&CONFIG_FORKS[ZBX_PROCESS_TYPE_HTTPPOLLER],		TYPE_INT,
@@ -777,6 +848,8 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	1024,			32767},
 		{"SNMPTrapperFile",		&CONFIG_SNMPTRAP_FILE,			TYPE_STRING,
 			PARM_OPT,	0,			0},
+		{"SNMPTrapperSocket",		&CONFIG_SNMPTRAP_SOCKET,		TYPE_STRING,
+			PARM_OPT,	0,			0},
 		{"StartSNMPTrapper",		&CONFIG_FORKS[ZBX_PROCESS_TYPE_SNMPTRAPPER],		TYPE_INT,
 			PARM_OPT,	0,			1},
 		{"CacheSize",			&config_conf_cache_size,		TYPE_UINT64,
@@ -785,12 +858,26 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	128 * ZBX_KIBIBYTE,	__UINT64_C(2) * ZBX_GIBIBYTE},
 		{"HistoryIndexCacheSize",	&config_history_index_cache_size,	TYPE_UINT64,
 			PARM_OPT,	128 * ZBX_KIBIBYTE,	__UINT64_C(2) * ZBX_GIBIBYTE},
+		{"HistoryCacheShards",		&config_history_cache_shards,		TYPE_INT,
+			PARM_OPT,	1,			ZBX_HC_SHARDS_MAX},
+		{"HistoryIngestRingSize",	&config_history_ingest_ring_size,	TYPE_UINT64,
+			PARM_OPT,	0,			__UINT64_C(64) * ZBX_MEBIBYTE},
+		{"SharedMemoryHugePages",	&config_shmem_huge_pages,		TYPE_INT,
+			PARM_OPT,	0,			1},
 		{"HousekeepingFrequency",	&config_housekeeping_frequency,		TYPE_INT,
 			PARM_OPT,	0,			24},
+		{"AvailabilityFlushDelay",	&config_availability_flush_delay,	TYPE_INT,
+			PARM_OPT,	1,			60},
 		{"ProxyLocalBuffer",		&config_proxy_local_buffer,		TYPE_INT,
 			PARM_OPT,	0,			720},
 		{"ProxyOfflineBuffer",		&config_proxy_offline_buffer,		TYPE_INT,
 			PARM_OPT,	1,			720},
+		{"ProxyBufferMode",		&config_proxy_buffer_mode,		TYPE_STRING,
+			PARM_OPT,	0,			0},
+		{"ProxyMemoryBufferSize",	&config_proxy_memory_buffer_size,	TYPE_UINT64,
+			PARM_OPT,	0,			__UINT64_C(2) * ZBX_GIBIBYTE},
+		{"ProxyMemoryBufferAge",	&config_proxy_memory_buffer_age,	TYPE_INT,
+			PARM_OPT,	0,			SEC_PER_DAY * 10},
 		{"HeartbeatFrequency",		&CONFIG_HEARTBEAT_FREQUENCY,		TYPE_INT,
 			PARM_OPT,	0,			ZBX_PROXY_HEARTBEAT_FREQUENCY_MAX},
 		{"ConfigFrequency",		&CONFIG_CONFSYNCER_FREQUENCY,		TYPE_INT,
@@ -799,16 +886,22 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	1,			SEC_PER_WEEK},
 		{"DataSenderFrequency",		&config_proxydata_frequency,		TYPE_INT,
 			PARM_OPT,	1,			SEC_PER_HOUR},
+		{"DataSenderConnections",	&config_datasender_connections,		TYPE_INT,
+			PARM_OPT,	1,			16},
 		{"TmpDir",			&CONFIG_TMPDIR,				TYPE_STRING,
 			PARM_OPT,	0,			0},
 		{"FpingLocation",		&CONFIG_FPING_LOCATION,			TYPE_STRING,
 			PARM_OPT,	0,			0},
 		{"Fping6Location",		&CONFIG_FPING6_LOCATION,		TYPE_STRING,
 			PARM_OPT,	0,			0},
+		{"NativeICMPPing",		&config_native_icmpping,		TYPE_INT,
+			PARM_OPT,	0,			1},
 		{"Timeout",			&zbx_config_timeout,			TYPE_INT,
 			PARM_OPT,	1,			30},
 		{"TrapperTimeout",		&CONFIG_TRAPPER_TIMEOUT,		TYPE_INT,
 			PARM_OPT,	1,			300},
+		{"MaxConcurrentTrapperConnections",	&config_max_concurrent_trapper_connections,	TYPE_INT,
+			PARM_OPT,	0,			10000},
 		{"UnreachablePeriod",		&config_unreachable_period,		TYPE_INT,
 			PARM_OPT,	1,			SEC_PER_HOUR},
 		{"UnreachableDelay",		&config_unreachable_delay,		TYPE_INT,
@@ -873,6 +966,8 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	0,			0},
 		{"DBTLSCipher13",		&(zbx_config_dbhigh->config_db_tls_cipher_13),	TYPE_STRING,
 			PARM_OPT,	0,			0},
+		{"DBPreparedInserts",		&(zbx_config_dbhigh->config_db_prepared_inserts),	TYPE_INT,
+			PARM_OPT,	0,			1},
 		{"SSHKeyLocation",		&CONFIG_SSH_KEY_LOCATION,		TYPE_STRING,
 			PARM_OPT,	0,			0},
 		{"LogSlowQueries",		&config_log_slow_queries,		TYPE_INT,
@@ -933,6 +1028,8 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	0,			0},
 		{"TLSCipherAll",		&(zbx_config_tls->cipher_all),		TYPE_STRING,
 			PARM_OPT,	0,			0},
+		{"TLSSessionCacheSize",		&config_tls_session_cache_size,		TYPE_UINT64,
+			PARM_OPT,	0,			__UINT64_C(2) * ZBX_GIBIBYTE},
 		{"SocketDir",			&CONFIG_SOCKET_PATH,			TYPE_STRING,
 			PARM_OPT,	0,			0},
 		{"EnableRemoteCommands",	&zbx_config_enable_remote_commands,	TYPE_INT,
@@ -947,6 +1044,14 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	0,			INT_MAX},
 		{"StartODBCPollers",		&CONFIG_FORKS[ZBX_PROCESS_TYPE_ODBCPOLLER],		TYPE_INT,
 			PARM_OPT,	0,			1000},
+		{"StartAgentPollers",		&CONFIG_FORKS[ZBX_PROCESS_TYPE_AGENT_POLLER],		TYPE_INT,
+			PARM_OPT,	0,			1000},
+		{"StartSNMPPollers",		&CONFIG_FORKS[ZBX_PROCESS_TYPE_SNMP_POLLER],		TYPE_INT,
+			PARM_OPT,	0,			1000},
+		{"StartHTTPAgentPollers",	&CONFIG_FORKS[ZBX_PROCESS_TYPE_HTTPAGENT_POLLER],	TYPE_INT,
+			PARM_OPT,	0,			1000},
+		{"MaxConcurrentChecksPerPoller",	&config_max_concurrent_checks_per_poller,	TYPE_INT,
+			PARM_OPT,	1,			1000},
 		{NULL}
 	};
 
@@ -1031,7 +1136,11 @@ static void	zbx_on_exit(int ret)
 	zbx_vmware_destroy();
 
 	zbx_free_selfmon_collector();
+	zbx_prof_probes_destroy();
 	free_proxy_history_lock();
+#if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
+	zbx_tls_session_cache_destroy();
+#endif
 
 	zbx_unload_modules();
 
@@ -1063,7 +1172,8 @@ int	main(int argc, char **argv)
 #ifdef HAVE_IPV6
 		get_fping6_location,
 #endif
-		get_tmpdir};
+		get_tmpdir,
+		get_native_icmpping};
 
 	ZBX_TASK_EX			t = {ZBX_TASK_START};
 	char				ch;
@@ -1158,7 +1268,7 @@ int	main(int argc, char **argv)
 			get_zbx_config_log_remote_commands, get_zbx_config_unsafe_user_parameters);
 	zbx_init_library_stats(get_program_type);
 	zbx_init_library_dbhigh(zbx_config_dbhigh);
-	zbx_init_library_preproc(preproc_flush_value_proxy);
+	zbx_init_library_preproc(preproc_flush_value_proxy, NULL);
 
 	if (ZBX_TASK_RUNTIME_CONTROL == t.task)
 	{
@@ -1274,14 +1384,15 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 								config_proxymode, zbx_config_timeout};
 	zbx_thread_args_t			thread_args;
 	zbx_thread_poller_args			poller_args = {&config_comms, get_program_type, ZBX_NO_POLLER,
-								config_startup_time, config_unavailable_delay, 0, 0};
+								config_startup_time, config_unavailable_delay, 0, 0,
+								config_max_concurrent_checks_per_poller};
 	zbx_thread_proxyconfig_args		proxyconfig_args = {zbx_config_tls, &zbx_config_vault,
 								get_program_type, zbx_config_timeout,
 								&config_server_addrs, CONFIG_HOSTNAME, CONFIG_SOURCE_IP,
 								config_proxyconfig_frequency};
 	zbx_thread_datasender_args		datasender_args = {zbx_config_tls, get_program_type, zbx_config_timeout,
 								&config_server_addrs, CONFIG_SOURCE_IP, CONFIG_HOSTNAME,
-								config_proxydata_frequency};
+								config_proxydata_frequency, config_datasender_connections};
 	zbx_thread_taskmanager_args		taskmanager_args = {&config_comms, get_program_type,
 								config_startup_time, zbx_config_enable_remote_commands,
 								zbx_config_log_remote_commands};
@@ -1289,7 +1400,8 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 								&events_cbs};
 	zbx_thread_trapper_args			trapper_args = {&config_comms, &zbx_config_vault, get_program_type,
 								&events_cbs, &listen_sock, config_startup_time,
-								config_proxydata_frequency};
+								config_proxydata_frequency,
+								config_max_concurrent_trapper_connections};
 	zbx_thread_proxy_housekeeper_args	housekeeper_args = {zbx_config_timeout, config_housekeeping_frequency,
 								config_proxy_local_buffer, config_proxy_offline_buffer};
 	zbx_thread_pinger_args			pinger_args = {zbx_config_timeout};
@@ -1298,7 +1410,9 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 #endif
 	zbx_thread_pp_manager_args		preproc_man_args = {
 							.workers_num = CONFIG_FORKS[ZBX_PROCESS_TYPE_PREPROCESSOR]};
-	zbx_thread_dbsyncer_args		dbsyncer_args = {&events_cbs, config_histsyncer_frequency};
+	zbx_thread_avail_manager_args		avail_manager_args = {config_availability_flush_delay};
+	zbx_thread_dbsyncer_args		dbsyncer_args = {&events_cbs, config_histsyncer_frequency,
+			CONFIG_FORKS[ZBX_PROCESS_TYPE_HISTSYNCER], config_histsyncer_min};
 
 	zbx_rtc_process_request_ex_func_t	rtc_process_request_func = NULL;
 
@@ -1403,6 +1517,8 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 
 	zbx_free_config();
 
+	zbx_shmem_set_huge_pages(config_shmem_huge_pages);
+
 	if (SUCCEED != zbx_rtc_init(&rtc, &error))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize runtime control service: %s", error);
@@ -1411,7 +1527,8 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 	}
 
 	if (SUCCEED != zbx_init_database_cache(get_program_type, config_history_cache_size,
-			config_history_index_cache_size, config_trends_cache_size,&error))
+			config_history_index_cache_size, config_trends_cache_size,
+			config_history_cache_shards, &error))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize database cache: %s", error);
 		zbx_free(error);
@@ -1439,6 +1556,13 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 		exit(EXIT_FAILURE);
 	}
 
+	if (SUCCEED != zbx_prof_probes_init(&error))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize profiling probes: %s", error);
+		zbx_free(error);
+		exit(EXIT_FAILURE);
+	}
+
 	if (0 != CONFIG_FORKS[ZBX_PROCESS_TYPE_VMWARE] && SUCCEED != zbx_vmware_init(&error))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize VMware cache: %s", error);
@@ -1481,6 +1605,30 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 		threads_num += CONFIG_FORKS[i];
 	}
 
+	if (SUCCEED != zbx_init_history_ingest(config_history_ingest_ring_size, threads_num, &error))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize history ingestion rings: %s", error);
+		zbx_free(error);
+		exit(EXIT_FAILURE);
+	}
+
+	if (SUCCEED != zbx_init_proxy_buffer(config_proxy_buffer_mode, config_proxy_memory_buffer_size,
+			config_proxy_memory_buffer_age, &error))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize proxy buffer: %s", error);
+		zbx_free(error);
+		exit(EXIT_FAILURE);
+	}
+#if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
+	if (0 != config_tls_session_cache_size && SUCCEED != zbx_tls_session_cache_init(
+			config_tls_session_cache_size, &error))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize TLS session cache: %s", error);
+		zbx_free(error);
+		exit(EXIT_FAILURE);
+	}
+#endif
+
 	threads = (pid_t *)zbx_calloc(threads, (size_t)threads_num, sizeof(pid_t));
 	threads_flags = (int *)zbx_calloc(threads_flags, (size_t)threads_num, sizeof(int));
 
@@ -1601,6 +1749,7 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 				break;
 			case ZBX_PROCESS_TYPE_AVAILMAN:
 				threads_flags[i] = ZBX_THREAD_PRIORITY_FIRST;
+				thread_args.args = &avail_manager_args;
 				zbx_thread_start(zbx_availability_manager_thread, &thread_args, &threads[i]);
 				break;
 			case ZBX_PROCESS_TYPE_ODBCPOLLER:
@@ -1608,6 +1757,21 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 				thread_args.args = &poller_args;
 				zbx_thread_start(poller_thread, &thread_args, &threads[i]);
 				break;
+			case ZBX_PROCESS_TYPE_AGENT_POLLER:
+				poller_args.poller_type = ZBX_POLLER_TYPE_AGENT;
+				thread_args.args = &poller_args;
+				zbx_thread_start(poller_thread, &thread_args, &threads[i]);
+				break;
+			case ZBX_PROCESS_TYPE_SNMP_POLLER:
+				poller_args.poller_type = ZBX_POLLER_TYPE_SNMP;
+				thread_args.args = &poller_args;
+				zbx_thread_start(poller_thread, &thread_args, &threads[i]);
+				break;
+			case ZBX_PROCESS_TYPE_HTTPAGENT_POLLER:
+				poller_args.poller_type = ZBX_POLLER_TYPE_HTTPAGENT;
+				thread_args.args = &poller_args;
+				zbx_thread_start(poller_thread, &thread_args, &threads[i]);
+				break;
 		}
 	}
 
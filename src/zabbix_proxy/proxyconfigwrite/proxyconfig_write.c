@@ -43,7 +43,8 @@
  *    Inserts new rows that were not present in database.
  *
  * 4) proxyconfig_update_rows()
- *    Update changed fields.
+ *    Update changed fields. With PostgreSQL rows having the same set of changed fields are updated
+ *    in bulk with 'update ... from (values ...)' statements.
  *
  * When processing related tables (for example drules, dchecks) the prepare and delete operations are
  * done from child tables to master tables. The insert and update operations are done from master
@@ -823,6 +824,283 @@ static int	proxyconfig_convert_value(const zbx_db_table_t *table, const zbx_db_f
 	return SUCCEED;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: append field value to SQL statement                               *
+ *                                                                            *
+ * Parameters: sql        - [IN/OUT] the SQL statement                        *
+ *             sql_alloc  - [IN/OUT]                                          *
+ *             sql_offset - [IN/OUT]                                          *
+ *             table      - [IN]                                              *
+ *             field      - [IN]                                              *
+ *             buf        - [IN] the value to append                          *
+ *             type       - [IN] the json value type                          *
+ *             error      - [OUT] the error message                           *
+ *                                                                            *
+ * Return value: SUCCEED - the value was appended successfully                *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	proxyconfig_append_value(char **sql, size_t *sql_alloc, size_t *sql_offset,
+		const zbx_db_table_t *table, const zbx_db_field_t *field, const char *buf, zbx_json_type_t type,
+		char **error)
+{
+	char	*value_esc;
+
+	if (ZBX_JSON_TYPE_NULL == type)
+	{
+		zbx_strcpy_alloc(sql, sql_alloc, sql_offset, "null");
+		return SUCCEED;
+	}
+
+	if (SUCCEED != proxyconfig_convert_value(table, field, buf, type, NULL, error))
+		return FAIL;
+
+	switch (field->type)
+	{
+		case ZBX_TYPE_ID:
+		case ZBX_TYPE_UINT:
+		case ZBX_TYPE_FLOAT:
+		case ZBX_TYPE_INT:
+			zbx_strcpy_alloc(sql, sql_alloc, sql_offset, buf);
+			break;
+		case ZBX_TYPE_CHAR:
+		case ZBX_TYPE_TEXT:
+		case ZBX_TYPE_SHORTTEXT:
+		case ZBX_TYPE_LONGTEXT:
+			value_esc = zbx_db_dyn_escape_string_len(buf, field->length);
+			zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "'%s'", value_esc);
+			zbx_free(value_esc);
+			break;
+		default:
+			*error = zbx_dsprintf(*error, "unsupported field type %d in \"%s.%s\"",
+					(int)field->type, table->table, field->name);
+			return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+#if defined(HAVE_POSTGRESQL)
+
+/* maximum number of rows updated by a single bulk update statement */
+#define PROXYCONFIG_UPDATE_BATCH_SIZE	1000
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compare sets of updated fields of two rows                        *
+ *                                                                            *
+ ******************************************************************************/
+static int	proxyconfig_update_fields_compare(const zbx_table_row_t *row1, const zbx_table_row_t *row2)
+{
+	zbx_flags128_t	flags1 = row1->flags, flags2 = row2->flags;
+
+	/* row existence flag does not affect the updated field set */
+	zbx_flags128_clear(&flags1, PROXYCONFIG_ROW_EXISTS);
+	zbx_flags128_clear(&flags2, PROXYCONFIG_ROW_EXISTS);
+
+	ZBX_RETURN_IF_NOT_EQUAL(flags1.blocks[0], flags2.blocks[0]);
+	ZBX_RETURN_IF_NOT_EQUAL(flags1.blocks[1], flags2.blocks[1]);
+
+	return 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: sort update rows by their updated field sets and identifiers      *
+ *                                                                            *
+ ******************************************************************************/
+static int	proxyconfig_update_row_compare(const void *d1, const void *d2)
+{
+	const zbx_table_row_t	*row1 = *(const zbx_table_row_t * const *)d1;
+	const zbx_table_row_t	*row2 = *(const zbx_table_row_t * const *)d2;
+	int			ret;
+
+	if (0 != (ret = proxyconfig_update_fields_compare(row1, row2)))
+		return ret;
+
+	ZBX_RETURN_IF_NOT_EQUAL(row1->recid, row2->recid);
+
+	return 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get SQL type used to cast bulk update values to field type        *
+ *                                                                            *
+ ******************************************************************************/
+static const char	*proxyconfig_field_sql_type(const zbx_db_field_t *field)
+{
+	switch (field->type)
+	{
+		case ZBX_TYPE_ID:
+			return "bigint";
+		case ZBX_TYPE_UINT:
+			return "numeric(20)";
+		case ZBX_TYPE_INT:
+			return "integer";
+		case ZBX_TYPE_FLOAT:
+			return "double precision";
+		default:
+			return "text";
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: start bulk update statement for rows with the same updated fields *
+ *                                                                            *
+ ******************************************************************************/
+static void	proxyconfig_update_bulk_begin(char **sql, size_t *sql_alloc, size_t *sql_offset,
+		const zbx_table_data_t *td, zbx_table_row_t *row)
+{
+	char	delim = ' ';
+	int	j;
+
+	zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "update %s set", td->table->table);
+
+	for (j = 1; j < td->fields.values_num; j++)
+	{
+		const zbx_db_field_t	*field = td->fields.values[j].field;
+
+		if (SUCCEED != zbx_flags128_isset(&row->flags, j))
+			continue;
+
+		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%c%s=cast(v.%s as %s)", delim, field->name,
+				field->name, proxyconfig_field_sql_type(field));
+		delim = ',';
+	}
+
+	zbx_strcpy_alloc(sql, sql_alloc, sql_offset, " from (values ");
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: finish bulk update statement for rows with the same updated       *
+ *          fields                                                            *
+ *                                                                            *
+ ******************************************************************************/
+static void	proxyconfig_update_bulk_end(char **sql, size_t *sql_alloc, size_t *sql_offset,
+		const zbx_table_data_t *td, zbx_table_row_t *row)
+{
+	int	j;
+
+	zbx_snprintf_alloc(sql, sql_alloc, sql_offset, ") as v(%s", td->table->recid);
+
+	for (j = 1; j < td->fields.values_num; j++)
+	{
+		if (SUCCEED == zbx_flags128_isset(&row->flags, j))
+			zbx_snprintf_alloc(sql, sql_alloc, sql_offset, ",%s", td->fields.values[j].field->name);
+	}
+
+	zbx_snprintf_alloc(sql, sql_alloc, sql_offset, ") where %s.%s=v.%s;\n", td->table->table, td->table->recid,
+			td->table->recid);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: update existing rows with new field values                        *
+ *                                                                            *
+ * Parameters: td    - [IN] the table data object                             *
+ *             error - [OUT] the error message                                *
+ *                                                                            *
+ * Return value: SUCCEED - the rows were updated successfully                 *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Rows having the same set of changed fields are updated with      *
+ *           a single 'update ... from (values ...)' statement instead of     *
+ *           a statement per row.                                             *
+ *                                                                            *
+ ******************************************************************************/
+static int	proxyconfig_update_rows(zbx_table_data_t *td, char **error)
+{
+	char				*sql = NULL, *buf;
+	size_t				sql_alloc = 0, sql_offset = 0, buf_alloc = ZBX_KIBIBYTE;
+	int				i, j, rows_num = 0, ret = FAIL;
+	zbx_vector_table_row_ptr_t	rows;
+	zbx_table_row_t			*group = NULL;
+
+	if (0 == td->updates.values_num)
+		return SUCCEED;
+
+	zbx_vector_table_row_ptr_create(&rows);
+	zbx_vector_table_row_ptr_append_array(&rows, td->updates.values, td->updates.values_num);
+	zbx_vector_table_row_ptr_sort(&rows, proxyconfig_update_row_compare);
+
+	buf = (char *)zbx_malloc(NULL, buf_alloc);
+
+	zbx_db_begin_multiple_update(&sql, &sql_alloc, &sql_offset);
+
+	for (i = 0; i < rows.values_num; i++)
+	{
+		const char	*pf;
+		zbx_table_row_t	*row = rows.values[i];
+		zbx_json_type_t	type;
+
+		if (NULL != group && (0 != proxyconfig_update_fields_compare(group, row) ||
+				PROXYCONFIG_UPDATE_BATCH_SIZE == rows_num))
+		{
+			proxyconfig_update_bulk_end(&sql, &sql_alloc, &sql_offset, td, group);
+			group = NULL;
+
+			if (SUCCEED != zbx_db_execute_overflowed_sql(&sql, &sql_alloc, &sql_offset))
+				goto out;
+		}
+
+		if (NULL == group)
+		{
+			proxyconfig_update_bulk_begin(&sql, &sql_alloc, &sql_offset, td, row);
+			group = row;
+			rows_num = 0;
+		}
+		else
+			zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, ',');
+
+		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "(" ZBX_FS_UI64, row->recid);
+
+		pf = zbx_json_next(&row->columns, NULL);
+
+		for (j = 1; NULL != (pf = zbx_json_next_value_dyn(&row->columns, pf, &buf, &buf_alloc, &type)); j++)
+		{
+			if (SUCCEED != zbx_flags128_isset(&row->flags, j))
+				continue;
+
+			zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, ',');
+
+			if (SUCCEED != proxyconfig_append_value(&sql, &sql_alloc, &sql_offset, td->table,
+					td->fields.values[j].field, buf, type, error))
+			{
+				goto out;
+			}
+		}
+
+		zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, ')');
+		rows_num++;
+	}
+
+	proxyconfig_update_bulk_end(&sql, &sql_alloc, &sql_offset, td, group);
+
+	zbx_db_end_multiple_update(&sql, &sql_alloc, &sql_offset);
+
+	if (16 < sql_offset && ZBX_DB_OK > zbx_db_execute("%s", sql))
+		goto out;
+
+	ret = SUCCEED;
+out:
+	zbx_free(sql);
+	zbx_free(buf);
+	zbx_vector_table_row_ptr_destroy(&rows);
+
+	if (SUCCEED != ret && NULL == *error)
+		*error = zbx_dsprintf(NULL, "cannot update rows in table \"%s\"", td->table->table);
+
+	return ret;
+}
+
+#undef PROXYCONFIG_UPDATE_BATCH_SIZE
+
+#else
+
 /******************************************************************************
  *                                                                            *
  * Purpose: update existing rows with new field values                        *
@@ -861,7 +1139,6 @@ static int	proxyconfig_update_rows(zbx_table_data_t *td, char **error)
 		for (j = 1; NULL != (pf = zbx_json_next_value_dyn(&row->columns, pf, &buf, &buf_alloc, &type)); j++)
 		{
 			const zbx_db_field_t	*field = td->fields.values[j].field;
-			char			*value_esc;
 
 			if (SUCCEED != zbx_flags128_isset(&row->flags, j))
 				continue;
@@ -869,35 +1146,10 @@ static int	proxyconfig_update_rows(zbx_table_data_t *td, char **error)
 			zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "%c%s=", delim, field->name);
 			delim = ',';
 
-			if (ZBX_JSON_TYPE_NULL == type)
+			if (SUCCEED != proxyconfig_append_value(&sql, &sql_alloc, &sql_offset, td->table, field, buf,
+					type, error))
 			{
-				zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, "null");
-				continue;
-			}
-
-			if (SUCCEED != proxyconfig_convert_value(td->table, field, buf, type, NULL, error))
 				goto out;
-
-			switch (field->type)
-			{
-				case ZBX_TYPE_ID:
-				case ZBX_TYPE_UINT:
-				case ZBX_TYPE_FLOAT:
-				case ZBX_TYPE_INT:
-					zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, buf);
-					break;
-				case ZBX_TYPE_CHAR:
-				case ZBX_TYPE_TEXT:
-				case ZBX_TYPE_SHORTTEXT:
-				case ZBX_TYPE_LONGTEXT:
-					value_esc = zbx_db_dyn_escape_string_len(buf, field->length);
-					zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "'%s'", value_esc);
-					zbx_free(value_esc);
-					break;
-				default:
-					*error = zbx_dsprintf(*error, "unsupported field type %d in \"%s.%s\"",
-							(int)field->type, td->table->table, field->name);
-					goto out;
 			}
 		}
 
@@ -924,6 +1176,8 @@ out:
 	return ret;
 }
 
+#endif
+
 ZBX_PTR_VECTOR_DECL(db_value_ptr, zbx_db_value_t *)
 ZBX_PTR_VECTOR_IMPL(db_value_ptr, zbx_db_value_t *)
 
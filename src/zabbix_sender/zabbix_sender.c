@@ -41,11 +41,11 @@ const char	syslog_app_name[] = "zabbix_sender";
 const char	*usage_message[] = {
 	"[-v]", "-z server", "[-p port]", "[-I IP-address]", "[-t timeout]", "-s host", "-k key", "-o value", NULL,
 	"[-v]", "-z server", "[-p port]", "[-I IP-address]", "[-t timeout]", "[-s host]", "[-T]", "[-N]", "[-r]",
-	"-i input-file", NULL,
+	"[--stream]", "-i input-file", NULL,
 	"[-v]", "-c config-file", "[-z server]", "[-p port]", "[-I IP-address]", "[-t timeout]", "[-s host]", "-k key",
 	"-o value", NULL,
 	"[-v]", "-c config-file", "[-z server]", "[-p port]", "[-I IP-address]", "[-t timeout]", "[-s host]", "[-T]",
-	"[-N]", "[-r]", "-i input-file", NULL,
+	"[-N]", "[-r]", "[--stream]", "-i input-file", NULL,
 #if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
 	"[-v]", "-z server", "[-p port]", "[-I IP-address]", "[-t timeout]", "-s host", "--tls-connect cert",
 	"--tls-ca-file CA-file", "[--tls-crl-file CRL-file]", "[--tls-server-cert-issuer cert-issuer]",
@@ -147,6 +147,16 @@ static int	CONFIG_SENDER_TIMEOUT = GET_SENDER_TIMEOUT;
 #define CONFIG_SENDER_TIMEOUT_MIN_STR	ZBX_STR(CONFIG_SENDER_TIMEOUT_MIN)
 #define CONFIG_SENDER_TIMEOUT_MAX_STR	ZBX_STR(CONFIG_SENDER_TIMEOUT_MAX)
 
+#define STREAM_DEPTH_DEFAULT	4
+#define STREAM_DEPTH_MIN	1
+#define STREAM_DEPTH_MAX	64
+#define STREAM_BATCH_DEFAULT	1000
+#define STREAM_BATCH_MIN	1
+#define STREAM_BATCH_MAX	100000
+#define STREAM_LATENCY_DEFAULT	200
+#define STREAM_LATENCY_MIN	1
+#define STREAM_LATENCY_MAX	60000
+
 const char	*help_message[] = {
 	"Utility for sending monitoring data to Zabbix server or proxy.",
 	"",
@@ -200,6 +210,26 @@ const char	*help_message[] = {
 	"                             received. This can be used when reading from",
 	"                             standard input",
 	"",
+	"  --stream                   Keep connections open and send values in",
+	"                             compressed batches without waiting for previous",
+	"                             batches to be acknowledged. Batch is sent when it",
+	"                             is full or its oldest value waits longer than",
+	"                             --stream-latency. This can be used with",
+	"                             --input-file option and a single server or proxy",
+	"",
+	"  --stream-depth connections   Number of batches in flight, each uses its own",
+	"                             connection. Valid range: " ZBX_STR(STREAM_DEPTH_MIN) "-"
+			ZBX_STR(STREAM_DEPTH_MAX) " (default: " ZBX_STR(STREAM_DEPTH_DEFAULT) ")",
+	"",
+	"  --stream-batch values      Maximum number of values in a batch. Valid range:",
+	"                             " ZBX_STR(STREAM_BATCH_MIN) "-" ZBX_STR(STREAM_BATCH_MAX) " (default: "
+			ZBX_STR(STREAM_BATCH_DEFAULT) ")",
+	"",
+	"  --stream-latency ms        Maximum time a value read from standard input",
+	"                             waits for its batch to be sent. Valid range:",
+	"                             " ZBX_STR(STREAM_LATENCY_MIN) "-" ZBX_STR(STREAM_LATENCY_MAX)
+			" milliseconds (default: " ZBX_STR(STREAM_LATENCY_DEFAULT) ")",
+	"",
 	"  -v --verbose               Verbose mode, -vv for more details",
 	"",
 	"  -h --help                  Display this help message",
@@ -309,6 +339,10 @@ static struct zbx_option	longopts[] =
 	{"tls-psk-file",		1,	NULL,	'9'},
 	{"tls-cipher13",		1,	NULL,	'A'},
 	{"tls-cipher",			1,	NULL,	'B'},
+	{"stream",			0,	NULL,	'C'},
+	{"stream-depth",		1,	NULL,	'D'},
+	{"stream-batch",		1,	NULL,	'E'},
+	{"stream-latency",		1,	NULL,	'F'},
 	{NULL}
 };
 
@@ -323,6 +357,10 @@ static char	*INPUT_FILE = NULL;
 static int	WITH_TIMESTAMPS = 0;
 static int	WITH_NS = 0;
 static int	REAL_TIME = 0;
+static int	STREAM = 0;
+static int	STREAM_DEPTH = STREAM_DEPTH_DEFAULT;
+static int	STREAM_BATCH = STREAM_BATCH_DEFAULT;
+static int	STREAM_LATENCY = STREAM_LATENCY_DEFAULT;
 
 char		*CONFIG_SOURCE_IP = NULL;
 static char	*ZABBIX_SERVER = NULL;
@@ -833,6 +871,382 @@ static int	perform_data_sending(zbx_thread_sendval_args *sendval_args, int old_s
 	return ret;
 }
 
+/* In streaming mode values are sent from the main process over persistent */
+/* connections. Each connection carries at most one unacknowledged batch,  */
+/* so the number of connections is the number of batches in flight. Batch   */
+/* is kept until acknowledged to resend it when server has closed the       */
+/* reused connection before the batch could be delivered.                   */
+typedef struct
+{
+	zbx_socket_t	sock;
+	int		connected;
+	int		reused;		/* batch in flight was sent over connection of previous batch */
+	int		values_num;	/* 0 - no batch in flight */
+	char		*data;
+	size_t		data_alloc;
+	size_t		data_len;
+	double		time_sent;
+}
+zbx_stream_conn_t;
+
+typedef struct
+{
+	zbx_stream_conn_t	*conns;
+	int			conns_num;
+	int			next;
+	zbx_uint64_t		batches;
+	zbx_uint64_t		values;
+	double			latency_total;
+	double			latency_max;
+	double			time_start;
+}
+zbx_stream_t;
+
+static void	stream_init(zbx_stream_t *stream, int conns_num)
+{
+	memset(stream, 0, sizeof(zbx_stream_t));
+
+	stream->conns = (zbx_stream_conn_t *)zbx_calloc(NULL, (size_t)conns_num, sizeof(zbx_stream_conn_t));
+	stream->conns_num = conns_num;
+	stream->time_start = zbx_time();
+}
+
+static void	stream_disconnect(zbx_stream_conn_t *conn)
+{
+	if (0 == conn->connected)
+		return;
+
+	zbx_tcp_close(&conn->sock);
+	conn->connected = 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: connect to server or reuse connection that is still open          *
+ *                                                                            *
+ * Parameters: conn - [IN/OUT] streaming connection                           *
+ *                                                                            *
+ * Comments: Server does not send anything without a request, so a readable   *
+ *           connection without batch in flight was closed by the peer.       *
+ *                                                                            *
+ ******************************************************************************/
+static int	stream_connect(zbx_stream_conn_t *conn)
+{
+	conn->reused = 0;
+
+	if (0 != conn->connected)
+	{
+		zbx_pollfd_t	pd;
+
+		pd.fd = conn->sock.socket;
+		pd.events = POLLIN;
+		pd.revents = 0;
+
+		if (0 == zbx_socket_poll(&pd, 1, 0))
+		{
+			conn->reused = 1;
+			return SUCCEED;
+		}
+
+		zabbix_log(LOG_LEVEL_DEBUG, "connection to [%s]:%d was closed by peer",
+				((zbx_addr_t *)destinations[0].addrs.values[0])->ip,
+				((zbx_addr_t *)destinations[0].addrs.values[0])->port);
+
+		stream_disconnect(conn);
+	}
+
+	if (SUCCEED != zbx_connect_to_server(&conn->sock, CONFIG_SOURCE_IP, &destinations[0].addrs,
+			CONFIG_SENDER_TIMEOUT, config_timeout, 0, LOG_LEVEL_DEBUG, zbx_config_tls))
+	{
+		return FAIL;
+	}
+
+	conn->connected = 1;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: send batch of the connection without waiting for response         *
+ *                                                                            *
+ * Parameters: conn - [IN/OUT] streaming connection                           *
+ *                                                                            *
+ ******************************************************************************/
+static int	stream_send(zbx_stream_conn_t *conn)
+{
+	while (SUCCEED == stream_connect(conn))
+	{
+		if (SUCCEED == zbx_tcp_send_ext(&conn->sock, conn->data, conn->data_len, 0,
+				ZBX_TCP_PROTOCOL | ZBX_TCP_COMPRESS, CONFIG_SENDER_TIMEOUT))
+		{
+			conn->time_sent = zbx_time();
+			return SUCCEED;
+		}
+
+		zabbix_log(LOG_LEVEL_DEBUG, "Unable to send to [%s]:%d [%s]",
+				((zbx_addr_t *)destinations[0].addrs.values[0])->ip,
+				((zbx_addr_t *)destinations[0].addrs.values[0])->port, zbx_socket_strerror());
+
+		stream_disconnect(conn);
+
+		/* new connection is tried only if the failed one was open from previous batches */
+		if (0 == conn->reused)
+			break;
+	}
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: wait for response to the batch in flight of the connection        *
+ *                                                                            *
+ * Parameters: stream     - [IN/OUT] streaming state and statistics           *
+ *             conn       - [IN/OUT] streaming connection                     *
+ *             old_status - [IN] previous status                              *
+ *                                                                            *
+ * Return value:  SUCCEED - success with all values                           *
+ *                FAIL - an error occurred                                    *
+ *                SUCCEED_PARTIAL - processing of at least one value failed   *
+ *                                                                            *
+ ******************************************************************************/
+static int	stream_complete(zbx_stream_t *stream, zbx_stream_conn_t *conn, int old_status)
+{
+	int		ret = FAIL;
+	double		latency;
+	zbx_addr_t	*addr;
+
+	if (0 == conn->values_num)
+		return old_status;
+
+	while (SUCCEED != zbx_tcp_recv_to(&conn->sock, CONFIG_SENDER_TIMEOUT))
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "Unable to receive from [%s]:%d [%s]",
+				((zbx_addr_t *)destinations[0].addrs.values[0])->ip,
+				((zbx_addr_t *)destinations[0].addrs.values[0])->port, zbx_socket_strerror());
+
+		stream_disconnect(conn);
+
+		/* server might have closed the reused connection right after the previous response */
+		if (0 == conn->reused || SUCCEED != stream_send(conn))
+			goto out;
+	}
+
+	addr = (zbx_addr_t *)destinations[0].addrs.values[0];
+
+	zabbix_log(LOG_LEVEL_DEBUG, "answer [%s]", conn->sock.buffer);
+
+	if (FAIL == (ret = check_response(conn->sock.buffer, addr->ip, addr->port)))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "incorrect answer from \"%s:%hu\": [%s]", addr->ip, addr->port,
+				conn->sock.buffer);
+		goto out;
+	}
+
+	latency = zbx_time() - conn->time_sent;
+
+	stream->batches++;
+	stream->values += (zbx_uint64_t)conn->values_num;
+	stream->latency_total += latency;
+
+	if (stream->latency_max < latency)
+		stream->latency_max = latency;
+out:
+	conn->values_num = 0;
+
+	if (FAIL == ret)
+	{
+		stream_disconnect(conn);
+		return FAIL;
+	}
+
+	return SUCCEED_PARTIAL == old_status || SUCCEED_PARTIAL == ret ? SUCCEED_PARTIAL : SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: collect responses that have arrived while waiting for input       *
+ *                                                                            *
+ * Parameters: stream  - [IN/OUT] streaming state and statistics              *
+ *             fd      - [IN] input descriptor to wait for, -1 - none         *
+ *             timeout - [IN] maximum time to wait in milliseconds            *
+ *             status  - [IN/OUT] status of acknowledged batches              *
+ *                                                                            *
+ * Return value: 1 - input is available, 0 - timeout, -1 - error              *
+ *                                                                            *
+ * Comments: Responses are collected as soon as they arrive, so the latency   *
+ *           does not include the time connection waits for its next batch.   *
+ *                                                                            *
+ ******************************************************************************/
+static int	stream_poll(zbx_stream_t *stream, int fd, int timeout, int *status)
+{
+	zbx_pollfd_t		pds[STREAM_DEPTH_MAX + 1];
+	zbx_stream_conn_t	*conns[STREAM_DEPTH_MAX + 1];
+	double			deadline = zbx_time() + timeout / 1000.0;
+	int			i, pds_num, ret;
+
+	do
+	{
+		pds_num = 0;
+
+		if (-1 != fd)
+		{
+			pds[pds_num].fd = fd;
+			pds[pds_num].events = POLLIN;
+			pds[pds_num].revents = 0;
+			conns[pds_num++] = NULL;
+		}
+
+		for (i = 0; i < stream->conns_num; i++)
+		{
+			if (0 == stream->conns[i].values_num)
+				continue;
+
+			pds[pds_num].fd = stream->conns[i].sock.socket;
+			pds[pds_num].events = POLLIN;
+			pds[pds_num].revents = 0;
+			conns[pds_num++] = &stream->conns[i];
+		}
+
+		if (0 == pds_num)
+			return 0;
+
+		if (0 >= (ret = zbx_socket_poll(pds, (unsigned long)pds_num, timeout)))
+		{
+			if (-1 == ret)
+				zabbix_log(LOG_LEVEL_WARNING, "poll() failed: %s", zbx_strerror(errno));
+
+			return ret;
+		}
+
+		for (ret = 0, i = 0; i < pds_num; i++)
+		{
+			if (0 == pds[i].revents)
+				continue;
+
+			if (NULL == conns[i])
+				ret = 1;
+			else if (FAIL != *status)
+				*status = stream_complete(stream, conns[i], *status);
+		}
+
+		if (1 == ret || FAIL == *status)
+			return ret;
+	}
+	while (0 < (timeout = (int)((deadline - zbx_time()) * 1000)));
+
+	return 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: send batch over the next connection in turn                       *
+ *                                                                            *
+ * Parameters: stream         - [IN/OUT] streaming state and statistics       *
+ *             json           - [IN] closed batch of values                   *
+ *             values_num     - [IN] number of values in the batch            *
+ *             sync_timestamp - [IN] 1 - add batch send time to the batch     *
+ *             old_status     - [IN] previous status                          *
+ *                                                                            *
+ * Return value:  SUCCEED - success with all acknowledged values              *
+ *                FAIL - an error occurred                                    *
+ *                SUCCEED_PARTIAL - processing of at least one value failed   *
+ *                                                                            *
+ * Comments: Connection can carry the batch only after its previous batch was *
+ *           acknowledged, so this blocks only when all batches are in        *
+ *           flight.                                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	stream_flush(zbx_stream_t *stream, struct zbx_json *json, int values_num, int sync_timestamp,
+		int old_status)
+{
+	zbx_stream_conn_t	*conn = &stream->conns[stream->next];
+	int			ret = old_status;
+
+	stream->next = (stream->next + 1) % stream->conns_num;
+
+	stream_poll(stream, -1, 0, &ret);
+
+	if (FAIL == ret || FAIL == (ret = stream_complete(stream, conn, ret)))
+		return FAIL;
+
+	if (1 == sync_timestamp)
+	{
+		zbx_timespec_t	ts;
+
+		zbx_timespec(&ts);
+
+		zbx_json_adduint64(json, ZBX_PROTO_TAG_CLOCK, ts.sec);
+		zbx_json_adduint64(json, ZBX_PROTO_TAG_NS, ts.ns);
+	}
+
+	if (conn->data_alloc < json->buffer_size)
+	{
+		conn->data_alloc = json->buffer_size;
+		conn->data = (char *)zbx_realloc(conn->data, conn->data_alloc);
+	}
+
+	memcpy(conn->data, json->buffer, json->buffer_size);
+	conn->data_len = json->buffer_size;
+
+	if (SUCCEED != stream_send(conn))
+		return FAIL;
+
+	conn->values_num = values_num;
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: wait for responses to all batches in flight and close connections *
+ *                                                                            *
+ * Parameters: stream     - [IN/OUT] streaming state and statistics           *
+ *             old_status - [IN] previous status                              *
+ *                                                                            *
+ * Return value:  SUCCEED - success with all values                           *
+ *                FAIL - an error occurred                                    *
+ *                SUCCEED_PARTIAL - processing of at least one value failed   *
+ *                                                                            *
+ ******************************************************************************/
+static int	stream_finish(zbx_stream_t *stream, int old_status)
+{
+	int	i, ret = old_status;
+
+	/* batches are acknowledged in the order they were sent */
+	for (i = 0; i < stream->conns_num; i++)
+	{
+		zbx_stream_conn_t	*conn = &stream->conns[(stream->next + i) % stream->conns_num];
+
+		if (FAIL != ret)
+			ret = stream_complete(stream, conn, ret);
+
+		stream_disconnect(conn);
+		zbx_free(conn->data);
+	}
+
+	zbx_free(stream->conns);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: print throughput and latency of acknowledged batches              *
+ *                                                                            *
+ ******************************************************************************/
+static void	stream_print_summary(const zbx_stream_t *stream)
+{
+	double	elapsed = zbx_time() - stream->time_start;
+
+	printf("batches: " ZBX_FS_UI64 "; throughput: " ZBX_FS_DBL " values/sec; latency avg: " ZBX_FS_DBL
+			" sec; max: " ZBX_FS_DBL " sec\n", stream->batches,
+			0 < elapsed ? (double)stream->values / elapsed : 0.0,
+			0 != stream->batches ? stream->latency_total / (double)stream->batches : 0.0,
+			stream->latency_max);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: add server or proxy to the list of destinations                   *
@@ -1079,6 +1493,36 @@ static void	parse_commandline(int argc, char **argv)
 				else if (LOG_LEVEL_DEBUG > CONFIG_LOG_LEVEL)
 					CONFIG_LOG_LEVEL = LOG_LEVEL_DEBUG;
 				break;
+			case 'C':
+				STREAM = 1;
+				break;
+			case 'D':
+				if (FAIL == zbx_is_uint_n_range(zbx_optarg, ZBX_MAX_UINT64_LEN, &STREAM_DEPTH,
+						sizeof(STREAM_DEPTH), STREAM_DEPTH_MIN, STREAM_DEPTH_MAX))
+				{
+					zbx_error("Invalid stream depth, valid range %d:%d", STREAM_DEPTH_MIN,
+							STREAM_DEPTH_MAX);
+					exit(EXIT_FAILURE);
+				}
+				break;
+			case 'E':
+				if (FAIL == zbx_is_uint_n_range(zbx_optarg, ZBX_MAX_UINT64_LEN, &STREAM_BATCH,
+						sizeof(STREAM_BATCH), STREAM_BATCH_MIN, STREAM_BATCH_MAX))
+				{
+					zbx_error("Invalid stream batch size, valid range %d:%d values", STREAM_BATCH_MIN,
+							STREAM_BATCH_MAX);
+					exit(EXIT_FAILURE);
+				}
+				break;
+			case 'F':
+				if (FAIL == zbx_is_uint_n_range(zbx_optarg, ZBX_MAX_UINT64_LEN, &STREAM_LATENCY,
+						sizeof(STREAM_LATENCY), STREAM_LATENCY_MIN, STREAM_LATENCY_MAX))
+				{
+					zbx_error("Invalid stream latency, valid range %d:%d milliseconds",
+							STREAM_LATENCY_MIN, STREAM_LATENCY_MAX);
+					exit(EXIT_FAILURE);
+				}
+				break;
 #if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
 			case '1':
 				zbx_config_tls->connect = zbx_strdup(zbx_config_tls->connect, zbx_optarg);
@@ -1433,6 +1877,20 @@ static void	parse_commandline(int argc, char **argv)
 		exit(EXIT_FAILURE);
 	}
 
+	/* streaming options are not part of the option mask above */
+	if (1 == STREAM && (0 == opt_count['i'] || 0 != opt_count['r']))
+	{
+		zbx_error("option \"--stream\" requires \"-i\" option and cannot be used with \"-r\" option");
+		exit(EXIT_FAILURE);
+	}
+
+	if (0 == STREAM && 0 != opt_count['D'] + opt_count['E'] + opt_count['F'])
+	{
+		zbx_error("options \"--stream-depth\", \"--stream-batch\" and \"--stream-latency\" require"
+				" \"--stream\" option");
+		exit(EXIT_FAILURE);
+	}
+
 	/* Parameters which are not option values are invalid. The check relies on zbx_getopt_internal() which */
 	/* always permutes command line arguments regardless of POSIXLY_CORRECT environment variable. */
 	if (argc > zbx_optind)
@@ -1550,6 +2008,19 @@ int	main(int argc, char **argv)
 	signal(SIGALRM, main_signal_handler);
 	signal(SIGPIPE, main_signal_handler);
 #endif
+	if (1 == STREAM)
+	{
+		if (1 < destinations_count)
+		{
+			zabbix_log(LOG_LEVEL_CRIT, "streaming mode supports a single server or proxy only");
+			goto exit;
+		}
+#if !defined(_WINDOWS)
+		/* connection closed by server is detected by failed send and reopened */
+		signal(SIGPIPE, SIG_IGN);
+#endif
+	}
+
 	if (NULL != zbx_config_tls->connect ||
 			NULL != zbx_config_tls->ca_file ||
 			NULL != zbx_config_tls->crl_file ||
@@ -1597,15 +2068,20 @@ int	main(int argc, char **argv)
 	sendval_args->zbx_get_program_type_cb_arg = get_program_type;
 	zbx_json_init(&sendval_args->json, ZBX_JSON_STAT_BUF_LEN);
 	zbx_json_addstring(&sendval_args->json, ZBX_PROTO_TAG_REQUEST, ZBX_PROTO_VALUE_SENDER_DATA, ZBX_JSON_TYPE_STRING);
+
+	if (1 == STREAM)
+		zbx_json_addint64(&sendval_args->json, ZBX_PROTO_TAG_PERSISTENT, 1);
+
 	zbx_json_addarray(&sendval_args->json, ZBX_PROTO_TAG_DATA);
 
 	if (INPUT_FILE)
 	{
 		FILE	*in;
 		char	*in_line = NULL, *key = NULL, *key_value = NULL;
-		int	buffer_count = 0;
-		size_t	key_alloc = 0, in_line_alloc = MAX_BUFFER_LEN;
-		double	last_send = 0;
+		int		buffer_count = 0, values_max = VALUES_MAX;
+		size_t		key_alloc = 0, in_line_alloc = MAX_BUFFER_LEN;
+		double		last_send = 0, batch_start = 0;
+		zbx_stream_t	stream;
 
 		if (0 == strcmp(INPUT_FILE, "-"))
 		{
@@ -1625,6 +2101,12 @@ int	main(int argc, char **argv)
 		sendval_args->sync_timestamp = WITH_TIMESTAMPS;
 		in_line = (char *)zbx_malloc(NULL, in_line_alloc);
 
+		if (1 == STREAM)
+		{
+			stream_init(&stream, STREAM_DEPTH);
+			values_max = STREAM_BATCH;
+		}
+
 		ret = SUCCEED;
 
 		while (0 == sig_exiting && (SUCCEED == ret || SUCCEED_PARTIAL == ret) &&
@@ -1755,9 +2237,21 @@ int	main(int argc, char **argv)
 			zbx_json_close(&sendval_args->json);
 
 			succeed_count++;
-			buffer_count++;
 
-			if (stdin == in && 1 == REAL_TIME)
+			if (1 == ++buffer_count)
+				batch_start = zbx_time();
+
+			if (stdin == in && 1 == STREAM && values_max != buffer_count)
+			{
+				/* wait for more values as long as the oldest value in the batch allows */
+
+				int	wait = STREAM_LATENCY - (int)((zbx_time() - batch_start) * 1000);
+
+				/* stdin is file descriptor 0 */
+				if (0 < wait && 0 == (read_more = stream_poll(&stream, 0, wait, &ret)) && FAIL == ret)
+					break;
+			}
+			else if (stdin == in && 1 == REAL_TIME)
 			{
 				/* if there is nothing on standard input after 1/5 seconds, we send what we have */
 				/* otherwise, we keep reading, but we should send data at least once per second */
@@ -1784,18 +2278,29 @@ int	main(int argc, char **argv)
 				}
 			}
 
-			if (VALUES_MAX == buffer_count || (stdin == in && 1 == REAL_TIME && 0 >= read_more))
+			if (values_max == buffer_count || (stdin == in && (1 == REAL_TIME || 1 == STREAM) &&
+					0 >= read_more))
 			{
 				zbx_json_close(&sendval_args->json);
 
 				last_send = zbx_time();
 
-				ret = perform_data_sending(sendval_args, ret);
+				if (1 == STREAM)
+				{
+					ret = stream_flush(&stream, &sendval_args->json, buffer_count,
+							sendval_args->sync_timestamp, ret);
+				}
+				else
+					ret = perform_data_sending(sendval_args, ret);
 
 				buffer_count = 0;
 				zbx_json_clean(&sendval_args->json);
 				zbx_json_addstring(&sendval_args->json, ZBX_PROTO_TAG_REQUEST,
 						ZBX_PROTO_VALUE_SENDER_DATA, ZBX_JSON_TYPE_STRING);
+
+				if (1 == STREAM)
+					zbx_json_addint64(&sendval_args->json, ZBX_PROTO_TAG_PERSISTENT, 1);
+
 				zbx_json_addarray(&sendval_args->json, ZBX_PROTO_TAG_DATA);
 			}
 		}
@@ -1803,7 +2308,22 @@ int	main(int argc, char **argv)
 		if (FAIL != ret && 0 != buffer_count)
 		{
 			zbx_json_close(&sendval_args->json);
-			ret = perform_data_sending(sendval_args, ret);
+
+			if (1 == STREAM)
+			{
+				ret = stream_flush(&stream, &sendval_args->json, buffer_count,
+						sendval_args->sync_timestamp, ret);
+			}
+			else
+				ret = perform_data_sending(sendval_args, ret);
+		}
+
+		if (1 == STREAM)
+		{
+			ret = stream_finish(&stream, ret);
+
+			if (FAIL != ret)
+				stream_print_summary(&stream);
 		}
 
 		if (in != stdin)
@@ -3094,10 +3094,12 @@ static void	prepare_actions_conditions_eval(zbx_vector_ptr_t *actions, zbx_hashs
  *             closed_events - [IN] a vector of closed event data -           *
  *                                  (PROBLEM eventid, OK eventid) pairs.      *
  *                                                                            *
+ * Return value: the number of created and recovered escalations              *
+ *                                                                            *
  ******************************************************************************/
-void	process_actions(const zbx_vector_ptr_t *events, const zbx_vector_uint64_pair_t *closed_events)
+int	process_actions(const zbx_vector_ptr_t *events, const zbx_vector_uint64_pair_t *closed_events)
 {
-	int				i;
+	int				i, escalations_num;
 	zbx_vector_ptr_t		actions;
 	zbx_vector_ptr_t 		new_escalations;
 	zbx_vector_uint64_pair_t	rec_escalations;
@@ -3308,10 +3310,14 @@ void	process_actions(const zbx_vector_ptr_t *events, const zbx_vector_uint64_pai
 		zbx_free(sql);
 	}
 
+	escalations_num = new_escalations.values_num + rec_escalations.values_num;
+
 	zbx_vector_uint64_pair_destroy(&rec_escalations);
 	zbx_vector_ptr_destroy(&new_escalations);
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() escalations_num:%d", __func__, escalations_num);
+
+	return escalations_num;
 }
 
 /******************************************************************************
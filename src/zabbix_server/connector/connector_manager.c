@@ -36,14 +36,22 @@
 #define ZBX_CONNECTOR_RESCHEDULE_FALSE	0
 #define ZBX_CONNECTOR_RESCHEDULE_TRUE	1
 
-/* connector worker data */
+/* connector task being delivered by worker */
 typedef struct
 {
-	zbx_ipc_client_t	*client;	/* the connected worker client */
-	zbx_uint64_t		taskid;		/* the current task id (connectorid) */
+	zbx_uint64_t		connectorid;	/* the task connector, 0 if the task slot is free */
 	zbx_vector_uint64_t	ids;
 	int			reschedule;
 }
+zbx_connector_task_t;
+
+/* connector worker data */
+typedef struct
+{
+	zbx_ipc_client_t	*client;	/* the connected worker client */
+	zbx_connector_task_t	tasks[ZBX_CONNECTOR_WORKER_TASKS_MAX];
+	int			tasks_num;	/* the number of tasks being delivered by worker */
+}
 zbx_connector_worker_t;
 
 /* connector manager data */
@@ -125,12 +133,15 @@ static void	connector_init_manager(zbx_connector_manager_t *manager, int worker_
 
 static void	connector_destroy_manager(zbx_connector_manager_t *manager)
 {
-	int	i;
+	int	i, j;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() workers: %d", __func__, manager->worker_count);
 
 	for (i = 0; i < manager->worker_count; i++)
-		zbx_vector_uint64_destroy(&manager->workers[i].ids);
+	{
+		for (j = 0; j < ZBX_CONNECTOR_WORKER_TASKS_MAX; j++)
+			zbx_vector_uint64_destroy(&manager->workers[i].tasks[j].ids);
+	}
 
 	zbx_free(manager->workers);
 	zbx_hashset_destroy(&manager->connectors);
@@ -154,6 +165,7 @@ static void	connector_register_worker(zbx_connector_manager_t *manager, zbx_ipc_
 {
 	zbx_connector_worker_t	*worker = NULL;
 	pid_t			ppid;
+	int			i;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -174,7 +186,9 @@ static void	connector_register_worker(zbx_connector_manager_t *manager, zbx_ipc_
 
 		worker = (zbx_connector_worker_t *)&manager->workers[manager->worker_count++];
 		worker->client = client;
-		zbx_vector_uint64_create(&worker->ids);
+
+		for (i = 0; i < ZBX_CONNECTOR_WORKER_TASKS_MAX; i++)
+			zbx_vector_uint64_create(&worker->tasks[i].ids);
 	}
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
@@ -182,28 +196,50 @@ static void	connector_register_worker(zbx_connector_manager_t *manager, zbx_ipc_
 
 /******************************************************************************
  *                                                                            *
- * Purpose: get worker without active task                                    *
+ * Purpose: get the least loaded worker with free task slot                   *
  *                                                                            *
  * Parameters: manager - [IN] connector manager                               *
  *                                                                            *
  * Return value: pointer to the worker data or NULL if none                   *
  *                                                                            *
+ * Comments: Workers deliver up to ZBX_CONNECTOR_WORKER_TASKS_MAX requests    *
+ *           concurrently, so tasks are spread over workers before filling    *
+ *           task slots of single worker.                                     *
+ *                                                                            *
  ******************************************************************************/
 static zbx_connector_worker_t	*connector_get_free_worker(zbx_connector_manager_t *manager)
 {
-	int	i;
+	int			i;
+	zbx_connector_worker_t	*worker = NULL;
 
 	for (i = 0; i < manager->worker_count; i++)
 	{
-		if (0 == manager->workers[i].ids.values_num)
-			return &manager->workers[i];
+		if (ZBX_CONNECTOR_WORKER_TASKS_MAX == manager->workers[i].tasks_num)
+			continue;
+
+		if (NULL == worker || manager->workers[i].tasks_num < worker->tasks_num)
+			worker = &manager->workers[i];
+	}
+
+	return worker;
+}
+
+static zbx_uint32_t	connector_get_free_task_slot(const zbx_connector_worker_t *worker)
+{
+	zbx_uint32_t	slot;
+
+	for (slot = 0; slot < ZBX_CONNECTOR_WORKER_TASKS_MAX; slot++)
+	{
+		if (0 == worker->tasks[slot].connectorid)
+			break;
 	}
 
-	return NULL;
+	return slot;
 }
 
-static void	connector_get_next_task(zbx_connector_t *connector, zbx_connector_worker_t *worker,
-		unsigned char **data, size_t *data_alloc, size_t *data_offset, int *reschedule, int *processed_num)
+static void	connector_get_next_task(zbx_connector_t *connector, zbx_connector_task_t *task,
+		unsigned char **data, size_t *data_alloc, size_t task_offset, size_t *data_offset, int *reschedule,
+		int *processed_num)
 {
 #define ZBX_DATA_JSON_RESERVED		(ZBX_HISTORY_TEXT_VALUE_LEN * 4 + ZBX_KIBIBYTE * 4)
 #define ZBX_DATA_JSON_RECORD_LIMIT	(ZBX_MAX_RECV_DATA_SIZE - ZBX_DATA_JSON_RESERVED)
@@ -215,7 +251,7 @@ static void	connector_get_next_task(zbx_connector_t *connector, zbx_connector_wo
 	while (ZBX_CONNECTOR_RESCHEDULE_FALSE == *reschedule &&
 			SUCCEED == zbx_list_pop(&connector->data_point_link_queue, (void **)&data_point_link))
 	{
-		if (0 == *data_offset)
+		if (task_offset == *data_offset)
 			zbx_connector_serialize_connector(data, data_alloc, data_offset, connector);
 
 		for (i = 0; i < data_point_link->connector_data_points.values_num; i++, records++)
@@ -260,15 +296,15 @@ static void	connector_get_next_task(zbx_connector_t *connector, zbx_connector_wo
 					zbx_connector_data_point_free);
 		}
 
-		zbx_vector_uint64_append(&worker->ids, data_point_link->objectid);
+		zbx_vector_uint64_append(&task->ids, data_point_link->objectid);
 	}
 
 	*processed_num += records;
 
-	if (0 != worker->ids.values_num)
+	if (0 != task->ids.values_num)
 	{
-		worker->reschedule = *reschedule;
-		worker->taskid = connector->connectorid;
+		task->reschedule = *reschedule;
+		task->connectorid = connector->connectorid;
 	}
 
 #undef ZBX_DATA_JSON_RESERVED
@@ -282,6 +318,9 @@ static void	connector_get_next_task(zbx_connector_t *connector, zbx_connector_wo
  *             now           - [IN] current time                              *
  *             processed_num - [OUT] number of records sent to workers        *
  *                                                                            *
+ * Comments: The number of concurrent requests to connector is limited by its *
+ *           sender window, see connector_add_result().                       *
+ *                                                                            *
  ******************************************************************************/
 static void	connector_assign_tasks(zbx_connector_manager_t *manager, int now, int *processed_num)
 {
@@ -309,15 +348,24 @@ static void	connector_assign_tasks(zbx_connector_manager_t *manager, int now, in
 
 		connector->time_flush = now + ZBX_CONNECTOR_FLUSH_INTERVAL;
 
-		while (connector->senders < connector->max_senders)
+		while (connector->senders < connector->senders_window)
 		{
-			data_offset = 0;
-			int	reschedule;
+			int		reschedule;
+			zbx_uint32_t	slot;
+
+			slot = connector_get_free_task_slot(worker);
+
+			/* requests are prefixed with worker task slot to match the results */
+			if (NULL == data)
+				data = (unsigned char *)zbx_malloc(NULL, (data_alloc = ZBX_KIBIBYTE));
+
+			memcpy(data, &slot, sizeof(slot));
+			data_offset = sizeof(slot);
 
-			connector_get_next_task(connector, worker, &data, &data_alloc, &data_offset, &reschedule,
-					processed_num);
+			connector_get_next_task(connector, &worker->tasks[slot], &data, &data_alloc, data_offset,
+					&data_offset, &reschedule, processed_num);
 
-			if (0 == data_offset)
+			if (sizeof(slot) == data_offset)
 				break;
 
 			if (FAIL == zbx_ipc_client_send(worker->client, ZBX_IPC_CONNECTOR_REQUEST, data,
@@ -328,6 +376,7 @@ static void	connector_assign_tasks(zbx_connector_manager_t *manager, int now, in
 			}
 
 			connector->senders++;
+			worker->tasks_num++;
 
 			if (NULL == (worker = connector_get_free_worker(manager)))
 			{
@@ -419,24 +468,53 @@ static zbx_connector_worker_t	*connector_get_worker_by_client(zbx_connector_mana
 	return worker;
 }
 
-static void	connector_add_result(zbx_connector_manager_t *manager, zbx_ipc_client_t *client, int now)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: processes connector task result received from worker              *
+ *                                                                            *
+ * Parameters: manager - [IN] connector manager                               *
+ *             client  - [IN] connector worker client                         *
+ *             message - [IN] the result message                              *
+ *             now     - [IN] current time                                    *
+ *                                                                            *
+ * Comments: Delivery failures halve the connector sender window and delay    *
+ *           the next flush, while successful deliveries widen the window     *
+ *           back up to the configured number of senders. This way a slow or  *
+ *           failing receiver is not flooded with concurrent requests.        *
+ *                                                                            *
+ ******************************************************************************/
+static void	connector_add_result(zbx_connector_manager_t *manager, zbx_ipc_client_t *client,
+		const zbx_ipc_message_t *message, int now)
 {
 	zbx_connector_worker_t	*worker;
+	zbx_connector_task_t	*task;
 	zbx_connector_t		*connector;
-	int			i;
+	zbx_uint32_t		slot;
+	int			i, status;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
 	worker = connector_get_worker_by_client(manager, client);
 
-	if (NULL != (connector = (zbx_connector_t *)zbx_hashset_search(&manager->connectors, &worker->taskid)))
+	memcpy(&slot, message->data, sizeof(slot));
+	memcpy(&status, message->data + sizeof(slot), sizeof(status));
+
+	if (ZBX_CONNECTOR_WORKER_TASKS_MAX <= slot || 0 == worker->tasks[slot].connectorid)
 	{
-		for (i = 0; i < worker->ids.values_num; i++)
+		THIS_SHOULD_NEVER_HAPPEN;
+		goto out;
+	}
+
+	task = &worker->tasks[slot];
+
+	if (NULL != (connector = (zbx_connector_t *)zbx_hashset_search(&manager->connectors, &task->connectorid)))
+	{
+		for (i = 0; i < task->ids.values_num; i++)
 		{
 			zbx_data_point_link_t	*data_point_link;
 
 			if (NULL == (data_point_link = (zbx_data_point_link_t *)zbx_hashset_search(
-					&connector->data_point_links, &worker->ids.values[i])))
+					&connector->data_point_links, &task->ids.values[i])))
 			{
 				continue;
 			}
@@ -449,11 +527,26 @@ static void	connector_add_result(zbx_connector_manager_t *manager, zbx_ipc_clien
 
 		connector->senders--;
 
-		if (ZBX_CONNECTOR_RESCHEDULE_TRUE == worker->reschedule)
-			connector->time_flush = now;
+		if (SUCCEED != status)
+		{
+			connector->senders_window = MAX(1, connector->senders_window / 2);
+			connector->time_flush = now + ZBX_CONNECTOR_FLUSH_INTERVAL;
+		}
+		else
+		{
+			if (connector->senders_window < connector->max_senders)
+				connector->senders_window++;
+
+			if (ZBX_CONNECTOR_RESCHEDULE_TRUE == task->reschedule)
+				connector->time_flush = now;
+		}
 	}
 
-	zbx_vector_uint64_clear(&worker->ids);
+	zbx_vector_uint64_clear(&task->ids);
+	task->connectorid = 0;
+	worker->tasks_num--;
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
 static	void	connector_get_items_totals(zbx_connector_manager_t *manager, zbx_uint64_t *queued)
@@ -689,7 +782,7 @@ ZBX_THREAD_ENTRY(connector_manager_thread, args)
 					connector_register_worker(&manager, client, message);
 					break;
 				case ZBX_IPC_CONNECTOR_RESULT:
-					connector_add_result(&manager, client, (int)time_now);
+					connector_add_result(&manager, client, message, (int)time_now);
 					break;
 				case ZBX_IPC_CONNECTOR_DIAG_STATS:
 					connector_get_diag_stats(&manager, client);
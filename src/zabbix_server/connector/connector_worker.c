@@ -31,99 +31,323 @@
 #include "zbxjson.h"
 #include "zbxstr.h"
 
+#define ZBX_CONNECTOR_WORKER_WAIT	1000	/* milliseconds to wait for request progress or manager messages */
+
+/* connector request being delivered by worker */
+typedef struct
+{
+	zbx_uint32_t		slot;
+	char			*url;
+	char			*body;
+#ifdef HAVE_LIBCURL
+	zbx_http_context_t	context;
+#endif
+}
+zbx_connector_request_t;
+
 static int	connector_object_compare_func(const void *d1, const void *d2)
 {
 	return zbx_timespec_compare(&((const zbx_connector_data_point_t *)d1)->ts,
 			&((const zbx_connector_data_point_t *)d2)->ts);
 }
 
-static void	worker_process_request(zbx_ipc_socket_t *socket, zbx_ipc_message_t *message,
-		zbx_vector_connector_data_point_t *connector_data_points, zbx_uint64_t *processed_num)
+static void	connector_clear(zbx_connector_t *connector)
+{
+	zbx_free(connector->url);
+	zbx_free(connector->timeout);
+	zbx_free(connector->token);
+	zbx_free(connector->http_proxy);
+	zbx_free(connector->username);
+	zbx_free(connector->password);
+	zbx_free(connector->ssl_cert_file);
+	zbx_free(connector->ssl_key_file);
+	zbx_free(connector->ssl_key_password);
+}
+
+static void	connector_request_free(zbx_connector_request_t *request)
+{
+#ifdef HAVE_LIBCURL
+	zbx_http_context_destroy(&request->context);
+#endif
+	zbx_free(request->url);
+	zbx_free(request->body);
+	zbx_free(request);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reports request delivery result to connector manager              *
+ *                                                                            *
+ * Parameters: socket - [IN] the connector service socket                     *
+ *             slot   - [IN] the worker task slot of the request              *
+ *             status - [IN] SUCCEED - the data was delivered                 *
+ *                           FAIL    - otherwise                              *
+ *                                                                            *
+ * Comments: Failed delivery is reported so the manager can reduce the number *
+ *           of concurrent requests to the connector.                         *
+ *                                                                            *
+ ******************************************************************************/
+static void	worker_send_result(zbx_ipc_socket_t *socket, zbx_uint32_t slot, int status)
 {
-	zbx_connector_t	connector;
-	int		i;
-	char		*str = NULL, *out = NULL, *error = NULL;
-	size_t		str_alloc = 0, str_offset = 0;
+	unsigned char	data[sizeof(zbx_uint32_t) + sizeof(int)];
 
-	zbx_connector_deserialize_connector_and_data_point(message->data, message->size, &connector,
-			connector_data_points);
+	memcpy(data, &slot, sizeof(slot));
+	memcpy(data + sizeof(slot), &status, sizeof(status));
 
-	zbx_vector_connector_data_point_sort(connector_data_points, connector_object_compare_func);
-	for (i = 0; i < connector_data_points->values_num; i++)
+	if (FAIL == zbx_ipc_socket_write(socket, ZBX_IPC_CONNECTOR_RESULT, data, sizeof(data)))
 	{
-		zbx_strcpy_alloc(&str, &str_alloc, &str_offset, connector_data_points->values[i].str);
-		zbx_chrcpy_alloc(&str, &str_alloc, &str_offset, '\n');
+		zabbix_log(LOG_LEVEL_CRIT, "cannot send connector result");
+		exit(EXIT_FAILURE);
 	}
+}
 
-	*processed_num += (zbx_uint64_t)connector_data_points->values_num;
-
-	zbx_vector_connector_data_point_clear_ext(connector_data_points, zbx_connector_data_point_free);
 #ifdef HAVE_LIBCURL
-	char	headers[] = "", posts[] = "", status_codes[] = "200";
-
-	if (SUCCEED != zbx_http_request(HTTP_REQUEST_POST, connector.url, headers, posts,
-			str, ZBX_RETRIEVE_MODE_CONTENT, connector.http_proxy, 0,
-			connector.timeout, connector.max_attempts, connector.ssl_cert_file, connector.ssl_key_file,
-			connector.ssl_key_password, connector.verify_peer, connector.verify_host, connector.authtype,
-			connector.username, connector.password, connector.token, ZBX_POSTTYPE_NDJSON, status_codes,
-			HTTP_STORE_RAW, &out, &error))
+static void	worker_log_error(const char *url, const char *out, const char *error)
+{
+	char	*info = NULL;
+
+	if (NULL != out)
 	{
-		char	*info = NULL;
+		struct zbx_json_parse	jp;
+		size_t			info_alloc = 0;
 
-		if (NULL != out)
+		if (SUCCEED != zbx_json_open(out, &jp))
 		{
-			struct zbx_json_parse	jp;
-			size_t			info_alloc = 0;
-
-			if (SUCCEED != zbx_json_open(out, &jp))
-			{
-				zabbix_log(LOG_LEVEL_WARNING, "cannot retrieve error from \"%s\": %s response: %s",
-						connector.url, zbx_json_strerror(), out);
-			}
-			else
+			zabbix_log(LOG_LEVEL_WARNING, "cannot retrieve error from \"%s\": %s response: %s",
+					url, zbx_json_strerror(), out);
+		}
+		else
+		{
+			if (SUCCEED != zbx_json_value_by_name_dyn(&jp, ZBX_PROTO_TAG_ERROR, &info, &info_alloc, NULL))
 			{
-				if (SUCCEED != zbx_json_value_by_name_dyn(&jp, ZBX_PROTO_TAG_ERROR, &info, &info_alloc,
-					NULL))
-				{
-					zabbix_log(LOG_LEVEL_WARNING, "cannot find error tag in response from \"%s\""
-							" response: %s", connector.url, out);
-					info = NULL;
-				}
+				zabbix_log(LOG_LEVEL_WARNING, "cannot find error tag in response from \"%s\""
+						" response: %s", url, out);
+				info = NULL;
 			}
 		}
+	}
+
+	if (NULL != info)
+		zabbix_log(LOG_LEVEL_WARNING, "cannot send data to \"%s\": %s: %s", url, error, info);
+	else
+		zabbix_log(LOG_LEVEL_WARNING, "cannot send data to \"%s\": %s", url, error);
+
+	zbx_free(info);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: creates multi handle for concurrent delivery of requests          *
+ *                                                                            *
+ * Comments: The multi handle connection cache keeps connections to           *
+ *           connector receivers alive between requests. HTTP/2 requests to   *
+ *           the same receiver are multiplexed over single connection.        *
+ *                                                                            *
+ ******************************************************************************/
+static CURLM	*worker_multi_init(void)
+{
+	CURLM	*multi;
+
+	if (NULL == (multi = curl_multi_init()))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize cURL multi session");
+		exit(EXIT_FAILURE);
+	}
+#if LIBCURL_VERSION_NUM >= 0x072b00
+	/* CURLPIPE_MULTIPLEX is supported starting with version 7.43.0 (0x072b00) */
+	curl_multi_setopt(multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+#endif
+	return multi;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: starts asynchronous delivery of data points received from         *
+ *          connector manager                                                 *
+ *                                                                            *
+ * Parameters: multi     - [IN] the multi handle                              *
+ *             request   - [IN] the request with NDJSON body                  *
+ *             connector - [IN] the connector                                 *
+ *                                                                            *
+ * Return value: SUCCEED - the request was added to multi handle              *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	worker_request_start(CURLM *multi, zbx_connector_request_t *request, const zbx_connector_t *connector)
+{
+	char		query_fields[] = "", headers[] = "", *error = NULL;
+	CURLcode	err;
+	CURLMcode	merr;
+
+	zbx_http_context_create(&request->context);
+
+	if (SUCCEED != zbx_http_request_prepare(&request->context, HTTP_REQUEST_POST, connector->url, query_fields,
+			headers, request->body, ZBX_RETRIEVE_MODE_CONTENT, connector->http_proxy, 0, connector->timeout,
+			connector->max_attempts, connector->ssl_cert_file, connector->ssl_key_file,
+			connector->ssl_key_password, connector->verify_peer, connector->verify_host,
+			connector->authtype, connector->username, connector->password, connector->token,
+			ZBX_POSTTYPE_NDJSON, HTTP_STORE_RAW, &error))
+	{
+		worker_log_error(connector->url, NULL, error);
+		zbx_free(error);
+
+		return FAIL;
+	}
+
+	if (CURLE_OK != (err = curl_easy_setopt(request->context.easyhandle, CURLOPT_PRIVATE, request)))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot send data to \"%s\": cannot set cURL option: %s",
+				connector->url, curl_easy_strerror(err));
+		return FAIL;
+	}
+
+#if LIBCURL_VERSION_NUM >= 0x072f00
+	/* CURL_HTTP_VERSION_2TLS is supported starting with version 7.47.0 (0x072f00) */
+	curl_easy_setopt(request->context.easyhandle, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_2TLS);
+	curl_easy_setopt(request->context.easyhandle, CURLOPT_PIPEWAIT, 1L);
+#endif
+	*request->context.errbuf = '\0';
+
+	if (CURLM_OK != (merr = curl_multi_add_handle(multi, request->context.easyhandle)))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot send data to \"%s\": %s", connector->url,
+				curl_multi_strerror(merr));
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: progresses requests being delivered and reports finished ones     *
+ *          to connector manager                                              *
+ *                                                                            *
+ * Parameters: socket   - [IN] the connector service socket                   *
+ *             multi    - [IN] the multi handle                               *
+ *             requests - [IN/OUT] the requests being delivered               *
+ *                                                                            *
+ ******************************************************************************/
+static void	worker_requests_perform(zbx_ipc_socket_t *socket, CURLM *multi, zbx_vector_ptr_t *requests)
+{
+	int			running, msgnum, i;
+	CURLMsg			*msg;
+	CURLMcode		merr;
+
+	if (CURLM_OK != (merr = curl_multi_perform(multi, &running)))
+		zabbix_log(LOG_LEVEL_WARNING, "cannot perform on cURL multi handle: %s", curl_multi_strerror(merr));
+
+	while (NULL != (msg = curl_multi_info_read(multi, &msgnum)))
+	{
+		zbx_connector_request_t	*request;
+		char			*out = NULL, *error = NULL, status_codes[] = "200";
+		int			status;
 
-		if (NULL != info)
+		if (CURLMSG_DONE != msg->msg)
+			continue;
+
+		if (CURLE_OK != curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char **)&request))
 		{
-			zabbix_log(LOG_LEVEL_WARNING, "cannot send data to \"%s\": %s: %s", connector.url,
-					error, info);
+			THIS_SHOULD_NEVER_HAPPEN;
+			continue;
+		}
+
+		curl_multi_remove_handle(multi, msg->easy_handle);
+
+		/* retry transport errors the same way as synchronous requests do */
+		if (CURLE_OK != msg->data.result && 0 < --request->context.max_attempts)
+		{
+			zabbix_log(LOG_LEVEL_INFORMATION, "cannot perform request: %s",
+					'\0' == *request->context.errbuf ? curl_easy_strerror(msg->data.result) :
+					request->context.errbuf);
+
+			request->context.header.offset = 0;
+			request->context.body.offset = 0;
+			*request->context.errbuf = '\0';
+
+			if (CURLM_OK == curl_multi_add_handle(multi, msg->easy_handle))
+				continue;
 		}
-		else
-			zabbix_log(LOG_LEVEL_WARNING, "cannot send data to \"%s\": %s", connector.url, error);
 
-		zbx_free(info);
+		if (SUCCEED != (status = zbx_http_handle_response(&request->context, msg->data.result, status_codes,
+				&out, &error)))
+		{
+			worker_log_error(request->url, out, error);
+			status = FAIL;
+		}
+
+		worker_send_result(socket, request->slot, status);
+
+		if (FAIL != (i = zbx_vector_ptr_search(requests, request, ZBX_DEFAULT_PTR_COMPARE_FUNC)))
+			zbx_vector_ptr_remove_noorder(requests, i);
+
+		connector_request_free(request);
+		zbx_free(out);
+		zbx_free(error);
+	}
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: starts delivery of data points received from connector manager    *
+ *                                                                            *
+ * Parameters: socket                - [IN] the connector service socket      *
+ *             multi                 - [IN] the multi handle                  *
+ *             message               - [IN] the connector request             *
+ *             connector_data_points - [IN] the data point vector to use      *
+ *             requests              - [IN/OUT] the requests being delivered  *
+ *             processed_num         - [IN/OUT] the number of processed       *
+ *                                              data points                   *
+ *                                                                            *
+ ******************************************************************************/
+static void	worker_process_request(zbx_ipc_socket_t *socket, void *multi, zbx_ipc_message_t *message,
+		zbx_vector_connector_data_point_t *connector_data_points, zbx_vector_ptr_t *requests,
+		zbx_uint64_t *processed_num)
+{
+	zbx_connector_t		connector;
+	zbx_connector_request_t	*request;
+	int			i;
+	size_t			str_alloc = 0, str_offset = 0;
+
+	request = (zbx_connector_request_t *)zbx_malloc(NULL, sizeof(zbx_connector_request_t));
+	memset(request, 0, sizeof(zbx_connector_request_t));
+
+	memcpy(&request->slot, message->data, sizeof(request->slot));
+	zbx_connector_deserialize_connector_and_data_point(message->data + sizeof(request->slot),
+			message->size - (zbx_uint32_t)sizeof(request->slot), &connector, connector_data_points);
+
+	zbx_vector_connector_data_point_sort(connector_data_points, connector_object_compare_func);
+	for (i = 0; i < connector_data_points->values_num; i++)
+	{
+		zbx_strcpy_alloc(&request->body, &str_alloc, &str_offset, connector_data_points->values[i].str);
+		zbx_chrcpy_alloc(&request->body, &str_alloc, &str_offset, '\n');
+	}
+
+	*processed_num += (zbx_uint64_t)connector_data_points->values_num;
+
+	zbx_vector_connector_data_point_clear_ext(connector_data_points, zbx_connector_data_point_free);
+
+	request->url = zbx_strdup(NULL, connector.url);
+#ifdef HAVE_LIBCURL
+	if (SUCCEED == worker_request_start((CURLM *)multi, request, &connector))
+	{
+		zbx_vector_ptr_append(requests, request);
+		request = NULL;
 	}
 #else
+	ZBX_UNUSED(multi);
+	ZBX_UNUSED(requests);
+
 	zabbix_log(LOG_LEVEL_WARNING, "Support for connectors was not compiled in: missing cURL library");
 #endif
-	zbx_free(str);
-	zbx_free(error);
-	zbx_free(out);
-
-	zbx_free(connector.url);
-	zbx_free(connector.timeout);
-	zbx_free(connector.token);
-	zbx_free(connector.http_proxy);
-	zbx_free(connector.username);
-	zbx_free(connector.password);
-	zbx_free(connector.ssl_cert_file);
-	zbx_free(connector.ssl_key_file);
-	zbx_free(connector.ssl_key_password);
-
-	if (FAIL == zbx_ipc_socket_write(socket, ZBX_IPC_CONNECTOR_RESULT, NULL, 0))
+	if (NULL != request)
 	{
-		zabbix_log(LOG_LEVEL_CRIT, "cannot send preprocessing result");
-		exit(EXIT_FAILURE);
+		worker_send_result(socket, request->slot, FAIL);
+		connector_request_free(request);
 	}
+
+	connector_clear(&connector);
 }
 
 ZBX_THREAD_ENTRY(connector_worker_thread, args)
@@ -141,6 +365,9 @@ ZBX_THREAD_ENTRY(connector_worker_thread, args)
 	unsigned char				process_type = ((zbx_thread_args_t *)args)->info.process_type;
 	zbx_vector_connector_data_point_t	connector_data_points;
 	zbx_uint64_t				processed_num = 0, connections_num = 0;
+	int					i;
+	zbx_vector_ptr_t			requests;
+	void					*multi = NULL;
 
 	zbx_setproctitle("%s #%d starting", get_process_type_string(info->program_type), process_num);
 
@@ -164,7 +391,10 @@ ZBX_THREAD_ENTRY(connector_worker_thread, args)
 	zbx_setproctitle("%s #%d started", get_process_type_string(process_type), process_num);
 
 	zbx_vector_connector_data_point_create(&connector_data_points);
-
+	zbx_vector_ptr_create(&requests);
+#ifdef HAVE_LIBCURL
+	multi = worker_multi_init();
+#endif
 	time_stat = zbx_time();
 
 	for (;;)
@@ -185,7 +415,33 @@ ZBX_THREAD_ENTRY(connector_worker_thread, args)
 			connections_num = 0;
 		}
 
-		zbx_update_selfmon_counter(info, ZBX_PROCESS_STATE_IDLE);
+#ifdef HAVE_LIBCURL
+		/* while requests are being delivered wait for both their progress and new manager messages */
+		if (0 != requests.values_num && socket.rx_buffer_bytes <= socket.rx_buffer_offset)
+		{
+			struct curl_waitfd	waitfd = {.fd = socket.fd, .events = CURL_WAIT_POLLIN};
+			CURLMcode		merr;
+
+			if (CURLM_OK != (merr = curl_multi_wait((CURLM *)multi, &waitfd, 1, ZBX_CONNECTOR_WORKER_WAIT,
+					NULL)))
+			{
+				zabbix_log(LOG_LEVEL_WARNING, "cannot wait on cURL multi handle: %s",
+						curl_multi_strerror(merr));
+			}
+
+			worker_requests_perform(&socket, (CURLM *)multi, &requests);
+
+			if (0 == (waitfd.revents & CURL_WAIT_POLLIN))
+			{
+				if (!ZBX_IS_RUNNING())
+					break;
+
+				continue;
+			}
+		}
+#endif
+		if (0 == requests.values_num)
+			zbx_update_selfmon_counter(info, ZBX_PROCESS_STATE_IDLE);
 
 		if (SUCCEED != zbx_ipc_socket_read(&socket, &message))
 		{
@@ -201,21 +457,40 @@ ZBX_THREAD_ENTRY(connector_worker_thread, args)
 		zbx_update_selfmon_counter(info, ZBX_PROCESS_STATE_BUSY);
 
 		time_read = zbx_time();
-		time_idle += time_read - time_now;
+
+		if (0 == requests.values_num)
+			time_idle += time_read - time_now;
 
 		zbx_update_env(get_process_type_string(process_type), time_read);
 
 		switch (message.code)
 		{
 			case ZBX_IPC_CONNECTOR_REQUEST:
-				worker_process_request(&socket, &message, &connector_data_points, &processed_num);
+				worker_process_request(&socket, multi, &message, &connector_data_points, &requests,
+						&processed_num);
 				connections_num++;
 				break;
 		}
 
 		zbx_ipc_message_clean(&message);
+#ifdef HAVE_LIBCURL
+		worker_requests_perform(&socket, (CURLM *)multi, &requests);
+#endif
 	}
 
+	for (i = 0; i < requests.values_num; i++)
+	{
+		zbx_connector_request_t	*request = (zbx_connector_request_t *)requests.values[i];
+
+#ifdef HAVE_LIBCURL
+		curl_multi_remove_handle((CURLM *)multi, request->context.easyhandle);
+#endif
+		connector_request_free(request);
+	}
+	zbx_vector_ptr_destroy(&requests);
+#ifdef HAVE_LIBCURL
+	curl_multi_cleanup((CURLM *)multi);
+#endif
 	zbx_vector_connector_data_point_destroy(&connector_data_points);
 	exit(EXIT_SUCCESS);
 }
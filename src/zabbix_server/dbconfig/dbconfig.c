@@ -65,7 +65,10 @@ ZBX_THREAD_ENTRY(dbconfig_thread, args)
 
 	sec = zbx_time();
 	zbx_setproctitle("%s [syncing configuration]", get_process_type_string(process_type));
-	zbx_dc_sync_configuration(ZBX_DBSYNC_INIT, ZBX_SYNCED_NEW_CONFIG_NO, NULL, dbconfig_args_in->config_vault,
+
+	/* configuration cache synced on standby node needs only the changes since the last sync */
+	zbx_dc_sync_configuration(0 != dbconfig_args_in->config_cache_synced ? ZBX_DBSYNC_UPDATE : ZBX_DBSYNC_INIT,
+			ZBX_SYNCED_NEW_CONFIG_NO, NULL, dbconfig_args_in->config_vault,
 			dbconfig_args_in->proxyconfig_frequency);
 	zbx_dc_sync_kvs_paths(NULL, dbconfig_args_in->config_vault);
 	zbx_setproctitle("%s [synced configuration in " ZBX_FS_DBL " sec, idle %d sec]",
@@ -139,6 +142,7 @@ ZBX_THREAD_ENTRY(dbconfig_thread, args)
 		}
 		else
 		{
+			zbx_dc_expire_kvs_paths();
 			zbx_dc_sync_kvs_paths(NULL, dbconfig_args_in->config_vault);
 			secrets_reload = 0;
 			zabbix_log(LOG_LEVEL_WARNING, "finished forced reloading of the secrets");
@@ -29,6 +29,7 @@ typedef struct
 	int			config_timeout;
 	int			proxyconfig_frequency;
 	int			proxydata_frequency;
+	int			config_cache_synced;	/* cache was synced on standby node */
 }
 zbx_thread_dbconfig_args;
 
@@ -239,6 +239,30 @@ static void	diag_add_lld_items(struct zbx_json *json, const char *field, const z
 	zbx_json_close(json);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: add lld item processing time top list to output json              *
+ *                                                                            *
+ ******************************************************************************/
+static void	diag_add_lld_times(struct zbx_json *json, const char *field, const zbx_vector_lld_rule_time_t *times)
+{
+	int	i;
+
+	zbx_json_addarray(json, field);
+
+	for (i = 0; i < times->values_num; i++)
+	{
+		zbx_json_addobject(json, NULL);
+		zbx_json_adduint64(json, "itemid", times->values[i].itemid);
+		zbx_json_addint64(json, "values", times->values[i].values_num);
+		zbx_json_addfloat(json, "time", times->values[i].time_last);
+		zbx_json_addfloat(json, "time_max", times->values[i].time_max);
+		zbx_json_close(json);
+	}
+
+	zbx_json_close(json);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: add requested lld manager diagnostic information to json data     *
@@ -314,6 +338,24 @@ static int	diag_add_lld_info(const struct zbx_json_parse *jp, struct zbx_json *j
 					diag_add_lld_items(json, map->name, &items);
 					zbx_vector_uint64_pair_destroy(&items);
 				}
+				else if (0 == strcmp(map->name, "time"))
+				{
+					zbx_vector_lld_rule_time_t	times;
+
+					zbx_vector_lld_rule_time_create(&times);
+
+					time1 = zbx_time();
+					if (FAIL == (ret = zbx_lld_get_top_times(map->value, &times, error)))
+					{
+						zbx_vector_lld_rule_time_destroy(&times);
+						goto out;
+					}
+					time2 = zbx_time();
+					time_total += time2 - time1;
+
+					diag_add_lld_times(json, map->name, &times);
+					zbx_vector_lld_rule_time_destroy(&times);
+				}
 				else
 				{
 					*error = zbx_dsprintf(*error, "Unsupported top field: %s", map->name);
@@ -543,6 +585,13 @@ int	diag_add_section_info(const char *section, const struct zbx_json_parse *jp,
 	}
 	else if (0 == strcmp(section, ZBX_DIAG_CONNECTOR))
 		ret = zbx_diag_add_connector_info(jp, json, error);
+	else if (0 == strcmp(section, ZBX_DIAG_DISCOVERY))
+		ret = zbx_diag_add_discovery_info(jp, json, error);
+	else if (0 == strcmp(section, ZBX_DIAG_PROFILING))
+	{
+		zbx_diag_add_profiling_info(json);
+		ret = SUCCEED;
+	}
 	else
 		*error = zbx_dsprintf(*error, "Unsupported diagnostics section: %s", section);
 
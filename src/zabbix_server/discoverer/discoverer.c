@@ -38,6 +38,7 @@
 extern unsigned char			program_type;
 
 #define ZBX_DISCOVERER_IPRANGE_LIMIT	(1 << 16)
+#define ZBX_DISCOVERER_CHUNK_SIZE	256	/* the number of addresses probed concurrently */
 
 typedef struct
 {
@@ -57,15 +58,48 @@ typedef struct
 }
 DB_DCHECK;
 
+typedef struct
+{
+	char			ip[ZBX_INTERFACE_IP_LEN_MAX];
+	char			dns[ZBX_INTERFACE_DNS_LEN_MAX];
+	int			now;
+	int			status;
+	zbx_vector_ptr_t	services;
+}
+zbx_discoverer_host_t;
+
+static void	discoverer_host_free(zbx_discoverer_host_t *host)
+{
+	zbx_vector_ptr_clear_ext(&host->services, zbx_ptr_free);
+	zbx_vector_ptr_destroy(&host->services);
+	zbx_free(host);
+}
+
+static void	dcheck_free(DB_DCHECK *dcheck)
+{
+	zbx_free(dcheck->ports);
+	zbx_free(dcheck->key_);
+	zbx_free(dcheck->snmp_community);
+	zbx_free(dcheck->snmpv3_securityname);
+	zbx_free(dcheck->snmpv3_authpassphrase);
+	zbx_free(dcheck->snmpv3_privpassphrase);
+	zbx_free(dcheck->snmpv3_contextname);
+	zbx_free(dcheck);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: process new service status                                        *
  *                                                                            *
- * Parameters: service - service info                                         *
+ * Parameters: sql        - [IN/OUT] the multiple statement sql buffer        *
+ *             sql_alloc  - [IN/OUT]                                          *
+ *             sql_offset - [IN/OUT]                                          *
+ *             service    - service info                                      *
  *                                                                            *
  ******************************************************************************/
-static void	proxy_update_service(zbx_uint64_t druleid, zbx_uint64_t dcheckid, const char *ip,
-		const char *dns, int port, int status, const char *value, int now)
+static void	proxy_update_service(char **sql, size_t *sql_alloc, size_t *sql_offset, zbx_uint64_t druleid,
+		zbx_uint64_t dcheckid, const char *ip, const char *dns, int port, int status, const char *value,
+		int now)
 {
 	char	*ip_esc, *dns_esc, *value_esc;
 
@@ -73,9 +107,11 @@ static void	proxy_update_service(zbx_uint64_t druleid, zbx_uint64_t dcheckid, co
 	dns_esc = zbx_db_dyn_escape_field("proxy_dhistory", "dns", dns);
 	value_esc = zbx_db_dyn_escape_field("proxy_dhistory", "value", value);
 
-	zbx_db_execute("insert into proxy_dhistory (clock,druleid,dcheckid,ip,dns,port,value,status)"
-			" values (%d," ZBX_FS_UI64 "," ZBX_FS_UI64 ",'%s','%s',%d,'%s',%d)",
+	zbx_snprintf_alloc(sql, sql_alloc, sql_offset,
+			"insert into proxy_dhistory (clock,druleid,dcheckid,ip,dns,port,value,status)"
+			" values (%d," ZBX_FS_UI64 "," ZBX_FS_UI64 ",'%s','%s',%d,'%s',%d);\n",
 			now, druleid, dcheckid, ip_esc, dns_esc, port, value_esc, status);
+	zbx_db_execute_overflowed_sql(sql, sql_alloc, sql_offset);
 
 	zbx_free(value_esc);
 	zbx_free(dns_esc);
@@ -84,21 +120,26 @@ static void	proxy_update_service(zbx_uint64_t druleid, zbx_uint64_t dcheckid, co
 
 /******************************************************************************
  *                                                                            *
- * Purpose: process new service status                                        *
+ * Purpose: process new host status                                           *
  *                                                                            *
- * Parameters: service - service info                                         *
+ * Parameters: sql        - [IN/OUT] the multiple statement sql buffer        *
+ *             sql_alloc  - [IN/OUT]                                          *
+ *             sql_offset - [IN/OUT]                                          *
+ *             host       - host info                                         *
  *                                                                            *
  ******************************************************************************/
-static void	proxy_update_host(zbx_uint64_t druleid, const char *ip, const char *dns, int status, int now)
+static void	proxy_update_host(char **sql, size_t *sql_alloc, size_t *sql_offset, zbx_uint64_t druleid,
+		const char *ip, const char *dns, int status, int now)
 {
 	char	*ip_esc, *dns_esc;
 
 	ip_esc = zbx_db_dyn_escape_field("proxy_dhistory", "ip", ip);
 	dns_esc = zbx_db_dyn_escape_field("proxy_dhistory", "dns", dns);
 
-	zbx_db_execute("insert into proxy_dhistory (clock,druleid,ip,dns,status)"
-			" values (%d," ZBX_FS_UI64 ",'%s','%s',%d)",
+	zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "insert into proxy_dhistory (clock,druleid,ip,dns,status)"
+			" values (%d," ZBX_FS_UI64 ",'%s','%s',%d);\n",
 			now, druleid, ip_esc, dns_esc, status);
+	zbx_db_execute_overflowed_sql(sql, sql_alloc, sql_offset);
 
 	zbx_free(dns_esc);
 	zbx_free(ip_esc);
@@ -170,7 +211,6 @@ static int	discover_service(const DB_DCHECK *dcheck, char *ip, int port, int con
 		case SVC_SNMPv1:
 		case SVC_SNMPv2c:
 		case SVC_SNMPv3:
-		case SVC_ICMPPING:
 			break;
 		default:
 			ret = FAIL;
@@ -181,9 +221,8 @@ static int	discover_service(const DB_DCHECK *dcheck, char *ip, int port, int con
 	{
 		char		**pvalue;
 		size_t		value_offset = 0;
-		ZBX_FPING_HOST	host;
 		zbx_dc_item_t	item;
-		char		key[MAX_STRING_LEN], error[ZBX_ITEM_ERROR_LEN_MAX];
+		char		key[MAX_STRING_LEN];
 
 		switch (dcheck->type)
 		{
@@ -323,22 +362,6 @@ static int	discover_service(const DB_DCHECK *dcheck, char *ip, int port, int con
 							item.key, result.msg);
 				}
 				break;
-			case SVC_ICMPPING:
-				zbx_alarm_on(config_timeout);
-
-				memset(&host, 0, sizeof(host));
-				host.addr = strdup(ip);
-
-				if (SUCCEED != zbx_ping(&host, 1, 3, 0, 0, 0, dcheck->allow_redirect, error,
-						sizeof(error)) || 0 == host.rcv)
-				{
-					ret = FAIL;
-				}
-
-				zbx_free(host.addr);
-
-				zbx_alarm_off();
-				break;
 			default:
 				break;
 		}
@@ -352,24 +375,183 @@ static int	discover_service(const DB_DCHECK *dcheck, char *ip, int port, int con
 
 /******************************************************************************
  *                                                                            *
- * Purpose: check if service is available and update database                 *
+ * Purpose: check if discovery check type is verified by TCP connection       *
+ *                                                                            *
+ ******************************************************************************/
+static int	discoverer_is_tcp_check(int type)
+{
+	switch (type)
+	{
+		case SVC_SSH:
+		case SVC_LDAP:
+		case SVC_SMTP:
+		case SVC_FTP:
+		case SVC_HTTP:
+		case SVC_POP:
+		case SVC_NNTP:
+		case SVC_IMAP:
+		case SVC_TCP:
+		case SVC_HTTPS:
+		case SVC_TELNET:
+		case SVC_AGENT:
+			return SUCCEED;
+		default:
+			return FAIL;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: try to connect to the same TCP port of multiple hosts             *
+ *          concurrently                                                      *
+ *                                                                            *
+ * Parameters: hosts          - [IN] the hosts to probe                       *
+ *             port           - [IN]                                          *
+ *             config_timeout - [IN]                                          *
+ *             up             - [OUT] 1 - port accepted connection,           *
+ *                                    0 - otherwise                           *
+ *                                                                            *
+ * Comments: Only the hosts with open port are checked further, so closed     *
+ *           and filtered ports of the whole chunk cost a single timeout.     *
  *                                                                            *
  ******************************************************************************/
-static void	process_check(const DB_DCHECK *dcheck, int *host_status, char *ip, int now, zbx_vector_ptr_t *services,
-		int config_timeout)
+static void	discoverer_probe_tcp(const zbx_vector_ptr_t *hosts, unsigned short port, int config_timeout,
+		unsigned char *up)
+{
+	zbx_socket_t	*sockets;
+	zbx_pollfd_t	*pds;
+	int		i, pending = 0;
+	double		deadline;
+
+	sockets = (zbx_socket_t *)zbx_malloc(NULL, sizeof(zbx_socket_t) * (size_t)hosts->values_num);
+	pds = (zbx_pollfd_t *)zbx_malloc(NULL, sizeof(zbx_pollfd_t) * (size_t)hosts->values_num);
+
+	for (i = 0; i < hosts->values_num; i++)
+	{
+		const zbx_discoverer_host_t	*host = (const zbx_discoverer_host_t *)hosts->values[i];
+
+		up[i] = 0;
+		pds[i].events = POLLOUT;
+		pds[i].revents = 0;
+
+		if (SUCCEED != zbx_tcp_connect_start(&sockets[i], CONFIG_SOURCE_IP, host->ip, port, config_timeout))
+		{
+			pds[i].fd = -1;
+			continue;
+		}
+
+		pds[i].fd = sockets[i].socket;
+		pending++;
+	}
+
+	deadline = zbx_time() + config_timeout;
+
+	while (0 < pending)
+	{
+		int	rc, timeout_ms;
+
+		if (0 >= (timeout_ms = (int)((deadline - zbx_time()) * 1000)))
+			break;
+
+		if (-1 == (rc = zbx_socket_poll(pds, (unsigned long)hosts->values_num, timeout_ms)))
+		{
+			if (EINTR == zbx_socket_last_error() && ZBX_IS_RUNNING())
+				continue;
+
+			zabbix_log(LOG_LEVEL_DEBUG, "%s() poll() failed: %s", __func__,
+					strerror_from_system(zbx_socket_last_error()));
+			break;
+		}
+
+		for (i = 0; i < hosts->values_num && 0 < rc; i++)
+		{
+			if (-1 == pds[i].fd || 0 == pds[i].revents)
+				continue;
+
+			rc--;
+
+			if (SUCCEED == zbx_tcp_connect_check(&sockets[i]))
+				up[i] = 1;
+
+			zbx_tcp_close(&sockets[i]);
+			pds[i].fd = -1;
+			pending--;
+		}
+	}
+
+	for (i = 0; i < hosts->values_num; i++)
+	{
+		if (-1 != pds[i].fd)
+			zbx_tcp_close(&sockets[i]);
+	}
+
+	zbx_free(pds);
+	zbx_free(sockets);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: ping multiple hosts with a single ICMP pinger run                 *
+ *                                                                            *
+ * Parameters: hosts          - [IN] the hosts to ping                        *
+ *             allow_redirect - [IN]                                          *
+ *             up             - [OUT] 1 - host replied, 0 - otherwise         *
+ *                                                                            *
+ ******************************************************************************/
+static void	discoverer_probe_icmp(const zbx_vector_ptr_t *hosts, unsigned char allow_redirect, unsigned char *up)
+{
+	ZBX_FPING_HOST	*fping_hosts;
+	char		error[ZBX_ITEM_ERROR_LEN_MAX];
+	int		i, ret;
+
+	fping_hosts = (ZBX_FPING_HOST *)zbx_malloc(NULL, sizeof(ZBX_FPING_HOST) * (size_t)hosts->values_num);
+	memset(fping_hosts, 0, sizeof(ZBX_FPING_HOST) * (size_t)hosts->values_num);
+
+	for (i = 0; i < hosts->values_num; i++)
+		fping_hosts[i].addr = zbx_strdup(NULL, ((const zbx_discoverer_host_t *)hosts->values[i])->ip);
+
+	if (SUCCEED != (ret = zbx_ping(fping_hosts, hosts->values_num, 3, 0, 0, 0, allow_redirect, error,
+			sizeof(error))))
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "%s() cannot ping hosts: %s", __func__, error);
+	}
+
+	for (i = 0; i < hosts->values_num; i++)
+	{
+		up[i] = (SUCCEED == ret && 0 != fping_hosts[i].rcv ? 1 : 0);
+		zbx_free(fping_hosts[i].addr);
+	}
+
+	zbx_free(fping_hosts);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: check if service is available on the chunk of hosts               *
+ *                                                                            *
+ * Parameters: dcheck         - [IN] the discovery check                      *
+ *             hosts          - [IN/OUT] the hosts to check, discovered       *
+ *                                       services are added to hosts          *
+ *             config_timeout - [IN]                                          *
+ *             up             - [IN] the buffer for probing results, not less *
+ *                                   than the number of hosts                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	process_check(const DB_DCHECK *dcheck, zbx_vector_ptr_t *hosts, int config_timeout,
+		unsigned char *up)
 {
 	const char	*start;
 	char		*value = NULL;
 	size_t		value_alloc = 128;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() hosts:%d", __func__, hosts->values_num);
 
 	value = (char *)zbx_malloc(value, value_alloc);
 
 	for (start = dcheck->ports; '\0' != *start;)
 	{
 		char	*comma, *last_port;
-		int	port, first, last;
+		int	port, first, last, i;
 
 		if (NULL != (comma = strchr(start, ',')))
 			*comma = '\0';
@@ -386,22 +568,48 @@ static void	process_check(const DB_DCHECK *dcheck, int *host_status, char *ip, i
 
 		for (port = first; port <= last; port++)
 		{
-			zbx_dservice_t	*service;
-
 			zabbix_log(LOG_LEVEL_DEBUG, "%s() port:%d", __func__, port);
 
-			service = (zbx_dservice_t *)zbx_malloc(NULL, sizeof(zbx_dservice_t));
-			service->status = (SUCCEED == discover_service(dcheck, ip, port, config_timeout, &value,
-					&value_alloc) ? DOBJECT_STATUS_UP : DOBJECT_STATUS_DOWN);
-			service->dcheckid = dcheck->dcheckid;
-			service->itemtime = (time_t)now;
-			service->port = port;
-			zbx_strlcpy_utf8(service->value, value, ZBX_MAX_DISCOVERED_VALUE_SIZE);
-			zbx_vector_ptr_append(services, service);
-
-			/* update host status */
-			if (-1 == *host_status || DOBJECT_STATUS_UP == service->status)
-				*host_status = service->status;
+			if (SVC_ICMPPING == dcheck->type)
+				discoverer_probe_icmp(hosts, dcheck->allow_redirect, up);
+			else if (SUCCEED == discoverer_is_tcp_check(dcheck->type))
+				discoverer_probe_tcp(hosts, (unsigned short)port, config_timeout, up);
+			else
+				memset(up, 1, (size_t)hosts->values_num);
+
+			for (i = 0; i < hosts->values_num; i++)
+			{
+				zbx_discoverer_host_t	*host = (zbx_discoverer_host_t *)hosts->values[i];
+				zbx_dservice_t		*service;
+
+				*value = '\0';
+
+				service = (zbx_dservice_t *)zbx_malloc(NULL, sizeof(zbx_dservice_t));
+
+				/* ICMP and plain TCP checks are complete after probing, */
+				/* other services are checked on hosts that responded    */
+				if (0 == up[i])
+					service->status = DOBJECT_STATUS_DOWN;
+				else if (SVC_ICMPPING == dcheck->type || SVC_TCP == dcheck->type)
+					service->status = DOBJECT_STATUS_UP;
+				else if (SUCCEED == discover_service(dcheck, host->ip, port, config_timeout, &value,
+						&value_alloc))
+				{
+					service->status = DOBJECT_STATUS_UP;
+				}
+				else
+					service->status = DOBJECT_STATUS_DOWN;
+
+				service->dcheckid = dcheck->dcheckid;
+				service->itemtime = (time_t)host->now;
+				service->port = port;
+				zbx_strlcpy_utf8(service->value, value, ZBX_MAX_DISCOVERED_VALUE_SIZE);
+				zbx_vector_ptr_append(&host->services, service);
+
+				/* update host status */
+				if (-1 == host->status || DOBJECT_STATUS_UP == service->status)
+					host->status = service->status;
+			}
 		}
 
 		if (NULL != comma)
@@ -417,12 +625,22 @@ static void	process_check(const DB_DCHECK *dcheck, int *host_status, char *ip, i
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
-static void	process_checks(const zbx_db_drule *drule, int *host_status, char *ip, int unique, int now,
-		zbx_vector_ptr_t *services, zbx_vector_uint64_t *dcheckids, int config_timeout)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: load discovery rule checks                                        *
+ *                                                                            *
+ * Parameters: drule     - [IN] the discovery rule                            *
+ *             unique    - [IN] 1 - load only unique check,                   *
+ *                              0 - load other checks                         *
+ *             dchecks   - [OUT] the loaded checks                            *
+ *             dcheckids - [OUT] the loaded check identifiers                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	load_checks(const zbx_db_drule *drule, int unique, zbx_vector_ptr_t *dchecks,
+		zbx_vector_uint64_t *dcheckids)
 {
 	zbx_db_result_t	result;
 	zbx_db_row_t	row;
-	DB_DCHECK	dcheck;
 	char		sql[MAX_STRING_LEN];
 	size_t		offset = 0;
 
@@ -446,86 +664,288 @@ static void	process_checks(const zbx_db_drule *drule, int *host_status, char *ip
 
 	while (NULL != (row = zbx_db_fetch(result)))
 	{
-		memset(&dcheck, 0, sizeof(dcheck));
-
-		ZBX_STR2UINT64(dcheck.dcheckid, row[0]);
-		dcheck.type = atoi(row[1]);
-		dcheck.key_ = row[2];
-		dcheck.snmp_community = row[3];
-		dcheck.snmpv3_securityname = row[4];
-		dcheck.snmpv3_securitylevel = (unsigned char)atoi(row[5]);
-		dcheck.snmpv3_authpassphrase = row[6];
-		dcheck.snmpv3_privpassphrase = row[7];
-		dcheck.snmpv3_authprotocol = (unsigned char)atoi(row[8]);
-		dcheck.snmpv3_privprotocol = (unsigned char)atoi(row[9]);
-		dcheck.ports = row[10];
-		dcheck.snmpv3_contextname = row[11];
-		dcheck.allow_redirect = (unsigned char)atoi(row[12]);
-
-		zbx_vector_uint64_append(dcheckids, dcheck.dcheckid);
-
-		process_check(&dcheck, host_status, ip, now, services, config_timeout);
+		DB_DCHECK	*dcheck;
+
+		dcheck = (DB_DCHECK *)zbx_malloc(NULL, sizeof(DB_DCHECK));
+
+		ZBX_STR2UINT64(dcheck->dcheckid, row[0]);
+		dcheck->type = atoi(row[1]);
+		dcheck->key_ = zbx_strdup(NULL, row[2]);
+		dcheck->snmp_community = zbx_strdup(NULL, row[3]);
+		dcheck->snmpv3_securityname = zbx_strdup(NULL, row[4]);
+		dcheck->snmpv3_securitylevel = (unsigned char)atoi(row[5]);
+		dcheck->snmpv3_authpassphrase = zbx_strdup(NULL, row[6]);
+		dcheck->snmpv3_privpassphrase = zbx_strdup(NULL, row[7]);
+		dcheck->snmpv3_authprotocol = (unsigned char)atoi(row[8]);
+		dcheck->snmpv3_privprotocol = (unsigned char)atoi(row[9]);
+		dcheck->ports = zbx_strdup(NULL, row[10]);
+		dcheck->snmpv3_contextname = zbx_strdup(NULL, row[11]);
+		dcheck->allow_redirect = (unsigned char)atoi(row[12]);
+
+		zbx_vector_ptr_append(dchecks, dcheck);
+		zbx_vector_uint64_append(dcheckids, dcheck->dcheckid);
 	}
 	zbx_db_free_result(result);
 }
 
-static int	process_services(const zbx_db_drule *drule, zbx_db_dhost *dhost, const char *ip, const char *dns,
-		int now, const zbx_vector_ptr_t *services, zbx_vector_uint64_t *dcheckids,
-		zbx_add_event_func_t add_event_cb)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: update discovered services and hosts of the processed chunk in a  *
+ *          single transaction                                                *
+ *                                                                            *
+ * Return value: SUCCEED - the results were saved                             *
+ *               FAIL    - the rule or all its checks were deleted during     *
+ *                         processing                                         *
+ *                                                                            *
+ ******************************************************************************/
+static int	process_services(const zbx_db_drule *drule, const zbx_vector_ptr_t *hosts,
+		const zbx_vector_uint64_t *dcheckids, const zbx_events_funcs_t *events_cbs)
 {
-	int	i, ret;
+	int			i, j, ret = FAIL;
+	zbx_vector_uint64_t	lock_dcheckids;
+	char			*sql = NULL;
+	size_t			sql_alloc = 0, sql_offset = 0;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() hosts:%d", __func__, hosts->values_num);
 
-	zbx_vector_uint64_sort(dcheckids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_create(&lock_dcheckids);
+	zbx_vector_uint64_append_array(&lock_dcheckids, dcheckids->values, dcheckids->values_num);
+	zbx_vector_uint64_sort(&lock_dcheckids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 
-	if (SUCCEED != (ret = zbx_db_lock_ids("dchecks", "dcheckid", dcheckids)))
-		goto fail;
+	zbx_db_begin();
 
-	for (i = 0; i < services->values_num; i++)
+	if (SUCCEED != zbx_db_lock_druleid(drule->druleid))
 	{
-		zbx_dservice_t	*service = (zbx_dservice_t *)services->values[i];
+		zbx_db_rollback();
 
-		if (FAIL == zbx_vector_uint64_bsearch(dcheckids, service->dcheckid, ZBX_DEFAULT_UINT64_COMPARE_FUNC))
-			continue;
+		zabbix_log(LOG_LEVEL_DEBUG, "discovery rule '%s' was deleted during processing, stopping", drule->name);
+		goto out;
+	}
+
+	if (SUCCEED != zbx_db_lock_ids("dchecks", "dcheckid", &lock_dcheckids))
+	{
+		zbx_db_rollback();
+
+		zabbix_log(LOG_LEVEL_DEBUG, "all checks where deleted for discovery rule '%s' during processing,"
+				" stopping", drule->name);
+		goto out;
+	}
+
+	if (0 != (program_type & ZBX_PROGRAM_TYPE_PROXY))
+		zbx_db_begin_multiple_update(&sql, &sql_alloc, &sql_offset);
+
+	for (i = 0; i < hosts->values_num; i++)
+	{
+		const zbx_discoverer_host_t	*host = (const zbx_discoverer_host_t *)hosts->values[i];
+		zbx_db_dhost			dhost;
+
+		memset(&dhost, 0, sizeof(dhost));
+
+		for (j = 0; j < host->services.values_num; j++)
+		{
+			zbx_dservice_t	*service = (zbx_dservice_t *)host->services.values[j];
+
+			if (FAIL == zbx_vector_uint64_bsearch(&lock_dcheckids, service->dcheckid,
+					ZBX_DEFAULT_UINT64_COMPARE_FUNC))
+			{
+				continue;
+			}
+
+			if (0 != (program_type & ZBX_PROGRAM_TYPE_SERVER))
+			{
+				zbx_discovery_update_service(drule, service->dcheckid, &dhost, host->ip, host->dns,
+						service->port, service->status, service->value, host->now,
+						events_cbs->add_event_cb);
+			}
+			else if (0 != (program_type & ZBX_PROGRAM_TYPE_PROXY))
+			{
+				proxy_update_service(&sql, &sql_alloc, &sql_offset, drule->druleid, service->dcheckid,
+						host->ip, host->dns, service->port, service->status, service->value,
+						host->now);
+			}
+		}
 
 		if (0 != (program_type & ZBX_PROGRAM_TYPE_SERVER))
 		{
-			zbx_discovery_update_service(drule, service->dcheckid, dhost, ip, dns, service->port,
-					service->status, service->value, now, add_event_cb);
+			zbx_discovery_update_host(&dhost, host->status, host->now, events_cbs->add_event_cb);
 		}
 		else if (0 != (program_type & ZBX_PROGRAM_TYPE_PROXY))
 		{
-			proxy_update_service(drule->druleid, service->dcheckid, ip, dns, service->port,
-					service->status, service->value, now);
+			proxy_update_host(&sql, &sql_alloc, &sql_offset, drule->druleid, host->ip, host->dns,
+					host->status, host->now);
 		}
 	}
-fail:
+
+	if (0 != (program_type & ZBX_PROGRAM_TYPE_SERVER))
+	{
+		if (NULL != events_cbs->process_events_cb)
+			events_cbs->process_events_cb(NULL, NULL);
+
+		if (NULL != events_cbs->clean_events_cb)
+			events_cbs->clean_events_cb();
+	}
+	else if (0 != (program_type & ZBX_PROGRAM_TYPE_PROXY))
+	{
+		zbx_db_end_multiple_update(&sql, &sql_alloc, &sql_offset);
+
+		if (16 < sql_offset)	/* in ORACLE always present begin..end; */
+			zbx_db_execute("%s", sql);
+	}
+
+	if (ZBX_DB_OK == zbx_db_commit() && NULL != events_cbs->events_notify_escalators_cb)
+		events_cbs->events_notify_escalators_cb();
+
+	ret = SUCCEED;
+out:
+	zbx_free(sql);
+	zbx_vector_uint64_destroy(&lock_dcheckids);
+
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: run all rule checks on the chunk of hosts and save results        *
+ *                                                                            *
+ ******************************************************************************/
+static int	process_hosts(const zbx_db_drule *drule, const zbx_vector_ptr_t *dchecks,
+		const zbx_vector_uint64_t *dcheckids, zbx_vector_ptr_t *hosts, int config_timeout,
+		const zbx_events_funcs_t *events_cbs)
+{
+	unsigned char	*up;
+	int		i;
+
+	up = (unsigned char *)zbx_malloc(NULL, (size_t)hosts->values_num);
+
+	for (i = 0; i < dchecks->values_num; i++)
+		process_check((const DB_DCHECK *)dchecks->values[i], hosts, config_timeout, up);
+
+	zbx_free(up);
+
+	return process_services(drule, hosts, dcheckids, events_cbs);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: parse next IP range of discovery rule                             *
+ *                                                                            *
+ * Parameters: drule   - [IN] the discovery rule                              *
+ *             range   - [IN] the IP range                                    *
+ *             iprange - [OUT] the parsed IP range                            *
+ *             verbose - [IN] 1 - log invalid ranges, 0 - otherwise           *
+ *                                                                            *
+ * Return value: SUCCEED - the IP range can be discovered                     *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	discoverer_iprange_parse(const zbx_db_drule *drule, const char *range, zbx_iprange_t *iprange,
+		int verbose)
+{
+	if (SUCCEED != zbx_iprange_parse(iprange, range))
+	{
+		if (0 != verbose)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "discovery rule \"%s\": wrong format of IP range \"%s\"",
+					drule->name, range);
+		}
+		return FAIL;
+	}
+
+	if (ZBX_DISCOVERER_IPRANGE_LIMIT < zbx_iprange_volume(iprange))
+	{
+		if (0 != verbose)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "discovery rule \"%s\": IP range \"%s\" exceeds %d address limit",
+					drule->name, range, ZBX_DISCOVERER_IPRANGE_LIMIT);
+		}
+		return FAIL;
+	}
+#ifndef HAVE_IPV6
+	if (ZBX_IPRANGE_V6 == iprange->type)
+	{
+		if (0 != verbose)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "discovery rule \"%s\": encountered IP range \"%s\","
+					" but IPv6 support not compiled in", drule->name, range);
+		}
+		return FAIL;
+	}
+#endif
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: count addresses to be checked by discovery rule                   *
+ *                                                                            *
+ ******************************************************************************/
+static int	discoverer_count_addresses(zbx_db_drule *drule)
+{
+	char		*start, *comma;
+	zbx_iprange_t	iprange;
+	int		addresses_num = 0;
+
+	for (start = drule->iprange; '\0' != *start;)
+	{
+		if (NULL != (comma = strchr(start, ',')))
+			*comma = '\0';
+
+		if (SUCCEED == discoverer_iprange_parse(drule, start, &iprange, 0))
+			addresses_num += (int)zbx_iprange_volume(&iprange);
+
+		if (NULL != comma)
+		{
+			*comma = ',';
+			start = comma + 1;
+		}
+		else
+			break;
+	}
+
+	return addresses_num;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: process single discovery rule                                     *
  *                                                                            *
+ * Comments: The addresses are processed in chunks - each check probes all    *
+ *           chunk addresses concurrently and the results of the whole        *
+ *           chunk are saved in a single transaction.                         *
+ *                                                                            *
  ******************************************************************************/
 static void	process_rule(zbx_db_drule *drule, int config_timeout, const zbx_events_funcs_t *events_cbs)
 {
-	zbx_db_dhost		dhost;
-	int			host_status, now;
-	char			ip[ZBX_INTERFACE_IP_LEN_MAX], *start, *comma, dns[ZBX_INTERFACE_DNS_LEN_MAX];
-	int			ipaddress[8];
+	zbx_discoverer_host_t	*host;
+	char			*start, *comma;
+	int			ipaddress[8], addresses_num, processed_num = 0;
 	zbx_iprange_t		iprange;
-	zbx_vector_ptr_t	services;
+	zbx_vector_ptr_t	dchecks, hosts;
 	zbx_vector_uint64_t	dcheckids;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() rule:'%s' range:'%s'", __func__, drule->name, drule->iprange);
 
-	zbx_vector_ptr_create(&services);
+	zbx_vector_ptr_create(&dchecks);
+	zbx_vector_ptr_create(&hosts);
 	zbx_vector_uint64_create(&dcheckids);
 
+	/* the unique check must be processed first */
+	if (0 != drule->unique_dcheckid)
+		load_checks(drule, 1, &dchecks, &dcheckids);
+
+	load_checks(drule, 0, &dchecks, &dcheckids);
+
+	if (0 == dchecks.values_num)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "discovery rule '%s' has no checks", drule->name);
+		goto out;
+	}
+
+	addresses_num = discoverer_count_addresses(drule);
+	zbx_dc_drule_update_progress(drule->druleid, addresses_num, 0);
+
 	for (start = drule->iprange; '\0' != *start;)
 	{
 		if (NULL != (comma = strchr(start, ',')))
@@ -533,105 +953,55 @@ static void	process_rule(zbx_db_drule *drule, int config_timeout, const zbx_even
 
 		zabbix_log(LOG_LEVEL_DEBUG, "%s() range:'%s'", __func__, start);
 
-		if (SUCCEED != zbx_iprange_parse(&iprange, start))
-		{
-			zabbix_log(LOG_LEVEL_WARNING, "discovery rule \"%s\": wrong format of IP range \"%s\"",
-					drule->name, start);
+		if (SUCCEED != discoverer_iprange_parse(drule, start, &iprange, 1))
 			goto next;
-		}
 
-		if (ZBX_DISCOVERER_IPRANGE_LIMIT < zbx_iprange_volume(&iprange))
-		{
-			zabbix_log(LOG_LEVEL_WARNING, "discovery rule \"%s\": IP range \"%s\" exceeds %d address limit",
-					drule->name, start, ZBX_DISCOVERER_IPRANGE_LIMIT);
-			goto next;
-		}
-#ifndef HAVE_IPV6
-		if (ZBX_IPRANGE_V6 == iprange.type)
-		{
-			zabbix_log(LOG_LEVEL_WARNING, "discovery rule \"%s\": encountered IP range \"%s\","
-					" but IPv6 support not compiled in", drule->name, start);
-			goto next;
-		}
-#endif
 		zbx_iprange_first(&iprange, ipaddress);
 
 		do
 		{
+			host = (zbx_discoverer_host_t *)zbx_malloc(NULL, sizeof(zbx_discoverer_host_t));
 #ifdef HAVE_IPV6
 			if (ZBX_IPRANGE_V6 == iprange.type)
 			{
-				zbx_snprintf(ip, sizeof(ip), "%x:%x:%x:%x:%x:%x:%x:%x", (unsigned int)ipaddress[0],
-						(unsigned int)ipaddress[1], (unsigned int)ipaddress[2],
-						(unsigned int)ipaddress[3], (unsigned int)ipaddress[4],
-						(unsigned int)ipaddress[5], (unsigned int)ipaddress[6],
-						(unsigned int)ipaddress[7]);
+				zbx_snprintf(host->ip, sizeof(host->ip), "%x:%x:%x:%x:%x:%x:%x:%x",
+						(unsigned int)ipaddress[0], (unsigned int)ipaddress[1],
+						(unsigned int)ipaddress[2], (unsigned int)ipaddress[3],
+						(unsigned int)ipaddress[4], (unsigned int)ipaddress[5],
+						(unsigned int)ipaddress[6], (unsigned int)ipaddress[7]);
 			}
 			else
 			{
 #endif
-				zbx_snprintf(ip, sizeof(ip), "%u.%u.%u.%u", (unsigned int)ipaddress[0],
+				zbx_snprintf(host->ip, sizeof(host->ip), "%u.%u.%u.%u", (unsigned int)ipaddress[0],
 						(unsigned int)ipaddress[1], (unsigned int)ipaddress[2],
 						(unsigned int)ipaddress[3]);
 #ifdef HAVE_IPV6
 			}
 #endif
-			memset(&dhost, 0, sizeof(dhost));
-			host_status = -1;
+			zabbix_log(LOG_LEVEL_DEBUG, "%s() ip:'%s'", __func__, host->ip);
 
-			now = time(NULL);
-
-			zabbix_log(LOG_LEVEL_DEBUG, "%s() ip:'%s'", __func__, ip);
+			host->status = -1;
+			host->now = (int)time(NULL);
+			zbx_vector_ptr_create(&host->services);
+			zbx_vector_ptr_append(&hosts, host);
 
 			zbx_alarm_on(config_timeout);
-			zbx_gethost_by_ip(ip, dns, sizeof(dns));
+			zbx_gethost_by_ip(host->ip, host->dns, sizeof(host->dns));
 			zbx_alarm_off();
 
-			if (0 != drule->unique_dcheckid)
-				process_checks(drule, &host_status, ip, 1, now, &services, &dcheckids, config_timeout);
-
-			process_checks(drule, &host_status, ip, 0, now, &services, &dcheckids, config_timeout);
+			if (ZBX_DISCOVERER_CHUNK_SIZE > hosts.values_num)
+				continue;
 
-			zbx_db_begin();
-
-			if (SUCCEED != zbx_db_lock_druleid(drule->druleid))
-			{
-				zbx_db_rollback();
-
-				zabbix_log(LOG_LEVEL_DEBUG, "discovery rule '%s' was deleted during processing,"
-						" stopping", drule->name);
-				zbx_vector_ptr_clear_ext(&services, zbx_ptr_free);
+			if (SUCCEED != process_hosts(drule, &dchecks, &dcheckids, &hosts, config_timeout, events_cbs))
 				goto out;
-			}
 
-			if (SUCCEED != process_services(drule, &dhost, ip, dns, now, &services, &dcheckids,
-					events_cbs->add_event_cb))
-			{
-				zbx_db_rollback();
+			processed_num += hosts.values_num;
+			zbx_vector_ptr_clear_ext(&hosts, (zbx_clean_func_t)discoverer_host_free);
+			zbx_dc_drule_update_progress(drule->druleid, addresses_num, processed_num);
 
-				zabbix_log(LOG_LEVEL_DEBUG, "all checks where deleted for discovery rule '%s'"
-						" during processing, stopping", drule->name);
-				zbx_vector_ptr_clear_ext(&services, zbx_ptr_free);
+			if (!ZBX_IS_RUNNING())
 				goto out;
-			}
-
-			zbx_vector_uint64_clear(&dcheckids);
-			zbx_vector_ptr_clear_ext(&services, zbx_ptr_free);
-
-			if (0 != (program_type & ZBX_PROGRAM_TYPE_SERVER))
-			{
-				zbx_discovery_update_host(&dhost, host_status, now, events_cbs->add_event_cb);
-
-				if (NULL != events_cbs->process_events_cb)
-					events_cbs->process_events_cb(NULL, NULL);
-
-				if (NULL != events_cbs->clean_events_cb)
-					events_cbs->clean_events_cb();
-			}
-			else if (0 != (program_type & ZBX_PROGRAM_TYPE_PROXY))
-				proxy_update_host(drule->druleid, ip, dns, host_status, now);
-
-			zbx_db_commit();
 		}
 		while (SUCCEED == zbx_iprange_next(&iprange, ipaddress));
 next:
@@ -643,8 +1013,14 @@ next:
 		else
 			break;
 	}
+
+	if (0 != hosts.values_num)
+		process_hosts(drule, &dchecks, &dcheckids, &hosts, config_timeout, events_cbs);
 out:
-	zbx_vector_ptr_destroy(&services);
+	zbx_vector_ptr_clear_ext(&hosts, (zbx_clean_func_t)discoverer_host_free);
+	zbx_vector_ptr_destroy(&hosts);
+	zbx_vector_ptr_clear_ext(&dchecks, (zbx_clean_func_t)dcheck_free);
+	zbx_vector_ptr_destroy(&dchecks);
 	zbx_vector_uint64_destroy(&dcheckids);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
@@ -37,10 +37,14 @@
 #include "zbx_host_constants.h"
 #include "zbx_trigger_constants.h"
 #include "zbx_item_constants.h"
+#include "zbxrtc.h"
+#include "zbx_rtc_constants.h"
 
 extern int	CONFIG_FORKS[ZBX_PROCESS_TYPE_COUNT];
 
 #define CONFIG_ESCALATOR_FREQUENCY	3
+#define ZBX_ESCALATOR_IDLE_MAX		SEC_PER_MIN	/* not every event source wakes up escalators, */
+								/* so escalations are polled at least this often */
 
 #define ZBX_ESCALATION_SOURCE_DEFAULT	0
 #define ZBX_ESCALATION_SOURCE_ITEM	1
@@ -112,6 +116,39 @@ typedef enum
 }
 zbx_vc_item_update_type_t;
 
+/* User and trigger data used by permission checks is cached for one escalator cycle, */
+/* so notifying many users about escalations of the same triggers does not repeat    */
+/* the same queries for every user and message.                                      */
+typedef struct
+{
+	zbx_uint64_t		userid;
+	zbx_uint64_t		roleid;
+	int			type;
+	char			*timezone;
+	unsigned char		tag_filters_loaded;
+	zbx_vector_ptr_t	tag_filters;
+}
+zbx_esc_user_t;
+
+typedef struct
+{
+	zbx_uint64_t		triggerid;
+	zbx_vector_uint64_t	hostgroupids;
+}
+zbx_esc_trigger_t;
+
+typedef struct
+{
+	/* first - userid, second - triggerid */
+	zbx_uint64_pair_t	ids;
+	int			perm;
+}
+zbx_esc_trigger_perm_t;
+
+static zbx_hashset_t	esc_users;
+static zbx_hashset_t	esc_triggers;
+static zbx_hashset_t	esc_trigger_perms;
+
 static void	zbx_tag_filter_free(zbx_tag_filter_t *tag_filter)
 {
 	zbx_free(tag_filter->tag);
@@ -119,32 +156,108 @@ static void	zbx_tag_filter_free(zbx_tag_filter_t *tag_filter)
 	zbx_free(tag_filter);
 }
 
-static void	add_message_alert(const zbx_db_event *event, const zbx_db_event *r_event, zbx_uint64_t actionid,
-		int esc_step, zbx_uint64_t userid, zbx_uint64_t mediatypeid, const char *subject, const char *message,
-		const zbx_db_acknowledge *ack, const zbx_service_alarm_t *service_alarm, const zbx_db_service *service,
-		int err_type, const char *tz);
+static void	esc_user_clean(void *data)
+{
+	zbx_esc_user_t	*user = (zbx_esc_user_t *)data;
 
-static int	get_user_info(zbx_uint64_t userid, zbx_uint64_t *roleid, char **user_timezone)
+	zbx_free(user->timezone);
+	zbx_vector_ptr_clear_ext(&user->tag_filters, (zbx_clean_func_t)zbx_tag_filter_free);
+	zbx_vector_ptr_destroy(&user->tag_filters);
+}
+
+static void	esc_trigger_clean(void *data)
+{
+	zbx_esc_trigger_t	*trigger = (zbx_esc_trigger_t *)data;
+
+	zbx_vector_uint64_destroy(&trigger->hostgroupids);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: create permission check cache                                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	esc_cache_init(void)
 {
-	int		user_type = -1;
+	zbx_hashset_create_ext(&esc_users, 100, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC,
+			esc_user_clean, ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC,
+			ZBX_DEFAULT_MEM_FREE_FUNC);
+	zbx_hashset_create_ext(&esc_triggers, 100, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC,
+			esc_trigger_clean, ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC,
+			ZBX_DEFAULT_MEM_FREE_FUNC);
+	zbx_hashset_create(&esc_trigger_perms, 100, ZBX_DEFAULT_UINT64_PAIR_HASH_FUNC,
+			ZBX_DEFAULT_UINT64_PAIR_COMPARE_FUNC);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: discard permission check data cached during escalator cycle       *
+ *                                                                            *
+ ******************************************************************************/
+static void	esc_cache_clear(void)
+{
+	zbx_hashset_clear(&esc_users);
+	zbx_hashset_clear(&esc_triggers);
+	zbx_hashset_clear(&esc_trigger_perms);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get cached user, loading it from database if necessary            *
+ *                                                                            *
+ * Parameters: userid - [IN]                                                  *
+ *                                                                            *
+ * Return value: cached user, type -1 if the user was not found               *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_esc_user_t	*esc_get_user(zbx_uint64_t userid)
+{
+	zbx_esc_user_t	*user, user_local;
 	zbx_db_result_t	result;
 	zbx_db_row_t	row;
 
-	*user_timezone = NULL;
+	if (NULL != (user = (zbx_esc_user_t *)zbx_hashset_search(&esc_users, &userid)))
+		return user;
+
+	user_local.userid = userid;
+	user_local.roleid = 0;
+	user_local.type = -1;
+	user_local.timezone = NULL;
+	user_local.tag_filters_loaded = 0;
 
 	result = zbx_db_select("select r.type,u.roleid,u.timezone from users u,role r where u.roleid=r.roleid and"
 			" userid=" ZBX_FS_UI64, userid);
 
 	if (NULL != (row = zbx_db_fetch(result)) && FAIL == zbx_db_is_null(row[0]))
 	{
-		user_type = atoi(row[0]);
-		ZBX_STR2UINT64(*roleid, row[1]);
-		*user_timezone = zbx_strdup(NULL, row[2]);
+		user_local.type = atoi(row[0]);
+		ZBX_STR2UINT64(user_local.roleid, row[1]);
+		user_local.timezone = zbx_strdup(NULL, row[2]);
 	}
 
 	zbx_db_free_result(result);
 
-	return user_type;
+	user = (zbx_esc_user_t *)zbx_hashset_insert(&esc_users, &user_local, sizeof(user_local));
+	zbx_vector_ptr_create(&user->tag_filters);
+
+	return user;
+}
+
+static void	add_message_alert(const zbx_db_event *event, const zbx_db_event *r_event, zbx_uint64_t actionid,
+		int esc_step, zbx_uint64_t userid, zbx_uint64_t mediatypeid, const char *subject, const char *message,
+		const zbx_db_acknowledge *ack, const zbx_service_alarm_t *service_alarm, const zbx_db_service *service,
+		int err_type, const char *tz);
+
+static int	get_user_info(zbx_uint64_t userid, zbx_uint64_t *roleid, char **user_timezone)
+{
+	const zbx_esc_user_t	*user;
+
+	user = esc_get_user(userid);
+
+	*roleid = user->roleid;
+	*user_timezone = (NULL != user->timezone ? zbx_strdup(NULL, user->timezone) : NULL);
+
+	return user->type;
 }
 
 static const char	*permission_string(int perm)
@@ -221,44 +334,48 @@ out:
 static int	check_tag_based_permission(zbx_uint64_t userid, zbx_vector_uint64_t *hostgroupids,
 		const zbx_db_event *event)
 {
-	char			*sql = NULL, hostgroupid[ZBX_MAX_UINT64_LEN + 1];
-	size_t			sql_alloc = 0, sql_offset = 0;
-	zbx_db_result_t		result;
-	zbx_db_row_t		row;
+	char			hostgroupid[ZBX_MAX_UINT64_LEN + 1];
 	int			ret = FAIL, i;
-	zbx_vector_ptr_t	tag_filters;
+	zbx_esc_user_t		*user;
 	zbx_tag_filter_t	*tag_filter;
 	zbx_condition_t		condition;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	zbx_vector_ptr_create(&tag_filters);
-
-	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
-			"select tf.groupid,tf.tag,tf.value from tag_filter tf"
-			" join users_groups ug on ug.usrgrpid=tf.usrgrpid"
-				" where ug.userid=" ZBX_FS_UI64, userid);
-	result = zbx_db_select("%s order by tf.groupid", sql);
+	user = esc_get_user(userid);
 
-	while (NULL != (row = zbx_db_fetch(result)))
+	if (0 == user->tag_filters_loaded)
 	{
-		tag_filter = (zbx_tag_filter_t *)zbx_malloc(NULL, sizeof(zbx_tag_filter_t));
-		ZBX_STR2UINT64(tag_filter->hostgroupid, row[0]);
-		tag_filter->tag = zbx_strdup(NULL, row[1]);
-		tag_filter->value = zbx_strdup(NULL, row[2]);
-		zbx_vector_ptr_append(&tag_filters, tag_filter);
+		zbx_db_result_t	result;
+		zbx_db_row_t	row;
+
+		result = zbx_db_select(
+				"select tf.groupid,tf.tag,tf.value from tag_filter tf"
+				" join users_groups ug on ug.usrgrpid=tf.usrgrpid"
+					" where ug.userid=" ZBX_FS_UI64
+				" order by tf.groupid", userid);
+
+		while (NULL != (row = zbx_db_fetch(result)))
+		{
+			tag_filter = (zbx_tag_filter_t *)zbx_malloc(NULL, sizeof(zbx_tag_filter_t));
+			ZBX_STR2UINT64(tag_filter->hostgroupid, row[0]);
+			tag_filter->tag = zbx_strdup(NULL, row[1]);
+			tag_filter->value = zbx_strdup(NULL, row[2]);
+			zbx_vector_ptr_append(&user->tag_filters, tag_filter);
+		}
+		zbx_db_free_result(result);
+
+		user->tag_filters_loaded = 1;
 	}
-	zbx_free(sql);
-	zbx_db_free_result(result);
 
-	if (0 < tag_filters.values_num)
+	if (0 < user->tag_filters.values_num)
 		condition.op = ZBX_CONDITION_OPERATOR_EQUAL;
 	else
 		ret = SUCCEED;
 
-	for (i = 0; i < tag_filters.values_num && SUCCEED != ret; i++)
+	for (i = 0; i < user->tag_filters.values_num && SUCCEED != ret; i++)
 	{
-		tag_filter = (zbx_tag_filter_t *)tag_filters.values[i];
+		tag_filter = (zbx_tag_filter_t *)user->tag_filters.values[i];
 
 		if (FAIL == zbx_vector_uint64_search(hostgroupids, tag_filter->hostgroupid,
 				ZBX_DEFAULT_UINT64_COMPARE_FUNC))
@@ -289,8 +406,6 @@ static int	check_tag_based_permission(zbx_uint64_t userid, zbx_vector_uint64_t *
 		else
 			ret = SUCCEED;
 	}
-	zbx_vector_ptr_clear_ext(&tag_filters, (zbx_clean_func_t)zbx_tag_filter_free);
-	zbx_vector_ptr_destroy(&tag_filters);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
@@ -308,10 +423,9 @@ static int	check_tag_based_permission(zbx_uint64_t userid, zbx_vector_uint64_t *
 static int	get_trigger_permission(zbx_uint64_t userid, const zbx_db_event *event, char **user_timezone)
 {
 	int			perm = PERM_DENY;
-	zbx_db_result_t		result;
-	zbx_db_row_t		row;
-	zbx_vector_uint64_t	hostgroupids;
-	zbx_uint64_t		hostgroupid, roleid;
+	zbx_uint64_t		roleid;
+	zbx_esc_trigger_t	*trigger;
+	zbx_esc_trigger_perm_t	*trigger_perm, trigger_perm_local;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -321,31 +435,52 @@ static int	get_trigger_permission(zbx_uint64_t userid, const zbx_db_event *event
 		goto out;
 	}
 
-	zbx_vector_uint64_create(&hostgroupids);
+	if (NULL == (trigger = (zbx_esc_trigger_t *)zbx_hashset_search(&esc_triggers, &event->objectid)))
+	{
+		zbx_db_result_t		result;
+		zbx_db_row_t		row;
+		zbx_esc_trigger_t	trigger_local;
+		zbx_uint64_t		hostgroupid;
 
-	result = zbx_db_select(
-			"select distinct hg.groupid from items i"
-			" join functions f on i.itemid=f.itemid"
-			" join hosts_groups hg on hg.hostid = i.hostid"
-				" and f.triggerid=" ZBX_FS_UI64,
-			event->objectid);
+		trigger_local.triggerid = event->objectid;
+		trigger = (zbx_esc_trigger_t *)zbx_hashset_insert(&esc_triggers, &trigger_local,
+				sizeof(trigger_local));
+		zbx_vector_uint64_create(&trigger->hostgroupids);
 
-	while (NULL != (row = zbx_db_fetch(result)))
-	{
-		ZBX_STR2UINT64(hostgroupid, row[0]);
-		zbx_vector_uint64_append(&hostgroupids, hostgroupid);
+		result = zbx_db_select(
+				"select distinct hg.groupid from items i"
+				" join functions f on i.itemid=f.itemid"
+				" join hosts_groups hg on hg.hostid = i.hostid"
+					" and f.triggerid=" ZBX_FS_UI64,
+				event->objectid);
+
+		while (NULL != (row = zbx_db_fetch(result)))
+		{
+			ZBX_STR2UINT64(hostgroupid, row[0]);
+			zbx_vector_uint64_append(&trigger->hostgroupids, hostgroupid);
+		}
+		zbx_db_free_result(result);
+
+		zbx_vector_uint64_sort(&trigger->hostgroupids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 	}
-	zbx_db_free_result(result);
 
-	zbx_vector_uint64_sort(&hostgroupids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	trigger_perm_local.ids.first = userid;
+	trigger_perm_local.ids.second = event->objectid;
 
-	if (PERM_DENY < (perm = get_hostgroups_permission(userid, &hostgroupids)) &&
-			FAIL == check_tag_based_permission(userid, &hostgroupids, event))
+	if (NULL == (trigger_perm = (zbx_esc_trigger_perm_t *)zbx_hashset_search(&esc_trigger_perms,
+			&trigger_perm_local)))
 	{
-		perm = PERM_DENY;
+		trigger_perm_local.perm = get_hostgroups_permission(userid, &trigger->hostgroupids);
+		trigger_perm = (zbx_esc_trigger_perm_t *)zbx_hashset_insert(&esc_trigger_perms, &trigger_perm_local,
+				sizeof(trigger_perm_local));
 	}
 
-	zbx_vector_uint64_destroy(&hostgroupids);
+	/* tag based permissions depend on event tags and cannot be cached by trigger */
+	if (PERM_DENY < (perm = trigger_perm->perm) &&
+			FAIL == check_tag_based_permission(userid, &trigger->hostgroupids, event))
+	{
+		perm = PERM_DENY;
+	}
 out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, permission_string(perm));
 
@@ -3209,6 +3344,9 @@ static int	process_db_escalations(int now, int *nextcheck, zbx_vector_ptr_t *esc
 				zbx_vector_uint64_append(&escalationids, escalation->escalationid);
 				continue;
 			case ZBX_ESCALATION_SKIP:
+				/* nextcheck is not changed, recheck with the former polling frequency */
+				if (now + CONFIG_ESCALATOR_FREQUENCY < *nextcheck)
+					*nextcheck = now + CONFIG_ESCALATOR_FREQUENCY;
 				continue;
 			case ZBX_ESCALATION_SUPPRESS:
 				diff = escalation_create_diff(escalation);
@@ -3510,26 +3648,12 @@ static int	process_escalations(int now, int *nextcheck, unsigned int escalation_
 				" from escalations"
 				" where %s and nextcheck<=%d"
 				" order by actionid,triggerid,itemid," ZBX_SQL_SORT_ASC("r_eventid") ",escalationid",
-				filter, now + CONFIG_ESCALATOR_FREQUENCY);
-	zbx_free(filter);
+				filter, now);
 
 	while (NULL != (row = zbx_db_fetch(result)) && ZBX_IS_RUNNING())
 	{
-		int	esc_nextcheck;
-
-		esc_nextcheck = atoi(row[5]);
-
-		/* skip escalations that must be checked in next CONFIG_ESCALATOR_FREQUENCY period */
-		if (esc_nextcheck > now)
-		{
-			if (esc_nextcheck < *nextcheck)
-				*nextcheck = esc_nextcheck;
-
-			continue;
-		}
-
 		escalation = (zbx_db_escalation *)zbx_malloc(NULL, sizeof(zbx_db_escalation));
-		escalation->nextcheck = esc_nextcheck;
+		escalation->nextcheck = atoi(row[5]);
 		ZBX_DBROW2UINT64(escalation->r_eventid, row[4]);
 		ZBX_STR2UINT64(escalation->escalationid, row[0]);
 		ZBX_STR2UINT64(escalation->actionid, row[1]);
@@ -3569,6 +3693,19 @@ static int	process_escalations(int now, int *nextcheck, unsigned int escalation_
 		zbx_vector_ptr_clear_ext(&escalations, zbx_ptr_free);
 	}
 
+	/* find when the next escalation is due, processed escalations are already rescheduled */
+	result = zbx_db_select("select min(nextcheck) from escalations where %s and nextcheck>%d", filter, now);
+
+	if (NULL != (row = zbx_db_fetch(result)) && SUCCEED != zbx_db_is_null(row[0]))
+	{
+		int	esc_nextcheck = atoi(row[0]);
+
+		if (esc_nextcheck < *nextcheck)
+			*nextcheck = esc_nextcheck;
+	}
+	zbx_db_free_result(result);
+
+	zbx_free(filter);
 	zbx_vector_ptr_destroy(&escalations);
 	zbx_vector_uint64_destroy(&actionids);
 	zbx_vector_uint64_destroy(&eventids);
@@ -3599,6 +3736,8 @@ ZBX_THREAD_ENTRY(escalator_thread, args)
 	int				server_num = ((zbx_thread_args_t *)args)->info.server_num;
 	int				process_num = ((zbx_thread_args_t *)args)->info.process_num;
 	unsigned char			process_type = ((zbx_thread_args_t *)args)->info.process_type;
+	zbx_ipc_async_socket_t		rtc;
+	zbx_uint32_t			rtc_msgs[] = {ZBX_RTC_ESCALATOR_NOTIFY};
 
 	zabbix_log(LOG_LEVEL_INFORMATION, "%s #%d started [%s #%d]", get_program_type_string(info->program_type),
 			server_num, get_process_type_string(process_type), process_num);
@@ -3616,8 +3755,16 @@ ZBX_THREAD_ENTRY(escalator_thread, args)
 
 	zbx_db_connect(ZBX_DB_CONNECT_NORMAL);
 
+	esc_cache_init();
+
+	zbx_rtc_subscribe(process_type, process_num, rtc_msgs, ARRSIZE(rtc_msgs), escalator_args_in->config_timeout,
+			&rtc);
+
 	while (ZBX_IS_RUNNING())
 	{
+		zbx_uint32_t	rtc_cmd;
+		unsigned char	*rtc_data;
+
 		sec = zbx_time();
 		zbx_update_env(get_process_type_string(process_type), sec);
 
@@ -3630,7 +3777,7 @@ ZBX_THREAD_ENTRY(escalator_thread, args)
 
 		zbx_config_get(&cfg, ZBX_CONFIG_FLAGS_DEFAULT_TIMEZONE);
 
-		nextcheck = time(NULL) + CONFIG_ESCALATOR_FREQUENCY;
+		nextcheck = time(NULL) + ZBX_ESCALATOR_IDLE_MAX;
 		escalations_count += process_escalations(time(NULL), &nextcheck, ZBX_ESCALATION_SOURCE_TRIGGER,
 				cfg.default_timezone, process_num, escalator_args_in->config_timeout);
 		escalations_count += process_escalations(time(NULL), &nextcheck, ZBX_ESCALATION_SOURCE_ITEM,
@@ -3640,10 +3787,11 @@ ZBX_THREAD_ENTRY(escalator_thread, args)
 		escalations_count += process_escalations(time(NULL), &nextcheck, ZBX_ESCALATION_SOURCE_DEFAULT,
 				cfg.default_timezone, process_num, escalator_args_in->config_timeout);
 
+		esc_cache_clear();
 		zbx_config_clean(&cfg);
 		total_sec += zbx_time() - sec;
 
-		sleeptime = zbx_calculate_sleeptime(nextcheck, CONFIG_ESCALATOR_FREQUENCY);
+		sleeptime = zbx_calculate_sleeptime(nextcheck, ZBX_ESCALATOR_IDLE_MAX);
 
 		now = time(NULL);
 
@@ -3669,7 +3817,14 @@ ZBX_THREAD_ENTRY(escalator_thread, args)
 			last_stat_time = now;
 		}
 
-		zbx_sleep_loop(info, sleeptime);
+		/* sleep until the next escalation is due or new escalations are created */
+		if (SUCCEED == zbx_rtc_wait(&rtc, info, &rtc_cmd, &rtc_data, sleeptime) && 0 != rtc_cmd)
+		{
+			zbx_free(rtc_data);
+
+			if (ZBX_RTC_SHUTDOWN == rtc_cmd)
+				break;
+		}
 	}
 
 	zbx_setproctitle("%s #%d [terminated]", get_process_type_string(process_type), process_num);
@@ -38,6 +38,7 @@
 #include "zbxvariant.h"
 #include "zbxconnector.h"
 #include "zbxtagfilter.h"
+#include "zbxrtc.h"
 
 /* event recovery data */
 typedef struct
@@ -75,6 +76,9 @@ static zbx_hashset_t		event_recovery;
 static zbx_hashset_t		correlation_cache;
 static zbx_correlation_rules_t	correlation_rules;
 
+/* escalations were created or recovered since the last escalator notification */
+static int			escalations_pending;
+
 /******************************************************************************
  *                                                                            *
  * Purpose: Check that tag name is not empty and that tag is not duplicate.   *
@@ -1173,6 +1177,52 @@ typedef enum
 }
 zbx_problem_state_t;
 
+/* problem matched by global correlation filter */
+typedef struct
+{
+	zbx_uint64_t	eventid;
+	zbx_uint64_t	objectid;
+	zbx_uint64_t	correlationid;
+}
+zbx_corr_match_t;
+
+ZBX_VECTOR_DECL(corr_match, zbx_corr_match_t)
+ZBX_VECTOR_IMPL(corr_match, zbx_corr_match_t)
+
+/* Problems matched by the same old event filter during one correlation batch. New events */
+/* are written to database only after correlation, so the problem table does not change  */
+/* within batch and events with identical filters (usually having the same tags) can     */
+/* share single query result.                                                           */
+typedef struct
+{
+	char			*filter;
+	zbx_vector_corr_match_t	matches;
+}
+zbx_corr_filter_t;
+
+static zbx_hash_t	corr_filter_hash_func(const void *data)
+{
+	const zbx_corr_filter_t	*filter = (const zbx_corr_filter_t *)data;
+
+	return ZBX_DEFAULT_STRING_HASH_FUNC(filter->filter);
+}
+
+static int	corr_filter_compare_func(const void *d1, const void *d2)
+{
+	const zbx_corr_filter_t	*filter1 = (const zbx_corr_filter_t *)d1;
+	const zbx_corr_filter_t	*filter2 = (const zbx_corr_filter_t *)d2;
+
+	return strcmp(filter1->filter, filter2->filter);
+}
+
+static void	corr_filter_clean_func(void *data)
+{
+	zbx_corr_filter_t	*filter = (zbx_corr_filter_t *)data;
+
+	zbx_free(filter->filter);
+	zbx_vector_corr_match_destroy(&filter->matches);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: find problem events that must be recovered by global correlation  *
@@ -1180,6 +1230,7 @@ zbx_problem_state_t;
  *                                                                            *
  * Parameters: event         - [IN] new event                                 *
  *             problem_state - [IN/OUT] problem state cache variable          *
+ *             filters       - [IN/OUT] old event filter result cache         *
  *                                                                            *
  * Comments: The correlation data (zbx_event_recovery_t) of events that       *
  *           must be closed are added to event_correlation hashset            *
@@ -1188,10 +1239,13 @@ zbx_problem_state_t;
  *             1) exclude correlations that can't possibly match the event    *
  *                based on new event tag/value/group conditions               *
  *             2) assemble sql statement to select problems/correlations      *
- *                based on the rest correlation conditions                    *
+ *                based on the rest correlation conditions, the statement is  *
+ *                executed only if it was not already executed for another    *
+ *                event in the same batch                                     *
  *                                                                            *
  ******************************************************************************/
-static void	correlate_event_by_global_rules(zbx_db_event *event, zbx_problem_state_t *problem_state)
+static void	correlate_event_by_global_rules(zbx_db_event *event, zbx_problem_state_t *problem_state,
+		zbx_hashset_t *filters)
 {
 	int			i;
 	zbx_correlation_t	*correlation;
@@ -1199,7 +1253,7 @@ static void	correlate_event_by_global_rules(zbx_db_event *event, zbx_problem_sta
 	char			*sql = NULL;
 	const char		*delim = "";
 	size_t			sql_alloc = 0, sql_offset = 0;
-	zbx_uint64_t		eventid, correlationid, objectid;
+	zbx_corr_filter_t	*filter, filter_local;
 
 	zbx_vector_ptr_create(&corr_old);
 	zbx_vector_ptr_create(&corr_new);
@@ -1270,9 +1324,6 @@ static void	correlate_event_by_global_rules(zbx_db_event *event, zbx_problem_sta
 
 	if (0 != corr_old.values_num)
 	{
-		zbx_db_result_t	result;
-		zbx_db_row_t	row;
-
 		/* Process correlations that matches new event and either uses old events in conditions */
 		/* or has operations involving old events.                                              */
 
@@ -1292,31 +1343,53 @@ static void	correlate_event_by_global_rules(zbx_db_event *event, zbx_problem_sta
 		}
 
 		zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, ')');
-		result = zbx_db_select("%s", sql);
 
-		while (NULL != (row = zbx_db_fetch(result)))
+		filter_local.filter = sql;
+
+		if (NULL == (filter = (zbx_corr_filter_t *)zbx_hashset_search(filters, &filter_local)))
 		{
-			ZBX_STR2UINT64(eventid, row[0]);
+			zbx_db_result_t		result;
+			zbx_db_row_t		row;
+			zbx_corr_match_t	match;
+
+			filter = (zbx_corr_filter_t *)zbx_hashset_insert(filters, &filter_local, sizeof(filter_local));
+			zbx_vector_corr_match_create(&filter->matches);
+			sql = NULL;
+
+			result = zbx_db_select("%s", filter->filter);
+
+			while (NULL != (row = zbx_db_fetch(result)))
+			{
+				ZBX_STR2UINT64(match.eventid, row[0]);
+				ZBX_STR2UINT64(match.objectid, row[1]);
+				ZBX_STR2UINT64(match.correlationid, row[2]);
+				zbx_vector_corr_match_append(&filter->matches, match);
+			}
+
+			zbx_db_free_result(result);
+		}
+		else
+			zbx_free(sql);
+
+		for (i = 0; i < filter->matches.values_num; i++)
+		{
+			zbx_corr_match_t	*match = &filter->matches.values[i];
+			int			index;
 
 			/* check if this event is not already recovered by another correlation rule */
-			if (NULL != zbx_hashset_search(&correlation_cache, &eventid))
+			if (NULL != zbx_hashset_search(&correlation_cache, &match->eventid))
 				continue;
 
-			ZBX_STR2UINT64(correlationid, row[2]);
-
-			if (FAIL == (i = zbx_vector_ptr_bsearch(&corr_old, &correlationid,
+			if (FAIL == (index = zbx_vector_ptr_bsearch(&corr_old, &match->correlationid,
 					ZBX_DEFAULT_UINT64_PTR_COMPARE_FUNC)))
 			{
 				THIS_SHOULD_NEVER_HAPPEN;
 				continue;
 			}
 
-			ZBX_STR2UINT64(objectid, row[1]);
-			correlation_execute_operations((zbx_correlation_t *)corr_old.values[i], event, eventid, objectid);
+			correlation_execute_operations((zbx_correlation_t *)corr_old.values[index], event,
+					match->eventid, match->objectid);
 		}
-
-		zbx_db_free_result(result);
-		zbx_free(sql);
 	}
 
 	zbx_vector_ptr_destroy(&corr_new);
@@ -1334,6 +1407,7 @@ static void	correlate_events_by_global_rules(zbx_vector_ptr_t *trigger_events, z
 	int			i, index;
 	zbx_trigger_diff_t	*diff;
 	zbx_problem_state_t	problem_state = ZBX_PROBLEM_STATE_UNKNOWN;
+	zbx_hashset_t		filters;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() events:%d", __func__, correlation_cache.num_data);
 
@@ -1342,6 +1416,9 @@ static void	correlate_events_by_global_rules(zbx_vector_ptr_t *trigger_events, z
 	if (0 == correlation_rules.correlations.values_num)
 		goto out;
 
+	zbx_hashset_create_ext(&filters, 0, corr_filter_hash_func, corr_filter_compare_func, corr_filter_clean_func,
+			ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
+
 	/* process global correlation and queue the events that must be closed */
 	for (i = 0; i < trigger_events->values_num; i++)
 	{
@@ -1350,7 +1427,7 @@ static void	correlate_events_by_global_rules(zbx_vector_ptr_t *trigger_events, z
 		if (0 == (ZBX_FLAGS_DB_EVENT_CREATE & event->flags))
 			continue;
 
-		correlate_event_by_global_rules(event, &problem_state);
+		correlate_event_by_global_rules(event, &problem_state, &filters);
 
 		/* force value recalculation based on open problems for triggers with */
 		/* events closed by 'close new' correlation operation                */
@@ -1365,6 +1442,7 @@ static void	correlate_events_by_global_rules(zbx_vector_ptr_t *trigger_events, z
 		}
 	}
 
+	zbx_hashset_destroy(&filters);
 out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
@@ -1393,7 +1471,7 @@ static void	flush_correlation_queue(zbx_vector_ptr_t *trigger_diff, zbx_vector_u
 
 	/* lock source triggers of events to be closed by global correlation rules */
 
-	zbx_vector_uint64_sort(triggerids_lock, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_sort_asc(triggerids_lock);
 
 	/* create a list of triggers that must be locked to close correlated events */
 	zbx_hashset_iter_reset(&correlation_cache, &iter);
@@ -1413,8 +1491,7 @@ static void	flush_correlation_queue(zbx_vector_ptr_t *trigger_diff, zbx_vector_u
 	{
 		int	num = triggerids_lock->values_num;
 
-		zbx_vector_uint64_sort(&lockids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
-		zbx_vector_uint64_uniq(&lockids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_sort_uniq(&lockids);
 
 		zbx_dc_config_lock_triggers_by_triggerids(&lockids, triggerids_lock);
 
@@ -1434,7 +1511,7 @@ static void	flush_correlation_queue(zbx_vector_ptr_t *trigger_diff, zbx_vector_u
 
 		/* get locked trigger data - needed for trigger diff and event generation */
 
-		zbx_vector_uint64_sort(&triggerids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_sort_asc(&triggerids);
 
 		triggers = (zbx_dc_trigger_t *)zbx_malloc(NULL, sizeof(zbx_dc_trigger_t) * triggerids.values_num);
 		errcodes = (int *)zbx_malloc(NULL, sizeof(int) * triggerids.values_num);
@@ -1485,7 +1562,7 @@ static void	flush_correlation_queue(zbx_vector_ptr_t *trigger_diff, zbx_vector_u
 			zbx_vector_uint64_append(&eventids, recovery->eventid);
 		}
 
-		zbx_vector_uint64_sort(&eventids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_sort_asc(&eventids);
 		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, "select eventid from problem"
 								" where r_eventid is null and");
 		zbx_db_add_condition_alloc(&sql, &sql_alloc, &sql_offset, "eventid", eventids.values, eventids.values_num);
@@ -1779,6 +1856,8 @@ void	zbx_export_events(int events_export_enabled, zbx_vector_connector_filter_t
 	zbx_hashset_iter_t	iter;
 	zbx_event_recovery_t	*recovery;
 	zbx_connector_object_t	connector_object;
+	zbx_match_tags_index_t	connector_index;
+	zbx_vector_uint32_t	connector_matches;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() events:" ZBX_FS_SIZE_T, __func__, (zbx_fs_size_t)events.values_num);
 
@@ -1790,6 +1869,14 @@ void	zbx_export_events(int events_export_enabled, zbx_vector_connector_filter_t
 	zbx_hashset_create(&hosts, events.values_num, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 	zbx_vector_uint64_create(&hostids);
 	zbx_vector_uint64_create(&connector_object.ids);
+	zbx_vector_uint32_create(&connector_matches);
+	zbx_match_tags_index_init(&connector_index);
+
+	for (i = 0; i < connector_filters->values_num; i++)
+	{
+		zbx_match_tags_index_add(&connector_index, connector_filters->values[i].tags_evaltype,
+				&connector_filters->values[i].connector_tags);
+	}
 
 	for (i = 0; i < events.values_num; i++)
 	{
@@ -1813,16 +1900,15 @@ void	zbx_export_events(int events_export_enabled, zbx_vector_connector_filter_t
 			zbx_vector_tags_append_array(&event_tags, event->tags.values, event->tags.values_num);
 			zbx_vector_tags_sort(&event_tags, zbx_compare_tags);
 
-			for (k = 0; k < connector_filters->values_num; k++)
+			zbx_match_tags_index_match(&connector_index, &event_tags, &connector_matches);
+
+			for (k = 0; k < connector_matches.values_num; k++)
 			{
-				if (SUCCEED == zbx_match_tags(connector_filters->values[k].tags_evaltype,
-						&connector_filters->values[k].connector_tags, &event_tags))
-				{
-					zbx_vector_uint64_append(&connector_object.ids,
-							connector_filters->values[k].connectorid);
-				}
+				zbx_vector_uint64_append(&connector_object.ids,
+						connector_filters->values[connector_matches.values[k]].connectorid);
 			}
 
+			zbx_vector_uint32_clear(&connector_matches);
 			zbx_vector_tags_destroy(&event_tags);
 
 			if (0 == connector_object.ids.values_num && FAIL == events_export_enabled)
@@ -1921,16 +2007,15 @@ void	zbx_export_events(int events_export_enabled, zbx_vector_connector_filter_t
 					recovery->r_event->tags.values_num);
 			zbx_vector_tags_sort(&event_tags, zbx_compare_tags);
 
-			for (k = 0; k < connector_filters->values_num; k++)
+			zbx_match_tags_index_match(&connector_index, &event_tags, &connector_matches);
+
+			for (k = 0; k < connector_matches.values_num; k++)
 			{
-				if (SUCCEED == zbx_match_tags(connector_filters->values[k].tags_evaltype,
-						&connector_filters->values[k].connector_tags, &event_tags))
-				{
-					zbx_vector_uint64_append(&connector_object.ids,
-							connector_filters->values[k].connectorid);
-				}
+				zbx_vector_uint64_append(&connector_object.ids,
+						connector_filters->values[connector_matches.values[k]].connectorid);
 			}
 
+			zbx_vector_uint32_clear(&connector_matches);
 			zbx_vector_tags_destroy(&event_tags);
 
 			if (0 == connector_object.ids.values_num && FAIL == events_export_enabled)
@@ -1962,6 +2047,8 @@ void	zbx_export_events(int events_export_enabled, zbx_vector_connector_filter_t
 	if (SUCCEED == events_export_enabled)
 		zbx_problems_export_flush();
 
+	zbx_match_tags_index_destroy(&connector_index);
+	zbx_vector_uint32_destroy(&connector_matches);
 	zbx_vector_uint64_destroy(&connector_object.ids);
 	zbx_hashset_destroy(&hosts);
 	zbx_vector_uint64_destroy(&hostids);
@@ -2018,6 +2105,24 @@ void	zbx_events_update_itservices(void)
 	zbx_free(data);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: wakes up escalators if actions created or recovered escalations   *
+ *                                                                            *
+ * Comments: Must be called after the transaction processing events is       *
+ *           committed, otherwise escalators might not see the changes.       *
+ *           Notification after rolled back transaction is harmless.          *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_events_notify_escalators(void)
+{
+	if (0 == escalations_pending)
+		return;
+
+	zbx_rtc_notify_escalators();
+	escalations_pending = 0;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: adds event suppress data for problem events matching active       *
@@ -2179,7 +2284,9 @@ static int	flush_events(void)
 
 	zbx_vector_uint64_pair_sort(&closed_events, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 
-	process_actions(&events, &closed_events);
+	if (0 != process_actions(&events, &closed_events))
+		escalations_pending = 1;
+
 	zbx_vector_uint64_pair_destroy(&closed_events);
 
 	return ret;
@@ -2363,11 +2470,15 @@ static void	process_internal_events_without_actions(zbx_vector_ptr_t *internal_p
  *                                                                            *
  * Purpose: gets open problems created by the specified triggers              *
  *                                                                            *
- * Parameters: triggerids - [IN] trigger identifiers (sorted)                 *
- *             problems   - [OUT]                                             *
+ * Parameters: triggerids     - [IN] trigger identifiers (sorted)             *
+ *             tag_triggerids - [IN] identifiers of triggers with tag based   *
+ *                                   event correlation (sorted), tags are     *
+ *                                   loaded only for their problems           *
+ *             problems       - [OUT]                                         *
  *                                                                            *
  ******************************************************************************/
-static void	get_open_problems(const zbx_vector_uint64_t *triggerids, zbx_vector_ptr_t *problems)
+static void	get_open_problems(const zbx_vector_uint64_t *triggerids, const zbx_vector_uint64_t *tag_triggerids,
+		zbx_vector_ptr_t *problems)
 {
 	zbx_db_result_t		result;
 	zbx_db_row_t		row;
@@ -2398,14 +2509,19 @@ static void	get_open_problems(const zbx_vector_uint64_t *triggerids, zbx_vector_
 		zbx_vector_tags_create(&problem->tags);
 		zbx_vector_ptr_append(problems, problem);
 
-		zbx_vector_uint64_append(&eventids, problem->eventid);
+		if (FAIL != zbx_vector_uint64_bsearch(tag_triggerids, problem->triggerid,
+				ZBX_DEFAULT_UINT64_COMPARE_FUNC))
+		{
+			zbx_vector_uint64_append(&eventids, problem->eventid);
+		}
 	}
 	zbx_db_free_result(result);
 
-	if (0 != problems->values_num)
+	zbx_vector_ptr_sort(problems, ZBX_DEFAULT_UINT64_PTR_COMPARE_FUNC);
+
+	if (0 != eventids.values_num)
 	{
-		zbx_vector_ptr_sort(problems, ZBX_DEFAULT_UINT64_PTR_COMPARE_FUNC);
-		zbx_vector_uint64_sort(&eventids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_sort_asc(&eventids);
 
 		sql_offset = 0;
 		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, "select eventid,tag,value from problem_tag where");
@@ -2558,7 +2674,7 @@ static int	match_tag(const char *name, const zbx_vector_tags_t *tags1, const zbx
 static void	process_trigger_events(const zbx_vector_ptr_t *trigger_events, const zbx_vector_ptr_t *trigger_diff)
 {
 	int			i, j, index;
-	zbx_vector_uint64_t	triggerids;
+	zbx_vector_uint64_t	triggerids, tag_triggerids;
 	zbx_vector_ptr_t	problems, deps;
 	zbx_db_event		*event;
 	zbx_event_problem_t	*problem;
@@ -2567,6 +2683,7 @@ static void	process_trigger_events(const zbx_vector_ptr_t *trigger_events, const
 
 	zbx_vector_uint64_create(&triggerids);
 	zbx_vector_uint64_reserve(&triggerids, trigger_events->values_num);
+	zbx_vector_uint64_create(&tag_triggerids);
 
 	zbx_vector_ptr_create(&problems);
 	zbx_vector_ptr_reserve(&problems, trigger_events->values_num);
@@ -2580,16 +2697,24 @@ static void	process_trigger_events(const zbx_vector_ptr_t *trigger_events, const
 	{
 		event = (zbx_db_event *)trigger_events->values[i];
 
-		if (TRIGGER_VALUE_OK == event->value)
-			zbx_vector_uint64_append(&triggerids, event->objectid);
+		if (TRIGGER_VALUE_OK != event->value)
+			continue;
+
+		zbx_vector_uint64_append(&triggerids, event->objectid);
+
+		if (ZBX_TRIGGER_CORRELATION_NONE != event->trigger.correlation_mode)
+			zbx_vector_uint64_append(&tag_triggerids, event->objectid);
 	}
 
 	if (0 != triggerids.values_num)
 	{
-		zbx_vector_uint64_sort(&triggerids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
-		get_open_problems(&triggerids, &problems);
+		zbx_vector_uint64_sort_asc(&triggerids);
+		zbx_vector_uint64_sort_asc(&tag_triggerids);
+		get_open_problems(&triggerids, &tag_triggerids, &problems);
 	}
 
+	zbx_vector_uint64_destroy(&tag_triggerids);
+
 	/* get trigger dependency data */
 
 	zbx_vector_uint64_clear(&triggerids);
@@ -2599,7 +2724,7 @@ static void	process_trigger_events(const zbx_vector_ptr_t *trigger_events, const
 		zbx_vector_uint64_append(&triggerids, event->objectid);
 	}
 
-	zbx_vector_uint64_sort(&triggerids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_sort_asc(&triggerids);
 	zbx_dc_get_trigger_dependencies(&triggerids, &deps);
 
 	/* process trigger events */
@@ -2740,8 +2865,7 @@ static void	process_internal_events_dependency(const zbx_vector_ptr_t *internal_
 		zbx_vector_uint64_append(&triggerids, event->objectid);
 	}
 
-	zbx_vector_uint64_sort(&triggerids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
-	zbx_vector_uint64_uniq(&triggerids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_sort_uniq(&triggerids);
 	zbx_dc_get_trigger_dependencies(&triggerids, &deps);
 
 	for (i = 0; i < internal_events->values_num; i++)
@@ -2944,6 +3068,7 @@ int	zbx_close_problem(zbx_uint64_t triggerid, zbx_uint64_t eventid, zbx_uint64_t
 			zbx_dc_config_triggers_apply_changes(&trigger_diff);
 
 			zbx_events_update_itservices();
+			zbx_events_notify_escalators();
 
 			zbx_vector_connector_filter_create(&connector_filters_events);
 
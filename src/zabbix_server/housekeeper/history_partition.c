@@ -0,0 +1,355 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "history_partition.h"
+
+#include "log.h"
+#include "zbxdbhigh.h"
+#include "zbxalgo.h"
+#include "zbxstr.h"
+
+#if defined(HAVE_POSTGRESQL) || defined(HAVE_MYSQL)
+
+#define HK_PARTITION_PERIOD	SEC_PER_DAY
+#define HK_PARTITIONS_AHEAD	7	/* number of days to create partitions for in advance */
+
+typedef struct
+{
+	char	*name;
+	int	from;	/* INT_MIN - no lower bound */
+	int	to;	/* INT_MAX - no upper bound */
+}
+zbx_hk_partition_t;
+
+static void	hk_partition_free(void *data)
+{
+	zbx_hk_partition_t	*partition = (zbx_hk_partition_t *)data;
+
+	zbx_free(partition->name);
+	zbx_free(partition);
+}
+
+static int	hk_partition_compare(const void *d1, const void *d2)
+{
+	const zbx_hk_partition_t	*p1 = *(const zbx_hk_partition_t * const *)d1;
+	const zbx_hk_partition_t	*p2 = *(const zbx_hk_partition_t * const *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(p1->to, p2->to);
+
+	return 0;
+}
+
+static void	hk_partition_add(zbx_vector_ptr_t *partitions, const char *name, int from, int to)
+{
+	zbx_hk_partition_t	*partition;
+
+	partition = (zbx_hk_partition_t *)zbx_malloc(NULL, sizeof(zbx_hk_partition_t));
+	partition->name = zbx_strdup(NULL, name);
+	partition->from = from;
+	partition->to = to;
+
+	zbx_vector_ptr_append(partitions, partition);
+}
+
+#if defined(HAVE_POSTGRESQL)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: parse range partition bound                                       *
+ *                                                                            *
+ * Parameters: bound     - [IN] partition bound expression, for example       *
+ *                              FOR VALUES FROM (1697328000) TO (1697414400)  *
+ *             keyword   - [IN] bound keyword to parse (FROM or TO)           *
+ *             unbounded - [IN] value of MINVALUE/MAXVALUE bound              *
+ *             value     - [OUT] parsed bound                                 *
+ *                                                                            *
+ * Return value: SUCCEED - bound was parsed                                   *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	hk_partition_parse_bound(const char *bound, const char *keyword, int unbounded, int *value)
+{
+	const char	*ptr;
+
+	if (NULL == (ptr = strstr(bound, keyword)))
+		return FAIL;
+
+	for (ptr += strlen(keyword); ' ' == *ptr || '(' == *ptr || '\'' == *ptr; ptr++)
+		;
+
+	if (0 == isdigit((unsigned char)*ptr) && '-' != *ptr)
+		*value = unbounded;
+	else
+		*value = atoi(ptr);
+
+	return SUCCEED;
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get range partitions of table                                     *
+ *                                                                            *
+ * Parameters: table      - [IN] partitioned table                            *
+ *             partitions - [OUT] partitions sorted by upper bound            *
+ *                                                                            *
+ * Comments: Default partition and partitions with bounds that are not        *
+ *           integer values are ignored.                                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	hk_partitions_get(const char *table, zbx_vector_ptr_t *partitions)
+{
+	zbx_db_result_t	result;
+	zbx_db_row_t	row;
+#if defined(HAVE_MYSQL)
+	int		from = INT_MIN;
+#endif
+
+#if defined(HAVE_POSTGRESQL)
+	result = zbx_db_select("select c.relname,pg_get_expr(c.relpartbound,c.oid)"
+			" from pg_inherits i,pg_class c"
+			" where i.inhrelid=c.oid"
+				" and i.inhparent=to_regclass('%s')",
+			table);
+
+	while (NULL != (row = zbx_db_fetch(result)))
+	{
+		int	from, to;
+
+		if (SUCCEED != hk_partition_parse_bound(row[1], "FROM", INT_MIN, &from) ||
+				SUCCEED != hk_partition_parse_bound(row[1], " TO", INT_MAX, &to))
+		{
+			continue;
+		}
+
+		hk_partition_add(partitions, row[0], from, to);
+	}
+#else
+	result = zbx_db_select("select partition_name,partition_description"
+			" from information_schema.partitions"
+			" where table_schema=database()"
+				" and table_name='%s'"
+				" and partition_name is not null"
+				" and partition_method like 'RANGE%%'"
+			" order by partition_ordinal_position",
+			table);
+
+	while (NULL != (row = zbx_db_fetch(result)))
+	{
+		int	to;
+
+		if (0 == isdigit((unsigned char)*row[1]) && '-' != *row[1])
+			to = INT_MAX;
+		else
+			to = atoi(row[1]);
+
+		hk_partition_add(partitions, row[0], from, to);
+		from = to;
+	}
+#endif
+	zbx_db_free_result(result);
+
+	zbx_vector_ptr_sort(partitions, hk_partition_compare);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: create partition for the specified time range                     *
+ *                                                                            *
+ * Parameters: table - [IN] partitioned table                                 *
+ *             from  - [IN] partition start time (inclusive)                  *
+ *             to    - [IN] partition end time (exclusive)                    *
+ *                                                                            *
+ * Return value: SUCCEED - partition was created                              *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	hk_partition_create(const char *table, int from, int to)
+{
+	struct tm	tm;
+	time_t		time_from = from;
+	char		suffix[16];
+	int		rc;
+
+	gmtime_r(&time_from, &tm);
+	zbx_snprintf(suffix, sizeof(suffix), "p%04d%02d%02d", tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday);
+
+#if defined(HAVE_POSTGRESQL)
+	rc = zbx_db_execute("create table %s_%s partition of %s for values from (%d) to (%d)", table, suffix, table,
+			from, to);
+#else
+	rc = zbx_db_execute("alter table %s add partition (partition %s values less than (%d))", table, suffix, to);
+#endif
+	if (ZBX_DB_OK > rc)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot create partition of table \"%s\" for period starting at %d",
+				table, from);
+		return FAIL;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "created partition %s of table \"%s\" from:%d to:%d", suffix, table, from, to);
+
+	return SUCCEED;
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: check if table is partitioned by range with native database       *
+ *          partitioning                                                      *
+ *                                                                            *
+ * Parameters: table - [IN] history or trends table                           *
+ *                                                                            *
+ * Return value: SUCCEED - table is partitioned                               *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: TimescaleDB hypertables are not natively partitioned tables.     *
+ *                                                                            *
+ ******************************************************************************/
+int	hk_history_partitioned(const char *table)
+{
+#if defined(HAVE_POSTGRESQL) || defined(HAVE_MYSQL)
+	zbx_db_result_t	result;
+	zbx_db_row_t	row;
+	int		ret = FAIL;
+
+#if defined(HAVE_POSTGRESQL)
+	result = zbx_db_select("select null from pg_class where oid=to_regclass('%s') and relkind='p'", table);
+#else
+	result = zbx_db_select("select null from information_schema.partitions"
+			" where table_schema=database()"
+				" and table_name='%s'"
+				" and partition_method like 'RANGE%%'",
+			table);
+#endif
+	if (NULL != (row = zbx_db_fetch(result)))
+		ret = SUCCEED;
+
+	zbx_db_free_result(result);
+
+	return ret;
+#else
+	ZBX_UNUSED(table);
+
+	return FAIL;
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: create daily partitions for the following days and drop           *
+ *          partitions with expired data                                      *
+ *                                                                            *
+ * Parameters: table     - [IN] partitioned history or trends table           *
+ *             keep_from - [IN] the oldest data timestamp to keep             *
+ *             now       - [IN] the current timestamp                         *
+ *                                                                            *
+ * Return value: number of dropped partitions                                 *
+ *                                                                            *
+ * Comments: A partition is dropped only when all its data is older than      *
+ *           keep_from. Partitions are appended after the last existing       *
+ *           partition, a gap since the last partition is covered by one      *
+ *           partition.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+int	hk_history_partitions_update(const char *table, int keep_from, int now)
+{
+	int			dropped = 0;
+#if defined(HAVE_POSTGRESQL) || defined(HAVE_MYSQL)
+	zbx_vector_ptr_t	partitions;
+	int			i, from, to, today, until;
+#if defined(HAVE_MYSQL)
+	char			*sql = NULL;
+	size_t			sql_alloc = 0, sql_offset = 0;
+#endif
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() table:%s keep_from:%d", __func__, table, keep_from);
+
+	zbx_vector_ptr_create(&partitions);
+	hk_partitions_get(table, &partitions);
+
+	today = now - now % HK_PARTITION_PERIOD;
+	until = today + (HK_PARTITIONS_AHEAD + 1) * HK_PARTITION_PERIOD;
+
+	if (0 == partitions.values_num)
+		from = today;
+	else
+		from = ((zbx_hk_partition_t *)partitions.values[partitions.values_num - 1])->to;
+
+	/* partitions cannot be appended after partition without upper bound */
+	if (INT_MAX == from)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "table \"%s\" has partition without upper bound", table);
+		from = until;
+	}
+
+	while (from < until)
+	{
+		if ((to = from - from % HK_PARTITION_PERIOD + HK_PARTITION_PERIOD) < today)
+			to = today;
+
+		if (SUCCEED != hk_partition_create(table, from, to))
+			break;
+
+		from = to;
+	}
+
+	/* creating partitions first ensures that at least one partition is left */
+	for (i = 0; i < partitions.values_num; i++)
+	{
+		zbx_hk_partition_t	*partition = (zbx_hk_partition_t *)partitions.values[i];
+
+		if (partition->to > keep_from)
+			break;
+#if defined(HAVE_POSTGRESQL)
+		if (ZBX_DB_OK > zbx_db_execute("drop table %s", partition->name))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot drop partition \"%s\" of table \"%s\"", partition->name,
+					table);
+			break;
+		}
+#else
+		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "%s%s", 0 == sql_offset ? "" : ",",
+				partition->name);
+#endif
+		dropped++;
+	}
+
+#if defined(HAVE_MYSQL)
+	if (0 != dropped)
+	{
+		if (ZBX_DB_OK > zbx_db_execute("alter table %s drop partition %s", table, sql))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot drop partitions %s of table \"%s\"", sql, table);
+			dropped = 0;
+		}
+	}
+
+	zbx_free(sql);
+#endif
+	zbx_vector_ptr_clear_ext(&partitions, hk_partition_free);
+	zbx_vector_ptr_destroy(&partitions);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() dropped:%d", __func__, dropped);
+#else
+	ZBX_UNUSED(table);
+	ZBX_UNUSED(keep_from);
+	ZBX_UNUSED(now);
+#endif
+	return dropped;
+}
@@ -26,7 +26,10 @@
 #include "zbxrtc.h"
 #include "zbxnum.h"
 #include "zbxtime.h"
+#include "zbxtrends.h"
+#include "zbxcachehistory.h"
 #include "history_compress.h"
+#include "history_partition.h"
 #include "zbx_rtc_constants.h"
 #include "zbx_host_constants.h"
 
@@ -46,6 +49,21 @@ static int	hk_period;
 /* global configuration data containing housekeeping configuration */
 static zbx_config_t	cfg;
 
+/* limits of the number of items removed by a single history delete statement */
+#define HK_DELETE_BATCH_MIN		1
+#define HK_DELETE_BATCH_MAX		10000
+
+/* the target duration of a single history delete statement in seconds */
+#define HK_DELETE_BATCH_TIME		1.0
+
+/* history deletes are paused while less than this percentage of history cache is free, */
+/* but not longer than HK_DELETE_BACKLOG_WAIT seconds per housekeeping cycle             */
+#define HK_DELETE_BACKLOG_PFREE		20.0
+#define HK_DELETE_BACKLOG_WAIT		300
+
+/* the number of items per history delete statement, adapted to HK_DELETE_BATCH_TIME */
+static int	hk_delete_batch = 100;
+
 /* Housekeeping rule definition.                                */
 /* A housekeeping rule describes table from which records older */
 /* than history setting must be removed according to optional   */
@@ -103,6 +121,8 @@ static zbx_hk_cleanup_table_t	hk_cleanup_tables[] = {
 	{"history_uint",	&cfg.hk.history_mode,	&cfg.hk.history_global},
 	{"trends",		&cfg.hk.trends_mode,	&cfg.hk.trends_global},
 	{"trends_uint",		&cfg.hk.trends_mode,	&cfg.hk.trends_global},
+	{"trends_day",		&cfg.hk.trends_mode,	&cfg.hk.trends_global},
+	{"trends_uint_day",	&cfg.hk.trends_mode,	&cfg.hk.trends_global},
 	/* force events housekeeping mode on to perform problem cleanup when events housekeeping is disabled */
 	{"events",		&poption_mode_regular,	&poption_global_disabled},
 	{NULL}
@@ -129,6 +149,7 @@ typedef struct
 {
 	zbx_uint64_t	itemid;
 	int		min_clock;
+	int		history;
 }
 zbx_hk_delete_queue_t;
 
@@ -153,6 +174,16 @@ typedef struct
 	/* type for checking which values are sent to the history storage */
 	unsigned char		type;
 
+	/* the daily rollup table of the target table, NULL if there is none */
+	const char		*rollup;
+
+	/* 1 - the target table is partitioned and expired partitions are dropped, 0 - otherwise */
+	unsigned char		partitioned;
+
+	/* the longest storage period of the table items, data of items with this period is removed */
+	/* by dropping partitions, -1 - unknown                                                       */
+	int			history_max;
+
 	/* the oldest item record timestamp cache for target table */
 	zbx_hashset_t		item_cache;
 
@@ -184,32 +215,34 @@ static zbx_hk_history_rule_t	hk_history_rules[] = {
 			.type = ITEM_VALUE_TYPE_BIN},
 	{.table = "trends",		.history = "trends",	.poption_mode = &cfg.hk.trends_mode,
 			.poption_global = &cfg.hk.trends_global,	.poption = &cfg.hk.trends,
-			.type = ITEM_VALUE_TYPE_FLOAT},
+			.type = ITEM_VALUE_TYPE_FLOAT,			.rollup = "trends" ZBX_TRENDS_ROLLUP_SUFFIX},
 	{.table = "trends_uint",	.history = "trends",	.poption_mode = &cfg.hk.trends_mode,
 			.poption_global = &cfg.hk.trends_global,	.poption = &cfg.hk.trends,
-			.type = ITEM_VALUE_TYPE_UINT64},
+			.type = ITEM_VALUE_TYPE_UINT64,			.rollup = "trends_uint" ZBX_TRENDS_ROLLUP_SUFFIX},
 	{NULL}
 };
 
 /******************************************************************************
  *                                                                            *
- * Purpose: compare two delete queue items by their itemid                    *
+ * Purpose: compare two delete queue records by cutoff clock and itemid       *
  *                                                                            *
- * Parameters: d1 - [IN] the first delete queue item to compare               *
- *             d2 - [IN] the second delete queue item to compare              *
+ * Parameters: d1 - [IN] the first delete queue record to compare             *
+ *             d2 - [IN] the second delete queue record to compare            *
  *                                                                            *
- * Return value: <0 - the first item is less than the second                  *
- *               >0 - the first item is greater than the second               *
- *               =0 - the items are the same                                  *
+ * Return value: <0 - the first record is less than the second                *
+ *               >0 - the first record is greater than the second             *
+ *               =0 - the records are the same                                *
  *                                                                            *
- * Comments: this function is used to sort delete queue by itemids            *
+ * Comments: this function is used to group items with the same cutoff        *
+ *           clock into a single delete statement                             *
  *                                                                            *
  ******************************************************************************/
-static int	hk_item_update_cache_compare(const void *d1, const void *d2)
+static int	hk_delete_queue_clock_compare(const void *d1, const void *d2)
 {
 	zbx_hk_delete_queue_t	*r1 = *(zbx_hk_delete_queue_t **)d1;
 	zbx_hk_delete_queue_t	*r2 = *(zbx_hk_delete_queue_t **)d2;
 
+	ZBX_RETURN_IF_NOT_EQUAL(r1->min_clock, r2->min_clock);
 	ZBX_RETURN_IF_NOT_EQUAL(r1->itemid, r2->itemid);
 
 	return 0;
@@ -250,6 +283,7 @@ static void	hk_history_delete_queue_append(zbx_hk_history_rule_t *rule, int now,
 		update_record = (zbx_hk_delete_queue_t *)zbx_malloc(NULL, sizeof(zbx_hk_delete_queue_t));
 		update_record->itemid = item_record->itemid;
 		update_record->min_clock = item_record->min_clock;
+		update_record->history = history;
 		zbx_vector_ptr_append(&rule->delete_queue, update_record);
 	}
 }
@@ -276,7 +310,10 @@ static void	hk_history_prepare(zbx_hk_history_rule_t *rule)
 	zbx_vector_ptr_create(&rule->delete_queue);
 	zbx_vector_ptr_reserve(&rule->delete_queue, HK_INITIAL_DELETE_QUEUE_SIZE);
 
+	/* full table scan of old data, replication lag can affect only items created within lag period */
+	zbx_db_begin_replica_read(0);
 	result = zbx_db_select("select itemid,min(clock) from %s group by itemid", rule->table);
+	zbx_db_end_replica_read();
 
 	while (NULL != (row = zbx_db_fetch(result)))
 	{
@@ -374,6 +411,10 @@ static void	hk_history_update(zbx_hk_history_rule_t *rules, int now)
 	zbx_db_row_t		row;
 	char			*tmp = NULL;
 	zbx_dc_um_handle_t	*um_handle;
+	zbx_hk_history_rule_t	*rule;
+
+	for (rule = rules; NULL != rule->table; rule++)
+		rule->history_max = -1;
 
 	result = zbx_db_select(
 			"select i.itemid,i.value_type,i.history,i.trends,h.hostid"
@@ -388,9 +429,8 @@ static void	hk_history_update(zbx_hk_history_rule_t *rules, int now)
 
 	while (NULL != (row = zbx_db_fetch(result)))
 	{
-		zbx_uint64_t		itemid, hostid;
-		int			history, trends, value_type;
-		zbx_hk_history_rule_t	*rule;
+		zbx_uint64_t	itemid, hostid;
+		int		history, trends, value_type;
 
 		ZBX_STR2UINT64(itemid, row[0]);
 		value_type = atoi(row[1]);
@@ -419,6 +459,8 @@ static void	hk_history_update(zbx_hk_history_rule_t *rules, int now)
 			if (0 != history && ZBX_HK_OPTION_DISABLED != *rule->poption_global)
 				history = *rule->poption;
 
+			rule->history_max = MAX(rule->history_max, history);
+
 			hk_history_item_update(rules, rule, ITEM_VALUE_TYPE_BIN + 1, now, itemid, history);
 		}
 
@@ -449,6 +491,8 @@ static void	hk_history_update(zbx_hk_history_rule_t *rules, int now)
 			if (0 != trends && ZBX_HK_OPTION_DISABLED != *rule->poption_global)
 				trends = *rule->poption;
 
+			rule->history_max = MAX(rule->history_max, trends);
+
 			hk_history_item_update(rules + HK_UPDATE_CACHE_OFFSET_TREND_FLOAT, rule,
 					HK_UPDATE_CACHE_TREND_COUNT, now, itemid, trends);
 		}
@@ -482,7 +526,12 @@ static void	hk_history_delete_queue_prepare_all(zbx_hk_history_rule_t *rules, in
 	/* prepare history item cache (hashset containing itemid:min_clock values) */
 	for (rule = rules; NULL != rule->table; rule++)
 	{
-		if (ZBX_HK_MODE_REGULAR == *rule->poption_mode)
+		rule->partitioned = (0 != CONFIG_HOUSEKEEPING_PARTITIONS && ZBX_HK_MODE_REGULAR == *rule->poption_mode &&
+				SUCCEED == hk_history_partitioned(rule->table));
+
+		/* with overridden period all data of partitioned table is removed by dropping partitions */
+		if (ZBX_HK_MODE_REGULAR == *rule->poption_mode &&
+				(0 == rule->partitioned || ZBX_HK_OPTION_DISABLED == *rule->poption_global))
 		{
 			if (0 == rule->item_cache.num_slots)
 				hk_history_prepare(rule);
@@ -541,6 +590,10 @@ static void	hk_drop_partition_for_rule(zbx_hk_history_rule_t *rule, int now)
 				"select drop_chunks(table_name=>'%s',newer_than=>0)" :
 				"select drop_chunks(relation=>'%s',newer_than=>0)",
 				rule->table);
+
+		/* daily rollups are kept in regular tables */
+		if (NULL != rule->rollup)
+			zbx_db_execute("delete from %s", rule->rollup);
 	}
 	else
 	{
@@ -560,6 +613,9 @@ static void	hk_drop_partition_for_rule(zbx_hk_history_rule_t *rule, int now)
 				"select drop_chunks(table_name=>'%s',older_than=>%d)" :
 				"select drop_chunks(relation=>'%s',older_than=>%d)",
 				rule->table, keep_from);
+
+		if (NULL != rule->rollup)
+			zbx_db_execute("delete from %s where clock<%d", rule->rollup, keep_from);
 	}
 
 	if (NULL == result)
@@ -576,6 +632,35 @@ out:
 #endif
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: maintain partitions of natively partitioned history or trends     *
+ *          table                                                             *
+ *                                                                            *
+ * Parameters: rule - [IN] history housekeeping rule                          *
+ *             now  - [IN] the current timestamp                              *
+ *                                                                            *
+ * Comments: Partitions are dropped when their data is older than the         *
+ *           overridden storage period or the longest storage period of the   *
+ *           table items.                                                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	hk_history_partitions_for_rule(zbx_hk_history_rule_t *rule, int now)
+{
+	int	keep_from = 0;
+
+	if (ZBX_HK_OPTION_DISABLED != *rule->poption_global)
+		keep_from = now - *rule->poption;
+	else if (-1 != rule->history_max)
+		keep_from = now - rule->history_max;
+
+	hk_history_partitions_update(rule->table, keep_from, now);
+
+	/* daily rollups are kept in regular tables */
+	if (NULL != rule->rollup && 0 != keep_from)
+		zbx_db_execute("delete from %s where clock<%d", rule->rollup, keep_from);
+}
+
 #if defined(HAVE_POSTGRESQL)
 static void	hk_tsdb_check_config(void)
 {
@@ -609,6 +694,131 @@ static void 	hk_update_dbversion_status(void)
 }
 #endif
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: wait for history syncers to catch up when history cache is        *
+ *          filling up                                                        *
+ *                                                                            *
+ * Parameters: wait_sec - [IN/OUT] seconds already waited during the current  *
+ *                                 housekeeping cycle                         *
+ *                                                                            *
+ ******************************************************************************/
+static void	hk_history_delete_throttle(int *wait_sec)
+{
+	int	waited = 0;
+
+	while (HK_DELETE_BACKLOG_WAIT > *wait_sec && ZBX_IS_RUNNING() &&
+			HK_DELETE_BACKLOG_PFREE > *(double *)zbx_dc_get_stats(ZBX_STATS_HISTORY_PFREE))
+	{
+		if (0 == waited)
+			zabbix_log(LOG_LEVEL_DEBUG, "history cache is filling up, pausing history housekeeping");
+
+		zbx_sleep(1);
+		(*wait_sec)++;
+		waited++;
+	}
+
+	if (0 != waited)
+		zabbix_log(LOG_LEVEL_DEBUG, "resumed history housekeeping after %d sec", waited);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: remove old history of the items in the delete queue of a history  *
+ *          housekeeping rule                                                 *
+ *                                                                            *
+ * Parameters: rule     - [IN/OUT] the history housekeeping rule              *
+ *             wait_sec - [IN/OUT] seconds already waited for history cache   *
+ *                                 during the current housekeeping cycle      *
+ *                                                                            *
+ * Return value: the number of deleted records                                *
+ *                                                                            *
+ * Comments: Items with the same cutoff clock are removed with a single       *
+ *           statement. The number of items per statement is adjusted so      *
+ *           that a statement takes about HK_DELETE_BATCH_TIME seconds.       *
+ *                                                                            *
+ ******************************************************************************/
+static int	hk_history_delete_queue_process(zbx_hk_history_rule_t *rule, int *wait_sec)
+{
+	int			deleted = 0, i = 0, min_clock, rc;
+	char			*sql = NULL;
+	size_t			sql_alloc = 0, sql_offset;
+	double			sec;
+	zbx_vector_uint64_t	itemids;
+
+	zbx_vector_uint64_create(&itemids);
+	zbx_vector_uint64_reserve(&itemids, (size_t)MIN(hk_delete_batch, rule->delete_queue.values_num));
+
+	zbx_vector_ptr_sort(&rule->delete_queue, hk_delete_queue_clock_compare);
+
+	while (i < rule->delete_queue.values_num && ZBX_IS_RUNNING())
+	{
+		min_clock = ((zbx_hk_delete_queue_t *)rule->delete_queue.values[i])->min_clock;
+		zbx_vector_uint64_clear(&itemids);
+
+		for (; i < rule->delete_queue.values_num && itemids.values_num < hk_delete_batch; i++)
+		{
+			zbx_hk_delete_queue_t	*item_record = (zbx_hk_delete_queue_t *)rule->delete_queue.values[i];
+
+			if (item_record->min_clock != min_clock)
+				break;
+
+			/* data of items with the longest storage period is removed with partitions */
+			if (0 != rule->partitioned && item_record->history == rule->history_max)
+				continue;
+
+			zbx_vector_uint64_append(&itemids, item_record->itemid);
+		}
+
+		if (0 == itemids.values_num)
+			continue;
+
+		hk_history_delete_throttle(wait_sec);
+
+		sql_offset = 0;
+		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "delete from %s where clock<%d and", rule->table,
+				min_clock);
+		zbx_db_add_condition_alloc(&sql, &sql_alloc, &sql_offset, "itemid", itemids.values,
+				itemids.values_num);
+
+		sec = zbx_time();
+
+		if (ZBX_DB_OK < (rc = zbx_db_execute("%s", sql)))
+			deleted += rc;
+
+		sec = zbx_time() - sec;
+
+		/* a day rollup is removed together with its first hour */
+		if (NULL != rule->rollup)
+		{
+			sql_offset = 0;
+			zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "delete from %s where clock<%d and",
+					rule->rollup, min_clock);
+			zbx_db_add_condition_alloc(&sql, &sql_alloc, &sql_offset, "itemid", itemids.values,
+					itemids.values_num);
+			zbx_db_execute("%s", sql);
+		}
+
+		/* adjust batch size only by statements that were limited by it */
+		if (itemids.values_num == hk_delete_batch)
+		{
+			if (HK_DELETE_BATCH_TIME / 2 > sec)
+				hk_delete_batch = MIN(hk_delete_batch * 2, HK_DELETE_BATCH_MAX);
+		}
+
+		if (HK_DELETE_BATCH_TIME < sec)
+			hk_delete_batch = MAX(hk_delete_batch / 2, HK_DELETE_BATCH_MIN);
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() table:%s deleted:%d batch:%d", __func__, rule->table, deleted,
+			hk_delete_batch);
+
+	zbx_free(sql);
+	zbx_vector_uint64_destroy(&itemids);
+
+	return deleted;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: performs housekeeping for history and trends tables               *
@@ -618,7 +828,7 @@ static void 	hk_update_dbversion_status(void)
  ******************************************************************************/
 static int	housekeeping_history_and_trends(int now)
 {
-	int			deleted = 0, i, rc;
+	int			deleted = 0, wait_sec = 0;
 	zbx_hk_history_rule_t	*rule;
 #if defined(HAVE_POSTGRESQL)
 	int			ignore_history = 0, ignore_trends = 0;
@@ -653,6 +863,14 @@ static int	housekeeping_history_and_trends(int now)
 			goto skip;
 		}
 
+		if (0 != rule->partitioned)
+		{
+			hk_history_partitions_for_rule(rule, now);
+
+			if (ZBX_HK_OPTION_DISABLED != *rule->poption_global)
+				goto skip;
+		}
+
 #if defined(HAVE_POSTGRESQL)
 		if (tsdb_version > 0)
 		{
@@ -689,18 +907,7 @@ static int	housekeeping_history_and_trends(int now)
 		}
 #endif
 		/* process delete queue for the housekeeping rule */
-
-		zbx_vector_ptr_sort(&rule->delete_queue, hk_item_update_cache_compare);
-
-		for (i = 0; i < rule->delete_queue.values_num; i++)
-		{
-			zbx_hk_delete_queue_t	*item_record = (zbx_hk_delete_queue_t *)rule->delete_queue.values[i];
-
-			rc = zbx_db_execute("delete from %s where itemid=" ZBX_FS_UI64 " and clock<%d",
-					rule->table, item_record->itemid, item_record->min_clock);
-			if (ZBX_DB_OK < rc)
-				deleted += rc;
-		}
+		deleted += hk_history_delete_queue_process(rule, &wait_sec);
 skip:
 		/* clear history rule delete queue so it's ready for the next housekeeping cycle */
 		hk_history_delete_queue_clear(rule);
@@ -1058,7 +1265,7 @@ static int	housekeeping_cleanup(void)
 
 	if (0 != housekeeperids.values_num)
 	{
-		zbx_vector_uint64_sort(&housekeeperids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_sort_asc(&housekeeperids);
 		zbx_db_execute_multiple_query("delete from housekeeper where", "housekeeperid", &housekeeperids);
 	}
 
@@ -1270,7 +1477,7 @@ ZBX_THREAD_ENTRY(housekeeper_thread, args)
 							(((zbx_thread_args_t *)args)->args);
 	int				now, d_history_and_trends, d_cleanup, d_events, d_problems, d_sessions,
 					d_services, d_audit, sleeptime, records;
-	double				sec, time_slept, time_now;
+	double				sec, sec_history, time_slept, time_now;
 	char				sleeptext[25];
 	zbx_ipc_async_socket_t		rtc;
 	const zbx_thread_info_t	*info = &((zbx_thread_args_t *)args)->info;
@@ -1382,6 +1589,7 @@ ZBX_THREAD_ENTRY(housekeeper_thread, args)
 				get_process_type_string(process_type));
 		sec = zbx_time();
 		d_history_and_trends = housekeeping_history_and_trends(now);
+		sec_history = zbx_time() - sec;
 
 		zbx_setproctitle("%s [removing old problems]", get_process_type_string(process_type));
 		d_problems = housekeeping_problems(now);
@@ -1405,9 +1613,10 @@ ZBX_THREAD_ENTRY(housekeeper_thread, args)
 		d_cleanup = housekeeping_cleanup();
 		sec = zbx_time() - sec;
 
-		zabbix_log(LOG_LEVEL_WARNING, "%s [deleted %d hist/trends, %d items/triggers, %d events, %d problems,"
-				" %d sessions, %d alarms, %d audit, %d records in " ZBX_FS_DBL " sec, %s]",
-				get_process_type_string(process_type), d_history_and_trends, d_cleanup, d_events,
+		zabbix_log(LOG_LEVEL_WARNING, "%s [deleted %d hist/trends (%.0f rows/sec), %d items/triggers,"
+				" %d events, %d problems, %d sessions, %d alarms, %d audit, %d records in " ZBX_FS_DBL
+				" sec, %s]", get_process_type_string(process_type), d_history_and_trends,
+				0.0 < sec_history ? d_history_and_trends / sec_history : 0.0, d_cleanup, d_events,
 				d_problems, d_sessions, d_services, d_audit, records, sec, sleeptext);
 
 		zbx_config_clean(&cfg);
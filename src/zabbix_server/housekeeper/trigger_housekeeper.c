@@ -71,7 +71,7 @@ static int	housekeep_problems_without_triggers(void)
 	}
 	zbx_db_free_result(result);
 
-	zbx_vector_uint64_sort(&ids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_sort_asc(&ids);
 
 	if (0 != ids.values_num)
 	{
@@ -56,23 +56,34 @@ typedef struct
 }
 zbx_httppage_t;
 
-static zbx_httppage_t	page;
+/* curl_multi_wait() is supported starting with version 7.28.0 (0x071c00) */
+#if LIBCURL_VERSION_NUM >= 0x071c00
+#	define ZBX_HTTPTEST_MULTI
+/* the maximum number of web scenarios executed concurrently by one http poller */
+#	define ZBX_HTTPTEST_JOBS_MAX	64
+#else
+#	define ZBX_HTTPTEST_JOBS_MAX	1
+#endif
+
+#define ZBX_HTTPTEST_WAIT_TIMEOUT	1000	/* milliseconds */
+
+/* DNS cache, TLS sessions and connections shared by all web scenarios of the process */
+static CURLSH	*share = NULL;
 
 static size_t	curl_write_cb(void *ptr, size_t size, size_t nmemb, void *userdata)
 {
-	size_t	r_size = size * nmemb;
-
-	ZBX_UNUSED(userdata);
+	size_t		r_size = size * nmemb;
+	zbx_httppage_t	*page = (zbx_httppage_t *)userdata;
 
 	/* first piece of data */
-	if (NULL == page.data)
+	if (NULL == page->data)
 	{
-		page.allocated = MAX(8096, r_size);
-		page.offset = 0;
-		page.data = (char *)zbx_malloc(page.data, page.allocated);
+		page->allocated = MAX(8096, r_size);
+		page->offset = 0;
+		page->data = (char *)zbx_malloc(page->data, page->allocated);
 	}
 
-	zbx_strncpy_alloc(&page.data, &page.allocated, &page.offset, (char *)ptr, r_size);
+	zbx_strncpy_alloc(&page->data, &page->allocated, &page->offset, (char *)ptr, r_size);
 
 	return r_size;
 }
@@ -87,6 +98,32 @@ static size_t	curl_ignore_cb(void *ptr, size_t size, size_t nmemb, void *userdat
 
 #endif	/* HAVE_LIBCURL */
 
+#ifndef ZBX_HTTPTEST_JOBS_MAX
+#	define ZBX_HTTPTEST_JOBS_MAX	1
+#endif
+
+/* web scenario being executed */
+typedef struct
+{
+	zbx_dc_host_t		host;
+	zbx_httptest_t		httptest;
+	int			delay;
+	zbx_db_result_t		result;		/* the scenario steps */
+	zbx_db_httpstep		db_httpstep;
+	char			*err_str;
+	int			lastfailedstep;
+	double			speed_download;
+	int			speed_download_num;
+#ifdef HAVE_LIBCURL
+	zbx_httpstep_t		httpstep;
+	CURL			*easyhandle;
+	struct curl_slist	*headers_slist;
+	zbx_httppage_t		page;
+	char			errbuf[CURL_ERROR_SIZE];
+#endif
+}
+zbx_httptest_job_t;
+
 /******************************************************************************
  *                                                                            *
  * Purpose: remove all macro variables cached during http test execution      *
@@ -611,417 +648,769 @@ out:
 	return ret;
 }
 
+
+#ifdef HAVE_LIBCURL
 /******************************************************************************
  *                                                                            *
- * Purpose: process single scenario of http test                              *
+ * Purpose: frees data of the current web scenario step                       *
  *                                                                            *
  ******************************************************************************/
-static void	process_httptest(zbx_dc_host_t *host, zbx_httptest_t *httptest, int *delay)
+static void	httpstep_clean(zbx_httptest_job_t *job)
+{
+	curl_slist_free_all(job->headers_slist);
+	job->headers_slist = NULL;
+
+	zbx_free(job->db_httpstep.status_codes);
+	zbx_free(job->db_httpstep.required);
+	zbx_free(job->db_httpstep.posts);
+	zbx_free(job->db_httpstep.url);
+
+	httppairs_free(&job->httpstep.variables);
+
+	if (ZBX_POSTTYPE_FORM == job->httpstep.httpstep->post_type)
+		zbx_free(job->httpstep.posts);
+
+	zbx_free(job->httpstep.url);
+	zbx_free(job->httpstep.headers);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: prepares the next step of web scenario for execution              *
+ *                                                                            *
+ * Parameters: job - [IN] the web scenario                                    *
+ *                                                                            *
+ * Return value: SUCCEED - the step easy handle is ready to be performed      *
+ *               FAIL    - there are no more steps or step preparation failed *
+ *                         (job->err_str is set)                              *
+ *                                                                            *
+ ******************************************************************************/
+static int	httpstep_prepare(zbx_httptest_job_t *job)
 {
-	zbx_db_result_t	result;
-	zbx_db_httpstep	db_httpstep;
-	char		*err_str = NULL, *buffer = NULL;
-	int		lastfailedstep = 0;
-	zbx_timespec_t	ts;
-	double		speed_download = 0;
-	int		speed_download_num = 0;
-#ifdef HAVE_LIBCURL
 	zbx_db_row_t	row;
-	zbx_httpstat_t	stat;
-	char		errbuf[CURL_ERROR_SIZE];
-	CURL		*easyhandle = NULL;
+	zbx_httptest_t	*httptest = &job->httptest;
+	zbx_dc_host_t	*host = &job->host;
+	zbx_db_httpstep	*db_httpstep = &job->db_httpstep;
+	char		*header_cookie = NULL, *buffer = NULL;
 	CURLcode	err;
-	zbx_httpstep_t	httpstep;
-#endif
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() httptestid:" ZBX_FS_UI64 " name:'%s'",
-			__func__, httptest->httptest.httptestid, httptest->httptest.name);
+	size_t		(*curl_header_cb)(void *ptr, size_t size, size_t nmemb, void *userdata);
+	size_t		(*curl_body_cb)(void *ptr, size_t size, size_t nmemb, void *userdata);
 
-	result = zbx_db_select(
-			"select httpstepid,no,name,url,timeout,posts,required,status_codes,post_type,follow_redirects,"
-				"retrieve_mode"
-			" from httpstep"
-			" where httptestid=" ZBX_FS_UI64
-			" order by no",
-			httptest->httptest.httptestid);
+	if (NULL == (row = zbx_db_fetch(job->result)) || !ZBX_IS_RUNNING())
+		return FAIL;
 
-	buffer = zbx_strdup(buffer, httptest->httptest.delay);
-	zbx_substitute_simple_macros(NULL, NULL, NULL, NULL, &host->hostid, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
-				&buffer, MACRO_TYPE_COMMON, NULL, 0);
+	ZBX_STR2UINT64(db_httpstep->httpstepid, row[0]);
+	db_httpstep->httptestid = httptest->httptest.httptestid;
+	db_httpstep->no = atoi(row[1]);
+	db_httpstep->name = row[2];
 
-	/* Avoid the potential usage of uninitialized values when: */
-	/* 1) compile without libCURL support */
-	/* 2) update interval is invalid */
-	db_httpstep.name = NULL;
+	db_httpstep->url = zbx_strdup(NULL, row[3]);
+	zbx_substitute_simple_macros_unmasked(NULL, NULL, NULL, NULL, NULL, host, NULL, NULL, NULL, NULL, NULL,
+			NULL, &db_httpstep->url, MACRO_TYPE_HTTPTEST_FIELD, NULL, 0);
+	http_substitute_variables(httptest, &db_httpstep->url);
 
-	if (SUCCEED != zbx_is_time_suffix(buffer, delay, ZBX_LENGTH_UNLIMITED))
+	db_httpstep->required = zbx_strdup(NULL, row[6]);
+	zbx_substitute_simple_macros(NULL, NULL, NULL, NULL, NULL, host, NULL, NULL, NULL, NULL, NULL, NULL,
+			&db_httpstep->required, MACRO_TYPE_HTTPTEST_FIELD, NULL, 0);
+
+	db_httpstep->status_codes = zbx_strdup(NULL, row[7]);
+	zbx_substitute_simple_macros(NULL, NULL, NULL, NULL, &host->hostid, NULL, NULL, NULL, NULL, NULL, NULL,
+			NULL, &db_httpstep->status_codes, MACRO_TYPE_COMMON, NULL, 0);
+
+	db_httpstep->post_type = atoi(row[8]);
+
+	if (ZBX_POSTTYPE_RAW == db_httpstep->post_type)
 	{
-		err_str = zbx_dsprintf(err_str, "update interval \"%s\" is invalid", buffer);
-		lastfailedstep = -1;
-		*delay = ZBX_DEFAULT_INTERVAL;
-		goto httptest_error;
+		db_httpstep->posts = zbx_strdup(NULL, row[5]);
+		zbx_substitute_simple_macros_unmasked(NULL, NULL, NULL, NULL, NULL, host, NULL, NULL, NULL, NULL,
+				NULL, NULL, &db_httpstep->posts, MACRO_TYPE_HTTPTEST_FIELD, NULL, 0);
+		http_substitute_variables(httptest, &db_httpstep->posts);
 	}
+	else
+		db_httpstep->posts = NULL;
 
-#ifdef HAVE_LIBCURL
-	if (NULL == (easyhandle = curl_easy_init()))
+	if (SUCCEED != httpstep_load_pairs(host, &job->httpstep))
 	{
-		err_str = zbx_strdup(err_str, "cannot initialize cURL library");
-		goto clean;
+		job->err_str = zbx_strdup(job->err_str, "cannot load web scenario step data");
+		goto httpstep_error;
 	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_PROXY, httptest->httptest.http_proxy)) ||
-			CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_COOKIEFILE, "")) ||
-			CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_USERAGENT, httptest->httptest.agent)) ||
-			CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_ERRORBUFFER, errbuf)) ||
-			CURLE_OK != (err = curl_easy_setopt(easyhandle, ZBX_CURLOPT_ACCEPT_ENCODING, "")))
+	buffer = zbx_strdup(buffer, row[4]);
+	zbx_substitute_simple_macros(NULL, NULL, NULL, NULL, &host->hostid, NULL, NULL, NULL, NULL, NULL, NULL,
+			NULL, &buffer, MACRO_TYPE_COMMON, NULL, 0);
+
+	if (SUCCEED != zbx_is_time_suffix(buffer, &db_httpstep->timeout, ZBX_LENGTH_UNLIMITED))
 	{
-		err_str = zbx_strdup(err_str, curl_easy_strerror(err));
-		goto clean;
+		job->err_str = zbx_dsprintf(job->err_str, "timeout \"%s\" is invalid", buffer);
+		goto httpstep_error;
+	}
+	else if (db_httpstep->timeout < 1 || SEC_PER_HOUR < db_httpstep->timeout)
+	{
+		job->err_str = zbx_dsprintf(job->err_str, "timeout \"%s\" is out of 1-3600 seconds bounds", buffer);
+		goto httpstep_error;
 	}
 
-#if LIBCURL_VERSION_NUM >= 0x071304
-	/* CURLOPT_PROTOCOLS is supported starting with version 7.19.4 (0x071304) */
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_PROTOCOLS, CURLPROTO_HTTP | CURLPROTO_HTTPS)))
+	db_httpstep->follow_redirects = atoi(row[9]);
+	db_httpstep->retrieve_mode = atoi(row[10]);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() use step \"%s\"", __func__, db_httpstep->name);
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() use post \"%s\"", __func__, ZBX_NULL2EMPTY_STR(job->httpstep.posts));
+
+	if (CURLE_OK != (err = curl_easy_setopt(job->easyhandle, CURLOPT_POSTFIELDS, job->httpstep.posts)))
 	{
-		err_str = zbx_strdup(err_str, curl_easy_strerror(err));
-		goto clean;
+		job->err_str = zbx_strdup(job->err_str, curl_easy_strerror(err));
+		goto httpstep_error;
 	}
-#endif
 
-	if (SUCCEED != zbx_http_prepare_ssl(easyhandle, httptest->httptest.ssl_cert_file,
-			httptest->httptest.ssl_key_file, httptest->httptest.ssl_key_password,
-			httptest->httptest.verify_peer, httptest->httptest.verify_host, &err_str))
+	if (CURLE_OK != (err = curl_easy_setopt(job->easyhandle, CURLOPT_POST, (NULL != job->httpstep.posts &&
+			'\0' != *job->httpstep.posts) ? 1L : 0L)))
 	{
-		goto clean;
+		job->err_str = zbx_strdup(job->err_str, curl_easy_strerror(err));
+		goto httpstep_error;
 	}
 
-	httpstep.httptest = httptest;
-	httpstep.httpstep = &db_httpstep;
+	if (CURLE_OK != (err = curl_easy_setopt(job->easyhandle, CURLOPT_FOLLOWLOCATION,
+			0 == db_httpstep->follow_redirects ? 0L : 1L)))
+	{
+		job->err_str = zbx_strdup(job->err_str, curl_easy_strerror(err));
+		goto httpstep_error;
+	}
 
-	while (NULL != (row = zbx_db_fetch(result)) && ZBX_IS_RUNNING())
+	if (0 != db_httpstep->follow_redirects)
 	{
-		struct curl_slist	*headers_slist = NULL;
-		char			*header_cookie = NULL;
-		size_t			(*curl_header_cb)(void *ptr, size_t size, size_t nmemb, void *userdata);
-		size_t			(*curl_body_cb)(void *ptr, size_t size, size_t nmemb, void *userdata);
+		if (CURLE_OK != (err = curl_easy_setopt(job->easyhandle, CURLOPT_MAXREDIRS, ZBX_CURLOPT_MAXREDIRS)))
+		{
+			job->err_str = zbx_strdup(job->err_str, curl_easy_strerror(err));
+			goto httpstep_error;
+		}
+	}
 
-		/* NOTE: do not break or return from this block! */
-		/*       process_step_data() call is required! */
+	/* headers defined in a step overwrite headers defined in scenario */
+	if (NULL != job->httpstep.headers && '\0' != *job->httpstep.headers)
+		add_http_headers(job->httpstep.headers, &job->headers_slist, &header_cookie);
+	else if (NULL != httptest->headers && '\0' != *httptest->headers)
+		add_http_headers(httptest->headers, &job->headers_slist, &header_cookie);
 
-		ZBX_STR2UINT64(db_httpstep.httpstepid, row[0]);
-		db_httpstep.httptestid = httptest->httptest.httptestid;
-		db_httpstep.no = atoi(row[1]);
-		db_httpstep.name = row[2];
+	err = curl_easy_setopt(job->easyhandle, CURLOPT_COOKIE, header_cookie);
+	zbx_free(header_cookie);
 
-		db_httpstep.url = zbx_strdup(NULL, row[3]);
-		zbx_substitute_simple_macros_unmasked(NULL, NULL, NULL, NULL, NULL, host, NULL, NULL, NULL, NULL, NULL,
-				NULL, &db_httpstep.url, MACRO_TYPE_HTTPTEST_FIELD, NULL, 0);
-		http_substitute_variables(httptest, &db_httpstep.url);
+	if (CURLE_OK != err)
+	{
+		job->err_str = zbx_strdup(job->err_str, curl_easy_strerror(err));
+		goto httpstep_error;
+	}
 
-		db_httpstep.required = zbx_strdup(NULL, row[6]);
-		zbx_substitute_simple_macros(NULL, NULL, NULL, NULL, NULL, host, NULL, NULL, NULL, NULL, NULL, NULL,
-				&db_httpstep.required, MACRO_TYPE_HTTPTEST_FIELD, NULL, 0);
+	if (CURLE_OK != (err = curl_easy_setopt(job->easyhandle, CURLOPT_HTTPHEADER, job->headers_slist)))
+	{
+		job->err_str = zbx_strdup(job->err_str, curl_easy_strerror(err));
+		goto httpstep_error;
+	}
 
-		db_httpstep.status_codes = zbx_strdup(NULL, row[7]);
-		zbx_substitute_simple_macros(NULL, NULL, NULL, NULL, &host->hostid, NULL, NULL, NULL, NULL, NULL, NULL,
-				NULL, &db_httpstep.status_codes, MACRO_TYPE_COMMON, NULL, 0);
+	switch (db_httpstep->retrieve_mode)
+	{
+		case ZBX_RETRIEVE_MODE_CONTENT:
+			curl_header_cb = curl_ignore_cb;
+			curl_body_cb = curl_write_cb;
+			break;
+		case ZBX_RETRIEVE_MODE_BOTH:
+			curl_header_cb = curl_body_cb = curl_write_cb;
+			break;
+		case ZBX_RETRIEVE_MODE_HEADERS:
+			curl_header_cb = curl_write_cb;
+			curl_body_cb = curl_ignore_cb;
+			break;
+		default:
+			THIS_SHOULD_NEVER_HAPPEN;
+			job->err_str = zbx_strdup(job->err_str, "invalid retrieve mode");
+			goto httpstep_error;
+	}
 
-		db_httpstep.post_type = atoi(row[8]);
+	if (CURLE_OK != (err = curl_easy_setopt(job->easyhandle, CURLOPT_WRITEFUNCTION, curl_body_cb)) ||
+			CURLE_OK != (err = curl_easy_setopt(job->easyhandle, CURLOPT_HEADERFUNCTION, curl_header_cb)))
+	{
+		job->err_str = zbx_strdup(job->err_str, curl_easy_strerror(err));
+		goto httpstep_error;
+	}
 
-		if (ZBX_POSTTYPE_RAW == db_httpstep.post_type)
-		{
-			db_httpstep.posts = zbx_strdup(NULL, row[5]);
-			zbx_substitute_simple_macros_unmasked(NULL, NULL, NULL, NULL, NULL, host, NULL, NULL, NULL, NULL,
-					NULL, NULL, &db_httpstep.posts, MACRO_TYPE_HTTPTEST_FIELD, NULL, 0);
-			http_substitute_variables(httptest, &db_httpstep.posts);
-		}
-		else
-			db_httpstep.posts = NULL;
+	/* enable/disable fetching the body */
+	if (CURLE_OK != (err = curl_easy_setopt(job->easyhandle, CURLOPT_NOBODY,
+			ZBX_RETRIEVE_MODE_HEADERS == db_httpstep->retrieve_mode ? 1L : 0L)))
+	{
+		job->err_str = zbx_strdup(job->err_str, curl_easy_strerror(err));
+		goto httpstep_error;
+	}
 
-		if (SUCCEED != httpstep_load_pairs(host, &httpstep))
-		{
-			err_str = zbx_strdup(err_str, "cannot load web scenario step data");
-			goto httpstep_error;
-		}
+	if (SUCCEED != zbx_http_prepare_auth(job->easyhandle, httptest->httptest.authentication,
+			httptest->httptest.http_user, httptest->httptest.http_password, NULL, &job->err_str))
+	{
+		goto httpstep_error;
+	}
 
-		buffer = zbx_strdup(buffer, row[4]);
-		zbx_substitute_simple_macros(NULL, NULL, NULL, NULL, &host->hostid, NULL, NULL, NULL, NULL, NULL, NULL,
-				NULL, &buffer, MACRO_TYPE_COMMON, NULL, 0);
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() go to URL \"%s\"", __func__, job->httpstep.url);
 
-		if (SUCCEED != zbx_is_time_suffix(buffer, &db_httpstep.timeout, ZBX_LENGTH_UNLIMITED))
-		{
-			err_str = zbx_dsprintf(err_str, "timeout \"%s\" is invalid", buffer);
-			goto httpstep_error;
-		}
-		else if (db_httpstep.timeout < 1 || SEC_PER_HOUR < db_httpstep.timeout)
-		{
-			err_str = zbx_dsprintf(err_str, "timeout \"%s\" is out of 1-3600 seconds bounds", buffer);
-			goto httpstep_error;
-		}
+	if (CURLE_OK != (err = curl_easy_setopt(job->easyhandle, CURLOPT_TIMEOUT, (long)db_httpstep->timeout)) ||
+			CURLE_OK != (err = curl_easy_setopt(job->easyhandle, CURLOPT_URL, job->httpstep.url)))
+	{
+		job->err_str = zbx_strdup(job->err_str, curl_easy_strerror(err));
+		goto httpstep_error;
+	}
 
-		db_httpstep.follow_redirects = atoi(row[9]);
-		db_httpstep.retrieve_mode = atoi(row[10]);
+	memset(&job->page, 0, sizeof(job->page));
+	job->errbuf[0] = '\0';
 
-		memset(&stat, 0, sizeof(stat));
+	zbx_free(buffer);
 
-		zabbix_log(LOG_LEVEL_DEBUG, "%s() use step \"%s\"", __func__, db_httpstep.name);
-		zabbix_log(LOG_LEVEL_DEBUG, "%s() use post \"%s\"", __func__, ZBX_NULL2EMPTY_STR(httpstep.posts));
+	return SUCCEED;
+httpstep_error:
+	zbx_free(buffer);
+	httpstep_clean(job);
+	job->lastfailedstep = db_httpstep->no;
 
-		if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_POSTFIELDS, httpstep.posts)))
-		{
-			err_str = zbx_strdup(err_str, curl_easy_strerror(err));
-			goto httpstep_error;
-		}
+	return FAIL;
+}
 
-		if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_POST, (NULL != httpstep.posts &&
-				'\0' != *httpstep.posts) ? 1L : 0L)))
-		{
-			err_str = zbx_strdup(err_str, curl_easy_strerror(err));
-			goto httpstep_error;
-		}
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if failed step request must be retried and prepares the    *
+ *          easy handle for it                                                *
+ *                                                                            *
+ * Parameters: job - [IN] the web scenario                                    *
+ *             err - [IN] the step request result                             *
+ *                                                                            *
+ * Return value: SUCCEED - the request must be performed again                *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	httpstep_retry(zbx_httptest_job_t *job, CURLcode err)
+{
+	/* try to retrieve page several times depending on number of retries */
+	if (CURLE_OK == err || 0 >= --job->httptest.httptest.retries)
+		return FAIL;
 
-		if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_FOLLOWLOCATION,
-				0 == db_httpstep.follow_redirects ? 0L : 1L)))
-		{
-			err_str = zbx_strdup(err_str, curl_easy_strerror(err));
-			goto httpstep_error;
-		}
+	zbx_free(job->page.data);
+	memset(&job->page, 0, sizeof(job->page));
+	job->errbuf[0] = '\0';
 
-		if (0 != db_httpstep.follow_redirects)
-		{
-			if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_MAXREDIRS, ZBX_CURLOPT_MAXREDIRS)))
-			{
-				err_str = zbx_strdup(err_str, curl_easy_strerror(err));
-				goto httpstep_error;
-			}
-		}
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: processes result of performed web scenario step                   *
+ *                                                                            *
+ * Parameters: job - [IN] the web scenario                                    *
+ *             err - [IN] the step request result                             *
+ *                                                                            *
+ * Return value: SUCCEED - the step succeeded, scenario can continue          *
+ *               FAIL    - the step failed (job->err_str is set)              *
+ *                                                                            *
+ ******************************************************************************/
+static int	httpstep_process(zbx_httptest_job_t *job, CURLcode err)
+{
+	zbx_httptest_t	*httptest = &job->httptest;
+	zbx_db_httpstep	*db_httpstep = &job->db_httpstep;
+	zbx_httpstat_t	stat;
+	zbx_timespec_t	ts;
 
-		/* headers defined in a step overwrite headers defined in scenario */
-		if (NULL != httpstep.headers && '\0' != *httpstep.headers)
-			add_http_headers(httpstep.headers, &headers_slist, &header_cookie);
-		else if (NULL != httptest->headers && '\0' != *httptest->headers)
-			add_http_headers(httptest->headers, &headers_slist, &header_cookie);
+	memset(&stat, 0, sizeof(stat));
 
-		err = curl_easy_setopt(easyhandle, CURLOPT_COOKIE, header_cookie);
-		zbx_free(header_cookie);
+	if (CURLE_OK == err)
+	{
+		char	*var_err_str = NULL;
+
+		zabbix_log(LOG_LEVEL_TRACE, "%s() page.data from %s:'%s'", __func__, job->httpstep.url,
+				job->page.data);
 
-		if (CURLE_OK != err)
+		/* first get the data that is needed even if step fails */
+		if (CURLE_OK != (err = curl_easy_getinfo(job->easyhandle, CURLINFO_RESPONSE_CODE, &stat.rspcode)))
 		{
-			err_str = zbx_strdup(err_str, curl_easy_strerror(err));
-			goto httpstep_error;
+			job->err_str = zbx_strdup(job->err_str, curl_easy_strerror(err));
 		}
-
-		if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_HTTPHEADER, headers_slist)))
+		else if ('\0' != *db_httpstep->status_codes &&
+				FAIL == zbx_int_in_list(db_httpstep->status_codes, stat.rspcode))
 		{
-			err_str = zbx_strdup(err_str, curl_easy_strerror(err));
-			goto httpstep_error;
+			job->err_str = zbx_dsprintf(job->err_str, "response code \"%ld\" did not match any of the"
+					" required status codes \"%s\"", stat.rspcode, db_httpstep->status_codes);
 		}
 
-		switch (db_httpstep.retrieve_mode)
+		if (CURLE_OK != (err = curl_easy_getinfo(job->easyhandle, CURLINFO_TOTAL_TIME, &stat.total_time)) &&
+				NULL == job->err_str)
 		{
-			case ZBX_RETRIEVE_MODE_CONTENT:
-				curl_header_cb = curl_ignore_cb;
-				curl_body_cb = curl_write_cb;
-				break;
-			case ZBX_RETRIEVE_MODE_BOTH:
-				curl_header_cb = curl_body_cb = curl_write_cb;
-				break;
-			case ZBX_RETRIEVE_MODE_HEADERS:
-				curl_header_cb = curl_write_cb;
-				curl_body_cb = curl_ignore_cb;
-				break;
-			default:
-				THIS_SHOULD_NEVER_HAPPEN;
-				err_str = zbx_strdup(err_str, "invalid retrieve mode");
-				goto httpstep_error;
+			job->err_str = zbx_strdup(job->err_str, curl_easy_strerror(err));
 		}
 
-		if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_WRITEFUNCTION, curl_body_cb)) ||
-				CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_HEADERFUNCTION, curl_header_cb)))
+		if (CURLE_OK != (err = curl_easy_getinfo(job->easyhandle, ZBX_CURLINFO_SPEED_DOWNLOAD,
+				&stat.speed_download)) && NULL == job->err_str)
 		{
-			err_str = zbx_strdup(err_str, curl_easy_strerror(err));
-			goto httpstep_error;
+			job->err_str = zbx_strdup(job->err_str, curl_easy_strerror(err));
 		}
-
-		/* enable/disable fetching the body */
-		if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_NOBODY,
-				ZBX_RETRIEVE_MODE_HEADERS == db_httpstep.retrieve_mode ? 1L : 0L)))
+		else
 		{
-			err_str = zbx_strdup(err_str, curl_easy_strerror(err));
-			goto httpstep_error;
+			job->speed_download += stat.speed_download;
+			job->speed_download_num++;
 		}
 
-		if (SUCCEED != zbx_http_prepare_auth(easyhandle, httptest->httptest.authentication,
-				httptest->httptest.http_user, httptest->httptest.http_password, NULL, &err_str))
+		/* required pattern */
+		if (NULL == job->err_str && '\0' != *db_httpstep->required &&
+				NULL == zbx_regexp_match(job->page.data, db_httpstep->required, NULL))
 		{
-			goto httpstep_error;
+			job->err_str = zbx_dsprintf(job->err_str, "required pattern \"%s\" was not found on %s",
+					db_httpstep->required, job->httpstep.url);
 		}
 
-		zabbix_log(LOG_LEVEL_DEBUG, "%s() go to URL \"%s\"", __func__, httpstep.url);
-
-		if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_TIMEOUT, (long)db_httpstep.timeout)) ||
-				CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_URL, httpstep.url)))
+		/* variables defined in scenario */
+		if (NULL == job->err_str && FAIL == http_process_variables(httptest, &httptest->variables,
+				job->page.data, &var_err_str))
 		{
-			err_str = zbx_strdup(err_str, curl_easy_strerror(err));
-			goto httpstep_error;
+			char	*variables = NULL;
+			size_t	alloc_len = 0, offset;
+
+			httpstep_pairs_join(&variables, &alloc_len, &offset, "=", " ", &httptest->variables);
+
+			job->err_str = zbx_dsprintf(job->err_str, "error in scenario variables \"%s\": %s", variables,
+					var_err_str);
+
+			zbx_free(variables);
 		}
 
-		/* try to retrieve page several times depending on number of retries */
-		do
+		/* variables defined in a step */
+		if (NULL == job->err_str && FAIL == http_process_variables(httptest, &job->httpstep.variables,
+				job->page.data, &var_err_str))
 		{
-			memset(&page, 0, sizeof(page));
-			errbuf[0] = '\0';
+			char	*variables = NULL;
+			size_t	alloc_len = 0, offset;
 
-			if (CURLE_OK == (err = curl_easy_perform(easyhandle)))
-				break;
+			httpstep_pairs_join(&variables, &alloc_len, &offset, "=", " ", &job->httpstep.variables);
 
-			zbx_free(page.data);
+			job->err_str = zbx_dsprintf(job->err_str, "error in step variables \"%s\": %s", variables,
+					var_err_str);
+
+			zbx_free(variables);
 		}
-		while (0 < --httptest->httptest.retries);
 
-		curl_slist_free_all(headers_slist);	/* must be called after curl_easy_perform() */
+		zbx_free(var_err_str);
 
-		if (CURLE_OK == err)
-		{
-			char	*var_err_str = NULL;
+		zbx_timespec(&ts);
+		process_step_data(db_httpstep->httpstepid, &stat, &ts);
 
-			zabbix_log(LOG_LEVEL_TRACE, "%s() page.data from %s:'%s'", __func__, httpstep.url, page.data);
+		zbx_free(job->page.data);
+	}
+	else
+	{
+		job->err_str = zbx_dsprintf(job->err_str, "%s", 0 < strlen(job->errbuf) ? job->errbuf :
+				curl_easy_strerror(err));
+		zbx_free(job->page.data);
+	}
 
-			/* first get the data that is needed even if step fails */
-			if (CURLE_OK != (err = curl_easy_getinfo(easyhandle, CURLINFO_RESPONSE_CODE, &stat.rspcode)))
-			{
-				err_str = zbx_strdup(err_str, curl_easy_strerror(err));
-			}
-			else if ('\0' != *db_httpstep.status_codes &&
-					FAIL == zbx_int_in_list(db_httpstep.status_codes, stat.rspcode))
-			{
-				err_str = zbx_dsprintf(err_str, "response code \"%ld\" did not match any of the"
-						" required status codes \"%s\"", stat.rspcode,
-						db_httpstep.status_codes);
-			}
+	httpstep_clean(job);
 
-			if (CURLE_OK != (err = curl_easy_getinfo(easyhandle, CURLINFO_TOTAL_TIME, &stat.total_time)) &&
-					NULL == err_str)
-			{
-				err_str = zbx_strdup(err_str, curl_easy_strerror(err));
-			}
+	if (NULL != job->err_str)
+	{
+		job->lastfailedstep = db_httpstep->no;
+		return FAIL;
+	}
 
-			if (CURLE_OK != (err = curl_easy_getinfo(easyhandle, ZBX_CURLINFO_SPEED_DOWNLOAD,
-					&stat.speed_download)) && NULL == err_str)
-			{
-				err_str = zbx_strdup(err_str, curl_easy_strerror(err));
-			}
-			else
-			{
-				speed_download += stat.speed_download;
-				speed_download_num++;
-			}
+	return SUCCEED;
+}
 
-			/* required pattern */
-			if (NULL == err_str && '\0' != *db_httpstep.required &&
-					NULL == zbx_regexp_match(page.data, db_httpstep.required, NULL))
-			{
-				err_str = zbx_dsprintf(err_str, "required pattern \"%s\" was not found on %s",
-						db_httpstep.required, httpstep.url);
-			}
+/******************************************************************************
+ *                                                                            *
+ * Purpose: executes web scenario steps until a step request is started or    *
+ *          scenario is finished                                              *
+ *                                                                            *
+ * Parameters: job   - [IN] the web scenario                                  *
+ *             multi - [IN] the curl multi handle, NULL if libcurl does not   *
+ *                          support multi interface waiting                   *
+ *                                                                            *
+ * Return value: SUCCEED - step request was added to the multi handle         *
+ *               FAIL    - the scenario is finished                           *
+ *                                                                            *
+ ******************************************************************************/
+static int	httptest_job_run(zbx_httptest_job_t *job, CURLM *multi)
+{
+	while (SUCCEED == httpstep_prepare(job))
+	{
+		CURLcode	err;
 
-			/* variables defined in scenario */
-			if (NULL == err_str && FAIL == http_process_variables(httptest, &httptest->variables, page.data,
-					&var_err_str))
-			{
-				char	*variables = NULL;
-				size_t	alloc_len = 0, offset;
+#ifdef ZBX_HTTPTEST_MULTI
+		CURLMcode	merr;
 
-				httpstep_pairs_join(&variables, &alloc_len, &offset, "=", " ", &httptest->variables);
+		if (CURLM_OK == (merr = curl_multi_add_handle(multi, job->easyhandle)))
+			return SUCCEED;
 
-				err_str = zbx_dsprintf(err_str, "error in scenario variables \"%s\": %s", variables,
-						var_err_str);
+		job->err_str = zbx_strdup(job->err_str, curl_multi_strerror(merr));
+		err = CURLE_FAILED_INIT;
+#else
+		ZBX_UNUSED(multi);
 
-				zbx_free(variables);
-			}
+		while (CURLE_OK != (err = curl_easy_perform(job->easyhandle)) && SUCCEED == httpstep_retry(job, err))
+			;
+#endif
+		if (SUCCEED != httpstep_process(job, err))
+			break;
+	}
 
-			/* variables defined in a step */
-			if (NULL == err_str && FAIL == http_process_variables(httptest, &httpstep.variables, page.data,
-					&var_err_str))
-			{
-				char	*variables = NULL;
-				size_t	alloc_len = 0, offset;
+	return FAIL;
+}
+#endif	/* HAVE_LIBCURL */
 
-				httpstep_pairs_join(&variables, &alloc_len, &offset, "=", " ", &httpstep.variables);
+/******************************************************************************
+ *                                                                            *
+ * Purpose: starts execution of web scenario                                  *
+ *                                                                            *
+ * Parameters: job   - [IN] the web scenario                                  *
+ *             multi - [IN] the curl multi handle                             *
+ *                                                                            *
+ * Return value: SUCCEED - the first step request was started                 *
+ *               FAIL    - the scenario is finished                           *
+ *                                                                            *
+ ******************************************************************************/
+static int	httptest_job_start(zbx_httptest_job_t *job, void *multi)
+{
+	char		*buffer = NULL;
+	int		ret = FAIL;
+	zbx_httptest_t	*httptest = &job->httptest;
+#ifdef HAVE_LIBCURL
+	CURLcode	err;
+#endif
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() httptestid:" ZBX_FS_UI64 " name:'%s'",
+			__func__, httptest->httptest.httptestid, httptest->httptest.name);
 
-				err_str = zbx_dsprintf(err_str, "error in step variables \"%s\": %s", variables,
-						var_err_str);
+	job->result = zbx_db_select(
+			"select httpstepid,no,name,url,timeout,posts,required,status_codes,post_type,follow_redirects,"
+				"retrieve_mode"
+			" from httpstep"
+			" where httptestid=" ZBX_FS_UI64
+			" order by no",
+			httptest->httptest.httptestid);
 
-				zbx_free(variables);
-			}
+	buffer = zbx_strdup(buffer, httptest->httptest.delay);
+	zbx_substitute_simple_macros(NULL, NULL, NULL, NULL, &job->host.hostid, NULL, NULL, NULL, NULL, NULL, NULL,
+			NULL, &buffer, MACRO_TYPE_COMMON, NULL, 0);
 
-			zbx_free(var_err_str);
+	/* Avoid the potential usage of uninitialized values when: */
+	/* 1) compile without libCURL support */
+	/* 2) update interval is invalid */
+	job->db_httpstep.name = NULL;
 
-			zbx_timespec(&ts);
-			process_step_data(db_httpstep.httpstepid, &stat, &ts);
+	if (SUCCEED != zbx_is_time_suffix(buffer, &job->delay, ZBX_LENGTH_UNLIMITED))
+	{
+		job->err_str = zbx_dsprintf(job->err_str, "update interval \"%s\" is invalid", buffer);
+		job->lastfailedstep = -1;
+		job->delay = ZBX_DEFAULT_INTERVAL;
+		goto out;
+	}
 
-			zbx_free(page.data);
-		}
-		else
-			err_str = zbx_dsprintf(err_str, "%s", 0 < strlen(errbuf) ? errbuf : curl_easy_strerror(err));
+#ifdef HAVE_LIBCURL
+	if (NULL == (job->easyhandle = curl_easy_init()))
+	{
+		job->err_str = zbx_strdup(job->err_str, "cannot initialize cURL library");
+		goto out;
+	}
 
-httpstep_error:
-		zbx_free(db_httpstep.status_codes);
-		zbx_free(db_httpstep.required);
-		zbx_free(db_httpstep.posts);
-		zbx_free(db_httpstep.url);
+	if (CURLE_OK != (err = curl_easy_setopt(job->easyhandle, CURLOPT_PROXY, httptest->httptest.http_proxy)) ||
+			CURLE_OK != (err = curl_easy_setopt(job->easyhandle, CURLOPT_COOKIEFILE, "")) ||
+			CURLE_OK != (err = curl_easy_setopt(job->easyhandle, CURLOPT_USERAGENT,
+					httptest->httptest.agent)) ||
+			CURLE_OK != (err = curl_easy_setopt(job->easyhandle, CURLOPT_ERRORBUFFER, job->errbuf)) ||
+			CURLE_OK != (err = curl_easy_setopt(job->easyhandle, CURLOPT_WRITEDATA, &job->page)) ||
+			CURLE_OK != (err = curl_easy_setopt(job->easyhandle, CURLOPT_HEADERDATA, &job->page)) ||
+			CURLE_OK != (err = curl_easy_setopt(job->easyhandle, CURLOPT_PRIVATE, job)) ||
+			CURLE_OK != (err = curl_easy_setopt(job->easyhandle, ZBX_CURLOPT_ACCEPT_ENCODING, "")))
+	{
+		job->err_str = zbx_strdup(job->err_str, curl_easy_strerror(err));
+		goto out;
+	}
 
-		httppairs_free(&httpstep.variables);
+	/* cookies are not shared, each scenario keeps its own cookie engine state */
+	if (NULL == share && NULL != (share = curl_share_init()))
+	{
+		curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+#if LIBCURL_VERSION_NUM >= 0x071700
+		/* TLS session sharing is supported starting with version 7.23.0 (0x071700) */
+		curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+#endif
+#if LIBCURL_VERSION_NUM >= 0x073900
+		/* connection cache sharing is supported starting with version 7.57.0 (0x073900) */
+		curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+#endif
+	}
 
-		if (ZBX_POSTTYPE_FORM == httpstep.httpstep->post_type)
-			zbx_free(httpstep.posts);
+	if (NULL != share && CURLE_OK != (err = curl_easy_setopt(job->easyhandle, CURLOPT_SHARE, share)))
+	{
+		job->err_str = zbx_strdup(job->err_str, curl_easy_strerror(err));
+		goto out;
+	}
 
-		zbx_free(httpstep.url);
-		zbx_free(httpstep.headers);
+#if LIBCURL_VERSION_NUM >= 0x071304
+	/* CURLOPT_PROTOCOLS is supported starting with version 7.19.4 (0x071304) */
+	if (CURLE_OK != (err = curl_easy_setopt(job->easyhandle, CURLOPT_PROTOCOLS, CURLPROTO_HTTP | CURLPROTO_HTTPS)))
+	{
+		job->err_str = zbx_strdup(job->err_str, curl_easy_strerror(err));
+		goto out;
+	}
+#endif
 
-		if (NULL != err_str)
-		{
-			lastfailedstep = db_httpstep.no;
-			break;
-		}
+	if (SUCCEED != zbx_http_prepare_ssl(job->easyhandle, httptest->httptest.ssl_cert_file,
+			httptest->httptest.ssl_key_file, httptest->httptest.ssl_key_password,
+			httptest->httptest.verify_peer, httptest->httptest.verify_host, &job->err_str))
+	{
+		goto out;
 	}
-clean:
-	curl_easy_cleanup(easyhandle);
+
+	job->httpstep.httptest = httptest;
+	job->httpstep.httpstep = &job->db_httpstep;
+
+	ret = httptest_job_run(job, (CURLM *)multi);
 #else
-	err_str = zbx_strdup(err_str, "cURL library is required for Web monitoring support");
+	ZBX_UNUSED(multi);
+	job->err_str = zbx_strdup(job->err_str, "cURL library is required for Web monitoring support");
 #endif	/* HAVE_LIBCURL */
+out:
+	zbx_free(buffer);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: loads web scenario configuration                                  *
+ *                                                                            *
+ * Parameters: httptestid - [IN] the web scenario identifier                  *
+ *                                                                            *
+ * Return value: The web scenario or NULL if it cannot be processed.          *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_httptest_job_t	*httptest_job_create(zbx_uint64_t httptestid)
+{
+	zbx_db_result_t		result;
+	zbx_db_row_t		row;
+	zbx_httptest_job_t	*job = NULL;
+	zbx_httptest_t		*httptest;
+	zbx_dc_host_t		*host;
+
+	result = zbx_db_select(
+			"select h.hostid,h.host,h.name,t.httptestid,t.name,t.agent,"
+				"t.authentication,t.http_user,t.http_password,t.http_proxy,t.retries,t.ssl_cert_file,"
+				"t.ssl_key_file,t.ssl_key_password,t.verify_peer,t.verify_host,t.delay"
+			" from httptest t,hosts h"
+			" where t.hostid=h.hostid"
+				" and t.httptestid=" ZBX_FS_UI64,
+			httptestid);
+
+	if (NULL == (row = zbx_db_fetch(result)))
+		goto out;
+
+	job = (zbx_httptest_job_t *)zbx_malloc(NULL, sizeof(zbx_httptest_job_t));
+	memset(job, 0, sizeof(zbx_httptest_job_t));
+
+	host = &job->host;
+	httptest = &job->httptest;
+
+	ZBX_STR2UINT64(host->hostid, row[0]);
+	zbx_strscpy(host->host, row[1]);
+	zbx_strlcpy_utf8(host->name, row[2], sizeof(host->name));
 
-httptest_error:
+	/* create macro cache to use in http test */
+	zbx_vector_ptr_pair_create(&httptest->macros);
+
+	ZBX_STR2UINT64(httptest->httptest.httptestid, row[3]);
+	httptest->httptest.name = zbx_strdup(NULL, row[4]);
+
+	if (SUCCEED != httptest_load_pairs(host, httptest))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot process web scenario \"%s\" on host \"%s\": "
+				"cannot load web scenario data", httptest->httptest.name, host->name);
+		THIS_SHOULD_NEVER_HAPPEN;
+		zbx_vector_ptr_pair_destroy(&httptest->macros);
+		zbx_free(httptest->httptest.name);
+		zbx_free(job);
+		goto out;
+	}
+
+	httptest->httptest.agent = zbx_strdup(NULL, row[5]);
+	zbx_substitute_simple_macros(NULL, NULL, NULL, NULL, &host->hostid, NULL, NULL, NULL, NULL, NULL,
+			NULL, NULL, &httptest->httptest.agent, MACRO_TYPE_COMMON, NULL, 0);
+
+	if (HTTPTEST_AUTH_NONE != (httptest->httptest.authentication = atoi(row[6])))
+	{
+		httptest->httptest.http_user = zbx_strdup(NULL, row[7]);
+		zbx_substitute_simple_macros_unmasked(NULL, NULL, NULL, NULL, &host->hostid, NULL, NULL,
+				NULL, NULL, NULL, NULL, NULL, &httptest->httptest.http_user,
+				MACRO_TYPE_COMMON, NULL, 0);
+
+		httptest->httptest.http_password = zbx_strdup(NULL, row[8]);
+		zbx_substitute_simple_macros_unmasked(NULL, NULL, NULL, NULL, &host->hostid, NULL, NULL,
+				NULL, NULL, NULL, NULL, NULL, &httptest->httptest.http_password,
+				MACRO_TYPE_COMMON, NULL, 0);
+	}
+
+	if ('\0' != *row[9])
+	{
+		httptest->httptest.http_proxy = zbx_strdup(NULL, row[9]);
+		zbx_substitute_simple_macros(NULL, NULL, NULL, NULL, &host->hostid, NULL, NULL, NULL,
+				NULL, NULL, NULL, NULL, &httptest->httptest.http_proxy,
+				MACRO_TYPE_COMMON, NULL, 0);
+	}
+	else
+		httptest->httptest.http_proxy = NULL;
+
+	httptest->httptest.retries = atoi(row[10]);
+
+	httptest->httptest.ssl_cert_file = zbx_strdup(NULL, row[11]);
+	zbx_substitute_simple_macros(NULL, NULL, NULL, NULL, NULL, host, NULL, NULL, NULL, NULL, NULL,
+			NULL, &httptest->httptest.ssl_cert_file, MACRO_TYPE_HTTPTEST_FIELD, NULL, 0);
+
+	httptest->httptest.ssl_key_file = zbx_strdup(NULL, row[12]);
+	zbx_substitute_simple_macros(NULL, NULL, NULL, NULL, NULL, host, NULL, NULL, NULL, NULL, NULL,
+			NULL, &httptest->httptest.ssl_key_file, MACRO_TYPE_HTTPTEST_FIELD, NULL, 0);
+
+	httptest->httptest.ssl_key_password = zbx_strdup(NULL, row[13]);
+	zbx_substitute_simple_macros_unmasked(NULL, NULL, NULL, NULL, &host->hostid, NULL, NULL, NULL,
+			NULL, NULL, NULL, NULL, &httptest->httptest.ssl_key_password, MACRO_TYPE_COMMON,
+			NULL, 0);
+
+	httptest->httptest.verify_peer = atoi(row[14]);
+	httptest->httptest.verify_host = atoi(row[15]);
+
+	httptest->httptest.delay = zbx_strdup(NULL, row[16]);
+
+	/* add httptest variables to the current test macro cache */
+	http_process_variables(httptest, &httptest->variables, NULL, NULL);
+out:
+	zbx_db_free_result(result);
+
+	return job;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: finishes web scenario execution - updates scenario items,         *
+ *          reschedules the scenario and frees its data                       *
+ *                                                                            *
+ * Parameters: job - [IN] the web scenario                                    *
+ *             now - [IN] the current timestamp                               *
+ *                                                                            *
+ ******************************************************************************/
+static void	httptest_job_finish(zbx_httptest_job_t *job, int now)
+{
+	zbx_timespec_t	ts;
+	zbx_httptest_t	*httptest = &job->httptest;
+
+#ifdef HAVE_LIBCURL
+	if (NULL != job->easyhandle)
+		curl_easy_cleanup(job->easyhandle);
+#endif
 	zbx_timespec(&ts);
 
-	if (NULL != err_str)
+	if (NULL != job->err_str)
 	{
-		if (0 >= lastfailedstep)
+		if (0 >= job->lastfailedstep)
 		{
 			/* we are here because web scenario update interval is invalid, */
 			/* cURL initialization failed or we have been compiled without cURL library */
 
-			lastfailedstep = 1;
+			job->lastfailedstep = 1;
 		}
 
-		if (NULL != db_httpstep.name)
+		if (NULL != job->db_httpstep.name)
 		{
 			zabbix_log(LOG_LEVEL_DEBUG, "cannot process step \"%s\" of web scenario \"%s\" on host \"%s\": "
-					"%s", db_httpstep.name, httptest->httptest.name, host->name, err_str);
+					"%s", job->db_httpstep.name, httptest->httptest.name, job->host.name,
+					job->err_str);
 		}
 	}
-	zbx_db_free_result(result);
+	zbx_db_free_result(job->result);
 
-	if (0 != speed_download_num)
-		speed_download /= speed_download_num;
+	if (0 != job->speed_download_num)
+		job->speed_download /= job->speed_download_num;
 
-	process_test_data(httptest->httptest.httptestid, lastfailedstep, speed_download, err_str, &ts);
+	process_test_data(httptest->httptest.httptestid, job->lastfailedstep, job->speed_download, job->err_str,
+			&ts);
 
-	zbx_free(buffer);
-	zbx_free(err_str);
+	zbx_free(job->err_str);
 	zbx_preprocessor_flush();
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+	zbx_dc_httptest_queue(now, httptest->httptest.httptestid, job->delay);
+
+	zbx_free(httptest->httptest.delay);
+	zbx_free(httptest->httptest.ssl_key_password);
+	zbx_free(httptest->httptest.ssl_key_file);
+	zbx_free(httptest->httptest.ssl_cert_file);
+	zbx_free(httptest->httptest.http_proxy);
+
+	if (HTTPTEST_AUTH_NONE != httptest->httptest.authentication)
+	{
+		zbx_free(httptest->httptest.http_password);
+		zbx_free(httptest->httptest.http_user);
+	}
+	zbx_free(httptest->httptest.agent);
+	zbx_free(httptest->httptest.name);
+	zbx_free(httptest->headers);
+	httppairs_free(&httptest->variables);
+
+	/* destroy the macro cache used in this http test */
+	httptest_remove_macros(httptest);
+	zbx_vector_ptr_pair_destroy(&httptest->macros);
+
+	zbx_free(job);
+}
+
+#ifdef ZBX_HTTPTEST_MULTI
+/******************************************************************************
+ *                                                                            *
+ * Purpose: waits for step requests of running web scenarios and proceeds     *
+ *          with the scenarios which step requests have completed             *
+ *                                                                            *
+ * Parameters: multi - [IN] the curl multi handle                             *
+ *             now   - [IN] the current timestamp                             *
+ *                                                                            *
+ * Return value: The number of finished web scenarios.                        *
+ *                                                                            *
+ ******************************************************************************/
+static int	httptest_jobs_perform(CURLM *multi, int now)
+{
+	int		running, msgnum, finished_num = 0;
+	CURLMsg		*msg;
+	CURLMcode	code;
+
+	if (CURLM_OK != (code = curl_multi_perform(multi, &running)))
+		zabbix_log(LOG_LEVEL_WARNING, "cannot perform on curl multi handle: %s", curl_multi_strerror(code));
+
+	while (NULL != (msg = curl_multi_info_read(multi, &msgnum)))
+	{
+		zbx_httptest_job_t	*job;
+		char			*priv;
+		CURLcode		err;
+
+		if (CURLMSG_DONE != msg->msg)
+			continue;
+
+		curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, &priv);
+		job = (zbx_httptest_job_t *)priv;
+		err = msg->data.result;
+
+		/* the message must not be accessed after the handle is removed */
+		curl_multi_remove_handle(multi, job->easyhandle);
+
+		if (SUCCEED == httpstep_retry(job, err) && CURLM_OK == curl_multi_add_handle(multi, job->easyhandle))
+			continue;
+
+		if (SUCCEED == httpstep_process(job, err) && SUCCEED == httptest_job_run(job, multi))
+			continue;
+
+		httptest_job_finish(job, now);
+		finished_num++;
+	}
+
+	if (0 != running && CURLM_OK != (code = curl_multi_wait(multi, NULL, 0, ZBX_HTTPTEST_WAIT_TIMEOUT, NULL)))
+		zabbix_log(LOG_LEVEL_WARNING, "cannot wait on curl multi handle: %s", curl_multi_strerror(code));
+
+	return finished_num;
 }
+#endif
 
 /******************************************************************************
  *                                                                            *
@@ -1031,139 +1420,65 @@ httptest_error:
  *                                                                            *
  * Return value: number of processed httptests                                *
  *                                                                            *
- * Comments: always SUCCEED                                                   *
+ * Comments: Up to ZBX_HTTPTEST_JOBS_MAX web scenarios are executed           *
+ *           concurrently, steps of each scenario are executed in order.      *
  *                                                                            *
  ******************************************************************************/
 int	process_httptests(int now, time_t *nextcheck)
 {
-	zbx_db_result_t		result;
-	zbx_db_row_t		row;
 	zbx_uint64_t		httptestid;
-	zbx_httptest_t		httptest;
-	zbx_dc_host_t		host;
-	int			httptests_count = 0;
+	int			httptests_count = 0, jobs_num = 0, next;
 	zbx_dc_um_handle_t	*um_handle;
+	zbx_httptest_job_t	*job;
+	void			*multi = NULL;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	if (SUCCEED != zbx_dc_httptest_next(now, &httptestid, nextcheck))
+	if (SUCCEED != (next = zbx_dc_httptest_next(now, &httptestid, nextcheck)))
 		goto out;
 
 	um_handle = zbx_dc_open_user_macros();
 
-	/* create macro cache to use in http tests */
-	zbx_vector_ptr_pair_create(&httptest.macros);
-
-	do
+#ifdef ZBX_HTTPTEST_MULTI
+	if (NULL == (multi = curl_multi_init()))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot initialize cURL multi session");
+		zbx_dc_httptest_queue(now, httptestid, ZBX_DEFAULT_INTERVAL);
+		goto clean;
+	}
+#endif
+	for (;;)
 	{
-		int	delay = 0;
-
-		result = zbx_db_select(
-				"select h.hostid,h.host,h.name,t.httptestid,t.name,t.agent,"
-					"t.authentication,t.http_user,t.http_password,t.http_proxy,t.retries,t.ssl_cert_file,"
-					"t.ssl_key_file,t.ssl_key_password,t.verify_peer,t.verify_host,t.delay"
-				" from httptest t,hosts h"
-				" where t.hostid=h.hostid"
-					" and t.httptestid=" ZBX_FS_UI64,
-				httptestid);
-
-		if (NULL != (row = zbx_db_fetch(result)))
+		/* start new web scenarios until the concurrency limit is reached */
+		while (SUCCEED == next && ZBX_HTTPTEST_JOBS_MAX > jobs_num)
 		{
-			ZBX_STR2UINT64(host.hostid, row[0]);
-			zbx_strscpy(host.host, row[1]);
-			zbx_strlcpy_utf8(host.name, row[2], sizeof(host.name));
-
-			ZBX_STR2UINT64(httptest.httptest.httptestid, row[3]);
-			httptest.httptest.name = row[4];
-
-			if (SUCCEED != httptest_load_pairs(&host, &httptest))
-			{
-				zabbix_log(LOG_LEVEL_WARNING, "cannot process web scenario \"%s\" on host \"%s\": "
-						"cannot load web scenario data", httptest.httptest.name, host.name);
-				zbx_db_free_result(result);
-				THIS_SHOULD_NEVER_HAPPEN;
-				continue;
-			}
-
-			httptest.httptest.agent = zbx_strdup(NULL, row[5]);
-			zbx_substitute_simple_macros(NULL, NULL, NULL, NULL, &host.hostid, NULL, NULL, NULL, NULL, NULL,
-					NULL, NULL, &httptest.httptest.agent, MACRO_TYPE_COMMON, NULL, 0);
-
-			if (HTTPTEST_AUTH_NONE != (httptest.httptest.authentication = atoi(row[6])))
-			{
-				httptest.httptest.http_user = zbx_strdup(NULL, row[7]);
-				zbx_substitute_simple_macros_unmasked(NULL, NULL, NULL, NULL, &host.hostid, NULL, NULL,
-						NULL, NULL, NULL, NULL, NULL, &httptest.httptest.http_user,
-						MACRO_TYPE_COMMON, NULL, 0);
-
-				httptest.httptest.http_password = zbx_strdup(NULL, row[8]);
-				zbx_substitute_simple_macros_unmasked(NULL, NULL, NULL, NULL, &host.hostid, NULL, NULL,
-						NULL, NULL, NULL, NULL, NULL, &httptest.httptest.http_password,
-						MACRO_TYPE_COMMON, NULL, 0);
-			}
-
-			if ('\0' != *row[9])
+			if (NULL != (job = httptest_job_create(httptestid)))
 			{
-				httptest.httptest.http_proxy = zbx_strdup(NULL, row[9]);
-				zbx_substitute_simple_macros(NULL, NULL, NULL, NULL, &host.hostid, NULL, NULL, NULL,
-						NULL, NULL, NULL, NULL, &httptest.httptest.http_proxy,
-						MACRO_TYPE_COMMON, NULL, 0);
-			}
-			else
-				httptest.httptest.http_proxy = NULL;
-
-			httptest.httptest.retries = atoi(row[10]);
-
-			httptest.httptest.ssl_cert_file = zbx_strdup(NULL, row[11]);
-			zbx_substitute_simple_macros(NULL, NULL, NULL, NULL, NULL, &host, NULL, NULL, NULL, NULL, NULL,
-					NULL, &httptest.httptest.ssl_cert_file, MACRO_TYPE_HTTPTEST_FIELD, NULL, 0);
-
-			httptest.httptest.ssl_key_file = zbx_strdup(NULL, row[12]);
-			zbx_substitute_simple_macros(NULL, NULL, NULL, NULL, NULL, &host, NULL, NULL, NULL, NULL, NULL,
-					NULL, &httptest.httptest.ssl_key_file, MACRO_TYPE_HTTPTEST_FIELD, NULL, 0);
-
-			httptest.httptest.ssl_key_password = zbx_strdup(NULL, row[13]);
-			zbx_substitute_simple_macros_unmasked(NULL, NULL, NULL, NULL, &host.hostid, NULL, NULL, NULL,
-					NULL, NULL, NULL, NULL, &httptest.httptest.ssl_key_password, MACRO_TYPE_COMMON,
-					NULL, 0);
-
-			httptest.httptest.verify_peer = atoi(row[14]);
-			httptest.httptest.verify_host = atoi(row[15]);
-
-			httptest.httptest.delay = row[16];
+				if (SUCCEED == httptest_job_start(job, multi))
+					jobs_num++;
+				else
+					httptest_job_finish(job, now);
 
-			/* add httptest variables to the current test macro cache */
-			http_process_variables(&httptest, &httptest.variables, NULL, NULL);
-
-			process_httptest(&host, &httptest, &delay);
-			zbx_dc_httptest_queue(now, httptestid, delay);
-
-			zbx_free(httptest.httptest.ssl_key_password);
-			zbx_free(httptest.httptest.ssl_key_file);
-			zbx_free(httptest.httptest.ssl_cert_file);
-			zbx_free(httptest.httptest.http_proxy);
-
-			if (HTTPTEST_AUTH_NONE != httptest.httptest.authentication)
-			{
-				zbx_free(httptest.httptest.http_password);
-				zbx_free(httptest.httptest.http_user);
+				httptests_count++;	/* performance metric */
 			}
-			zbx_free(httptest.httptest.agent);
-			zbx_free(httptest.headers);
-			httppairs_free(&httptest.variables);
-
-			/* clear the macro cache used in this http test */
-			httptest_remove_macros(&httptest);
 
-			httptests_count++;	/* performance metric */
+			next = ZBX_IS_RUNNING() ? zbx_dc_httptest_next(now, &httptestid, nextcheck) : FAIL;
 		}
-		zbx_db_free_result(result);
-	}
-	while (ZBX_IS_RUNNING() && SUCCEED == zbx_dc_httptest_next(now, &httptestid, nextcheck));
 
-	/* destroy the macro cache used in http tests */
-	zbx_vector_ptr_pair_destroy(&httptest.macros);
+		if (0 == jobs_num)
+			break;
+#ifdef ZBX_HTTPTEST_MULTI
+		jobs_num -= httptest_jobs_perform((CURLM *)multi, now);
+#else
+		THIS_SHOULD_NEVER_HAPPEN;
+		break;
+#endif
+	}
 
+#ifdef ZBX_HTTPTEST_MULTI
+	curl_multi_cleanup((CURLM *)multi);
+clean:
+#endif
 	zbx_dc_close_user_macros(um_handle);
 out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
@@ -140,6 +140,8 @@ typedef struct zbx_ipmi_host
 	unsigned int		domain_nr;	/* Domain number. It is converted to text string and used as */
 						/* domain name. */
 	char			*err;
+	int			pending;	/* domain opening was started by zbx_open_ipmi_host() and its */
+						/* outcome was not consumed yet */
 	struct zbx_ipmi_host	*next;
 }
 zbx_ipmi_host_t;
@@ -147,6 +149,8 @@ zbx_ipmi_host_t;
 static unsigned int	domain_nr = 0;		/* for making a sequence of domain names "0", "1", "2", ... */
 static zbx_ipmi_host_t	*hosts = NULL;		/* head of single-linked list of monitored hosts */
 static os_handler_t	*os_hnd;
+static int		sessions_reused = 0;	/* checks served by already open sessions */
+static int		sessions_opened = 0;	/* attempts to open a session */
 
 static char	*zbx_sensor_id_to_str(char *str, size_t str_sz, const char *id, enum ipmi_str_type_e id_type, int id_sz)
 {
@@ -1474,10 +1478,17 @@ void	zbx_free_ipmi_handler(void)
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
-static zbx_ipmi_host_t	*zbx_init_ipmi_host(const char *ip, int port, int authtype, int privilege, const char *username,
-		const char *password)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: starts opening OpenIPMI domain (connection and SDR scan) of the   *
+ *          host without waiting for it to come up                            *
+ *                                                                            *
+ * Return value: SUCCEED - domain opening was started                         *
+ *               FAIL    - otherwise, h->err and h->ret are set               *
+ *                                                                            *
+ ******************************************************************************/
+static int	zbx_connect_ipmi_host(zbx_ipmi_host_t *h)
 {
-	zbx_ipmi_host_t		*h;
 	ipmi_open_option_t	options[4];
 
 	/* Although we use only one address and port we pass them in 2-element arrays. The reason is */
@@ -1493,19 +1504,7 @@ static zbx_ipmi_host_t	*zbx_init_ipmi_host(const char *ip, int port, int authtyp
 	char			*addrs[2] = {NULL}, *ports[2] = {NULL};
 
 	char			domain_name[11];	/* max int length */
-	int			ret;
-
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() host:'[%s]:%d'", __func__, ip, port);
-
-	/* Host already in the list? */
-
-	if (NULL != (h = zbx_get_ipmi_host(ip, port, authtype, privilege, username, password)))
-	{
-		if (1 == h->domain_up)
-			goto out;
-	}
-	else
-		h = zbx_allocate_ipmi_host(ip, port, authtype, privilege, username, password);
+	int			ret, res = FAIL;
 
 	h->ret = SUCCEED;
 	h->done = 0;
@@ -1554,16 +1553,157 @@ static zbx_ipmi_host_t	*zbx_init_ipmi_host(const char *ip, int port, int authtyp
 		goto out;
 	}
 
-	zbx_perform_openipmi_ops(h, __func__);	/* ignore returned result */
+	res = SUCCEED;
 out:
 	zbx_free(addrs[0]);
 	zbx_free(ports[0]);
 
+	return res;
+}
+
+static zbx_ipmi_host_t	*zbx_init_ipmi_host(const char *ip, int port, int authtype, int privilege, const char *username,
+		const char *password)
+{
+	zbx_ipmi_host_t		*h;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() host:'[%s]:%d'", __func__, ip, port);
+
+	/* Host already in the list? */
+
+	if (NULL != (h = zbx_get_ipmi_host(ip, port, authtype, privilege, username, password)))
+	{
+		if (1 == h->domain_up)
+		{
+			sessions_reused++;
+			goto out;
+		}
+
+		if (1 == h->pending)
+		{
+			/* domain opening was started by zbx_open_ipmi_host() together with other hosts, */
+			/* use its outcome instead of reconnecting                                       */
+			if (0 == h->done)
+				zbx_perform_openipmi_ops(h, __func__);	/* ignore returned result */
+
+			goto out;
+		}
+	}
+	else
+		h = zbx_allocate_ipmi_host(ip, port, authtype, privilege, username, password);
+
+	sessions_opened++;
+
+	if (SUCCEED == zbx_connect_ipmi_host(h))
+		zbx_perform_openipmi_ops(h, __func__);	/* ignore returned result */
+out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%p domain_nr:%u", __func__, (void *)h, h->domain_nr);
 
 	return h;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: starts opening session to IPMI host without waiting for it, so    *
+ *          that sessions to several hosts can be brought up concurrently     *
+ *                                                                            *
+ * Comments: The hosts are marked as pending until                            *
+ *           zbx_reset_pending_ipmi_hosts() is called. Checks of pending      *
+ *           hosts use the outcome of this connection attempt instead of      *
+ *           reconnecting.                                                    *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_open_ipmi_host(const char *ip, int port, int authtype, int privilege, const char *username,
+		const char *password)
+{
+	zbx_ipmi_host_t	*h;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() host:'[%s]:%d'", __func__, ip, port);
+
+	if (NULL == os_hnd)
+		goto out;
+
+	if (NULL != (h = zbx_get_ipmi_host(ip, port, authtype, privilege, username, password)))
+	{
+		if (1 == h->domain_up || 1 == h->pending)
+			goto out;
+	}
+	else
+		h = zbx_allocate_ipmi_host(ip, port, authtype, privilege, username, password);
+
+	h->pending = 1;
+	h->lastaccess = time(NULL);
+	sessions_opened++;
+
+	if (FAIL == zbx_connect_ipmi_host(h))
+		h->done = 1;
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: passes control to OpenIPMI library until all pending hosts are    *
+ *          either up or failed                                               *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_perform_pending_openipmi_ops(void)
+{
+	zbx_ipmi_host_t	*h;
+	struct timeval	tv;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	for (h = hosts; NULL != h; h = h->next)
+	{
+		if (1 != h->pending)
+			continue;
+
+		while (0 == h->done)
+		{
+			int	res;
+
+			tv.tv_sec = 10;		/* set timeout for one operation */
+			tv.tv_usec = 0;
+
+			if (0 != (res = os_hnd->perform_one_op(os_hnd, &tv)))
+			{
+				zabbix_log(LOG_LEVEL_DEBUG, "End %s(): error: %s", __func__, zbx_strerror(res));
+				return;
+			}
+		}
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: clears pending flag of hosts opened by zbx_open_ipmi_host()       *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_reset_pending_ipmi_hosts(void)
+{
+	zbx_ipmi_host_t	*h;
+
+	for (h = hosts; NULL != h; h = h->next)
+		h->pending = 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns the number of IPMI sessions reused and opened since the   *
+ *          last call                                                         *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_get_ipmi_session_stats(int *reused, int *opened)
+{
+	*reused = sessions_reused;
+	*opened = sessions_opened;
+
+	sessions_reused = 0;
+	sessions_opened = 0;
+}
+
 static ipmi_domain_id_t	domain_id;		/* global variable for passing OpenIPMI domain ID between callbacks */
 static int		domain_id_found;	/* A flag to indicate whether the 'domain_id' carries a valid value. */
 						/* Values: 0 - not found, 1 - found. The flag is used because we */
@@ -46,6 +46,12 @@ void	zbx_delete_inactive_ipmi_hosts(time_t last_check);
 
 void	zbx_perform_all_openipmi_ops(int timeout);
 
+void	zbx_open_ipmi_host(const char *ip, int port, int authtype, int privilege, const char *username,
+		const char *password);
+void	zbx_perform_pending_openipmi_ops(void);
+void	zbx_reset_pending_ipmi_hosts(void);
+void	zbx_get_ipmi_session_stats(int *reused, int *opened);
+
 #endif	/* HAVE_OPENIPMI */
 
 #endif	/* ZABBIX_CHECKS_IPMI_H */
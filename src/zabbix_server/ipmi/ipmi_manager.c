@@ -49,6 +49,10 @@ extern int		CONFIG_FORKS[ZBX_PROCESS_TYPE_COUNT];
 #define ZBX_IPMI_MANAGER_CLEANUP_DELAY		SEC_PER_HOUR
 #define ZBX_IPMI_MANAGER_HOST_TTL		SEC_PER_DAY
 
+/* the maximum number of requests sent to a poller without waiting for results, */
+/* the poller opens sessions to the hosts of all received requests concurrently  */
+#define ZBX_IPMI_POLLER_REQUESTS_MAX		8
+
 /* IPMI request queued by pollers */
 typedef struct
 {
@@ -72,6 +76,9 @@ typedef struct
 
 	/* the source client for external requests (command request) */
 	zbx_ipc_client_t	*client;
+
+	/* the time when request was queued */
+	double			queued;
 }
 zbx_ipmi_request_t;
 
@@ -84,8 +91,13 @@ typedef struct
 	/* the request queue */
 	zbx_binary_heap_t	requests;
 
-	/* the currently processing request */
-	zbx_ipmi_request_t	*request;
+	/* the requests sent to poller, results are returned in the same order */
+	zbx_list_t		sent;
+	int			sent_num;
+
+	/* the total time requests spent in queue before being sent and the number of sent requests */
+	double			queue_wait;
+	int			queue_wait_num;
 
 	/* the number of hosts handled by the poller */
 	int			hosts_num;
@@ -203,6 +215,7 @@ static zbx_ipmi_request_t	*ipmi_request_create(zbx_uint64_t hostid)
 	memset(request, 0, sizeof(zbx_ipmi_request_t));
 	request->requestid = next_requestid++;
 	request->hostid = hostid;
+	request->queued = zbx_time();
 
 	return request;
 }
@@ -274,7 +287,11 @@ static void	ipmi_poller_send_request(zbx_ipmi_poller_t *poller, zbx_ipmi_request
 		exit(EXIT_FAILURE);
 	}
 
-	poller->request = request;
+	zbx_list_append(&poller->sent, request, NULL);
+	poller->sent_num++;
+
+	poller->queue_wait += zbx_time() - request->queued;
+	poller->queue_wait_num++;
 }
 
 /******************************************************************************
@@ -287,7 +304,7 @@ static void	ipmi_poller_send_request(zbx_ipmi_poller_t *poller, zbx_ipmi_request
  ******************************************************************************/
 static void	ipmi_poller_schedule_request(zbx_ipmi_poller_t *poller, zbx_ipmi_request_t *request)
 {
-	if (NULL == poller->request && NULL != poller->client)
+	if (ZBX_IPMI_POLLER_REQUESTS_MAX > poller->sent_num && NULL != poller->client)
 		ipmi_poller_send_request(poller, request);
 	else
 		ipmi_poller_push_request(poller, request);
@@ -295,15 +312,40 @@ static void	ipmi_poller_schedule_request(zbx_ipmi_poller_t *poller, zbx_ipmi_req
 
 /******************************************************************************
  *                                                                            *
- * Purpose: frees the current request processed by IPMI poller                *
+ * Purpose: returns the oldest request sent to IPMI poller                    *
+ *                                                                            *
+ * Parameters: poller  - [IN] the IPMI poller                                 *
+ *                                                                            *
+ * Return value: The request the next poller result belongs to or NULL if no  *
+ *               requests are being processed.                                *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_ipmi_request_t	*ipmi_poller_get_request(zbx_ipmi_poller_t *poller)
+{
+	void	*request;
+
+	if (SUCCEED != zbx_list_peek(&poller->sent, &request))
+		return NULL;
+
+	return (zbx_ipmi_request_t *)request;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: frees the oldest request processed by IPMI poller                 *
  *                                                                            *
  * Parameters: poller  - [IN] the IPMI poller                                 *
  *                                                                            *
  ******************************************************************************/
 static void	ipmi_poller_free_request(zbx_ipmi_poller_t *poller)
 {
-	ipmi_request_free(poller->request);
-	poller->request = NULL;
+	void	*request;
+
+	if (SUCCEED != zbx_list_pop(&poller->sent, &request))
+		return;
+
+	ipmi_request_free((zbx_ipmi_request_t *)request);
+	poller->sent_num--;
 }
 
 /******************************************************************************
@@ -322,6 +364,11 @@ static void	ipmi_poller_free(zbx_ipmi_poller_t *poller)
 
 	zbx_binary_heap_destroy(&poller->requests);
 
+	while (NULL != ipmi_poller_get_request(poller))
+		ipmi_poller_free_request(poller);
+
+	zbx_list_destroy(&poller->sent);
+
 	zbx_free(poller);
 }
 
@@ -351,8 +398,12 @@ static void	ipmi_manager_init(zbx_ipmi_manager_t *manager)
 		poller = (zbx_ipmi_poller_t *)zbx_malloc(NULL, sizeof(zbx_ipmi_poller_t));
 
 		poller->client = NULL;
-		poller->request = NULL;
+		poller->sent_num = 0;
 		poller->hosts_num = 0;
+		poller->queue_wait = 0;
+		poller->queue_wait_num = 0;
+
+		zbx_list_create(&poller->sent);
 
 		zbx_binary_heap_create(&poller->requests, ipmi_request_compare, 0);
 
@@ -527,8 +578,10 @@ static zbx_ipmi_poller_t	*ipmi_manager_get_host_poller(zbx_ipmi_manager_t *manag
  *             poller  - [IN] the IPMI poller                                 *
  *             now     - [IN] the current time                                *
  *                                                                            *
- * Comments: This function will send the next request in queue to the poller, *
- *           skipping requests for unreachable hosts for unreachable period.  *
+ * Comments: This function will send the next requests in queue to the        *
+ *           poller until ZBX_IPMI_POLLER_REQUESTS_MAX requests are in        *
+ *           progress, skipping requests for unreachable hosts for            *
+ *           unreachable period.                                              *
  *                                                                            *
  ******************************************************************************/
 static void	ipmi_manager_process_poller_queue(zbx_ipmi_manager_t *manager, zbx_ipmi_poller_t *poller, int now)
@@ -536,7 +589,8 @@ static void	ipmi_manager_process_poller_queue(zbx_ipmi_manager_t *manager, zbx_i
 	zbx_ipmi_request_t	*request;
 	zbx_ipmi_manager_host_t	*host;
 
-	while (NULL != (request = ipmi_poller_pop_request(poller)))
+	while (ZBX_IPMI_POLLER_REQUESTS_MAX > poller->sent_num &&
+			NULL != (request = ipmi_poller_pop_request(poller)))
 	{
 		switch (request->message.code)
 		{
@@ -564,7 +618,6 @@ static void	ipmi_manager_process_poller_queue(zbx_ipmi_manager_t *manager, zbx_i
 		}
 
 		ipmi_poller_send_request(poller, request);
-		break;
 	}
 }
 
@@ -831,6 +884,7 @@ static void	ipmi_manager_process_client_result(zbx_ipmi_manager_t *manager, zbx_
 		zbx_ipc_message_t *message, int now, int code)
 {
 	zbx_ipmi_poller_t	*poller;
+	zbx_ipmi_request_t	*request;
 
 	if (NULL == (poller = ipmi_manager_get_poller_by_client(manager, client)))
 	{
@@ -838,10 +892,16 @@ static void	ipmi_manager_process_client_result(zbx_ipmi_manager_t *manager, zbx_
 		return;
 	}
 
-	if (SUCCEED == zbx_ipc_client_connected(poller->request->client))
+	if (NULL == (request = ipmi_poller_get_request(poller)))
+	{
+		THIS_SHOULD_NEVER_HAPPEN;
+		return;
+	}
+
+	if (SUCCEED == zbx_ipc_client_connected(request->client))
 	{
-		zbx_ipc_client_send(poller->request->client, code, message->data, message->size);
-		zbx_ipc_client_release(poller->request->client);
+		zbx_ipc_client_send(request->client, code, message->data, message->size);
+		zbx_ipc_client_release(request->client);
 	}
 
 	ipmi_poller_free_request(poller);
@@ -871,6 +931,7 @@ static void	ipmi_manager_process_value_result(zbx_ipmi_manager_t *manager, zbx_i
 	int			errcode;
 	AGENT_RESULT		result;
 	zbx_ipmi_poller_t	*poller;
+	zbx_ipmi_request_t	*request;
 	zbx_uint64_t		itemid;
 	unsigned char		flags;
 
@@ -880,14 +941,20 @@ static void	ipmi_manager_process_value_result(zbx_ipmi_manager_t *manager, zbx_i
 		return;
 	}
 
-	if (NULL != poller->request->client)
+	if (NULL == (request = ipmi_poller_get_request(poller)))
+	{
+		THIS_SHOULD_NEVER_HAPPEN;
+		return;
+	}
+
+	if (NULL != request->client)
 	{
 		ipmi_manager_process_client_result(manager, client, message, now, ZBX_IPC_IPMI_VALUE_RESULT);
 		return;
 	}
 
-	itemid = poller->request->itemid;
-	flags = poller->request->item_flags;
+	itemid = request->itemid;
+	flags = request->item_flags;
 
 	zbx_ipmi_deserialize_result(message->data, &ts, &errcode, &value);
 
@@ -920,7 +987,7 @@ static void	ipmi_manager_process_value_result(zbx_ipmi_manager_t *manager, zbx_i
 				zbx_init_agent_result(&result);
 				SET_TEXT_RESULT(&result, value);
 				value = NULL;
-				zbx_preprocess_item_value(itemid, poller->request->hostid, ITEM_VALUE_TYPE_TEXT, flags,
+				zbx_preprocess_item_value(itemid, request->hostid, ITEM_VALUE_TYPE_TEXT, flags,
 						&result, &ts, state, NULL);
 				zbx_free_agent_result(&result);
 			}
@@ -930,7 +997,7 @@ static void	ipmi_manager_process_value_result(zbx_ipmi_manager_t *manager, zbx_i
 		case AGENT_ERROR:
 		case CONFIG_ERROR:
 			state = ITEM_STATE_NOTSUPPORTED;
-			zbx_preprocess_item_value(itemid, poller->request->hostid, ITEM_VALUE_TYPE_TEXT, flags, NULL,
+			zbx_preprocess_item_value(itemid, request->hostid, ITEM_VALUE_TYPE_TEXT, flags, NULL,
 					&ts, state, value);
 			break;
 		default:
@@ -947,6 +1014,33 @@ static void	ipmi_manager_process_value_result(zbx_ipmi_manager_t *manager, zbx_i
 	ipmi_manager_process_poller_queue(manager, poller, now);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns average time requests spent in poller queues since the    *
+ *          last call                                                         *
+ *                                                                            *
+ * Parameters: manager - [IN] the IPMI manager                                *
+ *                                                                            *
+ ******************************************************************************/
+static double	ipmi_manager_get_queue_wait(zbx_ipmi_manager_t *manager)
+{
+	int	i, num = 0;
+	double	wait = 0;
+
+	for (i = 0; i < manager->pollers.values_num; i++)
+	{
+		zbx_ipmi_poller_t	*poller = (zbx_ipmi_poller_t *)manager->pollers.values[i];
+
+		wait += poller->queue_wait;
+		num += poller->queue_wait_num;
+
+		poller->queue_wait = 0;
+		poller->queue_wait_num = 0;
+	}
+
+	return 0 != num ? wait / num : 0;
+}
+
 ZBX_THREAD_ENTRY(ipmi_manager_thread, args)
 {
 	zbx_ipc_service_t		ipmi_service;
@@ -999,9 +1093,10 @@ ZBX_THREAD_ENTRY(ipmi_manager_thread, args)
 
 		if (STAT_INTERVAL < time_now - time_stat)
 		{
-			zbx_setproctitle("%s #%d [scheduled %d, polled %d values, idle " ZBX_FS_DBL " sec during "
-					ZBX_FS_DBL " sec]", get_process_type_string(process_type), process_num,
-					scheduled_num, polled_num, time_idle, time_now - time_stat);
+			zbx_setproctitle("%s #%d [scheduled %d, polled %d values, queue wait " ZBX_FS_DBL " sec avg,"
+					" idle " ZBX_FS_DBL " sec during " ZBX_FS_DBL " sec]",
+					get_process_type_string(process_type), process_num, scheduled_num, polled_num,
+					ipmi_manager_get_queue_wait(&ipmi_manager), time_idle, time_now - time_stat);
 
 			time_stat = time_now;
 			time_idle = 0;
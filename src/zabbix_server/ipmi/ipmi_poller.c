@@ -163,12 +163,61 @@ static void	ipmi_poller_process_command_request(zbx_ipc_async_socket_t *socket,
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: starts opening sessions to all hosts targeted by the received     *
+ *          requests and waits until they are up or failed                    *
+ *                                                                            *
+ * Parameters: messages - [IN] the received request messages                  *
+ *                                                                            *
+ * Comments: OpenIPMI processes domain opening (session activation and SDR    *
+ *           scan) of all hosts concurrently, so the requests can be served   *
+ *           without waiting for host connections one by one.                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	ipmi_poller_open_hosts(const zbx_vector_ptr_t *messages)
+{
+	int	i;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() messages:%d", __func__, messages->values_num);
+
+	for (i = 0; i < messages->values_num; i++)
+	{
+		zbx_ipc_message_t	*message = (zbx_ipc_message_t *)messages->values[i];
+		zbx_uint64_t		objectid;
+		char			*addr, *username, *password, *sensor, *key;
+		signed char		authtype;
+		unsigned char		privilege;
+		unsigned short		port;
+		int			command;
+
+		if (ZBX_IPC_IPMI_VALUE_REQUEST != message->code && ZBX_IPC_IPMI_COMMAND_REQUEST != message->code)
+			continue;
+
+		zbx_ipmi_deserialize_request(message->data, &objectid, &addr, &port, &authtype, &privilege, &username,
+				&password, &sensor, &command, &key);
+
+		zbx_open_ipmi_host(addr, port, authtype, privilege, username, password);
+
+		zbx_free(addr);
+		zbx_free(username);
+		zbx_free(password);
+		zbx_free(sensor);
+		zbx_free(key);
+	}
+
+	zbx_perform_pending_openipmi_ops();
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
 ZBX_THREAD_ENTRY(ipmi_poller_thread, args)
 {
 	char			*error = NULL;
 	zbx_ipc_async_socket_t	ipmi_socket;
-	int			polled_num = 0;
+	int			polled_num = 0, sessions_reused, sessions_opened, i;
 	double			time_stat, time_idle = 0, time_now, time_read;
+	zbx_vector_ptr_t	messages;
 	const zbx_thread_info_t	*info = &((zbx_thread_args_t *)args)->info;
 	int			server_num = ((zbx_thread_args_t *)args)->info.server_num;
 	int			process_num = ((zbx_thread_args_t *)args)->info.process_num;
@@ -195,6 +244,8 @@ ZBX_THREAD_ENTRY(ipmi_poller_thread, args)
 
 	ipmi_poller_register(&ipmi_socket);
 
+	zbx_vector_ptr_create(&messages);
+
 	time_stat = zbx_time();
 
 	zbx_setproctitle("%s #%d started", get_process_type_string(process_type), process_num);
@@ -207,9 +258,12 @@ ZBX_THREAD_ENTRY(ipmi_poller_thread, args)
 
 		if (STAT_INTERVAL < time_now - time_stat)
 		{
-			zbx_setproctitle("%s #%d [polled %d values, idle " ZBX_FS_DBL " sec during "
-					ZBX_FS_DBL " sec]", get_process_type_string(process_type), process_num,
-					polled_num, time_idle, time_now - time_stat);
+			zbx_get_ipmi_session_stats(&sessions_reused, &sessions_opened);
+
+			zbx_setproctitle("%s #%d [polled %d values, reused %d, opened %d sessions, idle " ZBX_FS_DBL
+					" sec during " ZBX_FS_DBL " sec]", get_process_type_string(process_type),
+					process_num, polled_num, sessions_reused, sessions_opened, time_idle,
+					time_now - time_stat);
 
 			time_stat = time_now;
 			time_idle = 0;
@@ -244,22 +298,45 @@ ZBX_THREAD_ENTRY(ipmi_poller_thread, args)
 		time_idle += time_read - time_now;
 		zbx_update_env(get_process_type_string(process_type), time_read);
 
-		switch (message->code)
+		/* collect all requests already sent by manager to bring their host sessions up concurrently */
+		do
 		{
-			case ZBX_IPC_IPMI_VALUE_REQUEST:
-				ipmi_poller_process_value_request(&ipmi_socket, message);
-				polled_num++;
-				break;
-			case ZBX_IPC_IPMI_COMMAND_REQUEST:
-				ipmi_poller_process_command_request(&ipmi_socket, message);
-				break;
-			case ZBX_IPC_IPMI_CLEANUP_REQUEST:
-				zbx_delete_inactive_ipmi_hosts(time(NULL));
-				break;
+			zbx_vector_ptr_append(&messages, message);
+
+			if (SUCCEED != zbx_ipc_async_socket_recv(&ipmi_socket, 0, &message))
+			{
+				zabbix_log(LOG_LEVEL_CRIT, "cannot read IPMI service request");
+				exit(EXIT_FAILURE);
+			}
+		}
+		while (NULL != message);
+
+		if (1 < messages.values_num)
+			ipmi_poller_open_hosts(&messages);
+
+		for (i = 0; i < messages.values_num; i++)
+		{
+			message = (zbx_ipc_message_t *)messages.values[i];
+
+			switch (message->code)
+			{
+				case ZBX_IPC_IPMI_VALUE_REQUEST:
+					ipmi_poller_process_value_request(&ipmi_socket, message);
+					polled_num++;
+					break;
+				case ZBX_IPC_IPMI_COMMAND_REQUEST:
+					ipmi_poller_process_command_request(&ipmi_socket, message);
+					break;
+				case ZBX_IPC_IPMI_CLEANUP_REQUEST:
+					zbx_delete_inactive_ipmi_hosts(time(NULL));
+					break;
+			}
+
+			zbx_ipc_message_free(message);
 		}
 
-		zbx_ipc_message_free(message);
-		message = NULL;
+		zbx_reset_pending_ipmi_hosts();
+		zbx_vector_ptr_clear(&messages);
 	}
 
 	zbx_setproctitle("%s #%d [terminated]", get_process_type_string(process_type), process_num);
@@ -267,6 +344,7 @@ ZBX_THREAD_ENTRY(ipmi_poller_thread, args)
 	while (1)
 		zbx_sleep(SEC_PER_MIN);
 
+	zbx_vector_ptr_destroy(&messages);
 	zbx_ipc_async_socket_close(&ipmi_socket);
 
 	zbx_free_ipmi_handler();
@@ -28,6 +28,7 @@
 #include "zbx_trigger_constants.h"
 #include "zbx_item_constants.h"
 #include "zbxvariant.h"
+#include "zbxcacheconfig.h"
 
 /* lld rule filter condition (item_condition table record) */
 typedef struct
@@ -46,6 +47,30 @@ ZBX_PTR_VECTOR_IMPL(lld_override, zbx_lld_override_t*)
 
 ZBX_PTR_VECTOR_IMPL(lld_row, zbx_lld_row_t*)
 
+/* Discovery rule configuration is cached by LLD worker between runs of the same rule. The      */
+/* cached configuration is reloaded when the configuration revision of the rule host changes to */
+/* pick up changes of user macros and global regular expressions. Filters, macro paths and      */
+/* overrides are not tracked by configuration cache, so cached configuration is also reloaded   */
+/* after ZBX_LLD_RULE_CONFIG_TTL seconds.                                                       */
+#define ZBX_LLD_RULE_CONFIG_TTL	SEC_PER_MIN
+
+typedef struct
+{
+	zbx_uint64_t			ruleid;
+	zbx_uint64_t			revision;
+	time_t				loaded;
+	zbx_uint64_t			hostid;
+	char				*key;
+	int				lifetime;
+	zbx_lld_filter_t		filter;
+	zbx_vector_ptr_t		macro_paths;
+	zbx_vector_lld_override_t	overrides;
+}
+lld_rule_config_t;
+
+static zbx_hashset_t	lld_rule_configs;
+static time_t		lld_rule_configs_pruned;
+
 /******************************************************************************
  *                                                                            *
  * Purpose: release resources allocated by filter condition                   *
@@ -1066,76 +1091,59 @@ static void	lld_row_free(zbx_lld_row_t *lld_row)
 	zbx_free(lld_row);
 }
 
+static void	lld_rule_config_clean(lld_rule_config_t *rule)
+{
+	zbx_free(rule->key);
+	lld_filter_clean(&rule->filter);
+
+	zbx_vector_lld_override_clear_ext(&rule->overrides, lld_override_free);
+	zbx_vector_lld_override_destroy(&rule->overrides);
+	zbx_vector_ptr_clear_ext(&rule->macro_paths, (zbx_clean_func_t)zbx_lld_macro_path_free);
+	zbx_vector_ptr_destroy(&rule->macro_paths);
+}
+
 /******************************************************************************
  *                                                                            *
- * Purpose: add or update items, triggers and graphs for discovery item       *
+ * Purpose: loads discovery rule configuration from database                  *
  *                                                                            *
- * Parameters: lld_ruleid - [IN] discovery item identifier from database      *
- *             value      - [IN] received value from agent                    *
- *             error      - [OUT] error or informational message. Will be set *
- *                               to empty string on successful discovery      *
- *                               without additional information.              *
+ * Parameters: rule  - [IN/OUT] discovery rule configuration with rule id set *
+ *             item  - [IN] discovery rule item                               *
+ *             error - [OUT] error message                                    *
+ *                                                                            *
+ * Return value: SUCCEED - the configuration was loaded                       *
+ *               FAIL    - the configuration cannot be loaded, error is set   *
+ *                         unless the rule was not found in database          *
  *                                                                            *
  ******************************************************************************/
-int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, char **error)
+static int	lld_rule_config_load(lld_rule_config_t *rule, const zbx_dc_item_t *item, char **error)
 {
-	zbx_db_result_t			result;
-	zbx_db_row_t			row;
-	zbx_uint64_t			hostid;
-	char				*discovery_key = NULL, *info = NULL;
-	int				lifetime, ret = SUCCEED, errcode;
-	zbx_vector_ptr_t		lld_macro_paths;
-	zbx_lld_filter_t		filter;
-	time_t				now;
-	zbx_dc_item_t			item;
-	zbx_config_t			cfg;
-	zbx_dc_um_handle_t		*um_handle;
-	zbx_vector_lld_override_t	overrides;
-	zbx_vector_lld_row_t		lld_rows;
-
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() itemid:" ZBX_FS_UI64, __func__, lld_ruleid);
-
-	um_handle = zbx_dc_open_user_macros();
-
-	zbx_vector_lld_row_create(&lld_rows);
-	zbx_vector_ptr_create(&lld_macro_paths);
-	zbx_vector_lld_override_create(&overrides);
-
-	lld_filter_init(&filter);
-
-	zbx_dc_config_get_items_by_itemids(&item, &lld_ruleid, &errcode, 1);
-
-	if (SUCCEED != errcode)
-	{
-		*error = zbx_dsprintf(*error, "Invalid discovery rule ID [" ZBX_FS_UI64 "].", lld_ruleid);
-		ret = FAIL;
-		goto out;
-	}
+	zbx_db_result_t	result;
+	zbx_db_row_t	row;
 
 	result = zbx_db_select(
 			"select hostid,key_,evaltype,formula,lifetime"
 			" from items"
 			" where itemid=" ZBX_FS_UI64,
-			lld_ruleid);
+			rule->ruleid);
 
 	if (NULL != (row = zbx_db_fetch(result)))
 	{
 		char	*lifetime_str;
 
-		ZBX_STR2UINT64(hostid, row[0]);
-		discovery_key = zbx_strdup(discovery_key, row[1]);
-		filter.evaltype = atoi(row[2]);
-		filter.expression = zbx_strdup(NULL, row[3]);
+		ZBX_STR2UINT64(rule->hostid, row[0]);
+		rule->key = zbx_strdup(rule->key, row[1]);
+		rule->filter.evaltype = atoi(row[2]);
+		rule->filter.expression = zbx_strdup(NULL, row[3]);
 		lifetime_str = zbx_strdup(NULL, row[4]);
-		zbx_substitute_simple_macros(NULL, NULL, NULL, NULL, &hostid, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
-				&lifetime_str, MACRO_TYPE_COMMON, NULL, 0);
+		zbx_substitute_simple_macros(NULL, NULL, NULL, NULL, &rule->hostid, NULL, NULL, NULL, NULL, NULL, NULL,
+				NULL, &lifetime_str, MACRO_TYPE_COMMON, NULL, 0);
 
-		if (SUCCEED != zbx_is_time_suffix(lifetime_str, &lifetime, ZBX_LENGTH_UNLIMITED))
+		if (SUCCEED != zbx_is_time_suffix(lifetime_str, &rule->lifetime, ZBX_LENGTH_UNLIMITED))
 		{
 			zabbix_log(LOG_LEVEL_WARNING, "cannot process lost resources for the discovery rule \"%s:%s\":"
 					" \"%s\" is not a valid value",
-					zbx_host_string(hostid), discovery_key, lifetime_str);
-			lifetime = 25 * SEC_PER_YEAR;	/* max value for the field */
+					zbx_host_string(rule->hostid), rule->key, lifetime_str);
+			rule->lifetime = 25 * SEC_PER_YEAR;	/* max value for the field */
 		}
 
 		zbx_free(lifetime_str);
@@ -1144,26 +1152,150 @@ int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, char
 
 	if (NULL == row)
 	{
-		zabbix_log(LOG_LEVEL_WARNING, "invalid discovery rule ID [" ZBX_FS_UI64 "]", lld_ruleid);
-		goto out;
+		zabbix_log(LOG_LEVEL_WARNING, "invalid discovery rule ID [" ZBX_FS_UI64 "]", rule->ruleid);
+		return FAIL;
 	}
 
-	if (SUCCEED != lld_filter_load(&filter, lld_ruleid, &item, error))
+	if (SUCCEED != lld_filter_load(&rule->filter, rule->ruleid, item, error))
+		return FAIL;
+
+	if (SUCCEED != zbx_lld_macro_paths_get(rule->ruleid, &rule->macro_paths, error))
+		return FAIL;
+
+	return lld_overrides_load(&rule->overrides, rule->ruleid, item, error);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets cached discovery rule configuration, loading it from         *
+ *          database if necessary                                             *
+ *                                                                            *
+ * Parameters: item  - [IN] discovery rule item                               *
+ *             rule  - [OUT] discovery rule configuration, NULL if the rule   *
+ *                           was not found in database                        *
+ *             error - [OUT] error message                                    *
+ *                                                                            *
+ * Return value: SUCCEED - the configuration was found or the rule does not   *
+ *                         exist anymore                                      *
+ *               FAIL    - the configuration cannot be loaded                 *
+ *                                                                            *
+ ******************************************************************************/
+static int	lld_rule_config_get(const zbx_dc_item_t *item, lld_rule_config_t **rule, char **error)
+{
+	lld_rule_config_t	*config, config_local;
+	zbx_uint64_t		revision;
+	time_t			now;
+	int			ret;
+
+	if (NULL == lld_rule_configs.slots)
 	{
-		ret = FAIL;
-		goto out;
+		zbx_hashset_create_ext(&lld_rule_configs, 0, ZBX_DEFAULT_UINT64_HASH_FUNC,
+				ZBX_DEFAULT_UINT64_COMPARE_FUNC, (zbx_clean_func_t)lld_rule_config_clean,
+				ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
+		lld_rule_configs_pruned = time(NULL);
+	}
+
+	now = time(NULL);
+
+	/* remove configuration of rules that are not processed anymore */
+	if (now >= lld_rule_configs_pruned + ZBX_LLD_RULE_CONFIG_TTL)
+	{
+		zbx_hashset_iter_t	iter;
+
+		zbx_hashset_iter_reset(&lld_rule_configs, &iter);
+		while (NULL != (config = (lld_rule_config_t *)zbx_hashset_iter_next(&iter)))
+		{
+			if (now >= config->loaded + ZBX_LLD_RULE_CONFIG_TTL)
+				zbx_hashset_iter_remove(&iter);
+		}
+
+		lld_rule_configs_pruned = now;
 	}
 
-	if (SUCCEED != zbx_lld_macro_paths_get(lld_ruleid, &lld_macro_paths, error))
+	/* revision must be taken before the configuration is loaded to detect later changes */
+	revision = zbx_dc_get_host_config_revision(item->host.hostid);
+
+	if (NULL != (config = (lld_rule_config_t *)zbx_hashset_search(&lld_rule_configs, &item->itemid)))
+	{
+		if (0 != revision && config->revision == revision && now < config->loaded + ZBX_LLD_RULE_CONFIG_TTL)
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "using cached configuration of discovery rule:" ZBX_FS_UI64,
+					item->itemid);
+			*rule = config;
+			return SUCCEED;
+		}
+
+		zbx_hashset_remove_direct(&lld_rule_configs, config);
+	}
+
+	memset(&config_local, 0, sizeof(config_local));
+	config_local.ruleid = item->itemid;
+	config_local.revision = revision;
+	config_local.loaded = now;
+	lld_filter_init(&config_local.filter);
+	zbx_vector_ptr_create(&config_local.macro_paths);
+	zbx_vector_lld_override_create(&config_local.overrides);
+
+	if (SUCCEED != (ret = lld_rule_config_load(&config_local, item, error)))
+	{
+		/* missing rule is not an error, it could have been removed while its value was queued, */
+		/* rule key is set only when the rule was found                                          */
+		if (NULL == config_local.key)
+			ret = SUCCEED;
+
+		lld_rule_config_clean(&config_local);
+		*rule = NULL;
+
+		return ret;
+	}
+
+	*rule = (lld_rule_config_t *)zbx_hashset_insert(&lld_rule_configs, &config_local, sizeof(config_local));
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: add or update items, triggers and graphs for discovery item       *
+ *                                                                            *
+ * Parameters: lld_ruleid - [IN] discovery item identifier from database      *
+ *             value      - [IN] received value from agent                    *
+ *             error      - [OUT] error or informational message. Will be set *
+ *                               to empty string on successful discovery      *
+ *                               without additional information.              *
+ *                                                                            *
+ ******************************************************************************/
+int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, char **error)
+{
+	char			*info = NULL;
+	int			ret = SUCCEED, errcode;
+	time_t			now;
+	zbx_dc_item_t		item;
+	zbx_config_t		cfg;
+	zbx_dc_um_handle_t	*um_handle;
+	zbx_vector_lld_row_t	lld_rows;
+	lld_rule_config_t	*rule;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() itemid:" ZBX_FS_UI64, __func__, lld_ruleid);
+
+	um_handle = zbx_dc_open_user_macros();
+
+	zbx_vector_lld_row_create(&lld_rows);
+
+	zbx_dc_config_get_items_by_itemids(&item, &lld_ruleid, &errcode, 1);
+
+	if (SUCCEED != errcode)
 	{
+		*error = zbx_dsprintf(*error, "Invalid discovery rule ID [" ZBX_FS_UI64 "].", lld_ruleid);
 		ret = FAIL;
 		goto out;
 	}
 
-	if (SUCCEED != (ret = lld_overrides_load(&overrides, lld_ruleid, &item, error)))
+	if (SUCCEED != (ret = lld_rule_config_get(&item, &rule, error)) || NULL == rule)
 		goto out;
 
-	if (SUCCEED != lld_rows_get(value, &filter, &lld_rows, &lld_macro_paths, &overrides, &info, error))
+	if (SUCCEED != lld_rows_get(value, &rule->filter, &lld_rows, &rule->macro_paths, &rule->overrides, &info,
+			error))
 	{
 		ret = FAIL;
 		goto out;
@@ -1176,7 +1308,8 @@ int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, char
 	zbx_config_get(&cfg, ZBX_CONFIG_FLAGS_AUDITLOG_ENABLED);
 	zbx_audit_init(cfg.auditlog_enabled);
 
-	if (SUCCEED != lld_update_items(hostid, lld_ruleid, &lld_rows, &lld_macro_paths, error, lifetime, now))
+	if (SUCCEED != lld_update_items(rule->hostid, lld_ruleid, &lld_rows, &rule->macro_paths, error,
+			rule->lifetime, now))
 	{
 		zabbix_log(LOG_LEVEL_DEBUG, "cannot update/add items because parent host was removed while"
 				" processing lld rule");
@@ -1185,21 +1318,23 @@ int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, char
 
 	lld_item_links_sort(&lld_rows);
 
-	if (SUCCEED != lld_update_triggers(hostid, lld_ruleid, &lld_rows, &lld_macro_paths, error, lifetime, now))
+	if (SUCCEED != lld_update_triggers(rule->hostid, lld_ruleid, &lld_rows, &rule->macro_paths, error,
+			rule->lifetime, now))
 	{
 		zabbix_log(LOG_LEVEL_DEBUG, "cannot update/add triggers because parent host was removed while"
 				" processing lld rule");
 		goto out;
 	}
 
-	if (SUCCEED != lld_update_graphs(hostid, lld_ruleid, &lld_rows, &lld_macro_paths, error, lifetime, now))
+	if (SUCCEED != lld_update_graphs(rule->hostid, lld_ruleid, &lld_rows, &rule->macro_paths, error,
+			rule->lifetime, now))
 	{
 		zabbix_log(LOG_LEVEL_DEBUG, "cannot update/add graphs because parent host was removed while"
 				" processing lld rule");
 		goto out;
 	}
 
-	lld_update_hosts(lld_ruleid, &lld_rows, &lld_macro_paths, error, lifetime, now);
+	lld_update_hosts(lld_ruleid, &lld_rows, &rule->macro_paths, error, rule->lifetime, now);
 
 	/* add informative warning to the error message about lack of data for macros used in filter */
 	if (NULL != info)
@@ -1208,16 +1343,9 @@ out:
 	zbx_audit_flush();
 	zbx_dc_config_clean_items(&item, &errcode, 1);
 	zbx_free(info);
-	zbx_free(discovery_key);
-
-	lld_filter_clean(&filter);
 
-	zbx_vector_lld_override_clear_ext(&overrides, lld_override_free);
-	zbx_vector_lld_override_destroy(&overrides);
 	zbx_vector_lld_row_clear_ext(&lld_rows, lld_row_free);
 	zbx_vector_lld_row_destroy(&lld_rows);
-	zbx_vector_ptr_clear_ext(&lld_macro_paths, (zbx_clean_func_t)zbx_lld_macro_path_free);
-	zbx_vector_ptr_destroy(&lld_macro_paths);
 
 	zbx_dc_close_user_macros(um_handle);
 
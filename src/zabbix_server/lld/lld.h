@@ -132,6 +132,7 @@ typedef struct
 	char			*ssl_cert_file;
 	char			*ssl_key_file;
 	char			*ssl_key_password;
+	char			*history_downsample_param;
 	unsigned char		verify_peer;
 	unsigned char		verify_host;
 	unsigned char		follow_redirects;
@@ -145,6 +146,7 @@ typedef struct
 	unsigned char		authtype;
 	unsigned char		allow_traps;
 	unsigned char		discover;
+	unsigned char		history_downsample;
 	zbx_vector_lld_row_t	lld_rows;
 	zbx_vector_lld_item_preproc_t	preproc_ops;
 	zbx_vector_item_param_ptr_t	item_params;
@@ -206,6 +208,8 @@ struct zbx_lld_item_full_s
 #define ZBX_FLAG_LLD_ITEM_UPDATE_VERIFY_PEER		__UINT64_C(0x0020000000000000)
 #define ZBX_FLAG_LLD_ITEM_UPDATE_VERIFY_HOST		__UINT64_C(0x0040000000000000)
 #define ZBX_FLAG_LLD_ITEM_UPDATE_ALLOW_TRAPS		__UINT64_C(0x0080000000000000)
+#define ZBX_FLAG_LLD_ITEM_UPDATE_DOWNSAMPLE		__UINT64_C(0x0100000000000000)
+#define ZBX_FLAG_LLD_ITEM_UPDATE_DOWNSAMPLE_PARAM	__UINT64_C(0x0200000000000000)
 #define ZBX_FLAG_LLD_ITEM_UPDATE			(~ZBX_FLAG_LLD_ITEM_DISCOVERED)
 	zbx_uint64_t			flags;
 	char				*key_proto;
@@ -283,6 +287,8 @@ struct zbx_lld_item_full_s
 	unsigned char			verify_peer_orig;
 	unsigned char			verify_host_orig;
 	unsigned char			allow_traps_orig;
+	unsigned char			history_downsample_orig;
+	char				*history_downsample_param_orig;
 };
 
 ZBX_PTR_VECTOR_FUNC_DECL(lld_item_full, zbx_lld_item_full_t*)
@@ -88,6 +88,8 @@ void	zbx_audit_item_update_json_add_lld_data(zbx_uint64_t itemid, const zbx_lld_
 	ADD_JSON_P_UI(verify_peer, AUDIT_TABLE_NAME, "verify_peer");
 	ADD_JSON_P_UI(verify_host, AUDIT_TABLE_NAME, "verify_host");
 	ADD_JSON_P_UI(allow_traps, AUDIT_TABLE_NAME, "allow_traps");
+	ADD_JSON_P_UI(history_downsample, AUDIT_TABLE_NAME, "history_downsample");
+	ADD_JSON_P_S(history_downsample_param, AUDIT_TABLE_NAME, "history_downsample_param");
 
 #undef AUDIT_TABLE_NAME
 #undef ADD_JSON_UI
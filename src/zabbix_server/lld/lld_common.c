@@ -178,7 +178,7 @@ void	lld_remove_lost_objects(const char *table, const char *id_name, const zbx_v
 	/* remove 'lost' objects */
 	if (0 != del_ids.values_num)
 	{
-		zbx_vector_uint64_sort(&del_ids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_sort_asc(&del_ids);
 
 		cb(&del_ids);
 	}
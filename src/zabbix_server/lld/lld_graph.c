@@ -307,7 +307,7 @@ static void	lld_gitems_get(zbx_uint64_t parent_graphid, zbx_vector_ptr_t *gitems
 		zbx_vector_uint64_append(&graphids, graph->graphid);
 	}
 
-	zbx_vector_uint64_sort(&graphids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_sort_asc(&graphids);
 
 	sql = (char *)zbx_malloc(sql, sql_alloc);
 
@@ -422,7 +422,7 @@ static void	lld_items_get(const zbx_vector_ptr_t *gitems_proto, zbx_uint64_t ymi
 		char	*sql = NULL;
 		size_t	sql_alloc = 256, sql_offset = 0;
 
-		zbx_vector_uint64_sort(&itemids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_sort_asc(&itemids);
 
 		sql = (char *)zbx_malloc(sql, sql_alloc);
 
@@ -926,7 +926,7 @@ static void	lld_graphs_validate(zbx_uint64_t hostid, zbx_vector_ptr_t *graphs, c
 
 		if (0 != graphids.values_num)
 		{
-			zbx_vector_uint64_sort(&graphids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+			zbx_vector_uint64_sort_asc(&graphids);
 			zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " and not");
 			zbx_db_add_condition_alloc(&sql, &sql_alloc, &sql_offset, "g.graphid",
 					graphids.values, graphids.values_num);
@@ -1403,7 +1403,7 @@ static int	lld_graphs_save(zbx_uint64_t hostid, zbx_uint64_t parent_graphid, zbx
 
 	if (0 != del_gitemids.values_num)
 	{
-		zbx_vector_uint64_sort(&del_gitemids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_sort_asc(&del_gitemids);
 
 		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, "delete from graphs_items where");
 		zbx_db_add_condition_alloc(&sql, &sql_alloc, &sql_offset, "gitemid",
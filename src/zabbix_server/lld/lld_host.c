@@ -768,7 +768,7 @@ static void	lld_hosts_validate(zbx_vector_ptr_t *hosts, char **error)
 
 		if (0 != hostids.values_num)
 		{
-			zbx_vector_uint64_sort(&hostids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+			zbx_vector_uint64_sort_asc(&hostids);
 			zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " and not");
 			zbx_db_add_condition_alloc(&sql, &sql_alloc, &sql_offset, "hostid",
 					hostids.values, hostids.values_num);
@@ -1066,7 +1066,7 @@ static void	lld_simple_groups_get(zbx_uint64_t parent_hostid, zbx_vector_uint64_
 	}
 	zbx_db_free_result(result);
 
-	zbx_vector_uint64_sort(groupids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_sort_asc(groupids);
 }
 
 /******************************************************************************
@@ -1129,7 +1129,7 @@ static void	lld_hostgroups_make(const zbx_vector_uint64_t *groupids, zbx_vector_
 	for (i = 0; i < hosts->values_num; i++)
 	{
 		host = (zbx_lld_host_t *)hosts->values[i];
-		zbx_vector_uint64_sort(&host->new_groupids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_sort_asc(&host->new_groupids);
 	}
 
 	if (0 != hostids.values_num)
@@ -1180,7 +1180,7 @@ static void	lld_hostgroups_make(const zbx_vector_uint64_t *groupids, zbx_vector_
 		}
 		zbx_db_free_result(result);
 
-		zbx_vector_uint64_sort(del_hostgroupids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_sort_asc(del_hostgroupids);
 	}
 
 	zbx_vector_uint64_destroy(&hostids);
@@ -1540,7 +1540,7 @@ static void	lld_groups_validate(zbx_vector_ptr_t *groups, char **error)
 
 		if (0 != groupids.values_num)
 		{
-			zbx_vector_uint64_sort(&groupids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+			zbx_vector_uint64_sort_asc(&groupids);
 			zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " and not");
 			zbx_db_add_condition_alloc(&sql, &sql_alloc, &sql_offset, "groupid",
 					groupids.values, groupids.values_num);
@@ -2311,7 +2311,7 @@ static void	lld_templates_make(zbx_uint64_t parent_hostid, zbx_vector_ptr_t *hos
 	}
 	zbx_db_free_result(result);
 
-	zbx_vector_uint64_sort(&templateids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_sort_asc(&templateids);
 
 	/* select list of already created hosts */
 
@@ -2327,8 +2327,7 @@ static void	lld_templates_make(zbx_uint64_t parent_hostid, zbx_vector_ptr_t *hos
 			zbx_vector_uint64_append(&host->lnk_templateids, templateids.values[j]);
 
 		/* sort templates which should be linked by override */
-		zbx_vector_uint64_sort(&host->lnk_templateids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
-		zbx_vector_uint64_uniq(&host->lnk_templateids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_sort_uniq(&host->lnk_templateids);
 
 		if (0 != host->hostid)
 			zbx_vector_uint64_append(&hostids, host->hostid);
@@ -2392,7 +2391,7 @@ static void	lld_templates_make(zbx_uint64_t parent_hostid, zbx_vector_ptr_t *hos
 			if (0 == (host->flags & ZBX_FLAG_LLD_HOST_DISCOVERED))
 				continue;
 
-			zbx_vector_uint64_sort(&host->del_templateids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+			zbx_vector_uint64_sort_asc(&host->del_templateids);
 		}
 	}
 
@@ -3361,7 +3360,7 @@ static void	lld_hosts_save(zbx_uint64_t parent_hostid, zbx_vector_ptr_t *hosts,
 
 		if (0 != del_hostmacroids.values_num)
 		{
-			zbx_vector_uint64_sort(&del_hostmacroids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+			zbx_vector_uint64_sort_asc(&del_hostmacroids);
 			zbx_strcpy_alloc(&sql2, &sql2_alloc, &sql2_offset, "delete from hostmacro where");
 			zbx_db_add_condition_alloc(&sql2, &sql2_alloc, &sql2_offset, "hostmacroid",
 					del_hostmacroids.values, del_hostmacroids.values_num);
@@ -3440,16 +3439,29 @@ out:
 
 static void	lld_templates_link(const zbx_vector_ptr_t *hosts, char **error)
 {
-	int		i;
-	zbx_lld_host_t	*host;
-	char		*err = NULL;
+#define LLD_TEMPLATES_LINK_PROGRESS_PERIOD	10
+	int				i;
+	zbx_lld_host_t			*host;
+	char				*err = NULL;
+	zbx_template_link_cache_t	*cache;
+	time_t				now, progress_time;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
+	cache = zbx_template_link_cache_create();
+	progress_time = time(NULL);
+
 	for (i = 0; i < hosts->values_num; i++)
 	{
 		host = (zbx_lld_host_t *)hosts->values[i];
 
+		if (LLD_TEMPLATES_LINK_PROGRESS_PERIOD <= (now = time(NULL)) - progress_time)
+		{
+			zabbix_log(LOG_LEVEL_INFORMATION, "linking templates to discovered hosts: processed %d of %d"
+					" hosts", i, hosts->values_num);
+			progress_time = now;
+		}
+
 		if (0 == (host->flags & ZBX_FLAG_LLD_HOST_DISCOVERED))
 			continue;
 
@@ -3466,7 +3478,7 @@ static void	lld_templates_link(const zbx_vector_ptr_t *hosts, char **error)
 		if (0 != host->lnk_templateids.values_num)
 		{
 			if (SUCCEED != zbx_db_copy_template_elements(host->hostid, &host->lnk_templateids,
-					ZBX_TEMPLATE_LINK_LLD, &err))
+					ZBX_TEMPLATE_LINK_LLD, cache, &err))
 			{
 				*error = zbx_strdcatf(*error, "Cannot link template(s) %s.\n", err);
 				zbx_free(err);
@@ -3474,7 +3486,10 @@ static void	lld_templates_link(const zbx_vector_ptr_t *hosts, char **error)
 		}
 	}
 
+	zbx_template_link_cache_free(cache);
+
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+#undef LLD_TEMPLATES_LINK_PROGRESS_PERIOD
 }
 
 /******************************************************************************
@@ -3577,7 +3592,7 @@ static void	lld_hosts_remove(const zbx_vector_ptr_t *hosts, int lifetime, int la
 
 	if (0 != del_hostids.values_num)
 	{
-		zbx_vector_uint64_sort(&del_hostids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_sort_asc(&del_hostids);
 
 		for (i = 0; i < del_hostids.values_num; i++)
 		{
@@ -3697,7 +3712,7 @@ static void	lld_groups_remove(const zbx_vector_ptr_t *groups, int lifetime, int
 
 	if (0 != del_groupids.values_num)
 	{
-		zbx_vector_uint64_sort(&del_groupids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_sort_asc(&del_groupids);
 
 		zbx_db_begin();
 
@@ -4354,7 +4369,7 @@ static void	lld_interfaces_validate(zbx_vector_ptr_t *hosts, char **error)
 
 	if (0 != interfaceids.values_num)
 	{
-		zbx_vector_uint64_sort(&interfaceids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_sort_asc(&interfaceids);
 
 		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, "select interfaceid,type from items where");
 		zbx_db_add_condition_alloc(&sql, &sql_alloc, &sql_offset, "interfaceid",
@@ -4422,7 +4437,7 @@ static void	lld_interfaces_validate(zbx_vector_ptr_t *hosts, char **error)
 
 	if (0 != interfaceids.values_num)
 	{
-		zbx_vector_uint64_sort(&interfaceids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_sort_asc(&interfaceids);
 
 		sql_offset = 0;
 		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, "select interfaceid from items where");
@@ -180,6 +180,7 @@ static void	lld_item_prototype_free(zbx_lld_item_prototype_t *item_prototype)
 	zbx_free(item_prototype->ssl_cert_file);
 	zbx_free(item_prototype->ssl_key_file);
 	zbx_free(item_prototype->ssl_key_password);
+	zbx_free(item_prototype->history_downsample_param);
 
 	zbx_vector_lld_row_destroy(&item_prototype->lld_rows);
 
@@ -244,6 +245,7 @@ static void	lld_item_free(zbx_lld_item_full_t *item)
 	zbx_free(item->ssl_key_file_orig);
 	zbx_free(item->ssl_key_password);
 	zbx_free(item->ssl_key_password_orig);
+	zbx_free(item->history_downsample_param_orig);
 	zbx_free(item->trapper_hosts_orig);
 	zbx_free(item->formula_orig);
 	zbx_free(item->logtimefmt_orig);
@@ -305,7 +307,7 @@ static void	lld_items_get(const zbx_vector_ptr_t *item_prototypes, zbx_vector_ll
 				"i.timeout,i.url,i.query_fields,i.posts,i.status_codes,i.follow_redirects,i.post_type,"
 				"i.http_proxy,i.headers,i.retrieve_mode,i.request_method,i.output_format,"
 				"i.ssl_cert_file,i.ssl_key_file,i.ssl_key_password,i.verify_peer,i.verify_host,"
-				"id.parent_itemid,i.allow_traps"
+				"id.parent_itemid,i.allow_traps,i.history_downsample,i.history_downsample_param"
 			" from item_discovery id"
 				" join items i"
 					" on id.itemid=i.itemid"
@@ -523,6 +525,20 @@ static void	lld_items_get(const zbx_vector_ptr_t *item_prototypes, zbx_vector_ll
 			item->allow_traps_orig = (unsigned char)atoi(row[46]);
 		}
 
+		if ((unsigned char)atoi(row[47]) != item_prototype->history_downsample)
+		{
+			item->flags |= ZBX_FLAG_LLD_ITEM_UPDATE_DOWNSAMPLE;
+			item->history_downsample_orig = (unsigned char)atoi(row[47]);
+		}
+
+		if (0 != strcmp(row[48], item_prototype->history_downsample_param))
+		{
+			item->flags |= ZBX_FLAG_LLD_ITEM_UPDATE_DOWNSAMPLE_PARAM;
+			item->history_downsample_param_orig = zbx_strdup(NULL, row[48]);
+		}
+		else
+			item->history_downsample_param_orig = NULL;
+
 		item->lld_row = NULL;
 
 		zbx_vector_lld_item_preproc_create(&item->preproc_ops);
@@ -1519,7 +1535,7 @@ static void	lld_items_validate(zbx_uint64_t hostid, zbx_vector_lld_item_full_t *
 
 		if (0 != itemids.values_num)
 		{
-			zbx_vector_uint64_sort(&itemids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+			zbx_vector_uint64_sort_asc(&itemids);
 			zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " and not");
 			zbx_db_add_condition_alloc(&sql, &sql_alloc, &sql_offset, "itemid",
 					itemids.values, itemids.values_num);
@@ -1853,6 +1869,7 @@ static zbx_lld_item_full_t	*lld_item_make(const zbx_lld_item_prototype_t *item_p
 	zbx_substitute_lld_macros(&item->ssl_key_password, jp_row, lld_macro_paths, ZBX_MACRO_ANY, NULL, 0);
 	/* zbx_lrtrim(item->ipmi_sensor, ZBX_WHITESPACE); is not missing here */
 
+	item->history_downsample_param_orig = NULL;
 	item->trapper_hosts_orig = NULL;
 	item->formula_orig = NULL;
 	item->logtimefmt_orig = NULL;
@@ -2736,7 +2753,8 @@ static void	lld_item_save(zbx_uint64_t hostid, const zbx_vector_ptr_t *item_prot
 				item->headers, item_prototype->retrieve_mode, item_prototype->request_method,
 				item_prototype->output_format, item->ssl_cert_file, item->ssl_key_file,
 				item->ssl_key_password, item_prototype->verify_peer, item_prototype->verify_host,
-				item_prototype->allow_traps);
+				item_prototype->allow_traps, (int)item_prototype->history_downsample,
+				item_prototype->history_downsample_param);
 
 		zbx_db_insert_add_values(db_insert_idiscovery, (*itemdiscoveryid)++, *itemid,
 				item->parent_itemid, item_prototype->key);
@@ -3137,9 +3155,27 @@ static void	lld_item_prepare_update(const zbx_lld_item_prototype_t *item_prototy
 	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_ALLOW_TRAPS))
 	{
 		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%sallow_traps=%d", d, (int)item_prototype->allow_traps);
+		d = ",";
 		zbx_audit_item_update_json_update_allow_traps(item->itemid, (int)ZBX_FLAG_DISCOVERY_CREATED,
 				(int)item->allow_traps_orig, (int)item_prototype->allow_traps);
 	}
+	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_DOWNSAMPLE))
+	{
+		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%shistory_downsample=%d", d,
+				(int)item_prototype->history_downsample);
+		d = ",";
+		zbx_audit_item_update_json_update_history_downsample(item->itemid, (int)ZBX_FLAG_DISCOVERY_CREATED,
+				(int)item->history_downsample_orig, (int)item_prototype->history_downsample);
+	}
+	if (0 != (item->flags & ZBX_FLAG_LLD_ITEM_UPDATE_DOWNSAMPLE_PARAM))
+	{
+		value_esc = zbx_db_dyn_escape_string(item_prototype->history_downsample_param);
+		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%shistory_downsample_param='%s'", d, value_esc);
+		zbx_free(value_esc);
+		zbx_audit_item_update_json_update_history_downsample_param(item->itemid,
+				(int)ZBX_FLAG_DISCOVERY_CREATED, item->history_downsample_param_orig,
+				item_prototype->history_downsample_param);
+	}
 
 	zbx_snprintf_alloc(sql, sql_alloc, sql_offset, " where itemid=" ZBX_FS_UI64 ";\n", item->itemid);
 
@@ -3274,7 +3310,7 @@ static int	lld_items_save(zbx_uint64_t hostid, const zbx_vector_ptr_t *item_prot
 	{
 		sql_offset = 0;
 
-		zbx_vector_uint64_sort(&upd_keys, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_sort_asc(&upd_keys);
 
 #ifdef HAVE_MYSQL
 		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "update items set key_=concat('#',key_) where");
@@ -3305,7 +3341,8 @@ static int	lld_items_save(zbx_uint64_t hostid, const zbx_vector_ptr_t *item_prot
 				"jmx_endpoint", "master_itemid", "timeout", "url", "query_fields", "posts",
 				"status_codes", "follow_redirects", "post_type", "http_proxy", "headers",
 				"retrieve_mode", "request_method", "output_format", "ssl_cert_file", "ssl_key_file",
-				"ssl_key_password", "verify_peer", "verify_host", "allow_traps", NULL);
+				"ssl_key_password", "verify_peer", "verify_host", "allow_traps",
+				"history_downsample", "history_downsample_param", NULL);
 
 		zbx_db_insert_prepare(&db_insert_idiscovery, "item_discovery", "itemdiscoveryid", "itemid",
 				"parent_itemid", "key_", NULL);
@@ -4062,7 +4099,8 @@ static void	lld_item_prototypes_get(zbx_uint64_t lld_ruleid, zbx_vector_ptr_t *i
 				"i.jmx_endpoint,i.master_itemid,i.timeout,i.url,i.query_fields,"
 				"i.posts,i.status_codes,i.follow_redirects,i.post_type,i.http_proxy,i.headers,"
 				"i.retrieve_mode,i.request_method,i.output_format,i.ssl_cert_file,i.ssl_key_file,"
-				"i.ssl_key_password,i.verify_peer,i.verify_host,i.allow_traps,i.discover"
+				"i.ssl_key_password,i.verify_peer,i.verify_host,i.allow_traps,i.discover,"
+				"i.history_downsample,i.history_downsample_param"
 			" from items i,item_discovery id"
 			" where i.itemid=id.itemid"
 				" and id.parent_itemid=" ZBX_FS_UI64,
@@ -4118,6 +4156,8 @@ static void	lld_item_prototypes_get(zbx_uint64_t lld_ruleid, zbx_vector_ptr_t *i
 		ZBX_STR2UCHAR(item_prototype->verify_host, row[42]);
 		ZBX_STR2UCHAR(item_prototype->allow_traps, row[43]);
 		ZBX_STR2UCHAR(item_prototype->discover, row[44]);
+		ZBX_STR2UCHAR(item_prototype->history_downsample, row[45]);
+		item_prototype->history_downsample_param = zbx_strdup(NULL, row[46]);
 
 		zbx_vector_lld_row_create(&item_prototype->lld_rows);
 		zbx_vector_lld_item_preproc_create(&item_prototype->preproc_ops);
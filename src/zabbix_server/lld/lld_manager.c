@@ -27,6 +27,7 @@
 #include "lld_protocol.h"
 #include "zbxstr.h"
 #include "zbxtime.h"
+#include "zbxcacheconfig.h"
 
 /*
  * The LLD queue is organized as a queue (rule_queue binary heap) of LLD rules,
@@ -41,8 +42,31 @@
  * values in the list the rule is removed from the index (rule_index hashset),
  * otherwise the rule is enqueued back in LLD queue.
  *
+ * When worker reports that a value was processed successfully the manager keeps
+ * fingerprint of the value with the configuration revision of the rule host. Values
+ * equal to the last processed value of the same discovery rule are skipped without
+ * sending them to workers unless the host has changed or the fingerprint is older
+ * than ZBX_LLD_FINGERPRINT_TTL. The fingerprint lifetime limits delay of applying
+ * changes of prototypes, filters and overrides that are not tracked by the
+ * configuration cache, and staleness of discovered resource lastcheck timestamps.
+ *
  */
 
+#define ZBX_LLD_FINGERPRINT_TTL	(10 * SEC_PER_MIN)
+
+/* processing time statistics are kept for rules processed during the last day */
+#define ZBX_LLD_RULE_TIME_TTL	SEC_PER_DAY
+
+/* fingerprint of the last successfully processed discovery rule value */
+typedef struct
+{
+	zbx_uint64_t	itemid;
+	zbx_uint64_t	hash;
+	zbx_uint64_t	revision;
+	time_t		processed;
+}
+zbx_lld_fingerprint_t;
+
 typedef struct
 {
 	/* workers vector, created during manager initialization */
@@ -66,6 +90,13 @@ typedef struct
 	/* the number of queued LLD rules */
 	zbx_uint64_t		queued_num;
 
+	/* fingerprints of processed values by LLD rule item id */
+	zbx_hashset_t		fingerprints;
+	time_t			fingerprints_pruned;
+
+	/* processing time statistics by LLD rule item id */
+	zbx_hashset_t		rule_times;
+	time_t			rule_times_pruned;
 }
 zbx_lld_manager_t;
 
@@ -73,6 +104,13 @@ typedef struct
 {
 	zbx_ipc_client_t	*client;
 	zbx_lld_rule_t		*rule;
+
+	/* fingerprint of the value being processed, 0 if it cannot be fingerprinted */
+	zbx_uint64_t		hash;
+	zbx_uint64_t		revision;
+
+	/* the time when the value was sent to worker */
+	double			time_start;
 }
 zbx_lld_worker_t;
 
@@ -169,6 +207,12 @@ static void	lld_manager_init(zbx_lld_manager_t *manager, zbx_get_config_forks_f
 
 	zbx_binary_heap_create(&manager->rule_queue, rule_elem_compare_func, ZBX_BINARY_HEAP_OPTION_EMPTY);
 
+	zbx_hashset_create(&manager->fingerprints, 0, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	manager->fingerprints_pruned = time(NULL);
+
+	zbx_hashset_create(&manager->rule_times, 0, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	manager->rule_times_pruned = manager->fingerprints_pruned;
+
 	manager->next_worker_index = 0;
 
 	for (i = 0; i < get_config_forks_cb(ZBX_PROCESS_TYPE_LLDWORKER); i++)
@@ -176,6 +220,9 @@ static void	lld_manager_init(zbx_lld_manager_t *manager, zbx_get_config_forks_f
 		worker = (zbx_lld_worker_t *)zbx_malloc(NULL, sizeof(zbx_lld_worker_t));
 
 		worker->client = NULL;
+		worker->rule = NULL;
+		worker->hash = 0;
+		worker->time_start = 0;
 
 		zbx_vector_ptr_append(&manager->workers, worker);
 	}
@@ -194,6 +241,8 @@ static void	lld_manager_destroy(zbx_lld_manager_t *manager)
 {
 	zbx_binary_heap_destroy(&manager->rule_queue);
 	zbx_hashset_destroy(&manager->rule_index);
+	zbx_hashset_destroy(&manager->fingerprints);
+	zbx_hashset_destroy(&manager->rule_times);
 	zbx_queue_ptr_destroy(&manager->free_workers);
 	zbx_hashset_destroy(&manager->workers_client);
 	zbx_vector_ptr_clear_ext(&manager->workers, (zbx_clean_func_t)lld_worker_free);
@@ -351,6 +400,149 @@ out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: calculates fingerprint of LLD value                               *
+ *                                                                            *
+ * Return value: The value fingerprint or 0 if the value cannot be skipped    *
+ *               when it is not changed.                                      *
+ *                                                                            *
+ * Comments: Errors and values with log metadata always must be processed.    *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint64_t	lld_data_hash(const zbx_lld_data_t *data)
+{
+	zbx_hash_t	hash_lo, hash_hi;
+	size_t		len;
+	zbx_uint64_t	hash;
+
+	if (NULL != data->error || NULL == data->value || 0 != data->meta)
+		return 0;
+
+	len = strlen(data->value);
+	hash_lo = ZBX_DEFAULT_STRING_HASH_ALGO(data->value, len, ZBX_DEFAULT_HASH_SEED);
+
+	/* second hash with different seed reduces probability of collisions */
+	hash_hi = ZBX_DEFAULT_STRING_HASH_ALGO(data->value, len, hash_lo);
+
+	if (0 == (hash = ((zbx_uint64_t)hash_hi << 32) | hash_lo))
+		hash = 1;
+
+	return hash;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if value is equal to the last processed value of the rule  *
+ *                                                                            *
+ * Parameters: manager  - [IN]                                                *
+ *             itemid   - [IN] LLD rule item id                               *
+ *             hash     - [IN] value fingerprint                              *
+ *             revision - [IN] configuration revision of the rule host        *
+ *             now      - [IN] current time                                   *
+ *                                                                            *
+ * Return value: SUCCEED - the value was already processed and can be skipped *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	lld_fingerprint_match(zbx_lld_manager_t *manager, zbx_uint64_t itemid, zbx_uint64_t hash,
+		zbx_uint64_t revision, time_t now)
+{
+	zbx_lld_fingerprint_t	*fingerprint;
+
+	if (0 == hash || NULL == (fingerprint = (zbx_lld_fingerprint_t *)zbx_hashset_search(&manager->fingerprints,
+			&itemid)))
+	{
+		return FAIL;
+	}
+
+	if (fingerprint->hash != hash || fingerprint->revision != revision ||
+			now >= fingerprint->processed + ZBX_LLD_FINGERPRINT_TTL)
+	{
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: updates fingerprint of the last processed value of LLD rule       *
+ *                                                                            *
+ * Parameters: manager   - [IN]                                               *
+ *             itemid    - [IN] LLD rule item id                              *
+ *             worker    - [IN] worker that processed the value               *
+ *             processed - [IN] SUCCEED - the value was processed             *
+ *                                        successfully                        *
+ *                              FAIL    - otherwise                           *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_fingerprint_update(zbx_lld_manager_t *manager, zbx_uint64_t itemid, const zbx_lld_worker_t *worker,
+		int processed)
+{
+	zbx_lld_fingerprint_t	*fingerprint, fingerprint_local = {.itemid = itemid};
+	zbx_hashset_iter_t	iter;
+	time_t			now;
+
+	if (SUCCEED != processed || 0 == worker->hash)
+	{
+		zbx_hashset_remove(&manager->fingerprints, &itemid);
+		return;
+	}
+
+	now = time(NULL);
+
+	if (NULL == (fingerprint = (zbx_lld_fingerprint_t *)zbx_hashset_search(&manager->fingerprints, &itemid)))
+	{
+		fingerprint = (zbx_lld_fingerprint_t *)zbx_hashset_insert(&manager->fingerprints, &fingerprint_local,
+				sizeof(fingerprint_local));
+	}
+
+	fingerprint->hash = worker->hash;
+	fingerprint->revision = worker->revision;
+	fingerprint->processed = now;
+
+	/* remove fingerprints of rules that are not processed anymore */
+	if (now < manager->fingerprints_pruned + ZBX_LLD_FINGERPRINT_TTL)
+		return;
+
+	zbx_hashset_iter_reset(&manager->fingerprints, &iter);
+	while (NULL != (fingerprint = (zbx_lld_fingerprint_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (now >= fingerprint->processed + ZBX_LLD_FINGERPRINT_TTL)
+			zbx_hashset_iter_remove(&iter);
+	}
+
+	manager->fingerprints_pruned = now;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: removes the oldest value of LLD rule and requeues the rule if it  *
+ *          has more values                                                   *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_rule_pop_value(zbx_lld_manager_t *manager, zbx_lld_rule_t *rule)
+{
+	zbx_lld_data_t	*data;
+
+	data = rule->head;
+	rule->head = rule->head->next;
+
+	if (NULL == rule->head)
+	{
+		zbx_hashset_remove_direct(&manager->rule_index, rule);
+	}
+	else
+	{
+		rule->head->prev = NULL;
+		rule->values_num--;
+		lld_queue_rule(manager, rule);
+	}
+
+	lld_data_free(data);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: processes next LLD request from queue                             *
@@ -358,23 +550,58 @@ out:
  * Parameters: manager - [IN]                                                 *
  *             worker  - [IN] target worker                                   *
  *                                                                            *
+ * Return value: SUCCEED - the request was sent to worker                     *
+ *               FAIL    - there are no requests to be processed              *
+ *                                                                            *
+ * Comments: Values equal to the last processed values are skipped.           *
+ *                                                                            *
  ******************************************************************************/
-static void	lld_process_next_request(zbx_lld_manager_t *manager, zbx_lld_worker_t *worker)
+static int	lld_process_next_request(zbx_lld_manager_t *manager, zbx_lld_worker_t *worker)
 {
 	zbx_binary_heap_elem_t	*elem;
 	unsigned char		*buf;
 	zbx_uint32_t		buf_len;
 	zbx_lld_data_t		*data;
+	zbx_lld_rule_t		*rule;
+	time_t			now = time(NULL);
+
+	while (SUCCEED != zbx_binary_heap_empty(&manager->rule_queue))
+	{
+		elem = zbx_binary_heap_find_min(&manager->rule_queue);
+		rule = (zbx_lld_rule_t *)elem->data;
+		zbx_binary_heap_remove_min(&manager->rule_queue);
+
+		data = rule->head;
+
+		/* revision must be taken before the value is processed to detect later changes, */
+		/* values of rules on hosts missing in configuration cache are not fingerprinted  */
+		if (0 != (worker->hash = lld_data_hash(data)) &&
+				0 == (worker->revision = zbx_dc_get_host_config_revision(rule->hostid)))
+		{
+			worker->hash = 0;
+		}
+
+		if (SUCCEED == lld_fingerprint_match(manager, data->itemid, worker->hash, worker->revision, now))
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "skip unchanged value of discovery rule:" ZBX_FS_UI64, data->itemid);
 
-	elem = zbx_binary_heap_find_min(&manager->rule_queue);
-	worker->rule = (zbx_lld_rule_t *)elem->data;
-	zbx_binary_heap_remove_min(&manager->rule_queue);
+			lld_rule_pop_value(manager, rule);
+			manager->queued_num--;
+			continue;
+		}
+
+		worker->rule = rule;
+		worker->time_start = zbx_time();
+
+		buf_len = zbx_lld_serialize_item_value(&buf, data->itemid, 0, data->value, &data->ts, data->meta,
+				data->lastlogsize, data->mtime, data->error);
+		zbx_ipc_client_send(worker->client, ZBX_IPC_LLD_TASK, buf, buf_len);
+		zbx_free(buf);
 
-	data = worker->rule->head;
-	buf_len = zbx_lld_serialize_item_value(&buf, data->itemid, 0, data->value, &data->ts, data->meta,
-			data->lastlogsize, data->mtime, data->error);
-	zbx_ipc_client_send(worker->client, ZBX_IPC_LLD_TASK, buf, buf_len);
-	zbx_free(buf);
+		return SUCCEED;
+	}
+
+	return FAIL;
 }
 
 /******************************************************************************
@@ -391,8 +618,56 @@ static void	lld_process_queue(zbx_lld_manager_t *manager)
 		if (NULL == (worker = zbx_queue_ptr_pop(&manager->free_workers)))
 			break;
 
-		lld_process_next_request(manager, worker);
+		if (SUCCEED != lld_process_next_request(manager, worker))
+		{
+			zbx_queue_ptr_push(&manager->free_workers, worker);
+			break;
+		}
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: updates processing time statistics of LLD rule                    *
+ *                                                                            *
+ * Parameters: manager    - [IN]                                              *
+ *             itemid     - [IN] LLD rule item id                             *
+ *             time_spent - [IN] value processing time in seconds             *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_rule_time_update(zbx_lld_manager_t *manager, zbx_uint64_t itemid, double time_spent)
+{
+	zbx_lld_rule_time_t	*rule_time, rule_time_local = {.itemid = itemid};
+	zbx_hashset_iter_t	iter;
+	time_t			now;
+
+	now = time(NULL);
+
+	if (NULL == (rule_time = (zbx_lld_rule_time_t *)zbx_hashset_search(&manager->rule_times, &itemid)))
+	{
+		rule_time = (zbx_lld_rule_time_t *)zbx_hashset_insert(&manager->rule_times, &rule_time_local,
+				sizeof(rule_time_local));
+	}
+
+	rule_time->values_num++;
+	rule_time->time_last = time_spent;
+	rule_time->processed = now;
+
+	if (rule_time->time_max < time_spent)
+		rule_time->time_max = time_spent;
+
+	/* remove statistics of rules that are not processed anymore */
+	if (now < manager->rule_times_pruned + ZBX_LLD_RULE_TIME_TTL)
+		return;
+
+	zbx_hashset_iter_reset(&manager->rule_times, &iter);
+	while (NULL != (rule_time = (zbx_lld_rule_time_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (now >= rule_time->processed + ZBX_LLD_RULE_TIME_TTL)
+			zbx_hashset_iter_remove(&iter);
 	}
+
+	manager->rule_times_pruned = now;
 }
 
 /******************************************************************************
@@ -400,14 +675,16 @@ static void	lld_process_queue(zbx_lld_manager_t *manager)
  * Purpose: processes LLD worker 'done' response                              *
  *                                                                            *
  * Parameters: manager - [IN]                                                 *
- * Parameters: client  - [IN] worker's IPC client connection                  *
+ *             client  - [IN] worker's IPC client connection                  *
+ *             message - [IN] the response message                            *
  *                                                                            *
  ******************************************************************************/
-static void	lld_process_result(zbx_lld_manager_t *manager, zbx_ipc_client_t *client)
+static void	lld_process_result(zbx_lld_manager_t *manager, zbx_ipc_client_t *client,
+		const zbx_ipc_message_t *message)
 {
 	zbx_lld_worker_t	*worker;
 	zbx_lld_rule_t		*rule;
-	zbx_lld_data_t		*data;
+	int			processed = FAIL;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -415,28 +692,17 @@ static void	lld_process_result(zbx_lld_manager_t *manager, zbx_ipc_client_t *cli
 
 	zabbix_log(LOG_LEVEL_DEBUG, "discovery rule:" ZBX_FS_UI64 " has been processed", worker->rule->head->itemid);
 
+	if (sizeof(processed) <= message->size)
+		memcpy(&processed, message->data, sizeof(processed));
+
 	rule = worker->rule;
 	worker->rule = NULL;
 
-	data = rule->head;
-	rule->head = rule->head->next;
-
-	if (NULL == rule->head)
-	{
-		zbx_hashset_remove_direct(&manager->rule_index, rule);
-	}
-	else
-	{
-		rule->head->prev = NULL;
-		rule->values_num--;
-		lld_queue_rule(manager, rule);
-	}
-
-	lld_data_free(data);
+	lld_fingerprint_update(manager, rule->head->itemid, worker, processed);
+	lld_rule_time_update(manager, rule->head->itemid, zbx_time() - worker->time_start);
+	lld_rule_pop_value(manager, rule);
 
-	if (SUCCEED != zbx_binary_heap_empty(&manager->rule_queue))
-		lld_process_next_request(manager, worker);
-	else
+	if (SUCCEED != lld_process_next_request(manager, worker))
 		zbx_queue_ptr_push(&manager->free_workers, worker);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
@@ -537,6 +803,64 @@ static void	lld_process_top_items(zbx_lld_manager_t *manager, zbx_ipc_client_t *
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: sort lld manager rule processing time view by the last            *
+ *          processing time in descending order                               *
+ *                                                                            *
+ ******************************************************************************/
+static int	lld_diag_time_compare_desc(const void *d1, const void *d2)
+{
+	const zbx_lld_rule_time_t	*r1 = *(const zbx_lld_rule_time_t * const *)d1;
+	const zbx_lld_rule_time_t	*r2 = *(const zbx_lld_rule_time_t * const *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(r2->time_last, r1->time_last);
+
+	return 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: processes external top processing times request                   *
+ *                                                                            *
+ * Parameters: manager - [IN]                                                 *
+ *             client  - [IN] connected worker IPC client data                *
+ *             message - [IN] received message                                *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_process_top_times(zbx_lld_manager_t *manager, zbx_ipc_client_t *client,
+		const zbx_ipc_message_t *message)
+{
+	int			limit;
+	unsigned char		*data;
+	zbx_uint32_t		data_len;
+	zbx_vector_ptr_t	view;
+	zbx_hashset_iter_t	iter;
+	zbx_lld_rule_time_t	*rule_time;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	zbx_lld_deserialize_top_items_request(message->data, &limit);
+
+	zbx_vector_ptr_create(&view);
+	zbx_vector_ptr_reserve(&view, (size_t)manager->rule_times.num_data);
+
+	zbx_hashset_iter_reset(&manager->rule_times, &iter);
+	while (NULL != (rule_time = (zbx_lld_rule_time_t *)zbx_hashset_iter_next(&iter)))
+		zbx_vector_ptr_append(&view, rule_time);
+
+	zbx_vector_ptr_sort(&view, lld_diag_time_compare_desc);
+
+	data_len = zbx_lld_serialize_top_times_result(&data, (const zbx_lld_rule_time_t **)view.values,
+			MIN(limit, view.values_num));
+	zbx_ipc_client_send(client, ZBX_IPC_LLD_TOP_TIMES_RESULT, data, data_len);
+
+	zbx_free(data);
+	zbx_vector_ptr_destroy(&view);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: main processing loop                                              *
@@ -622,7 +946,7 @@ ZBX_THREAD_ENTRY(lld_manager_thread, args)
 					lld_process_queue(&manager);
 					break;
 				case ZBX_IPC_LLD_DONE:
-					lld_process_result(&manager, client);
+					lld_process_result(&manager, client, message);
 					processed_num++;
 					manager.queued_num--;
 					break;
@@ -636,6 +960,9 @@ ZBX_THREAD_ENTRY(lld_manager_thread, args)
 				case ZBX_IPC_LLD_TOP_ITEMS:
 					lld_process_top_items(&manager, client, message);
 					break;
+				case ZBX_IPC_LLD_TOP_TIMES:
+					lld_process_top_times(&manager, client, message);
+					break;
 			}
 
 			zbx_ipc_message_free(message);
@@ -21,6 +21,7 @@
 #define ZABBIX_LLD_MANAGER_H
 
 #include "zbxthreads.h"
+#include "zbxalgo.h"
 #include "zbxtime.h"
 
 typedef struct zbx_lld_value
@@ -67,6 +68,26 @@ typedef struct
 }
 zbx_lld_rule_info_t;
 
+/* processing time statistics of LLD rule */
+typedef struct
+{
+	/* the LLD rule item id */
+	zbx_uint64_t	itemid;
+
+	/* the number of processed values */
+	int		values_num;
+
+	/* the last and the longest value processing time in seconds */
+	double		time_last;
+	double		time_max;
+
+	/* the time when the last value was processed */
+	time_t		processed;
+}
+zbx_lld_rule_time_t;
+
+ZBX_VECTOR_DECL(lld_rule_time, zbx_lld_rule_time_t)
+
 typedef struct
 {
 	zbx_get_config_forks_f	get_process_forks_cb_arg;
@@ -24,6 +24,11 @@
 #include "zbxipcservice.h"
 #include "zbxsysinfo.h"
 
+ZBX_VECTOR_IMPL(lld_rule_time, zbx_lld_rule_time_t)
+
+/* each process has a permanent connection to LLD manager for queuing values */
+static zbx_ipc_socket_t	lld_queue_socket;
+
 zbx_uint32_t	zbx_lld_serialize_item_value(unsigned char **data, zbx_uint64_t itemid, zbx_uint64_t hostid,
 		const char *value, const zbx_timespec_t *ts, unsigned char meta, zbx_uint64_t lastlogsize, int mtime,
 		const char *error)
@@ -173,6 +178,62 @@ static void	zbx_lld_deserialize_top_items_result(const unsigned char *data, zbx_
 	}
 }
 
+zbx_uint32_t	zbx_lld_serialize_top_times_result(unsigned char **data, const zbx_lld_rule_time_t **rule_times,
+		int num)
+{
+	unsigned char	*ptr;
+	zbx_uint32_t	data_len = 0, item_len = 0;
+	int		i;
+
+	if (0 != num)
+	{
+		zbx_serialize_prepare_value(item_len, rule_times[0]->itemid);
+		zbx_serialize_prepare_value(item_len, rule_times[0]->values_num);
+		zbx_serialize_prepare_value(item_len, rule_times[0]->time_last);
+		zbx_serialize_prepare_value(item_len, rule_times[0]->time_max);
+	}
+
+	zbx_serialize_prepare_value(data_len, num);
+	data_len += item_len * num;
+	*data = (unsigned char *)zbx_malloc(NULL, data_len);
+
+	ptr = *data;
+	ptr += zbx_serialize_value(ptr, num);
+
+	for (i = 0; i < num; i++)
+	{
+		ptr += zbx_serialize_value(ptr, rule_times[i]->itemid);
+		ptr += zbx_serialize_value(ptr, rule_times[i]->values_num);
+		ptr += zbx_serialize_value(ptr, rule_times[i]->time_last);
+		ptr += zbx_serialize_value(ptr, rule_times[i]->time_max);
+	}
+
+	return data_len;
+}
+
+static void	zbx_lld_deserialize_top_times_result(const unsigned char *data, zbx_vector_lld_rule_time_t *times)
+{
+	int	i, times_num;
+
+	data += zbx_deserialize_value(data, &times_num);
+
+	if (0 != times_num)
+	{
+		zbx_vector_lld_rule_time_reserve(times, (size_t)times_num);
+
+		for (i = 0; i < times_num; i++)
+		{
+			zbx_lld_rule_time_t	rule_time = {0};
+
+			data += zbx_deserialize_value(data, &rule_time.itemid);
+			data += zbx_deserialize_value(data, &rule_time.values_num);
+			data += zbx_deserialize_value(data, &rule_time.time_last);
+			data += zbx_deserialize_value(data, &rule_time.time_max);
+			zbx_vector_lld_rule_time_append_ptr(times, &rule_time);
+		}
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: enqueue low level discovery value/error                           *
@@ -186,17 +247,20 @@ static void	zbx_lld_deserialize_top_items_result(const unsigned char *data, zbx_
  *             mtime       - [IN] (metadata)                                  *
  *             error       - [IN] error message (can be NULL)                 *
  *                                                                            *
+ * Comments: The values are coalesced and sent to LLD manager in batches,     *
+ *           zbx_lld_queue_flush() must be called to send the remaining       *
+ *           values.                                                          *
+ *                                                                            *
  ******************************************************************************/
 void	zbx_lld_queue_value(zbx_uint64_t itemid, zbx_uint64_t hostid, const char *value, const zbx_timespec_t *ts,
 		unsigned char meta, zbx_uint64_t lastlogsize, int mtime, const char *error)
 {
-	static zbx_ipc_socket_t	socket;
-	char			*errmsg = NULL;
-	unsigned char		*data;
-	zbx_uint32_t		data_len;
+	char		*errmsg = NULL;
+	unsigned char	*data;
+	zbx_uint32_t	data_len;
 
-	/* each process has a permanent connection to manager */
-	if (0 == socket.fd && FAIL == zbx_ipc_socket_open(&socket, ZBX_IPC_SERVICE_LLD, SEC_PER_MIN, &errmsg))
+	if (0 == lld_queue_socket.fd && FAIL == zbx_ipc_socket_open(&lld_queue_socket, ZBX_IPC_SERVICE_LLD,
+			SEC_PER_MIN, &errmsg))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot connect to LLD manager service: %s", errmsg);
 		exit(EXIT_FAILURE);
@@ -204,7 +268,7 @@ void	zbx_lld_queue_value(zbx_uint64_t itemid, zbx_uint64_t hostid, const char *v
 
 	data_len = zbx_lld_serialize_item_value(&data, itemid, hostid, value, ts, meta, lastlogsize, mtime, error);
 
-	if (FAIL == zbx_ipc_socket_write(&socket, ZBX_IPC_LLD_REQUEST, data, data_len))
+	if (FAIL == zbx_ipc_socket_write_batch(&lld_queue_socket, ZBX_IPC_LLD_REQUEST, data, data_len))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot send data to LLD manager service");
 		exit(EXIT_FAILURE);
@@ -213,6 +277,23 @@ void	zbx_lld_queue_value(zbx_uint64_t itemid, zbx_uint64_t hostid, const char *v
 	zbx_free(data);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: send coalesced low level discovery values to LLD manager          *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_lld_queue_flush(void)
+{
+	if (0 == lld_queue_socket.fd)
+		return;
+
+	if (FAIL == zbx_ipc_socket_flush(&lld_queue_socket))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "cannot send data to LLD manager service");
+		exit(EXIT_FAILURE);
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: process low level discovery agent result                          *
@@ -246,7 +327,10 @@ void	zbx_lld_process_agent_result(zbx_uint64_t itemid, zbx_uint64_t hostid, AGEN
 	}
 
 	if (NULL != value || NULL != error || 0 != meta)
+	{
 		zbx_lld_queue_value(itemid, hostid, value, ts, meta, lastlogsize, mtime, error);
+		zbx_lld_queue_flush();
+	}
 }
 
 /******************************************************************************
@@ -346,3 +430,37 @@ out:
 
 	return ret;
 }
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get the top N items by the last value processing time             *
+ *                                                                            *
+ * Parameters limit - [IN] number of top records to retrieve                  *
+ *            times - [OUT] vector of top item processing time statistics     *
+ *            error - [OUT] error message                                     *
+ *                                                                            *
+ * Return value: SUCCEED - the top n items were returned successfully         *
+ *               FAIL - otherwise                                             *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_lld_get_top_times(int limit, zbx_vector_lld_rule_time_t *times, char **error)
+{
+	int		ret;
+	unsigned char	*data, *result;
+	zbx_uint32_t	data_len;
+
+	data_len = zbx_lld_serialize_top_items_request(&data, limit);
+
+	if (SUCCEED != (ret = zbx_ipc_async_exchange(ZBX_IPC_SERVICE_LLD, ZBX_IPC_LLD_TOP_TIMES, SEC_PER_MIN, data,
+			data_len, &result, error)))
+	{
+		goto out;
+	}
+
+	zbx_lld_deserialize_top_times_result(result, times);
+	zbx_free(result);
+out:
+	zbx_free(data);
+
+	return ret;
+}
@@ -51,6 +51,12 @@
 /* manager -> process */
 #define ZBX_IPC_LLD_TOP_ITEMS_RESULT	1403
 
+/* process -> manager */
+#define ZBX_IPC_LLD_TOP_TIMES		1404
+
+/* manager -> process */
+#define ZBX_IPC_LLD_TOP_TIMES_RESULT	1405
+
 zbx_uint32_t	zbx_lld_serialize_item_value(unsigned char **data, zbx_uint64_t itemid, zbx_uint64_t hostid,
 		const char *value, const zbx_timespec_t *ts, unsigned char meta, zbx_uint64_t lastlogsize, int mtime,
 		const char *error);
@@ -66,8 +72,12 @@ void	zbx_lld_deserialize_top_items_request(const unsigned char *data, int *limit
 zbx_uint32_t	zbx_lld_serialize_top_items_result(unsigned char **data, const zbx_lld_rule_info_t **rule_infos,
 		int num);
 
+zbx_uint32_t	zbx_lld_serialize_top_times_result(unsigned char **data, const zbx_lld_rule_time_t **rule_times,
+		int num);
+
 void	zbx_lld_queue_value(zbx_uint64_t itemid, zbx_uint64_t hostid, const char *value, const zbx_timespec_t *ts,
 		unsigned char meta, zbx_uint64_t lastlogsize, int mtime, const char *error);
+void	zbx_lld_queue_flush(void);
 
 void	zbx_lld_process_agent_result(zbx_uint64_t itemid, zbx_uint64_t hostid, AGENT_RESULT *result,
 		zbx_timespec_t *ts, char *error);
@@ -77,5 +87,6 @@ int	zbx_lld_get_queue_size(zbx_uint64_t *size, char **error);
 int	zbx_lld_get_diag_stats(zbx_uint64_t *items_num, zbx_uint64_t *values_num, char **error);
 
 int	zbx_lld_get_top_items(int limit, zbx_vector_uint64_pair_t *items, char **error);
+int	zbx_lld_get_top_times(int limit, zbx_vector_lld_rule_time_t *times, char **error);
 
 #endif
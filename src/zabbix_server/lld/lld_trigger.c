@@ -556,7 +556,7 @@ static void	lld_functions_get(zbx_vector_ptr_t *trigger_prototypes, zbx_vector_p
 		size_t			sql_alloc = 256, sql_offset = 0;
 		int			index;
 
-		zbx_vector_uint64_sort(&triggerids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_sort_asc(&triggerids);
 
 		sql = (char *)zbx_malloc(sql, sql_alloc);
 
@@ -667,7 +667,7 @@ static void	lld_dependencies_get(zbx_vector_ptr_t *trigger_prototypes, zbx_vecto
 		zbx_vector_uint64_append(&triggerids, trigger->triggerid);
 	}
 
-	zbx_vector_uint64_sort(&triggerids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_sort_asc(&triggerids);
 
 	sql = (char *)zbx_malloc(sql, sql_alloc);
 
@@ -765,7 +765,7 @@ static void	lld_tags_get(const zbx_vector_ptr_t *trigger_prototypes, zbx_vector_
 		zbx_vector_uint64_append(&triggerids, trigger->triggerid);
 	}
 
-	zbx_vector_uint64_sort(&triggerids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_sort_asc(&triggerids);
 
 	sql = (char *)zbx_malloc(sql, sql_alloc);
 
@@ -2172,7 +2172,7 @@ static void	lld_triggers_validate(zbx_uint64_t hostid, zbx_vector_ptr_t *trigger
 
 		if (0 != triggerids.values_num)
 		{
-			zbx_vector_uint64_sort(&triggerids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+			zbx_vector_uint64_sort_asc(&triggerids);
 			zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " and not");
 			zbx_db_add_condition_alloc(&sql, &sql_alloc, &sql_offset, "tg.triggerid",
 					triggerids.values, triggerids.values_num);
@@ -2913,7 +2913,7 @@ static int	lld_triggers_save(zbx_uint64_t hostid, const zbx_vector_ptr_t *trigge
 
 	if (0 != del_functionids.values_num)
 	{
-		zbx_vector_uint64_sort(&del_functionids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_sort_asc(&del_functionids);
 
 		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, "delete from functions where");
 		zbx_db_add_condition_alloc(&sql, &sql_alloc, &sql_offset, "functionid",
@@ -2923,7 +2923,7 @@ static int	lld_triggers_save(zbx_uint64_t hostid, const zbx_vector_ptr_t *trigge
 
 	if (0 != del_triggerdepids.values_num)
 	{
-		zbx_vector_uint64_sort(&del_triggerdepids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_sort_asc(&del_triggerdepids);
 
 		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, "delete from trigger_depends where");
 		zbx_db_add_condition_alloc(&sql, &sql_alloc, &sql_offset, "triggerdepid",
@@ -2933,7 +2933,7 @@ static int	lld_triggers_save(zbx_uint64_t hostid, const zbx_vector_ptr_t *trigge
 
 	if (0 != del_triggertagids.values_num)
 	{
-		zbx_vector_uint64_sort(&del_triggertagids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_sort_asc(&del_triggertagids);
 
 		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, "delete from trigger_tag where");
 		zbx_db_add_condition_alloc(&sql, &sql_alloc, &sql_offset, "triggertagid",
@@ -3217,8 +3217,7 @@ static void	lld_trigger_cache_init(zbx_hashset_t *cache, zbx_vector_ptr_t *trigg
 		if (0 != triggerids_down.values_num)
 		{
 			sql_offset = 0;
-			zbx_vector_uint64_sort(&triggerids_down, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
-			zbx_vector_uint64_uniq(&triggerids_down, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+			zbx_vector_uint64_sort_uniq(&triggerids_down);
 
 			zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
 					"select td.triggerid_down,td.triggerid_up"
@@ -3300,8 +3299,7 @@ static void	lld_trigger_cache_init(zbx_hashset_t *cache, zbx_vector_ptr_t *trigg
 		if (0 != triggerids_up.values_num)
 		{
 			sql_offset = 0;
-			zbx_vector_uint64_sort(&triggerids_up, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
-			zbx_vector_uint64_uniq(&triggerids_up, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+			zbx_vector_uint64_sort_uniq(&triggerids_up);
 
 			zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
 					"select td.triggerid_down"
@@ -55,15 +55,18 @@ static void	lld_register_worker(zbx_ipc_socket_t *socket)
  *                                                                            *
  * Parameters: message - [IN] message with LLD request                        *
  *                                                                            *
+ * Return value: SUCCEED - the discovery rule value was processed             *
+ *               FAIL    - the value was not processed or processing failed   *
+ *                                                                            *
  ******************************************************************************/
-static void	lld_process_task(zbx_ipc_message_t *message)
+static int	lld_process_task(zbx_ipc_message_t *message)
 {
 	zbx_uint64_t		itemid, hostid, lastlogsize;
 	char			*value, *error;
 	zbx_timespec_t		ts;
 	zbx_item_diff_t		diff;
 	zbx_dc_item_t		item;
-	int			errcode, mtime;
+	int			errcode, mtime, ret = FAIL;
 	unsigned char		state, meta;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
@@ -82,7 +85,10 @@ static void	lld_process_task(zbx_ipc_message_t *message)
 	if (NULL != error || NULL != value)
 	{
 		if (NULL == error && SUCCEED == lld_process_discovery_rule(itemid, value, &error))
+		{
 			state = ITEM_STATE_NORMAL;
+			ret = SUCCEED;
+		}
 		else
 			state = ITEM_STATE_NOTSUPPORTED;
 
@@ -163,7 +169,9 @@ out:
 	zbx_free(value);
 	zbx_free(error);
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
 }
 
 ZBX_THREAD_ENTRY(lld_worker_thread, args)
@@ -171,6 +179,7 @@ ZBX_THREAD_ENTRY(lld_worker_thread, args)
 	char			*error = NULL;
 	zbx_ipc_socket_t	lld_socket;
 	zbx_ipc_message_t	message;
+	int			processed;
 	double			time_stat, time_idle = 0, time_now, time_read;
 	zbx_uint64_t		processed_num = 0;
 	zbx_thread_info_t	*info = &((zbx_thread_args_t *)args)->info;
@@ -233,8 +242,10 @@ ZBX_THREAD_ENTRY(lld_worker_thread, args)
 		switch (message.code)
 		{
 			case ZBX_IPC_LLD_TASK:
-				lld_process_task(&message);
-				zbx_ipc_socket_write(&lld_socket, ZBX_IPC_LLD_DONE, NULL, 0);
+				/* report successful processing so the manager can skip repeated values */
+				processed = lld_process_task(&message);
+				zbx_ipc_socket_write(&lld_socket, ZBX_IPC_LLD_DONE, (unsigned char *)&processed,
+						sizeof(processed));
 				processed_num++;
 				break;
 		}
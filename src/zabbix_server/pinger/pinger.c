@@ -422,7 +422,7 @@ static void	get_pinger_hosts(icmpitem_t **icmp_items, int *icmp_items_alloc, int
 	um_handle = zbx_dc_open_user_macros();
 
 	items = &item;
-	num = zbx_dc_config_get_poller_items(ZBX_POLLER_TYPE_PINGER, config_timeout, &items);
+	num = zbx_dc_config_get_poller_items(ZBX_POLLER_TYPE_PINGER, config_timeout, 0, 0, &items);
 
 	for (i = 0; i < num; i++)
 	{
@@ -459,9 +459,6 @@ static void	get_pinger_hosts(icmpitem_t **icmp_items, int *icmp_items_alloc, int
 
 	zbx_dc_config_clean_items(items, NULL, num);
 
-	if (items != &item)
-		zbx_free(items);
-
 	zbx_preprocessor_flush();
 
 	zbx_dc_close_user_macros(um_handle);
@@ -0,0 +1,692 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "async_agent.h"
+#include "poller.h"
+
+#include "log.h"
+#include "zbxsysinfo.h"
+#include "zbxjson.h"
+
+#if !(defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL))
+extern unsigned char	program_type;
+#endif
+
+#define ZBX_AGENT_STEP_CONNECT	0
+#define ZBX_AGENT_STEP_TLS	1
+#define ZBX_AGENT_STEP_SEND	2
+#define ZBX_AGENT_STEP_RECV	3
+
+/* the maximum number of items of one interface requested over a single connection */
+#define ZBX_AGENT_BATCH_MAX		16
+
+/* how often agents which did not understand batch request are probed again */
+#define ZBX_AGENT_BATCH_PROBE_PERIOD	SEC_PER_HOUR
+
+typedef struct
+{
+	zbx_uint64_t	interfaceid;
+	int		nextprobe;
+}
+zbx_agent_nobatch_t;
+
+/* interfaces of agents which do not support batch requests */
+static zbx_hashset_t	agent_nobatch;
+static int		agent_nobatch_init = 0;
+
+static void	agent_context_start(struct event_base *base, zbx_agent_context_t *agent_context);
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: check if items of interface may be requested in one batch         *
+ *                                                                            *
+ ******************************************************************************/
+static int	agent_batch_allowed(zbx_uint64_t interfaceid, int now)
+{
+	zbx_agent_nobatch_t	*nobatch;
+
+	if (0 == agent_nobatch_init)
+		return SUCCEED;
+
+	if (NULL == (nobatch = (zbx_agent_nobatch_t *)zbx_hashset_search(&agent_nobatch, &interfaceid)))
+		return SUCCEED;
+
+	if (now < nobatch->nextprobe)
+		return FAIL;
+
+	zbx_hashset_remove_direct(&agent_nobatch, nobatch);
+
+	return SUCCEED;
+}
+
+static void	agent_batch_disable(zbx_uint64_t interfaceid)
+{
+	zbx_agent_nobatch_t	*nobatch, nobatch_local;
+
+	if (0 == agent_nobatch_init)
+	{
+		zbx_hashset_create(&agent_nobatch, 100, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		agent_nobatch_init = 1;
+	}
+
+	nobatch_local.interfaceid = interfaceid;
+	nobatch = (zbx_agent_nobatch_t *)zbx_hashset_insert(&agent_nobatch, &nobatch_local, sizeof(nobatch_local));
+	nobatch->nextprobe = (int)time(NULL) + ZBX_AGENT_BATCH_PROBE_PERIOD;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: release connection resources of the check                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_context_close(zbx_agent_context_t *agent_context)
+{
+	/* events are created only after connection is started */
+	if (NULL != agent_context->ev)
+	{
+		event_free(agent_context->ev);
+		event_free(agent_context->ev_timeout);
+		agent_context->ev = NULL;
+		agent_context->ev_timeout = NULL;
+
+		zbx_tcp_close(&agent_context->s);
+	}
+
+	zbx_tcp_send_context_clear(&agent_context->send_context);
+	zbx_free(agent_context->request);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: finish the check and the checks of its batch                      *
+ *                                                                            *
+ * Parameters: agent_context - [IN] the check                                 *
+ *             errcode       - [IN] the check result code                     *
+ *             propagate     - [IN] 1 - set the same result for all batch     *
+ *                                      items (connection failures)           *
+ *                                  0 - batch items already have results      *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_context_finish_ext(zbx_agent_context_t *agent_context, int errcode, int propagate)
+{
+	int	i;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() key:'%s' addr:'%s' errcode:%s batch:%d", __func__,
+			agent_context->item.key, agent_context->item.interface.addr, zbx_result_string(errcode),
+			agent_context->batch_num);
+
+	agent_context->errcode = errcode;
+
+	agent_context_close(agent_context);
+
+	zbx_vector_ptr_append(agent_context->finished, agent_context);
+
+	for (i = 0; i < agent_context->batch_num; i++)
+	{
+		zbx_agent_context_t	*batch_context = agent_context->batch[i];
+
+		if (0 != propagate)
+		{
+			batch_context->errcode = errcode;
+
+			if (NULL != agent_context->result.msg)
+				SET_MSG_RESULT(&batch_context->result, zbx_strdup(NULL, agent_context->result.msg));
+		}
+
+		zbx_vector_ptr_append(agent_context->finished, batch_context);
+	}
+}
+
+static void	agent_context_finish(zbx_agent_context_t *agent_context, int errcode)
+{
+	agent_context_finish_ext(agent_context, errcode, 1);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: convert agent response into check result                          *
+ *                                                                            *
+ * Parameters: agent_context - [IN] the check                                 *
+ *             response      - [IN] the response data                         *
+ *             response_len  - [IN] the response data size                    *
+ *             received_len  - [IN] the number of received bytes              *
+ *             result        - [OUT] the check result                         *
+ *                                                                            *
+ * Return value: SUCCEED - value was retrieved                                *
+ *               NETWORK_ERROR - agent closed connection without response     *
+ *               NOTSUPPORTED - item not supported by the agent               *
+ *               AGENT_ERROR - uncritical error on agent side occurred        *
+ *                                                                            *
+ ******************************************************************************/
+static int	agent_process_value(const zbx_agent_context_t *agent_context, char *response,
+		size_t response_len, ssize_t received_len, AGENT_RESULT *result)
+{
+	zabbix_log(LOG_LEVEL_DEBUG, "get value from agent result: '%s'", response);
+
+	if (0 == strcmp(response, ZBX_NOTSUPPORTED))
+	{
+		/* 'ZBX_NOTSUPPORTED\0<error message>' */
+		if (sizeof(ZBX_NOTSUPPORTED) < response_len)
+			SET_MSG_RESULT(result, zbx_dsprintf(NULL, "%s", response + sizeof(ZBX_NOTSUPPORTED)));
+		else
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Not supported by Zabbix Agent"));
+
+		return NOTSUPPORTED;
+	}
+
+	if (0 == strcmp(response, ZBX_ERROR))
+	{
+		SET_MSG_RESULT(result, zbx_strdup(NULL, "Zabbix Agent non-critical error"));
+		return AGENT_ERROR;
+	}
+
+	if (0 == received_len)
+	{
+		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Received empty response from Zabbix Agent at [%s]."
+				" Assuming that agent dropped connection because of access permissions.",
+				agent_context->item.interface.addr));
+		return NETWORK_ERROR;
+	}
+
+	zbx_set_agent_result_type(result, ITEM_VALUE_TYPE_TEXT, response);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: set check result from an element of batch response                *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_batch_set_result(zbx_agent_context_t *agent_context, const char *row, char **value,
+		size_t *value_alloc)
+{
+	struct zbx_json_parse	jp_row;
+
+	if (NULL == row || SUCCEED != zbx_json_brackets_open(row, &jp_row))
+	{
+		SET_MSG_RESULT(&agent_context->result, zbx_strdup(NULL, "Missing value in Zabbix Agent response."));
+		agent_context->errcode = NOTSUPPORTED;
+	}
+	else if (SUCCEED == zbx_json_value_by_name_dyn(&jp_row, ZBX_PROTO_TAG_VALUE, value, value_alloc, NULL))
+	{
+		zbx_set_agent_result_type(&agent_context->result, ITEM_VALUE_TYPE_TEXT, *value);
+		agent_context->errcode = SUCCEED;
+	}
+	else if (SUCCEED == zbx_json_value_by_name_dyn(&jp_row, ZBX_PROTO_TAG_ERROR, value, value_alloc, NULL) &&
+			0 != strcmp(*value, ZBX_NOTSUPPORTED))
+	{
+		SET_MSG_RESULT(&agent_context->result, zbx_strdup(NULL, *value));
+		agent_context->errcode = NOTSUPPORTED;
+	}
+	else
+	{
+		SET_MSG_RESULT(&agent_context->result, zbx_strdup(NULL, "Not supported by Zabbix Agent"));
+		agent_context->errcode = NOTSUPPORTED;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: restart items of batch as separate checks                         *
+ *                                                                            *
+ * Comments: Used when agent did not understand batch request.                *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_batch_fallback(zbx_agent_context_t *agent_context)
+{
+	struct event_base	*base = event_get_base(agent_context->ev);
+	zbx_agent_context_t	**batch = agent_context->batch;
+	int			i, batch_num = agent_context->batch_num;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "agent at [%s] does not support batch requests, falling back to single checks",
+			agent_context->item.interface.addr);
+
+	agent_batch_disable(agent_context->item.interface.interfaceid);
+
+	agent_context_close(agent_context);
+
+	agent_context->batch = NULL;
+	agent_context->batch_num = 0;
+
+	agent_context_start(base, agent_context);
+
+	for (i = 0; i < batch_num; i++)
+		agent_context_start(base, batch[i]);
+
+	zbx_free(batch);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: process agent response and finish the check                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_process_response(zbx_agent_context_t *agent_context, ssize_t received_len)
+{
+	zbx_socket_t		*s = &agent_context->s;
+	struct zbx_json_parse	jp, jp_data;
+	const char		*p = NULL;
+	char			*value = NULL;
+	size_t			value_alloc = 0;
+	int			i;
+
+	if (0 == agent_context->batch_num)
+	{
+		agent_context_finish(agent_context, agent_process_value(agent_context, s->buffer, s->read_bytes,
+				received_len, &agent_context->result));
+		return;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "get values from agent result: '%s'", s->buffer);
+
+	if ('{' != *s->buffer || SUCCEED != zbx_json_open(s->buffer, &jp) ||
+			SUCCEED != zbx_json_brackets_by_name(&jp, ZBX_PROTO_TAG_DATA, &jp_data))
+	{
+		if (0 == received_len)
+		{
+			agent_context_finish(agent_context, agent_process_value(agent_context, s->buffer,
+					s->read_bytes, received_len, &agent_context->result));
+		}
+		else
+			agent_batch_fallback(agent_context);
+
+		return;
+	}
+
+	/* the response data contains values of the batch items in the request order */
+	p = zbx_json_next(&jp_data, p);
+	agent_batch_set_result(agent_context, p, &value, &value_alloc);
+
+	for (i = 0; i < agent_context->batch_num; i++)
+	{
+		if (NULL != p)
+			p = zbx_json_next(&jp_data, p);
+
+		agent_batch_set_result(agent_context->batch[i], p, &value, &value_alloc);
+	}
+
+	zbx_free(value);
+
+	agent_context_finish_ext(agent_context, agent_context->errcode, 0);
+}
+
+static void	agent_check_event_cb(evutil_socket_t fd, short what, void *arg);
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: wait for socket to become ready for the next check step           *
+ *                                                                            *
+ * Parameters: agent_context - [IN/OUT] agent check context                   *
+ *             event         - [IN] POLLIN or POLLOUT                         *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_context_wait(zbx_agent_context_t *agent_context, short event)
+{
+	struct event_base	*base = event_get_base(agent_context->ev);
+
+	event_assign(agent_context->ev, base, agent_context->s.socket, 0 != (event & POLLIN) ? EV_READ : EV_WRITE,
+			agent_check_event_cb, agent_context);
+	event_add(agent_context->ev, NULL);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: advance agent check until it has to wait for socket or finishes   *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_check_process(zbx_agent_context_t *agent_context)
+{
+	short	event;
+	ssize_t	received_len;
+
+	while (1)
+	{
+		switch (agent_context->step)
+		{
+			case ZBX_AGENT_STEP_CONNECT:
+				if (SUCCEED != zbx_tcp_connect_check(&agent_context->s))
+					goto network_error;
+
+				if (ZBX_TCP_SEC_UNENCRYPTED != agent_context->item.host.tls_connect)
+					agent_context->step = ZBX_AGENT_STEP_TLS;
+				else
+					agent_context->step = ZBX_AGENT_STEP_SEND;
+				break;
+			case ZBX_AGENT_STEP_TLS:
+#if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
+				if (SUCCEED != zbx_tcp_tls_connect(&agent_context->s,
+						agent_context->item.host.tls_connect, agent_context->tls_arg1,
+						agent_context->tls_arg2, &event))
+				{
+					if (0 != event)
+						goto wait;
+
+					goto network_error;
+				}
+
+				agent_context->step = ZBX_AGENT_STEP_SEND;
+				break;
+#else
+				THIS_SHOULD_NEVER_HAPPEN;
+				goto network_error;
+#endif
+			case ZBX_AGENT_STEP_SEND:
+				if (SUCCEED != zbx_tcp_send_context(&agent_context->s, &agent_context->send_context,
+						&event))
+				{
+					if (0 != event)
+						goto wait;
+
+					goto network_error;
+				}
+
+				/* agent evaluates batch items one after another, each within the timeout */
+				if (0 != agent_context->batch_num)
+				{
+					struct timeval	tv = {agent_context->timeout * (agent_context->batch_num + 1), 0};
+
+					evtimer_add(agent_context->ev_timeout, &tv);
+				}
+
+				zbx_tcp_recv_context_init(&agent_context->s, &agent_context->recv_context, 0);
+				agent_context->step = ZBX_AGENT_STEP_RECV;
+				break;
+			case ZBX_AGENT_STEP_RECV:
+				if (FAIL == (received_len = zbx_tcp_recv_context(&agent_context->s,
+						&agent_context->recv_context, 0, &event)))
+				{
+					if (0 != event)
+						goto wait;
+
+					goto network_error;
+				}
+
+				agent_process_response(agent_context, received_len);
+				return;
+			default:
+				THIS_SHOULD_NEVER_HAPPEN;
+				SET_MSG_RESULT(&agent_context->result, zbx_strdup(NULL, "Invalid agent check state."));
+				agent_context_finish(agent_context, CONFIG_ERROR);
+				return;
+		}
+	}
+wait:
+	agent_context_wait(agent_context, event);
+	return;
+network_error:
+	SET_MSG_RESULT(&agent_context->result, zbx_dsprintf(NULL, "Get value from agent failed: %s",
+			zbx_socket_strerror()));
+	agent_context_finish(agent_context, NETWORK_ERROR);
+}
+
+static void	agent_check_event_cb(evutil_socket_t fd, short what, void *arg)
+{
+	zbx_agent_context_t	*agent_context = (zbx_agent_context_t *)arg;
+
+	ZBX_UNUSED(fd);
+	ZBX_UNUSED(what);
+
+	agent_check_process(agent_context);
+}
+
+static void	agent_check_timeout_cb(evutil_socket_t fd, short what, void *arg)
+{
+	zbx_agent_context_t	*agent_context = (zbx_agent_context_t *)arg;
+	const char		*operation;
+
+	ZBX_UNUSED(fd);
+	ZBX_UNUSED(what);
+
+	switch (agent_context->step)
+	{
+		case ZBX_AGENT_STEP_CONNECT:
+			operation = "connection";
+			break;
+		case ZBX_AGENT_STEP_TLS:
+			operation = "TLS handshake";
+			break;
+		case ZBX_AGENT_STEP_SEND:
+			operation = "write";
+			break;
+		default:
+			operation = "read";
+	}
+
+	SET_MSG_RESULT(&agent_context->result, zbx_dsprintf(NULL, "Get value from agent failed: %s timeout",
+			operation));
+	agent_context_finish(agent_context, TIMEOUT_ERROR);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: prepare request of the check                                      *
+ *                                                                            *
+ * Comments: Items of a batch are requested as                                *
+ *           {"request":"passive checks","data":[{"key":"..."},...]}          *
+ *                                                                            *
+ ******************************************************************************/
+static int	agent_context_prepare_request(zbx_agent_context_t *agent_context)
+{
+	struct zbx_json	j;
+	int		i, ret;
+
+	if (0 == agent_context->batch_num)
+	{
+		return zbx_tcp_send_context_init(agent_context->item.key, strlen(agent_context->item.key), 0,
+				ZBX_TCP_PROTOCOL, &agent_context->send_context);
+	}
+
+	zbx_json_init(&j, ZBX_JSON_STAT_BUF_LEN);
+	zbx_json_addstring(&j, ZBX_PROTO_TAG_REQUEST, ZBX_PROTO_VALUE_GET_PASSIVE_CHECKS, ZBX_JSON_TYPE_STRING);
+	zbx_json_addarray(&j, ZBX_PROTO_TAG_DATA);
+
+	zbx_json_addobject(&j, NULL);
+	zbx_json_addstring(&j, ZBX_PROTO_TAG_KEY, agent_context->item.key, ZBX_JSON_TYPE_STRING);
+	zbx_json_close(&j);
+
+	for (i = 0; i < agent_context->batch_num; i++)
+	{
+		zbx_json_addobject(&j, NULL);
+		zbx_json_addstring(&j, ZBX_PROTO_TAG_KEY, agent_context->batch[i]->item.key, ZBX_JSON_TYPE_STRING);
+		zbx_json_close(&j);
+	}
+
+	agent_context->request = zbx_strdup(NULL, j.buffer);
+	zbx_json_free(&j);
+
+	ret = zbx_tcp_send_context_init(agent_context->request, strlen(agent_context->request), 0, ZBX_TCP_PROTOCOL,
+			&agent_context->send_context);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: start connection of the check                                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_context_start(struct event_base *base, zbx_agent_context_t *agent_context)
+{
+	struct timeval	tv = {agent_context->timeout, 0};
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() host:'%s' addr:'%s' key:'%s' conn:'%s' batch:%d", __func__,
+			agent_context->item.host.host, agent_context->item.interface.addr, agent_context->item.key,
+			zbx_tcp_connection_type_name(agent_context->item.host.tls_connect), agent_context->batch_num);
+
+	agent_context->step = ZBX_AGENT_STEP_CONNECT;
+
+	switch (agent_context->item.host.tls_connect)
+	{
+		case ZBX_TCP_SEC_UNENCRYPTED:
+			agent_context->tls_arg1 = NULL;
+			agent_context->tls_arg2 = NULL;
+			break;
+#if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
+		case ZBX_TCP_SEC_TLS_CERT:
+			agent_context->tls_arg1 = agent_context->item.host.tls_issuer;
+			agent_context->tls_arg2 = agent_context->item.host.tls_subject;
+			break;
+		case ZBX_TCP_SEC_TLS_PSK:
+			agent_context->tls_arg1 = agent_context->item.host.tls_psk_identity;
+			agent_context->tls_arg2 = agent_context->item.host.tls_psk;
+			break;
+#else
+		case ZBX_TCP_SEC_TLS_CERT:
+		case ZBX_TCP_SEC_TLS_PSK:
+			SET_MSG_RESULT(&agent_context->result, zbx_dsprintf(NULL, "A TLS connection is configured to be"
+					" used with agent but support for TLS was not compiled into %s.",
+					get_program_type_string(program_type)));
+			agent_context_finish(agent_context, CONFIG_ERROR);
+			goto out;
+#endif
+		default:
+			THIS_SHOULD_NEVER_HAPPEN;
+			SET_MSG_RESULT(&agent_context->result, zbx_strdup(NULL, "Invalid TLS connection parameters."));
+			agent_context_finish(agent_context, CONFIG_ERROR);
+			goto out;
+	}
+
+	if (SUCCEED != agent_context_prepare_request(agent_context))
+	{
+		SET_MSG_RESULT(&agent_context->result, zbx_dsprintf(NULL, "Get value from agent failed: %s",
+				zbx_socket_strerror()));
+		agent_context_finish(agent_context, NETWORK_ERROR);
+		goto out;
+	}
+
+	if (SUCCEED != zbx_tcp_connect_start(&agent_context->s, CONFIG_SOURCE_IP, agent_context->item.interface.addr,
+			agent_context->item.interface.port, agent_context->timeout))
+	{
+		SET_MSG_RESULT(&agent_context->result, zbx_dsprintf(NULL, "Get value from agent failed: %s",
+				zbx_socket_strerror()));
+		agent_context_finish(agent_context, NETWORK_ERROR);
+		goto out;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "Sending [%s]", NULL != agent_context->request ? agent_context->request :
+			agent_context->item.key);
+
+	agent_context->ev = event_new(base, agent_context->s.socket, EV_WRITE, agent_check_event_cb, agent_context);
+	agent_context->ev_timeout = evtimer_new(base, agent_check_timeout_cb, agent_context);
+
+	event_add(agent_context->ev, NULL);
+	evtimer_add(agent_context->ev_timeout, &tv);
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
+static zbx_agent_context_t	*agent_context_create(const zbx_dc_item_t *item, int timeout,
+		zbx_vector_ptr_t *finished)
+{
+	zbx_agent_context_t	*agent_context;
+
+	agent_context = (zbx_agent_context_t *)zbx_malloc(NULL, sizeof(zbx_agent_context_t));
+	zbx_dc_item_copy(&agent_context->item, item);
+	agent_context->errcode = SUCCEED;
+	agent_context->step = ZBX_AGENT_STEP_CONNECT;
+	agent_context->ev = NULL;
+	agent_context->ev_timeout = NULL;
+	agent_context->finished = finished;
+	agent_context->timeout = timeout;
+	agent_context->request = NULL;
+	agent_context->batch = NULL;
+	agent_context->batch_num = 0;
+	zbx_init_agent_result(&agent_context->result);
+
+	/* the context must be valid for cleanup before it is initialized with data */
+	(void)zbx_tcp_send_context_init(NULL, 0, 0, 0, &agent_context->send_context);
+
+	return agent_context;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: start retrieving data from Zabbix agents without waiting for the  *
+ *          results                                                           *
+ *                                                                            *
+ * Parameters: base      - [IN] event base the checks are processed by        *
+ *             items     - [IN] items to check, the items and their dynamic   *
+ *                              fields are taken over by the checks           *
+ *             items_num - [IN] number of items                               *
+ *             timeout   - [IN] check timeout in seconds                      *
+ *             finished  - [OUT] finished checks (zbx_agent_context_t *)      *
+ *                                                                            *
+ * Comments: Items of the same interface are requested over one connection    *
+ *           unless the agent is known not to support batch requests.         *
+ *           Finished checks must be freed with zbx_async_check_agent_clean() *
+ *           after processing their results.                                  *
+ *                                                                            *
+ *           Host name of the interface is resolved synchronously.            *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_async_check_agents(struct event_base *base, const zbx_dc_item_t *items, int items_num, int timeout,
+		zbx_vector_ptr_t *finished)
+{
+	zbx_agent_context_t	*agent_context;
+	unsigned char		*started;
+	int			i, j, now;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() num:%d", __func__, items_num);
+
+	started = (unsigned char *)zbx_calloc(NULL, (size_t)items_num, sizeof(unsigned char));
+	now = (int)time(NULL);
+
+	for (i = 0; i < items_num; i++)
+	{
+		if (0 != started[i])
+			continue;
+
+		agent_context = agent_context_create(&items[i], timeout, finished);
+
+		if (SUCCEED == agent_batch_allowed(items[i].interface.interfaceid, now))
+		{
+			for (j = i + 1; j < items_num && ZBX_AGENT_BATCH_MAX > agent_context->batch_num + 1; j++)
+			{
+				if (0 != started[j] || items[j].interface.interfaceid != items[i].interface.interfaceid)
+					continue;
+
+				agent_context->batch = (zbx_agent_context_t **)zbx_realloc(agent_context->batch,
+						sizeof(zbx_agent_context_t *) * (size_t)(agent_context->batch_num + 1));
+				agent_context->batch[agent_context->batch_num++] = agent_context_create(&items[j],
+						timeout, finished);
+				started[j] = 1;
+			}
+		}
+
+		agent_context_start(base, agent_context);
+	}
+
+	zbx_free(started);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: free finished agent check together with its item                  *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_async_check_agent_clean(zbx_agent_context_t *agent_context)
+{
+	zbx_clean_items(&agent_context->item, 1, &agent_context->result);
+	zbx_dc_config_clean_items(&agent_context->item, NULL, 1);
+	zbx_free(agent_context->batch);
+	zbx_free(agent_context);
+}
@@ -0,0 +1,57 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#ifndef ZABBIX_ASYNC_AGENT_H
+#define ZABBIX_ASYNC_AGENT_H
+
+#include "zbxcacheconfig.h"
+#include "zbxcomms.h"
+#include "module.h"
+
+#include <event.h>
+
+extern char	*CONFIG_SOURCE_IP;
+
+typedef struct zbx_agent_context zbx_agent_context_t;
+
+struct zbx_agent_context
+{
+	zbx_dc_item_t		item;
+	AGENT_RESULT		result;
+	int			errcode;
+	zbx_socket_t		s;
+	zbx_tcp_send_context_t	send_context;
+	zbx_tcp_recv_context_t	recv_context;
+	const char		*tls_arg1;
+	const char		*tls_arg2;
+	unsigned char		step;
+	struct event		*ev;
+	struct event		*ev_timeout;
+	zbx_vector_ptr_t	*finished;
+	int			timeout;
+	char			*request;	/* batch request being sent */
+	zbx_agent_context_t	**batch;	/* other items of the interface checked over this connection */
+	int			batch_num;
+};
+
+void	zbx_async_check_agents(struct event_base *base, const zbx_dc_item_t *items, int items_num, int timeout,
+		zbx_vector_ptr_t *finished);
+void	zbx_async_check_agent_clean(zbx_agent_context_t *agent_context);
+
+#endif
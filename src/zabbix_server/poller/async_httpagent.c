@@ -0,0 +1,341 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "async_httpagent.h"
+
+#ifdef HAVE_LIBCURL
+
+#include "poller.h"
+
+#include "log.h"
+#include "zbxsysinfo.h"
+
+static void	httpagent_context_finish(zbx_async_httpagent_t *httpagent, zbx_httpagent_context_t *httpagent_context,
+		int errcode)
+{
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() key:'%s' url:'%s' errcode:%s", __func__, httpagent_context->item.key,
+			httpagent_context->item.url, zbx_result_string(errcode));
+
+	httpagent_context->errcode = errcode;
+
+	zbx_vector_ptr_append(httpagent->finished, httpagent_context);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: convert finished transfers into check results                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	check_multi_info(zbx_async_httpagent_t *httpagent)
+{
+	CURLMsg	*message;
+	int	pending;
+
+	while (NULL != (message = curl_multi_info_read(httpagent->curl_handle, &pending)))
+	{
+		zbx_httpagent_context_t	*httpagent_context;
+		CURLcode		err;
+		char			*out = NULL, *error = NULL;
+		int			ret;
+
+		if (CURLMSG_DONE != message->msg)
+			continue;
+
+		err = message->data.result;
+
+		if (CURLE_OK != curl_easy_getinfo(message->easy_handle, CURLINFO_PRIVATE, (char **)&httpagent_context))
+		{
+			THIS_SHOULD_NEVER_HAPPEN;
+			curl_multi_remove_handle(httpagent->curl_handle, message->easy_handle);
+			continue;
+		}
+
+		/* message is invalid after the handle is removed */
+		curl_multi_remove_handle(httpagent->curl_handle, httpagent_context->http_context.easyhandle);
+
+		if (SUCCEED == (ret = zbx_http_handle_response(&httpagent_context->http_context, err,
+				httpagent_context->item.status_codes, &out, &error)))
+		{
+			SET_TEXT_RESULT(&httpagent_context->result, out);
+		}
+		else
+			SET_MSG_RESULT(&httpagent_context->result, error);
+
+		httpagent_context_finish(httpagent, httpagent_context, ret);
+	}
+}
+
+static void	httpagent_socket_cb(evutil_socket_t fd, short what, void *arg)
+{
+	zbx_async_httpagent_t	*httpagent = (zbx_async_httpagent_t *)arg;
+	int			flags = 0, running;
+
+	if (0 != (what & EV_READ))
+		flags |= CURL_CSELECT_IN;
+
+	if (0 != (what & EV_WRITE))
+		flags |= CURL_CSELECT_OUT;
+
+	curl_multi_socket_action(httpagent->curl_handle, fd, flags, &running);
+
+	check_multi_info(httpagent);
+}
+
+static void	httpagent_timeout_cb(evutil_socket_t fd, short what, void *arg)
+{
+	zbx_async_httpagent_t	*httpagent = (zbx_async_httpagent_t *)arg;
+	int			running;
+
+	ZBX_UNUSED(fd);
+	ZBX_UNUSED(what);
+
+	curl_multi_socket_action(httpagent->curl_handle, CURL_SOCKET_TIMEOUT, 0, &running);
+
+	check_multi_info(httpagent);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: keep libevent socket events in sync with the sockets libcurl      *
+ *          wants to be monitored                                             *
+ *                                                                            *
+ ******************************************************************************/
+static int	httpagent_curl_socket_cb(CURL *easy, curl_socket_t s, int action, void *userp, void *socketp)
+{
+	zbx_async_httpagent_t	*httpagent = (zbx_async_httpagent_t *)userp;
+	struct event		*ev = (struct event *)socketp;
+	short			what;
+
+	ZBX_UNUSED(easy);
+
+	if (CURL_POLL_REMOVE == action)
+	{
+		if (NULL != ev)
+		{
+			event_free(ev);
+			curl_multi_assign(httpagent->curl_handle, s, NULL);
+		}
+
+		return 0;
+	}
+
+	what = EV_PERSIST;
+
+	if (CURL_POLL_IN == action || CURL_POLL_INOUT == action)
+		what |= EV_READ;
+
+	if (CURL_POLL_OUT == action || CURL_POLL_INOUT == action)
+		what |= EV_WRITE;
+
+	if (NULL != ev)
+	{
+		event_del(ev);
+		event_assign(ev, httpagent->base, s, what, httpagent_socket_cb, httpagent);
+	}
+	else
+	{
+		ev = event_new(httpagent->base, s, what, httpagent_socket_cb, httpagent);
+		curl_multi_assign(httpagent->curl_handle, s, ev);
+	}
+
+	event_add(ev, NULL);
+
+	return 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: schedule libcurl timeout processing                               *
+ *                                                                            *
+ * Comments: libcurl must not be called back from this function, the timeout  *
+ *           is processed from the event loop even when it has expired        *
+ *           already.                                                         *
+ *                                                                            *
+ ******************************************************************************/
+static int	httpagent_curl_timer_cb(CURLM *multi, long timeout_ms, void *userp)
+{
+	zbx_async_httpagent_t	*httpagent = (zbx_async_httpagent_t *)userp;
+
+	ZBX_UNUSED(multi);
+
+	if (-1 == timeout_ms)
+	{
+		evtimer_del(httpagent->curl_timeout);
+	}
+	else
+	{
+		struct timeval	tv;
+
+		tv.tv_sec = timeout_ms / 1000;
+		tv.tv_usec = (timeout_ms % 1000) * 1000;
+
+		evtimer_add(httpagent->curl_timeout, &tv);
+	}
+
+	return 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: initialize asynchronous HTTP agent checks                         *
+ *                                                                            *
+ * Parameters: httpagent - [OUT] asynchronous HTTP agent checks               *
+ *             base      - [IN] event base the checks are processed by        *
+ *             finished  - [OUT] finished checks (zbx_httpagent_context_t *)  *
+ *             error     - [OUT] error message                                *
+ *                                                                            *
+ * Return value: SUCCEED - checks were initialized successfully               *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Connections are kept open by the multi handle and reused by the  *
+ *           following checks of the same hosts. Requests to the same HTTP/2  *
+ *           server are multiplexed over a single connection when libcurl     *
+ *           supports it.                                                     *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_async_httpagent_init(zbx_async_httpagent_t *httpagent, struct event_base *base,
+		zbx_vector_ptr_t *finished, char **error)
+{
+	CURLMcode	merr;
+
+	if (NULL == (httpagent->curl_handle = curl_multi_init()))
+	{
+		*error = zbx_strdup(NULL, "cannot initialize cURL multi session");
+		return FAIL;
+	}
+
+	httpagent->base = base;
+	httpagent->finished = finished;
+	httpagent->curl_timeout = evtimer_new(base, httpagent_timeout_cb, httpagent);
+
+	if (CURLM_OK != (merr = curl_multi_setopt(httpagent->curl_handle, CURLMOPT_SOCKETFUNCTION,
+			httpagent_curl_socket_cb)) ||
+			CURLM_OK != (merr = curl_multi_setopt(httpagent->curl_handle, CURLMOPT_SOCKETDATA,
+			httpagent)) ||
+			CURLM_OK != (merr = curl_multi_setopt(httpagent->curl_handle, CURLMOPT_TIMERFUNCTION,
+			httpagent_curl_timer_cb)) ||
+			CURLM_OK != (merr = curl_multi_setopt(httpagent->curl_handle, CURLMOPT_TIMERDATA,
+			httpagent)))
+	{
+		*error = zbx_dsprintf(NULL, "cannot set cURL multi option: %s", curl_multi_strerror(merr));
+		zbx_async_httpagent_destroy(httpagent);
+		return FAIL;
+	}
+
+#if LIBCURL_VERSION_NUM >= 0x072b00
+	if (CURLM_OK != (merr = curl_multi_setopt(httpagent->curl_handle, CURLMOPT_PIPELINING,
+			CURLPIPE_MULTIPLEX)))
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "cannot enable HTTP/2 multiplexing: %s", curl_multi_strerror(merr));
+	}
+#endif
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: free asynchronous HTTP agent checks                               *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_async_httpagent_destroy(zbx_async_httpagent_t *httpagent)
+{
+	curl_multi_cleanup(httpagent->curl_handle);
+	event_free(httpagent->curl_timeout);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: start HTTP agent check without waiting for the result             *
+ *                                                                            *
+ * Parameters: httpagent - [IN] asynchronous HTTP agent checks                *
+ *             item      - [IN] item to check, the item and its dynamic       *
+ *                              fields are taken over by the check            *
+ *                                                                            *
+ * Comments: Finished checks must be freed with                               *
+ *           zbx_async_check_httpagent_clean() after processing their         *
+ *           results.                                                         *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_async_check_httpagent(zbx_async_httpagent_t *httpagent, const zbx_dc_item_t *item)
+{
+	zbx_httpagent_context_t	*httpagent_context;
+	char			*error = NULL;
+	CURLcode		err;
+	CURLMcode		merr;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() key:'%s' url:'%s'", __func__, item->key, item->url);
+
+	httpagent_context = (zbx_httpagent_context_t *)zbx_malloc(NULL, sizeof(zbx_httpagent_context_t));
+	zbx_dc_item_copy(&httpagent_context->item, item);
+	httpagent_context->errcode = SUCCEED;
+	zbx_init_agent_result(&httpagent_context->result);
+	zbx_http_context_create(&httpagent_context->http_context);
+
+	item = &httpagent_context->item;
+
+	if (SUCCEED != zbx_http_request_prepare(&httpagent_context->http_context, item->request_method, item->url,
+			item->query_fields, item->headers, item->posts, item->retrieve_mode, item->http_proxy,
+			item->follow_redirects, item->timeout, 1, item->ssl_cert_file, item->ssl_key_file,
+			item->ssl_key_password, item->verify_peer, item->verify_host, item->authtype, item->username,
+			item->password, NULL, item->post_type, item->output_format, &error))
+	{
+		SET_MSG_RESULT(&httpagent_context->result, error);
+		httpagent_context_finish(httpagent, httpagent_context, NOTSUPPORTED);
+		goto out;
+	}
+
+	if (CURLE_OK != (err = curl_easy_setopt(httpagent_context->http_context.easyhandle, CURLOPT_PRIVATE,
+			httpagent_context)))
+	{
+		SET_MSG_RESULT(&httpagent_context->result, zbx_dsprintf(NULL, "Cannot set pointer to private data:"
+				" %s", curl_easy_strerror(err)));
+		httpagent_context_finish(httpagent, httpagent_context, NOTSUPPORTED);
+		goto out;
+	}
+
+#if LIBCURL_VERSION_NUM >= 0x072b00
+	/* wait for a connection that can be multiplexed rather than open a new one */
+	(void)curl_easy_setopt(httpagent_context->http_context.easyhandle, CURLOPT_PIPEWAIT, 1L);
+#endif
+
+	if (CURLM_OK != (merr = curl_multi_add_handle(httpagent->curl_handle,
+			httpagent_context->http_context.easyhandle)))
+	{
+		SET_MSG_RESULT(&httpagent_context->result, zbx_dsprintf(NULL, "Cannot add cURL handle: %s",
+				curl_multi_strerror(merr)));
+		httpagent_context_finish(httpagent, httpagent_context, NOTSUPPORTED);
+	}
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: free finished HTTP agent check together with its item             *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_async_check_httpagent_clean(zbx_httpagent_context_t *httpagent_context)
+{
+	zbx_http_context_destroy(&httpagent_context->http_context);
+	zbx_clean_items(&httpagent_context->item, 1, &httpagent_context->result);
+	zbx_dc_config_clean_items(&httpagent_context->item, NULL, 1);
+	zbx_free(httpagent_context);
+}
+
+#endif
@@ -0,0 +1,58 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#ifndef ZABBIX_ASYNC_HTTPAGENT_H
+#define ZABBIX_ASYNC_HTTPAGENT_H
+
+#include "zbxcacheconfig.h"
+#include "module.h"
+
+#ifdef HAVE_LIBCURL
+
+#include "zbxhttp.h"
+
+#include <event.h>
+
+typedef struct
+{
+	CURLM			*curl_handle;
+	struct event_base	*base;
+	struct event		*curl_timeout;
+	zbx_vector_ptr_t	*finished;
+}
+zbx_async_httpagent_t;
+
+typedef struct
+{
+	zbx_dc_item_t		item;
+	AGENT_RESULT		result;
+	int			errcode;
+	zbx_http_context_t	http_context;
+}
+zbx_httpagent_context_t;
+
+int	zbx_async_httpagent_init(zbx_async_httpagent_t *httpagent, struct event_base *base,
+		zbx_vector_ptr_t *finished, char **error);
+void	zbx_async_httpagent_destroy(zbx_async_httpagent_t *httpagent);
+void	zbx_async_check_httpagent(zbx_async_httpagent_t *httpagent, const zbx_dc_item_t *item);
+void	zbx_async_check_httpagent_clean(zbx_httpagent_context_t *httpagent_context);
+
+#endif
+
+#endif
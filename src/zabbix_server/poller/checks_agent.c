@@ -21,11 +21,144 @@
 
 #include "log.h"
 #include "zbxsysinfo.h"
+#include "zbxtime.h"
 
 #if !(defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL))
 extern unsigned char	program_type;
 #endif
 
+/* reused connection idle time limit, must stay below agent listener keep-alive timeout */
+#define ZBX_AGENT_KEEPALIVE_IDLE		2
+
+/* how often agents which closed reused connection are probed again */
+#define ZBX_AGENT_KEEPALIVE_PROBE_PERIOD	(10 * SEC_PER_MIN)
+
+typedef struct
+{
+	zbx_uint64_t	interfaceid;
+	int		nextprobe;
+}
+zbx_agent_nokeepalive_t;
+
+/* the connection kept open after the last passive check of the poller */
+typedef struct
+{
+	zbx_socket_t	s;
+	zbx_uint64_t	interfaceid;
+	char		*addr;
+	char		*tls_arg1;
+	char		*tls_arg2;
+	unsigned short	port;
+	unsigned char	tls_connect;
+	int		lastaccess;
+	int		connected;
+}
+zbx_agent_keepalive_t;
+
+static zbx_agent_keepalive_t	agent_keepalive;
+
+/* interfaces of agents which do not serve several requests over one connection */
+static zbx_hashset_t	agent_nokeepalive;
+static int		agent_nokeepalive_init = 0;
+
+static int	agent_get_tls_args(const zbx_dc_item_t *item, const char **tls_arg1, const char **tls_arg2,
+		AGENT_RESULT *result)
+{
+	switch (item->host.tls_connect)
+	{
+		case ZBX_TCP_SEC_UNENCRYPTED:
+			*tls_arg1 = NULL;
+			*tls_arg2 = NULL;
+			break;
+#if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
+		case ZBX_TCP_SEC_TLS_CERT:
+			*tls_arg1 = item->host.tls_issuer;
+			*tls_arg2 = item->host.tls_subject;
+			break;
+		case ZBX_TCP_SEC_TLS_PSK:
+			*tls_arg1 = item->host.tls_psk_identity;
+			*tls_arg2 = item->host.tls_psk;
+			break;
+#else
+		case ZBX_TCP_SEC_TLS_CERT:
+		case ZBX_TCP_SEC_TLS_PSK:
+			SET_MSG_RESULT(result, zbx_dsprintf(NULL, "A TLS connection is configured to be used with agent"
+					" but support for TLS was not compiled into %s.",
+					get_program_type_string(program_type)));
+			return CONFIG_ERROR;
+#endif
+		default:
+			THIS_SHOULD_NEVER_HAPPEN;
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid TLS connection parameters."));
+			return CONFIG_ERROR;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: send item key to agent and receive the response                   *
+ *                                                                            *
+ * Parameters: s            - [IN] connection to agent                        *
+ *             item         - [IN]                                            *
+ *             received_len - [OUT] number of bytes received                  *
+ *                                                                            *
+ * Return value: SUCCEED - response received                                  *
+ *               NETWORK_ERROR, TIMEOUT_ERROR - otherwise                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	agent_send_request(zbx_socket_t *s, const zbx_dc_item_t *item, ssize_t *received_len)
+{
+	zabbix_log(LOG_LEVEL_DEBUG, "Sending [%s]", item->key);
+
+	if (SUCCEED != zbx_tcp_send(s, item->key))
+		return NETWORK_ERROR;
+
+	if (FAIL != (*received_len = zbx_tcp_recv_ext(s, 0, 0)))
+		return SUCCEED;
+
+	if (SUCCEED != zbx_socket_check_deadline(s))
+		return TIMEOUT_ERROR;
+
+	return NETWORK_ERROR;
+}
+
+static int	agent_parse_response(const zbx_socket_t *s, ssize_t received_len, const zbx_dc_item_t *item,
+		AGENT_RESULT *result)
+{
+	zabbix_log(LOG_LEVEL_DEBUG, "get value from agent result: '%s'", s->buffer);
+
+	if (0 == strcmp(s->buffer, ZBX_NOTSUPPORTED))
+	{
+		/* 'ZBX_NOTSUPPORTED\0<error message>' */
+		if (sizeof(ZBX_NOTSUPPORTED) < s->read_bytes)
+			SET_MSG_RESULT(result, zbx_dsprintf(NULL, "%s", s->buffer + sizeof(ZBX_NOTSUPPORTED)));
+		else
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Not supported by Zabbix Agent"));
+
+		return NOTSUPPORTED;
+	}
+
+	if (0 == strcmp(s->buffer, ZBX_ERROR))
+	{
+		SET_MSG_RESULT(result, zbx_strdup(NULL, "Zabbix Agent non-critical error"));
+		return AGENT_ERROR;
+	}
+
+	if (0 == received_len)
+	{
+		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Received empty response from Zabbix Agent at [%s]."
+				" Assuming that agent dropped connection because of access permissions.",
+				item->interface.addr));
+		return NETWORK_ERROR;
+	}
+
+	zbx_set_agent_result_type(result, ITEM_VALUE_TYPE_TEXT, s->buffer);
+
+	return SUCCEED;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: retrieve data from Zabbix agent                                   *
@@ -46,93 +179,220 @@ int	get_value_agent(const zbx_dc_item_t *item, int timeout, AGENT_RESULT *result
 {
 	zbx_socket_t	s;
 	const char	*tls_arg1, *tls_arg2;
-	int		ret = SUCCEED;
+	int		ret;
 	ssize_t		received_len;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() host:'%s' addr:'%s' key:'%s' conn:'%s'", __func__, item->host.host,
 			item->interface.addr, item->key, zbx_tcp_connection_type_name(item->host.tls_connect));
 
-	switch (item->host.tls_connect)
-	{
-		case ZBX_TCP_SEC_UNENCRYPTED:
-			tls_arg1 = NULL;
-			tls_arg2 = NULL;
-			break;
-#if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
-		case ZBX_TCP_SEC_TLS_CERT:
-			tls_arg1 = item->host.tls_issuer;
-			tls_arg2 = item->host.tls_subject;
-			break;
-		case ZBX_TCP_SEC_TLS_PSK:
-			tls_arg1 = item->host.tls_psk_identity;
-			tls_arg2 = item->host.tls_psk;
-			break;
-#else
-		case ZBX_TCP_SEC_TLS_CERT:
-		case ZBX_TCP_SEC_TLS_PSK:
-			SET_MSG_RESULT(result, zbx_dsprintf(NULL, "A TLS connection is configured to be used with agent"
-					" but support for TLS was not compiled into %s.",
-					get_program_type_string(program_type)));
-			ret = CONFIG_ERROR;
-			goto out;
-#endif
-		default:
-			THIS_SHOULD_NEVER_HAPPEN;
-			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid TLS connection parameters."));
-			ret = CONFIG_ERROR;
-			goto out;
-	}
+	if (SUCCEED != (ret = agent_get_tls_args(item, &tls_arg1, &tls_arg2, result)))
+		goto out;
 
 	if (SUCCEED == zbx_tcp_connect(&s, CONFIG_SOURCE_IP, item->interface.addr, item->interface.port, timeout,
 			item->host.tls_connect, tls_arg1, tls_arg2))
 	{
-		zabbix_log(LOG_LEVEL_DEBUG, "Sending [%s]", item->key);
-
-		if (SUCCEED != zbx_tcp_send(&s, item->key))
-			ret = NETWORK_ERROR;
-		else if (FAIL != (received_len = zbx_tcp_recv_ext(&s, 0, 0)))
-			ret = SUCCEED;
-		else if (SUCCEED != zbx_socket_check_deadline(&s))
-			ret = TIMEOUT_ERROR;
-		else
-			ret = NETWORK_ERROR;
+		ret = agent_send_request(&s, item, &received_len);
 	}
 	else
 		ret = NETWORK_ERROR;
 
 	if (SUCCEED == ret)
+		ret = agent_parse_response(&s, received_len, item, result);
+	else
+		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Get value from agent failed: %s", zbx_socket_strerror()));
+
+	zbx_tcp_close(&s);
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
+}
+
+static int	agent_keepalive_allowed(zbx_uint64_t interfaceid, int now)
+{
+	zbx_agent_nokeepalive_t	*nokeepalive;
+
+	if (0 == agent_nokeepalive_init)
+		return SUCCEED;
+
+	if (NULL == (nokeepalive = (zbx_agent_nokeepalive_t *)zbx_hashset_search(&agent_nokeepalive, &interfaceid)))
+		return SUCCEED;
+
+	if (now < nokeepalive->nextprobe)
+		return FAIL;
+
+	zbx_hashset_remove_direct(&agent_nokeepalive, nokeepalive);
+
+	return SUCCEED;
+}
+
+static void	agent_keepalive_disable(zbx_uint64_t interfaceid, int now)
+{
+	zbx_agent_nokeepalive_t	*nokeepalive, nokeepalive_local;
+
+	if (0 == agent_nokeepalive_init)
 	{
-		zabbix_log(LOG_LEVEL_DEBUG, "get value from agent result: '%s'", s.buffer);
+		zbx_hashset_create(&agent_nokeepalive, 100, ZBX_DEFAULT_UINT64_HASH_FUNC,
+				ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		agent_nokeepalive_init = 1;
+	}
 
-		if (0 == strcmp(s.buffer, ZBX_NOTSUPPORTED))
-		{
-			/* 'ZBX_NOTSUPPORTED\0<error message>' */
-			if (sizeof(ZBX_NOTSUPPORTED) < s.read_bytes)
-				SET_MSG_RESULT(result, zbx_dsprintf(NULL, "%s", s.buffer + sizeof(ZBX_NOTSUPPORTED)));
-			else
-				SET_MSG_RESULT(result, zbx_strdup(NULL, "Not supported by Zabbix Agent"));
+	nokeepalive_local.interfaceid = interfaceid;
+	nokeepalive = (zbx_agent_nokeepalive_t *)zbx_hashset_insert(&agent_nokeepalive, &nokeepalive_local,
+			sizeof(nokeepalive_local));
+	nokeepalive->nextprobe = now + ZBX_AGENT_KEEPALIVE_PROBE_PERIOD;
+}
 
-			ret = NOTSUPPORTED;
-		}
-		else if (0 == strcmp(s.buffer, ZBX_ERROR))
-		{
-			SET_MSG_RESULT(result, zbx_strdup(NULL, "Zabbix Agent non-critical error"));
-			ret = AGENT_ERROR;
-		}
-		else if (0 == received_len)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: check if the kept connection leads to the item interface with the *
+ *          same connection parameters and has not been idle for too long     *
+ *                                                                            *
+ ******************************************************************************/
+static int	agent_keepalive_match(const zbx_dc_item_t *item, const char *tls_arg1, const char *tls_arg2,
+		int now)
+{
+	if (ZBX_AGENT_KEEPALIVE_IDLE < now - agent_keepalive.lastaccess)
+		return FAIL;
+
+	if (agent_keepalive.interfaceid != item->interface.interfaceid || agent_keepalive.port != item->interface.port ||
+			agent_keepalive.tls_connect != item->host.tls_connect)
+	{
+		return FAIL;
+	}
+
+	if (0 != strcmp(agent_keepalive.addr, item->interface.addr) ||
+			0 != zbx_strcmp_null(agent_keepalive.tls_arg1, tls_arg1) ||
+			0 != zbx_strcmp_null(agent_keepalive.tls_arg2, tls_arg2))
+	{
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+static void	agent_keepalive_store(const zbx_dc_item_t *item, const char *tls_arg1, const char *tls_arg2,
+		int now)
+{
+	agent_keepalive.interfaceid = item->interface.interfaceid;
+	agent_keepalive.addr = zbx_strdup(agent_keepalive.addr, item->interface.addr);
+	agent_keepalive.port = item->interface.port;
+	agent_keepalive.tls_connect = item->host.tls_connect;
+	agent_keepalive.tls_arg1 = (NULL != tls_arg1 ? zbx_strdup(agent_keepalive.tls_arg1, tls_arg1) : NULL);
+	agent_keepalive.tls_arg2 = (NULL != tls_arg2 ? zbx_strdup(agent_keepalive.tls_arg2, tls_arg2) : NULL);
+	agent_keepalive.lastaccess = now;
+	agent_keepalive.connected = 1;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: close the connection kept open after the last passive check       *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_agent_keepalive_close(void)
+{
+	if (0 == agent_keepalive.connected)
+		return;
+
+	zbx_tcp_close(&agent_keepalive.s);
+	agent_keepalive.connected = 0;
+
+	zbx_free(agent_keepalive.addr);
+	zbx_free(agent_keepalive.tls_arg1);
+	zbx_free(agent_keepalive.tls_arg2);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: retrieve data from Zabbix agent reusing the connection left open  *
+ *          by the previous check of the same interface                       *
+ *                                                                            *
+ * Parameters: item    - [IN] item we are interested in                       *
+ *             timeout - [IN]                                                 *
+ *             result  - [OUT]                                                *
+ *                                                                            *
+ * Return value: see get_value_agent()                                        *
+ *                                                                            *
+ * Comments: After a successful check the connection is kept open, so the     *
+ *           following checks of the interface within a few seconds save the  *
+ *           connection and TLS handshake. Agents serving one request per     *
+ *           connection close it - then the request is repeated over a new    *
+ *           connection and the interface is not reused for a while.          *
+ *                                                                            *
+ *           Call zbx_agent_keepalive_close() before the poller goes idle.    *
+ *                                                                            *
+ ******************************************************************************/
+int	get_value_agent_keepalive(const zbx_dc_item_t *item, int timeout, AGENT_RESULT *result)
+{
+	const char	*tls_arg1, *tls_arg2;
+	int		ret, now;
+	ssize_t		received_len;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() host:'%s' addr:'%s' key:'%s' conn:'%s'", __func__, item->host.host,
+			item->interface.addr, item->key, zbx_tcp_connection_type_name(item->host.tls_connect));
+
+	if (SUCCEED != (ret = agent_get_tls_args(item, &tls_arg1, &tls_arg2, result)))
+		goto out;
+
+	now = (int)time(NULL);
+
+	if (0 != agent_keepalive.connected)
+	{
+		if (SUCCEED == agent_keepalive_match(item, tls_arg1, tls_arg2, now))
 		{
-			SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Received empty response from Zabbix Agent at [%s]."
-					" Assuming that agent dropped connection because of access permissions.",
-					item->interface.addr));
-			ret = NETWORK_ERROR;
+			zbx_socket_set_deadline(&agent_keepalive.s, timeout);
+
+			ret = agent_send_request(&agent_keepalive.s, item, &received_len);
+
+			zbx_socket_set_deadline(&agent_keepalive.s, 0);
+
+			if (SUCCEED == ret && 0 != received_len)
+				goto parse;
+
+			/* the request was not processed if the agent has closed the connection */
+			if (TIMEOUT_ERROR != ret)
+			{
+				zabbix_log(LOG_LEVEL_DEBUG, "agent at [%s] closed reused connection, reconnecting",
+						item->interface.addr);
+				agent_keepalive_disable(item->interface.interfaceid, now);
+			}
 		}
-		else
-			zbx_set_agent_result_type(result, ITEM_VALUE_TYPE_TEXT, s.buffer);
+
+		zbx_agent_keepalive_close();
+
+		if (TIMEOUT_ERROR == ret)
+			goto fail;
+	}
+
+	if (SUCCEED != zbx_tcp_connect(&agent_keepalive.s, CONFIG_SOURCE_IP, item->interface.addr,
+			item->interface.port, timeout, item->host.tls_connect, tls_arg1, tls_arg2))
+	{
+		ret = NETWORK_ERROR;
+		goto fail;
+	}
+
+	if (SUCCEED != (ret = agent_send_request(&agent_keepalive.s, item, &received_len)))
+	{
+		zbx_tcp_close(&agent_keepalive.s);
+		goto fail;
+	}
+
+	/* the connection is kept by agent_keepalive_store() below */
+	agent_keepalive.connected = 1;
+parse:
+	ret = agent_parse_response(&agent_keepalive.s, received_len, item, result);
+
+	if ((SUCCEED == ret || NOTSUPPORTED == ret || AGENT_ERROR == ret) &&
+			SUCCEED == agent_keepalive_allowed(item->interface.interfaceid, now))
+	{
+		agent_keepalive_store(item, tls_arg1, tls_arg2, now);
 	}
 	else
-		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Get value from agent failed: %s", zbx_socket_strerror()));
+		zbx_agent_keepalive_close();
 
-	zbx_tcp_close(&s);
+	goto out;
+fail:
+	SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Get value from agent failed: %s", zbx_socket_strerror()));
 out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
@@ -26,5 +26,7 @@
 extern char	*CONFIG_SOURCE_IP;
 
 int	get_value_agent(const zbx_dc_item_t *item, int timeout, AGENT_RESULT *result);
+int	get_value_agent_keepalive(const zbx_dc_item_t *item, int timeout, AGENT_RESULT *result);
+void	zbx_agent_keepalive_close(void);
 
 #endif
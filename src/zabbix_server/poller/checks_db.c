@@ -25,6 +25,211 @@
 #include "zbxsysinfo.h"
 
 #include "zbxodbc.h"
+#include "zbxtime.h"
+
+/* pooled ODBC connection, identified by its connection parameters */
+typedef struct
+{
+	char			*dsn;
+	char			*connection;
+	char			*user;
+	char			*pass;
+	zbx_odbc_data_source_t	*data_source;
+	time_t			lastaccess;
+}
+zbx_odbc_pool_entry_t;
+
+#define ZBX_ODBC_POOL_IDLE_TIMEOUT	(5 * SEC_PER_MIN)
+#define ZBX_ODBC_POOL_PURGE_INTERVAL	SEC_PER_MIN
+
+/* The pool is process local and is disabled by default. It is enabled by pollers, each keeping at most one */
+/* connection per data source, because items of a poller are checked sequentially.                        */
+static int		odbc_pool_enabled = 0;
+static zbx_hashset_t	odbc_pool;
+static time_t		odbc_pool_purge_time;
+
+static zbx_hash_t	odbc_pool_hash_func(const void *data)
+{
+	const zbx_odbc_pool_entry_t	*entry = (const zbx_odbc_pool_entry_t *)data;
+	zbx_hash_t			hash;
+
+	hash = ZBX_DEFAULT_STRING_HASH_ALGO(entry->dsn, strlen(entry->dsn), ZBX_DEFAULT_HASH_SEED);
+	hash = ZBX_DEFAULT_STRING_HASH_ALGO(entry->connection, strlen(entry->connection), hash);
+	hash = ZBX_DEFAULT_STRING_HASH_ALGO(entry->user, strlen(entry->user), hash);
+
+	return ZBX_DEFAULT_STRING_HASH_ALGO(entry->pass, strlen(entry->pass), hash);
+}
+
+static int	odbc_pool_compare_func(const void *d1, const void *d2)
+{
+	const zbx_odbc_pool_entry_t	*e1 = (const zbx_odbc_pool_entry_t *)d1;
+	const zbx_odbc_pool_entry_t	*e2 = (const zbx_odbc_pool_entry_t *)d2;
+	int				ret;
+
+	if (0 != (ret = strcmp(e1->dsn, e2->dsn)))
+		return ret;
+
+	if (0 != (ret = strcmp(e1->connection, e2->connection)))
+		return ret;
+
+	if (0 != (ret = strcmp(e1->user, e2->user)))
+		return ret;
+
+	return strcmp(e1->pass, e2->pass);
+}
+
+static void	odbc_pool_entry_clean(void *data)
+{
+	zbx_odbc_pool_entry_t	*entry = (zbx_odbc_pool_entry_t *)data;
+
+	if (NULL != entry->data_source)
+		zbx_odbc_data_source_free(entry->data_source);
+
+	zbx_free(entry->dsn);
+	zbx_free(entry->connection);
+	zbx_free(entry->user);
+	zbx_free(entry->pass);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: enable ODBC connection pool for database monitor items of the     *
+ *          current process                                                   *
+ *                                                                            *
+ * Comments: Connections are kept open between checks and closed after        *
+ *           ZBX_ODBC_POOL_IDLE_TIMEOUT seconds without use, see              *
+ *           odbc_pool_purge(). The pool is not thread safe.                  *
+ *                                                                            *
+ ******************************************************************************/
+void	odbc_pool_enable(void)
+{
+	if (0 != odbc_pool_enabled)
+		return;
+
+	zbx_hashset_create_ext(&odbc_pool, 10, odbc_pool_hash_func, odbc_pool_compare_func, odbc_pool_entry_clean,
+			ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
+
+	odbc_pool_purge_time = time(NULL);
+	odbc_pool_enabled = 1;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: close pooled ODBC connections that were not used recently         *
+ *                                                                            *
+ ******************************************************************************/
+void	odbc_pool_purge(void)
+{
+	zbx_hashset_iter_t	iter;
+	zbx_odbc_pool_entry_t	*entry;
+	time_t			now;
+
+	if (0 == odbc_pool_enabled)
+		return;
+
+	now = time(NULL);
+
+	if (ZBX_ODBC_POOL_PURGE_INTERVAL > now - odbc_pool_purge_time)
+		return;
+
+	zbx_hashset_iter_reset(&odbc_pool, &iter);
+	while (NULL != (entry = (zbx_odbc_pool_entry_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (ZBX_ODBC_POOL_IDLE_TIMEOUT <= now - entry->lastaccess)
+			zbx_hashset_iter_remove(&iter);
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() pooled connections:%d", __func__, odbc_pool.num_data);
+
+	odbc_pool_purge_time = now;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get pooled ODBC connection or open a new one                      *
+ *                                                                            *
+ * Parameters: dsn        - [IN] data source name                             *
+ *             connection - [IN] connection string (optional)                 *
+ *             user       - [IN] user name                                    *
+ *             pass       - [IN] password                                     *
+ *             timeout    - [IN] login timeout                                *
+ *             entry      - [OUT] the pool entry                              *
+ *             error      - [OUT] error message                               *
+ *                                                                            *
+ * Return value: SUCCEED - connection was taken from pool                     *
+ *               FAIL    - new connection was opened or could not be opened,  *
+ *                         entry->data_source is NULL in the latter case      *
+ *                                                                            *
+ ******************************************************************************/
+static int	odbc_pool_get(const char *dsn, const char *connection, const char *user, const char *pass,
+		int timeout, zbx_odbc_pool_entry_t **entry, char **error)
+{
+	zbx_odbc_pool_entry_t	entry_local;
+
+	entry_local.dsn = (char *)ZBX_NULL2EMPTY_STR(dsn);
+	entry_local.connection = (char *)ZBX_NULL2EMPTY_STR(connection);
+	entry_local.user = (char *)user;
+	entry_local.pass = (char *)pass;
+
+	if (NULL == (*entry = (zbx_odbc_pool_entry_t *)zbx_hashset_search(&odbc_pool, &entry_local)))
+	{
+		entry_local.dsn = zbx_strdup(NULL, entry_local.dsn);
+		entry_local.connection = zbx_strdup(NULL, entry_local.connection);
+		entry_local.user = zbx_strdup(NULL, user);
+		entry_local.pass = zbx_strdup(NULL, pass);
+		entry_local.data_source = NULL;
+
+		*entry = (zbx_odbc_pool_entry_t *)zbx_hashset_insert(&odbc_pool, &entry_local, sizeof(entry_local));
+	}
+
+	(*entry)->lastaccess = time(NULL);
+
+	if (NULL != (*entry)->data_source)
+		return SUCCEED;
+
+	(*entry)->data_source = zbx_odbc_connect(dsn, connection, user, pass, timeout, error);
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: execute query using pooled ODBC connection                        *
+ *                                                                            *
+ * Comments: When query fails on a pooled connection the connection could     *
+ *           have been closed by the data source, so it is reopened and the   *
+ *           query is executed once more.                                     *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_odbc_query_result_t	*odbc_pool_select(const char *dsn, const char *connection, const char *user,
+		const char *pass, const char *query, int timeout, char **error)
+{
+	zbx_odbc_pool_entry_t	*entry;
+	zbx_odbc_query_result_t	*query_result;
+
+	if (SUCCEED == odbc_pool_get(dsn, connection, user, pass, timeout, &entry, error))
+	{
+		if (NULL != (query_result = zbx_odbc_select(entry->data_source, query, error)))
+			return query_result;
+
+		zabbix_log(LOG_LEVEL_DEBUG, "%s() reconnecting after query failure: %s", __func__, *error);
+		zbx_free(*error);
+
+		zbx_odbc_data_source_free(entry->data_source);
+		entry->data_source = zbx_odbc_connect(dsn, connection, user, pass, timeout, error);
+	}
+
+	if (NULL == entry->data_source)
+	{
+		zbx_hashset_remove_direct(&odbc_pool, entry);
+		return NULL;
+	}
+
+	return zbx_odbc_select(entry->data_source, query, error);
+}
+
+#undef ZBX_ODBC_POOL_IDLE_TIMEOUT
+#undef ZBX_ODBC_POOL_PURGE_INTERVAL
 
 /******************************************************************************
  *                                                                            *
@@ -42,8 +247,8 @@ int	get_value_db(const zbx_dc_item_t *item, int config_timeout, AGENT_RESULT *re
 {
 	AGENT_REQUEST		request;
 	const char		*dsn, *connection = NULL;
-	zbx_odbc_data_source_t	*data_source;
-	zbx_odbc_query_result_t	*query_result;
+	zbx_odbc_data_source_t	*data_source = NULL;
+	zbx_odbc_query_result_t	*query_result = NULL;
 	char			*error = NULL;
 	int			(*query_result_to_text)(zbx_odbc_query_result_t *query_result, char **text, char **error),
 				ret = NOTSUPPORTED;
@@ -95,25 +300,33 @@ int	get_value_db(const zbx_dc_item_t *item, int config_timeout, AGENT_RESULT *re
 		goto out;
 	}
 
-	if (NULL != (data_source = zbx_odbc_connect(dsn, connection, item->username, item->password, config_timeout,
-			&error)))
+	if (0 != odbc_pool_enabled)
 	{
-		if (NULL != (query_result = zbx_odbc_select(data_source, item->params, &error)))
-		{
-			char	*text = NULL;
+		query_result = odbc_pool_select(dsn, connection, item->username, item->password, item->params,
+				config_timeout, &error);
+	}
+	else if (NULL != (data_source = zbx_odbc_connect(dsn, connection, item->username, item->password,
+			config_timeout, &error)))
+	{
+		query_result = zbx_odbc_select(data_source, item->params, &error);
+	}
 
-			if (SUCCEED == query_result_to_text(query_result, &text, &error))
-			{
-				SET_TEXT_RESULT(result, text);
-				ret = SUCCEED;
-			}
+	if (NULL != query_result)
+	{
+		char	*text = NULL;
 
-			zbx_odbc_query_result_free(query_result);
+		if (SUCCEED == query_result_to_text(query_result, &text, &error))
+		{
+			SET_TEXT_RESULT(result, text);
+			ret = SUCCEED;
 		}
 
-		zbx_odbc_data_source_free(data_source);
+		zbx_odbc_query_result_free(query_result);
 	}
 
+	if (NULL != data_source)
+		zbx_odbc_data_source_free(data_source);
+
 	if (SUCCEED != ret)
 		SET_MSG_RESULT(result, error);
 out:
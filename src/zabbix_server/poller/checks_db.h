@@ -23,6 +23,8 @@
 #include "zbxcacheconfig.h"
 
 #ifdef HAVE_UNIXODBC
+void	odbc_pool_enable(void);
+void	odbc_pool_purge(void);
 int	get_value_db(const zbx_dc_item_t *item, int config_timeout, AGENT_RESULT *result);
 #endif
 
@@ -22,6 +22,8 @@
 
 #include "checks_java.h"
 #include "zbxself.h"
+#include "zbxprof.h"
+#include "zbxmutexs.h"
 #include "zbxtrends.h"
 #include "../vmware/vmware.h"
 #include "../../libs/zbxsysinfo/common/zabbix_stats.h"
@@ -33,6 +35,35 @@
 extern unsigned char	program_type;
 extern int		CONFIG_FORKS[ZBX_PROCESS_TYPE_COUNT];
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get poller type by its name                                       *
+ *                                                                            *
+ * Parameters: name - [IN] the poller type name, empty or NULL for normal     *
+ *                         pollers                                            *
+ *                                                                            *
+ * Return value: poller type (ZBX_POLLER_TYPE_...) or FAIL if the name is not *
+ *               known                                                        *
+ *                                                                            *
+ ******************************************************************************/
+static int	get_poller_type_by_name(const char *name)
+{
+	static const char	*names[ZBX_POLLER_TYPE_COUNT] = {"normal", "unreachable", "ipmi", "pinger", "java",
+					"history", "odbc", "agent", "snmp", "httpagent"};
+	int			i;
+
+	if (NULL == name || '\0' == *name)
+		return ZBX_POLLER_TYPE_NORMAL;
+
+	for (i = 0; i < ZBX_POLLER_TYPE_COUNT; i++)
+	{
+		if (0 == strcmp(name, names[i]))
+			return i;
+	}
+
+	return FAIL;
+}
+
 static int	compare_interfaces(const void *p1, const void *p2)
 {
 	const zbx_dc_interface2_t	*i1 = (const zbx_dc_interface2_t *)p1, *i2 = (const zbx_dc_interface2_t *)p2;
@@ -232,6 +263,39 @@ out:
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: set result to the requested latency probe statistic               *
+ *                                                                            *
+ * Parameters: stats  - [IN] latency probe statistics                         *
+ *             mode   - [IN] avg (default), count, p50, p90 or p99            *
+ *             result - [OUT] the statistic value                             *
+ *                                                                            *
+ * Return value: SUCCEED - the result was set                                 *
+ *               FAIL    - unknown mode                                       *
+ *                                                                            *
+ ******************************************************************************/
+static int	get_latency_stat(const zbx_prof_probe_stats_t *stats, const char *mode, AGENT_RESULT *result)
+{
+	if (NULL == mode || '\0' == *mode || 0 == strcmp(mode, "avg"))
+	{
+		SET_DBL_RESULT(result, 0 == stats->count ? 0.0 :
+				(double)stats->total_us / (double)stats->count / 1000000.0);
+	}
+	else if (0 == strcmp(mode, "count"))
+		SET_UI64_RESULT(result, stats->count);
+	else if (0 == strcmp(mode, "p50"))
+		SET_DBL_RESULT(result, zbx_prof_probe_percentile(stats, 50));
+	else if (0 == strcmp(mode, "p90"))
+		SET_DBL_RESULT(result, zbx_prof_probe_percentile(stats, 90));
+	else if (0 == strcmp(mode, "p99"))
+		SET_DBL_RESULT(result, zbx_prof_probe_percentile(stats, 99));
+	else
+		return FAIL;
+
+	return SUCCEED;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: retrieve data from Zabbix server (internally supported items)     *
@@ -351,6 +415,154 @@ int	get_value_internal(const zbx_dc_item_t *item, AGENT_RESULT *result, const zb
 
 		SET_UI64_RESULT(result, zbx_dc_get_item_queue(NULL, from, to));
 	}
+	else if (0 == strcmp(tmp, "scheduling_lag"))		/* zabbix["scheduling_lag",<poller type>] */
+	{
+		int	poller_type;
+
+		if (2 < nparams)
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid number of parameters."));
+			goto out;
+		}
+
+		tmp = get_rparam(&request, 1);
+
+		if (FAIL == (poller_type = get_poller_type_by_name(tmp)))
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid second parameter."));
+			goto out;
+		}
+
+		SET_UI64_RESULT(result, zbx_dc_get_poller_lag((unsigned char)poller_type));
+	}
+	else if (0 == strcmp(tmp, "latency"))			/* zabbix["latency",<probe>,<mode>] */
+	{
+		int			probe;
+		zbx_prof_probe_stats_t	stats;
+
+		if (2 > nparams || 3 < nparams)
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid number of parameters."));
+			goto out;
+		}
+
+		if (FAIL == (probe = zbx_prof_probe_by_name(get_rparam(&request, 1))))
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid second parameter."));
+			goto out;
+		}
+
+		if (SUCCEED != zbx_prof_probe_get_stats(probe, &stats))
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Profiling probes are not available."));
+			goto out;
+		}
+
+		if (SUCCEED != get_latency_stat(&stats, get_rparam(&request, 2), result))
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid third parameter."));
+			goto out;
+		}
+	}
+	else if (0 == strcmp(tmp, "value_latency"))	/* zabbix["value_latency",<stage>,<item type>,<mode>] */
+	{
+		int			stage, type = -1;
+		zbx_prof_probe_stats_t	stats;
+
+		if (2 > nparams || 4 < nparams)
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid number of parameters."));
+			goto out;
+		}
+
+		if (FAIL == (stage = zbx_prof_value_stage_by_name(get_rparam(&request, 1))))
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid second parameter."));
+			goto out;
+		}
+
+		if (NULL != (tmp = get_rparam(&request, 2)) && '\0' != *tmp &&
+				(FAIL == zbx_is_uint31(tmp, &type) || ZBX_PROF_ITEM_TYPES_NUM <= type))
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid third parameter."));
+			goto out;
+		}
+
+		if (SUCCEED != zbx_prof_value_latency_get_stats(stage, type, &stats))
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Profiling probes are not available."));
+			goto out;
+		}
+
+		if (SUCCEED != get_latency_stat(&stats, get_rparam(&request, 3), result))
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid fourth parameter."));
+			goto out;
+		}
+	}
+	else if (0 == strcmp(tmp, "locks"))			/* zabbix["locks",<lock>,<mode>] */
+	{
+		int			lock;
+		zbx_lock_stats_t	stats;
+
+		if (3 != nparams)
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid number of parameters."));
+			goto out;
+		}
+
+		if (FAIL == (lock = zbx_lock_get_by_name(get_rparam(&request, 1))))
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid second parameter."));
+			goto out;
+		}
+
+		if (SUCCEED != zbx_lock_get_stats(lock, &stats))
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Lock usage statistics are not available."));
+			goto out;
+		}
+
+		tmp = get_rparam(&request, 2);
+
+		if (0 == strcmp(tmp, "locks"))
+		{
+			SET_UI64_RESULT(result, stats.locks);
+		}
+		else if (0 == strcmp(tmp, "contended"))
+		{
+			SET_UI64_RESULT(result, stats.contended);
+		}
+		else if (0 == strcmp(tmp, "wait"))
+		{
+			SET_DBL_RESULT(result, (double)stats.wait_ns / 1000000000.0);
+		}
+		else if (0 == strcmp(tmp, "wait_max"))
+		{
+			SET_DBL_RESULT(result, (double)stats.wait_max_ns / 1000000000.0);
+		}
+		else if (0 == strcmp(tmp, "hold"))
+		{
+			SET_DBL_RESULT(result, (double)stats.hold_ns / 1000000000.0);
+		}
+		else if (0 == strcmp(tmp, "hold_p50"))
+		{
+			SET_DBL_RESULT(result, zbx_lock_stats_hold_percentile(&stats, 50));
+		}
+		else if (0 == strcmp(tmp, "hold_p90"))
+		{
+			SET_DBL_RESULT(result, zbx_lock_stats_hold_percentile(&stats, 90));
+		}
+		else if (0 == strcmp(tmp, "hold_p99"))
+		{
+			SET_DBL_RESULT(result, zbx_lock_stats_hold_percentile(&stats, 99));
+		}
+		else
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid third parameter."));
+			goto out;
+		}
+	}
 	else if (0 == strcmp(tmp, "requiredperformance"))	/* zabbix["requiredperformance"] */
 	{
 		if (1 != nparams)
@@ -919,6 +1131,32 @@ int	get_value_internal(const zbx_dc_item_t *item, AGENT_RESULT *result, const zb
 
 		SET_UI64_RESULT(result, zbx_preprocessor_get_queue_size());
 	}
+	else if (0 == strcmp(tmp, "inflight_checks"))		/* zabbix[inflight_checks,<type>] */
+	{
+		unsigned char	poller_type;
+
+		if (2 != nparams)
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid number of parameters."));
+			goto out;
+		}
+
+		tmp = get_rparam(&request, 1);
+
+		if (0 == strcmp(tmp, "agent"))
+			poller_type = ZBX_POLLER_TYPE_AGENT;
+		else if (0 == strcmp(tmp, "snmp"))
+			poller_type = ZBX_POLLER_TYPE_SNMP;
+		else if (0 == strcmp(tmp, "http"))
+			poller_type = ZBX_POLLER_TYPE_HTTPAGENT;
+		else
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid second parameter."));
+			goto out;
+		}
+
+		SET_UI64_RESULT(result, (zbx_uint64_t)zbx_dc_get_inflight_checks(poller_type));
+	}
 	else if (0 == strcmp(tmp, "tcache"))			/* zabbix[tcache,cache,<parameter>] */
 	{
 		char		*error = NULL;
@@ -996,6 +1234,83 @@ int	get_value_internal(const zbx_dc_item_t *item, AGENT_RESULT *result, const zb
 			goto out;
 		}
 	}
+	else if (0 == strcmp(tmp, "tls"))			/* zabbix[tls,<client|server>,<parameter>] */
+	{
+#if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
+		char			*error = NULL;
+		zbx_tls_session_stats_t	stats;
+		zbx_uint64_t		hits, misses;
+
+		if (2 > nparams || 3 < nparams)
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid number of parameters."));
+			goto out;
+		}
+
+		if (FAIL == zbx_tls_session_get_stats(&stats, &error))
+		{
+			SET_MSG_RESULT(result, error);
+			goto out;
+		}
+
+		tmp1 = get_rparam(&request, 1);
+
+		if (0 == strcmp(tmp1, "client"))
+		{
+			hits = stats.client_hits;
+			misses = stats.client_misses;
+		}
+		else if (0 == strcmp(tmp1, "server"))
+		{
+			hits = stats.server_hits;
+			misses = stats.server_misses;
+		}
+		else
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid second parameter."));
+			goto out;
+		}
+
+		tmp = get_rparam(&request, 2);
+
+		if (NULL == tmp || 0 == strcmp(tmp, "all"))
+		{
+			SET_UI64_RESULT(result, hits + misses);
+		}
+		else if (0 == strcmp(tmp, "hits"))
+		{
+			SET_UI64_RESULT(result, hits);
+		}
+		else if (0 == strcmp(tmp, "misses"))
+		{
+			SET_UI64_RESULT(result, misses);
+		}
+		else if (0 == strcmp(tmp, "phits"))
+		{
+			SET_DBL_RESULT(result, (0 == hits + misses ? 0 : (double)hits / (double)(hits + misses) * 100));
+		}
+		else if (0 == strcmp(tmp, "pmisses"))
+		{
+			SET_DBL_RESULT(result, (0 == hits + misses ? 0 : (double)misses / (double)(hits + misses) * 100));
+		}
+		else if (0 == strcmp(tmp1, "client") && 0 == strcmp(tmp, "sessions"))
+		{
+			SET_UI64_RESULT(result, stats.sessions_num);
+		}
+		else if (0 == strcmp(tmp1, "client") && 0 == strcmp(tmp, "pused"))
+		{
+			SET_DBL_RESULT(result, (double)stats.sessions_num / (double)stats.slots_num * 100);
+		}
+		else
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid third parameter."));
+			goto out;
+		}
+#else
+		SET_MSG_RESULT(result, zbx_strdup(NULL, "Support for TLS was not compiled in."));
+		goto out;
+#endif
+	}
 	else
 	{
 		SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid first parameter."));
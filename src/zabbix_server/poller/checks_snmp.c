@@ -24,6 +24,7 @@
 #define SNMP_NO_DEBUGGING		/* disabling debugging messages from Net-SNMP library */
 #include <net-snmp/net-snmp-config.h>
 #include <net-snmp/net-snmp-includes.h>
+#include <net-snmp/library/large_fd_set.h>
 
 #include "log.h"
 #include "zbxcomms.h"
@@ -31,6 +32,8 @@
 #include "zbxjson.h"
 #include "zbxparam.h"
 #include "zbxsysinfo.h"
+#include "poller.h"
+#include "zbxtime.h"
 
 /*
  * SNMP Dynamic Index Cache
@@ -114,6 +117,27 @@ zbx_snmp_oid_t;
 ZBX_PTR_VECTOR_DECL(snmp_oid, zbx_snmp_oid_t *)
 ZBX_PTR_VECTOR_IMPL(snmp_oid, zbx_snmp_oid_t *)
 
+struct zbx_snmp_context
+{
+	zbx_dc_item_t		*items;
+	AGENT_RESULT		*results;
+	int			*errcodes;
+	int			num;
+	oid			(*parsed_oids)[MAX_OID_LEN];
+	size_t			*parsed_oid_lens;
+	int			*mapping;	/* indexes of items to be queried */
+	int			mapping_num;
+	int			from;		/* position in mapping of the first item of current request */
+	int			vars_num;	/* number of items in current request                       */
+	int			max_vars;	/* maximum number of items queried in one request           */
+	int			timeout;
+	double			time_sent;	/* when the current request was sent                        */
+	int			max_succeed;
+	int			min_fail;
+	struct snmp_session	*ss;
+	zbx_vector_ptr_t	*finished;
+};
+
 static zbx_hashset_t	snmpidx;		/* Dynamic Index Cache */
 static char		zbx_snmp_init_done;
 
@@ -2534,6 +2558,480 @@ out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: set error of the mapped items that have not been queried yet      *
+ *                                                                            *
+ * Parameters: snmp_context - [IN/OUT]                                        *
+ *             from         - [IN] the first position in mapping              *
+ *             to           - [IN] the position in mapping to stop before     *
+ *             err          - [IN] the error code                             *
+ *             error        - [IN] the error message                          *
+ *                                                                            *
+ ******************************************************************************/
+static void	snmp_async_set_error(zbx_snmp_context_t *snmp_context, int from, int to, int err, const char *error)
+{
+	int	i;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "getting SNMP values failed: %s", error);
+
+	for (i = from; i < to; i++)
+	{
+		int	j = snmp_context->mapping[i];
+
+		if (SUCCEED != snmp_context->errcodes[j])
+			continue;
+
+		SET_MSG_RESULT(&snmp_context->results[j], zbx_strdup(NULL, error));
+		snmp_context->errcodes[j] = err;
+	}
+}
+
+static void	snmp_async_finish(zbx_snmp_context_t *snmp_context)
+{
+	if (0 != snmp_context->max_succeed || ZBX_MAX_SNMP_ITEMS + 1 != snmp_context->min_fail)
+	{
+		zbx_dc_config_update_interface_snmp_stats(snmp_context->items[0].interface.interfaceid,
+				snmp_context->max_succeed, snmp_context->min_fail);
+	}
+
+	zbx_vector_ptr_append(snmp_context->finished, snmp_context);
+}
+
+static int	snmp_async_cb(int operation, struct snmp_session *sp, int reqid, struct snmp_pdu *response,
+		void *magic);
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: send GET request for the next mapped items, up to the maximum     *
+ *          number of items queried in one request                            *
+ *                                                                            *
+ * Return value: SUCCEED - the request was sent                               *
+ *               FAIL    - otherwise, the error is set for all items that     *
+ *                         have not been queried yet                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	snmp_async_send_request(zbx_snmp_context_t *snmp_context)
+{
+	struct snmp_pdu	*pdu;
+	int		i, from, to;
+	char		error[MAX_STRING_LEN];
+
+	from = snmp_context->from;
+	snmp_context->vars_num = MIN(snmp_context->max_vars, snmp_context->mapping_num - from);
+	to = from + snmp_context->vars_num;
+
+	if (NULL == (pdu = snmp_pdu_create(SNMP_MSG_GET)))
+	{
+		snmp_async_set_error(snmp_context, from, snmp_context->mapping_num, CONFIG_ERROR,
+				"snmp_pdu_create(): cannot create PDU object.");
+		return FAIL;
+	}
+
+	for (i = from; i < to; i++)
+	{
+		int	j = snmp_context->mapping[i];
+
+		if (NULL == snmp_add_null_var(pdu, snmp_context->parsed_oids[j], snmp_context->parsed_oid_lens[j]))
+		{
+			snmp_free_pdu(pdu);
+			snmp_async_set_error(snmp_context, from, snmp_context->mapping_num, CONFIG_ERROR,
+					"snmp_add_null_var(): cannot add null variable.");
+			return FAIL;
+		}
+	}
+
+	snmp_context->ss->retries = (1 == snmp_context->mapping_num ? 1 : 0);
+	snmp_context->time_sent = zbx_time();
+
+	if (0 == snmp_async_send(snmp_context->ss, pdu, snmp_async_cb, snmp_context))
+	{
+		snmp_free_pdu(pdu);
+		snmp_async_set_error(snmp_context, from, snmp_context->mapping_num,
+				zbx_get_snmp_response_error(snmp_context->ss, &snmp_context->items[0].interface,
+				STAT_ERROR, NULL, error, sizeof(error)), error);
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: process response to the request with multiple variable bindings   *
+ *                                                                            *
+ * Return value: SUCCEED - the values were set                                *
+ *               FAIL    - the variable bindings do not match the request,    *
+ *                         the items must be queried separately               *
+ *                                                                            *
+ ******************************************************************************/
+static int	snmp_async_process_values(zbx_snmp_context_t *snmp_context, const struct snmp_pdu *response)
+{
+	int			i, j, from, to;
+	struct variable_list	*var;
+	unsigned char		val_type;
+	const char		*host = snmp_context->items[0].host.host;
+
+	from = snmp_context->from;
+	to = from + snmp_context->vars_num;
+
+	/* check that response variable bindings match the request before storing any value */
+	for (i = from, var = response->variables; i < to && NULL != var; i++, var = var->next_variable)
+	{
+		j = snmp_context->mapping[i];
+
+		if (snmp_context->parsed_oid_lens[j] != var->name_length || 0 != memcmp(snmp_context->parsed_oids[j],
+				var->name, snmp_context->parsed_oid_lens[j] * sizeof(oid)))
+		{
+			char	sent_oid[ZBX_ITEM_SNMP_OID_LEN_MAX], received_oid[ZBX_ITEM_SNMP_OID_LEN_MAX];
+
+			zbx_snmp_dump_oid(sent_oid, sizeof(sent_oid), snmp_context->parsed_oids[j],
+					snmp_context->parsed_oid_lens[j]);
+			zbx_snmp_dump_oid(received_oid, sizeof(received_oid), var->name, var->name_length);
+
+			if (1 != to - from)
+			{
+				zabbix_log(LOG_LEVEL_WARNING, "SNMP response from host \"%s\" contains variable"
+						" bindings that do not match the request: sent \"%s\", received \"%s\"",
+						host, sent_oid, received_oid);
+
+				return FAIL;
+			}
+
+			zabbix_log(LOG_LEVEL_DEBUG, "SNMP response from host \"%s\" contains variable bindings that"
+					" do not match the request: sent \"%s\", received \"%s\"",
+					host, sent_oid, received_oid);
+		}
+	}
+
+	if (i != to || NULL != var)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "SNMP response from host \"%s\" contains too %s variable bindings",
+				host, i != to ? "few" : "many");
+
+		if (1 != to - from)	/* give device a chance to handle a smaller request */
+			return FAIL;
+
+		snmp_async_set_error(snmp_context, from, to, NOTSUPPORTED, i != to ?
+				"Invalid SNMP response: too few variable bindings." :
+				"Invalid SNMP response: too many variable bindings.");
+
+		return SUCCEED;
+	}
+
+	for (i = from, var = response->variables; i < to; i++, var = var->next_variable)
+	{
+		j = snmp_context->mapping[i];
+
+		snmp_context->errcodes[j] = zbx_snmp_set_result(var, &snmp_context->results[j], &val_type);
+
+		if (ZBX_ISSET_TEXT(&snmp_context->results[j]) && ZBX_SNMP_STR_HEX == val_type)
+			zbx_remove_chars(snmp_context->results[j].text, "\r\n");
+	}
+
+	if (snmp_context->max_succeed < to - from)
+		snmp_context->max_succeed = to - from;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: process response of asynchronous SNMP request and send the next   *
+ *          request if any                                                    *
+ *                                                                            *
+ * Comments: Follows the logic of zbx_snmp_get_values(). The items of the     *
+ *           check are requested one chunk after another. When the device     *
+ *           cannot handle a request its size is halved for the rest of the   *
+ *           check.                                                           *
+ *                                                                            *
+ ******************************************************************************/
+static int	snmp_async_cb(int operation, struct snmp_session *sp, int reqid, struct snmp_pdu *response,
+		void *magic)
+{
+	zbx_snmp_context_t	*snmp_context = (zbx_snmp_context_t *)magic;
+	int			status, num, from, ret;
+	char			error[MAX_STRING_LEN];
+
+	ZBX_UNUSED(sp);
+
+	switch (operation)
+	{
+		case NETSNMP_CALLBACK_OP_RECEIVED_MESSAGE:
+			status = STAT_SUCCESS;
+			break;
+		case NETSNMP_CALLBACK_OP_TIMED_OUT:
+			status = STAT_TIMEOUT;
+			break;
+		default:
+			status = STAT_ERROR;
+	}
+
+	from = snmp_context->from;
+	num = snmp_context->vars_num;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() reqid:%d status:%d s_snmp_errno:%d errstat:%ld num:%d", __func__, reqid,
+			status, snmp_context->ss->s_snmp_errno, STAT_SUCCESS != status ? (long)-1 : response->errstat,
+			num);
+
+	if (STAT_SUCCESS == status && SNMP_ERR_NOERROR == response->errstat)
+	{
+		if (SUCCEED != snmp_async_process_values(snmp_context, response))
+			goto split;
+
+		/* do not grow requests that the device is already slow to respond to */
+		if (1 < num && snmp_context->timeout < (zbx_time() - snmp_context->time_sent) * 2 &&
+				snmp_context->min_fail > num + 1)
+		{
+			snmp_context->min_fail = num + 1;
+		}
+	}
+	else if (STAT_SUCCESS == status && SNMP_ERR_NOSUCHNAME == response->errstat && 0 != response->errindex)
+	{
+		/* see zbx_snmp_get_values() on handling of the bad variable */
+
+		int	i = response->errindex - 1, j;
+
+		if (0 > i || i >= num)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "SNMP response from host \"%s\" contains an out of bounds error"
+					" index: %ld", snmp_context->items[0].host.host, response->errindex);
+
+			snmp_async_set_error(snmp_context, from, from + num, NOTSUPPORTED,
+					"Invalid SNMP response: error index out of bounds.");
+			goto next;
+		}
+
+		j = snmp_context->mapping[from + i];
+
+		ret = zbx_get_snmp_response_error(snmp_context->ss, &snmp_context->items[0].interface, status,
+				response, error, sizeof(error));
+		SET_MSG_RESULT(&snmp_context->results[j], zbx_strdup(NULL, error));
+		snmp_context->errcodes[j] = ret;
+
+		if (1 < num)
+		{
+			/* remove the bad variable and retry the request */
+			memmove(snmp_context->mapping + from + i, snmp_context->mapping + from + i + 1,
+					sizeof(int) * (size_t)(snmp_context->mapping_num - from - i - 1));
+			snmp_context->mapping_num--;
+
+			if (SUCCEED == snmp_async_send_request(snmp_context))
+				return 1;
+
+			goto finish;
+		}
+	}
+	else if (1 < num && ((STAT_SUCCESS == status && SNMP_ERR_TOOBIG == response->errstat) ||
+			STAT_TIMEOUT == status || (STAT_ERROR == status && SNMPERR_TOO_LONG ==
+			snmp_context->ss->s_snmp_errno)))
+	{
+		/* see zbx_snmp_get_values() on why bulk request can fail */
+		goto split;
+	}
+	else
+	{
+		ret = zbx_get_snmp_response_error(snmp_context->ss, &snmp_context->items[0].interface, status,
+				response, error, sizeof(error));
+
+		/* do not query the rest of items separately if the device is not reachable */
+		snmp_async_set_error(snmp_context, from, NETWORK_ERROR == ret ? snmp_context->mapping_num :
+				from + num, ret, error);
+
+		if (NETWORK_ERROR == ret)
+			goto finish;
+	}
+next:
+	/* query the next chunk of items */
+	if ((snmp_context->from += num) >= snmp_context->mapping_num)
+		goto finish;
+
+	if (SUCCEED == snmp_async_send_request(snmp_context))
+		return 1;
+
+	goto finish;
+split:
+	if (snmp_context->min_fail > num)
+		snmp_context->min_fail = num;
+
+	snmp_context->max_vars = num / 2;
+
+	if (SUCCEED == snmp_async_send_request(snmp_context))
+		return 1;
+finish:
+	snmp_async_finish(snmp_context);
+
+	return 1;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: start asynchronous SNMP check of the items of one interface       *
+ *                                                                            *
+ * Parameters: items          - [IN] the items to check, the check takes over *
+ *                                   memory allocated for the item fields     *
+ *             results        - [IN] the prepared item results, the check     *
+ *                                   takes them over                          *
+ *             errcodes       - [IN] the item preparation error codes         *
+ *             num            - [IN] the number of items                      *
+ *             config_timeout - [IN]                                          *
+ *             finished       - [OUT] the check is added to the finished      *
+ *                                    checks when it is completed             *
+ *                                                                            *
+ * Comments: Only standard OIDs are supported. The check is processed while   *
+ *           waiting for events with zbx_async_check_snmp_wait() and must be  *
+ *           freed with zbx_async_check_snmp_clean() once finished.           *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_async_check_snmp(const zbx_dc_item_t *items, const AGENT_RESULT *results, const int *errcodes, int num,
+		int config_timeout, zbx_vector_ptr_t *finished)
+{
+	zbx_snmp_context_t	*snmp_context;
+	int			i;
+	char			error[MAX_STRING_LEN], oid_translated[ZBX_ITEM_SNMP_OID_LEN_MAX];
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() host:'%s' addr:'%s' num:%d",
+			__func__, items[0].host.host, items[0].interface.addr, num);
+
+	zbx_init_snmp();	/* avoid high CPU usage by only initializing SNMP once used */
+
+	snmp_context = (zbx_snmp_context_t *)zbx_malloc(NULL, sizeof(zbx_snmp_context_t));
+	snmp_context->items = (zbx_dc_item_t *)zbx_malloc(NULL, sizeof(zbx_dc_item_t) * (size_t)num);
+	snmp_context->results = (AGENT_RESULT *)zbx_malloc(NULL, sizeof(AGENT_RESULT) * (size_t)num);
+	snmp_context->errcodes = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)num);
+	snmp_context->parsed_oids = zbx_malloc(NULL, sizeof(*snmp_context->parsed_oids) * (size_t)num);
+	snmp_context->parsed_oid_lens = (size_t *)zbx_malloc(NULL, sizeof(size_t) * (size_t)num);
+	snmp_context->mapping = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)num);
+
+	for (i = 0; i < num; i++)
+		zbx_dc_item_copy(&snmp_context->items[i], &items[i]);
+
+	memcpy(snmp_context->results, results, sizeof(AGENT_RESULT) * (size_t)num);
+	memcpy(snmp_context->errcodes, errcodes, sizeof(int) * (size_t)num);
+
+	snmp_context->num = num;
+	snmp_context->mapping_num = 0;
+	snmp_context->from = 0;
+	snmp_context->vars_num = 0;
+	snmp_context->max_vars = zbx_dc_config_get_suggested_snmp_vars(items[0].interface.interfaceid, NULL);
+	snmp_context->timeout = config_timeout;
+	snmp_context->time_sent = 0;
+	snmp_context->max_succeed = 0;
+	snmp_context->min_fail = ZBX_MAX_SNMP_ITEMS + 1;
+	snmp_context->ss = NULL;
+	snmp_context->finished = finished;
+
+	for (i = 0; i < num; i++)
+	{
+		zbx_dc_item_t	*item = &snmp_context->items[i];
+
+		if (SUCCEED != snmp_context->errcodes[i])
+			continue;
+
+		if (0 != zbx_num_key_param(item->snmp_oid))
+		{
+			SET_MSG_RESULT(&snmp_context->results[i], zbx_dsprintf(NULL, "OID \"%s\" contains unsupported"
+					" parameters.", item->snmp_oid));
+			snmp_context->errcodes[i] = CONFIG_ERROR;
+			continue;
+		}
+
+		zbx_snmp_translate(oid_translated, item->snmp_oid, sizeof(oid_translated));
+		snmp_context->parsed_oid_lens[i] = MAX_OID_LEN;
+
+		if (NULL == snmp_parse_oid(oid_translated, snmp_context->parsed_oids[i],
+				&snmp_context->parsed_oid_lens[i]))
+		{
+			SET_MSG_RESULT(&snmp_context->results[i], zbx_dsprintf(NULL, "snmp_parse_oid(): cannot parse"
+					" OID \"%s\".", oid_translated));
+			snmp_context->errcodes[i] = CONFIG_ERROR;
+			continue;
+		}
+
+		snmp_context->mapping[snmp_context->mapping_num++] = i;
+	}
+
+	if (0 == snmp_context->mapping_num)
+		goto finish;
+
+	if (NULL == (snmp_context->ss = zbx_snmp_open_session(&snmp_context->items[snmp_context->mapping[0]], error,
+			sizeof(error), config_timeout)))
+	{
+		snmp_async_set_error(snmp_context, 0, snmp_context->mapping_num, NETWORK_ERROR, error);
+		goto finish;
+	}
+
+	if (SUCCEED == snmp_async_send_request(snmp_context))
+		goto out;
+finish:
+	snmp_async_finish(snmp_context);
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get items and results of finished asynchronous SNMP check         *
+ *                                                                            *
+ * Return value: the number of items                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_async_check_snmp_get_items(zbx_snmp_context_t *snmp_context, zbx_dc_item_t **items,
+		AGENT_RESULT **results, int **errcodes)
+{
+	*items = snmp_context->items;
+	*results = snmp_context->results;
+	*errcodes = snmp_context->errcodes;
+
+	return snmp_context->num;
+}
+
+void	zbx_async_check_snmp_clean(zbx_snmp_context_t *snmp_context)
+{
+	if (NULL != snmp_context->ss)
+		zbx_snmp_close_session(snmp_context->ss);
+
+	zbx_clean_items(snmp_context->items, snmp_context->num, snmp_context->results);
+	zbx_dc_config_clean_items(snmp_context->items, NULL, (size_t)snmp_context->num);
+
+	zbx_free(snmp_context->mapping);
+	zbx_free(snmp_context->parsed_oid_lens);
+	zbx_free(snmp_context->parsed_oids);
+	zbx_free(snmp_context->errcodes);
+	zbx_free(snmp_context->results);
+	zbx_free(snmp_context->items);
+	zbx_free(snmp_context);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: wait for responses to asynchronous SNMP requests of all open      *
+ *          sessions for up to sleeptime seconds and process them             *
+ *                                                                            *
+ * Comments: Net-SNMP library timeouts and retries are handled here too, the  *
+ *           wait is shortened to the earliest request timeout.               *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_async_check_snmp_wait(int sleeptime)
+{
+	netsnmp_large_fd_set	fdset;
+	struct timeval		timeout = {sleeptime, 0};
+	int			numfds = 0, block = 0, ret;
+
+	netsnmp_large_fd_set_init(&fdset, FD_SETSIZE);
+
+	snmp_select_info2(&numfds, &fdset, &timeout, &block);
+
+	if (0 < (ret = netsnmp_large_fd_set_select(numfds, &fdset, NULL, NULL, &timeout)))
+		snmp_read2(&fdset);
+	else if (0 == ret)
+		snmp_timeout();
+	else if (EINTR != errno)
+		zabbix_log(LOG_LEVEL_WARNING, "cannot wait for SNMP responses: %s", zbx_strerror(errno));
+
+	netsnmp_large_fd_set_cleanup(&fdset);
+}
+
 static void	zbx_shutdown_snmp(void)
 {
 	sigset_t	mask, orig_mask;
@@ -39,6 +39,15 @@ int	get_value_snmp(const zbx_dc_item_t *item, AGENT_RESULT *result, unsigned cha
 void	get_values_snmp(const zbx_dc_item_t *items, AGENT_RESULT *results, int *errcodes, int num,
 		unsigned char poller_type, int config_timeout);
 void	zbx_clear_cache_snmp(unsigned char process_type, int process_num);
+
+typedef struct zbx_snmp_context	zbx_snmp_context_t;
+
+void	zbx_async_check_snmp(const zbx_dc_item_t *items, const AGENT_RESULT *results, const int *errcodes, int num,
+		int config_timeout, zbx_vector_ptr_t *finished);
+int	zbx_async_check_snmp_get_items(zbx_snmp_context_t *snmp_context, zbx_dc_item_t **items,
+		AGENT_RESULT **results, int **errcodes);
+void	zbx_async_check_snmp_clean(zbx_snmp_context_t *snmp_context);
+void	zbx_async_check_snmp_wait(int sleeptime);
 #endif
 
 #endif
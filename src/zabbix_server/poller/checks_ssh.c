@@ -23,6 +23,182 @@
 #if defined(HAVE_SSH2) || defined(HAVE_SSH)
 
 #include "zbxsysinfo.h"
+#include "log.h"
+
+/* authenticated SSH session kept open between checks */
+typedef struct
+{
+	char			*addr;
+	unsigned short		port;
+	unsigned char		authtype;
+	char			*username;
+	char			*password;
+	char			*publickey;
+	char			*privatekey;
+	char			*options;
+	zbx_ssh_session_t	*session;
+	time_t			lastaccess;
+}
+zbx_ssh_session_entry_t;
+
+#define ZBX_SSH_SESSION_IDLE_TIMEOUT	(5 * SEC_PER_MIN)
+#define ZBX_SSH_SESSION_PURGE_INTERVAL	SEC_PER_MIN
+
+/* The cache is process local and is disabled by default. It is enabled by pollers, each keeping at most one */
+/* session per host and credentials, because items of a poller are checked sequentially.                    */
+static int		ssh_cache_enabled = 0;
+static zbx_hashset_t	ssh_cache;
+static time_t		ssh_cache_purge_time;
+
+static zbx_hash_t	ssh_session_hash_func(const void *data)
+{
+	const zbx_ssh_session_entry_t	*entry = (const zbx_ssh_session_entry_t *)data;
+	zbx_hash_t			hash;
+
+	hash = ZBX_DEFAULT_STRING_HASH_ALGO(entry->addr, strlen(entry->addr), ZBX_DEFAULT_HASH_SEED);
+	hash = ZBX_DEFAULT_HASH_ALGO(&entry->port, sizeof(entry->port), hash);
+	hash = ZBX_DEFAULT_HASH_ALGO(&entry->authtype, sizeof(entry->authtype), hash);
+	hash = ZBX_DEFAULT_STRING_HASH_ALGO(entry->username, strlen(entry->username), hash);
+	hash = ZBX_DEFAULT_STRING_HASH_ALGO(entry->password, strlen(entry->password), hash);
+	hash = ZBX_DEFAULT_STRING_HASH_ALGO(entry->publickey, strlen(entry->publickey), hash);
+	hash = ZBX_DEFAULT_STRING_HASH_ALGO(entry->privatekey, strlen(entry->privatekey), hash);
+
+	return ZBX_DEFAULT_STRING_HASH_ALGO(entry->options, strlen(entry->options), hash);
+}
+
+static int	ssh_session_compare_func(const void *d1, const void *d2)
+{
+	const zbx_ssh_session_entry_t	*e1 = (const zbx_ssh_session_entry_t *)d1;
+	const zbx_ssh_session_entry_t	*e2 = (const zbx_ssh_session_entry_t *)d2;
+	int				ret;
+
+	ZBX_RETURN_IF_NOT_EQUAL(e1->port, e2->port);
+	ZBX_RETURN_IF_NOT_EQUAL(e1->authtype, e2->authtype);
+
+	if (0 != (ret = strcmp(e1->addr, e2->addr)))
+		return ret;
+
+	if (0 != (ret = strcmp(e1->username, e2->username)))
+		return ret;
+
+	if (0 != (ret = strcmp(e1->password, e2->password)))
+		return ret;
+
+	if (0 != (ret = strcmp(e1->publickey, e2->publickey)))
+		return ret;
+
+	if (0 != (ret = strcmp(e1->privatekey, e2->privatekey)))
+		return ret;
+
+	return strcmp(e1->options, e2->options);
+}
+
+static void	ssh_session_entry_clean(void *data)
+{
+	zbx_ssh_session_entry_t	*entry = (zbx_ssh_session_entry_t *)data;
+
+	if (NULL != entry->session)
+		ssh_session_free(entry->session);
+
+	zbx_free(entry->addr);
+	zbx_free(entry->username);
+	zbx_free(entry->password);
+	zbx_free(entry->publickey);
+	zbx_free(entry->privatekey);
+	zbx_free(entry->options);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: enable SSH session cache for ssh.run items of the current process *
+ *                                                                            *
+ * Comments: Authenticated sessions are kept open between checks and closed   *
+ *           after ZBX_SSH_SESSION_IDLE_TIMEOUT seconds without use, see      *
+ *           ssh_session_cache_purge(). The cache is not thread safe.         *
+ *                                                                            *
+ ******************************************************************************/
+void	ssh_session_cache_enable(void)
+{
+	if (0 != ssh_cache_enabled)
+		return;
+
+	zbx_hashset_create_ext(&ssh_cache, 10, ssh_session_hash_func, ssh_session_compare_func,
+			ssh_session_entry_clean, ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC,
+			ZBX_DEFAULT_MEM_FREE_FUNC);
+
+	ssh_cache_purge_time = time(NULL);
+	ssh_cache_enabled = 1;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: close cached SSH sessions that were not used recently             *
+ *                                                                            *
+ ******************************************************************************/
+void	ssh_session_cache_purge(void)
+{
+	zbx_hashset_iter_t	iter;
+	zbx_ssh_session_entry_t	*entry;
+	time_t			now;
+
+	if (0 == ssh_cache_enabled)
+		return;
+
+	now = time(NULL);
+
+	if (ZBX_SSH_SESSION_PURGE_INTERVAL > now - ssh_cache_purge_time)
+		return;
+
+	zbx_hashset_iter_reset(&ssh_cache, &iter);
+	while (NULL != (entry = (zbx_ssh_session_entry_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (NULL == entry->session || ZBX_SSH_SESSION_IDLE_TIMEOUT <= now - entry->lastaccess)
+			zbx_hashset_iter_remove(&iter);
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() cached sessions:%d", __func__, ssh_cache.num_data);
+
+	ssh_cache_purge_time = now;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get SSH session cache entry for item connection parameters        *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_ssh_session_entry_t	*ssh_session_cache_get(const zbx_dc_item_t *item, const char *options)
+{
+	zbx_ssh_session_entry_t	*entry, entry_local;
+
+	entry_local.addr = item->interface.addr;
+	entry_local.port = item->interface.port;
+	entry_local.authtype = item->authtype;
+	entry_local.username = item->username;
+	entry_local.password = item->password;
+	entry_local.publickey = item->publickey;
+	entry_local.privatekey = item->privatekey;
+	entry_local.options = (char *)options;
+
+	if (NULL == (entry = (zbx_ssh_session_entry_t *)zbx_hashset_search(&ssh_cache, &entry_local)))
+	{
+		entry_local.addr = zbx_strdup(NULL, item->interface.addr);
+		entry_local.username = zbx_strdup(NULL, item->username);
+		entry_local.password = zbx_strdup(NULL, item->password);
+		entry_local.publickey = zbx_strdup(NULL, item->publickey);
+		entry_local.privatekey = zbx_strdup(NULL, item->privatekey);
+		entry_local.options = zbx_strdup(NULL, options);
+		entry_local.session = NULL;
+
+		entry = (zbx_ssh_session_entry_t *)zbx_hashset_insert(&ssh_cache, &entry_local, sizeof(entry_local));
+	}
+
+	entry->lastaccess = time(NULL);
+
+	return entry;
+}
+
+#undef ZBX_SSH_SESSION_IDLE_TIMEOUT
+#undef ZBX_SSH_SESSION_PURGE_INTERVAL
 
 int	get_value_ssh(zbx_dc_item_t *item, int timeout, AGENT_RESULT *result)
 {
@@ -79,7 +255,19 @@ int	get_value_ssh(zbx_dc_item_t *item, int timeout, AGENT_RESULT *result)
 	encoding = get_rparam(&request, 3);
 	ssh_options = get_rparam(&request, 4);
 
-	ret = ssh_run(item, result, ZBX_NULL2EMPTY_STR(encoding), ZBX_NULL2EMPTY_STR(ssh_options), timeout);
+	if (0 != ssh_cache_enabled)
+	{
+		zbx_ssh_session_entry_t	*entry;
+
+		entry = ssh_session_cache_get(item, ZBX_NULL2EMPTY_STR(ssh_options));
+		ret = ssh_run(item, result, ZBX_NULL2EMPTY_STR(encoding), ZBX_NULL2EMPTY_STR(ssh_options), timeout,
+				&entry->session);
+	}
+	else
+	{
+		ret = ssh_run(item, result, ZBX_NULL2EMPTY_STR(encoding), ZBX_NULL2EMPTY_STR(ssh_options), timeout,
+				NULL);
+	}
 out:
 	zbx_free_agent_request(&request);
 
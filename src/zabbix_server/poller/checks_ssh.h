@@ -26,6 +26,8 @@
 #if defined(HAVE_SSH2) || defined(HAVE_SSH)
 #include "zbxcacheconfig.h"
 
+void	ssh_session_cache_enable(void);
+void	ssh_session_cache_purge(void);
 int	get_value_ssh(zbx_dc_item_t *item, int timeout, AGENT_RESULT *result);
 #endif	/* defined(HAVE_SSH2) || defined(HAVE_SSH)*/
 
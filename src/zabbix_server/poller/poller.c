@@ -32,6 +32,8 @@
 #include "checks_java.h"
 #include "checks_calculated.h"
 #include "checks_http.h"
+#include "async_agent.h"
+#include "async_httpagent.h"
 
 #include "zbxnix.h"
 #include "zbxself.h"
@@ -46,6 +48,7 @@
 #include "zbxnum.h"
 #include "zbxtime.h"
 #include "zbxsysinfo.h"
+#include "zbxprof.h"
 #include "zbx_rtc_constants.h"
 #include "zbx_item_constants.h"
 
@@ -293,7 +296,7 @@ void	zbx_free_agent_result_ptr(AGENT_RESULT *result)
 }
 
 static int	get_value(zbx_dc_item_t *item, AGENT_RESULT *result, zbx_vector_ptr_t *add_results,
-		const zbx_config_comms_args_t *config_comms, int config_startup_time)
+		unsigned char poller_type, const zbx_config_comms_args_t *config_comms, int config_startup_time)
 {
 	int	res = FAIL;
 
@@ -302,7 +305,11 @@ static int	get_value(zbx_dc_item_t *item, AGENT_RESULT *result, zbx_vector_ptr_t
 	switch (item->type)
 	{
 		case ITEM_TYPE_ZABBIX:
-			res = get_value_agent(item, config_comms->config_timeout, result);
+			/* pollers reuse connection for the following checks of the same interface */
+			if (ZBX_NO_POLLER != poller_type)
+				res = get_value_agent_keepalive(item, config_comms->config_timeout, result);
+			else
+				res = get_value_agent(item, config_comms->config_timeout, result);
 			break;
 		case ITEM_TYPE_SIMPLE:
 			/* simple checks use their own timeouts */
@@ -731,7 +738,7 @@ void	zbx_check_items(zbx_dc_item_t *items, int *errcodes, int num, AGENT_RESULT
 	else if (1 == num)
 	{
 		if (SUCCEED == errcodes[0])
-			errcodes[0] = get_value(&items[0], &results[0], add_results, config_comms,
+			errcodes[0] = get_value(&items[0], &results[0], add_results, poller_type, config_comms,
 				config_startup_time);
 	}
 	else
@@ -821,7 +828,8 @@ static int	get_values(unsigned char poller_type, int *nextcheck, const zbx_confi
 {
 	zbx_dc_item_t		item, *items;
 	AGENT_RESULT		results[ZBX_MAX_POLLER_ITEMS];
-	int			errcodes[ZBX_MAX_POLLER_ITEMS];
+	int			errcodes[ZBX_MAX_POLLER_ITEMS], lastclocks[ZBX_MAX_POLLER_ITEMS];
+	zbx_uint64_t		itemids[ZBX_MAX_POLLER_ITEMS];
 	zbx_timespec_t		timespec;
 	int			i, num, last_available = ZBX_INTERFACE_AVAILABLE_UNKNOWN;
 	zbx_vector_ptr_t	add_results;
@@ -831,10 +839,13 @@ static int	get_values(unsigned char poller_type, int *nextcheck, const zbx_confi
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
 	items = &item;
-	num = zbx_dc_config_get_poller_items(poller_type, config_comms->config_timeout, &items);
+	num = zbx_dc_config_get_poller_items(poller_type, config_comms->config_timeout, 0, 0, &items);
 
 	if (0 == num)
 	{
+		/* do not hold agent listener while the poller is idle */
+		zbx_agent_keepalive_close();
+
 		*nextcheck = zbx_dc_config_get_poller_nextcheck(poller_type);
 		goto exit;
 	}
@@ -934,10 +945,11 @@ static int	get_values(unsigned char poller_type, int *nextcheck, const zbx_confi
 					items[i].flags, NULL, &timespec, items[i].state, results[i].msg);
 		}
 
-		zbx_dc_poller_requeue_items(&items[i].itemid, &timespec.sec, &errcodes[i], 1, poller_type,
-				nextcheck);
+		itemids[i] = items[i].itemid;
+		lastclocks[i] = timespec.sec;
 	}
 
+	zbx_dc_poller_requeue_items(itemids, lastclocks, errcodes, (size_t)num, poller_type, nextcheck);
 	zbx_preprocessor_flush();
 	zbx_clean_items(items, num, results);
 	zbx_dc_config_clean_items(items, NULL, num);
@@ -949,15 +961,529 @@ static int	get_values(unsigned char poller_type, int *nextcheck, const zbx_confi
 		zbx_availability_send(ZBX_IPC_AVAILABILITY_REQUEST, data, (zbx_uint32_t)data_offset, NULL);
 		zbx_free(data);
 	}
-
-	if (items != &item)
-		zbx_free(items);
 exit:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%d", __func__, num);
 
 	return num;
 }
 
+/***********************************************************************************
+ *                                                                                 *
+ * Purpose: process results of finished asynchronous agent checks                  *
+ *                                                                                 *
+ * Parameters: finished                   - [IN/OUT] finished agent checks         *
+ *             nextcheck                  - [OUT] item nextcheck                   *
+ *             config_unavailable_delay   - [IN]                                   *
+ *             config_unreachable_period  - [IN]                                   *
+ *             config_unreachable_delay   - [IN]                                   *
+ *                                                                                 *
+ * Return value: number of items processed                                         *
+ *                                                                                 *
+ **********************************************************************************/
+static int	process_async_agent_results(zbx_vector_ptr_t *finished, int *nextcheck,
+		int config_unavailable_delay, int config_unreachable_period, int config_unreachable_delay)
+{
+	zbx_timespec_t	timespec;
+	int		i, num, *lastclocks, *errcodes;
+	zbx_uint64_t	*itemids;
+	unsigned char	*data = NULL;
+	size_t		data_alloc = 0, data_offset = 0;
+
+	if (0 == (num = finished->values_num))
+		return 0;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() num:%d", __func__, num);
+
+	itemids = (zbx_uint64_t *)zbx_malloc(NULL, sizeof(zbx_uint64_t) * (size_t)num);
+	lastclocks = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)num);
+	errcodes = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)num);
+
+	zbx_timespec(&timespec);
+
+	for (i = 0; i < num; i++)
+	{
+		zbx_agent_context_t	*agent_context = (zbx_agent_context_t *)finished->values[i];
+		zbx_dc_item_t		*item = &agent_context->item;
+
+		switch (agent_context->errcode)
+		{
+			case SUCCEED:
+			case NOTSUPPORTED:
+			case AGENT_ERROR:
+				zbx_activate_item_interface(&timespec, item, &data, &data_alloc, &data_offset);
+				break;
+			case NETWORK_ERROR:
+			case TIMEOUT_ERROR:
+				zbx_deactivate_item_interface(&timespec, item, &data, &data_alloc, &data_offset,
+						config_unavailable_delay, config_unreachable_period,
+						config_unreachable_delay, agent_context->result.msg);
+				break;
+			case CONFIG_ERROR:
+				/* nothing to do */
+				break;
+			default:
+				zbx_error("unknown response code returned: %d", agent_context->errcode);
+				THIS_SHOULD_NEVER_HAPPEN;
+		}
+
+		if (SUCCEED == agent_context->errcode)
+		{
+			item->state = ITEM_STATE_NORMAL;
+			zbx_preprocess_item_value(item->itemid, item->host.hostid, item->value_type, item->flags,
+					&agent_context->result, &timespec, item->state, NULL);
+		}
+		else if (NOTSUPPORTED == agent_context->errcode || AGENT_ERROR == agent_context->errcode ||
+				CONFIG_ERROR == agent_context->errcode)
+		{
+			item->state = ITEM_STATE_NOTSUPPORTED;
+			zbx_preprocess_item_value(item->itemid, item->host.hostid, item->value_type, item->flags, NULL,
+					&timespec, item->state, agent_context->result.msg);
+		}
+
+		itemids[i] = item->itemid;
+		lastclocks[i] = timespec.sec;
+		errcodes[i] = agent_context->errcode;
+
+		zbx_async_check_agent_clean(agent_context);
+	}
+
+	zbx_vector_ptr_clear(finished);
+
+	zbx_dc_poller_requeue_items(itemids, lastclocks, errcodes, (size_t)num, ZBX_POLLER_TYPE_AGENT, nextcheck);
+	zbx_preprocessor_flush();
+
+	if (NULL != data)
+	{
+		zbx_availability_send(ZBX_IPC_AVAILABILITY_REQUEST, data, (zbx_uint32_t)data_offset, NULL);
+		zbx_free(data);
+	}
+
+	zbx_free(errcodes);
+	zbx_free(lastclocks);
+	zbx_free(itemids);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+
+	return num;
+}
+
+/***********************************************************************************
+ *                                                                                 *
+ * Purpose: start asynchronous agent checks of the items that are due              *
+ *                                                                                 *
+ * Parameters: base                       - [IN] event base to run checks with     *
+ *             processing                 - [IN] number of checks in progress      *
+ *             finished                   - [OUT] finished agent checks            *
+ *             nextcheck                  - [OUT] item nextcheck                   *
+ *             config_comms               - [IN] server/proxy configuration for    *
+ *                                               communication                     *
+ *             config_max_concurrent_checks_per_poller - [IN]                      *
+ *                                                                                 *
+ * Return value: number of started checks                                          *
+ *                                                                                 *
+ **********************************************************************************/
+static int	get_values_async(struct event_base *base, int processing, zbx_vector_ptr_t *finished,
+		int *nextcheck, const zbx_config_comms_args_t *config_comms, int config_max_concurrent_checks_per_poller)
+{
+	zbx_dc_item_t	item, *items;
+	AGENT_RESULT	results[ZBX_MAX_POLLER_ITEMS];
+	int		errcodes[ZBX_MAX_POLLER_ITEMS], lastclocks[ZBX_MAX_POLLER_ITEMS];
+	zbx_uint64_t	itemids[ZBX_MAX_POLLER_ITEMS];
+	zbx_timespec_t	timespec;
+	int		i, num, started = 0, failed = 0;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() processing:%d", __func__, processing);
+
+	items = &item;
+	num = zbx_dc_config_get_poller_items(ZBX_POLLER_TYPE_AGENT, config_comms->config_timeout, processing,
+			config_max_concurrent_checks_per_poller, &items);
+
+	if (0 == num)
+		goto out;
+
+	zbx_prepare_items(items, errcodes, num, results, MACRO_EXPAND_YES);
+	zbx_timespec(&timespec);
+
+	for (i = 0; i < num; i++)
+	{
+		if (SUCCEED != errcodes[i])
+		{
+			items[i].state = ITEM_STATE_NOTSUPPORTED;
+			zbx_preprocess_item_value(items[i].itemid, items[i].host.hostid, items[i].value_type,
+					items[i].flags, NULL, &timespec, items[i].state, results[i].msg);
+			itemids[failed] = items[i].itemid;
+			lastclocks[failed] = timespec.sec;
+			errcodes[failed++] = errcodes[i];
+
+			zbx_clean_items(&items[i], 1, &results[i]);
+			zbx_dc_config_clean_items(&items[i], NULL, 1);
+			continue;
+		}
+
+		zbx_free_agent_result(&results[i]);
+
+		if (started != i)
+			zbx_dc_item_copy(&items[started], &items[i]);
+
+		started++;
+	}
+
+	/* the checks take over the items */
+	if (0 != started)
+		zbx_async_check_agents(base, items, started, config_comms->config_timeout, finished);
+
+	if (0 != failed)
+	{
+		zbx_dc_poller_requeue_items(itemids, lastclocks, errcodes, (size_t)failed, ZBX_POLLER_TYPE_AGENT,
+				nextcheck);
+		zbx_preprocessor_flush();
+	}
+out:
+	*nextcheck = zbx_dc_config_get_poller_nextcheck(ZBX_POLLER_TYPE_AGENT);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%d", __func__, started);
+
+	return started;
+}
+
+#ifdef HAVE_NETSNMP
+/***********************************************************************************
+ *                                                                                 *
+ * Purpose: process results of finished asynchronous SNMP checks                   *
+ *                                                                                 *
+ * Parameters: finished                   - [IN/OUT] finished SNMP checks          *
+ *             nextcheck                  - [OUT] item nextcheck                   *
+ *             config_unavailable_delay   - [IN]                                   *
+ *             config_unreachable_period  - [IN]                                   *
+ *             config_unreachable_delay   - [IN]                                   *
+ *                                                                                 *
+ * Return value: number of items processed                                         *
+ *                                                                                 *
+ **********************************************************************************/
+static int	process_async_snmp_results(zbx_vector_ptr_t *finished, int *nextcheck,
+		int config_unavailable_delay, int config_unreachable_period, int config_unreachable_delay)
+{
+	zbx_timespec_t	timespec;
+	int		i, j, num = 0, lastclocks[ZBX_MAX_POLLER_ITEMS];
+	zbx_uint64_t	itemids[ZBX_MAX_POLLER_ITEMS];
+	unsigned char	*data = NULL;
+	size_t		data_alloc = 0, data_offset = 0;
+
+	if (0 == finished->values_num)
+		return 0;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() checks:%d", __func__, finished->values_num);
+
+	zbx_timespec(&timespec);
+
+	for (i = 0; i < finished->values_num; i++)
+	{
+		zbx_snmp_context_t	*snmp_context = (zbx_snmp_context_t *)finished->values[i];
+		zbx_dc_item_t		*items;
+		AGENT_RESULT		*results;
+		int			*errcodes, items_num, last_available = ZBX_INTERFACE_AVAILABLE_UNKNOWN;
+
+		items_num = zbx_async_check_snmp_get_items(snmp_context, &items, &results, &errcodes);
+
+		for (j = 0; j < items_num; j++)
+		{
+			switch (errcodes[j])
+			{
+				case SUCCEED:
+				case NOTSUPPORTED:
+				case AGENT_ERROR:
+					if (ZBX_INTERFACE_AVAILABLE_TRUE != last_available)
+					{
+						zbx_activate_item_interface(&timespec, &items[j], &data, &data_alloc,
+								&data_offset);
+						last_available = ZBX_INTERFACE_AVAILABLE_TRUE;
+					}
+					break;
+				case NETWORK_ERROR:
+				case TIMEOUT_ERROR:
+					if (ZBX_INTERFACE_AVAILABLE_FALSE != last_available)
+					{
+						zbx_deactivate_item_interface(&timespec, &items[j], &data, &data_alloc,
+								&data_offset, config_unavailable_delay,
+								config_unreachable_period, config_unreachable_delay,
+								results[j].msg);
+						last_available = ZBX_INTERFACE_AVAILABLE_FALSE;
+					}
+					break;
+				case CONFIG_ERROR:
+					/* nothing to do */
+					break;
+				default:
+					zbx_error("unknown response code returned: %d", errcodes[j]);
+					THIS_SHOULD_NEVER_HAPPEN;
+			}
+
+			if (SUCCEED == errcodes[j])
+			{
+				items[j].state = ITEM_STATE_NORMAL;
+				zbx_preprocess_item_value(items[j].itemid, items[j].host.hostid, items[j].value_type,
+						items[j].flags, &results[j], &timespec, items[j].state, NULL);
+			}
+			else if (NOTSUPPORTED == errcodes[j] || AGENT_ERROR == errcodes[j] ||
+					CONFIG_ERROR == errcodes[j])
+			{
+				items[j].state = ITEM_STATE_NOTSUPPORTED;
+				zbx_preprocess_item_value(items[j].itemid, items[j].host.hostid, items[j].value_type,
+						items[j].flags, NULL, &timespec, items[j].state, results[j].msg);
+			}
+
+			itemids[j] = items[j].itemid;
+			lastclocks[j] = timespec.sec;
+		}
+
+		zbx_dc_poller_requeue_items(itemids, lastclocks, errcodes, (size_t)items_num, ZBX_POLLER_TYPE_SNMP,
+				nextcheck);
+		num += items_num;
+
+		zbx_async_check_snmp_clean(snmp_context);
+	}
+
+	zbx_vector_ptr_clear(finished);
+	zbx_preprocessor_flush();
+
+	if (NULL != data)
+	{
+		zbx_availability_send(ZBX_IPC_AVAILABILITY_REQUEST, data, (zbx_uint32_t)data_offset, NULL);
+		zbx_free(data);
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%d", __func__, num);
+
+	return num;
+}
+
+/***********************************************************************************
+ *                                                                                 *
+ * Purpose: start asynchronous SNMP checks of the items that are due               *
+ *                                                                                 *
+ * Parameters: processing                 - [IN] number of checks in progress      *
+ *             finished                   - [OUT] finished SNMP checks             *
+ *             nextcheck                  - [OUT] item nextcheck                   *
+ *             config_comms               - [IN] server/proxy configuration for    *
+ *                                               communication                     *
+ *             config_max_concurrent_checks_per_poller - [IN]                      *
+ *                                                                                 *
+ * Return value: number of items being checked                                     *
+ *                                                                                 *
+ * Comments: one check queries items of a single interface, checks are started     *
+ *           until the concurrency limit is reached or no more items are due       *
+ *                                                                                 *
+ **********************************************************************************/
+static int	get_values_async_snmp(int processing, zbx_vector_ptr_t *finished, int *nextcheck,
+		const zbx_config_comms_args_t *config_comms, int config_max_concurrent_checks_per_poller)
+{
+	zbx_dc_item_t	item, *items;
+	AGENT_RESULT	results[ZBX_MAX_POLLER_ITEMS];
+	int		errcodes[ZBX_MAX_POLLER_ITEMS];
+	int		num, started = 0;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() processing:%d", __func__, processing);
+
+	while (processing + started < config_max_concurrent_checks_per_poller)
+	{
+		items = &item;
+
+		if (0 == (num = zbx_dc_config_get_poller_items(ZBX_POLLER_TYPE_SNMP, config_comms->config_timeout,
+				processing + started, config_max_concurrent_checks_per_poller, &items)))
+		{
+			break;
+		}
+
+		zbx_prepare_items(items, errcodes, num, results, MACRO_EXPAND_YES);
+
+		/* the check takes over the items and their results */
+		zbx_async_check_snmp(items, results, errcodes, num, config_comms->config_timeout, finished);
+		started += num;
+	}
+
+	*nextcheck = zbx_dc_config_get_poller_nextcheck(ZBX_POLLER_TYPE_SNMP);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%d", __func__, started);
+
+	return started;
+}
+#endif
+
+#ifdef HAVE_LIBCURL
+/***********************************************************************************
+ *                                                                                 *
+ * Purpose: process results of finished asynchronous HTTP agent checks             *
+ *                                                                                 *
+ * Parameters: finished  - [IN/OUT] finished HTTP agent checks                     *
+ *             nextcheck - [OUT] item nextcheck                                    *
+ *                                                                                 *
+ * Return value: number of items processed                                         *
+ *                                                                                 *
+ **********************************************************************************/
+static int	process_async_httpagent_results(zbx_vector_ptr_t *finished, int *nextcheck)
+{
+	zbx_timespec_t	timespec;
+	int		i, num, *lastclocks, *errcodes;
+	zbx_uint64_t	*itemids;
+
+	if (0 == (num = finished->values_num))
+		return 0;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() num:%d", __func__, num);
+
+	itemids = (zbx_uint64_t *)zbx_malloc(NULL, sizeof(zbx_uint64_t) * (size_t)num);
+	lastclocks = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)num);
+	errcodes = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)num);
+
+	zbx_timespec(&timespec);
+
+	for (i = 0; i < num; i++)
+	{
+		zbx_httpagent_context_t	*httpagent_context = (zbx_httpagent_context_t *)finished->values[i];
+		zbx_dc_item_t		*item = &httpagent_context->item;
+
+		if (SUCCEED == httpagent_context->errcode)
+		{
+			item->state = ITEM_STATE_NORMAL;
+			zbx_preprocess_item_value(item->itemid, item->host.hostid, item->value_type, item->flags,
+					&httpagent_context->result, &timespec, item->state, NULL);
+		}
+		else
+		{
+			item->state = ITEM_STATE_NOTSUPPORTED;
+			zbx_preprocess_item_value(item->itemid, item->host.hostid, item->value_type, item->flags, NULL,
+					&timespec, item->state, httpagent_context->result.msg);
+		}
+
+		itemids[i] = item->itemid;
+		lastclocks[i] = timespec.sec;
+		errcodes[i] = httpagent_context->errcode;
+
+		zbx_async_check_httpagent_clean(httpagent_context);
+	}
+
+	zbx_vector_ptr_clear(finished);
+
+	zbx_dc_poller_requeue_items(itemids, lastclocks, errcodes, (size_t)num, ZBX_POLLER_TYPE_HTTPAGENT,
+			nextcheck);
+	zbx_preprocessor_flush();
+
+	zbx_free(errcodes);
+	zbx_free(lastclocks);
+	zbx_free(itemids);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+
+	return num;
+}
+
+/***********************************************************************************
+ *                                                                                 *
+ * Purpose: start asynchronous HTTP agent checks of the items that are due         *
+ *                                                                                 *
+ * Parameters: httpagent                  - [IN] asynchronous HTTP agent checks    *
+ *             processing                 - [IN] number of checks in progress      *
+ *             nextcheck                  - [OUT] item nextcheck                   *
+ *             config_comms               - [IN] server/proxy configuration for    *
+ *                                               communication                     *
+ *             config_max_concurrent_checks_per_poller - [IN]                      *
+ *                                                                                 *
+ * Return value: number of started checks                                          *
+ *                                                                                 *
+ **********************************************************************************/
+static int	get_values_async_httpagent(zbx_async_httpagent_t *httpagent, int processing, int *nextcheck,
+		const zbx_config_comms_args_t *config_comms, int config_max_concurrent_checks_per_poller)
+{
+	zbx_dc_item_t	item, *items;
+	AGENT_RESULT	results[ZBX_MAX_POLLER_ITEMS];
+	int		errcodes[ZBX_MAX_POLLER_ITEMS], lastclocks[ZBX_MAX_POLLER_ITEMS];
+	zbx_uint64_t	itemids[ZBX_MAX_POLLER_ITEMS];
+	zbx_timespec_t	timespec;
+	int		i, num, started = 0, failed = 0;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() processing:%d", __func__, processing);
+
+	items = &item;
+	num = zbx_dc_config_get_poller_items(ZBX_POLLER_TYPE_HTTPAGENT, config_comms->config_timeout, processing,
+			config_max_concurrent_checks_per_poller, &items);
+
+	if (0 == num)
+		goto out;
+
+	zbx_prepare_items(items, errcodes, num, results, MACRO_EXPAND_YES);
+	zbx_timespec(&timespec);
+
+	for (i = 0; i < num; i++)
+	{
+		if (SUCCEED != errcodes[i])
+		{
+			items[i].state = ITEM_STATE_NOTSUPPORTED;
+			zbx_preprocess_item_value(items[i].itemid, items[i].host.hostid, items[i].value_type,
+					items[i].flags, NULL, &timespec, items[i].state, results[i].msg);
+			itemids[failed] = items[i].itemid;
+			lastclocks[failed] = timespec.sec;
+			errcodes[failed++] = errcodes[i];
+
+			zbx_clean_items(&items[i], 1, &results[i]);
+			zbx_dc_config_clean_items(&items[i], NULL, 1);
+			continue;
+		}
+
+		zbx_free_agent_result(&results[i]);
+
+		/* the check takes over the item */
+		zbx_async_check_httpagent(httpagent, &items[i]);
+		started++;
+	}
+
+	if (0 != failed)
+	{
+		zbx_dc_poller_requeue_items(itemids, lastclocks, errcodes, (size_t)failed, ZBX_POLLER_TYPE_HTTPAGENT,
+				nextcheck);
+		zbx_preprocessor_flush();
+	}
+out:
+	*nextcheck = zbx_dc_config_get_poller_nextcheck(ZBX_POLLER_TYPE_HTTPAGENT);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%d", __func__, started);
+
+	return started;
+}
+#endif
+
+static void	async_poller_timer_cb(evutil_socket_t fd, short what, void *arg)
+{
+	ZBX_UNUSED(fd);
+	ZBX_UNUSED(what);
+	ZBX_UNUSED(arg);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: process events of asynchronous checks for up to sleeptime         *
+ *          seconds or until any check makes progress                         *
+ *                                                                            *
+ ******************************************************************************/
+static void	async_poller_wait(struct event_base *base, struct event *ev_timer, int sleeptime,
+		const zbx_thread_info_t *info)
+{
+	struct timeval	tv = {sleeptime, 0};
+
+	if (0 == sleeptime)
+	{
+		event_base_loop(base, EVLOOP_NONBLOCK);
+		return;
+	}
+
+	evtimer_add(ev_timer, &tv);
+
+	zbx_update_selfmon_counter(info, ZBX_PROCESS_STATE_IDLE);
+	event_base_loop(base, EVLOOP_ONCE);
+	zbx_update_selfmon_counter(info, ZBX_PROCESS_STATE_BUSY);
+
+	evtimer_del(ev_timer);
+}
+
 ZBX_THREAD_ENTRY(poller_thread, args)
 {
 	zbx_thread_poller_args	*poller_args_in = (zbx_thread_poller_args *)(((zbx_thread_args_t *)args)->args);
@@ -972,6 +1498,16 @@ ZBX_THREAD_ENTRY(poller_thread, args)
 	int			process_num = ((zbx_thread_args_t *)args)->info.process_num;
 	unsigned char		process_type = ((zbx_thread_args_t *)args)->info.process_type;
 	zbx_uint32_t		rtc_msgs[] = {ZBX_RTC_SNMP_CACHE_RELOAD};
+	struct event_base	*base = NULL;
+	struct event		*ev_timer = NULL;
+	zbx_vector_ptr_t	finished;
+	int			processing = 0;
+#ifdef HAVE_NETSNMP
+	int			snmp_cache_reload = 0;
+#endif
+#ifdef HAVE_LIBCURL
+	zbx_async_httpagent_t	httpagent;
+#endif
 
 #define	STAT_INTERVAL	5	/* if a process is busy and does not sleep then update status not faster than */
 				/* once in STAT_INTERVAL seconds */
@@ -984,6 +1520,13 @@ ZBX_THREAD_ENTRY(poller_thread, args)
 	zbx_update_selfmon_counter(info, ZBX_PROCESS_STATE_BUSY);
 
 	scriptitem_es_engine_init();
+	zbx_tcp_dns_cache_enable();
+#ifdef HAVE_UNIXODBC
+	odbc_pool_enable();
+#endif
+#if defined(HAVE_SSH2) || defined(HAVE_SSH)
+	ssh_session_cache_enable();
+#endif
 
 #if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
 	zbx_tls_init_child(poller_args_in->config_comms->config_tls,
@@ -996,6 +1539,36 @@ ZBX_THREAD_ENTRY(poller_thread, args)
 
 		zbx_db_connect(ZBX_DB_CONNECT_NORMAL);
 	}
+	if (ZBX_POLLER_TYPE_AGENT == poller_type || ZBX_POLLER_TYPE_HTTPAGENT == poller_type)
+	{
+		if (NULL == (base = event_base_new()))
+		{
+			zabbix_log(LOG_LEVEL_CRIT, "cannot initialize asynchronous checks");
+			exit(EXIT_FAILURE);
+		}
+
+		ev_timer = evtimer_new(base, async_poller_timer_cb, NULL);
+	}
+
+	if (ZBX_POLLER_TYPE_AGENT == poller_type || ZBX_POLLER_TYPE_SNMP == poller_type ||
+			ZBX_POLLER_TYPE_HTTPAGENT == poller_type)
+	{
+		zbx_vector_ptr_create(&finished);
+	}
+#ifdef HAVE_LIBCURL
+	if (ZBX_POLLER_TYPE_HTTPAGENT == poller_type)
+	{
+		char	*error = NULL;
+
+		if (SUCCEED != zbx_async_httpagent_init(&httpagent, base, &finished, &error))
+		{
+			zabbix_log(LOG_LEVEL_CRIT, "cannot initialize asynchronous HTTP agent checks: %s", error);
+			zbx_free(error);
+			exit(EXIT_FAILURE);
+		}
+	}
+#endif
+
 	zbx_setproctitle("%s #%d started", get_process_type_string(process_type), process_num);
 	last_stat_time = time(NULL);
 
@@ -1006,6 +1579,7 @@ ZBX_THREAD_ENTRY(poller_thread, args)
 	{
 		zbx_uint32_t	rtc_cmd;
 		unsigned char	*rtc_data;
+		int		rtc_timeout;
 
 		sec = zbx_time();
 		zbx_update_env(get_process_type_string(process_type), sec);
@@ -1017,13 +1591,97 @@ ZBX_THREAD_ENTRY(poller_thread, args)
 					old_total_sec);
 		}
 
-		processed += get_values(poller_type, &nextcheck, poller_args_in->config_comms,
-				poller_args_in->config_startup_time, poller_args_in->config_unavailable_delay,
-				poller_args_in->config_unreachable_period, poller_args_in->config_unreachable_delay);
+		if (ZBX_POLLER_TYPE_AGENT == poller_type)
+		{
+			int	num;
+
+			num = process_async_agent_results(&finished, &nextcheck,
+					poller_args_in->config_unavailable_delay,
+					poller_args_in->config_unreachable_period,
+					poller_args_in->config_unreachable_delay);
+			processing -= num;
+			processed += num;
+
+			processing += get_values_async(base, processing, &finished, &nextcheck,
+					poller_args_in->config_comms,
+					poller_args_in->config_max_concurrent_checks_per_poller);
+		}
+#ifdef HAVE_NETSNMP
+		else if (ZBX_POLLER_TYPE_SNMP == poller_type)
+		{
+			int	num;
+
+			num = process_async_snmp_results(&finished, &nextcheck,
+					poller_args_in->config_unavailable_delay,
+					poller_args_in->config_unreachable_period,
+					poller_args_in->config_unreachable_delay);
+			processing -= num;
+			processed += num;
+
+			/* SNMP library can be reinitialized only when there are no open sessions */
+			if (0 != snmp_cache_reload && 0 == processing)
+			{
+				zbx_clear_cache_snmp(process_type, process_num);
+				snmp_cache_reload = 0;
+			}
+
+			if (0 == snmp_cache_reload)
+			{
+				processing += get_values_async_snmp(processing, &finished, &nextcheck,
+						poller_args_in->config_comms,
+						poller_args_in->config_max_concurrent_checks_per_poller);
+			}
+			else
+				nextcheck = FAIL;	/* only wait for the running checks */
+		}
+#endif
+#ifdef HAVE_LIBCURL
+		else if (ZBX_POLLER_TYPE_HTTPAGENT == poller_type)
+		{
+			int	num;
+
+			num = process_async_httpagent_results(&finished, &nextcheck);
+			processing -= num;
+			processed += num;
+
+			processing += get_values_async_httpagent(&httpagent, processing, &nextcheck,
+					poller_args_in->config_comms,
+					poller_args_in->config_max_concurrent_checks_per_poller);
+		}
+#endif
+		else
+		{
+			int	num;
+
+			num = get_values(poller_type, &nextcheck, poller_args_in->config_comms,
+					poller_args_in->config_startup_time, poller_args_in->config_unavailable_delay,
+					poller_args_in->config_unreachable_period,
+					poller_args_in->config_unreachable_delay);
+			processed += num;
+
+			if (0 != num)
+				zbx_prof_probe_add(ZBX_PROF_PROBE_POLLER, zbx_time() - sec);
+#ifdef HAVE_UNIXODBC
+			odbc_pool_purge();
+#endif
+#if defined(HAVE_SSH2) || defined(HAVE_SSH)
+			ssh_session_cache_purge();
+#endif
+		}
 		total_sec += zbx_time() - sec;
 
 		sleeptime = zbx_calculate_sleeptime(nextcheck, POLLER_DELAY);
 
+		if (ZBX_POLLER_TYPE_AGENT == poller_type || ZBX_POLLER_TYPE_SNMP == poller_type ||
+				ZBX_POLLER_TYPE_HTTPAGENT == poller_type)
+		{
+			/* wait for running checks to free up slots instead of polling the queue */
+			if (0 != finished.values_num)
+				sleeptime = 0;
+			else if (processing >= poller_args_in->config_max_concurrent_checks_per_poller)
+				sleeptime = POLLER_DELAY;
+		}
+
 		if (0 != sleeptime || STAT_INTERVAL <= time(NULL) - last_stat_time)
 		{
 			if (0 == sleeptime)
@@ -1044,13 +1702,38 @@ ZBX_THREAD_ENTRY(poller_thread, args)
 			last_stat_time = time(NULL);
 		}
 
-		if (SUCCEED == zbx_rtc_wait(&rtc, info, &rtc_cmd, &rtc_data, sleeptime) && 0 != rtc_cmd)
+		if (ZBX_POLLER_TYPE_AGENT == poller_type || ZBX_POLLER_TYPE_HTTPAGENT == poller_type)
+		{
+			/* asynchronous checks are processed while waiting, RTC commands are checked afterwards */
+			async_poller_wait(base, ev_timer, sleeptime, info);
+			rtc_timeout = 0;
+		}
+#ifdef HAVE_NETSNMP
+		else if (ZBX_POLLER_TYPE_SNMP == poller_type)
+		{
+			if (0 != sleeptime)
+				zbx_update_selfmon_counter(info, ZBX_PROCESS_STATE_IDLE);
+
+			zbx_async_check_snmp_wait(sleeptime);
+
+			if (0 != sleeptime)
+				zbx_update_selfmon_counter(info, ZBX_PROCESS_STATE_BUSY);
+
+			rtc_timeout = 0;
+		}
+#endif
+		else
+			rtc_timeout = sleeptime;
+
+		if (SUCCEED == zbx_rtc_wait(&rtc, info, &rtc_cmd, &rtc_data, rtc_timeout) && 0 != rtc_cmd)
 		{
 #ifdef HAVE_NETSNMP
 			if (ZBX_RTC_SNMP_CACHE_RELOAD == rtc_cmd)
 			{
 				if (ZBX_POLLER_TYPE_NORMAL == poller_type || ZBX_POLLER_TYPE_UNREACHABLE == poller_type)
 					zbx_clear_cache_snmp(process_type, process_num);
+				else if (ZBX_POLLER_TYPE_SNMP == poller_type)
+					snmp_cache_reload = 1;
 			}
 #endif
 			if (ZBX_RTC_SHUTDOWN == rtc_cmd)
@@ -33,6 +33,7 @@ typedef struct
 	int			config_unavailable_delay;
 	int			config_unreachable_period;
 	int			config_unreachable_delay;
+	int			config_max_concurrent_checks_per_poller;
 }
 zbx_thread_poller_args;
 
@@ -248,18 +248,45 @@ static int	ssh_nonblocking_error(zbx_socket_t *s, LIBSSH2_SESSION *session, int
 	return SUCCEED;
 }
 
-/* example ssh.run["ls /"] */
-int	ssh_run(zbx_dc_item_t *item, AGENT_RESULT *result, const char *encoding, const char *options, int timeout)
+/* established SSH session that can be reused for following commands */
+struct zbx_ssh_session
 {
 	zbx_socket_t	s;
 	LIBSSH2_SESSION	*session;
-	LIBSSH2_CHANNEL	*channel;
-	int		auth_pw = 0, rc, ret = NOTSUPPORTED, exitcode;
-	char		tmp_buf[DATA_BUFFER_SIZE], *userauthlist, *publickey = NULL, *privatekey = NULL, *ssherr,
-			*output, *buffer = NULL, *err_msg = NULL;
-	size_t		offset = 0, buf_size = DATA_BUFFER_SIZE;
+};
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: close SSH session and free its resources                          *
+ *                                                                            *
+ ******************************************************************************/
+void	ssh_session_free(zbx_ssh_session_t *sess)
+{
+	libssh2_session_disconnect(sess->session, "Normal Shutdown");
+	zbx_tcp_close(&sess->s);
+	libssh2_session_free(sess->session);
+	zbx_free(sess);
+}
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+/******************************************************************************
+ *                                                                            *
+ * Purpose: connect to SSH server and authenticate                            *
+ *                                                                            *
+ * Parameters: item    - [IN] the item                                        *
+ *             result  - [OUT] error message on failure                       *
+ *             options - [IN] SSH options                                     *
+ *             timeout - [IN] the timeout                                     *
+ *                                                                            *
+ * Return value: the authenticated session or NULL on failure                 *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_ssh_session_t	*ssh_session_open(zbx_dc_item_t *item, AGENT_RESULT *result, const char *options,
+		int timeout)
+{
+	zbx_ssh_session_t	*sess = NULL;
+	LIBSSH2_SESSION		*session;
+	int			auth_pw = 0, rc, ret = NOTSUPPORTED;
+	char			*userauthlist, *publickey = NULL, *privatekey = NULL, *ssherr, *err_msg = NULL;
 
 	/* initializes an SSH session object */
 	if (NULL == (session = libssh2_session_init()))
@@ -271,14 +298,20 @@ int	ssh_run(zbx_dc_item_t *item, AGENT_RESULT *result, const char *encoding, con
 	if (SUCCEED != ssh_parse_options(session, options, &err_msg))
 	{
 		SET_MSG_RESULT(result, err_msg);
-		goto session_free;
+		libssh2_session_free(session);
+		goto ret_label;
 	}
 
-	if (FAIL == zbx_tcp_connect(&s, CONFIG_SOURCE_IP, item->interface.addr, item->interface.port, timeout,
+	sess = (zbx_ssh_session_t *)zbx_malloc(NULL, sizeof(zbx_ssh_session_t));
+	sess->session = session;
+
+	if (FAIL == zbx_tcp_connect(&sess->s, CONFIG_SOURCE_IP, item->interface.addr, item->interface.port, timeout,
 			ZBX_TCP_SEC_UNENCRYPTED, NULL, NULL))
 	{
 		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot connect to SSH server: %s", zbx_socket_strerror()));
-		goto session_free;
+		libssh2_session_free(session);
+		zbx_free(sess);
+		goto ret_label;
 	}
 
 	/* set blocking mode on session */
@@ -286,26 +319,29 @@ int	ssh_run(zbx_dc_item_t *item, AGENT_RESULT *result, const char *encoding, con
 
 	/* Create a session instance and start it up. This will trade welcome */
 	/* banners, exchange keys, and setup crypto, compression, and MAC layers */
-	while (0 != (rc = libssh2_session_startup(session, s.socket)))
+	while (0 != (rc = libssh2_session_startup(session, sess->s.socket)))
 	{
-		if (SUCCEED != ssh_nonblocking_error(&s, session, rc, &ssherr))
+		if (SUCCEED != ssh_nonblocking_error(&sess->s, session, rc, &ssherr))
 		{
 			SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot establish SSH session: %s", ssherr));
 			zbx_free(ssherr);
 
-			goto tcp_close;
+			zbx_tcp_close(&sess->s);
+			libssh2_session_free(session);
+			zbx_free(sess);
+			goto ret_label;
 		}
 	}
 
 	while (NULL == (userauthlist = libssh2_userauth_list(session, item->username, strlen(item->username))))
 	{
 		rc = libssh2_session_last_error(session, NULL, NULL, 0);
-		if (SUCCEED != ssh_nonblocking_error(&s, session, rc, &ssherr))
+		if (SUCCEED != ssh_nonblocking_error(&sess->s, session, rc, &ssherr))
 		{
 			SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot obtain authentication methods: %s", ssherr));
 			zbx_free(ssherr);
 
-			goto session_close;
+			goto out;
 		}
 	}
 
@@ -325,13 +361,13 @@ int	ssh_run(zbx_dc_item_t *item, AGENT_RESULT *result, const char *encoding, con
 			{
 				while (0 != (rc = libssh2_userauth_password(session, item->username, item->password)))
 				{
-					if (SUCCEED != ssh_nonblocking_error(&s, session, rc, &ssherr))
+					if (SUCCEED != ssh_nonblocking_error(&sess->s, session, rc, &ssherr))
 					{
 						SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Password authentication"
 								" failed: %s", ssherr));
 						zbx_free(ssherr);
 
-						goto session_close;
+						goto out;
 					}
 				}
 
@@ -345,13 +381,13 @@ int	ssh_run(zbx_dc_item_t *item, AGENT_RESULT *result, const char *encoding, con
 				while (0 != (rc = libssh2_userauth_keyboard_interactive(session, item->username,
 						&kbd_callback)))
 				{
-					if (SUCCEED != ssh_nonblocking_error(&s, session, rc, &ssherr))
+					if (SUCCEED != ssh_nonblocking_error(&sess->s, session, rc, &ssherr))
 					{
 						SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Keyboard-interactive "
 								"authentication failed: %s", ssherr));
 						zbx_free(ssherr);
 
-						goto session_close;
+						goto out;
 					}
 				}
 
@@ -362,7 +398,7 @@ int	ssh_run(zbx_dc_item_t *item, AGENT_RESULT *result, const char *encoding, con
 			{
 				SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Unsupported authentication method."
 						" Supported methods: %s", userauthlist));
-				goto session_close;
+				goto out;
 			}
 			break;
 		case ITEM_AUTHTYPE_PUBLICKEY:
@@ -372,7 +408,7 @@ int	ssh_run(zbx_dc_item_t *item, AGENT_RESULT *result, const char *encoding, con
 				{
 					SET_MSG_RESULT(result, zbx_strdup(NULL, "Authentication by public key failed."
 							" SSHKeyLocation option is not set"));
-					goto session_close;
+					goto out;
 				}
 
 				/* or by public key */
@@ -384,26 +420,26 @@ int	ssh_run(zbx_dc_item_t *item, AGENT_RESULT *result, const char *encoding, con
 				{
 					SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot access public key file %s",
 							publickey));
-					goto session_close;
+					goto out;
 				}
 
 				if (SUCCEED != zbx_is_regular_file(privatekey))
 				{
 					SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot access private key file %s",
 							privatekey));
-					goto session_close;
+					goto out;
 				}
 
 				while (0 != (rc = libssh2_userauth_publickey_fromfile(session, item->username,
 						publickey, privatekey, item->password)))
 				{
-					if (SUCCEED != ssh_nonblocking_error(&s, session, rc, &ssherr))
+					if (SUCCEED != ssh_nonblocking_error(&sess->s, session, rc, &ssherr))
 					{
 						SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Public key authentication "
 							"failed: %s", ssherr));
 						zbx_free(ssherr);
 
-						goto session_close;
+						goto out;
 					}
 				}
 
@@ -413,22 +449,75 @@ int	ssh_run(zbx_dc_item_t *item, AGENT_RESULT *result, const char *encoding, con
 			{
 				SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Unsupported authentication method."
 						" Supported methods: %s", userauthlist));
-				goto session_close;
+				goto out;
 			}
 			break;
 	}
 
+	ret = SUCCEED;
+out:
+	if (SUCCEED != ret)
+	{
+		ssh_session_free(sess);
+		sess = NULL;
+	}
+ret_label:
+	zbx_free(publickey);
+	zbx_free(privatekey);
+
+	return sess;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: execute command over a new channel of established session         *
+ *                                                                            *
+ * Parameters: sess     - [IN] the SSH session                                *
+ *             item     - [IN] the item                                       *
+ *             result   - [OUT] the command output or error message           *
+ *             encoding - [IN] the output encoding                            *
+ *             reused   - [IN] 1 if the session was used by earlier commands  *
+ *             state    - [OUT] ZBX_SSH_SESSION_OK - the session can be       *
+ *                                 reused,                                    *
+ *                              ZBX_SSH_SESSION_BROKEN - the session must be  *
+ *                                 closed,                                    *
+ *                              ZBX_SSH_SESSION_RETRY - channel of a reused   *
+ *                                 session could not be opened, the command   *
+ *                                 was not executed and result is not set     *
+ *                                                                            *
+ ******************************************************************************/
+static int	ssh_session_exec(zbx_ssh_session_t *sess, zbx_dc_item_t *item, AGENT_RESULT *result,
+		const char *encoding, int reused, int *state)
+{
+	LIBSSH2_SESSION	*session = sess->session;
+	LIBSSH2_CHANNEL	*channel;
+	int		rc, ret = NOTSUPPORTED, exitcode;
+	char		tmp_buf[DATA_BUFFER_SIZE], *ssherr, *output, *buffer = NULL;
+	size_t		offset = 0, buf_size = DATA_BUFFER_SIZE;
+
+	*state = ZBX_SSH_SESSION_BROKEN;
+
 	/* exec non-blocking on the remove host */
 	while (NULL == (channel = libssh2_channel_open_session(session)))
 	{
 		rc = libssh2_session_last_error(session, NULL, NULL, 0);
-		if (SUCCEED != ssh_nonblocking_error(&s, session, rc, &ssherr))
+		if (SUCCEED != ssh_nonblocking_error(&sess->s, session, rc, &ssherr))
 		{
+			if (0 != reused)
+			{
+				zabbix_log(LOG_LEVEL_DEBUG, "%s() cannot open channel of reused session: %s",
+						__func__, ssherr);
+				zbx_free(ssherr);
+				*state = ZBX_SSH_SESSION_RETRY;
+
+				return NOTSUPPORTED;
+			}
+
 			SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot establish generic session channel: %s",
 					ssherr));
 			zbx_free(ssherr);
 
-			goto session_close;
+			return NOTSUPPORTED;
 		}
 	}
 
@@ -436,7 +525,7 @@ int	ssh_run(zbx_dc_item_t *item, AGENT_RESULT *result, const char *encoding, con
 	/* request a shell on a channel and execute command */
 	while (0 != (rc = libssh2_channel_exec(channel, item->params)))
 	{
-		if (SUCCEED != ssh_nonblocking_error(&s, session, rc, &ssherr))
+		if (SUCCEED != ssh_nonblocking_error(&sess->s, session, rc, &ssherr))
 		{
 			SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot request a shell: %s", ssherr));
 			zbx_free(ssherr);
@@ -451,7 +540,7 @@ int	ssh_run(zbx_dc_item_t *item, AGENT_RESULT *result, const char *encoding, con
 	{
 		if (rc < 0)
 		{
-			if (SUCCEED != ssh_nonblocking_error(&s, session, rc, &ssherr))
+			if (SUCCEED != ssh_nonblocking_error(&sess->s, session, rc, &ssherr))
 			{
 				SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot read data from SSH server: %s",
 						ssherr));
@@ -488,7 +577,7 @@ channel_close:
 	exitcode = 127;
 	while (0 != (rc = libssh2_channel_close(channel)))
 	{
-		if (SUCCEED != ssh_nonblocking_error(&s, session, rc, &ssherr))
+		if (SUCCEED != ssh_nonblocking_error(&sess->s, session, rc, &ssherr))
 		{
 			zabbix_log(LOG_LEVEL_WARNING, "%s() cannot close generic session channel: %s", __func__,
 					ssherr);
@@ -501,26 +590,74 @@ channel_close:
 	zbx_free(buffer);
 
 	if (0 == rc)
+	{
 		exitcode = libssh2_channel_get_exit_status(channel);
 
+		/* channel was closed cleanly, the session can be used for following commands */
+		if (SYSINFO_RET_OK == ret)
+			*state = ZBX_SSH_SESSION_OK;
+	}
+
 	zabbix_log(LOG_LEVEL_DEBUG, "%s() exitcode:%d bytecount:" ZBX_FS_SIZE_T, __func__, exitcode, offset);
 
 	libssh2_channel_free(channel);
-	channel = NULL;
 
-session_close:
-	libssh2_session_disconnect(session, "Normal Shutdown");
+	return ret;
+}
 
-tcp_close:
-	zbx_tcp_close(&s);
+/******************************************************************************
+ *                                                                            *
+ * Purpose: execute command on SSH server                                     *
+ *                                                                            *
+ * Parameters: item     - [IN] the item                                       *
+ *             result   - [OUT] the command output or error message           *
+ *             encoding - [IN] the output encoding                            *
+ *             options  - [IN] SSH options                                    *
+ *             timeout  - [IN] the timeout                                    *
+ *             session  - [IN/OUT] the session to reuse, NULL or pointer to   *
+ *                                 NULL to open new session (optional).       *
+ *                                 Returns the session that can be reused or  *
+ *                                 NULL. When NULL is passed the session is   *
+ *                                 always closed.                             *
+ *                                                                            *
+ ******************************************************************************/
+int	ssh_run(zbx_dc_item_t *item, AGENT_RESULT *result, const char *encoding, const char *options, int timeout,
+		zbx_ssh_session_t **session)
+{
+	zbx_ssh_session_t	*sess;
+	int			ret, state;
 
-session_free:
-	libssh2_session_free(session);
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-ret_label:
-	zbx_free(publickey);
-	zbx_free(privatekey);
+	if (NULL != session && NULL != (sess = *session))
+	{
+		*session = NULL;
+		zbx_socket_set_deadline(&sess->s, timeout);
 
+		ret = ssh_session_exec(sess, item, result, encoding, 1, &state);
+
+		if (ZBX_SSH_SESSION_RETRY != state)
+			goto out;
+
+		ssh_session_free(sess);
+	}
+
+	if (NULL == (sess = ssh_session_open(item, result, options, timeout)))
+	{
+		ret = NOTSUPPORTED;
+		goto ret_label;
+	}
+
+	ret = ssh_session_exec(sess, item, result, encoding, 0, &state);
+out:
+	if (NULL != session && ZBX_SSH_SESSION_OK == state)
+	{
+		zbx_socket_set_deadline(&sess->s, 0);
+		*session = sess;
+	}
+	else
+		ssh_session_free(sess);
+ret_label:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
 	return ret;
@@ -192,19 +192,45 @@ static int	ssh_nonblocking_error(ssh_session session, int errcode, int errcode_a
 	return SUCCEED;
 }
 
-/* example ssh.run["ls /"] */
-int	ssh_run(zbx_dc_item_t *item, AGENT_RESULT *result, const char *encoding, const char *options, int timeout)
+/* established SSH session that can be reused for following commands */
+struct zbx_ssh_session
 {
 	ssh_session	session;
-	ssh_channel	channel;
-	ssh_key 	privkey = NULL, pubkey = NULL;
-	int		rc, userauth, ret = NOTSUPPORTED;
-	char		*output, *publickey = NULL, *privatekey = NULL, *buffer = NULL, *err_msg = NULL;
-	char		tmp_buf[DATA_BUFFER_SIZE], userauthlist[64];
-	size_t		offset = 0, buf_size = DATA_BUFFER_SIZE;
-	zbx_timespec_t	deadline;
+};
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: close SSH session and free its resources                          *
+ *                                                                            *
+ ******************************************************************************/
+void	ssh_session_free(zbx_ssh_session_t *sess)
+{
+	ssh_disconnect(sess->session);
+	ssh_free(sess->session);
+	zbx_free(sess);
+}
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+/******************************************************************************
+ *                                                                            *
+ * Purpose: connect to SSH server and authenticate                            *
+ *                                                                            *
+ * Parameters: item     - [IN] the item                                       *
+ *             result   - [OUT] error message on failure                      *
+ *             options  - [IN] SSH options                                    *
+ *             deadline - [IN] the operation deadline                         *
+ *                                                                            *
+ * Return value: the authenticated session or NULL on failure                 *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_ssh_session_t	*ssh_session_open(zbx_dc_item_t *item, AGENT_RESULT *result, const char *options,
+		zbx_timespec_t *deadline)
+{
+	zbx_ssh_session_t	*sess = NULL;
+	ssh_session		session;
+	ssh_key 		privkey = NULL, pubkey = NULL;
+	int			rc, userauth, ret = NOTSUPPORTED;
+	char			*publickey = NULL, *privatekey = NULL, *err_msg = NULL, userauthlist[64];
+	size_t			offset = 0;
 
 	/* initializes an SSH session object */
 	if (NULL == (session = ssh_new()))
@@ -215,8 +241,6 @@ int	ssh_run(zbx_dc_item_t *item, AGENT_RESULT *result, const char *encoding, con
 		goto close;
 	}
 
-	zbx_ts_get_deadline(&deadline, 0 == timeout ? SEC_PER_YEAR : timeout);
-
 	/* set blocking mode on session */
 	ssh_set_blocking(session, 0);
 
@@ -250,7 +274,7 @@ int	ssh_run(zbx_dc_item_t *item, AGENT_RESULT *result, const char *encoding, con
 
 	while (SSH_OK != (rc = ssh_connect(session)))
 	{
-		if (SUCCEED != ssh_nonblocking_error(session, rc, SSH_AGAIN, &deadline, &err_msg))
+		if (SUCCEED != ssh_nonblocking_error(session, rc, SSH_AGAIN, deadline, &err_msg))
 		{
 			SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot establish SSH session: %s", err_msg));
 			zbx_free(err_msg);
@@ -262,19 +286,19 @@ int	ssh_run(zbx_dc_item_t *item, AGENT_RESULT *result, const char *encoding, con
 	/* check which authentication methods are available */
 	while (SSH_AUTH_AGAIN == (rc = ssh_userauth_none(session, NULL)))
 	{
-		if (SUCCEED != ssh_nonblocking_error(session, rc, SSH_AUTH_AGAIN, &deadline, &err_msg))
+		if (SUCCEED != ssh_nonblocking_error(session, rc, SSH_AUTH_AGAIN, deadline, &err_msg))
 		{
 			SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Error during authentication: %s", err_msg));
 			zbx_free(err_msg);
 
-			goto session_close;
+			goto out;
 		}
 	}
 
 	if (rc == SSH_AUTH_ERROR)
 	{
 		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Error during authentication: %s", ssh_get_error(session)));
-		goto session_close;
+		goto out;
 	}
 
 	userauthlist[0] = '\0';
@@ -306,14 +330,14 @@ int	ssh_run(zbx_dc_item_t *item, AGENT_RESULT *result, const char *encoding, con
 				/* we could authenticate via password */
 				while (SSH_AUTH_SUCCESS != (rc = ssh_userauth_password(session, NULL, item->password)))
 				{
-					if (SUCCEED != ssh_nonblocking_error(session, rc, SSH_AUTH_AGAIN, &deadline,
+					if (SUCCEED != ssh_nonblocking_error(session, rc, SSH_AUTH_AGAIN, deadline,
 							&err_msg))
 					{
 						SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Password authentication "
 								"failed: %s", err_msg));
 						zbx_free(err_msg);
 
-						goto session_close;
+						goto out;
 					}
 				}
 
@@ -336,12 +360,12 @@ int	ssh_run(zbx_dc_item_t *item, AGENT_RESULT *result, const char *encoding, con
 							continue;
 					}
 
-					if (SUCCEED != ssh_nonblocking_error(session, rc, SSH_AUTH_AGAIN, &deadline,
+					if (SUCCEED != ssh_nonblocking_error(session, rc, SSH_AUTH_AGAIN, deadline,
 										&err_msg))
 					{
 						SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Keyboard-interactive "
 								"authentication failed: %s", err_msg));
-						goto session_close;
+						goto out;
 					}
 
 				}
@@ -353,7 +377,7 @@ int	ssh_run(zbx_dc_item_t *item, AGENT_RESULT *result, const char *encoding, con
 			{
 				SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Unsupported authentication method."
 						" Supported methods: %s", userauthlist));
-				goto session_close;
+				goto out;
 			}
 			break;
 		case ITEM_AUTHTYPE_PUBLICKEY:
@@ -363,7 +387,7 @@ int	ssh_run(zbx_dc_item_t *item, AGENT_RESULT *result, const char *encoding, con
 				{
 					SET_MSG_RESULT(result, zbx_strdup(NULL, "Authentication by public key failed."
 							" SSHKeyLocation option is not set"));
-					goto session_close;
+					goto out;
 				}
 
 				/* or by public key */
@@ -375,33 +399,33 @@ int	ssh_run(zbx_dc_item_t *item, AGENT_RESULT *result, const char *encoding, con
 				{
 					SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot access public key file %s",
 							publickey));
-					goto session_close;
+					goto out;
 				}
 
 				if (SUCCEED != zbx_is_regular_file(privatekey))
 				{
 					SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot access private key file %s",
 							privatekey));
-					goto session_close;
+					goto out;
 				}
 
 				if (SSH_OK != ssh_pki_import_pubkey_file(publickey, &pubkey))
 				{
 					SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Failed to import public key: %s",
 							ssh_get_error(session)));
-					goto session_close;
+					goto out;
 				}
 
 				while (SSH_AUTH_SUCCESS != (rc = ssh_userauth_try_publickey(session, NULL, pubkey)))
 				{
-					if (SUCCEED != ssh_nonblocking_error(session, rc, SSH_AUTH_AGAIN, &deadline,
+					if (SUCCEED != ssh_nonblocking_error(session, rc, SSH_AUTH_AGAIN, deadline,
 										&err_msg))
 					{
 						SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Public key try failed: %s",
 								err_msg));
 						zbx_free(err_msg);
 
-						goto session_close;
+						goto out;
 					}
 				}
 
@@ -413,7 +437,7 @@ int	ssh_run(zbx_dc_item_t *item, AGENT_RESULT *result, const char *encoding, con
 						SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot import private key"
 								" file \"%s\" because it does not exist or permission"
 								" denied", privatekey));
-						goto session_close;
+						goto out;
 					}
 
 					SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot import private key \"%s\"",
@@ -422,19 +446,19 @@ int	ssh_run(zbx_dc_item_t *item, AGENT_RESULT *result, const char *encoding, con
 					zabbix_log(LOG_LEVEL_DEBUG, "%s() failed to import private key \"%s\", rc:%d",
 							__func__, privatekey, rc);
 
-					goto session_close;
+					goto out;
 				}
 
 				while (SSH_AUTH_SUCCESS != (rc = ssh_userauth_publickey(session, NULL, privkey)))
 				{
-					if (SUCCEED != ssh_nonblocking_error(session, rc, SSH_AUTH_AGAIN, &deadline,
+					if (SUCCEED != ssh_nonblocking_error(session, rc, SSH_AUTH_AGAIN, deadline,
 										&err_msg))
 					{
 						SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Public key authentication "
 								"failed: %s", err_msg));
 						zbx_free(err_msg);
 
-						goto session_close;
+						goto out;
 					}
 				}
 
@@ -444,23 +468,91 @@ int	ssh_run(zbx_dc_item_t *item, AGENT_RESULT *result, const char *encoding, con
 			{
 				SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Unsupported authentication method."
 						" Supported methods: %s", userauthlist));
-				goto session_close;
+				goto out;
 			}
 			break;
 	}
 
+	ret = SUCCEED;
+out:
+	if (NULL != privkey)
+		ssh_key_free(privkey);
+	if (NULL != pubkey)
+		ssh_key_free(pubkey);
+
+	if (SUCCEED == ret)
+	{
+		sess = (zbx_ssh_session_t *)zbx_malloc(NULL, sizeof(zbx_ssh_session_t));
+		sess->session = session;
+		goto close;
+	}
+
+	ssh_disconnect(session);
+session_free:
+	ssh_free(session);
+close:
+	zbx_free(publickey);
+	zbx_free(privatekey);
+
+	return sess;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: execute command over a new channel of established session         *
+ *                                                                            *
+ * Parameters: sess     - [IN] the SSH session                                *
+ *             item     - [IN] the item                                       *
+ *             result   - [OUT] the command output or error message           *
+ *             encoding - [IN] the output encoding                            *
+ *             deadline - [IN] the operation deadline                         *
+ *             reused   - [IN] 1 if the session was used by earlier commands  *
+ *             state    - [OUT] ZBX_SSH_SESSION_OK - the session can be       *
+ *                                 reused,                                    *
+ *                              ZBX_SSH_SESSION_BROKEN - the session must be  *
+ *                                 closed,                                    *
+ *                              ZBX_SSH_SESSION_RETRY - channel of a reused   *
+ *                                 session could not be opened, the command   *
+ *                                 was not executed and result is not set     *
+ *                                                                            *
+ ******************************************************************************/
+static int	ssh_session_exec(zbx_ssh_session_t *sess, zbx_dc_item_t *item, AGENT_RESULT *result,
+		const char *encoding, zbx_timespec_t *deadline, int reused, int *state)
+{
+	ssh_session	session = sess->session;
+	ssh_channel	channel;
+	int		rc, ret = NOTSUPPORTED;
+	char		*output, *buffer = NULL, *err_msg = NULL, tmp_buf[DATA_BUFFER_SIZE];
+	size_t		offset = 0, buf_size = DATA_BUFFER_SIZE;
+
+	*state = ZBX_SSH_SESSION_BROKEN;
+
 	if (NULL == (channel = ssh_channel_new(session)))
 	{
-		SET_MSG_RESULT(result, zbx_strdup(NULL, "Cannot create generic session channel"));
-		goto session_close;
+		if (0 != reused)
+			*state = ZBX_SSH_SESSION_RETRY;
+		else
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Cannot create generic session channel"));
+
+		return NOTSUPPORTED;
 	}
 
 	while (SSH_OK != (rc = ssh_channel_open_session(channel)))
 	{
-		if (SUCCEED != ssh_nonblocking_error(session, rc, SSH_AGAIN, &deadline, &err_msg))
+		if (SUCCEED != ssh_nonblocking_error(session, rc, SSH_AGAIN, deadline, &err_msg))
 		{
-			SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot establish generic session channel: %s",
-					err_msg));
+			if (0 != reused)
+			{
+				zabbix_log(LOG_LEVEL_DEBUG, "%s() cannot open channel of reused session: %s",
+						__func__, err_msg);
+				*state = ZBX_SSH_SESSION_RETRY;
+			}
+			else
+			{
+				SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot establish generic session channel:"
+						" %s", err_msg));
+			}
+
 			zbx_free(err_msg);
 			goto channel_free;
 		}
@@ -471,7 +563,7 @@ int	ssh_run(zbx_dc_item_t *item, AGENT_RESULT *result, const char *encoding, con
 
 	while (SSH_OK != (rc = ssh_channel_request_exec(channel, item->params)))
 	{
-		if (SUCCEED != ssh_nonblocking_error(session, rc, SSH_AGAIN, &deadline, &err_msg))
+		if (SUCCEED != ssh_nonblocking_error(session, rc, SSH_AGAIN, deadline, &err_msg))
 		{
 			SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot request a shell: %s", err_msg));
 			zbx_free(err_msg);
@@ -481,7 +573,6 @@ int	ssh_run(zbx_dc_item_t *item, AGENT_RESULT *result, const char *encoding, con
 	}
 
 	buffer = (char *)zbx_malloc(buffer, buf_size);
-	offset = 0;
 
 	while (SSH_EOF != (rc = ssh_channel_read_nonblocking(channel, tmp_buf, sizeof(tmp_buf), 0)))
 	{
@@ -490,7 +581,7 @@ int	ssh_run(zbx_dc_item_t *item, AGENT_RESULT *result, const char *encoding, con
 
 		if (0 > rc)
 		{
-			if (SUCCEED != ssh_nonblocking_error(session, rc, SSH_AGAIN, &deadline, &err_msg))
+			if (SUCCEED != ssh_nonblocking_error(session, rc, SSH_AGAIN, deadline, &err_msg))
 			{
 				SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot read data from SSH server: %s",
 						err_msg));
@@ -524,24 +615,70 @@ int	ssh_run(zbx_dc_item_t *item, AGENT_RESULT *result, const char *encoding, con
 
 	ret = SYSINFO_RET_OK;
 channel_close:
-	ssh_channel_close(channel);
+	/* channel was closed cleanly, the session can be used for following commands */
+	if (SSH_OK == ssh_channel_close(channel) && SYSINFO_RET_OK == ret)
+		*state = ZBX_SSH_SESSION_OK;
+
 	zbx_free(buffer);
 channel_free:
 	ssh_channel_free(channel);
-session_close:
-	if (NULL != privkey)
-		ssh_key_free(privkey);
-	if (NULL != pubkey)
-		ssh_key_free(pubkey);
-	ssh_disconnect(session);
-session_free:
-	ssh_free(session);
-close:
-	zbx_free(publickey);
-	zbx_free(privatekey);
 
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: execute command on SSH server                                     *
+ *                                                                            *
+ * Parameters: item     - [IN] the item                                       *
+ *             result   - [OUT] the command output or error message           *
+ *             encoding - [IN] the output encoding                            *
+ *             options  - [IN] SSH options                                    *
+ *             timeout  - [IN] the timeout                                    *
+ *             session  - [IN/OUT] the session to reuse, NULL or pointer to   *
+ *                                 NULL to open new session (optional).       *
+ *                                 Returns the session that can be reused or  *
+ *                                 NULL. When NULL is passed the session is   *
+ *                                 always closed.                             *
+ *                                                                            *
+ ******************************************************************************/
+int	ssh_run(zbx_dc_item_t *item, AGENT_RESULT *result, const char *encoding, const char *options, int timeout,
+		zbx_ssh_session_t **session)
+{
+	zbx_ssh_session_t	*sess;
+	int			ret, state;
+	zbx_timespec_t		deadline;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	zbx_ts_get_deadline(&deadline, 0 == timeout ? SEC_PER_YEAR : timeout);
+
+	if (NULL != session && NULL != (sess = *session))
+	{
+		*session = NULL;
+
+		ret = ssh_session_exec(sess, item, result, encoding, &deadline, 1, &state);
+
+		if (ZBX_SSH_SESSION_RETRY != state)
+			goto out;
+
+		ssh_session_free(sess);
+	}
+
+	if (NULL == (sess = ssh_session_open(item, result, options, &deadline)))
+	{
+		ret = NOTSUPPORTED;
+		goto ret_label;
+	}
+
+	ret = ssh_session_exec(sess, item, result, encoding, &deadline, 0, &state);
+out:
+	if (NULL != session && ZBX_SSH_SESSION_OK == state)
+		*session = sess;
+	else
+		ssh_session_free(sess);
+ret_label:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
 	return ret;
 }
-
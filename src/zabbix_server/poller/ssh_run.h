@@ -31,7 +31,15 @@
 #define KEY_CIPHERS_STR		"Ciphers"
 #define KEY_MACS_STR		"MACs"
 
-int	ssh_run(zbx_dc_item_t *item, AGENT_RESULT *result, const char *encoding, const char *options, int timeout);
+#define ZBX_SSH_SESSION_OK	0
+#define ZBX_SSH_SESSION_BROKEN	1
+#define ZBX_SSH_SESSION_RETRY	2
+
+typedef struct zbx_ssh_session	zbx_ssh_session_t;
+
+int	ssh_run(zbx_dc_item_t *item, AGENT_RESULT *result, const char *encoding, const char *options, int timeout,
+		zbx_ssh_session_t **session);
+void	ssh_session_free(zbx_ssh_session_t *sess);
 #endif	/* defined(HAVE_SSH2) || defined(HAVE_SSH)*/
 
 #endif
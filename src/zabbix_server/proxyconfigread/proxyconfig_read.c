@@ -38,6 +38,17 @@ typedef struct
 }
 zbx_keys_path_t;
 
+/* serialized data of tables shared by all proxies, valid for the revision it was read at */
+typedef struct
+{
+	zbx_uint64_t	revision;
+	char		*data;
+}
+zbx_proxyconfig_cache_t;
+
+static zbx_proxyconfig_cache_t	expression_cache, config_cache, autoreg_tls_cache;
+
+typedef int	(*zbx_proxyconfig_get_data_f)(struct zbx_json *j, char **error);
 
 static int	keys_path_compare(const void *d1, const void *d2)
 {
@@ -76,26 +87,37 @@ static void	key_path_free(void *data)
 static void	get_macro_secrets(const zbx_vector_ptr_t *keys_paths, struct zbx_json *j,
 		const zbx_config_vault_t *config_vault)
 {
-	int		i;
-	zbx_kvs_t	kvs;
+	int			i;
+	zbx_vault_kvs_request_t	*requests;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	zbx_kvs_create(&kvs, 100);
+	requests = (zbx_vault_kvs_request_t *)zbx_malloc(NULL, sizeof(zbx_vault_kvs_request_t) *
+			(size_t)keys_paths->values_num);
+
+	for (i = 0; i < keys_paths->values_num; i++)
+	{
+		requests[i].path = ((zbx_keys_path_t *)keys_paths->values[i])->path;
+		zbx_kvs_create(&requests[i].kvs, 10);
+	}
+
+	zbx_vault_kvs_get_multi(requests, keys_paths->values_num, config_vault);
 
 	zbx_json_addobject(j, ZBX_PROTO_TAG_MACRO_SECRETS);
 
 	for (i = 0; i < keys_paths->values_num; i++)
 	{
 		zbx_keys_path_t		*keys_path;
-		char			*error = NULL, **ptr;
+		char			**ptr;
 		zbx_hashset_iter_t	iter;
 
 		keys_path = (zbx_keys_path_t *)keys_paths->values[i];
-		if (FAIL == zbx_vault_kvs_get(keys_path->path, &kvs, config_vault, &error))
+		if (FAIL == requests[i].ret)
 		{
-			zabbix_log(LOG_LEVEL_WARNING, "cannot get secrets for path \"%s\": %s", keys_path->path, error);
-			zbx_free(error);
+			zabbix_log(LOG_LEVEL_WARNING, "cannot get secrets for path \"%s\": %s", keys_path->path,
+					requests[i].error);
+			zbx_free(requests[i].error);
+			zbx_kvs_destroy(&requests[i].kvs);
 			continue;
 		}
 
@@ -108,16 +130,16 @@ static void	get_macro_secrets(const zbx_vector_ptr_t *keys_paths, struct zbx_jso
 
 			kv_local.key = *ptr;
 
-			if (NULL != (kv = zbx_kvs_search(&kvs, &kv_local)))
+			if (NULL != (kv = zbx_kvs_search(&requests[i].kvs, &kv_local)))
 				zbx_json_addstring(j, kv->key, kv->value, ZBX_JSON_TYPE_STRING);
 		}
 		zbx_json_close(j);
 
-		zbx_kvs_clear(&kvs);
+		zbx_kvs_destroy(&requests[i].kvs);
 	}
 
 	zbx_json_close(j);
-	zbx_kvs_destroy(&kvs);
+	zbx_free(requests);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
@@ -833,6 +855,72 @@ out:
 	return ret;
 }
 
+static int	proxyconfig_get_config_data(struct zbx_json *j, char **error)
+{
+	return proxyconfig_get_table_data("config", NULL, NULL, NULL, NULL, j, error);
+}
+
+static int	proxyconfig_get_autoreg_tls_data(struct zbx_json *j, char **error)
+{
+	return proxyconfig_get_table_data("config_autoreg_tls", NULL, NULL, NULL, NULL, j, error);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: add data of tables shared by all proxies, reusing data serialized *
+ *          for other proxies at the same revision                            *
+ *                                                                            *
+ * Parameters: cache    - [IN/OUT] the serialized table data cache            *
+ *             revision - [IN] the current revision of cached tables          *
+ *             get_data - [IN] the callback to read table data from database  *
+ *             j        - [OUT] the output json                               *
+ *             error    - [OUT] the error message                             *
+ *                                                                            *
+ * Return value: SUCCEED - the data was added successfully                    *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: When many proxies are synchronized (for example all proxies      *
+ *           requesting full sync after server restart) the shared tables are *
+ *           read and serialized only once per revision.                      *
+ *                                                                            *
+ ******************************************************************************/
+static int	proxyconfig_add_cached_data(zbx_proxyconfig_cache_t *cache, zbx_uint64_t revision,
+		zbx_proxyconfig_get_data_f get_data, struct zbx_json *j, char **error)
+{
+	if (NULL == cache->data || cache->revision != revision)
+	{
+		struct zbx_json	j_tables;
+		size_t		len;
+
+		zbx_json_init(&j_tables, ZBX_JSON_STAT_BUF_LEN);
+
+		if (SUCCEED != get_data(&j_tables, error))
+		{
+			zbx_json_free(&j_tables);
+			return FAIL;
+		}
+
+		/* cache table objects without the enclosing braces */
+		len = j_tables.buffer_size - 2;
+		cache->data = (char *)zbx_realloc(cache->data, len + 1);
+		memcpy(cache->data, j_tables.buffer + 1, len);
+		cache->data[len] = '\0';
+		cache->revision = revision;
+
+		zbx_json_free(&j_tables);
+	}
+	else
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "%s() reusing serialized data of revision " ZBX_FS_UI64, __func__,
+				revision);
+	}
+
+	if ('\0' != *cache->data)
+		zbx_json_addraw(j, NULL, cache->data);
+
+	return SUCCEED;
+}
+
 static int	proxyconfig_get_tables(const zbx_dc_proxy_t *proxy, zbx_uint64_t proxy_config_revision,
 		const zbx_dc_revision_t *dc_revision, struct zbx_json *j, zbx_proxyconfig_status_t *status,
 		const zbx_config_vault_t *config_vault, char **error)
@@ -950,14 +1038,16 @@ static int	proxyconfig_get_tables(const zbx_dc_proxy_t *proxy, zbx_uint64_t prox
 			goto out;
 		}
 
-		if (0 != (flags & ZBX_PROXYCONFIG_SYNC_EXPRESSIONS) &&
-				SUCCEED != proxyconfig_get_expression_data(j, error))
+		if (0 != (flags & ZBX_PROXYCONFIG_SYNC_EXPRESSIONS) && SUCCEED !=
+				proxyconfig_add_cached_data(&expression_cache, dc_revision->expression,
+				proxyconfig_get_expression_data, j, error))
 		{
 			goto out;
 		}
 
-		if (0 != (flags & ZBX_PROXYCONFIG_SYNC_CONFIG) &&
-				SUCCEED != proxyconfig_get_table_data("config", NULL, NULL, NULL, NULL, j, error))
+		if (0 != (flags & ZBX_PROXYCONFIG_SYNC_CONFIG) && SUCCEED !=
+				proxyconfig_add_cached_data(&config_cache, dc_revision->config_table,
+				proxyconfig_get_config_data, j, error))
 		{
 			goto out;
 		}
@@ -968,9 +1058,9 @@ static int	proxyconfig_get_tables(const zbx_dc_proxy_t *proxy, zbx_uint64_t prox
 			goto out;
 		}
 
-		if (0 != (flags & ZBX_PROXYCONFIG_SYNC_AUTOREG) &&
-				SUCCEED != proxyconfig_get_table_data("config_autoreg_tls", NULL, NULL, NULL, NULL, j,
-						error))
+		if (0 != (flags & ZBX_PROXYCONFIG_SYNC_AUTOREG) && SUCCEED !=
+				proxyconfig_add_cached_data(&autoreg_tls_cache, dc_revision->autoreg_tls,
+				proxyconfig_get_autoreg_tls_data, j, error))
 		{
 			goto out;
 		}
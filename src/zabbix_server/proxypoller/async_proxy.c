@@ -0,0 +1,841 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "async_proxy.h"
+#include "proxypoller.h"
+
+#include "proxyconfigread/proxyconfig_read.h"
+#include "../trapper/proxydata.h"
+
+#include "log.h"
+#include "zbxserver.h"
+#include "zbxdbwrap.h"
+#include "zbxcachehistory.h"
+#include "zbxnix.h"
+#include "zbxcompress.h"
+#include "zbxcommshigh.h"
+#include "zbxnum.h"
+#include "zbxtime.h"
+#include "zbxversion.h"
+#include "zbx_host_constants.h"
+
+#define ZBX_PROXY_EXCHANGE_CONFIG	0
+#define ZBX_PROXY_EXCHANGE_DATA		1
+#define ZBX_PROXY_EXCHANGE_TASKS	2
+
+/* data and tasks exchanges use CONNECT -> TLS -> SEND -> RECV steps, configuration exchange */
+/* continues with SEND_CONFIG -> RECV_RESPONSE steps over the same connection                */
+#define ZBX_PROXY_STEP_CONNECT		0
+#define ZBX_PROXY_STEP_TLS		1
+#define ZBX_PROXY_STEP_SEND		2
+#define ZBX_PROXY_STEP_RECV		3
+#define ZBX_PROXY_STEP_SEND_CONFIG	4
+#define ZBX_PROXY_STEP_RECV_RESPONSE	5
+
+static const char	*proxy_exchange_string(unsigned char exchange)
+{
+	switch (exchange)
+	{
+		case ZBX_PROXY_EXCHANGE_CONFIG:
+			return "configuration";
+		case ZBX_PROXY_EXCHANGE_DATA:
+			return "data";
+		default:
+			return "tasks";
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: close connection of the current exchange                          *
+ *                                                                            *
+ ******************************************************************************/
+static void	proxy_context_disconnect(zbx_proxy_context_t *proxy_context)
+{
+	/* events are created only after connection is started */
+	if (NULL != proxy_context->ev)
+	{
+		event_free(proxy_context->ev);
+		event_free(proxy_context->ev_timeout);
+		proxy_context->ev = NULL;
+		proxy_context->ev_timeout = NULL;
+
+		zbx_tcp_close(&proxy_context->s);
+	}
+
+	zbx_tcp_send_context_clear(&proxy_context->send_context);
+}
+
+static void	proxy_context_finish(zbx_proxy_context_t *proxy_context, int ret)
+{
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() proxy:'%s' exchanges:%d ret:%s", __func__, proxy_context->proxy.host,
+			proxy_context->exchanges, zbx_result_string(ret));
+
+	proxy_context_disconnect(proxy_context);
+
+	proxy_context->ret = ret;
+	proxy_context->latency = zbx_time() - proxy_context->time_start;
+
+	zbx_vector_ptr_append(proxy_context->finished, proxy_context);
+}
+
+static void	proxy_exchange_event_cb(evutil_socket_t fd, short what, void *arg);
+static void	proxy_exchange_timeout_cb(evutil_socket_t fd, short what, void *arg);
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: wait for socket to become ready for the next exchange step        *
+ *                                                                            *
+ * Parameters: proxy_context - [IN/OUT] proxy session context                 *
+ *             event         - [IN] POLLIN or POLLOUT                         *
+ *                                                                            *
+ ******************************************************************************/
+static void	proxy_context_wait(zbx_proxy_context_t *proxy_context, short event)
+{
+	event_assign(proxy_context->ev, proxy_context->base, proxy_context->s.socket,
+			0 != (event & POLLIN) ? EV_READ : EV_WRITE, proxy_exchange_event_cb, proxy_context);
+	event_add(proxy_context->ev, NULL);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: start exchange with proxy without waiting for its result          *
+ *                                                                            *
+ * Parameters: proxy_context - [IN/OUT] proxy session context                 *
+ *             exchange      - [IN] ZBX_PROXY_EXCHANGE_* exchange to start    *
+ *                                                                            *
+ ******************************************************************************/
+static void	proxy_exchange_start(zbx_proxy_context_t *proxy_context, unsigned char exchange)
+{
+	struct timeval	tv = {CONFIG_TRAPPER_TIMEOUT, 0};
+	zbx_dc_proxy_t	*proxy = &proxy_context->proxy;
+	struct zbx_json	*j = &proxy_context->j;
+	unsigned char	flags = ZBX_TCP_PROTOCOL;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() proxy:'%s' address:%s port:%hu exchange:%s", __func__, proxy->host,
+			proxy->addr, proxy->port, proxy_exchange_string(exchange));
+
+	proxy_context->exchange = exchange;
+	proxy_context->step = ZBX_PROXY_STEP_CONNECT;
+	proxy_context->exchanges++;
+
+	zbx_json_clean(j);
+
+	if (ZBX_PROXY_EXCHANGE_CONFIG == exchange)
+	{
+		zbx_json_addstring(j, ZBX_PROTO_TAG_REQUEST, ZBX_PROTO_VALUE_PROXY_CONFIG, ZBX_JSON_TYPE_STRING);
+	}
+	else if (ZBX_PROXY_EXCHANGE_DATA == exchange)
+	{
+		zbx_json_addstring(j, ZBX_PROTO_TAG_REQUEST, ZBX_PROTO_VALUE_PROXY_DATA, ZBX_JSON_TYPE_STRING);
+		zbx_json_addstring(j, ZBX_PROTO_TAG_HISTORY_FORMAT, ZBX_PROTO_VALUE_HISTORY_FORMAT_BINARY,
+				ZBX_JSON_TYPE_STRING);
+
+		if ('\0' != *zbx_compress_codecs())
+			zbx_json_addstring(j, ZBX_PROTO_TAG_COMPRESSION, zbx_compress_codecs(), ZBX_JSON_TYPE_STRING);
+	}
+	else
+		zbx_json_addstring(j, ZBX_PROTO_TAG_REQUEST, ZBX_PROTO_VALUE_PROXY_TASKS, ZBX_JSON_TYPE_STRING);
+
+	if (ZBX_PROXY_EXCHANGE_CONFIG != exchange && 0 != proxy->auto_compress)
+		flags |= ZBX_TCP_COMPRESS;
+
+	if (SUCCEED != zbx_tcp_send_context_init(j->buffer, j->buffer_size, 0, flags, &proxy_context->send_context))
+	{
+		zabbix_log(LOG_LEVEL_ERR, "cannot send data to proxy \"%s\": %s", proxy->host, zbx_socket_strerror());
+		proxy_context_finish(proxy_context, FAIL);
+		goto out;
+	}
+
+	if (SUCCEED != zbx_tcp_connect_start(&proxy_context->s, CONFIG_SOURCE_IP, proxy->addr, proxy->port,
+			CONFIG_TRAPPER_TIMEOUT))
+	{
+		zabbix_log(LOG_LEVEL_ERR, "cannot connect to proxy \"%s\": %s", proxy->host, zbx_socket_strerror());
+		proxy_context_finish(proxy_context, NETWORK_ERROR);
+		goto out;
+	}
+
+	proxy_context->ev = event_new(proxy_context->base, proxy_context->s.socket, EV_WRITE, proxy_exchange_event_cb,
+			proxy_context);
+	proxy_context->ev_timeout = evtimer_new(proxy_context->base, proxy_exchange_timeout_cb, proxy_context);
+
+	event_add(proxy_context->ev, NULL);
+	evtimer_add(proxy_context->ev_timeout, &tv);
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: start the next due exchange or finish the proxy session           *
+ *                                                                            *
+ * Comments: Exchanges are performed in the same order as before: the         *
+ *           configuration is pushed first, then data is pulled while the     *
+ *           proxy reports more data and history cache accepts it, then tasks *
+ *           are exchanged if no data exchange has taken place.               *
+ *                                                                            *
+ ******************************************************************************/
+static void	proxy_context_next(zbx_proxy_context_t *proxy_context)
+{
+	if (0 != proxy_context->config_pending)
+	{
+		proxy_context->config_pending = 0;
+		proxy_exchange_start(proxy_context, ZBX_PROXY_EXCHANGE_CONFIG);
+		return;
+	}
+
+	if (0 != proxy_context->data_pending)
+	{
+		if (SUCCEED == zbx_hc_check_proxy(proxy_context->proxy.hostid))
+		{
+			proxy_exchange_start(proxy_context, ZBX_PROXY_EXCHANGE_DATA);
+			return;
+		}
+
+		proxy_context->data_pending = 0;
+	}
+
+	if (0 != proxy_context->tasks_pending)
+	{
+		proxy_context->tasks_pending = 0;
+		proxy_exchange_start(proxy_context, ZBX_PROXY_EXCHANGE_TASKS);
+		return;
+	}
+
+	proxy_context_finish(proxy_context, proxy_context->ret);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: complete the current exchange and continue proxy session          *
+ *                                                                            *
+ ******************************************************************************/
+static void	proxy_exchange_finish(zbx_proxy_context_t *proxy_context, int ret)
+{
+	proxy_context_disconnect(proxy_context);
+
+	if (SUCCEED != ret)
+	{
+		proxy_context_finish(proxy_context, ret);
+		return;
+	}
+
+	proxy_context->ret = ret;
+	proxy_context_next(proxy_context);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: processes proxy data request                                      *
+ *                                                                            *
+ * Parameters: proxy               - [IN/OUT] proxy data                      *
+ *             answer              - [IN] data received from proxy            *
+ *             ts                  - [IN] timestamp when the proxy connection *
+ *                                        was established                     *
+ *             events_cbs          - [IN]                                     *
+ *             proxydata_frequency - [IN]                                     *
+ *             more                - [OUT] available data flag                *
+ *                                                                            *
+ * Return value: SUCCEED - data were received and processed successfully      *
+ *               FAIL - otherwise                                             *
+ *                                                                            *
+ * Comments: The proxy->version property is updated with the version number   *
+ *           sent by proxy.                                                   *
+ *                                                                            *
+ ******************************************************************************/
+static int	proxy_process_proxy_data(zbx_dc_proxy_t *proxy, const char *answer, zbx_timespec_t *ts,
+		const zbx_events_funcs_t *events_cbs, int proxydata_frequency, int *more)
+{
+	struct zbx_json_parse	jp;
+	char			*error = NULL, *version_str = NULL;
+	int			version_int, ret = FAIL;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	*more = ZBX_PROXY_DATA_DONE;
+
+	if ('\0' == *answer)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "proxy \"%s\" at \"%s\" returned no proxy data:"
+				" check allowed connection types and access rights", proxy->host, proxy->addr);
+		goto out;
+	}
+
+	if (SUCCEED != zbx_json_open(answer, &jp))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "proxy \"%s\" at \"%s\" returned invalid proxy data: %s",
+				proxy->host, proxy->addr, zbx_json_strerror());
+		goto out;
+	}
+
+	version_str = zbx_get_proxy_protocol_version_str(&jp);
+	version_int = zbx_get_proxy_protocol_version_int(version_str);
+
+	zbx_strlcpy(proxy->version_str, version_str, sizeof(proxy->version_str));
+	proxy->version_int = version_int;
+
+	if (SUCCEED != zbx_check_protocol_version(proxy, version_int))
+	{
+		goto out;
+	}
+
+	if (SUCCEED != (ret = zbx_process_proxy_data(proxy, &jp, ts, HOST_STATUS_PROXY_PASSIVE, events_cbs,
+			proxydata_frequency, more, &error)))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "proxy \"%s\" at \"%s\" returned invalid proxy data: %s",
+				proxy->host, proxy->addr, error);
+	}
+
+out:
+	zbx_free(error);
+	zbx_free(version_str);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: acknowledge and process 'proxy data' or 'proxy tasks' answer      *
+ *                                                                            *
+ * Parameters: proxy_context - [IN/OUT] proxy session context                 *
+ *                                                                            *
+ * Return value: SUCCEED - data were received and processed successfully      *
+ *               other code - an error occurred                               *
+ *                                                                            *
+ * Comments: The acknowledgement is small and is sent without returning to    *
+ *           the event loop. The connection is closed before the received     *
+ *           data is processed.                                               *
+ *                                                                            *
+ *           This function updates proxy version, compress and lastaccess     *
+ *           properties.                                                      *
+ *                                                                            *
+ ******************************************************************************/
+static int	proxy_process_data(zbx_proxy_context_t *proxy_context)
+{
+	zbx_dc_proxy_t	*proxy = &proxy_context->proxy;
+	zbx_socket_t	*s = &proxy_context->s;
+	char		*answer;
+	int		ret, more;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "obtained %s from proxy \"%s\": [%s]", proxy_exchange_string(proxy_context->exchange),
+			proxy->host, s->buffer);
+
+	if (0 != (s->protocol & ZBX_TCP_COMPRESS))
+		proxy->auto_compress = 1;
+
+	if (!ZBX_IS_RUNNING())
+	{
+		int	flags_response = ZBX_TCP_PROTOCOL;
+
+		if (0 != (s->protocol & ZBX_TCP_COMPRESS))
+			flags_response |= ZBX_TCP_COMPRESS;
+
+		zbx_send_response_ext(s, FAIL, "Zabbix server shutdown in progress", NULL, flags_response,
+				proxy_context->config->config_timeout);
+
+		zabbix_log(LOG_LEVEL_WARNING, "cannot process proxy data from passive proxy at \"%s\": Zabbix server"
+				" shutdown in progress", s->peer);
+
+		return FAIL;
+	}
+
+	if (SUCCEED != (ret = zbx_send_proxy_data_response(proxy, s, NULL, SUCCEED, ZBX_PROXY_UPLOAD_UNDEFINED,
+			proxy_context->config->config_timeout)))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot send response to proxy \"%s\" at \"%s\": %s", proxy->host,
+				s->peer, zbx_socket_strerror());
+		return ret;
+	}
+
+	answer = zbx_strdup(NULL, s->buffer);
+	proxy_context_disconnect(proxy_context);
+
+	/* handle pre 3.4 proxies that did not support proxy data request and active/passive configuration mismatch */
+	if ('\0' == *answer)
+	{
+		zbx_strlcpy(proxy->version_str, ZBX_VERSION_UNDEFINED_STR, sizeof(proxy->version_str));
+		proxy->version_int = ZBX_COMPONENT_VERSION_UNDEFINED;
+		ret = FAIL;
+		goto out;
+	}
+
+	proxy->lastaccess = time(NULL);
+
+	if (SUCCEED != (ret = proxy_process_proxy_data(proxy, answer, &proxy_context->ts,
+			proxy_context->config->events_cbs, proxy_context->config->proxydata_frequency, &more)))
+	{
+		goto out;
+	}
+
+	if (ZBX_PROXY_EXCHANGE_DATA == proxy_context->exchange)
+	{
+		proxy_context->tasks_pending = 0;
+
+		if (ZBX_PROXY_DATA_MORE != more)
+			proxy_context->data_pending = 0;
+	}
+out:
+	zbx_free(answer);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: prepare configuration data requested by proxy for sending         *
+ *                                                                            *
+ * Parameters: proxy_context - [IN/OUT] proxy session context                 *
+ *                                                                            *
+ * Return value: SUCCEED - configuration data is ready to be sent             *
+ *               other code - an error occurred                               *
+ *                                                                            *
+ ******************************************************************************/
+static int	proxy_prepare_configuration(zbx_proxy_context_t *proxy_context)
+{
+	zbx_dc_proxy_t			*proxy = &proxy_context->proxy;
+	struct zbx_json			*j = &proxy_context->j;
+	struct zbx_json_parse		jp;
+	zbx_proxyconfig_status_t	status;
+	char				*error = NULL;
+	int				ret, loglevel;
+	unsigned char			flags = ZBX_TCP_PROTOCOL;
+
+	if (SUCCEED != (ret = zbx_json_open(proxy_context->s.buffer, &jp)))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot parse configuration information from proxy \"%s\": %s",
+				proxy->host, zbx_json_strerror());
+		return ret;
+	}
+
+	zbx_tcp_send_context_clear(&proxy_context->send_context);
+	zbx_json_clean(j);
+
+	if (SUCCEED != (ret = zbx_proxyconfig_get_data(proxy, &jp, j, &status, proxy_context->config->config_vault,
+			&error)))
+	{
+		zabbix_log(LOG_LEVEL_ERR, "cannot collect configuration data for proxy \"%s\": %s",
+				proxy->host, error);
+		zbx_free(error);
+		return ret;
+	}
+
+	if (0 != proxy->auto_compress)
+		flags |= ZBX_TCP_COMPRESS;
+
+	if (SUCCEED != zbx_tcp_send_context_init(j->buffer, j->buffer_size, 0, flags, &proxy_context->send_context))
+	{
+		zabbix_log(LOG_LEVEL_ERR, "cannot send configuration data to proxy \"%s\": %s", proxy->host,
+				zbx_socket_strerror());
+		return FAIL;
+	}
+
+	loglevel = (ZBX_PROXYCONFIG_STATUS_DATA == status ? LOG_LEVEL_WARNING : LOG_LEVEL_DEBUG);
+
+	if (0 != proxy->auto_compress)
+	{
+		zabbix_log(loglevel, "sending configuration data to proxy \"%s\" at \"%s\", datalen "
+				ZBX_FS_SIZE_T ", bytes " ZBX_FS_SIZE_T " with compression ratio %.1f", proxy->host,
+				proxy_context->s.peer, (zbx_fs_size_t)j->buffer_size,
+				(zbx_fs_size_t)proxy_context->send_context.send_len,
+				(double)j->buffer_size / proxy_context->send_context.send_len);
+
+		/* compressed data is kept by send context, json buffer can be large, free as fast as possible */
+		zbx_json_free(j);
+		zbx_json_init(j, ZBX_JSON_STAT_BUF_LEN);
+	}
+	else
+	{
+		zabbix_log(loglevel, "sending configuration data to proxy \"%s\" at \"%s\", datalen "
+				ZBX_FS_SIZE_T, proxy->host, proxy_context->s.peer, (zbx_fs_size_t)j->buffer_size);
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: process proxy response to the sent configuration data             *
+ *                                                                            *
+ * Parameters: proxy_context - [IN/OUT] proxy session context                 *
+ *                                                                            *
+ * Return value: SUCCEED - configuration data was accepted by proxy           *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: This function updates proxy version, compress and lastaccess     *
+ *           properties.                                                      *
+ *                                                                            *
+ ******************************************************************************/
+static int	proxy_process_configuration_response(zbx_proxy_context_t *proxy_context)
+{
+	zbx_dc_proxy_t		*proxy = &proxy_context->proxy;
+	zbx_socket_t		*s = &proxy_context->s;
+	struct zbx_json_parse	jp;
+	char			*error = NULL, *version_str;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() '%s'", __func__, s->buffer);
+
+	if (SUCCEED != zbx_parse_response(s->buffer, &error))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot send configuration data to proxy \"%s\" at \"%s\": %s",
+				proxy->host, s->peer, error);
+		zbx_free(error);
+		return FAIL;
+	}
+
+	if (SUCCEED != zbx_json_open(s->buffer, &jp))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "invalid configuration data response received from proxy \"%s\" at"
+				" \"%s\": %s", proxy->host, s->peer, zbx_json_strerror());
+		return SUCCEED;
+	}
+
+	version_str = zbx_get_proxy_protocol_version_str(&jp);
+	zbx_strlcpy(proxy->version_str, version_str, sizeof(proxy->version_str));
+	proxy->version_int = zbx_get_proxy_protocol_version_int(version_str);
+	proxy->auto_compress = (0 != (s->protocol & ZBX_TCP_COMPRESS) ? 1 : 0);
+	proxy->lastaccess = time(NULL);
+	zbx_free(version_str);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: advance proxy exchange until it has to wait for socket or         *
+ *          finishes                                                          *
+ *                                                                            *
+ ******************************************************************************/
+static void	proxy_exchange_process(zbx_proxy_context_t *proxy_context)
+{
+	zbx_dc_proxy_t	*proxy = &proxy_context->proxy;
+	struct timeval	tv;
+	short		event;
+	int		ret;
+
+	while (1)
+	{
+		switch (proxy_context->step)
+		{
+			case ZBX_PROXY_STEP_CONNECT:
+				if (SUCCEED != zbx_tcp_connect_check(&proxy_context->s))
+				{
+					zabbix_log(LOG_LEVEL_ERR, "cannot connect to proxy \"%s\": %s", proxy->host,
+							zbx_socket_strerror());
+					proxy_context_finish(proxy_context, NETWORK_ERROR);
+					return;
+				}
+
+				/* connection timestamp */
+				zbx_timespec(&proxy_context->ts);
+
+				if (ZBX_TCP_SEC_UNENCRYPTED != proxy->tls_connect)
+					proxy_context->step = ZBX_PROXY_STEP_TLS;
+				else
+					proxy_context->step = ZBX_PROXY_STEP_SEND;
+				break;
+			case ZBX_PROXY_STEP_TLS:
+#if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
+				if (SUCCEED != zbx_tcp_tls_connect(&proxy_context->s, proxy->tls_connect,
+						proxy_context->tls_arg1, proxy_context->tls_arg2, &event))
+				{
+					if (0 != event)
+						goto wait;
+
+					zabbix_log(LOG_LEVEL_ERR, "cannot connect to proxy \"%s\": %s", proxy->host,
+							zbx_socket_strerror());
+					proxy_context_finish(proxy_context, NETWORK_ERROR);
+					return;
+				}
+
+				proxy_context->step = ZBX_PROXY_STEP_SEND;
+				break;
+#else
+				THIS_SHOULD_NEVER_HAPPEN;
+				proxy_context_finish(proxy_context, FAIL);
+				return;
+#endif
+			case ZBX_PROXY_STEP_SEND:
+			case ZBX_PROXY_STEP_SEND_CONFIG:
+				if (SUCCEED != zbx_tcp_send_context(&proxy_context->s, &proxy_context->send_context,
+						&event))
+				{
+					if (0 != event)
+						goto wait;
+
+					zabbix_log(LOG_LEVEL_ERR, "cannot send data to proxy \"%s\": %s", proxy->host,
+							zbx_socket_strerror());
+					proxy_context_finish(proxy_context, NETWORK_ERROR);
+					return;
+				}
+
+				zbx_tcp_recv_context_init(&proxy_context->s, &proxy_context->recv_context, 0);
+
+				if (ZBX_PROXY_STEP_SEND == proxy_context->step)
+					proxy_context->step = ZBX_PROXY_STEP_RECV;
+				else
+					proxy_context->step = ZBX_PROXY_STEP_RECV_RESPONSE;
+				break;
+			case ZBX_PROXY_STEP_RECV:
+				if (FAIL == zbx_tcp_recv_context(&proxy_context->s, &proxy_context->recv_context, 0,
+						&event))
+				{
+					if (0 != event)
+						goto wait;
+
+					zabbix_log(LOG_LEVEL_WARNING, "cannot obtain %s from proxy \"%s\": %s",
+							proxy_exchange_string(proxy_context->exchange), proxy->host,
+							zbx_socket_strerror());
+					proxy_context_finish(proxy_context, FAIL);
+					return;
+				}
+
+				if (ZBX_PROXY_EXCHANGE_CONFIG != proxy_context->exchange)
+				{
+					ret = proxy_process_data(proxy_context);
+					proxy_exchange_finish(proxy_context, ret);
+					return;
+				}
+
+				if (SUCCEED != (ret = proxy_prepare_configuration(proxy_context)))
+				{
+					proxy_context_finish(proxy_context, ret);
+					return;
+				}
+
+				/* give proxy the full timeout to receive configuration after it has been prepared */
+				tv.tv_sec = CONFIG_TRAPPER_TIMEOUT;
+				tv.tv_usec = 0;
+				evtimer_add(proxy_context->ev_timeout, &tv);
+
+				proxy_context->step = ZBX_PROXY_STEP_SEND_CONFIG;
+				break;
+			case ZBX_PROXY_STEP_RECV_RESPONSE:
+				if (FAIL == zbx_tcp_recv_context(&proxy_context->s, &proxy_context->recv_context, 0,
+						&event))
+				{
+					if (0 != event)
+						goto wait;
+
+					zabbix_log(LOG_LEVEL_WARNING, "cannot send configuration data to proxy \"%s\" at"
+							" \"%s\": %s", proxy->host, proxy_context->s.peer,
+							zbx_socket_strerror());
+					proxy_context_finish(proxy_context, FAIL);
+					return;
+				}
+
+				ret = proxy_process_configuration_response(proxy_context);
+				proxy_exchange_finish(proxy_context, ret);
+				return;
+			default:
+				THIS_SHOULD_NEVER_HAPPEN;
+				proxy_context_finish(proxy_context, FAIL);
+				return;
+		}
+	}
+wait:
+	proxy_context_wait(proxy_context, event);
+}
+
+static void	proxy_exchange_event_cb(evutil_socket_t fd, short what, void *arg)
+{
+	zbx_proxy_context_t	*proxy_context = (zbx_proxy_context_t *)arg;
+
+	ZBX_UNUSED(fd);
+	ZBX_UNUSED(what);
+
+	proxy_exchange_process(proxy_context);
+}
+
+static void	proxy_exchange_timeout_cb(evutil_socket_t fd, short what, void *arg)
+{
+	zbx_proxy_context_t	*proxy_context = (zbx_proxy_context_t *)arg;
+	const char		*operation;
+	int			ret = FAIL;
+
+	ZBX_UNUSED(fd);
+	ZBX_UNUSED(what);
+
+	switch (proxy_context->step)
+	{
+		case ZBX_PROXY_STEP_CONNECT:
+			operation = "connection";
+			ret = NETWORK_ERROR;
+			break;
+		case ZBX_PROXY_STEP_TLS:
+			operation = "TLS handshake";
+			ret = NETWORK_ERROR;
+			break;
+		case ZBX_PROXY_STEP_SEND:
+		case ZBX_PROXY_STEP_SEND_CONFIG:
+			operation = "write";
+			ret = NETWORK_ERROR;
+			break;
+		default:
+			operation = "read";
+	}
+
+	zabbix_log(LOG_LEVEL_WARNING, "cannot exchange %s with proxy \"%s\": %s timeout",
+			proxy_exchange_string(proxy_context->exchange), proxy_context->proxy.host, operation);
+
+	proxy_context_finish(proxy_context, ret);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: start data exchange session with passive proxy without waiting    *
+ *          for its result                                                    *
+ *                                                                            *
+ * Parameters: base     - [IN] event base the session is processed by         *
+ *             proxy    - [IN] proxy returned by proxy poller queue           *
+ *             now      - [IN] current time                                   *
+ *             config   - [IN] proxy poller configuration, must be valid      *
+ *                             until the session has finished                 *
+ *             finished - [OUT] finished sessions (zbx_proxy_context_t *)     *
+ *                                                                            *
+ * Comments: Session performs configuration, data and tasks exchanges that    *
+ *           are due, each exchange over a separate connection. Network I/O   *
+ *           is processed by event loop, while received data is processed     *
+ *           synchronously.                                                   *
+ *                                                                            *
+ *           User macro handle must be opened to resolve proxy port.          *
+ *                                                                            *
+ *           Finished sessions must be freed with zbx_async_proxy_clean()     *
+ *           after processing their results.                                  *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_async_proxy_start(struct event_base *base, const zbx_dc_proxy_t *proxy, time_t now,
+		const zbx_async_proxy_config_t *config, zbx_vector_ptr_t *finished)
+{
+	zbx_proxy_context_t	*proxy_context;
+	char			*port = NULL;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() proxy:'%s'", __func__, proxy->host);
+
+	proxy_context = (zbx_proxy_context_t *)zbx_malloc(NULL, sizeof(zbx_proxy_context_t));
+	proxy_context->proxy = *proxy;
+	proxy_context->proxy.addr = proxy_context->proxy.addr_orig;
+	proxy_context->proxy_old = proxy_context->proxy;
+	proxy_context->proxy_old.addr = proxy_context->proxy_old.addr_orig;
+	proxy_context->config = config;
+	proxy_context->ret = FAIL;
+	proxy_context->update_nextcheck = 0;
+	proxy_context->config_pending = 0;
+	proxy_context->data_pending = 0;
+	proxy_context->tasks_pending = 0;
+	proxy_context->exchange = ZBX_PROXY_EXCHANGE_CONFIG;
+	proxy_context->step = ZBX_PROXY_STEP_CONNECT;
+	proxy_context->exchanges = 0;
+	proxy_context->time_start = zbx_time();
+	proxy_context->latency = 0.0;
+	proxy_context->base = base;
+	proxy_context->ev = NULL;
+	proxy_context->ev_timeout = NULL;
+	proxy_context->finished = finished;
+	zbx_json_init(&proxy_context->j, ZBX_JSON_STAT_BUF_LEN);
+
+	/* the context must be valid for cleanup before it is initialized with data */
+	(void)zbx_tcp_send_context_init(NULL, 0, 0, 0, &proxy_context->send_context);
+
+	if (proxy->proxy_config_nextcheck <= now)
+		proxy_context->update_nextcheck |= ZBX_PROXY_CONFIG_NEXTCHECK;
+	if (proxy->proxy_data_nextcheck <= now)
+		proxy_context->update_nextcheck |= ZBX_PROXY_DATA_NEXTCHECK;
+	if (proxy->proxy_tasks_nextcheck <= now)
+		proxy_context->update_nextcheck |= ZBX_PROXY_TASKS_NEXTCHECK;
+
+	/* Check if passive proxy has been misconfigured on the server side. If it has happened more */
+	/* recently than last synchronisation of cache then there is no point to retry connecting to */
+	/* proxy again. The next reconnection attempt will happen after cache synchronisation. */
+	if (proxy->last_cfg_error_time >= zbx_dc_config_get_last_sync_time())
+	{
+		proxy_context_finish(proxy_context, FAIL);
+		goto out;
+	}
+
+	port = zbx_strdup(port, proxy->port_orig);
+	zbx_substitute_simple_macros(NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+			NULL, &port, MACRO_TYPE_COMMON, NULL, 0);
+	if (FAIL == zbx_is_ushort(port, &proxy_context->proxy.port))
+	{
+		zabbix_log(LOG_LEVEL_ERR, "invalid proxy \"%s\" port: \"%s\"", proxy->host, port);
+		zbx_free(port);
+		proxy_context_finish(proxy_context, CONFIG_ERROR);
+		goto out;
+	}
+	zbx_free(port);
+
+	switch (proxy->tls_connect)
+	{
+		case ZBX_TCP_SEC_UNENCRYPTED:
+			proxy_context->tls_arg1 = NULL;
+			proxy_context->tls_arg2 = NULL;
+			break;
+#if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
+		case ZBX_TCP_SEC_TLS_CERT:
+			proxy_context->tls_arg1 = proxy_context->proxy.tls_issuer;
+			proxy_context->tls_arg2 = proxy_context->proxy.tls_subject;
+			break;
+		case ZBX_TCP_SEC_TLS_PSK:
+			proxy_context->tls_arg1 = proxy_context->proxy.tls_psk_identity;
+			proxy_context->tls_arg2 = proxy_context->proxy.tls_psk;
+			break;
+#else
+		case ZBX_TCP_SEC_TLS_CERT:
+		case ZBX_TCP_SEC_TLS_PSK:
+			zabbix_log(LOG_LEVEL_ERR, "TLS connection is configured to be used with passive proxy \"%s\""
+					" but support for TLS was not compiled into %s.", proxy->host,
+					get_program_type_string(config->get_program_type_cb()));
+			proxy_context_finish(proxy_context, CONFIG_ERROR);
+			goto out;
+#endif
+		default:
+			THIS_SHOULD_NEVER_HAPPEN;
+			proxy_context_finish(proxy_context, FAIL);
+			goto out;
+	}
+
+	if (proxy->proxy_config_nextcheck <= now && ZBX_PROXY_VERSION_CURRENT == proxy->compatibility)
+		proxy_context->config_pending = 1;
+
+	if (proxy->proxy_data_nextcheck <= now && (ZBX_PROXY_VERSION_CURRENT == proxy->compatibility ||
+			ZBX_PROXY_VERSION_OUTDATED == proxy->compatibility))
+	{
+		proxy_context->data_pending = 1;
+	}
+
+	if (proxy->proxy_tasks_nextcheck <= now)
+		proxy_context->tasks_pending = 1;
+
+	proxy_context_next(proxy_context);
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: free finished proxy session                                       *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_async_proxy_clean(zbx_proxy_context_t *proxy_context)
+{
+	zbx_json_free(&proxy_context->j);
+	zbx_free(proxy_context);
+}
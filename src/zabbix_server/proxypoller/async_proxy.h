@@ -0,0 +1,74 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#ifndef ZABBIX_ASYNC_PROXY_H
+#define ZABBIX_ASYNC_PROXY_H
+
+#include "zbxcacheconfig.h"
+#include "zbxcomms.h"
+#include "zbxdbhigh.h"
+#include "zbxjson.h"
+#include "zbxvault.h"
+
+#include <event.h>
+
+typedef struct
+{
+	const zbx_config_vault_t	*config_vault;
+	const zbx_events_funcs_t	*events_cbs;
+	zbx_get_program_type_f		get_program_type_cb;
+	int				config_timeout;
+	int				proxydata_frequency;
+}
+zbx_async_proxy_config_t;
+
+typedef struct
+{
+	zbx_dc_proxy_t			proxy;
+	zbx_dc_proxy_t			proxy_old;
+	const zbx_async_proxy_config_t	*config;
+	int				ret;
+	unsigned char			update_nextcheck;
+	unsigned char			config_pending;
+	unsigned char			data_pending;
+	unsigned char			tasks_pending;
+	unsigned char			exchange;
+	unsigned char			step;
+	int				exchanges;
+	zbx_socket_t			s;
+	zbx_tcp_send_context_t		send_context;
+	zbx_tcp_recv_context_t		recv_context;
+	struct zbx_json			j;
+	zbx_timespec_t			ts;
+	const char			*tls_arg1;
+	const char			*tls_arg2;
+	double				time_start;
+	double				latency;
+	struct event_base		*base;
+	struct event			*ev;
+	struct event			*ev_timeout;
+	zbx_vector_ptr_t		*finished;
+}
+zbx_proxy_context_t;
+
+void	zbx_async_proxy_start(struct event_base *base, const zbx_dc_proxy_t *proxy, time_t now,
+		const zbx_async_proxy_config_t *config, zbx_vector_ptr_t *finished);
+void	zbx_async_proxy_clean(zbx_proxy_context_t *proxy_context);
+
+#endif
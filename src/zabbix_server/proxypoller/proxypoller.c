@@ -17,654 +17,152 @@
 ** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 **/
 
-#include "proxypoller.h"
 
-#include "proxyconfigread/proxyconfig_read.h"
-#include "../trapper/proxydata.h"
+#include "proxypoller.h"
+#include "async_proxy.h"
 
-#include "zbxserver.h"
 #include "zbxdbwrap.h"
-#include "zbxcachehistory.h"
 #include "zbxnix.h"
 #include "zbxself.h"
-#include "zbxdbhigh.h"
 #include "log.h"
-#include "zbxcompress.h"
 #include "zbxrtc.h"
-#include "zbxcommshigh.h"
-#include "zbxnum.h"
 #include "zbxtime.h"
-#include "zbxversion.h"
 #include "zbx_rtc_constants.h"
-#include "zbx_host_constants.h"
 
-static zbx_get_program_type_f		zbx_get_program_type_cb = NULL;
-
-static int	connect_to_proxy(const zbx_dc_proxy_t *proxy, zbx_socket_t *sock, int timeout)
+static void	proxy_poller_timer_cb(evutil_socket_t fd, short what, void *arg)
 {
-	int		ret = FAIL;
-	const char	*tls_arg1, *tls_arg2;
-
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() address:%s port:%hu timeout:%d conn:%u", __func__, proxy->addr,
-			proxy->port, timeout, (unsigned int)proxy->tls_connect);
-
-	switch (proxy->tls_connect)
-	{
-		case ZBX_TCP_SEC_UNENCRYPTED:
-			tls_arg1 = NULL;
-			tls_arg2 = NULL;
-			break;
-#if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
-		case ZBX_TCP_SEC_TLS_CERT:
-			tls_arg1 = proxy->tls_issuer;
-			tls_arg2 = proxy->tls_subject;
-			break;
-		case ZBX_TCP_SEC_TLS_PSK:
-			tls_arg1 = proxy->tls_psk_identity;
-			tls_arg2 = proxy->tls_psk;
-			break;
-#else
-		case ZBX_TCP_SEC_TLS_CERT:
-		case ZBX_TCP_SEC_TLS_PSK:
-			zabbix_log(LOG_LEVEL_ERR, "TLS connection is configured to be used with passive proxy \"%s\""
-					" but support for TLS was not compiled into %s.", proxy->host,
-					get_program_type_string(zbx_get_program_type_cb()));
-			ret = CONFIG_ERROR;
-			goto out;
-#endif
-		default:
-			THIS_SHOULD_NEVER_HAPPEN;
-			goto out;
-	}
-
-	if (FAIL == (ret = zbx_tcp_connect(sock, CONFIG_SOURCE_IP, proxy->addr, proxy->port, timeout,
-			proxy->tls_connect, tls_arg1, tls_arg2)))
-	{
-		zabbix_log(LOG_LEVEL_ERR, "cannot connect to proxy \"%s\": %s", proxy->host, zbx_socket_strerror());
-		ret = NETWORK_ERROR;
-	}
-out:
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
-
-	return ret;
-}
-
-static int	send_data_to_proxy(const zbx_dc_proxy_t *proxy, zbx_socket_t *sock, const char *data, size_t size,
-		size_t reserved, int flags)
-{
-	int	ret;
-
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
-
-	if (FAIL == (ret = zbx_tcp_send_ext(sock, data, size, reserved, flags, 0)))
-	{
-		zabbix_log(LOG_LEVEL_ERR, "cannot send data to proxy \"%s\": %s", proxy->host, zbx_socket_strerror());
-
-		ret = NETWORK_ERROR;
-	}
-
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
-
-	return ret;
-}
-
-static int	recv_data_from_proxy(const zbx_dc_proxy_t *proxy, zbx_socket_t *sock)
-{
-	int	ret;
-
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
-
-	if (FAIL == (ret = zbx_tcp_recv(sock)))
-	{
-		zabbix_log(LOG_LEVEL_ERR, "cannot obtain data from proxy \"%s\": %s", proxy->host,
-				zbx_socket_strerror());
-	}
-	else
-		zabbix_log(LOG_LEVEL_DEBUG, "obtained data from proxy \"%s\": [%s]", proxy->host, sock->buffer);
-
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
-
-	return ret;
-}
-
-static void	disconnect_proxy(zbx_socket_t *sock)
-{
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
-
-	zbx_tcp_close(sock);
-
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+	ZBX_UNUSED(fd);
+	ZBX_UNUSED(what);
+	ZBX_UNUSED(arg);
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: get historical data from proxy                                    *
- *                                                                            *
- * Parameters: proxy          - [IN/OUT] proxy data                           *
- *             request        - [IN] requested data type                      *
- *             config_timeout - [IN]                                          *
- *             data           - [OUT] data received from proxy                *
- *             ts             - [OUT] timestamp when the proxy connection was *
- *                                    established                             *
+ * Purpose: start sessions with passive proxies that are due                  *
  *                                                                            *
- * Return value: SUCCESS - processed successfully                             *
- *               other code - an error occurred                               *
+ * Parameters: base        - [IN] event base to run sessions with             *
+ *             proxies     - [IN] buffer for proxies taken from queue         *
+ *             max_proxies - [IN] maximum number of sessions to start         *
+ *             config      - [IN] proxy session configuration                 *
+ *             finished    - [OUT] finished sessions                          *
  *                                                                            *
- * Comments: The proxy->compress property is updated depending on the         *
- *           protocol flags sent by proxy.                                    *
+ * Return value: number of started sessions                                   *
  *                                                                            *
  ******************************************************************************/
-static int	get_data_from_proxy(zbx_dc_proxy_t *proxy, const char *request, int config_timeout, char **data,
-		zbx_timespec_t *ts)
+static int	proxy_poller_start(struct event_base *base, zbx_dc_proxy_t *proxies, int max_proxies,
+		const zbx_async_proxy_config_t *config, zbx_vector_ptr_t *finished)
 {
-	zbx_socket_t	s;
-	struct zbx_json	j;
-	int		ret, flags = ZBX_TCP_PROTOCOL;
-	char		*buffer = NULL;
-	size_t		buffer_size, reserved = 0;
-
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() request:'%s'", __func__, request);
-
-	zbx_json_init(&j, ZBX_JSON_STAT_BUF_LEN);
+	int			num, i;
+	time_t			now;
+	zbx_dc_um_handle_t	*um_handle;
 
-	zbx_json_addstring(&j, "request", request, ZBX_JSON_TYPE_STRING);
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() max_proxies:%d", __func__, max_proxies);
 
-	if (0 != proxy->auto_compress)
-	{
-		if (SUCCEED != zbx_compress(j.buffer, j.buffer_size, &buffer, &buffer_size))
-		{
-			zabbix_log(LOG_LEVEL_ERR,"cannot compress data: %s", zbx_compress_strerror());
-			ret = FAIL;
-			goto out;
-		}
-
-		flags |= ZBX_TCP_COMPRESS;
-		reserved = j.buffer_size;
-		zbx_json_free(&j);	/* json buffer can be large, free as fast as possible */
-	}
+	if (0 == (num = zbx_dc_config_get_proxypoller_hosts(proxies, max_proxies)))
+		goto out;
 
-	if (SUCCEED == (ret = connect_to_proxy(proxy, &s, CONFIG_TRAPPER_TIMEOUT)))
-	{
-		/* get connection timestamp if required */
-		if (NULL != ts)
-			zbx_timespec(ts);
+	now = time(NULL);
 
-		if (0 != proxy->auto_compress)
-		{
-			ret = send_data_to_proxy(proxy, &s, buffer, buffer_size, reserved, flags);
-			zbx_free(buffer);
-		}
-		else
-		{
-			ret = send_data_to_proxy(proxy, &s, j.buffer, j.buffer_size, 0, flags);
-			zbx_json_free(&j);
-		}
+	um_handle = zbx_dc_open_user_macros();
 
-		if (SUCCEED == ret)
-		{
-			if (SUCCEED == (ret = recv_data_from_proxy(proxy, &s)))
-			{
-				if (0 != (s.protocol & ZBX_TCP_COMPRESS))
-					proxy->auto_compress = 1;
-
-				if (!ZBX_IS_RUNNING())
-				{
-					int	flags_response = ZBX_TCP_PROTOCOL;
-
-					if (0 != (s.protocol & ZBX_TCP_COMPRESS))
-						flags_response |= ZBX_TCP_COMPRESS;
-
-					zbx_send_response_ext(&s, FAIL, "Zabbix server shutdown in progress", NULL,
-							flags_response, config_timeout);
-
-					zabbix_log(LOG_LEVEL_WARNING, "cannot process proxy data from passive proxy at"
-							" \"%s\": Zabbix server shutdown in progress", s.peer);
-					ret = FAIL;
-				}
-				else
-				{
-					ret = zbx_send_proxy_data_response(proxy, &s, NULL, SUCCEED,
-							ZBX_PROXY_UPLOAD_UNDEFINED, 0);
-
-					if (SUCCEED == ret)
-						*data = zbx_strdup(*data, s.buffer);
-				}
-			}
-		}
+	for (i = 0; i < num; i++)
+		zbx_async_proxy_start(base, &proxies[i], now, config, finished);
 
-		disconnect_proxy(&s);
-	}
+	zbx_dc_close_user_macros(um_handle);
 out:
-	zbx_json_free(&j);
-	zbx_free(buffer);
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%d", __func__, num);
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
-
-	return ret;
+	return num;
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: sends configuration data to proxy                                 *
- *                                                                            *
- * Parameters: proxy        - [IN/OUT] proxy data                             *
- *             config_vault - [IN]                                            *
+ * Purpose: update and requeue proxies of finished sessions                   *
  *                                                                            *
- * Return value: SUCCEED - processed successfully                             *
- *               other code - an error occurred                               *
+ * Parameters: finished              - [IN/OUT] finished sessions             *
+ *             proxyconfig_frequency - [IN]                                   *
+ *             proxydata_frequency   - [IN]                                   *
+ *             latency_max           - [IN/OUT] the highest session latency   *
+ *                                              seen so far                   *
  *                                                                            *
- * Comments: This function updates proxy version, compress and lastaccess     *
- *           properties.                                                      *
+ * Return value: number of processed sessions                                 *
  *                                                                            *
  ******************************************************************************/
-static int	proxy_send_configuration(zbx_dc_proxy_t *proxy, const zbx_config_vault_t *config_vault)
+static int	proxy_poller_process_finished(zbx_vector_ptr_t *finished, int proxyconfig_frequency,
+		int proxydata_frequency, double *latency_max)
 {
-	char				*error = NULL, *buffer = NULL;
-	int				ret, flags = ZBX_TCP_PROTOCOL, loglevel;
-	zbx_socket_t			s;
-	struct zbx_json			j;
-	struct zbx_json_parse		jp;
-	size_t				buffer_size, reserved = 0;
-	zbx_proxyconfig_status_t	status;
+	int	i, num;
 
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() finished:%d", __func__, finished->values_num);
 
-	zbx_json_init(&j, 512 * ZBX_KIBIBYTE);
-	zbx_json_addstring(&j, ZBX_PROTO_TAG_REQUEST, ZBX_PROTO_VALUE_PROXY_CONFIG, ZBX_JSON_TYPE_STRING);
-
-	if (SUCCEED != (ret = connect_to_proxy(proxy, &s, CONFIG_TRAPPER_TIMEOUT)))
-		goto out;
-
-	if (SUCCEED != (ret = send_data_to_proxy(proxy, &s, j.buffer, j.buffer_size, reserved, ZBX_TCP_PROTOCOL)))
-		goto clean;
-
-	if (FAIL == (ret = zbx_tcp_recv_ext(&s, 0, 0)))
+	for (i = 0; i < finished->values_num; i++)
 	{
-		zabbix_log(LOG_LEVEL_WARNING, "cannot receive configuration information from proxy \"%s\": %s",
-				proxy->host, zbx_socket_strerror());
-		goto clean;
-	}
+		zbx_proxy_context_t	*proxy_context = (zbx_proxy_context_t *)finished->values[i];
+		zbx_dc_proxy_t		*proxy = &proxy_context->proxy, *proxy_old = &proxy_context->proxy_old;
 
-	if (SUCCEED != (ret = zbx_json_open(s.buffer, &jp)))
-	{
-		zabbix_log(LOG_LEVEL_WARNING, "cannot parse configuration information from proxy \"%s\": %s",
-				proxy->host, zbx_socket_strerror());
-		goto clean;
-	}
-
-	zbx_json_clean(&j);
-
-	if (SUCCEED != (ret = zbx_proxyconfig_get_data(proxy, &jp, &j, &status, config_vault, &error)))
-	{
-		zabbix_log(LOG_LEVEL_ERR, "cannot collect configuration data for proxy \"%s\": %s",
-				proxy->host, error);
-		goto clean;
-	}
-
-	if (0 != proxy->auto_compress)
-	{
-		if (SUCCEED != zbx_compress(j.buffer, j.buffer_size, &buffer, &buffer_size))
+		if (0 != strcmp(proxy_old->version_str, proxy->version_str) ||
+				proxy_old->auto_compress != proxy->auto_compress ||
+				proxy_old->lastaccess != proxy->lastaccess)
 		{
-			zabbix_log(LOG_LEVEL_ERR,"cannot compress data: %s", zbx_compress_strerror());
-			ret = FAIL;
-			goto clean;
+			zbx_update_proxy_data(proxy_old, proxy->version_str, proxy->version_int, proxy->lastaccess,
+					proxy->auto_compress, 0);
 		}
 
-		flags |= ZBX_TCP_COMPRESS;
-		reserved = j.buffer_size;
-		zbx_json_free(&j);	/* json buffer can be large, free as fast as possible */
-	}
-
-	loglevel = (ZBX_PROXYCONFIG_STATUS_DATA == status ? LOG_LEVEL_WARNING : LOG_LEVEL_DEBUG);
-
-	if (0 != proxy->auto_compress)
-	{
-		zabbix_log(loglevel, "sending configuration data to proxy \"%s\" at \"%s\", datalen "
-				ZBX_FS_SIZE_T ", bytes " ZBX_FS_SIZE_T " with compression ratio %.1f", proxy->host,
-				s.peer, (zbx_fs_size_t)reserved, (zbx_fs_size_t)buffer_size,
-				(double)reserved / buffer_size);
-
-		ret = send_data_to_proxy(proxy, &s, buffer, buffer_size, reserved, flags);
-		zbx_free(buffer);		/* json buffer can be large, free as fast as possible */
-	}
-	else
-	{
-		zabbix_log(loglevel, "sending configuration data to proxy \"%s\" at \"%s\", datalen "
-				ZBX_FS_SIZE_T, proxy->host, s.peer, (zbx_fs_size_t)j.buffer_size);
-
-		ret = send_data_to_proxy(proxy, &s, j.buffer, j.buffer_size, reserved, flags);
-		zbx_json_free(&j);	/* json buffer can be large, free as fast as possible */
-	}
-
-	if (SUCCEED == ret)
-	{
-		if (SUCCEED != (ret = zbx_recv_response(&s, 0, &error)))
-		{
-			zabbix_log(LOG_LEVEL_WARNING, "cannot send configuration data to proxy"
-					" \"%s\" at \"%s\": %s", proxy->host, s.peer, error);
-		}
-		else
-		{
-			if (SUCCEED != zbx_json_open(s.buffer, &jp))
-			{
-				zabbix_log(LOG_LEVEL_WARNING, "invalid configuration data response received from proxy"
-						" \"%s\" at \"%s\": %s", proxy->host, s.peer, zbx_json_strerror());
-			}
-			else
-			{
-				char	*version_str;
-
-				version_str = zbx_get_proxy_protocol_version_str(&jp);
-				zbx_strlcpy(proxy->version_str, version_str, sizeof(proxy->version_str));
-				proxy->version_int = zbx_get_proxy_protocol_version_int(version_str);
-				proxy->auto_compress = (0 != (s.protocol & ZBX_TCP_COMPRESS) ? 1 : 0);
-				proxy->lastaccess = time(NULL);
-				zbx_free(version_str);
-			}
-		}
-	}
-clean:
-	disconnect_proxy(&s);
-out:
-	zbx_free(buffer);
-	zbx_free(error);
-	zbx_json_free(&j);
-
-	return ret;
-}
-
-/******************************************************************************
- *                                                                            *
- * Purpose: processes proxy data request                                      *
- *                                                                            *
- * Parameters: proxy               - [IN/OUT] proxy data                      *
- *             answer              - [IN] data received from proxy            *
- *             ts                  - [IN] timestamp when the proxy connection *
- *                                        was established                     *
- *             events_cbs          - [IN]                                     *
- *             proxydata_frequency - [IN]                                     *
- *             more                - [OUT] available data flag                *
- *                                                                            *
- * Return value: SUCCEED - data were received and processed successfully      *
- *               FAIL - otherwise                                             *
- *                                                                            *
- * Comments: The proxy->version property is updated with the version number   *
- *           sent by proxy.                                                   *
- *                                                                            *
- ******************************************************************************/
-static int	proxy_process_proxy_data(zbx_dc_proxy_t *proxy, const char *answer, zbx_timespec_t *ts,
-		const zbx_events_funcs_t *events_cbs, int proxydata_frequency, int *more)
-{
-	struct zbx_json_parse	jp;
-	char			*error = NULL, *version_str = NULL;
-	int			version_int, ret = FAIL;
-
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+		zbx_dc_requeue_proxy(proxy->hostid, proxy_context->update_nextcheck, proxy_context->ret,
+				proxyconfig_frequency, proxydata_frequency);
 
-	*more = ZBX_PROXY_DATA_DONE;
+		zabbix_log(LOG_LEVEL_DEBUG, "finished session with proxy \"%s\": exchanges:%d result:%s latency:"
+				ZBX_FS_DBL " sec", proxy->host, proxy_context->exchanges,
+				zbx_result_string(proxy_context->ret), proxy_context->latency);
 
-	if ('\0' == *answer)
-	{
-		zabbix_log(LOG_LEVEL_WARNING, "proxy \"%s\" at \"%s\" returned no proxy data:"
-				" check allowed connection types and access rights", proxy->host, proxy->addr);
-		goto out;
-	}
+		if (*latency_max < proxy_context->latency)
+			*latency_max = proxy_context->latency;
 
-	if (SUCCEED != zbx_json_open(answer, &jp))
-	{
-		zabbix_log(LOG_LEVEL_WARNING, "proxy \"%s\" at \"%s\" returned invalid proxy data: %s",
-				proxy->host, proxy->addr, zbx_json_strerror());
-		goto out;
+		zbx_async_proxy_clean(proxy_context);
 	}
 
-	version_str = zbx_get_proxy_protocol_version_str(&jp);
-	version_int = zbx_get_proxy_protocol_version_int(version_str);
+	num = finished->values_num;
+	zbx_vector_ptr_clear(finished);
 
-	zbx_strlcpy(proxy->version_str, version_str, sizeof(proxy->version_str));
-	proxy->version_int = version_int;
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%d", __func__, num);
 
-	if (SUCCEED != zbx_check_protocol_version(proxy, version_int))
-	{
-		goto out;
-	}
-
-	if (SUCCEED != (ret = zbx_process_proxy_data(proxy, &jp, ts, HOST_STATUS_PROXY_PASSIVE, events_cbs,
-			proxydata_frequency, more, &error)))
-	{
-		zabbix_log(LOG_LEVEL_WARNING, "proxy \"%s\" at \"%s\" returned invalid proxy data: %s",
-				proxy->host, proxy->addr, error);
-	}
-
-out:
-	zbx_free(error);
-	zbx_free(version_str);
-
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
-
-	return ret;
-}
-
-/******************************************************************************
- *                                                                            *
- * Purpose: gets data from proxy ('proxy data' request)                       *
- *                                                                            *
- * Parameters: proxy               - [IN/OUT] proxy data                      *
- *             config_timeout      - [IN]                                     *
- *             events_cbs          - [IN]                                     *
- *             proxydata_frequency - [IN]                                     *
- *             more                - [OUT] available data flag                *
- *                                                                            *
- * Return value: SUCCEED - data were received and processed successfully      *
- *               other code - an error occurred                               *
- *                                                                            *
- * Comments: This function updates proxy version, compress and lastaccess     *
- *           properties.                                                      *
- *                                                                            *
- ******************************************************************************/
-static int	proxy_get_data(zbx_dc_proxy_t *proxy, int config_timeout, const zbx_events_funcs_t *events_cbs,
-		int proxydata_frequency, int *more)
-{
-	char		*answer = NULL;
-	int		ret;
-	zbx_timespec_t	ts;
-
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
-
-	if (SUCCEED != (ret = get_data_from_proxy(proxy, ZBX_PROTO_VALUE_PROXY_DATA, config_timeout, &answer, &ts)))
-		goto out;
-
-	/* handle pre 3.4 proxies that did not support proxy data request and active/passive configuration mismatch */
-	if ('\0' == *answer)
-	{
-		zbx_strlcpy(proxy->version_str, ZBX_VERSION_UNDEFINED_STR, sizeof(proxy->version_str));
-		proxy->version_int = ZBX_COMPONENT_VERSION_UNDEFINED;
-		zbx_free(answer);
-		ret = FAIL;
-		goto out;
-	}
-
-	proxy->lastaccess = time(NULL);
-	ret = proxy_process_proxy_data(proxy, answer, &ts, events_cbs, proxydata_frequency, more);
-	zbx_free(answer);
-out:
-	if (SUCCEED == ret)
-		zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s more:%d", __func__, zbx_result_string(ret), *more);
-	else
-		zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
-
-	return ret;
+	return num;
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: gets data from proxy ('proxy data' request)                       *
- *                                                                            *
- * Parameters: proxy               - [IN/OUT] proxy data                      *
- *             config_timeout      - [IN]                                     *
- *             events_cbs          - [IN]                                     *
- *             proxydata_frequency - [IN]                                     *
- *                                                                            *
- * Return value: SUCCEED - data were received and processed successfully      *
- *               other code - an error occurred                               *
- *                                                                            *
- * Comments: This function updates proxy version, compress and lastaccess     *
- *           properties.                                                      *
+ * Purpose: process events of proxy sessions for up to sleeptime seconds or   *
+ *          until any session makes progress                                  *
  *                                                                            *
  ******************************************************************************/
-static int	proxy_get_tasks(zbx_dc_proxy_t *proxy, int config_timeout, const zbx_events_funcs_t *events_cbs,
-		int proxydata_frequency)
+static void	proxy_poller_wait(struct event_base *base, struct event *ev_timer, int sleeptime,
+		const zbx_thread_info_t *info)
 {
-	char		*answer = NULL;
-	int		ret = FAIL, more;
-	zbx_timespec_t	ts;
+	struct timeval	tv = {sleeptime, 0};
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
-
-	if (SUCCEED != (ret = get_data_from_proxy(proxy, ZBX_PROTO_VALUE_PROXY_TASKS, config_timeout, &answer, &ts)))
-		goto out;
-
-	/* handle pre 3.4 proxies that did not support proxy data request and active/passive configuration mismatch */
-	if ('\0' == *answer)
+	if (0 == sleeptime)
 	{
-		zbx_strlcpy(proxy->version_str, ZBX_VERSION_UNDEFINED_STR, sizeof(proxy->version_str));
-		proxy->version_int = ZBX_COMPONENT_VERSION_UNDEFINED;
-		zbx_free(answer);
-		ret = FAIL;
-		goto out;
+		event_base_loop(base, EVLOOP_NONBLOCK);
+		return;
 	}
 
-	proxy->lastaccess = time(NULL);
-
-	ret = proxy_process_proxy_data(proxy, answer, &ts, events_cbs, proxydata_frequency, &more);
-
-	zbx_free(answer);
-out:
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
-
-	return ret;
-}
-
-/******************************************************************************
- *                                                                            *
- * Purpose: retrieve values of metrics from monitored hosts                   *
- *                                                                            *
- ******************************************************************************/
-static int	process_proxy(const zbx_config_vault_t *config_vault, int config_timeout,
-		const zbx_events_funcs_t *events_cbs, int proxyconfig_frequency, int proxydata_frequency)
-{
-	zbx_dc_proxy_t		proxy, proxy_old;
-	int			num, i;
-	time_t			now;
-	zbx_dc_um_handle_t	*um_handle;
-
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
-
-	if (0 == (num = zbx_dc_config_get_proxypoller_hosts(&proxy, 1)))
-		goto exit;
+	evtimer_add(ev_timer, &tv);
 
-	now = time(NULL);
-
-	um_handle = zbx_dc_open_user_macros();
-
-	for (i = 0; i < num; i++)
-	{
-		int		ret = FAIL;
-		unsigned char	update_nextcheck = 0;
-
-		memcpy(&proxy_old, &proxy, sizeof(zbx_dc_proxy_t));
-
-		if (proxy.proxy_config_nextcheck <= now)
-			update_nextcheck |= ZBX_PROXY_CONFIG_NEXTCHECK;
-		if (proxy.proxy_data_nextcheck <= now)
-			update_nextcheck |= ZBX_PROXY_DATA_NEXTCHECK;
-		if (proxy.proxy_tasks_nextcheck <= now)
-			update_nextcheck |= ZBX_PROXY_TASKS_NEXTCHECK;
-
-		/* Check if passive proxy has been misconfigured on the server side. If it has happened more */
-		/* recently than last synchronisation of cache then there is no point to retry connecting to */
-		/* proxy again. The next reconnection attempt will happen after cache synchronisation. */
-		if (proxy.last_cfg_error_time < zbx_dc_config_get_last_sync_time())
-		{
-			char	*port = NULL;
-			int	check_tasks = 0;
-
-			proxy.addr = proxy.addr_orig;
-
-			port = zbx_strdup(port, proxy.port_orig);
-			zbx_substitute_simple_macros(NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
-					NULL, &port, MACRO_TYPE_COMMON, NULL, 0);
-			if (FAIL == zbx_is_ushort(port, &proxy.port))
-			{
-				zabbix_log(LOG_LEVEL_ERR, "invalid proxy \"%s\" port: \"%s\"", proxy.host, port);
-				ret = CONFIG_ERROR;
-				zbx_free(port);
-				goto error;
-			}
-			zbx_free(port);
-
-			if (proxy.proxy_config_nextcheck <= now && proxy.compatibility == ZBX_PROXY_VERSION_CURRENT)
-			{
-				if (SUCCEED != (ret = proxy_send_configuration(&proxy, config_vault)))
-					goto error;
-			}
-
-			if (proxy.proxy_tasks_nextcheck <= now)
-				check_tasks = 1;
-
-			if (proxy.proxy_data_nextcheck <= now && (proxy.compatibility == ZBX_PROXY_VERSION_CURRENT ||
-					proxy.compatibility == ZBX_PROXY_VERSION_OUTDATED))
-			{
-				int	more;
-
-				do
-				{
-					if (FAIL == zbx_hc_check_proxy(proxy.hostid))
-						break;
-
-					if (SUCCEED != (ret = proxy_get_data(&proxy, config_timeout, events_cbs,
-							proxydata_frequency, &more)))
-					{
-						goto error;
-					}
-
-					check_tasks = 0;
-				}
-				while (ZBX_PROXY_DATA_MORE == more);
-			}
-
-			if (1 == check_tasks)
-			{
-				if (SUCCEED != (ret = proxy_get_tasks(&proxy, config_timeout, events_cbs,
-						proxydata_frequency)))
-				{
-					goto error;
-				}
-			}
-		}
-error:
-		if (0 != strcmp(proxy_old.version_str, proxy.version_str) ||
-				proxy_old.auto_compress != proxy.auto_compress ||
-				proxy_old.lastaccess != proxy.lastaccess)
-		{
-			zbx_update_proxy_data(&proxy_old, proxy.version_str, proxy.version_int, proxy.lastaccess,
-					proxy.auto_compress, 0);
-		}
-
-		zbx_dc_requeue_proxy(proxy.hostid, update_nextcheck, ret, proxyconfig_frequency, proxydata_frequency);
-	}
-
-	zbx_dc_close_user_macros(um_handle);
-exit:
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+	zbx_update_selfmon_counter(info, ZBX_PROCESS_STATE_IDLE);
+	event_base_loop(base, EVLOOP_ONCE);
+	zbx_update_selfmon_counter(info, ZBX_PROCESS_STATE_BUSY);
 
-	return num;
+	evtimer_del(ev_timer);
 }
 
 ZBX_THREAD_ENTRY(proxypoller_thread, args)
 {
 	zbx_thread_proxy_poller_args	*proxy_poller_args_in = (zbx_thread_proxy_poller_args *)
 							(((zbx_thread_args_t *)args)->args);
-	int				nextcheck, sleeptime = -1, processed = 0, old_processed = 0;
-	double				sec, total_sec = 0.0, old_total_sec = 0.0;
+	int				nextcheck, sleeptime = -1, processed = 0, old_processed = 0, processing = 0,
+					max_proxies;
+	double				sec, total_sec = 0.0, old_total_sec = 0.0, latency_max = 0.0,
+					old_latency_max = 0.0;
 	time_t				last_stat_time;
 	zbx_ipc_async_socket_t		rtc;
 	const zbx_thread_info_t		*info = &((zbx_thread_args_t *)args)->info;
@@ -672,8 +170,18 @@ ZBX_THREAD_ENTRY(proxypoller_thread, args)
 	int				process_num = ((zbx_thread_args_t *)args)->info.process_num;
 	unsigned char			process_type = ((zbx_thread_args_t *)args)->info.process_type;
 	zbx_uint32_t			rtc_msgs[] = {ZBX_RTC_PROXYPOLLER_PROCESS};
-
-	zbx_get_program_type_cb = proxy_poller_args_in->zbx_get_program_type_cb_arg;
+	zbx_async_proxy_config_t	config;
+	zbx_dc_proxy_t			*proxies;
+	struct event_base		*base;
+	struct event			*ev_timer;
+	zbx_vector_ptr_t		finished;
+
+	config.config_vault = proxy_poller_args_in->config_vault;
+	config.events_cbs = proxy_poller_args_in->events_cbs;
+	config.get_program_type_cb = proxy_poller_args_in->zbx_get_program_type_cb_arg;
+	config.config_timeout = proxy_poller_args_in->config_timeout;
+	config.proxydata_frequency = proxy_poller_args_in->proxydata_frequency;
+	max_proxies = proxy_poller_args_in->config_max_concurrent_proxies_per_poller;
 
 	zabbix_log(LOG_LEVEL_INFORMATION, "%s #%d started [%s #%d]", get_program_type_string(info->program_type),
 			server_num, get_process_type_string(process_type), process_num);
@@ -684,13 +192,24 @@ ZBX_THREAD_ENTRY(proxypoller_thread, args)
 				/* once in STAT_INTERVAL seconds */
 
 #if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
-	zbx_tls_init_child(proxy_poller_args_in->config_tls, zbx_get_program_type_cb);
+	zbx_tls_init_child(proxy_poller_args_in->config_tls, proxy_poller_args_in->zbx_get_program_type_cb_arg);
 #endif
 	zbx_setproctitle("%s #%d [connecting to the database]", get_process_type_string(process_type), process_num);
 	last_stat_time = time(NULL);
 
 	zbx_db_connect(ZBX_DB_CONNECT_NORMAL);
 
+	if (NULL == (base = event_base_new()))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize asynchronous proxy sessions");
+		exit(EXIT_FAILURE);
+	}
+
+	ev_timer = evtimer_new(base, proxy_poller_timer_cb, NULL);
+	zbx_vector_ptr_create(&finished);
+	zbx_tcp_dns_cache_enable();
+	proxies = (zbx_dc_proxy_t *)zbx_malloc(NULL, sizeof(zbx_dc_proxy_t) * (size_t)max_proxies);
+
 	zbx_rtc_subscribe(process_type, process_num, rtc_msgs, ARRSIZE(rtc_msgs), proxy_poller_args_in->config_timeout,
 			&rtc);
 
@@ -698,47 +217,66 @@ ZBX_THREAD_ENTRY(proxypoller_thread, args)
 	{
 		zbx_uint32_t	rtc_cmd;
 		unsigned char	*rtc_data;
+		int		num;
 
 		sec = zbx_time();
 		zbx_update_env(get_process_type_string(process_type), sec);
 
 		if (0 != sleeptime)
 		{
-			zbx_setproctitle("%s #%d [exchanged data with %d proxies in " ZBX_FS_DBL " sec,"
-					" exchanging data]", get_process_type_string(process_type), process_num,
-					old_processed, old_total_sec);
+			zbx_setproctitle("%s #%d [exchanged data with %d proxies in " ZBX_FS_DBL " sec, max latency "
+					ZBX_FS_DBL " sec, exchanging data]", get_process_type_string(process_type),
+					process_num, old_processed, old_total_sec, old_latency_max);
 		}
 
-		processed += process_proxy(proxy_poller_args_in->config_vault, proxy_poller_args_in->config_timeout,
-				proxy_poller_args_in->events_cbs, proxy_poller_args_in->proxyconfig_frequency,
-				proxy_poller_args_in->proxydata_frequency);
+		num = proxy_poller_process_finished(&finished, proxy_poller_args_in->proxyconfig_frequency,
+				proxy_poller_args_in->proxydata_frequency, &latency_max);
+		processing -= num;
+		processed += num;
+
+		if (processing < max_proxies)
+			processing += proxy_poller_start(base, proxies, max_proxies - processing, &config, &finished);
+
 		total_sec += zbx_time() - sec;
 
 		nextcheck = zbx_dc_config_get_proxypoller_nextcheck();
 		sleeptime = zbx_calculate_sleeptime(nextcheck, POLLER_DELAY);
 
+		/* wait for running sessions to free up slots instead of polling the queue */
+		if (0 != finished.values_num)
+			sleeptime = 0;
+		else if (processing >= max_proxies)
+			sleeptime = POLLER_DELAY;
+
 		if (0 != sleeptime || STAT_INTERVAL <= time(NULL) - last_stat_time)
 		{
 			if (0 == sleeptime)
 			{
 				zbx_setproctitle("%s #%d [exchanged data with %d proxies in " ZBX_FS_DBL " sec,"
-						" exchanging data]", get_process_type_string(process_type), process_num,
-						processed, total_sec);
+						" max latency " ZBX_FS_DBL " sec, exchanging data]",
+						get_process_type_string(process_type), process_num, processed, total_sec,
+						latency_max);
 			}
 			else
 			{
 				zbx_setproctitle("%s #%d [exchanged data with %d proxies in " ZBX_FS_DBL " sec,"
-						" idle %d sec]", get_process_type_string(process_type), process_num,
-						processed, total_sec, sleeptime);
+						" max latency " ZBX_FS_DBL " sec, idle %d sec]",
+						get_process_type_string(process_type), process_num, processed, total_sec,
+						latency_max, sleeptime);
 				old_processed = processed;
 				old_total_sec = total_sec;
+				old_latency_max = latency_max;
 			}
 			processed = 0;
 			total_sec = 0.0;
+			latency_max = 0.0;
 			last_stat_time = time(NULL);
 		}
 
-		if (SUCCEED == zbx_rtc_wait(&rtc, info, &rtc_cmd, &rtc_data, sleeptime) && 0 != rtc_cmd)
+		/* proxy sessions are processed while waiting, RTC commands are checked afterwards */
+		proxy_poller_wait(base, ev_timer, sleeptime, info);
+
+		if (SUCCEED == zbx_rtc_wait(&rtc, info, &rtc_cmd, &rtc_data, 0) && 0 != rtc_cmd)
 		{
 			if (ZBX_RTC_SHUTDOWN == rtc_cmd)
 				break;
@@ -37,6 +37,7 @@ typedef struct
 	const zbx_events_funcs_t	*events_cbs;
 	int				proxyconfig_frequency;
 	int				proxydata_frequency;
+	int				config_max_concurrent_proxies_per_poller;
 }
 zbx_thread_proxy_poller_args;
 
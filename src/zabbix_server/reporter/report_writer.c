@@ -37,8 +37,136 @@ typedef struct
 }
 zbx_buffer_t;
 
+/* Rendered reports are cached for a short time, so the same dashboard rendered for the same */
+/* access user and period is requested from web service only once when several reports      */
+/* scheduled at the same time are sent.                                                     */
+#define ZBX_RW_CACHE_TTL	(SEC_PER_MIN * 10)
+#define ZBX_RW_CACHE_SIZE	8
+
+typedef struct
+{
+	char	*url;
+	char	*cookie;
+	int	width;
+	int	height;
+	char	*data;
+	size_t	size;
+	time_t	lastaccess;
+	time_t	created;
+}
+zbx_rw_report_t;
+
+static zbx_vector_ptr_t	rw_cache;
+
+static void	rw_report_free(zbx_rw_report_t *report)
+{
+	zbx_free(report->url);
+	zbx_free(report->cookie);
+	zbx_free(report->data);
+	zbx_free(report);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: find cached report with the same rendering parameters             *
+ *                                                                            *
+ * Parameters: url    - [IN] the report url (includes dashboard and period)   *
+ *             cookie - [IN] the authentication cookie of the access user     *
+ *             width  - [IN] the report width                                 *
+ *             height - [IN] the report height                                *
+ *             now    - [IN] the current time                                 *
+ *                                                                            *
+ * Return value: the cached report or NULL if not found                       *
+ *                                                                            *
+ * Comments: expired reports are removed from cache during lookup.            *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_rw_report_t	*rw_cache_get(const char *url, const char *cookie, int width, int height, time_t now)
+{
+	int		i;
+	zbx_rw_report_t	*report, *found = NULL;
+
+	for (i = 0; i < rw_cache.values_num;)
+	{
+		report = (zbx_rw_report_t *)rw_cache.values[i];
+
+		if (report->created + ZBX_RW_CACHE_TTL <= now || report->created > now)
+		{
+			rw_report_free(report);
+			zbx_vector_ptr_remove_noorder(&rw_cache, i);
+			continue;
+		}
+
+		if (NULL == found && width == report->width && height == report->height &&
+				0 == strcmp(url, report->url) && 0 == strcmp(cookie, report->cookie))
+		{
+			report->lastaccess = now;
+			found = report;
+		}
+
+		i++;
+	}
+
+	return found;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: add rendered report to cache                                      *
+ *                                                                            *
+ * Parameters: url    - [IN] the report url                                   *
+ *             cookie - [IN] the authentication cookie of the access user     *
+ *             width  - [IN] the report width                                 *
+ *             height - [IN] the report height                                *
+ *             data   - [IN] the report contents, owned by cache afterwards   *
+ *             size   - [IN] the report size                                  *
+ *             now    - [IN] the current time                                 *
+ *                                                                            *
+ * Return value: the cached report                                            *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_rw_report_t	*rw_cache_add(const char *url, const char *cookie, int width, int height, char *data,
+		size_t size, time_t now)
+{
+	zbx_rw_report_t	*report;
+
+	if (ZBX_RW_CACHE_SIZE <= rw_cache.values_num)
+	{
+		int	i, lru = 0;
+
+		for (i = 1; i < rw_cache.values_num; i++)
+		{
+			if (((zbx_rw_report_t *)rw_cache.values[i])->lastaccess <
+					((zbx_rw_report_t *)rw_cache.values[lru])->lastaccess)
+			{
+				lru = i;
+			}
+		}
+
+		rw_report_free((zbx_rw_report_t *)rw_cache.values[lru]);
+		zbx_vector_ptr_remove_noorder(&rw_cache, lru);
+	}
+
+	report = (zbx_rw_report_t *)zbx_malloc(NULL, sizeof(zbx_rw_report_t));
+	report->url = zbx_strdup(NULL, url);
+	report->cookie = zbx_strdup(NULL, cookie);
+	report->width = width;
+	report->height = height;
+	report->data = data;
+	report->size = size;
+	report->created = now;
+	report->lastaccess = now;
+
+	zbx_vector_ptr_append(&rw_cache, report);
+
+	return report;
+}
+
 #if defined(HAVE_LIBCURL)
 
+/* web service connection handle, kept between requests to reuse connections */
+static CURL	*rw_curl = NULL;
+
 static size_t	curl_write_cb(void *ptr, size_t size, size_t nmemb, void *userdata)
 {
 	size_t		r_size = size * nmemb, buf_alloc;
@@ -139,11 +267,18 @@ static int	rw_get_report(const char *url, const char *cookie, int width, int hei
 	zbx_json_addstring(&j, "height", buffer, ZBX_JSON_TYPE_STRING);
 	zbx_json_close(&j);
 
-	if (NULL == (curl = curl_easy_init()))
+	if (NULL == rw_curl)
 	{
-		*error = zbx_strdup(NULL, "Cannot initialize cURL library");
-		goto out;
+		if (NULL == (rw_curl = curl_easy_init()))
+		{
+			*error = zbx_strdup(NULL, "Cannot initialize cURL library");
+			goto out;
+		}
 	}
+	else
+		curl_easy_reset(rw_curl);
+
+	curl = rw_curl;
 
 	headers = curl_slist_append(headers, "Content-Type:application/json");
 
@@ -189,6 +324,10 @@ static int	rw_get_report(const char *url, const char *cookie, int width, int hei
 	if (CURLE_OK != (err = curl_easy_perform(curl)))
 	{
 		*error = zbx_dsprintf(*error, "Cannot connect to web service: %s", (curl_error = rw_curl_error(err)));
+
+		/* drop the connection handle so the next request starts with a clean state */
+		curl_easy_cleanup(rw_curl);
+		rw_curl = NULL;
 		goto out;
 	}
 
@@ -240,10 +379,11 @@ out:
 	zbx_free(curl_error);
 	zbx_free(response.data);
 
-	curl_slist_free_all(headers);
+	/* the handle still refers to request specific data, reset it before it's freed */
+	if (NULL != rw_curl)
+		curl_easy_reset(rw_curl);
 
-	if (NULL != curl)
-		curl_easy_cleanup(curl);
+	curl_slist_free_all(headers);
 
 	zbx_json_clean(&j);
 	zbx_free(cookie_value);
@@ -277,6 +417,8 @@ static int	rw_begin_report(zbx_ipc_message_t *msg, zbx_alerter_dispatch_t *dispa
 	const char		*subject = "", *message = "";
 	char			*url, *cookie, *report = NULL, *name;
 	size_t			report_size = 0;
+	time_t			now;
+	zbx_rw_report_t		*cached;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -301,14 +443,26 @@ static int	rw_begin_report(zbx_ipc_message_t *msg, zbx_alerter_dispatch_t *dispa
 		}
 	}
 
-	if (SUCCEED == (ret = rw_get_report(url, cookie, width, height, &report, &report_size, config_tls_ca_file,
-			config_tls_cert_file, config_tls_key_file, config_source_ip, error)))
+	now = time(NULL);
+
+	if (NULL != (cached = rw_cache_get(url, cookie, width, height, now)))
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "%s() using cached report", __func__);
+		ret = SUCCEED;
+	}
+	else if (SUCCEED == (ret = rw_get_report(url, cookie, width, height, &report, &report_size,
+			config_tls_ca_file, config_tls_cert_file, config_tls_key_file, config_source_ip, error)))
+	{
+		cached = rw_cache_add(url, cookie, width, height, report, report_size, now);
+	}
+
+	if (SUCCEED == ret)
 	{
-		ret = zbx_alerter_begin_dispatch(dispatch, subject, message, name, "application/pdf", report,
+		report_size = cached->size;
+		ret = zbx_alerter_begin_dispatch(dispatch, subject, message, name, "application/pdf", cached->data,
 				report_size, error);
 	}
 
-	zbx_free(report);
 	zbx_free(name);
 	zbx_free(url);
 	zbx_free(cookie);
@@ -429,6 +583,7 @@ ZBX_THREAD_ENTRY(report_writer_thread, args)
 	zbx_setproctitle("%s #%d starting", get_process_type_string(process_type), process_num);
 
 	zbx_ipc_message_init(&message);
+	zbx_vector_ptr_create(&rw_cache);
 
 	if (FAIL == zbx_ipc_socket_open(&socket, ZBX_IPC_SERVICE_REPORTER, SEC_PER_MIN, &error))
 	{
@@ -25,12 +25,14 @@
 
 #include "zbxexport.h"
 #include "zbxself.h"
+#include "zbxprof.h"
 
 #include "cfg.h"
 #include "zbxdbupgrade.h"
 #include "log.h"
 #include "zbxgetopt.h"
 #include "zbxmutexs.h"
+#include "zbxshmem.h"
 #include "zbxmodules.h"
 #include "zbxnix.h"
 #include "zbxcomms.h"
@@ -121,8 +123,8 @@ const char	*help_message[] = {
 	"      " ZBX_SECRETS_RELOAD "                  Reload secrets from Vault",
 	"      " ZBX_DIAGINFO "=section                Log internal diagnostic information of the",
 	"                                        section (historycache, preprocessing, alerting,",
-	"                                        lld, valuecache, locks, connector) or everything if section is",
-	"                                        not specified",
+	"                                        lld, valuecache, locks, connector, discovery, profiling) or",
+	"                                        everything if section is not specified",
 	"      " ZBX_PROF_ENABLE "=target              Enable profiling, affects all processes if",
 	"                                        target is not specified",
 	"      " ZBX_PROF_DISABLE "=target             Disable profiling, affects all processes if",
@@ -272,6 +274,10 @@ int	CONFIG_FORKS[ZBX_PROCESS_TYPE_COUNT] = {
 	1, /* ZBX_PROCESS_TYPE_ODBCPOLLER */
 	0, /* ZBX_PROCESS_TYPE_CONNECTORMANAGER */
 	0, /* ZBX_PROCESS_TYPE_CONNECTORWORKER */
+	1, /* ZBX_PROCESS_TYPE_AGENT_POLLER */
+	1, /* ZBX_PROCESS_TYPE_SNMP_POLLER */
+	1, /* ZBX_PROCESS_TYPE_HTTPAGENT_POLLER */
+	1, /* ZBX_PROCESS_TYPE_TRENDWRITER */
 };
 
 static int	get_config_forks(unsigned char process_type)
@@ -308,12 +314,19 @@ static const char	*get_fping6_location(void)
 }
 #endif
 
+static int	config_native_icmpping = 0;
+static int	get_native_icmpping(void)
+{
+	return config_native_icmpping;
+}
+
 ZBX_PROPERTY_DECL_CONST(char *, zbx_config_alert_scripts_path, NULL)
 ZBX_PROPERTY_DECL(int, zbx_config_timeout, 3)
 
 static int	config_startup_time		= 0;
 static int	config_unavailable_delay	= 60;
 static int	config_histsyncer_frequency	= 1;
+static int	config_histsyncer_min		= 0;
 
 int	CONFIG_LISTEN_PORT		= ZBX_DEFAULT_SERVER_PORT;
 char	*CONFIG_LISTEN_IP		= NULL;
@@ -322,10 +335,13 @@ static char	*config_server		= NULL;		/* not used in zabbix_server, required for
 
 int	CONFIG_HOUSEKEEPING_FREQUENCY	= 1;
 int	CONFIG_MAX_HOUSEKEEPER_DELETE	= 5000;		/* applies for every separate field value */
+int	CONFIG_HOUSEKEEPING_PARTITIONS	= 0;
 int	CONFIG_CONFSYNCER_FREQUENCY	= 10;
 
 int	CONFIG_PROBLEMHOUSEKEEPING_FREQUENCY = 60;
 
+static int	config_availability_flush_delay = 5;
+
 int	CONFIG_VMWARE_FREQUENCY		= 60;
 int	CONFIG_VMWARE_PERF_FREQUENCY	= 60;
 int	CONFIG_VMWARE_TIMEOUT		= 10;
@@ -333,13 +349,27 @@ int	CONFIG_VMWARE_TIMEOUT		= 10;
 static zbx_uint64_t	config_conf_cache_size		= 32 * ZBX_MEBIBYTE;
 static zbx_uint64_t	config_history_cache_size	= 16 * ZBX_MEBIBYTE;
 static zbx_uint64_t	config_history_index_cache_size	= 4 * ZBX_MEBIBYTE;
+static int		config_history_cache_shards	= 1;
+static zbx_uint64_t	config_history_ingest_ring_size	= 0;
 static zbx_uint64_t	config_trends_cache_size	= 4 * ZBX_MEBIBYTE;
 static zbx_uint64_t	CONFIG_TREND_FUNC_CACHE_SIZE	= 4 * ZBX_MEBIBYTE;
+static int		config_shmem_huge_pages		= 0;
 static zbx_uint64_t	config_value_cache_size		= 8 * ZBX_MEBIBYTE;
+static zbx_uint64_t	config_tls_session_cache_size	= 0;
+static char		*config_vc_snapshot_file	= NULL;
+static int		config_vc_snapshot_period	= 0;
+static int		config_ha_standby_config_sync	= 0;
+
+/* configuration cache kept in sync by the main process of standby node */
+static int		standby_config_cache_created	= 0;
+static int		standby_config_cache_synced	= 0;
 zbx_uint64_t	CONFIG_VMWARE_CACHE_SIZE	= 8 * ZBX_MEBIBYTE;
 
 static int	config_unreachable_period	= 45;
 static int	config_unreachable_delay	= 15;
+static int	config_max_concurrent_checks_per_poller	= 1000;
+static int	config_max_concurrent_proxies_per_poller	= 100;
+static int	config_max_concurrent_trapper_connections	= 0;
 int	CONFIG_LOG_LEVEL		= LOG_LEVEL_WARNING;
 char	*CONFIG_EXTERNALSCRIPTS		= NULL;
 int	CONFIG_ALLOW_UNSUPPORTED_DB_VERSIONS = 0;
@@ -349,6 +379,7 @@ ZBX_PROPERTY_DECL(int, zbx_config_log_remote_commands, 0)
 ZBX_PROPERTY_DECL(int, zbx_config_unsafe_user_parameters, 0)
 
 char	*CONFIG_SNMPTRAP_FILE		= NULL;
+char	*CONFIG_SNMPTRAP_SOCKET		= NULL;
 
 char	*CONFIG_JAVA_GATEWAY		= NULL;
 int	CONFIG_JAVA_GATEWAY_PORT	= ZBX_DEFAULT_GATEWAY_PORT;
@@ -373,7 +404,7 @@ char	*CONFIG_SSL_KEY_LOCATION	= NULL;
 
 static zbx_config_tls_t		*zbx_config_tls = NULL;
 static zbx_config_export_t	zbx_config_export = {NULL, NULL, ZBX_GIBIBYTE};
-static zbx_config_vault_t	zbx_config_vault = {NULL, NULL, NULL, NULL, NULL, NULL};
+static zbx_config_vault_t	zbx_config_vault = {NULL, NULL, NULL, NULL, NULL, NULL, SEC_PER_MIN};
 static zbx_config_dbhigh_t	*zbx_config_dbhigh = NULL;
 
 char	*CONFIG_HA_NODE_NAME		= NULL;
@@ -404,7 +435,8 @@ static	const zbx_events_funcs_t	events_cbs = {
 	.clean_events_cb		= zbx_clean_events,
 	.reset_event_recovery_cb	= zbx_reset_event_recovery,
 	.export_events_cb		= zbx_export_events,
-	.events_update_itservices_cb	= zbx_events_update_itservices
+	.events_update_itservices_cb	= zbx_events_update_itservices,
+	.events_notify_escalators_cb	= zbx_events_notify_escalators
 };
 
 int	get_process_info_by_thread(int local_server_num, unsigned char *local_process_type, int *local_process_num);
@@ -592,6 +624,26 @@ int	get_process_info_by_thread(int local_server_num, unsigned char *local_proces
 		*local_process_type = ZBX_PROCESS_TYPE_CONNECTORWORKER;
 		*local_process_num = local_server_num - server_count + CONFIG_FORKS[ZBX_PROCESS_TYPE_CONNECTORWORKER];
 	}
+	else if (local_server_num <= (server_count += CONFIG_FORKS[ZBX_PROCESS_TYPE_AGENT_POLLER]))
+	{
+		*local_process_type = ZBX_PROCESS_TYPE_AGENT_POLLER;
+		*local_process_num = local_server_num - server_count + CONFIG_FORKS[ZBX_PROCESS_TYPE_AGENT_POLLER];
+	}
+	else if (local_server_num <= (server_count += CONFIG_FORKS[ZBX_PROCESS_TYPE_SNMP_POLLER]))
+	{
+		*local_process_type = ZBX_PROCESS_TYPE_SNMP_POLLER;
+		*local_process_num = local_server_num - server_count + CONFIG_FORKS[ZBX_PROCESS_TYPE_SNMP_POLLER];
+	}
+	else if (local_server_num <= (server_count += CONFIG_FORKS[ZBX_PROCESS_TYPE_HTTPAGENT_POLLER]))
+	{
+		*local_process_type = ZBX_PROCESS_TYPE_HTTPAGENT_POLLER;
+		*local_process_num = local_server_num - server_count + CONFIG_FORKS[ZBX_PROCESS_TYPE_HTTPAGENT_POLLER];
+	}
+	else if (local_server_num <= (server_count += CONFIG_FORKS[ZBX_PROCESS_TYPE_TRENDWRITER]))
+	{
+		*local_process_type = ZBX_PROCESS_TYPE_TRENDWRITER;
+		*local_process_num = local_server_num - server_count + CONFIG_FORKS[ZBX_PROCESS_TYPE_TRENDWRITER];
+	}
 
 	else
 		return FAIL;
@@ -611,6 +663,9 @@ static void	zbx_set_defaults(void)
 	if (NULL == zbx_config_dbhigh->config_dbhost)
 		zbx_config_dbhigh->config_dbhost = zbx_strdup(zbx_config_dbhigh->config_dbhost, "localhost");
 
+	if (0 == zbx_config_dbhigh->config_dbreplica_max_lag)
+		zbx_config_dbhigh->config_dbreplica_max_lag = SEC_PER_MIN;
+
 	if (NULL == CONFIG_SNMPTRAP_FILE)
 		CONFIG_SNMPTRAP_FILE = zbx_strdup(CONFIG_SNMPTRAP_FILE, "/tmp/zabbix_traps.tmp");
 
@@ -657,6 +712,14 @@ static void	zbx_set_defaults(void)
 
 	if (0 != CONFIG_FORKS[ZBX_PROCESS_TYPE_IPMIPOLLER])
 		CONFIG_FORKS[ZBX_PROCESS_TYPE_IPMIMANAGER] = 1;
+#ifndef HAVE_NETSNMP
+	/* without SNMP support SNMP items are left to regular pollers that report them as not supported */
+	CONFIG_FORKS[ZBX_PROCESS_TYPE_SNMP_POLLER] = 0;
+#endif
+#ifndef HAVE_LIBCURL
+	/* without cURL support HTTP agent items are left to regular pollers that report them as not supported */
+	CONFIG_FORKS[ZBX_PROCESS_TYPE_HTTPAGENT_POLLER] = 0;
+#endif
 
 	if (NULL == zbx_config_vault.url)
 		zbx_config_vault.url = zbx_strdup(zbx_config_vault.url, "https://127.0.0.1:8200");
@@ -683,10 +746,11 @@ static void	zbx_validate_config(ZBX_TASK_EX *task)
 	unsigned short	port;
 
 	if (0 == CONFIG_FORKS[ZBX_PROCESS_TYPE_UNREACHABLE] &&
-			0 != CONFIG_FORKS[ZBX_PROCESS_TYPE_POLLER] + CONFIG_FORKS[ZBX_PROCESS_TYPE_JAVAPOLLER])
+			0 != CONFIG_FORKS[ZBX_PROCESS_TYPE_POLLER] + CONFIG_FORKS[ZBX_PROCESS_TYPE_JAVAPOLLER] +
+			CONFIG_FORKS[ZBX_PROCESS_TYPE_AGENT_POLLER] + CONFIG_FORKS[ZBX_PROCESS_TYPE_SNMP_POLLER])
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "\"StartPollersUnreachable\" configuration parameter must not be 0"
-				" if regular or Java pollers are started");
+				" if regular, Java, agent or SNMP pollers are started");
 		err = 1;
 	}
 
@@ -711,6 +775,13 @@ static void	zbx_validate_config(ZBX_TASK_EX *task)
 		err = 1;
 	}
 
+	if (config_histsyncer_min > CONFIG_FORKS[ZBX_PROCESS_TYPE_HISTSYNCER])
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "\"StartDBSyncersMin\" configuration parameter must not be greater"
+				" than \"StartDBSyncers\"");
+		err = 1;
+	}
+
 	if (NULL != CONFIG_SOURCE_IP && SUCCEED != zbx_is_supported_ip(CONFIG_SOURCE_IP))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "invalid \"SourceIP\" configuration parameter: '%s'", CONFIG_SOURCE_IP);
@@ -770,6 +841,17 @@ static void	zbx_validate_config(ZBX_TASK_EX *task)
 	if (SUCCEED != zbx_validate_log_parameters(task, &log_file_cfg))
 		err = 1;
 
+#if !(defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL))
+	err |= (FAIL == check_cfg_feature_int("TLSSessionCacheSize", 0 != config_tls_session_cache_size,
+			"TLS support"));
+#else
+	if (0 != config_tls_session_cache_size && 128 * ZBX_KIBIBYTE > config_tls_session_cache_size)
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "\"TLSSessionCacheSize\" configuration parameter must be either 0"
+				" or greater than 128KB");
+		err = 1;
+	}
+#endif
 #if !(defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL))
 	err |= (FAIL == check_cfg_feature_str("TLSCAFile", zbx_config_tls->ca_file, "TLS support"));
 	err |= (FAIL == check_cfg_feature_str("TLSCRLFile", zbx_config_tls->crl_file, "TLS support"));
@@ -825,6 +907,8 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			MANDATORY,	MIN,			MAX */
 		{"StartDBSyncers",		&CONFIG_FORKS[ZBX_PROCESS_TYPE_HISTSYNCER],		TYPE_INT,
 			PARM_OPT,	1,			100},
+		{"StartDBSyncersMin",		&config_histsyncer_min,			TYPE_INT,
+			PARM_OPT,	0,			100},
 		{"StartDiscoverers",		&CONFIG_FORKS[ZBX_PROCESS_TYPE_DISCOVERER],		TYPE_INT,
 			PARM_OPT,	0,			250},
 		{"StartHTTPPollers",		&CONFIG_FORKS[ZBX_PROCESS_TYPE_HTTPPOLLER],		TYPE_INT,
@@ -851,6 +935,8 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	1024,			32767},
 		{"SNMPTrapperFile",		&CONFIG_SNMPTRAP_FILE,			TYPE_STRING,
 			PARM_OPT,	0,			0},
+		{"SNMPTrapperSocket",		&CONFIG_SNMPTRAP_SOCKET,		TYPE_STRING,
+			PARM_OPT,	0,			0},
 		{"StartSNMPTrapper",		&CONFIG_FORKS[ZBX_PROCESS_TYPE_SNMPTRAPPER],		TYPE_INT,
 			PARM_OPT,	0,			1},
 		{"CacheSize",			&config_conf_cache_size,		TYPE_UINT64,
@@ -859,24 +945,38 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	128 * ZBX_KIBIBYTE,	__UINT64_C(2) * ZBX_GIBIBYTE},
 		{"HistoryIndexCacheSize",	&config_history_index_cache_size,	TYPE_UINT64,
 			PARM_OPT,	128 * ZBX_KIBIBYTE,	__UINT64_C(2) * ZBX_GIBIBYTE},
+		{"HistoryCacheShards",		&config_history_cache_shards,		TYPE_INT,
+			PARM_OPT,	1,			ZBX_HC_SHARDS_MAX},
+		{"HistoryIngestRingSize",	&config_history_ingest_ring_size,	TYPE_UINT64,
+			PARM_OPT,	0,			__UINT64_C(64) * ZBX_MEBIBYTE},
+		{"SharedMemoryHugePages",	&config_shmem_huge_pages,		TYPE_INT,
+			PARM_OPT,	0,			1},
 		{"TrendCacheSize",		&config_trends_cache_size,		TYPE_UINT64,
 			PARM_OPT,	128 * ZBX_KIBIBYTE,	__UINT64_C(2) * ZBX_GIBIBYTE},
 		{"TrendFunctionCacheSize",	&CONFIG_TREND_FUNC_CACHE_SIZE,		TYPE_UINT64,
 			PARM_OPT,	0,			__UINT64_C(2) * ZBX_GIBIBYTE},
 		{"ValueCacheSize",		&config_value_cache_size,		TYPE_UINT64,
 			PARM_OPT,	0,			__UINT64_C(64) * ZBX_GIBIBYTE},
+		{"ValueCacheSnapshotFile",	&config_vc_snapshot_file,		TYPE_STRING,
+			PARM_OPT,	0,			0},
+		{"ValueCacheSnapshotPeriod",	&config_vc_snapshot_period,		TYPE_INT,
+			PARM_OPT,	0,			SEC_PER_DAY},
 		{"CacheUpdateFrequency",	&CONFIG_CONFSYNCER_FREQUENCY,		TYPE_INT,
 			PARM_OPT,	1,			SEC_PER_HOUR},
 		{"HousekeepingFrequency",	&CONFIG_HOUSEKEEPING_FREQUENCY,		TYPE_INT,
 			PARM_OPT,	0,			24},
 		{"MaxHousekeeperDelete",	&CONFIG_MAX_HOUSEKEEPER_DELETE,		TYPE_INT,
 			PARM_OPT,	0,			1000000},
+		{"HousekeepingPartitions",	&CONFIG_HOUSEKEEPING_PARTITIONS,	TYPE_INT,
+			PARM_OPT,	0,			1},
 		{"TmpDir",			&CONFIG_TMPDIR,				TYPE_STRING,
 			PARM_OPT,	0,			0},
 		{"FpingLocation",		&CONFIG_FPING_LOCATION,			TYPE_STRING,
 			PARM_OPT,	0,			0},
 		{"Fping6Location",		&CONFIG_FPING6_LOCATION,		TYPE_STRING,
 			PARM_OPT,	0,			0},
+		{"NativeICMPPing",		&config_native_icmpping,		TYPE_INT,
+			PARM_OPT,	0,			1},
 		{"Timeout",			&zbx_config_timeout,			TYPE_INT,
 			PARM_OPT,	1,			30},
 		{"TrapperTimeout",		&CONFIG_TRAPPER_TIMEOUT,		TYPE_INT,
@@ -929,6 +1029,8 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	0,			0},
 		{"VaultDBPath",			&(zbx_config_vault.db_path),		TYPE_STRING,
 			PARM_OPT,	0,			0},
+		{"VaultSecretsTTL",		&(zbx_config_vault.secrets_ttl),	TYPE_INT,
+			PARM_OPT,	0,			SEC_PER_DAY},
 		{"DBSocket",			&(zbx_config_dbhigh->config_dbsocket),	TYPE_STRING,
 			PARM_OPT,	0,			0},
 		{"DBPort",			&(zbx_config_dbhigh->config_dbport),	TYPE_INT,
@@ -947,6 +1049,16 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	0,			0},
 		{"DBTLSCipher13",		&(zbx_config_dbhigh->config_db_tls_cipher_13),	TYPE_STRING,
 			PARM_OPT,	0,			0},
+		{"DBReplicaHost",		&(zbx_config_dbhigh->config_dbreplica_host),	TYPE_STRING,
+			PARM_OPT,	0,			0},
+		{"DBReplicaPort",		&(zbx_config_dbhigh->config_dbreplica_port),	TYPE_INT,
+			PARM_OPT,	1024,			65535},
+		{"DBReplicaMaxLag",		&(zbx_config_dbhigh->config_dbreplica_max_lag),	TYPE_INT,
+			PARM_OPT,	10,			SEC_PER_HOUR},
+		{"DBIdleTimeout",		&(zbx_config_dbhigh->config_db_idle_timeout),	TYPE_INT,
+			PARM_OPT,	0,			SEC_PER_HOUR},
+		{"DBPreparedInserts",		&(zbx_config_dbhigh->config_db_prepared_inserts),	TYPE_INT,
+			PARM_OPT,	0,			1},
 		{"SSHKeyLocation",		&CONFIG_SSH_KEY_LOCATION,		TYPE_STRING,
 			PARM_OPT,	0,			0},
 		{"LogSlowQueries",		&config_log_slow_queries,		TYPE_INT,
@@ -1001,6 +1113,8 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	0,			0},
 		{"TLSCipherAll",		&(zbx_config_tls->cipher_all),		TYPE_STRING,
 			PARM_OPT,	0,			0},
+		{"TLSSessionCacheSize",		&config_tls_session_cache_size,		TYPE_UINT64,
+			PARM_OPT,	0,			__UINT64_C(2) * ZBX_GIBIBYTE},
 		{"SocketDir",			&CONFIG_SOCKET_PATH,			TYPE_STRING,
 			PARM_OPT,	0,			0},
 		{"StartAlerters",		&CONFIG_FORKS[ZBX_PROCESS_TYPE_ALERTER],			TYPE_INT,
@@ -1031,6 +1145,8 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	0,			0},
 		{"ProblemHousekeepingFrequency",	&CONFIG_PROBLEMHOUSEKEEPING_FREQUENCY,	TYPE_INT,
 			PARM_OPT,	1,			3600},
+		{"AvailabilityFlushDelay",	&config_availability_flush_delay,	TYPE_INT,
+			PARM_OPT,	1,			60},
 		{"ServiceManagerSyncFrequency",	&CONFIG_SERVICEMAN_SYNC_FREQUENCY,	TYPE_INT,
 			PARM_OPT,	1,			3600},
 		{"ListenBacklog",		&CONFIG_TCP_MAX_BACKLOG_SIZE,		TYPE_INT,
@@ -1039,8 +1155,24 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	0,			0},
 		{"NodeAddress",			&CONFIG_NODE_ADDRESS,		TYPE_STRING,
 			PARM_OPT,	0,			0},
+		{"HAStandbyConfigSync",		&config_ha_standby_config_sync,		TYPE_INT,
+			PARM_OPT,	0,			1},
 		{"StartODBCPollers",		&CONFIG_FORKS[ZBX_PROCESS_TYPE_ODBCPOLLER],		TYPE_INT,
 			PARM_OPT,	0,			1000},
+		{"StartAgentPollers",		&CONFIG_FORKS[ZBX_PROCESS_TYPE_AGENT_POLLER],		TYPE_INT,
+			PARM_OPT,	0,			1000},
+		{"StartSNMPPollers",		&CONFIG_FORKS[ZBX_PROCESS_TYPE_SNMP_POLLER],		TYPE_INT,
+			PARM_OPT,	0,			1000},
+		{"StartHTTPAgentPollers",	&CONFIG_FORKS[ZBX_PROCESS_TYPE_HTTPAGENT_POLLER],	TYPE_INT,
+			PARM_OPT,	0,			1000},
+		{"StartTrendWriters",		&CONFIG_FORKS[ZBX_PROCESS_TYPE_TRENDWRITER],		TYPE_INT,
+			PARM_OPT,	0,			1},
+		{"MaxConcurrentChecksPerPoller",	&config_max_concurrent_checks_per_poller,	TYPE_INT,
+			PARM_OPT,	1,			1000},
+		{"MaxConcurrentProxiesPerPoller",	&config_max_concurrent_proxies_per_poller,	TYPE_INT,
+			PARM_OPT,	1,			1000},
+		{"MaxConcurrentTrapperConnections",	&config_max_concurrent_trapper_connections,	TYPE_INT,
+			PARM_OPT,	0,			10000},
 		{"StartConnectors",		&CONFIG_FORKS[ZBX_PROCESS_TYPE_CONNECTORWORKER],	TYPE_INT,
 			PARM_OPT,	0,			1000},
 		{NULL}
@@ -1083,6 +1215,60 @@ static const char	*get_pid_file_path(void)
 	return CONFIG_PID_FILE;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: saves value cache contents into snapshot file                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	server_save_vc_snapshot(void)
+{
+	char	*error = NULL;
+
+	if (SUCCEED != zbx_vc_snapshot_save(config_vc_snapshot_file, &error))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot save value cache snapshot: %s", error);
+		zbx_free(error);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: keep configuration cache in sync while node is in standby mode    *
+ *                                                                            *
+ * Comments: The cache is created and loaded by the main process, so after    *
+ *           failover configuration syncer only has to apply the changes made *
+ *           since the last sync instead of loading whole configuration.      *
+ *                                                                            *
+ ******************************************************************************/
+static void	server_sync_standby_config(void)
+{
+	char	*error = NULL;
+
+	if (0 == standby_config_cache_created)
+	{
+		if (SUCCEED != zbx_init_configuration_cache(get_program_type, get_config_forks,
+				config_conf_cache_size, &error))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot initialize configuration cache on standby node: %s",
+					error);
+			zbx_free(error);
+			config_ha_standby_config_sync = 0;
+			return;
+		}
+
+		standby_config_cache_created = 1;
+	}
+
+	if (ZBX_DB_OK != zbx_db_connect(ZBX_DB_CONNECT_ONCE))
+		return;
+
+	zbx_dc_sync_configuration_standby(0 == standby_config_cache_synced ? ZBX_DBSYNC_INIT : ZBX_DBSYNC_UPDATE,
+			&zbx_config_vault, config_proxyconfig_frequency);
+	standby_config_cache_synced = 1;
+
+	zbx_db_close();
+}
+
 static void	zbx_on_exit(int ret)
 {
 	char	*error = NULL;
@@ -1117,6 +1303,9 @@ static void	zbx_on_exit(int ret)
 
 		zbx_free_configuration_cache();
 
+		if (SUCCEED == ret && NULL != config_vc_snapshot_file)
+			server_save_vc_snapshot();
+
 		/* free history value cache */
 		zbx_vc_destroy();
 
@@ -1124,6 +1313,7 @@ static void	zbx_on_exit(int ret)
 		zbx_vmware_destroy();
 
 		zbx_free_selfmon_collector();
+		zbx_prof_probes_destroy();
 	}
 
 	zbx_uninitialize_events();
@@ -1168,7 +1358,8 @@ int	main(int argc, char **argv)
 #ifdef HAVE_IPV6
 		get_fping6_location,
 #endif
-		get_tmpdir};
+		get_tmpdir,
+		get_native_icmpping};
 
 	ZBX_TASK_EX			t = {ZBX_TASK_START};
 	char				ch;
@@ -1263,7 +1454,7 @@ int	main(int argc, char **argv)
 	zbx_init_library_sysinfo(get_zbx_config_timeout, get_zbx_config_enable_remote_commands,
 			get_zbx_config_log_remote_commands, get_zbx_config_unsafe_user_parameters);
 	zbx_init_library_dbhigh(zbx_config_dbhigh);
-	zbx_init_library_preproc(preproc_flush_value_server);
+	zbx_init_library_preproc(preproc_flush_value_server, zbx_lld_queue_flush);
 
 	if (ZBX_TASK_RUNTIME_CONTROL == t.task)
 	{
@@ -1408,14 +1599,17 @@ static int	server_startup(zbx_socket_t *listen_sock, int *ha_stat, int *ha_failo
 
 	zbx_thread_poller_args		poller_args = {&config_comms, get_program_type, ZBX_NO_POLLER,
 							config_startup_time, config_unavailable_delay,
-							config_unreachable_period, config_unreachable_delay};
+							config_unreachable_period, config_unreachable_delay,
+							config_max_concurrent_checks_per_poller};
 	zbx_thread_trapper_args		trapper_args = {&config_comms, &zbx_config_vault, get_program_type,
 							&events_cbs, listen_sock, config_startup_time,
-							config_proxydata_frequency};
+							config_proxydata_frequency,
+							config_max_concurrent_trapper_connections};
 	zbx_thread_escalator_args	escalator_args = {zbx_config_tls, get_program_type, zbx_config_timeout};
 	zbx_thread_proxy_poller_args	proxy_poller_args = {zbx_config_tls, &zbx_config_vault, get_program_type,
 							zbx_config_timeout, &events_cbs, config_proxyconfig_frequency,
-							config_proxydata_frequency};
+							config_proxydata_frequency,
+							config_max_concurrent_proxies_per_poller};
 	zbx_thread_discoverer_args	discoverer_args = {zbx_config_tls, get_program_type, zbx_config_timeout,
 							&events_cbs};
 	zbx_thread_report_writer_args	report_writer_args = {zbx_config_tls->ca_file, zbx_config_tls->cert_file,
@@ -1425,7 +1619,8 @@ static int	server_startup(zbx_socket_t *listen_sock, int *ha_stat, int *ha_failo
 	zbx_thread_server_trigger_housekeeper_args	trigger_housekeeper_args = {zbx_config_timeout};
 	zbx_thread_taskmanager_args	taskmanager_args = {zbx_config_timeout, config_startup_time};
 	zbx_thread_dbconfig_args	dbconfig_args = {&zbx_config_vault, zbx_config_timeout,
-							config_proxyconfig_frequency, config_proxydata_frequency};
+							config_proxyconfig_frequency, config_proxydata_frequency,
+							standby_config_cache_synced};
 	zbx_thread_pinger_args		pinger_args = {zbx_config_timeout};
 	zbx_thread_pp_manager_args	preproc_man_args = {
 						.workers_num = CONFIG_FORKS[ZBX_PROCESS_TYPE_PREPROCESSOR]};
@@ -1439,23 +1634,31 @@ static int	server_startup(zbx_socket_t *listen_sock, int *ha_stat, int *ha_failo
 			zbx_config_dbhigh};
 	zbx_thread_lld_manager_args	lld_manager_args = {get_config_forks};
 	zbx_thread_connector_manager_args	connector_manager_args = {get_config_forks};
-	zbx_thread_dbsyncer_args		dbsyncer_args = {&events_cbs, config_histsyncer_frequency};
+	zbx_thread_avail_manager_args		avail_manager_args = {config_availability_flush_delay};
+	zbx_thread_dbsyncer_args		dbsyncer_args = {&events_cbs, config_histsyncer_frequency,
+			CONFIG_FORKS[ZBX_PROCESS_TYPE_HISTSYNCER], config_histsyncer_min};
 
 	if (SUCCEED != zbx_init_database_cache(get_program_type, config_history_cache_size,
-			config_history_index_cache_size, config_trends_cache_size, &error))
+			config_history_index_cache_size, config_trends_cache_size,
+			config_history_cache_shards, &error))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize database cache: %s", error);
 		zbx_free(error);
 		return FAIL;
 	}
 
-	if (SUCCEED != zbx_init_configuration_cache(get_program_type, get_config_forks, config_conf_cache_size, &error))
+	/* configuration cache created on standby node is handed over to configuration syncer */
+	if (0 == standby_config_cache_created && SUCCEED != zbx_init_configuration_cache(get_program_type,
+			get_config_forks, config_conf_cache_size, &error))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize configuration cache: %s", error);
 		zbx_free(error);
 		return FAIL;
 	}
 
+	standby_config_cache_created = 0;
+	standby_config_cache_synced = 0;
+
 	if (SUCCEED != zbx_init_selfmon_collector(get_config_forks, &error))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize self-monitoring: %s", error);
@@ -1463,6 +1666,13 @@ static int	server_startup(zbx_socket_t *listen_sock, int *ha_stat, int *ha_failo
 		return FAIL;
 	}
 
+	if (SUCCEED != zbx_prof_probes_init(&error))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize profiling probes: %s", error);
+		zbx_free(error);
+		return FAIL;
+	}
+
 	if (0 != CONFIG_FORKS[ZBX_PROCESS_TYPE_VMWARE] && SUCCEED != zbx_vmware_init(&error))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize VMware cache: %s", error);
@@ -1477,12 +1687,34 @@ static int	server_startup(zbx_socket_t *listen_sock, int *ha_stat, int *ha_failo
 		return FAIL;
 	}
 
+	if (NULL != config_vc_snapshot_file)
+	{
+		zbx_db_connect(ZBX_DB_CONNECT_NORMAL);
+
+		if (SUCCEED != zbx_vc_snapshot_load(config_vc_snapshot_file, &error))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot load value cache snapshot: %s", error);
+			zbx_free(error);
+		}
+
+		zbx_db_close();
+	}
+
 	if (SUCCEED != zbx_tfc_init(CONFIG_TREND_FUNC_CACHE_SIZE, &error))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize trends read cache: %s", error);
 		zbx_free(error);
 		return FAIL;
 	}
+#if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
+	if (0 != config_tls_session_cache_size && SUCCEED != zbx_tls_session_cache_init(
+			config_tls_session_cache_size, &error))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize TLS session cache: %s", error);
+		zbx_free(error);
+		return FAIL;
+	}
+#endif
 
 	if (0 != CONFIG_FORKS[ZBX_PROCESS_TYPE_CONNECTORMANAGER])
 		zbx_connector_init();
@@ -1506,6 +1738,13 @@ static int	server_startup(zbx_socket_t *listen_sock, int *ha_stat, int *ha_failo
 		threads_num += CONFIG_FORKS[i];
 	}
 
+	if (SUCCEED != zbx_init_history_ingest(config_history_ingest_ring_size, threads_num, &error))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize history ingestion rings: %s", error);
+		zbx_free(error);
+		return FAIL;
+	}
+
 	threads = (pid_t *)zbx_calloc(threads, (size_t)threads_num, sizeof(pid_t));
 	threads_flags = (int *)zbx_calloc(threads_flags, (size_t)threads_num, sizeof(int));
 
@@ -1672,6 +1911,7 @@ static int	server_startup(zbx_socket_t *listen_sock, int *ha_stat, int *ha_failo
 				break;
 			case ZBX_PROCESS_TYPE_AVAILMAN:
 				threads_flags[i] = ZBX_THREAD_PRIORITY_FIRST;
+				thread_args.args = &avail_manager_args;
 				zbx_thread_start(zbx_availability_manager_thread, &thread_args, &threads[i]);
 				break;
 			case ZBX_PROCESS_TYPE_CONNECTORMANAGER:
@@ -1698,6 +1938,25 @@ static int	server_startup(zbx_socket_t *listen_sock, int *ha_stat, int *ha_failo
 				thread_args.args = &poller_args;
 				zbx_thread_start(poller_thread, &thread_args, &threads[i]);
 				break;
+			case ZBX_PROCESS_TYPE_AGENT_POLLER:
+				poller_args.poller_type = ZBX_POLLER_TYPE_AGENT;
+				thread_args.args = &poller_args;
+				zbx_thread_start(poller_thread, &thread_args, &threads[i]);
+				break;
+			case ZBX_PROCESS_TYPE_SNMP_POLLER:
+				poller_args.poller_type = ZBX_POLLER_TYPE_SNMP;
+				thread_args.args = &poller_args;
+				zbx_thread_start(poller_thread, &thread_args, &threads[i]);
+				break;
+			case ZBX_PROCESS_TYPE_HTTPAGENT_POLLER:
+				poller_args.poller_type = ZBX_POLLER_TYPE_HTTPAGENT;
+				thread_args.args = &poller_args;
+				zbx_thread_start(poller_thread, &thread_args, &threads[i]);
+				break;
+			case ZBX_PROCESS_TYPE_TRENDWRITER:
+				thread_args.args = &dbsyncer_args;
+				zbx_thread_start(zbx_trendwriter_thread, &thread_args, &threads[i]);
+				break;
 		}
 	}
 
@@ -1785,9 +2044,13 @@ static void	server_teardown(zbx_rtc_t *rtc, zbx_socket_t *listen_sock)
 
 	/* destroy shared caches */
 	zbx_tfc_destroy();
+#if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
+	zbx_tls_session_cache_destroy();
+#endif
 	zbx_vc_destroy();
 	zbx_vmware_destroy();
 	zbx_free_selfmon_collector();
+	zbx_prof_probes_destroy();
 	zbx_free_configuration_cache();
 	zbx_free_database_cache(ZBX_SYNC_NONE, &events_cbs);
 #ifdef HAVE_PTHREAD_PROCESS_SHARED
@@ -1856,7 +2119,7 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 	int		i, db_type, ret, ha_status_old;
 
 	zbx_socket_t	listen_sock;
-	time_t		standby_warning_time;
+	time_t		standby_warning_time, vc_snapshot_time, standby_sync_time = 0;
 	zbx_rtc_t	rtc;
 	zbx_timespec_t	rtc_timeout = {1, 0};
 	zbx_ha_config_t	*ha_config = NULL;
@@ -1970,6 +2233,8 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 
 	zbx_free_config();
 
+	zbx_shmem_set_huge_pages(config_shmem_huge_pages);
+
 	if (SUCCEED != zbx_rtc_init(&rtc, &error))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize runtime control service: %s", error);
@@ -2020,7 +2285,8 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 	}
 
 	if (SUCCEED != zbx_init_database_cache(get_program_type, config_history_cache_size,
-			config_history_index_cache_size, config_trends_cache_size, &error))
+			config_history_index_cache_size, config_trends_cache_size,
+			config_history_cache_shards, &error))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize database cache: %s", error);
 		zbx_free(error);
@@ -2112,6 +2378,7 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 	}
 
 	ha_status_old = ha_status;
+	vc_snapshot_time = time(NULL);
 
 	if (ZBX_NODE_STATUS_STANDBY == ha_status)
 		standby_warning_time = time(NULL);
@@ -2200,8 +2467,21 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 			}
 		}
 
+		if (ZBX_NODE_STATUS_ACTIVE == ha_status && NULL != config_vc_snapshot_file &&
+				0 != config_vc_snapshot_period && vc_snapshot_time + config_vc_snapshot_period <= now)
+		{
+			server_save_vc_snapshot();
+			vc_snapshot_time = now;
+		}
+
 		if (ZBX_NODE_STATUS_STANDBY == ha_status)
 		{
+			if (0 != config_ha_standby_config_sync && standby_sync_time + CONFIG_CONFSYNCER_FREQUENCY <= now)
+			{
+				server_sync_standby_config();
+				standby_sync_time = time(NULL);
+			}
+
 			if (standby_warning_time + SEC_PER_HOUR <= now)
 			{
 				zabbix_log(LOG_LEVEL_INFORMATION, "\"%s\" node is working in \"%s\" mode",
@@ -31,6 +31,7 @@
 #include "zbxexpr.h"
 #include "zbxcacheconfig.h"
 #include "zbx_trigger_constants.h"
+#include "zbxrtc.h"
 
 extern int				CONFIG_SERVICEMAN_SYNC_FREQUENCY;
 
@@ -1923,21 +1924,30 @@ void	service_get_rootcause_eventids(const zbx_service_t *parent, zbx_vector_uint
  *                                                                            *
  * Purpose: updates service and its parents statuses                          *
  *                                                                            *
- * Parameters: service    - [IN] the service to update                        *
- *             ts         - [IN] the update timestamp                         *
- *             alarms     - [OUT] the alarms update queue                     *
+ * Parameters: service      - [IN] the service to update                      *
+ *             ts           - [IN] the update timestamp                       *
+ *             alarms       - [OUT] the alarms update queue                   *
+ *             recalculated - [IN/OUT] services already recalculated during   *
+ *                                     recalculation pass                     *
  *                                                                            *
  * Comments: This function recalculates service status according to the       *
  *           algorithm and status of the children services. If the status     *
  *           has been changed, an alarm is generated and parent services      *
  *           (up until the root service) are updated too.                     *
  *                                                                            *
+ *           During recalculation pass parents are updated also when status   *
+ *           has not changed, but only if they were not recalculated yet -    *
+ *           afterwards they depend only on status changes of children.       *
+ *                                                                            *
  ******************************************************************************/
 static void	its_itservice_update_status(zbx_service_t *itservice, const zbx_timespec_t *ts,
-		zbx_vector_ptr_t *alarms, zbx_hashset_t *service_updates, int flags)
+		zbx_vector_ptr_t *alarms, zbx_hashset_t *service_updates, zbx_hashset_t *recalculated, int flags)
 {
 	int	status, rule_status, i;
 
+	if (0 != (ZBX_FLAG_SERVICE_RECALCULATE & flags))
+		zbx_hashset_insert(recalculated, &itservice->serviceid, sizeof(itservice->serviceid));
+
 	status = service_get_main_status(itservice);
 
 	for (i = 0; i < itservice->status_rules.values_num; i++)
@@ -1959,7 +1969,7 @@ static void	its_itservice_update_status(zbx_service_t *itservice, const zbx_time
 		for (i = 0; i < itservice->parents.values_num; i++)
 		{
 			its_itservice_update_status((zbx_service_t *)itservice->parents.values[i], ts, alarms,
-					service_updates, flags);
+					service_updates, recalculated, flags);
 		}
 	}
 	else if (0 != (ZBX_FLAG_SERVICE_RECALCULATE & flags))
@@ -1967,8 +1977,12 @@ static void	its_itservice_update_status(zbx_service_t *itservice, const zbx_time
 		/* update parent services */
 		for (i = 0; i < itservice->parents.values_num; i++)
 		{
-			its_itservice_update_status((zbx_service_t *)itservice->parents.values[i], ts, alarms,
-					service_updates, flags);
+			zbx_service_t	*parent = (zbx_service_t *)itservice->parents.values[i];
+
+			if (NULL != zbx_hashset_search(recalculated, &parent->serviceid))
+				continue;
+
+			its_itservice_update_status(parent, ts, alarms, service_updates, recalculated, flags);
 		}
 	}
 }
@@ -2421,12 +2435,15 @@ out:
  * Purpose: generate and process service events in response to service        *
  *          updates                                                           *
  *                                                                            *
+ * Return value: the number of created, resolved and updated service events   *
+ *                                                                            *
  ******************************************************************************/
-static void	db_manage_service_events(zbx_service_manager_t *manager, zbx_hashset_t *service_updates)
+static int	db_manage_service_events(zbx_service_manager_t *manager, zbx_hashset_t *service_updates)
 {
 	zbx_hashset_iter_t	iter;
 	zbx_service_update_t	*update;
 	zbx_vector_ptr_t	events_create, events_resolve, events_update;
+	int			events_num;
 
 	zbx_vector_ptr_create(&events_create);
 	zbx_vector_ptr_create(&events_resolve);
@@ -2458,9 +2475,13 @@ static void	db_manage_service_events(zbx_service_manager_t *manager, zbx_hashset
 	if (0 != events_update.values_num)
 		db_update_service_events(manager, &events_update);
 
+	events_num = events_create.values_num + events_resolve.values_num + events_update.values_num;
+
 	zbx_vector_ptr_destroy(&events_update);
 	zbx_vector_ptr_destroy(&events_resolve);
 	zbx_vector_ptr_destroy(&events_create);
+
+	return events_num;
 }
 
 static zbx_hash_t	service_update_hash_func(const void *d)
@@ -2485,7 +2506,8 @@ static void	db_update_services(zbx_service_manager_t *manager)
 	zbx_services_diff_t	*service_diff;
 	zbx_vector_ptr_t	alarms, service_problems_new;
 	zbx_vector_uint64_t	service_problemids;
-	zbx_hashset_t		service_updates;
+	zbx_hashset_t		service_updates, recalculated;
+	int			events_num = 0;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -2493,6 +2515,7 @@ static void	db_update_services(zbx_service_manager_t *manager)
 	zbx_vector_ptr_create(&service_problems_new);
 	zbx_vector_uint64_create(&service_problemids);
 	zbx_hashset_create(&service_updates, 100, service_update_hash_func, service_update_compare_func);
+	zbx_hashset_create(&recalculated, 100, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 
 	zbx_hashset_iter_reset(&manager->service_diffs, &iter);
 	while (NULL != (service_diff = (zbx_services_diff_t *)zbx_hashset_iter_next(&iter)))
@@ -2594,7 +2617,7 @@ static void	db_update_services(zbx_service_manager_t *manager)
 			for (i = 0; i < service->parents.values_num; i++)
 			{
 				its_itservice_update_status((zbx_service_t *)service->parents.values[i], &ts, &alarms,
-						&service_updates, service_diff->flags);
+						&service_updates, &recalculated, service_diff->flags);
 			}
 		}
 		else if (0 != (ZBX_FLAG_SERVICE_RECALCULATE & service_diff->flags))
@@ -2602,8 +2625,13 @@ static void	db_update_services(zbx_service_manager_t *manager)
 			/* update parent services */
 			for (i = 0; i < service->parents.values_num; i++)
 			{
-				its_itservice_update_status((zbx_service_t *)service->parents.values[i], &ts, &alarms,
-						&service_updates, service_diff->flags);
+				zbx_service_t	*parent = (zbx_service_t *)service->parents.values[i];
+
+				if (NULL != zbx_hashset_search(&recalculated, &parent->serviceid))
+					continue;
+
+				its_itservice_update_status(parent, &ts, &alarms, &service_updates, &recalculated,
+						service_diff->flags);
 			}
 		}
 	}
@@ -2614,12 +2642,17 @@ static void	db_update_services(zbx_service_manager_t *manager)
 		its_write_status_and_alarms(&alarms, &service_updates, &service_problems_new, &service_problemids);
 
 		if (0 != manager->actions.num_data)
-			db_manage_service_events(manager, &service_updates);
+			events_num = db_manage_service_events(manager, &service_updates);
 	}
 	while (ZBX_DB_DOWN == zbx_db_commit());
 
+	/* service events might have created or recovered escalations */
+	if (0 != events_num)
+		zbx_rtc_notify_escalators();
+
 	zbx_vector_uint64_destroy(&service_problemids);
 	zbx_vector_ptr_destroy(&service_problems_new);
+	zbx_hashset_destroy(&recalculated);
 	zbx_hashset_destroy(&service_updates);
 	zbx_vector_ptr_clear_ext(&alarms, zbx_ptr_free);
 	zbx_vector_ptr_destroy(&alarms);
@@ -37,6 +37,7 @@ static ino_t	trap_ino = 0;
 static char	*buffer = NULL;
 static int	offset = 0;
 static int	force = 0;
+static int	trap_socket = -1;
 
 static void	DBget_lastsize(void)
 {
@@ -67,55 +68,140 @@ static void	DBupdate_lastsize(void)
 	zbx_db_commit();
 }
 
+/* SNMP trap items of an interface with parsed keys and compiled expressions */
+typedef struct
+{
+	zbx_uint64_t	itemid;
+	zbx_uint64_t	hostid;
+	unsigned char	value_type;
+	unsigned char	flags;
+	char		*logtimefmt;
+	char		*regex;		/* snmptrap[] parameter, NULL if any trap matches */
+	char		*literal;	/* literal required by the regular expression, NULL if none */
+	zbx_regexp_t	*regexp;	/* compiled regular expression, NULL for global regular expressions */
+	char		*error;		/* error message of not supported item */
+}
+zbx_snmptrap_item_t;
+
+typedef struct
+{
+	zbx_uint64_t		interfaceid;
+	zbx_uint64_t		hostid;
+	zbx_uint64_t		revision;
+	int			lastupdate;
+	zbx_vector_ptr_t	items;
+	zbx_snmptrap_item_t	*fallback;
+	zbx_vector_expression_t	regexps;
+}
+zbx_snmptrap_interface_t;
+
+/* Maintenance periods without data collection do not change configuration revision, */
+/* so interface items are reloaded at least that often.                              */
+#define ZBX_SNMPTRAP_INTERFACE_TTL	5
+
+/* the maximum number of traps received from socket before preprocessor is flushed */
+#define ZBX_SNMPTRAP_BATCH_MAX		1000
+
+#define ZBX_SNMPTRAP_SOCKET_RCVBUF	(4 * ZBX_MEBIBYTE)
+
+static zbx_hashset_t	trap_interfaces;
+static zbx_uint64_t	trap_items_revision;
+
+static zbx_snmptrap_item_t	*snmptrap_item_create(const zbx_dc_item_t *dc_item)
+{
+	zbx_snmptrap_item_t	*item;
+
+	item = (zbx_snmptrap_item_t *)zbx_malloc(NULL, sizeof(zbx_snmptrap_item_t));
+	memset(item, 0, sizeof(zbx_snmptrap_item_t));
+
+	item->itemid = dc_item->itemid;
+	item->hostid = dc_item->host.hostid;
+	item->value_type = dc_item->value_type;
+	item->flags = dc_item->flags;
+
+	if (ITEM_VALUE_TYPE_LOG == dc_item->value_type)
+		item->logtimefmt = zbx_strdup(NULL, dc_item->logtimefmt);
+
+	return item;
+}
+
+static void	snmptrap_item_free(zbx_snmptrap_item_t *item)
+{
+	if (NULL != item->regexp)
+		zbx_regexp_free(item->regexp);
+
+	zbx_free(item->logtimefmt);
+	zbx_free(item->regex);
+	zbx_free(item->literal);
+	zbx_free(item->error);
+	zbx_free(item);
+}
+
+static void	snmptrap_interface_clear(zbx_snmptrap_interface_t *interface)
+{
+	zbx_vector_ptr_clear_ext(&interface->items, (zbx_clean_func_t)snmptrap_item_free);
+
+	if (NULL != interface->fallback)
+	{
+		snmptrap_item_free(interface->fallback);
+		interface->fallback = NULL;
+	}
+
+	zbx_regexp_clean_expressions(&interface->regexps);
+}
+
+static void	snmptrap_interface_clean(void *data)
+{
+	zbx_snmptrap_interface_t	*interface = (zbx_snmptrap_interface_t *)data;
+
+	snmptrap_interface_clear(interface);
+	zbx_vector_ptr_destroy(&interface->items);
+	zbx_vector_expression_destroy(&interface->regexps);
+}
+
 /******************************************************************************
  *                                                                            *
- * Purpose: add trap to all matching items for the specified interface        *
- *                                                                            *
- * Return value: SUCCEED - a matching item was found                          *
- *               FAIL - no matching item was found (including fallback items) *
+ * Purpose: load SNMP trap items of interface from configuration cache,       *
+ *          resolve and parse their keys and compile regular expressions      *
  *                                                                            *
  ******************************************************************************/
-static int	process_trap_for_interface(zbx_uint64_t interfaceid, char *trap, zbx_timespec_t *ts)
+static void	snmptrap_interface_load(zbx_snmptrap_interface_t *interface)
 {
 	zbx_dc_item_t		*items = NULL;
-	const char		*regex;
+	const char		*regex, *err_msg = NULL;
 	char			error[ZBX_ITEM_ERROR_LEN_MAX];
 	size_t			num, i;
-	int			ret = FAIL, fb = -1, *lastclocks = NULL, *errcodes = NULL, value_type, regexp_ret;
-	zbx_uint64_t		*itemids = NULL;
-	AGENT_RESULT		*results = NULL;
 	AGENT_REQUEST		request;
-	zbx_vector_expression_t	regexps;
 	zbx_dc_um_handle_t	*um_handle;
+	zbx_snmptrap_item_t	*item;
 
-	zbx_vector_expression_create(&regexps);
+	snmptrap_interface_clear(interface);
+	interface->hostid = 0;
 
 	um_handle = zbx_dc_open_user_macros();
 
-	num = zbx_dc_config_get_snmp_items_by_interfaceid(interfaceid, &items);
-
-	itemids = (zbx_uint64_t *)zbx_malloc(itemids, sizeof(zbx_uint64_t) * num);
-	lastclocks = (int *)zbx_malloc(lastclocks, sizeof(int) * num);
-	errcodes = (int *)zbx_malloc(errcodes, sizeof(int) * num);
-	results = (AGENT_RESULT *)zbx_malloc(results, sizeof(AGENT_RESULT) * num);
+	num = zbx_dc_config_get_snmp_items_by_interfaceid(interface->interfaceid, &items);
 
 	for (i = 0; i < num; i++)
 	{
-		zbx_init_agent_result(&results[i]);
-		errcodes[i] = FAIL;
+		interface->hostid = items[i].host.hostid;
 
 		items[i].key = zbx_strdup(items[i].key, items[i].key_orig);
 		if (SUCCEED != zbx_substitute_key_macros(&items[i].key, NULL, &items[i], NULL, NULL,
 				MACRO_TYPE_ITEM_KEY, error, sizeof(error)))
 		{
-			SET_MSG_RESULT(&results[i], zbx_strdup(NULL, error));
-			errcodes[i] = NOTSUPPORTED;
+			item = snmptrap_item_create(&items[i]);
+			item->error = zbx_strdup(NULL, error);
+			zbx_vector_ptr_append(&interface->items, item);
 			continue;
 		}
 
 		if (0 == strcmp(items[i].key, "snmptrap.fallback"))
 		{
-			fb = i;
+			if (NULL != interface->fallback)
+				snmptrap_item_free(interface->fallback);
+
+			interface->fallback = snmptrap_item_create(&items[i]);
 			continue;
 		}
 
@@ -130,100 +216,199 @@ static int	process_trap_for_interface(zbx_uint64_t interfaceid, char *trap, zbx_
 		if (1 < get_rparams_num(&request))
 			goto next;
 
-		if (NULL != (regex = get_rparam(&request, 0)))
+		item = snmptrap_item_create(&items[i]);
+		zbx_vector_ptr_append(&interface->items, item);
+
+		if (NULL == (regex = get_rparam(&request, 0)))
+			goto next;
+
+		item->regex = zbx_strdup(NULL, regex);
+
+		if ('@' == *regex)
 		{
-			if ('@' == *regex)
-			{
-				zbx_dc_get_expressions_by_name(&regexps, regex + 1);
-
-				if (0 == regexps.values_num)
-				{
-					SET_MSG_RESULT(&results[i], zbx_dsprintf(NULL,
-							"Global regular expression \"%s\" does not exist.", regex + 1));
-					errcodes[i] = NOTSUPPORTED;
-					goto next;
-				}
-			}
+			if (SUCCEED != zbx_global_regexp_exists(regex + 1, &interface->regexps))
+				zbx_dc_get_expressions_by_name(&interface->regexps, regex + 1);
 
-			if (ZBX_REGEXP_NO_MATCH == (regexp_ret = zbx_regexp_match_ex(&regexps, trap, regex,
-					ZBX_CASE_SENSITIVE)))
+			if (SUCCEED != zbx_global_regexp_exists(regex + 1, &interface->regexps))
 			{
-				goto next;
-			}
-			else if (FAIL == regexp_ret)
-			{
-				SET_MSG_RESULT(&results[i], zbx_dsprintf(NULL,
-						"Invalid regular expression \"%s\".", regex));
-				errcodes[i] = NOTSUPPORTED;
-				goto next;
+				item->error = zbx_dsprintf(NULL, "Global regular expression \"%s\" does not exist.",
+						regex + 1);
 			}
+
+			goto next;
 		}
 
-		value_type = (ITEM_VALUE_TYPE_LOG == items[i].value_type ? ITEM_VALUE_TYPE_LOG : ITEM_VALUE_TYPE_TEXT);
-		zbx_set_agent_result_type(&results[i], value_type, trap);
-		errcodes[i] = SUCCEED;
-		ret = SUCCEED;
+		if (SUCCEED != zbx_regexp_compile(regex, &item->regexp, &err_msg))
+		{
+			item->error = zbx_dsprintf(NULL, "Invalid regular expression \"%s\".", regex);
+			zbx_regexp_err_msg_free(err_msg);
+			err_msg = NULL;
+			goto next;
+		}
+
+		item->literal = zbx_regexp_get_literal(regex);
 next:
 		zbx_free_agent_request(&request);
 	}
 
-	if (FAIL == ret && -1 != fb)
+	for (i = 0; i < num; i++)
+		zbx_free(items[i].key);
+
+	zbx_dc_config_clean_items(items, NULL, num);
+	zbx_free(items);
+
+	zbx_dc_close_user_macros(um_handle);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get cached SNMP trap items of interface, reloading them if        *
+ *          configuration has changed since they were loaded                  *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_snmptrap_interface_t	*snmptrap_interface_get(zbx_uint64_t interfaceid, int now)
+{
+	zbx_snmptrap_interface_t	*interface, interface_local;
+	zbx_uint64_t			revision;
+
+	if (NULL == (interface = (zbx_snmptrap_interface_t *)zbx_hashset_search(&trap_interfaces, &interfaceid)))
 	{
-		value_type = (ITEM_VALUE_TYPE_LOG == items[fb].value_type ? ITEM_VALUE_TYPE_LOG : ITEM_VALUE_TYPE_TEXT);
-		zbx_set_agent_result_type(&results[fb], value_type, trap);
-		errcodes[fb] = SUCCEED;
-		ret = SUCCEED;
+		interface_local.interfaceid = interfaceid;
+		interface = (zbx_snmptrap_interface_t *)zbx_hashset_insert(&trap_interfaces, &interface_local,
+				sizeof(interface_local));
+
+		zbx_vector_ptr_create(&interface->items);
+		zbx_vector_expression_create(&interface->regexps);
+		interface->fallback = NULL;
+		interface->hostid = 0;
+		interface->lastupdate = 0;
+		interface->revision = 0;
 	}
 
-	for (i = 0; i < num; i++)
+	revision = trap_items_revision;
+
+	if (0 != interface->hostid)
+		revision = MAX(revision, zbx_dc_get_host_config_revision(interface->hostid));
+
+	if (0 == interface->lastupdate || revision != interface->revision ||
+			ZBX_SNMPTRAP_INTERFACE_TTL <= now - interface->lastupdate)
 	{
-		switch (errcodes[i])
-		{
-			case SUCCEED:
-				if (ITEM_VALUE_TYPE_LOG == items[i].value_type)
-				{
-					zbx_calc_timestamp(results[i].log->value, &results[i].log->timestamp,
-							items[i].logtimefmt);
-				}
-
-				items[i].state = ITEM_STATE_NORMAL;
-				zbx_preprocess_item_value(items[i].itemid, items[i].host.hostid, items[i].value_type, items[i].flags,
-						&results[i], ts, items[i].state, NULL);
-
-				itemids[i] = items[i].itemid;
-				lastclocks[i] = ts->sec;
-				break;
-			case NOTSUPPORTED:
-				items[i].state = ITEM_STATE_NOTSUPPORTED;
-				zbx_preprocess_item_value(items[i].itemid, items[i].host.hostid, items[i].value_type, items[i].flags, NULL,
-						ts, items[i].state, results[i].msg);
-
-				itemids[i] = items[i].itemid;
-				lastclocks[i] = ts->sec;
-				break;
-		}
+		snmptrap_interface_load(interface);
 
-		zbx_free(items[i].key);
-		zbx_free_agent_result(&results[i]);
+		if (0 != interface->hostid)
+			revision = MAX(trap_items_revision, zbx_dc_get_host_config_revision(interface->hostid));
+
+		interface->revision = revision;
+		interface->lastupdate = now;
 	}
 
-	zbx_free(results);
+	return interface;
+}
 
-	zbx_dc_requeue_items(itemids, lastclocks, errcodes, num);
+/******************************************************************************
+ *                                                                            *
+ * Purpose: drop cached items of interfaces which have not received traps     *
+ *          recently                                                          *
+ *                                                                            *
+ ******************************************************************************/
+static void	snmptrap_interfaces_cleanup(int now)
+{
+	zbx_hashset_iter_t		iter;
+	zbx_snmptrap_interface_t	*interface;
 
-	zbx_free(errcodes);
-	zbx_free(lastclocks);
-	zbx_free(itemids);
+	zbx_hashset_iter_reset(&trap_interfaces, &iter);
 
-	zbx_dc_config_clean_items(items, NULL, num);
-	zbx_free(items);
+	while (NULL != (interface = (zbx_snmptrap_interface_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (ZBX_SNMPTRAP_INTERFACE_TTL <= now - interface->lastupdate)
+			zbx_hashset_iter_remove(&iter);
+	}
+}
 
-	zbx_dc_close_user_macros(um_handle);
+static void	snmptrap_item_set_value(const zbx_snmptrap_item_t *item, char *trap, zbx_timespec_t *ts)
+{
+	AGENT_RESULT	result;
+	int		value_type;
 
-	zbx_regexp_clean_expressions(&regexps);
-	zbx_vector_expression_destroy(&regexps);
+	zbx_init_agent_result(&result);
 
-	zbx_preprocessor_flush();
+	value_type = (ITEM_VALUE_TYPE_LOG == item->value_type ? ITEM_VALUE_TYPE_LOG : ITEM_VALUE_TYPE_TEXT);
+	zbx_set_agent_result_type(&result, value_type, trap);
+
+	if (ITEM_VALUE_TYPE_LOG == item->value_type)
+		zbx_calc_timestamp(result.log->value, &result.log->timestamp, item->logtimefmt);
+
+	zbx_preprocess_item_value(item->itemid, item->hostid, item->value_type, item->flags, &result, ts,
+			ITEM_STATE_NORMAL, NULL);
+
+	zbx_free_agent_result(&result);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: add trap to all matching items for the specified interface        *
+ *                                                                            *
+ * Return value: SUCCEED - a matching item was found                          *
+ *               FAIL - no matching item was found (including fallback items) *
+ *                                                                            *
+ * Comments: The values are flushed to preprocessing by the caller once per   *
+ *           batch of traps.                                                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	process_trap_for_interface(zbx_uint64_t interfaceid, char *trap, zbx_timespec_t *ts)
+{
+	zbx_snmptrap_interface_t	*interface;
+	int				i, ret = FAIL, regexp_ret;
+
+	interface = snmptrap_interface_get(interfaceid, ts->sec);
+
+	for (i = 0; i < interface->items.values_num; i++)
+	{
+		const zbx_snmptrap_item_t	*item = (const zbx_snmptrap_item_t *)interface->items.values[i];
+
+		if (NULL != item->error)
+		{
+			zbx_preprocess_item_value(item->itemid, item->hostid, item->value_type, item->flags, NULL, ts,
+					ITEM_STATE_NOTSUPPORTED, item->error);
+			continue;
+		}
+
+		if (NULL != item->literal && NULL == strstr(trap, item->literal))
+			continue;
+
+		if (NULL != item->regexp)
+		{
+			if (0 != zbx_regexp_match_precompiled(trap, item->regexp))
+				continue;
+		}
+		else if (NULL != item->regex)
+		{
+			if (ZBX_REGEXP_NO_MATCH == (regexp_ret = zbx_regexp_match_ex(&interface->regexps, trap,
+					item->regex, ZBX_CASE_SENSITIVE)))
+			{
+				continue;
+			}
+			else if (FAIL == regexp_ret)
+			{
+				char	*error;
+
+				error = zbx_dsprintf(NULL, "Invalid regular expression \"%s\".", item->regex);
+				zbx_preprocess_item_value(item->itemid, item->hostid, item->value_type, item->flags,
+						NULL, ts, ITEM_STATE_NOTSUPPORTED, error);
+				zbx_free(error);
+				continue;
+			}
+		}
+
+		snmptrap_item_set_value(item, trap, ts);
+		ret = SUCCEED;
+	}
+
+	if (FAIL == ret && NULL != interface->fallback)
+	{
+		snmptrap_item_set_value(interface->fallback, trap, ts);
+		ret = SUCCEED;
+	}
 
 	return ret;
 }
@@ -280,6 +465,8 @@ static void	parse_traps(int flag)
 {
 	char	*c, *line, *begin = NULL, *end = NULL, *addr = NULL, *pzbegin, *pzaddr = NULL, *pzdate = NULL;
 
+	trap_items_revision = zbx_dc_get_items_revision();
+
 	c = line = buffer;
 
 	while ('\0' != *c)
@@ -375,6 +562,8 @@ static void	parse_traps(int flag)
 			*buffer = '\0';
 		}
 	}
+
+	zbx_preprocessor_flush();
 }
 
 /******************************************************************************
@@ -579,6 +768,181 @@ static int	get_latest_data(void)
 	return SUCCEED;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: create the datagram socket trap receivers can send traps to       *
+ *                                                                            *
+ * Return value: SUCCEED - the socket was created                             *
+ *               FAIL - otherwise                                             *
+ *                                                                            *
+ ******************************************************************************/
+static int	open_trap_socket(void)
+{
+	struct sockaddr_un	addr;
+	int			rcvbuf = ZBX_SNMPTRAP_SOCKET_RCVBUF;
+
+	if (sizeof(addr.sun_path) <= strlen(CONFIG_SNMPTRAP_SOCKET))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "SNMP trapper socket path \"%s\" is too long", CONFIG_SNMPTRAP_SOCKET);
+		return FAIL;
+	}
+
+	if (-1 == (trap_socket = socket(AF_UNIX, SOCK_DGRAM, 0)))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "cannot create SNMP trapper socket: %s", zbx_strerror(errno));
+		return FAIL;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	zbx_strlcpy(addr.sun_path, CONFIG_SNMPTRAP_SOCKET, sizeof(addr.sun_path));
+
+	if (0 != unlink(CONFIG_SNMPTRAP_SOCKET) && ENOENT != errno)
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "cannot remove SNMP trapper socket \"%s\": %s", CONFIG_SNMPTRAP_SOCKET,
+				zbx_strerror(errno));
+		goto fail;
+	}
+
+	if (0 != bind(trap_socket, (struct sockaddr *)&addr, sizeof(addr)))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "cannot bind SNMP trapper socket \"%s\": %s", CONFIG_SNMPTRAP_SOCKET,
+				zbx_strerror(errno));
+		goto fail;
+	}
+
+	/* trap receivers usually run as a different user */
+	if (0 != chmod(CONFIG_SNMPTRAP_SOCKET, 0666))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot change permissions of SNMP trapper socket \"%s\": %s",
+				CONFIG_SNMPTRAP_SOCKET, zbx_strerror(errno));
+	}
+
+	/* larger receive buffer absorbs trap storms while the traps are being processed */
+	if (0 != setsockopt(trap_socket, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf)))
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "cannot set SNMP trapper socket receive buffer size: %s",
+				zbx_strerror(errno));
+	}
+
+	if (-1 == fcntl(trap_socket, F_SETFL, fcntl(trap_socket, F_GETFL) | O_NONBLOCK))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "cannot set SNMP trapper socket to non-blocking mode: %s",
+				zbx_strerror(errno));
+		goto fail;
+	}
+
+	return SUCCEED;
+fail:
+	close(trap_socket);
+	trap_socket = -1;
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: process a trap received from socket                               *
+ *                                                                            *
+ * Parameters: data - [IN] trap in the same format as in SNMP trapper file,   *
+ *                         one trap per datagram                              *
+ *                                                                            *
+ ******************************************************************************/
+static void	process_trap_datagram(char *data, size_t len)
+{
+	char	*header, *addr, *c;
+
+	if (0 < len && '\n' == data[len - 1])
+		data[len - 1] = '\0';
+
+	if (NULL == (header = strstr(data, "ZBXTRAP")) || NULL != memchr(data, '\n', header - data))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "invalid trap data received \"%s\"", data);
+		return;
+	}
+
+	c = header + 7;
+
+	while ('\0' != *c && NULL != strchr(ZBX_WHITESPACE, *c))
+		c++;
+
+	addr = c;
+
+	while ('\0' != *c && NULL == strchr(ZBX_WHITESPACE, *c))
+		c++;
+
+	*header = '\0';
+
+	if ('\0' != *c)
+		*c++ = '\0';
+
+	process_trap(addr, data, c);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: receive and process a batch of traps from socket                  *
+ *                                                                            *
+ * Return value: the number of received traps                                 *
+ *                                                                            *
+ ******************************************************************************/
+static int	read_trap_socket(char *dgram)
+{
+	ssize_t	nbytes;
+	int	num = 0;
+
+	trap_items_revision = zbx_dc_get_items_revision();
+
+	while (ZBX_SNMPTRAP_BATCH_MAX > num)
+	{
+		if (-1 == (nbytes = recv(trap_socket, dgram, MAX_BUFFER_LEN - 1, 0)))
+		{
+			if (EINTR == errno)
+				continue;
+
+			if (EAGAIN != errno && EWOULDBLOCK != errno)
+			{
+				zabbix_log(LOG_LEVEL_WARNING, "cannot receive from SNMP trapper socket \"%s\": %s",
+						CONFIG_SNMPTRAP_SOCKET, zbx_strerror(errno));
+			}
+
+			break;
+		}
+
+		if (MAX_BUFFER_LEN - 1 == nbytes)
+			zabbix_log(LOG_LEVEL_WARNING, "SNMP trapper buffer is full, trap data might be truncated");
+
+		dgram[nbytes] = '\0';
+		process_trap_datagram(dgram, (size_t)nbytes);
+		num++;
+	}
+
+	if (0 != num)
+		zbx_preprocessor_flush();
+
+	return num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: wait for traps on socket for up to one second                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	wait_trap_socket(const zbx_thread_info_t *info)
+{
+	struct pollfd	pd;
+
+	pd.fd = trap_socket;
+	pd.events = POLLIN;
+
+	zbx_update_selfmon_counter(info, ZBX_PROCESS_STATE_IDLE);
+
+	if (-1 == poll(&pd, 1, 1000) && EINTR != errno)
+		zabbix_log(LOG_LEVEL_WARNING, "cannot wait on SNMP trapper socket: %s", zbx_strerror(errno));
+
+	zbx_update_selfmon_counter(info, ZBX_PROCESS_STATE_BUSY);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: SNMP trap reader's entry point                                    *
@@ -587,6 +951,8 @@ static int	get_latest_data(void)
 ZBX_THREAD_ENTRY(snmptrapper_thread, args)
 {
 	double			sec;
+	char			*dgram = NULL;
+	int			traps_num = 0;
 	const zbx_thread_info_t	*info = &((zbx_thread_args_t *)args)->info;
 	int			server_num = ((zbx_thread_args_t *)args)->info.server_num;
 	int			process_num = ((zbx_thread_args_t *)args)->info.process_num;
@@ -608,6 +974,16 @@ ZBX_THREAD_ENTRY(snmptrapper_thread, args)
 	buffer = (char *)zbx_malloc(buffer, MAX_BUFFER_LEN);
 	*buffer = '\0';
 
+	zbx_hashset_create_ext(&trap_interfaces, 100, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC,
+			snmptrap_interface_clean, ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC,
+			ZBX_DEFAULT_MEM_FREE_FUNC);
+
+	if (NULL != CONFIG_SNMPTRAP_SOCKET && SUCCEED == open_trap_socket())
+	{
+		zabbix_log(LOG_LEVEL_INFORMATION, "receiving SNMP traps on socket \"%s\"", CONFIG_SNMPTRAP_SOCKET);
+		dgram = (char *)zbx_malloc(NULL, MAX_BUFFER_LEN);
+	}
+
 	while (ZBX_IS_RUNNING())
 	{
 		sec = zbx_time();
@@ -617,19 +993,36 @@ ZBX_THREAD_ENTRY(snmptrapper_thread, args)
 
 		while (ZBX_IS_RUNNING() && SUCCEED == get_latest_data())
 			read_traps();
+
+		if (-1 != trap_socket)
+			traps_num = read_trap_socket(dgram);
+
+		snmptrap_interfaces_cleanup((int)time(NULL));
+
 		sec = zbx_time() - sec;
 
 		zbx_setproctitle("%s [processed data in " ZBX_FS_DBL " sec, idle 1 sec]",
 				get_process_type_string(process_type), sec);
 
-		zbx_sleep_loop(info, 1);
+		if (-1 == trap_socket)
+			zbx_sleep_loop(info, 1);
+		else if (ZBX_SNMPTRAP_BATCH_MAX > traps_num)	/* socket is drained, wait for more traps */
+			wait_trap_socket(info);
 	}
 
 	zbx_free(buffer);
+	zbx_free(dgram);
+	zbx_hashset_destroy(&trap_interfaces);
 
 	if (-1 != trap_fd)
 		close(trap_fd);
 
+	if (-1 != trap_socket)
+	{
+		close(trap_socket);
+		unlink(CONFIG_SNMPTRAP_SOCKET);
+	}
+
 	zbx_setproctitle("%s #%d [terminated]", get_process_type_string(process_type), process_num);
 
 	while (1)
@@ -23,6 +23,7 @@
 #include "zbxthreads.h"
 
 extern char		*CONFIG_SNMPTRAP_FILE;
+extern char		*CONFIG_SNMPTRAP_SOCKET;
 
 ZBX_THREAD_ENTRY(snmptrapper_thread, args);
 
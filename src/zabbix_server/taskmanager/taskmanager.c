@@ -166,154 +166,232 @@ static int	tm_try_task_close_problem(zbx_uint64_t taskid)
 
 /******************************************************************************
  *                                                                            *
- * Purpose: process expired remote command task                               *
+ * Purpose: process expired remote command tasks                              *
+ *                                                                            *
+ * Return value: The number of expired tasks                                  *
  *                                                                            *
  ******************************************************************************/
-static void	tm_expire_remote_command(zbx_uint64_t taskid)
+static int	tm_expire_remote_commands(const zbx_vector_uint64_t *taskids)
 {
-	zbx_db_row_t	row;
-	zbx_db_result_t	result;
-	zbx_uint64_t	alertid;
-	char		*error;
+	zbx_db_row_t		row;
+	zbx_db_result_t		result;
+	zbx_uint64_t		alertid;
+	zbx_vector_uint64_t	alertids;
+	char			*sql = NULL, *error;
+	size_t			sql_alloc = 0, sql_offset = 0;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() taskid:" ZBX_FS_UI64, __func__, taskid);
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() tasks_num:%d", __func__, taskids->values_num);
+
+	zbx_vector_uint64_create(&alertids);
 
 	zbx_db_begin();
 
-	result = zbx_db_select("select alertid from task_remote_command where taskid=" ZBX_FS_UI64, taskid);
+	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, "select alertid from task_remote_command where");
+	zbx_db_add_condition_alloc(&sql, &sql_alloc, &sql_offset, "taskid", taskids->values, taskids->values_num);
+	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " and alertid is not null");
+	result = zbx_db_select("%s", sql);
 
-	if (NULL != (row = zbx_db_fetch(result)))
+	while (NULL != (row = zbx_db_fetch(result)))
 	{
-		if (SUCCEED != zbx_db_is_null(row[0]))
-		{
-			ZBX_STR2UINT64(alertid, row[0]);
-
-			error = zbx_db_dyn_escape_string_len("Remote command has been expired.", ALERT_ERROR_LEN);
-			zbx_db_execute("update alerts set error='%s',status=%d where alertid=" ZBX_FS_UI64,
-					error, ALERT_STATUS_FAILED, alertid);
-			zbx_free(error);
-		}
+		ZBX_STR2UINT64(alertid, row[0]);
+		zbx_vector_uint64_append(&alertids, alertid);
 	}
-
 	zbx_db_free_result(result);
 
-	zbx_db_execute("update task set status=%d where taskid=" ZBX_FS_UI64, ZBX_TM_STATUS_EXPIRED, taskid);
+	if (0 != alertids.values_num)
+	{
+		zbx_vector_uint64_sort(&alertids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+		error = zbx_db_dyn_escape_string_len("Remote command has been expired.", ALERT_ERROR_LEN);
+		sql_offset = 0;
+		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "update alerts set error='%s',status=%d where",
+				error, ALERT_STATUS_FAILED);
+		zbx_db_add_condition_alloc(&sql, &sql_alloc, &sql_offset, "alertid", alertids.values,
+				alertids.values_num);
+		zbx_db_execute("%s", sql);
+		zbx_free(error);
+	}
+
+	sql_offset = 0;
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "update task set status=%d where", ZBX_TM_STATUS_EXPIRED);
+	zbx_db_add_condition_alloc(&sql, &sql_alloc, &sql_offset, "taskid", taskids->values, taskids->values_num);
+	zbx_db_execute("%s", sql);
 
 	zbx_db_commit();
 
+	zbx_free(sql);
+	zbx_vector_uint64_destroy(&alertids);
+
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+
+	return taskids->values_num;
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: process remote command result task                                *
+ * Purpose: process remote command result tasks                               *
  *                                                                            *
- * Return value: SUCCEED - the task was processed successfully                *
- *               FAIL    - otherwise                                          *
+ * Return value: The number of successfully processed tasks                   *
+ *                                                                            *
+ * Comments: The result tasks and their parent remote command tasks are       *
+ *           closed and the related alerts are updated in one transaction.    *
  *                                                                            *
  ******************************************************************************/
-static int	tm_process_remote_command_result(zbx_uint64_t taskid)
+static int	tm_process_remote_command_results(const zbx_vector_uint64_t *taskids)
 {
-	zbx_db_row_t	row;
-	zbx_db_result_t	result;
-	zbx_uint64_t	alertid, parent_taskid = 0;
-	int		status, ret = FAIL;
-	char		*error, *sql = NULL;
-	size_t		sql_alloc = 0, sql_offset = 0;
+	zbx_db_row_t		row;
+	zbx_db_result_t		result;
+	zbx_uint64_t		alertid, parent_taskid;
+	zbx_vector_uint64_t	done_taskids, sent_alertids;
+	int			processed_num = 0;
+	char			*error, *sql = NULL;
+	size_t			sql_alloc = 0, sql_offset = 0;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() taskid:" ZBX_FS_UI64, __func__, taskid);
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() tasks_num:%d", __func__, taskids->values_num);
+
+	zbx_vector_uint64_create(&done_taskids);
+	zbx_vector_uint64_create(&sent_alertids);
+
+	zbx_vector_uint64_append_array(&done_taskids, taskids->values, taskids->values_num);
 
 	zbx_db_begin();
 
-	result = zbx_db_select("select r.status,r.info,a.alertid,r.parent_taskid"
+	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset,
+			"select r.status,r.info,a.alertid,r.parent_taskid"
 			" from task_remote_command_result r"
 			" left join task_remote_command c"
 				" on c.taskid=r.parent_taskid"
 			" left join alerts a"
 				" on a.alertid=c.alertid"
-			" where r.taskid=" ZBX_FS_UI64, taskid);
+			" where");
+	zbx_db_add_condition_alloc(&sql, &sql_alloc, &sql_offset, "r.taskid", taskids->values, taskids->values_num);
+	result = zbx_db_select("%s", sql);
 
-	if (NULL != (row = zbx_db_fetch(result)))
+	sql_offset = 0;
+	zbx_db_begin_multiple_update(&sql, &sql_alloc, &sql_offset);
+
+	while (NULL != (row = zbx_db_fetch(result)))
 	{
 		ZBX_STR2UINT64(parent_taskid, row[3]);
 
+		if (0 != parent_taskid)
+			zbx_vector_uint64_append(&done_taskids, parent_taskid);
+
 		if (SUCCEED != zbx_db_is_null(row[2]))
 		{
 			ZBX_STR2UINT64(alertid, row[2]);
-			status = atoi(row[0]);
 
-			if (SUCCEED == status)
+			if (SUCCEED == atoi(row[0]))
 			{
-				zbx_db_execute("update alerts set status=%d where alertid=" ZBX_FS_UI64, ALERT_STATUS_SENT,
-						alertid);
+				zbx_vector_uint64_append(&sent_alertids, alertid);
 			}
 			else
 			{
 				error = zbx_db_dyn_escape_string_len(row[1], ALERT_ERROR_LEN);
-				zbx_db_execute("update alerts set error='%s',status=%d where alertid=" ZBX_FS_UI64,
+				zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
+						"update alerts set error='%s',status=%d"
+						" where alertid=" ZBX_FS_UI64 ";\n",
 						error, ALERT_STATUS_FAILED, alertid);
 				zbx_free(error);
+
+				zbx_db_execute_overflowed_sql(&sql, &sql_alloc, &sql_offset);
 			}
 		}
 
-		ret = SUCCEED;
+		processed_num++;
 	}
-
 	zbx_db_free_result(result);
 
-	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "update task set status=%d where taskid=" ZBX_FS_UI64,
-			ZBX_TM_STATUS_DONE, taskid);
-	if (0 != parent_taskid)
-		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, " or taskid=" ZBX_FS_UI64, parent_taskid);
+	zbx_db_end_multiple_update(&sql, &sql_alloc, &sql_offset);
 
+	if (16 < sql_offset)	/* in ORACLE always present begin..end; */
+		zbx_db_execute("%s", sql);
+
+	if (0 != sent_alertids.values_num)
+	{
+		zbx_vector_uint64_sort(&sent_alertids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+		sql_offset = 0;
+		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "update alerts set status=%d where",
+				ALERT_STATUS_SENT);
+		zbx_db_add_condition_alloc(&sql, &sql_alloc, &sql_offset, "alertid", sent_alertids.values,
+				sent_alertids.values_num);
+		zbx_db_execute("%s", sql);
+	}
+
+	zbx_vector_uint64_sort(&done_taskids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_uniq(&done_taskids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	sql_offset = 0;
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "update task set status=%d where", ZBX_TM_STATUS_DONE);
+	zbx_db_add_condition_alloc(&sql, &sql_alloc, &sql_offset, "taskid", done_taskids.values,
+			done_taskids.values_num);
 	zbx_db_execute("%s", sql);
-	zbx_free(sql);
 
 	zbx_db_commit();
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+	zbx_free(sql);
+	zbx_vector_uint64_destroy(&sent_alertids);
+	zbx_vector_uint64_destroy(&done_taskids);
 
-	return ret;
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() processed:%d", __func__, processed_num);
+
+	return processed_num;
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: process data task result                                          *
+ * Purpose: process data result tasks                                         *
+ *                                                                            *
+ * Return value: The number of processed tasks                                *
  *                                                                            *
  ******************************************************************************/
-static void	tm_process_data_result(zbx_uint64_t taskid)
+static int	tm_process_data_results(const zbx_vector_uint64_t *taskids)
 {
-	zbx_db_row_t	row;
-	zbx_db_result_t	result;
-	zbx_uint64_t	parent_taskid = 0;
-	char		*sql = NULL;
-	size_t		sql_alloc = 0, sql_offset = 0;
+	zbx_db_row_t		row;
+	zbx_db_result_t		result;
+	zbx_uint64_t		parent_taskid;
+	zbx_vector_uint64_t	done_taskids;
+	char			*sql = NULL;
+	size_t			sql_alloc = 0, sql_offset = 0;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() taskid:" ZBX_FS_UI64, __func__, taskid);
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() tasks_num:%d", __func__, taskids->values_num);
+
+	zbx_vector_uint64_create(&done_taskids);
+	zbx_vector_uint64_append_array(&done_taskids, taskids->values, taskids->values_num);
 
 	zbx_db_begin();
 
-	result = zbx_db_select("select parent_taskid"
-			" from task_result"
-			" where taskid=" ZBX_FS_UI64,
-			taskid);
+	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, "select parent_taskid from task_result where");
+	zbx_db_add_condition_alloc(&sql, &sql_alloc, &sql_offset, "taskid", taskids->values, taskids->values_num);
+	result = zbx_db_select("%s", sql);
 
-	if (NULL != (row = zbx_db_fetch(result)))
+	while (NULL != (row = zbx_db_fetch(result)))
+	{
 		ZBX_STR2UINT64(parent_taskid, row[0]);
 
+		if (0 != parent_taskid)
+			zbx_vector_uint64_append(&done_taskids, parent_taskid);
+	}
 	zbx_db_free_result(result);
 
-	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "update task set status=%d where taskid=" ZBX_FS_UI64,
-			ZBX_TM_STATUS_DONE, taskid);
-	if (0 != parent_taskid)
-		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, " or taskid=" ZBX_FS_UI64, parent_taskid);
+	zbx_vector_uint64_sort(&done_taskids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_uniq(&done_taskids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 
+	sql_offset = 0;
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "update task set status=%d where", ZBX_TM_STATUS_DONE);
+	zbx_db_add_condition_alloc(&sql, &sql_alloc, &sql_offset, "taskid", done_taskids.values,
+			done_taskids.values_num);
 	zbx_db_execute("%s", sql);
-	zbx_free(sql);
 
 	zbx_db_commit();
 
+	zbx_free(sql);
+	zbx_vector_uint64_destroy(&done_taskids);
+
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+
+	return taskids->values_num;
 }
 
 /******************************************************************************
@@ -641,6 +719,9 @@ static int	tm_process_acknowledgments(zbx_vector_uint64_t *ack_taskids)
 		processed_num = process_actions_by_acknowledgments(&ack_tasks);
 
 		notify_service_manager(&ack_tasks);
+
+		if (0 != processed_num)
+			zbx_rtc_notify_escalators();
 	}
 
 	sql_offset = 0;
@@ -667,16 +748,17 @@ static int	tm_process_acknowledgments(zbx_vector_uint64_t *ack_taskids)
  ******************************************************************************/
 static int	tm_process_check_now(zbx_vector_uint64_t *taskids)
 {
-	zbx_db_row_t		row;
-	zbx_db_result_t		result;
-	int			i, processed_num = 0;
-	char			*sql = NULL;
-	size_t			sql_alloc = 0, sql_offset = 0;
-	zbx_vector_ptr_t	tasks;
-	zbx_vector_uint64_t	done_taskids, itemids;
-	zbx_uint64_t		taskid, itemid, proxy_hostid, *proxy_hostids;
-	zbx_tm_task_t		*task;
-	zbx_tm_check_now_t	*data;
+	zbx_db_row_t			row;
+	zbx_db_result_t			result;
+	int				i, processed_num = 0;
+	char				*sql = NULL;
+	size_t				sql_alloc = 0, sql_offset = 0;
+	zbx_vector_ptr_t		tasks;
+	zbx_vector_uint64_t		done_taskids, itemids, update_taskids;
+	zbx_vector_uint64_pair_t	proxy_tasks;
+	zbx_uint64_t			taskid, itemid, proxy_hostid, *proxy_hostids;
+	zbx_tm_task_t			*task;
+	zbx_tm_check_now_t		*data;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() tasks_num:%d", __func__, taskids->values_num);
 
@@ -737,46 +819,58 @@ static int	tm_process_check_now(zbx_vector_uint64_t *taskids)
 		proxy_hostids = (zbx_uint64_t *)zbx_malloc(NULL, tasks.values_num * sizeof(zbx_uint64_t));
 		zbx_dc_reschedule_items(&itemids, time(NULL), proxy_hostids);
 
-		sql_offset = 0;
-		zbx_db_begin_multiple_update(&sql, &sql_alloc, &sql_offset);
+		zbx_vector_uint64_create(&update_taskids);
+		zbx_vector_uint64_pair_create(&proxy_tasks);
 
 		for (i = 0; i < tasks.values_num; i++)
 		{
 			task = (zbx_tm_task_t *)tasks.values[i];
 
-			if (0 != proxy_hostids[i] && task->proxy_hostid == proxy_hostids[i])
-				continue;
-
-			zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset , "update task set");
-
 			if (0 == proxy_hostids[i])
 			{
-				/* close tasks managed by server -                  */
-				/* items either have been rescheduled or not cached */
-				zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, " status=%d", ZBX_TM_STATUS_DONE);
-				if (0 != task->proxy_hostid)
-					zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, ",proxy_hostid=null");
-
+				/* tasks managed by server - items either have been rescheduled or not cached */
+				zbx_vector_uint64_append(&update_taskids, task->taskid);
 				processed_num++;
 			}
-			else
+			else if (task->proxy_hostid != proxy_hostids[i])
 			{
-				/* update target proxy hostid */
-				zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, " proxy_hostid=" ZBX_FS_UI64,
-						proxy_hostids[i]);
-			}
+				zbx_uint64_pair_t	pair = {proxy_hostids[i], task->taskid};
 
-			zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, " where taskid=" ZBX_FS_UI64 ";\n",
-					task->taskid);
+				zbx_vector_uint64_pair_append(&proxy_tasks, pair);
+			}
+		}
 
-			zbx_db_execute_overflowed_sql(&sql, &sql_alloc, &sql_offset);
+		if (0 != update_taskids.values_num)
+		{
+			sql_offset = 0;
+			zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "update task set status=%d,proxy_hostid=null"
+					" where", ZBX_TM_STATUS_DONE);
+			zbx_db_add_condition_alloc(&sql, &sql_alloc, &sql_offset, "taskid", update_taskids.values,
+					update_taskids.values_num);
+			zbx_db_execute("%s", sql);
 		}
 
-		zbx_db_end_multiple_update(&sql, &sql_alloc, &sql_offset);
+		/* update target proxy hostid with one statement per proxy */
+		zbx_vector_uint64_pair_sort(&proxy_tasks, ZBX_DEFAULT_UINT64_PAIR_COMPARE_FUNC);
+
+		for (i = 0; i < proxy_tasks.values_num;)
+		{
+			proxy_hostid = proxy_tasks.values[i].first;
+			zbx_vector_uint64_clear(&update_taskids);
+
+			for (; i < proxy_tasks.values_num && proxy_hostid == proxy_tasks.values[i].first; i++)
+				zbx_vector_uint64_append(&update_taskids, proxy_tasks.values[i].second);
 
-		if (16 < sql_offset)	/* in ORACLE always present begin..end; */
+			sql_offset = 0;
+			zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "update task set proxy_hostid=" ZBX_FS_UI64
+					" where", proxy_hostid);
+			zbx_db_add_condition_alloc(&sql, &sql_alloc, &sql_offset, "taskid", update_taskids.values,
+					update_taskids.values_num);
 			zbx_db_execute("%s", sql);
+		}
 
+		zbx_vector_uint64_pair_destroy(&proxy_tasks);
+		zbx_vector_uint64_destroy(&update_taskids);
 		zbx_vector_uint64_destroy(&itemids);
 		zbx_free(proxy_hostids);
 
@@ -1240,32 +1334,50 @@ static int	tm_expire_generic_tasks(zbx_vector_uint64_t *taskids)
 	return taskids->values_num;
 }
 
+typedef struct
+{
+	zbx_uint64_t			proxy_hostid;
+	zbx_proxy_compatibility_t	compatibility;
+}
+zbx_tm_proxy_compatibility_t;
+
 /******************************************************************************
  *                                                                            *
  * Purpose: get proxy version compatibility with server version               *
  *                                                                            *
+ * Parameters: proxies      - [IN/OUT] the proxy compatibility cached during  *
+ *                                     the current task processing pass       *
+ *             proxy_hostid - [IN] the proxy identifier                       *
+ *                                                                            *
  ******************************************************************************/
-static zbx_proxy_compatibility_t	tm_get_proxy_compatibility(zbx_uint64_t proxy_hostid)
+static zbx_proxy_compatibility_t	tm_get_proxy_compatibility(zbx_hashset_t *proxies, zbx_uint64_t proxy_hostid)
 {
-	zbx_proxy_compatibility_t	compatibility = ZBX_PROXY_VERSION_UNDEFINED;
+	zbx_tm_proxy_compatibility_t	*proxy, proxy_local;
+	zbx_db_row_t			row;
+	zbx_db_result_t			result;
 
-	if (0 < proxy_hostid)
-	{
-		zbx_db_row_t	row;
-		zbx_db_result_t	result;
+	if (0 == proxy_hostid)
+		return ZBX_PROXY_VERSION_UNDEFINED;
 
-		result = zbx_db_select(
-				"select compatibility"
-				" from host_rtdata"
-				" where hostid=" ZBX_FS_UI64, proxy_hostid);
+	if (NULL != (proxy = (zbx_tm_proxy_compatibility_t *)zbx_hashset_search(proxies, &proxy_hostid)))
+		return proxy->compatibility;
 
-		if (NULL != (row = zbx_db_fetch(result)))
-			compatibility = (zbx_proxy_compatibility_t)atoi(row[0]);
+	proxy_local.proxy_hostid = proxy_hostid;
+	proxy_local.compatibility = ZBX_PROXY_VERSION_UNDEFINED;
 
-		zbx_db_free_result(result);
-	}
+	result = zbx_db_select(
+			"select compatibility"
+			" from host_rtdata"
+			" where hostid=" ZBX_FS_UI64, proxy_hostid);
+
+	if (NULL != (row = zbx_db_fetch(result)))
+		proxy_local.compatibility = (zbx_proxy_compatibility_t)atoi(row[0]);
+
+	zbx_db_free_result(result);
+
+	zbx_hashset_insert(proxies, &proxy_local, sizeof(proxy_local));
 
-	return compatibility;
+	return proxy_local.compatibility;
 }
 
 /******************************************************************************
@@ -1274,6 +1386,10 @@ static zbx_proxy_compatibility_t	tm_get_proxy_compatibility(zbx_uint64_t proxy_h
  *                                                                            *
  * Return value: The number of successfully processed tasks                   *
  *                                                                            *
+ * Comments: Tasks are grouped by type and each group is processed with       *
+ *           set-based statements, except close problem tasks that lock       *
+ *           the related triggers one by one.                                 *
+ *                                                                            *
  ******************************************************************************/
 static int	tm_process_tasks(zbx_ipc_async_socket_t *rtc, int now)
 {
@@ -1281,12 +1397,18 @@ static int	tm_process_tasks(zbx_ipc_async_socket_t *rtc, int now)
 	zbx_db_result_t		result;
 	int			type, processed_num = 0, expired_num = 0, clock, ttl;
 	zbx_uint64_t		taskid, proxy_hostid;
-	zbx_vector_uint64_t	ack_taskids, check_now_taskids, expire_taskids, data_taskids;
+	zbx_vector_uint64_t	ack_taskids, check_now_taskids, expire_taskids, data_taskids, command_expire_taskids,
+				command_result_taskids, data_result_taskids;
+	zbx_hashset_t		proxies;
 
 	zbx_vector_uint64_create(&ack_taskids);
 	zbx_vector_uint64_create(&check_now_taskids);
 	zbx_vector_uint64_create(&expire_taskids);
 	zbx_vector_uint64_create(&data_taskids);
+	zbx_vector_uint64_create(&command_expire_taskids);
+	zbx_vector_uint64_create(&command_result_taskids);
+	zbx_vector_uint64_create(&data_result_taskids);
+	zbx_hashset_create(&proxies, 0, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 
 	result = zbx_db_select("select taskid,type,clock,ttl,proxy_hostid"
 				" from task"
@@ -1312,7 +1434,7 @@ static int	tm_process_tasks(zbx_ipc_async_socket_t *rtc, int now)
 					processed_num++;
 				break;
 			case ZBX_TM_TASK_REMOTE_COMMAND:
-				compatibility = tm_get_proxy_compatibility(proxy_hostid);
+				compatibility = tm_get_proxy_compatibility(&proxies, proxy_hostid);
 
 				if (ZBX_PROXY_VERSION_UNSUPPORTED == compatibility)
 				{
@@ -1329,21 +1451,17 @@ static int	tm_process_tasks(zbx_ipc_async_socket_t *rtc, int now)
 
 				/* both - 'new' and 'in progress' remote tasks should expire */
 				if ((0 != ttl && clock + ttl < now) || (ZBX_PROXY_VERSION_UNSUPPORTED == compatibility))
-				{
-					tm_expire_remote_command(taskid);
-					expired_num++;
-				}
+					zbx_vector_uint64_append(&command_expire_taskids, taskid);
 				break;
 			case ZBX_TM_TASK_REMOTE_COMMAND_RESULT:
 				/* close problem tasks will never have 'in progress' status */
-				if (SUCCEED == tm_process_remote_command_result(taskid))
-					processed_num++;
+				zbx_vector_uint64_append(&command_result_taskids, taskid);
 				break;
 			case ZBX_TM_TASK_ACKNOWLEDGE:
 				zbx_vector_uint64_append(&ack_taskids, taskid);
 				break;
 			case ZBX_TM_TASK_CHECK_NOW:
-				compatibility = tm_get_proxy_compatibility(proxy_hostid);
+				compatibility = tm_get_proxy_compatibility(&proxies, proxy_hostid);
 
 				if (ZBX_PROXY_VERSION_UNSUPPORTED == compatibility)
 				{
@@ -1357,7 +1475,7 @@ static int	tm_process_tasks(zbx_ipc_async_socket_t *rtc, int now)
 					zbx_vector_uint64_append(&check_now_taskids, taskid);
 				break;
 			case ZBX_TM_TASK_DATA:
-				compatibility = tm_get_proxy_compatibility(proxy_hostid);
+				compatibility = tm_get_proxy_compatibility(&proxies, proxy_hostid);
 
 				if (ZBX_PROXY_VERSION_OUTDATED == compatibility ||
 						ZBX_PROXY_VERSION_UNSUPPORTED == compatibility)
@@ -1385,8 +1503,7 @@ static int	tm_process_tasks(zbx_ipc_async_socket_t *rtc, int now)
 					zbx_vector_uint64_append(&data_taskids, taskid);
 				break;
 			case ZBX_TM_TASK_DATA_RESULT:
-				tm_process_data_result(taskid);
-				processed_num++;
+				zbx_vector_uint64_append(&data_result_taskids, taskid);
 				break;
 			default:
 				THIS_SHOULD_NEVER_HAPPEN;
@@ -1396,6 +1513,16 @@ static int	tm_process_tasks(zbx_ipc_async_socket_t *rtc, int now)
 	}
 	zbx_db_free_result(result);
 
+	/* expire remote commands before processing results, which close their parent remote command tasks */
+	if (0 < command_expire_taskids.values_num)
+		expired_num += tm_expire_remote_commands(&command_expire_taskids);
+
+	if (0 < command_result_taskids.values_num)
+		processed_num += tm_process_remote_command_results(&command_result_taskids);
+
+	if (0 < data_result_taskids.values_num)
+		processed_num += tm_process_data_results(&data_result_taskids);
+
 	if (0 < ack_taskids.values_num)
 		processed_num += tm_process_acknowledgments(&ack_taskids);
 
@@ -1408,6 +1535,10 @@ static int	tm_process_tasks(zbx_ipc_async_socket_t *rtc, int now)
 	if (0 < expire_taskids.values_num)
 		expired_num += tm_expire_generic_tasks(&expire_taskids);
 
+	zbx_hashset_destroy(&proxies);
+	zbx_vector_uint64_destroy(&data_result_taskids);
+	zbx_vector_uint64_destroy(&command_result_taskids);
+	zbx_vector_uint64_destroy(&command_expire_taskids);
 	zbx_vector_uint64_destroy(&data_taskids);
 	zbx_vector_uint64_destroy(&expire_taskids);
 	zbx_vector_uint64_destroy(&check_now_taskids);
@@ -228,8 +228,21 @@ static void	event_queries_fetch(zbx_db_result_t result, zbx_vector_ptr_t *event_
  * Purpose: get open, recently resolved and resolved problems with suppress   *
  *          data from database and prepare event query, event data structures *
  *                                                                            *
+ * Parameters: event_queries  - [OUT] the events to check                     *
+ *             event_data     - [OUT] the current event suppress data         *
+ *             maintenanceids - [IN] the modified maintenances, sorted        *
+ *             hostids        - [IN] the hosts of running modified            *
+ *                                   maintenances                             *
+ *             process_num    - [IN] process number                           *
+ *                                                                            *
+ * Comments: Only problems on hosts of the running modified maintenances can  *
+ *           get new suppress data, while the existing suppress data can      *
+ *           change only for the modified maintenances. Other events are not  *
+ *           affected by the maintenance update and are not read.             *
+ *                                                                            *
  ******************************************************************************/
-static void	db_get_query_events(zbx_vector_ptr_t *event_queries, zbx_vector_ptr_t *event_data, int process_num)
+static void	db_get_query_events(zbx_vector_ptr_t *event_queries, zbx_vector_ptr_t *event_data,
+		const zbx_vector_uint64_t *maintenanceids, const zbx_vector_uint64_t *hostids, int process_num)
 {
 	zbx_db_row_t			row;
 	zbx_db_result_t			result;
@@ -239,6 +252,8 @@ static void	db_get_query_events(zbx_vector_ptr_t *event_queries, zbx_vector_ptr_
 	zbx_vector_uint64_t		eventids;
 	int				read_tags;
 	const char			*tag_fields, *tag_join;
+	char				*sql = NULL;
+	size_t				sql_alloc = 0, sql_offset = 0;
 
 	if (SUCCEED == (read_tags = zbx_dc_maintenance_has_tags()))
 	{
@@ -251,30 +266,51 @@ static void	db_get_query_events(zbx_vector_ptr_t *event_queries, zbx_vector_ptr_
 		tag_join = "";
 	}
 
-	/* get open or recently closed problems */
-	result = zbx_db_select("select p.eventid,p.objectid,p.r_eventid,%s"
-			" from problem p"
-			"%s"
-			" where p.source=%d"
-				" and p.object=%d"
-				" and " ZBX_SQL_MOD(p.eventid, %d) "=%d"
-			" order by p.eventid",
-			tag_fields, tag_join,
-			EVENT_SOURCE_TRIGGERS, EVENT_OBJECT_TRIGGER, CONFIG_FORKS[ZBX_PROCESS_TYPE_TIMER],
-			process_num - 1);
-
-	event_queries_fetch(result, event_queries);
-	zbx_db_free_result(result);
+	/* get open or recently closed problems of the hosts in running modified maintenances */
+	if (0 != hostids->values_num)
+	{
+		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
+				"select p.eventid,p.objectid,p.r_eventid,%s"
+				" from problem p"
+				"%s"
+				" where p.source=%d"
+					" and p.object=%d"
+					" and " ZBX_SQL_MOD(p.eventid, %d) "=%d"
+					" and p.objectid in ("
+						"select f.triggerid"
+						" from functions f,items i"
+						" where f.itemid=i.itemid"
+							" and",
+				tag_fields, tag_join,
+				EVENT_SOURCE_TRIGGERS, EVENT_OBJECT_TRIGGER, CONFIG_FORKS[ZBX_PROCESS_TYPE_TIMER],
+				process_num - 1);
+		zbx_db_add_condition_alloc(&sql, &sql_alloc, &sql_offset, "i.hostid", hostids->values,
+				hostids->values_num);
+		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, ") order by p.eventid");
+
+		result = zbx_db_select("%s", sql);
+
+		event_queries_fetch(result, event_queries);
+		zbx_db_free_result(result);
+	}
 
-	/* get event suppress data */
+	/* get event suppress data of the modified maintenances */
 
 	zbx_vector_uint64_create(&eventids);
 
-	result = zbx_db_select("select eventid,maintenanceid,suppress_until"
+	sql_offset = 0;
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
+			"select eventid,maintenanceid,suppress_until"
 			" from event_suppress"
 			" where " ZBX_SQL_MOD(eventid, %d) "=%d"
-			" order by eventid",
+				" and",
 			CONFIG_FORKS[ZBX_PROCESS_TYPE_TIMER], process_num - 1);
+	zbx_db_add_condition_alloc(&sql, &sql_alloc, &sql_offset, "maintenanceid", maintenanceids->values,
+			maintenanceids->values_num);
+	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " order by eventid");
+
+	result = zbx_db_select("%s", sql);
+	zbx_free(sql);
 
 	while (NULL != (row = zbx_db_fetch(result)))
 	{
@@ -349,35 +385,60 @@ static void	db_get_query_events(zbx_vector_ptr_t *event_queries, zbx_vector_ptr_
  * Parameters: suppressed_num - [OUT] the number of suppressed events         *
  *             process_num    - [IN] process number                           *
  *                                                                            *
+ * Comments: Only the maintenances modified during the last maintenance       *
+ *           update are processed, suppress data of other maintenances is     *
+ *           left as it is.                                                   *
+ *                                                                            *
  ******************************************************************************/
 static void	db_update_event_suppress_data(int *suppressed_num, int process_num)
 {
 	zbx_vector_ptr_t	event_queries, event_data;
+	zbx_vector_uint64_t	modifiedids, maintenanceids, hostids;
+	int			i;
 
 	*suppressed_num = 0;
 
 	zbx_vector_ptr_create(&event_queries);
 	zbx_vector_ptr_create(&event_data);
+	zbx_vector_uint64_create(&modifiedids);
+	zbx_vector_uint64_create(&maintenanceids);
+	zbx_vector_uint64_create(&hostids);
 
-	db_get_query_events(&event_queries, &event_data, process_num);
+	if (SUCCEED != zbx_dc_get_modified_maintenanceids(&modifiedids))
+		goto out;
+
+	/* running modified maintenances can suppress new events */
+	zbx_dc_get_running_maintenanceids(&maintenanceids);
+
+	for (i = 0; i < maintenanceids.values_num;)
+	{
+		if (FAIL == zbx_vector_uint64_bsearch(&modifiedids, maintenanceids.values[i],
+				ZBX_DEFAULT_UINT64_COMPARE_FUNC))
+		{
+			zbx_vector_uint64_remove_noorder(&maintenanceids, i);
+		}
+		else
+			i++;
+	}
+
+	if (0 != maintenanceids.values_num)
+		zbx_dc_get_maintenance_hostids(&maintenanceids, &hostids);
+
+	db_get_query_events(&event_queries, &event_data, &modifiedids, &hostids, process_num);
 
 	if (0 != event_queries.values_num)
 	{
 		zbx_db_insert_t			db_insert;
 		char				*sql = NULL;
 		size_t				sql_alloc = 0, sql_offset = 0;
-		int				i, j, k;
+		int				j, k;
 		zbx_event_suppress_query_t	*query;
 		zbx_event_suppress_data_t	*data;
 		zbx_vector_uint64_pair_t	del_event_maintenances;
-		zbx_vector_uint64_t		maintenanceids;
 		zbx_uint64_pair_t		pair;
 
-		zbx_vector_uint64_create(&maintenanceids);
 		zbx_vector_uint64_pair_create(&del_event_maintenances);
 
-		zbx_dc_get_running_maintenanceids(&maintenanceids);
-
 		zbx_db_begin();
 
 		if (0 != maintenanceids.values_num && SUCCEED == zbx_db_lock_maintenanceids(&maintenanceids))
@@ -499,8 +560,11 @@ cleanup:
 		zbx_free(sql);
 
 		zbx_vector_uint64_pair_destroy(&del_event_maintenances);
-		zbx_vector_uint64_destroy(&maintenanceids);
 	}
+out:
+	zbx_vector_uint64_destroy(&hostids);
+	zbx_vector_uint64_destroy(&maintenanceids);
+	zbx_vector_uint64_destroy(&modifiedids);
 
 	zbx_vector_ptr_clear_ext(&event_data, (zbx_clean_func_t)event_suppress_data_free);
 	zbx_vector_ptr_destroy(&event_data);
@@ -595,9 +659,12 @@ ZBX_THREAD_ENTRY(timer_thread, args)
 
 				update = zbx_dc_update_maintenances();
 
-				/* force maintenance updates at server startup */
+				/* force full maintenance updates at server startup */
 				if (0 == maintenance_time)
+				{
+					zbx_dc_maintenance_set_modified();
 					update = SUCCEED;
+				}
 
 				/* update hosts if there are modified (stopped, started, changed) maintenances */
 				if (SUCCEED == update)
@@ -652,7 +719,10 @@ ZBX_THREAD_ENTRY(timer_thread, args)
 		}
 
 		if (0 != idle)
+		{
+			zbx_db_release_idle();
 			zbx_sleep_loop(thread_info, 1);
+		}
 
 		idle = 1;
 	}
@@ -107,6 +107,9 @@ static void	db_register_host(const char *host, const char *ip, unsigned short po
 		}
 	}
 	while (ZBX_DB_DOWN == zbx_db_commit());
+
+	if (NULL != events_cbs->events_notify_escalators_cb)
+		events_cbs->events_notify_escalators_cb();
 }
 
 static int	zbx_autoreg_host_check_permissions(const char *host, const char *ip, unsigned short port,
@@ -128,7 +131,7 @@ static int	zbx_autoreg_host_check_permissions(const char *host, const char *ip,
 #if defined(HAVE_GNUTLS) || (defined(HAVE_OPENSSL) && defined(HAVE_OPENSSL_WITH_PSK))
 	if (ZBX_TCP_SEC_TLS_PSK == sock->connection_type)
 	{
-		if (0 == (ZBX_PSK_FOR_AUTOREG & zbx_tls_get_psk_usage()))
+		if (0 == (ZBX_PSK_FOR_AUTOREG & zbx_tls_get_psk_usage(sock)))
 		{
 			zabbix_log(LOG_LEVEL_WARNING, "autoregistration from \"%s\" denied (host:\"%s\" ip:\"%s\""
 					" port:%hu): connection used PSK which is not configured for autoregistration",
@@ -429,6 +432,131 @@ out:
 	zbx_free_agent_request(&request);
 }
 
+/* serialized active check responses, cached per host by each trapper process */
+typedef struct
+{
+	zbx_uint64_t	hostid;
+	zbx_uint64_t	revision;
+	int		version;
+	int		lastaccess;
+	char		*data;
+	size_t		data_size;
+	char		*compressed;
+	size_t		compressed_size;
+}
+zbx_active_response_t;
+
+#define ZBX_ACTIVE_RESPONSE_TTL			SEC_PER_HOUR
+#define ZBX_ACTIVE_RESPONSE_CLEANUP_PERIOD	(10 * SEC_PER_MIN)
+
+static zbx_hashset_t	active_responses;
+static int		active_responses_cleanup;
+
+static void	active_response_clear(void *data)
+{
+	zbx_active_response_t	*response = (zbx_active_response_t *)data;
+
+	zbx_free(response->data);
+	zbx_free(response->compressed);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get cached response with active checks of the host                *
+ *                                                                            *
+ * Parameters: hostid   - [IN]                                                *
+ *             revision - [IN] current configuration revision of the host     *
+ *             version  - [IN] agent version                                  *
+ *                                                                            *
+ * Return value: cached response or NULL if there is no response matching     *
+ *               the host revision and agent version                          *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_active_response_t	*active_response_get(zbx_uint64_t hostid, zbx_uint64_t revision, int version)
+{
+	zbx_active_response_t	*response;
+
+	if (0 == active_responses.num_slots)
+		return NULL;
+
+	if (NULL == (response = (zbx_active_response_t *)zbx_hashset_search(&active_responses, &hostid)))
+		return NULL;
+
+	if (response->revision != revision || response->version != version)
+		return NULL;
+
+	response->lastaccess = (int)time(NULL);
+
+	return response;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: cache response with active checks of the host, replacing response *
+ *          of older revision                                                 *
+ *                                                                            *
+ * Parameters: hostid    - [IN]                                               *
+ *             revision  - [IN] configuration revision the response is built  *
+ *                              for                                           *
+ *             version   - [IN] agent version                                 *
+ *             data      - [IN] serialized response                           *
+ *             data_size - [IN] size of the response                          *
+ *                                                                            *
+ * Return value: cached response                                              *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_active_response_t	*active_response_add(zbx_uint64_t hostid, zbx_uint64_t revision, int version,
+		const char *data, size_t data_size)
+{
+	zbx_active_response_t	*response, response_local;
+	int			now;
+
+	now = (int)time(NULL);
+
+	if (0 == active_responses.num_slots)
+	{
+		zbx_hashset_create_ext(&active_responses, 0, ZBX_DEFAULT_UINT64_HASH_FUNC,
+				ZBX_DEFAULT_UINT64_COMPARE_FUNC, active_response_clear, ZBX_DEFAULT_MEM_MALLOC_FUNC,
+				ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
+		active_responses_cleanup = now;
+	}
+
+	if (ZBX_ACTIVE_RESPONSE_CLEANUP_PERIOD <= now - active_responses_cleanup)
+	{
+		zbx_hashset_iter_t	iter;
+
+		zbx_hashset_iter_reset(&active_responses, &iter);
+
+		while (NULL != (response = (zbx_active_response_t *)zbx_hashset_iter_next(&iter)))
+		{
+			if (ZBX_ACTIVE_RESPONSE_TTL <= now - response->lastaccess)
+				zbx_hashset_iter_remove(&iter);
+		}
+
+		active_responses_cleanup = now;
+	}
+
+	if (NULL == (response = (zbx_active_response_t *)zbx_hashset_search(&active_responses, &hostid)))
+	{
+		memset(&response_local, 0, sizeof(response_local));
+		response_local.hostid = hostid;
+		response = (zbx_active_response_t *)zbx_hashset_insert(&active_responses, &response_local,
+				sizeof(response_local));
+	}
+	else
+		active_response_clear(response);
+
+	response->revision = revision;
+	response->version = version;
+	response->lastaccess = now;
+	response->data = (char *)zbx_malloc(NULL, data_size);
+	memcpy(response->data, data, data_size);
+	response->data_size = data_size;
+	response->compressed_size = 0;
+
+	return response;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: send list of active checks to the host                            *
@@ -448,21 +576,26 @@ int	send_list_of_active_checks_json(zbx_socket_t *sock, struct zbx_json_parse *j
 	char			host[ZBX_HOSTNAME_BUF_LEN], tmp[MAX_STRING_LEN], ip[ZBX_INTERFACE_IP_LEN_MAX],
 				error[MAX_STRING_LEN], *host_metadata = NULL, *interface = NULL, *buffer = NULL;
 	struct zbx_json		json;
-	int			ret = FAIL, i, version, num = 0;
+	int			ret = FAIL, i, version, num = 0, delta = 0, full, cacheable;
 	zbx_uint64_t		hostid, revision, agent_config_revision;
 	size_t			host_metadata_alloc = 1;	/* for at least NUL-terminated string */
 	size_t			interface_alloc = 1;		/* for at least NUL-terminated string */
-	size_t			buffer_size, reserved = 0;
+	size_t			buffer_size, data_size, *compressed_size;
+	const char		*data;
+	char			**compressed;
+	zbx_active_response_t	*response = NULL;
 	unsigned short		port;
 	zbx_conn_flags_t	flag = ZBX_CONN_DEFAULT;
 	zbx_session_t		*session = NULL;
 	zbx_vector_expression_t	regexps;
 	zbx_vector_str_t	names;
+	zbx_vector_uint64_t	unchanged_itemids;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
 	zbx_vector_expression_create(&regexps);
 	zbx_vector_str_create(&names);
+	zbx_vector_uint64_create(&unchanged_itemids);
 
 	if (FAIL == zbx_json_value_by_name(jp, ZBX_PROTO_TAG_HOST, host, sizeof(host), NULL))
 	{
@@ -553,10 +686,30 @@ int	send_list_of_active_checks_json(zbx_socket_t *sock, struct zbx_json_parse *j
 		session = zbx_dc_get_or_create_session(hostid, tmp, ZBX_SESSION_TYPE_CONFIG);
 	}
 
+	/* Agent may receive only items changed since the revision it has acknowledged in this session, */
+	/* the rest of its configuration is confirmed by item identifiers.                              */
+	if (NULL != session && 0 != agent_config_revision && session->last_id == agent_config_revision &&
+			SUCCEED == zbx_json_value_by_name(jp, ZBX_PROTO_TAG_CONFIG_DELTA, tmp, sizeof(tmp), NULL) &&
+			0 != atoi(tmp))
+	{
+		delta = 1;
+	}
+
+	full = (NULL == session || 0 == session->last_id || agent_config_revision != revision);
+
+	/* full configuration depends only on host revision and agent version, delta is built per agent */
+	cacheable = (0 != full && 0 == delta);
+
+	if (0 != cacheable && NULL != (response = active_response_get(hostid, revision, version)))
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "%s() sending cached [%s]", __func__, response->data);
+		goto send;
+	}
+
 	zbx_json_init(&json, ZBX_JSON_STAT_BUF_LEN);
 	zbx_json_addstring(&json, ZBX_PROTO_TAG_RESPONSE, ZBX_PROTO_VALUE_SUCCESS, ZBX_JSON_TYPE_STRING);
 
-	if (NULL == session || 0 == session->last_id || agent_config_revision != revision)
+	if (0 != full)
 	{
 		zbx_json_adduint64(&json, ZBX_PROTO_TAG_CONFIG_REVISION, (zbx_uint64_t)revision);
 		zbx_json_addarray(&json, ZBX_PROTO_TAG_DATA);
@@ -567,7 +720,7 @@ int	send_list_of_active_checks_json(zbx_socket_t *sock, struct zbx_json_parse *j
 	if (0 != num)
 	{
 		zbx_dc_item_t		*dc_items;
-		int			*errcodes, delay;
+		int			*errcodes, delay, unchanged;
 		zbx_dc_um_handle_t	*um_handle;
 
 		dc_items = (zbx_dc_item_t *)zbx_malloc(NULL, sizeof(zbx_dc_item_t) * num);
@@ -592,6 +745,18 @@ int	send_list_of_active_checks_json(zbx_socket_t *sock, struct zbx_json_parse *j
 			if (HOST_STATUS_MONITORED != dc_items[i].host.status)
 				continue;
 
+			/* lastlogsize and mtime are updated without configuration revision change */
+			if (0 == strncmp(dc_items[i].key_orig, "log", 3) ||
+					0 == strncmp(dc_items[i].key_orig, "eventlog[", 9))
+			{
+				cacheable = 0;
+			}
+
+			/* items with macros in key or interval can change without item revision being updated */
+			unchanged = (0 != delta && dc_items[i].revision <= agent_config_revision &&
+					NULL == strchr(dc_items[i].key_orig, '{') &&
+					NULL == strchr(dc_items[i].delay, '{'));
+
 			zbx_substitute_simple_macros(NULL, NULL, NULL, NULL, &dc_items[i].host.hostid, NULL, NULL,
 					NULL, NULL, NULL, NULL, NULL, &dc_items[i].delay, MACRO_TYPE_COMMON, NULL, 0);
 
@@ -602,6 +767,12 @@ int	send_list_of_active_checks_json(zbx_socket_t *sock, struct zbx_json_parse *j
 			zbx_substitute_key_macros_unmasked(&dc_items[i].key, NULL, &dc_items[i], NULL, NULL,
 					MACRO_TYPE_ITEM_KEY, NULL, 0);
 
+			if (0 != unchanged)
+			{
+				zbx_vector_uint64_append(&unchanged_itemids, dc_items[i].itemid);
+				goto next;
+			}
+
 			zbx_json_addobject(&json, NULL);
 			zbx_json_addstring(&json, ZBX_PROTO_TAG_KEY, dc_items[i].key, ZBX_JSON_TYPE_STRING);
 
@@ -631,7 +802,7 @@ int	send_list_of_active_checks_json(zbx_socket_t *sock, struct zbx_json_parse *j
 			zbx_json_adduint64(&json, ZBX_PROTO_TAG_LASTLOGSIZE, dc_items[i].lastlogsize);
 			zbx_json_adduint64(&json, ZBX_PROTO_TAG_MTIME, dc_items[i].mtime);
 			zbx_json_close(&json);
-
+next:
 			zbx_itemkey_extract_global_regexps(dc_items[i].key, &names);
 
 			zbx_free(dc_items[i].key);
@@ -647,6 +818,16 @@ int	send_list_of_active_checks_json(zbx_socket_t *sock, struct zbx_json_parse *j
 
 	zbx_json_close(&json);
 
+	if (0 != delta && 0 != num)
+	{
+		zbx_json_addarray(&json, ZBX_PROTO_TAG_UNCHANGED_ITEMIDS);
+
+		for (i = 0; i < unchanged_itemids.values_num; i++)
+			zbx_json_adduint64(&json, NULL, unchanged_itemids.values[i]);
+
+		zbx_json_close(&json);
+	}
+
 	if (ZBX_COMPONENT_VERSION(4, 4, 0) == version || ZBX_COMPONENT_VERSION(5, 0, 0) == version)
 		zbx_json_adduint64(&json, ZBX_PROTO_TAG_REFRESH_UNSUPPORTED, 600);
 
@@ -683,33 +864,53 @@ int	send_list_of_active_checks_json(zbx_socket_t *sock, struct zbx_json_parse *j
 
 	zabbix_log(LOG_LEVEL_DEBUG, "%s() sending [%s]", __func__, json.buffer);
 
+	if (0 != cacheable)
+	{
+		response = active_response_add(hostid, revision, version, json.buffer, json.buffer_size);
+		zbx_json_free(&json);
+	}
+send:
+	if (NULL != response)
+	{
+		data = response->data;
+		data_size = response->data_size;
+		compressed = &response->compressed;
+		compressed_size = &response->compressed_size;
+	}
+	else
+	{
+		data = json.buffer;
+		data_size = json.buffer_size;
+		compressed = &buffer;
+		compressed_size = &buffer_size;
+	}
+
 	if (0 != (ZBX_TCP_COMPRESS & sock->protocol))
 	{
-		if (SUCCEED != zbx_compress(json.buffer, json.buffer_size, &buffer, &buffer_size))
+		if (NULL == *compressed && SUCCEED != zbx_compress(data, data_size, compressed, compressed_size))
 		{
 			zbx_snprintf(error, MAX_STRING_LEN, "cannot compress data: %s", zbx_compress_strerror());
+
+			if (NULL == response)
+				zbx_json_free(&json);
+
 			goto error;
 		}
 
-		reserved = json.buffer_size;
-		zbx_json_free(&json);	/* json buffer can be large, free as fast as possible */
-
-		if (SUCCEED != (ret = zbx_tcp_send_ext(sock, buffer, buffer_size, reserved, sock->protocol,
-				config_timeout)))
+		if (SUCCEED != (ret = zbx_tcp_send_ext(sock, *compressed, *compressed_size, data_size,
+				sock->protocol, config_timeout)))
 		{
 			zbx_strscpy(error, zbx_socket_strerror());
 		}
 	}
 	else
 	{
-		if (SUCCEED != (ret = zbx_tcp_send_ext(sock, json.buffer, json.buffer_size, 0, sock->protocol,
-				config_timeout)))
-		{
+		if (SUCCEED != (ret = zbx_tcp_send_ext(sock, data, data_size, 0, sock->protocol, config_timeout)))
 			zbx_strscpy(error, zbx_socket_strerror());
-		}
 	}
 
-	zbx_json_free(&json);
+	if (NULL == response)
+		zbx_json_free(&json);
 
 	if (SUCCEED == ret)
 	{
@@ -736,6 +937,7 @@ out:
 		zbx_free(names.values[i]);
 
 	zbx_vector_str_destroy(&names);
+	zbx_vector_uint64_destroy(&unchanged_itemids);
 
 	zbx_regexp_clean_expressions(&regexps);
 	zbx_vector_expression_destroy(&regexps);
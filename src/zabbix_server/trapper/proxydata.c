@@ -74,8 +74,20 @@ int	zbx_send_proxy_data_response(const zbx_dc_proxy_t *proxy, zbx_socket_t *sock
 	if (0 != tasks.values_num)
 		zbx_tm_json_serialize_tasks(&json, &tasks);
 
+	zbx_json_addstring(&json, ZBX_PROTO_TAG_HISTORY_FORMAT, ZBX_PROTO_VALUE_HISTORY_FORMAT_BINARY,
+			ZBX_JSON_TYPE_STRING);
+
+	if ('\0' != *zbx_compress_codecs())
+		zbx_json_addstring(&json, ZBX_PROTO_TAG_COMPRESSION, zbx_compress_codecs(), ZBX_JSON_TYPE_STRING);
+
 	if (0 != proxy->auto_compress)
-		flags |= ZBX_TCP_COMPRESS;
+	{
+		/* reply with the codec used by proxy, it is known to be supported by both sides */
+		if (0 != (sock->protocol & ZBX_TCP_COMPRESS))
+			flags |= sock->protocol & ZBX_TCP_COMPRESS_MASK;
+		else
+			flags |= ZBX_TCP_COMPRESS;
+	}
 
 	if (SUCCEED == (ret = zbx_tcp_send_ext(sock, json.buffer, strlen(json.buffer), 0, flags, config_timeout)))
 	{
@@ -106,6 +118,9 @@ static int	proxy_data_no_history(const struct zbx_json_parse *jp)
 	if (SUCCEED == zbx_json_brackets_by_name(jp, ZBX_PROTO_TAG_HISTORY_DATA, &jp_data))
 		return FAIL;
 
+	if (NULL != zbx_json_pair_by_name(jp, ZBX_PROTO_TAG_HISTORY_DATA_BINARY))
+		return FAIL;
+
 	if (SUCCEED == zbx_json_brackets_by_name(jp, ZBX_PROTO_TAG_DISCOVERY_DATA, &jp_data))
 		return FAIL;
 
@@ -237,10 +252,10 @@ out:
  *                                                                            *
  ******************************************************************************/
 static int	send_data_to_server(zbx_socket_t *sock, char **buffer, size_t buffer_size, size_t reserved,
-		int config_timeout, char **error)
+		unsigned char codec, int config_timeout, char **error)
 {
-	if (SUCCEED != zbx_tcp_send_ext(sock, *buffer, buffer_size, reserved, ZBX_TCP_PROTOCOL | ZBX_TCP_COMPRESS,
-			config_timeout))
+	if (SUCCEED != zbx_tcp_send_ext(sock, *buffer, buffer_size, reserved,
+			ZBX_TCP_PROTOCOL | zbx_tcp_compress_flags(codec), config_timeout))
 	{
 		*error = zbx_strdup(*error, zbx_socket_strerror());
 		return FAIL;
@@ -259,20 +274,25 @@ static int	send_data_to_server(zbx_socket_t *sock, char **buffer, size_t buffer_
  * Purpose: sends 'proxy data' request to server                              *
  *                                                                            *
  * Parameters: sock             - [IN] connection socket                      *
+ *             jp_request       - [IN] the received 'proxy data' request      *
  *             ts               - [IN] connection timestamp                   *
  *             config_comms     - [IN] proxy configuration for communication  *
  *                                     with server                            *
  *                                                                            *
  ******************************************************************************/
-void	zbx_send_proxy_data(zbx_socket_t *sock, zbx_timespec_t *ts, const zbx_config_comms_args_t *config_comms)
+void	zbx_send_proxy_data(zbx_socket_t *sock, const struct zbx_json_parse *jp_request, zbx_timespec_t *ts,
+		const zbx_config_comms_args_t *config_comms)
 {
 	struct zbx_json		j;
 	zbx_uint64_t		areg_lastid = 0, history_lastid = 0, discovery_lastid = 0;
 	char			*error = NULL, *buffer = NULL;
-	int			availability_ts, more_history, more_discovery, more_areg, proxy_delay;
+	int			availability_ts, more_history, more_discovery, more_areg, proxy_delay,
+				history_format = ZBX_PROXY_HISTORY_FORMAT_JSON;
 	zbx_vector_tm_task_t	tasks;
 	struct zbx_json_parse	jp, jp_tasks;
 	size_t			buffer_size, reserved;
+	char			value[MAX_STRING_LEN];
+	unsigned char		codec = ZBX_COMPRESS_ZLIB;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -283,12 +303,22 @@ void	zbx_send_proxy_data(zbx_socket_t *sock, zbx_timespec_t *ts, const zbx_confi
 		goto out;
 	}
 
+	/* binary history data is sent only to servers requesting it */
+	if (SUCCEED == zbx_json_value_by_name(jp_request, ZBX_PROTO_TAG_HISTORY_FORMAT, value, sizeof(value), NULL) &&
+			0 == strcmp(value, ZBX_PROTO_VALUE_HISTORY_FORMAT_BINARY))
+	{
+		history_format = ZBX_PROXY_HISTORY_FORMAT_BINARY;
+	}
+
+	if (SUCCEED == zbx_json_value_by_name(jp_request, ZBX_PROTO_TAG_COMPRESSION, value, sizeof(value), NULL))
+		codec = zbx_compress_select_codec(value);
+
 	LOCK_PROXY_HISTORY;
 	zbx_json_init(&j, ZBX_JSON_STAT_BUF_LEN);
 
 	zbx_json_addstring(&j, ZBX_PROTO_TAG_SESSION, zbx_dc_get_session_token(), ZBX_JSON_TYPE_STRING);
 	zbx_get_interface_availability_data(&j, &availability_ts);
-	zbx_proxy_get_hist_data(&j, &history_lastid, &more_history);
+	zbx_proxy_get_hist_data(&j, history_format, &history_lastid, &more_history);
 	zbx_proxy_get_dhis_data(&j, &discovery_lastid, &more_discovery);
 	zbx_proxy_get_areg_data(&j, &areg_lastid, &more_areg);
 	zbx_proxy_get_host_active_availability(&j);
@@ -312,7 +342,7 @@ void	zbx_send_proxy_data(zbx_socket_t *sock, zbx_timespec_t *ts, const zbx_confi
 	if (0 != history_lastid && 0 != (proxy_delay = zbx_proxy_get_delay(history_lastid)))
 		zbx_json_adduint64(&j, ZBX_PROTO_TAG_PROXY_DELAY, proxy_delay);
 
-	if (SUCCEED != zbx_compress(j.buffer, j.buffer_size, &buffer, &buffer_size))
+	if (SUCCEED != zbx_compress_ext(codec, j.buffer, j.buffer_size, &buffer, &buffer_size))
 	{
 		zabbix_log(LOG_LEVEL_ERR,"cannot compress data: %s", zbx_compress_strerror());
 		goto clean;
@@ -321,7 +351,7 @@ void	zbx_send_proxy_data(zbx_socket_t *sock, zbx_timespec_t *ts, const zbx_confi
 	reserved = j.buffer_size;
 	zbx_json_free(&j);	/* json buffer can be large, free as fast as possible */
 
-	if (SUCCEED == send_data_to_server(sock, &buffer, buffer_size, reserved, config_comms->config_timeout,
+	if (SUCCEED == send_data_to_server(sock, &buffer, buffer_size, reserved, codec, config_comms->config_timeout,
 			&error))
 	{
 		zbx_set_availability_diff_ts(availability_ts);
@@ -329,23 +359,7 @@ void	zbx_send_proxy_data(zbx_socket_t *sock, zbx_timespec_t *ts, const zbx_confi
 		zbx_db_begin();
 
 		if (0 != history_lastid)
-		{
-			zbx_uint64_t	history_maxid;
-			zbx_db_result_t	result;
-			zbx_db_row_t	row;
-
-			result = zbx_db_select("select max(id) from proxy_history");
-
-			if (NULL == (row = zbx_db_fetch(result)) || SUCCEED == zbx_db_is_null(row[0]))
-				history_maxid = history_lastid;
-			else
-				ZBX_STR2UINT64(history_maxid, row[0]);
-
-			zbx_db_free_result(result);
-
-			zbx_reset_proxy_history_count(history_maxid - history_lastid);
 			zbx_proxy_set_hist_lastid(history_lastid);
-		}
 
 		if (0 != discovery_lastid)
 			zbx_proxy_set_dhis_lastid(discovery_lastid);
@@ -434,8 +448,8 @@ void	zbx_send_task_data(zbx_socket_t *sock, zbx_timespec_t *ts, const zbx_config
 	reserved = j.buffer_size;
 	zbx_json_free(&j);	/* json buffer can be large, free as fast as possible */
 
-	if (SUCCEED == send_data_to_server(sock, &buffer, buffer_size, reserved, config_comms->config_timeout,
-			&error))
+	if (SUCCEED == send_data_to_server(sock, &buffer, buffer_size, reserved, ZBX_COMPRESS_ZLIB,
+			config_comms->config_timeout, &error))
 	{
 		zbx_db_begin();
 
@@ -29,7 +29,8 @@ extern int	CONFIG_TRAPPER_TIMEOUT;
 
 void	zbx_recv_proxy_data(zbx_socket_t *sock, struct zbx_json_parse *jp, const zbx_timespec_t *ts,
 		const zbx_events_funcs_t *events_cbs, int config_timeout, int proxydata_frequency);
-void	zbx_send_proxy_data(zbx_socket_t *sock, zbx_timespec_t *ts, const zbx_config_comms_args_t *config_comms);
+void	zbx_send_proxy_data(zbx_socket_t *sock, const struct zbx_json_parse *jp_request, zbx_timespec_t *ts,
+		const zbx_config_comms_args_t *config_comms);
 void	zbx_send_task_data(zbx_socket_t *sock, zbx_timespec_t *ts, const zbx_config_comms_args_t *config_comms);
 
 int	zbx_send_proxy_data_response(const zbx_dc_proxy_t *proxy, zbx_socket_t *sock, const char *info, int status,
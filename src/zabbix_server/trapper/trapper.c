@@ -45,6 +45,9 @@
 #include "zbx_trigger_constants.h"
 #include "zbx_item_constants.h"
 #include "version.h"
+#include "zbxipcservice.h"
+
+#include <event.h>
 
 #ifdef HAVE_NETSNMP
 #	include "zbxrtc.h"
@@ -117,14 +120,14 @@ zbx_status_section_t;
  *                                                                            *
  ******************************************************************************/
 static void	recv_agenthistory(zbx_socket_t *sock, struct zbx_json_parse *jp, zbx_timespec_t *ts,
-		int config_timeout)
+		zbx_host_rights_t *rights, int config_timeout)
 {
 	char	*info = NULL;
 	int	ret;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	if (SUCCEED != (ret = zbx_process_agent_history_data(sock, jp, ts, &info)))
+	if (SUCCEED != (ret = zbx_process_agent_history_data(sock, jp, ts, rights, &info)))
 	{
 		zabbix_log(LOG_LEVEL_WARNING, "received invalid agent history data from \"%s\": %s", sock->peer, info);
 	}
@@ -522,6 +525,7 @@ static zbx_entry_info_t	templates, hosts_monitored, hosts_not_monitored, items_a
 			items_disabled, triggers_enabled_ok, triggers_enabled_problem, triggers_disabled, users_online,
 			users_offline, required_performance;
 static int		templates_res, users_res;
+static time_t		status_stats_lastupdate;
 
 static void	zbx_status_counters_init(void)
 {
@@ -533,7 +537,7 @@ static void	zbx_status_counters_init(void)
 	zbx_vector_ptr_create(&required_performance.counters);
 }
 
-static void	zbx_status_counters_free(void)
+static void	zbx_status_counters_clear(void)
 {
 	zbx_vector_ptr_clear_ext(&hosts_monitored.counters, zbx_default_mem_free_func);
 	zbx_vector_ptr_clear_ext(&hosts_not_monitored.counters, zbx_default_mem_free_func);
@@ -541,13 +545,6 @@ static void	zbx_status_counters_free(void)
 	zbx_vector_ptr_clear_ext(&items_active_notsupported.counters, zbx_default_mem_free_func);
 	zbx_vector_ptr_clear_ext(&items_disabled.counters, zbx_default_mem_free_func);
 	zbx_vector_ptr_clear_ext(&required_performance.counters, zbx_default_mem_free_func);
-
-	zbx_vector_ptr_destroy(&hosts_monitored.counters);
-	zbx_vector_ptr_destroy(&hosts_not_monitored.counters);
-	zbx_vector_ptr_destroy(&items_active_normal.counters);
-	zbx_vector_ptr_destroy(&items_active_notsupported.counters);
-	zbx_vector_ptr_destroy(&items_disabled.counters);
-	zbx_vector_ptr_destroy(&required_performance.counters);
 }
 
 const zbx_status_section_t	status_sections[] = {
@@ -721,15 +718,33 @@ static void	status_entry_export(struct zbx_json *json, const zbx_section_entry_t
 	zbx_free(tmp);
 }
 
-static void	status_stats_export(struct zbx_json *json, zbx_user_type_t access_level)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gather status information if the gathered snapshot has expired    *
+ *                                                                            *
+ * Comments: The snapshot is kept for a short time to avoid database queries  *
+ *           and configuration cache locking on every frontend request when   *
+ *           many dashboards with system information are opened.              *
+ *                                                                            *
+ ******************************************************************************/
+static void	status_stats_update(void)
 {
-	const zbx_status_section_t	*section;
-	const zbx_section_entry_t	*entry;
-	int				i;
+#define ZBX_STATUS_STATS_TTL	5
 
-	zbx_status_counters_init();
+	time_t	now;
 
-	/* get status information */
+	now = time(NULL);
+
+	if (0 != status_stats_lastupdate && now >= status_stats_lastupdate &&
+			now < status_stats_lastupdate + ZBX_STATUS_STATS_TTL)
+	{
+		return;
+	}
+
+	if (0 == status_stats_lastupdate)
+		zbx_status_counters_init();
+	else
+		zbx_status_counters_clear();
 
 	templates_res = DBget_template_count(&templates.counter.ui64);
 	users_res = DBget_user_count(&users_online.counter.ui64, &users_offline.counter.ui64);
@@ -738,6 +753,21 @@ static void	status_stats_export(struct zbx_json *json, zbx_user_type_t access_le
 			&triggers_enabled_ok.counter.ui64, &triggers_enabled_problem.counter.ui64,
 			&triggers_disabled.counter.ui64, &required_performance.counters);
 
+	status_stats_lastupdate = now;
+
+#undef ZBX_STATUS_STATS_TTL
+}
+
+static void	status_stats_export(struct zbx_json *json, zbx_user_type_t access_level)
+{
+	const zbx_status_section_t	*section;
+	const zbx_section_entry_t	*entry;
+	int				i;
+
+	/* get status information */
+
+	status_stats_update();
+
 	/* add status information to JSON */
 	for (section = status_sections; NULL != section->name; section++)
 	{
@@ -779,8 +809,6 @@ static void	status_stats_export(struct zbx_json *json, zbx_user_type_t access_le
 
 		zbx_json_close(json);
 	}
-
-	zbx_status_counters_free();
 }
 
 /******************************************************************************
@@ -1091,9 +1119,42 @@ static int	comms_parse_response(char *xml, char *host, size_t host_len, char *ke
 	return ret;
 }
 
+/* state kept between requests of persistent active agent or sender connection */
+typedef struct
+{
+	zbx_host_rights_t	rights;
+	unsigned char		persistent;
+}
+zbx_trapper_session_t;
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: check if active agent or sender asks to keep connection open for  *
+ *          further requests                                                  *
+ *                                                                            *
+ ******************************************************************************/
+static unsigned char	trapper_request_is_persistent(const struct zbx_json_parse *jp, const char *request)
+{
+	char	value[MAX_ID_LEN];
+
+	if (0 != strcmp(request, ZBX_PROTO_VALUE_AGENT_DATA) &&
+			0 != strcmp(request, ZBX_PROTO_VALUE_GET_ACTIVE_CHECKS) &&
+			0 != strcmp(request, ZBX_PROTO_VALUE_ACTIVE_CHECK_HEARTBEAT) &&
+			0 != strcmp(request, ZBX_PROTO_VALUE_SENDER_DATA))
+	{
+		return 0;
+	}
+
+	if (SUCCEED != zbx_json_value_by_name(jp, ZBX_PROTO_TAG_PERSISTENT, value, sizeof(value), NULL))
+		return 0;
+
+	return 0 == strcmp(value, "1") ? 1 : 0;
+}
+
 static int	process_trap(zbx_socket_t *sock, char *s, ssize_t bytes_received, zbx_timespec_t *ts,
 		const zbx_config_comms_args_t *config_comms, const zbx_config_vault_t *config_vault,
-		int config_startup_time, const zbx_events_funcs_t *events_cbs, int proxydata_frequency)
+		int config_startup_time, const zbx_events_funcs_t *events_cbs, int proxydata_frequency,
+		zbx_trapper_session_t *session)
 {
 	int	ret = SUCCEED;
 
@@ -1125,9 +1186,13 @@ static int	process_trap(zbx_socket_t *sock, char *s, ssize_t bytes_received, zbx
 			return FAIL;
 		}
 
+		if (NULL != session)
+			session->persistent = trapper_request_is_persistent(&jp, value);
+
 		if (0 == strcmp(value, ZBX_PROTO_VALUE_AGENT_DATA))
 		{
-			recv_agenthistory(sock, &jp, ts, config_comms->config_timeout);
+			recv_agenthistory(sock, &jp, ts, NULL != session ? &session->rights : NULL,
+					config_comms->config_timeout);
 		}
 		else if (0 == strcmp(value, ZBX_PROTO_VALUE_SENDER_DATA))
 		{
@@ -1146,7 +1211,7 @@ static int	process_trap(zbx_socket_t *sock, char *s, ssize_t bytes_received, zbx
 						proxydata_frequency);
 			}
 			else if (0 != (zbx_get_program_type_cb() & ZBX_PROGRAM_TYPE_PROXY_PASSIVE))
-				zbx_send_proxy_data(sock, ts, config_comms);
+				zbx_send_proxy_data(sock, &jp, ts, config_comms);
 		}
 		else if (0 == strcmp(value, ZBX_PROTO_VALUE_PROXY_HEARTBEAT))
 		{
@@ -1194,6 +1259,10 @@ static int	process_trap(zbx_socket_t *sock, char *s, ssize_t bytes_received, zbx
 		else if (0 == strcmp(value, ZBX_PROTO_VALUE_ACTIVE_CHECK_HEARTBEAT))
 		{
 			ret = process_active_check_heartbeat(&jp);
+
+			/* agent waits for response before sending next request over persistent connection */
+			if (NULL != session && 0 != session->persistent)
+				zbx_send_response(sock, ret, NULL, config_comms->config_timeout);
 		}
 		else if (SUCCEED != trapper_process_request(value, sock, &jp, config_comms->config_tls, config_vault,
 				zbx_get_program_type_cb, config_comms->config_timeout, config_comms->server))
@@ -1289,7 +1358,378 @@ static void	process_trapper_child(zbx_socket_t *sock, zbx_timespec_t *ts,
 		return;
 
 	process_trap(sock, sock->buffer, bytes_received, ts, config_comms, config_vault, config_startup_time,
-			events_cbs, proxydata_frequency);
+			events_cbs, proxydata_frequency, NULL);
+
+	/* release memory used to parse received history data */
+	zbx_history_data_arena_release();
+}
+
+/* connections accepted in event-driven mode go through ACCEPT -> RECV steps, persistent */
+/* connections return to RECV step after each processed request                            */
+#define ZBX_TRAPPER_STEP_ACCEPT	0
+#define ZBX_TRAPPER_STEP_RECV	1
+
+/* how long persistent connection can stay idle between requests */
+#define ZBX_TRAPPER_IDLE_TIMEOUT	SEC_PER_MIN
+
+typedef struct
+{
+	struct event_base	*base;
+	const zbx_socket_t	*listen_sock;
+	struct event		*ev_listen[ZBX_SOCKET_COUNT];
+	int			listening;
+	int			connections_num;
+	int			connections_max;
+	zbx_vector_ptr_t	received;
+}
+zbx_trapper_async_t;
+
+typedef struct
+{
+	zbx_socket_t		s;
+	zbx_tcp_recv_context_t	recv_context;
+	zbx_timespec_t		ts;
+	ssize_t			bytes_received;
+	unsigned char		step;
+	int			requests_num;
+	zbx_trapper_session_t	session;
+	struct event		*ev;
+	struct event		*ev_timeout;
+	zbx_trapper_async_t	*trapper;
+}
+zbx_trapper_conn_t;
+
+static void	trapper_conn_event_cb(evutil_socket_t fd, short what, void *arg);
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: start or stop accepting new connections                           *
+ *                                                                            *
+ ******************************************************************************/
+static void	trapper_async_listen(zbx_trapper_async_t *trapper, int listen)
+{
+	int	i;
+
+	if (listen == trapper->listening)
+		return;
+
+	for (i = 0; i < trapper->listen_sock->num_socks; i++)
+	{
+		if (0 != listen)
+			event_add(trapper->ev_listen[i], NULL);
+		else
+			event_del(trapper->ev_listen[i]);
+	}
+
+	trapper->listening = listen;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: close connection and resume accepting new connections if the      *
+ *          limit was reached                                                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	trapper_conn_free(zbx_trapper_conn_t *conn)
+{
+	zbx_trapper_async_t	*trapper = conn->trapper;
+
+	event_free(conn->ev);
+	event_free(conn->ev_timeout);
+	zbx_tcp_unaccept(&conn->s);
+	zbx_free(conn);
+
+	if (--trapper->connections_num < trapper->connections_max)
+		trapper_async_listen(trapper, 1);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: advance connection until it has to wait for socket, the request   *
+ *          is received or connection is closed                               *
+ *                                                                            *
+ ******************************************************************************/
+static void	trapper_conn_process(zbx_trapper_conn_t *conn)
+{
+	struct timeval	tv = {CONFIG_TRAPPER_TIMEOUT, 0};
+	short		event;
+
+	while (1)
+	{
+		switch (conn->step)
+		{
+			case ZBX_TRAPPER_STEP_ACCEPT:
+				/* Trapper has to accept all types of connections it can accept with the specified */
+				/* configuration. Only after receiving data it is known who has sent them and one  */
+				/* can decide to accept or discard the data.                                       */
+				if (SUCCEED != zbx_tcp_accept_check(&conn->s, ZBX_TCP_SEC_TLS_CERT |
+						ZBX_TCP_SEC_TLS_PSK | ZBX_TCP_SEC_UNENCRYPTED, &event))
+				{
+					if (0 != event)
+						goto wait;
+
+					zabbix_log(LOG_LEVEL_WARNING, "failed to accept an incoming connection: %s",
+							zbx_socket_strerror());
+					trapper_conn_free(conn);
+					return;
+				}
+
+				/* get connection timestamp */
+				zbx_timespec(&conn->ts);
+
+				zbx_tcp_recv_context_init(&conn->s, &conn->recv_context, ZBX_TCP_LARGE);
+				conn->step = ZBX_TRAPPER_STEP_RECV;
+
+				/* receiving is limited by trapper timeout after connection is established */
+				evtimer_del(conn->ev_timeout);
+				evtimer_add(conn->ev_timeout, &tv);
+				break;
+			case ZBX_TRAPPER_STEP_RECV:
+				if (FAIL == (conn->bytes_received = zbx_tcp_recv_context(&conn->s, &conn->recv_context,
+						ZBX_TCP_LARGE, &event)))
+				{
+					if (0 != event)
+						goto wait;
+
+					trapper_conn_free(conn);
+					return;
+				}
+
+				evtimer_del(conn->ev_timeout);
+
+				/* requests of persistent connection are timestamped when received */
+				if (0 != conn->requests_num)
+					zbx_timespec(&conn->ts);
+
+				zbx_vector_ptr_append(&conn->trapper->received, conn);
+				return;
+		}
+	}
+wait:
+	event_assign(conn->ev, conn->trapper->base, conn->s.socket, 0 != (event & POLLIN) ? EV_READ : EV_WRITE,
+			trapper_conn_event_cb, conn);
+	event_add(conn->ev, NULL);
+}
+
+static void	trapper_conn_event_cb(evutil_socket_t fd, short what, void *arg)
+{
+	ZBX_UNUSED(fd);
+	ZBX_UNUSED(what);
+
+	trapper_conn_process((zbx_trapper_conn_t *)arg);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: keep persistent connection open and wait for its next request     *
+ *                                                                            *
+ ******************************************************************************/
+static void	trapper_conn_wait_request(zbx_trapper_conn_t *conn)
+{
+	struct timeval	tv = {ZBX_TRAPPER_IDLE_TIMEOUT, 0};
+
+	conn->requests_num++;
+	conn->step = ZBX_TRAPPER_STEP_RECV;
+	zbx_tcp_recv_context_init(&conn->s, &conn->recv_context, ZBX_TCP_LARGE);
+
+	evtimer_add(conn->ev_timeout, &tv);
+
+	/* next request might be already buffered by TLS layer */
+	trapper_conn_process(conn);
+}
+
+static void	trapper_conn_timeout_cb(evutil_socket_t fd, short what, void *arg)
+{
+	zbx_trapper_conn_t	*conn = (zbx_trapper_conn_t *)arg;
+
+	ZBX_UNUSED(fd);
+	ZBX_UNUSED(what);
+
+	if (ZBX_TRAPPER_STEP_ACCEPT == conn->step)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "failed to accept an incoming connection: from %s: timed out",
+				conn->s.peer);
+	}
+
+	trapper_conn_free(conn);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: accept pending connections up to the concurrent connection limit  *
+ *                                                                            *
+ ******************************************************************************/
+static void	trapper_listen_cb(evutil_socket_t fd, short what, void *arg)
+{
+	zbx_trapper_async_t	*trapper = (zbx_trapper_async_t *)arg;
+
+	ZBX_UNUSED(what);
+
+	while (trapper->connections_num < trapper->connections_max)
+	{
+		zbx_trapper_conn_t	*conn;
+		struct timeval		tv;
+		int			ret;
+
+		conn = (zbx_trapper_conn_t *)zbx_malloc(NULL, sizeof(zbx_trapper_conn_t));
+
+		if (SUCCEED != (ret = zbx_tcp_accept_start(trapper->listen_sock, fd, &conn->s)))
+		{
+			/* connections can be taken by other trappers listening on the same socket */
+			if (TIMEOUT_ERROR != ret)
+			{
+				zabbix_log(LOG_LEVEL_WARNING, "failed to accept an incoming connection: %s",
+						zbx_socket_strerror());
+			}
+
+			zbx_free(conn);
+			break;
+		}
+
+		conn->step = ZBX_TRAPPER_STEP_ACCEPT;
+		conn->requests_num = 0;
+		memset(&conn->session, 0, sizeof(conn->session));
+		conn->trapper = trapper;
+		conn->ev = event_new(trapper->base, conn->s.socket, EV_READ, trapper_conn_event_cb, conn);
+		conn->ev_timeout = evtimer_new(trapper->base, trapper_conn_timeout_cb, conn);
+
+		tv.tv_sec = conn->s.timeout;
+		tv.tv_usec = 0;
+		evtimer_add(conn->ev_timeout, &tv);
+
+		if (++trapper->connections_num == trapper->connections_max)
+			trapper_async_listen(trapper, 0);
+
+		trapper_conn_process(conn);
+	}
+}
+
+static void	trapper_timer_cb(evutil_socket_t fd, short what, void *arg)
+{
+	ZBX_UNUSED(fd);
+	ZBX_UNUSED(what);
+	ZBX_UNUSED(arg);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: serve many connections at the same time, processing received      *
+ *          requests one after another                                        *
+ *                                                                            *
+ * Comments: Accepting connections, TLS handshakes and receiving requests are *
+ *           processed by event loop, so a slow client occupies a connection  *
+ *           slot instead of the whole trapper.                               *
+ *                                                                            *
+ ******************************************************************************/
+static void	trapper_async_run(const zbx_thread_trapper_args *trapper_args_in, const zbx_thread_info_t *info,
+		zbx_ipc_async_socket_t *rtc)
+{
+#define POLL_TIMEOUT	1
+	zbx_trapper_async_t	trapper;
+	struct event		*ev_timer;
+	struct timeval		tv = {POLL_TIMEOUT, 0};
+	double			sec = 0.0;
+	int			i, processed = 0;
+	unsigned char		process_type = info->process_type;
+	int			process_num = info->process_num;
+#ifndef HAVE_NETSNMP
+	ZBX_UNUSED(rtc);
+#endif
+
+	if (SUCCEED != zbx_tcp_listen_nonblocking(trapper_args_in->listen_sock))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "cannot listen for connections: %s", zbx_socket_strerror());
+		exit(EXIT_FAILURE);
+	}
+
+	if (NULL == (trapper.base = event_base_new()))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize event-driven trapper");
+		exit(EXIT_FAILURE);
+	}
+
+	trapper.listen_sock = trapper_args_in->listen_sock;
+	trapper.listening = 0;
+	trapper.connections_num = 0;
+	trapper.connections_max = trapper_args_in->config_max_concurrent_connections;
+	zbx_vector_ptr_create(&trapper.received);
+
+	for (i = 0; i < trapper.listen_sock->num_socks; i++)
+	{
+		trapper.ev_listen[i] = event_new(trapper.base, trapper.listen_sock->sockets[i], EV_READ | EV_PERSIST,
+				trapper_listen_cb, &trapper);
+	}
+
+	trapper_async_listen(&trapper, 1);
+	ev_timer = evtimer_new(trapper.base, trapper_timer_cb, NULL);
+
+	while (ZBX_IS_RUNNING())
+	{
+#ifdef HAVE_NETSNMP
+		zbx_uint32_t	rtc_cmd;
+		unsigned char	*rtc_data;
+		int		snmp_reload = 0;
+#endif
+		zbx_setproctitle("%s #%d [processed %d requests in " ZBX_FS_DBL " sec, %d connections,"
+				" waiting for connection]", get_process_type_string(process_type), process_num,
+				processed, sec, trapper.connections_num);
+
+		evtimer_add(ev_timer, &tv);
+
+		zbx_update_selfmon_counter(info, ZBX_PROCESS_STATE_IDLE);
+		event_base_loop(trapper.base, EVLOOP_ONCE);
+		zbx_update_selfmon_counter(info, ZBX_PROCESS_STATE_BUSY);
+
+		evtimer_del(ev_timer);
+		zbx_update_env(get_process_type_string(process_type), zbx_time());
+
+#ifdef HAVE_NETSNMP
+		while (SUCCEED == zbx_rtc_wait(rtc, info, &rtc_cmd, &rtc_data, 0) && 0 != rtc_cmd)
+		{
+			if (ZBX_RTC_SNMP_CACHE_RELOAD == rtc_cmd && 0 == snmp_reload)
+			{
+				zbx_clear_cache_snmp(process_type, process_num);
+				snmp_reload = 1;
+			}
+			else if (ZBX_RTC_SHUTDOWN == rtc_cmd)
+				return;
+		}
+#endif
+		if (0 == trapper.received.values_num)
+			continue;
+
+		zbx_setproctitle("%s #%d [processing data, %d connections]", get_process_type_string(process_type),
+				process_num, trapper.connections_num);
+
+		sec = zbx_time();
+
+		/* requests received while processing are appended and processed in the same pass */
+		for (i = 0; i < trapper.received.values_num; i++)
+		{
+			zbx_trapper_conn_t	*conn = (zbx_trapper_conn_t *)trapper.received.values[i];
+
+			process_trap(&conn->s, conn->s.buffer, conn->bytes_received, &conn->ts,
+					trapper_args_in->config_comms, trapper_args_in->config_vault,
+					trapper_args_in->config_startup_time, trapper_args_in->events_cbs,
+					trapper_args_in->proxydata_frequency, &conn->session);
+
+			/* release memory used to parse received history data */
+			zbx_history_data_arena_release();
+
+			if (0 != conn->session.persistent && ZBX_IS_RUNNING())
+				trapper_conn_wait_request(conn);
+			else
+				trapper_conn_free(conn);
+
+			/* let other connections progress between requests */
+			event_base_loop(trapper.base, EVLOOP_NONBLOCK);
+		}
+
+		processed = trapper.received.values_num;
+		zbx_vector_ptr_clear(&trapper.received);
+		sec = zbx_time() - sec;
+	}
+#undef POLL_TIMEOUT
 }
 
 ZBX_THREAD_ENTRY(trapper_thread, args)
@@ -1322,6 +1762,8 @@ ZBX_THREAD_ENTRY(trapper_thread, args)
 	zbx_tls_init_child(trapper_args_in->config_comms->config_tls, zbx_get_program_type_cb);
 	find_psk_in_cache = zbx_dc_get_psk_by_identity;
 #endif
+	zbx_tcp_allowed_peers_cache_enable();
+
 	zbx_setproctitle("%s #%d [connecting to the database]", get_process_type_string(process_type), process_num);
 
 	zbx_db_connect(ZBX_DB_CONNECT_NORMAL);
@@ -1331,6 +1773,16 @@ ZBX_THREAD_ENTRY(trapper_thread, args)
 			trapper_args_in->config_comms->config_timeout, &rtc);
 #endif
 
+	if (0 != trapper_args_in->config_max_concurrent_connections)
+	{
+#ifdef HAVE_NETSNMP
+		trapper_async_run(trapper_args_in, info, &rtc);
+#else
+		trapper_async_run(trapper_args_in, info, NULL);
+#endif
+		goto out;
+	}
+
 	while (ZBX_IS_RUNNING())
 	{
 #ifdef HAVE_NETSNMP
@@ -1352,7 +1804,10 @@ ZBX_THREAD_ENTRY(trapper_thread, args)
 		zbx_update_env(get_process_type_string(process_type), zbx_time());
 
 		if (TIMEOUT_ERROR == ret)
+		{
+			zbx_db_release_idle();
 			continue;
+		}
 
 		if (SUCCEED == ret)
 		{
@@ -1396,9 +1851,7 @@ ZBX_THREAD_ENTRY(trapper_thread, args)
 					zbx_socket_strerror());
 		}
 	}
-#ifdef HAVE_NETSNMP
 out:
-#endif
 	zbx_setproctitle("%s #%d [terminated]", get_process_type_string(process_type), process_num);
 
 	while (1)
@@ -40,6 +40,7 @@ typedef struct
 	zbx_socket_t			*listen_sock;
 	int				config_startup_time;
 	int				proxydata_frequency;
+	int				config_max_concurrent_connections;
 }
 zbx_thread_trapper_args;
 
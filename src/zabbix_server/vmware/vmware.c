@@ -92,6 +92,11 @@ zbx_vmware_t	*vmware = NULL;
 #define ZBX_VCENTER_LESS_THAN_6_5_0_STATS_MAXQUERYMETRICS	64
 #define ZBX_VCENTER_6_5_0_AND_MORE_STATS_MAXQUERYMETRICS	256
 
+/* the maximum number of vmware web service requests sent concurrently */
+#define ZBX_VMWARE_SOAP_REQUESTS_MAX	8
+/* the maximum time to wait for concurrent requests activity, in milliseconds */
+#define ZBX_VMWARE_SOAP_WAIT		1000
+
 ZBX_PTR_VECTOR_IMPL(str_uint64_pair, zbx_str_uint64_pair_t)
 ZBX_PTR_VECTOR_IMPL(vmware_datastore, zbx_vmware_datastore_t *)
 ZBX_PTR_VECTOR_IMPL(vmware_datacenter, zbx_vmware_datacenter_t *)
@@ -410,10 +415,11 @@ static int	vmware_diskinfo_diskname_compare(const void *d1, const void *d2);
 
 typedef struct
 {
-	const char	*name;
-	const char	*xpath;
-	nodeprocfunc_t	func;
-	unsigned short	vc_min;
+	const char		*name;
+	const char		*xpath;
+	nodeprocfunc_t		func;
+	unsigned short		vc_min;
+	xmlXPathCompExprPtr	xpath_comp;	/* xpath compiled on the first use */
 }
 zbx_vmware_propmap_t;
 
@@ -653,6 +659,20 @@ typedef struct
 }
 ZBX_HTTPPAGE;
 
+/* vmware web service request sent concurrently with other requests */
+typedef struct
+{
+	char		*request;
+	ZBX_HTTPPAGE	page;
+	xmlDoc		*doc;
+	char		*error;
+	int		ret;
+}
+zbx_vmware_soap_req_t;
+
+typedef char	*(*zbx_vmware_soap_request_func_t)(const zbx_vmware_service_t *service, const char *id,
+		const zbx_vector_cq_value_t *cq_values);
+
 static size_t	curl_write_cb(void *ptr, size_t size, size_t nmemb, void *userdata)
 {
 	size_t		r_size = size * nmemb;
@@ -757,34 +777,29 @@ static int	zbx_http_post(CURL *easyhandle, const char *request, ZBX_HTTPPAGE **r
 }
 /******************************************************************************
  *                                                                            *
- * Purpose: unification of vmware web service call with SOAP error validation *
+ * Purpose: validates vmware web service response for SOAP errors             *
  *                                                                            *
  * Parameters: fn_parent  - [IN] the parent function name for Log records     *
- *             easyhandle - [IN] the CURL handle                              *
- *             request    - [IN] the http request                             *
+ *             resp       - [IN] the http response                            *
  *             xdoc       - [OUT] the xml document response (optional)        *
  *             token      - [OUT] the soap token for next query (optional)    *
  *             error      - [OUT] the error message in the case of failure    *
  *                                (optional)                                  *
  *                                                                            *
- * Return value: SUCCEED - the SOAP request was completed successfully        *
+ * Return value: SUCCEED - the SOAP response has no errors                    *
  *               FAIL    - the SOAP request has failed                        *
  ******************************************************************************/
-static int	zbx_soap_post(const char *fn_parent, CURL *easyhandle, const char *request, xmlDoc **xdoc,
-		char **token , char **error)
+static int	zbx_soap_parse_response(const char *fn_parent, const ZBX_HTTPPAGE *resp, xmlDoc **xdoc, char **token,
+		char **error)
 {
 #	define ZBX_XPATH_RETRIEVE_PROPERTIES_TOKEN			\
 		"/*[local-name()='Envelope']/*[local-name()='Body']"	\
 		"/*[local-name()='RetrievePropertiesExResponse']"	\
 		"/*[local-name()='returnval']/*[local-name()='token'][1]"
 
-	xmlDoc		*doc;
-	ZBX_HTTPPAGE	*resp;
-	int		ret = SUCCEED;
-	char		*val = NULL;
-
-	if (SUCCEED != zbx_http_post(easyhandle, request, &resp, error))
-		return FAIL;
+	xmlDoc	*doc;
+	int	ret = SUCCEED;
+	char	*val = NULL;
 
 	if (NULL != fn_parent)
 		zabbix_log(LOG_LEVEL_TRACE, "%s() SOAP response: %s", fn_parent, resp->data);
@@ -836,6 +851,229 @@ static int	zbx_soap_post(const char *fn_parent, CURL *easyhandle, const char *re
 #	undef ZBX_XPATH_RETRIEVE_PROPERTIES_TOKEN
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: unification of vmware web service call with SOAP error validation *
+ *                                                                            *
+ * Parameters: fn_parent  - [IN] the parent function name for Log records     *
+ *             easyhandle - [IN] the CURL handle                              *
+ *             request    - [IN] the http request                             *
+ *             xdoc       - [OUT] the xml document response (optional)        *
+ *             token      - [OUT] the soap token for next query (optional)    *
+ *             error      - [OUT] the error message in the case of failure    *
+ *                                (optional)                                  *
+ *                                                                            *
+ * Return value: SUCCEED - the SOAP request was completed successfully        *
+ *               FAIL    - the SOAP request has failed                        *
+ ******************************************************************************/
+static int	zbx_soap_post(const char *fn_parent, CURL *easyhandle, const char *request, xmlDoc **xdoc,
+		char **token , char **error)
+{
+	ZBX_HTTPPAGE	*resp;
+
+	if (SUCCEED != zbx_http_post(easyhandle, request, &resp, error))
+		return FAIL;
+
+	return zbx_soap_parse_response(fn_parent, resp, xdoc, token, error);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: frees resources of concurrent SOAP requests                       *
+ *                                                                            *
+ * Parameters: reqs     - [IN] the requests                                   *
+ *             reqs_num - [IN] the number of requests                         *
+ *                                                                            *
+ ******************************************************************************/
+static void	vmware_soap_reqs_clean(zbx_vmware_soap_req_t *reqs, int reqs_num)
+{
+	int	i;
+
+	for (i = 0; i < reqs_num; i++)
+	{
+		zbx_free(reqs[i].request);
+		zbx_free(reqs[i].page.data);
+		zbx_free(reqs[i].error);
+		zbx_xml_free_doc(reqs[i].doc);
+		reqs[i].doc = NULL;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: performs several vmware web service calls concurrently            *
+ *                                                                            *
+ * Parameters: fn_parent  - [IN] the parent function name for Log records     *
+ *             easyhandle - [IN] the authenticated CURL handle                *
+ *             reqs       - [IN/OUT] the requests, on return every request    *
+ *                                   has its result, xml document response    *
+ *                                   or error message set                     *
+ *             reqs_num   - [IN] the number of requests, must not exceed      *
+ *                               ZBX_VMWARE_SOAP_REQUESTS_MAX                 *
+ *                                                                            *
+ * Comments: Every request is sent with its own duplicate of the              *
+ *           authenticated handle carrying the session cookie, so the         *
+ *           service processes them in parallel. Requests that cannot be      *
+ *           started or finished concurrently are sent sequentially with the  *
+ *           original handle.                                                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	zbx_soap_post_multi(const char *fn_parent, CURL *easyhandle, zbx_vmware_soap_req_t *reqs, int reqs_num)
+{
+	CURL	*handles[ZBX_VMWARE_SOAP_REQUESTS_MAX];
+	int	i, done[ZBX_VMWARE_SOAP_REQUESTS_MAX];
+
+	for (i = 0; i < reqs_num; i++)
+	{
+		memset(&reqs[i].page, 0, sizeof(reqs[i].page));
+		reqs[i].doc = NULL;
+		reqs[i].error = NULL;
+		reqs[i].ret = FAIL;
+		handles[i] = NULL;
+		done[i] = 0;
+	}
+
+#if LIBCURL_VERSION_NUM >= 0x071c00
+	/* curl_multi_wait() is supported starting with version 7.28.0 (0x071c00) */
+	if (1 < reqs_num)
+	{
+		CURLM			*multi;
+		CURLMcode		code;
+		CURLMsg			*msg;
+		struct curl_slist	*cookies = NULL, *cookie;
+		int			running, msgs_num;
+
+		if (NULL == (multi = curl_multi_init()))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "%s() cannot initialize cURL multi session", fn_parent);
+			goto serial;
+		}
+
+		if (CURLE_OK != curl_easy_getinfo(easyhandle, CURLINFO_COOKIELIST, &cookies))
+			cookies = NULL;
+
+		for (i = 0; i < reqs_num; i++)
+		{
+			if (NULL == (handles[i] = curl_easy_duphandle(easyhandle)))
+				continue;
+
+			for (cookie = cookies; NULL != cookie; cookie = cookie->next)
+				curl_easy_setopt(handles[i], CURLOPT_COOKIELIST, cookie->data);
+
+			if (CURLE_OK != curl_easy_setopt(handles[i], CURLOPT_WRITEDATA, &reqs[i].page) ||
+					CURLE_OK != curl_easy_setopt(handles[i], CURLOPT_PRIVATE, &reqs[i].page) ||
+					CURLE_OK != curl_easy_setopt(handles[i], CURLOPT_POSTFIELDS, reqs[i].request) ||
+					CURLM_OK != curl_multi_add_handle(multi, handles[i]))
+			{
+				curl_easy_cleanup(handles[i]);
+				handles[i] = NULL;
+			}
+		}
+
+		curl_slist_free_all(cookies);
+
+		while (1)
+		{
+			if (CURLM_OK != (code = curl_multi_perform(multi, &running)))
+			{
+				zabbix_log(LOG_LEVEL_WARNING, "%s() cannot perform on cURL multi handle: %s", fn_parent,
+						curl_multi_strerror(code));
+				break;
+			}
+
+			while (NULL != (msg = curl_multi_info_read(multi, &msgs_num)))
+			{
+				if (CURLMSG_DONE != msg->msg)
+					continue;
+
+				for (i = 0; i < reqs_num && handles[i] != msg->easy_handle; i++)
+					;
+
+				if (i == reqs_num)
+					continue;
+
+				if (CURLE_OK == msg->data.result)
+				{
+					reqs[i].ret = zbx_soap_parse_response(fn_parent, &reqs[i].page, &reqs[i].doc,
+							NULL, &reqs[i].error);
+				}
+				else
+					reqs[i].error = zbx_strdup(NULL, curl_easy_strerror(msg->data.result));
+
+				done[i] = 1;
+			}
+
+			if (0 == running)
+				break;
+
+			if (CURLM_OK != (code = curl_multi_wait(multi, NULL, 0, ZBX_VMWARE_SOAP_WAIT, NULL)))
+			{
+				zabbix_log(LOG_LEVEL_WARNING, "%s() cannot wait on cURL multi handle: %s", fn_parent,
+						curl_multi_strerror(code));
+				break;
+			}
+		}
+
+		for (i = 0; i < reqs_num; i++)
+		{
+			if (NULL == handles[i])
+				continue;
+
+			curl_multi_remove_handle(multi, handles[i]);
+			curl_easy_cleanup(handles[i]);
+		}
+
+		curl_multi_cleanup(multi);
+	}
+serial:
+#endif
+	for (i = 0; i < reqs_num; i++)
+	{
+		if (0 != done[i])
+			continue;
+
+		zbx_free(reqs[i].page.data);
+		memset(&reqs[i].page, 0, sizeof(reqs[i].page));
+		reqs[i].ret = zbx_soap_post(fn_parent, easyhandle, reqs[i].request, &reqs[i].doc, NULL, &reqs[i].error);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: retrieves data of several vmware objects concurrently             *
+ *                                                                            *
+ * Parameters: fn_parent    - [IN] the parent function name for Log records   *
+ *             service      - [IN] the vmware service                         *
+ *             easyhandle   - [IN] the authenticated CURL handle              *
+ *             request_func - [IN] the object data request builder            *
+ *             ids          - [IN] the object ids                             *
+ *             offset       - [IN] the index of the first object to retrieve  *
+ *             max_num      - [IN] the maximum number of objects to retrieve, *
+ *                                 must not exceed                            *
+ *                                 ZBX_VMWARE_SOAP_REQUESTS_MAX               *
+ *             cq_values    - [IN] the vector with custom query entries       *
+ *             reqs         - [OUT] the requests with object data             *
+ *                                                                            *
+ * Return value: the number of requests, which must be freed with             *
+ *               vmware_soap_reqs_clean()                                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	vmware_service_soap_prefetch(const char *fn_parent, const zbx_vmware_service_t *service,
+		CURL *easyhandle, zbx_vmware_soap_request_func_t request_func, const zbx_vector_str_t *ids,
+		int offset, int max_num, const zbx_vector_cq_value_t *cq_values, zbx_vmware_soap_req_t *reqs)
+{
+	int	i, reqs_num;
+
+	reqs_num = MIN(max_num, ids->values_num - offset);
+
+	for (i = 0; i < reqs_num; i++)
+		reqs[i].request = request_func(service, ids->values[offset + i], cq_values);
+
+	zbx_soap_post_multi(fn_parent, easyhandle, reqs, reqs_num);
+
+	return reqs_num;
+}
+
 /******************************************************************************
  *                                                                            *
  * performance counter hashset support functions                              *
@@ -994,9 +1232,11 @@ static void	vmware_free_perfdata(zbx_vmware_perf_data_t *data)
  * Return value: an array of property values                                  *
  *                                                                            *
  * Comments: The array with property values must be freed by the caller.      *
+ *           The property xpaths are compiled once per process and evaluated  *
+ *           within a single context.                                         *
  *                                                                            *
  ******************************************************************************/
-static char	**xml_read_props(xmlDoc *xdoc, const zbx_vmware_propmap_t *propmap, int props_num)
+static char	**xml_read_props(xmlDoc *xdoc, zbx_vmware_propmap_t *propmap, int props_num)
 {
 	xmlXPathContext	*xpathCtx;
 	xmlXPathObject	*xpathObj;
@@ -1008,11 +1248,17 @@ static char	**xml_read_props(xmlDoc *xdoc, const zbx_vmware_propmap_t *propmap,
 	props = (char **)zbx_malloc(NULL, sizeof(char *) * props_num);
 	memset(props, 0, sizeof(char *) * props_num);
 
+	xpathCtx = xmlXPathNewContext(xdoc);
+
 	for (i = 0; i < props_num; i++)
 	{
-		xpathCtx = xmlXPathNewContext(xdoc);
+		if (NULL == propmap[i].xpath_comp &&
+				NULL == (propmap[i].xpath_comp = xmlXPathCompile((const xmlChar *)propmap[i].xpath)))
+		{
+			continue;
+		}
 
-		if (NULL != (xpathObj = xmlXPathEvalExpression((const xmlChar *)propmap[i].xpath, xpathCtx)))
+		if (NULL != (xpathObj = xmlXPathCompiledEval(propmap[i].xpath_comp, xpathCtx)))
 		{
 			if (XPATH_STRING == xpathObj->type)
 			{
@@ -1039,10 +1285,10 @@ static char	**xml_read_props(xmlDoc *xdoc, const zbx_vmware_propmap_t *propmap,
 
 			xmlXPathFreeObject(xpathObj);
 		}
-
-		xmlXPathFreeContext(xpathCtx);
 	}
 
+	xmlXPathFreeContext(xpathCtx);
+
 	return props;
 }
 
@@ -1692,6 +1938,9 @@ static void	vmware_service_shared_free(zbx_vmware_service_t *service)
 	if (NULL != service->fullname)
 		vmware_shared_strfree(service->fullname);
 
+	if (NULL != service->session)
+		vmware_shared_strfree(service->session);
+
 	vmware_data_shared_free(service->data);
 
 	zbx_hashset_iter_reset(&service->entities, &iter);
@@ -2731,6 +2980,135 @@ static void	vmware_counter_free(zbx_vmware_counter_t *counter)
 	zbx_free(counter);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reuses the session kept from the previous vmware service update   *
+ *                                                                            *
+ * Parameters: service    - [IN] the vmware service                           *
+ *             easyhandle - [IN] the CURL handle                              *
+ *                                                                            *
+ * Return value: SUCCEED - the kept session is still active                   *
+ *               FAIL    - there is no kept session or it has expired         *
+ *                                                                            *
+ ******************************************************************************/
+static int	vmware_service_session_restore(zbx_vmware_service_t *service, CURL *easyhandle)
+{
+#	define ZBX_POST_VMWARE_CURRENT_SESSION						\
+		ZBX_POST_VSPHERE_HEADER							\
+		"<ns0:RetrievePropertiesEx>"						\
+			"<ns0:_this type=\"PropertyCollector\">%s</ns0:_this>"		\
+			"<ns0:specSet>"							\
+				"<ns0:propSet>"						\
+					"<ns0:type>SessionManager</ns0:type>"		\
+					"<ns0:pathSet>currentSession</ns0:pathSet>"	\
+				"</ns0:propSet>"					\
+				"<ns0:objectSet>"					\
+					"<ns0:obj type=\"SessionManager\">%s</ns0:obj>"	\
+				"</ns0:objectSet>"					\
+			"</ns0:specSet>"						\
+			"<ns0:options/>"						\
+		"</ns0:RetrievePropertiesEx>"						\
+		ZBX_POST_VSPHERE_FOOTER
+
+	char	tmp[MAX_STRING_LEN], *session = NULL, *cookie, *next, *value, *error = NULL;
+	xmlDoc	*doc = NULL;
+	int	ret = FAIL;
+
+	zbx_vmware_lock();
+
+	if (NULL != service->session)
+		session = zbx_strdup(NULL, service->session);
+
+	zbx_vmware_unlock();
+
+	if (NULL == session)
+		return FAIL;
+
+	for (cookie = session; NULL != cookie; cookie = next)
+	{
+		if (NULL != (next = strchr(cookie, '\n')))
+			*next++ = '\0';
+
+		if (CURLE_OK != curl_easy_setopt(easyhandle, CURLOPT_COOKIELIST, cookie))
+			goto out;
+	}
+
+	zbx_snprintf(tmp, sizeof(tmp), ZBX_POST_VMWARE_CURRENT_SESSION,
+			vmware_service_objects[service->type].property_collector,
+			vmware_service_objects[service->type].session_manager);
+
+	if (SUCCEED != zbx_soap_post(__func__, easyhandle, tmp, &doc, NULL, &error))
+		goto out;
+
+	if (NULL != (value = zbx_xml_doc_read_value(doc, ZBX_XPATH_PROP_NAME("currentSession"))))
+	{
+		zbx_free(value);
+		ret = SUCCEED;
+	}
+out:
+	if (SUCCEED != ret)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "%s() cannot reuse session: %s", __func__, ZBX_NULL2EMPTY_STR(error));
+		curl_easy_setopt(easyhandle, CURLOPT_COOKIELIST, "ALL");
+	}
+
+	zbx_xml_free_doc(doc);
+	zbx_free(error);
+	zbx_free(session);
+
+	return ret;
+
+#	undef ZBX_POST_VMWARE_CURRENT_SESSION
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: keeps the authenticated session for the next vmware service       *
+ *          updates                                                           *
+ *                                                                            *
+ * Parameters: service    - [IN] the vmware service                           *
+ *             easyhandle - [IN] the CURL handle                              *
+ *                                                                            *
+ * Return value: SUCCEED - the session was kept                               *
+ *               FAIL    - the session cookies cannot be read                 *
+ *                                                                            *
+ ******************************************************************************/
+static int	vmware_service_session_store(zbx_vmware_service_t *service, CURL *easyhandle)
+{
+	struct curl_slist	*cookies = NULL, *cookie;
+	char			*session = NULL;
+	size_t			session_alloc = 0, session_offset = 0;
+
+	if (CURLE_OK != curl_easy_getinfo(easyhandle, CURLINFO_COOKIELIST, &cookies) || NULL == cookies)
+		return FAIL;
+
+	for (cookie = cookies; NULL != cookie; cookie = cookie->next)
+	{
+		if (0 != session_offset)
+			zbx_chrcpy_alloc(&session, &session_alloc, &session_offset, '\n');
+
+		zbx_strcpy_alloc(&session, &session_alloc, &session_offset, cookie->data);
+	}
+
+	curl_slist_free_all(cookies);
+
+	zbx_vmware_lock();
+
+	if (NULL == service->session || 0 != strcmp(service->session, session))
+	{
+		if (NULL != service->session)
+			vmware_shared_strfree(service->session);
+
+		service->session = vmware_shared_strdup(session);
+	}
+
+	zbx_vmware_unlock();
+
+	zbx_free(session);
+
+	return SUCCEED;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: authenticates vmware service                                      *
@@ -2805,6 +3183,13 @@ static int	vmware_service_authenticate(zbx_vmware_service_t *service, CURL *easy
 		}
 	}
 
+	/* the service type is known after the first login, so the session kept since then may be reused */
+	if (ZBX_VMWARE_TYPE_UNKNOWN != service->type && SUCCEED == vmware_service_session_restore(service, easyhandle))
+	{
+		ret = SUCCEED;
+		goto out;
+	}
+
 	username_esc = zbx_xml_escape_dyn(service->username);
 	password_esc = zbx_xml_escape_dyn(service->password);
 
@@ -3608,23 +3993,17 @@ clean:
 
 /******************************************************************************
  *                                                                            *
- * Purpose: gets the virtual machine data                                     *
+ * Purpose: creates the virtual machine data request                          *
  *                                                                            *
  * Parameters: service      - [IN] the vmware service                         *
- *             easyhandle   - [IN] the CURL handle                            *
  *             vmid         - [IN] the virtual machine id                     *
- *             propmap      - [IN] the xpaths of the properties to read       *
- *             props_num    - [IN] the number of properties to read           *
- *             cq_prop      - [IN] the soap part of query with cq property    *
- *             xdoc         - [OUT] a reference to output xml document        *
- *             error        - [OUT] the error message in the case of failure  *
+ *             cq_values    - [IN] the vector with custom query entries       *
  *                                                                            *
- * Return value: SUCCEED - the operation has completed successfully           *
- *               FAIL    - the operation has failed                           *
+ * Return value: the SOAP request                                             *
  *                                                                            *
  ******************************************************************************/
-static int	vmware_service_get_vm_data(zbx_vmware_service_t *service, CURL *easyhandle, const char *vmid,
-		const zbx_vmware_propmap_t *propmap, int props_num, const char *cq_prop, xmlDoc **xdoc, char **error)
+static char	*vmware_service_vm_data_request(const zbx_vmware_service_t *service, const char *vmid,
+		const zbx_vector_cq_value_t *cq_values)
 {
 #	define ZBX_POST_VMWARE_VM_STATUS_EX 						\
 		ZBX_POST_VSPHERE_HEADER							\
@@ -3674,30 +4053,33 @@ static int	vmware_service_get_vm_data(zbx_vmware_service_t *service, CURL *easyh
 		"</ns0:RetrievePropertiesEx>"						\
 		ZBX_POST_VSPHERE_FOOTER
 
-	char	*tmp, props[ZBX_VMWARE_VMPROPS_NUM * 150], *vmid_esc;
-	int	i, ret;
+	char			*tmp, props[ZBX_VMWARE_VMPROPS_NUM * 150], *vmid_esc, *cq_prop;
+	int			i;
+	zbx_vector_cq_value_t	cqvs;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() vmid:'%s'", __func__, vmid);
 	props[0] = '\0';
 
-	for (i = 0; i < props_num; i++)
+	for (i = 0; i < ZBX_VMWARE_VMPROPS_NUM; i++)
 	{
 		zbx_strscat(props, "<ns0:pathSet>");
-		zbx_strscat(props, propmap[i].name);
+		zbx_strscat(props, vm_propmap[i].name);
 		zbx_strscat(props, "</ns0:pathSet>");
 	}
 
+	zbx_vector_cq_value_create(&cqvs);
+	cq_prop = vmware_cq_prop_soap_request(cq_values, ZBX_VMWARE_SOAP_VM, vmid, &cqvs);
+	zbx_vector_cq_value_destroy(&cqvs);
+
 	vmid_esc = zbx_xml_escape_dyn(vmid);
 	tmp = zbx_dsprintf(NULL, ZBX_POST_VMWARE_VM_STATUS_EX,
 			vmware_service_objects[service->type].property_collector, props, cq_prop, vmid_esc);
 
 	zbx_free(vmid_esc);
-	ret = zbx_soap_post(__func__, easyhandle, tmp, xdoc, NULL, error);
-	zbx_str_free(tmp);
+	zbx_free(cq_prop);
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+	return tmp;
 
-	return ret;
+#	undef ZBX_POST_VMWARE_VM_STATUS_EX
 }
 
 /******************************************************************************
@@ -4237,6 +4619,7 @@ clean:
  * Parameters: service      - [IN] the vmware service                         *
  *             easyhandle   - [IN] the CURL handle                            *
  *             id           - [IN] the virtual machine id                     *
+ *             details      - [IN] the virtual machine data                   *
  *             rpools       - [IN/OUT] the vector with all Resource Pools     *
  *             cq_values    - [IN/OUT] the vector with custom query entries   *
  *             alarms_data  - [IN/OUT] the all alarms with cache              *
@@ -4247,15 +4630,14 @@ clean:
  *                                                                            *
  ******************************************************************************/
 static zbx_vmware_vm_t	*vmware_service_create_vm(zbx_vmware_service_t *service, CURL *easyhandle,
-		const char *id, zbx_vector_vmware_resourcepool_t *rpools, zbx_vector_cq_value_t *cq_values,
-		zbx_vmware_alarms_data_t *alarms_data, char **error)
+		const char *id, xmlDoc *details, zbx_vector_vmware_resourcepool_t *rpools,
+		zbx_vector_cq_value_t *cq_values, zbx_vmware_alarms_data_t *alarms_data, char **error)
 {
 	zbx_vmware_vm_t		*vm;
 	char			*value, *cq_prop;
-	xmlDoc			*details = NULL;
 	zbx_vector_cq_value_t	cqvs;
 	const char		*uuid_xpath[3] = {NULL, ZBX_XPATH_VM_UUID(), ZBX_XPATH_VM_INSTANCE_UUID()};
-	int			ret;
+	int			ret = FAIL;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() vmid:'%s'", __func__, id);
 
@@ -4267,19 +4649,12 @@ static zbx_vmware_vm_t	*vmware_service_create_vm(zbx_vmware_service_t *service,
 	zbx_vector_vmware_custom_attr_create(&vm->custom_attrs);
 	zbx_vector_cq_value_create(&cqvs);
 	cq_prop = vmware_cq_prop_soap_request(cq_values, ZBX_VMWARE_SOAP_VM, id, &cqvs);
-	ret = vmware_service_get_vm_data(service, easyhandle, id, vm_propmap, ZBX_VMWARE_VMPROPS_NUM, cq_prop,
-			&details, error);
 	zbx_str_free(cq_prop);
 
-	if (FAIL == ret)
-		goto out;
-
 	if (NULL == (value = zbx_xml_doc_read_value(details, uuid_xpath[service->type])))
-	{
-		ret = FAIL;
 		goto out;
-	}
 
+	ret = SUCCEED;
 	vm->uuid = value;
 	vm->id = zbx_strdup(NULL, id);
 
@@ -4337,7 +4712,6 @@ static zbx_vmware_vm_t	*vmware_service_create_vm(zbx_vmware_service_t *service,
 			error);
 out:
 	zbx_vector_cq_value_destroy(&cqvs);
-	zbx_xml_free_doc(details);
 
 	if (SUCCEED != ret)
 	{
@@ -4455,20 +4829,17 @@ out:
 
 /******************************************************************************
  *                                                                            *
- * Purpose: create vmware hypervisor datastore object                         *
+ * Purpose: creates the datastore data request                                *
  *                                                                            *
  * Parameters: service      - [IN] the vmware service                         *
- *             easyhandle   - [IN] the CURL handle                            *
  *             id           - [IN] the datastore id                           *
- *             cq_values    - [IN/OUT] the custom query values                *
- *             alarms_data  - [IN/OUT] the all alarms with cache              *
+ *             cq_values    - [IN] the custom query values                    *
  *                                                                            *
- * Return value: The created datastore object or NULL if an error was         *
- *                detected                                                    *
+ * Return value: the SOAP request                                             *
  *                                                                            *
  ******************************************************************************/
-static zbx_vmware_datastore_t	*vmware_service_create_datastore(const zbx_vmware_service_t *service, CURL *easyhandle,
-		const char *id, zbx_vector_cq_value_t *cq_values, zbx_vmware_alarms_data_t *alarms_data)
+static char	*vmware_service_datastore_data_request(const zbx_vmware_service_t *service, const char *id,
+		const zbx_vector_cq_value_t *cq_values)
 {
 #	define ZBX_POST_DATASTORE_GET								\
 		ZBX_POST_VSPHERE_HEADER								\
@@ -4490,37 +4861,73 @@ static zbx_vmware_datastore_t	*vmware_service_create_datastore(const zbx_vmware_
 		"</ns0:RetrievePropertiesEx>"							\
 		ZBX_POST_VSPHERE_FOOTER
 
-	char			*tmp, *cq_prop, *uuid = NULL, *name = NULL, *path, *id_esc, *value, *error = NULL;
-	int			ret;
+	char			*tmp, *cq_prop, *id_esc;
+	zbx_vector_cq_value_t	cqvs;
+
+	zbx_vector_cq_value_create(&cqvs);
+	cq_prop = vmware_cq_prop_soap_request(cq_values, ZBX_VMWARE_SOAP_DS, id, &cqvs);
+	zbx_vector_cq_value_destroy(&cqvs);
+
+	id_esc = zbx_xml_escape_dyn(id);
+	tmp = zbx_dsprintf(NULL, ZBX_POST_DATASTORE_GET, vmware_service_objects[service->type].property_collector,
+			cq_prop, id_esc);
+	zbx_free(id_esc);
+	zbx_free(cq_prop);
+
+	return tmp;
+
+#	undef ZBX_POST_DATASTORE_GET
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if datastores must be refreshed before reading their data  *
+ *                                                                            *
+ * Parameters: service      - [IN] the vmware service                         *
+ *                                                                            *
+ * Return value: SUCCEED - datastores must be refreshed                       *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	vmware_service_datastore_refresh_required(const zbx_vmware_service_t *service)
+{
+	if (ZBX_VMWARE_TYPE_VSPHERE == service->type && NULL != service->version &&
+			ZBX_VMWARE_DS_REFRESH_VERSION > service->major_version)
+	{
+		return SUCCEED;
+	}
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: create vmware hypervisor datastore object                         *
+ *                                                                            *
+ * Parameters: service      - [IN] the vmware service                         *
+ *             easyhandle   - [IN] the CURL handle                            *
+ *             id           - [IN] the datastore id                           *
+ *             doc          - [IN] the datastore data                         *
+ *             cq_values    - [IN/OUT] the custom query values                *
+ *             alarms_data  - [IN/OUT] the all alarms with cache              *
+ *                                                                            *
+ * Return value: The created datastore object or NULL if an error was         *
+ *                detected                                                    *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_vmware_datastore_t	*vmware_service_create_datastore(const zbx_vmware_service_t *service, CURL *easyhandle,
+		const char *id, xmlDoc *doc, zbx_vector_cq_value_t *cq_values, zbx_vmware_alarms_data_t *alarms_data)
+{
+	char			*cq_prop, *uuid = NULL, *name = NULL, *path, *value, *error = NULL;
 	zbx_vmware_datastore_t	*datastore = NULL;
 	zbx_uint64_t		capacity = ZBX_MAX_UINT64, free_space = ZBX_MAX_UINT64, uncommitted = ZBX_MAX_UINT64;
-	xmlDoc			*doc = NULL;
 	zbx_vector_cq_value_t	cqvs;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() datastore:'%s'", __func__, id);
 
 	zbx_vector_cq_value_create(&cqvs);
-	id_esc = zbx_xml_escape_dyn(id);
-
-	if (ZBX_VMWARE_TYPE_VSPHERE == service->type && NULL != service->version &&
-			ZBX_VMWARE_DS_REFRESH_VERSION > service->major_version && SUCCEED !=
-			vmware_service_refresh_datastore_info(easyhandle, id_esc, &error))
-	{
-		zbx_free(id_esc);
-		goto out;
-	}
-
-
 	cq_prop = vmware_cq_prop_soap_request(cq_values, ZBX_VMWARE_SOAP_DS, id, &cqvs);
-	tmp = zbx_dsprintf(NULL, ZBX_POST_DATASTORE_GET, vmware_service_objects[service->type].property_collector,
-			cq_prop, id_esc);
-	zbx_str_free(id_esc);
 	zbx_str_free(cq_prop);
-	ret = zbx_soap_post(__func__, easyhandle, tmp, &doc, NULL, &error);
-	zbx_str_free(tmp);
-
-	if (FAIL == ret)
-		goto out;
 
 	name = zbx_xml_doc_read_value(doc, ZBX_XPATH_DATASTORE_SUMMARY("name"));
 
@@ -4594,7 +5001,6 @@ static zbx_vmware_datastore_t	*vmware_service_create_datastore(const zbx_vmware_
 		datastore = NULL;
 	}
 out:
-	zbx_xml_free_doc(doc);
 	zbx_vector_cq_value_destroy(&cqvs);
 
 	if (NULL != error)
@@ -4610,23 +5016,17 @@ out:
 
 /******************************************************************************
  *                                                                            *
- * Purpose: gets the vmware hypervisor data                                   *
+ * Purpose: creates the vmware hypervisor data request                        *
  *                                                                            *
  * Parameters: service      - [IN] the vmware service                         *
- *             easyhandle   - [IN] the CURL handle                            *
  *             hvid         - [IN] the vmware hypervisor id                   *
- *             propmap      - [IN] the xpaths of the properties to read       *
- *             props_num    - [IN] the number of properties to read           *
- *             cq_prop      - [IN] the soap part of query with cq property    *
- *             xdoc         - [OUT] a reference to output xml document        *
- *             error        - [OUT] the error message in the case of failure  *
+ *             cq_values    - [IN] the vector with custom query entries       *
  *                                                                            *
- * Return value: SUCCEED - the operation has completed successfully           *
- *               FAIL    - the operation has failed                           *
+ * Return value: the SOAP request                                             *
  *                                                                            *
  ******************************************************************************/
-static int	vmware_service_get_hv_data(const zbx_vmware_service_t *service, CURL *easyhandle, const char *hvid,
-		const zbx_vmware_propmap_t *propmap, int props_num, const char *cq_prop, xmlDoc **xdoc, char **error)
+static char	*vmware_service_hv_data_request(const zbx_vmware_service_t *service, const char *hvid,
+		const zbx_vector_cq_value_t *cq_values)
 {
 #	define ZBX_POST_HV_DETAILS 										\
 		ZBX_POST_VSPHERE_HEADER										\
@@ -4656,37 +5056,40 @@ static int	vmware_service_get_hv_data(const zbx_vmware_service_t *service, CURL
 		"</ns0:RetrievePropertiesEx>"									\
 		ZBX_POST_VSPHERE_FOOTER
 
-	char	*tmp, props[ZBX_VMWARE_HVPROPS_NUM * 150], *hvid_esc;
-	int	i, ret = FAIL;
+	char			*tmp, props[ZBX_VMWARE_HVPROPS_NUM * 150], *hvid_esc, *cq_prop;
+	int			i;
+	zbx_vector_cq_value_t	cqvs;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() guesthvid:'%s'", __func__, hvid);
 	props[0] = '\0';
 
-	for (i = 0; i < props_num; i++)
+	for (i = 0; i < ZBX_VMWARE_HVPROPS_NUM; i++)
 	{
-		if (NULL == propmap[i].name)
+		if (NULL == hv_propmap[i].name)
 			continue;
 
-		if (0 != propmap[i].vc_min && propmap[i].vc_min > service->major_version * 10 + service->minor_version)
+		if (0 != hv_propmap[i].vc_min &&
+				hv_propmap[i].vc_min > service->major_version * 10 + service->minor_version)
+		{
 			continue;
+		}
 
 		zbx_strscat(props, "<ns0:pathSet>");
-		zbx_strscat(props, propmap[i].name);
+		zbx_strscat(props, hv_propmap[i].name);
 		zbx_strscat(props, "</ns0:pathSet>");
 	}
 
+	zbx_vector_cq_value_create(&cqvs);
+	cq_prop = vmware_cq_prop_soap_request(cq_values, ZBX_VMWARE_SOAP_HV, hvid, &cqvs);
+	zbx_vector_cq_value_destroy(&cqvs);
+
 	hvid_esc = zbx_xml_escape_dyn(hvid);
 	tmp = zbx_dsprintf(NULL, ZBX_POST_HV_DETAILS, vmware_service_objects[service->type].property_collector,
 			props, cq_prop, hvid_esc);
 	zbx_free(hvid_esc);
+	zbx_free(cq_prop);
 	zabbix_log(LOG_LEVEL_TRACE, "%s() SOAP request: %s", __func__, tmp);
 
-	ret = zbx_soap_post(__func__, easyhandle, tmp, xdoc, NULL, error);
-	zbx_str_free(tmp);
-
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
-
-	return ret;
+	return tmp;
 
 #	undef	ZBX_POST_HV_DETAILS
 }
@@ -5944,6 +6347,7 @@ static const char	*vmware_hv_vsan_uuid(zbx_vector_vmware_datastore_t *dss, zbx_v
  * Parameters: service      - [IN] the vmware service                         *
  *             easyhandle   - [IN] the CURL handle                            *
  *             id           - [IN] the vmware hypervisor id                   *
+ *             details      - [IN] the vmware hypervisor data                 *
  *             dss          - [IN/OUT] the vector with all Datastores         *
  *             rpools       - [IN/OUT] the vector with all Resource Pools     *
  *             cq_values    - [IN/OUT] the vector with custom query entries   *
@@ -5956,13 +6360,14 @@ static const char	*vmware_hv_vsan_uuid(zbx_vector_vmware_datastore_t *dss, zbx_v
  *                                                                            *
  ******************************************************************************/
 static int	vmware_service_init_hv(zbx_vmware_service_t *service, CURL *easyhandle, const char *id,
-		zbx_vector_vmware_datastore_t *dss, zbx_vector_vmware_resourcepool_t *rpools,
+		xmlDoc *details, zbx_vector_vmware_datastore_t *dss, zbx_vector_vmware_resourcepool_t *rpools,
 		zbx_vector_cq_value_t *cq_values, zbx_vmware_alarms_data_t *alarms_data, zbx_vmware_hv_t *hv,
 		char **error)
 {
 	char				*value, *cq_prop;
-	int				i, j, ret;
-	xmlDoc				*details = NULL, *multipath_data = NULL;
+	int				i, j, k, reqs_num, ret = FAIL;
+	xmlDoc				*multipath_data = NULL;
+	zbx_vmware_soap_req_t		reqs[ZBX_VMWARE_SOAP_REQUESTS_MAX];
 	zbx_vector_str_t		datastores, vms;
 	zbx_vector_cq_value_t		cqvs;
 	zbx_vector_ptr_pair_t		disks_info;
@@ -5982,15 +6387,8 @@ static int	vmware_service_init_hv(zbx_vmware_service_t *service, CURL *easyhandl
 
 	zbx_vector_vmware_pnic_create(&hv->pnics);
 	cq_prop = vmware_cq_prop_soap_request(cq_values, ZBX_VMWARE_SOAP_HV, id, &cqvs);
-	ret = vmware_service_get_hv_data(service, easyhandle, id, hv_propmap, ZBX_VMWARE_HVPROPS_NUM, cq_prop,
-			&details, error);
 	zbx_str_free(cq_prop);
 
-	if (FAIL == ret)
-		goto out;
-
-	ret = FAIL;
-
 	if (NULL == (hv->props = xml_read_props(details, hv_propmap, ZBX_VMWARE_HVPROPS_NUM)))
 		goto out;
 
@@ -6112,20 +6510,39 @@ static int	vmware_service_init_hv(zbx_vmware_service_t *service, CURL *easyhandl
 	zbx_xml_read_values(details, ZBX_XPATH_HV_VMS(), &vms);
 	zbx_vector_ptr_reserve(&hv->vms, (size_t)(vms.values_num + hv->vms.values_alloc));
 
-	for (i = 0; i < vms.values_num; i++)
+	for (i = 0; i < vms.values_num; i += reqs_num)
 	{
-		zbx_vmware_vm_t	*vm;
+		reqs_num = vmware_service_soap_prefetch(__func__, service, easyhandle, vmware_service_vm_data_request,
+				&vms, i, ZBX_VMWARE_SOAP_REQUESTS_MAX, cq_values, reqs);
 
-		if (NULL != (vm = vmware_service_create_vm(service, easyhandle, vms.values[i], rpools, cq_values,
-				alarms_data, error)))
-		{
-			zbx_vector_ptr_append(&hv->vms, vm);
-		}
-		else if (NULL != *error)
+		for (k = 0; k < reqs_num; k++)
 		{
-			zabbix_log(LOG_LEVEL_DEBUG, "Unable initialize vm %s: %s.", vms.values[i], *error);
-			zbx_free(*error);
+			zbx_vmware_vm_t	*vm;
+
+			if (SUCCEED != reqs[k].ret)
+			{
+				if (NULL != reqs[k].error)
+				{
+					zabbix_log(LOG_LEVEL_DEBUG, "Unable initialize vm %s: %s.", vms.values[i + k],
+							reqs[k].error);
+				}
+
+				continue;
+			}
+
+			if (NULL != (vm = vmware_service_create_vm(service, easyhandle, vms.values[i + k],
+					reqs[k].doc, rpools, cq_values, alarms_data, error)))
+			{
+				zbx_vector_ptr_append(&hv->vms, vm);
+			}
+			else if (NULL != *error)
+			{
+				zabbix_log(LOG_LEVEL_DEBUG, "Unable initialize vm %s: %s.", vms.values[i + k], *error);
+				zbx_free(*error);
+			}
 		}
+
+		vmware_soap_reqs_clean(reqs, reqs_num);
 	}
 
 	zbx_vector_vmware_diskinfo_reserve(&hv->diskinfo, (size_t)disks_info.values_num);
@@ -6139,7 +6556,6 @@ static int	vmware_service_init_hv(zbx_vmware_service_t *service, CURL *easyhandl
 	ret = SUCCEED;
 out:
 	zbx_xml_free_doc(multipath_data);
-	zbx_xml_free_doc(details);
 
 	zbx_vector_str_clear_ext(&vms, zbx_str_free);
 	zbx_vector_str_destroy(&vms);
@@ -8547,7 +8963,8 @@ int	zbx_vmware_service_update(zbx_vmware_service_t *service)
 	zbx_vector_ptr_t	events;
 	zbx_vector_cq_value_t	dvs_query_values, prop_query_values, cust_query_values;
 	zbx_vmware_alarms_data_t	alarms_data;
-	int			i, ret = FAIL;
+	zbx_vmware_soap_req_t	reqs[ZBX_VMWARE_SOAP_REQUESTS_MAX];
+	int			i, j, reqs_num, reqs_max, ret = FAIL;
 	ZBX_HTTPPAGE		page;	/* 347K/87K */
 	unsigned char		evt_pause = 0, evt_skip_old;
 	zbx_uint64_t		evt_last_key, events_sz = 0;
@@ -8621,15 +9038,52 @@ int	zbx_vmware_service_update(zbx_vmware_service_t *service)
 
 	zbx_vector_vmware_datastore_reserve(&data->datastores, (size_t)(dss.values_num + data->datastores.values_alloc));
 
-	for (i = 0; i < dss.values_num; i++)
+	/* datastores must be refreshed one by one right before reading their data */
+	reqs_max = SUCCEED == vmware_service_datastore_refresh_required(service) ? 1 : ZBX_VMWARE_SOAP_REQUESTS_MAX;
+
+	for (i = 0; i < dss.values_num; i += reqs_num)
 	{
 		zbx_vmware_datastore_t	*datastore;
 
-		if (NULL != (datastore = vmware_service_create_datastore(service, easyhandle, dss.values[i],
-				&prop_query_values, &alarms_data)))
+		if (1 == reqs_max)
+		{
+			char	*id_esc, *error = NULL;
+			int	res;
+
+			id_esc = zbx_xml_escape_dyn(dss.values[i]);
+			res = vmware_service_refresh_datastore_info(easyhandle, id_esc, &error);
+			zbx_free(id_esc);
+
+			if (SUCCEED != res)
+			{
+				zabbix_log(LOG_LEVEL_WARNING, "Cannot get Datastore info: %s.", ZBX_NULL2EMPTY_STR(error));
+				zbx_free(error);
+				reqs_num = 1;
+				continue;
+			}
+		}
+
+		reqs_num = vmware_service_soap_prefetch(__func__, service, easyhandle,
+				vmware_service_datastore_data_request, &dss, i, reqs_max, &prop_query_values, reqs);
+
+		for (j = 0; j < reqs_num; j++)
 		{
-			zbx_vector_vmware_datastore_append(&data->datastores, datastore);
+			if (SUCCEED != reqs[j].ret)
+			{
+				if (NULL != reqs[j].error)
+					zabbix_log(LOG_LEVEL_WARNING, "Cannot get Datastore info: %s.", reqs[j].error);
+
+				continue;
+			}
+
+			if (NULL != (datastore = vmware_service_create_datastore(service, easyhandle, dss.values[i + j],
+					reqs[j].doc, &prop_query_values, &alarms_data)))
+			{
+				zbx_vector_vmware_datastore_append(&data->datastores, datastore);
+			}
 		}
+
+		vmware_soap_reqs_clean(reqs, reqs_num);
 	}
 
 	zbx_vector_vmware_datastore_sort(&data->datastores, vmware_ds_id_compare);
@@ -8647,30 +9101,52 @@ int	zbx_vmware_service_update(zbx_vmware_service_t *service)
 		exit(EXIT_FAILURE);
 	}
 
-	for (i = 0; i < hvs.values_num; i++)
+	for (i = 0; i < hvs.values_num; i += reqs_num)
 	{
-		zbx_vmware_hv_t	hv_local, *hv;
+		reqs_num = vmware_service_soap_prefetch(__func__, service, easyhandle, vmware_service_hv_data_request,
+				&hvs, i, ZBX_VMWARE_SOAP_REQUESTS_MAX, &prop_query_values, reqs);
 
-		if (SUCCEED == vmware_service_init_hv(service, easyhandle, hvs.values[i], &data->datastores,
-				&data->resourcepools, &prop_query_values, &alarms_data, &hv_local, &data->error))
+		for (j = 0; j < reqs_num; j++)
 		{
-			if (NULL != (hv = zbx_hashset_search(&data->hvs, &hv_local)))
+			zbx_vmware_hv_t	hv_local, *hv;
+
+			if (SUCCEED != reqs[j].ret)
 			{
-				zabbix_log(LOG_LEVEL_DEBUG, "Duplicate uuid of new hv id:%s name:%s uuid:%s and"
-					" discovered hv with id:%s name:%s", hv_local.id,
-					ZBX_NULL2EMPTY_STR(hv_local.props[ZBX_VMWARE_HVPROP_NAME]), hv_local.uuid,
-					hv->id, ZBX_NULL2EMPTY_STR(hv->props[ZBX_VMWARE_HVPROP_NAME]));
-				vmware_hv_clean(&hv_local);
+				if (NULL != reqs[j].error)
+				{
+					zabbix_log(LOG_LEVEL_DEBUG, "Unable initialize hv %s: %s.", hvs.values[i + j],
+							reqs[j].error);
+				}
+
 				continue;
 			}
 
-			zbx_hashset_insert(&data->hvs, &hv_local, sizeof(hv_local));
-		}
-		else if (NULL != data->error)
-		{
-			zabbix_log(LOG_LEVEL_DEBUG, "Unable initialize hv %s: %s.", hvs.values[i], data->error);
-			zbx_free(data->error);
+			if (SUCCEED == vmware_service_init_hv(service, easyhandle, hvs.values[i + j], reqs[j].doc,
+					&data->datastores, &data->resourcepools, &prop_query_values, &alarms_data,
+					&hv_local, &data->error))
+			{
+				if (NULL != (hv = zbx_hashset_search(&data->hvs, &hv_local)))
+				{
+					zabbix_log(LOG_LEVEL_DEBUG, "Duplicate uuid of new hv id:%s name:%s uuid:%s and"
+						" discovered hv with id:%s name:%s", hv_local.id,
+						ZBX_NULL2EMPTY_STR(hv_local.props[ZBX_VMWARE_HVPROP_NAME]),
+						hv_local.uuid, hv->id,
+						ZBX_NULL2EMPTY_STR(hv->props[ZBX_VMWARE_HVPROP_NAME]));
+					vmware_hv_clean(&hv_local);
+					continue;
+				}
+
+				zbx_hashset_insert(&data->hvs, &hv_local, sizeof(hv_local));
+			}
+			else if (NULL != data->error)
+			{
+				zabbix_log(LOG_LEVEL_DEBUG, "Unable initialize hv %s: %s.", hvs.values[i + j],
+						data->error);
+				zbx_free(data->error);
+			}
 		}
+
+		vmware_soap_reqs_clean(reqs, reqs_num);
 	}
 
 	for (i = 0; i < data->datastores.values_num; i++)
@@ -8730,7 +9206,8 @@ int	zbx_vmware_service_update(zbx_vmware_service_t *service)
 		goto clean;
 	}
 
-	if (SUCCEED != vmware_service_logout(service, easyhandle, &data->error))
+	if (SUCCEED != vmware_service_session_store(service, easyhandle) &&
+			SUCCEED != vmware_service_logout(service, easyhandle, &data->error))
 	{
 		zabbix_log(LOG_LEVEL_DEBUG, "Cannot close vmware connection: %s.", data->error);
 		zbx_free(data->error);
@@ -8860,6 +9337,60 @@ out:
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if xml node is element with the specified local name       *
+ *                                                                            *
+ ******************************************************************************/
+static int	vmware_xml_node_is(const xmlNode *node, const char *name)
+{
+	if (XML_ELEMENT_NODE != node->type || 0 != strcmp((const char *)node->name, name))
+		return FAIL;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets the first child element with the specified local name        *
+ *                                                                            *
+ * Return value: the child element or NULL if not found                       *
+ *                                                                            *
+ ******************************************************************************/
+static xmlNode	*vmware_xml_node_child(const xmlNode *node, const char *name)
+{
+	xmlNode	*child;
+
+	for (child = node->children; NULL != child; child = child->next)
+	{
+		if (SUCCEED == vmware_xml_node_is(child, name))
+			return child;
+	}
+
+	return NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets the text content of xml node                                 *
+ *                                                                            *
+ * Return value: the allocated text or NULL if node is NULL or has no text    *
+ *                                                                            *
+ ******************************************************************************/
+static char	*vmware_xml_node_text(xmlDoc *xdoc, const xmlNode *node)
+{
+	xmlChar	*val;
+	char	*value;
+
+	if (NULL == node || NULL == (val = xmlNodeListGetString(xdoc, node->xmlChildrenNode, 1)))
+		return NULL;
+
+	value = zbx_strdup(NULL, (const char *)val);
+	xmlFree(val);
+
+	return value;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: updates vmware performance statistics data                        *
@@ -8877,40 +9408,51 @@ out:
  ******************************************************************************/
 static int	vmware_service_process_perf_entity_data(zbx_vmware_perf_data_t *perfdata, xmlDoc *xdoc, xmlNode *node)
 {
-	xmlXPathContext		*xpathCtx;
-	xmlXPathObject		*xpathObj;
-	xmlNodeSetPtr		nodeset;
+	xmlNode			*series;
 	char			*instance, *counter, *value;
-	int			i, values = 0, ret = FAIL;
+	int			values = 0, ret = FAIL;
 	zbx_vector_ptr_t	*pervalues = &perfdata->values;
 	zbx_vmware_perf_value_t	*perfvalue;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	xpathCtx = xmlXPathNewContext(xdoc);
-	xpathCtx->node = node;
+	for (series = node->children; NULL != series; series = series->next)
+	{
+		xmlNode	*child, *text, *id = NULL, *last = NULL, *last_valid = NULL;
 
-	if (NULL == (xpathObj = xmlXPathEvalExpression((const xmlChar *)"*[local-name()='value']", xpathCtx)))
-		goto out;
+		if (SUCCEED != vmware_xml_node_is(series, "value"))
+			continue;
 
-	if (0 != xmlXPathNodeSetIsEmpty(xpathObj->nodesetval))
-		goto out;
+		/* the counter id and the last sample, preferably the last one with valid value */
+		for (child = series->children; NULL != child; child = child->next)
+		{
+			if (SUCCEED == vmware_xml_node_is(child, "id"))
+			{
+				if (NULL == id)
+					id = child;
 
-	nodeset = xpathObj->nodesetval;
-	zbx_vector_ptr_reserve(pervalues, (size_t)(nodeset->nodeNr + pervalues->values_alloc));
+				continue;
+			}
 
-	for (i = 0; i < nodeset->nodeNr; i++)
-	{
-		if (NULL == (value = zbx_xml_node_read_value(xdoc, nodeset->nodeTab[i],
-				"*[local-name()='value'][text() != '-1'][last()]")))
-		{
-			value = zbx_xml_node_read_value(xdoc, nodeset->nodeTab[i], "*[local-name()='value'][last()]");
+			if (SUCCEED != vmware_xml_node_is(child, "value"))
+				continue;
+
+			last = child;
+
+			for (text = child->children; NULL != text; text = text->next)
+			{
+				if ((XML_TEXT_NODE == text->type || XML_CDATA_SECTION_NODE == text->type) &&
+						0 != strcmp((const char *)text->content, "-1"))
+				{
+					last_valid = child;
+					break;
+				}
+			}
 		}
 
-		instance = zbx_xml_node_read_value(xdoc, nodeset->nodeTab[i], "*[local-name()='id']"
-				"/*[local-name()='instance']");
-		counter = zbx_xml_node_read_value(xdoc, nodeset->nodeTab[i], "*[local-name()='id']"
-				"/*[local-name()='counterId']");
+		value = NULL != last ? vmware_xml_node_text(xdoc, NULL != last_valid ? last_valid : last) : NULL;
+		instance = NULL != id ? vmware_xml_node_text(xdoc, vmware_xml_node_child(id, "instance")) : NULL;
+		counter = NULL != id ? vmware_xml_node_text(xdoc, vmware_xml_node_child(id, "counterId")) : NULL;
 
 		if (NULL != value && NULL != counter)
 		{
@@ -8940,10 +9482,6 @@ static int	vmware_service_process_perf_entity_data(zbx_vmware_perf_data_t *perfd
 		zbx_free(value);
 	}
 
-out:
-	xmlXPathFreeObject(xpathObj);
-	xmlXPathFreeContext(xpathCtx);
-
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() values:%d", __func__, values);
 
 	return ret;
@@ -8956,6 +9494,9 @@ out:
  * Parameters: perfdata - [OUT] performance entity data                       *
  *             xdoc     - [IN] the performance data xml document              *
  *                                                                            *
+ * Comments: The performance data is read by walking the document tree once   *
+ *           instead of evaluating xpath for every counter value.             *
+ *                                                                            *
  ******************************************************************************/
 static void	vmware_service_parse_perf_data(zbx_vector_ptr_t *perfdata, xmlDoc *xdoc)
 {
@@ -8980,15 +9521,27 @@ static void	vmware_service_parse_perf_data(zbx_vector_ptr_t *perfdata, xmlDoc *x
 	for (i = 0; i < nodeset->nodeNr; i++)
 	{
 		zbx_vmware_perf_data_t	*data;
+		xmlNode			*entity;
+		xmlChar			*type;
 		int			ret = FAIL;
 
 		data = (zbx_vmware_perf_data_t *)zbx_malloc(NULL, sizeof(zbx_vmware_perf_data_t));
-
-		data->id = zbx_xml_node_read_value(xdoc, nodeset->nodeTab[i], "*[local-name()='entity']");
-		data->type = zbx_xml_node_read_value(xdoc, nodeset->nodeTab[i], "*[local-name()='entity']/@type");
+		data->id = NULL;
+		data->type = NULL;
 		data->error = NULL;
 		zbx_vector_ptr_create(&data->values);
 
+		if (NULL != (entity = vmware_xml_node_child(nodeset->nodeTab[i], "entity")))
+		{
+			data->id = vmware_xml_node_text(xdoc, entity);
+
+			if (NULL != (type = xmlGetNoNsProp(entity, (const xmlChar *)"type")))
+			{
+				data->type = zbx_strdup(NULL, (const char *)type);
+				xmlFree(type);
+			}
+		}
+
 		if (NULL != data->type && NULL != data->id)
 			ret = vmware_service_process_perf_entity_data(data, xdoc, nodeset->nodeTab[i]);
 
@@ -9088,140 +9641,180 @@ static void	vmware_service_copy_perf_data(zbx_vmware_service_t *service, zbx_vec
 
 /******************************************************************************
  *                                                                            *
- * Purpose: retrieves performance counter values from vmware service          *
+ * Purpose: creates performance counter values request                        *
  *                                                                            *
- * Parameters: service      - [IN] the vmware service                         *
- *             easyhandle   - [IN] prepared cURL connection handle            *
- *             entities     - [IN] the performance collector entities to      *
- *                                 retrieve counters for                      *
- *             counters_max - [IN] the maximum number of counters per query.  *
- *             perfdata     - [OUT] the performance counter values            *
+ * Parameters: service       - [IN] the vmware service                        *
+ *             entities      - [IN] the performance collector entities to     *
+ *                                  retrieve counters for                     *
+ *             counters_max  - [IN] the maximum number of counters per query  *
+ *             index         - [IN/OUT] the index of the next entity to       *
+ *                                      request counters for, entities are    *
+ *                                      processed from the end of vector      *
+ *             start_counter - [IN/OUT] the first counter of the next entity  *
+ *                                      to request                            *
+ *                                                                            *
+ * Return value: the SOAP request                                             *
+ *                                                                            *
+ * Comments: Must be called with vmware lock held.                            *
  *                                                                            *
  ******************************************************************************/
-static void	vmware_service_retrieve_perf_counters(zbx_vmware_service_t *service, CURL *easyhandle,
-		zbx_vector_ptr_t *entities, int counters_max, zbx_vector_ptr_t *perfdata)
+static char	*vmware_service_perf_counters_request(const zbx_vmware_service_t *service,
+		const zbx_vector_ptr_t *entities, int counters_max, int *index, int *start_counter)
 {
-	char				*tmp = NULL, *error = NULL;
-	size_t				tmp_alloc = 0, tmp_offset;
-	int				i, j, start_counter = 0;
+	char				*tmp = NULL;
+	size_t				tmp_alloc = 0, tmp_offset = 0;
+	int				i, j, counters_num = 0;
 	zbx_vmware_perf_entity_t	*entity;
-	xmlDoc				*doc = NULL;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() counters_max:%d", __func__, counters_max);
+	zbx_strcpy_alloc(&tmp, &tmp_alloc, &tmp_offset, ZBX_POST_VSPHERE_HEADER);
+	zbx_snprintf_alloc(&tmp, &tmp_alloc, &tmp_offset, "<ns0:QueryPerf>"
+			"<ns0:_this type=\"PerformanceManager\">%s</ns0:_this>",
+			vmware_service_objects[service->type].performance_manager);
 
-	while (0 != entities->values_num)
+	for (i = *index; 0 <= i && counters_num < counters_max;)
 	{
-		int	counters_num = 0;
+		char	*id_esc;
 
-		tmp_offset = 0;
-		zbx_strcpy_alloc(&tmp, &tmp_alloc, &tmp_offset, ZBX_POST_VSPHERE_HEADER);
-		zbx_snprintf_alloc(&tmp, &tmp_alloc, &tmp_offset, "<ns0:QueryPerf>"
-				"<ns0:_this type=\"PerformanceManager\">%s</ns0:_this>",
-				vmware_service_objects[service->type].performance_manager);
+		entity = (zbx_vmware_perf_entity_t *)entities->values[i];
 
-		zbx_vmware_lock();
+		id_esc = zbx_xml_escape_dyn(entity->id);
 
-		for (i = entities->values_num - 1; 0 <= i && counters_num < counters_max;)
-		{
-			char	*id_esc;
+		/* add entity performance counter request */
+		zbx_snprintf_alloc(&tmp, &tmp_alloc, &tmp_offset, "<ns0:querySpec>"
+				"<ns0:entity type=\"%s\">%s</ns0:entity>", entity->type, id_esc);
 
-			entity = (zbx_vmware_perf_entity_t *)entities->values[i];
+		zbx_free(id_esc);
 
-			id_esc = zbx_xml_escape_dyn(entity->id);
+		if (ZBX_VMWARE_PERF_INTERVAL_NONE == entity->refresh)
+		{
+			time_t	st_raw;
+			struct	tm st;
+			char	st_str[ZBX_XML_DATETIME];
+
+			/* add startTime for entity performance counter request for decrease XML data load */
+			st_raw = time(NULL) - SEC_PER_HOUR;
+			gmtime_r(&st_raw, &st);
+			strftime(st_str, sizeof(st_str), "%Y-%m-%dT%TZ", &st);
+			zbx_snprintf_alloc(&tmp, &tmp_alloc, &tmp_offset, "<ns0:startTime>%s</ns0:startTime>",
+					st_str);
+		}
 
-			/* add entity performance counter request */
-			zbx_snprintf_alloc(&tmp, &tmp_alloc, &tmp_offset, "<ns0:querySpec>"
-					"<ns0:entity type=\"%s\">%s</ns0:entity>", entity->type, id_esc);
+		zbx_snprintf_alloc(&tmp, &tmp_alloc, &tmp_offset, "<ns0:maxSample>2</ns0:maxSample>");
 
-			zbx_free(id_esc);
+		for (j = *start_counter; j < entity->counters.values_num && counters_num < counters_max; j++)
+		{
+			zbx_vmware_perf_counter_t	*counter;
 
-			if (ZBX_VMWARE_PERF_INTERVAL_NONE == entity->refresh)
-			{
-				time_t	st_raw;
-				struct	tm st;
-				char	st_str[ZBX_XML_DATETIME];
+			counter = (zbx_vmware_perf_counter_t *)entity->counters.values[j];
 
-				/* add startTime for entity performance counter request for decrease XML data load */
-				st_raw = time(NULL) - SEC_PER_HOUR;
-				gmtime_r(&st_raw, &st);
-				strftime(st_str, sizeof(st_str), "%Y-%m-%dT%TZ", &st);
-				zbx_snprintf_alloc(&tmp, &tmp_alloc, &tmp_offset, "<ns0:startTime>%s</ns0:startTime>",
-						st_str);
+			if (0 != (counter->state & ZBX_VMWARE_COUNTER_CUSTOM) &&
+					0 == (counter->state & ZBX_VMWARE_COUNTER_ACCEPTABLE))
+			{
+				continue;
 			}
 
-			zbx_snprintf_alloc(&tmp, &tmp_alloc, &tmp_offset, "<ns0:maxSample>2</ns0:maxSample>");
+			zbx_snprintf_alloc(&tmp, &tmp_alloc, &tmp_offset,
+					"<ns0:metricId><ns0:counterId>" ZBX_FS_UI64
+					"</ns0:counterId><ns0:instance>%s</ns0:instance></ns0:metricId>",
+					counter->counterid, NULL == counter->query_instance ?
+					entity->query_instance : counter->query_instance);
 
-			for (j = start_counter; j < entity->counters.values_num && counters_num < counters_max; j++)
-			{
-				zbx_vmware_perf_counter_t	*counter;
+			counter->state |= ZBX_VMWARE_COUNTER_UPDATING;
+
+			counters_num++;
+		}
 
-				counter = (zbx_vmware_perf_counter_t *)entity->counters.values[j];
+		if (j == entity->counters.values_num)
+		{
+			*start_counter = 0;
+			i--;
+		}
+		else
+			*start_counter = j;
 
-				if (0 != (counter->state & ZBX_VMWARE_COUNTER_CUSTOM) &&
-						0 == (counter->state & ZBX_VMWARE_COUNTER_ACCEPTABLE))
-				{
-					continue;
-				}
+		if (ZBX_VMWARE_PERF_INTERVAL_NONE != entity->refresh)
+		{
+			zbx_snprintf_alloc(&tmp, &tmp_alloc, &tmp_offset, "<ns0:intervalId>%d</ns0:intervalId>",
+				entity->refresh);
+		}
 
-				zbx_snprintf_alloc(&tmp, &tmp_alloc, &tmp_offset,
-						"<ns0:metricId><ns0:counterId>" ZBX_FS_UI64
-						"</ns0:counterId><ns0:instance>%s</ns0:instance></ns0:metricId>",
-						counter->counterid, NULL == counter->query_instance ?
-						entity->query_instance : counter->query_instance);
+		zbx_snprintf_alloc(&tmp, &tmp_alloc, &tmp_offset, "</ns0:querySpec>");
+	}
 
-				counter->state |= ZBX_VMWARE_COUNTER_UPDATING;
+	zbx_strcpy_alloc(&tmp, &tmp_alloc, &tmp_offset, "</ns0:QueryPerf>");
+	zbx_strcpy_alloc(&tmp, &tmp_alloc, &tmp_offset, ZBX_POST_VSPHERE_FOOTER);
 
-				counters_num++;
-			}
+	*index = i;
 
-			if (j == entity->counters.values_num)
-			{
-				start_counter = 0;
-				i--;
-			}
-			else
-				start_counter = j;
+	return tmp;
+}
 
-			if (ZBX_VMWARE_PERF_INTERVAL_NONE != entity->refresh)
-			{
-				zbx_snprintf_alloc(&tmp, &tmp_alloc, &tmp_offset, "<ns0:intervalId>%d</ns0:intervalId>",
-					entity->refresh);
-			}
+/******************************************************************************
+ *                                                                            *
+ * Purpose: retrieves performance counter values from vmware service          *
+ *                                                                            *
+ * Parameters: service      - [IN] the vmware service                         *
+ *             easyhandle   - [IN] prepared cURL connection handle            *
+ *             entities     - [IN] the performance collector entities to      *
+ *                                 retrieve counters for                      *
+ *             counters_max - [IN] the maximum number of counters per query.  *
+ *             perfdata     - [OUT] the performance counter values            *
+ *                                                                            *
+ * Comments: Entities are batched into queries of up to counters_max counters *
+ *           and several queries are sent concurrently.                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	vmware_service_retrieve_perf_counters(zbx_vmware_service_t *service, CURL *easyhandle,
+		zbx_vector_ptr_t *entities, int counters_max, zbx_vector_ptr_t *perfdata)
+{
+	zbx_vmware_soap_req_t		reqs[ZBX_VMWARE_SOAP_REQUESTS_MAX];
+	int				i, j, k, reqs_num, start_counter = 0, ret = SUCCEED,
+					first[ZBX_VMWARE_SOAP_REQUESTS_MAX], last[ZBX_VMWARE_SOAP_REQUESTS_MAX];
+	zbx_vmware_perf_entity_t	*entity;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() counters_max:%d", __func__, counters_max);
+
+	i = entities->values_num - 1;
+
+	while (SUCCEED == ret && 0 <= i)
+	{
+		zbx_vmware_lock();
 
-			zbx_snprintf_alloc(&tmp, &tmp_alloc, &tmp_offset, "</ns0:querySpec>");
+		for (reqs_num = 0; reqs_num < ZBX_VMWARE_SOAP_REQUESTS_MAX && 0 <= i; reqs_num++)
+		{
+			last[reqs_num] = i + 1;
+			reqs[reqs_num].request = vmware_service_perf_counters_request(service, entities, counters_max,
+					&i, &start_counter);
+			first[reqs_num] = i + 1;
+
+			zabbix_log(LOG_LEVEL_TRACE, "%s() SOAP request: %s", __func__, reqs[reqs_num].request);
 		}
 
 		zbx_vmware_unlock();
-		zbx_xml_free_doc(doc);
-		doc = NULL;
 
-		zbx_strcpy_alloc(&tmp, &tmp_alloc, &tmp_offset, "</ns0:QueryPerf>");
-		zbx_strcpy_alloc(&tmp, &tmp_alloc, &tmp_offset, ZBX_POST_VSPHERE_FOOTER);
+		zbx_soap_post_multi(__func__, easyhandle, reqs, reqs_num);
 
-		zabbix_log(LOG_LEVEL_TRACE, "%s() SOAP request: %s", __func__, tmp);
-
-		if (SUCCEED != zbx_soap_post(__func__, easyhandle, tmp, &doc, NULL, &error))
+		for (k = 0; k < reqs_num; k++)
 		{
-			for (j = i + 1; j < entities->values_num; j++)
+			if (SUCCEED != reqs[k].ret)
 			{
-				entity = (zbx_vmware_perf_entity_t *)entities->values[j];
-				vmware_perf_data_add_error(perfdata, entity->type, entity->id, error);
+				for (j = first[k]; j < last[k]; j++)
+				{
+					entity = (zbx_vmware_perf_entity_t *)entities->values[j];
+					vmware_perf_data_add_error(perfdata, entity->type, entity->id, reqs[k].error);
+				}
+
+				ret = FAIL;
+				continue;
 			}
 
-			zbx_free(error);
-			break;
+			/* parse performance data into local memory */
+			vmware_service_parse_perf_data(perfdata, reqs[k].doc);
 		}
 
-		/* parse performance data into local memory */
-		vmware_service_parse_perf_data(perfdata, doc);
-
-		while (entities->values_num > i + 1)
-			zbx_vector_ptr_remove_noorder(entities, entities->values_num - 1);
+		vmware_soap_reqs_clean(reqs, reqs_num);
 	}
 
-	zbx_free(tmp);
-	zbx_xml_free_doc(doc);
-
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
@@ -9605,7 +10198,8 @@ int	zbx_vmware_service_update_perf(zbx_vmware_service_t *service)
 	vmware_service_retrieve_perf_counters(service, easyhandle, &hist_entities, service->data->max_query_metrics,
 			&perfdata);
 
-	if (SUCCEED != vmware_service_logout(service, easyhandle, &error))
+	if (SUCCEED != vmware_service_session_store(service, easyhandle) &&
+			SUCCEED != vmware_service_logout(service, easyhandle, &error))
 	{
 		zabbix_log(LOG_LEVEL_DEBUG, "Cannot close vmware connection: %s.", error);
 		zbx_free(error);
@@ -503,6 +503,9 @@ typedef struct
 	/* the vmware service instance fullname */
 	char				*fullname;
 
+	/* the authenticated session cookies kept between service updates */
+	char				*session;
+
 	/* the performance counters dictionary */
 	zbx_hashset_t			counters;
 
@@ -0,0 +1,401 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxbench.h"
+
+#include "zbxalgo.h"
+#include "zbxshmem.h"
+#include "zbxserialize.h"
+
+#define BENCH_ITEMS_NUM		10000
+#define BENCH_SHMEM_SIZE	(64 * ZBX_MEBIBYTE)
+
+typedef struct
+{
+	zbx_uint64_t	keys[BENCH_ITEMS_NUM];
+	zbx_hashset_t	hashset;
+}
+bench_keys_t;
+
+static void	*bench_keys_setup(void)
+{
+	bench_keys_t	*keys;
+
+	keys = (bench_keys_t *)zbx_malloc(NULL, sizeof(bench_keys_t));
+
+	/* unique keys in pseudo random order */
+	for (int i = 0; i < BENCH_ITEMS_NUM; i++)
+		keys->keys[i] = ((zbx_uint64_t)i * __UINT64_C(2654435761)) % __UINT64_C(4294967311);
+
+	zbx_hashset_create(&keys->hashset, BENCH_ITEMS_NUM, ZBX_DEFAULT_UINT64_HASH_FUNC,
+			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	for (int i = 0; i < BENCH_ITEMS_NUM; i++)
+		zbx_hashset_insert(&keys->hashset, &keys->keys[i], sizeof(zbx_uint64_t));
+
+	return keys;
+}
+
+static void	bench_keys_cleanup(void *data)
+{
+	bench_keys_t	*keys = (bench_keys_t *)data;
+
+	zbx_hashset_destroy(&keys->hashset);
+	zbx_free(keys);
+}
+
+static void	bench_hashset_insert(void *data, zbx_uint64_t loops)
+{
+	bench_keys_t	*keys = (bench_keys_t *)data;
+	zbx_hashset_t	hashset;
+
+	zbx_hashset_create(&hashset, 0, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	for (zbx_uint64_t i = 0; i < loops; i++)
+	{
+		if (0 == i % BENCH_ITEMS_NUM)
+			zbx_hashset_clear(&hashset);
+
+		zbx_hashset_insert(&hashset, &keys->keys[i % BENCH_ITEMS_NUM], sizeof(zbx_uint64_t));
+	}
+
+	zbx_hashset_destroy(&hashset);
+}
+
+static void	bench_hashset_search(void *data, zbx_uint64_t loops)
+{
+	bench_keys_t	*keys = (bench_keys_t *)data;
+	zbx_uint64_t	found = 0;
+
+	for (zbx_uint64_t i = 0; i < loops; i++)
+	{
+		if (NULL != zbx_hashset_search(&keys->hashset, &keys->keys[i % BENCH_ITEMS_NUM]))
+			found++;
+	}
+
+	zbx_bench_sink = found;
+}
+
+/* items per host, identifiers are consecutive within a host with gaps left by deleted items */
+#define BENCH_HOST_ITEMS_NUM	150
+
+typedef struct
+{
+	zbx_uint64_t	itemids[BENCH_ITEMS_NUM];
+	char		*keys[BENCH_ITEMS_NUM];
+	size_t		keys_len[BENCH_ITEMS_NUM];
+}
+bench_hash_t;
+
+static void	*bench_hash_setup(void)
+{
+	static const char	*templates[][2] = {{"system.cpu.load[all,avg", "]"}, {"net.if.in[\"eth", "\",bytes]"},
+				{"vfs.fs.size[/var/lib/data", ",pused]"}, {"proc.num[zabbix_server,,,poller #", "]"},
+				{"vmware.vm.cpu.usage[{$VMWARE.URL},vm-", "]"}, {"log[/var/log/app", ".log,error]"}};
+	bench_hash_t		*hash;
+	zbx_uint64_t		itemid = 23000;
+
+	hash = (bench_hash_t *)zbx_malloc(NULL, sizeof(bench_hash_t));
+
+	for (int i = 0; i < BENCH_ITEMS_NUM; i++)
+	{
+		if (0 == i % BENCH_HOST_ITEMS_NUM)
+			itemid += 1000;
+		else if (0 == i % 17)
+			itemid += i % 5;
+
+		hash->itemids[i] = itemid++;
+
+		hash->keys[i] = zbx_dsprintf(NULL, "%s%d%s", templates[i % ARRSIZE(templates)][0],
+				i / (int)ARRSIZE(templates), templates[i % ARRSIZE(templates)][1]);
+		hash->keys_len[i] = strlen(hash->keys[i]);
+	}
+
+	return hash;
+}
+
+static void	bench_hash_cleanup(void *data)
+{
+	bench_hash_t	*hash = (bench_hash_t *)data;
+
+	for (int i = 0; i < BENCH_ITEMS_NUM; i++)
+		zbx_free(hash->keys[i]);
+
+	zbx_free(hash);
+}
+
+static void	bench_hash_itemids(void *data, zbx_uint64_t loops,
+		zbx_hash_t (*hash_func)(const void *, size_t, zbx_hash_t))
+{
+	bench_hash_t	*hash = (bench_hash_t *)data;
+	zbx_hash_t	value = 0;
+
+	for (zbx_uint64_t i = 0; i < loops; i++)
+		value ^= hash_func(&hash->itemids[i % BENCH_ITEMS_NUM], sizeof(zbx_uint64_t), ZBX_DEFAULT_HASH_SEED);
+
+	zbx_bench_sink = value;
+}
+
+static void	bench_hash_keys(void *data, zbx_uint64_t loops,
+		zbx_hash_t (*hash_func)(const void *, size_t, zbx_hash_t))
+{
+	bench_hash_t	*hash = (bench_hash_t *)data;
+	zbx_hash_t	value = 0;
+
+	for (zbx_uint64_t i = 0; i < loops; i++)
+	{
+		int	n = (int)(i % BENCH_ITEMS_NUM);
+
+		value ^= hash_func(hash->keys[n], hash->keys_len[n], ZBX_DEFAULT_HASH_SEED);
+	}
+
+	zbx_bench_sink = value;
+}
+
+static void	bench_hash_words_itemid(void *data, zbx_uint64_t loops)
+{
+	bench_hash_itemids(data, loops, zbx_hash_words);
+}
+
+static void	bench_hash_modfnv_itemid(void *data, zbx_uint64_t loops)
+{
+	bench_hash_itemids(data, loops, zbx_hash_modfnv);
+}
+
+static void	bench_hash_words_item_key(void *data, zbx_uint64_t loops)
+{
+	bench_hash_keys(data, loops, zbx_hash_words);
+}
+
+static void	bench_hash_modfnv_item_key(void *data, zbx_uint64_t loops)
+{
+	bench_hash_keys(data, loops, zbx_hash_modfnv);
+}
+
+static int	bench_heap_compare(const void *d1, const void *d2)
+{
+	const zbx_binary_heap_elem_t	*e1 = (const zbx_binary_heap_elem_t *)d1;
+	const zbx_binary_heap_elem_t	*e2 = (const zbx_binary_heap_elem_t *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(e1->key, e2->key);
+
+	return 0;
+}
+
+static void	bench_binary_heap(void *data, zbx_uint64_t loops)
+{
+	bench_keys_t		*keys = (bench_keys_t *)data;
+	zbx_binary_heap_t	heap;
+
+	zbx_binary_heap_create(&heap, bench_heap_compare, ZBX_BINARY_HEAP_OPTION_EMPTY);
+
+	/* keep the heap half full, every operation is insert followed by remove_min */
+	for (int i = 0; i < BENCH_ITEMS_NUM / 2; i++)
+	{
+		zbx_binary_heap_elem_t	elem = {keys->keys[i], NULL};
+
+		zbx_binary_heap_insert(&heap, &elem);
+	}
+
+	for (zbx_uint64_t i = 0; i < loops; i++)
+	{
+		zbx_binary_heap_elem_t	elem = {keys->keys[i % BENCH_ITEMS_NUM], NULL};
+
+		zbx_binary_heap_insert(&heap, &elem);
+		zbx_binary_heap_remove_min(&heap);
+	}
+
+	zbx_binary_heap_destroy(&heap);
+}
+
+static void	bench_vector_append(void *data, zbx_uint64_t loops)
+{
+	bench_keys_t		*keys = (bench_keys_t *)data;
+	zbx_vector_uint64_t	values;
+
+	zbx_vector_uint64_create(&values);
+
+	for (zbx_uint64_t i = 0; i < loops; i++)
+	{
+		if (0 == i % BENCH_ITEMS_NUM)
+			zbx_vector_uint64_clear(&values);
+
+		zbx_vector_uint64_append(&values, keys->keys[i % BENCH_ITEMS_NUM]);
+	}
+
+	zbx_vector_uint64_destroy(&values);
+}
+
+static void	bench_vector_sort(void *data, zbx_uint64_t loops)
+{
+	bench_keys_t		*keys = (bench_keys_t *)data;
+	zbx_vector_uint64_t	values;
+
+	zbx_vector_uint64_create(&values);
+
+	/* one operation is sorting vector of BENCH_ITEMS_NUM values */
+	for (zbx_uint64_t i = 0; i < loops; i++)
+	{
+		zbx_vector_uint64_clear(&values);
+		zbx_vector_uint64_append_array(&values, keys->keys, BENCH_ITEMS_NUM);
+		zbx_vector_uint64_sort(&values, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	}
+
+	zbx_vector_uint64_destroy(&values);
+}
+
+static void	bench_vector_bsearch(void *data, zbx_uint64_t loops)
+{
+	bench_keys_t		*keys = (bench_keys_t *)data;
+	zbx_vector_uint64_t	values;
+	zbx_uint64_t		found = 0;
+
+	zbx_vector_uint64_create(&values);
+	zbx_vector_uint64_append_array(&values, keys->keys, BENCH_ITEMS_NUM);
+	zbx_vector_uint64_sort(&values, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	for (zbx_uint64_t i = 0; i < loops; i++)
+	{
+		if (FAIL != zbx_vector_uint64_bsearch(&values, keys->keys[i % BENCH_ITEMS_NUM],
+				ZBX_DEFAULT_UINT64_COMPARE_FUNC))
+		{
+			found++;
+		}
+	}
+
+	zbx_bench_sink = found;
+	zbx_vector_uint64_destroy(&values);
+}
+
+static zbx_shmem_info_t	*bench_shmem;
+
+static void	*bench_shmem_setup(void)
+{
+	char	*error = NULL;
+
+	if (SUCCEED != zbx_shmem_create(&bench_shmem, BENCH_SHMEM_SIZE, "benchmark", "ZBX_BENCH", 0, &error))
+	{
+		fprintf(stderr, "cannot create shared memory: %s\n", error);
+		zbx_free(error);
+		return NULL;
+	}
+
+	return bench_shmem;
+}
+
+static void	bench_shmem_cleanup(void *data)
+{
+	zbx_shmem_destroy((zbx_shmem_info_t *)data);
+	bench_shmem = NULL;
+}
+
+static void	bench_shmem_malloc_free(void *data, zbx_uint64_t loops)
+{
+	void	*ptrs[64];
+
+	ZBX_UNUSED(data);
+
+	/* mixed allocation sizes, freed in batches to fragment free chunks lists */
+	for (zbx_uint64_t i = 0; i < loops; i++)
+	{
+		ptrs[i % ARRSIZE(ptrs)] = zbx_shmem_malloc(bench_shmem, NULL, 16 + (i * 37) % 512);
+
+		if (ARRSIZE(ptrs) - 1 == i % ARRSIZE(ptrs))
+		{
+			for (size_t j = 0; j < ARRSIZE(ptrs); j++)
+				zbx_shmem_free(bench_shmem, ptrs[j]);
+		}
+	}
+
+	for (size_t j = 0; j < loops % ARRSIZE(ptrs); j++)
+		zbx_shmem_free(bench_shmem, ptrs[j]);
+}
+
+static void	bench_serialize(void *data, zbx_uint64_t loops)
+{
+	unsigned char	buffer[256], *ptr;
+	zbx_uint64_t	itemid = 0, lastlogsize = 0;
+	int		sec = 0, ns = 0;
+	const char	*value = "sample string value of a collected item";
+	char		*value_out;
+	zbx_uint32_t	value_len = (zbx_uint32_t)strlen(value), len;
+
+	ZBX_UNUSED(data);
+
+	/* pack and unpack record shaped like item value sent over IPC */
+	for (zbx_uint64_t i = 0; i < loops; i++)
+	{
+		itemid = i;
+		ptr = buffer;
+		ptr += zbx_serialize_uint64(ptr, itemid);
+		ptr += zbx_serialize_int(ptr, sec);
+		ptr += zbx_serialize_int(ptr, ns);
+		ptr += zbx_serialize_uint64(ptr, lastlogsize);
+		ptr += zbx_serialize_str(ptr, value, value_len);
+
+		ptr = buffer;
+		ptr += zbx_deserialize_uint64(ptr, &itemid);
+		ptr += zbx_deserialize_int(ptr, &sec);
+		ptr += zbx_deserialize_int(ptr, &ns);
+		ptr += zbx_deserialize_uint64(ptr, &lastlogsize);
+		(void)zbx_deserialize_str(ptr, &value_out, len);
+
+		zbx_bench_sink += itemid + len;
+		zbx_free(value_out);
+	}
+}
+
+static void	bench_serialize_compact(void *data, zbx_uint64_t loops)
+{
+	unsigned char	buffer[16];
+	zbx_uint64_t	value;
+
+	ZBX_UNUSED(data);
+
+	for (zbx_uint64_t i = 0; i < loops; i++)
+	{
+		zbx_uint32_t	len;
+
+		len = zbx_serialize_uint64_compact(buffer, i * 1021);
+		zbx_deserialize_uint64_compact(buffer, buffer + len, &value);
+		zbx_bench_sink += value;
+	}
+}
+
+int	main(int argc, char **argv)
+{
+	static const zbx_bench_case_t	cases[] = {
+		{"hashset_insert", bench_keys_setup, bench_hashset_insert, bench_keys_cleanup},
+		{"hashset_search", bench_keys_setup, bench_hashset_search, bench_keys_cleanup},
+		{"hash_words_itemid", bench_hash_setup, bench_hash_words_itemid, bench_hash_cleanup},
+		{"hash_modfnv_itemid", bench_hash_setup, bench_hash_modfnv_itemid, bench_hash_cleanup},
+		{"hash_words_item_key", bench_hash_setup, bench_hash_words_item_key, bench_hash_cleanup},
+		{"hash_modfnv_item_key", bench_hash_setup, bench_hash_modfnv_item_key, bench_hash_cleanup},
+		{"binary_heap_insert_remove_min", bench_keys_setup, bench_binary_heap, bench_keys_cleanup},
+		{"vector_uint64_append", bench_keys_setup, bench_vector_append, bench_keys_cleanup},
+		{"vector_uint64_sort_10000", bench_keys_setup, bench_vector_sort, bench_keys_cleanup},
+		{"vector_uint64_bsearch", bench_keys_setup, bench_vector_bsearch, bench_keys_cleanup},
+		{"shmem_malloc_free", bench_shmem_setup, bench_shmem_malloc_free, bench_shmem_cleanup},
+		{"serialize_value_pack_unpack", NULL, bench_serialize, NULL},
+		{"serialize_uint64_compact", NULL, bench_serialize_compact, NULL},
+		{NULL}
+	};
+
+	return zbx_bench_main(argc, argv, cases);
+}
@@ -0,0 +1,227 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+/* Configuration cache item scans. Items are created the same way as by configuration cache sync - hashset   */
+/* entries with separately allocated cold records - and walked as by zbx_dc_config_get_poller_items() and     */
+/* zbx_dc_get_item_queue(). Both scans only read the hot part of the items, so the cost per item is mostly   */
+/* the cache misses on item records.                                                                          */
+
+#include "zbxbench.h"
+
+#include "zbxalgo.h"
+#include "zbxnum.h"
+#include "zbx_item_constants.h"
+#include "libs/zbxcacheconfig/dbconfig.h"
+
+/* number of items can be changed to measure larger caches, for example 5 million items: */
+/* BENCH_DCITEM_ITEMS=5000000 make bench BENCH_ARGS="dc_item"                            */
+#define BENCH_DCITEM_ITEMS_ENV		"BENCH_DCITEM_ITEMS"
+#define BENCH_DCITEM_ITEMS_DEFAULT	1000000
+#define BENCH_DCITEM_HOST_ITEMS		100
+#define BENCH_DCITEM_DELAY		60
+
+typedef struct
+{
+	zbx_hashset_t		items;
+	zbx_vector_ptr_t	host_items;	/* items grouped by hosts as in host item vectors */
+	zbx_binary_heap_t	queue;
+	int			items_num;
+	int			queue_index;
+}
+bench_dcitem_t;
+
+static const char	*bench_dcitem_keys[] = {"system.cpu.load[all,avg1]", "vfs.fs.size[/,pfree]",
+		"net.if.in[eth0]", "proc.num[,,run]", "agent.ping", NULL};
+
+static int	bench_dcitem_nextcheck_compare(const void *d1, const void *d2)
+{
+	const zbx_binary_heap_elem_t	*e1 = (const zbx_binary_heap_elem_t *)d1;
+	const zbx_binary_heap_elem_t	*e2 = (const zbx_binary_heap_elem_t *)d2;
+
+	const ZBX_DC_ITEM		*i1 = (const ZBX_DC_ITEM *)e1->data;
+	const ZBX_DC_ITEM		*i2 = (const ZBX_DC_ITEM *)e2->data;
+
+	ZBX_RETURN_IF_NOT_EQUAL(i1->nextcheck, i2->nextcheck);
+	ZBX_RETURN_IF_NOT_EQUAL(i1->queue_priority, i2->queue_priority);
+
+	return 0;
+}
+
+static void	bench_dcitem_cleanup(void *data)
+{
+	bench_dcitem_t		*bench = (bench_dcitem_t *)data;
+	zbx_hashset_iter_t	iter;
+	ZBX_DC_ITEM		*item;
+
+	zbx_hashset_iter_reset(&bench->items, &iter);
+
+	while (NULL != (item = (ZBX_DC_ITEM *)zbx_hashset_iter_next(&iter)))
+	{
+		zbx_vector_ptr_destroy(&item->cold->tags);
+		zbx_free(item->cold);
+	}
+
+	zbx_binary_heap_destroy(&bench->queue);
+	zbx_vector_ptr_destroy(&bench->host_items);
+	zbx_hashset_destroy(&bench->items);
+	zbx_free(bench);
+}
+
+static void	*bench_dcitem_setup(void)
+{
+	bench_dcitem_t	*bench;
+	const char	*value;
+	int		items_num = BENCH_DCITEM_ITEMS_DEFAULT, keys_num;
+
+	if (NULL != (value = getenv(BENCH_DCITEM_ITEMS_ENV)) && (FAIL == zbx_is_uint31(value, &items_num) ||
+			0 == items_num))
+	{
+		fprintf(stderr, "invalid %s value \"%s\"\n", BENCH_DCITEM_ITEMS_ENV, value);
+		return NULL;
+	}
+
+	for (keys_num = 0; NULL != bench_dcitem_keys[keys_num]; keys_num++)
+		;
+
+	bench = (bench_dcitem_t *)zbx_malloc(NULL, sizeof(bench_dcitem_t));
+	bench->items_num = items_num;
+	bench->queue_index = 0;
+
+	zbx_hashset_create(&bench->items, (size_t)items_num, ZBX_DEFAULT_UINT64_HASH_FUNC,
+			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_ptr_create(&bench->host_items);
+	zbx_vector_ptr_reserve(&bench->host_items, (size_t)items_num);
+	zbx_binary_heap_create(&bench->queue, bench_dcitem_nextcheck_compare, ZBX_BINARY_HEAP_OPTION_DIRECT);
+
+	/* items of the same host are synced together, but scattered in hashset by their identifiers */
+	for (int i = 0; i < items_num; i++)
+	{
+		ZBX_DC_ITEM		item_local, *item;
+		zbx_binary_heap_elem_t	elem;
+
+		memset(&item_local, 0, sizeof(item_local));
+		item_local.itemid = (zbx_uint64_t)i + 1;
+		item = (ZBX_DC_ITEM *)zbx_hashset_insert(&bench->items, &item_local, sizeof(item_local));
+
+		item->hostid = (zbx_uint64_t)(i / BENCH_DCITEM_HOST_ITEMS) + 1;
+		item->interfaceid = item->hostid;
+		item->key = bench_dcitem_keys[i % keys_num];
+		item->delay = "1m";
+		item->nextcheck = i % BENCH_DCITEM_DELAY;
+		item->schedule_delay = BENCH_DCITEM_DELAY;
+		item->type = ITEM_TYPE_ZABBIX;
+		item->poller_type = ZBX_POLLER_TYPE_NORMAL;
+		item->location = ZBX_LOC_QUEUE;
+		item->status = ITEM_STATUS_ACTIVE;
+		item->state = ITEM_STATE_NORMAL;
+		item->value_type = ITEM_VALUE_TYPE_FLOAT;
+
+		item->cold = (ZBX_DC_ITEM_COLD *)zbx_malloc(NULL, sizeof(ZBX_DC_ITEM_COLD));
+		memset(item->cold, 0, sizeof(ZBX_DC_ITEM_COLD));
+		item->cold->name = item->key;
+		item->cold->error = "";
+		item->cold->history_period = "90d";
+		zbx_vector_ptr_create(&item->cold->tags);
+
+		zbx_vector_ptr_append(&bench->host_items, item);
+
+		elem.key = item->itemid;
+		elem.data = item;
+		zbx_binary_heap_insert(&bench->queue, &elem);
+	}
+
+	return bench;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: take due items from poller queue and reschedule them, one item    *
+ *          per operation                                                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	bench_dcitem_poller_scan(void *data, zbx_uint64_t loops)
+{
+	bench_dcitem_t	*bench = (bench_dcitem_t *)data;
+	zbx_uint64_t	sum = 0;
+
+	for (zbx_uint64_t i = 0; i < loops; i++)
+	{
+		const zbx_binary_heap_elem_t	*min;
+		ZBX_DC_ITEM			*item;
+		zbx_binary_heap_elem_t		elem;
+
+		min = zbx_binary_heap_find_min(&bench->queue);
+		item = (ZBX_DC_ITEM *)min->data;
+
+		zbx_binary_heap_remove_min(&bench->queue);
+		item->location = ZBX_LOC_NOWHERE;
+
+		if (ITEM_STATUS_ACTIVE == item->status && 0 == (ZBX_FLAG_DISCOVERY_RULE & item->flags))
+			sum += item->hostid + item->interfaceid + (zbx_uint64_t)*item->key + item->type;
+
+		item->nextcheck += item->schedule_delay;
+		item->location = ZBX_LOC_QUEUE;
+
+		elem.key = item->itemid;
+		elem.data = item;
+		zbx_binary_heap_insert(&bench->queue, &elem);
+	}
+
+	zbx_bench_sink = sum;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: check items of monitored hosts as item queue does, one item per   *
+ *          operation                                                         *
+ *                                                                            *
+ ******************************************************************************/
+static void	bench_dcitem_queue_scan(void *data, zbx_uint64_t loops)
+{
+	bench_dcitem_t	*bench = (bench_dcitem_t *)data;
+	zbx_uint64_t	queued = 0;
+	int		now = BENCH_DCITEM_DELAY;
+
+	for (zbx_uint64_t i = 0; i < loops; i++)
+	{
+		const ZBX_DC_ITEM	*item = (const ZBX_DC_ITEM *)bench->host_items.values[bench->queue_index];
+
+		if (++bench->queue_index == bench->items_num)
+			bench->queue_index = 0;
+
+		if (ITEM_STATUS_ACTIVE != item->status || ITEM_TYPE_ZABBIX != item->type)
+			continue;
+
+		if (ZBX_LOC_POLLER != item->location && now - item->nextcheck >= 0 && '\0' != *item->key)
+			queued++;
+	}
+
+	zbx_bench_sink = queued;
+}
+
+int	main(int argc, char **argv)
+{
+	static const zbx_bench_case_t	cases[] = {
+		{"dc_item_poller_scan", bench_dcitem_setup, bench_dcitem_poller_scan, bench_dcitem_cleanup},
+		{"dc_item_queue_scan", bench_dcitem_setup, bench_dcitem_queue_scan, bench_dcitem_cleanup},
+		{NULL}
+	};
+
+	return zbx_bench_main(argc, argv, cases);
+}
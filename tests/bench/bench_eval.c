@@ -0,0 +1,125 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxbench.h"
+
+#include "zbxeval.h"
+#include "zbxvariant.h"
+
+#define BENCH_EXPRESSION	"(1 + 2 * 3) / 4 > 1 and abs(-5) = 5 or length(\"benchmark\") > 10 and " \
+				"max(1, 7, 3) * 1.5 - 0.25 <> min(4, 2) + 1K"
+
+static void	bench_eval_cleanup(void *data)
+{
+	zbx_eval_clear((zbx_eval_context_t *)data);
+	zbx_free(data);
+}
+
+static void	*bench_eval_setup(void)
+{
+	zbx_eval_context_t	*ctx;
+	zbx_variant_t		value;
+	char			*error = NULL;
+
+	ctx = (zbx_eval_context_t *)zbx_malloc(NULL, sizeof(zbx_eval_context_t));
+
+	if (SUCCEED != zbx_eval_parse_expression(ctx, BENCH_EXPRESSION, ZBX_EVAL_PARSE_CALC_EXPRESSION, &error))
+	{
+		fprintf(stderr, "cannot parse benchmark expression: %s\n", error);
+		zbx_free(error);
+		zbx_free(ctx);
+		return NULL;
+	}
+
+	if (SUCCEED != zbx_eval_execute(ctx, NULL, &value, &error))
+	{
+		fprintf(stderr, "cannot evaluate benchmark expression: %s\n", error);
+		zbx_free(error);
+		bench_eval_cleanup(ctx);
+		return NULL;
+	}
+
+	zbx_variant_clear(&value);
+
+	return ctx;
+}
+
+static void	bench_eval_parse(void *data, zbx_uint64_t loops)
+{
+	ZBX_UNUSED(data);
+
+	for (zbx_uint64_t i = 0; i < loops; i++)
+	{
+		zbx_eval_context_t	ctx;
+		char			*error = NULL;
+
+		if (SUCCEED == zbx_eval_parse_expression(&ctx, BENCH_EXPRESSION, ZBX_EVAL_PARSE_CALC_EXPRESSION,
+				&error))
+		{
+			zbx_eval_clear(&ctx);
+		}
+		else
+			zbx_free(error);
+	}
+}
+
+static void	bench_eval_execute(void *data, zbx_uint64_t loops)
+{
+	zbx_eval_context_t	*ctx = (zbx_eval_context_t *)data;
+
+	for (zbx_uint64_t i = 0; i < loops; i++)
+	{
+		zbx_variant_t	value;
+		char		*error = NULL;
+
+		if (SUCCEED == zbx_eval_execute(ctx, NULL, &value, &error))
+			zbx_variant_clear(&value);
+		else
+			zbx_free(error);
+	}
+}
+
+static void	bench_eval_serialize(void *data, zbx_uint64_t loops)
+{
+	zbx_eval_context_t	*ctx = (zbx_eval_context_t *)data;
+
+	/* expressions are stored serialized in configuration cache and restored for every evaluation */
+	for (zbx_uint64_t i = 0; i < loops; i++)
+	{
+		zbx_eval_context_t	local;
+		unsigned char		*buffer = NULL;
+
+		zbx_eval_serialize(ctx, NULL, &buffer);
+		zbx_eval_deserialize(&local, BENCH_EXPRESSION, ZBX_EVAL_PARSE_CALC_EXPRESSION, buffer);
+		zbx_eval_clear(&local);
+		zbx_free(buffer);
+	}
+}
+
+int	main(int argc, char **argv)
+{
+	static const zbx_bench_case_t	cases[] = {
+		{"eval_parse_expression", NULL, bench_eval_parse, NULL},
+		{"eval_execute", bench_eval_setup, bench_eval_execute, bench_eval_cleanup},
+		{"eval_serialize_deserialize", bench_eval_setup, bench_eval_serialize, bench_eval_cleanup},
+		{NULL}
+	};
+
+	return zbx_bench_main(argc, argv, cases);
+}
@@ -0,0 +1,661 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+/* History syncer replay benchmark.                                                                     */
+/*                                                                                                      */
+/* Replays history stream through the value cache and trigger function evaluation the same way history */
+/* syncer does - values are added to value cache in batches and then functions of the received items   */
+/* are evaluated at the value timestamps. History storage is replaced with stubs, so the results do not */
+/* depend on database.                                                                                  */
+/*                                                                                                      */
+/* By default a generated stream is replayed. A recorded stream can be replayed by setting              */
+/* BENCH_HISTORY_REPLAY environment variable to the stream file path. The file contains one record per  */
+/* line, items must be defined before their functions and values:                                       */
+/*   item <itemid> <value type>                                                                         */
+/*   function <itemid> <function name> <parameters>                                                     */
+/*   value <itemid> <seconds> <nanoseconds> <value>                                                     */
+/* Supported value types are float (0), string (1), unsigned (3) and text (4).                          */
+
+#include "zbxbench.h"
+
+#include "zbxcachevalue.h"
+#include "zbxhistory.h"
+#include "zbxmutexs.h"
+#include "zbxnum.h"
+#include "zbxstr.h"
+#include "zbxtime.h"
+#include "zbxvariant.h"
+#include "libs/zbxserver/evalfunc.h"
+
+#define BENCH_HISTORY_REPLAY_ENV	"BENCH_HISTORY_REPLAY"
+
+/* history syncer processes up to ZBX_HC_SYNC_MAX values at once */
+#define BENCH_HISTORY_BATCH		1000
+
+#define BENCH_HISTORY_CACHE_SIZE	(256 * ZBX_MEBIBYTE)
+
+/* generated stream parameters */
+#define BENCH_HISTORY_ITEMS		1000
+#define BENCH_HISTORY_ROUNDS		60
+#define BENCH_HISTORY_INTERVAL		10
+
+typedef struct
+{
+	zbx_uint64_t		itemid;
+	unsigned char		value_type;
+	char			*key;
+	zbx_vector_ptr_pair_t	functions;	/* function name, parameters */
+}
+bench_history_item_t;
+
+typedef struct
+{
+	bench_history_item_t	*item;
+	zbx_timespec_t		ts;
+	zbx_history_value_t	value;
+}
+bench_history_value_t;
+
+typedef struct
+{
+	zbx_hashset_t		items;
+	bench_history_value_t	*values;
+	int			values_num;
+	int			values_alloc;
+
+	/* timestamp shift applied to every replay of the stream, so that values keep increasing */
+	int			span;
+	int			shift;
+	int			pos;
+
+	int			evaluate;
+
+	zbx_dc_history_t	history[BENCH_HISTORY_BATCH];
+	zbx_vector_ptr_t	history_ptrs;
+
+	/* statistics */
+	zbx_uint64_t		replayed;
+	zbx_uint64_t		evaluated;
+	zbx_uint64_t		failed;
+	zbx_uint64_t		allocations;
+	double			time_cache;
+	double			time_evaluate;
+}
+bench_history_t;
+
+static zbx_uint64_t	bench_allocations;
+
+void	*__real_zbx_malloc2(const char *filename, int line, void *old, size_t size);
+void	*__real_zbx_realloc2(const char *filename, int line, void *old, size_t size);
+char	*__real_zbx_strdup2(const char *filename, int line, char *old, const char *str);
+
+void	*__wrap_zbx_malloc2(const char *filename, int line, void *old, size_t size);
+void	*__wrap_zbx_realloc2(const char *filename, int line, void *old, size_t size);
+char	*__wrap_zbx_strdup2(const char *filename, int line, char *old, const char *str);
+
+int	__wrap_zbx_history_add_values(const zbx_vector_ptr_t *history, int *ret_flush);
+int	__wrap_zbx_history_get_values(zbx_uint64_t itemid, int value_type, int start, int count, int end,
+		zbx_vector_history_record_t *values);
+void	__wrap_zbx_history_get_values_batch(zbx_history_query_t *queries, int queries_num, int value_type);
+
+/* heap allocations are counted to show allocation rate of the replayed path */
+
+void	*__wrap_zbx_malloc2(const char *filename, int line, void *old, size_t size)
+{
+	bench_allocations++;
+
+	return __real_zbx_malloc2(filename, line, old, size);
+}
+
+void	*__wrap_zbx_realloc2(const char *filename, int line, void *old, size_t size)
+{
+	bench_allocations++;
+
+	return __real_zbx_realloc2(filename, line, old, size);
+}
+
+char	*__wrap_zbx_strdup2(const char *filename, int line, char *old, const char *str)
+{
+	bench_allocations++;
+
+	return __real_zbx_strdup2(filename, line, old, str);
+}
+
+/* history storage stubs - values are not written anywhere and there is no older history */
+
+int	__wrap_zbx_history_add_values(const zbx_vector_ptr_t *history, int *ret_flush)
+{
+	ZBX_UNUSED(history);
+
+	*ret_flush = FLUSH_SUCCEED;
+
+	return SUCCEED;
+}
+
+int	__wrap_zbx_history_get_values(zbx_uint64_t itemid, int value_type, int start, int count, int end,
+		zbx_vector_history_record_t *values)
+{
+	ZBX_UNUSED(itemid);
+	ZBX_UNUSED(value_type);
+	ZBX_UNUSED(start);
+	ZBX_UNUSED(count);
+	ZBX_UNUSED(end);
+	ZBX_UNUSED(values);
+
+	return SUCCEED;
+}
+
+void	__wrap_zbx_history_get_values_batch(zbx_history_query_t *queries, int queries_num, int value_type)
+{
+	ZBX_UNUSED(value_type);
+
+	for (int i = 0; i < queries_num; i++)
+		queries[i].ret = SUCCEED;
+}
+
+static void	bench_history_item_clean(void *data)
+{
+	bench_history_item_t	*item = (bench_history_item_t *)data;
+
+	for (int i = 0; i < item->functions.values_num; i++)
+	{
+		zbx_free(item->functions.values[i].first);
+		zbx_free(item->functions.values[i].second);
+	}
+
+	zbx_vector_ptr_pair_destroy(&item->functions);
+	zbx_free(item->key);
+}
+
+static void	bench_history_cleanup(void *data)
+{
+	bench_history_t	*bench = (bench_history_t *)data;
+
+	if (0 != bench->replayed)
+	{
+		zbx_vc_stats_t	stats;
+
+		printf("  %s: values:" ZBX_FS_UI64 " functions:" ZBX_FS_UI64 " failed:" ZBX_FS_UI64
+				" cache:%.1f ns/value evaluate:%.1f ns/value allocations:%.2f/value\n",
+				0 == bench->evaluate ? "cache values" : "cache values and evaluate functions",
+				bench->replayed, bench->evaluated, bench->failed,
+				bench->time_cache * 1e9 / (double)bench->replayed,
+				bench->time_evaluate * 1e9 / (double)bench->replayed,
+				(double)bench->allocations / (double)bench->replayed);
+
+		if (SUCCEED == zbx_vc_get_statistics(&stats))
+		{
+			printf("  value cache: hits:" ZBX_FS_UI64 " misses:" ZBX_FS_UI64 " used:" ZBX_FS_UI64
+					" bytes\n", stats.hits, stats.misses, stats.total_size - stats.free_size);
+		}
+	}
+
+	zbx_vc_reset();
+
+	for (int i = 0; i < bench->values_num; i++)
+	{
+		switch (bench->values[i].item->value_type)
+		{
+			case ITEM_VALUE_TYPE_STR:
+			case ITEM_VALUE_TYPE_TEXT:
+				zbx_free(bench->values[i].value.str);
+				break;
+		}
+	}
+
+	zbx_free(bench->values);
+	zbx_vector_ptr_destroy(&bench->history_ptrs);
+	zbx_hashset_destroy(&bench->items);
+	zbx_free(bench);
+}
+
+static bench_history_t	*bench_history_create(void)
+{
+	bench_history_t	*bench;
+
+	bench = (bench_history_t *)zbx_malloc(NULL, sizeof(bench_history_t));
+	memset(bench, 0, sizeof(bench_history_t));
+
+	zbx_hashset_create_ext(&bench->items, BENCH_HISTORY_ITEMS, ZBX_DEFAULT_UINT64_HASH_FUNC,
+			ZBX_DEFAULT_UINT64_COMPARE_FUNC, bench_history_item_clean, ZBX_DEFAULT_MEM_MALLOC_FUNC,
+			ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
+	zbx_vector_ptr_create(&bench->history_ptrs);
+	zbx_vector_ptr_reserve(&bench->history_ptrs, BENCH_HISTORY_BATCH);
+
+	return bench;
+}
+
+static bench_history_item_t	*bench_history_add_item(bench_history_t *bench, zbx_uint64_t itemid,
+		unsigned char value_type)
+{
+	bench_history_item_t	item_local, *item;
+
+	item_local.itemid = itemid;
+
+	if (NULL != (item = (bench_history_item_t *)zbx_hashset_search(&bench->items, &item_local)))
+		return item;
+
+	item = (bench_history_item_t *)zbx_hashset_insert(&bench->items, &item_local, sizeof(item_local));
+	item->value_type = value_type;
+	item->key = zbx_dsprintf(NULL, "bench.item[" ZBX_FS_UI64 "]", itemid);
+	zbx_vector_ptr_pair_create(&item->functions);
+
+	return item;
+}
+
+static void	bench_history_add_function(bench_history_item_t *item, const char *function, const char *parameter)
+{
+	zbx_ptr_pair_t	pair;
+
+	pair.first = zbx_strdup(NULL, function);
+	pair.second = zbx_strdup(NULL, parameter);
+	zbx_vector_ptr_pair_append(&item->functions, pair);
+}
+
+static bench_history_value_t	*bench_history_add_value(bench_history_t *bench, bench_history_item_t *item,
+		int sec, int ns)
+{
+	bench_history_value_t	*value;
+
+	if (bench->values_num == bench->values_alloc)
+	{
+		bench->values_alloc = (0 == bench->values_alloc ? 1024 : bench->values_alloc * 2);
+		bench->values = (bench_history_value_t *)zbx_realloc(bench->values,
+				sizeof(bench_history_value_t) * (size_t)bench->values_alloc);
+	}
+
+	value = &bench->values[bench->values_num++];
+	value->item = item;
+	value->ts.sec = sec;
+	value->ts.ns = ns;
+
+	return value;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: generate history stream of numeric items with severity-tiered     *
+ *          trigger functions                                                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	bench_history_generate(bench_history_t *bench)
+{
+	int	start;
+
+	start = (int)time(NULL) - BENCH_HISTORY_ROUNDS * BENCH_HISTORY_INTERVAL;
+
+	for (zbx_uint64_t itemid = 1; itemid <= BENCH_HISTORY_ITEMS; itemid++)
+	{
+		bench_history_item_t	*item;
+
+		item = bench_history_add_item(bench, itemid,
+				0 == itemid % 2 ? ITEM_VALUE_TYPE_FLOAT : ITEM_VALUE_TYPE_UINT64);
+
+		bench_history_add_function(item, "last", "$");
+		bench_history_add_function(item, "avg", "$,5m");
+		bench_history_add_function(item, "max", "$,#10");
+	}
+
+	for (int round = 0; round < BENCH_HISTORY_ROUNDS; round++)
+	{
+		for (zbx_uint64_t itemid = 1; itemid <= BENCH_HISTORY_ITEMS; itemid++)
+		{
+			bench_history_item_t	*item;
+			bench_history_value_t	*value;
+
+			item = (bench_history_item_t *)zbx_hashset_search(&bench->items, &itemid);
+			value = bench_history_add_value(bench, item, start + round * BENCH_HISTORY_INTERVAL,
+					(int)itemid);
+
+			if (ITEM_VALUE_TYPE_FLOAT == item->value_type)
+				value->value.dbl = (double)(((zbx_uint64_t)round * 7 + itemid) % 100) + 0.5;
+			else
+				value->value.ui64 = ((zbx_uint64_t)round * itemid) % 1000;
+		}
+	}
+}
+
+static char	*bench_history_token(char **ptr)
+{
+	char	*token = *ptr, *end;
+
+	if (NULL == (end = strchr(token, ' ')))
+	{
+		*ptr = token + strlen(token);
+	}
+	else
+	{
+		*end = '\0';
+		*ptr = end + 1;
+	}
+
+	return token;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: load recorded history stream                                      *
+ *                                                                            *
+ * Parameters: bench - [IN/OUT] the benchmark data                            *
+ *             path  - [IN] the stream file path                              *
+ *                                                                            *
+ * Return value: SUCCEED - the stream was loaded                              *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	bench_history_load(bench_history_t *bench, const char *path)
+{
+	FILE	*f;
+	char	line[MAX_BUFFER_LEN];
+	int	line_num = 0, ret = SUCCEED;
+
+	if (NULL == (f = fopen(path, "r")))
+	{
+		fprintf(stderr, "cannot open history stream \"%s\": %s\n", path, zbx_strerror(errno));
+		return FAIL;
+	}
+
+	while (SUCCEED == ret && NULL != fgets(line, sizeof(line), f))
+	{
+		char			*ptr = line, *type, *id;
+		zbx_uint64_t		itemid;
+		bench_history_item_t	*item = NULL;
+
+		line_num++;
+		zbx_rtrim(line, "\r\n");
+
+		if ('\0' == *line || '#' == *line)
+			continue;
+
+		type = bench_history_token(&ptr);
+		id = bench_history_token(&ptr);
+
+		if (SUCCEED != zbx_is_uint64(id, &itemid))
+		{
+			ret = FAIL;
+		}
+		else if (0 == strcmp(type, "item"))
+		{
+			int	value_type;
+
+			if (SUCCEED != zbx_is_uint31(ptr, &value_type) || (ITEM_VALUE_TYPE_FLOAT != value_type &&
+					ITEM_VALUE_TYPE_STR != value_type && ITEM_VALUE_TYPE_UINT64 != value_type &&
+					ITEM_VALUE_TYPE_TEXT != value_type))
+			{
+				ret = FAIL;
+			}
+			else
+				bench_history_add_item(bench, itemid, (unsigned char)value_type);
+		}
+		else if (NULL == (item = (bench_history_item_t *)zbx_hashset_search(&bench->items, &itemid)))
+		{
+			ret = FAIL;
+		}
+		else if (0 == strcmp(type, "function"))
+		{
+			char	*function;
+
+			function = bench_history_token(&ptr);
+			bench_history_add_function(item, function, ptr);
+		}
+		else if (0 == strcmp(type, "value"))
+		{
+			int			sec, ns;
+			double			value_dbl;
+			zbx_uint64_t		value_ui64;
+			bench_history_value_t	*value;
+			const char		*sec_str, *ns_str;
+
+			sec_str = bench_history_token(&ptr);
+			ns_str = bench_history_token(&ptr);
+
+			if (SUCCEED != zbx_is_uint31(sec_str, &sec) || SUCCEED != zbx_is_uint_n_range(ns_str,
+					ZBX_MAX_UINT64_LEN, &ns, sizeof(ns), 0, 999999999))
+			{
+				ret = FAIL;
+				continue;
+			}
+
+			switch (item->value_type)
+			{
+				case ITEM_VALUE_TYPE_FLOAT:
+					if (SUCCEED != zbx_is_double(ptr, &value_dbl))
+					{
+						ret = FAIL;
+						continue;
+					}
+					value = bench_history_add_value(bench, item, sec, ns);
+					value->value.dbl = value_dbl;
+					break;
+				case ITEM_VALUE_TYPE_UINT64:
+					if (SUCCEED != zbx_is_uint64(ptr, &value_ui64))
+					{
+						ret = FAIL;
+						continue;
+					}
+					value = bench_history_add_value(bench, item, sec, ns);
+					value->value.ui64 = value_ui64;
+					break;
+				default:
+					value = bench_history_add_value(bench, item, sec, ns);
+					value->value.str = zbx_strdup(NULL, ptr);
+			}
+		}
+		else
+			ret = FAIL;
+	}
+
+	fclose(f);
+
+	if (SUCCEED != ret)
+	{
+		fprintf(stderr, "invalid history stream \"%s\" record at line %d\n", path, line_num);
+	}
+	else if (0 == bench->values_num)
+	{
+		fprintf(stderr, "history stream \"%s\" contains no values\n", path);
+		ret = FAIL;
+	}
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: replay values through value cache and evaluate item functions    *
+ *                                                                            *
+ * Parameters: bench  - [IN/OUT] the benchmark data                           *
+ *             values - [IN] number of values to replay                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	bench_history_replay(bench_history_t *bench, int values)
+{
+	int	i, ret_flush;
+	double	time_start, time_cache;
+
+	time_start = zbx_time();
+
+	zbx_vector_ptr_clear(&bench->history_ptrs);
+
+	for (i = 0; i < values; i++)
+	{
+		const bench_history_value_t	*value = &bench->values[bench->pos];
+		zbx_dc_history_t		*h = &bench->history[i];
+
+		memset(h, 0, sizeof(zbx_dc_history_t));
+		h->itemid = value->item->itemid;
+		h->value_type = value->item->value_type;
+		h->value = value->value;
+		h->ts.sec = value->ts.sec + bench->shift;
+		h->ts.ns = value->ts.ns;
+		zbx_vector_ptr_append(&bench->history_ptrs, h);
+
+		if (++bench->pos == bench->values_num)
+		{
+			bench->pos = 0;
+			bench->shift += bench->span;
+		}
+	}
+
+	(void)zbx_vc_add_values(&bench->history_ptrs, &ret_flush);
+
+	time_cache = zbx_time();
+	bench->time_cache += time_cache - time_start;
+
+	if (0 != bench->evaluate)
+	{
+		for (i = 0; i < values; i++)
+		{
+			const zbx_dc_history_t		*h = &bench->history[i];
+			const bench_history_item_t	*item;
+			zbx_dc_evaluate_item_t		eval_item;
+
+			item = (const bench_history_item_t *)zbx_hashset_search(&bench->items, &h->itemid);
+
+			eval_item.itemid = item->itemid;
+			eval_item.proxy_hostid = 0;
+			eval_item.host = "bench";
+			eval_item.key_orig = item->key;
+			eval_item.value_type = item->value_type;
+
+			for (int j = 0; j < item->functions.values_num; j++)
+			{
+				zbx_variant_t	value;
+				char		*error = NULL;
+
+				if (SUCCEED == evaluate_function(&value, &eval_item, item->functions.values[j].first,
+						item->functions.values[j].second, &h->ts, &error))
+				{
+					zbx_variant_clear(&value);
+				}
+				else
+				{
+					bench->failed++;
+					zbx_free(error);
+				}
+
+				bench->evaluated++;
+			}
+		}
+
+		bench->time_evaluate += zbx_time() - time_cache;
+	}
+
+	bench->replayed += (zbx_uint64_t)values;
+}
+
+static void	*bench_history_setup(int evaluate)
+{
+	static int	initialized;
+	bench_history_t	*bench;
+	const char	*path;
+	int		first, last;
+	char		*error = NULL;
+
+	if (0 == initialized)
+	{
+		if (SUCCEED != zbx_locks_create(&error) || SUCCEED != zbx_vc_init(BENCH_HISTORY_CACHE_SIZE, &error))
+		{
+			fprintf(stderr, "cannot initialize value cache: %s\n", error);
+			zbx_free(error);
+			return NULL;
+		}
+
+		zbx_vc_enable();
+		initialized = 1;
+	}
+
+	bench = bench_history_create();
+	bench->evaluate = evaluate;
+
+	if (NULL != (path = getenv(BENCH_HISTORY_REPLAY_ENV)))
+	{
+		if (SUCCEED != bench_history_load(bench, path))
+		{
+			bench_history_cleanup(bench);
+			return NULL;
+		}
+	}
+	else
+		bench_history_generate(bench);
+
+	first = last = bench->values[0].ts.sec;
+
+	for (int i = 1; i < bench->values_num; i++)
+	{
+		if (bench->values[i].ts.sec < first)
+			first = bench->values[i].ts.sec;
+		else if (bench->values[i].ts.sec > last)
+			last = bench->values[i].ts.sec;
+	}
+
+	bench->span = last - first + 1;
+
+	/* replay the whole stream once to fill value cache, as it would be after server has been running */
+	for (int i = 0; i < bench->values_num; i += BENCH_HISTORY_BATCH)
+		bench_history_replay(bench, MIN(BENCH_HISTORY_BATCH, bench->values_num - i));
+
+	bench->replayed = 0;
+	bench->evaluated = 0;
+	bench->failed = 0;
+	bench->time_cache = 0;
+	bench->time_evaluate = 0;
+	bench_allocations = 0;
+
+	return bench;
+}
+
+static void	*bench_history_cache_setup(void)
+{
+	return bench_history_setup(0);
+}
+
+static void	*bench_history_evaluate_setup(void)
+{
+	return bench_history_setup(1);
+}
+
+static void	bench_history_run(void *data, zbx_uint64_t loops)
+{
+	bench_history_t	*bench = (bench_history_t *)data;
+	zbx_uint64_t	allocations = bench_allocations;
+
+	while (0 != loops)
+	{
+		int	values = (int)MIN(loops, BENCH_HISTORY_BATCH);
+
+		bench_history_replay(bench, values);
+		loops -= (zbx_uint64_t)values;
+	}
+
+	bench->allocations += bench_allocations - allocations;
+}
+
+int	main(int argc, char **argv)
+{
+	static const zbx_bench_case_t	cases[] = {
+		{"history_replay_cache_values", bench_history_cache_setup, bench_history_run,
+				bench_history_cleanup},
+		{"history_replay_evaluate_functions", bench_history_evaluate_setup, bench_history_run,
+				bench_history_cleanup},
+		{NULL}
+	};
+
+	return zbx_bench_main(argc, argv, cases);
+}
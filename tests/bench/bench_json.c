@@ -0,0 +1,258 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxbench.h"
+
+#include "zbxjson.h"
+
+#define BENCH_JSON_ROWS		200
+
+#define BENCH_JSONPATH_FILTER	"$.data[?(@.name == \"metric150\")].value"
+#define BENCH_JSONPATH_DEFINITE	"$.data[150].value"
+
+typedef struct
+{
+	char		*data;
+	zbx_jsonobj_t	obj;
+	zbx_jsonpath_t	path;
+}
+bench_json_t;
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: prepare JSON document shaped like monitoring API response         *
+ *                                                                            *
+ ******************************************************************************/
+static void	*bench_json_setup(void)
+{
+	bench_json_t	*json;
+	struct zbx_json	j;
+
+	json = (bench_json_t *)zbx_malloc(NULL, sizeof(bench_json_t));
+
+	zbx_json_init(&j, ZBX_JSON_STAT_BUF_LEN);
+	zbx_json_addarray(&j, "data");
+
+	for (int i = 0; i < BENCH_JSON_ROWS; i++)
+	{
+		char	name[32];
+
+		zbx_snprintf(name, sizeof(name), "metric%d", i);
+
+		zbx_json_addobject(&j, NULL);
+		zbx_json_addstring(&j, "name", name, ZBX_JSON_TYPE_STRING);
+		zbx_json_addint64(&j, "value", i * 7);
+		zbx_json_addstring(&j, "unit", "bytes", ZBX_JSON_TYPE_STRING);
+		zbx_json_addobject(&j, "tags");
+		zbx_json_addstring(&j, "host", "server", ZBX_JSON_TYPE_STRING);
+		zbx_json_addstring(&j, "env", 0 == i % 2 ? "prod" : "test", ZBX_JSON_TYPE_STRING);
+		zbx_json_close(&j);
+		zbx_json_close(&j);
+	}
+
+	json->data = zbx_strdup(NULL, j.buffer);
+	zbx_json_free(&j);
+
+	if (SUCCEED != zbx_jsonobj_open(json->data, &json->obj))
+	{
+		fprintf(stderr, "cannot parse benchmark JSON: %s\n", zbx_json_strerror());
+		zbx_free(json->data);
+		zbx_free(json);
+		return NULL;
+	}
+
+	if (SUCCEED != zbx_jsonpath_compile(BENCH_JSONPATH_FILTER, &json->path))
+	{
+		fprintf(stderr, "cannot compile benchmark JSONPath: %s\n", zbx_json_strerror());
+		zbx_jsonobj_clear(&json->obj);
+		zbx_free(json->data);
+		zbx_free(json);
+		return NULL;
+	}
+
+	return json;
+}
+
+static void	bench_json_cleanup(void *data)
+{
+	bench_json_t	*json = (bench_json_t *)data;
+
+	zbx_jsonpath_clear(&json->path);
+	zbx_jsonobj_clear(&json->obj);
+	zbx_free(json->data);
+	zbx_free(json);
+}
+
+static void	bench_json_open(void *data, zbx_uint64_t loops, int (*open_func)(const char *, zbx_jsonobj_t *))
+{
+	bench_json_t	*json = (bench_json_t *)data;
+
+	for (zbx_uint64_t i = 0; i < loops; i++)
+	{
+		zbx_jsonobj_t	obj;
+
+		if (SUCCEED == open_func(json->data, &obj))
+			zbx_jsonobj_clear(&obj);
+	}
+}
+
+static void	bench_jsonobj_open(void *data, zbx_uint64_t loops)
+{
+	bench_json_open(data, loops, zbx_jsonobj_open);
+}
+
+static void	bench_jsonobj_open_lazy(void *data, zbx_uint64_t loops)
+{
+	bench_json_open(data, loops, zbx_jsonobj_open_lazy);
+}
+
+static void	bench_jsonobj_open_arena(void *data, zbx_uint64_t loops)
+{
+	bench_json_open(data, loops, zbx_jsonobj_open_arena);
+}
+
+static void	bench_jsonpath_compile(void *data, zbx_uint64_t loops)
+{
+	ZBX_UNUSED(data);
+
+	for (zbx_uint64_t i = 0; i < loops; i++)
+	{
+		zbx_jsonpath_t	path;
+
+		if (SUCCEED == zbx_jsonpath_compile(BENCH_JSONPATH_FILTER, &path))
+			zbx_jsonpath_clear(&path);
+	}
+}
+
+static void	bench_jsonobj_query(void *data, zbx_uint64_t loops, const char *path)
+{
+	bench_json_t	*json = (bench_json_t *)data;
+
+	for (zbx_uint64_t i = 0; i < loops; i++)
+	{
+		char	*output = NULL;
+
+		if (SUCCEED == zbx_jsonobj_query(&json->obj, path, &output))
+			zbx_free(output);
+	}
+}
+
+static void	bench_jsonobj_query_filter(void *data, zbx_uint64_t loops)
+{
+	bench_jsonobj_query(data, loops, BENCH_JSONPATH_FILTER);
+}
+
+static void	bench_jsonobj_query_definite(void *data, zbx_uint64_t loops)
+{
+	bench_jsonobj_query(data, loops, BENCH_JSONPATH_DEFINITE);
+}
+
+static void	bench_jsonobj_query_compiled(void *data, zbx_uint64_t loops)
+{
+	bench_json_t	*json = (bench_json_t *)data;
+
+	for (zbx_uint64_t i = 0; i < loops; i++)
+	{
+		char	*output = NULL;
+
+		if (SUCCEED == zbx_jsonobj_query_ext(&json->obj, &json->path, &output))
+			zbx_free(output);
+	}
+}
+
+static void	bench_json_query_text(void *data, zbx_uint64_t loops)
+{
+	bench_json_t		*json = (bench_json_t *)data;
+	struct zbx_json_parse	jp;
+
+	if (SUCCEED != zbx_json_open(json->data, &jp))
+		return;
+
+	/* parses the document on every query, as done when the value is not cached */
+	for (zbx_uint64_t i = 0; i < loops; i++)
+	{
+		char	*output = NULL;
+
+		if (SUCCEED == zbx_jsonpath_query(&jp, BENCH_JSONPATH_FILTER, &output))
+			zbx_free(output);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: build JSON document shaped like history export records            *
+ *                                                                            *
+ ******************************************************************************/
+static void	bench_json_build(zbx_uint64_t loops, const char *value)
+{
+	for (zbx_uint64_t i = 0; i < loops; i++)
+	{
+		struct zbx_json	j;
+
+		zbx_json_init(&j, ZBX_JSON_STAT_BUF_LEN);
+		zbx_json_addarray(&j, ZBX_PROTO_TAG_DATA);
+
+		for (int row = 0; row < BENCH_JSON_ROWS; row++)
+		{
+			zbx_json_addobject(&j, NULL);
+			zbx_json_addstring(&j, "host", "Zabbix server", ZBX_JSON_TYPE_STRING);
+			zbx_json_addstring(&j, "key", "log[/var/log/messages]", ZBX_JSON_TYPE_STRING);
+			zbx_json_addint64(&j, "clock", 1700000000 + row);
+			zbx_json_addstring(&j, "value", value, ZBX_JSON_TYPE_STRING);
+			zbx_json_close(&j);
+		}
+
+		zbx_json_free(&j);
+	}
+}
+
+static void	bench_json_build_plain(void *data, zbx_uint64_t loops)
+{
+	ZBX_UNUSED(data);
+
+	bench_json_build(loops, "Oct 15 10:00:00 server systemd[1]: Started Session 42 of user zabbix, "
+			"connection from 192.168.1.10 port 51234 accepted by sshd service");
+}
+
+static void	bench_json_build_escaped(void *data, zbx_uint64_t loops)
+{
+	ZBX_UNUSED(data);
+
+	bench_json_build(loops, "Oct 15 10:00:00 server app[1]: request \"GET /api\" failed:\n"
+			"\tat C:\\app\\main.c:42\n\tat C:\\app\\loop.c:7\r\n");
+}
+
+int	main(int argc, char **argv)
+{
+	static const zbx_bench_case_t	cases[] = {
+		{"jsonobj_open", bench_json_setup, bench_jsonobj_open, bench_json_cleanup},
+		{"jsonobj_open_lazy", bench_json_setup, bench_jsonobj_open_lazy, bench_json_cleanup},
+		{"jsonobj_open_arena", bench_json_setup, bench_jsonobj_open_arena, bench_json_cleanup},
+		{"jsonpath_compile", bench_json_setup, bench_jsonpath_compile, bench_json_cleanup},
+		{"jsonobj_query_filter", bench_json_setup, bench_jsonobj_query_filter, bench_json_cleanup},
+		{"jsonobj_query_definite", bench_json_setup, bench_jsonobj_query_definite, bench_json_cleanup},
+		{"jsonobj_query_compiled", bench_json_setup, bench_jsonobj_query_compiled, bench_json_cleanup},
+		{"jsonpath_query_text", bench_json_setup, bench_json_query_text, bench_json_cleanup},
+		{"json_build_plain", NULL, bench_json_build_plain, NULL},
+		{"json_build_escaped", NULL, bench_json_build_escaped, NULL},
+		{NULL}
+	};
+
+	return zbx_bench_main(argc, argv, cases);
+}
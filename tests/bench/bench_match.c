@@ -0,0 +1,260 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxbench.h"
+
+#include "zbxprometheus.h"
+#include "zbxregexp.h"
+#include "zbxstr.h"
+
+#define BENCH_PROMETHEUS_ROWS	500
+
+#define BENCH_PROMETHEUS_FILTER	"http_requests_total{code=\"200\",handler=\"handler250\"}"
+#define BENCH_REGEXP		"^([a-z]+)\\[([0-9]+)\\] took ([0-9.]+) ms$"
+#define BENCH_REGEXP_SUBJECT	"request[12345] took 17.25 ms"
+
+typedef struct
+{
+	char			*data;
+	zbx_prometheus_t	prom;
+	zbx_prometheus_filter_t	*filter;
+}
+bench_prometheus_t;
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: prepare metrics page in Prometheus text format                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	*bench_prometheus_setup(void)
+{
+	bench_prometheus_t	*bench;
+	size_t			data_alloc = 0, data_offset = 0;
+	char			*error = NULL;
+
+	bench = (bench_prometheus_t *)zbx_malloc(NULL, sizeof(bench_prometheus_t));
+	bench->data = NULL;
+
+	zbx_strcpy_alloc(&bench->data, &data_alloc, &data_offset,
+			"# HELP http_requests_total Total number of HTTP requests.\n"
+			"# TYPE http_requests_total counter\n");
+
+	for (int i = 0; i < BENCH_PROMETHEUS_ROWS; i++)
+	{
+		zbx_snprintf_alloc(&bench->data, &data_alloc, &data_offset,
+				"http_requests_total{code=\"%d\",handler=\"handler%d\",method=\"get\"} %d\n",
+				0 == i % 5 ? 500 : 200, i, i * 13);
+	}
+
+	if (SUCCEED != zbx_prometheus_init(&bench->prom, bench->data, &error))
+		goto fail;
+
+	if (SUCCEED != zbx_prometheus_filter_create(BENCH_PROMETHEUS_FILTER, &bench->filter, &error))
+	{
+		zbx_prometheus_clear(&bench->prom);
+		goto fail;
+	}
+
+	return bench;
+fail:
+	fprintf(stderr, "cannot prepare Prometheus benchmark: %s\n", error);
+	zbx_free(error);
+	zbx_free(bench->data);
+	zbx_free(bench);
+
+	return NULL;
+}
+
+static void	bench_prometheus_cleanup(void *data)
+{
+	bench_prometheus_t	*bench = (bench_prometheus_t *)data;
+
+	zbx_prometheus_filter_free(bench->filter);
+	zbx_prometheus_clear(&bench->prom);
+	zbx_free(bench->data);
+	zbx_free(bench);
+}
+
+static void	bench_prometheus_pattern(void *data, zbx_uint64_t loops)
+{
+	bench_prometheus_t	*bench = (bench_prometheus_t *)data;
+
+	for (zbx_uint64_t i = 0; i < loops; i++)
+	{
+		char	*value = NULL, *error = NULL;
+
+		if (SUCCEED == zbx_prometheus_pattern(bench->data, BENCH_PROMETHEUS_FILTER, "value", "", &value,
+				&error))
+		{
+			zbx_free(value);
+		}
+		else
+			zbx_free(error);
+	}
+}
+
+static void	bench_prometheus_pattern_cached(void *data, zbx_uint64_t loops)
+{
+	bench_prometheus_t	*bench = (bench_prometheus_t *)data;
+
+	for (zbx_uint64_t i = 0; i < loops; i++)
+	{
+		char	*value = NULL, *error = NULL;
+
+		if (SUCCEED == zbx_prometheus_pattern_ex(&bench->prom, BENCH_PROMETHEUS_FILTER, "value", "", &value,
+				&error))
+		{
+			zbx_free(value);
+		}
+		else
+			zbx_free(error);
+	}
+}
+
+static void	bench_prometheus_pattern_prepared(void *data, zbx_uint64_t loops)
+{
+	bench_prometheus_t	*bench = (bench_prometheus_t *)data;
+
+	for (zbx_uint64_t i = 0; i < loops; i++)
+	{
+		char	*value = NULL, *error = NULL;
+
+		if (SUCCEED == zbx_prometheus_pattern_prepared(&bench->prom, bench->filter, "value", "", &value,
+				&error))
+		{
+			zbx_free(value);
+		}
+		else
+			zbx_free(error);
+	}
+}
+
+static void	bench_prometheus_init(void *data, zbx_uint64_t loops)
+{
+	bench_prometheus_t	*bench = (bench_prometheus_t *)data;
+
+	for (zbx_uint64_t i = 0; i < loops; i++)
+	{
+		zbx_prometheus_t	prom;
+		char			*error = NULL;
+
+		if (SUCCEED == zbx_prometheus_init(&prom, bench->data, &error))
+			zbx_prometheus_clear(&prom);
+		else
+			zbx_free(error);
+	}
+}
+
+static void	*bench_regexp_setup(void)
+{
+	zbx_regexp_t	*regexp;
+	const char	*error = NULL;
+
+	if (SUCCEED != zbx_regexp_compile(BENCH_REGEXP, &regexp, &error))
+	{
+		fprintf(stderr, "cannot compile benchmark regular expression: %s\n", error);
+		zbx_regexp_err_msg_free(error);
+		return NULL;
+	}
+
+	return regexp;
+}
+
+static void	bench_regexp_cleanup(void *data)
+{
+	zbx_regexp_free((zbx_regexp_t *)data);
+}
+
+static void	bench_regexp_compile(void *data, zbx_uint64_t loops)
+{
+	ZBX_UNUSED(data);
+
+	for (zbx_uint64_t i = 0; i < loops; i++)
+	{
+		zbx_regexp_t	*regexp;
+		const char	*error = NULL;
+
+		if (SUCCEED == zbx_regexp_compile(BENCH_REGEXP, &regexp, &error))
+			zbx_regexp_free(regexp);
+		else
+			zbx_regexp_err_msg_free(error);
+	}
+}
+
+static void	bench_regexp_match_precompiled(void *data, zbx_uint64_t loops)
+{
+	zbx_uint64_t	matched = 0;
+
+	for (zbx_uint64_t i = 0; i < loops; i++)
+	{
+		if (ZBX_REGEXP_MATCH == zbx_regexp_match_precompiled(BENCH_REGEXP_SUBJECT, (zbx_regexp_t *)data))
+			matched++;
+	}
+
+	zbx_bench_sink = matched;
+}
+
+static void	bench_regexp_match(void *data, zbx_uint64_t loops)
+{
+	zbx_uint64_t	matched = 0;
+
+	ZBX_UNUSED(data);
+
+	for (zbx_uint64_t i = 0; i < loops; i++)
+	{
+		if (NULL != zbx_regexp_match(BENCH_REGEXP_SUBJECT, BENCH_REGEXP, NULL))
+			matched++;
+	}
+
+	zbx_bench_sink = matched;
+}
+
+static void	bench_regexp_sub(void *data, zbx_uint64_t loops)
+{
+	ZBX_UNUSED(data);
+
+	for (zbx_uint64_t i = 0; i < loops; i++)
+	{
+		char	*out = NULL;
+
+		if (SUCCEED == zbx_mregexp_sub(BENCH_REGEXP_SUBJECT, BENCH_REGEXP, "\\3", &out))
+			zbx_free(out);
+	}
+}
+
+int	main(int argc, char **argv)
+{
+	static const zbx_bench_case_t	cases[] = {
+		{"prometheus_init_500", bench_prometheus_setup, bench_prometheus_init, bench_prometheus_cleanup},
+		{"prometheus_pattern_500", bench_prometheus_setup, bench_prometheus_pattern,
+				bench_prometheus_cleanup},
+		{"prometheus_pattern_cached", bench_prometheus_setup, bench_prometheus_pattern_cached,
+				bench_prometheus_cleanup},
+		{"prometheus_pattern_prepared", bench_prometheus_setup, bench_prometheus_pattern_prepared,
+				bench_prometheus_cleanup},
+		{"regexp_compile", NULL, bench_regexp_compile, NULL},
+		{"regexp_match", NULL, bench_regexp_match, NULL},
+		{"regexp_match_precompiled", bench_regexp_setup, bench_regexp_match_precompiled,
+				bench_regexp_cleanup},
+		{"regexp_sub", NULL, bench_regexp_sub, NULL},
+		{NULL}
+	};
+
+	return zbx_bench_main(argc, argv, cases);
+}
@@ -0,0 +1,255 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxbench.h"
+
+#include "zbxpreproc.h"
+#include "zbxvariant.h"
+#include "zbxjson.h"
+#include "zbxstr.h"
+#include "libs/zbxpreproc/pp_execute.h"
+
+#define BENCH_PREPROC_STEPS_MAX	4
+
+typedef struct
+{
+	unsigned char	type;
+	const char	*params;
+}
+bench_step_def_t;
+
+typedef struct
+{
+	zbx_pp_context_t	ctx;
+	zbx_pp_step_t		steps[BENCH_PREPROC_STEPS_MAX];
+	int			steps_num;
+	unsigned char		value_type;
+	char			*input;
+}
+bench_preproc_t;
+
+static void	bench_preproc_cleanup(void *data)
+{
+	bench_preproc_t	*bench = (bench_preproc_t *)data;
+
+	for (int i = 0; i < bench->steps_num; i++)
+	{
+		zbx_free(bench->steps[i].params);
+		zbx_free(bench->steps[i].error_handler_params);
+	}
+
+	pp_context_destroy(&bench->ctx);
+	zbx_free(bench->input);
+	zbx_free(bench);
+}
+
+static int	bench_preproc_execute(bench_preproc_t *bench)
+{
+	zbx_variant_t	value, history_value;
+	zbx_timespec_t	ts = {1700000000, 0}, history_ts = {0, 0};
+	int		ret = SUCCEED;
+
+	zbx_variant_set_str(&value, zbx_strdup(NULL, bench->input));
+	zbx_variant_set_none(&history_value);
+
+	for (int i = 0; i < bench->steps_num && SUCCEED == ret; i++)
+	{
+		ret = pp_execute_step(&bench->ctx, NULL, bench->value_type, &value, ts, &bench->steps[i],
+				&history_value, &history_ts);
+	}
+
+	if (ZBX_VARIANT_ERR == value.type)
+		ret = FAIL;
+
+	zbx_variant_clear(&value);
+	zbx_variant_clear(&history_value);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: prepare preprocessing step chain and check that it succeeds       *
+ *                                                                            *
+ * Parameters: defs       - [IN] step definitions                             *
+ *             defs_num   - [IN] number of steps                              *
+ *             value_type - [IN] item value type                              *
+ *             input      - [IN] input value (owned by the benchmark)         *
+ *                                                                            *
+ ******************************************************************************/
+static void	*bench_preproc_create(const bench_step_def_t *defs, int defs_num, unsigned char value_type,
+		char *input)
+{
+	bench_preproc_t	*bench;
+
+	bench = (bench_preproc_t *)zbx_malloc(NULL, sizeof(bench_preproc_t));
+	memset(bench, 0, sizeof(bench_preproc_t));
+
+	pp_context_init(&bench->ctx);
+	bench->value_type = value_type;
+	bench->input = input;
+
+	for (; bench->steps_num < defs_num; bench->steps_num++)
+	{
+		zbx_pp_step_t	*step = &bench->steps[bench->steps_num];
+
+		step->type = defs[bench->steps_num].type;
+		step->error_handler = ZBX_PREPROC_FAIL_DEFAULT;
+		step->params = zbx_strdup(NULL, defs[bench->steps_num].params);
+		step->error_handler_params = zbx_strdup(NULL, "");
+	}
+
+	if (SUCCEED != bench_preproc_execute(bench))
+	{
+		fprintf(stderr, "cannot execute benchmark preprocessing steps\n");
+		bench_preproc_cleanup(bench);
+		return NULL;
+	}
+
+	return bench;
+}
+
+static void	*bench_preproc_json_setup(void)
+{
+	static const bench_step_def_t	defs[] = {
+		{ZBX_PREPROC_JSONPATH, "$.data[?(@.name == \"metric42\")].value.first()"},
+		{ZBX_PREPROC_MULTIPLIER, "8"},
+		{ZBX_PREPROC_VALIDATE_RANGE, "0\n1000000"}
+	};
+	struct zbx_json			j;
+	char				*input;
+
+	zbx_json_init(&j, ZBX_JSON_STAT_BUF_LEN);
+	zbx_json_addarray(&j, "data");
+
+	for (int i = 0; i < 100; i++)
+	{
+		char	name[32];
+
+		zbx_snprintf(name, sizeof(name), "metric%d", i);
+		zbx_json_addobject(&j, NULL);
+		zbx_json_addstring(&j, "name", name, ZBX_JSON_TYPE_STRING);
+		zbx_json_adduint64(&j, "value", (zbx_uint64_t)i * 11);
+		zbx_json_close(&j);
+	}
+
+	input = zbx_strdup(NULL, j.buffer);
+	zbx_json_free(&j);
+
+	return bench_preproc_create(defs, ARRSIZE(defs), ITEM_VALUE_TYPE_FLOAT, input);
+}
+
+static void	*bench_preproc_text_setup(void)
+{
+	static const bench_step_def_t	defs[] = {
+		{ZBX_PREPROC_TRIM, " \n"},
+		{ZBX_PREPROC_REGSUB, "took ([0-9.]+) ms\n\\1"},
+		{ZBX_PREPROC_MULTIPLIER, "0.001"}
+	};
+
+	return bench_preproc_create(defs, ARRSIZE(defs), ITEM_VALUE_TYPE_FLOAT,
+			zbx_strdup(NULL, "  request[12345] took 17.25 ms\n"));
+}
+
+static void	*bench_preproc_prometheus_setup(void)
+{
+	static const bench_step_def_t	defs[] = {
+		{ZBX_PREPROC_PROMETHEUS_PATTERN, "http_requests_total{handler=\"handler42\"}\nvalue\n"},
+		{ZBX_PREPROC_MULTIPLIER, "2"}
+	};
+	char				*input = NULL;
+	size_t				input_alloc = 0, input_offset = 0;
+
+	for (int i = 0; i < 100; i++)
+	{
+		zbx_snprintf_alloc(&input, &input_alloc, &input_offset,
+				"http_requests_total{code=\"200\",handler=\"handler%d\"} %d\n", i, i * 13);
+	}
+
+	return bench_preproc_create(defs, ARRSIZE(defs), ITEM_VALUE_TYPE_FLOAT, input);
+}
+
+static char	*bench_preproc_history_json(void)
+{
+	struct zbx_json	j;
+	char		*input;
+
+	zbx_json_initarray(&j, ZBX_JSON_STAT_BUF_LEN);
+
+	for (int i = 0; i < 1000; i++)
+	{
+		zbx_json_addobject(&j, NULL);
+		zbx_json_adduint64(&j, "itemid", 100000 + (zbx_uint64_t)i);
+		zbx_json_adduint64(&j, "clock", 1700000000 + (zbx_uint64_t)i);
+		zbx_json_adduint64(&j, "ns", (zbx_uint64_t)i * 997);
+		zbx_json_addfloat(&j, "value", i * 0.25 + 0.1);
+		zbx_json_adddouble(&j, "ratio", 1.0 / (i + 3));
+		zbx_json_close(&j);
+	}
+
+	input = zbx_strdup(NULL, j.buffer);
+	zbx_json_free(&j);
+
+	return input;
+}
+
+static void	*bench_preproc_script_parse_setup(void)
+{
+	static const bench_step_def_t	defs[] = {
+		{ZBX_PREPROC_SCRIPT, "return JSON.parse(value).length;"}
+	};
+
+	return bench_preproc_create(defs, ARRSIZE(defs), ITEM_VALUE_TYPE_TEXT, bench_preproc_history_json());
+}
+
+static void	*bench_preproc_script_stringify_setup(void)
+{
+	static const bench_step_def_t	defs[] = {
+		{ZBX_PREPROC_SCRIPT, "return JSON.stringify(JSON.parse(value));"}
+	};
+
+	return bench_preproc_create(defs, ARRSIZE(defs), ITEM_VALUE_TYPE_TEXT, bench_preproc_history_json());
+}
+
+static void	bench_preproc_run(void *data, zbx_uint64_t loops)
+{
+	bench_preproc_t	*bench = (bench_preproc_t *)data;
+
+	for (zbx_uint64_t i = 0; i < loops; i++)
+		(void)bench_preproc_execute(bench);
+}
+
+int	main(int argc, char **argv)
+{
+	static const zbx_bench_case_t	cases[] = {
+		{"preproc_jsonpath_multiplier_range", bench_preproc_json_setup, bench_preproc_run,
+				bench_preproc_cleanup},
+		{"preproc_trim_regsub_multiplier", bench_preproc_text_setup, bench_preproc_run,
+				bench_preproc_cleanup},
+		{"preproc_prometheus_multiplier", bench_preproc_prometheus_setup, bench_preproc_run,
+				bench_preproc_cleanup},
+		{"preproc_javascript_json_parse", bench_preproc_script_parse_setup, bench_preproc_run,
+				bench_preproc_cleanup},
+		{"preproc_javascript_json_stringify", bench_preproc_script_stringify_setup, bench_preproc_run,
+				bench_preproc_cleanup},
+		{NULL}
+	};
+
+	return zbx_bench_main(argc, argv, cases);
+}
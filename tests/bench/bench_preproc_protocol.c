@@ -0,0 +1,151 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxbench.h"
+
+#include "zbxsysinfo.h"
+
+/* value packing functions are internal to the preprocessing protocol */
+#include "libs/zbxpreproc/pp_protocol.c"
+
+#define BENCH_PP_BATCH_SIZE	256
+
+typedef struct
+{
+	zbx_preproc_item_value_t	values[BENCH_PP_BATCH_SIZE];
+	AGENT_RESULT			results[BENCH_PP_BATCH_SIZE];
+	zbx_timespec_t			ts[BENCH_PP_BATCH_SIZE];
+	zbx_ipc_message_t		message;
+}
+bench_pp_values_t;
+
+static void	*bench_pp_values_create(int meta)
+{
+	bench_pp_values_t	*bench;
+
+	bench = (bench_pp_values_t *)zbx_malloc(NULL, sizeof(bench_pp_values_t));
+	memset(bench, 0, sizeof(bench_pp_values_t));
+
+	for (int i = 0; i < BENCH_PP_BATCH_SIZE; i++)
+	{
+		zbx_preproc_item_value_t	*value = &bench->values[i];
+
+		zbx_init_agent_result(&bench->results[i]);
+		SET_UI64_RESULT(&bench->results[i], (zbx_uint64_t)i * 1000003);
+
+		/* meta information forces the generic layout for otherwise the same values */
+		if (0 != meta)
+			bench->results[i].type |= AR_META;
+
+		bench->ts[i].sec = 1700000000 + i / 16;
+		bench->ts[i].ns = i * 3906250;
+
+		value->itemid = 100000 + (zbx_uint64_t)i;
+		value->hostid = 10000 + (zbx_uint64_t)i / 32;
+		value->item_value_type = ITEM_VALUE_TYPE_UINT64;
+		value->item_flags = ZBX_FLAG_DISCOVERY_NORMAL;
+		value->state = ITEM_STATE_NORMAL;
+		value->result = &bench->results[i];
+		value->ts = &bench->ts[i];
+	}
+
+	zbx_ipc_message_init(&bench->message);
+
+	return bench;
+}
+
+static void	*bench_pp_numeric_setup(void)
+{
+	return bench_pp_values_create(0);
+}
+
+static void	*bench_pp_full_setup(void)
+{
+	return bench_pp_values_create(1);
+}
+
+static void	bench_pp_cleanup(void *data)
+{
+	bench_pp_values_t	*bench = (bench_pp_values_t *)data;
+
+	zbx_ipc_message_clean(&bench->message);
+	zbx_free(bench);
+}
+
+/* unpack values the same way as preprocessing manager does */
+static zbx_uint64_t	bench_pp_unpack(const zbx_ipc_message_t *message)
+{
+	zbx_uint32_t	offset = 0, size;
+	zbx_uint64_t	sum = 0;
+
+	while (offset < message->size)
+	{
+		zbx_preproc_item_value_t	value;
+		zbx_variant_t			var;
+		zbx_timespec_t			ts;
+
+		if (0 != (size = zbx_preprocessor_unpack_numeric_value(&value, &var, &ts, message->data + offset)))
+		{
+			offset += size;
+			sum += var.data.ui64;
+			continue;
+		}
+
+		offset += zbx_preprocessor_unpack_value(&value, message->data + offset);
+		sum += value.result->ui64;
+
+		zbx_free(value.error);
+		zbx_free(value.ts);
+		zbx_free_agent_result(value.result);
+		zbx_free(value.result);
+	}
+
+	return sum;
+}
+
+static void	bench_pp_run(void *data, zbx_uint64_t loops)
+{
+	bench_pp_values_t	*bench = (bench_pp_values_t *)data;
+	zbx_uint64_t		sum = 0, bytes = 0;
+
+	for (zbx_uint64_t i = 0; i < loops; i++)
+	{
+		(void)preprocessor_pack_value(&bench->message, &bench->values[i % BENCH_PP_BATCH_SIZE]);
+
+		if (BENCH_PP_BATCH_SIZE - 1 == i % BENCH_PP_BATCH_SIZE || i + 1 == loops)
+		{
+			sum += bench_pp_unpack(&bench->message);
+			bytes += bench->message.size;
+			bench->message.size = 0;
+		}
+	}
+
+	zbx_bench_sink = sum + bytes;
+}
+
+int	main(int argc, char **argv)
+{
+	static const zbx_bench_case_t	cases[] = {
+		{"preproc_protocol_numeric", bench_pp_numeric_setup, bench_pp_run, bench_pp_cleanup},
+		{"preproc_protocol_full", bench_pp_full_setup, bench_pp_run, bench_pp_cleanup},
+		{NULL}
+	};
+
+	return zbx_bench_main(argc, argv, cases);
+}
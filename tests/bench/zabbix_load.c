@@ -0,0 +1,675 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxcommon.h"
+#include "zbxcomms.h"
+#include "zbxjson.h"
+#include "zbxnum.h"
+#include "zbxstr.h"
+#include "zbxtime.h"
+#include "zbxcrypto.h"
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+/* the load generator is linked without daemon, these are required by zbxlog and zbxnix */
+const char	title_message[] = "zabbix_load";
+const char	*usage_message[] = {
+		"[-z server] [-p port] [-m sender|agent|proxy] [-c clients] [-H hosts] [-k keys] [-b batch]"
+		" [-i interval ms] [-d duration s] [-t float|uint|text] [-l text size] [-I first itemid]"
+		" [-n name prefix] [-S stats interval s]",
+		NULL};
+const char	*help_message[] = {
+		"Simulate clients sending values to server or proxy trapper and report ingestion throughput.\n"
+		"In sender and agent modes each client sends values of items \"load.item[<key>]\" for its hosts named\n"
+		"\"<prefix><host>\", in proxy mode each client is proxy \"<prefix><client>\" sending history of\n"
+		"consecutive item identifiers starting with the first itemid. Server statistics are requested\n"
+		"with \"zabbix.stats\", so the load generator address must be listed in StatsAllowedIP.",
+		NULL};
+const char	*progname = "zabbix_load";
+const char	syslog_app_name[] = "zabbix_load";
+
+int	CONFIG_TCP_MAX_BACKLOG_SIZE	= SOMAXCONN;
+
+#define LOAD_MODE_SENDER	0
+#define LOAD_MODE_AGENT		1
+#define LOAD_MODE_PROXY		2
+
+#define LOAD_VALUE_FLOAT	0
+#define LOAD_VALUE_UINT		1
+#define LOAD_VALUE_TEXT		2
+
+#define LOAD_TIMEOUT		30
+
+typedef struct
+{
+	const char	*server;
+	const char	*prefix;
+	unsigned short	port;
+	int		mode;
+	int		clients;
+	int		hosts;
+	int		keys;
+	int		batch;
+	int		interval_ms;
+	int		duration;
+	int		value_type;
+	int		text_size;
+	int		stats_interval;
+	zbx_uint64_t	itemid;
+}
+zbx_load_config_t;
+
+/* counters are written by a single client process and read by the parent */
+typedef struct
+{
+	zbx_uint64_t	requests;
+	zbx_uint64_t	values;
+	zbx_uint64_t	processed;
+	zbx_uint64_t	failed;
+	zbx_uint64_t	errors;
+	double		latency_sum;
+	double		latency_max;
+}
+zbx_load_counters_t;
+
+typedef struct
+{
+	zbx_uint64_t	synced;
+	zbx_uint64_t	preprocessing_queue;
+	zbx_uint64_t	queue;
+	double		history_pused;
+	double		syncer_busy;
+}
+zbx_load_server_stats_t;
+
+static void	load_sleep(double sec)
+{
+	struct timespec	ts;
+
+	if (0 >= sec)
+		return;
+
+	ts.tv_sec = (time_t)sec;
+	ts.tv_nsec = (long)((sec - (double)ts.tv_sec) * 1e9);
+	nanosleep(&ts, NULL);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: send request to server and receive the response                   *
+ *                                                                            *
+ * Parameters: config   - [IN]                                                *
+ *             request  - [IN] JSON request                                   *
+ *             response - [OUT] the response, must be freed by caller         *
+ *                                                                            *
+ * Return value: SUCCEED - response was received                              *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	load_exchange(const zbx_load_config_t *config, const struct zbx_json *request, char **response)
+{
+	zbx_socket_t	s;
+	int		ret = FAIL;
+
+	if (SUCCEED != zbx_tcp_connect(&s, NULL, config->server, config->port, LOAD_TIMEOUT,
+			ZBX_TCP_SEC_UNENCRYPTED, NULL, NULL))
+	{
+		return FAIL;
+	}
+
+	if (SUCCEED == zbx_tcp_send_ext(&s, request->buffer, request->buffer_size, 0, ZBX_TCP_PROTOCOL, 0) &&
+			SUCCEED == zbx_tcp_recv_to(&s, LOAD_TIMEOUT))
+	{
+		*response = zbx_strdup(NULL, s.buffer);
+		ret = SUCCEED;
+	}
+
+	zbx_tcp_close(&s);
+
+	return ret;
+}
+
+static void	load_add_value(const zbx_load_config_t *config, struct zbx_json *json, zbx_uint64_t seq,
+		char *text)
+{
+	char	buf[ZBX_MAX_DOUBLE_LEN + 1];
+
+	switch (config->value_type)
+	{
+		case LOAD_VALUE_FLOAT:
+			zbx_snprintf(buf, sizeof(buf), ZBX_FS_DBL, (double)(seq % 100000) / 7);
+			zbx_json_addstring(json, ZBX_PROTO_TAG_VALUE, buf, ZBX_JSON_TYPE_STRING);
+			break;
+		case LOAD_VALUE_UINT:
+			zbx_snprintf(buf, sizeof(buf), ZBX_FS_UI64, seq);
+			zbx_json_addstring(json, ZBX_PROTO_TAG_VALUE, buf, ZBX_JSON_TYPE_STRING);
+			break;
+		default:
+			/* vary the beginning so that values are not identical */
+			zbx_snprintf(buf, sizeof(buf), ZBX_FS_UI64, seq);
+			memcpy(text, buf, MIN(strlen(buf), (size_t)config->text_size));
+			zbx_json_addstring(json, ZBX_PROTO_TAG_VALUE, text, ZBX_JSON_TYPE_STRING);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: build one request of the configured protocol                      *
+ *                                                                            *
+ * Parameters: config  - [IN]                                                 *
+ *             client  - [IN] client index                                    *
+ *             session - [IN] agent or proxy session token                    *
+ *             json    - [OUT] the request                                    *
+ *             seq     - [IN/OUT] value sequence number of the client         *
+ *             text    - [IN] text value buffer                               *
+ *                                                                            *
+ ******************************************************************************/
+static void	load_build_request(const zbx_load_config_t *config, int client, const char *session,
+		struct zbx_json *json, zbx_uint64_t *seq, char *text)
+{
+	zbx_timespec_t	ts;
+	int		items = config->hosts * config->keys;
+	char		host[MAX_STRING_LEN], key[MAX_STRING_LEN];
+
+	zbx_timespec(&ts);
+	zbx_json_clean(json);
+
+	switch (config->mode)
+	{
+		case LOAD_MODE_SENDER:
+			zbx_json_addstring(json, ZBX_PROTO_TAG_REQUEST, ZBX_PROTO_VALUE_SENDER_DATA,
+					ZBX_JSON_TYPE_STRING);
+			zbx_json_addarray(json, ZBX_PROTO_TAG_DATA);
+			break;
+		case LOAD_MODE_AGENT:
+			zbx_json_addstring(json, ZBX_PROTO_TAG_REQUEST, ZBX_PROTO_VALUE_AGENT_DATA,
+					ZBX_JSON_TYPE_STRING);
+			zbx_json_addstring(json, ZBX_PROTO_TAG_SESSION, session, ZBX_JSON_TYPE_STRING);
+			zbx_json_addarray(json, ZBX_PROTO_TAG_DATA);
+			break;
+		default:
+			zbx_snprintf(host, sizeof(host), "%s%d", config->prefix, client);
+			zbx_json_addstring(json, ZBX_PROTO_TAG_REQUEST, ZBX_PROTO_VALUE_PROXY_DATA,
+					ZBX_JSON_TYPE_STRING);
+			zbx_json_addstring(json, ZBX_PROTO_TAG_HOST, host, ZBX_JSON_TYPE_STRING);
+			zbx_json_addstring(json, ZBX_PROTO_TAG_SESSION, session, ZBX_JSON_TYPE_STRING);
+			zbx_json_addstring(json, ZBX_PROTO_TAG_VERSION, ZABBIX_VERSION, ZBX_JSON_TYPE_STRING);
+			zbx_json_addarray(json, ZBX_PROTO_TAG_HISTORY_DATA);
+	}
+
+	for (int i = 0; i < config->batch; i++, (*seq)++)
+	{
+		int	item = (int)(*seq % (zbx_uint64_t)items);
+
+		zbx_json_addobject(json, NULL);
+
+		if (LOAD_MODE_PROXY == config->mode)
+		{
+			zbx_json_adduint64(json, ZBX_PROTO_TAG_ID, *seq + 1);
+			zbx_json_adduint64(json, ZBX_PROTO_TAG_ITEMID, config->itemid +
+					(zbx_uint64_t)client * (zbx_uint64_t)items + (zbx_uint64_t)item);
+		}
+		else
+		{
+			zbx_snprintf(host, sizeof(host), "%s%d", config->prefix, client * config->hosts +
+					item / config->keys);
+			zbx_snprintf(key, sizeof(key), "load.item[%d]", item % config->keys);
+			zbx_json_addstring(json, ZBX_PROTO_TAG_HOST, host, ZBX_JSON_TYPE_STRING);
+			zbx_json_addstring(json, ZBX_PROTO_TAG_KEY, key, ZBX_JSON_TYPE_STRING);
+
+			if (LOAD_MODE_AGENT == config->mode)
+				zbx_json_adduint64(json, ZBX_PROTO_TAG_ID, *seq + 1);
+		}
+
+		load_add_value(config, json, *seq, text);
+		zbx_json_adduint64(json, ZBX_PROTO_TAG_CLOCK, (zbx_uint64_t)ts.sec);
+		zbx_json_adduint64(json, ZBX_PROTO_TAG_NS, (zbx_uint64_t)ts.ns);
+		zbx_json_close(json);
+	}
+
+	zbx_json_close(json);
+
+	zbx_json_adduint64(json, ZBX_PROTO_TAG_CLOCK, (zbx_uint64_t)ts.sec);
+	zbx_json_adduint64(json, ZBX_PROTO_TAG_NS, (zbx_uint64_t)ts.ns);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: account server response to data request                           *
+ *                                                                            *
+ * Comments: Proxy data responses carry no processing information, all values *
+ *           of successful request are counted as processed then.             *
+ *                                                                            *
+ ******************************************************************************/
+static void	load_check_response(const char *response, int values, zbx_load_counters_t *counters)
+{
+	struct zbx_json_parse	jp;
+	char			value[MAX_STRING_LEN];
+	int			processed, failed;
+
+	if (SUCCEED != zbx_json_open(response, &jp) ||
+			SUCCEED != zbx_json_value_by_name(&jp, ZBX_PROTO_TAG_RESPONSE, value, sizeof(value), NULL) ||
+			0 != strcmp(value, ZBX_PROTO_VALUE_SUCCESS))
+	{
+		counters->errors++;
+		return;
+	}
+
+	if (SUCCEED == zbx_json_value_by_name(&jp, ZBX_PROTO_TAG_INFO, value, sizeof(value), NULL) &&
+			2 == sscanf(value, "processed: %d; failed: %d", &processed, &failed))
+	{
+		counters->processed += (zbx_uint64_t)processed;
+		counters->failed += (zbx_uint64_t)failed;
+	}
+	else
+		counters->processed += (zbx_uint64_t)values;
+}
+
+static void	load_client(const zbx_load_config_t *config, int client, zbx_load_counters_t *counters)
+{
+	struct zbx_json	json;
+	char		*session, *text = NULL;
+	zbx_uint64_t	seq = 0;
+	double		next, end, sent;
+
+	session = zbx_create_token((zbx_uint64_t)client);
+
+	if (LOAD_VALUE_TEXT == config->value_type)
+	{
+		text = (char *)zbx_malloc(NULL, (size_t)config->text_size + 1);
+		memset(text, 'x', (size_t)config->text_size);
+		text[config->text_size] = '\0';
+	}
+
+	zbx_json_init(&json, ZBX_JSON_STAT_BUF_LEN);
+
+	/* spread the first requests of clients over the interval */
+	next = zbx_time() + (double)config->interval_ms * client / config->clients / 1000;
+	end = zbx_time() + config->duration;
+
+	while ((sent = zbx_time()) < end)
+	{
+		char	*response = NULL;
+
+		if (sent < next)
+		{
+			load_sleep(MIN(next, end) - sent);
+			continue;
+		}
+
+		load_build_request(config, client, session, &json, &seq, text);
+
+		sent = zbx_time();
+
+		if (SUCCEED == load_exchange(config, &json, &response))
+		{
+			double	latency = zbx_time() - sent;
+
+			load_check_response(response, config->batch, counters);
+			counters->latency_sum += latency;
+
+			if (latency > counters->latency_max)
+				counters->latency_max = latency;
+
+			zbx_free(response);
+		}
+		else
+			counters->errors++;
+
+		counters->values += (zbx_uint64_t)config->batch;
+		counters->requests++;
+
+		next += (double)config->interval_ms / 1000;
+	}
+
+	zbx_json_free(&json);
+	zbx_free(text);
+	zbx_free(session);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: read server throughput and backlog from zabbix.stats              *
+ *                                                                            *
+ * Return value: SUCCEED - statistics were retrieved                          *
+ *               FAIL    - server did not respond or denied the request       *
+ *                                                                            *
+ ******************************************************************************/
+static int	load_get_server_stats(const zbx_load_config_t *config, zbx_load_server_stats_t *stats)
+{
+	struct zbx_json		json;
+	struct zbx_json_parse	jp, jp_data, jp_obj, jp_busy;
+	char			*response = NULL, buf[MAX_STRING_LEN];
+	int			ret = FAIL;
+
+	memset(stats, 0, sizeof(zbx_load_server_stats_t));
+	zbx_json_init(&json, ZBX_JSON_STAT_BUF_LEN);
+
+	zbx_json_addstring(&json, ZBX_PROTO_TAG_REQUEST, ZBX_PROTO_VALUE_ZABBIX_STATS, ZBX_JSON_TYPE_STRING);
+
+	if (SUCCEED != load_exchange(config, &json, &response) || SUCCEED != zbx_json_open(response, &jp) ||
+			SUCCEED != zbx_json_brackets_by_name(&jp, ZBX_PROTO_TAG_DATA, &jp_data))
+	{
+		goto out;
+	}
+
+	if (SUCCEED == zbx_json_brackets_by_name(&jp_data, "wcache", &jp_obj))
+	{
+		struct zbx_json_parse	jp_cache;
+
+		if (SUCCEED == zbx_json_brackets_by_name(&jp_obj, "values", &jp_cache) &&
+				SUCCEED == zbx_json_value_by_name(&jp_cache, "all", buf, sizeof(buf), NULL))
+		{
+			ZBX_STR2UINT64(stats->synced, buf);
+		}
+
+		if (SUCCEED == zbx_json_brackets_by_name(&jp_obj, "history", &jp_cache) &&
+				SUCCEED == zbx_json_value_by_name(&jp_cache, "pused", buf, sizeof(buf), NULL))
+		{
+			stats->history_pused = atof(buf);
+		}
+	}
+
+	if (SUCCEED == zbx_json_value_by_name(&jp_data, "preprocessing_queue", buf, sizeof(buf), NULL))
+		ZBX_STR2UINT64(stats->preprocessing_queue, buf);
+
+	if (SUCCEED == zbx_json_brackets_by_name(&jp_data, "process", &jp_obj) &&
+			SUCCEED == zbx_json_brackets_by_name(&jp_obj, "history syncer", &jp_busy) &&
+			SUCCEED == zbx_json_brackets_by_name(&jp_busy, "busy", &jp_obj) &&
+			SUCCEED == zbx_json_value_by_name(&jp_obj, "avg", buf, sizeof(buf), NULL))
+	{
+		stats->syncer_busy = atof(buf);
+	}
+
+	zbx_free(response);
+
+	zbx_json_clean(&json);
+	zbx_json_addstring(&json, ZBX_PROTO_TAG_REQUEST, ZBX_PROTO_VALUE_ZABBIX_STATS, ZBX_JSON_TYPE_STRING);
+	zbx_json_addstring(&json, ZBX_PROTO_TAG_TYPE, ZBX_PROTO_VALUE_ZABBIX_STATS_QUEUE, ZBX_JSON_TYPE_STRING);
+	zbx_json_addobject(&json, ZBX_PROTO_TAG_PARAMS);
+	zbx_json_close(&json);
+
+	if (SUCCEED == load_exchange(config, &json, &response) && SUCCEED == zbx_json_open(response, &jp) &&
+			SUCCEED == zbx_json_value_by_name(&jp, ZBX_PROTO_VALUE_ZABBIX_STATS_QUEUE, buf, sizeof(buf),
+			NULL))
+	{
+		ZBX_STR2UINT64(stats->queue, buf);
+	}
+
+	ret = SUCCEED;
+out:
+	zbx_free(response);
+	zbx_json_free(&json);
+
+	return ret;
+}
+
+static void	load_sum_counters(const zbx_load_counters_t *counters, int num, zbx_load_counters_t *sum)
+{
+	memset(sum, 0, sizeof(zbx_load_counters_t));
+
+	for (int i = 0; i < num; i++)
+	{
+		sum->requests += counters[i].requests;
+		sum->values += counters[i].values;
+		sum->processed += counters[i].processed;
+		sum->failed += counters[i].failed;
+		sum->errors += counters[i].errors;
+		sum->latency_sum += counters[i].latency_sum;
+
+		if (counters[i].latency_max > sum->latency_max)
+			sum->latency_max = counters[i].latency_max;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: print one line of throughput report                               *
+ *                                                                            *
+ * Comments: Synced values are counted by history syncers, so the difference  *
+ *           between accepted and synced values is the backlog of values      *
+ *           waiting in preprocessing and history cache, the history syncer   *
+ *           lag is the time needed to sync it at the current sync rate.      *
+ *                                                                            *
+ ******************************************************************************/
+static void	load_report(double elapsed, double period, const zbx_load_counters_t *now,
+		const zbx_load_counters_t *last, const zbx_load_server_stats_t *stats,
+		const zbx_load_server_stats_t *last_stats, zbx_uint64_t synced_start, int stats_ok)
+{
+	zbx_uint64_t	requests = now->requests - last->requests;
+	double		latency = 0 != requests ? (now->latency_sum - last->latency_sum) / requests : 0;
+
+	printf("%8.1f %10.1f %10.1f %8.0f %6.0f %9.2f", elapsed, (double)(now->values - last->values) / period,
+			(double)(now->processed - last->processed) / period, (double)(now->failed - last->failed),
+			(double)(now->errors - last->errors), latency * 1000);
+
+	if (SUCCEED == stats_ok)
+	{
+		double		sync_rate = (double)(stats->synced - last_stats->synced) / period;
+		zbx_uint64_t	backlog = 0, synced = stats->synced - synced_start;
+
+		if (now->processed > synced)
+			backlog = now->processed - synced;
+
+		printf(" %10.1f %9.0f %8.1f %7.2f %8.0f %8.0f %7.2f", sync_rate, (double)backlog,
+				0 < sync_rate ? (double)backlog / sync_rate : 0.0, stats->history_pused,
+				(double)stats->preprocessing_queue, (double)stats->queue, stats->syncer_busy);
+	}
+
+	printf("\n");
+	fflush(stdout);
+}
+
+static void	load_run(const zbx_load_config_t *config)
+{
+	zbx_load_counters_t	*counters, sum, last;
+	zbx_load_server_stats_t	stats, last_stats;
+	zbx_uint64_t		synced_start;
+	pid_t			*pids;
+	size_t			size = sizeof(zbx_load_counters_t) * (size_t)config->clients;
+	double			start, now, last_time;
+	int			stats_ok;
+
+	if (MAP_FAILED == (counters = (zbx_load_counters_t *)mmap(NULL, size, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_ANONYMOUS, -1, 0)))
+	{
+		fprintf(stderr, "cannot allocate shared memory: %s\n", zbx_strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+
+	memset(counters, 0, size);
+
+	if (SUCCEED != (stats_ok = load_get_server_stats(config, &last_stats)))
+		fprintf(stderr, "cannot get server statistics, check StatsAllowedIP\n");
+
+	/* backlog is relative to the synced values counter before the load started */
+	synced_start = last_stats.synced;
+
+	pids = (pid_t *)zbx_malloc(NULL, sizeof(pid_t) * (size_t)config->clients);
+	fflush(stdout);
+
+	for (int i = 0; i < config->clients; i++)
+	{
+		if (-1 == (pids[i] = fork()))
+		{
+			fprintf(stderr, "cannot fork client: %s\n", zbx_strerror(errno));
+			exit(EXIT_FAILURE);
+		}
+
+		if (0 == pids[i])
+		{
+			load_client(config, i, &counters[i]);
+			_exit(EXIT_SUCCESS);
+		}
+	}
+
+	printf("%8s %10s %10s %8s %6s %9s", "time", "sent/s", "accepted/s", "failed", "errors", "rtt ms");
+
+	if (SUCCEED == stats_ok)
+	{
+		printf(" %10s %9s %8s %7s %8s %8s %7s", "synced/s", "backlog", "lag s", "wcache%", "preproc",
+				"queue", "syncer%");
+	}
+
+	printf("\n");
+
+	memset(&last, 0, sizeof(last));
+	start = last_time = zbx_time();
+
+	for (int running = config->clients; 0 != running;)
+	{
+		load_sleep(config->stats_interval);
+
+		while (0 < waitpid(-1, NULL, WNOHANG))
+			running--;
+
+		now = zbx_time();
+		load_sum_counters(counters, config->clients, &sum);
+
+		if (SUCCEED == stats_ok && SUCCEED != load_get_server_stats(config, &stats))
+			stats = last_stats;
+
+		load_report(now - start, now - last_time, &sum, &last, &stats, &last_stats, synced_start, stats_ok);
+
+		last = sum;
+		last_time = now;
+
+		if (SUCCEED == stats_ok)
+			last_stats = stats;
+	}
+
+	now = zbx_time();
+	load_sum_counters(counters, config->clients, &sum);
+
+	printf("\nrequests: " ZBX_FS_UI64 ", values: " ZBX_FS_UI64 ", accepted: " ZBX_FS_UI64 ", failed: "
+			ZBX_FS_UI64 ", errors: " ZBX_FS_UI64 "\n", sum.requests, sum.values, sum.processed,
+			sum.failed, sum.errors);
+	printf("throughput: %.1f values/s, accepted: %.1f values/s, rtt avg: %.2f ms, rtt max: %.2f ms\n",
+			(double)sum.values / (now - start), (double)sum.processed / (now - start),
+			0 != sum.requests ? sum.latency_sum * 1000 / sum.requests : 0.0, sum.latency_max * 1000);
+
+	zbx_free(pids);
+	munmap(counters, size);
+}
+
+static int	load_get_option(int argc, char **argv, int *index, int *value)
+{
+	if (++(*index) >= argc || FAIL == zbx_is_uint31(argv[*index], value) || 0 == *value)
+	{
+		fprintf(stderr, "invalid value of option \"%s\"\n", argv[*index - 1]);
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+static int	load_get_name(int argc, char **argv, int *index, const char **value, const char * const *names,
+		int *num)
+{
+	if (++(*index) >= argc)
+	{
+		fprintf(stderr, "missing value of option \"%s\"\n", argv[*index - 1]);
+		return FAIL;
+	}
+
+	if (NULL == names)
+	{
+		*value = argv[*index];
+		return SUCCEED;
+	}
+
+	for (int i = 0; NULL != names[i]; i++)
+	{
+		if (0 == strcmp(argv[*index], names[i]))
+		{
+			*num = i;
+			return SUCCEED;
+		}
+	}
+
+	fprintf(stderr, "invalid value of option \"%s\"\n", argv[*index - 1]);
+
+	return FAIL;
+}
+
+int	main(int argc, char **argv)
+{
+	const char * const	modes[] = {"sender", "agent", "proxy", NULL};
+	const char * const	types[] = {"float", "uint", "text", NULL};
+	zbx_load_config_t	config = {"127.0.0.1", "load", ZBX_DEFAULT_SERVER_PORT, LOAD_MODE_SENDER, 1, 1, 10, 250,
+						1000, 60, LOAD_VALUE_FLOAT, 64, 5, 1};
+	int			port = ZBX_DEFAULT_SERVER_PORT;
+
+	for (int i = 1; i < argc; i++)
+	{
+		int	ret;
+
+		if (0 == strcmp(argv[i], "-z"))
+			ret = load_get_name(argc, argv, &i, &config.server, NULL, NULL);
+		else if (0 == strcmp(argv[i], "-p"))
+			ret = load_get_option(argc, argv, &i, &port);
+		else if (0 == strcmp(argv[i], "-m"))
+			ret = load_get_name(argc, argv, &i, NULL, modes, &config.mode);
+		else if (0 == strcmp(argv[i], "-c"))
+			ret = load_get_option(argc, argv, &i, &config.clients);
+		else if (0 == strcmp(argv[i], "-H"))
+			ret = load_get_option(argc, argv, &i, &config.hosts);
+		else if (0 == strcmp(argv[i], "-k"))
+			ret = load_get_option(argc, argv, &i, &config.keys);
+		else if (0 == strcmp(argv[i], "-b"))
+			ret = load_get_option(argc, argv, &i, &config.batch);
+		else if (0 == strcmp(argv[i], "-i"))
+			ret = load_get_option(argc, argv, &i, &config.interval_ms);
+		else if (0 == strcmp(argv[i], "-d"))
+			ret = load_get_option(argc, argv, &i, &config.duration);
+		else if (0 == strcmp(argv[i], "-t"))
+			ret = load_get_name(argc, argv, &i, NULL, types, &config.value_type);
+		else if (0 == strcmp(argv[i], "-l"))
+			ret = load_get_option(argc, argv, &i, &config.text_size);
+		else if (0 == strcmp(argv[i], "-n"))
+			ret = load_get_name(argc, argv, &i, &config.prefix, NULL, NULL);
+		else if (0 == strcmp(argv[i], "-S"))
+			ret = load_get_option(argc, argv, &i, &config.stats_interval);
+		else if (0 == strcmp(argv[i], "-I") && i + 1 < argc && SUCCEED == zbx_is_uint64(argv[i + 1],
+				&config.itemid) && 0 != config.itemid)
+		{
+			ret = SUCCEED;
+			i++;
+		}
+		else
+			ret = FAIL;
+
+		if (SUCCEED != ret || USHRT_MAX < port)
+		{
+			fprintf(stderr, "usage: %s %s\n%s\n", argv[0], usage_message[0], help_message[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	config.port = (unsigned short)port;
+
+	printf("%s load of %s:%hu: %d clients, %d values per %d ms each, %d items per client, %s values\n",
+			modes[config.mode], config.server, config.port, config.clients, config.batch,
+			config.interval_ms, config.hosts * config.keys, types[config.value_type]);
+
+	load_run(&config);
+
+	return EXIT_SUCCESS;
+}
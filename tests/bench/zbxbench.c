@@ -0,0 +1,202 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxbench.h"
+
+#include "zbxnum.h"
+#include "zbxtime.h"
+#include "zbxalgo.h"
+
+/* the benchmarked libraries are linked without daemon, these are required by zbxlog and zbxnix */
+const char	title_message[] = "zabbix_bench";
+const char	*usage_message[] = {"[-s samples] [-t sample time ms] [-w warmup samples] [benchmark name filter]...",
+		NULL};
+const char	*help_message[] = {"Run benchmarks with names containing any of the filters, all by default.",
+		NULL};
+const char	*progname = "zabbix_bench";
+const char	syslog_app_name[] = "zabbix_bench";
+
+volatile zbx_uint64_t	zbx_bench_sink;
+
+#define BENCH_SAMPLES_DEFAULT		30
+#define BENCH_WARMUP_DEFAULT		5
+#define BENCH_SAMPLE_MS_DEFAULT		20
+
+static zbx_uint64_t	bench_time_ns(void)
+{
+#if defined(HAVE_TIME_CLOCK_GETTIME)
+	struct timespec	ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (zbx_uint64_t)ts.tv_sec * 1000000000 + (zbx_uint64_t)ts.tv_nsec;
+#else
+	return (zbx_uint64_t)(zbx_time() * 1e9);
+#endif
+}
+
+static zbx_uint64_t	bench_sample_ns(const zbx_bench_case_t *bench, void *data, zbx_uint64_t loops)
+{
+	zbx_uint64_t	start;
+
+	start = bench_time_ns();
+	bench->run(data, loops);
+
+	return bench_time_ns() - start;
+}
+
+static double	bench_percentile(const zbx_vector_dbl_t *values, double percentile)
+{
+	int	index;
+
+	index = (int)ceil(values->values_num * percentile / 100) - 1;
+
+	return values->values[0 > index ? 0 : index];
+}
+
+static int	bench_selected(const char *name, char **filters, int filters_num)
+{
+	if (0 == filters_num)
+		return SUCCEED;
+
+	for (int i = 0; i < filters_num; i++)
+	{
+		if (NULL != strstr(name, filters[i]))
+			return SUCCEED;
+	}
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: run benchmark and print its per operation time distribution       *
+ *                                                                            *
+ * Parameters: bench     - [IN] benchmark to run                              *
+ *             samples   - [IN] number of measured samples                    *
+ *             warmup    - [IN] number of discarded samples                   *
+ *             sample_ns - [IN] minimum duration of one sample                *
+ *                                                                            *
+ * Comments: Number of operations per sample is calibrated first, so that     *
+ *           timer resolution and call overhead do not affect the results.    *
+ *                                                                            *
+ ******************************************************************************/
+static void	bench_run(const zbx_bench_case_t *bench, int samples, int warmup, zbx_uint64_t sample_ns)
+{
+	void			*data = NULL;
+	zbx_uint64_t		loops = 1, ns;
+	zbx_vector_dbl_t	values;
+
+	if (NULL != bench->setup && NULL == (data = bench->setup()))
+	{
+		printf("%-36s skipped\n", bench->name);
+		return;
+	}
+
+	while ((ns = bench_sample_ns(bench, data, loops)) < sample_ns && ZBX_MAX_UINT64 / 2 > loops)
+		loops = (0 == ns || ns * 8 < sample_ns ? loops * 8 : loops * 2);
+
+	for (int i = 0; i < warmup; i++)
+		bench_sample_ns(bench, data, loops);
+
+	zbx_vector_dbl_create(&values);
+	zbx_vector_dbl_reserve(&values, (size_t)samples);
+
+	for (int i = 0; i < samples; i++)
+		zbx_vector_dbl_append(&values, (double)bench_sample_ns(bench, data, loops) / (double)loops);
+
+	zbx_vector_dbl_sort(&values, ZBX_DEFAULT_DBL_COMPARE_FUNC);
+
+	printf("%-36s %12.1f %12.1f %12.1f %12.1f %12.1f %14.0f\n", bench->name, values.values[0],
+			bench_percentile(&values, 50), bench_percentile(&values, 90),
+			bench_percentile(&values, 99), values.values[values.values_num - 1],
+			1e9 / bench_percentile(&values, 50));
+
+	zbx_vector_dbl_destroy(&values);
+
+	if (NULL != bench->cleanup)
+		bench->cleanup(data);
+}
+
+static int	bench_get_option(int argc, char **argv, int *index, int *value)
+{
+	if (++(*index) >= argc || FAIL == zbx_is_uint31(argv[*index], value) || 0 == *value)
+	{
+		fprintf(stderr, "invalid value of option \"%s\"\n", argv[*index - 1]);
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: parse command line and run the selected benchmarks                *
+ *                                                                            *
+ * Parameters: argc  - [IN] number of command line arguments                  *
+ *             argv  - [IN] command line arguments                            *
+ *             cases - [IN] benchmarks, terminated by an entry with NULL name *
+ *                                                                            *
+ * Return value: EXIT_SUCCESS or EXIT_FAILURE on invalid command line         *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_bench_main(int argc, char **argv, const zbx_bench_case_t *cases)
+{
+	int	samples = BENCH_SAMPLES_DEFAULT, warmup = BENCH_WARMUP_DEFAULT, sample_ms = BENCH_SAMPLE_MS_DEFAULT,
+		filters_num = 0, i;
+	char	**filters;
+
+	filters = (char **)zbx_malloc(NULL, sizeof(char *) * (size_t)argc);
+
+	for (i = 1; i < argc; i++)
+	{
+		int	ret = SUCCEED;
+
+		if (0 == strcmp(argv[i], "-s"))
+			ret = bench_get_option(argc, argv, &i, &samples);
+		else if (0 == strcmp(argv[i], "-t"))
+			ret = bench_get_option(argc, argv, &i, &sample_ms);
+		else if (0 == strcmp(argv[i], "-w"))
+			ret = bench_get_option(argc, argv, &i, &warmup);
+		else if ('-' == *argv[i])
+			ret = FAIL;
+		else
+			filters[filters_num++] = argv[i];
+
+		if (SUCCEED != ret)
+		{
+			fprintf(stderr, "usage: %s %s\n%s\n", argv[0], usage_message[0], help_message[0]);
+			zbx_free(filters);
+			return EXIT_FAILURE;
+		}
+	}
+
+	printf("%-36s %12s %12s %12s %12s %12s %14s\n", "benchmark (ns/op)", "min", "p50", "p90", "p99", "max",
+			"ops/s");
+
+	for (; NULL != cases->name; cases++)
+	{
+		if (SUCCEED == bench_selected(cases->name, filters, filters_num))
+			bench_run(cases, samples, warmup, (zbx_uint64_t)sample_ms * 1000000);
+	}
+
+	zbx_free(filters);
+
+	return EXIT_SUCCESS;
+}
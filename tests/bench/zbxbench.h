@@ -0,0 +1,47 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#ifndef ZABBIX_BENCH_H
+#define ZABBIX_BENCH_H
+
+#include "zbxcommon.h"
+
+/* prepares benchmark data, returns NULL when the benchmark cannot be run */
+typedef void	*(*zbx_bench_setup_func_t)(void);
+
+/* runs the benchmarked operation the specified number of times */
+typedef void	(*zbx_bench_run_func_t)(void *data, zbx_uint64_t loops);
+
+typedef void	(*zbx_bench_cleanup_func_t)(void *data);
+
+typedef struct
+{
+	const char			*name;
+	zbx_bench_setup_func_t		setup;
+	zbx_bench_run_func_t		run;
+	zbx_bench_cleanup_func_t	cleanup;
+}
+zbx_bench_case_t;
+
+/* results written here are never optimized away */
+extern volatile zbx_uint64_t	zbx_bench_sink;
+
+int	zbx_bench_main(int argc, char **argv, const zbx_bench_case_t *cases);
+
+#endif	/* ZABBIX_BENCH_H */
@@ -22,14 +22,17 @@ AC_DEFUN([CONF_TESTS],
 	AM_COND_IF([ZBXCMOCKA],[
 		AC_CONFIG_FILES([
 		tests/Makefile
+		tests/bench/Makefile
 		tests/libs/Makefile
 		tests/libs/zbxalgo/Makefile
 		tests/libs/zbxcommon/Makefile
 		tests/libs/zbxcomms/Makefile
 		tests/libs/zbxcommshigh/Makefile
+		tests/libs/zbxcompress/Makefile
 		tests/libs/zbxconf/Makefile
 		tests/libs/zbxdbcache/Makefile
 		tests/libs/zbxdbhigh/Makefile
+		tests/libs/zbxdbwrap/Makefile
 		tests/libs/zbxeval/Makefile
 		tests/libs/zbxhistory/Makefile
 		tests/libs/zbxicmpping/Makefile
@@ -37,7 +40,9 @@ AC_DEFUN([CONF_TESTS],
 		tests/libs/zbxpreproc/Makefile
 		tests/libs/zbxprometheus/Makefile
 		tests/libs/zbxregexp/Makefile
+		tests/libs/zbxserialize/Makefile
 		tests/libs/zbxserver/Makefile
+		tests/libs/zbxshmem/Makefile
 		tests/libs/zbxsysinfo/Makefile
 		tests/libs/zbxsysinfo/common/Makefile
 		tests/libs/zbxtagfilter/Makefile
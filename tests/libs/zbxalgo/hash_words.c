@@ -0,0 +1,219 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxalgo.h"
+
+#define	HASH_TAIL		1
+#define	HASH_LENGTH		2
+#define	HASH_SEED		3
+#define	HASH_DISTRIBUTION	4
+
+static int	get_type(const char *str)
+{
+	if (0 == strcmp(str, "TAIL"))
+		return HASH_TAIL;
+	if (0 == strcmp(str, "LENGTH"))
+		return HASH_LENGTH;
+	if (0 == strcmp(str, "SEED"))
+		return HASH_SEED;
+	if (0 == strcmp(str, "DISTRIBUTION"))
+		return HASH_DISTRIBUTION;
+
+	fail_msg("unknown cmocka step type: %s", str);
+	return FAIL;
+}
+
+/* hash of every prefix must depend only on the prefix bytes, not on their alignment or the bytes following them */
+static void	test_tail(const char *data)
+{
+	size_t		len, data_len;
+	char		*exact, *buffer;
+	zbx_hash_t	hash;
+
+	data_len = strlen(data);
+	buffer = (char *)zbx_malloc(NULL, data_len + 16);
+
+	for (len = 0; len <= data_len; len++)
+	{
+		exact = (char *)zbx_malloc(NULL, len + 1);
+		memcpy(exact, data, len);
+		hash = zbx_hash_words(exact, len, ZBX_DEFAULT_HASH_SEED);
+
+		for (int offset = 0; offset < 8; offset++)
+		{
+			memset(buffer, 0xff, data_len + 16);
+			memcpy(buffer + offset, data, len);
+
+			zbx_mock_assert_uint64_eq("unaligned prefix hash", hash,
+					zbx_hash_words(buffer + offset, len, ZBX_DEFAULT_HASH_SEED));
+
+			memset(buffer + offset + len, 0, 8);
+
+			zbx_mock_assert_uint64_eq("prefix hash with different following bytes", hash,
+					zbx_hash_words(buffer + offset, len, ZBX_DEFAULT_HASH_SEED));
+		}
+
+		zbx_free(exact);
+	}
+
+	zbx_free(buffer);
+}
+
+/* zero padded data must not collide with the data itself, padding fills the last word */
+static void	test_length(const char *data)
+{
+	size_t			len, data_len;
+	char			*buffer;
+	zbx_vector_uint64_t	hashes;
+
+	zbx_vector_uint64_create(&hashes);
+
+	data_len = strlen(data);
+	buffer = (char *)zbx_malloc(NULL, data_len + 17);
+	memset(buffer, 0, data_len + 17);
+	memcpy(buffer, data, data_len);
+
+	for (len = data_len; len <= data_len + 16; len++)
+		zbx_vector_uint64_append(&hashes, zbx_hash_words(buffer, len, ZBX_DEFAULT_HASH_SEED));
+
+	zbx_vector_uint64_sort(&hashes, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_uniq(&hashes, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_mock_assert_int_eq("distinct hashes of zero padded data", 17, hashes.values_num);
+
+	zbx_free(buffer);
+	zbx_vector_uint64_destroy(&hashes);
+}
+
+/* seed is used for chained hashing of composite keys, so it must change the hash */
+static void	test_seed(const char *data)
+{
+	zbx_mock_handle_t	hseeds, hseed;
+	zbx_mock_error_t	err;
+	zbx_vector_uint64_t	hashes;
+	int			seeds_num = 0;
+
+	zbx_vector_uint64_create(&hashes);
+
+	hseeds = zbx_mock_get_parameter_handle("in.seeds");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hseeds, &hseed))))
+	{
+		zbx_uint64_t	seed;
+
+		if (ZBX_MOCK_SUCCESS != (err = zbx_mock_uint64(hseed, &seed)))
+			fail_msg("Cannot read seed: %s", zbx_mock_error_string(err));
+
+		zbx_vector_uint64_append(&hashes, zbx_hash_words(data, strlen(data), (zbx_hash_t)seed));
+		seeds_num++;
+	}
+
+	zbx_vector_uint64_sort(&hashes, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_uniq(&hashes, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_mock_assert_int_eq("distinct hashes with different seeds", seeds_num, hashes.values_num);
+
+	zbx_vector_uint64_destroy(&hashes);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: check distribution of generated keys between hash buckets         *
+ *                                                                            *
+ * Comments: Keys are either identifiers as 8-byte integers or item keys      *
+ *           <prefix><identifier>]. Chi-square statistic divided by the       *
+ *           number of buckets is close to 1 for uniform distribution.        *
+ *                                                                            *
+ ******************************************************************************/
+static void	test_distribution(void)
+{
+	zbx_uint64_t	count, buckets_num, id, step;
+	const char	*prefix;
+	int		*buckets;
+	double		expected, chi2 = 0;
+	char		key[MAX_STRING_LEN];
+
+	count = zbx_mock_get_parameter_uint64("in.count");
+	buckets_num = zbx_mock_get_parameter_uint64("in.buckets");
+	id = zbx_mock_get_parameter_uint64("in.base");
+	step = zbx_mock_get_parameter_uint64("in.step");
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_parameter_exists("in.prefix"))
+		prefix = NULL;
+	else
+		prefix = zbx_mock_get_parameter_string("in.prefix");
+
+	buckets = (int *)zbx_malloc(NULL, sizeof(int) * buckets_num);
+	memset(buckets, 0, sizeof(int) * buckets_num);
+
+	for (zbx_uint64_t i = 0; i < count; i++, id += step)
+	{
+		zbx_hash_t	hash;
+
+		if (NULL == prefix)
+		{
+			hash = ZBX_DEFAULT_UINT64_HASH_ALGO(&id, sizeof(id), ZBX_DEFAULT_HASH_SEED);
+		}
+		else
+		{
+			zbx_snprintf(key, sizeof(key), "%s" ZBX_FS_UI64 "]", prefix, id);
+			hash = ZBX_DEFAULT_STRING_HASH_ALGO(key, strlen(key), ZBX_DEFAULT_HASH_SEED);
+		}
+
+		buckets[hash % buckets_num]++;
+	}
+
+	expected = (double)count / (double)buckets_num;
+
+	for (zbx_uint64_t i = 0; i < buckets_num; i++)
+		chi2 += ((double)buckets[i] - expected) * ((double)buckets[i] - expected) / expected;
+
+	chi2 /= (double)buckets_num;
+
+	if (chi2 > zbx_mock_get_parameter_float("out.max_chi2"))
+		fail_msg("chi-square per bucket %f exceeds %s", chi2, zbx_mock_get_parameter_string("out.max_chi2"));
+
+	zbx_free(buckets);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	ZBX_UNUSED(state);
+
+	switch (get_type(zbx_mock_get_parameter_string("in.type")))
+	{
+		case HASH_TAIL:
+			test_tail(zbx_mock_get_parameter_string("in.data"));
+			break;
+		case HASH_LENGTH:
+			test_length(zbx_mock_get_parameter_string("in.data"));
+			break;
+		case HASH_SEED:
+			test_seed(zbx_mock_get_parameter_string("in.data"));
+			break;
+		case HASH_DISTRIBUTION:
+			test_distribution();
+			break;
+		default:
+			fail_msg("unknown cmocka step type: %s", zbx_mock_get_parameter_string("in.type"));
+	}
+}
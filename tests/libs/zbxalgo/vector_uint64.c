@@ -0,0 +1,152 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxalgo.h"
+
+#define	SORT_UNIQ	1
+#define	SORT_RANDOM	2
+#define	SETDIFF		3
+#define	INTERSECT	4
+#define	UNION		5
+
+static void	mock_read_values(const char *path, zbx_vector_uint64_t *values)
+{
+	zbx_mock_error_t	err;
+	zbx_mock_handle_t	hdata, hvalue;
+
+	hdata = zbx_mock_get_parameter_handle(path);
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hdata, &hvalue))))
+	{
+		zbx_uint64_t	value;
+
+		if (ZBX_MOCK_SUCCESS != (err = zbx_mock_uint64(hvalue, &value)))
+			fail_msg("Cannot read vector member: %s", zbx_mock_error_string(err));
+
+		zbx_vector_uint64_append(values, value);
+	}
+}
+
+static void	mock_assert_values(const zbx_vector_uint64_t *expected, const zbx_vector_uint64_t *returned)
+{
+	int	i;
+
+	zbx_mock_assert_int_eq("values_num", expected->values_num, returned->values_num);
+
+	for (i = 0; i < expected->values_num; i++)
+		zbx_mock_assert_uint64_eq("value", expected->values[i], returned->values[i]);
+}
+
+static int	get_type(const char *str)
+{
+	if (0 == strcmp(str, "SORT_UNIQ"))
+		return SORT_UNIQ;
+	if (0 == strcmp(str, "SORT_RANDOM"))
+		return SORT_RANDOM;
+	if (0 == strcmp(str, "SETDIFF"))
+		return SETDIFF;
+	if (0 == strcmp(str, "INTERSECT"))
+		return INTERSECT;
+	if (0 == strcmp(str, "UNION"))
+		return UNION;
+
+	fail_msg("unknown cmocka step type: %s", str);
+	return FAIL;
+}
+
+/* compare radix sort results with qsort on generated values, large enough to use radix sort */
+static void	test_sort_random(zbx_vector_uint64_t *returned, zbx_vector_uint64_t *expected)
+{
+	zbx_uint64_t	base, value;
+	int		i, count, range;
+
+	count = (int)zbx_mock_get_parameter_uint64("in.count");
+	range = (int)zbx_mock_get_parameter_uint64("in.range");
+	base = zbx_mock_get_parameter_uint64("in.base");
+
+	srand(count);
+
+	for (i = 0; i < count; i++)
+	{
+		value = base + (zbx_uint64_t)(rand() % range);
+		zbx_vector_uint64_append(returned, value);
+		zbx_vector_uint64_append(expected, value);
+	}
+
+	zbx_vector_uint64_sort(expected, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_sort_asc(returned);
+	mock_assert_values(expected, returned);
+
+	zbx_vector_uint64_uniq(expected, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_uniq_asc(returned);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_vector_uint64_t	left, right, expected;
+
+	ZBX_UNUSED(state);
+
+	zbx_vector_uint64_create(&left);
+	zbx_vector_uint64_create(&right);
+	zbx_vector_uint64_create(&expected);
+
+	switch (get_type(zbx_mock_get_parameter_string("in.type")))
+	{
+		case SORT_UNIQ:
+			mock_read_values("in.left", &left);
+			mock_read_values("out.values", &expected);
+			zbx_vector_uint64_sort_uniq(&left);
+			break;
+		case SORT_RANDOM:
+			test_sort_random(&left, &expected);
+			break;
+		case SETDIFF:
+			mock_read_values("in.left", &left);
+			mock_read_values("in.right", &right);
+			mock_read_values("out.values", &expected);
+			zbx_vector_uint64_setdiff_asc(&left, &right);
+			break;
+		case INTERSECT:
+			mock_read_values("in.left", &left);
+			mock_read_values("in.right", &right);
+			mock_read_values("out.values", &expected);
+			zbx_vector_uint64_intersect_asc(&left, &right);
+			break;
+		case UNION:
+			mock_read_values("in.left", &left);
+			mock_read_values("in.right", &right);
+			mock_read_values("out.values", &expected);
+			zbx_vector_uint64_union_asc(&left, &right);
+			break;
+		default:
+			fail_msg("unknown cmocka step type: %s", zbx_mock_get_parameter_string("in.type"));
+	}
+
+	mock_assert_values(&expected, &left);
+
+	zbx_vector_uint64_destroy(&expected);
+	zbx_vector_uint64_destroy(&right);
+	zbx_vector_uint64_destroy(&left);
+}
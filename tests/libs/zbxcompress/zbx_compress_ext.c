@@ -0,0 +1,278 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxcompress.h"
+#include "zbxstr.h"
+
+#define	COMPRESS_ROUNDTRIP	1
+#define	COMPRESS_CORRUPTED	2
+#define	COMPRESS_SELECT		3
+#define	COMPRESS_UNSUPPORTED	4
+
+static int	get_type(const char *str)
+{
+	if (0 == strcmp(str, "ROUNDTRIP"))
+		return COMPRESS_ROUNDTRIP;
+	if (0 == strcmp(str, "CORRUPTED"))
+		return COMPRESS_CORRUPTED;
+	if (0 == strcmp(str, "SELECT"))
+		return COMPRESS_SELECT;
+	if (0 == strcmp(str, "UNSUPPORTED"))
+		return COMPRESS_UNSUPPORTED;
+
+	fail_msg("unknown cmocka step type: %s", str);
+	return FAIL;
+}
+
+static unsigned char	get_codec(const char *str)
+{
+	if (0 == strcmp(str, ZBX_COMPRESS_NAME_ZLIB))
+		return ZBX_COMPRESS_ZLIB;
+	if (0 == strcmp(str, ZBX_COMPRESS_NAME_ZSTD))
+		return ZBX_COMPRESS_ZSTD;
+	if (0 == strcmp(str, ZBX_COMPRESS_NAME_LZ4))
+		return ZBX_COMPRESS_LZ4;
+
+	fail_msg("unknown compression codec: %s", str);
+	return ZBX_COMPRESS_ZLIB;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get test data, repeated the specified number of times             *
+ *                                                                            *
+ ******************************************************************************/
+static char	*get_data(size_t *size)
+{
+	const char	*data;
+	char		*buf = NULL;
+	size_t		buf_alloc = 0, buf_offset = 0;
+	zbx_uint64_t	repeat = 1;
+
+	data = zbx_mock_get_parameter_string("in.data");
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("in.repeat"))
+		repeat = zbx_mock_get_parameter_uint64("in.repeat");
+
+	zbx_strcpy_alloc(&buf, &buf_alloc, &buf_offset, "");
+
+	for (zbx_uint64_t i = 0; i < repeat; i++)
+		zbx_strcpy_alloc(&buf, &buf_alloc, &buf_offset, data);
+
+	*size = buf_offset;
+
+	return buf;
+}
+
+/* data must be restored by uncompression, also when the output buffer has exactly the data size as in protocol */
+static void	test_roundtrip(unsigned char codec)
+{
+	char	*data, *compressed, *out;
+	size_t	size, compressed_size, out_size;
+
+	data = get_data(&size);
+
+	if (SUCCEED != zbx_compress_ext(codec, data, size, &compressed, &compressed_size))
+		fail_msg("cannot compress data: %s", zbx_compress_strerror());
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("out.max_ratio") &&
+			(double)compressed_size > (double)size * zbx_mock_get_parameter_float("out.max_ratio"))
+	{
+		fail_msg("compressed size " ZBX_FS_SIZE_T " of " ZBX_FS_SIZE_T " bytes exceeds expected ratio %s",
+				(zbx_fs_size_t)compressed_size, (zbx_fs_size_t)size,
+				zbx_mock_get_parameter_string("out.max_ratio"));
+	}
+
+	out = (char *)zbx_malloc(NULL, size + 1);
+	out_size = size;
+
+	if (SUCCEED != zbx_uncompress_ext(codec, compressed, compressed_size, out, &out_size))
+		fail_msg("cannot uncompress data: %s", zbx_compress_strerror());
+
+	zbx_mock_assert_uint64_eq("uncompressed size", size, out_size);
+
+	if (0 != memcmp(data, out, size))
+		fail_msg("uncompressed data differs from original data");
+
+	zbx_free(out);
+
+	/* data must not be written beyond too small output buffer, receiver detects incomplete data by size */
+	if (0 != size)
+	{
+		out_size = size - 1;
+		out = (char *)zbx_malloc(NULL, MAX(out_size, 1));
+
+		if (SUCCEED == zbx_uncompress_ext(codec, compressed, compressed_size, out, &out_size) &&
+				out_size == size)
+		{
+			fail_msg("uncompressed data into too small buffer");
+		}
+
+		zbx_free(out);
+	}
+
+	zbx_free(compressed);
+	zbx_free(data);
+}
+
+static void	test_corrupted(unsigned char codec)
+{
+	char	*data, *compressed, *out;
+	size_t	size, compressed_size, out_size;
+
+	data = get_data(&size);
+
+	if (SUCCEED != zbx_compress_ext(codec, data, size, &compressed, &compressed_size))
+		fail_msg("cannot compress data: %s", zbx_compress_strerror());
+
+	out = (char *)zbx_malloc(NULL, size + 1);
+
+	/* truncated data */
+	out_size = size;
+
+	if (SUCCEED == zbx_uncompress_ext(codec, compressed, compressed_size / 2, out, &out_size))
+		fail_msg("uncompressed truncated data");
+
+	/* data of other codec */
+	for (unsigned char other = ZBX_COMPRESS_ZLIB; other <= ZBX_COMPRESS_LZ4; other++)
+	{
+		if (other == codec || SUCCEED != zbx_compress_codec_supported(other))
+			continue;
+
+		out_size = size;
+
+		if (SUCCEED == zbx_uncompress_ext(other, compressed, compressed_size, out, &out_size) &&
+				out_size == size && 0 == memcmp(data, out, size))
+		{
+			fail_msg("%s data was uncompressed by %s codec", zbx_compress_codec_name(codec),
+					zbx_compress_codec_name(other));
+		}
+	}
+
+	zbx_free(out);
+	zbx_free(compressed);
+	zbx_free(data);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: check codec selected from codecs supported by peer                *
+ *                                                                            *
+ * Comments: The expected codec is the first codec of out.preferred list      *
+ *           supported by this build, or zlib when none is supported.         *
+ *                                                                            *
+ ******************************************************************************/
+static void	test_select(void)
+{
+	zbx_mock_handle_t	hpreferred, hcodec;
+	zbx_mock_error_t	err;
+	const char		*codecs = NULL, *name;
+	unsigned char		expected = ZBX_COMPRESS_ZLIB;
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("in.codecs"))
+		codecs = zbx_mock_get_parameter_string("in.codecs");
+
+	hpreferred = zbx_mock_get_parameter_handle("out.preferred");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hpreferred, &hcodec))))
+	{
+		unsigned char	codec;
+
+		if (ZBX_MOCK_SUCCESS != err || ZBX_MOCK_SUCCESS != (err = zbx_mock_string(hcodec, &name)))
+			fail_msg("Cannot read codec: %s", zbx_mock_error_string(err));
+
+		if (SUCCEED == zbx_compress_codec_supported(codec = get_codec(name)))
+		{
+			expected = codec;
+			break;
+		}
+	}
+
+	zbx_mock_assert_str_eq("selected codec", zbx_compress_codec_name(expected),
+			zbx_compress_codec_name(zbx_compress_select_codec(codecs)));
+}
+
+static void	test_unsupported(void)
+{
+	char	*compressed = NULL, out[16];
+	size_t	compressed_size, out_size = sizeof(out);
+
+	if (SUCCEED == zbx_compress_ext(UCHAR_MAX, "data", 4, &compressed, &compressed_size))
+		fail_msg("compressed data with unknown codec");
+
+	zbx_mock_assert_str_eq("compression error", zbx_mock_get_parameter_string("out.error"),
+			zbx_compress_strerror());
+
+	if (SUCCEED == zbx_uncompress_ext(UCHAR_MAX, "data", 4, out, &out_size))
+		fail_msg("uncompressed data with unknown codec");
+
+	zbx_mock_assert_str_eq("uncompression error", zbx_mock_get_parameter_string("out.error"),
+			zbx_compress_strerror());
+
+	/* codecs listed for peers must be supported by this build */
+	for (unsigned char codec = ZBX_COMPRESS_ZSTD; codec <= ZBX_COMPRESS_LZ4; codec++)
+	{
+		int	listed;
+
+		listed = zbx_str_in_list(zbx_compress_codecs(), zbx_compress_codec_name(codec), ',');
+		zbx_mock_assert_result_eq("listed codec", zbx_compress_codec_supported(codec), listed);
+	}
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	int		type;
+	unsigned char	codec = ZBX_COMPRESS_ZLIB;
+
+	ZBX_UNUSED(state);
+
+	type = get_type(zbx_mock_get_parameter_string("in.type"));
+
+	if (COMPRESS_ROUNDTRIP == type || COMPRESS_CORRUPTED == type)
+	{
+		codec = get_codec(zbx_mock_get_parameter_string("in.codec"));
+
+		/* optional codecs are tested only if the build supports them */
+		if (SUCCEED != zbx_compress_codec_supported(codec))
+			skip();
+	}
+
+	switch (type)
+	{
+		case COMPRESS_ROUNDTRIP:
+			test_roundtrip(codec);
+			break;
+		case COMPRESS_CORRUPTED:
+			test_corrupted(codec);
+			break;
+		case COMPRESS_SELECT:
+			test_select();
+			break;
+		case COMPRESS_UNSUPPORTED:
+			test_unsupported();
+			break;
+		default:
+			fail_msg("unknown cmocka step type: %s", zbx_mock_get_parameter_string("in.type"));
+	}
+}
@@ -40,7 +40,7 @@ int	zbx_vc_get_cached_values(zbx_uint64_t itemid, unsigned char value_type, zbx_
 	for (chunk = item->tail; NULL != chunk; chunk = chunk->next)
 	{
 		for (i = chunk->first_value; i <= chunk->last_value; i++)
-			vc_history_record_vector_append(values, value_type, &chunk->slots[i]);
+			vc_history_record_vector_append(values, value_type, &vch_chunk_slots(chunk)[i]);
 	}
 
 	return SUCCEED;
@@ -51,6 +51,7 @@ int	zbx_vc_precache_values(zbx_uint64_t itemid, int value_type, int seconds, int
 	zbx_vc_item_t			*item;
 	int				ret;
 	zbx_vector_history_record_t	values;
+	zbx_vc_values_sink_t		sink = {.values = &values, .value_type = value_type};
 
 	/* add item to cache if necessary */
 	if (NULL == (item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid)))
@@ -62,7 +63,7 @@ int	zbx_vc_precache_values(zbx_uint64_t itemid, int value_type, int seconds, int
 	/* perform request to cache values */
 	zbx_history_record_vector_create(&values);
 	RDLOCK_CACHE;
-	ret = vch_item_get_values(item, &values, seconds, count, ts);
+	ret = vch_item_process_values(item, &sink, seconds, count, ts);
 	UNLOCK_CACHE;
 	zbx_vc_flush_stats();
 	zbx_history_record_vector_destroy(&values, value_type);
@@ -93,6 +94,25 @@ int	zbx_vc_get_item_state(zbx_uint64_t itemid, int *status, int *active_range, i
 	return ret;
 }
 
+int	zbx_vc_get_item_compressed_chunks(zbx_uint64_t itemid, int *chunks_num)
+{
+	zbx_vc_item_t	*item;
+	zbx_vc_chunk_t	*chunk;
+
+	if (NULL == (item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid)))
+		return FAIL;
+
+	*chunks_num = 0;
+
+	for (chunk = item->tail; NULL != chunk; chunk = chunk->next)
+	{
+		if (0 != chunk->compressed_size)
+			(*chunks_num)++;
+	}
+
+	return SUCCEED;
+}
+
 int	zbx_vc_get_cache_state(int *mode, zbx_uint64_t *hits, zbx_uint64_t *misses)
 {
 	if (NULL == vc_cache)
@@ -112,7 +112,7 @@ void	zbx_vc_common_test_func(
 	while (ZBX_MOCK_END_OF_VECTOR != (mock_err = (zbx_mock_vector_element(hitems, &hitem))))
 	{
 		int			item_status, item_active_range, item_db_cached_from, item_values_total;
-		zbx_mock_handle_t	hstatus;
+		zbx_mock_handle_t	hstatus, hchunks;
 
 		if (ZBX_MOCK_NOT_A_VECTOR == mock_err)
 			fail_msg("out.cache.items parameter is not a vector");
@@ -150,6 +150,19 @@ void	zbx_vc_common_test_func(
 
 			zbx_mock_assert_time_eq("item.db_cached_from", ts.sec, item_db_cached_from);
 
+			/* optional number of compressed item data chunks */
+			if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hitem, "compressed_chunks", &hchunks))
+			{
+				int	chunks_num;
+
+				if (ZBX_MOCK_SUCCESS != (mock_err = zbx_mock_string(hchunks, &data)))
+					fail_msg("Cannot read compressed chunks: %s", zbx_mock_error_string(mock_err));
+
+				zbx_mock_assert_result_eq("zbx_vc_get_item_compressed_chunks() return value", SUCCEED,
+						zbx_vc_get_item_compressed_chunks(itemid, &chunks_num));
+				zbx_mock_assert_int_eq("item.compressed_chunks", atoi(data), chunks_num);
+			}
+
 			value_type = zbx_mock_str_to_value_type(zbx_mock_get_object_member_string(hitem, "value type"));
 
 			zbx_vcmock_read_values(zbx_mock_get_object_member_handle(hitem, "data"), value_type, &expected);
@@ -0,0 +1,216 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+#include "zbxmockdb.h"
+
+#include "zbxnum.h"
+#include "zbxdbhigh.h"
+
+#if defined(HAVE_POSTGRESQL)
+
+/* binary COPY signature, flags and header extension length */
+#define COPY_HEADER		"5047434f50590aff0d0a00" "00000000" "00000000"
+#define COPY_TRAILER		"ffff"
+
+static void	mock_read_value(const zbx_db_field_t *field, const char *str, zbx_db_value_t *value)
+{
+	switch (field->type)
+	{
+		case ZBX_TYPE_INT:
+			value->i32 = atoi(str);
+			break;
+		case ZBX_TYPE_FLOAT:
+			value->dbl = atof(str);
+			break;
+		case ZBX_TYPE_UINT:
+		case ZBX_TYPE_ID:
+			if (SUCCEED != zbx_is_uint64(str, &value->ui64))
+				fail_msg("invalid value \"%s\" of field \"%s\"", str, field->name);
+			break;
+		default:
+			value->str = (char *)str;
+	}
+}
+
+static void	mock_read_rows(zbx_db_insert_t *db_insert, const zbx_db_field_t **fields, int fields_num)
+{
+	zbx_mock_handle_t	hrows, hrow, hvalue;
+	zbx_mock_error_t	err;
+	zbx_db_value_t		values[ZBX_MAX_FIELDS], *pvalues[ZBX_MAX_FIELDS];
+
+	for (int i = 0; i < fields_num; i++)
+		pvalues[i] = &values[i];
+
+	hrows = zbx_mock_get_parameter_handle("in.rows");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hrows, &hrow))))
+	{
+		const char	*str;
+		int		values_num = 0;
+
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("Cannot read row: %s", zbx_mock_error_string(err));
+
+		while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hrow, &hvalue))))
+		{
+			if (ZBX_MOCK_SUCCESS != err || ZBX_MOCK_SUCCESS != (err = zbx_mock_string(hvalue, &str)))
+				fail_msg("Cannot read row value: %s", zbx_mock_error_string(err));
+
+			if (values_num == fields_num)
+				fail_msg("too many values in row");
+
+			mock_read_value(fields[values_num], str, &values[values_num]);
+			values_num++;
+		}
+
+		zbx_mock_assert_int_eq("row values", fields_num, values_num);
+		zbx_db_insert_add_values_dyn(db_insert, pvalues, values_num);
+	}
+}
+
+static char	*mock_bin2hex(const char *data, size_t data_len)
+{
+	char	*hex = NULL;
+	size_t	hex_alloc = 0, hex_offset = 0;
+
+	zbx_strcpy_alloc(&hex, &hex_alloc, &hex_offset, "");
+
+	for (size_t i = 0; i < data_len; i++)
+		zbx_snprintf_alloc(&hex, &hex_alloc, &hex_offset, "%02x", (unsigned char)data[i]);
+
+	return hex;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get expected COPY data from row tuples in hexadecimal format      *
+ *                                                                            *
+ * Comments: Tuples can be split by spaces for readability, the spaces are    *
+ *           removed.                                                         *
+ *                                                                            *
+ ******************************************************************************/
+static char	*mock_get_expected_data(void)
+{
+	zbx_mock_handle_t	htuples, htuple;
+	zbx_mock_error_t	err;
+	char			*hex = NULL;
+	size_t			hex_alloc = 0, hex_offset = 0;
+
+	zbx_strcpy_alloc(&hex, &hex_alloc, &hex_offset, COPY_HEADER);
+
+	htuples = zbx_mock_get_parameter_handle("out.tuples");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(htuples, &htuple))))
+	{
+		const char	*tuple;
+
+		if (ZBX_MOCK_SUCCESS != err || ZBX_MOCK_SUCCESS != (err = zbx_mock_string(htuple, &tuple)))
+			fail_msg("Cannot read tuple: %s", zbx_mock_error_string(err));
+
+		for (; '\0' != *tuple; tuple++)
+		{
+			if (' ' != *tuple)
+				zbx_chrcpy_alloc(&hex, &hex_alloc, &hex_offset, *tuple);
+		}
+	}
+
+	zbx_strcpy_alloc(&hex, &hex_alloc, &hex_offset, COPY_TRAILER);
+
+	return hex;
+}
+
+static void	test_insert_copy(void)
+{
+	zbx_db_insert_t		db_insert;
+	const zbx_db_table_t	*table;
+	const zbx_db_field_t	*fields[ZBX_MAX_FIELDS];
+	zbx_mock_handle_t	hfields, hfield;
+	zbx_mock_error_t	err;
+	const char		*table_name, *sql, *data;
+	char			*returned, *expected;
+	size_t			data_len;
+	int			fields_num = 0;
+
+	table_name = zbx_mock_get_parameter_string("in.table");
+
+	if (NULL == (table = zbx_db_get_table(table_name)))
+		fail_msg("unknown table \"%s\"", table_name);
+
+	hfields = zbx_mock_get_parameter_handle("in.fields");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hfields, &hfield))))
+	{
+		const char	*field_name;
+
+		if (ZBX_MOCK_SUCCESS != err || ZBX_MOCK_SUCCESS != (err = zbx_mock_string(hfield, &field_name)))
+			fail_msg("Cannot read field: %s", zbx_mock_error_string(err));
+
+		if (NULL == (fields[fields_num++] = zbx_db_get_field(table, field_name)))
+			fail_msg("unknown field \"%s\" of table \"%s\"", field_name, table_name);
+	}
+
+	zbx_db_insert_prepare_dyn(&db_insert, table, fields, fields_num);
+	zbx_db_insert_use_copy(&db_insert);
+	mock_read_rows(&db_insert, fields, fields_num);
+
+	zbx_mock_assert_result_eq("zbx_db_insert_execute() return value", SUCCEED, zbx_db_insert_execute(&db_insert));
+	zbx_db_insert_clean(&db_insert);
+
+	sql = zbx_mockdb_get_copy(&data, &data_len);
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_parameter_exists("out.sql"))
+	{
+		if (NULL != sql)
+			fail_msg("unexpected COPY statement: %s", sql);
+
+		return;
+	}
+
+	if (NULL == sql)
+		fail_msg("COPY statement was not executed");
+
+	zbx_mock_assert_str_eq("COPY statement", zbx_mock_get_parameter_string("out.sql"), sql);
+
+	returned = mock_bin2hex(data, data_len);
+	expected = mock_get_expected_data();
+
+	zbx_mock_assert_str_eq("COPY data", expected, returned);
+
+	zbx_free(expected);
+	zbx_free(returned);
+}
+
+#endif
+
+void	zbx_mock_test_entry(void **state)
+{
+	ZBX_UNUSED(state);
+
+#if defined(HAVE_POSTGRESQL)
+	zbx_mockdb_init();
+	test_insert_copy();
+	zbx_mockdb_destroy();
+#else
+	skip();
+#endif
+}
@@ -0,0 +1,278 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "../../../src/libs/zbxdbwrap/history_binary.h"
+#include "zbxcrypto.h"
+#include "zbxstr.h"
+#include "zbx_item_constants.h"
+
+static zbx_uint64_t	mock_get_member_uint64(zbx_mock_handle_t hobject, const char *name, zbx_uint64_t def)
+{
+	zbx_mock_handle_t	hmember;
+	zbx_uint64_t		value;
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_object_member(hobject, name, &hmember))
+		return def;
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_uint64(hmember, &value))
+		fail_msg("invalid record field \"%s\"", name);
+
+	return value;
+}
+
+static int	mock_get_member_int(zbx_mock_handle_t hobject, const char *name)
+{
+	zbx_mock_handle_t	hmember;
+	int			value;
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_object_member(hobject, name, &hmember))
+		return 0;
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_int(hmember, &value))
+		fail_msg("invalid record field \"%s\"", name);
+
+	return value;
+}
+
+static const char	*mock_get_member_str(zbx_mock_handle_t hobject, const char *name)
+{
+	zbx_mock_handle_t	hmember;
+	const char		*value;
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_object_member(hobject, name, &hmember))
+		return NULL;
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_string(hmember, &value))
+		fail_msg("invalid record field \"%s\"", name);
+
+	return value;
+}
+
+static void	mock_write_records(zbx_history_binary_writer_t *writer)
+{
+	zbx_mock_handle_t		hrecords, hrecord;
+	zbx_proxy_history_data_t	*hds = NULL;
+	unsigned char			*value_types = NULL, value_type;
+	char				*buffer = NULL;
+	size_t				buffer_alloc = 0, buffer_offset = 0;
+	const char			*str;
+	int				i, records_num = 0;
+
+	hrecords = zbx_mock_get_parameter_handle("in.records");
+
+	/* string values are stored in a shared buffer referenced by offsets, as in proxy history cache */
+	while (ZBX_MOCK_END_OF_VECTOR != zbx_mock_vector_element(hrecords, &hrecord))
+	{
+		zbx_proxy_history_data_t	*hd;
+
+		hds = (zbx_proxy_history_data_t *)zbx_realloc(hds, sizeof(zbx_proxy_history_data_t) *
+				(size_t)(records_num + 1));
+		value_types = (unsigned char *)zbx_realloc(value_types, (size_t)(records_num + 1));
+
+		hd = &hds[records_num];
+		memset(hd, 0, sizeof(zbx_proxy_history_data_t));
+
+		hd->id = mock_get_member_uint64(hrecord, "id", 0);
+		hd->itemid = mock_get_member_uint64(hrecord, "itemid", 0);
+		hd->clock = mock_get_member_int(hrecord, "clock");
+		hd->ns = mock_get_member_int(hrecord, "ns");
+		hd->state = (unsigned char)mock_get_member_int(hrecord, "state");
+		hd->timestamp = mock_get_member_int(hrecord, "timestamp");
+		hd->severity = mock_get_member_int(hrecord, "severity");
+		hd->logeventid = mock_get_member_int(hrecord, "logeventid");
+		hd->lastlogsize = mock_get_member_uint64(hrecord, "lastlogsize", 0);
+		hd->mtime = mock_get_member_int(hrecord, "mtime");
+
+		if (0 != mock_get_member_int(hrecord, "meta"))
+			hd->flags |= ZBX_PROXY_HISTORY_FLAG_META;
+
+		if (NULL != (str = mock_get_member_str(hrecord, "value_type")))
+			value_type = zbx_mock_str_to_value_type(str);
+		else
+			value_type = ITEM_VALUE_TYPE_STR;
+
+		value_types[records_num] = value_type;
+
+		if (NULL != (str = mock_get_member_str(hrecord, "value")))
+		{
+			hd->value_offset = buffer_offset;
+			zbx_str_memcpy_alloc(&buffer, &buffer_alloc, &buffer_offset, str, strlen(str) + 1);
+
+			if (NULL == (str = mock_get_member_str(hrecord, "source")))
+				str = "";
+
+			hd->source_offset = buffer_offset;
+			zbx_str_memcpy_alloc(&buffer, &buffer_alloc, &buffer_offset, str, strlen(str) + 1);
+		}
+		else
+			hd->flags |= ZBX_PROXY_HISTORY_FLAG_NOVALUE;
+
+		records_num++;
+	}
+
+	for (i = 0; i < records_num; i++)
+		zbx_history_binary_writer_add(writer, &hds[i], buffer, value_types[i]);
+
+	zbx_free(value_types);
+	zbx_free(hds);
+	zbx_free(buffer);
+}
+
+static void	mock_assert_record(zbx_mock_handle_t hrecord, zbx_uint64_t itemid, const zbx_agent_value_t *av)
+{
+	const char	*str;
+
+	zbx_mock_assert_uint64_eq("id", mock_get_member_uint64(hrecord, "id", 0), av->id);
+	zbx_mock_assert_uint64_eq("itemid", mock_get_member_uint64(hrecord, "itemid", 0), itemid);
+	zbx_mock_assert_int_eq("clock", mock_get_member_int(hrecord, "clock"), av->ts.sec);
+	zbx_mock_assert_int_eq("ns", mock_get_member_int(hrecord, "ns"), av->ts.ns);
+	zbx_mock_assert_int_eq("state", mock_get_member_int(hrecord, "state"), av->state);
+	zbx_mock_assert_int_eq("timestamp", mock_get_member_int(hrecord, "timestamp"), av->timestamp);
+	zbx_mock_assert_int_eq("severity", mock_get_member_int(hrecord, "severity"), av->severity);
+	zbx_mock_assert_int_eq("logeventid", mock_get_member_int(hrecord, "logeventid"), av->logeventid);
+	zbx_mock_assert_int_eq("meta", mock_get_member_int(hrecord, "meta"), av->meta);
+	zbx_mock_assert_uint64_eq("lastlogsize", mock_get_member_uint64(hrecord, "lastlogsize", 0),
+			av->lastlogsize);
+	zbx_mock_assert_int_eq("mtime", mock_get_member_int(hrecord, "mtime"), av->mtime);
+
+	if (NULL != (str = mock_get_member_str(hrecord, "value")))
+	{
+		zbx_mock_assert_ptr_ne("value", NULL, av->value);
+		zbx_mock_assert_str_eq("value", str, av->value);
+	}
+	else
+		zbx_mock_assert_ptr_eq("value", NULL, av->value);
+
+	if (NULL != (str = mock_get_member_str(hrecord, "source")))
+	{
+		zbx_mock_assert_ptr_ne("source", NULL, av->source);
+		zbx_mock_assert_str_eq("source", str, av->source);
+	}
+	else
+		zbx_mock_assert_ptr_eq("source", NULL, av->source);
+}
+
+/* write records from test input and check that the reader returns the expected records */
+static void	test_round_trip(void)
+{
+	zbx_history_binary_writer_t	writer;
+	zbx_history_binary_reader_t	reader;
+	struct zbx_json			j;
+	struct zbx_json_parse		jp;
+	zbx_mock_handle_t		hrecords, hrecord;
+	zbx_arena_t			arena;
+	zbx_agent_value_t		av;
+	zbx_uint64_t			itemid;
+	char				*error = NULL;
+
+	zbx_history_binary_writer_init(&writer);
+	mock_write_records(&writer);
+
+	zbx_json_init(&j, ZBX_JSON_STAT_BUF_LEN);
+	zbx_history_binary_writer_flush(&writer, &j);
+	zbx_history_binary_writer_destroy(&writer);
+
+	if (SUCCEED != zbx_json_open(j.buffer, &jp))
+		fail_msg("cannot open output json: %s", zbx_json_strerror());
+
+	if (SUCCEED != zbx_history_binary_reader_open(&reader, &jp, &error))
+		fail_msg("cannot open binary history data: %s", error);
+
+	zbx_arena_create(&arena, ZBX_KIBIBYTE);
+
+	hrecords = zbx_mock_get_parameter_handle("out.records");
+
+	while (ZBX_MOCK_END_OF_VECTOR != zbx_mock_vector_element(hrecords, &hrecord))
+	{
+		if (SUCCEED != zbx_history_binary_reader_next(&reader, &itemid, &arena, &av, &error))
+			fail_msg("cannot read binary history data record: %s", error);
+
+		mock_assert_record(hrecord, itemid, &av);
+	}
+
+	/* all records must be consumed */
+	zbx_mock_assert_result_eq("reading past the last record", FAIL,
+			zbx_history_binary_reader_next(&reader, &itemid, &arena, &av, &error));
+
+	zbx_free(error);
+	zbx_arena_destroy(&arena);
+	zbx_history_binary_reader_close(&reader);
+	zbx_json_free(&j);
+}
+
+/* open raw binary block from test input and check that malformed data is rejected */
+static void	test_read_block(void)
+{
+	zbx_history_binary_reader_t	reader;
+	struct zbx_json			j;
+	struct zbx_json_parse		jp;
+	zbx_arena_t			arena;
+	zbx_agent_value_t		av;
+	zbx_uint64_t			itemid;
+	const char			*data;
+	char				*b64 = NULL, *error = NULL;
+	size_t				data_len;
+	int				ret;
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_binary(zbx_mock_get_parameter_handle("in.data"), &data, &data_len))
+		fail_msg("invalid binary parameter \"in.data\"");
+
+	zbx_base64_encode_dyn(data, &b64, (int)data_len);
+
+	zbx_json_init(&j, ZBX_JSON_STAT_BUF_LEN);
+	zbx_json_addstring(&j, ZBX_PROTO_TAG_HISTORY_DATA_BINARY, b64, ZBX_JSON_TYPE_STRING);
+	zbx_free(b64);
+
+	if (SUCCEED != zbx_json_open(j.buffer, &jp))
+		fail_msg("cannot open input json: %s", zbx_json_strerror());
+
+	ret = zbx_history_binary_reader_open(&reader, &jp, &error);
+	zbx_mock_assert_result_eq("zbx_history_binary_reader_open()",
+			zbx_mock_str_to_return_code(zbx_mock_get_parameter_string("out.open")), ret);
+
+	if (SUCCEED == ret)
+	{
+		zbx_arena_create(&arena, ZBX_KIBIBYTE);
+
+		ret = zbx_history_binary_reader_next(&reader, &itemid, &arena, &av, &error);
+		zbx_mock_assert_result_eq("zbx_history_binary_reader_next()",
+				zbx_mock_str_to_return_code(zbx_mock_get_parameter_string("out.next")), ret);
+
+		zbx_arena_destroy(&arena);
+		zbx_history_binary_reader_close(&reader);
+	}
+
+	zbx_free(error);
+	zbx_json_free(&j);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	ZBX_UNUSED(state);
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("in.records"))
+		test_round_trip();
+	else
+		test_read_block();
+}
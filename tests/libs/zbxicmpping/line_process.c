@@ -125,6 +125,7 @@ void	zbx_mock_test_entry(void **state)
 #ifdef HAVE_IPV6
 		NULL,
 #endif
+		NULL,
 		NULL};
 
 	ZBX_UNUSED(state);
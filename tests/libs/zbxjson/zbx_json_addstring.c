@@ -0,0 +1,152 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxjson.h"
+
+#define	JSON_ESCAPE	1
+#define	JSON_POSITION	2
+
+static int	get_type(const char *str)
+{
+	if (0 == strcmp(str, "ESCAPE"))
+		return JSON_ESCAPE;
+	if (0 == strcmp(str, "POSITION"))
+		return JSON_POSITION;
+
+	fail_msg("unknown cmocka step type: %s", str);
+	return FAIL;
+}
+
+static zbx_json_type_t	get_json_type(const char *str)
+{
+	if (0 == strcmp(str, "ZBX_JSON_TYPE_STRING"))
+		return ZBX_JSON_TYPE_STRING;
+	if (0 == strcmp(str, "ZBX_JSON_TYPE_INT"))
+		return ZBX_JSON_TYPE_INT;
+
+	fail_msg("unknown json type: %s", str);
+	return ZBX_JSON_TYPE_UNKNOWN;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: add string value to JSON object and check the resulting buffer    *
+ *                                                                            *
+ * Comments: Buffer size is calculated before the value is written, so the    *
+ *           calculated size must match the length of written data. String    *
+ *           values are also parsed back to check that escaping can be        *
+ *           reversed.                                                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	check_addstring(const char *value, zbx_json_type_t type, const char *expected)
+{
+	struct zbx_json		j;
+	struct zbx_json_parse	jp;
+	char			*decoded = NULL;
+	size_t			decoded_alloc = 0;
+
+	zbx_json_init(&j, ZBX_JSON_STAT_BUF_LEN);
+	zbx_json_addstring(&j, "value", value, type);
+
+	zbx_mock_assert_str_eq("json", expected, j.buffer);
+	zbx_mock_assert_uint64_eq("buffer size", strlen(j.buffer), j.buffer_size);
+
+	if (NULL != value && ZBX_JSON_TYPE_STRING == type)
+	{
+		if (SUCCEED != zbx_json_open(j.buffer, &jp))
+			fail_msg("cannot parse json: %s", zbx_json_strerror());
+
+		if (SUCCEED != zbx_json_value_by_name_dyn(&jp, "value", &decoded, &decoded_alloc, NULL))
+			fail_msg("cannot find value in json: %s", j.buffer);
+
+		zbx_mock_assert_str_eq("decoded value", value, decoded);
+		zbx_free(decoded);
+	}
+
+	zbx_json_free(&j);
+}
+
+static void	test_escape(void)
+{
+	const char	*value = NULL;
+	zbx_json_type_t	type = ZBX_JSON_TYPE_STRING;
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("in.value"))
+		value = zbx_mock_get_parameter_string("in.value");
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("in.json_type"))
+		type = get_json_type(zbx_mock_get_parameter_string("in.json_type"));
+
+	check_addstring(value, type, zbx_mock_get_parameter_string("out.json"));
+}
+
+/* character must be escaped the same way regardless of its position in the words scanned at once */
+static void	test_position(void)
+{
+	const char	*character, *escaped;
+	char		*value, *expected = NULL;
+	size_t		expected_alloc = 0, expected_offset, max_len;
+
+	character = zbx_mock_get_parameter_string("in.char");
+	escaped = zbx_mock_get_parameter_string("out.escaped");
+	max_len = (size_t)zbx_mock_get_parameter_uint64("in.max_len");
+
+	value = (char *)zbx_malloc(NULL, max_len + 1);
+
+	for (size_t len = 1; len <= max_len; len++)
+	{
+		for (size_t pos = 0; pos < len; pos++)
+		{
+			memset(value, 'a', len);
+			value[len] = '\0';
+			value[pos] = *character;
+
+			expected_offset = 0;
+			zbx_snprintf_alloc(&expected, &expected_alloc, &expected_offset, "{\"value\":\"%.*s%s%s\"}",
+					(int)pos, value, escaped, value + pos + 1);
+
+			check_addstring(value, ZBX_JSON_TYPE_STRING, expected);
+		}
+	}
+
+	zbx_free(expected);
+	zbx_free(value);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	ZBX_UNUSED(state);
+
+	switch (get_type(zbx_mock_get_parameter_string("in.type")))
+	{
+		case JSON_ESCAPE:
+			test_escape();
+			break;
+		case JSON_POSITION:
+			test_position();
+			break;
+		default:
+			fail_msg("unknown cmocka step type: %s", zbx_mock_get_parameter_string("in.type"));
+	}
+}
@@ -140,6 +140,9 @@ static void	read_step(const char *path, zbx_pp_step_t *step)
 
 	hop = zbx_mock_get_parameter_handle(path);
 	step->type = str_to_preproc_type(zbx_mock_get_object_member_string(hop, "type"));
+	step->jsonpath = NULL;
+	step->prometheus = NULL;
+	step->xpath = NULL;
 
 	if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hop, "params", &hop_params))
 		step->params = (char *)zbx_mock_get_object_member_string(hop, "params");
@@ -0,0 +1,335 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxsysinfo.h"
+
+#include "../../../src/libs/zbxpreproc/pp_protocol.c"
+
+#define PP_MOCK_FORMAT_NUMERIC	"numeric"
+#define PP_MOCK_FORMAT_FULL	"full"
+
+static const char	*mock_get_member_str(zbx_mock_handle_t hobject, const char *name)
+{
+	zbx_mock_handle_t	hmember;
+	const char		*value;
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_object_member(hobject, name, &hmember))
+		return NULL;
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_string(hmember, &value))
+		fail_msg("invalid value field \"%s\"", name);
+
+	return value;
+}
+
+static int	mock_get_member_int(zbx_mock_handle_t hobject, const char *name)
+{
+	zbx_mock_handle_t	hmember;
+	int			value;
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_object_member(hobject, name, &hmember))
+		return 0;
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_int(hmember, &value))
+		fail_msg("invalid value field \"%s\"", name);
+
+	return value;
+}
+
+/* string value is either given directly or generated with the specified size */
+static char	*mock_get_result_str(zbx_mock_handle_t hresult)
+{
+	const char	*str;
+	char		*value;
+	int		size;
+
+	if (NULL != (str = mock_get_member_str(hresult, "value")))
+		return zbx_strdup(NULL, str);
+
+	size = mock_get_member_int(hresult, "size");
+	value = (char *)zbx_malloc(NULL, (size_t)size + 1);
+
+	for (int i = 0; i < size; i++)
+		value[i] = (char)('a' + i % 26);
+
+	value[size] = '\0';
+
+	return value;
+}
+
+static AGENT_RESULT	*mock_read_result(zbx_mock_handle_t hvalue)
+{
+	zbx_mock_handle_t	hresult, hmeta;
+	AGENT_RESULT		*result;
+	const char		*type;
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_object_member(hvalue, "result", &hresult))
+		return NULL;
+
+	result = (AGENT_RESULT *)zbx_malloc(NULL, sizeof(AGENT_RESULT));
+	zbx_init_agent_result(result);
+
+	if (NULL == (type = mock_get_member_str(hresult, "type")))
+		type = "";
+
+	if (0 == strcmp(type, "ui64"))
+	{
+		SET_UI64_RESULT(result, zbx_mock_get_object_member_uint64(hresult, "value"));
+	}
+	else if (0 == strcmp(type, "dbl"))
+	{
+		SET_DBL_RESULT(result, zbx_mock_get_object_member_float(hresult, "value"));
+	}
+	else if (0 == strcmp(type, "str"))
+	{
+		SET_STR_RESULT(result, mock_get_result_str(hresult));
+	}
+	else if (0 == strcmp(type, "text"))
+	{
+		SET_TEXT_RESULT(result, mock_get_result_str(hresult));
+	}
+	else if (0 == strcmp(type, "log"))
+	{
+		zbx_log_t	*log;
+		const char	*source;
+
+		log = (zbx_log_t *)zbx_malloc(NULL, sizeof(zbx_log_t));
+		log->value = mock_get_result_str(hresult);
+		log->source = NULL != (source = mock_get_member_str(hresult, "source")) ? zbx_strdup(NULL, source) :
+				NULL;
+		log->timestamp = mock_get_member_int(hresult, "timestamp");
+		log->severity = mock_get_member_int(hresult, "severity");
+		log->logeventid = mock_get_member_int(hresult, "logeventid");
+		SET_LOG_RESULT(result, log);
+	}
+	else if ('\0' != *type)
+		fail_msg("unknown result type \"%s\"", type);
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hresult, "lastlogsize", &hmeta))
+	{
+		result->lastlogsize = zbx_mock_get_object_member_uint64(hresult, "lastlogsize");
+		result->mtime = mock_get_member_int(hresult, "mtime");
+		result->type |= AR_META;
+	}
+
+	return result;
+}
+
+static void	mock_read_value(zbx_mock_handle_t hvalue, zbx_preproc_item_value_t *value)
+{
+	zbx_mock_handle_t	hts;
+	const char		*str;
+
+	memset(value, 0, sizeof(zbx_preproc_item_value_t));
+
+	value->itemid = zbx_mock_get_object_member_uint64(hvalue, "itemid");
+	value->hostid = zbx_mock_get_object_member_uint64(hvalue, "hostid");
+	value->item_value_type = zbx_mock_str_to_value_type(zbx_mock_get_object_member_string(hvalue, "value_type"));
+	value->item_flags = (unsigned char)mock_get_member_int(hvalue, "flags");
+	value->state = (unsigned char)mock_get_member_int(hvalue, "state");
+
+	if (NULL != (str = mock_get_member_str(hvalue, "error")))
+		value->error = zbx_strdup(NULL, str);
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hvalue, "ts", &hts))
+	{
+		value->ts = (zbx_timespec_t *)zbx_malloc(NULL, sizeof(zbx_timespec_t));
+		value->ts->sec = zbx_mock_get_object_member_int(hts, "sec");
+		value->ts->ns = zbx_mock_get_object_member_int(hts, "ns");
+	}
+
+	value->result = mock_read_result(hvalue);
+}
+
+static void	mock_clear_value(zbx_preproc_item_value_t *value)
+{
+	zbx_free(value->error);
+	zbx_free(value->ts);
+
+	if (NULL != value->result)
+	{
+		zbx_free_agent_result(value->result);
+		zbx_free(value->result);
+	}
+}
+
+static void	mock_assert_str(const char *prefix, const char *expected, const char *returned)
+{
+	if (NULL == expected)
+	{
+		zbx_mock_assert_ptr_eq(prefix, NULL, returned);
+		return;
+	}
+
+	zbx_mock_assert_ptr_ne(prefix, NULL, returned);
+	zbx_mock_assert_str_eq(prefix, expected, returned);
+}
+
+static void	mock_assert_numeric_value(const zbx_preproc_item_value_t *expected,
+		const zbx_preproc_item_value_t *returned, const zbx_variant_t *var, const zbx_timespec_t *ts)
+{
+	zbx_mock_assert_int_eq("state", ITEM_STATE_NORMAL, returned->state);
+	zbx_mock_assert_ptr_eq("error", NULL, returned->error);
+	zbx_mock_assert_ptr_eq("timestamp", NULL, returned->ts);
+	zbx_mock_assert_ptr_eq("result", NULL, returned->result);
+	zbx_mock_assert_timespec_eq("timestamp", expected->ts, ts);
+
+	if (0 != ZBX_ISSET_UI64(expected->result))
+	{
+		zbx_mock_assert_int_eq("variant type", ZBX_VARIANT_UI64, var->type);
+		zbx_mock_assert_uint64_eq("variant value", expected->result->ui64, var->data.ui64);
+	}
+	else
+	{
+		zbx_mock_assert_int_eq("variant type", ZBX_VARIANT_DBL, var->type);
+		zbx_mock_assert_double_eq("variant value", expected->result->dbl, var->data.dbl);
+	}
+}
+
+static void	mock_assert_full_value(const zbx_preproc_item_value_t *expected,
+		const zbx_preproc_item_value_t *returned)
+{
+	zbx_mock_assert_int_eq("state", expected->state, returned->state);
+	mock_assert_str("error", expected->error, returned->error);
+
+	if (NULL == expected->ts)
+		zbx_mock_assert_ptr_eq("timestamp", NULL, returned->ts);
+	else
+		zbx_mock_assert_timespec_eq("timestamp", expected->ts, returned->ts);
+
+	if (NULL == expected->result)
+	{
+		zbx_mock_assert_ptr_eq("result", NULL, returned->result);
+		return;
+	}
+
+	zbx_mock_assert_ptr_ne("result", NULL, returned->result);
+	zbx_mock_assert_int_eq("result type", expected->result->type, returned->result->type);
+	zbx_mock_assert_uint64_eq("ui64", expected->result->ui64, returned->result->ui64);
+	zbx_mock_assert_double_eq("dbl", expected->result->dbl, returned->result->dbl);
+	mock_assert_str("str", expected->result->str, returned->result->str);
+	mock_assert_str("text", expected->result->text, returned->result->text);
+	mock_assert_str("msg", expected->result->msg, returned->result->msg);
+	zbx_mock_assert_uint64_eq("lastlogsize", expected->result->lastlogsize, returned->result->lastlogsize);
+	zbx_mock_assert_int_eq("mtime", expected->result->mtime, returned->result->mtime);
+
+	if (NULL == expected->result->log)
+	{
+		zbx_mock_assert_ptr_eq("log", NULL, returned->result->log);
+		return;
+	}
+
+	zbx_mock_assert_ptr_ne("log", NULL, returned->result->log);
+	mock_assert_str("log value", expected->result->log->value, returned->result->log->value);
+	mock_assert_str("log source", expected->result->log->source, returned->result->log->source);
+	zbx_mock_assert_int_eq("log timestamp", expected->result->log->timestamp,
+			returned->result->log->timestamp);
+	zbx_mock_assert_int_eq("log severity", expected->result->log->severity, returned->result->log->severity);
+	zbx_mock_assert_int_eq("log event id", expected->result->log->logeventid,
+			returned->result->log->logeventid);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_mock_handle_t		hvalues, hvalue, hformats, hformat;
+	zbx_preproc_item_value_t	*values = NULL;
+	zbx_ipc_message_t		message;
+	zbx_uint32_t			offset = 0;
+	int				values_num = 0;
+	const char			*format;
+
+	ZBX_UNUSED(state);
+
+	zbx_ipc_message_init(&message);
+
+	/* pack all values into single message to check that records are unpacked at correct offsets */
+	hvalues = zbx_mock_get_parameter_handle("in.values");
+
+	while (ZBX_MOCK_END_OF_VECTOR != zbx_mock_vector_element(hvalues, &hvalue))
+	{
+		values = (zbx_preproc_item_value_t *)zbx_realloc(values, sizeof(zbx_preproc_item_value_t) *
+				(size_t)(values_num + 1));
+		mock_read_value(hvalue, &values[values_num]);
+
+		if (0 == preprocessor_pack_value(&message, &values[values_num]))
+			fail_msg("cannot pack value #%d", values_num);
+
+		values_num++;
+	}
+
+	hformats = zbx_mock_get_parameter_handle("out.formats");
+
+	for (int i = 0; i < values_num; i++)
+	{
+		zbx_preproc_item_value_t	value;
+		zbx_variant_t			var;
+		zbx_timespec_t			ts;
+		zbx_uint32_t			size;
+
+		if (ZBX_MOCK_SUCCESS != zbx_mock_vector_element(hformats, &hformat) ||
+				ZBX_MOCK_SUCCESS != zbx_mock_string(hformat, &format))
+		{
+			fail_msg("missing expected format of value #%d", i);
+		}
+
+		zbx_mock_assert_uint64_ne("remaining data size", 0, message.size - offset);
+
+		memset(&value, 0, sizeof(value));
+		zbx_variant_set_none(&var);
+
+		size = zbx_preprocessor_unpack_numeric_value(&value, &var, &ts, message.data + offset);
+
+		if (0 == strcmp(format, PP_MOCK_FORMAT_NUMERIC))
+		{
+			zbx_mock_assert_uint64_ne("numeric record size", 0, size);
+			mock_assert_numeric_value(&values[i], &value, &var, &ts);
+		}
+		else if (0 == strcmp(format, PP_MOCK_FORMAT_FULL))
+		{
+			zbx_mock_assert_uint64_eq("numeric record size", 0, size);
+			size = zbx_preprocessor_unpack_value(&value, message.data + offset);
+			mock_assert_full_value(&values[i], &value);
+		}
+		else
+			fail_msg("unknown format \"%s\"", format);
+
+		zbx_mock_assert_uint64_eq("itemid", values[i].itemid, value.itemid);
+		zbx_mock_assert_uint64_eq("hostid", values[i].hostid, value.hostid);
+		zbx_mock_assert_int_eq("value type", values[i].item_value_type, value.item_value_type);
+		zbx_mock_assert_int_eq("flags", values[i].item_flags, value.item_flags);
+
+		offset += size;
+
+		zbx_variant_clear(&var);
+		mock_clear_value(&value);
+	}
+
+	zbx_mock_assert_uint64_eq("unpacked data size", message.size, offset);
+
+	for (int i = 0; i < values_num; i++)
+		mock_clear_value(&values[i]);
+
+	zbx_free(values);
+	zbx_ipc_message_clean(&message);
+}
@@ -0,0 +1,80 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxserialize.h"
+
+static const unsigned char	*mock_read_binary(const char *path, size_t *len)
+{
+	const char	*data;
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_binary(zbx_mock_get_parameter_handle(path), &data, len))
+		fail_msg("invalid binary parameter \"%s\"", path);
+
+	return (const unsigned char *)data;
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	const unsigned char	*data;
+	unsigned char		buffer[ZBX_SERIALIZE_UINT64_COMPACT_MAX];
+	size_t			data_len;
+	zbx_uint64_t		value, expected_value;
+	zbx_uint32_t		len, expected_len;
+
+	ZBX_UNUSED(state);
+
+	/* serialize value and compare with the expected byte stream */
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("in.value"))
+	{
+		value = zbx_mock_get_parameter_uint64("in.value");
+		data = mock_read_binary("out.data", &data_len);
+
+		len = zbx_serialize_uint64_compact(buffer, value);
+
+		zbx_mock_assert_uint64_eq("serialized length", (zbx_uint64_t)data_len, (zbx_uint64_t)len);
+
+		if (0 != memcmp(buffer, data, data_len))
+			fail_msg("serialized data does not match the expected data");
+
+		expected_len = len;
+		expected_value = value;
+	}
+	else
+	{
+		data = mock_read_binary("in.data", &data_len);
+		expected_len = (zbx_uint32_t)zbx_mock_get_parameter_uint64("out.length");
+
+		if (0 != expected_len)
+			expected_value = zbx_mock_get_parameter_uint64("out.value");
+		else
+			expected_value = 0;
+	}
+
+	len = zbx_deserialize_uint64_compact(data, data + data_len, &value);
+
+	zbx_mock_assert_uint64_eq("deserialized length", (zbx_uint64_t)expected_len, (zbx_uint64_t)len);
+
+	if (0 != expected_len)
+		zbx_mock_assert_uint64_eq("deserialized value", expected_value, value);
+}
@@ -44,6 +44,7 @@ static void	get_macros(const char *path, zbx_vector_ptr_t *macros)
 		macro = (zbx_lld_macro_path_t *)zbx_malloc(NULL, sizeof(zbx_lld_macro_path_t));
 		macro->lld_macro = zbx_strdup(NULL, zbx_mock_get_object_member_string(hmacro, "macro"));
 		macro->path = zbx_strdup(NULL, zbx_mock_get_object_member_string(hmacro, "path"));
+		macro->jsonpath = NULL;
 		zbx_vector_ptr_append(macros, macro);
 
 		macros_num++;
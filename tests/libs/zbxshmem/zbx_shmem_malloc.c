@@ -0,0 +1,179 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2023 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxshmem.h"
+#include "zbxalgo.h"
+
+#define	SHMEM_BUCKET_SIZE	1
+#define	SHMEM_ALLOCATE		2
+
+static int	get_type(const char *str)
+{
+	if (0 == strcmp(str, "BUCKET_SIZE"))
+		return SHMEM_BUCKET_SIZE;
+	if (0 == strcmp(str, "ALLOCATE"))
+		return SHMEM_ALLOCATE;
+
+	fail_msg("unknown cmocka step type: %s", str);
+	return FAIL;
+}
+
+static void	test_bucket_size(void)
+{
+	zbx_mock_handle_t	hbuckets, hbucket;
+	zbx_mock_error_t	err;
+
+	zbx_mock_assert_int_eq("bucket count", ZBX_SHMEM_BUCKET_COUNT,
+			(int)zbx_mock_get_parameter_uint64("out.count"));
+
+	hbuckets = zbx_mock_get_parameter_handle("out.buckets");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hbuckets, &hbucket))))
+	{
+		int	index;
+
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("Cannot read bucket: %s", zbx_mock_error_string(err));
+
+		index = zbx_mock_get_object_member_int(hbucket, "index");
+
+		zbx_mock_assert_uint64_eq("bucket size", zbx_mock_get_object_member_uint64(hbucket, "size"),
+				zbx_shmem_bucket_size(index));
+	}
+
+	/* bucket sizes must grow, otherwise allocation could take a chunk smaller than requested */
+	for (int i = 1; i < ZBX_SHMEM_BUCKET_COUNT; i++)
+	{
+		if (zbx_shmem_bucket_size(i - 1) >= zbx_shmem_bucket_size(i))
+			fail_msg("size of bucket %d does not exceed size of previous bucket", i);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: perform allocation steps in private shared memory segment         *
+ *                                                                            *
+ * Comments: Each step either allocates memory of the specified size or frees *
+ *           memory allocated by an earlier step, referenced by its index.    *
+ *           Allocation step can expect the returned memory to be the same as *
+ *           allocated by an earlier step or NULL when memory is exhausted.   *
+ *                                                                            *
+ ******************************************************************************/
+static void	test_allocate(void)
+{
+	zbx_shmem_info_t	*info;
+	zbx_shmem_stats_t	stats;
+	zbx_mock_handle_t	hsteps, hstep, hexpected;
+	zbx_mock_error_t	err;
+	zbx_vector_ptr_t	ptrs;
+	char			*error = NULL;
+	int			step = 0;
+
+	if (SUCCEED != zbx_shmem_create(&info, zbx_mock_get_parameter_uint64("in.size"), "test", "TestCacheSize",
+			1, &error))
+	{
+		fail_msg("cannot create shared memory: %s", error);
+	}
+
+	zbx_vector_ptr_create(&ptrs);
+
+	hsteps = zbx_mock_get_parameter_handle("in.steps");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hsteps, &hstep))))
+	{
+		const char	*op;
+		void		*ptr = NULL;
+
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("Cannot read step: %s", zbx_mock_error_string(err));
+
+		op = zbx_mock_get_object_member_string(hstep, "op");
+
+		if (0 == strcmp(op, "malloc"))
+		{
+			ptr = zbx_shmem_malloc(info, NULL, zbx_mock_get_object_member_uint64(hstep, "size"));
+
+			if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hstep, "same", &hexpected))
+			{
+				int	index;
+
+				index = zbx_mock_get_object_member_int(hstep, "same");
+
+				if (ptr != ptrs.values[index])
+					fail_msg("step %d did not reuse memory of step %d", step, index);
+			}
+			else if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hstep, "result", &hexpected))
+			{
+				if (NULL != ptr)
+					fail_msg("step %d allocated memory when it was expected to fail", step);
+			}
+			else if (NULL == ptr)
+				fail_msg("step %d failed to allocate memory", step);
+		}
+		else if (0 == strcmp(op, "free"))
+		{
+			int	index;
+
+			index = zbx_mock_get_object_member_int(hstep, "index");
+
+			/* keep address of freed memory to check if it is reused by following steps */
+			if (NULL == (ptr = ptrs.values[index]))
+				fail_msg("step %d frees memory that was not allocated", step);
+
+			zbx_shmem_free(info, ptr);
+		}
+		else
+			fail_msg("unknown step operation: %s", op);
+
+		zbx_vector_ptr_append(&ptrs, ptr);
+		step++;
+	}
+
+	zbx_shmem_get_stats(info, &stats);
+
+	zbx_mock_assert_uint64_eq("used size", zbx_mock_get_parameter_uint64("out.used_size"), stats.used_size);
+	zbx_mock_assert_int_eq("free chunks", (int)zbx_mock_get_parameter_uint64("out.free_chunks"),
+			(int)stats.free_chunks);
+	zbx_mock_assert_uint64_eq("total size", info->total_size, stats.used_size + stats.free_size + stats.overhead);
+
+	zbx_vector_ptr_destroy(&ptrs);
+	zbx_shmem_destroy(info);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	ZBX_UNUSED(state);
+
+	switch (get_type(zbx_mock_get_parameter_string("in.type")))
+	{
+		case SHMEM_BUCKET_SIZE:
+			test_bucket_size();
+			break;
+		case SHMEM_ALLOCATE:
+			test_allocate();
+			break;
+		default:
+			fail_msg("unknown cmocka step type: %s", zbx_mock_get_parameter_string("in.type"));
+	}
+}
@@ -191,6 +191,8 @@ void	zbx_mock_test_entry(void **state)
 	zbx_vector_match_tags_t	mtags;
 	zbx_vector_tags_t	etags;
 	int			expected_ret, returned_ret;
+	zbx_match_tags_index_t	index;
+	zbx_vector_uint32_t	matches;
 
 	ZBX_UNUSED(state);
 
@@ -211,6 +213,16 @@ void	zbx_mock_test_entry(void **state)
 
 	zbx_mock_assert_int_eq("tagfilter_match_tags return value", expected_ret, returned_ret);
 
+	zbx_vector_uint32_create(&matches);
+	zbx_match_tags_index_init(&index);
+	zbx_match_tags_index_add(&index, eval_type, &mtags);
+	zbx_match_tags_index_match(&index, &etags, &matches);
+
+	zbx_mock_assert_int_eq("tagfilter index return value", expected_ret, 0 == matches.values_num ? FAIL : SUCCEED);
+
+	zbx_match_tags_index_destroy(&index);
+	zbx_vector_uint32_destroy(&matches);
+
 	zbx_vector_match_tags_clear_ext(&mtags, zbx_match_tag_free);
 	zbx_vector_match_tags_destroy(&mtags);
 
@@ -501,14 +501,17 @@ void	zbx_vcmock_free_dc_history(void *ptr)
  * mock functions
  */
 
-static zbx_mutex_t	*vc_mutex = NULL;
+static zbx_mutex_t	*vc_mutexes[ZBX_MUTEX_COUNT];
+static int		vc_mutexes_num = 0;
 zbx_shmem_info_t		*vc_meminfo = NULL;
 
 static size_t		vcmock_mem = ZBX_MEBIBYTE * 1024;
 
 int	__wrap_zbx_mutex_create(zbx_mutex_t *mutex, zbx_mutex_name_t name, char **error)
 {
-	vc_mutex = mutex;
+	if (ZBX_MUTEX_COUNT > vc_mutexes_num)
+		vc_mutexes[vc_mutexes_num++] = mutex;
+
 	ZBX_UNUSED(name);
 	ZBX_UNUSED(error);
 
@@ -517,7 +520,18 @@ int	__wrap_zbx_mutex_create(zbx_mutex_t *mutex, zbx_mutex_name_t name, char **er
 
 void	__wrap_zbx_mutex_destroy(zbx_mutex_t *mutex)
 {
-	zbx_mock_assert_ptr_eq("Attempting to destroy unknown mutex", vc_mutex, mutex);
+	int	i;
+
+	for (i = 0; i < vc_mutexes_num; i++)
+	{
+		if (vc_mutexes[i] == mutex)
+		{
+			vc_mutexes[i] = vc_mutexes[--vc_mutexes_num];
+			return;
+		}
+	}
+
+	fail_msg("Attempting to destroy unknown mutex");
 }
 
 int	__wrap_zbx_shmem_create(zbx_shmem_info_t **info, zbx_uint64_t size, const char *descr, const char *param,
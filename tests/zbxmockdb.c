@@ -27,11 +27,13 @@
 #define zbx_db_fetch_basic	__wrap_zbx_db_fetch_basic
 #define zbx_db_fetch		__wrap_zbx_db_fetch_basic
 #define zbx_db_free_result	__wrap_zbx_db_free_result
+#define zbx_db_copy_basic	__wrap_zbx_db_copy_basic
 #include "zbxdb.h"
 #undef zbx_db_vselect
 #undef zbx_db_fetch_basic
 #undef zbx_db_fetch
 #undef zbx_db_free_result
+#undef zbx_db_copy_basic
 
 #define __zbx_db_execute		__wrap___zbx_db_execute
 #define zbx_db_execute_multiple_query	__wrap_zbx_db_execute_multiple_query
@@ -55,6 +57,9 @@ zbx_mockdb_query_t;
 typedef struct
 {
 	zbx_hashset_t	queries;
+	char		*copy_sql;	/* the last COPY statement */
+	char		*copy_data;	/* the data of the last COPY statement */
+	size_t		copy_data_len;
 }
 zbx_mockdb_t;
 
@@ -294,13 +299,51 @@ int	__wrap_zbx_db_commit(void)
 	return ZBX_DB_OK;
 }
 
+#if defined(HAVE_POSTGRESQL)
+int	__wrap_zbx_db_copy_basic(const char *sql, const char *data, size_t data_len)
+{
+	printf("\tSQL: %s\n", sql);
+
+	mockdb.copy_sql = zbx_strdup(mockdb.copy_sql, sql);
+	mockdb.copy_data = (char *)zbx_realloc(mockdb.copy_data, data_len);
+	memcpy(mockdb.copy_data, data, data_len);
+	mockdb.copy_data_len = data_len;
+
+	return 0;
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get the last statement and data copied with COPY statement        *
+ *                                                                            *
+ * Parameters: data     - [OUT] the copied data                               *
+ *             data_len - [OUT] the copied data length                        *
+ *                                                                            *
+ * Return value: the last COPY statement or NULL if nothing was copied        *
+ *                                                                            *
+ ******************************************************************************/
+const char	*zbx_mockdb_get_copy(const char **data, size_t *data_len)
+{
+	*data = mockdb.copy_data;
+	*data_len = mockdb.copy_data_len;
+
+	return mockdb.copy_sql;
+}
+
 void	zbx_mockdb_init(void)
 {
+	mockdb.copy_sql = NULL;
+	mockdb.copy_data = NULL;
+	mockdb.copy_data_len = 0;
+
 	zbx_hashset_create_ext(&mockdb.queries, 0, mockdb_query_hash, mockdb_query_compare, mockdb_query_clear,
 			ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
 }
 
 void	zbx_mockdb_destroy(void)
 {
+	zbx_free(mockdb.copy_sql);
+	zbx_free(mockdb.copy_data);
 	zbx_hashset_destroy(&mockdb.queries);
 }
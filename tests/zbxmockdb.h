@@ -23,5 +23,6 @@
 
 void	zbx_mockdb_init(void);
 void	zbx_mockdb_destroy(void);
+const char	*zbx_mockdb_get_copy(const char **data, size_t *data_len);
 
 #endif /* BUILD_TESTS_ZBXMOCKDB_H_ */
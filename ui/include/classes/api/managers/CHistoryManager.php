@@ -1349,6 +1349,17 @@ class CHistoryManager {
 			return false;
 		}
 
+		// Daily trend rollups are regular tables, they are never compressed.
+		if (in_array(ITEM_VALUE_TYPE_UINT64, $items)) {
+			$item_tables[] = 'trends_uint_day';
+			$table_names['trends_uint_day'] = ITEM_VALUE_TYPE_UINT64;
+		}
+
+		if (in_array(ITEM_VALUE_TYPE_FLOAT, $items)) {
+			$item_tables[] = 'trends_day';
+			$table_names['trends_day'] = ITEM_VALUE_TYPE_FLOAT;
+		}
+
 		foreach ($item_tables as $table_name) {
 			$itemids = array_keys(array_intersect($items, [(string) $table_names[$table_name]]));
 
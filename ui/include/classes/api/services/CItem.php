@@ -81,10 +81,10 @@ class CItem extends CItemGeneral {
 	 * @inheritDoc
 	 */
 	protected const VALUE_TYPE_FIELD_NAMES = [
-		ITEM_VALUE_TYPE_FLOAT => ['units', 'trends', 'valuemapid', 'inventory_link'],
+		ITEM_VALUE_TYPE_FLOAT => ['units', 'trends', 'history_downsample', 'history_downsample_param', 'valuemapid', 'inventory_link'],
 		ITEM_VALUE_TYPE_STR => ['valuemapid', 'inventory_link'],
 		ITEM_VALUE_TYPE_LOG => ['logtimefmt'],
-		ITEM_VALUE_TYPE_UINT64 => ['units', 'trends', 'valuemapid', 'inventory_link'],
+		ITEM_VALUE_TYPE_UINT64 => ['units', 'trends', 'history_downsample', 'history_downsample_param', 'valuemapid', 'inventory_link'],
 		ITEM_VALUE_TYPE_TEXT => ['inventory_link'],
 		ITEM_VALUE_TYPE_BINARY => []
 	];
@@ -544,6 +544,14 @@ class CItem extends CItemGeneral {
 									['if' => ['field' => 'value_type', 'in' => implode(',', [ITEM_VALUE_TYPE_FLOAT, ITEM_VALUE_TYPE_UINT64])], 'type' => API_TIME_UNIT, 'flags' => API_NOT_EMPTY | API_ALLOW_USER_MACRO, 'in' => '0,'.implode(':', [SEC_PER_DAY, 25 * SEC_PER_YEAR]), 'length' => DB::getFieldLength('items', 'trends')],
 									['else' => true, 'type' => API_TIME_UNIT, 'in' => '0', 'default' => 0]
 			]],
+			'history_downsample' => ['type' => API_MULTIPLE, 'rules' => [
+									['if' => ['field' => 'value_type', 'in' => implode(',', [ITEM_VALUE_TYPE_FLOAT, ITEM_VALUE_TYPE_UINT64])], 'type' => API_INT32, 'in' => implode(',', [ITEM_HISTORY_DOWNSAMPLE_NONE, ITEM_HISTORY_DOWNSAMPLE_AVG, ITEM_HISTORY_DOWNSAMPLE_MIN, ITEM_HISTORY_DOWNSAMPLE_MAX, ITEM_HISTORY_DOWNSAMPLE_LAST, ITEM_HISTORY_DOWNSAMPLE_DEADBAND])],
+									['else' => true, 'type' => API_INT32, 'in' => DB::getDefault('items', 'history_downsample')]
+			]],
+			'history_downsample_param' => ['type' => API_MULTIPLE, 'rules' => [
+									['if' => ['field' => 'value_type', 'in' => implode(',', [ITEM_VALUE_TYPE_FLOAT, ITEM_VALUE_TYPE_UINT64])], 'type' => API_STRING_UTF8, 'length' => DB::getFieldLength('items', 'history_downsample_param')],
+									['else' => true, 'type' => API_STRING_UTF8, 'in' => DB::getDefault('items', 'history_downsample_param')]
+			]],
 			'valuemapid' =>		['type' => API_MULTIPLE, 'rules' => [
 									['if' => ['field' => 'value_type', 'in' => implode(',', [ITEM_VALUE_TYPE_FLOAT, ITEM_VALUE_TYPE_STR, ITEM_VALUE_TYPE_UINT64])], 'type' => API_ID],
 									['else' => true, 'type' => API_ID, 'in' => '0']
@@ -663,7 +671,7 @@ class CItem extends CItemGeneral {
 		 */
 		$db_items = DB::select('items', [
 			'output' => array_merge(['uuid', 'itemid', 'name', 'type', 'key_', 'value_type', 'units', 'history',
-				'trends', 'valuemapid', 'inventory_link', 'logtimefmt', 'description', 'status'
+				'trends', 'history_downsample', 'history_downsample_param', 'valuemapid', 'inventory_link', 'logtimefmt', 'description', 'status'
 			], array_diff(CItemType::FIELD_NAMES, ['parameters'])),
 			'itemids' => array_column($items, 'itemid'),
 			'preservekeys' => true
@@ -749,6 +757,14 @@ class CItem extends CItemGeneral {
 									['if' => ['field' => 'value_type', 'in' => implode(',', [ITEM_VALUE_TYPE_FLOAT, ITEM_VALUE_TYPE_UINT64])], 'type' => API_TIME_UNIT, 'flags' => API_NOT_EMPTY | API_ALLOW_USER_MACRO, 'in' => '0,'.implode(':', [SEC_PER_DAY, 25 * SEC_PER_YEAR]), 'length' => DB::getFieldLength('items', 'trends')],
 									['else' => true, 'type' => API_TIME_UNIT, 'in' => '0']
 			]],
+			'history_downsample' => ['type' => API_MULTIPLE, 'rules' => [
+									['if' => ['field' => 'value_type', 'in' => implode(',', [ITEM_VALUE_TYPE_FLOAT, ITEM_VALUE_TYPE_UINT64])], 'type' => API_INT32, 'in' => implode(',', [ITEM_HISTORY_DOWNSAMPLE_NONE, ITEM_HISTORY_DOWNSAMPLE_AVG, ITEM_HISTORY_DOWNSAMPLE_MIN, ITEM_HISTORY_DOWNSAMPLE_MAX, ITEM_HISTORY_DOWNSAMPLE_LAST, ITEM_HISTORY_DOWNSAMPLE_DEADBAND])],
+									['else' => true, 'type' => API_INT32, 'in' => DB::getDefault('items', 'history_downsample')]
+			]],
+			'history_downsample_param' => ['type' => API_MULTIPLE, 'rules' => [
+									['if' => ['field' => 'value_type', 'in' => implode(',', [ITEM_VALUE_TYPE_FLOAT, ITEM_VALUE_TYPE_UINT64])], 'type' => API_STRING_UTF8, 'length' => DB::getFieldLength('items', 'history_downsample_param')],
+									['else' => true, 'type' => API_STRING_UTF8, 'in' => DB::getDefault('items', 'history_downsample_param')]
+			]],
 			'valuemapid' =>		['type' => API_MULTIPLE, 'rules' => [
 									['if' => ['field' => 'value_type', 'in' => implode(',', [ITEM_VALUE_TYPE_FLOAT, ITEM_VALUE_TYPE_STR, ITEM_VALUE_TYPE_UINT64])], 'type' => API_ID],
 									['else' => true, 'type' => API_ID, 'in' => '0']
@@ -786,6 +802,8 @@ class CItem extends CItemGeneral {
 									['if' => ['field' => 'value_type', 'in' => implode(',', [ITEM_VALUE_TYPE_FLOAT, ITEM_VALUE_TYPE_UINT64])], 'type' => API_TIME_UNIT, 'flags' => API_NOT_EMPTY | API_ALLOW_USER_MACRO, 'in' => '0,'.implode(':', [SEC_PER_DAY, 25 * SEC_PER_YEAR]), 'length' => DB::getFieldLength('items', 'trends')],
 									['else' => true, 'type' => API_TIME_UNIT, 'in' => '0']
 			]],
+			'history_downsample' => ['type' => API_UNEXPECTED, 'error_type' => API_ERR_INHERITED],
+			'history_downsample_param' => ['type' => API_UNEXPECTED, 'error_type' => API_ERR_INHERITED],
 			'valuemapid' =>		['type' => API_UNEXPECTED, 'error_type' => API_ERR_INHERITED],
 			'inventory_link' =>	['type' => API_MULTIPLE, 'rules' => [
 									['if' => ['field' => 'value_type', 'in' => implode(',', [ITEM_VALUE_TYPE_FLOAT, ITEM_VALUE_TYPE_STR, ITEM_VALUE_TYPE_UINT64, ITEM_VALUE_TYPE_TEXT])], 'type' => API_INT32, 'in' => '0,'.implode(',', array_keys(getHostInventories()))],
@@ -814,6 +832,8 @@ class CItem extends CItemGeneral {
 			'units' =>			['type' => API_UNEXPECTED, 'error_type' => API_ERR_DISCOVERED],
 			'history' =>		['type' => API_UNEXPECTED, 'error_type' => API_ERR_DISCOVERED],
 			'trends' =>			['type' => API_UNEXPECTED, 'error_type' => API_ERR_DISCOVERED],
+			'history_downsample' => ['type' => API_UNEXPECTED, 'error_type' => API_ERR_DISCOVERED],
+			'history_downsample_param' => ['type' => API_UNEXPECTED, 'error_type' => API_ERR_DISCOVERED],
 			'valuemapid' =>		['type' => API_UNEXPECTED, 'error_type' => API_ERR_DISCOVERED],
 			'inventory_link' =>	['type' => API_UNEXPECTED, 'error_type' => API_ERR_DISCOVERED],
 			'logtimefmt' =>		['type' => API_UNEXPECTED, 'error_type' => API_ERR_DISCOVERED],
@@ -935,7 +955,7 @@ class CItem extends CItemGeneral {
 	public static function linkTemplateObjects(array $templateids, array $hostids): void {
 		$db_items = DB::select('items', [
 			'output' => array_merge(['itemid', 'name', 'type', 'key_', 'value_type', 'units', 'history', 'trends',
-				'valuemapid', 'inventory_link', 'logtimefmt', 'description', 'status'
+				'history_downsample', 'history_downsample_param', 'valuemapid', 'inventory_link', 'logtimefmt', 'description', 'status'
 			], array_diff(CItemType::FIELD_NAMES, ['interfaceid', 'parameters'])),
 			'filter' => [
 				'hostid' => $templateids,
@@ -1104,7 +1124,7 @@ class CItem extends CItemGeneral {
 	private static function getChildObjectsUsingTemplateid(array $items, array $db_items, array $hostids): array {
 		$upd_db_items = DB::select('items', [
 			'output' => array_merge(['itemid', 'name', 'type', 'key_', 'value_type', 'units', 'history', 'trends',
-				'valuemapid', 'inventory_link', 'logtimefmt', 'description', 'status'
+				'history_downsample', 'history_downsample_param', 'valuemapid', 'inventory_link', 'logtimefmt', 'description', 'status'
 			], array_diff(CItemType::FIELD_NAMES, ['parameters'])),
 			'filter' => [
 				'templateid' => array_keys($db_items),
@@ -1214,7 +1234,7 @@ class CItem extends CItemGeneral {
 
 		$options = [
 			'output' => array_merge(['uuid', 'itemid', 'name', 'type', 'key_', 'value_type', 'units', 'history',
-				'trends', 'valuemapid', 'inventory_link', 'logtimefmt', 'description', 'status'
+				'trends', 'history_downsample', 'history_downsample_param', 'valuemapid', 'inventory_link', 'logtimefmt', 'description', 'status'
 			], array_diff(CItemType::FIELD_NAMES, ['parameters'])),
 			'itemids' => array_keys($upd_db_items)
 		];
@@ -1984,7 +2004,7 @@ class CItem extends CItemGeneral {
 
 		if (CHousekeepingHelper::get(CHousekeepingHelper::HK_TRENDS_MODE) == 1
 				&& (!$timescale_extension || CHousekeepingHelper::get(CHousekeepingHelper::HK_TRENDS_GLOBAL) == 0)) {
-			array_push($table_names, 'trends', 'trends_uint');
+			array_push($table_names, 'trends', 'trends_uint', 'trends_day', 'trends_uint_day');
 		}
 
 		$ins_housekeeper = [];
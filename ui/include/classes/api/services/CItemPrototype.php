@@ -81,10 +81,10 @@ class CItemPrototype extends CItemGeneral {
 	 * @inheritDoc
 	 */
 	protected const VALUE_TYPE_FIELD_NAMES = [
-		ITEM_VALUE_TYPE_FLOAT => ['units', 'trends', 'valuemapid'],
+		ITEM_VALUE_TYPE_FLOAT => ['units', 'trends', 'history_downsample', 'history_downsample_param', 'valuemapid'],
 		ITEM_VALUE_TYPE_STR => ['valuemapid'],
 		ITEM_VALUE_TYPE_LOG => ['logtimefmt'],
-		ITEM_VALUE_TYPE_UINT64 => ['units', 'trends', 'valuemapid'],
+		ITEM_VALUE_TYPE_UINT64 => ['units', 'trends', 'history_downsample', 'history_downsample_param', 'valuemapid'],
 		ITEM_VALUE_TYPE_TEXT => [],
 		ITEM_VALUE_TYPE_BINARY => []
 	];
@@ -419,6 +419,14 @@ class CItemPrototype extends CItemGeneral {
 									['if' => ['field' => 'value_type', 'in' => implode(',', [ITEM_VALUE_TYPE_FLOAT, ITEM_VALUE_TYPE_UINT64])], 'type' => API_TIME_UNIT, 'flags' => API_NOT_EMPTY | API_ALLOW_USER_MACRO | API_ALLOW_LLD_MACRO, 'in' => '0,'.implode(':', [SEC_PER_DAY, 25 * SEC_PER_YEAR]), 'length' => DB::getFieldLength('items', 'trends')],
 									['else' => true, 'type' => API_TIME_UNIT, 'in' => '0', 'default' => 0]
 			]],
+			'history_downsample' => ['type' => API_MULTIPLE, 'rules' => [
+									['if' => ['field' => 'value_type', 'in' => implode(',', [ITEM_VALUE_TYPE_FLOAT, ITEM_VALUE_TYPE_UINT64])], 'type' => API_INT32, 'in' => implode(',', [ITEM_HISTORY_DOWNSAMPLE_NONE, ITEM_HISTORY_DOWNSAMPLE_AVG, ITEM_HISTORY_DOWNSAMPLE_MIN, ITEM_HISTORY_DOWNSAMPLE_MAX, ITEM_HISTORY_DOWNSAMPLE_LAST, ITEM_HISTORY_DOWNSAMPLE_DEADBAND])],
+									['else' => true, 'type' => API_INT32, 'in' => DB::getDefault('items', 'history_downsample')]
+			]],
+			'history_downsample_param' => ['type' => API_MULTIPLE, 'rules' => [
+									['if' => ['field' => 'value_type', 'in' => implode(',', [ITEM_VALUE_TYPE_FLOAT, ITEM_VALUE_TYPE_UINT64])], 'type' => API_STRING_UTF8, 'length' => DB::getFieldLength('items', 'history_downsample_param')],
+									['else' => true, 'type' => API_STRING_UTF8, 'in' => DB::getDefault('items', 'history_downsample_param')]
+			]],
 			'valuemapid' =>		['type' => API_MULTIPLE, 'rules' => [
 									['if' => ['field' => 'value_type', 'in' => implode(',', [ITEM_VALUE_TYPE_FLOAT, ITEM_VALUE_TYPE_STR, ITEM_VALUE_TYPE_UINT64])], 'type' => API_ID],
 									['else' => true, 'type' => API_ID, 'in' => '0']
@@ -541,7 +549,7 @@ class CItemPrototype extends CItemGeneral {
 		 */
 		$db_items = DB::select('items', [
 			'output' => array_merge(['uuid', 'itemid', 'name', 'type', 'key_', 'value_type', 'units', 'history',
-				'trends', 'valuemapid', 'logtimefmt', 'description', 'status', 'discover'
+				'trends', 'history_downsample', 'history_downsample_param', 'valuemapid', 'logtimefmt', 'description', 'status', 'discover'
 			], array_diff(CItemType::FIELD_NAMES, ['parameters'])),
 			'itemids' => array_column($items, 'itemid'),
 			'preservekeys' => true
@@ -630,6 +638,14 @@ class CItemPrototype extends CItemGeneral {
 									['if' => ['field' => 'value_type', 'in' => implode(',', [ITEM_VALUE_TYPE_FLOAT, ITEM_VALUE_TYPE_UINT64])], 'type' => API_TIME_UNIT, 'flags' => API_NOT_EMPTY | API_ALLOW_USER_MACRO | API_ALLOW_LLD_MACRO, 'in' => '0,'.implode(':', [SEC_PER_DAY, 25 * SEC_PER_YEAR]), 'length' => DB::getFieldLength('items', 'trends')],
 									['else' => true, 'type' => API_TIME_UNIT, 'in' => '0']
 			]],
+			'history_downsample' => ['type' => API_MULTIPLE, 'rules' => [
+									['if' => ['field' => 'value_type', 'in' => implode(',', [ITEM_VALUE_TYPE_FLOAT, ITEM_VALUE_TYPE_UINT64])], 'type' => API_INT32, 'in' => implode(',', [ITEM_HISTORY_DOWNSAMPLE_NONE, ITEM_HISTORY_DOWNSAMPLE_AVG, ITEM_HISTORY_DOWNSAMPLE_MIN, ITEM_HISTORY_DOWNSAMPLE_MAX, ITEM_HISTORY_DOWNSAMPLE_LAST, ITEM_HISTORY_DOWNSAMPLE_DEADBAND])],
+									['else' => true, 'type' => API_INT32, 'in' => DB::getDefault('items', 'history_downsample')]
+			]],
+			'history_downsample_param' => ['type' => API_MULTIPLE, 'rules' => [
+									['if' => ['field' => 'value_type', 'in' => implode(',', [ITEM_VALUE_TYPE_FLOAT, ITEM_VALUE_TYPE_UINT64])], 'type' => API_STRING_UTF8, 'length' => DB::getFieldLength('items', 'history_downsample_param')],
+									['else' => true, 'type' => API_STRING_UTF8, 'in' => DB::getDefault('items', 'history_downsample_param')]
+			]],
 			'valuemapid' =>		['type' => API_MULTIPLE, 'rules' => [
 									['if' => ['field' => 'value_type', 'in' => implode(',', [ITEM_VALUE_TYPE_FLOAT, ITEM_VALUE_TYPE_STR, ITEM_VALUE_TYPE_UINT64])], 'type' => API_ID],
 									['else' => true, 'type' => API_ID, 'in' => '0']
@@ -664,6 +680,8 @@ class CItemPrototype extends CItemGeneral {
 									['if' => ['field' => 'value_type', 'in' => implode(',', [ITEM_VALUE_TYPE_FLOAT, ITEM_VALUE_TYPE_UINT64])], 'type' => API_TIME_UNIT, 'flags' => API_NOT_EMPTY | API_ALLOW_USER_MACRO | API_ALLOW_LLD_MACRO, 'in' => '0,'.implode(':', [SEC_PER_DAY, 25 * SEC_PER_YEAR]), 'length' => DB::getFieldLength('items', 'trends')],
 									['else' => true, 'type' => API_TIME_UNIT, 'in' => '0']
 			]],
+			'history_downsample' => ['type' => API_UNEXPECTED, 'error_type' => API_ERR_INHERITED],
+			'history_downsample_param' => ['type' => API_UNEXPECTED, 'error_type' => API_ERR_INHERITED],
 			'valuemapid' =>		['type' => API_UNEXPECTED, 'error_type' => API_ERR_INHERITED],
 			'logtimefmt' =>		['type' => API_UNEXPECTED, 'error_type' => API_ERR_INHERITED],
 			'description' =>	['type' => API_STRING_UTF8, 'length' => DB::getFieldLength('items', 'description')],
@@ -844,7 +862,7 @@ class CItemPrototype extends CItemGeneral {
 	public static function linkTemplateObjects(array $templateids, array $hostids): void {
 		$db_items = DB::select('items', [
 			'output' => array_merge(['itemid', 'name', 'type', 'key_', 'value_type', 'units', 'history', 'trends',
-				'valuemapid', 'logtimefmt', 'description', 'status', 'discover'
+				'history_downsample', 'history_downsample_param', 'valuemapid', 'logtimefmt', 'description', 'status', 'discover'
 			], array_diff(CItemType::FIELD_NAMES, ['interfaceid', 'parameters'])),
 			'filter' => [
 				'flags' => ZBX_FLAG_DISCOVERY_PROTOTYPE,
@@ -1014,7 +1032,7 @@ class CItemPrototype extends CItemGeneral {
 	private static function getChildObjectsUsingTemplateid(array $items, array $db_items, array $hostids): array {
 		$upd_db_items = DB::select('items', [
 			'output' => array_merge(['itemid', 'name', 'type', 'key_', 'value_type', 'units', 'history', 'trends',
-				'valuemapid', 'logtimefmt', 'description', 'status', 'discover'
+				'history_downsample', 'history_downsample_param', 'valuemapid', 'logtimefmt', 'description', 'status', 'discover'
 			], array_diff(CItemType::FIELD_NAMES, ['parameters'])),
 			'filter' => [
 				'templateid' => array_keys($db_items),
@@ -1155,7 +1173,7 @@ class CItemPrototype extends CItemGeneral {
 
 		$options = [
 			'output' => array_merge(['uuid', 'itemid', 'name', 'type', 'key_', 'value_type', 'units', 'history',
-				'trends', 'valuemapid', 'logtimefmt', 'description', 'status', 'discover'
+				'trends', 'history_downsample', 'history_downsample_param', 'valuemapid', 'logtimefmt', 'description', 'status', 'discover'
 			], array_diff(CItemType::FIELD_NAMES, ['parameters'])),
 			'itemids' => array_keys($upd_db_items)
 		];
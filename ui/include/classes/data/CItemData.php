@@ -368,10 +368,13 @@ final class CItemData {
 			'zabbix[host,<type>,available]',
 			'zabbix[host,discovery,interfaces]',
 			'zabbix[hosts]',
+			'zabbix[inflight_checks,<type>]',
 			'zabbix[items]',
 			'zabbix[items_unsupported]',
 			'zabbix[java,,<param>]',
+			'zabbix[latency,<probe>,<mode>]',
 			'zabbix[lld_queue]',
+			'zabbix[locks,<lock>,<mode>]',
 			'zabbix[preprocessing_queue]',
 			'zabbix[process,<type>,<mode>,<state>]',
 			'zabbix[proxy,<name>,<param>]',
@@ -380,11 +383,13 @@ final class CItemData {
 			'zabbix[queue,<from>,<to>]',
 			'zabbix[rcache,<cache>,<mode>]',
 			'zabbix[requiredperformance]',
+			'zabbix[scheduling_lag,<type>]',
 			'zabbix[stats,<ip>,<port>,queue,<from>,<to>]',
 			'zabbix[stats,<ip>,<port>]',
 			'zabbix[tcache, cache, <parameter>]',
 			'zabbix[triggers]',
 			'zabbix[uptime]',
+			'zabbix[value_latency,<stage>,<item type>,<mode>]',
 			'zabbix[vcache,buffer,<mode>]',
 			'zabbix[vcache,cache,<parameter>]',
 			'zabbix[version]',
@@ -1827,6 +1832,10 @@ final class CItemData {
 				'description' => _('Number of monitored hosts'),
 				'value_type' => ITEM_VALUE_TYPE_UINT64
 			],
+			'zabbix[inflight_checks,<type>]' => [
+				'description' => _('Number of checks being processed by asynchronous pollers. Valid types are: agent, snmp, http.'),
+				'value_type' => ITEM_VALUE_TYPE_UINT64
+			],
 			'zabbix[items]' => [
 				'description' => _('Number of items in Zabbix database.'),
 				'value_type' => ITEM_VALUE_TYPE_UINT64
@@ -1839,10 +1848,18 @@ final class CItemData {
 				'description' => _('Returns information associated with Zabbix Java gateway. Valid params are: ping, version.'),
 				'value_type' => null
 			],
+			'zabbix[latency,<probe>,<mode>]' => [
+				'description' => _('Latency statistics of the specified hot path in seconds. Valid probes are: history_sync, poller, preprocessing, db_query. Valid modes are: avg (default), count, p50, p90, p99.'),
+				'value_type' => ITEM_VALUE_TYPE_FLOAT
+			],
 			'zabbix[lld_queue]' => [
 				'description' => _('Count of values enqueued in the low-level discovery processing queue.'),
 				'value_type' => ITEM_VALUE_TYPE_UINT64
 			],
+			'zabbix[locks,<lock>,<mode>]' => [
+				'description' => _('Usage statistics of the specified lock, for example ZBX_MUTEX_CACHE or ZBX_RWLOCK_CONFIG. Valid modes are: locks, contended, wait, wait_max, hold, hold_p50, hold_p90, hold_p99. Times are returned in seconds.'),
+				'value_type' => ITEM_VALUE_TYPE_FLOAT
+			],
 			'zabbix[preprocessing_queue]' => [
 				'description' => _('Count of values enqueued in the preprocessing queue.'),
 				'value_type' => ITEM_VALUE_TYPE_UINT64
@@ -1875,6 +1892,10 @@ final class CItemData {
 				'description' => _('Required performance of the Zabbix server, in new values per second expected.'),
 				'value_type' => ITEM_VALUE_TYPE_FLOAT
 			],
+			'zabbix[scheduling_lag,<type>]' => [
+				'description' => _('Number of seconds the most overdue item in the queue of the specified poller type is late.'),
+				'value_type' => ITEM_VALUE_TYPE_UINT64
+			],
 			'zabbix[stats,<ip>,<port>,queue,<from>,<to>]' => [
 				'description' => _('Number of items in the queue which are delayed in Zabbix server or proxy by "from" till "to" seconds, inclusive.'),
 				'value_type' => ITEM_VALUE_TYPE_UINT64
@@ -1895,6 +1916,10 @@ final class CItemData {
 				'description' => _('Uptime of Zabbix server process in seconds.'),
 				'value_type' => ITEM_VALUE_TYPE_UINT64
 			],
+			'zabbix[value_latency,<stage>,<item type>,<mode>]' => [
+				'description' => _('Latency of collected values in seconds from the value timestamp to the specified history syncer stage. Valid stages are: sync, history, triggers. Item type is numeric, empty for all item types. Valid modes are: avg (default), count, p50, p90, p99.'),
+				'value_type' => ITEM_VALUE_TYPE_FLOAT
+			],
 			'zabbix[vcache,buffer,<mode>]' => [
 				'description' => _('Value cache statistics. Valid modes are: total, free, pfree, used and pused.'),
 				'value_type' => null
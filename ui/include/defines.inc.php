@@ -22,7 +22,7 @@ define('ZABBIX_VERSION',		'7.0.0alpha1');
 define('ZABBIX_API_VERSION',	'7.0.0');
 define('ZABBIX_EXPORT_VERSION',	'7.0');
 
-define('ZABBIX_DB_VERSION',		6050013);
+define('ZABBIX_DB_VERSION',		6050017);
 
 define('DB_VERSION_SUPPORTED',						0);
 define('DB_VERSION_LOWER_THAN_MINIMUM',				1);
@@ -579,6 +579,13 @@ define('ITEM_VALUE_TYPE_UINT64',	3);
 define('ITEM_VALUE_TYPE_TEXT',		4);
 define('ITEM_VALUE_TYPE_BINARY',	5);
 
+define('ITEM_HISTORY_DOWNSAMPLE_NONE',		0);
+define('ITEM_HISTORY_DOWNSAMPLE_AVG',		1);
+define('ITEM_HISTORY_DOWNSAMPLE_MIN',		2);
+define('ITEM_HISTORY_DOWNSAMPLE_MAX',		3);
+define('ITEM_HISTORY_DOWNSAMPLE_LAST',		4);
+define('ITEM_HISTORY_DOWNSAMPLE_DEADBAND',	5);
+
 define('ITEM_DATA_TYPE_DECIMAL',		0);
 define('ITEM_DATA_TYPE_OCTAL',			1);
 define('ITEM_DATA_TYPE_HEXADECIMAL',	2);